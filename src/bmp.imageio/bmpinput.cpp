@@ -30,6 +30,8 @@ public:
     bool close(void) override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin,
+                               int yend, int z, void* data) override;
 
 private:
     int64_t m_padded_scanline_size;
@@ -377,6 +379,16 @@ BmpInput::read_rle_image()
 
 
 
+// Swap the first and third channels of npixels pixels, in place.
+static void
+bgr_to_rgb(uint8_t* pixels, imagesize_t npixels, int nchannels)
+{
+    for (imagesize_t i = 0; i < npixels; ++i, pixels += nchannels)
+        std::swap(pixels[0], pixels[2]);
+}
+
+
+
 bool
 BmpInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
                                void* data)
@@ -407,23 +419,25 @@ BmpInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
         y = m_spec.height - y - 1;
     const int64_t scanline_off = y * m_padded_scanline_size;
 
-    fscanline.resize(m_padded_scanline_size);
-    ioseek(m_bmp_header.offset + scanline_off);
-    if (!ioread(fscanline.data(), m_padded_scanline_size)) {
-        return false;  // Read failed
-    }
-
     // in each case we process only first m_spec.scanline_bytes () bytes
     // as only they contain information about pixels. The rest are just
     // because scanline size have to be 32-bit boundary
     if (m_dib_header.bpp == 24 || m_dib_header.bpp == 32) {
-        for (unsigned int i = 0; i < m_spec.scanline_bytes();
-             i += m_spec.nchannels)
-            std::swap(fscanline[i], fscanline[i + 2]);
-        memcpy(data, fscanline.data(), m_spec.scanline_bytes());
+        // Already the pixels we want, but for channel order: read them
+        // right into the caller's buffer and swap there.
+        if (!ioseek(m_bmp_header.offset + scanline_off)
+            || !ioread(data, scanline_bytes))
+            return false;  // Read failed
+        bgr_to_rgb(mscanline, m_spec.width, m_spec.nchannels);
         return true;
     }
 
+    fscanline.resize(m_padded_scanline_size);
+    ioseek(m_bmp_header.offset + scanline_off);
+    if (!ioread(fscanline.data(), m_padded_scanline_size)) {
+        return false;  // Read failed
+    }
+
     if (m_dib_header.bpp == 16) {
         for (unsigned int i = 0, j = 0; j < scanline_bytes; i += 2, j += 3) {
             uint16_t pixel = *(uint16_t*)&fscanline[i];
@@ -497,6 +511,47 @@ BmpInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
 
 
 
+bool
+BmpInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                int yend, int z, void* data)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel))
+        return false;
+
+    // Uncompressed 24 and 32 bit rows with no padding lie back to back in
+    // the file, so a run of them is a single read into the caller's buffer.
+    // Anything else goes a scanline at a time.
+    const size_t scanline_bytes = m_spec.scanline_bytes();
+    yend = std::min(yend, m_spec.y + m_spec.height);
+    if ((m_dib_header.bpp != 24 && m_dib_header.bpp != 32)
+        || m_dib_header.compression == RLE4_COMPRESSION
+        || m_dib_header.compression == RLE8_COMPRESSION
+        || m_padded_scanline_size != int64_t(scanline_bytes) || ybegin < 0
+        || yend - ybegin < 2)
+        return ImageInput::read_native_scanlines(subimage, miplevel, ybegin,
+                                                 yend, z, data);
+
+    // if the height is positive scanlines are stored bottom-up
+    const bool bottomup = m_dib_header.height >= 0;
+    const size_t nrows  = size_t(yend - ybegin);
+    const int64_t first = bottomup ? m_spec.height - yend : ybegin;
+    uint8_t* buf        = (uint8_t*)data;
+    if (!ioseek(m_bmp_header.offset + first * m_padded_scanline_size)
+        || !ioread(buf, scanline_bytes, nrows))
+        return false;  // Read failed
+    if (bottomup) {
+        for (size_t lo = 0, hi = nrows - 1; lo < hi; ++lo, --hi)
+            std::swap_ranges(buf + lo * scanline_bytes,
+                             buf + (lo + 1) * scanline_bytes,
+                             buf + hi * scanline_bytes);
+    }
+    bgr_to_rgb(buf, imagesize_t(m_spec.width) * nrows, m_spec.nchannels);
+    return true;
+}
+
+
+
 bool
 BmpInput::close(void)
 {
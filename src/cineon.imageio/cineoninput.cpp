@@ -25,6 +25,8 @@ public:
     bool close() override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin, int yend,
+                               int z, void* data) override;
 
 private:
     InStream* m_stream = nullptr;
@@ -387,6 +389,31 @@ CineonInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
 
 
 
+bool
+CineonInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                   int yend, int /*z*/, void* data)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel))
+        return false;
+
+    // libcineon only offsets padded rows correctly one scanline at a time
+    if (m_cin.header.EndOfLinePadding() != 0)
+        return ImageInput::read_native_scanlines(subimage, miplevel, ybegin,
+                                                 yend, 0, data);
+
+    // One block for the whole range, rather than a block per scanline
+    cineon::Block block(0, ybegin, m_cin.header.Width() - 1, yend - 1);
+
+    // FIXME: un-hardcode the channel from 0
+    if (!m_cin.ReadBlock(data, m_cin.header.ComponentDataSize(0), block))
+        return false;
+
+    return true;
+}
+
+
+
 char*
 CineonInput::get_descriptor_string(cineon::Descriptor c)
 {
@@ -141,12 +141,12 @@ macro (oiio_add_all_tests)
                     cmake-consumer
                     cryptomatte
                     docs-examples-cpp
-                    iinfo igrep
+                    iconvert iinfo igrep
                     nonwhole-tiles
                     oiiotool
                     oiiotool-composite oiiotool-control oiiotool-copy
-                    oiiotool-fixnan
-                    oiiotool-pattern
+                    oiiotool-fixnan oiiotool-lazy
+                    oiiotool-pattern oiiotool-profile
                     oiiotool-readerror
                     oiiotool-subimage oiiotool-text oiiotool-xform
                     diff
@@ -158,12 +158,18 @@ macro (oiio_add_all_tests)
                     null
                     rational
                    )
+    if (NOT WIN32)
+        # --serve/--connect use Unix domain sockets
+        oiio_add_tests (oiiotool-serve)
+    endif ()
 
     set (all_texture_tests
                     texture-derivs texture-fill
                     texture-flipt texture-gettexels texture-gray
                     texture-interp-bicubic
                     texture-blurtube
+                    texture-coherent-batch texture-capture
+                    texture-sampler
                     texture-crop texture-cropover
                     texture-half texture-uint16
                     texture-icwrite
@@ -183,7 +189,7 @@ macro (oiio_add_all_tests)
                     texture-width0blur
                     texture-wrapfill
                     texture-fat texture-skinny
-                    texture-stats
+                    texture-stats texture-stochastic-texel
                     texture-threadtimes
                     texture-env
                     texture-colorspace
@@ -248,6 +254,12 @@ macro (oiio_add_all_tests)
     oiio_add_tests (dds
                     ENABLEVAR ENABLE_DDS
                     IMAGEDIR oiio-images/dds URL "Recent checkout of oiio-images")
+    oiio_add_tests (dds-write
+                    ENABLEVAR ENABLE_DDS)
+    if (USE_PYTHON AND NOT SANITIZE)
+        oiio_add_tests (ffmpeg
+                        FOUNDVAR FFmpeg_FOUND ENABLEVAR ENABLE_FFmpeg)
+    endif ()
     oiio_add_tests (fits
                     ENABLEVAR ENABLE_FITS
                     IMAGEDIR fits-images
@@ -300,6 +312,13 @@ macro (oiio_add_all_tests)
                         ENVIRONMENT OPENIMAGEIO_OPTIONS=openexr:core=1
                         IMAGEDIR openexr-images
                         URL http://github.com/AcademySoftwareFoundation/openexr-images)
+        # ... and with the core library writing the files, too
+        oiio_add_tests (openexr-suite openexr-multires openexr-chroma
+                        openexr-v2 openexr-window perchannel
+                        SUFFIX ".coreoutput"
+                        ENVIRONMENT "OPENIMAGEIO_OPTIONS=openexr:core=1,openexr:core_output=1"
+                        IMAGEDIR openexr-images
+                        URL http://github.com/AcademySoftwareFoundation/openexr-images)
     endif ()
     # if (NOT DEFINED ENV{${PROJECT_NAME}_CI})
     #     oiio_add_tests (openexr-damaged
@@ -312,6 +331,10 @@ macro (oiio_add_all_tests)
                     SUFFIX ".batch"
                     ENVIRONMENT TESTTEX_BATCH=1
                     FOUNDVAR OpenVDB_FOUND ENABLEVAR ENABLE_OpenVDB)
+    if (USE_PYTHON AND NOT SANITIZE)
+        oiio_add_tests (openvdb-tiles
+                        FOUNDVAR OpenVDB_FOUND ENABLEVAR ENABLE_OpenVDB)
+    endif ()
     oiio_add_tests (png png-damaged
                     ENABLEVAR ENABLE_PNG
                     IMAGEDIR oiio-images)
@@ -321,9 +344,13 @@ macro (oiio_add_all_tests)
     oiio_add_tests (psd psd-colormodes
                     ENABLEVAR ENABLE_PSD
                     IMAGEDIR oiio-images)
+    if (USE_PYTHON AND NOT SANITIZE)
+        oiio_add_tests (psd-layers
+                        ENABLEVAR ENABLE_PSD)
+    endif ()
     oiio_add_tests (ptex
                     FOUNDVAR PTEX_FOUND ENABLEVAR ENABLE_PTEX)
-    oiio_add_tests (raw
+    oiio_add_tests (raw raw-preview
                     FOUNDVAR LIBRAW_FOUND ENABLEVAR ENABLE_LIBRAW
                     IMAGEDIR oiio-images/raw)
     oiio_add_tests (rla
@@ -0,0 +1,613 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+#pragma once
+
+// Block compression (BCn) encoders used by DDSOutput. Each one packs a
+// single 4x4 block of pixels into the compressed block that bcdec.h (and
+// the GPU) decodes.
+//
+// The endpoints are fit along the principal axis of the block's values,
+// then quantized and, with more effort, refined by least squares against
+// the palette indices they produced, keeping whichever endpoints give the
+// smallest error. BC7 and BC6H use only their single-subset modes (BC7
+// mode 6, BC6H mode 11), which are simple to fit and good for most
+// texture content, though not as good as an exhaustive encoder on blocks
+// with sharp multi-colored edges. BC6H is the unsigned variant.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+namespace DDS_pvt {
+
+/// Encoder effort: 0 = fastest, 1 = normal, 2 = best.
+enum { BCEffortFast = 0, BCEffortNormal = 1, BCEffortBest = 2 };
+
+
+namespace bcenc {
+
+// Accumulates up to 128 bits, lowest first, for the BC6H/BC7 layouts.
+struct BitWriter {
+    uint64_t bits[2] = { 0, 0 };
+    int pos          = 0;
+    void put(uint32_t value, int n)
+    {
+        for (int i = 0; i < n; ++i, ++pos)
+            if ((value >> i) & 1)
+                bits[pos >> 6] |= uint64_t(1) << (pos & 63);
+    }
+    void store(uint8_t* dst) const
+    {
+        for (int i = 0; i < 16; ++i)
+            dst[i] = uint8_t(bits[i >> 3] >> (8 * (i & 7)));
+    }
+};
+
+
+
+// Mean and principal axis (by power iteration on the covariance) of n
+// points of dimension D. The axis is zero if the points are all the same.
+template<int D>
+inline void
+principal_axis(const float (*pts)[D], int n, float mean[D], float axis[D])
+{
+    for (int c = 0; c < D; ++c) {
+        mean[c] = 0.0f;
+        for (int i = 0; i < n; ++i)
+            mean[c] += pts[i][c];
+        mean[c] /= float(n);
+    }
+    float cov[D][D] = {};
+    for (int i = 0; i < n; ++i)
+        for (int a = 0; a < D; ++a)
+            for (int b = a; b < D; ++b)
+                cov[a][b] += (pts[i][a] - mean[a]) * (pts[i][b] - mean[b]);
+    for (int a = 0; a < D; ++a)
+        for (int b = 0; b < a; ++b)
+            cov[a][b] = cov[b][a];
+    // Start from the channel with the most variance
+    int big = 0;
+    for (int c = 1; c < D; ++c)
+        if (cov[c][c] > cov[big][big])
+            big = c;
+    float v[D];
+    for (int c = 0; c < D; ++c)
+        v[c] = cov[big][c];
+    for (int iter = 0; iter < 8; ++iter) {
+        float w[D] = {}, len = 0.0f;
+        for (int a = 0; a < D; ++a) {
+            for (int b = 0; b < D; ++b)
+                w[a] += cov[a][b] * v[b];
+            len = std::max(len, std::abs(w[a]));
+        }
+        if (len <= 0.0f)
+            break;
+        for (int c = 0; c < D; ++c)
+            v[c] = w[c] / len;
+    }
+    float len2 = 0.0f;
+    for (int c = 0; c < D; ++c)
+        len2 += v[c] * v[c];
+    float scale = len2 > 1.0e-12f ? 1.0f / std::sqrt(len2) : 0.0f;
+    for (int c = 0; c < D; ++c)
+        axis[c] = v[c] * scale;
+}
+
+
+
+// End points of the extent of the points along their principal axis.
+template<int D>
+inline void
+fit_endpoints(const float (*pts)[D], int n, float e0[D], float e1[D])
+{
+    float mean[D], axis[D];
+    principal_axis<D>(pts, n, mean, axis);
+    float tmin = 0.0f, tmax = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < D; ++c)
+            t += (pts[i][c] - mean[c]) * axis[c];
+        tmin = std::min(tmin, t);
+        tmax = std::max(tmax, t);
+    }
+    for (int c = 0; c < D; ++c) {
+        e0[c] = mean[c] + axis[c] * tmin;
+        e1[c] = mean[c] + axis[c] * tmax;
+    }
+}
+
+
+
+// Least-squares endpoints for points that are interpolated with weights
+// wt[i] (0 = all e0, 1 = all e1). Return false if the system is singular
+// (all the weights are the same).
+template<int D>
+inline bool
+refit_endpoints(const float (*pts)[D], const float* wt, int n, float e0[D],
+                float e1[D])
+{
+    float A = 0.0f, B = 0.0f, C = 0.0f;
+    float X0[D] = {}, X1[D] = {};
+    for (int i = 0; i < n; ++i) {
+        float a = 1.0f - wt[i], b = wt[i];
+        A += a * a;
+        B += a * b;
+        C += b * b;
+        for (int c = 0; c < D; ++c) {
+            X0[c] += a * pts[i][c];
+            X1[c] += b * pts[i][c];
+        }
+    }
+    float det = A * C - B * B;
+    if (std::abs(det) < 1.0e-6f)
+        return false;
+    float inv = 1.0f / det;
+    for (int c = 0; c < D; ++c) {
+        e0[c] = (C * X0[c] - B * X1[c]) * inv;
+        e1[c] = (A * X1[c] - B * X0[c]) * inv;
+    }
+    return true;
+}
+
+
+
+inline int
+clampi(int v, int lo, int hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+inline int
+roundclamp(float v, int lo, int hi)
+{
+    return clampi(int(std::floor(v + 0.5f)), lo, hi);
+}
+
+inline int
+quantize_pbit(float v, int p)
+{
+    return roundclamp((v - float(p)) * 0.5f, 0, 127);
+}
+
+// Interpolation weights (out of 64) of 4-bit BC6H/BC7 indices
+static const int weights4[16] = { 0,  4,  9,  13, 17, 21, 26, 30,
+                                  34, 38, 43, 47, 51, 55, 60, 64 };
+
+inline int
+interpolate64(int a, int b, int w)
+{
+    return (a * (64 - w) + b * w + 32) >> 6;
+}
+
+
+
+// BC1 color block (also the color half of BC3): 2 RGB565 endpoints and 2
+// bit indices. Always uses the opaque 4-color mode.
+struct ColorCandidate {
+    uint16_t c0 = 0, c1 = 0;
+    uint32_t indices = 0;
+    float error      = 1.0e30f;
+};
+
+inline uint16_t
+pack565(const float c[3])
+{
+    return uint16_t((roundclamp(c[0] * (31.0f / 255.0f), 0, 31) << 11)
+                    | (roundclamp(c[1] * (63.0f / 255.0f), 0, 63) << 5)
+                    | roundclamp(c[2] * (31.0f / 255.0f), 0, 31));
+}
+
+inline void
+unpack565(uint16_t c, int rgb[3])
+{
+    rgb[0] = (((c >> 11) & 0x1F) * 527 + 23) >> 6;
+    rgb[1] = (((c >> 5) & 0x3F) * 259 + 33) >> 6;
+    rgb[2] = ((c & 0x1F) * 527 + 23) >> 6;
+}
+
+inline void
+eval_color(const float (*pts)[3], uint16_t c0, uint16_t c1,
+           ColorCandidate& best)
+{
+    if (c0 < c1)
+        std::swap(c0, c1);
+    int pal[4][3];
+    unpack565(c0, pal[0]);
+    unpack565(c1, pal[1]);
+    for (int c = 0; c < 3; ++c) {
+        pal[2][c] = (2 * pal[0][c] + pal[1][c] + 1) / 3;
+        pal[3][c] = (pal[0][c] + 2 * pal[1][c] + 1) / 3;
+    }
+    // With equal endpoints a BC1 decoder is in its 3-color mode, where
+    // index 3 is transparent black, so only index 0 is safe.
+    int npal     = c0 == c1 ? 1 : 4;
+    uint32_t idx = 0;
+    float toterr = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        int bi = 0;
+        float be = 1.0e30f;
+        for (int p = 0; p < npal; ++p) {
+            float e = 0.0f;
+            for (int c = 0; c < 3; ++c) {
+                float d = pts[i][c] - float(pal[p][c]);
+                e += d * d;
+            }
+            if (e < be) {
+                be = e;
+                bi = p;
+            }
+        }
+        toterr += be;
+        idx |= uint32_t(bi) << (2 * i);
+    }
+    if (toterr < best.error) {
+        best.c0      = c0;
+        best.c1      = c1;
+        best.indices = idx;
+        best.error   = toterr;
+    }
+}
+
+inline void
+encode_color_block(const uint8_t rgba[16][4], uint8_t* out, int effort)
+{
+    float pts[16][3];
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+            pts[i][c] = float(rgba[i][c]);
+    float e0[3], e1[3];
+    fit_endpoints<3>(pts, 16, e0, e1);
+    ColorCandidate best;
+    eval_color(pts, pack565(e0), pack565(e1), best);
+    // Refine: the weight of each index toward c1 is 0, 1, 1/3, 2/3
+    static const float idxweight[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+    int iters = effort == BCEffortFast ? 0 : (effort == BCEffortNormal ? 1 : 4);
+    for (int it = 0; it < iters; ++it) {
+        float wt[16];
+        for (int i = 0; i < 16; ++i)
+            wt[i] = idxweight[(best.indices >> (2 * i)) & 3];
+        float r0[3], r1[3];
+        if (!refit_endpoints<3>(pts, wt, 16, r0, r1))
+            break;
+        float olderr = best.error;
+        eval_color(pts, pack565(r0), pack565(r1), best);
+        if (!(best.error < olderr))
+            break;
+    }
+    out[0] = uint8_t(best.c0);
+    out[1] = uint8_t(best.c0 >> 8);
+    out[2] = uint8_t(best.c1);
+    out[3] = uint8_t(best.c1 >> 8);
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = uint8_t(best.indices >> (8 * i));
+}
+
+
+
+// BC4 block (also the alpha half of BC3 and each half of BC5): 2 8-bit
+// endpoints and 3-bit indices.
+inline float
+eval_bc4(const int* vals, int a0, int a1, uint64_t& indices)
+{
+    int pal[8];
+    pal[0] = a0;
+    pal[1] = a1;
+    if (a0 > a1) {
+        for (int i = 1; i < 7; ++i)
+            pal[i + 1] = ((7 - i) * a0 + i * a1 + 1) / 7;
+    } else {
+        for (int i = 1; i < 5; ++i)
+            pal[i + 1] = ((5 - i) * a0 + i * a1 + 1) / 5;
+        pal[6] = 0;
+        pal[7] = 255;
+    }
+    indices   = 0;
+    float err = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        int bi = 0, be = 1 << 30;
+        for (int p = 0; p < 8; ++p) {
+            int d = vals[i] - pal[p];
+            if (d * d < be) {
+                be = d * d;
+                bi = p;
+            }
+        }
+        err += float(be);
+        indices |= uint64_t(bi) << (3 * i);
+    }
+    return err;
+}
+
+inline void
+encode_bc4_block(const uint8_t* v, int stride, uint8_t* out, int effort)
+{
+    int vals[16], mn = 255, mx = 0, imn = 255, imx = 0;
+    for (int i = 0; i < 16; ++i) {
+        vals[i] = v[i * stride];
+        mn      = std::min(mn, vals[i]);
+        mx      = std::max(mx, vals[i]);
+        if (vals[i] != 0 && vals[i] != 255) {
+            imn = std::min(imn, vals[i]);
+            imx = std::max(imx, vals[i]);
+        }
+    }
+    int best0 = mx, best1 = mn;
+    uint64_t bestidx;
+    float besterr = eval_bc4(vals, best0, best1, bestidx);
+    auto consider = [&](int a0, int a1) {
+        uint64_t idx;
+        float err = eval_bc4(vals, a0, a1, idx);
+        if (err < besterr) {
+            besterr = err;
+            best0   = a0;
+            best1   = a1;
+            bestidx = idx;
+        }
+    };
+    if (effort >= BCEffortNormal && besterr > 0.0f) {
+        // The 6-value mode, with exact 0 and 255 for the extremes
+        if (imn <= imx)
+            consider(imn, imx);
+    }
+    if (effort >= BCEffortBest && besterr > 0.0f) {
+        // Nudge the endpoints of the 8-value mode
+        for (int d0 = -2; d0 <= 2; ++d0)
+            for (int d1 = -2; d1 <= 2; ++d1) {
+                int a0 = clampi(mx + d0, 0, 255), a1 = clampi(mn + d1, 0, 255);
+                if (a0 > a1)
+                    consider(a0, a1);
+            }
+    }
+    out[0] = uint8_t(best0);
+    out[1] = uint8_t(best1);
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = uint8_t(bestidx >> (8 * i));
+}
+
+
+
+// BC7 mode 6: one subset of RGBA endpoints, 7 bits per channel plus a
+// p-bit per endpoint, and 4-bit indices.
+struct BC7Candidate {
+    int q[2][4]     = {};  // 7-bit endpoints
+    int p[2]        = {};  // p-bits
+    uint8_t idx[16] = {};
+    float error     = 1.0e30f;
+};
+
+inline void
+eval_bc7(const float (*pts)[4], const int q[2][4], const int p[2],
+         BC7Candidate& best)
+{
+    int e[2][4];
+    for (int j = 0; j < 2; ++j)
+        for (int c = 0; c < 4; ++c)
+            e[j][c] = (q[j][c] << 1) | p[j];
+    int pal[16][4];
+    for (int k = 0; k < 16; ++k)
+        for (int c = 0; c < 4; ++c)
+            pal[k][c] = interpolate64(e[0][c], e[1][c], weights4[k]);
+    BC7Candidate cand;
+    cand.error = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        int bi   = 0;
+        float be = 1.0e30f;
+        for (int k = 0; k < 16; ++k) {
+            float err = 0.0f;
+            for (int c = 0; c < 4; ++c) {
+                float d = pts[i][c] - float(pal[k][c]);
+                err += d * d;
+            }
+            if (err < be) {
+                be = err;
+                bi = k;
+            }
+        }
+        cand.idx[i] = uint8_t(bi);
+        cand.error += be;
+    }
+    if (cand.error < best.error) {
+        std::memcpy(cand.q, q, sizeof(cand.q));
+        cand.p[0] = p[0];
+        cand.p[1] = p[1];
+        best      = cand;
+    }
+}
+
+inline void
+try_bc7_endpoints(const float (*pts)[4], const float e0[4], const float e1[4],
+                  int effort, BC7Candidate& best)
+{
+    const float* e[2] = { e0, e1 };
+    int q[2][4], p[2];
+    if (effort == BCEffortFast) {
+        // Pick each p-bit by which quantizes its endpoint best
+        for (int j = 0; j < 2; ++j) {
+            float err[2] = { 0.0f, 0.0f };
+            for (int pb = 0; pb < 2; ++pb)
+                for (int c = 0; c < 4; ++c) {
+                    float d = float((quantize_pbit(e[j][c], pb) << 1) | pb)
+                              - e[j][c];
+                    err[pb] += d * d;
+                }
+            p[j] = err[1] < err[0] ? 1 : 0;
+            for (int c = 0; c < 4; ++c)
+                q[j][c] = quantize_pbit(e[j][c], p[j]);
+        }
+        eval_bc7(pts, q, p, best);
+        return;
+    }
+    for (int p0 = 0; p0 < 2; ++p0)
+        for (int p1 = 0; p1 < 2; ++p1) {
+            p[0] = p0;
+            p[1] = p1;
+            for (int c = 0; c < 4; ++c) {
+                q[0][c] = quantize_pbit(e0[c], p0);
+                q[1][c] = quantize_pbit(e1[c], p1);
+            }
+            eval_bc7(pts, q, p, best);
+        }
+}
+
+inline void
+encode_bc7_block(const uint8_t rgba[16][4], uint8_t* out, int effort)
+{
+    float pts[16][4];
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 4; ++c)
+            pts[i][c] = float(rgba[i][c]);
+    float e0[4], e1[4];
+    fit_endpoints<4>(pts, 16, e0, e1);
+    BC7Candidate best;
+    try_bc7_endpoints(pts, e0, e1, effort, best);
+    int iters = effort == BCEffortFast ? 0 : (effort == BCEffortNormal ? 1 : 3);
+    for (int it = 0; it < iters && best.error > 0.0f; ++it) {
+        float wt[16];
+        for (int i = 0; i < 16; ++i)
+            wt[i] = weights4[best.idx[i]] / 64.0f;
+        if (!refit_endpoints<4>(pts, wt, 16, e0, e1))
+            break;
+        float olderr = best.error;
+        try_bc7_endpoints(pts, e0, e1, effort, best);
+        if (!(best.error < olderr))
+            break;
+    }
+    // The first index is stored with one less bit, so it must be < 8:
+    // if not, swap the endpoints, which mirrors the indices.
+    if (best.idx[0] >= 8) {
+        for (int c = 0; c < 4; ++c)
+            std::swap(best.q[0][c], best.q[1][c]);
+        std::swap(best.p[0], best.p[1]);
+        for (int i = 0; i < 16; ++i)
+            best.idx[i] = uint8_t(15 - best.idx[i]);
+    }
+    BitWriter bw;
+    bw.put(1 << 6, 7);  // mode 6
+    for (int c = 0; c < 4; ++c) {
+        bw.put(best.q[0][c], 7);
+        bw.put(best.q[1][c], 7);
+    }
+    bw.put(best.p[0], 1);
+    bw.put(best.p[1], 1);
+    for (int i = 0; i < 16; ++i)
+        bw.put(best.idx[i], i == 0 ? 3 : 4);
+    bw.store(out);
+}
+
+
+
+// BC6H (unsigned) mode 11: one subset of 10-bit RGB endpoints and 4-bit
+// indices. The decoder interpolates in a 16-bit space in which the final
+// half value bits are x*31/64, so the fitting is done on the half bits
+// scaled by 64/31, which is roughly logarithmic in the pixel values.
+inline int
+bc6h_unquantize(int e)
+{
+    if (e == 0)
+        return 0;
+    if (e == 1023)
+        return 0xFFFF;
+    return ((e << 16) + 0x8000) >> 10;
+}
+
+struct BC6HCandidate {
+    int e[2][3]     = {};
+    uint8_t idx[16] = {};
+    float error     = 1.0e30f;
+};
+
+inline void
+eval_bc6h(const float (*halfbits)[3], const float e0[3], const float e1[3],
+          BC6HCandidate& best)
+{
+    BC6HCandidate cand;
+    int unq[2][3];
+    for (int c = 0; c < 3; ++c) {
+        cand.e[0][c] = roundclamp((e0[c] - 32.0f) / 64.0f, 0, 1023);
+        cand.e[1][c] = roundclamp((e1[c] - 32.0f) / 64.0f, 0, 1023);
+        unq[0][c]    = bc6h_unquantize(cand.e[0][c]);
+        unq[1][c]    = bc6h_unquantize(cand.e[1][c]);
+    }
+    float pal[16][3];
+    for (int k = 0; k < 16; ++k)
+        for (int c = 0; c < 3; ++c)
+            pal[k][c] = float(
+                (interpolate64(unq[0][c], unq[1][c], weights4[k]) * 31) >> 6);
+    cand.error = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        int bi   = 0;
+        float be = 1.0e30f;
+        for (int k = 0; k < 16; ++k) {
+            float err = 0.0f;
+            for (int c = 0; c < 3; ++c) {
+                float d = halfbits[i][c] - pal[k][c];
+                err += d * d;
+            }
+            if (err < be) {
+                be = err;
+                bi = k;
+            }
+        }
+        cand.idx[i] = uint8_t(bi);
+        cand.error += be;
+    }
+    if (cand.error < best.error)
+        best = cand;
+}
+
+inline void
+encode_bc6h_block(const uint16_t rgb[16][3], uint8_t* out, int effort)
+{
+    float halfbits[16][3], pts[16][3];
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c) {
+            int h = rgb[i][c];
+            if (h & 0x8000)  // negative -- unsigned format clamps to 0
+                h = 0;
+            else if (h > 0x7BFF)  // inf or nan -- largest finite
+                h = 0x7BFF;
+            halfbits[i][c] = float(h);
+            pts[i][c]      = float(h) * (64.0f / 31.0f);
+        }
+    float e0[3], e1[3];
+    fit_endpoints<3>(pts, 16, e0, e1);
+    BC6HCandidate best;
+    eval_bc6h(halfbits, e0, e1, best);
+    int iters = effort == BCEffortFast ? 0 : (effort == BCEffortNormal ? 1 : 3);
+    for (int it = 0; it < iters && best.error > 0.0f; ++it) {
+        float wt[16];
+        for (int i = 0; i < 16; ++i)
+            wt[i] = weights4[best.idx[i]] / 64.0f;
+        if (!refit_endpoints<3>(pts, wt, 16, e0, e1))
+            break;
+        float olderr = best.error;
+        eval_bc6h(halfbits, e0, e1, best);
+        if (!(best.error < olderr))
+            break;
+    }
+    if (best.idx[0] >= 8) {
+        for (int c = 0; c < 3; ++c)
+            std::swap(best.e[0][c], best.e[1][c]);
+        for (int i = 0; i < 16; ++i)
+            best.idx[i] = uint8_t(15 - best.idx[i]);
+    }
+    BitWriter bw;
+    bw.put(0x03, 5);  // mode 11
+    for (int j = 0; j < 2; ++j)
+        for (int c = 0; c < 3; ++c)
+            bw.put(best.e[j][c], 10);
+    for (int i = 0; i < 16; ++i)
+        bw.put(best.idx[i], i == 0 ? 3 : 4);
+    bw.store(out);
+}
+
+}  // namespace bcenc
+
+}  // namespace DDS_pvt
+
+OIIO_PLUGIN_NAMESPACE_END
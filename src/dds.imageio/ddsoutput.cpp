@@ -0,0 +1,419 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/fmath.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/strutil.h>
+
+#include "bcenc.h"
+#include "dds_pvt.h"
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+using namespace DDS_pvt;
+
+
+// DDS output writes 2D textures, optionally MIP-mapped, either as
+// uncompressed 8 bit data or block compressed (BC1, BC3, BC4, BC5, BC6H,
+// BC7) ready to be uploaded to a GPU. Because the header records the
+// number of MIP levels, each level is buffered as it is written and the
+// whole file is assembled at close(). Tiles are emulated by the same
+// buffering.
+class DDSOutput final : public ImageOutput {
+public:
+    DDSOutput() { init(); }
+    ~DDSOutput() override { close(); }
+    const char* format_name(void) const override { return "dds"; }
+    int supports(string_view feature) const override
+    {
+        return (feature == "tiles" || feature == "mipmap" || feature == "alpha"
+                || feature == "ioproxy");
+    }
+    bool open(const std::string& name, const ImageSpec& spec,
+              OpenMode mode) override;
+    bool write_scanline(int y, int z, TypeDesc format, const void* data,
+                        stride_t xstride) override;
+    bool write_tile(int x, int y, int z, TypeDesc format, const void* data,
+                    stride_t xstride, stride_t ystride,
+                    stride_t zstride) override;
+    bool close() override;
+
+private:
+    Compression m_compression;
+    int m_effort;                        // bcenc effort level
+    bool m_srgb;                         // write an sRGB DXGI format
+    int m_nlevels;                       // MIP levels finished so far
+    int m_width, m_height, m_nchannels;  // of the highest-res level
+    std::vector<unsigned char> m_level;  // pixels of the current level
+    std::vector<unsigned char> m_data;   // finished (encoded) levels
+    std::vector<unsigned char> m_scratch;
+
+    void init(void)
+    {
+        ioproxy_clear();
+        m_compression = Compression::None;
+        m_effort      = BCEffortNormal;
+        m_srgb        = false;
+        m_nlevels     = 0;
+        m_width = m_height = m_nchannels = 0;
+        std::vector<unsigned char>().swap(m_level);
+        std::vector<unsigned char>().swap(m_data);
+    }
+
+    // Pick the compression, effort, and native data format from m_spec.
+    void choose_compression();
+    // Encode the buffered level and append it to m_data.
+    void finish_level();
+    bool write_file();
+};
+
+
+
+OIIO_PLUGIN_EXPORTS_BEGIN
+
+OIIO_EXPORT ImageOutput*
+dds_output_imageio_create()
+{
+    return new DDSOutput;
+}
+
+OIIO_EXPORT const char* dds_output_extensions[] = { "dds", nullptr };
+
+OIIO_PLUGIN_EXPORTS_END
+
+
+
+void
+DDSOutput::choose_compression()
+{
+    auto compqual    = m_spec.decode_compression_metadata("none", 50);
+    string_view comp = compqual.first;
+    // Names that are not block compression methods (such as the "zip" that
+    // maketx asks for by default) just mean uncompressed.
+    m_compression = Compression::None;
+    if (Strutil::iequals(comp, "bc1") || Strutil::iequals(comp, "dxt1"))
+        m_compression = Compression::DXT1;
+    else if (Strutil::iequals(comp, "bc3") || Strutil::iequals(comp, "dxt5")
+             || Strutil::iequals(comp, "bc2") || Strutil::iequals(comp, "dxt3"))
+        m_compression = Compression::DXT5;
+    else if (Strutil::iequals(comp, "bc4") || Strutil::iequals(comp, "ati1"))
+        m_compression = Compression::BC4;
+    else if (Strutil::iequals(comp, "bc5") || Strutil::iequals(comp, "ati2"))
+        m_compression = Compression::BC5;
+    else if (Strutil::iequals(comp, "bc6h") || Strutil::iequals(comp, "bc6hu"))
+        m_compression = Compression::BC6HU;
+    else if (Strutil::iequals(comp, "bc7"))
+        m_compression = Compression::BC7;
+
+    int quality = clamp(compqual.second, 0, 100);
+    m_effort    = quality < 34 ? BCEffortFast
+                               : (quality < 67 ? BCEffortNormal : BCEffortBest);
+
+    // Only BC1, BC3, and BC7 have sRGB variants
+    m_srgb = (m_compression == Compression::DXT1
+              || m_compression == Compression::DXT5
+              || m_compression == Compression::BC7)
+             && Strutil::iequals(m_spec.get_string_attribute("oiio:ColorSpace"),
+                                 "sRGB");
+
+    m_spec.set_format(m_compression == Compression::BC6HU ? TypeDesc::HALF
+                                                          : TypeDesc::UINT8);
+}
+
+
+
+bool
+DDSOutput::open(const std::string& name, const ImageSpec& userspec,
+                OpenMode mode)
+{
+    if (mode == AppendMIPLevel) {
+        if (!ioproxy_opened()) {
+            errorfmt("Cannot append a MIP level to a file that is not open");
+            return false;
+        }
+        finish_level();
+        int w           = m_spec.width;
+        int h           = m_spec.height;
+        TypeDesc format = m_spec.format;
+        if (!check_open(mode, userspec, { 0, 65535, 0, 65535, 0, 1, 0, 4 }))
+            return false;
+        if (m_spec.width != std::max(1, w / 2)
+            || m_spec.height != std::max(1, h / 2)
+            || m_spec.nchannels != m_nchannels) {
+            errorfmt("DDS MIP level {} must be {}x{} with {} channels",
+                     m_nlevels, std::max(1, w / 2), std::max(1, h / 2),
+                     m_nchannels);
+            return false;
+        }
+        m_spec.set_format(format);
+        m_level.resize(m_spec.image_bytes());
+        return true;
+    }
+
+    if (!check_open(mode, userspec, { 0, 65535, 0, 65535, 0, 1, 0, 4 }))
+        return false;
+
+    choose_compression();
+    m_width     = m_spec.width;
+    m_height    = m_spec.height;
+    m_nchannels = m_spec.nchannels;
+
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
+        return false;
+
+    m_level.resize(m_spec.image_bytes());
+    return true;
+}
+
+
+
+bool
+DDSOutput::write_scanline(int y, int /*z*/, TypeDesc format, const void* data,
+                          stride_t xstride)
+{
+    if (y < m_spec.y || y >= m_spec.y + m_spec.height) {
+        errorfmt("Attempt to write scanline {} out of range", y);
+        return false;
+    }
+    data = to_native_scanline(format, data, xstride, m_scratch);
+    size_t rowbytes = m_spec.scanline_bytes();
+    memcpy(&m_level[(y - m_spec.y) * rowbytes], data, rowbytes);
+    return true;
+}
+
+
+
+bool
+DDSOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
+                      stride_t xstride, stride_t ystride, stride_t zstride)
+{
+    // Emulate tiles by buffering the whole level
+    return copy_tile_to_image_buffer(x, y, z, format, data, xstride, ystride,
+                                     zstride, &m_level[0]);
+}
+
+
+
+void
+DDSOutput::finish_level()
+{
+    const int width  = m_spec.width;
+    const int height = m_spec.height;
+    const int nc     = m_spec.nchannels;
+    ++m_nlevels;
+    if (m_compression == Compression::None) {
+        // The uncompressed layouts we write (L, LA, RGB, RGBA bytes) are
+        // just the native interleaved pixels.
+        m_data.insert(m_data.end(), m_level.begin(), m_level.end());
+        return;
+    }
+
+    const Compression cmp = m_compression;
+    const int effort      = m_effort;
+    const size_t blocksize
+        = (cmp == Compression::DXT1 || cmp == Compression::BC4) ? 8 : 16;
+    const int wblocks   = (width + 3) / 4;
+    const int hblocks   = (height + 3) / 4;
+    const size_t offset = m_data.size();
+    m_data.resize(offset + blocksize * wblocks * hblocks);
+    unsigned char* dst       = m_data.data() + offset;
+    const unsigned char* src = m_level.data();
+
+    // Each row of blocks is independent. Blocks that hang off the right or
+    // bottom edge are padded by repeating the last column/row.
+    parallel_for_chunked(
+        0, hblocks, 0,
+        [&](int64_t ybb, int64_t ybe) {
+            uint8_t rgba[16][4];
+            uint16_t rgbh[16][3];
+            for (int yb = int(ybb); yb < int(ybe); ++yb) {
+                unsigned char* out = dst + size_t(yb) * wblocks * blocksize;
+                for (int xb = 0; xb < wblocks; ++xb, out += blocksize) {
+                    for (int i = 0; i < 16; ++i) {
+                        int x = std::min(xb * 4 + (i & 3), width - 1);
+                        int y = std::min(yb * 4 + (i >> 2), height - 1);
+                        size_t p = size_t(y) * width + x;
+                        if (cmp == Compression::BC6HU) {
+                            const uint16_t* h = (const uint16_t*)src + p * nc;
+                            rgbh[i][0] = h[0];
+                            rgbh[i][1] = nc >= 2 ? h[1] : h[0];
+                            rgbh[i][2] = nc >= 3 ? h[2]
+                                                 : (nc == 2 ? 0 : h[0]);
+                            continue;
+                        }
+                        const uint8_t* v = src + p * nc;
+                        if (nc <= 1) {
+                            rgba[i][0] = rgba[i][1] = rgba[i][2] = v[0];
+                            rgba[i][3] = 255;
+                        } else if (nc == 2) {
+                            rgba[i][0] = v[0];
+                            rgba[i][1] = v[1];
+                            rgba[i][2] = 0;
+                            rgba[i][3] = 255;
+                        } else {
+                            rgba[i][0] = v[0];
+                            rgba[i][1] = v[1];
+                            rgba[i][2] = v[2];
+                            rgba[i][3] = nc >= 4 ? v[3] : 255;
+                        }
+                    }
+                    switch (cmp) {
+                    case Compression::DXT1:
+                        bcenc::encode_color_block(rgba, out, effort);
+                        break;
+                    case Compression::DXT5:
+                        bcenc::encode_bc4_block(&rgba[0][3], 4, out, effort);
+                        bcenc::encode_color_block(rgba, out + 8, effort);
+                        break;
+                    case Compression::BC4:
+                        bcenc::encode_bc4_block(&rgba[0][0], 4, out, effort);
+                        break;
+                    case Compression::BC5:
+                        bcenc::encode_bc4_block(&rgba[0][0], 4, out, effort);
+                        bcenc::encode_bc4_block(&rgba[0][1], 4, out + 8,
+                                                effort);
+                        break;
+                    case Compression::BC6HU:
+                        bcenc::encode_bc6h_block(rgbh, out, effort);
+                        break;
+                    case Compression::BC7:
+                        bcenc::encode_bc7_block(rgba, out, effort);
+                        break;
+                    default: break;
+                    }
+                }
+            }
+        },
+        paropt(threads(), paropt::SplitDir::Y, 8));
+}
+
+
+
+bool
+DDSOutput::write_file()
+{
+    dds_header dds;
+    memset(&dds, 0, sizeof(dds));
+    dds.fourCC      = DDS_MAKE4CC('D', 'D', 'S', ' ');
+    dds.size        = 124;
+    dds.flags       = DDS_CAPS | DDS_HEIGHT | DDS_WIDTH | DDS_PIXELFORMAT;
+    dds.height      = m_height;
+    dds.width       = m_width;
+    dds.mipmaps     = m_nlevels;
+    dds.fmt.size    = 32;
+    dds.caps.flags1 = DDS_CAPS1_TEXTURE;
+    if (m_nlevels > 1) {
+        dds.flags |= DDS_MIPMAPCOUNT;
+        dds.caps.flags1 |= DDS_CAPS1_COMPLEX | DDS_CAPS1_MIPMAP;
+    }
+
+    dds_header_dx10 dx10;
+    memset(&dx10, 0, sizeof(dx10));
+    bool use_dx10 = false;
+    if (m_compression == Compression::None) {
+        dds.flags |= DDS_PITCH;
+        dds.pitch   = m_width * m_nchannels;
+        dds.fmt.bpp = 8 * m_nchannels;
+        if (m_nchannels <= 2) {
+            dds.fmt.flags    = DDS_PF_LUMINANCE;
+            dds.fmt.masks[0] = 0x000000ff;
+            if (m_nchannels == 2) {
+                dds.fmt.flags |= DDS_PF_ALPHA;
+                dds.fmt.masks[3] = 0x0000ff00;
+            }
+        } else {
+            dds.fmt.flags    = DDS_PF_RGB;
+            dds.fmt.masks[0] = 0x000000ff;
+            dds.fmt.masks[1] = 0x0000ff00;
+            dds.fmt.masks[2] = 0x00ff0000;
+            if (m_nchannels == 4) {
+                dds.fmt.flags |= DDS_PF_ALPHA;
+                dds.fmt.masks[3] = 0xff000000u;
+            }
+        }
+    } else {
+        size_t blocksize = (m_compression == Compression::DXT1
+                            || m_compression == Compression::BC4)
+                               ? 8
+                               : 16;
+        dds.flags |= DDS_LINEARSIZE;
+        dds.pitch     = uint32_t(blocksize * ((m_width + 3) / 4)
+                                 * ((m_height + 3) / 4));
+        dds.fmt.flags = DDS_PF_FOURCC;
+        switch (m_compression) {
+        case Compression::DXT1:
+            if (m_srgb) {
+                use_dx10        = true;
+                dx10.dxgiFormat = DDS_FORMAT_BC1_UNORM_SRGB;
+            } else
+                dds.fmt.fourCC = DDS_4CC_DXT1;
+            break;
+        case Compression::DXT5:
+            if (m_srgb) {
+                use_dx10        = true;
+                dx10.dxgiFormat = DDS_FORMAT_BC3_UNORM_SRGB;
+            } else
+                dds.fmt.fourCC = DDS_4CC_DXT5;
+            break;
+        case Compression::BC4: dds.fmt.fourCC = DDS_4CC_ATI1; break;
+        case Compression::BC5: dds.fmt.fourCC = DDS_4CC_ATI2; break;
+        case Compression::BC6HU:
+            use_dx10        = true;
+            dx10.dxgiFormat = DDS_FORMAT_BC6H_UF16;
+            break;
+        case Compression::BC7:
+            use_dx10        = true;
+            dx10.dxgiFormat = m_srgb ? DDS_FORMAT_BC7_UNORM_SRGB
+                                     : DDS_FORMAT_BC7_UNORM;
+            break;
+        default: break;
+        }
+        if (use_dx10) {
+            dds.fmt.fourCC         = DDS_4CC_DX10;
+            dx10.resourceDimension = 3;  // Texture2D
+            dx10.arraySize         = 1;
+        }
+    }
+
+    if (bigendian()) {
+        // DDS files are little-endian; swap the same fields as DDSInput
+        swap_endian(&dds.size);
+        swap_endian(&dds.height);
+        swap_endian(&dds.width);
+        swap_endian(&dds.pitch);
+        swap_endian(&dds.mipmaps);
+        swap_endian(&dds.fmt.size);
+        swap_endian(&dds.fmt.bpp);
+    }
+
+    return iowrite(&dds, sizeof(dds))
+           && (!use_dx10 || iowrite(&dx10, sizeof(dx10)))
+           && iowrite(m_data.data(), m_data.size());
+}
+
+
+
+bool
+DDSOutput::close()
+{
+    if (!ioproxy_opened()) {  // already closed
+        init();
+        return true;
+    }
+
+    finish_level();
+    bool ok = write_file();
+    init();
+    return ok;
+}
+
+OIIO_PLUGIN_NAMESPACE_END
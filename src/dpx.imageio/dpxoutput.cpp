@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: BSD-3-Clause and Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -45,6 +46,9 @@ public:
     bool close() override;
     bool write_scanline(int y, int z, TypeDesc format, const void* data,
                         stride_t xstride) override;
+    bool write_scanlines(int ybegin, int yend, int z, TypeDesc format,
+                         const void* data, stride_t xstride = AutoStride,
+                         stride_t ystride = AutoStride) override;
     bool write_tile(int x, int y, int z, TypeDesc format, const void* data,
                     stride_t xstride, stride_t ystride,
                     stride_t zstride) override;
@@ -568,6 +572,7 @@ DPXOutput::write_buffer()
 
     bool ok = true;
     if (m_write_pending && m_buf.size()) {
+        m_dpx.SetThreads(threads());
         ok = m_dpx.WriteElement(m_subimage, m_buf.data(), m_datasize);
         if (!ok) {
             const char* err = strerror(errno);
@@ -640,6 +645,41 @@ DPXOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
 
 
 
+bool
+DPXOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
+                           const void* data, stride_t xstride, stride_t ystride)
+{
+    if (!is_opened()) {
+        errorfmt("write_scanlines called but file is not open.");
+        return false;
+    }
+
+    const ImageSpec& spec_s(m_subimage_specs[m_subimage]);
+    // Dithering and color conversion go a scanline at a time.
+    if (!m_rawcolor || m_dither || spec_s.channelformats.size())
+        return ImageOutput::write_scanlines(ybegin, yend, z, format, data,
+                                            xstride, ystride);
+
+    m_write_pending = true;
+    yend            = std::min(yend, spec_s.y + spec_s.height);
+    if (format == TypeUnknown)
+        format = spec_s.format;
+    stride_t zstride = AutoStride;
+    spec_s.auto_stride(xstride, ystride, zstride, format, spec_s.nchannels,
+                       spec_s.width, spec_s.height);
+    // Convert (from half, float, or anything else) straight into the
+    // subimage buffer that the packing reads from, in parallel, with no
+    // per-scanline scratch copies.
+    return parallel_convert_image(spec_s.nchannels, spec_s.width,
+                                  yend - ybegin, 1, data, format, xstride,
+                                  ystride, zstride,
+                                  &m_buf[(ybegin - spec_s.y) * m_bytes],
+                                  spec_s.format, AutoStride, m_bytes,
+                                  AutoStride, threads());
+}
+
+
+
 bool
 DPXOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
                       stride_t xstride, stride_t ystride, stride_t zstride)
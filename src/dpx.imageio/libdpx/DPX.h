@@ -410,10 +410,18 @@ namespace dpx
 		 */			
 		bool Finish();
 
+		/*!
+		 * \brief Set how many threads may pack scanlines
+		 *
+		 * \param n thread count (0 means OIIO's default)
+		 */
+		void SetThreads(const int n) { this->threads = n; }
+
 
 	protected:
 		long fileLoc;
 		OutStream *fd;
+		int threads;
 		
 		bool WriteThrough(void *, const U32, const U32, const int, const int, const U32, const U32, char *);
 		
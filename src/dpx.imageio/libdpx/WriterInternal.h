@@ -37,6 +37,11 @@
 #define _DPX_WRITERINTERNAL_H 1
 
 
+#include <algorithm>
+#include <vector>
+
+#include <OpenImageIO/parallel.h>
+
 #include "BaseTypeConverter.h"
 
 
@@ -219,35 +224,36 @@ namespace dpx
 		// shift bits over 2 if Method A
 		const int method_shift = (METHOD == kFilledMethodA ? 2 : 0);
 		
-		// loop through the buffer
-		int i;
-		U32 value = 0;
-		for (i = 0; i < len; i++)
+		// Whole words of three datums at a time, with constant shifts, so
+		// the loop can be vectorized. Datum i%3 == 0 goes in the low bits,
+		// or the high bits if reversed. Packing in place is safe, since
+		// word w is written only after datums 3w..3w+2 are read.
+		const IB *in = src + access.offset;
+		const U32 s0 = (reverse ? 2 * bitdepth : 0) + method_shift;
+		const U32 s1 = bitdepth + method_shift;
+		const U32 s2 = (reverse ? 0 : 2 * bitdepth) + method_shift;
+		const int words = len / 3;
+		for (int w = 0; w < words; w++)
 		{
-			int div = i / 3;			// 3 10-bit values in a U32
-			int rem = i % 3;
-	
-			// write previously calculated value
-			if (i && rem == 0)
+			const U32 d0 = (static_cast<U32>(in[3 * w]) >> shift) & bitmask;
+			const U32 d1 = (static_cast<U32>(in[3 * w + 1]) >> shift) & bitmask;
+			const U32 d2 = (static_cast<U32>(in[3 * w + 2]) >> shift) & bitmask;
+			dst_u32[w] = (d0 << s0) | (d1 << s1) | (d2 << s2);
+		}
+
+		// the last partial word
+		if (len % 3)
+		{
+			U32 value = 0;
+			for (int i = words * 3; i < len; i++)
 			{
-				dst_u32[div-1] = value;
-				value = 0;
+				int rem = i % 3;
+				if (reverse)
+					rem = 2 - rem;
+				value |= ((static_cast<U32>(in[i]) >> shift) & bitmask) << (bitdepth * rem + method_shift);
 			}
-
-			// if reverse the order
-			if (reverse)
-				rem = 2 - rem;
-
-			// place the 10 bits in the proper place with mask
-			U32 comp = ((static_cast<U32>(src[i+access.offset]) >> shift) << (bitdepth * rem)) << method_shift;
-			U32 mask = (bitmask << (bitdepth * rem)) << method_shift ;
-			
-			// overwrite only the proper 10 bits
-			value = (value & ~mask) | (comp & mask);
+			dst_u32[words] = value;
 		}
-		
-		// write last
-		dst_u32[(len+2)/3-1] = value;
 
 		// adjust offset/length
 		// multiply * 2 because it takes two U16 = U32 and this func packs into a U32
@@ -257,9 +263,81 @@ namespace dpx
 	
 			
 	
+	// convert, compress, pack, and byte swap line h of the image into dst,
+	// leaving what is to be written described by bufaccess
+	template <typename IB, int BITDEPTH, bool SAMEBUFTYPE>
+	void PackLine(DataSize src_size, void *src_buf, const U32 h, const U32 width, const int noc, const Packing packing,
+				  const bool rle, const bool reverse, const int eolnPad, const int rleBufAdd, bool swapEndian,
+				  IB *dst, BufferAccess &bufaccess)
+	{
+		IB *src;
+		bufaccess.offset = 0;
+		bufaccess.length = width * noc;
+
+		// image buffer
+		unsigned char *imageBuf = reinterpret_cast<unsigned char*>(src_buf);
+		const int bytes = Header::DataSizeByteCount(src_size);
+
+		// copy buffer if need to promote data types from src to destination
+		if (SAMEBUFTYPE)
+		{
+			src = dst;
+			CopyWriteBuffer<IB>(src_size, (imageBuf+(size_t(h)*width*noc*bytes)+(size_t(h)*eolnPad)), dst, (width*noc));
+		} 
+		else
+			// not a copy, access source
+			src = reinterpret_cast<IB*>(imageBuf + (size_t(h) * width * noc * bytes) + (size_t(h)*eolnPad));
+
+		// if rle, compress
+		if (rle)
+		{
+			RleCompress<IB, BITDEPTH>(src, dst, ((width * noc) + rleBufAdd), width * noc, bufaccess);
+			src = dst;
+		}
+		
+		// if 10 or 12 bit, pack
+		if (BITDEPTH == 10)
+		{
+			if (packing == dpx::kPacked)
+			{
+				WritePackedMethod<IB, BITDEPTH>(src, dst, (width*noc), reverse, bufaccess);
+			}
+			else if (packing == kFilledMethodA)
+			{
+				WritePackedMethodAB_10bit<IB, dpx::kFilledMethodA>(src, dst, (width*noc), reverse, bufaccess);
+			}
+			else // if (packing == dpx::kFilledMethodB)
+			{
+				WritePackedMethodAB_10bit<IB, dpx::kFilledMethodB>(src, dst, (width*noc), reverse, bufaccess);
+			}				
+		}
+		else if (BITDEPTH == 12)
+		{
+			if (packing == dpx::kPacked)
+			{
+				WritePackedMethod<IB, BITDEPTH>(src, dst, (width*noc), reverse, bufaccess);
+			}
+			else if (packing == dpx::kFilledMethodB)
+			{
+				// shift 4 MSB down, so 0x0f00 would become 0x00f0
+				for (int w = 0; w < bufaccess.length; w++)
+					dst[w] = src[bufaccess.offset+w] >> 4;
+				bufaccess.offset = 0;
+			}
+			// a bitdepth of 12 by default is packed with dpx::kFilledMethodA
+			// assumes that either a copy or rle was required
+			// otherwise this routine should not be called with:
+			//     12-bit Method A with the source buffer data type is kWord				
+		}
+
+		if (swapEndian)
+			EndianBufferSwap(BITDEPTH, packing, dst + bufaccess.offset, bufaccess.length * sizeof(IB));
+	}
+
+
 	template <typename IB, int BITDEPTH, bool SAMEBUFTYPE>
 	int WriteBuffer(OutStream *fd, DataSize src_size, void *src_buf, const U32 width, const U32 height, const int noc, const Packing packing, 
-					const bool rle, bool reverse, const int eolnPad, char *blank, bool &status, bool swapEndian)
+					const bool rle, bool reverse, const int eolnPad, char *blank, bool &status, bool swapEndian, int nthreads = 0)
 	{
 		int fileOffset = 0;
 		
@@ -269,104 +347,51 @@ namespace dpx
 		// so we will just double the destination size if RLE
 		int rleBufAdd = (rle ? ((width * noc / 3) + 1) : 0);
 
-		// buffer access parameters
-		BufferAccess bufaccess;
-		bufaccess.offset = 0;
-		bufaccess.length = width * noc;
-		
-		// allocate one line
-		IB *src;
-		IB *dst = new IB[(width * noc) + 1 + rleBufAdd];
-
 		// not exactly sure why, but the datum order is wrong when writing 4-channel images, so reverse it
 		if (noc == 4 && BITDEPTH == 10)
 			reverse = !reverse;
 
-		// each line in the buffer
-		for (U32 h = 0; h < height; h++)
-		{
-			// image buffer
-			unsigned char *imageBuf = reinterpret_cast<unsigned char*>(src_buf);
-			const int bytes = Header::DataSizeByteCount(src_size);
-
-			// copy buffer if need to promote data types from src to destination
-			if (SAMEBUFTYPE)
-			{
-				src = dst;
-				CopyWriteBuffer<IB>(src_size, (imageBuf+(h*width*noc*bytes)+(h*eolnPad)), dst, (width*noc));
-			} 
-			else
-				// not a copy, access source
-				src = reinterpret_cast<IB*>(imageBuf + (h * width * noc * bytes) + (h*eolnPad));
+		// Lines are packed a band at a time, in parallel, each into its own
+		// slot of the band buffer, then written in order.
+		const size_t linesize = (width * noc) + 1 + rleBufAdd;
+		const U32 bandlines = std::min<U32>(height, 64);
+		std::vector<IB> band(linesize * bandlines);
+		std::vector<BufferAccess> access(bandlines);
 
-			// if rle, compress
-			if (rle)
-			{
-				RleCompress<IB, BITDEPTH>(src, dst, ((width * noc) + rleBufAdd), width * noc, bufaccess);
-				src = dst;
-			}
-			
-			// if 10 or 12 bit, pack
-			if (BITDEPTH == 10)
-			{
-				if (packing == dpx::kPacked)
-				{
-					WritePackedMethod<IB, BITDEPTH>(src, dst, (width*noc), reverse, bufaccess);
-				}
-				else if (packing == kFilledMethodA)
-				{
-					WritePackedMethodAB_10bit<IB, dpx::kFilledMethodA>(src, dst, (width*noc), reverse, bufaccess);
-				}
-				else // if (packing == dpx::kFilledMethodB)
-				{
-					WritePackedMethodAB_10bit<IB, dpx::kFilledMethodB>(src, dst, (width*noc), reverse, bufaccess);
-				}				
-			}
-			else if (BITDEPTH == 12)
-			{
-				if (packing == dpx::kPacked)
-				{
-					WritePackedMethod<IB, BITDEPTH>(src, dst, (width*noc), reverse, bufaccess);
-				}
-				else if (packing == dpx::kFilledMethodB)
-				{
-					// shift 4 MSB down, so 0x0f00 would become 0x00f0
-					for (int w = 0; w < bufaccess.length; w++)
-						dst[w] = src[bufaccess.offset+w] >> 4;
-					bufaccess.offset = 0;
-				}
-				// a bitdepth of 12 by default is packed with dpx::kFilledMethodA
-				// assumes that either a copy or rle was required
-				// otherwise this routine should not be called with:
-				//     12-bit Method A with the source buffer data type is kWord				
-			}
-			
-			// write line
-			fileOffset += (bufaccess.length * sizeof(IB));
-			if (swapEndian)
-			    EndianBufferSwap(BITDEPTH, packing, dst + bufaccess.offset, bufaccess.length * sizeof(IB));
-			if (!fd->WriteCheck(dst+bufaccess.offset, (bufaccess.length * sizeof(IB))))
-			{
-				status = false;
-				break;
-			}
-			
-			// end of line padding
-			if (eolnPad)
+		for (U32 h0 = 0; h0 < height && status; h0 += bandlines)
+		{
+			const U32 h1 = std::min(height, h0 + bandlines);
+			OIIO::parallel_for(int64_t(h0), int64_t(h1), [&](int64_t h) {
+				PackLine<IB, BITDEPTH, SAMEBUFTYPE>(src_size, src_buf, U32(h), width, noc, packing, rle, reverse,
+													eolnPad, rleBufAdd, swapEndian,
+													band.data() + (h - h0) * linesize, access[h - h0]);
+			}, OIIO::paropt(nthreads, OIIO::paropt::SplitDir::Y, 8));
+
+			// write the lines
+			for (U32 h = h0; h < h1; h++)
 			{
-				fileOffset += eolnPad;
-				if (!fd->WriteCheck(blank, eolnPad))
+				const BufferAccess &bufaccess = access[h - h0];
+				IB *dst = band.data() + (h - h0) * linesize;
+				fileOffset += (bufaccess.length * sizeof(IB));
+				if (!fd->WriteCheck(dst+bufaccess.offset, (bufaccess.length * sizeof(IB))))
 				{
 					status = false;
 					break;
 				}
-			}	
-	
+				
+				// end of line padding
+				if (eolnPad)
+				{
+					fileOffset += eolnPad;
+					if (!fd->WriteCheck(blank, eolnPad))
+					{
+						status = false;
+						break;
+					}
+				}	
+			}
 		}
 		
-		// done with buffer
-		delete [] dst;
-		
 		return fileOffset;
 	}
 
@@ -11,6 +11,9 @@ extern "C" {  // ffmpeg is a C api
 #    error "OIIO FFmpeg support requires FFmpeg >= 3.0"
 #endif
 #include <libavutil/imgutils.h>
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 18, 100)
+#    include <libavutil/hwcontext.h>
+#endif
 }
 
 // It's hard to figure out FFMPEG versions from what they give us, so
@@ -29,6 +32,13 @@ extern "C" {  // ffmpeg is a C api
 #define USE_FFMPEG_4_3 (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 91, 100))
 #define USE_FFMPEG_4_4 (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 134, 100))
 
+// Hardware decoding through a device context (avcodec_get_hw_config and
+// friends) arrived with FFmpeg 4.0.
+#define FFMPEG_HAVE_HWACCEL USE_FFMPEG_4_0
+// AVStream::index_entries became private in favor of accessor functions.
+#define FFMPEG_HAVE_INDEX_ACCESSORS \
+    (LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100))
+
 
 
 inline int
@@ -79,7 +89,10 @@ receive_frame(AVCodecContext* avctx, AVFrame* picture, AVPacket* avpkt)
 
 
 #include <OpenImageIO/imageio.h>
+#include <algorithm>
+#include <deque>
 #include <iostream>
+#include <limits>
 #include <mutex>
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
@@ -96,6 +109,8 @@ public:
     }
     bool valid_file(const std::string& name) const override;
     bool open(const std::string& name, ImageSpec& spec) override;
+    bool open(const std::string& name, ImageSpec& newspec,
+              const ImageSpec& config) override;
     bool close(void) override;
     int current_subimage(void) const override
     {
@@ -137,6 +152,18 @@ private:
     bool m_codec_cap_delay;
     bool m_read_frame;
     int64_t m_start_time;
+    std::string m_hwaccel;            // requested hardware decoder, if any
+    size_t m_frame_cache_size;        // max decoded frames to keep around
+    // Decoded (software) frames near the last one asked for, oldest first.
+    std::deque<std::pair<int, AVFrame*>> m_frame_cache;
+    // (frame number, stream timestamp) of each key frame, in frame order.
+    // Only filled in when the demuxer indexes every frame of the stream.
+    std::vector<std::pair<int, int64_t>> m_keyframes;
+#if FFMPEG_HAVE_HWACCEL
+    AVBufferRef* m_hw_device_ctx  = nullptr;
+    AVPixelFormat m_hw_pix_format = AV_PIX_FMT_NONE;
+    AVFrame* m_sw_frame           = nullptr;  // hw frame copied to memory
+#endif
 
     // init to initialize state
     void init(void)
@@ -160,11 +187,52 @@ private:
         m_codec_cap_delay  = false;
         m_subimage         = 0;
         m_start_time       = 0;
+        m_hwaccel.clear();
+        m_frame_cache_size = 8;
+        m_frame_cache.clear();
+        m_keyframes.clear();
+#if FFMPEG_HAVE_HWACCEL
+        m_hw_device_ctx = nullptr;
+        m_hw_pix_format = AV_PIX_FMT_NONE;
+        m_sw_frame      = nullptr;
+#endif
     }
+
+    int frame_number(int64_t timestamp) const;
+    void build_keyframe_index();
+    bool can_decode_forward(int frame) const;
+    bool seek_keyframe(int frame);
+    int decode_to(int frame, bool stop_past_frame);
+    bool init_hwaccel();
+    const AVFrame* software_frame(AVFrame* frame);
+    bool convert_frame(const AVFrame* frame);
+    const AVFrame* cached_frame(int frame) const;
+    void cache_frame(int frame, const AVFrame* src);
+    void clear_frame_cache();
+#if FFMPEG_HAVE_HWACCEL
+    static AVPixelFormat get_hw_format(AVCodecContext* ctx,
+                                       const AVPixelFormat* formats);
+#endif
 };
 
 
 
+// The pixel format to tell swscale about: the "J" (full range) YUV
+// formats are deprecated there in favor of their regular counterparts.
+static AVPixelFormat
+sws_source_format(AVPixelFormat format)
+{
+    switch (format) {
+    case AV_PIX_FMT_YUVJ420P: return AV_PIX_FMT_YUV420P;
+    case AV_PIX_FMT_YUVJ422P: return AV_PIX_FMT_YUV422P;
+    case AV_PIX_FMT_YUVJ444P: return AV_PIX_FMT_YUV444P;
+    case AV_PIX_FMT_YUVJ440P: return AV_PIX_FMT_YUV440P;
+    default: return format;
+    }
+}
+
+
+
 // Obligatory material to make this a recognizable imageio plugin
 OIIO_PLUGIN_EXPORTS_BEGIN
 
@@ -216,6 +284,20 @@ FFmpegInput::valid_file(const std::string& name) const
 
 
 
+bool
+FFmpegInput::open(const std::string& name, ImageSpec& newspec,
+                  const ImageSpec& config)
+{
+    // Check 'config' for any special requests
+    m_hwaccel          = config.get_string_attribute("ffmpeg:hwaccel");
+    m_frame_cache_size = size_t(std::max(
+        0, config.get_int_attribute("ffmpeg:framecache",
+                                    int(m_frame_cache_size))));
+    return open(name, newspec);
+}
+
+
+
 bool
 FFmpegInput::open(const std::string& name, ImageSpec& spec)
 {
@@ -297,6 +379,11 @@ FFmpegInput::open(const std::string& name, ImageSpec& spec)
     }
 #endif
 
+    // Hardware decoding is strictly opportunistic: if no matching device
+    // can be set up, we just decode in software as usual.
+    if (m_hwaccel.size())
+        init_hwaccel();
+
     if (avcodec_open2(m_codec_context, m_codec, NULL) < 0) {
         errorfmt("\"{}\" could not open codec", file_name);
         return false;
@@ -334,18 +421,19 @@ FFmpegInput::open(const std::string& name, ImageSpec& spec)
             av_packet_unref(&pkt);  //Always free before format_context usage
         }
         m_frames = max_pts;
+        // The scan left the demuxer at the end; make sure we seek before
+        // decoding anything.
+        m_last_decoded_pos = -2;
     }
+    build_keyframe_index();
     m_frame     = av_frame_alloc();
     m_rgb_frame = av_frame_alloc();
+#if FFMPEG_HAVE_HWACCEL
+    if (m_hw_device_ctx)
+        m_sw_frame = av_frame_alloc();
+#endif
 
-    AVPixelFormat src_pix_format;
-    switch (m_codec_context->pix_fmt) {  // deprecation warning for YUV formats
-    case AV_PIX_FMT_YUVJ420P: src_pix_format = AV_PIX_FMT_YUV420P; break;
-    case AV_PIX_FMT_YUVJ422P: src_pix_format = AV_PIX_FMT_YUV422P; break;
-    case AV_PIX_FMT_YUVJ444P: src_pix_format = AV_PIX_FMT_YUV444P; break;
-    case AV_PIX_FMT_YUVJ440P: src_pix_format = AV_PIX_FMT_YUV440P; break;
-    default: src_pix_format = m_codec_context->pix_fmt; break;
-    }
+    AVPixelFormat src_pix_format = sws_source_format(m_codec_context->pix_fmt);
 
     // Assume by default that we're delivering RGB UINT8
     int nchannels     = 3;
@@ -521,6 +609,14 @@ FFmpegInput::open(const std::string& name, ImageSpec& spec)
     m_spec.attribute("oiio:BitsPerSample",
                      m_codec_context->bits_per_raw_sample);
     m_spec.attribute("ffmpeg:codec_name", m_codec_context->codec->long_name);
+#if FFMPEG_HAVE_HWACCEL
+    if (m_hw_device_ctx) {
+        auto device = reinterpret_cast<AVHWDeviceContext*>(
+            m_hw_device_ctx->data);
+        m_spec.attribute("ffmpeg:hwaccel",
+                         av_hwdevice_get_type_name(device->type));
+    }
+#endif
     m_nsubimages = m_frames;
     spec         = m_spec;
     m_filename   = name;
@@ -582,6 +678,13 @@ FFmpegInput::close(void)
         av_frame_free(&m_rgb_frame);
     if (m_sws_rgb_context)
         sws_freeContext(m_sws_rgb_context);
+    clear_frame_cache();
+#if FFMPEG_HAVE_HWACCEL
+    if (m_sw_frame)
+        av_frame_free(&m_sw_frame);
+    if (m_hw_device_ctx)
+        av_buffer_unref(&m_hw_device_ctx);
+#endif
     init();
     return true;
 }
@@ -591,12 +694,46 @@ FFmpegInput::close(void)
 void
 FFmpegInput::read_frame(int frame)
 {
-    if (m_last_decoded_pos + 1 != frame) {
+    m_read_frame = true;
+    if (const AVFrame* cached = cached_frame(frame)) {
+        convert_frame(cached);
+        return;
+    }
+
+    // If no key frame lies between the last decoded frame and this one,
+    // decoding onward is cheaper than seeking back. Otherwise, seek right
+    // to the key frame at or before it, if we know where that is. Either
+    // way it's an educated guess (the index records decode rather than
+    // display order), so should it prove wrong, fall back to a
+    // conventional seek.
+    bool guessed = can_decode_forward(frame) || seek_keyframe(frame);
+    if (!guessed)
+        seek(frame);
+    int found = decode_to(frame, guessed);
+    if (found <= 0 && guessed) {
         seek(frame);
+        found = decode_to(frame, false);
     }
+    if (found <= 0) {
+        // Where the decoder stands is anyone's guess now.
+        m_last_decoded_pos = -2;
+    }
+}
+
+
+
+// Decode until reaching `frame`, converting it to RGB. Frames decoded on
+// the way that are close enough before it are kept in the frame cache.
+// Return 1 if the frame was found, 0 if we ran out of frames, or -1 if
+// stop_past_frame is true and the stream went past the frame (meaning we
+// started decoding from the wrong place).
+int
+FFmpegInput::decode_to(int frame, bool stop_past_frame)
+{
     AVPacket pkt;
-    int finished = 0;
-    int ret      = 0;
+    int finished  = 0;
+    int ret       = 0;
+    int cache_min = frame - int(m_frame_cache_size) + 1;
     while ((ret = av_read_frame(m_format_context, &pkt)) == 0
            || m_codec_cap_delay) {
         if (ret == AVERROR_EOF) {
@@ -610,32 +747,241 @@ FFmpegInput::read_frame(int frame)
 
             finished = receive_frame(m_codec_context, m_frame, &pkt);
 
-            double pts = 0;
-            if (static_cast<int64_t>(m_frame->pts) != int64_t(AV_NOPTS_VALUE)) {
-                pts = av_q2d(
-                          m_format_context->streams[m_video_stream]->time_base)
-                      * m_frame->pts;
-            }
-
-            int current_frame = int((pts - m_start_time) * fps() + 0.5f);  //???
+            int64_t pts = 0;
+            if (static_cast<int64_t>(m_frame->pts) != int64_t(AV_NOPTS_VALUE))
+                pts = m_frame->pts;
+            int current_frame = frame_number(pts);
             //current_frame =   m_frame->display_picture_number;
             m_last_search_pos = current_frame;
 
-            if (current_frame == frame && finished) {
-                avpicture_fill(m_rgb_frame, &m_rgb_buffer[0], m_dst_pix_format,
-                               m_codec_context->width, m_codec_context->height);
-                sws_scale(m_sws_rgb_context,
-                          static_cast<uint8_t const* const*>(m_frame->data),
-                          m_frame->linesize, 0, m_codec_context->height,
-                          m_rgb_frame->data, m_rgb_frame->linesize);
-                m_last_decoded_pos = current_frame;
+            if (finished && current_frame > frame && stop_past_frame) {
                 av_packet_unref(&pkt);
-                break;
+                return -1;
+            }
+            if (finished && current_frame <= frame
+                && (current_frame >= cache_min || current_frame == frame)) {
+                const AVFrame* decoded = software_frame(m_frame);
+                if (decoded)
+                    cache_frame(current_frame, decoded);
+                if (current_frame == frame) {
+                    bool ok            = decoded && convert_frame(decoded);
+                    m_last_decoded_pos = current_frame;
+                    av_packet_unref(&pkt);
+                    return ok ? 1 : 0;
+                }
             }
         }
         av_packet_unref(&pkt);
     }
-    m_read_frame = true;
+    return 0;
+}
+
+
+
+// Map a timestamp (in the video stream's time base) to a frame number.
+int
+FFmpegInput::frame_number(int64_t timestamp) const
+{
+    double pts = av_q2d(m_format_context->streams[m_video_stream]->time_base)
+                 * timestamp;
+    return int((pts - m_start_time) * fps() + 0.5f);  //???
+}
+
+
+
+void
+FFmpegInput::build_keyframe_index()
+{
+    m_keyframes.clear();
+    AVStream* stream = m_format_context->streams[m_video_stream];
+#if FFMPEG_HAVE_INDEX_ACCESSORS
+    int nentries = avformat_index_get_entries_count(stream);
+#else
+    int nentries = stream->nb_index_entries;
+#endif
+    // Only an index with an entry for every frame (as QuickTime, MP4 and
+    // AVI have) tells us where the key frames are *not*. A sparse or
+    // partial one (MPEG program streams build theirs as they are read)
+    // is no use for deciding whether to seek.
+    if (m_frames <= 0 || nentries < m_frames)
+        return;
+    for (int i = 0; i < nentries; ++i) {
+#if FFMPEG_HAVE_INDEX_ACCESSORS
+        const AVIndexEntry* entry = avformat_index_get_entry(stream, i);
+#else
+        const AVIndexEntry* entry = &stream->index_entries[i];
+#endif
+        if (entry && (entry->flags & AVINDEX_KEYFRAME))
+            m_keyframes.emplace_back(frame_number(entry->timestamp),
+                                     entry->timestamp);
+    }
+    std::sort(m_keyframes.begin(), m_keyframes.end());
+}
+
+
+
+bool
+FFmpegInput::can_decode_forward(int frame) const
+{
+    if (m_last_decoded_pos + 1 == frame)
+        return true;
+    if (m_keyframes.empty() || m_last_decoded_pos < 0
+        || frame <= m_last_decoded_pos)
+        return false;
+    auto next = std::upper_bound(
+        m_keyframes.begin(), m_keyframes.end(),
+        std::make_pair(m_last_decoded_pos,
+                       std::numeric_limits<int64_t>::max()));
+    return next == m_keyframes.end() || next->first > frame;
+}
+
+
+
+bool
+FFmpegInput::seek_keyframe(int frame)
+{
+    auto key = std::upper_bound(
+        m_keyframes.begin(), m_keyframes.end(),
+        std::make_pair(frame, std::numeric_limits<int64_t>::max()));
+    if (key == m_keyframes.begin())
+        return false;
+    --key;
+    avcodec_flush_buffers(m_codec_context);
+    return av_seek_frame(m_format_context, m_video_stream, key->second,
+                         AVSEEK_FLAG_BACKWARD)
+           >= 0;
+}
+
+
+
+bool
+FFmpegInput::init_hwaccel()
+{
+#if FFMPEG_HAVE_HWACCEL
+    // "auto" takes the first device type the decoder supports and that
+    // can actually be opened on this machine.
+    bool any_type = Strutil::iequals(m_hwaccel, "auto");
+    AVHWDeviceType type = any_type ? AV_HWDEVICE_TYPE_NONE
+                                   : av_hwdevice_find_type_by_name(
+                                       m_hwaccel.c_str());
+    if (!any_type && type == AV_HWDEVICE_TYPE_NONE)
+        return false;
+    for (int i = 0;; ++i) {
+        const AVCodecHWConfig* config = avcodec_get_hw_config(m_codec, i);
+        if (!config)
+            break;
+        if (!(config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX)
+            || (!any_type && config->device_type != type))
+            continue;
+        AVBufferRef* device = nullptr;
+        if (av_hwdevice_ctx_create(&device, config->device_type, nullptr,
+                                   nullptr, 0)
+            < 0)
+            continue;
+        m_hw_device_ctx                = device;
+        m_hw_pix_format                = config->pix_fmt;
+        m_codec_context->hw_device_ctx = av_buffer_ref(device);
+        m_codec_context->opaque        = this;
+        m_codec_context->get_format    = get_hw_format;
+        return true;
+    }
+#endif
+    return false;
+}
+
+
+
+#if FFMPEG_HAVE_HWACCEL
+AVPixelFormat
+FFmpegInput::get_hw_format(AVCodecContext* ctx, const AVPixelFormat* formats)
+{
+    const FFmpegInput* self = static_cast<const FFmpegInput*>(ctx->opaque);
+    for (const AVPixelFormat* f = formats; *f != AV_PIX_FMT_NONE; ++f)
+        if (*f == self->m_hw_pix_format)
+            return *f;
+    // The hardware can't take this stream after all; decode in software.
+    return avcodec_default_get_format(ctx, formats);
+}
+#endif
+
+
+
+// Return a frame whose pixels are in memory: `frame` itself, or for a
+// hardware decoded frame, a copy transferred from the device.
+const AVFrame*
+FFmpegInput::software_frame(AVFrame* frame)
+{
+#if FFMPEG_HAVE_HWACCEL
+    if (m_hw_device_ctx && frame->format == m_hw_pix_format) {
+        av_frame_unref(m_sw_frame);
+        if (av_hwframe_transfer_data(m_sw_frame, frame, 0) < 0)
+            return nullptr;
+        return m_sw_frame;
+    }
+#endif
+    return frame;
+}
+
+
+
+bool
+FFmpegInput::convert_frame(const AVFrame* frame)
+{
+    // The decoded pixel format can differ from the one we opened with,
+    // e.g. NV12 from a hardware decoder, so let swscale adapt.
+    m_sws_rgb_context = sws_getCachedContext(
+        m_sws_rgb_context, m_codec_context->width, m_codec_context->height,
+        sws_source_format(AVPixelFormat(frame->format)),
+        m_codec_context->width, m_codec_context->height, m_dst_pix_format,
+        SWS_AREA, NULL, NULL, NULL);
+    if (!m_sws_rgb_context)
+        return false;
+    avpicture_fill(m_rgb_frame, &m_rgb_buffer[0], m_dst_pix_format,
+                   m_codec_context->width, m_codec_context->height);
+    sws_scale(m_sws_rgb_context,
+              static_cast<uint8_t const* const*>(frame->data), frame->linesize,
+              0, m_codec_context->height, m_rgb_frame->data,
+              m_rgb_frame->linesize);
+    return true;
+}
+
+
+
+const AVFrame*
+FFmpegInput::cached_frame(int frame) const
+{
+    for (auto& f : m_frame_cache)
+        if (f.first == frame)
+            return f.second;
+    return nullptr;
+}
+
+
+
+void
+FFmpegInput::cache_frame(int frame, const AVFrame* src)
+{
+    if (!m_frame_cache_size || cached_frame(frame))
+        return;
+    // Just another reference to the decoded buffers, not a copy.
+    AVFrame* ref = av_frame_clone(src);
+    if (!ref)
+        return;
+    m_frame_cache.emplace_back(frame, ref);
+    while (m_frame_cache.size() > m_frame_cache_size) {
+        av_frame_free(&m_frame_cache.front().second);
+        m_frame_cache.pop_front();
+    }
+}
+
+
+
+void
+FFmpegInput::clear_frame_cache()
+{
+    for (auto& f : m_frame_cache)
+        av_frame_free(&f.second);
+    m_frame_cache.clear();
 }
 
 
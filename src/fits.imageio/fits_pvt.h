@@ -48,24 +48,27 @@ public:
                 || feature == "iptc"  // Because of arbitrary_metadata
                 || feature == "multiimage"
                 || feature == "noimage"  // allow metadata only, no pixels
-        );
+                || feature == "ioproxy");
     }
-    bool valid_file(const std::string& filename) const override;
+    bool valid_file(Filesystem::IOProxy* ioproxy) const override;
     bool open(const std::string& name, ImageSpec& spec) override;
+    bool open(const std::string& name, ImageSpec& spec,
+              const ImageSpec& config) override;
     bool close(void) override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin,
+                               int yend, int z, void* data) override;
     bool seek_subimage(int subimage, int miplevel) override;
     int current_subimage() const override { return m_cur_subimage; }
 
 private:
-    FILE* m_fd;
     std::string m_filename;
     int m_cur_subimage;
     int m_bitpix;              // number of bits that represents data value;
     int m_naxes;               // number of axes of the image (e.g dimensions)
     std::vector<int> m_naxis;  // axis sizes of each dimension
-    fpos_t m_filepos;          // current position in the file
+    int64_t m_data_offset;     // file offset of the subimage's pixel data
     // here we store information how many times COMMENT, HISTORY, HIERARCH
     // keywords have occurred
     std::map<std::string, int> keys;
@@ -79,8 +82,9 @@ private:
 
     void init(void)
     {
-        m_fd = NULL;
+        ioproxy_clear();
         m_filename.clear();
+        m_data_offset  = 0;
         m_cur_subimage = 0;
         m_bitpix       = 0;
         m_naxes        = 0;
@@ -103,9 +107,14 @@ private:
 
     // search for subimages: in FITS subimage is a header with SIMPLE keyword
     // or with XTENSION keyword with value 'IMAGE   '. Information about found
-    // subimages are stored in m_subimages
+    // subimages are stored in m_subimages. The data of each HDU is skipped
+    // over rather than read, so only the headers are touched.
     void subimage_search();
 
+    // read scanlines [ybegin,yend) of the current subimage straight into
+    // data, in native (host) byte order.
+    bool read_rows(int ybegin, int yend, void* data);
+
     // set basic info (width, height) of subimage
     // add attributes to ImageSpec
     // return true if ok, false upon error reading the spec from the file.
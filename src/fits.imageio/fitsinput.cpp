@@ -38,43 +38,46 @@ OIIO_PLUGIN_EXPORTS_END
 
 
 bool
-FitsInput::valid_file(const std::string& filename) const
+FitsInput::valid_file(Filesystem::IOProxy* ioproxy) const
 {
-    FILE* fd = Filesystem::fopen(filename, "rb");
-    if (!fd)
+    if (!ioproxy || ioproxy->mode() != Filesystem::IOProxy::Mode::Read)
         return false;
 
     char magic[6] = { 0 };
-    bool ok = (fread(magic, 1, 6, fd) == 6) && !strncmp(magic, "SIMPLE", 6);
-
-    fclose(fd);
-    return ok;
+    return ioproxy->pread(magic, 6, 0) == 6 && !strncmp(magic, "SIMPLE", 6);
 }
 
 
 
 bool
 FitsInput::open(const std::string& name, ImageSpec& spec)
+{
+    ImageSpec config;
+    return open(name, spec, config);
+}
+
+
+
+bool
+FitsInput::open(const std::string& name, ImageSpec& spec,
+                const ImageSpec& config)
 {
     // saving 'name' for later use
     m_filename = name;
 
-    // checking if the file exists and can be opened in READ mode
-    m_fd = Filesystem::fopen(m_filename, "rb");
-    if (!m_fd) {
-        errorfmt("Could not open file \"{}\"", m_filename);
+    ioproxy_retrieve_from_config(config);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     // checking if the file is FITS file
     char magic[6] = { 0 };
-    if (fread(magic, 1, 6, m_fd) != 6 || strncmp(magic, "SIMPLE", 6)) {
+    if (!ioread(magic, 1, 6) || strncmp(magic, "SIMPLE", 6)) {
         errorfmt("{} isn't a FITS file", m_filename);
         close();
         return false;
     }
     // moving back to the start of the file
-    fseek(m_fd, 0, SEEK_SET);
+    ioseek(0);
 
     subimage_search();
 
@@ -94,48 +97,74 @@ FitsInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
     lock_guard lock(*this);
     if (!seek_subimage(subimage, miplevel))
         return false;
+    return read_rows(y, y + 1, data);
+};
+
+
+
+bool
+FitsInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                 int yend, int /*z*/, void* data)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel))
+        return false;
+    yend = std::min(yend, m_spec.y + m_spec.height);
+    if (ybegin >= yend)
+        return true;
+    return read_rows(ybegin, yend, data);
+}
+
 
+
+bool
+FitsInput::read_rows(int ybegin, int yend, void* data)
+{
     // we return true just to support 0x0 images
     if (!m_naxes)
         return true;
 
-    std::vector<unsigned char> data_tmp(m_spec.scanline_bytes());
-    long scanline_off = (m_spec.height - y) * m_spec.scanline_bytes();
-    fseek(m_fd, scanline_off, SEEK_CUR);
-    size_t n = fread(&data_tmp[0], 1, m_spec.scanline_bytes(), m_fd);
-    if (n != m_spec.scanline_bytes()) {
-        if (feof(m_fd))
-            errorfmt("Hit end of file unexpectedly (offset={}, scanline {})",
-                     ftell(m_fd), y);
-        else
-            errorfmt("read error");
+    // The file holds the rows in the opposite order from ours, so the
+    // whole range is one contiguous span of the file, which is read
+    // straight into the caller's buffer and then put in order in place.
+    const size_t sb     = m_spec.scanline_bytes();
+    const size_t nrows  = size_t(yend - ybegin);
+    const size_t nbytes = nrows * sb;
+    const int64_t offset
+        = m_data_offset + int64_t(m_spec.height - (yend - 1)) * int64_t(sb);
+
+    char* buf = (char*)data;
+    size_t n  = ioproxy()->pread(buf, nbytes, offset);
+    if (n != nbytes) {
+        errorfmt("Hit end of file unexpectedly (offset={}, scanlines {}-{})",
+                 offset + int64_t(n), ybegin, yend - 1);
         return false;  // Read failed
     }
+    if (nrows > 1) {
+        std::unique_ptr<char[]> tmp(new char[sb]);
+        for (size_t lo = 0, hi = nrows - 1; lo < hi; ++lo, --hi) {
+            memcpy(tmp.get(), buf + lo * sb, sb);
+            memcpy(buf + lo * sb, buf + hi * sb, sb);
+            memcpy(buf + hi * sb, tmp.get(), sb);
+        }
+    }
 
     // in FITS image data is stored in big-endian so we have to switch to
     // little-endian on little-endian machines
     if (littleendian()) {
         if (m_spec.format == TypeDesc::USHORT
             || m_spec.format == TypeDesc::SHORT)
-            swap_endian((unsigned short*)&data_tmp[0],
-                        data_tmp.size() / sizeof(unsigned short));
+            swap_endian((unsigned short*)buf, nbytes / sizeof(unsigned short));
         else if (m_spec.format == TypeDesc::UINT
                  || m_spec.format == TypeDesc::INT)
-            swap_endian((unsigned int*)&data_tmp[0],
-                        data_tmp.size() / sizeof(unsigned int));
+            swap_endian((unsigned int*)buf, nbytes / sizeof(unsigned int));
         else if (m_spec.format == TypeDesc::FLOAT)
-            swap_endian((float*)&data_tmp[0], data_tmp.size() / sizeof(float));
+            swap_endian((float*)buf, nbytes / sizeof(float));
         else if (m_spec.format == TypeDesc::DOUBLE)
-            swap_endian((double*)&data_tmp[0],
-                        data_tmp.size() / sizeof(double));
+            swap_endian((double*)buf, nbytes / sizeof(double));
     }
-
-    memcpy(data, &data_tmp[0], data_tmp.size());
-
-    // after reading scanline we set file pointer to the start of image data
-    fsetpos(m_fd, &m_filepos);
     return true;
-};
+}
 
 
 
@@ -153,7 +182,7 @@ FitsInput::seek_subimage(int subimage, int miplevel)
 
     // setting file pointer to the beginning of IMAGE extension
     m_cur_subimage = subimage;
-    fseek(m_fd, m_subimages[m_cur_subimage].offset, SEEK_SET);
+    ioseek(m_subimages[m_cur_subimage].offset);
 
     if (!set_spec_info())
         return false;
@@ -179,7 +208,7 @@ FitsInput::set_spec_info()
     // now we can get the current position in the file
     // this is the start of the image data
     // we will need it in the read_native_scanline method
-    fgetpos(m_fd, &m_filepos);
+    m_data_offset = iotell();
 
     if (m_bitpix == 8)
         m_spec.set_format(TypeDesc::UCHAR);
@@ -199,8 +228,6 @@ FitsInput::set_spec_info()
 bool
 FitsInput::close(void)
 {
-    if (m_fd)
-        fclose(m_fd);
     init();
     return true;
 }
@@ -213,13 +240,8 @@ FitsInput::read_fits_header(void)
     std::string fits_header(HEADER_SIZE, 0);
 
     // we read whole header at once
-    if (fread(&fits_header[0], 1, HEADER_SIZE, m_fd) != HEADER_SIZE) {
-        if (feof(m_fd))
-            errorfmt("Hit end of file unexpectedly (offset={})", ftell(m_fd));
-        else
-            errorfmt("read error");
+    if (!ioread(&fits_header[0], 1, HEADER_SIZE))
         return false;  // Read failed
-    }
 
     bool found_end = false;
     for (int i = 0; i < CARDS_PER_HEADER; ++i) {
@@ -382,19 +404,23 @@ FitsInput::add_to_spec(const std::string& keyname, const std::string& value)
 void
 FitsInput::subimage_search()
 {
-    // saving position of the file, just for safe)
-    fpos_t fpos;
-    fgetpos(m_fd, &fpos);
-
-    // starting reading headers from the beginning of the file
-    fseek(m_fd, 0, SEEK_SET);
-
-    // we search for subimages by reading whole header and checking if it
-    // starts by "SIMPLE" keyword (primary header is always image header)
-    // or by "XTENSION= 'IMAGE   '" (it is image extensions)
+    // We walk the HDUs (header + data units) of the file: each header is
+    // one or more blocks of cards ending with END, and tells how big the
+    // data following it is, so we can skip straight to the next header.
+    // An HDU is a subimage if its header starts with the "SIMPLE" keyword
+    // (primary header is always image header) or with
+    // "XTENSION= 'IMAGE   '" (it is image extensions)
+    Filesystem::IOProxy* io = ioproxy();
+    const int64_t filesize  = int64_t(io->size());
     std::string hdu(HEADER_SIZE, 0);
-    size_t offset = 0;
-    while (fread(&hdu[0], 1, HEADER_SIZE, m_fd) == HEADER_SIZE) {
+    int64_t offset = 0;
+    while (offset + HEADER_SIZE <= filesize
+           && io->pread(&hdu[0], HEADER_SIZE, offset) == HEADER_SIZE) {
+        if (strncmp(&hdu[0], "SIMPLE", 6) && strncmp(&hdu[0], "XTENSION", 8)) {
+            // Not a header where one should be; look at the next block
+            offset += HEADER_SIZE;
+            continue;
+        }
         if (!strncmp(&hdu[0], "SIMPLE", 6)
             || !strncmp(&hdu[0], "XTENSION= 'IMAGE   '", 20)) {
             fits_pvt::Subimage newSub;
@@ -402,9 +428,50 @@ FitsInput::subimage_search()
             newSub.offset = offset;
             m_subimages.push_back(newSub);
         }
-        offset += HEADER_SIZE;
+
+        int bitpix = 0;
+        int64_t pcount = 0, gcount = 1;
+        std::vector<int64_t> naxis;
+        bool found_end = false;
+        int64_t pos    = offset;
+        while (!found_end) {
+            if (pos != offset
+                && io->pread(&hdu[0], HEADER_SIZE, pos) != HEADER_SIZE)
+                break;
+            pos += HEADER_SIZE;
+            for (int i = 0; i < CARDS_PER_HEADER && !found_end; ++i) {
+                std::string card(&hdu[i * CARD_SIZE], CARD_SIZE);
+                std::string keyname, value;
+                fits_pvt::unpack_card(card, keyname, value);
+                if (keyname == "END")
+                    found_end = true;
+                else if (keyname == "BITPIX")
+                    bitpix = Strutil::stoi(&card[10]);
+                else if (keyname == "NAXIS")
+                    naxis.resize(clamp(Strutil::stoi(&card[10]), 0, 999));
+                else if (keyname == "PCOUNT")
+                    pcount = Strutil::stoi(&card[10]);
+                else if (keyname == "GCOUNT")
+                    gcount = Strutil::stoi(&card[10]);
+                else if (Strutil::starts_with(keyname, "NAXIS")) {
+                    int a = Strutil::stoi(keyname.substr(5));
+                    if (a > 0 && a <= int(naxis.size()))
+                        naxis[a - 1] = Strutil::stoi(&card[10]);
+                }
+            }
+        }
+        if (!found_end)
+            break;  // truncated header, nothing more to find
+
+        int64_t datasize = 0;
+        if (naxis.size()) {
+            datasize = 1;
+            for (auto n : naxis)
+                datasize *= n;
+            datasize = (std::abs(bitpix) / 8) * gcount * (pcount + datasize);
+        }
+        offset = pos + round_to_multiple(datasize, int64_t(HEADER_SIZE));
     }
-    fsetpos(m_fd, &fpos);
 }
 
 
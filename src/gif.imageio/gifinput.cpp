@@ -2,7 +2,9 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <deque>
 #include <fcntl.h>
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -76,6 +78,19 @@ private:
     std::vector<unsigned char> m_canvas;  ///< Image canvas in output format, on
                                           ///  which subimages are sequentially
                                           ///  drawn.
+    int64_t m_first_frame_offset;    ///< File offset of the first subimage
+
+    /// Everything needed to resume decoding after a given subimage
+    /// without starting over from the first one.
+    struct FrameState {
+        ImageSpec spec;                     ///< Spec of the subimage
+        std::vector<unsigned char> canvas;  ///< Canvas with it drawn
+        int disposal_method;                ///< Its disposal method
+        int64_t next_offset;                ///< File offset of the next one
+    };
+    std::map<int, FrameState> m_snapshots;  ///< Every m_snapshot_interval'th
+    int m_snapshot_interval;                ///<   subimage, within a budget
+    std::deque<std::pair<int, FrameState>> m_recent;  ///< Last few drawn
 
     /// Reset everything to initial state
     ///
@@ -89,6 +104,14 @@ private:
     ///
     bool read_subimage_data(void);
 
+    /// Read the metadata of the subimage following the current one and
+    /// draw it on the canvas, making it the current subimage.
+    bool read_next_subimage(void);
+
+    /// Save the state after drawing the current subimage, as a snapshot
+    /// and/or among the recently drawn, so we can get back to it quickly.
+    void remember_subimage(void);
+
     /// Helper: read gif extension.
     ///
     void read_gif_extension(int ext_code, GifByteType* ext, ImageSpec& spec);
@@ -147,7 +170,11 @@ OIIO_PLUGIN_EXPORTS_END
 void
 GIFInput::init(void)
 {
-    m_gif_file = nullptr;
+    m_gif_file           = nullptr;
+    m_first_frame_offset = 0;
+    m_snapshots.clear();
+    m_recent.clear();
+    m_snapshot_interval = 8;
     ioproxy_clear();
 }
 
@@ -386,6 +413,65 @@ GIFInput::read_subimage_data()
 
 
 
+bool
+GIFInput::read_next_subimage()
+{
+    // read metadata of the next subimage
+    if (!read_subimage_metadata(m_spec)) {
+        return false;
+    }
+
+    m_spec.width       = m_gif_file->SWidth;
+    m_spec.height      = m_gif_file->SHeight;
+    m_spec.depth       = 1;
+    m_spec.full_height = m_spec.height;
+    m_spec.full_width  = m_spec.width;
+    m_spec.full_depth  = m_spec.depth;
+
+    m_subimage += 1;
+
+    // draw subimage on canvas
+    if (!read_subimage_data()) {
+        return false;
+    }
+
+    remember_subimage();
+    return true;
+}
+
+
+
+void
+GIFInput::remember_subimage()
+{
+    // Canvas snapshots of every so many subimages let us get to any
+    // subimage by drawing at most a few others. If the snapshots outgrow
+    // their memory budget, thin them out and space them wider apart.
+    const size_t max_snapshot_bytes = 64 * 1024 * 1024;
+    const size_t max_recent         = 8;
+    FrameState state { m_spec, m_canvas, m_disposal_method, iotell() };
+    if (m_subimage % m_snapshot_interval == 0
+        && !m_snapshots.count(m_subimage)) {
+        m_snapshots[m_subimage] = state;
+        while (m_snapshots.size() > 1
+               && m_snapshots.size() * m_canvas.size() > max_snapshot_bytes) {
+            m_snapshot_interval *= 2;
+            for (auto s = m_snapshots.begin(); s != m_snapshots.end();)
+                s = (s->first % m_snapshot_interval) ? m_snapshots.erase(s)
+                                                     : std::next(s);
+        }
+    }
+    // The last few subimages drawn, for stepping backwards
+    for (auto& r : m_recent)
+        if (r.first == m_subimage)
+            return;
+    m_recent.emplace_back(m_subimage, std::move(state));
+    if (m_recent.size() > max_recent)
+        m_recent.pop_front();
+}
+
+
+
 bool
 GIFInput::seek_subimage(int subimage, int miplevel)
 {
@@ -397,14 +483,6 @@ GIFInput::seek_subimage(int subimage, int miplevel)
         return true;
     }
 
-    if (m_subimage > subimage) {
-        // requested subimage is located before the current one
-        // file needs to be reopened
-        if (m_gif_file && !close()) {
-            return false;
-        }
-    }
-
     if (!m_gif_file) {
         if (!ioproxy_use_or_open(m_filename))
             return false;
@@ -422,36 +500,49 @@ GIFInput::seek_subimage(int subimage, int miplevel)
             return false;
         }
 #endif
-        m_subimage = -1;
+        m_subimage           = -1;
+        m_first_frame_offset = iotell();
         m_canvas.resize(m_gif_file->SWidth * m_gif_file->SHeight * 4);
     }
 
-    // skip subimages preceding the requested one
-    if (m_subimage < subimage) {
-        for (m_subimage += 1; m_subimage < subimage; m_subimage++) {
-            if (!read_subimage_metadata(m_spec) || !read_subimage_data()) {
-                return false;
-            }
+    // Frames are drawn atop the canvas left by the previous ones, so find
+    // the closest subimage at or before the requested one that we can
+    // resume from: the current one, a recently drawn one, or a snapshot.
+    int from                = m_subimage < subimage ? m_subimage : -1;
+    const FrameState* state = nullptr;
+    for (auto& r : m_recent) {
+        if (r.first <= subimage && r.first > from) {
+            from  = r.first;
+            state = &r.second;
         }
     }
-
-    // read metadata of current subimage
-    if (!read_subimage_metadata(m_spec)) {
-        return false;
+    auto snap = m_snapshots.upper_bound(subimage);
+    if (snap != m_snapshots.begin() && (--snap)->first > from) {
+        from  = snap->first;
+        state = &snap->second;
+    }
+    if (state) {
+        m_spec            = state->spec;
+        m_canvas          = state->canvas;
+        m_disposal_method = state->disposal_method;
+        if (!ioseek(state->next_offset))
+            return false;
+        m_subimage = from;
+    } else if (from < 0) {
+        // Start over from the first subimage
+        if (!ioseek(m_first_frame_offset))
+            return false;
+        m_disposal_method = DISPOSAL_UNSPECIFIED;
+        m_subimage        = -1;
     }
 
-    m_spec.width       = m_gif_file->SWidth;
-    m_spec.height      = m_gif_file->SHeight;
-    m_spec.depth       = 1;
-    m_spec.full_height = m_spec.height;
-    m_spec.full_width  = m_spec.width;
-    m_spec.full_depth  = m_spec.depth;
-
-    m_subimage = subimage;
-
-    // draw subimage on canvas
-    if (!read_subimage_data()) {
-        return false;
+    // draw the subimages up to and including the requested one
+    while (m_subimage < subimage) {
+        if (!read_next_subimage()) {
+            // The canvas is only partly drawn, don't resume from it
+            m_subimage = -1;
+            return false;
+        }
     }
 
     return true;
@@ -500,6 +591,9 @@ GIFInput::close(void)
         m_gif_file = nullptr;
     }
     m_canvas.clear();
+    m_snapshots.clear();
+    m_recent.clear();
+    m_snapshot_interval = 8;
     ioproxy_clear();
     return ok;
 }
@@ -3,12 +3,17 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/simd.h>
 
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
@@ -47,6 +52,8 @@ public:
               const ImageSpec& config) override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin, int yend,
+                               int z, void* data) override;
     bool close() override;
     int current_subimage(void) const override { return m_subimage; }
     bool seek_subimage(int subimage, int miplevel) override;
@@ -54,21 +61,20 @@ public:
 private:
     std::string m_filename;  // File name
     int m_subimage;          // What subimage are we looking at?
-    int m_next_scanline;     // Next scanline to read
-    std::vector<int64_t> m_scanline_offsets;  // Cached scanline offsets
+    // File offsets of the scanlines found so far, plus that of the end of
+    // the last one found.
+    std::vector<int64_t> m_scanline_offsets;
 
     void init()
     {
-        m_subimage      = -1;
-        m_next_scanline = 0;
+        m_subimage = -1;
         m_scanline_offsets.clear();
         ioproxy_clear();
     }
 
     bool RGBE_ReadHeader();
-    bool RGBE_ReadPixels(float* data, int y, uint64_t numpixels);
-    bool RGBE_ReadPixels_RLE(float* data, int y, uint64_t scanline_width,
-                             int num_scanlines);
+    // Decode scanlines [ybegin,yend) into data.
+    bool RGBE_ReadScanlines(int ybegin, int yend, float* data);
 
     // helper: fgets reads a "line" from the proxy, akin to std fgets. The
     // bytes go in the buffer, and part up to and including the new line is
@@ -187,18 +193,137 @@ static const float exponent_table[256] = {
 };
 
 
-/* standard conversion from rgbe to float pixels */
-inline void
-rgbe2float(float& red, float& green, float& blue, unsigned char rgbe[4])
+// Scale that turns the mantissas of an RGBE pixel with exponent e into
+// floats. A zero exponent means black.
+inline float
+rgbe_scale(unsigned char e)
 {
-    if (rgbe[3]) { /*nonzero pixel*/
-        float f = exponent_table[rgbe[3]];
-        red     = rgbe[0] * f;
-        green   = rgbe[1] * f;
-        blue    = rgbe[2] * f;
-    } else {
-        red = green = blue = 0.0f;
+    return e ? exponent_table[e] : 0.0f;
+}
+
+
+
+// Convert n RGBE pixels, stored one after another, to RGB floats.
+static void
+rgbe_to_float(const unsigned char* rgbe, float* rgb, int n)
+{
+    using namespace simd;
+    for (int i = 0; i < n; ++i, rgbe += 4, rgb += 3) {
+        vfloat4 p = vfloat4(rgbe) * vfloat4(rgbe_scale(rgbe[3]));
+        p.store(rgb, 3);
+    }
+}
+
+
+
+// Convert a scanline of RGBE pixels stored as four planes (all the R
+// mantissas, then G, B, and the exponents) to RGB floats, four at a time.
+static void
+rgbe_planes_to_float(const unsigned char* planes, int width, float* rgb)
+{
+    using namespace simd;
+    const unsigned char* r = planes;
+    const unsigned char* g = r + width;
+    const unsigned char* b = g + width;
+    const unsigned char* e = b + width;
+    int x                  = 0;
+    for (; x + 4 <= width; x += 4, rgb += 12) {
+        vfloat4 scale(rgbe_scale(e[x]), rgbe_scale(e[x + 1]),
+                      rgbe_scale(e[x + 2]), rgbe_scale(e[x + 3]));
+        vfloat4 p0 = vfloat4(r + x) * scale;
+        vfloat4 p1 = vfloat4(g + x) * scale;
+        vfloat4 p2 = vfloat4(b + x) * scale;
+        vfloat4 p3 = vfloat4::Zero();
+        transpose(p0, p1, p2, p3);  // now one pixel in each
+        // Each store's 4th lane is overwritten by the next pixel.
+        p0.store(rgb);
+        p1.store(rgb + 3);
+        p2.store(rgb + 6);
+        p3.store(rgb + 9, 3);
+    }
+    for (; x < width; ++x, rgb += 3) {
+        float scale = rgbe_scale(e[x]);
+        rgb[0]      = r[x] * scale;
+        rgb[1]      = g[x] * scale;
+        rgb[2]      = b[x] * scale;
+    }
+}
+
+
+
+// Is the scanline at p (with avail bytes of the file left) run length
+// encoded? Such scanlines start with 2, 2, and the width. Anything else,
+// or any scanline of a width the encoding doesn't allow, is stored flat.
+inline bool
+rgbe_row_is_rle(const unsigned char* p, size_t avail, int width)
+{
+    return width >= 8 && width <= 0x7fff && avail >= 4 && p[0] == 2
+           && p[1] == 2 && !(p[2] & 0x80);
+}
+
+
+
+// Return the number of bytes the encoded scanline at p occupies in the
+// file, or 0 if it's corrupt or runs past the avail bytes we have.
+static size_t
+rgbe_row_size(const unsigned char* p, size_t avail, int width)
+{
+    if (!rgbe_row_is_rle(p, avail, width)) {
+        size_t flat = 4 * size_t(width);
+        return flat <= avail ? flat : 0;
+    }
+    if ((int(p[2]) << 8 | p[3]) != width)
+        return 0;
+    // Each of the four planes is a series of runs (count+128, value) and
+    // literal stretches (count, count values).
+    size_t pos = 4;
+    for (int c = 0; c < 4; ++c) {
+        for (int n = 0; n < width;) {
+            if (pos + 2 > avail)
+                return 0;
+            int count = p[pos];
+            if (count > 128) {
+                count -= 128;
+                pos += 2;
+            } else {
+                pos += 1 + count;
+            }
+            if (count == 0 || count > width - n || pos > avail)
+                return 0;
+            n += count;
+        }
+    }
+    return pos;
+}
+
+
+
+// Decode one scanline (already checked by rgbe_row_size) into RGB floats,
+// using planes (4*width bytes) as scratch space for RLE scanlines.
+static void
+rgbe_decode_row(const unsigned char* p, size_t size, int width, float* rgb,
+                unsigned char* planes)
+{
+    if (!rgbe_row_is_rle(p, size, width)) {
+        rgbe_to_float(p, rgb, width);
+        return;
+    }
+    p += 4;
+    unsigned char* q   = planes;
+    unsigned char* end = planes + 4 * size_t(width);
+    while (q < end) {
+        int count = *p;
+        if (count > 128) {
+            count -= 128;
+            memset(q, p[1], count);
+            p += 2;
+        } else {
+            memcpy(q, p + 1, count);
+            p += 1 + count;
+        }
+        q += count;
     }
+    rgbe_planes_to_float(planes, width, rgb);
 }
 
 
@@ -250,7 +375,6 @@ HdrInput::open(const std::string& name, ImageSpec& newspec)
     // FIXME -- should we do anything about exposure, software,
     // pixaspect, primaries?  (N.B. rgbe.c doesn't even handle most of them)
 
-    m_next_scanline = 0;
     m_scanline_offsets.clear();
     m_scanline_offsets.push_back(iotell());
 
@@ -375,103 +499,64 @@ HdrInput::RGBE_ReadHeader()
 
 
 
-/* simple read routine.  will not correctly handle run length encoding */
+// Read and decode scanlines [ybegin,yend) into data as float RGB, handling
+// both flat and run-length encoded scanlines. The file offsets of the
+// scanlines found along the way are cached, and the rows are decoded in
+// parallel once all their bytes are in memory.
 bool
-HdrInput::RGBE_ReadPixels(float* data, int y, uint64_t numpixels)
+HdrInput::RGBE_ReadScanlines(int ybegin, int yend, float* data)
 {
-    size_t size = 4 * numpixels;
-    unsigned char* rgbe;
-    OIIO_ALLOCATE_STACK_OR_HEAP(rgbe, unsigned char, size);
-    if (ioproxy()->read(rgbe, size) != size) {
-        errorfmt("Read error reading pixels on scanline {}", y);
+    int width = m_spec.width;
+    // Start from the last scanline at or before ybegin whose position in
+    // the file we know.
+    int y0       = std::min(ybegin, int(m_scanline_offsets.size()) - 1);
+    int64_t base = m_scanline_offsets[y0];
+    int64_t nbytes;
+    if (size_t(yend) < m_scanline_offsets.size()) {
+        nbytes = m_scanline_offsets[yend] - base;
+    } else {
+        // Read enough for the worst case RLE expansion (every run of
+        // length 1), but not past the end of the file.
+        nbytes = std::min(int64_t(yend - y0) * (8 * int64_t(width) + 4),
+                          int64_t(ioproxy()->size()) - base);
+    }
+    if (nbytes <= 0) {
+        errorfmt("Read error on scanline {}", ybegin);
         return false;
     }
-    for (uint64_t i = 0; i < numpixels; ++i)
-        rgbe2float(data[3 * i], data[3 * i + 1], data[3 * i + 2], &rgbe[4 * i]);
-    return true;
-}
-
-
-
-bool
-HdrInput::RGBE_ReadPixels_RLE(float* data, int y, uint64_t scanline_width,
-                              int num_scanlines)
-{
-    if ((scanline_width < 8) || (scanline_width > 0x7fff))
-        /* run length encoding is not allowed so read flat*/
-        return RGBE_ReadPixels(data, y, scanline_width * num_scanlines);
-
-    unsigned char rgbe[4], *ptr, *ptr_end;
-    int count;
-    unsigned char buf[2];
-    std::vector<unsigned char> scanline_buffer;
-    Filesystem::IOProxy* m_io = ioproxy();
-
-    /* read in each successive scanline */
-    while (num_scanlines > 0) {
-        if (m_io->read(rgbe, sizeof(rgbe)) < sizeof(rgbe)) {
-            errorfmt("Read error on scanline {}", y);
+    std::unique_ptr<unsigned char[]> buf(new unsigned char[nbytes]);
+    nbytes = int64_t(ioproxy()->pread(buf.get(), nbytes, base));
+
+    // Find the start of each scanline we haven't located yet.
+    for (int y = y0; y < yend; ++y) {
+        if (size_t(y + 1) < m_scanline_offsets.size())
+            continue;
+        size_t pos  = size_t(m_scanline_offsets[y] - base);
+        size_t size = rgbe_row_size(buf.get() + pos, size_t(nbytes) - pos,
+                                    width);
+        if (!size) {
+            errorfmt("Read error or bad data on scanline {}", y);
             return false;
         }
-        if ((rgbe[0] != 2) || (rgbe[1] != 2) || (rgbe[2] & 0x80)) {
-            /* this file is not run length encoded */
-            rgbe2float(data[0], data[1], data[2], rgbe);
-            data += 3;
-            return RGBE_ReadPixels(data, y, scanline_width * num_scanlines - 1);
-        }
-        if ((((uint64_t)rgbe[2]) << 8 | rgbe[3]) != scanline_width) {
-            errorfmt("wrong scanline width for scanline {}", y);
-            return false;
-        }
-        scanline_buffer.resize(4 * scanline_width);
-
-        ptr = scanline_buffer.data();
-        /* read each of the four channels for the scanline into the buffer */
-        for (int i = 0; i < 4; i++) {
-            ptr_end = scanline_buffer.data() + (i + 1) * scanline_width;
-            while (ptr < ptr_end) {
-                if (m_io->read(buf, 2) < 2) {
-                    errorfmt("Read error on scanline {}", y);
-                    return false;
-                }
-                if (buf[0] > 128) {
-                    /* a run of the same value */
-                    count = buf[0] - 128;
-                    if ((count == 0) || (count > ptr_end - ptr)) {
-                        errorfmt("bad scanline {} data", y);
-                        return false;
-                    }
-                    while (count-- > 0)
-                        *ptr++ = buf[1];
-                } else {
-                    /* a non-run */
-                    count = buf[0];
-                    if ((count == 0) || (count > ptr_end - ptr)) {
-                        errorfmt("bad scanline {} data", y);
-                        return false;
-                    }
-                    *ptr++ = buf[1];
-                    if (--count > 0) {
-                        if (m_io->read(ptr, count) < uint64_t(count)) {
-                            errorfmt("Read error on scanline {}", y);
-                            return false;
-                        }
-                        ptr += count;
-                    }
-                }
-            }
-        }
-        /* now convert data from buffer into floats */
-        for (uint64_t i = 0; i < scanline_width; i++) {
-            rgbe[0] = scanline_buffer[i];
-            rgbe[1] = scanline_buffer[i + scanline_width];
-            rgbe[2] = scanline_buffer[i + 2 * scanline_width];
-            rgbe[3] = scanline_buffer[i + 3 * scanline_width];
-            rgbe2float(data[0], data[1], data[2], rgbe);
-            data += 3;
-        }
-        num_scanlines--;
+        m_scanline_offsets.push_back(m_scanline_offsets[y] + int64_t(size));
     }
+
+    // Now every scanline's bytes are in memory, so they can be decoded
+    // independently of each other.
+    parallel_for_chunked(
+        ybegin, yend, 0,
+        [&](int64_t yb, int64_t ye) {
+            std::unique_ptr<unsigned char[]> planes(
+                new unsigned char[4 * size_t(width)]);
+            for (int64_t y = yb; y < ye; ++y) {
+                int64_t offset = m_scanline_offsets[y];
+                rgbe_decode_row(buf.get() + (offset - base),
+                                size_t(m_scanline_offsets[y + 1] - offset),
+                                width, data + (y - ybegin) * 3 * width,
+                                planes.get());
+            }
+        },
+        paropt(threads(), paropt::SplitDir::Y, 8));
     return true;
 }
 
@@ -484,25 +569,23 @@ HdrInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
     lock_guard lock(*this);
     if (!seek_subimage(subimage, miplevel))
         return false;
+    // Cached file offsets of scanlines make random access cheap.
+    return RGBE_ReadScanlines(y, y + 1, (float*)data);
+}
 
-    if (m_next_scanline != y) {
-        // For random access, use cached file offsets of scanlines. This avoids
-        // re-reading the same pixels many times over.
-        m_next_scanline = std::min((size_t)y, m_scanline_offsets.size() - 1);
-        ioseek(m_scanline_offsets[m_next_scanline]);
-    }
 
-    while (m_next_scanline <= y) {
-        // Keep reading until we've read the scanline we really need
-        bool ok = RGBE_ReadPixels_RLE((float*)data, y, m_spec.width, 1);
-        ++m_next_scanline;
-        if ((size_t)m_next_scanline == m_scanline_offsets.size()) {
-            m_scanline_offsets.push_back(iotell());
-        }
-        if (!ok)
-            return false;
-    }
-    return true;
+
+bool
+HdrInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                int yend, int /*z*/, void* data)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel))
+        return false;
+    yend = std::min(yend, m_spec.y + m_spec.height);
+    if (ybegin >= yend)
+        return true;
+    return RGBE_ReadScanlines(ybegin, yend, (float*)data);
 }
 
 
@@ -6,6 +6,8 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/tiffutils.h>
 
+#include "imageio_pvt.h"
+
 #include <libheif/heif_cxx.h>
 
 #define MAKE_LIBHEIF_VERSION(a, b, c, d) \
@@ -145,6 +147,15 @@ HeifInput::open(const std::string& name, ImageSpec& newspec,
     m_himage  = heif::Image();
     m_ihandle = heif::ImageHandle();
 
+#if LIBHEIF_HAVE_VERSION(1, 13, 0)
+    // libheif decodes tiles and grid cells with its own threads. Cap them
+    // like our own, and use none when we're already inside a pool worker.
+    // (Same cast as below: heif::Context is just a shared_ptr<heif_context>.)
+    heif_context_set_max_decoding_threads(
+        reinterpret_cast<std::shared_ptr<heif_context>*>(m_ctx.get())->get(),
+        pvt::codec_threads(threads()));
+#endif
+
     m_keep_unassociated_alpha
         = (config.get_int_attribute("oiio:UnassociatedAlpha") != 0);
     m_reorient = config.get_int_attribute("oiio:reorient", 1);
@@ -3,10 +3,14 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <iterator>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -17,6 +21,7 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/thread.h>
 
 
 using namespace OIIO;
@@ -27,7 +32,9 @@ static std::string dataformatname = "";
 static float gammaval             = 1.0f;
 //static bool depth = false;
 static bool verbose = false;
-static int nthreads = 0;  // default: use #cores threads if available
+static int nthreads       = 0;  // default: use #cores threads if available
+static int parallel_files = 0;  // default: one file per thread
+static int max_memory_MB  = 0;  // default: half of physical memory
 static std::vector<std::string> filenames;
 static int tile[3]   = { 0, 0, 1 };
 static bool scanline = false;
@@ -70,11 +77,15 @@ getargs(int argc, char* argv[])
     ap.options ("iconvert -- copy images with format conversions and other alterations\n"
                 OIIO_INTRO_STRING "\n"
                 "Usage:  iconvert [options] inputfile outputfile\n"
+                "   or:  iconvert [options] in1 out1 in2 out2 ...\n"
+                "   or:  iconvert [options] in.#.ext out.#.ext\n"
                 "   or:  iconvert --inplace [options] file...\n",
                 "%*", parse_files, "",
                 "--help", &help, "Print help message",
                 "-v", &verbose, "Verbose status messages",
                 "--threads %d:NTHREADS", &nthreads, "Number of threads (default 0 = #cores)",
+                "--parallel-files %d:N", &parallel_files, "Number of files to convert at once (default 0 = one per thread)",
+                "--max-memory %d:MB", &max_memory_MB, "Limit on pixel memory held by files being converted at once (default 0 = half of RAM)",
                 "-d %s:TYPE", &dataformatname, "Set the output data format to one of:"
                         "uint8, sint8, uint10, uint12, uint16, sint16, half, float, double",
                 "-g %f:GAMMA", &gammaval, "Set gamma correction (default = 1.0)",
@@ -116,7 +127,7 @@ getargs(int argc, char* argv[])
         return;
     }
 
-    if (filenames.size() != 2 && !inplace) {
+    if ((filenames.empty() || filenames.size() % 2) && !inplace) {
         print(
             stderr,
             "iconvert: Must have both an input and output filename specified.\n");
@@ -262,19 +273,21 @@ adjust_spec(ImageInput* in, ImageOutput* out, const ImageSpec& inspec,
     if (separate)
         outspec.attribute("planarconfig", "separate");
 
+    // Files may be converted concurrently, so the rotation is worked out
+    // per file rather than stored back into the global.
     if (orientation >= 1)
         outspec.attribute("Orientation", orientation);
     else {
-        orientation = outspec.get_int_attribute("Orientation", 1);
-        if (orientation >= 1 && orientation <= 8) {
-            static int cw[] = { 0, 6, 7, 8, 5, 2, 3, 4, 1 };
+        int orient = outspec.get_int_attribute("Orientation", 1);
+        if (orient >= 1 && orient <= 8) {
+            static const int cw[] = { 0, 6, 7, 8, 5, 2, 3, 4, 1 };
             if (rotcw || rotccw || rot180)
-                orientation = cw[orientation];
+                orient = cw[orient];
             if (rotccw || rot180)
-                orientation = cw[orientation];
+                orient = cw[orient];
             if (rotccw)
-                orientation = cw[orientation];
-            outspec.attribute("Orientation", orientation);
+                orient = cw[orient];
+            outspec.attribute("Orientation", orient);
         }
     }
 
@@ -310,6 +323,40 @@ adjust_spec(ImageInput* in, ImageOutput* out, const ImageSpec& inspec,
 
 
 
+// The --max-memory budget. A conversion reserves an estimate of the pixel
+// memory it will hold before it starts moving pixels, waiting while the
+// conversions already in flight would take the total over the limit. One
+// that alone is over the limit still runs, just by itself.
+static std::mutex budget_mutex;
+static std::condition_variable budget_cv;
+static imagesize_t budget_limit = 0;
+static imagesize_t budget_used  = 0;
+
+struct MemoryReservation {
+    MemoryReservation(imagesize_t bytes)
+        : m_bytes(bytes)
+    {
+        std::unique_lock<std::mutex> lock(budget_mutex);
+        budget_cv.wait(lock, [&]() {
+            return budget_used == 0 || budget_used + m_bytes <= budget_limit;
+        });
+        budget_used += m_bytes;
+    }
+    ~MemoryReservation()
+    {
+        {
+            std::lock_guard<std::mutex> lock(budget_mutex);
+            budget_used -= m_bytes;
+        }
+        budget_cv.notify_all();
+    }
+
+private:
+    imagesize_t m_bytes;
+};
+
+
+
 static bool
 convert_file(const std::string& in_filename, const std::string& out_filename)
 {
@@ -352,6 +399,13 @@ convert_file(const std::string& in_filename, const std::string& out_filename)
         return false;
     }
 
+    // The largest buffers are the input and output pixels of the first
+    // subimage, so reserve that much of the memory budget.
+    ImageSpec firstspec = inspec;
+    adjust_spec(in.get(), out.get(), inspec, firstspec);
+    MemoryReservation reservation(inspec.image_bytes(true)
+                                  + firstspec.image_bytes(true));
+
     // In order to deal with formats that support subimages, but not
     // subimage appending, we gather them all first.
     std::vector<ImageSpec> subimagespecs;
@@ -504,6 +558,75 @@ convert_file(const std::string& in_filename, const std::string& out_filename)
 
 
 
+// Expand an input and output frame sequence pattern, such as "in.#.exr"
+// and "out.#.tif", into matching lists of file names. Without an explicit
+// frame range, the frames are whichever input files exist.
+static bool
+expand_sequence(const std::string& inpattern, const std::string& outpattern,
+                std::vector<std::string>& infiles,
+                std::vector<std::string>& outfiles)
+{
+    std::string innorm, inframes, outnorm, outframes;
+    if (!Filesystem::parse_pattern(outpattern.c_str(), 0, outnorm,
+                                   outframes)) {
+        print(stderr,
+              "iconvert ERROR: Output \"{}\" must be a sequence pattern to "
+              "match input \"{}\"\n",
+              outpattern, inpattern);
+        return false;
+    }
+    Filesystem::parse_pattern(inpattern.c_str(), 0, innorm, inframes);
+    std::vector<int> frames;
+    bool ok;
+    if (inframes.size())
+        ok = Filesystem::enumerate_sequence(inframes, frames)
+             && Filesystem::enumerate_file_sequence(innorm, frames, infiles);
+    else
+        ok = Filesystem::scan_for_matching_filenames(innorm, frames, infiles);
+    if (!ok || infiles.empty()) {
+        print(stderr, "iconvert ERROR: No files match \"{}\"\n", inpattern);
+        return false;
+    }
+    return Filesystem::enumerate_file_sequence(outnorm, frames, outfiles);
+}
+
+
+
+// Convert each of infiles to the corresponding outfiles. Several files are
+// converted at once, each on its own thread, so that reading one overlaps
+// with converting and compressing others; the work within each image still
+// shares the thread pool. Return true if every conversion succeeded.
+static bool
+convert_files(const std::vector<std::string>& infiles,
+              const std::vector<std::string>& outfiles)
+{
+    budget_limit = max_memory_MB > 0 ? imagesize_t(max_memory_MB) << 20
+                                     : Sysutil::physical_memory() / 2;
+    size_t njobs = parallel_files > 0 ? size_t(parallel_files)
+                   : nthreads > 0     ? size_t(nthreads)
+                                      : Sysutil::hardware_concurrency();
+    njobs        = std::max(size_t(1), std::min(njobs, infiles.size()));
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool> ok(true);
+    auto worker = [&]() {
+        for (size_t i; (i = next++) < infiles.size();)
+            if (!convert_file(infiles[i], outfiles[i]))
+                ok = false;
+    };
+    if (njobs == 1) {
+        worker();
+    } else {
+        thread_group workers;
+        for (size_t j = 0; j < njobs; ++j)
+            workers.create_thread(worker);
+        workers.join_all();
+    }
+    return ok;
+}
+
+
+
 int
 main(int argc, char* argv[])
 {
@@ -519,13 +642,23 @@ main(int argc, char* argv[])
     OIIO::attribute("threads", nthreads);
 
     bool ok = true;
-
+    std::vector<std::string> infiles, outfiles;
+    std::string norm, frames;
     if (inplace) {
-        for (auto&& s : filenames)
-            ok &= convert_file(s, s);
+        infiles  = filenames;
+        outfiles = filenames;
+    } else if (filenames.size() == 2 && !Filesystem::exists(filenames[0])
+               && Filesystem::parse_pattern(filenames[0].c_str(), 0, norm,
+                                            frames)) {
+        ok = expand_sequence(filenames[0], filenames[1], infiles, outfiles);
     } else {
-        ok = convert_file(filenames[0], filenames[1]);
+        for (size_t i = 0; i + 1 < filenames.size(); i += 2) {
+            infiles.push_back(filenames[i]);
+            outfiles.push_back(filenames[i + 1]);
+        }
     }
+    if (ok)
+        ok = convert_files(infiles, outfiles);
     shutdown();
     return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
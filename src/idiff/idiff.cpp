@@ -3,6 +3,7 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -10,6 +11,7 @@
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <set>
 
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/dassert.h>
@@ -18,6 +20,8 @@
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
 
 
@@ -35,6 +39,37 @@ enum idiffErrors {
 };
 
 
+static bool verbose       = false;
+static bool quiet         = false;
+static bool compareall    = false;
+static bool outdiffonly   = false;
+static bool diffabs       = false;
+static bool perceptual    = false;
+static float diffscale    = 1.0f;
+static float failthresh   = 1.0e-6f;
+static float failrelative = 0.0f;
+static float failpercent  = 0.0f;
+static float hardfail     = std::numeric_limits<float>::infinity();
+static float warnthresh   = 1.0e-6f;
+static float warnrelative = 0.0f;
+static float warnpercent  = 0.0f;
+static float hardwarn     = std::numeric_limits<float>::infinity();
+static int allowfailures  = 0;
+static int stopafter      = 0;
+static bool quick         = false;
+static std::string diffimage;
+
+
+// What batch mode reports about one pair of images.
+struct PairResult {
+    int ret           = ErrOK;
+    double maxerror   = 0.0;
+    imagesize_t nwarn = 0;
+    imagesize_t nfail = 0;
+    std::string error;
+};
+
+
 
 static ArgParse
 getargs(int argc, char* argv[])
@@ -43,7 +78,9 @@ getargs(int argc, char* argv[])
     ArgParse ap;
     ap.intro("idiff -- compare two images\n"
              OIIO_INTRO_STRING)
-      .usage("idiff [options] <image1> <image2 | directory>")
+      .usage("idiff [options] <image1> <image2 | directory>\n"
+             "       idiff [options] <directory1> <directory2>\n"
+             "       idiff [options] -batch <manifest>")
       .add_version(OIIO_VERSION_STRING)
       .print_defaults(true);
 
@@ -56,6 +93,13 @@ getargs(int argc, char* argv[])
       .help("Quiet (minimal messages)");
     ap.arg("-a")
       .help("Compare all subimages/miplevels");
+    ap.arg("-batch")
+      .help("Compare the pairs of images listed in this file, one pair per line")
+      .metavar("MANIFEST");
+    ap.arg("-threads")
+      .help("Number of threads, which in batch mode compare pairs concurrently (0 = all cores)")
+      .metavar("N")
+      .defaultval(0);
 
     ap.separator("Thresholding and comparison options");
     ap.arg("-fail")
@@ -96,6 +140,12 @@ getargs(int argc, char* argv[])
       .defaultval(std::numeric_limits<float>::infinity());
     ap.arg("-p")
       .help("Perform perceptual (rather than numeric) comparison");
+    ap.arg("-stopafter")
+      .help("Stop comparing once this many pixels fail, or as soon as failure is certain (0 = compare all pixels)")
+      .metavar("N")
+      .defaultval(0);
+    ap.arg("-quick")
+      .help("Only numerically compare bands of scanlines whose pixels are not bit-identical");
 
     ap.separator("Difference image options");
     ap.arg("-o")
@@ -118,9 +168,12 @@ getargs(int argc, char* argv[])
 
 
 
+// Read the subimage and MIP level of the file into img (through the
+// cache), unless it's already there. On failure, the error goes into
+// `error` if it's given, otherwise it's printed.
 static bool
 read_input(const std::string& filename, ImageBuf& img, ImageCache* cache,
-           int subimage = 0, int miplevel = 0)
+           int subimage = 0, int miplevel = 0, std::string* error = nullptr)
 {
     if (img.subimage() >= 0 && img.subimage() == subimage
         && img.miplevel() == miplevel)
@@ -130,8 +183,12 @@ read_input(const std::string& filename, ImageBuf& img, ImageCache* cache,
     if (img.read(subimage, miplevel, false, TypeFloat))
         return true;
 
-    print(stderr, "idiff ERROR: Could not read {}:\n\t{}\n", filename,
-          img.geterror());
+    if (error)
+        *error = Strutil::fmt::format("Could not read {}: {}", filename,
+                                      img.geterror());
+    else
+        print(stderr, "idiff ERROR: Could not read {}:\n\t{}\n", filename,
+              img.geterror());
     return false;
 }
 
@@ -188,66 +245,18 @@ add_filename_to_directory(const std::string& first, std::string& second)
 }
 
 
-int
-main(int argc, char* argv[])
+// Compare the two files. If `batch` is given, the results are stored there
+// rather than printed, so that many pairs can be compared concurrently.
+static int
+compare_files(const std::string& file0, const std::string& file1,
+              ImageCache* imagecache, PairResult* batch = nullptr)
 {
-    // Helpful for debugging to make sure that any crashes dump a stack
-    // trace.
-    Sysutil::setup_crash_stacktrace("stdout");
-
-    Filesystem::convert_native_arguments(argc, (const char**)argv);
-    ArgParse ap = getargs(argc, argv);
-
-    std::vector<std::string> filenames = ap["filename"].as_vec<std::string>();
-    if (filenames.size() == 2) {
-        add_filename_to_directory(filenames[0], filenames[1]);
-    } else {
-        print(stderr, "idiff: Must have two input filenames.\n");
-        print(stderr, "> {}\n", Strutil::join(filenames, ", "));
-        ap.usage();
-        return EXIT_FAILURE;
-    }
-    bool verbose          = ap["v"].get<int>();
-    bool quiet            = ap["q"].get<int>();
-    bool compareall       = ap["a"].get<int>();
-    bool outdiffonly      = ap["od"].get<int>();
-    bool diffabs          = ap["abs"].get<int>();
-    bool perceptual       = ap["p"].get<int>();
-    std::string diffimage = ap["o"].get();
-    float diffscale       = ap["scale"].get<float>();
-    float failthresh      = ap["fail"].get<float>();
-    float failrelative    = ap["failrelative"].get<float>();
-    float failpercent     = ap["failpercent"].get<float>();
-    float hardfail        = ap["hardfail"].get<float>();
-    float warnthresh      = ap["warn"].get<float>();
-    float warnrelative    = ap["warnrelative"].get<float>();
-    float warnpercent     = ap["warnpercent"].get<float>();
-    float hardwarn        = ap["hardwarn"].get<float>();
-    int allowfailures     = ap["allowfailures"].get<int>();
-
-    if (!quiet) {
-        print("Comparing \"{}\" and \"{}\"\n", filenames[0], filenames[1]);
-        fflush(stdout);
-    }
-
-    // Create a private ImageCache so we can customize its cache size
-    // and instruct it store everything internally as floats.
-    ImageCache* imagecache = ImageCache::create(true);
-    imagecache->attribute("forcefloat", 1);
-    if (sizeof(void*) == 4)  // 32 bit or 64?
-        imagecache->attribute("max_memory_MB", 512.0);
-    else
-        imagecache->attribute("max_memory_MB", 2048.0);
-    imagecache->attribute("autotile", 256);
-    // force a full diff, even for files tagged with the same
-    // fingerprint, just in case some mistake has been made.
-    imagecache->attribute("deduplicate", 0);
-
+    bool report = (batch == nullptr);
     ImageBuf img0, img1;
-    if (!read_input(filenames[0], img0, imagecache)
-        || !read_input(filenames[1], img1, imagecache))
+    std::string* error = batch ? &batch->error : nullptr;
+    if (!read_input(file0, img0, imagecache, 0, 0, error)
+        || !read_input(file1, img1, imagecache, 0, 0, error))
         return ErrFile;
-    //    ImageSpec spec0 = img0.spec();  // stash it
 
     int ret = ErrOK;
     for (int subimage = 0; subimage < img0.nsubimages(); ++subimage) {
@@ -256,14 +265,15 @@ main(int argc, char* argv[])
         if (subimage >= img1.nsubimages())
             break;
 
-        if (!read_input(filenames[0], img0, imagecache, subimage)
-            || !read_input(filenames[1], img1, imagecache, subimage)) {
-            print(stderr, "Failed to read subimage {}\n", subimage);
+        if (!read_input(file0, img0, imagecache, subimage, 0, error)
+            || !read_input(file1, img1, imagecache, subimage, 0, error)) {
+            if (report)
+                print(stderr, "Failed to read subimage {}\n", subimage);
             return ErrFile;
         }
 
         if (img0.nmiplevels() != img1.nmiplevels()) {
-            if (!quiet)
+            if (report && !quiet)
                 print("Files do not match in their number of MIPmap levels\n");
         }
 
@@ -271,19 +281,25 @@ main(int argc, char* argv[])
             if (m > 0 && !compareall)
                 break;
             if (m > 0 && img0.nmiplevels() != img1.nmiplevels()) {
-                print(stderr,
-                      "Files do not match in their number of MIPmap levels\n");
+                if (report)
+                    print(stderr, "Files do not match in their number of "
+                                  "MIPmap levels\n");
+                else
+                    batch->error = "different numbers of MIPmap levels";
                 ret = ErrDifferentSize;
                 break;
             }
 
-            if (!read_input(filenames[0], img0, imagecache, subimage, m)
-                || !read_input(filenames[1], img1, imagecache, subimage, m))
+            if (!read_input(file0, img0, imagecache, subimage, m, error)
+                || !read_input(file1, img1, imagecache, subimage, m, error))
                 return ErrFile;
 
             if (img0.deep() != img1.deep()) {
-                print(stderr,
-                      "One image contains deep data, the other does not\n");
+                if (report)
+                    print(stderr,
+                          "One image contains deep data, the other does not\n");
+                else
+                    batch->error = "only one image contains deep data";
                 ret = ErrDifferentSize;
                 break;
             }
@@ -296,8 +312,16 @@ main(int argc, char* argv[])
 
             // Compare the two images.
             //
+            // When stopping early, never stop before enough pixels have
+            // failed to make the verdict a failure.
+            imagesize_t maxfailures = 0;
+            if (stopafter > 0)
+                maxfailures = std::max(
+                    { imagesize_t(stopafter), imagesize_t(allowfailures) + 1,
+                      imagesize_t(failpercent / 100.0 * npels) + 1 });
             auto cr = ImageBufAlgo::compare(img0, img1, failthresh, warnthresh,
-                                            failrelative, warnrelative);
+                                            failrelative, warnrelative,
+                                            maxfailures, quick);
 
             int yee_failures = 0;
             if (perceptual && !img0.deep()) {
@@ -317,10 +341,15 @@ main(int argc, char* argv[])
                 if (ret != ErrFail)
                     ret = ErrWarn;
             }
+            if (batch) {
+                batch->maxerror = std::max(batch->maxerror, cr.maxerror);
+                batch->nwarn += cr.nwarn;
+                batch->nfail += cr.nfail;
+            }
 
             // Print the report
             //
-            if (verbose || (ret != ErrOK && !quiet)) {
+            if (report && (verbose || (ret != ErrOK && !quiet))) {
                 if (compareall)
                     print_subimage(img0, subimage, m);
                 print("  Mean error = ");
@@ -364,6 +393,9 @@ main(int argc, char* argv[])
                       (100.0 * cr.nwarn / npels), warnthresh);
                 print("  {} pixels ({:1.3g}%) over {}\n", cr.nfail,
                       (100.0 * cr.nfail / npels), failthresh);
+                if (maxfailures && cr.nfail >= maxfailures && !perceptual)
+                    print("  (stopped comparing after {} failures)\n",
+                          cr.nfail);
                 if (perceptual)
                     print("  {} pixels ({:3g}%) failed the perceptual test\n",
                           yee_failures, (100.0 * yee_failures / npels));
@@ -373,7 +405,8 @@ main(int argc, char* argv[])
             // do that.  N.B. we only do this for the first subimage
             // right now, because ImageBuf doesn't really know how to
             // write subimages.
-            if (diffimage.size() && (cr.maxerror != 0 || !outdiffonly)) {
+            if (report && diffimage.size()
+                && (cr.maxerror != 0 || !outdiffonly)) {
                 ImageBuf diff;
                 if (diffabs)
                     ImageBufAlgo::absdiff(diff, img0, img1);
@@ -391,20 +424,219 @@ main(int argc, char* argv[])
     }
 
     if (compareall && img0.nsubimages() != img1.nsubimages()) {
-        if (!quiet)
+        if (report && !quiet)
             print(stderr,
                   "Images had differing numbers of subimages ({} vs {})\n",
                   img0.nsubimages(), img1.nsubimages());
         ret = ErrFail;
     }
     if (!compareall && (img0.nsubimages() > 1 || img1.nsubimages() > 1)) {
-        if (!quiet)
+        if (report && !quiet)
             print(
                 "Only compared the first subimage (of {} and {}, respectively)\n",
                 img0.nsubimages(), img1.nsubimages());
     }
 
-    if (ret == ErrOK) {
+    return ret;
+}
+
+
+
+// The pairs of files listed in a manifest, one pair per line (blank lines
+// and lines starting with '#' are skipped). As on the command line, the
+// second of a pair may be a directory holding a same-named file.
+static bool
+read_manifest(const std::string& manifest,
+              std::vector<std::pair<std::string, std::string>>& pairs)
+{
+    std::string text;
+    if (!Filesystem::read_text_file(manifest, text)) {
+        print(stderr, "idiff ERROR: Could not read manifest \"{}\"\n",
+              manifest);
+        return false;
+    }
+    int lineno = 0;
+    for (string_view line : Strutil::splitsv(text, "\n")) {
+        ++lineno;
+        line = Strutil::strip(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+        auto fields = Strutil::splitsv(line);
+        if (fields.size() != 2) {
+            print(stderr, "idiff ERROR: {}:{}: expected two filenames\n",
+                  manifest, lineno);
+            return false;
+        }
+        pairs.emplace_back(fields[0], fields[1]);
+        add_filename_to_directory(pairs.back().first, pairs.back().second);
+    }
+    return true;
+}
+
+
+
+// Pair each image file under dir0 with the file of the same relative path
+// under dir1.
+static void
+directory_pairs(const std::string& dir0, const std::string& dir1,
+                std::vector<std::pair<std::string, std::string>>& pairs)
+{
+    // Only files with extensions that some format plugin claims.
+    std::set<std::string> extensions;
+    for (auto format : Strutil::splitsv(OIIO::get_string_attribute(
+                                            "extension_list"),
+                                        ";")) {
+        auto exts = format.substr(format.find(':') + 1);
+        for (auto ext : Strutil::splitsv(exts, ","))
+            extensions.insert(Strutil::lower(ext));
+    }
+    std::vector<std::string> files;
+    Filesystem::get_directory_entries(dir0, files, true);
+    std::sort(files.begin(), files.end());
+    for (auto& file : files) {
+        std::string ext = Strutil::lower(Filesystem::extension(file, false));
+        if (!extensions.count(ext) || !Filesystem::is_regular(file))
+            continue;
+        string_view rel(file);
+        rel.remove_prefix(dir0.size());
+        while (rel.size() && (rel[0] == '/' || rel[0] == '\\'))
+            rel.remove_prefix(1);
+        std::string file1 = dir1;
+        if (file1.size() && file1.back() != '/' && file1.back() != '\\')
+            file1 += '/';
+        file1 += rel;
+        pairs.emplace_back(file, file1);
+    }
+}
+
+
+
+// Compare all the pairs, several at once, and print one tab-separated line
+// per pair -- verdict, max error, number of pixels over the warning and
+// failure thresholds, and the two filenames -- then the totals. Return the
+// worst verdict.
+static int
+compare_batch(const std::vector<std::pair<std::string, std::string>>& pairs,
+              ImageCache* imagecache)
+{
+    // Only the verdict matters for most pairs of a big batch, so stop
+    // comparing each one as soon as its failure is certain.
+    if (!stopafter)
+        stopafter = 1;
+
+    std::vector<PairResult> results(pairs.size());
+    parallel_for_chunked(0, int64_t(pairs.size()), 1,
+                         [&](int64_t b, int64_t e) {
+                             for (int64_t i = b; i < e; ++i)
+                                 results[i].ret = compare_files(
+                                     pairs[i].first, pairs[i].second,
+                                     imagecache, &results[i]);
+                         });
+
+    static const char* verdicts[] = { "PASS", "WARNING", "FAILURE",
+                                      "MISMATCH", "ERROR" };
+    int counts[ErrLast] = {};
+    int worst           = ErrOK;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        const PairResult& r(results[i]);
+        ++counts[r.ret];
+        worst = std::max(worst, r.ret);
+        if (quiet && r.ret == ErrOK)
+            continue;
+        print("{}\t{:g}\t{}\t{}\t{}\t{}", verdicts[r.ret], r.maxerror,
+              r.nwarn, r.nfail, pairs[i].first, pairs[i].second);
+        if (r.error.size())
+            print("\t{}", r.error);
+        print("\n");
+    }
+    print("# {} pairs: {} PASS, {} WARNING, {} FAILURE, {} MISMATCH, "
+          "{} ERROR\n",
+          pairs.size(), counts[ErrOK], counts[ErrWarn], counts[ErrFail],
+          counts[ErrDifferentSize], counts[ErrFile]);
+    return worst;
+}
+
+
+
+int
+main(int argc, char* argv[])
+{
+    // Helpful for debugging to make sure that any crashes dump a stack
+    // trace.
+    Sysutil::setup_crash_stacktrace("stdout");
+
+    Filesystem::convert_native_arguments(argc, (const char**)argv);
+    ArgParse ap = getargs(argc, argv);
+
+    verbose       = ap["v"].get<int>();
+    quiet         = ap["q"].get<int>();
+    compareall    = ap["a"].get<int>();
+    outdiffonly   = ap["od"].get<int>();
+    diffabs       = ap["abs"].get<int>();
+    perceptual    = ap["p"].get<int>();
+    diffimage     = ap["o"].get();
+    diffscale     = ap["scale"].get<float>();
+    failthresh    = ap["fail"].get<float>();
+    failrelative  = ap["failrelative"].get<float>();
+    failpercent   = ap["failpercent"].get<float>();
+    hardfail      = ap["hardfail"].get<float>();
+    warnthresh    = ap["warn"].get<float>();
+    warnrelative  = ap["warnrelative"].get<float>();
+    warnpercent   = ap["warnpercent"].get<float>();
+    hardwarn      = ap["hardwarn"].get<float>();
+    allowfailures = ap["allowfailures"].get<int>();
+    stopafter     = ap["stopafter"].get<int>();
+    quick         = ap["quick"].get<int>();
+    if (int threads = ap["threads"].get<int>())
+        OIIO::attribute("threads", threads);
+
+    // Batch mode: a manifest of pairs, or two directories of images.
+    std::vector<std::string> filenames = ap["filename"].as_vec<std::string>();
+    std::string manifest               = ap["batch"].get();
+    std::vector<std::pair<std::string, std::string>> pairs;
+    bool batch = false;
+    if (manifest.size() && filenames.empty()) {
+        if (!read_manifest(manifest, pairs))
+            return ErrFile;
+        batch = true;
+    } else if (filenames.size() == 2 && Filesystem::is_directory(filenames[0])
+               && Filesystem::is_directory(filenames[1])) {
+        directory_pairs(filenames[0], filenames[1], pairs);
+        batch = true;
+    } else if (filenames.size() == 2 && manifest.empty()) {
+        add_filename_to_directory(filenames[0], filenames[1]);
+    } else {
+        print(stderr, "idiff: Must have two input filenames.\n");
+        print(stderr, "> {}\n", Strutil::join(filenames, ", "));
+        ap.usage();
+        return EXIT_FAILURE;
+    }
+
+    if (!quiet && !batch) {
+        print("Comparing \"{}\" and \"{}\"\n", filenames[0], filenames[1]);
+        fflush(stdout);
+    }
+
+    // Create a private ImageCache so we can customize its cache size
+    // and instruct it store everything internally as floats. In batch mode
+    // all the comparisons share it.
+    ImageCache* imagecache = ImageCache::create(true);
+    imagecache->attribute("forcefloat", 1);
+    if (sizeof(void*) == 4)  // 32 bit or 64?
+        imagecache->attribute("max_memory_MB", 512.0);
+    else
+        imagecache->attribute("max_memory_MB", 2048.0);
+    imagecache->attribute("autotile", 256);
+    // force a full diff, even for files tagged with the same
+    // fingerprint, just in case some mistake has been made.
+    imagecache->attribute("deduplicate", 0);
+
+    int ret = batch ? compare_batch(pairs, imagecache)
+                    : compare_files(filenames[0], filenames[1], imagecache);
+
+    if (batch || ret == ErrFile) {
+        // Already reported
+    } else if (ret == ErrOK) {
         if (!quiet)
             print("PASS\n");
     } else if (ret == ErrWarn) {
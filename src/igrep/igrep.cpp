@@ -3,6 +3,7 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -15,8 +16,10 @@
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/tiffutils.h>
 
 using namespace OIIO;
 
@@ -32,94 +35,144 @@ static std::vector<std::string> filenames;
 
 
 
+// Search the string metadata of spec for the pattern. Unless only whole
+// files are being reported, each match is appended to out. Return true if
+// anything matched.
 static bool
-grep_file(const std::string& filename, std::regex& re,
-          bool ignore_nonimage_files = false)
+grep_spec(const std::string& filename, const ImageSpec& spec,
+          const std::regex& re, std::string& out)
 {
-    if (!Filesystem::exists(filename)) {
-        std::cerr << "igrep: " << filename << ": No such file or directory\n";
-        return false;
-    }
-
-    if (Filesystem::is_directory(filename)) {
-        if (!recursive)
-            return false;
-        if (print_dirs) {
-            std::cout << "(" << filename << "/)\n";
-            std::cout.flush();
+    bool found = false;
+    for (auto&& p : spec.extra_attribs) {
+        TypeDesc t = p.type();
+        if (t.elementtype() != TypeDesc::STRING)
+            continue;
+        int n = t.numelements();
+        for (int i = 0; i < n; ++i) {
+            const char* val = ((const char**)p.data())[i];
+            if (!val || !std::regex_search(val, re))
+                continue;
+            found = true;
+            if (list_files || invert_match)
+                return true;
+            out += filename + ": " + p.name().string() + " = " + val + "\n";
         }
-        bool r = false;
-        std::vector<std::string> directory_entries;
-        Filesystem::get_directory_entries(filename, directory_entries);
-        for (const auto& d : directory_entries)
-            r |= grep_file(d, re, true);
-        return r;
     }
+    return found;
+}
 
-    auto in = ImageInput::open(filename);
-    if (!in.get()) {
+
+
+// Search one image file, collecting what would be printed in out and err
+// rather than printing it, so that many files can be searched at once and
+// still be reported in order.
+static bool
+grep_file(const std::string& filename, const std::regex& re,
+          bool ignore_nonimage_files, std::string& out, std::string& err)
+{
+    // Readers that support it leave the Exif, XMP, and IPTC blocks
+    // undecoded, to be decoded below only if they need to be searched.
+    ImageSpec config;
+    config.attribute("oiio:metadata", "lazy");
+    auto in = ImageInput::open(filename, &config);
+    if (!in) {
+        std::string e = OIIO::geterror();
         if (!ignore_nonimage_files)
-            std::cerr << geterror() << "\n";
+            err += e + "\n";
         return false;
     }
-    ImageSpec spec = in->spec();
 
-    if (file_match) {
-        bool match = false;
-        try {
-            match = std::regex_search(filename, re);
-        } catch (const std::regex_error& e) {
-            std::cerr << "igrep: " << e.what() << "\n";
-            return false;
-        }
-        if (match && !invert_match) {
-            std::cout << filename << "\n";
-            return true;
-        }
+    if (file_match && !invert_match && std::regex_search(filename, re)) {
+        out += filename + "\n";
+        return true;
     }
 
-    bool found   = false;
-    int subimage = 0;
+    // When only whole files are reported, one match settles it.
+    bool per_file  = list_files || invert_match;
+    bool found     = false;
+    int subimage   = 0;
+    ImageSpec spec = in->spec();
     do {
         if (!all_subimages && subimage > 0)
             break;
-        for (auto&& p : spec.extra_attribs) {
-            TypeDesc t = p.type();
-            if (t.elementtype() == TypeDesc::STRING) {
-                int n = t.numelements();
-                for (int i = 0; i < n; ++i) {
-                    bool match = false;
-                    try {
-                        match = std::regex_search(((const char**)p.data())[i],
-                                                  re);
-                    } catch (const std::regex_error& e) {
-                        std::cerr << "igrep: " << e.what() << "\n";
-                        return false;
-                    }
-                    found |= match;
-                    if (match && !invert_match) {
-                        if (list_files) {
-                            std::cout << filename << "\n";
-                            return found;
-                        }
-                        std::cout << filename << ": " << p.name() << " = "
-                                  << ((const char**)p.data())[i] << "\n";
-                    }
-                }
-            }
+        bool raw = spec.extra_attribs.contains("oiio:RawExif")
+                   || spec.extra_attribs.contains("oiio:RawXMP")
+                   || spec.extra_attribs.contains("oiio:RawIPTC");
+        if (raw && per_file && grep_spec(filename, spec, re, out)) {
+            found = true;
+            break;
         }
+        if (raw)
+            decode_raw_metadata(spec);
+        found |= grep_spec(filename, spec, re, out);
+        if (found && per_file)
+            break;
     } while (in->seek_subimage(++subimage, 0, spec));
 
-    if (invert_match) {
+    if (invert_match)
         found = !found;
-        if (found)
-            std::cout << filename << "\n";
-    }
+    if (found && per_file)
+        out += filename + "\n";
     return found;
 }
 
 
 
+// Order paths as a depth-first walk of their directories would visit
+// them: compare the names a path component at a time.
+static bool
+path_order(const std::string& a, const std::string& b)
+{
+    auto key = [](char c) {
+        return (c == '/' || c == '\\') ? '\0' : c;
+    };
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(),
+                                        b.end(), [&](char x, char y) {
+                                            return (unsigned char)key(x)
+                                                   < (unsigned char)key(y);
+                                        });
+}
+
+
+
+// Search the files (and the directories, which are only noted if
+// print_dirs is on), a batch at a time in parallel, printing the results
+// of each batch in order.
+static void
+grep_files(const std::vector<std::string>& files, const std::regex& re,
+           bool ignore_nonimage_files)
+{
+    const size_t batchsize = 1024;
+    for (size_t begin = 0; begin < files.size(); begin += batchsize) {
+        size_t n = std::min(batchsize, files.size() - begin);
+        std::vector<std::string> out(n), err(n);
+        parallel_for(
+            int64_t(0), int64_t(n),
+            [&](int64_t i) {
+                const std::string& file(files[begin + i]);
+                if (Filesystem::is_directory(file)) {
+                    if (print_dirs)
+                        out[i] = "(" + file + "/)\n";
+                    return;
+                }
+                try {
+                    grep_file(file, re, ignore_nonimage_files, out[i],
+                              err[i]);
+                } catch (const std::regex_error& e) {
+                    err[i] += std::string("igrep: ") + e.what() + "\n";
+                }
+            },
+            paropt(0, paropt::SplitDir::Y, 1));
+        for (size_t i = 0; i < n; ++i) {
+            std::cout << out[i];
+            std::cerr << err[i];
+        }
+        std::cout.flush();
+    }
+}
+
+
+
 static int
 parse_files(int argc, const char* argv[])
 {
@@ -186,8 +239,23 @@ main(int argc, const char* argv[])
 
     try {
         std::regex re(pattern, flag);
-        for (auto&& s : filenames)
-            grep_file(s, re);
+        for (auto&& s : filenames) {
+            if (!Filesystem::exists(s)) {
+                std::cerr << "igrep: " << s << ": No such file or directory\n";
+                continue;
+            }
+            if (!Filesystem::is_directory(s)) {
+                grep_files({ s }, re, false);
+            } else if (recursive) {
+                // List the whole tree (which is done in parallel), then put
+                // it in the order the directories would have been walked.
+                std::vector<std::string> files;
+                Filesystem::get_directory_entries(s, files, true);
+                std::sort(files.begin(), files.end(), path_order);
+                files.insert(files.begin(), s);
+                grep_files(files, re, true);
+            }
+        }
     } catch (const std::regex_error& e) {
         std::cerr << "igrep: " << e.what() << "\n";
         ok = false;
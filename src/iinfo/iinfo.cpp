@@ -9,8 +9,10 @@
 #include <ctime>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <regex>
+#include <sstream>
 
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/deepdata.h>
@@ -19,6 +21,7 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
 
@@ -38,17 +41,24 @@ static std::regex field_re;
 static bool subimages     = false;
 static bool compute_sha1  = false;
 static bool compute_stats = false;
+static bool probe         = false;
+static bool summary       = false;
+static std::string hashtype("sha1");
 
 using OIIO::print;
 
 
 
 static void
-print_sha1(ImageInput* input, int subimage, int miplevel)
+print_sha1(std::ostream& out, ImageInput* input, int subimage, int miplevel)
 {
     std::string err;
-    std::string s1 = pvt::compute_sha1(input, subimage, miplevel, err);
-    print("    SHA-1: {}\n", err.size() ? err : s1);
+    std::string s1 = pvt::compute_pixel_hash(input, subimage, miplevel,
+                                             hashtype, err);
+    if (Strutil::iequals(hashtype, "sha1"))
+        print(out, "    SHA-1: {}\n", err.size() ? err : s1);
+    else
+        print(out, "    {}: {}\n", hashtype, err.size() ? err : s1);
 }
 
 
@@ -57,8 +67,8 @@ print_sha1(ImageInput* input, int subimage, int miplevel)
 // Stats
 
 static bool
-read_input(const std::string& filename, ImageBuf& img, int subimage = 0,
-           int miplevel = 0)
+read_input(std::ostream& err, const std::string& filename, ImageBuf& img,
+           int subimage = 0, int miplevel = 0)
 {
     if (img.subimage() >= 0 && img.subimage() == subimage)
         return true;
@@ -66,30 +76,31 @@ read_input(const std::string& filename, ImageBuf& img, int subimage = 0,
     if (img.read(subimage, miplevel, false, TypeDesc::FLOAT))
         return true;
 
-    std::cerr << "iinfo ERROR: Could not read " << filename << ":\n\t"
-              << img.geterror() << "\n";
+    err << "iinfo ERROR: Could not read " << filename << ":\n\t"
+        << img.geterror() << "\n";
     return false;
 }
 
 
 
 static void
-print_stats(const std::string& filename, const ImageSpec& originalspec,
-            int subimage = 0, int miplevel = 0, bool indentmip = false)
+print_stats(std::ostream& out, std::ostream& err, const std::string& filename,
+            const ImageSpec& originalspec, int subimage = 0, int miplevel = 0,
+            bool indentmip = false)
 {
     const char* indent = indentmip ? "      " : "    ";
 
     ImageBuf input(filename);
-    if (!read_input(filename, input, subimage, miplevel)) {
+    if (!read_input(err, filename, input, subimage, miplevel)) {
         // Note: read_input prints an error message if one occurs
         return;
     }
 
-    std::string err;
-    if (!pvt::print_stats(std::cout, indent, input, originalspec, ROI(), err)) {
-        print("{}Stats: (unable to compute)\n", indent);
-        if (err.size())
-            std::cerr << "Error: " << err << "\n";
+    std::string errmsg;
+    if (!pvt::print_stats(out, indent, input, originalspec, ROI(), errmsg)) {
+        print(out, "{}Stats: (unable to compute)\n", indent);
+        if (errmsg.size())
+            err << "Error: " << errmsg << "\n";
         return;
     }
 }
@@ -97,36 +108,37 @@ print_stats(const std::string& filename, const ImageSpec& originalspec,
 
 
 static void
-print_metadata(const ImageSpec& spec, const std::string& filename)
+print_metadata(std::ostream& out, const ImageSpec& spec,
+               const std::string& filename)
 {
     bool printed = false;
     if (metamatch.empty() || std::regex_search("channels", field_re)
         || std::regex_search("channel list", field_re)) {
         if (filenameprefix)
-            print("{} : ", filename);
-        print("    channel list: ");
+            print(out, "{} : ", filename);
+        print(out, "    channel list: ");
         for (int i = 0; i < spec.nchannels; ++i) {
             if (i < (int)spec.channelnames.size())
-                print("{}", spec.channelnames[i]);
+                print(out, "{}", spec.channelnames[i]);
             else
-                print("unknown");
+                print(out, "unknown");
             if (i < (int)spec.channelformats.size())
-                print(" ({})", spec.channelformats[i]);
+                print(out, " ({})", spec.channelformats[i]);
             if (i < spec.nchannels - 1)
-                print(", ");
+                print(out, ", ");
         }
-        print("\n");
+        print(out, "\n");
         printed = true;
     }
     if (spec.x || spec.y || spec.z) {
         if (metamatch.empty()
             || std::regex_search("pixel data origin", field_re)) {
             if (filenameprefix)
-                print("{} : ", filename);
-            print("    pixel data origin: x={}, y={}", spec.x, spec.y);
+                print(out, "{} : ", filename);
+            print(out, "    pixel data origin: x={}, y={}", spec.x, spec.y);
             if (spec.depth > 1)
-                print(", z={}", spec.z);
-            print("\n");
+                print(out, ", z={}", spec.z);
+            print(out, "\n");
             printed = true;
         }
     }
@@ -137,33 +149,35 @@ print_metadata(const ImageSpec& spec, const std::string& filename)
         if (metamatch.empty()
             || std::regex_search("full/display size", field_re)) {
             if (filenameprefix)
-                print("{} : ", filename);
-            print("    full/display size: {} x {}", spec.full_width,
+                print(out, "{} : ", filename);
+            print(out, "    full/display size: {} x {}", spec.full_width,
                   spec.full_height);
             if (spec.depth > 1)
-                print(" x {}", spec.full_depth);
-            print("\n");
+                print(out, " x {}", spec.full_depth);
+            print(out, "\n");
             printed = true;
         }
         if (metamatch.empty()
             || std::regex_search("full/display origin", field_re)) {
             if (filenameprefix)
-                print("{} : ", filename);
-            print("    full/display origin: {}, {}", spec.full_x, spec.full_y);
+                print(out, "{} : ", filename);
+            print(out, "    full/display origin: {}, {}", spec.full_x,
+                  spec.full_y);
             if (spec.depth > 1)
-                print(", {}", spec.full_z);
-            print("\n");
+                print(out, ", {}", spec.full_z);
+            print(out, "\n");
             printed = true;
         }
     }
     if (spec.tile_width) {
         if (metamatch.empty() || std::regex_search("tile", field_re)) {
             if (filenameprefix)
-                print("{} : ", filename);
-            print("    tile size: {} x {}", spec.tile_width, spec.tile_height);
+                print(out, "{} : ", filename);
+            print(out, "    tile size: {} x {}", spec.tile_width,
+                  spec.tile_height);
             if (spec.depth > 1)
-                print(" x {}", spec.tile_depth);
-            print("\n");
+                print(out, " x {}", spec.tile_depth);
+            print(out, "\n");
             printed = true;
         }
     }
@@ -179,20 +193,20 @@ print_metadata(const ImageSpec& spec, const std::string& filename)
             continue;
         std::string s = spec.metadata_val(p, true);
         if (filenameprefix)
-            print("{} : ", filename);
-        print("    {}: ", p.name());
+            print(out, "{} : ", filename);
+        print(out, "    {}: ", p.name());
         if (s == "1.#INF")
-            print("inf");
+            print(out, "inf");
         else
-            print("{}", s);
-        print("\n");
+            print(out, "{}", s);
+        print(out, "\n");
         printed = true;
     }
 
     if (!printed && !metamatch.empty()) {
         if (filenameprefix)
-            print("{} : ", filename);
-        print("    {}: <unknown>\n", metamatch);
+            print(out, "{} : ", filename);
+        print(out, "    {}: <unknown>\n", metamatch);
     }
 }
 
@@ -240,8 +254,9 @@ brief_format_name(TypeDesc type, int bits = 0)
 // prints basic info (resolution, width, height, depth, channels, data format,
 // and format name) about given subimage.
 static void
-print_info_subimage(int current_subimage, int max_subimages, ImageSpec& spec,
-                    ImageInput* input, const std::string& filename)
+print_info_subimage(std::ostream& out, std::ostream& err, int current_subimage,
+                    int max_subimages, ImageSpec& spec, ImageInput* input,
+                    const std::string& filename)
 {
     if (!input->seek_subimage(current_subimage, 0, spec))
         return;
@@ -262,42 +277,43 @@ print_info_subimage(int current_subimage, int max_subimages, ImageSpec& spec,
               || std::regex_search("resolution, width, height, depth, channels",
                                    field_re));
     if (printres && max_subimages > 1 && subimages) {
-        print(" subimage {:2}: ", current_subimage);
-        print("{:4} x {:4}", spec.width, spec.height);
+        print(out, " subimage {:2}: ", current_subimage);
+        print(out, "{:4} x {:4}", spec.width, spec.height);
         if (spec.depth > 1)
-            print(" x {:4}", spec.depth);
+            print(out, " x {:4}", spec.depth);
         int bits = spec.get_int_attribute("oiio:BitsPerSample", 0);
-        print(", {} channel, {}{}{}", spec.nchannels, spec.deep ? "deep " : "",
-              spec.depth > 1 ? "volume " : "",
+        print(out, ", {} channel, {}{}{}", spec.nchannels,
+              spec.deep ? "deep " : "", spec.depth > 1 ? "volume " : "",
               extended_format_name(spec.format, bits));
-        print(" {}", input->format_name());
-        print("\n");
+        print(out, " {}", input->format_name());
+        print(out, "\n");
     }
     // Count MIP levels
     ImageSpec mipspec;
     while (input->seek_subimage(current_subimage, nmip, mipspec)) {
         if (printres) {
             if (nmip == 1)
-                print("    MIP-map levels: {}x{}", spec.width, spec.height);
-            print(" {}x{}", mipspec.width, mipspec.height);
+                print(out, "    MIP-map levels: {}x{}", spec.width,
+                      spec.height);
+            print(out, " {}x{}", mipspec.width, mipspec.height);
         }
         ++nmip;
     }
     if (printres && nmip > 1)
-        print("\n");
+        print(out, "\n");
 
     if (compute_sha1
         && (metamatch.empty() || std::regex_search("sha-1", field_re))) {
         if (filenameprefix)
-            print("{} : ", filename);
+            print(out, "{} : ", filename);
         // Before sha-1, be sure to point back to the highest-res MIP level
         ImageSpec tmpspec;
         input->seek_subimage(current_subimage, 0, tmpspec);
-        print_sha1(input, current_subimage, 0);
+        print_sha1(out, input, current_subimage, 0);
     }
 
     if (verbose)
-        print_metadata(spec, filename);
+        print_metadata(out, spec, filename);
 
     if (compute_stats
         && (metamatch.empty() || std::regex_search("stats", field_re))) {
@@ -305,12 +321,13 @@ print_info_subimage(int current_subimage, int max_subimages, ImageSpec& spec,
             ImageSpec mipspec;
             input->seek_subimage(current_subimage, m, mipspec);
             if (filenameprefix)
-                print("{} : ", filename);
+                print(out, "{} : ", filename);
             if (nmip > 1 && (subimages || m == 0)) {
-                print("    MIP {} of {} ({} x {}):\n", m, nmip, mipspec.width,
-                      mipspec.height);
+                print(out, "    MIP {} of {} ({} x {}):\n", m, nmip,
+                      mipspec.width, mipspec.height);
             }
-            print_stats(filename, spec, current_subimage, m, nmip > 1);
+            print_stats(out, err, filename, spec, current_subimage, m,
+                        nmip > 1);
         }
     }
 
@@ -321,9 +338,9 @@ print_info_subimage(int current_subimage, int max_subimages, ImageSpec& spec,
 
 
 static void
-print_info(const std::string& filename, size_t namefieldlength,
-           ImageInput* input, ImageSpec& spec, bool verbose, bool sum,
-           long long& totalsize)
+print_info(std::ostream& out, std::ostream& err, const std::string& filename,
+           size_t namefieldlength, ImageInput* input, ImageSpec& spec,
+           bool verbose, bool sum, long long& totalsize)
 {
     int padlen = std::max(0, (int)namefieldlength - (int)filename.length());
     std::string padding(padlen, ' ');
@@ -355,57 +372,58 @@ print_info(const std::string& filename, size_t namefieldlength,
     if (metamatch.empty()
         || std::regex_search("resolution, width, height, depth, channels",
                              field_re)) {
-        print("{}{} : {:4} x {:4}", filename, padding, spec.width, spec.height);
+        print(out, "{}{} : {:4} x {:4}", filename, padding, spec.width,
+              spec.height);
         if (spec.depth > 1)
-            print(" x {:4}", spec.depth);
-        print(", {} channel, {}{}", spec.nchannels, spec.deep ? "deep " : "",
-              spec.depth > 1 ? "volume " : "");
+            print(out, " x {:4}", spec.depth);
+        print(out, ", {} channel, {}{}", spec.nchannels,
+              spec.deep ? "deep " : "", spec.depth > 1 ? "volume " : "");
         if (spec.channelformats.size()) {
             for (size_t c = 0; c < spec.channelformats.size(); ++c)
-                print("{}{}", c ? "/" : "", spec.channelformat(c));
+                print(out, "{}{}", c ? "/" : "", spec.channelformat(c));
         } else {
             int bits = spec.get_int_attribute("oiio:BitsPerSample", 0);
-            print("{}", extended_format_name(spec.format, bits));
+            print(out, "{}", extended_format_name(spec.format, bits));
         }
-        print(" {}", input->format_name());
+        print(out, " {}", input->format_name());
         if (sum) {
             imagesize_t imagebytes = spec.image_bytes(true);
             totalsize += imagebytes;
-            print(" ({:.2f} MB)", (float)imagebytes / (1024.0 * 1024.0));
+            print(out, " ({:.2f} MB)", (float)imagebytes / (1024.0 * 1024.0));
         }
         // we print info about how many subimages are stored in file
         // only when we have more then one subimage
         if (!verbose && num_of_subimages != 1)
-            print(" ({} subimages{})", num_of_subimages,
+            print(out, " ({} subimages{})", num_of_subimages,
                   any_mipmapping ? " +mipmap)" : "");
         if (!verbose && num_of_subimages == 1 && any_mipmapping)
-            print(" (+mipmap)");
-        print("\n");
+            print(out, " (+mipmap)");
+        print(out, "\n");
     }
 
     int movie = spec.get_int_attribute("oiio:Movie");
     if (verbose && num_of_subimages != 1) {
         // info about num of subimages and their resolutions
-        print("    {} subimages: ", num_of_subimages);
+        print(out, "    {} subimages: ", num_of_subimages);
         for (int i = 0; i < num_of_subimages; ++i) {
             input->seek_subimage(i, 0, spec);
             int bits = spec.get_int_attribute("oiio:BitsPerSample",
                                               spec.format.size() * 8);
             if (i)
-                print(", ");
+                print(out, ", ");
             if (spec.depth > 1)
-                print("{}x{}x{} ", spec.width, spec.height, spec.depth);
+                print(out, "{}x{}x{} ", spec.width, spec.height, spec.depth);
             else
-                print("{}x{} ", spec.width, spec.height);
-            // print("[");
+                print(out, "{}x{} ", spec.width, spec.height);
+            // print(out, "[");
             for (int c = 0; c < spec.nchannels; ++c)
-                print("{:c}{}", c ? ',' : '[',
+                print(out, "{:c}{}", c ? ',' : '[',
                       brief_format_name(spec.channelformat(c), bits));
-            print("]");
+            print(out, "]");
             if (movie)
                 break;
         }
-        print("\n");
+        print(out, "\n");
     }
 
     // if the '-a' flag is not set we print info
@@ -413,8 +431,135 @@ print_info(const std::string& filename, size_t namefieldlength,
     if (!subimages)
         num_of_subimages = 1;
     for (int i = 0; i < num_of_subimages; ++i) {
-        print_info_subimage(i, num_of_subimages, spec, input, filename);
+        print_info_subimage(out, err, i, num_of_subimages, spec, input,
+                            filename);
+    }
+}
+
+
+
+// What one file adds to the --summary totals.
+struct FileSummary {
+    std::string format_name;  ///< File format
+    std::string datatype;     ///< Data format of the first subimage
+    int width          = 0;   ///< Resolution of the first subimage
+    int height         = 0;
+    imagesize_t pixels = 0;   ///< Over all subimages and MIP levels
+    imagesize_t bytes  = 0;   ///< Uncompressed, in the native data formats
+};
+
+
+
+static void
+summarize(ImageInput* input, FileSummary& fs)
+{
+    fs.format_name = input->format_name();
+    ImageSpec spec;
+    for (int s = 0; input->seek_subimage(s, 0, spec); ++s) {
+        if (s == 0) {
+            int bits    = spec.get_int_attribute("oiio:BitsPerSample", 0);
+            fs.datatype = extended_format_name(spec.format, bits);
+            fs.width    = spec.width;
+            fs.height   = spec.height;
+        }
+        int m = 0;
+        do {
+            fs.pixels += spec.image_pixels();
+            fs.bytes += spec.image_bytes(true);
+        } while (input->seek_subimage(s, ++m, spec));
+    }
+}
+
+
+
+// Print how many files have each value, most common first.
+static void
+print_histogram(string_view title, const std::map<std::string, size_t>& counts)
+{
+    std::vector<std::pair<std::string, size_t>> sorted(counts.begin(),
+                                                       counts.end());
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const std::pair<std::string, size_t>& a,
+                        const std::pair<std::string, size_t>& b) {
+                         return a.second > b.second;
+                     });
+    const size_t maxlines = 20;
+    print("    {}:\n", title);
+    size_t others = 0;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if (i < maxlines)
+            print("    {:10}  {}\n", sorted[i].second, sorted[i].first);
+        else
+            others += sorted[i].second;
+    }
+    if (sorted.size() > maxlines)
+        print("    {:10}  ({} others)\n", others, sorted.size() - maxlines);
+}
+
+
+
+static void
+print_summary(const std::vector<FileSummary>& summaries, size_t nfailed)
+{
+    imagesize_t pixels = 0, bytes = 0;
+    std::map<std::string, size_t> formats, datatypes, resolutions;
+    for (auto& fs : summaries) {
+        if (fs.format_name.empty())
+            continue;
+        pixels += fs.pixels;
+        bytes += fs.bytes;
+        ++formats[fs.format_name];
+        ++datatypes[fs.datatype];
+        ++resolutions[Strutil::fmt::format("{}x{}", fs.width, fs.height)];
+    }
+    print("Summary of {} files", summaries.size() - nfailed);
+    if (nfailed)
+        print(" ({} more could not be read)", nfailed);
+    print(":\n");
+    print("    Total pixels: {} (all subimages and MIP levels)\n", pixels);
+    print("    Total size: {} (uncompressed)\n", Strutil::memformat(bytes));
+    print_histogram("File formats", formats);
+    print_histogram("Data formats", datatypes);
+    print_histogram("Resolutions", resolutions);
+}
+
+
+
+// For --probe: read just the headers of all the files, in parallel, and
+// print their basic shape in the order given.
+static int
+probe_all(size_t namefieldlength)
+{
+    std::vector<ImageSpec> specs(filenames.size());
+    std::vector<std::string> errors(filenames.size());
+    parallel_for(int64_t(0), int64_t(filenames.size()), [&](int64_t i) {
+        if (!ImageInput::probe_spec(filenames[i], specs[i])) {
+            errors[i] = geterror();
+            if (errors[i].empty())
+                errors[i] = "Could not open file.";
+        }
+    });
+    int returncode = EXIT_SUCCESS;
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        const std::string& filename(filenames[i]);
+        if (errors[i].size()) {
+            print(std::cerr, "iinfo ERROR: \"{}\" : {}\n", filename,
+                  errors[i]);
+            returncode = EXIT_FAILURE;
+            continue;
+        }
+        const ImageSpec& spec(specs[i]);
+        int padlen = std::max(0, (int)namefieldlength
+                                     - (int)filename.length());
+        print("{}{} : {:4} x {:4}", filename, std::string(padlen, ' '),
+              spec.width, spec.height);
+        if (spec.depth > 1)
+            print(" x {:4}", spec.depth);
+        print(", {} channel, {}\n", spec.nchannels,
+              extended_format_name(spec.format, 0));
     }
+    shutdown();
+    return returncode;
 }
 
 
@@ -449,8 +594,14 @@ main(int argc, const char* argv[])
     ap.arg("--hash", &compute_sha1)
       .help("Print SHA-1 hash of pixel values")
       .action(ArgParse::store_true());
+    ap.arg("--hashtype %s:NAME", &hashtype)
+      .help("Hash algorithm used by --hash: sha1 (default), xxhash");
     ap.arg("--stats", &compute_stats)
       .help("Print image pixel statistics (data window)");
+    ap.arg("--probe", &probe)
+      .help("Print only resolution, channels, and data format, reading just the file headers (in parallel)");
+    ap.arg("--summary", &summary)
+      .help("Print only totals over all the files: pixels, bytes, and counts of file formats, data formats, and resolutions");
     // clang-format on
     if (ap.parse(argc, argv) < 0 || filenames.empty()) {
         std::cerr << ap.geterror() << std::endl;
@@ -469,21 +620,60 @@ main(int argc, const char* argv[])
         longestname = std::max(longestname, s.length());
     longestname = std::min(longestname, (size_t)40);
 
+    if (probe)
+        return probe_all(longestname);
+
     int returncode      = EXIT_SUCCESS;
     long long totalsize = 0;
-    for (auto&& s : filenames) {
-        auto in = ImageInput::open(s);
-        if (!in) {
-            std::string err = geterror();
-            print(std::cerr, "iinfo ERROR: \"{}\" : {}\n", s,
-                  err.size() ? err : std::string("Could not open file."));
-            returncode = EXIT_FAILURE;
-            continue;
+    size_t nfailed      = 0;
+    std::vector<FileSummary> summaries(summary ? filenames.size() : 0);
+    ImageSpec config;
+    if (summary)
+        config["oiio:metadata"] = "none";
+    // Examine a batch of files at a time, in parallel (each task having
+    // just one file open at once), then print their results in order.
+    const size_t batchsize = 256;
+    for (size_t begin = 0; begin < filenames.size(); begin += batchsize) {
+        size_t n = std::min(batchsize, filenames.size() - begin);
+        std::vector<std::string> outs(n), errs(n);
+        std::vector<long long> sizes(n, 0);
+        std::vector<char> failed(n, 0);
+        parallel_for(
+            int64_t(0), int64_t(n),
+            [&](int64_t i) {
+                const std::string& s(filenames[begin + i]);
+                std::ostringstream out, err;
+                auto in = ImageInput::open(s, summary ? &config : nullptr);
+                if (!in) {
+                    std::string e = geterror();
+                    print(err, "iinfo ERROR: \"{}\" : {}\n", s,
+                          e.size() ? e : std::string("Could not open file."));
+                    failed[i] = 1;
+                } else if (summary) {
+                    summarize(in.get(), summaries[begin + i]);
+                } else {
+                    ImageSpec spec = in->spec();
+                    print_info(out, err, s, longestname, in.get(), spec,
+                               verbose, sum, sizes[i]);
+                }
+                outs[i] = out.str();
+                errs[i] = err.str();
+            },
+            paropt(0, paropt::SplitDir::Y, 1));
+        for (size_t i = 0; i < n; ++i) {
+            std::cout << outs[i];
+            std::cerr << errs[i];
+            totalsize += sizes[i];
+            if (failed[i]) {
+                returncode = EXIT_FAILURE;
+                ++nfailed;
+            }
         }
-        ImageSpec spec = in->spec();
-        print_info(s, longestname, in.get(), spec, verbose, sum, totalsize);
+        std::cout.flush();
     }
 
+    if (summary)
+        print_summary(summaries, nfailed);
     if (sum)
         print("Total size: {}\n", Strutil::memformat(totalsize));
 
@@ -147,6 +147,7 @@ public:
         run(func, args...);
         if (verbose())
             std::cout << (*this) << std::endl;
+        record_result();
         return avg();
     }
 
@@ -237,6 +238,34 @@ public:
 
     const std::string& name() const { return m_name; }
 
+    // Process-wide recording of results, so that benchmarks can be tracked
+    // from one build to the next. These affect every Benchmarker in the
+    // program, not just this one.
+    //
+    // json_output(filename) records every benchmark subsequently run, and
+    // writes them to the file as JSON when the program exits. Each record
+    // holds the name, the avg, median, stddev, and range (in seconds per
+    // iteration), and the trials, samples (trials remaining after outliers
+    // are excluded), iterations, and work per iteration.
+    //
+    // compare_baseline(filename) reads such a file saved by an earlier run
+    // and, as each benchmark finishes, compares it against the baseline
+    // result of the same name. It is reported as a regression if its
+    // average time is more than `threshold` (a fraction) slower than the
+    // baseline, and the slowdown is also more than `nsigma` times its
+    // standard error, so that it is unlikely to be noise. Return false if
+    // the baseline could not be read.
+    //
+    // regressions() returns the number of regressions found so far.
+    //
+    // Without any changes to a program, the same can be requested by
+    // setting the environment variables OIIO_BENCHMARK_JSON and
+    // OIIO_BENCHMARK_COMPARE to the file names.
+    static void json_output(string_view filename);
+    static bool compare_baseline(string_view filename, double threshold = 0.05,
+                                 double nsigma = 3.0);
+    static int regressions();
+
 private:
     size_t m_iterations      = 0;
     size_t m_user_iterations = 0;
@@ -248,6 +277,7 @@ private:
     double m_stddev;              // standard deviation per iteration
     double m_range;               // range per iteration
     double m_median;              // median per-iteration time
+    size_t m_samples = 0;         // trials used for the statistics
     int m_exclude_outliers = 1;
     int m_verbose          = 1;
     int m_indent           = 0;
@@ -303,6 +333,7 @@ private:
     void compute_stats() { compute_stats(m_times, m_iterations); }
     void compute_stats(std::vector<double>& times, size_t iterations);
     double iteration_overhead();
+    void record_result() const;
 
     friend OIIO_UTIL_API std::ostream& operator<<(std::ostream& out,
                                              const Benchmarker& bench);
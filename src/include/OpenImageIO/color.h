@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 
 #include <OpenImageIO/export.h>
@@ -22,7 +23,7 @@ OIIO_NAMESPACE_BEGIN
 class OIIO_API ColorProcessor {
 public:
     ColorProcessor() {};
-    virtual ~ColorProcessor(void) {};
+    virtual ~ColorProcessor(void);
     virtual bool isNoOp() const { return false; }
     virtual bool hasChannelCrosstalk() const { return false; }
 
@@ -38,6 +39,29 @@ public:
         apply((float*)data, 1, 1, 3, sizeof(float), 3 * sizeof(float),
               3 * sizeof(float));
     }
+
+    // Return a table holding the transformed RGBA (4 floats) of every
+    // possible value of a UINT8 (256 entries), UINT16 (65536 entries), or
+    // HALF (65536 entries, indexed by the bit pattern) channel, baked from
+    // this processor on first use and kept for the processor's lifetime.
+    // Return nullptr for any other type, or if the transform has channel
+    // crosstalk and so can't be applied one channel at a time. If `bake`
+    // is false, only return a table that has already been baked.
+    const float* lut1d(TypeDesc type, bool bake = true) const;
+
+    // Return a 3D LUT with `size` samples along each axis spanning
+    // [0,1]^3, holding the transformed color of each grid point as 4
+    // floats (the last unused), red varying fastest. It is baked on first
+    // use and kept for the processor's lifetime. Return nullptr if `size`
+    // is not in [2,129], or if the transform alters alpha or its color
+    // results depend on alpha. If `bake` is false, only return a LUT that
+    // has already been baked.
+    const float* lut3d(int size, bool bake = true) const;
+
+private:
+    struct BakedLUTs;
+    mutable std::atomic<BakedLUTs*> m_baked { nullptr };
+    BakedLUTs& baked() const;
 };
 
 // Preprocessor symbol to allow conditional compilation depending on
@@ -152,6 +152,33 @@ public:
     void* data_ptr(int64_t pixel, int channel, int sample);
     const void* data_ptr(int64_t pixel, int channel, int sample) const;
 
+    /// Return the total number of samples of the pixels in the range
+    /// `[pixelbegin, pixelend)`. A negative `pixelend` means "through the
+    /// last pixel."
+    int64_t total_samples(int64_t pixelbegin = 0, int64_t pixelend = -1) const;
+
+    /// Copy the values of channel `channel` for every sample of the pixels
+    /// in `[pixelbegin, pixelend)` (a negative `pixelend` means "through
+    /// the last pixel"), converted to float, into the contiguous array
+    /// `values`, ordered by pixel and then by sample. This gives a
+    /// structure-of-arrays view of one channel that is much cheaper than
+    /// calling `deep_value()` per sample. The `values` span must hold at
+    /// least `total_samples(pixelbegin, pixelend)` entries. Return `true`
+    /// if ok, `false` if the channel or range was invalid or `values` was
+    /// too small.
+    bool get_channel_values(int channel, span<float> values,
+                            int64_t pixelbegin = 0,
+                            int64_t pixelend   = -1) const;
+
+    /// The inverse of `get_channel_values()`: set channel `channel` for
+    /// every sample of the pixels in `[pixelbegin, pixelend)` from the
+    /// contiguous float array `values`, ordered by pixel and then by
+    /// sample. The sample counts are not changed. Return `true` if ok,
+    /// `false` if the channel or range was invalid or `values` was too
+    /// small.
+    bool set_channel_values(int channel, cspan<float> values,
+                            int64_t pixelbegin = 0, int64_t pixelend = -1);
+
     cspan<TypeDesc> all_channeltypes() const;
     cspan<unsigned int> all_samples() const;
     cspan<char> all_data() const;
@@ -22,6 +22,8 @@
 #include <cstdio>
 #include <ctime>
 #include <fstream>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -130,11 +132,37 @@ OIIO_UTIL_API std::string find_program(string_view program);
 /// returned.  Return true if ok, false if there was an error (such as
 /// dirname not being found or not actually being a directory). All file
 /// and directory names are presumed to be UTF-8 encoded.
+///
+/// When recursive, the subdirectories at each depth are listed in parallel,
+/// and each directory's entries follow its parent's. Directory listings
+/// may come from the directory cache (see `set_directory_cache_ttl()`).
 OIIO_UTIL_API bool get_directory_entries (const std::string &dirname,
                                std::vector<std::string> &filenames,
                                bool recursive = false,
                                const std::string &filter_regex=std::string());
 
+/// Set how long, in seconds, a directory's listing may be reused by
+/// get_directory_entries(), scan_for_matching_filenames(), cached_exists(),
+/// and searchpath_find(), rather than the directory being read again. This
+/// process-wide cache saves much time when the same directories are
+/// searched repeatedly on a slow (e.g., network) file system, at the
+/// expense of not noticing files that were created or removed during that
+/// time. The default is 0, which disables the cache, unless overridden by
+/// the environment variable `OPENIMAGEIO_DIRCACHE_TTL`.
+OIIO_UTIL_API void set_directory_cache_ttl (double seconds);
+
+/// Return the current directory cache time-to-live, in seconds.
+OIIO_UTIL_API double directory_cache_ttl ();
+
+/// Discard all cached directory listings.
+OIIO_UTIL_API void clear_directory_cache ();
+
+/// Return true if the UTF-8 encoded path exists. If the directory cache is
+/// enabled (see `set_directory_cache_ttl()`), this is answered from the
+/// cached listing of its parent directory, which is cheap when many files
+/// in the same directories are probed; otherwise it's just exists().
+OIIO_UTIL_API bool cached_exists (string_view path);
+
 /// Return true if the UTF-8 encoded path is an "absolute" (not relative)
 /// path. If 'dot_is_absolute' is true, consider "./foo" absolute.
 OIIO_UTIL_API bool path_is_absolute (string_view path,
@@ -300,6 +328,11 @@ OIIO_UTIL_API std::time_t last_write_time (string_view path) noexcept;
 ///
 OIIO_UTIL_API void last_write_time (string_view path, std::time_t time) noexcept;
 
+/// Get last modified time of the file named by `path` (UTF-8 encoded), in
+/// nanoseconds since the epoch, to whatever finer than one second
+/// resolution the platform keeps. Return 0 if there is any error.
+OIIO_UTIL_API int64_t last_write_time_ns (string_view path) noexcept;
+
 /// Return the size of the file (in bytes), or uint64_t(-1) if there is any
 /// error. The file name is UTF-8 encoded.
 OIIO_UTIL_API uint64_t file_size (string_view path) noexcept;
@@ -566,6 +599,142 @@ protected:
     cspan<unsigned char> m_buf;
 };
 
+
+
+/// IOProxy subclass for reading that memory-maps a whole file read-only.
+/// It behaves like an IOMemReader over the mapped bytes, and `buffer()`
+/// gives direct (zero-copy) access to the mapping, which stays valid for
+/// the lifetime of the proxy. If the file can't be mapped, `opened()`
+/// returns false and `error()` says why.
+class OIIO_UTIL_API IOMMapReader : public IOMemReader {
+public:
+    IOMMapReader(string_view filename);
+    ~IOMMapReader() override;
+    const char* proxytype() const override { return "mmapreader"; }
+    void close() override;
+
+private:
+    void* m_map      = nullptr;  // base of the mapping
+    size_t m_mapsize = 0;        // length of the mapping
+#ifdef _WIN32
+    void* m_mapping = nullptr;  // file mapping object handle
+#endif
+};
+
+
+
+/// IOProxy subclass for reading from storage that can only be fetched by
+/// byte range, typically slowly (for example, an object in S3 or on an
+/// HTTP server). The transport is supplied by the caller as a `fetch`
+/// function that reads `size` bytes starting at `offset` into `buf` and
+/// returns the number of bytes actually delivered; it may be called
+/// concurrently from several threads.
+///
+/// Reads are served from an in-memory cache of `blocksize`-aligned blocks
+/// holding at most `maxblocks` blocks (least recently used are evicted).
+/// Adjacent missing blocks needed by one read are fetched with a single
+/// request, and sequential reading triggers an asynchronous read-ahead of
+/// the next `readahead` blocks. Read-ahead runs on a small thread pool of
+/// its own, not the default one, so it can't be starved by callers that
+/// read from every default pool thread at once. All reads are thread-safe,
+/// and `stats()` reports how many bytes were fetched versus how many were
+/// actually read by the caller.
+class OIIO_UTIL_API IORangeReader : public IOProxy {
+public:
+    using FetchFunc = std::function<size_t(void* buf, size_t size,
+                                           int64_t offset)>;
+    struct Stats {
+        int64_t requests      = 0;  ///< Number of calls to `fetch`
+        int64_t bytes_fetched = 0;  ///< Total bytes returned by `fetch`
+        int64_t bytes_read    = 0;  ///< Total bytes delivered to readers
+        int64_t block_hits    = 0;  ///< Blocks already cached when needed
+        int64_t block_misses  = 0;  ///< Blocks that had to be fetched
+    };
+
+    IORangeReader(string_view filename, size_t filesize, FetchFunc fetch,
+                  size_t blocksize = 1 << 20, size_t maxblocks = 64,
+                  int readahead = 2);
+    ~IORangeReader() override;
+    const char* proxytype() const override { return "rangereader"; }
+    bool seek(int64_t offset) override
+    {
+        m_pos = offset;
+        return true;
+    }
+    size_t read(void* buf, size_t size) override;
+    size_t pread(void* buf, size_t size, int64_t offset) override;
+    size_t size() const override;
+
+    /// Retrieve the fetch statistics so far.
+    Stats stats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+
+
+/// A Linux io_uring submission/completion ring that can be shared by
+/// many threads and many files, so that concurrent reads become in-flight
+/// requests on one ring instead of one blocking syscall each. On other
+/// platforms, or if the kernel doesn't allow io_uring, `valid()` is false
+/// and `read()` falls back to ordinary synchronous reads.
+class OIIO_UTIL_API IOUring {
+public:
+    /// One read of `size` bytes at `offset` of the open file descriptor
+    /// `fd` into `buf`. After `read()`, `result` holds the number of
+    /// bytes read, or -1 on failure.
+    struct Request {
+        int fd         = -1;
+        void* buf      = nullptr;
+        size_t size    = 0;
+        int64_t offset = 0;
+        int64_t result = 0;
+    };
+
+    explicit IOUring(unsigned int entries = 64);
+    ~IOUring();
+    IOUring(const IOUring&)            = delete;
+    IOUring& operator=(const IOUring&) = delete;
+
+    /// Is the ring usable (i.e., are reads really going through io_uring)?
+    bool valid() const;
+
+    /// Submit all of the requests together and wait until all are done.
+    /// Thread-safe.
+    void read(span<Request> requests);
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+
+/// IOProxy subclass for reading a local file through a (possibly shared)
+/// IOUring. If `ring` is null or not valid, it reads with plain `pread`.
+/// Not available on Windows, where it never opens (use IOFile instead).
+class OIIO_UTIL_API IOUringReader : public IOProxy {
+public:
+    IOUringReader(string_view filename, std::shared_ptr<IOUring> ring);
+    ~IOUringReader() override;
+    const char* proxytype() const override { return "uring"; }
+    void close() override;
+    bool seek(int64_t offset) override
+    {
+        m_pos = offset;
+        return true;
+    }
+    size_t read(void* buf, size_t size) override;
+    size_t pread(void* buf, size_t size, int64_t offset) override;
+    size_t size() const override { return m_size; }
+
+private:
+    std::shared_ptr<IOUring> m_ring;
+    int m_fd      = -1;
+    size_t m_size = 0;
+};
+
 };  // namespace Filesystem
 
 OIIO_NAMESPACE_END
@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include <OpenImageIO/export.h>
 #include <OpenImageIO/oiioversion.h>
@@ -121,6 +123,60 @@ public:
     /// Return the name of the filter, e.g., "box", "gaussian"
     virtual string_view name(void) const = 0;
 
+    /// A Table holds a filter's horizontal and vertical weights, sampled
+    /// finely enough that linear interpolation between samples can stand
+    /// in for evaluating the filter in the inner loops of resampling, with
+    /// no virtual calls or transcendental math. A Table of a non-separable
+    /// filter evaluates the filter itself for `operator()`.
+    class Table {
+    public:
+        /// Get the width of the filter
+        float width() const { return 2.0f * m_x.radius; }
+        /// Get the height of the filter
+        float height() const { return 2.0f * m_y.radius; }
+        /// Is the filter separable?
+        bool separable() const { return m_filter == nullptr; }
+        /// Evaluate the filter at an x and y position (relative to filter
+        /// center).
+        float operator()(float x, float y) const
+        {
+            return m_filter ? (*m_filter)(x, y) : xfilt(x) * yfilt(y);
+        }
+        /// Evaluate just the horizontal filter.
+        float xfilt(float x) const { return m_x.lookup(x); }
+        /// Evaluate just the vertical filter.
+        float yfilt(float y) const { return m_y.lookup(y); }
+
+    private:
+        struct Axis {
+            std::vector<float> weights;  // samples from -radius to radius
+            float radius  = 0.0f;
+            float scale   = 0.0f;  // samples per unit distance
+            float edge[2] = { 0.0f, 0.0f };  // exact values at +/-radius
+            float lookup(float x) const
+            {
+                if (!(x > -radius && x < radius))
+                    return x == radius ? edge[1]
+                                       : (x == -radius ? edge[0] : 0.0f);
+                float u = (x + radius) * scale;
+                int i   = std::min(int(u), int(weights.size()) - 2);
+                float f = u - float(i);
+                return weights[i] + f * (weights[i + 1] - weights[i]);
+            }
+        };
+        Axis m_x, m_y;
+        const Filter2D* m_filter = nullptr;  // non-separable filter
+        friend class Filter2D;
+    };
+
+    /// Return a Table of this filter's weights, sampled at `resolution`
+    /// points across each of its width and height. At the default
+    /// resolution, interpolating in the table differs from evaluating any
+    /// of the built-in filters by no more than a few parts per million.
+    /// The Table of a non-separable filter refers to the filter, so must
+    /// not outlive it.
+    Table make_table(int resolution = 4097) const;
+
     /// This static function allocates specific filter implementation for the
     /// name you provide and returns it as a shared_ptr. It will be
     /// automatically deleted when the last reference do it is released.
@@ -912,6 +912,16 @@ convert_type<float,uint8_t> (const float *src, uint8_t *dst, size_t n,
 
 
 #if defined(_HALF_H_) || defined(IMATH_HALF_H_)
+/// Convert a whole array of half values to float, as fast as the hardware
+/// allows: 16 at a time with AVX-512, 8 at a time with F16C, 4 at a time
+/// with NEON or SSE. Converts min(src.size(), dst.size()) values.
+OIIO_UTIL_API void convert_half_to_float (cspan<half> src, span<float> dst);
+
+/// Convert a whole array of float values to half, rounding to nearest
+/// even, using the same hardware as convert_half_to_float(). Converts
+/// min(src.size(), dst.size()) values.
+OIIO_UTIL_API void convert_float_to_half (cspan<float> src, span<half> dst);
+
 template<>
 OIIO_UTIL_API
 void convert_type<half,float> (const half *src, float *dst, size_t n,
@@ -923,10 +933,17 @@ void convert_type<float,half> (const float *src, half *dst, size_t n,
 
 #if OIIO_FMATH_HEADER_ONLY
 // Not just the declarations, give the definitions here.
-template<>
-void convert_type<half,float> (const half *src, float *dst, size_t n,
-                               float /*_min*/, float /*_max*/)
+void convert_half_to_float (cspan<half> src_, span<float> dst_)
 {
+    const half* src = src_.data();
+    float* dst = dst_.data();
+    size_t n = std::min(size_t(src_.size()), size_t(dst_.size()));
+#if OIIO_SIMD_AVX >= 512
+    for ( ; n >= 16; n -= 16, src += 16, dst += 16) {
+        simd::vfloat16 s_simd (src);
+        s_simd.store (dst);
+    }
+#endif
 #if OIIO_SIMD >= 8 && OIIO_F16C_ENABLED
     // If f16c ops are enabled, it's worth doing this by 8's
     for ( ; n >= 8; n -= 8, src += 8, dst += 8) {
@@ -944,11 +961,17 @@ void convert_type<half,float> (const half *src, float *dst, size_t n,
         *dst++ = (*src++);
 }
 
-template<>
-void
-convert_type<float,half> (const float *src, half *dst, size_t n,
-                          half /*_min*/, half /*_max*/)
+void convert_float_to_half (cspan<float> src_, span<half> dst_)
 {
+    const float* src = src_.data();
+    half* dst = dst_.data();
+    size_t n = std::min(size_t(src_.size()), size_t(dst_.size()));
+#if OIIO_SIMD_AVX >= 512
+    for ( ; n >= 16; n -= 16, src += 16, dst += 16) {
+        simd::vfloat16 s (src);
+        s.store (dst);
+    }
+#endif
 #if OIIO_SIMD >= 8 && OIIO_F16C_ENABLED
     // If f16c ops are enabled, it's worth doing this by 8's
     for ( ; n >= 8; n -= 8, src += 8, dst += 8) {
@@ -965,6 +988,21 @@ convert_type<float,half> (const float *src, half *dst, size_t n,
     while (n--)
         *dst++ = *src++;
 }
+
+template<>
+void convert_type<half,float> (const half *src, float *dst, size_t n,
+                               float /*_min*/, float /*_max*/)
+{
+    convert_half_to_float (cspan<half>(src, n), span<float>(dst, n));
+}
+
+template<>
+void
+convert_type<float,half> (const float *src, half *dst, size_t n,
+                          half /*_min*/, half /*_max*/)
+{
+    convert_float_to_half (cspan<float>(src, n), span<half>(dst, n));
+}
 #endif /* if OIIO_FMATH_HEADER_ONLY */
 #endif /* if defined(IMATH_HALF_H_) */
 
@@ -16,6 +16,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -143,6 +144,51 @@ inline size_t xxhash (const Str& s, size_t seed=1771) {
     return xxhash (s.data(), s.length(), seed);
 }
 
+
+/// Incremental XXH64: feed data in pieces with append(), then ask for the
+/// digest. The result is identical to XXH64() of all the appended data
+/// concatenated, but the data never needs to be in memory all at once.
+class OIIO_API XXH64Hasher {
+public:
+    XXH64Hasher (unsigned long long seed=1771) { reset(seed); }
+
+    /// Discard everything appended so far and start over.
+    void reset (unsigned long long seed=1771);
+
+    /// Append more data
+    void append (const void* data, size_t size);
+
+    /// Append more data from a string_view
+    void append (string_view s) { append(s.data(), s.size()); }
+
+    /// Append more data from a span, without thinking about sizes.
+    template<typename T> void append (span<T> v) {
+        append (v.data(), v.size()*sizeof(T));
+    }
+
+    /// Return the hash of everything appended so far. More data may still
+    /// be appended afterwards.
+    unsigned long long digest () const;
+
+    /// Return the digest as a 16 character hex string.
+    std::string hexdigest () const;
+
+private:
+    alignas(8) long long m_state[11];  // opaque XXH64 streaming state
+};
+
+
+/// Compute a fingerprint of the entire contents of the named file. The
+/// file is read and hashed in independent blocks of `blocksize` bytes,
+/// using the thread pool, and the block hashes (along with the file
+/// length) are then hashed together. So the result is not the same as
+/// XXH64 of the whole file, but it is a function only of the file's
+/// contents and of `blocksize`. Return true and store the result in
+/// `hash` upon success, or return false if the file could not be read.
+OIIO_API bool file_hash (string_view filename, unsigned long long& hash,
+                         size_t blocksize = 16 << 20);
+
+
 }   // end namespace xxhash
 
 
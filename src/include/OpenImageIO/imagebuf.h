@@ -16,12 +16,14 @@
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imageio.h>
 
+#include <future>
 #include <limits>
 #include <memory>
 
 
 OIIO_NAMESPACE_BEGIN
 
+class ColorProcessor;
 class ImageBuf;
 class ImageBufImpl;  // Opaque type for the unique_ptr.
 class ImageCache;
@@ -55,6 +57,60 @@ enum class InitializePixels { No = 0, Yes = 1 };
 
 
 
+/// An ImageBufAllocator supplies the pixel memory of ImageBufs that own
+/// their pixels (`LOCALBUFFER` storage). An application may derive its own
+/// to use a custom heap, or use one of the three built in:
+///
+/// - `heap()`, the default, takes 64 byte aligned memory from the general
+///   heap.
+/// - `pool()` keeps freed buffers of 64 KB or more on hand, by size class,
+///   to hand back out for the next allocation of a similar size, which
+///   spares programs that make and discard many same-sized ImageBufs the
+///   cost of the general heap and of the OS faulting in fresh pages. It
+///   is controlled by the global attributes `imagebuf:pool_max_MB` and
+///   `imagebuf:hugepages` (see `OIIO::attribute()`).
+/// - `pinned()` takes page-locked memory from the OS (falling back to
+///   unlocked memory if the OS limit on locked memory is reached).
+///
+/// Since `read()` decodes straight into the memory the allocator supplies,
+/// and `write()` encodes straight from it, an allocator is also how pixels
+/// are kept in memory that a GPU can reach by DMA. `pinned()` suits any
+/// GPU API, while an application using CUDA or Vulkan may instead derive
+/// an allocator wrapping, for example, `cudaHostAlloc()`/`cudaFreeHost()`
+/// or memory it has registered with its device. OIIO itself never touches
+/// device memory, so such buffers must be host-addressable.
+///
+/// The global `attribute("imagebuf:allocator")` chooses which of the three
+/// ImageBufs use unless `ImageBuf::set_allocator()` says otherwise.
+/// Allocators must be thread-safe and must outlive every ImageBuf whose
+/// pixels they supplied.
+class OIIO_API ImageBufAllocator {
+public:
+    virtual ~ImageBufAllocator();
+
+    /// Return `size` bytes of pixel memory, aligned at least as well as
+    /// `new char[]`, or nullptr if it could not be allocated. The memory
+    /// need not be zeroed.
+    virtual void* allocate(size_t size) = 0;
+
+    /// Give back memory that `allocate(size)` returned.
+    virtual void deallocate(void* ptr, size_t size) = 0;
+
+    /// The plain `new`/`delete` allocator.
+    static ImageBufAllocator* heap();
+
+    /// The built-in recycling pool, shared by the whole process.
+    static ImageBufAllocator* pool();
+
+    /// The built-in page-locked ("pinned") host memory allocator.
+    static ImageBufAllocator* pinned();
+
+    /// The allocator currently selected by `imagebuf:allocator`.
+    static ImageBufAllocator* current();
+};
+
+
+
 /// An ImageBuf is a simple in-memory representation of a 2D image.  It uses
 /// ImageInput and ImageOutput underneath for its file I/O, and has simple
 /// routines for setting and getting individual pixels, that hides most of
@@ -133,13 +189,19 @@ public:
             /// owned by the calling application. The caller will continue
             /// to own that memory and be responsible for freeing it after
             /// the ImageBuf is destroyed.
-        IMAGECACHE
+        IMAGECACHE,
             ///< The ImageBuf is "backed" by an ImageCache, which will
             /// automatically be used to retrieve pixels when requested, but
             /// the ImageBuf will not allocate separate storage for it. 
             /// This brings all the advantages of the ImageCache, but can
             /// only be used for read-only ImageBuf's that reference a
             /// stored image file.
+        MMAPBUFFER
+            ///< The ImageBuf owns pixels that live in a memory-mapped file
+            /// (see `reset_mmap()`) rather than in allocated memory. They
+            /// may be read and written directly, just like `LOCALBUFFER`,
+            /// but the OS pages them in and out of RAM as needed, so the
+            /// image may be much larger than physical memory.
         // clang-format on
     };
 
@@ -255,6 +317,13 @@ public:
     ImageBuf(string_view name, const ImageSpec& spec, void* buffer);
 
     /// Construct a copy of an ImageBuf.
+    ///
+    /// If `src` owns its local pixel memory, the copy initially shares
+    /// that memory rather than duplicating it, and whichever of the two
+    /// first asks for writable access to the pixels (non-const
+    /// `localpixels()` or `pixeladdr()`, a writing `Iterator`,
+    /// `make_writable()`, or any ImageBufAlgo destination) quietly gets its
+    /// own private copy at that time.
     ImageBuf(const ImageBuf& src);
 
     /// Move the contents of an ImageBuf to another ImageBuf.
@@ -306,6 +375,26 @@ public:
                stride_t xstride = AutoStride, stride_t ystride = AutoStride,
                stride_t zstride = AutoStride);
 
+    /// Destroy any previous contents of the ImageBuf and re-initialize it
+    /// as a read/write image described by `spec`, whose pixels are kept
+    /// in a memory-mapped file (`MMAPBUFFER` storage) in native contiguous
+    /// layout instead of in allocated memory. This allows out-of-core
+    /// processing of images far larger than RAM while retaining direct
+    /// pointer access to the pixels for iterators and ImageBufAlgo.
+    ///
+    /// If `path` is empty, an unnamed scratch file is created in the
+    /// temporary directory and is removed when the ImageBuf releases its
+    /// pixels. Otherwise, the named file is used and persists afterwards;
+    /// if it already exists with exactly the size needed for `spec`, its
+    /// contents are kept as the pixel values, otherwise it is resized and
+    /// the pixels start out zero.
+    ///
+    /// @returns
+    ///             `true` upon success, or `false` (with an error set and
+    ///             the ImageBuf left uninitialized) if the file could not
+    ///             be created or mapped.
+    bool reset_mmap(const ImageSpec& spec, string_view path = "");
+
     /// Make the ImageBuf be writable. That means that if it was previously
     /// backed by an ImageCache (storage was `IMAGECACHE`), it will force a
     /// full read so that the whole image is in local memory. This will
@@ -434,6 +523,23 @@ public:
               TypeDesc convert, ProgressCallback progress_callback = nullptr,
               void* progress_callback_data = nullptr);
 
+    /// Read only a window of the file: the pixels of `roi` (intersected
+    /// with the file's data window) and channels `[roi.chbegin,
+    /// roi.chend)`, into local pixel memory whose data window is that
+    /// region. Only the scanlines or tiles that overlap the window are
+    /// decoded, which makes extracting a crop or thumbnail-sized region of
+    /// a huge image very much cheaper than reading all of it. The display
+    /// window is unchanged. An undefined `roi` reads the whole image (and
+    /// then `force` behaves as for the other `read()` varieties).
+    ///
+    /// @returns
+    ///             `true` upon success, or `false` if the read failed or
+    ///             `roi` did not overlap the data window at all.
+    bool read(int subimage, int miplevel, ROI roi, bool force = true,
+              TypeDesc convert                   = TypeDesc::UNKNOWN,
+              ProgressCallback progress_callback = nullptr,
+              void* progress_callback_data       = nullptr);
+
     /// Read the ImageSpec for the given file, subimage, and MIP level into
     /// the ImageBuf, but will not read the pixels or allocate any local
     /// storage (until a subsequent call to `read()`).  This is helpful if
@@ -508,6 +614,26 @@ public:
                ProgressCallback progress_callback = nullptr,
                void* progress_callback_data       = nullptr) const;
 
+    /// Write the image to the named file like `write()`, but do the
+    /// encoding and I/O on a background writer thread and return
+    /// immediately. The pixels are snapshotted first (cheaply, by sharing
+    /// them copy-on-write, except for `APPBUFFER` images, which must be
+    /// duplicated), so `*this` may be modified or destroyed right away
+    /// without affecting what is written.
+    ///
+    /// Writes run on their own pool of `imagebuf:write_threads` threads.
+    /// If the snapshots already waiting to be written exceed
+    /// `imagebuf:write_max_MB`, this call blocks until enough of them
+    /// finish.
+    ///
+    /// @returns
+    ///             A future whose value is an empty string once the write
+    ///             has succeeded, or the error message if it failed. Be
+    ///             sure to wait on it before exiting the application.
+    std::future<std::string>
+    write_async(string_view filename, TypeDesc dtype = TypeUnknown,
+                string_view fileformat = string_view()) const;
+
     /// Set the pixel data format that will be used for subsequent `write()`
     /// calls that do not themselves request a specific data type request.
     ///
@@ -544,6 +670,28 @@ public:
     /// tiling choice will be made automatically.
     void set_write_tiles(int width = 0, int height = 0, int depth = 0);
 
+    /// Set a color transformation to be applied to the pixels by
+    /// subsequent calls to `write()` (of either variety). The pixels are
+    /// converted to float and transformed one strip of scanlines or tiles
+    /// at a time, just before they are handed to the ImageOutput, which
+    /// quantizes (and dithers) them to the file's data type as usual. This
+    /// fuses `ImageBufAlgo::colorconvert()` with the write: the ImageBuf's
+    /// own pixels are left unchanged, and no full-size converted copy of
+    /// the image is ever made.
+    ///
+    /// The caller is responsible for setting the `"oiio:ColorSpace"`
+    /// metadata of the file, if desired.
+    ///
+    /// @param  processor
+    ///             The color transformation, or an empty pointer to stop
+    ///             transforming subsequent writes.
+    /// @param  unpremult
+    ///             As for `ImageBufAlgo::colorconvert()`, divide the color
+    ///             channels by alpha before the transformation and
+    ///             multiply them by it afterwards.
+    void set_write_colorprocessor(std::shared_ptr<ColorProcessor> processor,
+                                  bool unpremult = true);
+
     /// Supply an IOProxy to use for a subsequent call to `write()`.
     ///
     /// If a proxy is set but it later turns out that the file format
@@ -619,6 +767,10 @@ public:
     /// channels.  The data type of the pixels will be converted
     /// automatically to the data type of the app buffer.
     ///
+    /// If no data type conversion is needed and `src` owns contiguous local
+    /// pixel memory, `*this` will share it copy-on-write, as described for
+    /// the copy constructor.
+    ///
     /// @param  src
     ///             Another ImageBuf from which to copy the pixels and
     ///             metadata.
@@ -636,6 +788,26 @@ public:
     /// data format conversion).
     ImageBuf copy(TypeDesc format /*= TypeDesc::UNKNOWN*/) const;
 
+    /// Return an ImageBuf that is a *view* of the pixels of region `roi`
+    /// (including its channel range) of `this` ImageBuf, referencing them
+    /// in place, with the strides of `this`, rather than copying them. The
+    /// data window of the view is `roi`, and it has `roi.nchannels()`
+    /// channels, named and designated as the corresponding channels of
+    /// `this`. The default `roi` of `ROI::All()` means the whole image.
+    ///
+    /// If `this` owns its local pixel memory, the view shares it
+    /// copy-on-write, just like a copy would: it keeps the memory alive,
+    /// and whichever of the two ImageBufs is later written to gets its own
+    /// private copy first (for the view, a contiguous copy of just its own
+    /// region). If `this` wraps an application buffer, the view has
+    /// `APPBUFFER` storage wrapping the same memory, which must outlive it,
+    /// and writes through either are seen by both. A cache-backed image
+    /// has no pixels to reference, so the region is simply copied.
+    ///
+    /// Deep images are not supported. Upon failure (including a `roi` that
+    /// does not overlap the image), the returned ImageBuf has an error set.
+    ImageBuf view(ROI roi = ROI::All()) const;
+
     /// Swap the entire contents with another ImageBuf.
     void swap(ImageBuf& other) { std::swap(m_impl, other.m_impl); }
 
@@ -814,8 +986,9 @@ public:
     /// enumerated type describing the type of storage currently employed by
     /// the ImageBuf: `UNINITIALIZED` (no storage), `LOCALBUFFER` (the
     /// ImageBuf has allocated and owns the pixel memory), `APPBUFFER` (the
-    /// ImageBuf "wraps" memory owned by the calling application), or
-    /// `IMAGECACHE` (the image is backed by an ImageCache).
+    /// ImageBuf "wraps" memory owned by the calling application),
+    /// `IMAGECACHE` (the image is backed by an ImageCache), or `MMAPBUFFER`
+    /// (the ImageBuf owns pixels in a memory-mapped file).
     IBStorage storage() const;
 
     /// Return a read-only (const) reference to the image spec that
@@ -993,6 +1166,11 @@ public:
     /// `pixel_stride()`, `scanline_stride()`, and `z_stride()` methods
     /// to find out the spacing between pixels, scanlines, and volumetric
     /// planes, respectively.
+    ///
+    /// The non-const version implies intent to write, so if the pixel
+    /// memory is shared with another ImageBuf (see the copy constructor),
+    /// it first makes a private copy, and pointers previously obtained
+    /// from the const version should no longer be used.
     void* localpixels();
     const void* localpixels() const;
 
@@ -1025,6 +1203,30 @@ public:
     const void* pixeladdr(int x, int y, int z = 0, int ch = 0) const;
     void* pixeladdr(int x, int y, int z = 0, int ch = 0);
 
+    /// Return a span of all the channel values of pixels `[xbegin,xend)`
+    /// of scanline `y` (of slice `z`), as they are stored contiguously in
+    /// local memory, for loops that a compiler can easily vectorize. The
+    /// span is empty if the pixels are not local, are not of type `T`, are
+    /// not packed contiguously within the scanline, or if the range is not
+    /// entirely inside the data window. Note that the values are raw, so
+    /// integer types are not normalized as they are by `Iterator`.
+    template<typename T>
+    span<T> scanline_span(int xbegin, int xend, int y, int z = 0)
+    {
+        if (!scanline_span_ok(BaseTypeFromC<T>::value, xbegin, xend, y, z))
+            return span<T>();
+        return span<T>((T*)pixeladdr(xbegin, y, z),
+                       size_t(xend - xbegin) * nchannels());
+    }
+    template<typename T>
+    cspan<T> scanline_span(int xbegin, int xend, int y, int z = 0) const
+    {
+        if (!scanline_span_ok(BaseTypeFromC<T>::value, xbegin, xend, y, z))
+            return cspan<T>();
+        return cspan<T>((const T*)pixeladdr(xbegin, y, z),
+                        size_t(xend - xbegin) * nchannels());
+    }
+
     /// Return the index of pixel (x,y,z). If check_range is true, return
     /// -1 for an invalid coordinate that is not within the data window.
     int pixelindex(int x, int y, int z, bool check_range = false) const;
@@ -1045,6 +1247,16 @@ public:
     /// Retrieve the current thread-spawning policy of this ImageBuf.
     int threads() const;
 
+    /// Use `allocator` (or, if it is nullptr, the global default as set by
+    /// `attribute("imagebuf:allocator")`) for any pixel memory this
+    /// ImageBuf allocates from now on. Memory already allocated stays
+    /// where it is, and is returned to the allocator that supplied it.
+    void set_allocator(ImageBufAllocator* allocator);
+
+    /// Retrieve the allocator set by `set_allocator()`, or nullptr if this
+    /// ImageBuf uses the global default.
+    ImageBufAllocator* allocator() const;
+
     /// @}
 
     /// @{
@@ -1604,6 +1816,10 @@ protected:
     // x,y,z is within the valid pixel data window, false if it still is
     // not.
     bool do_wrap(int& x, int& y, int& z, WrapMode wrap) const;
+
+    // Can scanline_span() of this type and range be honored?
+    bool scanline_span_ok(TypeDesc type, int xbegin, int xend, int y,
+                          int z) const;
 };
 
 
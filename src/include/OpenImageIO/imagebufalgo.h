@@ -199,6 +199,57 @@ namespace ImageBufAlgo {
 using KWArgs = ParamValueSpan;
 
 
+/// A ComputeBackend is an optional accelerator (for example, one running
+/// CUDA or Vulkan compute kernels) that some ImageBufAlgo operations offer
+/// their work to before running their own CPU code: `resize()` (given a
+/// filter), `convolve()`, `colorconvert()` (given a processor), `over()`,
+/// `add()`, `sub()`, `mul()`, and `mad()`.
+///
+/// Each method is called after the operation has checked its arguments,
+/// settled the ROI, and allocated `dst` if needed. It should return true
+/// if it computed the result, or false to decline -- for example, because
+/// the buffers are not in memory it can reach (see `ImageBufAllocator`),
+/// or the data types or sizes are not worth the transfer -- in which case
+/// the operation continues on the CPU as usual. The default of every
+/// method is to decline. A backend may be called from many threads at
+/// once, and must outlive its installation.
+class OIIO_API ComputeBackend {
+public:
+    virtual ~ComputeBackend();
+
+    /// A short name for the backend, such as "cuda".
+    virtual const char* name() const = 0;
+
+    virtual bool resize(ImageBuf& dst, const ImageBuf& src,
+                        const Filter2D* filter, ROI roi, int nthreads);
+    virtual bool convolve(ImageBuf& dst, const ImageBuf& src,
+                          const ImageBuf& kernel, bool normalize, ROI roi,
+                          int nthreads);
+    virtual bool colorconvert(ImageBuf& dst, const ImageBuf& src,
+                              const ColorProcessor* processor, bool unpremult,
+                              ROI roi, int nthreads);
+    virtual bool over(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
+                      ROI roi, int nthreads);
+    virtual bool add(ImageBuf& dst, const Image_or_Const& A,
+                     const Image_or_Const& B, ROI roi, int nthreads);
+    virtual bool sub(ImageBuf& dst, const Image_or_Const& A,
+                     const Image_or_Const& B, ROI roi, int nthreads);
+    virtual bool mul(ImageBuf& dst, const Image_or_Const& A,
+                     const Image_or_Const& B, ROI roi, int nthreads);
+    virtual bool mad(ImageBuf& dst, const Image_or_Const& A,
+                     const Image_or_Const& B, const Image_or_Const& C,
+                     ROI roi, int nthreads);
+};
+
+/// Install `backend` (or, if it is nullptr, none) as the ComputeBackend
+/// that ImageBufAlgo operations offer their work to, returning the one
+/// it replaces.
+ComputeBackend* OIIO_API set_compute_backend (ComputeBackend* backend);
+
+/// Return the installed ComputeBackend, or nullptr if there is none.
+ComputeBackend* OIIO_API compute_backend ();
+
+
 /// Create an all-black `float` image of size and channels as described by
 /// the ROI.
 ImageBuf OIIO_API zero (ROI roi, int nthreads=0);
@@ -668,6 +719,14 @@ bool OIIO_API rotate (ImageBuf &dst, const ImageBuf &src,
 ///     `make_pv("filterptr", raw_filter_ptr)`.
 ///     Use with caution!
 ///
+///   - "usemip" : int (default: 0)
+///
+///     If nonzero and `src` is backed by an ImageCache and holds a MIP-mapped
+///     image (such as a texture made by `maketx`), filter from the smallest
+///     MIP level that is still at least as large as the result, rather than
+///     from the full-resolution level, which reads far fewer pixels and
+///     avoids filling the cache with tiles of the full resolution image.
+///
 /// The caller may either (a) explicitly pass a reconstruction `filter`, or
 /// (b) specify one by `filtername` and `filterwidth`. If `filter` is
 /// `nullptr` or if `filtername` is the empty string `resize()` will choose
@@ -744,6 +803,12 @@ bool OIIO_API resample (ImageBuf &dst, const ImageBuf &src,
 ///     `make_pv("filterptr", raw_filter_ptr)`.
 ///     Use with caution!
 ///
+///   - "usemip" : int (default: 0)
+///
+///     If nonzero, an ImageCache-backed MIP-mapped `src` is filtered from
+///     its smallest MIP level that still covers the fitted size, as with
+///     the same option of `resize()`.
+///
 ///   - "fillmode" : string (default: "letterbox")
 ///
 ///     The `fillmode` determines which of several methods will be used to
@@ -812,7 +877,10 @@ bool OIIO_API fit(ImageBuf &dst, const ImageBuf &src, KWArgs options = {},
 ///     The type of reconstruction filter used to weight the `src` pixels
 ///     falling underneath it for each `dst` pixel.  If the value is the
 ///     empty string or not supplied, a reasonable high-quality filter will
-///     be chosen automatically.
+///     be chosen automatically. The special name "bilinear" skips the
+///     filter and just bilinearly interpolates `src` at each transformed
+///     pixel center, which is much faster but aliases when minifying; it
+///     is intended for interactive previews.
 ///
 ///   - "filterwidth" : float (default: 0)
 ///
@@ -895,6 +963,14 @@ bool OIIO_API warp(ImageBuf &dst, const ImageBuf &src, M33fParam M,
 ///             when computing source pixel positions. This is useful if the
 ///             coordinates are defined in terms of a different image origin 
 ///             than OpenImageIO's.
+///
+/// If `filtername` is `"texture"`, `src` is instead MIP-mapped in memory
+/// and sampled through the batched TextureSystem lookups, with filter
+/// footprints taken from the differences between neighboring st values.
+/// That is much faster for large images, and correctly filters regions
+/// that the warp minifies, at the cost of building the MIP-map first. In
+/// this mode st values of 0 to 1 span the full (display) window of `src`,
+/// and concurrent calls take turns with the one TextureSystem they share.
 
 ImageBuf OIIO_API st_warp (const ImageBuf &src, const ImageBuf& stbuf,
                            string_view filtername=string_view(),
@@ -1028,6 +1104,19 @@ ImageBuf OIIO_API over (const ImageBuf &A, const ImageBuf &B,
 bool OIIO_API over (ImageBuf &dst, const ImageBuf &A, const ImageBuf &B,
                     ROI roi={}, int nthreads=0);
 
+/// Return the composite of a whole stack of `layers`, ordered front to
+/// back: the same result as `over(layers[0], over(layers[1], ...))`, but
+/// computed in a single pass that, for each pixel, stops at the first
+/// opaque layer. All layers must have alpha channels and the same number
+/// of channels. If `dst` is uninitialized, it is sized to the union of the
+/// layers' pixel data windows, and is float unless all the layers share a
+/// data type.
+ImageBuf OIIO_API over (cspan<const ImageBuf*> layers, ROI roi={},
+                        int nthreads=0);
+/// Write to an existing image `dst` (allocating if it is uninitialized).
+bool OIIO_API over (ImageBuf &dst, cspan<const ImageBuf*> layers,
+                    ROI roi={}, int nthreads=0);
+
 
 /// Just like `ImageBufAlgo::over()`, but inputs `A` and `B` must have
 /// designated 'z' channels, and on a pixel-by-pixel basis, the z values
@@ -1115,6 +1204,36 @@ bool OIIO_API channel_sum (ImageBuf &dst, const ImageBuf &src,
                            ROI roi={}, int nthreads=0);
 
 
+/// Extract per-object coverage mattes from a Cryptomatte layer of `src`.
+///
+/// The layer's rank channels are those named `<layer>NN.<chan>` (such as
+/// `CryptoObject00.R` through `CryptoObject02.A`), which pair up in channel
+/// order as (ID, coverage). Each of the `ids` is an object ID as stored in
+/// the ID channels, a 32-bit hash bit-cast to float (see `cryptomatte_id()`
+/// to compute one from an object name). The result has one float channel
+/// per requested ID holding the total coverage of that object. A single
+/// ID gives a one-channel image with the channel named "A"; otherwise the
+/// channels are named `<layer>.<8 hex digits of the ID>`.
+///
+/// The rank channels are read once per pixel, and each ID found there is
+/// looked up in a hash of the requested set, so extracting many IDs costs
+/// barely more than extracting one. The rank channels must be `float`
+/// (an ID stored as `half` can't be recovered).
+ImageBuf OIIO_API cryptomatte_extract (const ImageBuf &src,
+                                       string_view layer, cspan<float> ids,
+                                       ROI roi={}, int nthreads=0);
+/// Write to an existing image `dst` (allocating if it is uninitialized).
+bool OIIO_API cryptomatte_extract (ImageBuf &dst, const ImageBuf &src,
+                                   string_view layer, cspan<float> ids,
+                                   ROI roi={}, int nthreads=0);
+
+/// Return the Cryptomatte ID of the object called `name`: the 32-bit
+/// MurmurHash3 of the name (with its exponent bits nudged so it is never a
+/// denormal, infinity, or NaN), bit-cast to float, as it appears in the ID
+/// channels and manifest of a Cryptomatte layer.
+float OIIO_API cryptomatte_id (string_view name);
+
+
 /// @defgroup maxminclamp (Maximum, minimum, clamping)
 /// @{
 ///
@@ -1172,6 +1291,85 @@ bool OIIO_API clamp (ImageBuf &dst, const ImageBuf &src,
 /// @}
 
 
+/// Expr is a lazily evaluated chain of the per-pixel math of `add()`,
+/// `sub()`, `mul()`, `mad()`, `clamp()`, `pow()`, `invert()`, and
+/// `colorconvert()`. Building an Expr does no work; `Expr::eval()` runs the
+/// whole chain in one pass, scanline by scanline under `parallel_image()`,
+/// so a chain of any length reads each input pixel once and writes each
+/// result pixel once, with no intermediate images. For example,
+///
+///     using ImageBufAlgo::Expr;
+///     ImageBuf R = (Expr(A) * 2.0f + B).clamp(0.0f, 1.0f).pow(0.45f).eval();
+///
+/// computes the same pixels as the corresponding sequence of IBA calls.
+/// An Expr refers to its images without copying them, so they must stay
+/// alive (and unchanged) until it is evaluated. Arithmetic is done in
+/// float; channels that an input image lacks read as 0, as do pixels
+/// outside its data window. Deep images are not supported.
+class OIIO_API Expr {
+public:
+    /// An expression whose value is the pixels of `img`.
+    Expr(const ImageBuf& img);
+    /// A constant, either one value for all channels or per-channel
+    /// values. If there are fewer values than channels, the last one is
+    /// used for the rest.
+    Expr(float val);
+    Expr(cspan<float> val);
+    template<size_t N>
+    Expr(const float (&array)[N]) : Expr(cspan<float>(array)) {}
+
+    /// Per-pixel sum, difference, and product, like `add()`, `sub()`,
+    /// and `mul()`.
+    friend Expr operator+(const Expr& A, const Expr& B)
+    {
+        return binary('+', A, B);
+    }
+    friend Expr operator-(const Expr& A, const Expr& B)
+    {
+        return binary('-', A, B);
+    }
+    friend Expr operator*(const Expr& A, const Expr& B)
+    {
+        return binary('*', A, B);
+    }
+
+    /// Per-pixel `A * B + C`, like `mad()`.
+    static Expr mad(const Expr& A, const Expr& B, const Expr& C);
+    /// This value clamped to [min, max], like `clamp()`.
+    Expr clamp(cspan<float> min = -std::numeric_limits<float>::max(),
+               cspan<float> max = std::numeric_limits<float>::max(),
+               bool clampalpha01 = false) const;
+    /// This value raised to the per-channel power `b`, like `pow()`.
+    Expr pow(cspan<float> b) const;
+    /// `1 - this`, like `invert()`.
+    Expr invert() const;
+    /// This value transformed by `processor`, which must stay alive until
+    /// the expression is evaluated, like `colorconvert()`. It applies to
+    /// the first channels (three, or four if there is a fourth, which is
+    /// taken to be alpha), and needs the evaluation `roi.chbegin` to be 0.
+    Expr colorconvert(const ColorProcessor* processor,
+                      bool unpremult = true) const;
+
+    /// Evaluate the expression over the region of interest, returning the
+    /// result. If `roi` is not defined, it is the union of the data
+    /// windows of the images in the expression, and the result takes the
+    /// spec (including data format) of the first image.
+    ImageBuf eval(ROI roi = {}, int nthreads = 0) const;
+    /// Write to an existing image `dst` (allocating if it is uninitialized).
+    bool eval(ImageBuf& dst, ROI roi = {}, int nthreads = 0) const;
+
+    struct Node;
+
+private:
+    Expr(std::shared_ptr<const Node> node) : m_node(std::move(node)) {}
+    static Expr binary(char op, const Expr& A, const Expr& B);
+    std::shared_ptr<const Node> m_node;
+};
+
+
+/// @}
+
+
 /// @defgroup maxminchan (Maximum / minimum of channels)
 /// @{
 ///
@@ -1346,6 +1544,9 @@ bool OIIO_API rangeexpand (ImageBuf &dst, const ImageBuf &src,
 /// @}
 
 
+/// Per-channel statistics of the pixel values of an image, as computed by
+/// `computePixelStats()`. The min, max, avg, and stddev consider only the
+/// finite values.
 struct OIIO_API PixelStats {
     std::vector<float> min;
     std::vector<float> max;
@@ -1360,6 +1561,11 @@ struct OIIO_API PixelStats {
     PixelStats (PixelStats&& other) = default;
     PixelStats (int nchannels) { reset(nchannels); }
     void reset (int nchannels);
+    /// Fold in the stats `p` of other pixels, as if they had all been
+    /// measured together, updating avg and stddev to match. This lets
+    /// stats gathered separately (for tiles, frames, or on other machines)
+    /// be accumulated without revisiting any pixels. A default-constructed
+    /// PixelStats takes on the number of channels of the first one merged.
     void merge (const PixelStats &p);
     const PixelStats& operator= (PixelStats&& other);  // Move assignment
 };
@@ -1414,6 +1620,24 @@ CompareResults OIIO_API compare (const ImageBuf &A, const ImageBuf &B,
                                  float failrelative, float warnrelative,
                                  ROI roi={}, int nthreads=0);
 
+/// Numerically compare two images as above, with two options for when only
+/// the pass/fail verdict matters:
+///
+/// - If `maxfailures` > 0, the comparison stops as soon as that many pixels
+///   have failed. The error statistics (and `nwarn`) then only account for
+///   the pixels examined up to that point.
+/// - If `skip_identical` is true and both images store the same pixel data
+///   type and number of channels, bands of scanlines are first compared
+///   byte for byte in their native format, and the numerical comparison is
+///   only done for the bands that differ. This makes comparing identical
+///   images about as fast as reading their pixels. Skipped bands do not
+///   contribute to the peak value used for `PSNR`.
+CompareResults OIIO_API compare (const ImageBuf &A, const ImageBuf &B,
+                                 float failthresh, float warnthresh,
+                                 float failrelative, float warnrelative,
+                                 imagesize_t maxfailures, bool skip_identical,
+                                 ROI roi={}, int nthreads=0);
+
 /// Numerically compare two images.  The difference threshold (for any
 /// individual color channel in any pixel) for a "failure" is
 /// failthresh, and for a "warning" is warnthresh.  The results are
@@ -1576,6 +1800,27 @@ std::string OIIO_API computePixelHashSHA1 (const ImageBuf &src,
                                            int blocksize = 0, int nthreads=0);
 
 
+/// Compute a hash of all the pixels in the specified region of the image,
+/// returned as a hex string.  The `hashtype` selects the algorithm:
+///
+/// - `"xxhash"` (or `"xxh64"`, the default) is a fast, non-cryptographic
+///   64 bit hash, suitable for detecting changed images and for cache
+///   keys but not for security purposes. Blocks of scanlines are hashed
+///   in parallel using `nthreads` threads, and the block hashes are
+///   combined in order, so the result does not depend on the number of
+///   threads or on how the pixels are stored in memory.
+/// - `"sha1"` is the same as `computePixelHashSHA1(src, extrainfo, roi)`.
+///
+/// The `extrainfo` provides additional text that will be incorporated into
+/// the hash. Deep images are hashed by their sample counts and sample
+/// values. If `hashtype` is not recognized, an empty string is returned and
+/// an error message will be retrievable from `src.geterror()`.
+std::string OIIO_API computePixelHash (const ImageBuf &src,
+                                       string_view hashtype = "xxhash",
+                                       string_view extrainfo = "",
+                                       ROI roi={}, int nthreads=0);
+
+
 /// Compute a histogram of `src`, for the given channel and ROI. Return a
 /// vector of length `bins` that contains the counts of how many pixel
 /// values were in each of `bins` equally spaced bins covering the range of
@@ -1592,6 +1837,20 @@ std::vector<imagesize_t> histogram (const ImageBuf &src, int channel=0,
                                     ROI roi={}, int nthreads=0);
 
 
+/// Compute histograms of all the channels of `src` in `roi` in a single
+/// pass, returning one vector of `bins` counts for each of those channels
+/// (so `result[0]` is the histogram of channel `roi.chbegin`). The bins and
+/// `ignore_empty` are as for `histogram()`. Each thread accumulates its own
+/// bins, merged at the end, and 8 and 16 bit unsigned images are binned
+/// directly from their integer values.
+///
+/// If there was an error, the returned vector will be empty, and an error
+/// message will be retrievable from src.geterror().
+OIIO_API std::vector<std::vector<imagesize_t>>
+histograms (const ImageBuf &src, int bins=256, float min=0.0f, float max=1.0f,
+            bool ignore_empty=false, ROI roi={}, int nthreads=0);
+
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 /// DEPRECATED(1.9)
 OIIO_DEPRECATED("use version that returns vector (1.9)")
@@ -1636,7 +1895,9 @@ ImageBuf OIIO_API make_kernel (string_view name, float width, float height,
 /// Return the convolution of `src` and a `kernel`. If `roi` is not defined,
 /// it defaults to the full size `src`. If `normalized` is true, the kernel will
 /// be normalized for the  convolution, otherwise the original values will
-/// be used.
+/// be used. Kernels that are the product of a row and a column (such as the
+/// "box", "gaussian", and "binomial" kernels of `make_kernel()`) are found
+/// automatically and applied as two much cheaper 1D passes.
 ImageBuf OIIO_API convolve (const ImageBuf &src, const ImageBuf &kernel,
                             bool normalize = true, ROI roi={}, int nthreads=0);
 /// Write to an existing image `dst` (allocating if it is uninitialized).
@@ -1647,6 +1908,21 @@ bool OIIO_API convolve (ImageBuf &dst, const ImageBuf &src, const ImageBuf &kern
                         bool normalize = true, ROI roi={}, int nthreads=0);
 
 
+/// Return the convolution of `src` and a 2D `kernel`, like `convolve()`,
+/// but always computed with FFTs, a tile at a time across threads. This
+/// costs about the same per pixel whatever the kernel size, so it is far
+/// faster than direct convolution for large kernels such as bokeh or glare
+/// shapes (`convolve()` itself switches to it for large kernels that are not
+/// separable). Results match `convolve()` up to floating point rounding.
+ImageBuf OIIO_API fft_convolve (const ImageBuf &src, const ImageBuf &kernel,
+                                bool normalize = true, ROI roi={},
+                                int nthreads=0);
+/// Write to an existing image `dst` (allocating if it is uninitialized).
+bool OIIO_API fft_convolve (ImageBuf &dst, const ImageBuf &src,
+                            const ImageBuf &kernel, bool normalize = true,
+                            ROI roi={}, int nthreads=0);
+
+
 /// Return the Laplacian of the corresponding region of `src`.  The
 /// Laplacian is the generalized second derivative of the image
 /// \f[
@@ -1795,7 +2071,8 @@ bool OIIO_API fillholes_pushpull (ImageBuf &dst, const ImageBuf &src,
 ///
 /// Median filters are good for removing high-frequency detail smaller than
 /// the window size (including noise), without blurring edges that are
-/// larger than the window size.
+/// larger than the window size. This is `rank_filter()` with a rank of
+/// 0.5, and shares its costs and precision.
 ImageBuf OIIO_API median_filter (const ImageBuf &src,
                                  int width = 3, int height = -1,
                                  ROI roi={}, int nthreads=0);
@@ -1805,6 +2082,29 @@ bool OIIO_API median_filter (ImageBuf &dst, const ImageBuf &src,
                              ROI roi={}, int nthreads=0);
 
 
+/// Return a rank-filtered version of the corresponding region of `src`:
+/// each pixel is replaced, channel by channel, with the value at the given
+/// `rank` (0 is the lowest, 1 the highest) among the `width` x `height`
+/// window values surrounding it, so 0.5 is the median filter, and 0 and 1
+/// are a box erode and dilate. If `height` <= 0, it will be set to
+/// `width`, making a square window. Edge pixels are repeated outside the
+/// image.
+///
+/// 8 and 16 bit images are filtered exactly using histograms, so the cost
+/// per pixel does not grow with the window area (for 8 bit) or only grows
+/// with its height (16 bit). Other data types are histogrammed by the rank
+/// of their distinct values, which is exact unless the image has more than
+/// 65536 distinct values in a channel, in which case they are binned into
+/// 65536 levels and the result may be off by one level.
+ImageBuf OIIO_API rank_filter (const ImageBuf &src, float rank,
+                               int width = 3, int height = -1,
+                               ROI roi={}, int nthreads=0);
+/// Write to an existing image `dst` (allocating if it is uninitialized).
+bool OIIO_API rank_filter (ImageBuf &dst, const ImageBuf &src, float rank,
+                           int width = 3, int height = -1,
+                           ROI roi={}, int nthreads=0);
+
+
 /// Return a sharpened version of the corresponding region of `src` using
 /// the "unsharp mask" technique. Unsharp masking basically works by first
 /// blurring the image (low pass filter), subtracting this from the original
@@ -1841,7 +2141,9 @@ bool OIIO_API unsharp_mask (ImageBuf &dst, const ImageBuf &src,
 /// the structuring element (which is taken to be a width x height square).
 /// If height is not set, it will default to be the same as width. Dilation
 /// makes bright features wider and more prominent, dark features thinner,
-/// and removes small isolated dark spots.
+/// and removes small isolated dark spots. The cost per pixel is a few
+/// comparisons no matter how large the window is, for `dilate()` and
+/// `erode()` alike.
 ImageBuf OIIO_API dilate (const ImageBuf &src, int width=3, int height=-1,
                           ROI roi={}, int nthreads=0);
 /// Write to an existing image `dst` (allocating if it is uninitialized).
@@ -2227,6 +2529,19 @@ enum MakeTextureMode {
 ///                                  output file doesn't already exist, or is
 ///                                  older than the input file, or was created
 ///                                  with different command-line arguments. (0)
+///    - `maketx:update_by_hash` (int) :
+///                           If nonzero, write new output only if the
+///                           output file doesn't already exist or doesn't
+///                           record (as "oiio:SourceHash") the same hash of
+///                           the input file contents and conversion
+///                           options. Unlike `updatemode`, this is not
+///                           fooled by copies that change file times. (0)
+///    - `maketx:cas_dir` (string) :
+///                           If not empty, a directory of textures named by
+///                           the hash of their source contents and options.
+///                           A texture found there is copied to the output
+///                           instead of being made again, and newly made
+///                           textures are added to it. ("")
 ///    - `maketx:constant_color_detect` (int) :
 ///                           If nonzero, detect images that are entirely
 ///                           one color, and change them to be low
@@ -2241,6 +2556,24 @@ enum MakeTextureMode {
 ///    - `maketx:compute_average` (int) :
 ///                           If nonzero, compute and store the average
 ///                           color of the texture (default: 1).
+///    - `maketx:tile_stats` (int) :
+///                           If nonzero, and the file format takes
+///                           arbitrary metadata, record per-tile stats of
+///                           the top MIP level: `oiio:ConstantTiles` lists
+///                           the tiles that are one color ("tileindex:v0,
+///                           v1,..." entries separated by spaces), which an
+///                           ImageCache fills in without reading, and
+///                           `oiio:TileAlpha` has one character per tile,
+///                           'o' if all opaque, 't' if all transparent, or
+///                           '-' (default: 0).
+///    - `maketx:autotune` (string) :
+///                           If not empty, choose the tile size and
+///                           compression method by trial-encoding a sample
+///                           of the image with candidate settings and
+///                           measuring encoded size and decode time, then
+///                           picking the best for the objective: "size",
+///                           "speed", or "balanced". The choice is recorded
+///                           in `oiio:Autotune` (default: "").
 ///    - `maketx:unpremult` (int) : If nonzero, unpremultiply color by alpha
 ///                           before color conversion, then multiply by
 ///                           alpha after color conversion (default: 0).
@@ -2313,10 +2646,28 @@ enum MakeTextureMode {
 ///                           locally if it is smaller than this
 ///                           threshold. Zero causes the system to make a
 ///                           good guess at a reasonable threshold (e.g. 1
-///                           GB). (0)
+///                           GB). A bigger untiled file is read through a
+///                           private ImageCache in 64x64 virtual tiles, so
+///                           it need not be entirely resident. (0)
+///    - `maketx:stream` (int) :
+///                           If nonzero, stream the MIP levels through
+///                           bounded memory a couple of tile rows at a
+///                           time, spooling levels bigger than the
+///                           `read_local_MB` threshold to temporary files,
+///                           instead of holding each whole level in memory.
+///                           Only applies to the "box" filter without
+///                           sharpening or other per-level processing. (0)
 ///    - `maketx:forcefloat` (int) :
 ///                           Forces a conversion through float data for
-///                           the sake of ImageBuf math. (1)
+///                           the sake of ImageBuf math. If zero, 8 and 16
+///                           bit integer MIP levels that are exact 2x box
+///                           reductions are computed directly in their own
+///                           data type, with rounding to nearest. (1)
+///    - `maketx:linear_average` (int) :
+///                           If nonzero, and MIP levels are computed in
+///                           uint8 (see `forcefloat`) for an sRGB texture,
+///                           average the color channels in linear space
+///                           rather than in their sRGB encoding. (0)
 ///    - `maketx:hash` (int) :
 ///                           Compute the sha1 hash of the file in parallel. (1)
 ///    - `maketx:allow_pixel_shift` (int) :
@@ -2414,6 +2765,41 @@ bool OIIO_API make_texture (MakeTextureMode mode,
                             string_view outputfilename,
                             const ImageSpec &config,
                             std::ostream *outstream = nullptr);
+
+/// Convert many image files into textures in one call, as if calling
+/// `make_texture()` for each of them, but running several conversions
+/// concurrently under a shared scheduler.
+///
+/// `outputfilenames` must either be empty (meaning each output is named
+/// like its input but with a `.tx` extension) or have one entry per input.
+/// All conversions use the same `mode` and `config`, and their pixel work
+/// shares the global thread pool (see the "threads" attribute). These
+/// additional `config` attributes control the scheduler:
+///
+///    - `maketx:jobs` (int) :  The maximum number of conversions to run at
+///                           once (default: 0, meaning a quarter of the
+///                           thread count, between 1 and 8).
+///    - `maketx:memory_MB` (int) :
+///                           A budget for the estimated memory of the
+///                           conversions running at once; a new one will
+///                           not start until enough of the budget is free.
+///                           A conversion that is bigger than the whole
+///                           budget runs by itself. (default: 0, meaning
+///                           half of physical memory)
+///
+/// The output of each conversion is written to `outstream` (if not
+/// `nullptr`) in one piece after that conversion finishes. If `errors` is
+/// not `nullptr`, it is resized to the number of inputs, and holds the
+/// error message of each failed conversion (or an empty string for each
+/// one that succeeded).
+///
+/// @returns `true` if all conversions succeeded.
+bool OIIO_API make_texture_batch (MakeTextureMode mode,
+                                  cspan<std::string> filenames,
+                                  cspan<std::string> outputfilenames,
+                                  const ImageSpec &config,
+                                  std::ostream *outstream = nullptr,
+                                  std::vector<std::string> *errors = nullptr);
 /// @}
 
 
@@ -2436,6 +2822,28 @@ from_OpenCV (const cv::Mat& mat, TypeDesc convert = TypeUnknown,
 OIIO_API bool to_OpenCV (cv::Mat& dst, const ImageBuf& src,
                          ROI roi={}, int nthreads=0);
 
+/// Return an ImageBuf that wraps the pixels of `mat` in place, without
+/// copying them (an `APPBUFFER` ImageBuf whose strides are those of the
+/// Mat), so changes made through either are seen by the other. The Mat's
+/// data must outlive the ImageBuf. Rather than reordering OpenCV's BGR or
+/// BGRA pixels, the channels are named "B", "G", "R" (and "A", which is
+/// the alpha channel) in the spec; `channels()` or a channel-name-aware
+/// consumer can take it from there. Mats of other channel counts get the
+/// default channel names. On failure (including when OpenImageIO was
+/// compiled without OpenCV support), the returned ImageBuf has an error.
+OIIO_API ImageBuf from_OpenCV_wrap (cv::Mat& mat);
+
+/// Make `dst` a cv::Mat header over the pixels of `src`, which must be
+/// held in local memory (not backed by an ImageCache) in a data type that
+/// OpenCV has, with its channels interleaved, and return true. No pixels
+/// are copied or reordered: the Mat's channels are in the order of
+/// `src.spec().channelnames` (RGB order for most images, which OpenCV
+/// functions that care must be told of), and `src` must outlive `dst`. If
+/// it is not possible, or if OpenImageIO was compiled without OpenCV
+/// support, return false; the error message can be retrieved by calling
+/// OIIO::geterror().
+OIIO_API bool to_OpenCV_wrap (cv::Mat& dst, ImageBuf& src);
+
 
 /// Capture a still image from a designated camera.  If able to do so,
 /// store the image in dst and return true.  If there is no such device,
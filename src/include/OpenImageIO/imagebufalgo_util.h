@@ -6,6 +6,8 @@
 #pragma once
 
 #include <functional>
+#include <limits>
+#include <type_traits>
 
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/parallel.h>
@@ -90,6 +92,358 @@ parallel_image(ROI roi, std::function<void(ROI)> f)
 
 
 
+/// Version of parallel_image that knows which source images `A` and `B`
+/// (either may be null) the work will read. If one of them is backed by
+/// an ImageCache whose tiles are smaller than `roi`, the region is split
+/// on that tile grid, a whole number of tiles per task, and the tasks are
+/// queued a row of tiles at a time. That way no two threads ask the cache
+/// for the same tile at once, as they do when bands of scanlines cut
+/// across tiles. Otherwise this is the same as `parallel_image(roi, opt,
+/// f)`.
+inline void
+parallel_image(ROI roi, paropt opt, const ImageBuf* A, const ImageBuf* B,
+               std::function<void(ROI)> f)
+{
+    const ImageSpec* tiled = nullptr;
+    for (const ImageBuf* img : { A, B }) {
+        if (!tiled && img && img->storage() == ImageBuf::IMAGECACHE
+            && img->spec().tile_width > 0 && img->spec().tile_height > 0
+            && (img->spec().tile_width < roi.width()
+                || img->spec().tile_height < roi.height()))
+            tiled = &img->spec();
+    }
+    if (!tiled) {
+        parallel_image(roi, opt, f);
+        return;
+    }
+    opt.resolve();
+    opt.maxthreads(
+        std::min(opt.maxthreads(), 1 + int(roi.npixels() / opt.minitems())));
+    if (opt.singlethread()) {
+        f(roi);
+        return;
+    }
+
+    // Group tiles along their rows until a task has enough pixels to be
+    // worth a thread, then start the grid on a tile boundary.
+    int64_t xchunk = tiled->tile_width, ychunk = tiled->tile_height;
+    while (xchunk * ychunk < int64_t(opt.minitems()) && xchunk < roi.width())
+        xchunk += tiled->tile_width;
+    int64_t xoff = (roi.xbegin - tiled->x) % xchunk;
+    int64_t yoff = (roi.ybegin - tiled->y) % ychunk;
+    int64_t x0   = roi.xbegin - (xoff < 0 ? xoff + xchunk : xoff);
+    int64_t y0   = roi.ybegin - (yoff < 0 ? yoff + ychunk : yoff);
+
+    auto task = [&](int64_t xbegin, int64_t xend, int64_t ybegin,
+                    int64_t yend) {
+        f(ROI(std::max(xbegin, int64_t(roi.xbegin)), xend,
+              std::max(ybegin, int64_t(roi.ybegin)), yend, roi.zbegin,
+              roi.zend, roi.chbegin, roi.chend));
+    };
+    parallel_for_chunked_2D(x0, roi.xend, xchunk, y0, roi.yend, ychunk, task,
+                            opt);
+}
+
+
+/// Version of parallel_image that knows the single source image `A` the
+/// work will read, splitting on its ImageCache tiles if it has any.
+inline void
+parallel_image(ROI roi, paropt opt, const ImageBuf* A,
+               std::function<void(ROI)> f)
+{
+    parallel_image(roi, opt, A, nullptr, f);
+}
+
+
+
+/// Can `roi` of every one of the given images (null pointers are ignored)
+/// be processed one scanline at a time, as flat runs of values from
+/// `ImageBuf::scanline_span()`? That requires each image to hold its pixels
+/// locally and packed contiguously, to contain `roi`, and to have exactly
+/// the channels `[roi.chbegin, roi.chend)`, so that the value at index `i`
+/// of every image's span is the same pixel and channel.
+inline bool
+scanline_spans_ok(ROI roi, const ImageBuf& R, const ImageBuf* A = nullptr,
+                  const ImageBuf* B = nullptr, const ImageBuf* C = nullptr)
+{
+    for (const ImageBuf* img : { &R, A, B, C }) {
+        if (img
+            && (!img->localpixels() || !img->contains_roi(roi)
+                || roi.chbegin != 0 || roi.chend != img->nchannels()
+                || img->pixel_stride()
+                       != stride_t(img->nchannels()
+                                   * img->spec().format.size())))
+            return false;
+    }
+    return true;
+}
+
+
+/// Is arithmetic on the raw values of a `scanline_span<T>()` the same as
+/// arithmetic through an `ImageBuf::Iterator<T>`? Only for the types whose
+/// values the iterators don't normalize: float and half.
+template<typename T>
+constexpr bool
+span_arithmetic_ok()
+{
+    return std::is_same<T, float>::value || std::is_same<T, half>::value;
+}
+
+
+/// Load `n` values of a scanline span as floats. Half values are converted
+/// in batches, with F16C instructions where the build allows.
+template<typename T>
+inline void
+span_load(const T* values, float* f, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        f[i] = float(values[i]);
+}
+
+inline void
+span_load(const half* values, float* f, size_t n)
+{
+    convert_type<half, float>(values, f, n);
+}
+
+
+/// Store `n` floats into a scanline span, the inverse of `span_load()`.
+template<typename T>
+inline void
+span_store(const float* f, T* values, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        values[i] = T(f[i]);
+}
+
+inline void
+span_store(const float* f, half* values, size_t n)
+{
+    convert_type<float, half>(f, values, n);
+}
+
+
+/// How many values of a scanline span `binary_value_op()` converts at a
+/// time when any of the images is half.
+const size_t span_batch_size = 256;
+
+
+/// Helper for simple per-value IBA functions: set `R[i] = op(A[i], B[i])`
+/// (with `op` taking and returning float) for every channel value of
+/// `roi`, split over `nthreads` threads. When all three images are float
+/// or half and `scanline_spans_ok()`, this loops directly over scanline
+/// spans, which the compiler can vectorize (converting any half values to
+/// and from float in batches); otherwise it uses iterators.
+template<class Rtype, class Atype, class Btype, class OP>
+void
+binary_value_op(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
+                int nthreads, OP op)
+{
+    parallel_image(roi, nthreads, &A, &B, [&](ROI roi) {
+        if (span_arithmetic_ok<Rtype>() && span_arithmetic_ok<Atype>()
+            && span_arithmetic_ok<Btype>()
+            && scanline_spans_ok(roi, R, &A, &B)) {
+            for (int z = roi.zbegin; z < roi.zend; ++z)
+                for (int y = roi.ybegin; y < roi.yend; ++y) {
+                    span<Rtype> r = R.scanline_span<Rtype>(roi.xbegin,
+                                                           roi.xend, y, z);
+                    cspan<Atype> a = A.scanline_span<Atype>(roi.xbegin,
+                                                            roi.xend, y, z);
+                    cspan<Btype> b = B.scanline_span<Btype>(roi.xbegin,
+                                                            roi.xend, y, z);
+                    OIIO_DASSERT(r.size() && a.size() == r.size()
+                                 && b.size() == r.size());
+                    if (std::is_same<Rtype, float>::value
+                        && std::is_same<Atype, float>::value
+                        && std::is_same<Btype, float>::value) {
+                        for (size_t i = 0, n = r.size(); i < n; ++i)
+                            r[i] = Rtype(op(float(a[i]), float(b[i])));
+                        continue;
+                    }
+                    float fa[span_batch_size], fb[span_batch_size];
+                    for (size_t i = 0, n = r.size(); i < n;
+                         i += span_batch_size) {
+                        size_t m = std::min(span_batch_size, n - i);
+                        span_load(a.data() + i, fa, m);
+                        span_load(b.data() + i, fb, m);
+                        for (size_t j = 0; j < m; ++j)
+                            fa[j] = op(fa[j], fb[j]);
+                        span_store(fa, r.data() + i, m);
+                    }
+                }
+        } else {
+            ImageBuf::Iterator<Rtype> r(R, roi);
+            ImageBuf::ConstIterator<Atype> a(A, roi);
+            ImageBuf::ConstIterator<Btype> b(B, roi);
+            for (; !r.done(); ++r, ++a, ++b)
+                for (int c = roi.chbegin; c < roi.chend; ++c)
+                    r[c] = op(float(a[c]), float(b[c]));
+        }
+    });
+}
+
+
+/// Like `binary_value_op()`, but with a per-channel constant for the
+/// second operand: `R[i] = op(A[i], b[channel of i])`.
+template<class Rtype, class Atype, class OP>
+void
+binary_value_op(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi,
+                int nthreads, OP op)
+{
+    parallel_image(roi, nthreads, &A, [&](ROI roi) {
+        if (span_arithmetic_ok<Rtype>() && span_arithmetic_ok<Atype>()
+            && scanline_spans_ok(roi, R, &A)) {
+            const int nc = roi.nchannels();
+            for (int z = roi.zbegin; z < roi.zend; ++z)
+                for (int y = roi.ybegin; y < roi.yend; ++y) {
+                    span<Rtype> r = R.scanline_span<Rtype>(roi.xbegin,
+                                                           roi.xend, y, z);
+                    cspan<Atype> a = A.scanline_span<Atype>(roi.xbegin,
+                                                            roi.xend, y, z);
+                    OIIO_DASSERT(r.size() && a.size() == r.size());
+                    if ((std::is_same<Rtype, float>::value
+                         && std::is_same<Atype, float>::value)
+                        || nc > int(span_batch_size)) {
+                        for (size_t p = 0, n = r.size(); p < n; p += nc)
+                            for (int c = 0; c < nc; ++c)
+                                r[p + c] = Rtype(op(float(a[p + c]), b[c]));
+                        continue;
+                    }
+                    // Batches of whole pixels, so value j is channel j % nc
+                    float fa[span_batch_size];
+                    size_t batch = (span_batch_size / nc) * nc;
+                    for (size_t i = 0, n = r.size(); i < n; i += batch) {
+                        size_t m = std::min(batch, n - i);
+                        span_load(a.data() + i, fa, m);
+                        for (size_t j = 0; j < m; j += nc)
+                            for (int c = 0; c < nc; ++c)
+                                fa[j + c] = op(fa[j + c], b[c]);
+                        span_store(fa, r.data() + i, m);
+                    }
+                }
+        } else {
+            ImageBuf::Iterator<Rtype> r(R, roi);
+            ImageBuf::ConstIterator<Atype> a(A, roi);
+            for (; !r.done(); ++r, ++a)
+                for (int c = roi.chbegin; c < roi.chend; ++c)
+                    r[c] = op(float(a[c]), b[c]);
+        }
+    });
+}
+
+
+/// Saturating fixed-point arithmetic on the code values of uint8 and uint16
+/// pixels, where the maximum code value stands for 1.0. Each rounds just
+/// as converting the exact real result back from float would (that is,
+/// half up), so results match the float path, or beat it for uint16
+/// products, where float rounding can be off by one code value.
+template<typename T>
+inline T
+unorm_add(T a, T b)
+{
+    const uint32_t one = std::numeric_limits<T>::max();
+    return T(std::min(uint32_t(a) + uint32_t(b), one));
+}
+
+template<typename T>
+inline T
+unorm_mul(T a, T b)
+{
+    const uint32_t one = std::numeric_limits<T>::max();
+    return T((uint32_t(a) * uint32_t(b) + one / 2) / one);
+}
+
+/// a + (1 - alpha) * b, the "over" of a color value with alpha `alpha`.
+template<typename T>
+inline T
+unorm_over(T a, T alpha, T b)
+{
+    const uint32_t one = std::numeric_limits<T>::max();
+    uint32_t under     = ((one - alpha) * uint32_t(b) + one / 2) / one;
+    return T(std::min(uint32_t(a) + under, one));
+}
+
+
+/// Set `R[i] = op(A[i], B[i])` for every channel value of `roi`, with `op`
+/// taking and returning raw values of type `T`, looping directly over
+/// scanline spans split over `nthreads` threads. Return `false`, doing
+/// nothing, unless all three images hold `T` pixels and
+/// `scanline_spans_ok()`, so the caller can fall back to a general path.
+template<typename T, class OP>
+bool
+native_value_op(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
+                int nthreads, OP op)
+{
+    const TypeDesc type = BaseTypeFromC<T>::value;
+    if (R.spec().format != type || A.spec().format != type
+        || B.spec().format != type || !scanline_spans_ok(roi, R, &A, &B))
+        return false;
+    parallel_image(roi, nthreads, [&](ROI roi) {
+        for (int z = roi.zbegin; z < roi.zend; ++z)
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                span<T> r  = R.scanline_span<T>(roi.xbegin, roi.xend, y, z);
+                cspan<T> a = A.scanline_span<T>(roi.xbegin, roi.xend, y, z);
+                cspan<T> b = B.scanline_span<T>(roi.xbegin, roi.xend, y, z);
+                for (size_t i = 0, n = r.size(); i < n; ++i)
+                    r[i] = op(a[i], b[i]);
+            }
+    });
+    return true;
+}
+
+
+/// Set `R[i] = op(A[i])`, like the binary `native_value_op()`.
+template<typename T, class OP>
+bool
+native_value_op(ImageBuf& R, const ImageBuf& A, ROI roi, int nthreads, OP op)
+{
+    const TypeDesc type = BaseTypeFromC<T>::value;
+    if (R.spec().format != type || A.spec().format != type
+        || !scanline_spans_ok(roi, R, &A))
+        return false;
+    parallel_image(roi, nthreads, [&](ROI roi) {
+        for (int z = roi.zbegin; z < roi.zend; ++z)
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                span<T> r  = R.scanline_span<T>(roi.xbegin, roi.xend, y, z);
+                cspan<T> a = A.scanline_span<T>(roi.xbegin, roi.xend, y, z);
+                for (size_t i = 0, n = r.size(); i < n; ++i)
+                    r[i] = op(a[i]);
+            }
+    });
+    return true;
+}
+
+
+/// Call `f(span<T> values, int y, int z)` for every scanline of `roi` of
+/// `R`, in parallel, where `values` holds all the channel values of pixels
+/// `[roi.xbegin, roi.xend)` of that scanline, contiguous in memory. Simple
+/// per-value loops over the span vectorize well, with none of the per-pixel
+/// bounds, tile, and wrap checks of `ImageBuf::Iterator`.
+///
+/// Return `false` without calling `f` at all if `R`'s pixels are not of
+/// type `T` or cannot be handed out as spans (see `scanline_spans_ok()`),
+/// so that the caller may fall back to iterators.
+template<typename T, typename FUNC>
+bool
+for_each_scanline(ImageBuf& R, ROI roi, FUNC f, paropt opt = paropt(0))
+{
+    if (!roi.defined())
+        roi = R.roi();
+    roi.chend = std::min(roi.chend, R.nchannels());
+    if (R.spec().format != BaseTypeFromC<T>::value
+        || !scanline_spans_ok(roi, R))
+        return false;
+    R.localpixels();  // make any copy-on-write pixels private up front
+    parallel_image(roi, opt, [&](ROI roi) {
+        for (int z = roi.zbegin; z < roi.zend; ++z)
+            for (int y = roi.ybegin; y < roi.yend; ++y)
+                f(R.scanline_span<T>(roi.xbegin, roi.xend, y, z), y, z);
+    });
+    return true;
+}
+
+
+
 /// Common preparation for IBA functions: Given an ROI (which may or may not
 /// be the default ROI::All()), destination image (which may or may not yet
 /// be allocated), and optional input images, adjust roi if necessary and
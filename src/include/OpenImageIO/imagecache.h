@@ -24,6 +24,9 @@
 // Does invalidate() support the optional `force` flag?
 #define OIIO_IMAGECACHE_INVALIDATE_FORCE 1
 
+// Is the asynchronous prefetch() method present? (Added in 2.6)
+#define OIIO_IMAGECACHE_SUPPORTS_PREFETCH 1
+
 
 
 OIIO_NAMESPACE_BEGIN
@@ -104,10 +107,79 @@ public:
     ///           The approximate maximum number of file handles that the
     ///           image cache will hold open simultaneously. This is not an
     ///           iron-clad guarantee; the number of handles may momentarily
-    ///           exceed this by a small percentage. (Default = 100)
+    ///           exceed this by a small percentage. For files whose
+    ///           readers accept an IOProxy, reclaiming a handle closes only
+    ///           the file descriptor and keeps the ImageInput (with all of
+    ///           its parsed header state), so reading the file again later
+    ///           just reopens the descriptor. (Default = 100)
     /// - `float max_memory_MB` :
     ///           The approximate maximum amount of memory (measured in MB)
     ///           used for the internal "tile cache." (Default: 1024.0 MB)
+    /// - `float max_compressed_memory_MB` :
+    ///           If nonzero, tiles evicted from the tile cache to stay
+    ///           within `max_memory_MB` are not simply dropped, but
+    ///           compressed and kept in up to this much additional memory
+    ///           (measured in MB), so that a later need for them can be
+    ///           met by uncompressing rather than re-reading the file. This
+    ///           pays off best for float or half images with large flat or
+    ///           smooth regions. (Default: 0, meaning evicted tiles are
+    ///           dropped)
+    /// - `int read_ahead_tiles` :
+    ///           If greater than 1, a tile miss in a tiled file also reads
+    ///           the tiles to its right in the same tile row that are not
+    ///           yet in the cache, up to this many tiles in all, with a
+    ///           single read (which lets the format reader decode them in
+    ///           parallel), and adds them to the cache. This trades some
+    ///           speculative reading for fewer read calls, and pays off on
+    ///           cold caches with spatially coherent access. (Default: 0)
+    /// - `int microcache_size` :
+    ///           Number of recently used tiles each thread keeps in its
+    ///           private, 4-way set-associative tile "microcache" (besides
+    ///           the very last tile), so that lookups cycling among a few
+    ///           tiles don't go to the shared cache and its locks. Rounded
+    ///           up to a power of two number of sets; 0 keeps only the last
+    ///           tile. (Default: 16)
+    /// - `int trace_tiles` :
+    ///           If nonzero, each thread keeps a ring buffer of this many of
+    ///           its most recent tile accesses, which `write_tile_trace()`
+    ///           saves for offline analysis of the working set (hot tiles,
+    ///           unused MIP levels, and so on). Setting it also restarts
+    ///           the trace clock. (Default: 0, no tracing)
+    /// - `int numa_local_tiles` :
+    ///           If nonzero, the pixels of each tile read into the cache
+    ///           are given whole memory pages of their own and (on Linux)
+    ///           placed on the NUMA memory node of the thread that read
+    ///           them, and cache hits are counted as local or remote to the
+    ///           node of the thread looking up the tile (see
+    ///           `stat:numa_local_hits`). (Default: 0)
+    /// - `int share_constant_tiles` :
+    ///           If nonzero, each tile read into the cache is checked for
+    ///           having every pixel the same, and if so its pixels are
+    ///           released and it uses a single block shared by all such
+    ///           tiles of that size and value, whose memory is counted
+    ///           against `max_memory_MB` only once. This stretches the
+    ///           cache for masks, ID maps, and padded textures with large
+    ///           flat areas, at the cost of one comparison pass per tile
+    ///           read. Batched `texture3d()` lookups also read such tiles
+    ///           (like the empty space of a sparse OpenVDB volume) with a
+    ///           single fetch per tile rather than one per texel.
+    ///           (Default: 0)
+    /// - `int mmap_tiles` :
+    ///           If nonzero, tiles that are stored uncompressed in the file
+    ///           in exactly the layout the cache would hold them (currently
+    ///           uncompressed tiled TIFF, and single-channel uncompressed
+    ///           tiled OpenEXR, in the native data type with no color or
+    ///           alpha conversion) are not read, but used in place from a
+    ///           read-only memory mapping of the file, and do not count
+    ///           against `max_memory_MB`. Files must not be modified or
+    ///           truncated while they are mapped. (Default: 0)
+    /// - `int io_uring` :
+    ///           If nonzero (and on Linux, with a kernel that permits it),
+    ///           files whose readers accept an IOProxy do their reads
+    ///           through one io_uring ring shared by the whole cache, so
+    ///           that tile reads from many threads become in-flight
+    ///           requests on the ring rather than a blocking `pread`
+    ///           each. Elsewhere, this has no effect. (Default: 0)
     /// - `string searchpath` :
     ///           The search path for images: a colon-separated list of
     ///           directories that will be searched in order for any image
@@ -118,6 +190,31 @@ public:
     ///           directories that will be searched in order for any OIIO
     ///           plugins, if not found in OIIO's `lib` directory.
     ///           (Default: "")
+    /// - `string diskcache:path` :
+    ///           A directory (presumably on fast local storage) in which to
+    ///           keep a persistent second-level cache of decoded tiles.
+    ///           Tiles not found in memory are sought there before being
+    ///           read from their file, and tiles read from files are saved
+    ///           there, so later processes on the same machine can skip
+    ///           the original I/O and decompression. Tiles are identified
+    ///           by the file's fingerprint (if it has one) or its name and
+    ///           modification time. Several processes may share the
+    ///           directory. (Default: "", meaning no disk cache)
+    /// - `float diskcache:size` :
+    ///           The approximate maximum size (in MB) of the disk tile
+    ///           cache; the least recently used tiles are removed to stay
+    ///           within it. (Default: 4096.0 MB)
+    /// - `string headerindex:path` :
+    ///           A directory in which to keep a persistent index of the
+    ///           headers (the specs of every subimage and MIP level) of
+    ///           the files the cache opens. A file found in the index,
+    ///           with the same size and modification time as when it was
+    ///           recorded, is set up without being opened, so that
+    ///           `get_imagespec()`, `get_image_info()`, and texture setup
+    ///           don't wait on the file until its pixels are needed. Files
+    ///           read with a custom ImageInput creator or configuration
+    ///           hints are never indexed. Several processes may share the
+    ///           directory. (Default: "", meaning no header index)
     /// - `int autotile` ,
     ///   `int autoscanline` :
     ///           These attributes control how the image cache deals with
@@ -145,6 +242,9 @@ public:
     ///           default) or if they will be as wide as the image (but only
     ///           `autotile` scanlines high).  You should try in your
     ///           application to see which leads to higher performance.
+    ///           Either way, each row of virtual tiles is decoded once into
+    ///           a single block of memory that its tiles share, and with
+    ///           `autoscanline` the scanlines are decoded in place.
     /// - `int autoscanline` :
     ///           autotile using full width tiles
     /// - `int automip` :
@@ -195,6 +295,13 @@ public:
     ///           reads.  The default is 1 (de-duplication turned on). The
     ///           only reason to set it to 0 is if you specifically want to
     ///           disable the de-duplication optimization.
+    /// - `int fingerprint_files` :
+    ///           When nonzero, files that lack a SHA-1 fingerprint in their
+    ///           headers are fingerprinted by hashing their entire contents
+    ///           (in parallel) when they are opened, so that byte-identical
+    ///           copies under different names are also de-duplicated. This
+    ///           costs a full read of each such file at open time, so it is
+    ///           only worthwhile when duplicates are expected. (Default: 0)
     /// - `int max_open_files_strict` :
     ///             If nonzero, work harder to make sure that we have
     ///             smaller possible overages to the max open files limit.
@@ -274,6 +381,13 @@ public:
     ///           opened (at the time of the query), and the peak number of
     ///           files opened at any time.
     ///
+    /// - `int64 stat:fds_detached` ,
+    ///   `int64 stat:fds_reattached` :
+    ///           Number of times the file descriptor of an idle file was
+    ///           closed to stay within `max_open_files` while keeping its
+    ///           ImageInput open, and the number of times such a file was
+    ///           read again and needed its descriptor reopened.
+    ///
     /// - `int stat:find_tile_calls` :
     ///           Number of times a filename was looked up in the file cache.
     ///
@@ -315,6 +429,95 @@ public:
     ///           Total time (across all threads) that threads spent looking
     ///           up individual tiles.
     ///
+    /// - `int stat:prefetch_tiles` :
+    ///           Number of tile reads queued by `prefetch()`.
+    ///
+    /// - `int stat:prefetch_reads` :
+    ///           Number of queued prefetch reads that were actually
+    ///           carried out by the thread pool (the rest were picked up
+    ///           by lookups that needed the tile before the pool got to it).
+    ///
+    /// - `int64 stat:compressed_memory_used` :
+    ///           Memory currently holding compressed cold tiles (not
+    ///           counted in `stat:cache_memory_used`).
+    ///
+    /// - `int64 stat:colorconvert_memory_used` :
+    ///           The part of `stat:cache_memory_used` currently holding
+    ///           tiles that were color converted (for lookups with a
+    ///           `colortransformid`) as they were read.
+    ///
+    /// - `int64 stat:numa_local_hits`, `int64 stat:numa_remote_hits` :
+    ///           With `numa_local_tiles` on, the number of tile cache hits
+    ///           on tiles whose memory is on the same NUMA node as the
+    ///           looking-up thread, and on a different node.
+    ///
+    /// - `int64 stat:find_tile_microcache_hits` :
+    ///           Number of tile lookups satisfied by a per-thread microcache
+    ///           entry other than the last tile used (see `microcache_size`).
+    ///
+    /// - `int64 stat:tiles_read_ahead` :
+    ///           Number of tiles added to the cache by `read_ahead_tiles`
+    ///           along with the tile that missed.
+    ///
+    /// - `int64 stat:tiles_from_slab` :
+    ///           Number of tiles of autotiled scanline images that were
+    ///           needed again after being evicted, and were recovered from
+    ///           the still-live decoded block of their tile row (which its
+    ///           other tiles share) rather than by decoding it again.
+    ///
+    /// - `int64 stat:tiles_mmapped` :
+    ///           Number of tiles used in place from memory-mapped files
+    ///           (see `mmap_tiles`) rather than read into cache memory.
+    ///
+    /// - `int64 stat:tiles_constant_shared` :
+    ///           Number of tiles found to be constant and made to share
+    ///           their pixels (see `share_constant_tiles`).
+    ///
+    /// - `int64 stat:tiles_constant_synthesized` :
+    ///           Number of tiles that a texture made by maketx recorded as
+    ///           constant (`oiio:ConstantTiles`), and that were therefore
+    ///           filled in without reading the file.
+    ///
+    /// - `int64 stat:tiles_compressed`, `int64 stat:tiles_uncompressed` :
+    ///           Number of evicted tiles that were compressed and kept, and
+    ///           number of those that were later uncompressed for use.
+    ///
+    /// - `int64 stat:tiles_colorconverted` :
+    ///           Number of tiles color converted as they were read. Each
+    ///           tile is converted once per color transform and the
+    ///           converted copy is cached.
+    ///
+    /// - `int64 stat:diskcache_hits`, `int64 stat:diskcache_misses` :
+    ///           Number of tiles found, or not found, in the disk tile
+    ///           cache.
+    ///
+    /// - `int64 stat:diskcache_writes`, `int64 stat:diskcache_evictions` :
+    ///           Number of tiles written to, or trimmed from, the disk tile
+    ///           cache.
+    ///
+    /// - `int64 stat:diskcache_bytes_read`, `int64 stat:diskcache_bytes_used` :
+    ///           Bytes read from the disk tile cache, and the current size
+    ///           of the disk tile cache.
+    ///
+    /// - `int64 stat:headerindex_hits`, `int64 stat:headerindex_misses`,
+    ///   `int64 stat:headerindex_writes` :
+    ///           Number of files set up from the header index, not found
+    ///           (or out of date) there, and recorded there.
+    ///
+    /// - `int64 stat:tiles_evicted` :
+    ///           Number of tiles evicted from the cache to stay within
+    ///           `max_memory_MB`.
+    ///
+    /// - `float stat:eviction_time` :
+    ///           Total time (across all threads) spent evicting tiles.
+    ///
+    /// - `float[] stat:shard_eviction_time` :
+    ///           Time spent evicting tiles from each shard of the tile
+    ///           cache (the tile cache is divided into independently locked
+    ///           shards, each held to its own share of the memory limit,
+    ///           and the array length must match the number of shards,
+    ///           which may be queried with `getattributetype()`).
+    ///
     /// The following member functions of ImageCache allow you to set (and
     /// in some cases retrieve) options that control the overall behavior of
     /// the image cache:
@@ -476,6 +679,44 @@ public:
     /// Destroy a Perthread that was allocated by `create_thread_info()`.
     virtual void destroy_thread_info(Perthread* thread_info) = 0;
 
+    /// Make `thread_info` the Perthread that the calling thread uses for
+    /// every call that is not passed one explicitly (including all the
+    /// calls that take no `Perthread*` at all, and `get_perthread_info()`).
+    /// Passing `nullptr` undoes the binding, after which the thread goes
+    /// back to the Perthread managed by the ImageCache that it used before
+    /// (or gets one, if it had none). A bound Perthread must be unbound
+    /// before it is destroyed or used by another thread.
+    virtual void bind_thread_info(Perthread* thread_info) = 0;
+
+    /// A ThreadContext is a Perthread that is created for, and bound to,
+    /// the thread that constructs it, for as long as it lives. An app's
+    /// worker threads can each make one when they start, rather than
+    /// passing `Perthread*` everywhere or paying for the implicit per-call
+    /// lookup. It must be destroyed on the same thread.
+    class ThreadContext {
+    public:
+        explicit ThreadContext(ImageCache& imagecache)
+            : m_imagecache(imagecache)
+            , m_thread_info(imagecache.create_thread_info())
+        {
+            m_imagecache.bind_thread_info(m_thread_info);
+        }
+        ~ThreadContext()
+        {
+            m_imagecache.bind_thread_info(nullptr);
+            m_imagecache.destroy_thread_info(m_thread_info);
+        }
+        ThreadContext(const ThreadContext&) = delete;
+        ThreadContext& operator=(const ThreadContext&) = delete;
+
+        /// The bound Perthread, for the calls that take one.
+        Perthread* thread_info() const { return m_thread_info; }
+
+    private:
+        ImageCache& m_imagecache;
+        Perthread* m_thread_info;
+    };
+
     /// Define an opaque data type that allows us to have a handle to an
     /// image (already having its name resolved) but without exposing any
     /// internals.
@@ -508,6 +749,44 @@ public:
     /// This method was added in OpenImageIO 2.3.
     virtual ustring filename_from_handle(ImageHandle* handle) = 0;
 
+    /// Set a named attribute that controls how the cache treats the tiles
+    /// of one particular file, given its handle. The recognized per-file
+    /// attributes are:
+    ///
+    /// - `int evict_priority` :
+    ///           A hint about how hard the cache should try to keep this
+    ///           file's tiles when it needs to free memory. 0 (the default)
+    ///           treats them like any other. A positive value N lets each
+    ///           tile survive N more passes of the eviction sweep than it
+    ///           otherwise would after it was last used, so that "hero"
+    ///           assets tend to stay resident. A negative value means the
+    ///           tiles are evicted at the first opportunity, even if they
+    ///           were used recently, which suits images that are read once.
+    /// - `float max_memory_MB` :
+    ///           The approximate maximum amount of tile memory that this
+    ///           file may use (0, the default, means no limit other than
+    ///           the cache-wide `max_memory_MB`). When a file exceeds its
+    ///           quota, its own least recently used tiles are evicted.
+    ///
+    /// @param  file    The handle of the file.
+    /// @param  name    Name of the attribute to set.
+    /// @param  type    TypeDesc describing the type of the attribute.
+    /// @param  val     Pointer to the value data.
+    /// @returns        `true` if the name and type were recognized and the
+    ///                 attribute was set, or `false` upon failure.
+    ///
+    /// This method was added in OpenImageIO 2.6.
+    virtual bool attribute(ImageHandle* file, string_view name,
+                           TypeDesc type, const void* val) = 0;
+
+    /// Retrieve a per-file attribute previously set with
+    /// `attribute(ImageHandle*, ...)`, storing it in `*val`. Return `true`
+    /// if the name and type were recognized, `false` otherwise.
+    ///
+    /// This method was added in OpenImageIO 2.6.
+    virtual bool getattribute(ImageHandle* file, string_view name,
+                              TypeDesc type, void* val) const = 0;
+
     /// @}
 
 
@@ -654,6 +933,12 @@ public:
     /// - `"stat:is_duplicate"` : Stores 1 if this file was a duplicate of
     ///   another image, otherwise 0. (`int`)
     ///
+    /// - `"stat:texture_queries"`, `"stat:texture_probes"` (`int64`),
+    ///   `"stat:texture_time"` (`float`), `"stat:texture_mip_hits"`
+    ///   (`int64` array) : Texture lookup counts for this file, kept only
+    ///   by a TextureSystem whose "statistics:level" is 3 or more (see
+    ///   `TextureSystem::get_texture_info()`).
+    ///
     /// - *Anything else*  : For all other data names, the the metadata of
     ///   the image file will be searched for an item that matches both the
     ///   name and data type.
@@ -879,7 +1164,10 @@ public:
     /// cache has been updated on disk.  This is safe to do even if other
     /// procedures are currently holding reference-counted tile pointers from
     /// the named image, but those procedures will not get updated pixels
-    /// until they release the tiles they are holding.
+    /// until they release the tiles they are holding. It does not stall
+    /// other threads using the cache: the file's old tiles simply stop
+    /// matching lookups, and their memory is reclaimed lazily as the cache
+    /// needs it.
     ///
     /// If `force` is true, this invalidation will happen unconditionally; if
     /// false, the file will only be invalidated if it has been changed since
@@ -937,6 +1225,28 @@ public:
                              int x, int y, int z,
                              int chbegin = 0, int chend = -1) = 0;
 
+    /// Batched `get_tile()`: retrieve every tile of the given subimage and
+    /// MIP level that overlaps `roi` (whose channel range, if the ROI is
+    /// defined, also selects the channels of the tiles; an undefined ROI
+    /// means the whole image and all channels). This is cheaper than
+    /// calling `get_tile()` for each: each part of the cache is locked only
+    /// once for the whole batch, and tiles that must be read from disk are
+    /// read concurrently.
+    ///
+    /// The tiles are stored in `tiles` in order of z, then y, then x. If
+    /// `tiles` is not big enough to hold them all, nothing is retrieved.
+    /// Each tile retrieved must eventually be passed to `release_tile()`.
+    ///
+    /// @returns   The number of tiles overlapping the ROI (which were
+    ///            retrieved if there was room for them), or -1 if the file,
+    ///            subimage, or MIP level does not exist, or if any of the
+    ///            tiles could not be read.
+    ///
+    /// This method was added in OpenImageIO 2.6.
+    virtual int get_tiles(ImageHandle* file, Perthread* thread_info,
+                          int subimage, int miplevel, ROI roi,
+                          span<Tile*> tiles) = 0;
+
     /// After finishing with a tile, release_tile will allow it to
     /// once again be purged from the tile cache if required.
     virtual void release_tile(Tile* tile) const = 0;
@@ -1007,6 +1317,45 @@ public:
                      stride_t xstride=AutoStride, stride_t ystride=AutoStride,
                      stride_t zstride=AutoStride, bool copy = true) = 0;
 
+    /// Asynchronously request that all tiles of the given subimage and MIP
+    /// level that overlap `roi` be read into the cache. The call returns
+    /// immediately; the reads are carried out by tasks running on the
+    /// default thread pool. Placeholder tiles are entered into the cache
+    /// right away, so any subsequent lookup of one of those tiles will
+    /// wait for (or, if the pool has not gotten to it yet, perform) the
+    /// pending read rather than issuing a redundant read of its own.
+    ///
+    /// Tiles that are already in the cache are skipped. The channel range
+    /// of `roi` designates the channels to cache; an undefined `roi` (the
+    /// default) means the whole image and all of its channels.
+    ///
+    /// @param  filename
+    ///             The name of the image, as a UTF-8 encoded ustring.
+    /// @param  subimage/miplevel
+    ///             The subimage and MIP level whose tiles should be read.
+    /// @param  roi
+    ///             The region of pixels (and channel range) whose tiles
+    ///             should be read.
+    /// @returns
+    ///             `true` if the file was valid and the requests could be
+    ///             queued, `false` if the file could not be opened or does
+    ///             not contain the designated subimage or MIP level.
+    ///
+    /// This was added in version 2.6.
+    virtual bool prefetch (ustring filename, int subimage, int miplevel,
+                           ROI roi = ROI::All()) = 0;
+    /// A more efficient variety of `prefetch()` for cases where you can
+    /// use an `ImageHandle*` to specify the image and optionally have a
+    /// `Perthread*` for the calling thread.
+    virtual bool prefetch (ImageHandle *file, Perthread *thread_info,
+                           int subimage, int miplevel,
+                           ROI roi = ROI::All()) = 0;
+    /// Batch variety of `prefetch()` that queues the tiles overlapping each
+    /// of several regions of the same subimage and MIP level.
+    virtual bool prefetch (ImageHandle *file, Perthread *thread_info,
+                           int subimage, int miplevel,
+                           cspan<ROI> rois) = 0;
+
     /// @}
 
     /// @{
@@ -1035,6 +1384,17 @@ public:
     /// ImageCache.
     virtual void reset_stats() = 0;
 
+    /// Write the tile access trace gathered while the `trace_tiles`
+    /// attribute is nonzero to the named file, as JSON. The trace holds,
+    /// for the most recent accesses by each thread, the time (seconds
+    /// since tracing began), file, subimage, MIP level, and tile origin
+    /// of every tile lookup that went to the shared cache, whether it was
+    /// found there (a hit) or had to be read (a miss, with the seconds the
+    /// read took). Records from all threads are merged in time order.
+    /// Return `true` for success, or `false` (with an error message
+    /// retrievable by `geterror()`) if the file could not be written.
+    virtual bool write_tile_trace(string_view filename) const = 0;
+
     /// @}
 
     virtual ~ImageCache() {}
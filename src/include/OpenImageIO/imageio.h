@@ -663,6 +663,22 @@ public:
     /// Populates the fields of the `ImageSpec` based on the XML passed in.
     void from_xml (const char *xml);
 
+    /// Append to `out` a compact, versioned binary encoding of all the
+    /// fields of the `ImageSpec`, including its metadata (other than
+    /// attributes of pointer type, which are omitted), for passing to
+    /// another process or storing. It is much cheaper to make and to read
+    /// back than `serialize()` or `to_xml()`, but is not human-readable.
+    void to_binary (std::vector<unsigned char>& out) const;
+
+    /// Replace the contents of the `ImageSpec` with those decoded from the
+    /// start of `data`, which must hold an encoding made by `to_binary()`.
+    /// Strings are interned or copied straight from `data`, with no
+    /// intermediate copies. Return the number of bytes of `data` that the
+    /// encoding took up, or 0 (leaving the `ImageSpec` unchanged) if
+    /// `data` does not start with a complete, valid encoding of a version
+    /// that this library can read.
+    size_t from_binary (cspan<unsigned char> data);
+
     /// Hunt for the "Compression" and "CompressionQuality" settings in the
     /// spec and turn them into the compression name and quality. This
     /// handles compression name/qual combos of the form "name:quality".
@@ -1052,6 +1068,31 @@ public:
     ///         `true` upon success, or `false` upon failure.
     virtual bool valid_file (Filesystem::IOProxy* ioproxy) const;
 
+    /// Read only as much of the file as is needed to fill in `spec` with
+    /// the resolution, number of channels, and data format of its first
+    /// subimage, without setting up all the decoder state that `open()`
+    /// does. Metadata and other fields of `spec` may be left at their
+    /// defaults, so this is meant for bulk scans that need only the shape
+    /// of many images. The reader is chosen as by `create()`, and `hints`
+    /// may supply configuration hints (including `"oiio:ioproxy"`) as for
+    /// `open()`. Errors are retrievable with the global `OIIO::geterror()`.
+    ///
+    /// @returns
+    ///         `true` upon success, or `false` upon failure.
+    ///
+    /// @version 2.6
+    static bool probe_spec (string_view filename, ImageSpec& spec,
+                            const ImageSpec* hints = nullptr);
+
+    /// The per-format part of `probe_spec()`, which a format reader may
+    /// override to parse only the header bytes it needs. The default fully
+    /// opens and closes the file, asking not to decode any metadata (see
+    /// the `"oiio:metadata"` open hint).
+    ///
+    /// @version 2.6
+    virtual bool probe_header (string_view filename, ImageSpec& spec,
+                               const ImageSpec& config);
+
     /// Opens the file with given name and seek to the first subimage in the
     /// file.  Various file attributes are put in `newspec` and a copy
     /// is also saved internally to the `ImageInput` (retrievable via
@@ -1424,6 +1465,31 @@ public:
                              stride_t xstride=AutoStride, stride_t ystride=AutoStride,
                              stride_t zstride=AutoStride);
 
+    /// Asynchronous versions of the thread-safe `read_scanlines()` and
+    /// `read_tiles()`: start the read and return immediately with a
+    /// future that yields the `bool` result once the pixels are in
+    /// `data`. This lets a caller overlap reads with other work, or have
+    /// several reads in flight at once.
+    ///
+    /// The default implementation runs the synchronous call as a task on
+    /// the shared OIIO thread pool; readers with a native asynchronous
+    /// path may override it. The caller must keep the ImageInput open and
+    /// `data` valid until the future is ready, and any error message is
+    /// retrieved with `geterror()` as usual.
+    ///
+    /// @version 2.6
+    virtual std::future<bool>
+    read_scanlines_async (int subimage, int miplevel, int ybegin, int yend,
+                          int z, int chbegin, int chend, TypeDesc format,
+                          void *data, stride_t xstride=AutoStride,
+                          stride_t ystride=AutoStride);
+    virtual std::future<bool>
+    read_tiles_async (int subimage, int miplevel, int xbegin, int xend,
+                      int ybegin, int yend, int zbegin, int zend,
+                      int chbegin, int chend, TypeDesc format, void *data,
+                      stride_t xstride=AutoStride, stride_t ystride=AutoStride,
+                      stride_t zstride=AutoStride);
+
 #ifndef OIIO_DOXYGEN
     // DEPRECATED versions of read_tiles (pre-1.9 OIIO). These will
     // eventually be removed. Try to replace these calls with ones to the
@@ -1647,6 +1713,19 @@ public:
                                     int xbegin, int xend, int ybegin, int yend,
                                     int zbegin, int zend,
                                     int chbegin, int chend, void *data);
+
+    /// Find where the native tile with upper left corner (x,y,z) lives in
+    /// the file, for readers whose tiles are sometimes stored as raw
+    /// bytes, exactly as `read_native_tile()` would return them (no
+    /// compression, contiguous interleaved channels, full tile size,
+    /// native byte order). If so, store the byte offset of the tile from
+    /// the start of the file in `offset` and its length in `size` and
+    /// return `true`, so the caller may read or memory-map those bytes
+    /// directly. The base class, and readers for which any decoding at
+    /// all would be needed, return `false`.
+    virtual bool native_tile_location (int subimage, int miplevel,
+                                       int x, int y, int z,
+                                       int64_t& offset, int64_t& size);
     /// @}
 
 
@@ -1787,9 +1866,17 @@ protected:
     /// if `m_io` is still not set (i.e., wasn't found in the config), open a
     /// IOFile local proxy with the given read/write `mode`. Return true if a
     /// proxy is set up. If it can't be done (i.e., no proxy passed, file
-    /// couldn't be opened), issue an error and return false.
+    /// couldn't be opened), issue an error and return false. If the config
+    /// had a nonzero "oiio:ioproxy:mmap" hint, the local proxy will be an
+    /// IOMMapReader rather than an IOFile (falling back to IOFile if the
+    /// file can't be mapped).
     bool ioproxy_use_or_open(string_view name);
 
+    /// If the proxy holds the whole file in memory (an IOMemReader or an
+    /// IOMMapReader), return a span of all its bytes for direct parsing
+    /// without copying. Otherwise, return an empty span.
+    cspan<unsigned char> ioproxy_buffer() const;
+
     /// Helper: read from the proxy akin to fread(). Return true on success,
     /// false upon failure and issue a helpful error message. NOTE: this is
     /// not the same return value as std::fread, which returns the number of
@@ -2837,6 +2924,12 @@ OIIO_API std::string geterror(bool clear = true);
 ///    calling thread do its own work inside of OIIO rather than spawning
 ///    new threads with a high overall "fan out."
 ///
+///    The JPEG XL, JPEG-2000, and HEIF/AVIF codecs' internal threading is
+///    also bounded by this value (or by the ImageInput/ImageOutput's own
+///    `threads()` setting), and is disabled when the read or write is
+///    itself issued from one of OIIO's thread pool workers. JPEG XL runs
+///    its parallel work directly on the OIIO thread pool.
+///
 /// - `int exr_threads`
 ///
 ///    Sets the internal OpenEXR thread pool size. The default is to use as
@@ -2856,11 +2949,49 @@ OIIO_API std::string geterror(bool clear = true);
 ///    If zero, they will try to use OIIO's native thread pool even if TBB
 ///    is available.
 ///
+/// - `int nested_parallelism`
+///
+///    If nonzero, parallel work started from within other parallel work
+///    (for example, ImageBufAlgo functions called by pool threads, or by
+///    code already running in a `parallel_for`) is itself split up across
+///    the thread pool, a few levels deep, as if every `paropt` had its
+///    `recursive` flag set. If zero (the default), such nested work runs
+///    on the calling thread alone, unless that call asks for recursion.
+///
+/// - `int thread_budget`
+///
+///    The maximum number of helper threads (threads other than the
+///    application's own threads that called into OIIO) that may be busy
+///    with OIIO parallel work at once, summed over all concurrent parallel
+///    loops, ImageBufAlgo operations, and codecs. This lets an application
+///    that runs many OIIO calls at once, or that has thread pools of its
+///    own, bound OIIO's total fan-out without making each call serial.
+///    The default of 0 means no cap beyond the `"threads"` pool size.
+///    Codecs with their own internal threads (OpenEXR, JPEG-2000, HEIF)
+///    are started with no more threads than the budget allows at the
+///    time. See also `OIIO::set_parallel_executor()` in parallel.h, which
+///    lets an application lend OIIO its own executor, such as a TBB task
+///    arena, to run on instead of OIIO's thread pool.
+///
 /// - `string plugin_searchpath`
 ///
 ///    Colon-separated (or semicolon-separated) list of directories to search
 ///    for dynamically-loaded format plugins.
 ///
+/// - `string plugin_manifest`
+///
+///    If not empty, the name of a file used to cache what each format
+///    plugin in the `plugin_searchpath` provides (format name, extensions,
+///    and library version). When the manifest is up to date -- the search
+///    path is the same, and none of its directories or plugins have changed
+///    modification time since it was written -- every format is registered
+///    straight from it, without listing the directories or loading any
+///    plugin, and each plugin is loaded only when its format is first
+///    used. Otherwise the plugins are scanned as usual and the manifest is
+///    rewritten. The default is the value of the environment variable
+///    `OPENIMAGEIO_PLUGIN_MANIFEST`, or empty (no manifest) if it is not
+///    set.  (Added in OpenImageIO 2.6)
+///
 /// - `int try_all_readers`
 ///
 ///    When nonzero (the default), a call to `ImageInput::create()` or
@@ -2920,11 +3051,40 @@ OIIO_API std::string geterror(bool clear = true);
 ///    When nonzero, treats BC5/ATI2 format files as normal maps (loads as
 ///    3 channels, computes blue from red and green). Default is 0.
 ///
+/// - `int ptex:max_memory_MB`
+///
+///    The most memory, in MB, that Ptex may hold for face data across all
+///    open Ptex files, in the single cache that all Ptex file readers
+///    share. The ImageCache keeps its own copy of any tiles it reads, so
+///    this is best kept small, leaving the ImageCache's `max_memory_MB`
+///    as the memory budget that matters. It takes effect only if set
+///    before the first Ptex file is opened. Default is 64.
+///
+/// - `int colorconvert:lut3d` (0)
+///
+///    When nonzero (it must be between 2 and 129), `ImageBufAlgo::
+///    colorconvert()` of UINT8 and UINT16 images through a transform that
+///    mixes channels is done by tetrahedral interpolation of a 3D LUT with
+///    this many samples on each axis (33 or 65 are typical), baked once
+///    per ColorProcessor, rather than by running the full transform on
+///    every pixel. This is much faster but only approximates the
+///    transform between grid points, so it is off by default. (Transforms
+///    that act on each channel independently are always done with exact
+///    1D tables for UINT8, UINT16, and HALF images.)
+///
 /// - `int openexr:core`
 ///
 ///    When nonzero, use the new "OpenEXR core C library" when available,
 ///    for OpenEXR >= 3.1. This is experimental, and currently defaults to 0.
 ///
+/// - `int openexr:core_output`
+///
+///    When nonzero (and the OpenEXR core C library is available), write
+///    OpenEXR files through the core library as well, compressing
+///    independent chunks in parallel on OIIO's thread pool and writing
+///    them to the file in order. Deep files are still written with the
+///    C++ library. This is experimental, and currently defaults to 0.
+///
 /// - `int limits:channels` (1024)
 ///
 ///    When nonzero, the maximum number of color channels in an image. Image
@@ -2963,6 +3123,26 @@ OIIO_API std::string geterror(bool clear = true);
 ///    the log information. When the `log_times` attribute is disabled,
 ///    there is no additional performance cost.
 ///
+/// - `string trace_file` ("")
+///
+///    When set to a filename, tracing is turned on (see
+///    `set_trace_callback()`) and the spans are written to that file in
+///    the Chrome trace event JSON format, which can be viewed with
+///    Perfetto or `chrome://tracing`. Spans are written in batches, so the
+///    file is only complete once the program has exited. It can also be
+///    set with the environment variable `OPENIMAGEIO_TRACE`. Setting it to
+///    the empty string stops writing the file.
+///
+/// - `float dircache_ttl` (0)
+///
+///    How many seconds a directory's listing may be reused when resolving
+///    UDIM patterns, searching the ImageCache's searchpath, or scanning for
+///    file sequences, rather than reading the directory again. This can
+///    save much time on slow network file systems, but files created or
+///    removed within that time may go unnoticed. The default of 0 disables
+///    this caching, unless overridden by the `OPENIMAGEIO_DIRCACHE_TTL`
+///    environment variable. (See `Filesystem::set_directory_cache_ttl()`.)
+///
 /// - `oiio:print_uncaught_errors` (1)
 ///
 ///   If nonzero, upon program exit, any error messages that would have been
@@ -2997,6 +3177,57 @@ OIIO_API std::string geterror(bool clear = true);
 ///   If nonzero, an `ImageBuf` that references a file but is not given an
 ///   ImageCache will read the image through the default ImageCache.
 ///
+/// - `string imagebuf:allocator` ("heap")
+///
+///   Which ImageBufAllocator supplies the pixel memory of ImageBufs that
+///   were not given one with `ImageBuf::set_allocator()`: `"heap"` for the
+///   general heap, `"pool"` for a pool that recycles freed buffers of
+///   similar size, or `"pinned"` for page-locked memory that GPU APIs can
+///   transfer without staging.
+///
+/// - `int imagebuf:pool_max_MB` (1024)
+///
+///   The most memory, in MB, that the ImageBuf pool will keep holding in
+///   freed buffers waiting to be reused. Setting it to 0 empties the pool.
+///
+/// - `int imagebuf:hugepages` (0)
+///
+///   If nonzero, pixel buffers of 4 MB or more that the heap and pool
+///   ImageBuf allocators hand out are aligned to 2 MB and, on Linux,
+///   marked as candidates for transparent huge pages, saving TLB misses
+///   and page faults on very large images. (`imagebuf:pool_hugepages` is
+///   an older name for the same attribute.)
+///
+/// - `int imagebuf:scanline_align` (0)
+///
+///   If nonzero (it must be a power of 2), the scanlines of the pixel
+///   buffers that ImageBufs allocate for themselves are padded so that
+///   each one starts on a multiple of this many bytes, for example 64 to
+///   keep SIMD loads of every row within cache lines. Padded buffers are
+///   not contiguous, so `scanline_stride()` must be used to step between
+///   rows. Buffers always start on at least a 64 byte boundary.
+///
+/// - `int imagebuf:read_threads` (1)
+///
+///   When an `ImageBuf` reads a whole file into local memory, the number
+///   of threads that decode it concurrently, each reading its own horizontal
+///   band of scanlines or tiles through a separate ImageInput. This speeds
+///   up formats whose readers are serial, such as scanline OpenEXR files
+///   with many channels. One (the default) reads serially, and zero means
+///   to use the global `threads` count. Reads through an IOProxy or with a
+///   progress callback are always serial.
+///
+/// - `int imagebuf:write_threads` (2)
+///
+///   The number of background threads that carry out
+///   `ImageBuf::write_async()` requests. Zero makes those writes happen
+///   synchronously, before `write_async()` returns.
+///
+/// - `int imagebuf:write_max_MB` (2048)
+///
+///   The most memory, in MB, that image snapshots waiting to be written by
+///   `ImageBuf::write_async()` may hold before further requests block.
+///
 OIIO_API bool attribute(string_view name, TypeDesc type, const void* val);
 
 /// Shortcut attribute() for setting a single integer.
@@ -3192,6 +3423,42 @@ inline string_view get_string_attribute (string_view name,
 }
 
 
+
+/// One span of time recorded by OpenImageIO's tracing. See
+/// `set_trace_callback()`.
+struct TraceSpan {
+    const char* name;  ///< What ran, e.g. "IBA::resize" (a ustring's chars)
+    int64_t begin;     ///< Start time, ns since the steady_clock epoch
+    int64_t end;       ///< End time, ns since the steady_clock epoch
+    int thread;        ///< A small integer identifying the thread
+};
+
+/// A function that receives batches of trace spans.
+using TraceCallback = void (*)(cspan<TraceSpan> spans, void* userdata);
+
+/// Turn on tracing and deliver its spans to `callback`, or turn it off
+/// (unless the `"trace_file"` attribute is set) if `callback` is null.
+///
+/// When tracing is on, `ImageBufAlgo` functions (those that `"log_times"`
+/// measures), `ImageInput` reads, `ImageOutput` writes, ImageCache tile
+/// reads, and batched texture lookups each record a span of the time
+/// they ran, which can be forwarded to a profiler such as Perfetto or
+/// Tracy, or to other telemetry. Each thread collects its spans in its
+/// own buffer and calls `callback(spans, userdata)` with a batch of them
+/// when the buffer fills, when the thread exits, or when it calls
+/// `trace_flush()`. Calls are serialized, but may come from any thread, so
+/// the callback should not itself call OpenImageIO functions that trace.
+///
+/// When tracing is off, the cost of the instrumentation is a test of one
+/// global integer per instrumented call.
+OIIO_API void set_trace_callback(TraceCallback callback,
+                                 void* userdata = nullptr);
+
+/// Deliver the calling thread's buffered trace spans now, rather than
+/// waiting for its buffer to fill or the thread to exit.
+OIIO_API void trace_flush();
+
+
 /// Register the input and output 'create' routines and list of file
 /// extensions for a particular format.
 OIIO_API void declare_imageio_format (const std::string &format_name,
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
@@ -118,7 +119,8 @@ public:
     // * If no pool was specified, use the default pool.
     // * If no max thread count was specified, use the pool size.
     // * If the calling thread is itself in the pool and the recursive flag
-    //   was not turned on, just use one thread.
+    //   was not turned on (nor the global "nested_parallelism" attribute),
+    //   just use one thread.
     void resolve();
 
     constexpr bool singlethread() const noexcept { return m_maxthreads == 1; }
@@ -137,6 +139,13 @@ public:
         return *this;
     }
 
+    // Should a parallel loop run from within a task of another parallel
+    // loop (or by any pool thread) also split its work onto the pool,
+    // rather than run serially? The nested work is queued on the same
+    // pool, and threads waiting for it run it themselves, so this composes
+    // without oversubscribing or deadlocking. It applies only a few levels
+    // deep. The global OIIO attribute "nested_parallelism" turns this on
+    // for all parallel loops.
     constexpr bool recursive() const noexcept { return m_recursive; }
     paropt& recursive(bool r) noexcept
     {
@@ -176,6 +185,103 @@ private:
 
 
 
+/// Process-wide thread budget: the maximum number of helper threads (that
+/// is, threads other than the application threads that called into OIIO)
+/// that may be busy with OIIO parallel work at the same time, summed over
+/// every concurrent parallel loop, ImageBufAlgo operation, and codec. A
+/// value of 0 (the default) means there is no cap beyond the size of the
+/// thread pool itself. The global OIIO attribute "thread_budget" sets the
+/// same value.
+OIIO_UTIL_API void
+thread_budget(int nthreads);
+OIIO_UTIL_API int
+thread_budget();
+
+/// The number of helper threads currently claimed from the budget.
+OIIO_UTIL_API int
+thread_budget_active();
+
+/// The number of helper threads that could be claimed right now, or a very
+/// large number if the budget is not capped.
+OIIO_UTIL_API int
+thread_budget_available();
+
+/// Claim up to `nthreads` helper threads from the budget and return how
+/// many were granted (possibly 0). Every claim must be balanced by a call
+/// to thread_budget_release() with the granted count once the helpers are
+/// done; thread_budget_claim does this automatically. If `counted` is
+/// given, an uncapped budget grants the claim without counting it, and
+/// `*counted` says whether it needs releasing.
+OIIO_UTIL_API int
+thread_budget_acquire(int nthreads, bool* counted = nullptr);
+OIIO_UTIL_API void
+thread_budget_release(int nthreads);
+
+/// Scoped claim on the thread budget, released when it goes out of scope.
+class thread_budget_claim {
+public:
+    explicit thread_budget_claim(int nthreads)
+        : m_granted(thread_budget_acquire(nthreads, &m_counted))
+    {
+    }
+    ~thread_budget_claim()
+    {
+        if (m_counted)
+            thread_budget_release(m_granted);
+    }
+    thread_budget_claim(const thread_budget_claim&)            = delete;
+    thread_budget_claim& operator=(const thread_budget_claim&) = delete;
+
+    int granted() const noexcept { return m_granted; }
+
+private:
+    bool m_counted = false;  // Initialized before m_granted
+    int m_granted;
+};
+
+
+
+/// An executor that an application may lend to OIIO, to run OIIO's
+/// parallel loops on its own threads (for example, a TBB task arena)
+/// rather than on OIIO's thread pool. It must call `task(b, e)` for
+/// non-overlapping subranges that together cover [begin, end), no larger
+/// than `chunksize`, and return only when all of them have finished. It
+/// may be called again from within one of those tasks, and may run any of
+/// them on the calling thread.
+using parallel_executor = std::function<void(
+    int64_t begin, int64_t end, int64_t chunksize,
+    function_view<void(int64_t b, int64_t e)> task)>;
+
+/// Lend OIIO an executor that has `nthreads` threads. From then on,
+/// parallel loops that don't name their own thread pool or ask for the
+/// `OIIOpool` strategy run on it, and `nthreads` replaces the pool size as
+/// the default degree of parallelism. The thread budget still applies.
+/// Passing an empty executor returns to OIIO's own thread pool. For
+/// example, to lend a TBB arena:
+///
+///     tbb::task_arena arena(8);
+///     OIIO::set_parallel_executor(
+///         [&](int64_t b, int64_t e, int64_t chunk, auto task) {
+///             arena.execute([&] {
+///                 tbb::parallel_for(
+///                     tbb::blocked_range<int64_t>(b, e, chunk),
+///                     [&](auto& r) { task(r.begin(), r.end()); },
+///                     tbb::simple_partitioner());
+///             });
+///         },
+///         arena.max_concurrency());
+///
+/// The executor must stay valid until it is replaced or OIIO is no longer
+/// in use.
+OIIO_UTIL_API void
+set_parallel_executor(parallel_executor executor, int nthreads);
+
+/// Is an executor currently lent to OIIO?
+OIIO_UTIL_API bool
+has_parallel_executor();
+
+
+
 /// Parallel "for" loop, chunked: for a task that takes an int64_t
 /// [begin,end) range, break it into non-overlapping sections that run in
 /// parallel:
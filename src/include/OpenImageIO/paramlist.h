@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <initializer_list>
 #include <vector>
 
 #include <OpenImageIO/attrdelegate.h>
@@ -354,9 +356,119 @@ make_pv(string_view name, T* val)
 /// A list of ParamValue entries, that can be iterated over or searched.
 /// It's really just a std::vector<ParamValue>, but with a few more handy
 /// methods.
+///
+/// Long lists (such as the metadata of a heavily annotated file) keep a
+/// lazily built hash index of the entry names, so that find() and all the
+/// lookups built on it don't need to scan the whole list. The std::vector
+/// methods that add, remove, or reorder entries are wrapped here to keep
+/// the index current; the only thing to avoid is renaming an entry in
+/// place through a reference or iterator (other than to a name differing
+/// only in case) -- replace it with add_or_replace() or attribute()
+/// instead.
 class OIIO_UTIL_API ParamValueList : public std::vector<ParamValue> {
+    using base_t = std::vector<ParamValue>;
+
 public:
     ParamValueList() {}
+    ParamValueList(const ParamValueList& other)
+        : base_t(other)
+    {
+    }
+    ParamValueList(ParamValueList&& other) noexcept
+        : base_t(std::move(other))
+    {
+        other.invalidate_index();
+    }
+    ~ParamValueList() { invalidate_index(); }
+
+    ParamValueList& operator=(const ParamValueList& other)
+    {
+        invalidate_index();
+        base_t::operator=(other);
+        return *this;
+    }
+    ParamValueList& operator=(ParamValueList&& other) noexcept
+    {
+        invalidate_index();
+        other.invalidate_index();
+        base_t::operator=(std::move(other));
+        return *this;
+    }
+
+    // Wrappers of the std::vector methods that change which entries are
+    // in the list or where they are, keeping the name index current.
+    void clear() noexcept
+    {
+        invalidate_index();
+        base_t::clear();
+    }
+    void push_back(const ParamValue& pv)
+    {
+        base_t::push_back(pv);
+        index_appended();
+    }
+    void push_back(ParamValue&& pv)
+    {
+        base_t::push_back(std::move(pv));
+        index_appended();
+    }
+    template<typename... Args> reference emplace_back(Args&&... args)
+    {
+        base_t::emplace_back(std::forward<Args>(args)...);
+        index_appended();
+        return back();
+    }
+    template<typename... Args> iterator emplace(Args&&... args)
+    {
+        invalidate_index();
+        return base_t::emplace(std::forward<Args>(args)...);
+    }
+    template<typename... Args> iterator insert(Args&&... args)
+    {
+        invalidate_index();
+        return base_t::insert(std::forward<Args>(args)...);
+    }
+    iterator insert(const_iterator pos, std::initializer_list<ParamValue> il)
+    {
+        invalidate_index();
+        return base_t::insert(pos, il);
+    }
+    template<typename... Args> void assign(Args&&... args)
+    {
+        invalidate_index();
+        base_t::assign(std::forward<Args>(args)...);
+    }
+    iterator erase(const_iterator pos)
+    {
+        invalidate_index();
+        return base_t::erase(pos);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        invalidate_index();
+        return base_t::erase(first, last);
+    }
+    void pop_back()
+    {
+        invalidate_index();
+        base_t::pop_back();
+    }
+    void resize(size_type n)
+    {
+        invalidate_index();
+        base_t::resize(n);
+    }
+    void resize(size_type n, const ParamValue& pv)
+    {
+        invalidate_index();
+        base_t::resize(n, pv);
+    }
+    void swap(ParamValueList& other) noexcept
+    {
+        invalidate_index();
+        other.invalidate_index();
+        base_t::swap(other);
+    }
 
     /// Add space for one more ParamValue to the list, and return a
     /// reference to its slot.
@@ -564,6 +676,16 @@ public:
     {
         return { this, name };
     }
+
+private:
+    struct NameIndex;
+    mutable std::atomic<NameIndex*> m_index { nullptr };
+
+    const NameIndex* name_index() const;
+    void invalidate_index() noexcept;
+    void index_appended();
+    template<typename Name>
+    size_t find_pos(Name name, TypeDesc type, bool casesensitive) const;
 };
 
 
@@ -3123,12 +3123,12 @@ vfloat16 blend (const vfloat16& a, const vfloat16& b, const vbool4& mask);
 /// Use a bool mask to select between `a` (if mask[i] is true) or 0 if
 /// mask[i] is false), i.e., mask[i] ? a[i] : 0. Equivalent to
 /// blend(0,a,mask).
-vfloat16 blend0 (const vfloat16& a, const vbool4& mask);
+vfloat16 blend0 (const vfloat16& a, const vbool16& mask);
 
 /// Use a bool mask to select between components of a (if mask[i] is false)
 /// or 0 (if mask[i] is true), i.e., mask[i] ? 0 : a[i]. Equivalent to
 /// blend(0,a,!mask), or blend(a,0,mask).
-vfloat16 blend0not (const vfloat16& a, const vbool4& mask);
+vfloat16 blend0not (const vfloat16& a, const vbool16& mask);
 
 /// "Safe" divide of vfloat16/vfloat16 -- for any component of the divisor
 /// that is 0, return 0 rather than Inf.
@@ -5373,6 +5373,8 @@ OIIO_FORCEINLINE vint8::vint8 (const vint4& lo, const vint4 &hi) {
 OIIO_FORCEINLINE vint8 operator+ (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_add_epi32 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vint8 (a.lo() + b.lo(), a.hi() + b.hi());
 #else
     SIMD_RETURN (vint8, a[i] + b[i]);
 #endif
@@ -5387,6 +5389,8 @@ OIIO_FORCEINLINE const vint8& operator+= (vint8& a, const vint8& b) {
 OIIO_FORCEINLINE vint8 operator- (const vint8& a) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_sub_epi32 (_mm256_setzero_si256(), a);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vint8 (-a.lo(), -a.hi());
 #else
     SIMD_RETURN (vint8, -a[i]);
 #endif
@@ -5396,6 +5400,8 @@ OIIO_FORCEINLINE vint8 operator- (const vint8& a) {
 OIIO_FORCEINLINE vint8 operator- (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_sub_epi32 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vint8 (a.lo() - b.lo(), a.hi() - b.hi());
 #else
     SIMD_RETURN (vint8, a[i] - b[i]);
 #endif
@@ -5410,6 +5416,8 @@ OIIO_FORCEINLINE const vint8 &operator-= (vint8& a, const vint8& b) {
 OIIO_FORCEINLINE vint8 operator* (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_mullo_epi32 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vint8 (a.lo() * b.lo(), a.hi() * b.hi());
 #else
     SIMD_RETURN (vint8, a[i] * b[i]);
 #endif
@@ -5446,6 +5454,8 @@ OIIO_FORCEINLINE const vint8& operator%= (vint8& a, int b) { return a = a % b; }
 OIIO_FORCEINLINE vint8 operator& (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_and_si256 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vint8 (a.lo() & b.lo(), a.hi() & b.hi());
 #else
     SIMD_RETURN (vint8, a[i] & b[i]);
 #endif
@@ -5456,6 +5466,8 @@ OIIO_FORCEINLINE const vint8& operator&= (vint8& a, const vint8& b) { return a =
 OIIO_FORCEINLINE vint8 operator| (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_or_si256 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vint8 (a.lo() | b.lo(), a.hi() | b.hi());
 #else
     SIMD_RETURN (vint8, a[i] | b[i]);
 #endif
@@ -5466,6 +5478,8 @@ OIIO_FORCEINLINE const vint8& operator|= (vint8& a, const vint8& b) { return a =
 OIIO_FORCEINLINE vint8 operator^ (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_xor_si256 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vint8 (a.lo() ^ b.lo(), a.hi() ^ b.hi());
 #else
     SIMD_RETURN (vint8, a[i] ^ b[i]);
 #endif
@@ -5477,6 +5491,8 @@ OIIO_FORCEINLINE const vint8& operator^= (vint8& a, const vint8& b) { return a =
 OIIO_FORCEINLINE vint8 operator~ (const vint8& a) {
 #if OIIO_SIMD_AVX >= 2
     return a ^ a.NegOne();
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vint8 (~a.lo(), ~a.hi());
 #else
     SIMD_RETURN (vint8, ~a[i]);
 #endif
@@ -5486,7 +5502,7 @@ OIIO_FORCEINLINE vint8 operator~ (const vint8& a) {
 OIIO_FORCEINLINE vint8 operator<< (const vint8& a, unsigned int bits) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_slli_epi32 (a, bits);
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
     return vint8 (a.lo() << bits, a.hi() << bits);
 #else
     SIMD_RETURN (vint8, a[i] << bits);
@@ -5501,7 +5517,7 @@ OIIO_FORCEINLINE const vint8& operator<<= (vint8& a, const unsigned int bits) {
 OIIO_FORCEINLINE vint8 operator>> (const vint8& a, const unsigned int bits) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_srai_epi32 (a, bits);
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
     return vint8 (a.lo() >> bits, a.hi() >> bits);
 #else
     SIMD_RETURN (vint8, a[i] >> bits);
@@ -5516,6 +5532,8 @@ OIIO_FORCEINLINE const vint8& operator>>= (vint8& a, const unsigned int bits) {
 OIIO_FORCEINLINE vint8 srl (const vint8& a, const unsigned int bits) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_srli_epi32 (a, bits);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vint8 (srl(a.lo(), bits), srl(a.hi(), bits));
 #else
     SIMD_RETURN (vint8, int ((unsigned int)(a[i]) >> bits));
 #endif
@@ -6406,8 +6424,8 @@ OIIO_FORCEINLINE void vint16::store (int *values, int n) const {
 
 
 OIIO_FORCEINLINE void vint16::store (unsigned short *values) const {
-#if OIIO_SIMD_AVX512
-    _mm512_mask_cvtepi32_storeu_epi16 (values, __mmask16(0xff), m_simd);
+#if OIIO_SIMD_AVX >= 512
+    _mm512_mask_cvtepi32_storeu_epi16 (values, __mmask16(0xffff), m_simd);
 #elif OIIO_SIMD_AVX >= 2
     lo().store (values);
     hi().store (values+8);
@@ -6418,8 +6436,8 @@ OIIO_FORCEINLINE void vint16::store (unsigned short *values) const {
 
 
 OIIO_FORCEINLINE void vint16::store (unsigned char *values) const {
-#if OIIO_SIMD_AVX512
-    _mm512_mask_cvtepi32_storeu_epi8 (values, __mmask16(0xff), m_simd);
+#if OIIO_SIMD_AVX >= 512
+    _mm512_mask_cvtepi32_storeu_epi8 (values, __mmask16(0xffff), m_simd);
 #elif OIIO_SIMD_AVX >= 2
     lo().store (values);
     hi().store (values+8);
@@ -6467,15 +6485,23 @@ template<int i> vint16 shuffle (const vint16& a) {
 
 template<int i>
 OIIO_FORCEINLINE int extract (const vint16& a) {
+#if OIIO_SIMD_AVX >= 512
+    return _mm_extract_epi32 (_mm512_extracti32x4_epi32 (a.simd(), i/4), i%4);
+#else
     return a[i];
+#endif
 }
 
 
 template<int i>
 OIIO_FORCEINLINE vint16 insert (const vint16& a, int val) {
+#if OIIO_SIMD_AVX >= 512
+    return _mm512_mask_set1_epi32 (a.simd(), __mmask16(1<<i), val);
+#else
     vint16 tmp = a;
     tmp[i] = val;
     return tmp;
+#endif
 }
 
 
@@ -7534,6 +7560,9 @@ OIIO_FORCEINLINE vfloat4 blend0 (const vfloat4& a, const vbool4& mask)
 {
 #if OIIO_SIMD_SSE
     return _mm_and_ps(mask.simd(), a.simd());
+#elif OIIO_SIMD_NEON
+    return vreinterpretq_f32_u32(vandq_u32(mask.simd(),
+                                           vreinterpretq_u32_f32(a.simd())));
 #else
     return vfloat4 (mask[0] ? a[0] : 0.0f,
                    mask[1] ? a[1] : 0.0f,
@@ -7547,6 +7576,9 @@ OIIO_FORCEINLINE vfloat4 blend0not (const vfloat4& a, const vbool4& mask)
 {
 #if OIIO_SIMD_SSE
     return _mm_andnot_ps(mask.simd(), a.simd());
+#elif OIIO_SIMD_NEON
+    return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(a.simd()),
+                                           mask.simd()));
 #else
     return vfloat4 (mask[0] ? 0.0f : a[0],
                    mask[1] ? 0.0f : a[1],
@@ -7557,7 +7589,7 @@ OIIO_FORCEINLINE vfloat4 blend0not (const vfloat4& a, const vbool4& mask)
 
 
 OIIO_FORCEINLINE vfloat4 safe_div (const vfloat4 &a, const vfloat4 &b) {
-#if OIIO_SIMD_SSE
+#if OIIO_SIMD_SSE || OIIO_SIMD_NEON
     return blend0not (a/b, b == vfloat4::Zero());
 #else
     return vfloat4 (b[0] == 0.0f ? 0.0f : a[0] / b[0],
@@ -7610,6 +7642,8 @@ OIIO_FORCEINLINE vfloat4 ceil (const vfloat4& a)
 {
 #if OIIO_SIMD_SSE >= 4  /* SSE >= 4.1 */
     return _mm_ceil_ps (a);
+#elif OIIO_SIMD_NEON && defined(__aarch64__)
+    return vrndpq_f32(a);
 #else
     SIMD_RETURN (vfloat4, ceilf(a[i]));
 #endif
@@ -7619,6 +7653,8 @@ OIIO_FORCEINLINE vfloat4 floor (const vfloat4& a)
 {
 #if OIIO_SIMD_SSE >= 4  /* SSE >= 4.1 */
     return _mm_floor_ps (a);
+#elif OIIO_SIMD_NEON && defined(__aarch64__)
+    return vrndmq_f32(a);
 #else
     SIMD_RETURN (vfloat4, floorf(a[i]));
 #endif
@@ -7640,6 +7676,8 @@ OIIO_FORCEINLINE vint4 ifloor (const vfloat4& a)
     // FIXME: look into this, versus the method of quick_floor in texturesys.cpp
 #if OIIO_SIMD_SSE >= 4  /* SSE >= 4.1 */
     return vint4(floor(a));
+#elif OIIO_SIMD_NEON && defined(__aarch64__)
+    return vcvtmq_s32_f32(a);
 #else
     SIMD_RETURN (vint4, (int)floorf(a[i]));
 #endif
@@ -7654,17 +7692,22 @@ OIIO_FORCEINLINE vint4 rint (const vfloat4& a)
 
 OIIO_FORCEINLINE vfloat4 rcp_fast (const vfloat4 &a)
 {
-#if OIIO_SIMD_AVX512 && OIIO_AVX512VL_ENABLED
+#if OIIO_SIMD_AVX >= 512 && OIIO_AVX512VL_ENABLED
     // avx512vl directly has rcp14 on float4
     vfloat4 r = _mm_rcp14_ps(a);
     return r * nmadd(r,a,vfloat4(2.0f));
-#elif OIIO_SIMD_AVX512
+#elif OIIO_SIMD_AVX >= 512
     // Trickery: in and out of the 512 bit registers to use fast approx rcp
     vfloat16 r = _mm512_rcp14_ps(_mm512_castps128_ps512(a));
     return _mm512_castps512_ps128(r);
 #elif OIIO_SIMD_SSE
     vfloat4 r = _mm_rcp_ps(a);
     return r * nmadd(r,a,vfloat4(2.0f));
+#elif OIIO_SIMD_NEON
+    // The estimate is only good to ~8 bits; two Newton steps refine it.
+    float32x4_t r = vrecpeq_f32(a);
+    r = vmulq_f32(vrecpsq_f32(a, r), r);
+    return vmulq_f32(vrecpsq_f32(a, r), r);
 #else
     SIMD_RETURN (vfloat4, 1.0f/a[i]);
 #endif
@@ -7705,6 +7748,10 @@ OIIO_FORCEINLINE vfloat4 rsqrt_fast (const vfloat4 &a)
     return _mm512_castps512_ps128(_mm512_rsqrt14_ps(_mm512_castps128_ps512(a)));
 #elif OIIO_SIMD_SSE
     return _mm_rsqrt_ps (a.simd());
+#elif OIIO_SIMD_NEON
+    // One Newton step brings the ~8 bit estimate to about SSE's precision.
+    float32x4_t r = vrsqrteq_f32(a);
+    return vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
 #else
     SIMD_RETURN (vfloat4, 1.0f/sqrtf(a[i]));
 #endif
@@ -7737,6 +7784,9 @@ OIIO_FORCEINLINE vfloat4 max (const vfloat4& a, const vfloat4& b)
 OIIO_FORCEINLINE vfloat4 andnot (const vfloat4& a, const vfloat4& b) {
 #if OIIO_SIMD_SSE
     return _mm_andnot_ps (a.simd(), b.simd());
+#elif OIIO_SIMD_NEON
+    return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(b.simd()),
+                                           vreinterpretq_u32_f32(a.simd())));
 #else
     vint4 ai = bitcast_to_int(a);
     vint4 bi = bitcast_to_int(b);
@@ -8654,6 +8704,9 @@ OIIO_FORCEINLINE vfloat8::vfloat8 (const vfloat4& lo, const vfloat4 &hi) {
 OIIO_FORCEINLINE vfloat8::vfloat8 (const vint8& ival) {
 #if OIIO_SIMD_AVX
     m_simd = _mm256_cvtepi32_ps (ival);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    m_4[0] = vfloat4(ival.lo());
+    m_4[1] = vfloat4(ival.hi());
 #else
     SIMD_CONSTRUCT (float(ival[i]));
 #endif
@@ -9242,7 +9295,7 @@ OIIO_FORCEINLINE vfloat8 select (const vbool8& mask, const vfloat8& a, const vfl
 
 
 OIIO_FORCEINLINE vfloat8 safe_div (const vfloat8 &a, const vfloat8 &b) {
-#if OIIO_SIMD_SSE
+#if OIIO_SIMD_SSE || OIIO_SIMD_NEON
     return blend0not (a/b, b == vfloat8::Zero());
 #else
     SIMD_RETURN (vfloat8, b[i] == 0.0f ? 0.0f : a[i] / b[i]);
@@ -9274,6 +9327,8 @@ OIIO_FORCEINLINE vfloat8 ceil (const vfloat8& a)
 {
 #if OIIO_SIMD_AVX
     return _mm256_ceil_ps (a);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vfloat8(ceil(a.lo()), ceil(a.hi()));
 #else
     SIMD_RETURN (vfloat8, ceilf(a[i]));
 #endif
@@ -9283,6 +9338,8 @@ OIIO_FORCEINLINE vfloat8 floor (const vfloat8& a)
 {
 #if OIIO_SIMD_AVX
     return _mm256_floor_ps (a);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vfloat8(floor(a.lo()), floor(a.hi()));
 #else
     SIMD_RETURN (vfloat8, floorf(a[i]));
 #endif
@@ -9292,6 +9349,8 @@ OIIO_FORCEINLINE vfloat8 round (const vfloat8& a)
 {
 #if OIIO_SIMD_AVX
     return _mm256_round_ps (a, (_MM_FROUND_TO_NEAREST_INT |_MM_FROUND_NO_EXC));
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vfloat8(round(a.lo()), round(a.hi()));
 #else
     SIMD_RETURN (vfloat8, roundf(a[i]));
 #endif
@@ -9302,7 +9361,7 @@ OIIO_FORCEINLINE vint8 ifloor (const vfloat8& a)
     // FIXME: look into this, versus the method of quick_floor in texturesys.cpp
 #if OIIO_SIMD_AVX
     return vint8(floor(a));
-#elif OIIO_SIMD_SSE   /* SSE2/3 */
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
     return vint8 (ifloor(a.lo()), ifloor(a.hi()));
 #else
     SIMD_RETURN (vint8, (int)floorf(a[i]));
@@ -9319,7 +9378,7 @@ OIIO_FORCEINLINE vint8 rint (const vfloat8& a)
 
 OIIO_FORCEINLINE vfloat8 rcp_fast (const vfloat8 &a)
 {
-#if OIIO_SIMD_AVX512 && OIIO_AVX512VL_ENABLED
+#if OIIO_SIMD_AVX >= 512 && OIIO_AVX512VL_ENABLED
     vfloat8 r = _mm256_rcp14_ps(a);
     return r * nmadd(r,a,vfloat8(2.0f));
 #elif OIIO_SIMD_AVX
@@ -9335,6 +9394,8 @@ OIIO_FORCEINLINE vfloat8 sqrt (const vfloat8 &a)
 {
 #if OIIO_SIMD_AVX
     return _mm256_sqrt_ps (a.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vfloat8(sqrt(a.lo()), sqrt(a.hi()));
 #else
     SIMD_RETURN (vfloat8, sqrtf(a[i]));
 #endif
@@ -9346,6 +9407,8 @@ OIIO_FORCEINLINE vfloat8 rsqrt (const vfloat8 &a)
 {
 #if OIIO_SIMD_AVX
     return _mm256_div_ps (_mm256_set1_ps(1.0f), _mm256_sqrt_ps (a.simd()));
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vfloat8(rsqrt(a.lo()), rsqrt(a.hi()));
 #else
     SIMD_RETURN (vfloat8, 1.0f/sqrtf(a[i]));
 #endif
@@ -9996,15 +10059,25 @@ template<int i> vfloat16 shuffle (const vfloat16& a) {
 
 template<int i>
 OIIO_FORCEINLINE float extract (const vfloat16& a) {
+#if OIIO_SIMD_AVX >= 512
+    __m128 q = _mm512_extractf32x4_ps (a.simd(), i/4);
+    return _mm_cvtss_f32 (_mm_shuffle_ps (q, q, i%4));
+#else
     return a[i];
+#endif
 }
 
 
 template<int i>
 OIIO_FORCEINLINE vfloat16 insert (const vfloat16& a, float val) {
+#if OIIO_SIMD_AVX >= 512
+    return _mm512_mask_broadcastss_ps (a.simd(), __mmask16(1<<i),
+                                       _mm_set_ss(val));
+#else
     vfloat16 tmp = a;
     tmp[i] = val;
     return tmp;
+#endif
 }
 
 
@@ -10109,8 +10182,12 @@ OIIO_FORCEINLINE vfloat16 select (const vbool16& mask, const vfloat16& a, const
 
 
 OIIO_FORCEINLINE vfloat16 safe_div (const vfloat16 &a, const vfloat16 &b) {
-#if OIIO_SIMD_SSE
-    return blend0not (a/b, b == vfloat16::Zero());
+#if OIIO_SIMD_AVX >= 512
+    // Only divide the lanes whose divisor is nonzero, zero the rest.
+    return _mm512_maskz_div_ps (_mm512_cmp_ps_mask (b, _mm512_setzero_ps(),
+                                                    _CMP_NEQ_UQ), a, b);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
+    return vfloat16(safe_div(a.lo(), b.lo()), safe_div(a.hi(), b.hi()));
 #else
     SIMD_RETURN (vfloat16, b[i] == 0.0f ? 0.0f : a[i] / b[i]);
 #endif
@@ -10177,7 +10254,11 @@ OIIO_FORCEINLINE vint16 ifloor (const vfloat16& a)
 
 OIIO_FORCEINLINE vint16 rint (const vfloat16& a)
 {
+#if OIIO_SIMD_AVX >= 512
+    return _mm512_cvt_roundps_epi32 (a, (_MM_FROUND_TO_NEAREST_INT |_MM_FROUND_NO_EXC));
+#else
     return vint16(round(a));
+#endif
 }
 
 
@@ -648,6 +648,23 @@ OIIO_UTIL_API double stod (string_view s, size_t* pos=0);
 OIIO_UTIL_API double stod (const std::string& s, size_t* pos=0);
 OIIO_UTIL_API double stod (const char* s, size_t* pos=0);
 
+/// Convert a list of numbers in `s`, separated by `sep` (with optional
+/// whitespace around the numbers), into consecutive elements of `values`.
+/// Conversion stops when `values` is full, or at the first element that is
+/// not a number or is not followed by a separator. An all-whitespace `sep`
+/// means the numbers are separated by whitespace. Return the number of
+/// values converted. Like stoi/stof/stod, there is no locale
+/// dependence, and this is much cheaper than splitting the string and
+/// converting each piece, so it is the preferred way to read long arrays
+/// of numbers out of text metadata.
+OIIO_UTIL_API size_t from_string_list (string_view s, span<float> values,
+                                       string_view sep = ",");
+OIIO_UTIL_API size_t from_string_list (string_view s, span<double> values,
+                                       string_view sep = ",");
+OIIO_UTIL_API size_t from_string_list (string_view s, span<int> values,
+                                       string_view sep = ",");
+#define OIIO_STRUTIL_HAS_FROM_STRING_LIST 1
+
 
 
 /// Return true if the string is exactly (other than leading and trailing
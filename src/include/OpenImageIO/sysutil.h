@@ -109,6 +109,23 @@ physical_concurrency();
 OIIO_API size_t
 max_open_files();
 
+/// Number of NUMA memory nodes on this system (1 if it isn't a NUMA
+/// system, or if it can't be determined on this platform).
+OIIO_API int
+numa_nodes();
+
+/// The NUMA node of the CPU the calling thread is running on right now
+/// (0 if unknown). Threads may migrate, so this is only a snapshot.
+OIIO_API int
+current_numa_node();
+
+/// Ask the OS to place the pages of memory spanning `[ptr, ptr+size)` on
+/// NUMA node `node`, moving any that are already resident elsewhere.
+/// `ptr` should be aligned to a page. Return true if the request was
+/// accepted, false if it failed or is not supported on this platform.
+OIIO_API bool
+numa_prefer_node(void* ptr, size_t size, int node);
+
 /// Return a string containing a readable stack trace from the point where
 /// it was called. Return an empty string if not supported on this platform
 /// or this build of OpenImageIO.
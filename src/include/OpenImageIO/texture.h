@@ -629,8 +629,37 @@ public:
     /// - `int stochastic` :
     ///             Bit field determining how to use stochastic sampling for
     ///             MipModeStochasticAniso and/or MipModeStochasticTrilinear.
-    ///             Bit 1 = sample MIP level, bit 2 = sample anisotropy
-    ///             (default=0).
+    ///             Bit 1 = sample MIP level, bit 2 = sample anisotropy,
+    ///             bit 4 = a single tap: one MIP level, one probe, and one
+    ///             texel of its bilinear footprint chosen by `rnd`, which
+    ///             implies bits 1 and 2 (default=0). Lookups that ask for
+    ///             derivatives still interpolate the one probe.
+    /// - `int coherent_batches` :
+    ///             If nonzero, the batched `texture()` and `environment()`
+    ///             calls will sort the lanes they process one at a time by
+    ///             their likely MIP level and tile, so that lanes sharing
+    ///             a tile are looked up back to back. This helps when the
+    ///             lanes of a batch are scattered over a few tiles. The
+    ///             default is 0.
+    /// - `string capture` :
+    ///             If set to a file name, every 2D `texture()` lookup from
+    ///             then on (each active lane, for batched calls) is
+    ///             appended to that file, until the attribute is set to
+    ///             the empty string. `testtex --replay` plays such a file
+    ///             back as a benchmark. The file, in native byte order, is
+    ///             the 8 bytes `OIIOTXC1` followed by records that each
+    ///             begin with a one-byte tag. An `S` record is a `uint32`
+    ///             length and that many bytes of a string, which is given
+    ///             the next string index, counting from 0. A `T` record is
+    ///             a lookup: the `uint32` string index of the file name,
+    ///             then `int32` subimage name string index (-1 if none),
+    ///             subimage, firstchannel, nchannels, swrap, twrap,
+    ///             mipmode, interpmode, anisotropic, conservative_filter,
+    ///             and colortransformid, then `float` s, t, dsdx, dtdx,
+    ///             dsdy, dtdy, sblur, tblur, swidth, twidth, fill, and rnd.
+    ///             Lookups on UDIM tiles by a batched call are recorded
+    ///             with the tile's own file name. Capturing serializes
+    ///             lookups on a lock, so it is far too slow to leave on.
     ///
     /// - `string options`
     ///             This catch-all is simply a comma-separated list of
@@ -842,6 +871,17 @@ public:
     /// This method was added in OpenImageIO 2.3.
     virtual ustring filename_from_handle(TextureHandle* handle) = 0;
 
+    /// Set or retrieve a per-file attribute (such as `"evict_priority"` or
+    /// `"max_memory_MB"`) that controls how the underlying ImageCache
+    /// treats this texture's tiles. See `ImageCache::attribute(ImageHandle*,
+    /// ...)` for the recognized names.
+    ///
+    /// This method was added in OpenImageIO 2.6.
+    virtual bool attribute(TextureHandle* texture_handle, string_view name,
+                           TypeDesc type, const void* val) = 0;
+    virtual bool getattribute(TextureHandle* texture_handle, string_view name,
+                              TypeDesc type, void* val) const = 0;
+
     /// Retrieve an id for a color transformation by name. This ID can be used
     /// as the value for TextureOpt::colortransformid. The returned value will
     /// be -1 if either color space is unknown, and 0 for a null
@@ -850,6 +890,24 @@ public:
                                       ustring tospace) const = 0;
     virtual int get_colortransform_id(ustringhash fromspace,
                                       ustringhash tospace) const = 0;
+
+    /// Define an opaque data type for a set of texture options that have
+    /// been validated and resolved once, up front, so that many lookups
+    /// sharing identical options don't pay to set them up on every call.
+    class Sampler;
+
+    /// Create a Sampler holding a copy of `options`, with its modes
+    /// validated and the lookup method chosen. A Sampler is immutable and
+    /// may be shared freely among threads. Per-lookup fields that vary
+    /// (such as `rnd`) are taken from `options` and are the same for every
+    /// lookup made with it. It is the caller's responsibility to eventually
+    /// destroy it using `destroy_sampler()`.
+    ///
+    /// This method was added in OpenImageIO 2.6.
+    virtual Sampler* create_sampler(const TextureOpt& options) = 0;
+
+    /// Destroy a Sampler that was allocated by `create_sampler()`.
+    virtual void destroy_sampler(Sampler* sampler) = 0;
     /// @}
 
     /// @{
@@ -948,6 +1006,16 @@ public:
                           int nchannels, float *result,
                           float *dresultds=nullptr, float *dresultdt=nullptr) = 0;
 
+    /// Version of texture() lookup that takes its options from a Sampler
+    /// previously returned by `create_sampler()`, rather than validating a
+    /// TextureOpt on every call.
+    virtual bool texture (TextureHandle *texture_handle,
+                          Perthread *thread_info, const Sampler *sampler,
+                          float s, float t, float dsdx, float dtdx,
+                          float dsdy, float dtdy,
+                          int nchannels, float *result,
+                          float *dresultds=nullptr, float *dresultdt=nullptr) = 0;
+
 
     /// Perform a filtered 3D volumetric texture lookup on a position
     /// centered at 3D position `P` (with given differentials) from the
@@ -1201,6 +1269,17 @@ public:
                           int nchannels, float *result,
                           float *dresultds=nullptr,
                           float *dresultdt=nullptr) = 0;
+    /// Batched texture() lookup whose options all come from a Sampler
+    /// previously returned by `create_sampler()`, so that the blur, width,
+    /// and `rnd` values are the same for every lane.
+    virtual bool texture (TextureHandle *texture_handle,
+                          Perthread *thread_info, const Sampler *sampler,
+                          Tex::RunMask mask, const float *s, const float *t,
+                          const float *dsdx, const float *dtdx,
+                          const float *dsdy, const float *dtdy,
+                          int nchannels, float *result,
+                          float *dresultds=nullptr,
+                          float *dresultdt=nullptr) = 0;
 
 #ifndef OIIO_DOXYGEN
     // Old multi-point API call.
@@ -1597,6 +1676,19 @@ public:
     ///         Stores 1 if this file was a duplicate of another image,
     ///         otherwise 0.
     ///
+    ///   - `stat:texture_queries` (int64), `stat:texture_probes`
+    ///     (int64), `stat:texture_time` (float) :
+    ///         The number of `texture()` lookups of this file, the number
+    ///         of texel interpolations (probes) they took, and the time in
+    ///         seconds spent in them. These, and the next item, are only
+    ///         kept while the "statistics:level" attribute is 3 or more,
+    ///         which also lists them per file in `getstats()`.
+    ///
+    ///   - `stat:texture_mip_hits` (int64 array) :
+    ///         How many lookups of this file sampled each of its MIP
+    ///         levels, for as many levels as the array length asks for
+    ///         (levels past the 16th are counted in the 16th).
+    ///
     ///   - *Anything else* :
     ///         For all other data names, the the metadata of the image file
     ///         will be searched for an item that matches both the name and
@@ -1746,6 +1838,47 @@ public:
                              int chbegin, int chend,
                              TypeDesc format, void *result) = 0;
 
+    /// For a virtual-texture or GPU sparse-texture system that mirrors the
+    /// cache: report which tiles of one MIP level of a 2D texture are
+    /// resident in the cache right now, and gather the pixels of those that
+    /// have become resident since the caller's last look.
+    ///
+    /// @param  texture_handle
+    ///             The texture, which must be a valid non-UDIM handle.
+    /// @param  subimage/miplevel
+    ///             The subimage and MIP level to describe.
+    /// @param  pagetable
+    ///             On input, the page table returned by the previous call
+    ///             for this level (or empty, for the first call). On
+    ///             output, one entry per tile, indexed as
+    ///             `tx + ty * ntilesx`, that is 1 if that tile is resident
+    ///             and 0 if it is not.
+    /// @param  newtiles
+    ///             Output: the page table indices, in ascending order, of
+    ///             the tiles that are resident now but were not in the
+    ///             input `pagetable`.
+    /// @param  staging
+    ///             Output: the pixels of each tile in `newtiles`, one after
+    ///             another in the same order, each a whole tile of all
+    ///             channels in the data type the cache stores this texture
+    ///             in (as for ImageCache `get_tile()`).
+    /// @returns
+    ///             `true` for success, `false` for failure (an invalid
+    ///             handle, subimage, or MIP level).
+    ///
+    /// Tiles cached with a color transform, or with only some channels of
+    /// a file with very many channels, are not reported. Each call walks
+    /// the whole tile cache, so the intent is to call it once per frame,
+    /// not per lookup.
+    ///
+    /// This method was added in OpenImageIO 2.6.
+    virtual bool get_resident_tiles (TextureHandle *texture_handle,
+                                     Perthread *thread_info,
+                                     int subimage, int miplevel,
+                                     std::vector<unsigned char> &pagetable,
+                                     std::vector<int> &newtiles,
+                                     std::vector<unsigned char> &staging) = 0;
+
     /// @}
 
     /// @{
@@ -1780,6 +1913,18 @@ public:
                                         Perthread* thread_info,
                                         float s, float t) = 0;
 
+    /// Batched `resolve_udim()`: for each lane `i` set in `mask`, store in
+    /// `result[i]` the TextureHandle of the concrete tile file that
+    /// `(s[i], t[i])` falls in, or nullptr if there is none. Lanes not in
+    /// the mask get nullptr. Each distinct tile in the batch is resolved
+    /// only once.
+    ///
+    /// This method was added in OpenImageIO 2.6.
+    virtual void resolve_udim(TextureHandle* udimfile,
+                              Perthread* thread_info, Tex::RunMask mask,
+                              const float* s, const float* t,
+                              TextureHandle** result) = 0;
+
     /// Produce a full inventory of the set of concrete files comprising the
     /// UDIM set specified by UTF-8 encoded `udimpattern`.  The apparent
     /// number of texture atlas tiles in the u and v directions will be
@@ -716,9 +716,9 @@ public:
     /// If there are any tasks on the queue, pull one off and run it (on
     /// this calling thread) and return true. Otherwise (there are no
     /// pending jobs), return false immediately. This utility is what makes
-    /// it possible for non-pool threads to also run tasks from the queue
-    /// when they would ordinarily be idle. The thread id of the caller
-    /// should be passed.
+    /// it possible for threads waiting on tasks (pool threads included) to
+    /// run tasks from the queue when they would ordinarily be idle. The
+    /// thread id of the caller should be passed.
     bool run_one_task(std::thread::id id);
 
     /// Return true if the calling thread is part of the thread pool. This
@@ -209,6 +209,29 @@ OIIO_API bool decode_xmp (const char* xml, ImageSpec &spec);
 OIIO_API bool decode_xmp (const std::string& xml, ImageSpec &spec);
 
 
+/// Return how much embedded Exif, XMP, and IPTC metadata a format reader
+/// should decode when opening a file, as requested by the
+/// `"oiio:metadata"` hint in its `config` spec:
+///
+/// - `"all"` (the default): decode everything into the ImageSpec.
+/// - `"basic"`: decode only Exif, skipping XMP and IPTC.
+/// - `"lazy"`: decode nothing, but leave the undecoded blocks in the
+///   ImageSpec as `"oiio:RawExif"`, `"oiio:RawXMP"`, and `"oiio:RawIPTC"`
+///   byte arrays, to be turned into attributes later by
+///   `decode_raw_metadata()` if they turn out to be needed.
+/// - `"none"`: skip all of it.
+///
+/// The return value is always one of those four literal strings
+/// (unrecognized hints are treated as `"all"`).
+OIIO_API string_view metadata_hint (const ImageSpec& config);
+
+/// Decode and remove any `"oiio:RawExif"`, `"oiio:RawXMP"`, and
+/// `"oiio:RawIPTC"` blocks that a reader left in `spec` when opened with
+/// the `"oiio:metadata"` hint set to `"lazy"`. Return false if any of
+/// them was malformed.
+OIIO_API bool decode_raw_metadata (ImageSpec& spec);
+
+
 /// Find all the relevant metadata (IPTC, Exif, etc.) in spec and
 /// assemble it into an XMP XML string.  This is a utility function to
 /// make it easy for multiple format plugins to support embedding XMP
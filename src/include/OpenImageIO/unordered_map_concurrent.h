@@ -91,6 +91,11 @@ find_with_hash(Map& map, const Key& key, size_t /*hash*/)
 /// the first entry of the next bin, it will also release its current
 /// lock and obtain a lock on the next bin.
 ///
+/// When an insertion is about to make a large bin rehash, the bigger table
+/// is built from a copy while other threads can still read the bin, and the
+/// write lock is held only to swap it in, so that lookups don't stall for
+/// the length of the rehash.
+///
 
 template<class KEY, class VALUE, class HASH = std::hash<KEY>,
          class PRED = std::equal_to<KEY>, size_t BINS = 16,
@@ -352,8 +357,10 @@ public:
         iterator iret(this);
         iret.m_bin    = (unsigned)b;
         iret.m_locked = do_lock;
-        if (do_lock)
+        if (do_lock) {
+            grow_bin(bin);
             bin.lock();
+        }
         iret.m_biniterator = find_with_hash(bin.map, key, hash);
         if (iret.m_biniterator == bin.map.end()) {
             // Not found in the map, insert it
@@ -402,8 +409,10 @@ public:
         size_t hash = m_hash(key);
         size_t b    = whichbin(hash);
         Bin& bin(m_bins[b]);
-        if (do_lock)
+        if (do_lock) {
+            grow_bin(bin);
             bin.lock();
+        }
         auto result = bin.map.emplace(key, value);
         if (result.second) {
             // the insert was successful!
@@ -432,8 +441,10 @@ public:
         size_t hash = m_hash(key);
         size_t b    = whichbin(hash);
         Bin& bin(m_bins[b]);
-        if (do_lock)
+        if (do_lock) {
+            grow_bin(bin);
             bin.lock();
+        }
         auto result = bin.map.emplace(key, value);
         if (result.second) {
             // the insert was successful!
@@ -482,6 +493,40 @@ public:
     /// holds the lock).
     void unlock_bin(size_t bin) { m_bins[bin].unlock(); }
 
+    /// Return the number of bins the map is split into.
+    static constexpr size_t nbins() { return BINS; }
+
+    /// Return the bin number that the key will always appear in, without
+    /// locking anything.
+    size_t bin_of(const KEY& key) { return whichbin(m_hash(key)); }
+
+    /// Lock bin `b` for reading and call `func(const BinMap_t& map)` on its
+    /// underlying map, releasing the lock when it returns. This lets the
+    /// caller make many lookups in one bin for the price of one lock.
+    template<typename FUNC> void read_bin(size_t b, FUNC&& func) const
+    {
+        OIIO_DASSERT(b < BINS);
+        const Bin& bin(m_bins[b]);
+        bin.read_lock();
+        func((const BinMap_t&)bin.map);
+        bin.read_unlock();
+    }
+
+    /// Lock bin `b` and call `func(BinMap_t& map)` on its underlying map,
+    /// releasing the lock when it returns. The function is free to modify
+    /// the map (for example, to erase entries while walking it); the total
+    /// size of the unordered_map_concurrent is adjusted accordingly.
+    template<typename FUNC> void modify_bin(size_t b, FUNC&& func)
+    {
+        OIIO_DASSERT(b < BINS);
+        Bin& bin(m_bins[b]);
+        bin.lock();
+        size_t oldsize = bin.map.size();
+        func(bin.map);
+        m_size += int(bin.map.size()) - int(oldsize);
+        bin.unlock();
+    }
+
     // Return a mask that is 1 for bits of the hash that are not used to
     // determine the bin number.
     static constexpr size_t nobin_mask() { return ~size_t(0) >> log2(BINS); }
@@ -491,6 +536,9 @@ private:
         OIIO_CACHE_ALIGN                  // align bin to cache line
             mutable spin_rw_mutex mutex;  // mutex for this bin
         BinMap_t map;                     // hash map for this bin
+        mutable size_t version = 0;       // bumped by each write unlock
+        std::atomic<bool> growing { false };  // grow_bin in progress
+        mutable std::atomic<bool> full { false };  // grow_bin is due
 #ifndef NDEBUG
         mutable atomic_int m_nrlocks;  // for debugging
         mutable atomic_int m_nwlocks;  // for debugging
@@ -549,10 +597,69 @@ private:
                              (int)m_nrlocks, (int)m_nwlocks);
             --m_nwlocks;
 #endif
+            ++version;
+            // Note whether the next insertion would rehash a big map, so
+            // that grow_bin can tell whether it has work to do without
+            // taking a lock.
+            size_t n = map.size();
+            full.store(n >= min_offlock_grow
+                           && n + 1 > size_t(map.bucket_count()
+                                             * map.max_load_factor()),
+                       std::memory_order_relaxed);
             mutex.unlock();
         }
     };
 
+    // Bins at least this big are grown by grow_bin, outside the write
+    // lock; smaller ones are cheap enough to rehash in place.
+    static constexpr size_t min_offlock_grow = 256;
+
+    // If the next insertion into `bin` would make its map rehash, and the
+    // map is big enough for that to be a noticeable stall, build a bigger
+    // copy of it while holding only the read lock -- so lookups in the
+    // bin carry on meanwhile -- and then take the write lock just long
+    // enough to swap the copy in. A thread that finds another already
+    // growing the bin waits for it, rather than rehashing under the write
+    // lock itself. The copy is discarded if the bin was modified after it
+    // was taken.
+    void grow_bin(Bin& bin)
+    {
+        // Cheap early out for the usual case, so that inserts don't pay
+        // for an extra lock round trip. A stale answer only means that the
+        // bin rehashes in place, or that we check again under the lock.
+        if (!bin.full.load(std::memory_order_relaxed))
+            return;
+        atomic_backoff backoff;
+        for (;;) {
+            bin.read_lock();
+            size_t size = bin.map.size();
+            if (size < min_offlock_grow
+                || size + 1 <= size_t(bin.map.bucket_count()
+                                      * bin.map.max_load_factor())) {
+                bin.read_unlock();
+                return;
+            }
+            if (!bin.growing.exchange(true))
+                break;
+            bin.read_unlock();
+            backoff();
+        }
+        size_t version = bin.version;
+        BinMap_t bigger;
+        bigger.max_load_factor(bin.map.max_load_factor());
+        bigger.reserve(2 * bin.map.size());
+        for (auto& entry : bin.map)
+            bigger.insert(entry);
+        bin.read_unlock();
+        bin.lock();
+        if (bin.version == version)
+            bin.map.swap(bigger);
+        bin.unlock();
+        bin.growing = false;
+        // `bigger` now holds the old table, which is freed here, after the
+        // lock has been released.
+    }
+
     HASH m_hash;        // hashing function
     atomic_int m_size;  // total entries in all bins
     Bin m_bins[BINS];   // the bins
@@ -10,6 +10,7 @@
 #ifndef OPENIMAGEIO_IMAGEIO_PVT_H
 #define OPENIMAGEIO_IMAGEIO_PVT_H
 
+#include <OpenImageIO/function_view.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/thread.h>
 #include <OpenImageIO/timer.h>
@@ -33,6 +34,7 @@ extern atomic_int oiio_read_chunk;
 extern atomic_int oiio_try_all_readers;
 extern ustring font_searchpath;
 extern ustring plugin_searchpath;
+extern ustring plugin_manifest;
 extern std::string format_list;
 extern std::string input_format_list;
 extern std::string output_format_list;
@@ -40,17 +42,33 @@ extern std::string extension_list;
 extern std::string library_list;
 extern OIIO_UTIL_API int oiio_print_debug;
 extern int oiio_log_times;
+extern int oiio_trace;
 extern int openexr_core;
+extern int openexr_core_output;
 extern int limit_channels;
 extern int limit_imagesize_MB;
+extern int colorconvert_lut3d;
 extern int opencv_version;
 extern int imagebuf_print_uncaught_errors;
 extern int imagebuf_use_imagecache;
+extern int imagebuf_allocator;  // 0 heap, 1 pool, 2 pinned
+extern int imagebuf_pool_max_MB;
+extern int imagebuf_hugepages;
+extern int imagebuf_scanline_align;
+extern int imagebuf_read_threads;
+extern int imagebuf_write_threads;
+extern int imagebuf_write_max_MB;
+// Free pooled ImageBuf memory beyond imagebuf_pool_max_MB
+void
+imagebuf_pool_trim();
 extern atomic_ll IB_local_mem_current;
 extern atomic_ll IB_local_mem_peak;
 extern std::atomic<float> IB_total_open_time;
 extern std::atomic<float> IB_total_image_read_time;
 extern OIIO_UTIL_API int oiio_use_tbb;  // This lives in libOpenImageIO_Util
+// The "nested_parallelism" attribute: if nonzero, parallel loops started
+// from a thread pool worker may use the pool too. Also in the Util library.
+extern OIIO_UTIL_API int oiio_nested_parallelism;
 OIIO_API const std::vector<std::string>&
 font_dirs();
 OIIO_API const std::vector<std::string>&
@@ -114,6 +132,17 @@ const void*
 parallel_convert_from_float(const float* src, void* dst, size_t nvals,
                             TypeDesc format);
 
+/// Multiply (or, if `divide` is true, divide) by alpha the channels
+/// [chbegin,chend) of `npixels` pixels of `nchannels` contiguous values of
+/// type `format`, `xstride` bytes apart, leaving the alpha and z channels
+/// alone. Pixels with alpha 1 are never changed, nor are those with alpha
+/// 0 when dividing or when `preserve_alpha0` is true. This is the kernel
+/// shared by OIIO::premult() and ImageBufAlgo::premult/unpremult/repremult.
+OIIO_API void
+premult_span(TypeDesc format, void* data, int npixels, int nchannels,
+             stride_t xstride, int chbegin, int chend, int alpha_channel,
+             int z_channel, bool divide = false, bool preserve_alpha0 = false);
+
 /// Internal utility: Error checking on the spec -- if it contains texture-
 /// specific metadata but there are clues it's not actually a texture file
 /// written by maketx or `oiiotool -otex`, then assume these metadata are
@@ -122,6 +151,28 @@ parallel_convert_from_float(const float* src, void* dst, size_t nvals,
 OIIO_API bool
 check_texture_metadata_sanity(ImageSpec& spec);
 
+/// Internal utility: the number of threads that a codec library's own
+/// internal threading should use for one read or write. `requested` is the
+/// ImageInput's or ImageOutput's threads() value (0 means to use the global
+/// "threads" attribute). If we are already running on a worker thread of
+/// the default thread pool, the caller is itself one of many parallel
+/// jobs, so the answer is 1 to avoid oversubscribing the machine. It is
+/// also no more than the "thread_budget" has room for.
+OIIO_API int
+codec_threads(int requested = 0);
+
+/// Internal utility: an adaptor for codec libraries that let the caller
+/// supply a "parallel runner." Call `func(value, thread_id)` for every
+/// value in [begin, end), spread over at most `nthreads` threads of the
+/// default thread pool (the calling thread participates). Each thread_id
+/// is in [0, nthreads) and is never used by two threads at once, so the
+/// codec may use it to index per-thread scratch memory. If called from
+/// within a pool worker, it runs serially as thread 0. It runs as an OIIO
+/// parallel loop, so the thread budget and any lent executor apply.
+OIIO_API void
+codec_parallel_run(uint32_t begin, uint32_t end, int nthreads,
+                   function_view<void(uint32_t value, int thread_id)> func);
+
 /// Internal function to log time recorded by an OIIO::timer(). It will only
 /// trigger a read of the time if the "log_times" attribute is set or the
 /// OPENIMAGEIO_LOG_TIMES env variable is set.
@@ -132,20 +183,58 @@ log_time(string_view key, const Timer& timer, int count = 1);
 OIIO_API std::string
 timing_report();
 
+/// Internal function returning the clock that trace spans are measured
+/// on, in ns.
+OIIO_API int64_t
+trace_clock();
+
+/// Internal function to record a trace span called `name` that began at
+/// `begin` (a trace_clock() time) and ends now. Only call it if oiio_trace
+/// is nonzero.
+OIIO_API void
+trace_span(string_view name, int64_t begin);
+
+/// An object that, if tracing is enabled (oiio_trace is nonzero), records
+/// a trace span from its construction until its destruction. If tracing
+/// is disabled, it does nothing. The name must outlive the object, which
+/// it does if it's a string literal.
+class TraceScope {
+public:
+    TraceScope(string_view name)
+        : m_name(name)
+        , m_begin(oiio_trace ? trace_clock() : 0)
+    {
+    }
+    ~TraceScope()
+    {
+        if (m_begin)
+            trace_span(m_name, m_begin);
+    }
+
+private:
+    string_view m_name;
+    int64_t m_begin;
+};
+
 /// An object that, if oiio_log_times is nonzero, logs time until its
-/// destruction. If oiio_log_times is 0, it does nothing.
+/// destruction. If oiio_log_times is 0, it does nothing. It also records
+/// a trace span, like a TraceScope, if tracing is enabled.
 class LoggedTimer {
 public:
     LoggedTimer(string_view name)
         : m_timer(oiio_log_times)
     {
-        if (oiio_log_times)
+        if (oiio_log_times || oiio_trace)
             m_name = name;
+        if (oiio_trace)
+            m_trace_begin = trace_clock();
     }
     ~LoggedTimer()
     {
         if (oiio_log_times)
             log_time(m_name, m_timer, m_count);
+        if (m_trace_begin)
+            trace_span(m_name, m_trace_begin);
     }
     // Stop the timer. An optional count_offset will be added to the
     // "invocations count" of the underlying timer, if a single invocation
@@ -161,7 +250,8 @@ public:
 private:
     Timer m_timer;
     std::string m_name;
-    int m_count = 1;
+    int m_count           = 1;
+    int64_t m_trace_begin = 0;
 };
 
 
@@ -211,6 +301,7 @@ struct print_info_options {
     bool sum                = false;
     bool subimages          = false;
     bool compute_sha1       = false;
+    std::string hashtype    = "sha1";
     bool compute_stats      = false;
     bool dumpdata           = false;
     bool dumpdata_showempty = true;
@@ -226,6 +317,9 @@ struct print_info_options {
 
 OIIO_API std::string
 compute_sha1(ImageInput* input, int subimage, int miplevel, std::string& err);
+OIIO_API std::string
+compute_pixel_hash(ImageInput* input, int subimage, int miplevel,
+                   string_view hashtype, std::string& err);
 OIIO_API bool
 print_stats(std::ostream& out, string_view indent, const ImageBuf& input,
             const ImageSpec& spec, ROI roi, std::string& err);
@@ -0,0 +1,45 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+/// \file
+/// Layout of the TextureSystem "capture" file, shared by the TextureSystem
+/// that writes it and by testtex, which replays it.
+
+
+#ifndef OPENIMAGEIO_TEXTURECAPTURE_PVT_H
+#define OPENIMAGEIO_TEXTURECAPTURE_PVT_H
+
+#include <cstdint>
+
+#include <OpenImageIO/oiioversion.h>
+
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+/// Magic number that begins a capture file.
+constexpr char texture_capture_magic[9] = "OIIOTXC1";
+
+/// One lookup in a capture file, following a 'T' tag. The file format is
+/// documented with the "capture" attribute in texture.h, so don't
+/// rearrange this.
+struct TextureCaptureRecord {
+    uint32_t filename;     // string index
+    int32_t subimagename;  // string index, or -1 if none
+    int32_t subimage, firstchannel, nchannels;
+    int32_t swrap, twrap, mipmode, interpmode;
+    int32_t anisotropic, conservative_filter, colortransformid;
+    float s, t, dsdx, dtdx, dsdy, dtdy;
+    float sblur, tblur, swidth, twidth, fill, rnd;
+};
+static_assert(sizeof(TextureCaptureRecord) == 96, "capture format changed");
+
+}  // namespace pvt
+
+OIIO_NAMESPACE_END
+
+#endif  // OPENIMAGEIO_TEXTURECAPTURE_PVT_H
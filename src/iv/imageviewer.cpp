@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: BSD-3-Clause and Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #ifndef _WIN32
@@ -103,6 +104,7 @@ ImageViewer::ImageViewer(bool use_ocio, const std::string& image_color_space,
     : infoWindow(NULL)
     , preferenceWindow(NULL)
     , darkPaletteBox(NULL)
+    , maxMemoryTex(NULL)
     , m_current_image(-1)
     , m_current_channel(0)
     , m_color_mode(RGBA)
@@ -139,6 +141,12 @@ ImageViewer::ImageViewer(bool use_ocio, const std::string& image_color_space,
     slideDuration_ms = 5000;
     slide_loop       = true;
 
+    playTimer = new QTimer();
+    playTimer->setTimerType(Qt::PreciseTimer);
+    connect(playTimer, SIGNAL(timeout()), this, SLOT(playFrame()));
+    play_direction = 0;
+    play_fps       = 0;
+
 #ifdef HAS_OCIO_2
     glwin = new IvGL_OCIO(this, *this);
 #else
@@ -167,6 +175,7 @@ ImageViewer::ImageViewer(bool use_ocio, const std::string& image_color_space,
 
 ImageViewer::~ImageViewer()
 {
+    glwin->finish_fetches();
     for (auto i : m_images)
         delete i;
 }
@@ -404,6 +413,18 @@ ImageViewer::createActions()
     slideNoLoopAct->setCheckable(true);
     connect(slideNoLoopAct, SIGNAL(triggered()), this, SLOT(slideNoLoop()));
 
+    playForwardAct = new QAction(tr("Play Forward"), this);
+    playForwardAct->setShortcut(tr("Ctrl+Right"));
+    connect(playForwardAct, SIGNAL(triggered()), this, SLOT(playForward()));
+
+    playBackwardAct = new QAction(tr("Play Backward"), this);
+    playBackwardAct->setShortcut(tr("Ctrl+Left"));
+    connect(playBackwardAct, SIGNAL(triggered()), this, SLOT(playBackward()));
+
+    stopPlaybackAct = new QAction(tr("Stop Playback"), this);
+    stopPlaybackAct->setShortcut(tr("Ctrl+Down"));
+    connect(stopPlaybackAct, SIGNAL(triggered()), this, SLOT(stopPlayback()));
+
     sortByNameAct = new QAction(tr("By Name"), this);
     connect(sortByNameAct, SIGNAL(triggered()), this, SLOT(sortByName()));
 
@@ -452,6 +473,12 @@ ImageViewer::createActions()
     maxMemoryIC->setSingleStep(64);
     maxMemoryIC->setSuffix(" MB");
 
+    maxMemoryTexLabel = new QLabel(tr("GPU texture memory"));
+    maxMemoryTex      = new QSpinBox();
+    maxMemoryTex->setRange(64, 16384);
+    maxMemoryTex->setSingleStep(64);
+    maxMemoryTex->setSuffix(" MB");
+
     slideShowDurationLabel = new QLabel(tr("Slide Show delay"));
     slideShowDuration      = new QSpinBox();
     slideShowDuration->setRange(1, 3600);
@@ -460,6 +487,18 @@ ImageViewer::createActions()
     slideShowDuration->setAccelerated(true);
     connect(slideShowDuration, SIGNAL(valueChanged(int)), this,
             SLOT(setSlideShowDuration(int)));
+
+    playbackFpsLabel = new QLabel(tr("Playback rate"));
+    playbackFps      = new QSpinBox();
+    playbackFps->setRange(1, 120);
+    playbackFps->setSuffix(" fps");
+    connect(playbackFps, SIGNAL(valueChanged(int)), this,
+            SLOT(setPlaybackFps(int)));
+
+    readAheadLabel = new QLabel(tr("Playback read-ahead"));
+    readAhead      = new QSpinBox();
+    readAhead->setRange(0, 256);
+    readAhead->setSuffix(" frames");
 }
 
 #ifdef HAS_OCIO_2
@@ -581,7 +620,9 @@ ImageViewer::useOCIOAction(bool checked)
     ocioColorSpacesMenu->setEnabled(m_useOCIO);
     ocioDisplaysMenu->setEnabled(m_useOCIO);
 
-    displayCurrentImage();
+    // The OCIO transform is applied entirely in the shader, which is rebuilt
+    // on the next paint, so there is no need to re-upload the textures.
+    displayCurrentImage(false);
 }
 
 void
@@ -590,7 +631,7 @@ ImageViewer::ocioColorSpaceAction()
     QAction* action = ocioColorSpacesGroup->checkedAction();
     if (action) {
         m_ocioColourSpace = action->text().toStdString();
-        displayCurrentImage();
+        displayCurrentImage(false);
     }
 }
 
@@ -602,7 +643,7 @@ ImageViewer::ocioDisplayViewAction()
         QMenu* menu   = qobject_cast<QMenu*>(action->parent());
         m_ocioDisplay = menu->title().toStdString();
         m_ocioView    = action->text().toStdString();
-        displayCurrentImage();
+        displayCurrentImage(false);
     }
 }
 
@@ -653,6 +694,11 @@ ImageViewer::createMenus()
     slideMenu->addAction(slideLoopAct);
     slideMenu->addAction(slideNoLoopAct);
 
+    playMenu = new QMenu(tr("Playback"));
+    playMenu->addAction(playForwardAct);
+    playMenu->addAction(playBackwardAct);
+    playMenu->addAction(stopPlaybackAct);
+
     sortMenu = new QMenu(tr("Sort"));
     sortMenu->addAction(sortByNameAct);
     sortMenu->addAction(sortByPathAct);
@@ -709,6 +755,7 @@ ImageViewer::createMenus()
     toolsMenu->addAction(showInfoWindowAct);
     toolsMenu->addAction(showPixelviewWindowAct);
     toolsMenu->addMenu(slideMenu);
+    toolsMenu->addMenu(playMenu);
     toolsMenu->addMenu(sortMenu);
 
     // Menus, toolbars, & status
@@ -795,8 +842,11 @@ ImageViewer::readSettings(bool ui_is_set_up)
         maxMemoryIC->setValue(settings.value("maxMemoryIC", 512).toInt());
     else
         maxMemoryIC->setValue(settings.value("maxMemoryIC", 2048).toInt());
+    maxMemoryTex->setValue(settings.value("maxMemoryTex", 1024).toInt());
     slideShowDuration->setValue(
         settings.value("slideShowDuration", 10).toInt());
+    playbackFps->setValue(settings.value("playbackFps", 24).toInt());
+    readAhead->setValue(settings.value("readAhead", 16).toInt());
 
     ImageCache* imagecache = ImageCache::create(true);
     imagecache->attribute("automip", autoMipmap->isChecked());
@@ -816,7 +866,10 @@ ImageViewer::writeSettings()
     settings.setValue("darkPalette", darkPaletteBox->isChecked());
     settings.setValue("autoMipmap", autoMipmap->isChecked());
     settings.setValue("maxMemoryIC", maxMemoryIC->value());
+    settings.setValue("maxMemoryTex", maxMemoryTex->value());
     settings.setValue("slideShowDuration", slideShowDuration->value());
+    settings.setValue("playbackFps", playbackFps->value());
+    settings.setValue("readAhead", readAhead->value());
     QStringList recent;
     for (auto&& s : m_recent_files)
         recent.push_front(QString(s.c_str()));
@@ -941,6 +994,7 @@ ImageViewer::reload()
     if (m_images.empty())
         return;
     IvImage* newimage = m_images[m_current_image];
+    glwin->finish_fetches();
     newimage->invalidate();
     //glwin->trigger_redraw ();
     displayCurrentImage();
@@ -1136,6 +1190,19 @@ ImageViewer::updateStatusBar()
         message += Strutil::fmt::format("  MIP {}/{}", cur()->miplevel() + 1,
                                         cur()->nmiplevels());
     }
+    if (play_direction) {
+        // Achieved rate, frames queued ahead, and how full the cache is.
+        ImageCache* imagecache = ImageCache::create(true);
+        int64_t used           = 0;
+        float max_memory_MB    = 1;
+        imagecache->getattribute("stat:cache_memory_used", TypeInt64, &used);
+        imagecache->getattribute("max_memory_MB", max_memory_MB);
+        int ahead = (int)std::count(play_prefetched.begin(),
+                                    play_prefetched.end(), true);
+        message += Strutil::fmt::format(
+            "  play {:.1f} fps  ahead {}  cache {:.0f}%", play_fps, ahead,
+            100.0 * double(used) / (double(max_memory_MB) * 1048576.0));
+    }
 
     statusViewInfo->setText(message.c_str());  // tr("iv status"));
 }
@@ -1150,6 +1217,8 @@ ImageViewer::loadCurrentImage(int subimage, int miplevel)
     }
     IvImage* img = cur();
     if (img) {
+        // Don't change the image under any background reads of it.
+        glwin->finish_fetches();
         // We need the spec available to compare the image format with
         // opengl's capabilities.
         if (!img->init_spec(img->name(), subimage, miplevel)) {
@@ -1504,17 +1573,9 @@ ImageViewer::viewChannel(int c, COLOR_MODE colormode)
                 img->pixel_transform(srgb_transform, (int)colormode, c);
             }
         } else {
-            // FIXME: There are even more chances to avoid updating the textures
-            // if we can keep trac of which channels are in the texture.
-            if (m_current_channel == c) {
-                if (m_color_mode == SINGLE_CHANNEL || m_color_mode == HEATMAP) {
-                    if (colormode == HEATMAP || colormode == SINGLE_CHANNEL)
-                        update = false;
-                } else if (m_color_mode == RGB || m_color_mode == LUMINANCE) {
-                    if (colormode == RGB || colormode == LUMINANCE)
-                        update = false;
-                }
-            }
+            // The textures hold a window of channels around the current
+            // one; only switching outside of it needs a re-upload.
+            update = !glwin->channels_resident(c, colormode);
         }
         m_current_channel = c;
         m_color_mode      = colormode;
@@ -1594,6 +1655,124 @@ ImageViewer::setSlideShowDuration(int seconds)
 
 
 
+void
+ImageViewer::playForward()
+{
+    startPlayback(1);
+}
+
+
+
+void
+ImageViewer::playBackward()
+{
+    startPlayback(-1);
+}
+
+
+
+void
+ImageViewer::startPlayback(int direction)
+{
+    if (m_images.size() < 2)
+        return;
+    play_direction = direction;
+    play_fps       = 0;
+    play_prefetched.assign(m_images.size(), false);
+    play_clock.reset();
+    play_clock.start();
+    prefetchFrames();
+    playTimer->start(1000 / playbackFps->value());
+}
+
+
+
+void
+ImageViewer::stopPlayback()
+{
+    playTimer->stop();
+    play_direction = 0;
+    updateStatusBar();
+}
+
+
+
+void
+ImageViewer::setPlaybackFps(int fps)
+{
+    if (playTimer->isActive())
+        playTimer->setInterval(1000 / fps);
+}
+
+
+
+void
+ImageViewer::playFrame()
+{
+    int n = (int)m_images.size();
+    if (n < 2 || !play_direction) {
+        stopPlayback();
+        return;
+    }
+    if (play_prefetched.size() != m_images.size())
+        play_prefetched.assign(m_images.size(), false);
+
+    // Time from the last frame shown, smoothed a little so that the
+    // status bar is readable.
+    play_fps = smoothed_fps(play_fps, play_clock.lap());
+
+    // Loading may process events (for the progress bar), which must not
+    // start the next frame inside this one, so hold the timer meanwhile
+    // and then aim the next frame for its proper time.
+    Timer frame_time;
+    playTimer->stop();
+    int frame = play_frame(m_current_image, 1, play_direction, n);
+    // Shown frames age out of the cache; the next loop fetches them anew.
+    play_prefetched[frame] = false;
+    current_image(frame);
+    prefetchFrames();
+    if (play_direction)
+        playTimer->start(std::max(0, 1000 / playbackFps->value()
+                                         - int(frame_time() * 1000.0)));
+}
+
+
+
+void
+ImageViewer::prefetchFrames()
+{
+    // Queue reads of the next frames in the play direction, as many as the
+    // read-ahead preference asks for and no more than fit in half of the
+    // ImageCache, leaving the rest for the frame on screen. The reads run
+    // on the thread pool; the frames' display tile reads then hit (or wait
+    // for) the cache.
+    ImageCache* imagecache = ImageCache::create(true);
+    float max_memory_MB    = 0;
+    imagecache->getattribute("max_memory_MB", max_memory_MB);
+    int64_t budget = int64_t(max_memory_MB * 1048576.0f) / 2;
+    int64_t used   = 0;
+    int n          = (int)m_images.size();
+    int ahead      = std::min(readAhead->value(), n - 1);
+    for (int i = 1; i <= ahead; ++i) {
+        int frame    = play_frame(m_current_image, i, play_direction, n);
+        IvImage* img = m_images[frame];
+        ustring name(img->name());
+        int subimage = std::max(0, img->subimage());
+        ImageSpec spec;
+        if (!imagecache->get_imagespec(name, spec, subimage))
+            break;
+        used += int64_t(spec.image_bytes());
+        if (used > budget)
+            break;
+        if (!play_prefetched[frame])
+            play_prefetched[frame] = imagecache->prefetch(name, subimage, 0);
+    }
+    // An unreadable frame reports its own error when it is shown.
+    imagecache->geterror();
+}
+
+
+
 static bool
 compName(IvImage* first, IvImage* second)
 {
@@ -1966,6 +2145,7 @@ ImageViewer::closeImg()
 {
     if (m_images.empty())
         return;
+    glwin->finish_fetches();
     delete m_images[m_current_image];
     m_images[m_current_image] = NULL;
     m_images.erase(m_images.begin() + m_current_image);
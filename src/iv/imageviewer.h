@@ -38,6 +38,7 @@
 
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/timer.h>
 
 #include "ivgl_ocio.h"
 
@@ -234,6 +235,12 @@ public:
         return linearInterpolationBox && linearInterpolationBox->isChecked();
     }
 
+    /// How much GPU memory (in MB) may be used for image textures?
+    int textureMemoryMB(void) const
+    {
+        return maxMemoryTex ? maxMemoryTex->value() : 1024;
+    }
+
     bool darkPalette(void) const
     {
         return darkPaletteBox ? darkPaletteBox->isChecked() : m_darkPalette;
@@ -306,6 +313,11 @@ private slots:
     void setSlideShowDuration(
         int seconds);            ///< Set the slide show duration in seconds
     void slideImages();          ///< Slide show - move to next image
+    void playForward();          ///< Play the images as a sequence
+    void playBackward();         ///< Play the images in reverse
+    void stopPlayback();         ///< Stop playing the sequence
+    void setPlaybackFps(int);    ///< Set the playback rate in fps
+    void playFrame();            ///< Playback - show the next frame
     void showInfoWindow();       ///< View extended info on image
     void showPixelviewWindow();  ///< View closeup pixel view
     void editPreferences();      ///< Edit viewer preferences
@@ -334,11 +346,23 @@ private:
     void keyPressEvent(QKeyEvent* event) override;
     void resizeEvent(QResizeEvent* event) override;
     void closeEvent(QCloseEvent* event) override;
+    /// Start playing the images as a sequence in the given direction
+    /// (1 forward, -1 backward).
+    void startPlayback(int direction);
+    /// Queue background reads, into the ImageCache, of the frames about
+    /// to be played.
+    void prefetchFrames();
 
     QTimer* slideTimer;     ///< Timer to use for slide show mode
     long slideDuration_ms;  ///< Slide show mode duration (in ms)
     bool slide_loop;        ///< Do we loop when in slide mode?
 
+    QTimer* playTimer;   ///< Timer to use for playback
+    int play_direction;  ///< 1 forward, -1 backward, 0 not playing
+    Timer play_clock;    ///< Time since the last frame was played
+    double play_fps;     ///< Achieved playback rate
+    std::vector<bool> play_prefetched;  ///< Frames queued for read-ahead
+
     IvGL* glwin;
     IvInfoWindow* infoWindow;
     IvPreferenceWindow* preferenceWindow;
@@ -375,6 +399,7 @@ private:
     QAction *sortByNameAct, *sortByPathAct, *sortReverseAct;
     QAction *sortByImageDateAct, *sortByFileDateAct;
     QAction *slideShowAct, *slideLoopAct, *slideNoLoopAct;
+    QAction *playForwardAct, *playBackwardAct, *stopPlaybackAct;
     QAction* showInfoWindowAct;
     QAction* editPreferencesAct;
     QAction* showPixelviewWindowAct;
@@ -382,6 +407,7 @@ private:
         *helpMenu;
     QMenu* openRecentMenu;
     QMenu *expgamMenu, *channelMenu, *colormodeMenu, *slideMenu, *sortMenu;
+    QMenu* playMenu;
     QLabel *statusImgInfo, *statusViewInfo;
     QProgressBar* statusProgress;
     QComboBox* mouseModeComboBox;
@@ -398,8 +424,14 @@ private:
     QCheckBox* autoMipmap;
     QLabel* maxMemoryICLabel;
     QSpinBox* maxMemoryIC;
+    QLabel* maxMemoryTexLabel;
+    QSpinBox* maxMemoryTex;
     QLabel* slideShowDurationLabel;
     QSpinBox* slideShowDuration;
+    QLabel* playbackFpsLabel;
+    QSpinBox* playbackFps;
+    QLabel* readAheadLabel;
+    QSpinBox* readAhead;
 
     std::vector<IvImage*> m_images;  // List of images
     int m_current_image;             // Index of current image, -1 if none
@@ -5,6 +5,7 @@
 #include "ivgl.h"
 #include "imageviewer.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include <QComboBox>
@@ -18,6 +19,7 @@
 
 #include "ivutils.h"
 #include <OpenImageIO/strutil.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/timer.h>
 
 OIIO_PRAGMA_WARNING_PUSH
@@ -60,8 +62,15 @@ IvGL::IvGL(QWidget* parent, ImageViewer& viewer)
     , m_texture_height(1)
     , m_last_pbo_used(0)
     , m_current_image(NULL)
+    , m_tex_chbegin(0)
+    , m_tex_nchannels(0)
     , m_pixelview_left_corner(true)
-    , m_last_texbuf_used(0)
+    , m_paint_count(0)
+    , m_proxy_tex(0)
+    , m_proxy_width(0)
+    , m_proxy_height(0)
+    , m_proxy_texwidth(1)
+    , m_proxy_texheight(1)
 {
 #if 0
     QGLFormat format;
@@ -79,7 +88,7 @@ IvGL::IvGL(QWidget* parent, ImageViewer& viewer)
 
 
 
-IvGL::~IvGL() {}
+IvGL::~IvGL() { finish_fetches(); }
 
 
 
@@ -133,35 +142,8 @@ IvGL::create_textures(void)
     if (m_tex_created)
         return;
 
-    // FIXME: Determine this dynamically.
-    const int total_texbufs = 4;
-    GLuint textures[total_texbufs];
-
-    glGenTextures(total_texbufs, textures);
-
-    // Initialize texture objects
-    for (unsigned int texture : textures) {
-        m_texbufs.emplace_back();
-        glBindTexture(GL_TEXTURE_2D, texture);
-        print_error("bind tex");
-        glTexImage2D(GL_TEXTURE_2D, 0 /*mip level*/,
-                     4 /*internal format - color components */, 1 /*width*/,
-                     1 /*height*/, 0 /*border width*/,
-                     GL_RGBA /*type - GL_RGB, GL_RGBA, GL_LUMINANCE */,
-                     GL_FLOAT /*format - GL_FLOAT */, NULL /*data*/);
-        print_error("tex image 2d");
-        // Initialize tex parameters.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-        print_error("After tex parameters");
-        m_texbufs.back().tex_object = texture;
-        m_texbufs.back().x          = 0;
-        m_texbufs.back().y          = 0;
-        m_texbufs.back().width      = 0;
-        m_texbufs.back().height     = 0;
-    }
+    // update() sizes the pool to the image; start with a few.
+    resize_texbufs(4);
 
     // Create another texture for the pixelview.
     glGenTextures(1, &m_pixelview_tex);
@@ -173,6 +155,15 @@ IvGL::create_textures(void)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
+    // And one for the low-resolution proxy.
+    glGenTextures(1, &m_proxy_tex);
+    glBindTexture(GL_TEXTURE_2D, m_proxy_tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, 4, 1, 1, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
     glGenBuffers(2, m_pbo_objects);
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo_objects[0]);
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo_objects[1]);
@@ -181,6 +172,36 @@ IvGL::create_textures(void)
     m_tex_created = true;
 }
 
+
+
+void
+IvGL::resize_texbufs(size_t n)
+{
+    while (m_texbufs.size() > n) {
+        glDeleteTextures(1, &m_texbufs.back().tex_object);
+        m_texbufs.pop_back();
+    }
+    while (m_texbufs.size() < n) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        print_error("bind tex");
+        glTexImage2D(GL_TEXTURE_2D, 0 /*mip level*/,
+                     4 /*internal format - color components */, 1 /*width*/,
+                     1 /*height*/, 0 /*border width*/,
+                     GL_RGBA /*type - GL_RGB, GL_RGBA, GL_LUMINANCE */,
+                     GL_FLOAT /*format - GL_FLOAT */, NULL /*data*/);
+        print_error("tex image 2d");
+        // Initialize tex parameters.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        print_error("After tex parameters");
+        m_texbufs.push_back(TexBuffer { texture, 0, 0, 0, 0, 0, 0 });
+    }
+}
+
 const char*
 IvGL::color_func_shader_text()
 {
@@ -257,46 +278,65 @@ IvGL::create_shaders(void)
         "varying vec2 vTexCoord;\n"
         "uniform int startchannel;\n"
         "uniform int colormode;\n"
-        // Remember, if imgchannels == 2, second channel would be channel 4 (a).
         "uniform int imgchannels;\n"
+        // The texture holds channels [texchbegin, texchbegin+texchannels).
+        // Remember, if texchannels == 2, the second would be in a.
+        "uniform int texchbegin;\n"
+        "uniform int texchannels;\n"
         "uniform int pixelview;\n"
         "uniform int linearinterp;\n"
         "uniform int width;\n"
         "uniform int height;\n"
+        "float channel (vec4 C, int c)\n"
+        "{\n"
+        "    c -= texchbegin;\n"
+        "    if (c < 0 || c >= texchannels)\n"
+        "        return 0.0;\n"
+        "    if (c == 0)\n"
+        "        return C.r;\n"
+        "    if (c == 1 && texchannels != 2)\n"
+        "        return C.g;\n"
+        "    if (c == 2)\n"
+        "        return C.b;\n"
+        "    return C.a;\n"
+        "}\n"
         "vec4 rgba_mode (vec4 C)\n"
         "{\n"
-        "    if (imgchannels <= 2) {\n"
-        "        if (startchannel == 1)\n"
-        "           return vec4(C.aaa, 1.0);\n"
-        "        return C.rrra;\n"
-        "    }\n"
-        "    return C;\n"
+        "    int n = imgchannels - startchannel;\n"
+        "    float x = channel (C, startchannel);\n"
+        "    if (n == 1)\n"
+        "        return vec4 (x, x, x, 1.0);\n"
+        "    if (n == 2)\n"
+        "        return vec4 (x, x, x, channel (C, startchannel+1));\n"
+        "    return vec4 (x, channel (C, startchannel+1),\n"
+        "                 channel (C, startchannel+2),\n"
+        "                 n > 3 ? channel (C, startchannel+3) : 1.0);\n"
         "}\n"
         "vec4 rgb_mode (vec4 C)\n"
         "{\n"
-        "    if (imgchannels <= 2) {\n"
-        "        if (startchannel == 1)\n"
-        "           return vec4(C.aaa, 1.0);\n"
-        "        return vec4 (C.rrr, 1.0);\n"
-        "    }\n"
-        "    float C2[4];\n"
-        "    C2[0]=C.x; C2[1]=C.y; C2[2]=C.z; C2[3]=C.w;\n"
-        "    return vec4 (C2[startchannel], C2[startchannel+1], C2[startchannel+2], 1.0);\n"
+        "    float x = channel (C, startchannel);\n"
+        "    if (imgchannels - startchannel < 3)\n"
+        "        return vec4 (x, x, x, 1.0);\n"
+        "    return vec4 (x, channel (C, startchannel+1),\n"
+        "                 channel (C, startchannel+2), 1.0);\n"
         "}\n"
         "vec4 singlechannel_mode (vec4 C)\n"
         "{\n"
-        "    float C2[4];\n"
-        "    C2[0]=C.x; C2[1]=C.y; C2[2]=C.z; C2[3]=C.w;\n"
-        "    if (startchannel > imgchannels)\n"
-        "        return vec4 (0.0,0.0,0.0,1.0);\n"
-        "    return vec4 (C2[startchannel], C2[startchannel], C2[startchannel], 1.0);\n"
+        "    float x = channel (C, startchannel);\n"
+        "    return vec4 (x, x, x, 1.0);\n"
         "}\n"
         "vec4 luminance_mode (vec4 C)\n"
         "{\n"
-        "    if (imgchannels <= 2)\n"
-        "        return vec4 (C.rrr, C.a);\n"
-        "    float lum = dot (C.rgb, vec3(0.2126, 0.7152, 0.0722));\n"
-        "    return vec4 (lum, lum, lum, C.a);\n"
+        "    int n = imgchannels - startchannel;\n"
+        "    float x = channel (C, startchannel);\n"
+        "    if (n == 1)\n"
+        "        return vec4 (x, x, x, 1.0);\n"
+        "    if (n == 2)\n"
+        "        return vec4 (x, x, x, channel (C, startchannel+1));\n"
+        "    vec3 rgb = vec3 (x, channel (C, startchannel+1),\n"
+        "                     channel (C, startchannel+2));\n"
+        "    float lum = dot (rgb, vec3(0.2126, 0.7152, 0.0722));\n"
+        "    return vec4 (lum, lum, lum, 1.0);\n"
         "}\n"
         "float heat_red(float x)\n"
         "{\n"
@@ -310,12 +350,8 @@ IvGL::create_shaders(void)
         "}\n"
         "vec4 heatmap_mode (vec4 C)\n"
         "{\n"
-        "    float C2[4];\n"
-        "    C2[0]=C.x; C2[1]=C.y; C2[2]=C.z; C2[3]=C.w;\n"
-        "    return vec4(heat_red(C2[startchannel]),\n"
-        "                heat_green(C2[startchannel]),\n"
-        "                heat_red(1.0-C2[startchannel]),\n"
-        "                1.0);\n"
+        "    float x = channel (C, startchannel);\n"
+        "    return vec4(heat_red(x), heat_green(x), heat_red(1.0-x), 1.0);\n"
         "}\n"
         "void main ()\n"
         "{\n"
@@ -547,6 +583,7 @@ IvGL::paintGL()
     IvImage* img = m_current_image;
     if (!img || !img->image_valid())
         return;
+    ++m_paint_count;
 
     const ImageSpec& spec(img->spec());
     float z = m_zoom;
@@ -592,15 +629,28 @@ IvGL::paintGL()
         std::swap(wincenterx, wincentery);
     }
 
+    // Draw from the MIP level that best matches the zoom, so that a
+    // zoomed-out view neither reads nor uploads full resolution pixels.
+    int level = zoom_miplevel(m_zoom, int(m_levels.size()));
+    const ImageSpec& lspec(level_image(level).spec());
+    // Level pixels per image pixel
+    float sx = float(lspec.width) / float(spec.width);
+    float sy = float(lspec.height) / float(spec.height);
+
+    // The visible part of the level, rounded out to whole texture tiles.
     int xbegin = (int)floor(real_centerx) - wincenterx;
-    xbegin     = std::max(spec.x, xbegin - (xbegin % m_texture_width));
+    xbegin     = lspec.x + (int)floorf((xbegin - spec.x) * sx);
+    xbegin     = std::max(lspec.x, xbegin - (xbegin % m_texture_width));
     int ybegin = (int)floor(real_centery) - wincentery;
-    ybegin     = std::max(spec.y, ybegin - (ybegin % m_texture_height));
+    ybegin     = lspec.y + (int)floorf((ybegin - spec.y) * sy);
+    ybegin     = std::max(lspec.y, ybegin - (ybegin % m_texture_height));
     int xend   = (int)floor(real_centerx) + wincenterx;
-    xend       = std::min(spec.x + spec.width,
+    xend       = lspec.x + (int)ceilf((xend - spec.x) * sx);
+    xend       = std::min(lspec.x + lspec.width,
                           xend + m_texture_width - (xend % m_texture_width));
     int yend   = (int)floor(real_centery) + wincentery;
-    yend       = std::min(spec.y + spec.height,
+    yend       = lspec.y + (int)ceilf((yend - spec.y) * sy);
+    yend       = std::min(lspec.y + lspec.height,
                           yend + m_texture_height - (yend % m_texture_height));
     //std::cerr << "(" << xbegin << ',' << ybegin << ") - (" << xend << ',' << yend << ")\n";
 
@@ -608,26 +658,52 @@ IvGL::paintGL()
     m_viewer.statusViewInfo->hide();
     m_viewer.statusProgress->show();
 
-    // FIXME: change the code path so we can take full advantage of async DMA
-    // when using PBO.
+    // Tiles whose pixels have been read are uploaded and drawn. The rest
+    // are read in the background, which triggers another paint when each
+    // one is ready, and meanwhile the proxy (if any) is drawn in its place.
+    std::vector<std::shared_ptr<TileFetch>> wanted;
     for (int ystart = ybegin; ystart < yend; ystart += m_texture_height) {
         for (int xstart = xbegin; xstart < xend; xstart += m_texture_width) {
             int tile_width  = std::min(xend - xstart, m_texture_width);
             int tile_height = std::min(yend - ystart, m_texture_height);
-            smax            = tile_width / float(m_texture_width);
-            tmax            = tile_height / float(m_texture_height);
-
-            //std::cerr << "xstart: " << xstart << ". ystart: " << ystart << "\n";
-            //std::cerr << "tile_width: " << tile_width << ". tile_height: " << tile_height << "\n";
-
-            // FIXME: This can get too slow. Some ideas: avoid sending the tex
-            // images more than necessary, figure an optimum texture size, use
-            // multiple texture objects.
-            load_texture(xstart, ystart, tile_width, tile_height);
-            gl_rect(xstart, ystart, xstart + tile_width, ystart + tile_height,
-                    0, smin, tmin, smax, tmax);
+            // The tile's extent in image pixels
+            float x0 = spec.x + (xstart - lspec.x) / sx;
+            float y0 = spec.y + (ystart - lspec.y) / sy;
+            float x1 = spec.x + (xstart + tile_width - lspec.x) / sx;
+            float y1 = spec.y + (ystart + tile_height - lspec.y) / sy;
+            if (load_texture(level, xstart, ystart, tile_width, tile_height,
+                             wanted)) {
+                smax = tile_width / float(m_texture_width);
+                tmax = tile_height / float(m_texture_height);
+                gl_rect(x0, y0, x1, y1, 0, smin, tmin, smax, tmax);
+            } else if (m_proxy_width) {
+                // Texture coordinates per image pixel in the proxy
+                float ds = float(m_proxy_width)
+                           / (float(spec.width) * m_proxy_texwidth);
+                float dt = float(m_proxy_height)
+                           / (float(spec.height) * m_proxy_texheight);
+                glBindTexture(GL_TEXTURE_2D, m_proxy_tex);
+                useshader(m_proxy_texwidth, m_proxy_texheight);
+                gl_rect(x0, y0, x1, y1, 0, (x0 - spec.x) * ds,
+                        (y0 - spec.y) * dt, (x1 - spec.x) * ds,
+                        (y1 - spec.y) * dt);
+                useshader(m_texture_width, m_texture_height);
+            }
         }
     }
+    fetch_tiles(wanted);
+
+    // Forget the pixels of tiles that have left the view.
+    m_fetches.erase(std::remove_if(m_fetches.begin(), m_fetches.end(),
+                                   [=](const std::shared_ptr<TileFetch>& f) {
+                                       return f->ready
+                                              && (f->level != level
+                                                  || f->x < xbegin
+                                                  || f->x >= xend
+                                                  || f->y < ybegin
+                                                  || f->y >= yend);
+                                   }),
+                    m_fetches.end());
 
     glPopMatrix();
 
@@ -690,6 +766,19 @@ num_channels(int current_channel, int nchannels,
 
 
 
+bool
+IvGL::channels_resident(int channel, int colormode) const
+{
+    if (!m_use_shaders || !m_current_image
+        || m_current_image != m_viewer.cur())
+        return false;
+    int n = num_channels(channel, m_current_image->nchannels(),
+                         (ImageViewer::COLOR_MODE)colormode);
+    return channels_in_window(channel, n, m_tex_chbegin, m_tex_nchannels);
+}
+
+
+
 void
 IvGL::paint_pixelview()
 {
@@ -777,13 +866,8 @@ IvGL::paint_pixelview()
         //std::cerr << "tex (" << smin << "," << tmin << ") - (" << smax << "," << tmax << ")\n";
         //std::cerr << "center mouse (" << xp << "," << yp << "), real (" << real_xp << "," << real_yp << ")\n";
 
-        int nchannels = img->nchannels();
-        // For simplicity, we don't support more than 4 channels without shaders
-        // (yet).
-        if (m_use_shaders) {
-            nchannels = num_channels(m_viewer.current_channel(), nchannels,
-                                     m_viewer.current_color_mode());
-        }
+        // Match the layout of the main textures, set up by update().
+        int nchannels = m_use_shaders ? m_tex_nchannels : img->nchannels();
 
         void* zoombuffer = OIIO_ALLOCA(char, (xend - xbegin) * (yend - ybegin)
                                                  * nchannels
@@ -794,8 +878,8 @@ IvGL::paint_pixelview()
                             spec.format, zoombuffer);
         } else {
             ROI roi(spec.x + xbegin, spec.x + xend, spec.y + ybegin,
-                    spec.y + yend, 0, 1, m_viewer.current_channel(),
-                    m_viewer.current_channel() + nchannels);
+                    spec.y + yend, 0, 1, m_tex_chbegin,
+                    m_tex_chbegin + nchannels);
             img->get_pixels(roi, spec.format, zoombuffer);
         }
 
@@ -951,7 +1035,13 @@ IvGL::update_uniforms(int tex_width, int tex_height, bool pixelview)
         glUniform1i(loc, -1);
         return;
     }
-    glUniform1i(loc, 0);
+    glUniform1i(loc, m_viewer.current_channel());
+
+    loc = glGetUniformLocation(m_shader_program, "texchbegin");
+    glUniform1i(loc, m_tex_chbegin);
+
+    loc = glGetUniformLocation(m_shader_program, "texchannels");
+    glUniform1i(loc, m_tex_nchannels);
 
     loc = glGetUniformLocation(m_shader_program, "imgtex");
     // This is the texture unit, not the texture object
@@ -987,12 +1077,27 @@ IvGL::update_uniforms(int tex_width, int tex_height, bool pixelview)
 
 
 
+void
+IvGL::finish_fetches()
+{
+    for (auto& f : m_fetch_tasks)
+        f.wait();
+    m_fetch_tasks.clear();
+    m_fetches.clear();
+}
+
+
+
 void
 IvGL::update()
 {
     //std::cerr << "update image\n";
 
-    IvImage* img = m_viewer.cur();
+    finish_fetches();
+    m_levels.clear();
+    m_proxy_width  = 0;
+    m_proxy_height = 0;
+    IvImage* img   = m_viewer.cur();
     if (!img) {
         m_current_image = NULL;
         return;
@@ -1003,10 +1108,11 @@ IvGL::update()
     int nchannels = img->nchannels();
     // For simplicity, we don't support more than 4 channels without shaders
     // (yet).
-    if (m_use_shaders) {
-        nchannels = num_channels(m_viewer.current_channel(), nchannels,
-                                 m_viewer.current_color_mode());
-    }
+    m_tex_chbegin = 0;
+    if (m_use_shaders)
+        nchannels = texture_channels(m_viewer.current_channel(), nchannels,
+                                     m_tex_chbegin);
+    m_tex_nchannels = nchannels;
 
     if (!nchannels)
         return;  // Don't bother, the shader will show blackness for us.
@@ -1016,14 +1122,22 @@ IvGL::update()
     GLenum glinternalformat = GL_RGB;
     typespec_to_opengl(spec, nchannels, gltype, glformat, glinternalformat);
 
-    m_texture_width  = clamp(ceil2(spec.width), 1, m_max_texture_size);
-    m_texture_height = clamp(ceil2(spec.height), 1, m_max_texture_size);
+    int maxres       = std::min(int(m_max_texture_size), int(maxtileres));
+    m_texture_width  = clamp(ceil2(spec.width), 1, maxres);
+    m_texture_height = clamp(ceil2(spec.height), 1, maxres);
+
+    // Keep as many tile textures as fit in the texture memory budget.
+    size_t texbytes = size_t(m_texture_width) * size_t(m_texture_height)
+                      * size_t(nchannels) * spec.format.size();
+    size_t budget   = size_t(m_viewer.textureMemoryMB()) << 20;
+    resize_texbufs(texture_pool_size(texbytes, budget));
 
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
     for (auto&& tb : m_texbufs) {
-        tb.width  = 0;
-        tb.height = 0;
+        tb.width     = 0;
+        tb.height    = 0;
+        tb.last_used = 0;
         glBindTexture(GL_TEXTURE_2D, tb.tex_object);
         glTexImage2D(GL_TEXTURE_2D, 0 /*mip level*/, glinternalformat,
                      m_texture_width, m_texture_height, 0 /*border width*/,
@@ -1037,10 +1151,65 @@ IvGL::update()
                  closeuptexsize, 0, glformat, gltype, NULL);
     print_error("Setting up pixelview texture");
 
-    // Resize the buffer at once, rather than create one each drawing.
-    m_tex_buffer.resize(m_texture_width * m_texture_height * nchannels
-                        * spec.channel_bytes());
     m_current_image = img;
+    // Zoomed-out views are drawn from the MIP levels (when showing level
+    // 0 -- a level picked by the user is shown as is).
+    if (img->miplevel() == 0)
+        for (int m = 1; m < img->nmiplevels(); ++m)
+            m_levels.emplace_back(
+                new ImageBuf(img->name(), img->subimage(), m));
+    load_proxy();
+}
+
+
+
+const ImageBuf&
+IvGL::level_image(int level) const
+{
+    return level ? *m_levels[level - 1] : *m_current_image;
+}
+
+
+
+void
+IvGL::load_proxy()
+{
+    // Use the largest MIP level no bigger than proxy_res on a side: quick
+    // to read, but a reasonable stand-in at most zoom levels.
+    const int proxy_res   = 1024;
+    const ImageBuf* proxy = nullptr;
+    for (auto& lev : m_levels) {
+        if (proxy_fits(lev->spec().width, lev->spec().height, proxy_res)) {
+            proxy = lev.get();
+            break;
+        }
+    }
+    if (!proxy)
+        return;
+    const ImageSpec& pspec(proxy->spec());
+    const ImageSpec& spec(m_current_image->spec());
+    std::vector<unsigned char> pixels(pspec.image_pixels() * m_tex_nchannels
+                                      * spec.format.size());
+    if (!proxy->get_pixels(ROI(pspec.x, pspec.x + pspec.width, pspec.y,
+                               pspec.y + pspec.height, 0, 1, m_tex_chbegin,
+                               m_tex_chbegin + m_tex_nchannels),
+                           spec.format, pixels.data()))
+        return;
+
+    GLenum gltype, glformat, glinternalformat;
+    typespec_to_opengl(spec, m_tex_nchannels, gltype, glformat,
+                       glinternalformat);
+    m_proxy_texwidth  = clamp(ceil2(pspec.width), 1, m_max_texture_size);
+    m_proxy_texheight = clamp(ceil2(pspec.height), 1, m_max_texture_size);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, m_proxy_tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, glinternalformat, m_proxy_texwidth,
+                 m_proxy_texheight, 0, glformat, gltype, NULL);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, pspec.width, pspec.height,
+                    glformat, gltype, pixels.data());
+    print_error("Setting up proxy texture");
+    m_proxy_width  = pspec.width;
+    m_proxy_height = pspec.height;
 }
 
 
@@ -1492,55 +1661,66 @@ IvGL::typespec_to_opengl(const ImageSpec& spec, int nchannels, GLenum& gltype,
 
 
 
-void
-IvGL::load_texture(int x, int y, int width, int height)
+bool
+IvGL::load_texture(int level, int x, int y, int width, int height,
+                   std::vector<std::shared_ptr<TileFetch>>& wanted)
 {
     const ImageSpec& spec = m_current_image->spec();
     // Find if this has already been loaded.
     for (auto&& tb : m_texbufs) {
-        if (tb.x == x && tb.y == y && tb.width >= width
+        if (tb.level == level && tb.x == x && tb.y == y && tb.width >= width
             && tb.height >= height) {
             glBindTexture(GL_TEXTURE_2D, tb.tex_object);
-            return;
+            tb.last_used = m_paint_count;
+            return true;
         }
     }
 
-    setCursor(Qt::WaitCursor);
-
-    int nchannels = spec.nchannels;
-    // For simplicity, we don't support more than 4 channels without shaders
-    // (yet).
-    if (m_use_shaders) {
-        nchannels = num_channels(m_viewer.current_channel(), nchannels,
-                                 m_viewer.current_color_mode());
+    // Otherwise, we need its pixels, which may not have been read yet.
+    // They are copied out of the image, since ImageBuf has a cache
+    // underneath and the whole image may not be resident at once.
+    std::shared_ptr<TileFetch> fetch;
+    for (auto&& f : m_fetches) {
+        if (f->level == level && f->x == x && f->y == y && f->width >= width
+            && f->height >= height) {
+            fetch = f;
+            break;
+        }
+    }
+    if (!fetch) {
+        fetch.reset(new TileFetch);
+        fetch->level  = level;
+        fetch->x      = x;
+        fetch->y      = y;
+        fetch->width  = width;
+        fetch->height = height;
+        m_fetches.push_back(fetch);
+        wanted.push_back(fetch);
+        return false;
     }
+    if (!fetch->ready)
+        return false;
+
+    int nchannels = m_tex_nchannels;
     GLenum gltype, glformat, glinternalformat;
     typespec_to_opengl(spec, nchannels, gltype, glformat, glinternalformat);
 
-    TexBuffer& tb = m_texbufs[m_last_texbuf_used];
+    // Replace the least recently drawn texture.
+    TexBuffer* lru = &m_texbufs[0];
+    for (auto&& tb : m_texbufs)
+        if (tb.last_used < lru->last_used)
+            lru = &tb;
+    TexBuffer& tb = *lru;
+    tb.level      = level;
     tb.x          = x;
     tb.y          = y;
     tb.width      = width;
     tb.height     = height;
-    // Copy the imagebuf pixels we need, that's the only way we can do
-    // it safely since ImageBuf has a cache underneath and the whole image
-    // may not be resident at once.
-    if (!m_use_shaders) {
-        m_current_image->get_pixels(ROI(x, x + width, y, y + height),
-                                    spec.format, &m_tex_buffer[0]);
-    } else {
-        m_current_image->get_pixels(ROI(x, x + width, y, y + height, 0, 1,
-                                        m_viewer.current_channel(),
-                                        m_viewer.current_channel() + nchannels),
-                                    spec.format, &m_tex_buffer[0]);
-    }
+    tb.last_used  = m_paint_count;
 
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo_objects[m_last_pbo_used]);
-    glBufferData(GL_PIXEL_UNPACK_BUFFER,
-                 GLsizeiptr(uint64_t(width) * uint64_t(height)
-                            * uint64_t(nchannels)
-                            * uint64_t(spec.format.size())),
-                 &m_tex_buffer[0], GL_STREAM_DRAW);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(fetch->pixels.size()),
+                 fetch->pixels.data(), GL_STREAM_DRAW);
     print_error("After buffer data");
     m_last_pbo_used = (m_last_pbo_used + 1) & 1;
 
@@ -1549,11 +1729,72 @@ IvGL::load_texture(int x, int y, int width, int height)
 
     glBindTexture(GL_TEXTURE_2D, tb.tex_object);
     print_error("After bind texture");
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, glformat, gltype,
-                    data);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, fetch->width, fetch->height,
+                    glformat, gltype, data);
     print_error("After loading sub image");
-    m_last_texbuf_used = (m_last_texbuf_used + 1) % m_texbufs.size();
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return true;
+}
+
+
+
+void
+IvGL::fetch_tiles(std::vector<std::shared_ptr<TileFetch>>& wanted)
+{
+    if (wanted.empty())
+        return;
+    // Read first the tiles nearest where the user is looking: the mouse,
+    // if it's over the view, or else the center.
+    float fx = m_centerx, fy = m_centery;
+    if (underMouse()) {
+        int x, y;
+        get_focus_image_pixel(x, y);
+        fx = float(x);
+        fy = float(y);
+    }
+    // The tiles are all from the level being drawn, in its pixel space.
+    const ImageSpec& spec(m_current_image->spec());
+    const ImageSpec& lspec(level_image(wanted[0]->level).spec());
+    fx = lspec.x + (fx - spec.x) * float(lspec.width) / float(spec.width);
+    fy = lspec.y + (fy - spec.y) * float(lspec.height) / float(spec.height);
+    auto distance = [=](const std::shared_ptr<TileFetch>& f) {
+        return tile_distance2(f->x, f->y, f->width, f->height, fx, fy);
+    };
+    std::sort(wanted.begin(), wanted.end(),
+              [&](const std::shared_ptr<TileFetch>& a,
+                  const std::shared_ptr<TileFetch>& b) {
+                  return distance(a) < distance(b);
+              });
+
+    // Let go of reads that have already finished.
+    m_fetch_tasks.erase(std::remove_if(m_fetch_tasks.begin(),
+                                       m_fetch_tasks.end(),
+                                       [](const std::future<void>& f) {
+                                           return f.wait_for(
+                                                      std::chrono::seconds(0))
+                                                  == std::future_status::ready;
+                                       }),
+                        m_fetch_tasks.end());
+
+    TypeDesc format = m_current_image->spec().format;
+    int chbegin     = m_tex_chbegin;
+    int chend       = m_tex_chbegin + m_tex_nchannels;
+    for (auto&& fetch : wanted) {
+        const ImageBuf* img = &level_image(fetch->level);
+        auto read = [this, img, format, chbegin, chend, fetch](int) {
+            fetch->pixels.resize(size_t(fetch->width) * size_t(fetch->height)
+                                 * size_t(chend - chbegin) * format.size());
+            img->get_pixels(ROI(fetch->x, fetch->x + fetch->width, fetch->y,
+                                fetch->y + fetch->height, 0, 1, chbegin,
+                                chend),
+                            format, fetch->pixels.data());
+            fetch->ready = true;
+            // Repaint (on the GUI thread) to show it.
+            QMetaObject::invokeMethod(
+                this, [this]() { parent_t::update(); }, Qt::QueuedConnection);
+        };
+        m_fetch_tasks.push_back(default_thread_pool()->push(read));
+    }
 }
 
 
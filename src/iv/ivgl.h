@@ -18,6 +18,9 @@
 // included to remove std::min/std::max errors
 #include <OpenImageIO/platform.h>
 
+#include <atomic>
+#include <future>
+#include <memory>
 #include <vector>
 
 #include <QOpenGLExtraFunctions>
@@ -41,6 +44,11 @@ public:
     ///
     virtual void update();
 
+    /// Wait for any background reads of the current image's pixels to
+    /// finish, and discard them. Call this before changing, re-reading,
+    /// or deleting the image being shown.
+    void finish_fetches();
+
     /// Update the view -- center (in pixel coordinates) and zoom level.
     ///
     virtual void view(float centerx, float centery, float zoom,
@@ -88,6 +96,10 @@ public:
     ///
     bool is_half_capable(void) const { return m_use_halffloat; }
 
+    /// Are the channels shown for the given channel and color mode already
+    /// in the textures, so that switching to them needs no update()?
+    bool channels_resident(int channel, int colormode) const;
+
     /// Returns true if the image is too big to fit within allocated textures
     /// (i.e., it's recommended to use lower resolution versions when zoomed out).
     bool is_too_big(float width, float height);
@@ -118,11 +130,10 @@ protected:
     GLuint m_pbo_objects[2];       ///< Pixel buffer objects
     int m_last_pbo_used;           ///< Last used pixel buffer object.
     IvImage* m_current_image;      ///< Image to show on screen.
+    int m_tex_chbegin;             ///< First image channel in the textures
+    int m_tex_nchannels;           ///< Number of channels in the textures
     GLuint m_pixelview_tex;        ///< Pixelview's own texture.
     bool m_pixelview_left_corner;  ///< Draw pixelview in upper left or right
-    /// Buffer passed to IvImage::copy_image when not using PBO.
-    ///
-    std::vector<unsigned char> m_tex_buffer;
 
     std::string m_color_shader_text;
 
@@ -130,13 +141,35 @@ protected:
     ///
     struct TexBuffer {
         GLuint tex_object;
+        int level;  ///< MIP level of the pixels it holds
         int x;
         int y;
         int width;
         int height;
+        unsigned int last_used;  ///< Last paint that drew it
     };
     std::vector<TexBuffer> m_texbufs;
-    int m_last_texbuf_used;
+    unsigned int m_paint_count;  ///< Number of paints so far
+
+    /// The MIP levels of the current image beyond level 0, from which
+    /// zoomed-out views are drawn.
+    std::vector<std::unique_ptr<ImageBuf>> m_levels;
+
+    /// The pixels of one texture tile, read from the image on a background
+    /// thread so that painting never waits for file I/O or decompression.
+    struct TileFetch {
+        int level, x, y, width, height;
+        std::vector<unsigned char> pixels;
+        std::atomic<bool> ready { false };
+    };
+    std::vector<std::shared_ptr<TileFetch>> m_fetches;  ///< Pending or read
+    std::vector<std::future<void>> m_fetch_tasks;  ///< Background reads
+
+    /// A low-resolution version of the image (from one of its MIP levels),
+    /// drawn in place of tiles whose pixels haven't been read yet.
+    GLuint m_proxy_tex;
+    int m_proxy_width, m_proxy_height;  ///< Proxy resolution, 0 if none
+    GLsizei m_proxy_texwidth, m_proxy_texheight;  ///< Its texture's size
     bool m_mouse_activation;  ///< Can we expect the window to be activated by mouse?
 
 
@@ -186,6 +219,9 @@ private:
     /// closeuptexsize is the size of the texture used to upload the pixelview
     /// to OpenGL.
     const static int closeuptexsize = 16;
+    /// maxtileres is the largest texture tile used for the image, which
+    /// bounds what must be read and uploaded to show any part of it.
+    const static int maxtileres = 2048;
 
     void clamp_view_to_window();
 
@@ -197,9 +233,26 @@ private:
     ///
     void print_shader_log(std::ostream& out, const GLuint shader_id);
 
-    /// Loads the given patch of the image, but first figures if it's already
-    /// been loaded.
-    void load_texture(int x, int y, int width, int height);
+    /// Bind a texture holding the given patch of the image's MIP level,
+    /// uploading it (replacing the least recently drawn texture) if it
+    /// isn't already loaded. If its pixels haven't been read yet, return
+    /// false, having added it to `wanted` to be fetched in the background.
+    bool load_texture(int level, int x, int y, int width, int height,
+                      std::vector<std::shared_ptr<TileFetch>>& wanted);
+
+    /// The current image's given MIP level.
+    const ImageBuf& level_image(int level) const;
+
+    /// Create or delete texture objects to have n of them in m_texbufs.
+    void resize_texbufs(size_t n);
+
+    /// Start background reads of the `wanted` tiles, the ones nearest the
+    /// mouse (or the center of the view) first.
+    void fetch_tiles(std::vector<std::shared_ptr<TileFetch>>& wanted);
+
+    /// Read the proxy for the current image, if it has a suitable MIP
+    /// level, and upload it to m_proxy_tex.
+    void load_proxy();
 
     /// Destroys shaders and selects fixed-function pipeline
     void create_shaders_abort(void);
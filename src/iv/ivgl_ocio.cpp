@@ -116,7 +116,8 @@ IvGL_OCIO::update_state()
 
             m_shader_desc = shaderDesc;
 
-            allocate_all_textures(m_texbufs.size() + 1);
+            // The image textures all use unit 0, so the LUTs start at 1.
+            allocate_all_textures(1);
 
             create_shaders();
 
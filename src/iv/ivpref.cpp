@@ -35,12 +35,24 @@ IvPreferenceWindow::IvPreferenceWindow(ImageViewer& viewer)
     inner_layout->addWidget(viewer.maxMemoryICLabel);
     inner_layout->addWidget(viewer.maxMemoryIC);
 
+    QLayout* texMemoryLayout = new QHBoxLayout;
+    texMemoryLayout->addWidget(viewer.maxMemoryTexLabel);
+    texMemoryLayout->addWidget(viewer.maxMemoryTex);
+
     QLayout* slideShowLayout = new QHBoxLayout;
     slideShowLayout->addWidget(viewer.slideShowDurationLabel);
     slideShowLayout->addWidget(viewer.slideShowDuration);
 
+    QLayout* playbackLayout = new QHBoxLayout;
+    playbackLayout->addWidget(viewer.playbackFpsLabel);
+    playbackLayout->addWidget(viewer.playbackFps);
+    playbackLayout->addWidget(viewer.readAheadLabel);
+    playbackLayout->addWidget(viewer.readAhead);
+
     layout->addLayout(inner_layout);
+    layout->addLayout(texMemoryLayout);
     layout->addLayout(slideShowLayout);
+    layout->addLayout(playbackLayout);
     layout->addWidget(closeButton);
     setLayout(layout);
 
@@ -5,6 +5,9 @@
 #ifndef OPENIMAGEIO_IV_UTILS_H
 #define OPENIMAGEIO_IV_UTILS_H
 
+#include <algorithm>
+
+#include <OpenImageIO/fmath.h>
 #include <OpenImageIO/oiioversion.h>
 
 OIIO_NAMESPACE_BEGIN
@@ -33,6 +36,100 @@ floor2f(float f)
     return powf(2.0f, floorf(logval));
 }
 
+/// With shaders, iv's textures hold a window of up to four channels that
+/// covers the current channel, and the shader picks the ones to show, so
+/// that moving among them is a uniform change rather than a re-upload.
+/// Return the number of channels in the window for viewing
+/// `current_channel` of an image with `nchannels`, and set `chbegin` to
+/// the first of them.
+
+inline int
+texture_channels(int current_channel, int nchannels, int& chbegin)
+{
+    chbegin = 0;
+    if (nchannels > 4)
+        chbegin = clamp(current_channel, 0, nchannels - 4);
+    return std::min(nchannels, 4);
+}
+
+/// Are the `n` channels starting at `channel` all in the texture window
+/// of `texchannels` channels starting at `texchbegin`?
+
+inline bool
+channels_in_window(int channel, int n, int texchbegin, int texchannels)
+{
+    return n == 0
+           || (channel >= texchbegin
+               && channel + n <= texchbegin + texchannels);
+}
+
+/// Squared distance from (fx, fy) to the center of the `width` x `height`
+/// tile at (x, y). iv reads the tiles nearest where the user is looking
+/// first.
+
+inline float
+tile_distance2(int x, int y, int width, int height, float fx, float fy)
+{
+    float dx = x + 0.5f * width - fx;
+    float dy = y + 0.5f * height - fy;
+    return dx * dx + dy * dy;
+}
+
+/// Can an image (MIP level) of `width` x `height` serve as the proxy that
+/// iv draws until the full resolution tiles have been read: is it no
+/// bigger than `maxres` on a side?
+
+inline bool
+proxy_fits(int width, int height, int maxres)
+{
+    return width >= 1 && height >= 1 && width <= maxres && height <= maxres;
+}
+
+/// The MIP level that iv draws from at `zoom` (screen pixels per image
+/// pixel), when the image has `nlevels` levels below full resolution: the
+/// smallest one that still has at least one pixel per screen pixel.
+
+inline int
+zoom_miplevel(float zoom, int nlevels)
+{
+    int level = 0;
+    while (level < nlevels && zoom * (2 << level) <= 1.0f)
+        ++level;
+    return level;
+}
+
+/// The number of tile textures of `texbytes` each that iv keeps within a
+/// GPU memory `budget` (in bytes), but at least a few so that a view
+/// straddling tiles can be drawn.
+
+inline size_t
+texture_pool_size(size_t texbytes, size_t budget)
+{
+    return clamp(budget / std::max(texbytes, size_t(1)), size_t(4),
+                 size_t(256));
+}
+
+/// The frame `steps` away from `frame` when playing a sequence of
+/// `nframes` in `direction` (1 forward, -1 backward), looping around.
+
+inline int
+play_frame(int frame, int steps, int direction, int nframes)
+{
+    return ((frame + steps * direction) % nframes + nframes) % nframes;
+}
+
+/// The playback rate to show after a frame arrived `dt` seconds after the
+/// previous one, smoothed from the last rate `fps` (0 if none yet) so that
+/// the status bar is readable.
+
+inline double
+smoothed_fps(double fps, double dt)
+{
+    if (dt <= 0)
+        return fps;
+    return fps ? 0.9 * fps + 0.1 / dt : 1.0 / dt;
+}
+
 OIIO_NAMESPACE_END
 
 #endif  // OPENIMAGEIO_IV_UTILS_H
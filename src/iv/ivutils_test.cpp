@@ -0,0 +1,162 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <OpenImageIO/unittest.h>
+
+#include "ivutils.h"
+
+
+using namespace OIIO;
+
+
+
+static void
+test_pow2_rounding()
+{
+    std::cout << "Testing ceil2f, floor2f\n";
+    OIIO_CHECK_EQUAL(ceil2f(3.0f), 4.0f);
+    OIIO_CHECK_EQUAL(ceil2f(0.3f), 0.5f);
+    OIIO_CHECK_EQUAL(floor2f(3.0f), 2.0f);
+    OIIO_CHECK_EQUAL(floor2f(0.3f), 0.25f);
+}
+
+
+
+// The textures hold all channels of images with up to four, and otherwise
+// a window of four that starts at the current channel where it can.
+static void
+test_texture_channels()
+{
+    std::cout << "Testing texture_channels\n";
+    int chbegin = -1;
+    OIIO_CHECK_EQUAL(texture_channels(0, 3, chbegin), 3);
+    OIIO_CHECK_EQUAL(chbegin, 0);
+    OIIO_CHECK_EQUAL(texture_channels(2, 4, chbegin), 4);
+    OIIO_CHECK_EQUAL(chbegin, 0);
+    OIIO_CHECK_EQUAL(texture_channels(1, 6, chbegin), 4);
+    OIIO_CHECK_EQUAL(chbegin, 1);
+    OIIO_CHECK_EQUAL(texture_channels(5, 6, chbegin), 4);
+    OIIO_CHECK_EQUAL(chbegin, 2);
+    OIIO_CHECK_EQUAL(texture_channels(0, 0, chbegin), 0);
+    OIIO_CHECK_EQUAL(chbegin, 0);
+}
+
+
+
+// Moving among the channels already in the texture needs no re-upload;
+// stepping outside the window does.
+static void
+test_channels_in_window()
+{
+    std::cout << "Testing channels_in_window\n";
+    // A 6-channel image viewed from channel 0: channels 0-3 are resident
+    int chbegin = 0;
+    int n       = texture_channels(0, 6, chbegin);
+    OIIO_CHECK_ASSERT(channels_in_window(0, 4, chbegin, n));  // RGBA
+    OIIO_CHECK_ASSERT(channels_in_window(1, 3, chbegin, n));  // RGB from 1
+    OIIO_CHECK_ASSERT(channels_in_window(3, 1, chbegin, n));  // single
+    OIIO_CHECK_ASSERT(!channels_in_window(3, 3, chbegin, n));
+    OIIO_CHECK_ASSERT(!channels_in_window(4, 1, chbegin, n));
+    OIIO_CHECK_ASSERT(channels_in_window(5, 0, chbegin, n));  // nothing
+
+    // After re-uploading for channel 5, the window is channels 2-5
+    n = texture_channels(5, 6, chbegin);
+    OIIO_CHECK_ASSERT(channels_in_window(4, 2, chbegin, n));
+    OIIO_CHECK_ASSERT(channels_in_window(2, 1, chbegin, n));
+    OIIO_CHECK_ASSERT(!channels_in_window(1, 3, chbegin, n));
+}
+
+
+
+// Tiles are read nearest the focus first, and the proxy is the largest MIP
+// level that fits.
+static void
+test_fetch_helpers()
+{
+    std::cout << "Testing tile_distance2, proxy_fits\n";
+    OIIO_CHECK_EQUAL(tile_distance2(0, 0, 64, 64, 32.0f, 32.0f), 0.0f);
+    OIIO_CHECK_EQUAL(tile_distance2(64, 0, 64, 64, 32.0f, 32.0f),
+                     64.0f * 64.0f);
+    OIIO_CHECK_EQUAL(tile_distance2(64, 64, 64, 32, 0.0f, 0.0f),
+                     96.0f * 96.0f + 80.0f * 80.0f);
+
+    // Levels of a 4096x2048 image: 2048x1024 is too big, 1024x512 fits
+    int width = 4096, height = 2048, proxy = -1;
+    for (int m = 1; m < 13 && proxy < 0; ++m)
+        if (proxy_fits(std::max(1, width >> m), std::max(1, height >> m),
+                       1024))
+            proxy = m;
+    OIIO_CHECK_EQUAL(proxy, 2);
+    OIIO_CHECK_ASSERT(proxy_fits(1024, 1024, 1024));
+    OIIO_CHECK_ASSERT(!proxy_fits(1025, 16, 1024));
+    OIIO_CHECK_ASSERT(!proxy_fits(0, 16, 1024));
+}
+
+
+
+// Zoomed-out views draw from the MIP level with about one pixel per screen
+// pixel, and the texture pool is sized from the memory budget.
+static void
+test_miplevel_helpers()
+{
+    std::cout << "Testing zoom_miplevel, texture_pool_size\n";
+    OIIO_CHECK_EQUAL(zoom_miplevel(2.0f, 10), 0);
+    OIIO_CHECK_EQUAL(zoom_miplevel(1.0f, 10), 0);
+    OIIO_CHECK_EQUAL(zoom_miplevel(0.75f, 10), 0);
+    OIIO_CHECK_EQUAL(zoom_miplevel(0.5f, 10), 1);
+    OIIO_CHECK_EQUAL(zoom_miplevel(0.3f, 10), 1);
+    OIIO_CHECK_EQUAL(zoom_miplevel(0.25f, 10), 2);
+    OIIO_CHECK_EQUAL(zoom_miplevel(1.0f / 64, 10), 6);
+    OIIO_CHECK_EQUAL(zoom_miplevel(1.0f / 64, 3), 3);  // no smaller level
+    OIIO_CHECK_EQUAL(zoom_miplevel(0.25f, 0), 0);      // not MIP-mapped
+
+    size_t tile = size_t(2048) * 2048 * 4 * 2;  // 2048^2 RGBA half
+    OIIO_CHECK_EQUAL(texture_pool_size(tile, size_t(1024) << 20), size_t(32));
+    OIIO_CHECK_EQUAL(texture_pool_size(tile, size_t(64) << 20), size_t(4));
+    OIIO_CHECK_EQUAL(texture_pool_size(64, size_t(1024) << 20), size_t(256));
+}
+
+
+
+// Playback steps through the images in either direction, looping, and
+// reports a smoothed frame rate.
+static void
+test_playback_helpers()
+{
+    std::cout << "Testing play_frame, smoothed_fps\n";
+    OIIO_CHECK_EQUAL(play_frame(0, 1, 1, 5), 1);
+    OIIO_CHECK_EQUAL(play_frame(4, 1, 1, 5), 0);
+    OIIO_CHECK_EQUAL(play_frame(3, 4, 1, 5), 2);
+    OIIO_CHECK_EQUAL(play_frame(0, 1, -1, 5), 4);
+    OIIO_CHECK_EQUAL(play_frame(1, 4, -1, 5), 2);
+    OIIO_CHECK_EQUAL(play_frame(2, 12, -1, 5), 0);  // more than a loop
+
+    OIIO_CHECK_EQUAL_THRESH(smoothed_fps(0.0, 0.04), 25.0, 1e-9);
+    OIIO_CHECK_EQUAL(smoothed_fps(25.0, 0.0), 25.0);
+    OIIO_CHECK_EQUAL_THRESH(smoothed_fps(25.0, 0.05), 24.5, 1e-9);
+    // A steady rate converges to itself
+    double fps = 10.0;
+    for (int i = 0; i < 200; ++i)
+        fps = smoothed_fps(fps, 1.0 / 24);
+    OIIO_CHECK_EQUAL_THRESH(fps, 24.0, 1e-6);
+}
+
+
+
+int
+main(int /*argc*/, char* /*argv*/[])
+{
+    test_pow2_rounding();
+    test_texture_channels();
+    test_channels_in_window();
+    test_fetch_helpers();
+    test_miplevel_helpers();
+    test_playback_helpers();
+    return unit_test_failures;
+}
@@ -52,6 +52,19 @@ static const int JPEG_422_COMP[6] = { 2, 1, 1, 1, 1, 1 };
 static const int JPEG_420_COMP[6] = { 2, 2, 1, 1, 1, 1 };
 static const int JPEG_411_COMP[6] = { 4, 1, 1, 1, 1, 1 };
 
+// Allocated size of one component plane for raw (already subsampled)
+// access through jpeg_read_raw_data / jpeg_write_raw_data, which move
+// whole iMCU rows at a time: pad to full MCUs in both directions.
+inline void
+raw_plane_size(int width, int height, int max_h, int max_v,
+               const jpeg_component_info& comp, int& stride, int& rows)
+{
+    int mcu_cols = (width + max_h * DCTSIZE - 1) / (max_h * DCTSIZE);
+    int mcu_rows = (height + max_v * DCTSIZE - 1) / (max_v * DCTSIZE);
+    stride       = mcu_cols * comp.h_samp_factor * DCTSIZE;
+    rows         = mcu_rows * comp.v_samp_factor * DCTSIZE;
+}
+
 
 class JpgInput final : public ImageInput {
 public:
@@ -63,10 +76,15 @@ public:
         return (feature == "exif" || feature == "iptc" || feature == "ioproxy");
     }
     bool valid_file(Filesystem::IOProxy* ioproxy) const override;
+    bool probe_header(string_view filename, ImageSpec& spec,
+                      const ImageSpec& config) override;
 
     bool open(const std::string& name, ImageSpec& spec) override;
     bool open(const std::string& name, ImageSpec& spec,
               const ImageSpec& config) override;
+    int current_subimage(void) const override { return m_subimage; }
+    int current_miplevel(void) const override { return m_miplevel; }
+    bool seek_subimage(int subimage, int miplevel) override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
     bool close() override;
@@ -90,11 +108,20 @@ private:
     bool m_cmyk;           // The input file is cmyk
     bool m_fatalerr;       // JPEG reader hit a fatal error
     bool m_decomp_create;  // Have we created the decompressor?
+    int m_reduce;          // Decode at 1/2^m_reduce scale (0-3)
+    int m_miplevel;        // Current virtual MIP level
+    int m_nmiplevels;      // Number of virtual MIP levels exposed
+    bool m_rawycc;         // Return Y, Cb, Cr planes as subimages
+    bool m_planes_read;    // Have the raw planes been decoded?
+    int m_subimage;        // Current plane, in raw YCbCr mode
     struct jpeg_decompress_struct m_cinfo;
     my_error_mgr m_jerr;
     jvirt_barray_ptr* m_coeffs;
     std::vector<unsigned char> m_cmyk_buf;  // For CMYK translation
     std::unique_ptr<ImageSpec> m_config;    // Saved copy of configuration spec
+    ImageSpec m_plane_specs[3];             // Raw YCbCr mode: per-plane specs
+    std::vector<unsigned char> m_planes[3];  // Raw YCbCr mode: decoded planes
+    int m_plane_stride[3];
 
     void init()
     {
@@ -102,7 +129,15 @@ private:
         m_cmyk          = false;
         m_fatalerr      = false;
         m_decomp_create = false;
+        m_reduce        = 0;
+        m_miplevel      = 0;
+        m_nmiplevels    = 1;
+        m_rawycc        = false;
+        m_planes_read   = false;
+        m_subimage      = 0;
         m_coeffs        = NULL;
+        for (auto& p : m_planes)
+            std::vector<unsigned char>().swap(p);
         m_jerr.jpginput = this;
         ioproxy_clear();
         m_config.reset();
@@ -113,10 +148,13 @@ private:
     // information and adding attributes to spec.  This assumes it's in
     // the form of an IIM (Information Interchange Model), which is actually
     // considered obsolete and is replaced by an XML scheme called XMP.
-    void jpeg_decode_iptc(const unsigned char* buf);
+    void jpeg_decode_iptc(const unsigned char* buf, bool keep_raw = false);
 
     bool read_icc_profile(j_decompress_ptr cinfo, ImageSpec& spec);
 
+    // Decode the whole image into m_planes with jpeg_read_raw_data.
+    bool read_raw_planes();
+
     void close_file() { init(); }
 
     friend class JpgOutput;
@@ -150,12 +150,92 @@ JpgInput::valid_file(Filesystem::IOProxy* ioproxy) const
 
 
 
+bool
+JpgInput::probe_header(string_view filename, ImageSpec& spec,
+                       const ImageSpec& config)
+{
+    // Walk the marker segments up to the first frame header (SOFn), which
+    // holds the dimensions and number of components, without starting up
+    // libjpeg at all.
+    ioproxy_retrieve_from_config(config);
+    if (!ioproxy_use_or_open(filename))
+        return false;
+    Filesystem::IOProxy* io = ioproxy();
+    uint8_t b[6];
+    bool ok = io->pread(b, 2, 0) == 2 && b[0] == JPEG_MAGIC1
+              && b[1] == JPEG_MAGIC2;
+    int width = 0, height = 0, ncomponents = 0;
+    for (int64_t pos = 2; ok && !ncomponents;) {
+        if (io->pread(b, 4, pos) != 4 || b[0] != 0xff) {
+            ok = false;
+            break;
+        }
+        int marker = b[1];
+        int length = b[2] << 8 | b[3];  // includes the length bytes
+        if (marker == 0xff) {  // fill byte
+            ++pos;
+            continue;
+        }
+        if (marker == 0xd9 || marker == 0xda) {  // EOI or SOS: no frame
+            ok = false;
+            break;
+        }
+        if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4
+            && marker != 0xc8 && marker != 0xcc) {
+            // SOFn: precision, height, width, number of components
+            if (io->pread(b, 6, pos + 4) != 6) {
+                ok = false;
+                break;
+            }
+            height      = b[1] << 8 | b[2];
+            width       = b[3] << 8 | b[4];
+            ncomponents = b[5];
+        }
+        pos += 2 + length;
+    }
+    ioproxy_clear();
+    if (!ok || !ncomponents) {
+        errorfmt("Bad JPEG header for \"{}\"", filename);
+        return false;
+    }
+    // Match the dimensions open() would produce for a "jpeg:reduce" hint,
+    // rounding up the way libjpeg does.
+    int reduce = OIIO::clamp(config.get_int_attribute("jpeg:reduce"), 0, 3);
+    width      = (width + (1 << reduce) - 1) >> reduce;
+    height     = (height + (1 << reduce) - 1) >> reduce;
+    // CMYK and YCbCrK files are converted to RGB by open()
+    spec = ImageSpec(width, height, ncomponents == 4 ? 3 : ncomponents,
+                     TypeDesc::UINT8);
+    return true;
+}
+
+
+
 bool
 JpgInput::open(const std::string& name, ImageSpec& newspec,
                const ImageSpec& config)
 {
     auto p = config.find_attribute("_jpeg:raw", TypeInt);
     m_raw  = p && *(int*)p->data();
+    // "jpeg:reduce" asks libjpeg to scale down by 2^reduce in the DCT
+    // domain, which is much cheaper than decoding full resolution and
+    // resizing. With "jpeg:miplevels", each further power-of-two scale
+    // that libjpeg supports (down to 1/8) is presented as a MIP level.
+    // "jpeg:rawycc" returns the Y, Cb, and Cr planes, at their native
+    // subsampling and without color conversion, as three subimages. It
+    // excludes the scaled reads.
+    m_rawycc     = !m_raw && config.get_int_attribute("jpeg:rawycc");
+    int reduce   = m_rawycc ? 0
+                            : OIIO::clamp(config.get_int_attribute(
+                                              "jpeg:reduce"),
+                                          0, 3);
+    m_nmiplevels = !m_raw && !m_rawycc
+                           && config.get_int_attribute("jpeg:miplevels")
+                       ? 4 - reduce
+                       : 1;
+    m_miplevel   = OIIO::clamp(config.get_int_attribute("_jpeg:miplevel"), 0,
+                               m_nmiplevels - 1);
+    m_reduce     = m_raw ? 0 : reduce + m_miplevel;
     ioproxy_retrieve_from_config(config);
     m_config.reset(new ImageSpec(config));  // save config spec
     return open(name, newspec);
@@ -242,6 +322,21 @@ JpgInput::open(const std::string& name, ImageSpec& newspec)
         m_cmyk                  = true;
     }
 
+    // Raw planes only make sense for the ordinary 3-channel YCbCr case;
+    // anything else is read normally.
+    if (m_rawycc
+        && (m_cinfo.jpeg_color_space != JCS_YCbCr || nchannels != 3))
+        m_rawycc = false;
+    if (m_rawycc) {
+        m_cinfo.raw_data_out    = TRUE;
+        m_cinfo.out_color_space = JCS_YCbCr;
+    }
+
+    if (m_reduce) {
+        m_cinfo.scale_num   = 1;
+        m_cinfo.scale_denom = 1 << m_reduce;
+    }
+
     if (m_raw)
         m_coeffs = jpeg_read_coefficients(&m_cinfo);
     else
@@ -268,21 +363,34 @@ JpgInput::open(const std::string& name, ImageSpec& newspec)
     if (!subsampling.empty())
         m_spec.attribute(JPEG_SUBSAMPLING_ATTR, subsampling);
 
+    string_view metadata = m_config ? metadata_hint(*m_config) : "all";
     for (jpeg_saved_marker_ptr m = m_cinfo.marker_list; m; m = m->next) {
         if (m->marker == (JPEG_APP0 + 1)
             && !strcmp((const char*)m->data, "Exif")) {
             // The block starts with "Exif\0\0", so skip 6 bytes to get
             // to the start of the actual Exif data TIFF directory
-            decode_exif(string_view((char*)m->data + 6, m->data_length - 6),
-                        m_spec);
+            string_view exif((char*)m->data + 6, m->data_length - 6);
+            if (metadata == "all" || metadata == "basic")
+                decode_exif(exif, m_spec);
+            else if (metadata == "lazy")
+                m_spec.attribute("oiio:RawExif",
+                                 TypeDesc(TypeDesc::UINT8, exif.size()),
+                                 exif.data());
         } else if (m->marker == (JPEG_APP0 + 1)
                    && !strcmp((const char*)m->data,
                               "http://ns.adobe.com/xap/1.0/")) {  //NOSONAR
             std::string xml((const char*)m->data, m->data_length);
-            decode_xmp(xml, m_spec);
+            if (metadata == "all")
+                decode_xmp(xml, m_spec);
+            else if (metadata == "lazy")
+                m_spec.attribute("oiio:RawXMP",
+                                 TypeDesc(TypeDesc::UINT8, xml.size()),
+                                 xml.data());
         } else if (m->marker == (JPEG_APP0 + 13)
-                   && !strcmp((const char*)m->data, "Photoshop 3.0"))
-            jpeg_decode_iptc((unsigned char*)m->data);
+                   && !strcmp((const char*)m->data, "Photoshop 3.0")) {
+            if (metadata == "all" || metadata == "lazy")
+                jpeg_decode_iptc((unsigned char*)m->data, metadata == "lazy");
+        }
         else if (m->marker == JPEG_COM) {
             if (!m_spec.find_attribute("ImageDescription", TypeDesc::STRING))
                 m_spec.attribute("ImageDescription",
@@ -326,6 +434,23 @@ JpgInput::open(const std::string& name, ImageSpec& newspec)
 
     read_icc_profile(&m_cinfo, m_spec);  /// try to read icc profile
 
+    if (m_rawycc) {
+        // Each plane is its own single-channel subimage, carrying all the
+        // metadata of the full image.
+        static const char* names[3] = { "Y", "Cb", "Cr" };
+        for (int c = 0; c < 3; ++c) {
+            ImageSpec& ps(m_plane_specs[c]);
+            ps = m_spec;
+            ps.width = ps.full_width = m_cinfo.comp_info[c].downsampled_width;
+            ps.height = ps.full_height
+                = m_cinfo.comp_info[c].downsampled_height;
+            ps.nchannels = 1;
+            ps.channelnames.assign(1, names[c]);
+            ps.attribute("jpeg:rawycc", 1);
+        }
+        m_spec = m_plane_specs[0];
+    }
+
     newspec = m_spec;
     return true;
 }
@@ -424,6 +549,34 @@ cmyk_to_rgb(int n, const unsigned char* cmyk, size_t cmyk_stride,
 
 
 
+bool
+JpgInput::seek_subimage(int subimage, int miplevel)
+{
+    if (m_rawycc) {
+        if (subimage < 0 || subimage > 2 || miplevel != 0)
+            return false;
+        if (subimage != m_subimage) {
+            m_subimage = subimage;
+            m_spec     = m_plane_specs[subimage];
+        }
+        return true;
+    }
+    if (subimage == 0 && miplevel == m_miplevel)
+        return true;
+    if (subimage != 0 || miplevel < 0 || miplevel >= m_nmiplevels)
+        return false;
+    // Each MIP level is a separate pass of the decompressor at a different
+    // DCT scale, so switching levels means restarting from the top.
+    ImageSpec config;
+    if (m_config)
+        config = *m_config;
+    config.attribute("_jpeg:miplevel", miplevel);
+    ImageSpec dummyspec;
+    return close() && open(m_filename, dummyspec, config);
+}
+
+
+
 bool
 JpgInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
                                void* data)
@@ -433,6 +586,16 @@ JpgInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
         return false;
     if (m_raw)
         return false;
+    if (m_rawycc) {
+        // The planes can only be decoded all together, so do the whole
+        // image the first time anything is asked for.
+        if (y < 0 || y >= m_spec.height
+            || (!m_planes_read && !read_raw_planes()))
+            return false;
+        memcpy(data, &m_planes[subimage][size_t(y) * m_plane_stride[subimage]],
+               m_spec.width);
+        return true;
+    }
     if (y < 0 || y >= (int)m_cinfo.output_height)  // out of range scanline
         return false;
     if (m_next_scanline > y) {
@@ -445,7 +608,7 @@ JpgInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
         ImageSpec dummyspec;
         int subimage = current_subimage();
         if (!close() || !open(m_filename, dummyspec, configsave)
-            || !seek_subimage(subimage, 0))
+            || !seek_subimage(subimage, miplevel))
             return false;  // Somehow, the re-open failed
         OIIO_DASSERT(m_next_scanline == 0 && current_subimage() == subimage);
     }
@@ -483,6 +646,46 @@ JpgInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
 
 
 
+bool
+JpgInput::read_raw_planes()
+{
+    if (setjmp(m_jerr.setjmp_buffer)) {
+        // Jump to here if there's a libjpeg internal error
+        return false;
+    }
+    int rowsper[3];
+    std::vector<JSAMPROW> rows[3];
+    for (int c = 0; c < 3; ++c) {
+        const jpeg_component_info& comp(m_cinfo.comp_info[c]);
+        int nrows;
+        raw_plane_size(m_cinfo.output_width, m_cinfo.output_height,
+                       m_cinfo.max_h_samp_factor, m_cinfo.max_v_samp_factor,
+                       comp, m_plane_stride[c], nrows);
+        m_planes[c].resize(size_t(m_plane_stride[c]) * nrows);
+        rowsper[c] = comp.v_samp_factor * DCTSIZE;
+        rows[c].resize(rowsper[c]);
+    }
+    // Each call decodes one iMCU row: v_samp_factor * DCTSIZE rows of
+    // every component.
+    for (int r = 0; m_cinfo.output_scanline < m_cinfo.output_height; ++r) {
+        JSAMPARRAY planes[3];
+        for (int c = 0; c < 3; ++c) {
+            for (int i = 0; i < rowsper[c]; ++i)
+                rows[c][i] = &m_planes[c][size_t(r * rowsper[c] + i)
+                                          * m_plane_stride[c]];
+            planes[c] = rows[c].data();
+        }
+        if (!jpeg_read_raw_data(&m_cinfo, planes,
+                                m_cinfo.max_v_samp_factor * DCTSIZE)
+            || m_fatalerr)
+            return false;
+    }
+    m_planes_read = true;
+    return true;
+}
+
+
+
 bool
 JpgInput::close()
 {
@@ -500,7 +703,7 @@ JpgInput::close()
 
 
 void
-JpgInput::jpeg_decode_iptc(const unsigned char* buf)
+JpgInput::jpeg_decode_iptc(const unsigned char* buf, bool keep_raw)
 {
     // APP13 blob doesn't have to be IPTC info.  Look for the IPTC marker,
     // which is the string "Photoshop 3.0" followed by a null character.
@@ -526,7 +729,11 @@ JpgInput::jpeg_decode_iptc(const unsigned char* buf)
     int segmentsize = (buf[0] << 8) + buf[1];
     buf += 2;
 
-    decode_iptc_iim(buf, segmentsize, m_spec);
+    if (keep_raw)
+        m_spec.attribute("oiio:RawIPTC", TypeDesc(TypeDesc::UINT8, segmentsize),
+                         buf);
+    else
+        decode_iptc_iim(buf, segmentsize, m_spec);
 }
 
 OIIO_PLUGIN_NAMESPACE_END
@@ -56,6 +56,10 @@ private:
     jvirt_barray_ptr* m_copy_coeffs;
     struct jpeg_decompress_struct* m_copy_decompressor;
     std::vector<unsigned char> m_tilebuffer;
+    bool m_rawycc;                          // Writing raw Y, Cb, Cr planes
+    int m_plane;                            // Which plane is being written
+    std::vector<unsigned char> m_planes[3];  // Raw planes, padded to MCUs
+    int m_plane_stride[3], m_plane_rows[3];
     // m_outbuffer/m_outsize are used for jpeg-to-memory
     unsigned char* m_outbuffer = nullptr;
 #if OIIO_JPEG_LIB_VERSION >= 94
@@ -72,6 +76,10 @@ private:
     {
         m_copy_coeffs       = NULL;
         m_copy_decompressor = NULL;
+        m_rawycc            = false;
+        m_plane             = 0;
+        for (auto& p : m_planes)
+            std::vector<unsigned char>().swap(p);
         ioproxy_clear();
         clear_outbuffer();
     }
@@ -99,6 +107,11 @@ private:
     // Read the XResolution/YResolution and PixelAspectRatio metadata, store
     // in density fields m_cinfo.X_density,Y_density.
     void resmeta_to_density();
+
+    // Raw YCbCr mode: move on to the next plane's subimage.
+    bool open_ycc_plane(const ImageSpec& newspec);
+    // Raw YCbCr mode: compress the buffered planes.
+    void write_raw_planes();
 };
 
 
@@ -122,6 +135,9 @@ bool
 JpgOutput::open(const std::string& name, const ImageSpec& newspec,
                 OpenMode mode)
 {
+    if (mode == AppendSubimage && m_rawycc)
+        return open_ycc_plane(newspec);
+
     // Save name and spec for later use
     m_filename = name;
 
@@ -133,6 +149,15 @@ JpgOutput::open(const std::string& name, const ImageSpec& newspec,
     // that's only because we robustly truncate to only RGB no matter what we
     // are handed.
 
+    m_rawycc = m_spec.get_int_attribute("jpeg:rawycc") != 0;
+    if (m_rawycc && (m_spec.nchannels != 1 || m_spec.tile_width)) {
+        errorfmt(
+            "JPEG raw YCbCr output needs 1-channel scanline planes, not {} channels",
+            m_spec.nchannels);
+        m_rawycc = false;
+        return false;
+    }
+
     ioproxy_retrieve_from_config(m_spec);
     if (!ioproxy_use_or_open(name))
         return false;
@@ -154,7 +179,12 @@ JpgOutput::open(const std::string& name, const ImageSpec& newspec,
 
     // JFIF can only handle grayscale and RGB. Do the best we can with this
     // limited format by switching to 1 or 3 channels.
-    if (m_spec.nchannels >= 3) {
+    if (m_rawycc) {
+        // Already-subsampled planes, passed as three single-channel
+        // subimages: Y (full size), then Cb and Cr.
+        m_cinfo.input_components = 3;
+        m_cinfo.in_color_space   = JCS_YCbCr;
+    } else if (m_spec.nchannels >= 3) {
         // For 3 or more channels, write the first 3 as RGB and drop any
         // additional channels.
         m_cinfo.input_components = 3;
@@ -218,9 +248,28 @@ JpgOutput::open(const std::string& name, const ImageSpec& newspec,
             jpeg_simple_progression(&m_cinfo);
         }
 
+        if (m_rawycc) {
+            m_cinfo.raw_data_in = TRUE;
+#if JPEG_LIB_VERSION >= 70
+            m_cinfo.do_fancy_downsampling = FALSE;
+#endif
+        }
+
         jpeg_start_compress(&m_cinfo, TRUE);  // start working
         DBG std::cout << "out open: start_compress\n";
     }
+
+    if (m_rawycc) {
+        // Chroma starts out neutral, in case it's never written.
+        for (int c = 0; c < 3; ++c) {
+            raw_plane_size(m_cinfo.image_width, m_cinfo.image_height,
+                           m_cinfo.max_h_samp_factor,
+                           m_cinfo.max_v_samp_factor, m_cinfo.comp_info[c],
+                           m_plane_stride[c], m_plane_rows[c]);
+            m_planes[c].assign(size_t(m_plane_stride[c]) * m_plane_rows[c],
+                               c ? 128 : 0);
+        }
+    }
     m_next_scanline = 0;  // next scanline we'll write
 
     // Write JPEG comment, if sent an 'ImageDescription'
@@ -427,11 +476,84 @@ JpgOutput::resmeta_to_density()
 
 
 
+bool
+JpgOutput::open_ycc_plane(const ImageSpec& newspec)
+{
+    if (m_plane >= 2) {
+        errorfmt("JPEG raw YCbCr output only has 3 planes");
+        return false;
+    }
+    const jpeg_component_info& comp(m_cinfo.comp_info[m_plane + 1]);
+    if (newspec.nchannels != 1 || newspec.width != int(comp.downsampled_width)
+        || newspec.height != int(comp.downsampled_height)) {
+        errorfmt(
+            "JPEG raw YCbCr plane {} must be 1 channel of {}x{}, not {} channels of {}x{}",
+            m_plane + 1, comp.downsampled_width, comp.downsampled_height,
+            newspec.nchannels, newspec.width, newspec.height);
+        return false;
+    }
+    ++m_plane;
+    m_spec = newspec;
+    m_spec.set_format(TypeDesc::UINT8);
+    return true;
+}
+
+
+
+void
+JpgOutput::write_raw_planes()
+{
+    for (int c = 0; c < 3; ++c) {
+        // Replicate the right and bottom edges into the MCU padding, so
+        // the partial blocks at the edges compress cleanly.
+        const jpeg_component_info& comp(m_cinfo.comp_info[c]);
+        int w = comp.downsampled_width, h = comp.downsampled_height;
+        size_t stride = m_plane_stride[c];
+        unsigned char* plane = m_planes[c].data();
+        for (int y = 0; y < h; ++y)
+            memset(plane + y * stride + w, plane[y * stride + w - 1],
+                   stride - w);
+        for (int y = h; y < m_plane_rows[c]; ++y)
+            memcpy(plane + y * stride, plane + (h - 1) * stride, stride);
+    }
+    // Each call consumes one iMCU row: v_samp_factor * DCTSIZE rows of
+    // every component.
+    std::vector<JSAMPROW> rows[3];
+    for (int r = 0; m_cinfo.next_scanline < m_cinfo.image_height; ++r) {
+        JSAMPARRAY planes[3];
+        for (int c = 0; c < 3; ++c) {
+            int rowsper = m_cinfo.comp_info[c].v_samp_factor * DCTSIZE;
+            rows[c].resize(rowsper);
+            for (int i = 0; i < rowsper; ++i)
+                rows[c][i] = &m_planes[c][size_t(r * rowsper + i)
+                                          * m_plane_stride[c]];
+            planes[c] = rows[c].data();
+        }
+        jpeg_write_raw_data(&m_cinfo, planes,
+                            m_cinfo.max_v_samp_factor * DCTSIZE);
+    }
+}
+
+
+
 bool
 JpgOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
                           stride_t xstride)
 {
     y -= m_spec.y;
+    if (m_rawycc) {
+        // Planes are buffered, and compressed all together by close().
+        if (y < 0 || y >= m_spec.height) {
+            errorfmt("Attempt to write too many scanlines to {}", m_filename);
+            return false;
+        }
+        m_spec.auto_stride(xstride, format, m_spec.nchannels);
+        data = to_native_scanline(format, data, xstride, m_scratch, m_dither, y,
+                                  z);
+        memcpy(&m_planes[m_plane][size_t(y) * m_plane_stride[m_plane]], data,
+               m_spec.width);
+        return true;
+    }
     if (y != m_next_scanline) {
         errorfmt("Attempt to write scanlines out of order to {}", m_filename);
         return false;
@@ -499,6 +621,11 @@ JpgOutput::close()
 
     bool ok = true;
 
+    if (m_rawycc) {
+        write_raw_planes();
+        m_next_scanline = spec().height;
+    }
+
     if (m_spec.tile_width) {
         // We've been emulating tiles; now dump as scanlines.
         OIIO_DASSERT(m_tilebuffer.size());
@@ -14,6 +14,8 @@
 #include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/tiffutils.h>
 
+#include "imageio_pvt.h"
+
 #ifndef OIIO_OPJ_VERSION
 #    if defined(OPJ_VERSION_MAJOR)
 // OpenJPEG >= 2.1 defines these symbols
@@ -84,19 +86,62 @@ public:
     bool open(const std::string& name, ImageSpec& newspec,
               const ImageSpec& config) override;
     bool close(void) override;
+    int current_miplevel(void) const override { return m_miplevel; }
+    bool seek_subimage(int subimage, int miplevel) override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_tile(int subimage, int miplevel, int x, int y, int z,
+                          void* data) override;
 
 private:
+    // Full resolution geometry of one decoded component. (Decoded, because
+    // a JP2 palette expands to more components than the codestream has.)
+    struct CompInfo {
+        int x0, y0;  // Origin on the component's own (subsampled) grid
+        int w, h;
+        int dx, dy;
+    };
+    // Where the samples of one component lie in the image at the current
+    // resolution level, in pixel coordinates.
+    struct ChanWindow {
+        int x, y;    // Pixel position of the first sample
+        int w, h;    // Number of samples
+        int dx, dy;  // Subsampling factors
+    };
+
     std::string m_filename;
     std::vector<int> m_bpp;  // per channel bpp
-    opj_image_t* m_image;
+    opj_image_t* m_header;   // Undecoded image: full resolution geometry
+    opj_image_t* m_image;    // Whole decoded image of the current level
     opj_codec_t* m_codec;
     opj_stream_t* m_stream;
     bool m_keep_unassociated_alpha;  // Do not convert unassociated alpha
+    bool m_tiled;                    // Present codestream tiles as tiles
+    int m_miplevel;
+    int m_nmiplevels;
+    int m_tile_w, m_tile_h;  // Codestream tile size at full resolution
+    int m_ntiles_x;          // Codestream tiles per row
+    TypeDesc m_format;
+    unsigned int m_maxprecision;
+    std::vector<CompInfo> m_comps;    // Per channel, full resolution
+    std::vector<ChanWindow> m_chans;  // Per channel, at the current level
 
     void init(void);
 
+    // Read the header into `image` with a fresh codec and stream, set to
+    // decode at reduction `miplevel`.
+    bool start_decode(opj_image_t*& image, int miplevel);
+    void finish_decode()
+    {
+        destroy_decompressor();
+        destroy_stream();
+    }
+    // Decode the whole current level into m_image.
+    bool decode_level();
+    bool check_components(const opj_image_t* image);
+    void setup_level_spec();
+    void associate_alpha(void* data, int npixels);
+
     bool isJp2File(const int* const p_magicTable) const;
 
     opj_codec_t* create_decompressor();
@@ -110,7 +155,9 @@ private:
         }
     }
 
-    template<typename T> void read_scanline(int y, int z, void* data);
+    template<typename T>
+    void read_row(const opj_image_t* image, const ChanWindow* windows, int y,
+                  int xbegin, int xend, T* data);
 
     uint16_t baseTypeConvertU10ToU16(int src)
     {
@@ -122,9 +169,9 @@ private:
         return (uint16_t)((src << 4) | (src >> 8));
     }
 
-    template<typename T> void yuv_to_rgb(T* p_scanline)
+    template<typename T> void yuv_to_rgb(T* p_scanline, int npixels)
     {
-        for (int x = 0, i = 0; x < m_spec.width; ++x, i += m_spec.nchannels) {
+        for (int x = 0, i = 0; x < npixels; ++x, i += m_spec.nchannels) {
             float y = convert_type<T, float>(p_scanline[i + 0]);
             float u = convert_type<T, float>(p_scanline[i + 1]) - 0.5f;
             float v = convert_type<T, float>(p_scanline[i + 2]) - 0.5f;
@@ -201,10 +248,20 @@ OIIO_PLUGIN_EXPORTS_END
 void
 Jpeg2000Input::init(void)
 {
+    m_header                  = NULL;
     m_image                   = NULL;
     m_codec                   = NULL;
     m_stream                  = NULL;
     m_keep_unassociated_alpha = false;
+    m_tiled                   = false;
+    m_miplevel                = -1;
+    m_nmiplevels              = 1;
+    m_tile_w                  = 0;
+    m_tile_h                  = 0;
+    m_ntiles_x                = 1;
+    m_maxprecision            = 0;
+    m_comps.clear();
+    m_chans.clear();
     ioproxy_clear();
 }
 
@@ -213,16 +270,230 @@ Jpeg2000Input::init(void)
 bool
 Jpeg2000Input::open(const std::string& name, ImageSpec& p_spec)
 {
+    ImageSpec config;
+    return open(name, p_spec, config);
+}
+
+
+
+bool
+Jpeg2000Input::open(const std::string& name, ImageSpec& newspec,
+                    const ImageSpec& config)
+{
+    // Check 'config' for any special requests
+    if (config.get_int_attribute("oiio:UnassociatedAlpha", 0) == 1)
+        m_keep_unassociated_alpha = true;
+    bool want_mips  = config.get_int_attribute("jpeg2000:miplevels", 0) != 0;
+    bool want_tiles = config.get_int_attribute("jpeg2000:tiles", 0) != 0;
+    ioproxy_retrieve_from_config(config);
+
     m_filename = name;
 
     if (!ioproxy_use_or_open(name))
         return false;
+
+    OIIO_ASSERT(m_header == nullptr);
+    bool ok = start_decode(m_header, 0);
+    if (ok && (want_mips || want_tiles)) {
+        // The codestream info tells us the number of wavelet resolutions
+        // and the tile grid, which is all we need to know about the
+        // pyramid and tiling without decoding anything.
+        opj_codestream_info_v2_t* cstr = opj_get_cstr_info(m_codec);
+        if (cstr) {
+            const opj_tile_info_v2_t& tinfo(cstr->m_default_tile_info);
+            if (want_mips && tinfo.tccp_info) {
+                int nres = int(tinfo.tccp_info[0].numresolutions);
+                for (OPJ_UINT32 c = 1; c < cstr->nbcomps; ++c)
+                    nres = std::min(nres,
+                                    int(tinfo.tccp_info[c].numresolutions));
+                m_nmiplevels = std::max(1, nres);
+            }
+            // Only a tile grid anchored at the image origin, without
+            // subsampled components, maps onto uniform OIIO tiles.
+            m_tiled = want_tiles && cstr->tw * cstr->th > 1
+                      && cstr->tx0 == m_header->x0
+                      && cstr->ty0 == m_header->y0;
+            for (OPJ_UINT32 c = 0; c < m_header->numcomps; ++c)
+                if (m_header->comps[c].dx != 1 || m_header->comps[c].dy != 1)
+                    m_tiled = false;
+            m_tile_w   = int(cstr->tdx);
+            m_tile_h   = int(cstr->tdy);
+            m_ntiles_x = int(cstr->tw);
+            opj_destroy_cstr_info(&cstr);
+        }
+        // Tiles stay uniform at a reduced level only if it divides the
+        // tile size evenly.
+        if (m_tiled)
+            while (m_nmiplevels > 1
+                   && ((m_tile_w | m_tile_h) & ((1 << (m_nmiplevels - 1)) - 1)))
+                --m_nmiplevels;
+    }
+    finish_decode();
+    if (!ok) {
+        close();
+        return false;
+    }
+    OIIO_ASSERT(m_header != nullptr);
+
+    // Untiled images are decoded whole right away, as they always have
+    // been, so that a broken file is reported by open(). For tiles, we
+    // only decode the first one at the smallest size, to learn what the
+    // decoded components look like.
+    m_miplevel         = 0;
+    opj_image_t* probe = nullptr;
+    if (!m_tiled) {
+        ok = decode_level();
+    } else {
+        int level = m_nmiplevels - 1;
+        ok        = start_decode(probe, level)
+             && opj_get_decoded_tile(m_codec, m_stream, probe, 0)
+             && !has_error();
+        if (!ok && !has_error())
+            errorfmt("Could not decode Jpeg2000 data");
+        finish_decode();
+    }
+    if (!ok) {
+        if (probe)
+            opj_image_destroy(probe);
+        close();
+        return false;
+    }
+    const opj_image_t* decoded = m_tiled ? probe : m_image;
+
+    // we support only one, three or four components in image
+    const int channelCount = decoded->numcomps;
+    if (channelCount != 1 && channelCount != 3 && channelCount != 4) {
+        errorfmt(
+            "Only images with one, three or four components are supported");
+        if (probe)
+            opj_image_destroy(probe);
+        close();
+        return false;
+    }
+
+    m_bpp.clear();
+    m_bpp.reserve(channelCount);
+    m_comps.resize(channelCount);
+    for (int i = 0; i < channelCount; i++) {
+        const opj_image_comp_t& comp(decoded->comps[i]);
+        m_bpp.push_back(comp.prec);
+        m_maxprecision = std::max(comp.prec, m_maxprecision);
+        // A tile doesn't tell us the whole image's geometry, but then
+        // tiled mode has no subsampling, and components that a palette
+        // added are shaped like the one they came from.
+        const opj_image_comp_t& geom(
+            m_tiled ? m_header->comps[std::min(i, int(m_header->numcomps) - 1)]
+                    : comp);
+        m_comps[i] = { int(geom.x0), int(geom.y0), int(geom.w),
+                       int(geom.h),  int(geom.dx), int(geom.dy) };
+    }
+    m_format = (m_maxprecision <= 8) ? TypeDesc::UINT8 : TypeDesc::UINT16;
+    if (probe)
+        opj_image_destroy(probe);
+
+    setup_level_spec();
+
+    newspec = m_spec;
+    return true;
+}
+
+
+
+bool
+Jpeg2000Input::seek_subimage(int subimage, int miplevel)
+{
+    if (subimage != 0 || miplevel < 0 || miplevel >= m_nmiplevels)
+        return false;
+    if (miplevel == m_miplevel)
+        return true;
+    if (m_image) {
+        opj_image_destroy(m_image);
+        m_image = NULL;
+    }
+    m_miplevel = miplevel;
+    setup_level_spec();
+    return true;
+}
+
+
+
+void
+Jpeg2000Input::setup_level_spec()
+{
+    // Each wavelet reduction halves the reference grid, rounding up, so
+    // that is how the image and component bounds shrink too.
+    int64_t scale = int64_t(1) << m_miplevel;
+    auto reduce   = [=](int64_t v) { return int((v + scale - 1) / scale); };
+
+    const int channelCount = int(m_comps.size());
+    ROI datawindow;
+    m_chans.resize(channelCount);
+    for (int i = 0; i < channelCount; i++) {
+        const CompInfo& comp(m_comps[i]);
+        ChanWindow& win(m_chans[i]);
+        int cx0 = reduce(comp.x0), cy0 = reduce(comp.y0);
+        win.dx  = comp.dx;
+        win.dy  = comp.dy;
+        win.x   = cx0 * win.dx;
+        win.y   = cy0 * win.dy;
+        win.w   = reduce(int64_t(comp.x0) + comp.w) - cx0;
+        win.h   = reduce(int64_t(comp.y0) + comp.h) - cy0;
+        ROI roichan(win.x, win.x + win.w * win.dx, win.y,
+                    win.y + win.h * win.dy);
+        datawindow = roi_union(datawindow, roichan);
+        // std::cout << "  chan " << i << "\n";
+        // std::cout << "     dx=" << comp.dx << " dy=" << comp.dy
+        //           << " x0=" << comp.x0 << " y0=" << comp.y0
+        //           << " w=" << comp.w << " h=" << comp.h << "\n";
+        // std::cout << "     roichan=" << roichan << "\n";
+    }
+    // std::cout << "overall x0=" << m_header->x0 << " y0=" << m_header->y0
+    //           << " x1=" << m_header->x1 << " y1=" << m_header->y1 << "\n";
+    // std::cout << "color_space=" << m_header->color_space << "\n";
+    m_spec = ImageSpec(datawindow.width(), datawindow.height(), channelCount,
+                       m_format);
+    m_spec.x           = datawindow.xbegin;
+    m_spec.y           = datawindow.ybegin;
+    m_spec.full_x      = reduce(m_header->x0);
+    m_spec.full_y      = reduce(m_header->y0);
+    m_spec.full_width  = reduce(m_header->x1);
+    m_spec.full_height = reduce(m_header->y1);
+    if (m_tiled) {
+        m_spec.tile_width  = m_tile_w >> m_miplevel;
+        m_spec.tile_height = m_tile_h >> m_miplevel;
+        m_spec.tile_depth  = 1;
+    }
+
+    m_spec.attribute("oiio:BitsPerSample", m_maxprecision);
+    m_spec.attribute("oiio:ColorSpace", "sRGB");
+
+    if (m_header->icc_profile_len && m_header->icc_profile_buf) {
+        m_spec.attribute("ICCProfile",
+                         TypeDesc(TypeDesc::UINT8, m_header->icc_profile_len),
+                         m_header->icc_profile_buf);
+        std::string errormsg;
+        bool ok = decode_icc_profile(
+            cspan<uint8_t>((const uint8_t*)m_header->icc_profile_buf,
+                           m_header->icc_profile_len),
+            m_spec, errormsg);
+        if (!ok) {
+            // errorfmt("Could not decode ICC profile: {}\n", errormsg);
+            // return false;
+            // Nah, just skip an ICC specific error?
+        }
+    }
+}
+
+
+
+bool
+Jpeg2000Input::start_decode(opj_image_t*& image, int miplevel)
+{
     ioseek(0);
 
     m_codec = create_decompressor();
     if (!m_codec) {
         errorfmt("Could not create Jpeg2000 stream decompressor");
-        close();
         return false;
     }
 
@@ -235,16 +506,15 @@ Jpeg2000Input::open(const std::string& name, ImageSpec& p_spec)
 #if OIIO_OPJ_VERSION >= 20200
     // Set up multithread in OpenJPEG library -- added in OpenJPEG 2.2,
     // but it doesn't seem reliably safe until 2.4.
-    int nthreads = threads();
-    if (!nthreads)
-        nthreads = OIIO::get_int_attribute("threads");
-    opj_codec_set_threads(m_codec, nthreads);
+    // OpenJPEG has its own thread pool that we can't hand jobs to, so at
+    // least don't let it spawn threads when we're already inside one of
+    // ours (see pvt::codec_threads).
+    opj_codec_set_threads(m_codec, pvt::codec_threads(threads()));
 #endif
 
     m_stream = opj_stream_default_create(true /* is_input */);
     if (!m_stream) {
         errorfmt("Could not create Jpeg2000 stream");
-        close();
         return false;
     }
 
@@ -255,143 +525,164 @@ Jpeg2000Input::open(const std::string& name, ImageSpec& p_spec)
     opj_stream_set_user_data_length(m_stream, ioproxy()->size());
     // opj_stream_set_write_function(m_stream, StreamWrite);
 
-    OIIO_ASSERT(m_image == nullptr);
-    if (!opj_read_header(m_stream, m_codec, &m_image) || !m_image
+    if (!opj_read_header(m_stream, m_codec, &image) || !image
         || has_error()) {
         if (!has_error())
             errorfmt("Could not read Jpeg2000 header");
+        return false;
     }
-    if (!has_error()) {
-        if (!opj_decode(m_codec, m_stream, m_image)) {
-            if (!has_error())
-                errorfmt("Could not decode Jpeg2000 data");
-        }
+    if (miplevel > 0
+        && !opj_set_decoded_resolution_factor(m_codec, OPJ_UINT32(miplevel))) {
+        if (!has_error())
+            errorfmt("Could not set Jpeg2000 resolution level {}", miplevel);
+        return false;
     }
+    return true;
+}
 
-    destroy_decompressor();
-    destroy_stream();
 
-    if (has_error()) {
-        close();
-        return false;
+
+bool
+Jpeg2000Input::decode_level()
+{
+    OIIO_ASSERT(m_image == nullptr);
+    bool ok = start_decode(m_image, m_miplevel);
+    if (ok && (!opj_decode(m_codec, m_stream, m_image) || has_error())) {
+        if (!has_error())
+            errorfmt("Could not decode Jpeg2000 data");
+        ok = false;
+    }
+    finish_decode();
+    ok = ok && check_components(m_image);
+    if (!ok && m_image) {
+        opj_image_destroy(m_image);
+        m_image = NULL;
     }
-    OIIO_ASSERT(m_image != nullptr);
+    return ok;
+}
 
-    // we support only one, three or four components in image
-    const int channelCount = m_image->numcomps;
-    if (channelCount != 1 && channelCount != 3 && channelCount != 4) {
-        errorfmt(
-            "Only images with one, three or four components are supported");
-        close();
+
+
+bool
+Jpeg2000Input::check_components(const opj_image_t* image)
+{
+    if (m_comps.size() && image->numcomps != m_comps.size()) {
+        errorfmt("Jpeg2000 decoded {} components, expected {}",
+                 image->numcomps, m_comps.size());
         return false;
     }
-
-    for (int c = 0; c < channelCount; ++c) {
-        const opj_image_comp_t& comp(m_image->comps[c]);
+    for (int c = 0; c < int(image->numcomps); ++c) {
+        const opj_image_comp_t& comp(image->comps[c]);
         if (!comp.data) {
             errorfmt("Could not read Jpeg2000 component, no channel data {}",
                      c);
-            close();
             return false;
         }
     }
-
-    unsigned int maxPrecision = 0;
-    ROI datawindow;
-    m_bpp.clear();
-    m_bpp.reserve(channelCount);
-    std::vector<TypeDesc> chantypes(channelCount, TypeDesc::UINT8);
-    for (int i = 0; i < channelCount; i++) {
-        const opj_image_comp_t& comp(m_image->comps[i]);
-        m_bpp.push_back(comp.prec);
-        maxPrecision = std::max(comp.prec, maxPrecision);
-        ROI roichan(comp.x0, comp.x0 + comp.w * comp.dx, comp.y0,
-                    comp.y0 + comp.h * comp.dy);
-        datawindow = roi_union(datawindow, roichan);
-        // std::cout << "  chan " << i << "\n";
-        // std::cout << "     dx=" << comp.dx << " dy=" << comp.dy
-        //           << " x0=" << comp.x0 << " y0=" << comp.y0
-        //           << " w=" << comp.w << " h=" << comp.h
-        //           << " prec=" << comp.prec << " bpp=" << comp.bpp << "\n";
-        // std::cout << "     sgnd=" << comp.sgnd << " resno_decoded=" << comp.resno_decoded << " factor=" << comp.factor << "\n";
-        // std::cout << "     roichan=" << roichan << "\n";
-    }
-    // std::cout << "overall x0=" << m_image->x0 << " y0=" << m_image->y0
-    //           << " x1=" << m_image->x1 << " y1=" << m_image->y1 << "\n";
-    // std::cout << "color_space=" << m_image->color_space << "\n";
-    TypeDesc format = (maxPrecision <= 8) ? TypeDesc::UINT8 : TypeDesc::UINT16;
-    m_spec   = ImageSpec(datawindow.width(), datawindow.height(), channelCount,
-                         format);
-    m_spec.x = datawindow.xbegin;
-    m_spec.y = datawindow.ybegin;
-    m_spec.full_x      = m_image->x0;
-    m_spec.full_y      = m_image->y0;
-    m_spec.full_width  = m_image->x1;
-    m_spec.full_height = m_image->y1;
-
-    m_spec.attribute("oiio:BitsPerSample", maxPrecision);
-    m_spec.attribute("oiio:ColorSpace", "sRGB");
-
-    if (m_image->icc_profile_len && m_image->icc_profile_buf) {
-        m_spec.attribute("ICCProfile",
-                         TypeDesc(TypeDesc::UINT8, m_image->icc_profile_len),
-                         m_image->icc_profile_buf);
-        std::string errormsg;
-        bool ok = decode_icc_profile(
-            cspan<uint8_t>((const uint8_t*)m_image->icc_profile_buf,
-                           m_image->icc_profile_len),
-            m_spec, errormsg);
-        if (!ok) {
-            // errorfmt("Could not decode ICC profile: {}\n", errormsg);
-            // return false;
-            // Nah, just skip an ICC specific error?
-        }
-    }
-
-    p_spec = m_spec;
     return true;
 }
 
 
 
 bool
-Jpeg2000Input::open(const std::string& name, ImageSpec& newspec,
-                    const ImageSpec& config)
+Jpeg2000Input::read_native_scanline(int subimage, int miplevel, int y, int z,
+                                    void* data)
 {
-    // Check 'config' for any special requests
-    if (config.get_int_attribute("oiio:UnassociatedAlpha", 0) == 1)
-        m_keep_unassociated_alpha = true;
-    ioproxy_retrieve_from_config(config);
-    return open(name, newspec);
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel))
+        return false;
+
+    // Scanline reads of a tiled file, or of another MIP level, decode the
+    // whole level on first use.
+    if (!m_image && !decode_level())
+        return false;
+
+    // The decoded components may be a bit smaller than the windows we
+    // computed from the header, never larger.
+    std::vector<ChanWindow> windows(m_chans);
+    for (int c = 0; c < m_spec.nchannels; ++c) {
+        windows[c].w = std::min(windows[c].w, int(m_image->comps[c].w));
+        windows[c].h = std::min(windows[c].h, int(m_image->comps[c].h));
+    }
+    int xend = m_spec.x + m_spec.width;
+    if (m_spec.format == TypeDesc::UINT8)
+        read_row(m_image, windows.data(), y, m_spec.x, xend, (uint8_t*)data);
+    else
+        read_row(m_image, windows.data(), y, m_spec.x, xend, (uint16_t*)data);
+
+    associate_alpha(data, m_spec.width);
+    return true;
 }
 
 
+
 bool
-Jpeg2000Input::read_native_scanline(int subimage, int miplevel, int y, int z,
-                                    void* data)
+Jpeg2000Input::read_native_tile(int subimage, int miplevel, int x, int y,
+                                int /*z*/, void* data)
 {
     lock_guard lock(*this);
     if (!seek_subimage(subimage, miplevel))
         return false;
+    if (!m_tiled) {
+        errorfmt("Jpeg2000 tiles were not requested for this file");
+        return false;
+    }
+
+    int tx = (x - m_spec.x) / m_spec.tile_width;
+    int ty = (y - m_spec.y) / m_spec.tile_height;
+    opj_image_t* image = nullptr;
+    bool ok = start_decode(image, m_miplevel);
+    if (ok
+        && (!opj_get_decoded_tile(m_codec, m_stream, image,
+                                  OPJ_UINT32(ty * m_ntiles_x + tx))
+            || has_error())) {
+        if (!has_error())
+            errorfmt("Could not decode Jpeg2000 tile ({}, {})", x, y);
+        ok = false;
+    }
+    finish_decode();
+    ok = ok && check_components(image);
+
+    if (ok) {
+        // The decoded image holds just this tile (clipped to the image
+        // edge), at its reduced size.
+        std::vector<ChanWindow> windows(m_spec.nchannels);
+        for (int c = 0; c < m_spec.nchannels; ++c)
+            windows[c] = { x, y, int(image->comps[c].w),
+                           int(image->comps[c].h), 1, 1 };
+        stride_t rowbytes = m_spec.tile_width * m_spec.pixel_bytes(true);
+        for (int j = 0; j < m_spec.tile_height; ++j) {
+            char* row = (char*)data + j * rowbytes;
+            if (m_spec.format == TypeDesc::UINT8)
+                read_row(image, windows.data(), y + j, x,
+                         x + m_spec.tile_width, (uint8_t*)row);
+            else
+                read_row(image, windows.data(), y + j, x,
+                         x + m_spec.tile_width, (uint16_t*)row);
+        }
+        associate_alpha(data, m_spec.tile_pixels());
+    }
+    if (image)
+        opj_image_destroy(image);
+    return ok;
+}
+
 
-    if (m_spec.format == TypeDesc::UINT8)
-        read_scanline<uint8_t>(y, z, data);
-    else
-        read_scanline<uint16_t>(y, z, data);
 
+void
+Jpeg2000Input::associate_alpha(void* data, int npixels)
+{
     // JPEG2000 specifically dictates unassociated (un-"premultiplied") alpha.
     // Convert to associated unless we were requested not to do so.
     if (m_spec.alpha_channel != -1 && !m_keep_unassociated_alpha) {
         float gamma = m_spec.get_float_attribute("oiio:Gamma", 2.2f);
         if (m_spec.format == TypeDesc::UINT16)
-            j2k_associateAlpha((unsigned short*)data, m_spec.width,
+            j2k_associateAlpha((unsigned short*)data, npixels,
                                m_spec.nchannels, m_spec.alpha_channel, gamma);
         else
-            j2k_associateAlpha((unsigned char*)data, m_spec.width,
+            j2k_associateAlpha((unsigned char*)data, npixels,
                                m_spec.nchannels, m_spec.alpha_channel, gamma);
     }
-
-    return true;
 }
 
 
@@ -403,6 +694,10 @@ Jpeg2000Input::close(void)
         opj_image_destroy(m_image);
         m_image = NULL;
     }
+    if (m_header) {
+        opj_image_destroy(m_header);
+        m_header = NULL;
+    }
     destroy_decompressor();
     destroy_stream();
     init();
@@ -456,32 +751,33 @@ Jpeg2000Input::destroy_decompressor()
 
 template<typename T>
 void
-Jpeg2000Input::read_scanline(int y, int /*z*/, void* data)
+Jpeg2000Input::read_row(const opj_image_t* image, const ChanWindow* windows,
+                        int y, int xbegin, int xend, T* data)
 {
-    T* scanline = static_cast<T*>(data);
-    int nc      = m_spec.nchannels;
+    int nc = m_spec.nchannels;
     // It's easier to loop over channels
     int bits = sizeof(T) * 8;
     for (int c = 0; c < nc; ++c) {
-        const opj_image_comp_t& comp(m_image->comps[c]);
-        int chan_ybegin = comp.y0, chan_yend = comp.y0 + comp.h * comp.dy;
-        int chan_xend = comp.w * comp.dx;
-        int yoff      = (y - comp.y0) / comp.dy;
-        for (int x = 0; x < m_spec.width; ++x) {
-            if (yoff < chan_ybegin || yoff >= chan_yend || x > chan_xend) {
+        const opj_image_comp_t& comp(image->comps[c]);
+        const ChanWindow& win(windows[c]);
+        int row     = (y - win.y) / win.dy;
+        bool in_row = (y >= win.y && row < win.h);
+        for (int x = xbegin; x < xend; ++x) {
+            T& out  = data[(x - xbegin) * nc + c];
+            int col = (x - win.x) / win.dx;
+            if (!in_row || x < win.x || col >= win.w) {
                 // Outside the window of this channel
-                scanline[x * nc + c] = T(0);
+                out = T(0);
             } else {
-                unsigned int val = comp.data[yoff * comp.w + x / comp.dx];
+                unsigned int val = comp.data[row * comp.w + col];
                 if (comp.sgnd)
                     val += (1 << (bits / 2 - 1));
-                scanline[x * nc + c] = (T)bit_range_convert(val, comp.prec,
-                                                            bits);
+                out = (T)bit_range_convert(val, comp.prec, bits);
             }
         }
     }
-    if (m_image->color_space == OPJ_CLRSPC_SYCC)
-        yuv_to_rgb(scanline);
+    if (image->color_space == OPJ_CLRSPC_SYCC)
+        yuv_to_rgb(data, xend - xbegin);
 }
 
 
@@ -11,6 +11,8 @@
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imageio.h>
 
+#include "imageio_pvt.h"
+
 #ifndef OIIO_OPJ_VERSION
 #    if defined(OPJ_VERSION_MAJOR)
 // OpenJPEG >= 2.1 defines these symbols
@@ -171,8 +173,9 @@ Jpeg2000Output::open(const std::string& name, const ImageSpec& spec,
     if (!ioproxy_use_or_open(name))
         return false;
 
-    // If user asked for tiles -- which this format doesn't support, emulate
-    // it by buffering the whole image.
+    // If user asked for tiles, the codestream is tiled the same way (see
+    // setup_compression_params), but OpenJPEG wants the whole image at
+    // once, so we emulate tile writes by buffering the whole image.
     if (m_spec.tile_width && m_spec.tile_height)
         m_tilebuffer.resize(m_spec.image_bytes());
 
@@ -311,10 +314,10 @@ Jpeg2000Output::save_image()
 #if OIIO_OPJ_VERSION >= 20400
     // Set up multithread in OpenJPEG library -- added in OpenJPEG 2.2,
     // but it doesn't seem reliably safe until 2.4.
-    int nthreads = threads();
-    if (!nthreads)
-        nthreads = OIIO::get_int_attribute("threads");
-    opj_codec_set_threads(m_codec, nthreads);
+    // OpenJPEG has its own thread pool that we can't hand jobs to, so at
+    // least don't let it spawn threads when we're already inside one of
+    // ours (see pvt::codec_threads).
+    opj_codec_set_threads(m_codec, pvt::codec_threads(threads()));
 #endif
 
     m_stream = opj_stream_default_create(false /* is_input */);
@@ -520,6 +523,17 @@ Jpeg2000Output::setup_compression_params()
     if (is_cinema4k)
         setup_cinema_compression(OPJ_CINEMA4K);
 
+    // Tile the codestream like the spec, with the grid at the image origin,
+    // so that readers can decode one tile at a time.
+    if (m_spec.tile_width && m_spec.tile_height && !is_cinema2k
+        && !is_cinema4k) {
+        m_compression_parameters.tile_size_on = true;
+        m_compression_parameters.cp_tdx       = m_spec.tile_width;
+        m_compression_parameters.cp_tdy       = m_spec.tile_height;
+        m_compression_parameters.cp_tx0       = 0;
+        m_compression_parameters.cp_ty0       = 0;
+    }
+
     const ParamValue* initial_cb_width
         = m_spec.find_attribute("jpeg2000:InitialCodeBlockWidth",
                                 TypeDesc::UINT);
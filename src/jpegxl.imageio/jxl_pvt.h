@@ -0,0 +1,42 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+#pragma once
+
+#include <OpenImageIO/imageio.h>
+
+#include "imageio_pvt.h"
+
+#include <jxl/parallel_runner.h>
+
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+namespace JXL_pvt {
+
+// A JxlParallelRunner that schedules libjxl's internal parallel work onto
+// OIIO's default thread pool instead of libjxl's own threads, so that the
+// "threads" attribute bounds the total CPU use. The runner_opaque must
+// point to an int giving the maximum number of threads (as computed by
+// pvt::codec_threads()).
+inline JxlParallelRetCode
+parallel_runner(void* runner_opaque, void* jpegxl_opaque,
+                JxlParallelRunInit init, JxlParallelRunFunction func,
+                uint32_t start_range, uint32_t end_range)
+{
+    int nthreads = *(const int*)runner_opaque;
+    nthreads = std::max(1, std::min(nthreads, int(end_range - start_range)));
+    JxlParallelRetCode ret = init(jpegxl_opaque, size_t(nthreads));
+    if (ret != 0)
+        return ret;
+    pvt::codec_parallel_run(start_range, end_range, nthreads,
+                            [&](uint32_t value, int thread_id) {
+                                func(jpegxl_opaque, value, size_t(thread_id));
+                            });
+    return 0;
+}
+
+}  // namespace JXL_pvt
+
+OIIO_PLUGIN_NAMESPACE_END
@@ -21,9 +21,10 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/tiffutils.h>
 
+#include "jxl_pvt.h"
+
 #include <jxl/decode.h>
 #include <jxl/decode_cxx.h>
-#include <jxl/resizable_parallel_runner_cxx.h>
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
 
@@ -54,7 +55,7 @@ private:
     int m_next_scanline;  // Which scanline is the next to read?
     uint32_t m_channels;
     JxlDecoderPtr m_decoder;
-    JxlResizableParallelRunnerPtr m_runner;
+    int m_nthreads = 1;  // Threads for libjxl, see JXL_pvt::parallel_runner
     std::unique_ptr<ImageSpec> m_config;  // Saved copy of configuration spec
     std::vector<uint8_t> m_icc_profile;
     std::unique_ptr<uint8_t[]> m_buffer;
@@ -63,9 +64,9 @@ private:
     {
         ioproxy_clear();
         m_config.reset();
-        m_decoder = nullptr;
-        m_runner  = nullptr;
-        m_buffer  = nullptr;
+        m_decoder  = nullptr;
+        m_nthreads = 1;
+        m_buffer   = nullptr;
     }
 
     void close_file() { init(); }
@@ -156,11 +157,6 @@ JxlInput::open(const std::string& name, ImageSpec& newspec)
     }
 
     Filesystem::IOProxy* m_io = ioproxy();
-    std::string proxytype     = m_io->proxytype();
-    if (proxytype != "file" && proxytype != "memreader") {
-        errorfmt("JPEG XL reader can't handle proxy type {}", proxytype);
-        return false;
-    }
 
     m_decoder = JxlDecoderMake(nullptr);
     if (m_decoder == nullptr) {
@@ -168,14 +164,10 @@ JxlInput::open(const std::string& name, ImageSpec& newspec)
         return false;
     }
 
-    m_runner = JxlResizableParallelRunnerMake(nullptr);
-    if (m_runner == nullptr) {
-        DBG std::cout << "JxlThreadParallelRunnerMake failed\n";
-        return false;
-    }
+    m_nthreads = pvt::codec_threads(threads());
 
     JxlDecoderStatus status = JxlDecoderSetParallelRunner(
-        m_decoder.get(), JxlResizableParallelRunner, m_runner.get());
+        m_decoder.get(), JXL_pvt::parallel_runner, &m_nthreads);
     if (status != JXL_DEC_SUCCESS) {
         DBG std::cout << "JxlDecoderSetParallelRunner failed\n";
         return false;
@@ -192,30 +184,24 @@ JxlInput::open(const std::string& name, ImageSpec& newspec)
 
     std::unique_ptr<uint8_t[]> jxl;
 
-    DBG std::cout << "proxytype = " << proxytype << "\n";
-    if (proxytype == "file") {
+    // Decode straight out of a proxy that holds the whole file in memory
+    // (or memory-mapped). Any other proxy, we read the whole file first.
+    cspan<unsigned char> buffer = ioproxy_buffer();
+    DBG std::cout << "proxytype = " << m_io->proxytype() << "\n";
+    if (buffer.empty()) {
         size_t size = m_io->size();
         DBG std::cout << "size = " << size << "\n";
         jxl.reset(new uint8_t[size]);
         size_t result = m_io->read(jxl.get(), size);
         DBG std::cout << "result = " << result << "\n";
-
-        status = JxlDecoderSetInput(m_decoder.get(), jxl.get(), size);
-        if (status != JXL_DEC_SUCCESS) {
-            DBG std::cout << "JxlDecoderSetInput() returned " << status << "\n";
-            return false;
-        }
-        JxlDecoderCloseInput(m_decoder.get());
-
-    } else {
-        auto buffer = reinterpret_cast<Filesystem::IOMemReader*>(m_io)->buffer();
-        status = JxlDecoderSetInput(m_decoder.get(),
-                                    const_cast<unsigned char*>(buffer.data()),
-                                    buffer.size());
-        if (status != JXL_DEC_SUCCESS) {
-            return false;
-        }
+        buffer = cspan<unsigned char>(jxl.get(), result);
+    }
+    status = JxlDecoderSetInput(m_decoder.get(), buffer.data(), buffer.size());
+    if (status != JXL_DEC_SUCCESS) {
+        DBG std::cout << "JxlDecoderSetInput() returned " << status << "\n";
+        return false;
     }
+    JxlDecoderCloseInput(m_decoder.get());
 
     JxlBasicInfo info;
     JxlPixelFormat format;
@@ -270,10 +256,6 @@ JxlInput::open(const std::string& name, ImageSpec& newspec)
             format.num_channels = info.num_color_channels
                                   + info.num_extra_channels;
             m_channels = info.num_color_channels + info.num_extra_channels;
-            JxlResizableParallelRunnerSetThreads(
-                m_runner.get(),
-                JxlResizableParallelRunnerSuggestThreads(info.xsize,
-                                                         info.ysize));
         } else if (status == JXL_DEC_COLOR_ENCODING) {
             DBG std::cout << "JXL_DEC_COLOR_ENCODING\n";
 
@@ -11,9 +11,10 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/tiffutils.h>
 
+#include "jxl_pvt.h"
+
 #include <jxl/encode.h>
 #include <jxl/encode_cxx.h>
-#include <jxl/resizable_parallel_runner_cxx.h>
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
 
@@ -49,7 +50,7 @@ public:
 private:
     std::string m_filename;
     JxlEncoderPtr m_encoder;
-    JxlResizableParallelRunnerPtr m_runner;
+    int m_nthreads = 1;  // Threads for libjxl, see JXL_pvt::parallel_runner
     JxlBasicInfo m_basic_info;
     JxlEncoderFrameSettings* m_frame_settings;
     JxlPixelFormat m_pixel_format;
@@ -62,8 +63,8 @@ private:
     void init(void)
     {
         ioproxy_clear();
-        m_encoder = nullptr;
-        m_runner  = nullptr;
+        m_encoder  = nullptr;
+        m_nthreads = 1;
     }
 
     bool save_image(const void* data);
@@ -131,19 +132,10 @@ JxlOutput::open(const std::string& name, const ImageSpec& newspec,
 
     JxlEncoderAllowExpertOptions(m_encoder.get());
 
-    const uint32_t threads
-        = JxlResizableParallelRunnerSuggestThreads(m_spec.width, m_spec.height);
-
-    m_runner = JxlResizableParallelRunnerMake(nullptr);
-    if (m_runner == nullptr) {
-        DBG std::cout << "JxlThreadParallelRunnerMake failed\n";
-        return false;
-    }
-
-    JxlResizableParallelRunnerSetThreads(m_runner.get(), threads);
-    status = JxlEncoderSetParallelRunner(m_encoder.get(),
-                                         JxlResizableParallelRunner,
-                                         m_runner.get());
+    m_nthreads = pvt::codec_threads(threads());
+    status     = JxlEncoderSetParallelRunner(m_encoder.get(),
+                                             JXL_pvt::parallel_runner,
+                                             &m_nthreads);
 
     if (status != JXL_ENC_SUCCESS) {
         error = JxlEncoderGetError(m_encoder.get());
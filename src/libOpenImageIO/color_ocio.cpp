@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -1699,9 +1700,15 @@ public:
     {
         if (inverse)
             m_M = m_M.inverse();
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                if (i != j && m_M[i][j] != 0.0f)
+                    m_crosstalk = true;
     }
     ~ColorProcessor_Matrix() override {}
 
+    bool hasChannelCrosstalk() const override { return m_crosstalk; }
+
     void apply(float* data, int width, int height, int channels,
                stride_t chanstride, stride_t xstride,
                stride_t ystride) const override
@@ -1746,10 +1753,128 @@ public:
 
 private:
     simd::matrix44 m_M;
+    bool m_crosstalk = false;
+};
+
+
+
+// Lookup tables baked from a ColorProcessor. They are built on demand
+// under the mutex and, once built, never change or move until the
+// processor is destroyed, so callers may use them without locking.
+struct ColorProcessor::BakedLUTs {
+    std::mutex mutex;
+    std::unique_ptr<float[]> lut1d[3];  // UINT8, UINT16, HALF
+    std::vector<std::pair<int, std::unique_ptr<float[]>>> lut3d;
+    bool lut3d_unusable = false;
 };
 
 
 
+ColorProcessor::~ColorProcessor() { delete m_baked.load(); }
+
+
+
+ColorProcessor::BakedLUTs&
+ColorProcessor::baked() const
+{
+    BakedLUTs* b = m_baked.load(std::memory_order_acquire);
+    if (!b) {
+        BakedLUTs* created = new BakedLUTs;
+        if (m_baked.compare_exchange_strong(b, created))
+            b = created;
+        else
+            delete created;  // another thread beat us to it
+    }
+    return *b;
+}
+
+
+
+const float*
+ColorProcessor::lut1d(TypeDesc type, bool bake) const
+{
+    int which = -1;
+    if (type == TypeUInt8)
+        which = 0;
+    else if (type == TypeUInt16)
+        which = 1;
+    else if (type == TypeHalf)
+        which = 2;
+    if (which < 0 || hasChannelCrosstalk())
+        return nullptr;
+    BakedLUTs& b(baked());
+    std::lock_guard<std::mutex> lock(b.mutex);
+    if (!b.lut1d[which] && bake) {
+        // Transform every possible channel value at once, giving each
+        // channel of the pixel the same input.
+        int n = which == 0 ? 256 : 65536;
+        std::unique_ptr<float[]> lut(new float[4 * n]);
+        for (int i = 0; i < n; ++i) {
+            float v = which == 0 ? convert_type<uint8_t, float>(uint8_t(i))
+                    : which == 1 ? convert_type<uint16_t, float>(uint16_t(i))
+                                 : float(bitcast<half>(uint16_t(i)));
+            lut[4 * i + 0] = v;
+            lut[4 * i + 1] = v;
+            lut[4 * i + 2] = v;
+            lut[4 * i + 3] = v;
+        }
+        apply(lut.get(), n, 1, 4, sizeof(float), 4 * sizeof(float),
+              4 * n * sizeof(float));
+        b.lut1d[which] = std::move(lut);
+    }
+    return b.lut1d[which].get();
+}
+
+
+
+const float*
+ColorProcessor::lut3d(int size, bool bake) const
+{
+    if (size < 2 || size > 129)
+        return nullptr;
+    BakedLUTs& b(baked());
+    std::lock_guard<std::mutex> lock(b.mutex);
+    if (b.lut3d_unusable)
+        return nullptr;
+    for (auto& l : b.lut3d)
+        if (l.first == size)
+            return l.second.get();
+    if (!bake)
+        return nullptr;
+
+    // The LUT carries color only, so the transform must pass alpha
+    // through and give the same color regardless of alpha.
+    float probe[3][4] = { { 0.25f, 0.5f, 0.75f, 1.0f },
+                          { 0.25f, 0.5f, 0.75f, 0.5f },
+                          { 0.25f, 0.5f, 0.75f, 0.0f } };
+    apply(&probe[0][0], 3, 1, 4, sizeof(float), 4 * sizeof(float),
+          12 * sizeof(float));
+    for (int p = 1; p < 3; ++p)
+        for (int c = 0; c < 3; ++c)
+            if (probe[p][c] != probe[0][c])
+                b.lut3d_unusable = true;
+    if (probe[0][3] != 1.0f || probe[1][3] != 0.5f || probe[2][3] != 0.0f)
+        b.lut3d_unusable = true;
+    if (b.lut3d_unusable)
+        return nullptr;
+
+    int n = size * size * size;
+    std::unique_ptr<float[]> lut(new float[4 * n]);
+    float scale = 1.0f / float(size - 1);
+    for (int i = 0; i < n; ++i) {
+        lut[4 * i + 0] = float(i % size) * scale;
+        lut[4 * i + 1] = float((i / size) % size) * scale;
+        lut[4 * i + 2] = float(i / (size * size)) * scale;
+        lut[4 * i + 3] = 1.0f;
+    }
+    apply(lut.get(), n, 1, 4, sizeof(float), 4 * sizeof(float),
+          4 * n * sizeof(float));
+    b.lut3d.emplace_back(size, std::move(lut));
+    return b.lut3d.back().second.get();
+}
+
+
+
 ColorProcessorHandle
 ColorConfig::createColorProcessor(string_view inputColorSpace,
                                   string_view outputColorSpace,
@@ -2411,7 +2536,7 @@ colorconvert_impl(ImageBuf& R, const ImageBuf& A,
                         r.rerange(roi.xbegin, roi.xend, j, j + 1, k, k + 1);
                         for (; !r.done(); ++r, ++a)
                             for (int c = channelsToCopy; c < roi.chend; ++c)
-                                r[c] = 0.5 + 10 * a[c];
+                                r[c] = a[c];
                     }
                 }
             }
@@ -2423,61 +2548,59 @@ colorconvert_impl(ImageBuf& R, const ImageBuf& A,
 
 
 // Specialized version where both buffers are in memory (not cache based),
-// float data, and we are dealing with 4 channels.
+// with contiguous float or half pixels of 3 or 4 channels. A float
+// destination is transformed right in its own memory, and half pixels are
+// converted a whole scanline at a time, so nothing is copied per pixel.
 static bool
-colorconvert_impl_float_rgba(ImageBuf& R, const ImageBuf& A,
-                             const ColorProcessor* processor, bool unpremult,
-                             ROI roi, int nthreads)
+colorconvert_impl_local(ImageBuf& R, const ImageBuf& A,
+                        const ColorProcessor* processor, bool unpremult,
+                        ROI roi, int nthreads)
 {
     using namespace ImageBufAlgo;
-    using namespace simd;
-    OIIO_ASSERT(R.localpixels() && A.localpixels()
-                && R.spec().format == TypeFloat && A.spec().format == TypeFloat
-                && R.nchannels() == 4 && A.nchannels() == 4);
+    const int nc = R.nchannels();
+    OIIO_ASSERT(R.localpixels() && A.localpixels() && A.nchannels() == nc
+                && (nc == 3 || nc == 4));
+    const bool Rfloat = R.spec().format == TypeFloat;
+    const bool Afloat = A.spec().format == TypeFloat;
+    if (nc < 4)
+        unpremult = false;
     parallel_image(roi, parallel_options(nthreads), [&](ROI roi) {
-        int width = roi.width();
-        // Temporary space to hold one RGBA scanline
-        vfloat4* scanline;
-        OIIO_ALLOCATE_STACK_OR_HEAP(scanline, vfloat4, width);
-        float* alpha;
-        OIIO_ALLOCATE_STACK_OR_HEAP(alpha, float, width);
-        const float fltmin = std::numeric_limits<float>::min();
+        int width    = roi.width();
+        size_t nvals = size_t(width) * nc;
+        // Float scanline to work in, needed only for a half destination
+        float* scratch;
+        OIIO_ALLOCATE_STACK_OR_HEAP(scratch, float, Rfloat ? 0 : nvals);
         for (int k = roi.zbegin; k < roi.zend; ++k) {
             for (int j = roi.ybegin; j < roi.yend; ++j) {
                 // Load the scanline
-                memcpy((void*)scanline, A.pixeladdr(roi.xbegin, j, k),
-                       width * 4 * sizeof(float));
-                // Optionally unpremult
-                if (unpremult) {
-                    for (int i = 0; i < width; ++i) {
-                        vfloat4 p(scanline[i]);
-                        float a  = extract<3>(p);
-                        alpha[i] = a;
-                        a        = a >= fltmin ? a : 1.0f;
-                        if (a == 1.0f)
-                            scanline[i] = p;
-                        else
-                            scanline[i] = p / vfloat4(a, a, a, 1.0f);
-                    }
-                }
+                const void* src = A.pixeladdr(roi.xbegin, j, k);
+                float* line     = scratch;
+                if (Rfloat)
+                    line = (float*)R.pixeladdr(roi.xbegin, j, k);
+                if (!Afloat)
+                    convert_type((const half*)src, line, nvals);
+                else if (line != src)
+                    memcpy(line, src, nvals * sizeof(float));
+
+                // Optionally unpremult. Be careful of alpha==0 pixels,
+                // preserve their color rather than div-by-zero.
+                if (unpremult)
+                    pvt::premult_span(TypeFloat, line, width, nc,
+                                      nc * sizeof(float), 0, nc, 3, -1, true);
 
                 // Apply the color transformation in place
-                processor->apply((float*)&scanline[0], width, 1, 4,
-                                 sizeof(float), 4 * sizeof(float),
-                                 width * 4 * sizeof(float));
-
-                // Optionally premult
-                if (unpremult) {
-                    for (int i = 0; i < width; ++i) {
-                        vfloat4 p(scanline[i]);
-                        float a = alpha[i];
-                        a       = a >= fltmin ? a : 1.0f;
-                        p *= vfloat4(a, a, a, 1.0f);
-                        scanline[i] = p;
-                    }
-                }
-                memcpy(R.pixeladdr(roi.xbegin, j, k), scanline,
-                       width * 4 * sizeof(float));  //NOSONAR
+                processor->apply(line, width, 1, nc, sizeof(float),
+                                 nc * sizeof(float), nvals * sizeof(float));
+
+                // Optionally re-premult, again leaving alpha==0 pixels be.
+                if (unpremult)
+                    pvt::premult_span(TypeFloat, line, width, nc,
+                                      nc * sizeof(float), 0, nc, 3, -1, false,
+                                      true);
+
+                if (!Rfloat)
+                    convert_type(line, (half*)R.pixeladdr(roi.xbegin, j, k),
+                                 nvals);
             }
         }
     });
@@ -2486,6 +2609,114 @@ colorconvert_impl_float_rgba(ImageBuf& R, const ImageBuf& A,
 
 
 
+// Index of a channel value into ColorProcessor::lut1d().
+template<class T>
+inline int
+lut1d_index(T v)
+{
+    return int(v);
+}
+
+inline int
+lut1d_index(half v)
+{
+    return bitcast<uint16_t>(v);
+}
+
+
+
+// Tetrahedral interpolation of an RGB color in [0,1]^3 into a 3D LUT from
+// ColorProcessor::lut3d(). The cube cell around the color is split into
+// six tetrahedra along its main diagonal, and the one containing the color
+// is chosen by the ordering of its fractional position along each axis.
+static inline simd::vfloat4
+lut3d_lookup(const float* lut, int size, const simd::vfloat4& rgb)
+{
+    using namespace simd;
+    vfloat4 p = rgb * float(size - 1);
+    vint4 i   = min(ifloor(p), vint4(size - 2));
+    vfloat4 f = p - vfloat4(i);
+    float fr = f[0], fg = f[1], fb = f[2];
+    const int sr = 4, sg = 4 * size, sb = 4 * size * size;
+    const float* c = lut + i[0] * sr + i[1] * sg + i[2] * sb;
+    vfloat4 c000(c), c111(c + sr + sg + sb);
+    if (fr > fg) {
+        if (fg > fb) {
+            vfloat4 c100(c + sr), c110(c + sr + sg);
+            return c000 + fr * (c100 - c000) + fg * (c110 - c100)
+                   + fb * (c111 - c110);
+        } else if (fr > fb) {
+            vfloat4 c100(c + sr), c101(c + sr + sb);
+            return c000 + fr * (c100 - c000) + fb * (c101 - c100)
+                   + fg * (c111 - c101);
+        } else {
+            vfloat4 c001(c + sb), c101(c + sr + sb);
+            return c000 + fb * (c001 - c000) + fr * (c101 - c001)
+                   + fg * (c111 - c101);
+        }
+    } else {
+        if (fb > fg) {
+            vfloat4 c001(c + sb), c011(c + sg + sb);
+            return c000 + fb * (c001 - c000) + fg * (c011 - c001)
+                   + fr * (c111 - c011);
+        } else if (fb > fr) {
+            vfloat4 c010(c + sg), c011(c + sg + sb);
+            return c000 + fg * (c010 - c000) + fb * (c011 - c010)
+                   + fr * (c111 - c011);
+        } else {
+            vfloat4 c010(c + sg), c110(c + sr + sg);
+            return c000 + fg * (c010 - c000) + fr * (c110 - c010)
+                   + fb * (c111 - c110);
+        }
+    }
+}
+
+
+
+// Version for UINT8, UINT16, and HALF sources (without unpremultiplying)
+// that replaces the transform with lookups into tables baked from it:
+// exactly through lut1d, one channel at a time, or else by interpolating
+// the color in lut3d and passing alpha through.
+template<class Rtype, class Atype>
+static bool
+colorconvert_lut_impl(ImageBuf& R, const ImageBuf& A, const float* lut1d,
+                      const float* lut3d, int lut3d_size, ROI roi,
+                      int nthreads)
+{
+    using namespace ImageBufAlgo;
+    using namespace simd;
+    int channelsToCopy = std::min(4, roi.nchannels());
+    parallel_image(roi, parallel_options(nthreads), [&](ROI roi) {
+        ImageBuf::ConstIterator<Atype> a(A, roi);
+        ImageBuf::Iterator<Rtype> r(R, roi);
+        for (; !r.done(); ++r, ++a) {
+            if (lut1d) {
+                const Atype* p = (const Atype*)a.rawptr();
+                for (int c = 0; c < channelsToCopy; ++c)
+                    r[c] = lut1d[4 * lut1d_index(p[c]) + c];
+            } else {
+                vfloat4 v(0.0f);
+                for (int c = 0; c < channelsToCopy; ++c)
+                    v[c] = a[c];
+                if (channelsToCopy == 1)
+                    v[2] = v[1] = v[0];
+                vfloat4 x = lut3d_lookup(lut3d, lut3d_size, v);
+                for (int c = 0; c < std::min(3, channelsToCopy); ++c)
+                    r[c] = x[c];
+                if (channelsToCopy == 4)
+                    r[3] = v[3];
+            }
+            // Copy any "leftover" channels unaltered from the source.
+            if (&R != &A)
+                for (int c = channelsToCopy; c < roi.chend; ++c)
+                    r[c] = a[c];
+        }
+    });
+    return true;
+}
+
+
+
 bool
 ImageBufAlgo::colorconvert(ImageBuf& dst, const ImageBuf& src,
                            const ColorProcessor* processor, bool unpremult,
@@ -2506,6 +2737,7 @@ ImageBufAlgo::colorconvert(ImageBuf& dst, const ImageBuf& src,
 
     if (!IBAprep(roi, &dst, &src))
         return false;
+    TypeDesc srctype = src.spec().format;
 
     // If the processor is a no-op (and it's not an in-place conversion),
     // use copy() to simplify the operation.
@@ -2520,12 +2752,56 @@ ImageBufAlgo::colorconvert(ImageBuf& dst, const ImageBuf& src,
         // unassociated alpha, don't do a redundant unpremult step.
         unpremult = false;
     }
+    if (ComputeBackend* backend = compute_backend())
+        if (backend->colorconvert(dst, src, processor, unpremult, roi,
+                                  nthreads))
+            return true;
+
+    // For UINT8, UINT16, and HALF sources, there are few enough distinct
+    // channel values that a transform without channel crosstalk can be
+    // baked (once per processor) into exact 1D tables. Transforms that mix
+    // channels may instead use an interpolated 3D LUT for integer sources,
+    // but only if the app asked for that approximation.
+    if ((srctype == TypeUInt8 || srctype == TypeUInt16 || srctype == TypeHalf)
+        && roi.chbegin == 0 && (!unpremult || roi.nchannels() < 4)) {
+        const float* lut1d  = nullptr;
+        const float* lut3d  = nullptr;
+        int lut3d_size      = pvt::colorconvert_lut3d;
+        imagesize_t npixels = roi.npixels();
+        // Only bake tables for images with at least as many pixels as the
+        // table has entries, but use any that are already baked.
+        if (!processor->hasChannelCrosstalk()) {
+            imagesize_t entries = srctype == TypeUInt8 ? 256 : 65536;
+            lut1d = processor->lut1d(srctype, npixels >= entries);
+        } else if (lut3d_size && srctype != TypeHalf) {
+            imagesize_t entries = imagesize_t(lut3d_size) * lut3d_size
+                                  * lut3d_size;
+            lut3d = processor->lut3d(lut3d_size, npixels >= entries);
+        }
+        if (lut1d || lut3d) {
+            bool ok = true;
+            OIIO_DISPATCH_COMMON_TYPES2(ok, "colorconvert",
+                                        colorconvert_lut_impl,
+                                        dst.spec().format, srctype, dst, src,
+                                        lut1d, lut3d, lut3d_size, roi,
+                                        nthreads);
+            return ok;
+        }
+    }
 
-    if (dst.localpixels() && src.localpixels() && dst.spec().format == TypeFloat
-        && src.spec().format == TypeFloat && dst.nchannels() == 4
-        && src.nchannels() == 4) {
-        return colorconvert_impl_float_rgba(dst, src, processor, unpremult, roi,
-                                            nthreads);
+    // Local float and half images of 3 or 4 contiguous channels can be
+    // transformed a scanline at a time, without per-pixel iterators.
+    TypeDesc dstfmt = dst.spec().format;
+    int nc          = dst.nchannels();
+    if (dst.localpixels() && src.localpixels()
+        && (dstfmt == TypeFloat || dstfmt == TypeHalf)
+        && (srctype == TypeFloat || srctype == TypeHalf)
+        && (nc == 3 || nc == 4) && src.nchannels() == nc && roi.chbegin == 0
+        && roi.chend == nc && src.roi().contains(roi)
+        && dst.pixel_stride() == stride_t(nc * dstfmt.size())
+        && src.pixel_stride() == stride_t(nc * srctype.size())) {
+        return colorconvert_impl_local(dst, src, processor, unpremult, roi,
+                                       nthreads);
     }
 
     bool ok = true;
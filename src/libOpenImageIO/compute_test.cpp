@@ -10,6 +10,7 @@
 //
 
 
+#include <atomic>
 #include <iostream>
 
 #include <OpenImageIO/argparse.h>
@@ -133,6 +134,82 @@ test_IBA(ROI roi, int threads)
 
 
 
+// A stand-in for a GPU ComputeBackend. It takes mad() of whole, local,
+// float images, the way a device backend would take images in memory it
+// can reach, and declines everything else.
+class TestBackend final : public ImageBufAlgo::ComputeBackend {
+public:
+    const char* name() const override { return "test"; }
+
+    bool mad(ImageBuf& dst, const Image_or_Const& A, const Image_or_Const& B,
+             const Image_or_Const& C, ROI roi, int nthreads) override
+    {
+        if (!A.is_img() || !B.is_img() || !C.is_img())
+            return false;
+        const ImageBuf* imgs[] = { &dst, A.imgptr(), B.imgptr(), C.imgptr() };
+        for (const ImageBuf* img : imgs)
+            if (img->spec().format != TypeFloat || !img->localpixels()
+                || img->roi() != roi)
+                return false;
+        ++calls;
+        const float* a = (const float*)A.img().localpixels();
+        const float* b = (const float*)B.img().localpixels();
+        const float* c = (const float*)C.img().localpixels();
+        float* r       = (float*)dst.localpixels();
+        int64_t rowlen = int64_t(roi.width()) * roi.nchannels();
+        ImageBufAlgo::parallel_image(roi, nthreads, [=](ROI strip) {
+            int64_t begin = (strip.ybegin - roi.ybegin) * rowlen;
+            int64_t end   = (strip.yend - roi.ybegin) * rowlen;
+            for (int64_t i = begin; i < end; ++i)
+                r[i] = a[i] * b[i] + c[i];
+        });
+        return true;
+    }
+
+    std::atomic<int> calls { 0 };
+};
+
+
+
+// Route IBA::mad through a ComputeBackend, and make sure that operations
+// it declines still run on the CPU.
+void
+test_compute_backend()
+{
+    Benchmarker bench;
+    bench.iterations(iterations);
+    bench.trials(ntrials);
+    bench.work(xres * yres * channels);
+    bench.units(Benchmarker::Unit::ms);
+
+    ROI roi(0, xres, 0, yres, 0, 1, 0, channels);
+
+    TestBackend backend;
+    auto prev = ImageBufAlgo::set_compute_backend(&backend);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compute_backend(), &backend);
+
+    ImageBufAlgo::zero(imgR);
+    bench("IBA::mad via ComputeBackend", test_IBA, roi, numthreads);
+    OIIO_CHECK_ASSERT(backend.calls > 0);
+    OIIO_CHECK_EQUAL_THRESH(imgR.getchannel(xres / 2, yres / 2, 0, 0), 0.25,
+                            0.001);
+    OIIO_CHECK_EQUAL_THRESH(imgR.getchannel(xres / 2, yres / 2, 0, 1), 0.25,
+                            0.001);
+    OIIO_CHECK_EQUAL_THRESH(imgR.getchannel(xres / 2, yres / 2, 0, 2), 0.50,
+                            0.001);
+
+    ImageBuf sum = ImageBufAlgo::add(imgA, imgB);
+    OIIO_CHECK_EQUAL_THRESH(sum.getchannel(xres / 2, yres / 2, 0, 0), 0.50,
+                            0.001);
+    OIIO_CHECK_EQUAL_THRESH(sum.getchannel(xres / 2, yres / 2, 0, 2), 0.50,
+                            0.001);
+
+    ImageBufAlgo::set_compute_backend(prev);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compute_backend(), prev);
+}
+
+
+
 void
 test_compute()
 {
@@ -277,6 +354,7 @@ main(int argc, char* argv[])
     // imgB.write ("B.exr");
 
     test_compute();
+    test_compute_backend();
 
     return unit_test_failures;
 }
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <memory>
 #include <numeric>
 
 #include <OpenImageIO/half.h>
@@ -821,6 +822,157 @@ DeepData::set_deep_value(int64_t pixel, int channel, int sample, uint32_t value)
 
 
 
+// Gather channel values of the pixel range, which is laid out as
+// interleaved samples, into a contiguous float array.
+template<typename T>
+static void
+gather_channel(const char* data, const size_t* pixoffsets,
+               const unsigned int* nsamples, int64_t npixels,
+               size_t samplesize, float* values)
+{
+    for (int64_t p = 0; p < npixels; ++p) {
+        const char* d = data + pixoffsets[p];
+        for (unsigned int s = 0, n = nsamples[p]; s < n;
+             ++s, d += samplesize)
+            *values++ = convert_type<T, float>(*(const T*)d);
+    }
+}
+
+
+
+template<typename T>
+static void
+scatter_channel(char* data, const size_t* pixoffsets,
+                const unsigned int* nsamples, int64_t npixels,
+                size_t samplesize, const float* values)
+{
+    for (int64_t p = 0; p < npixels; ++p) {
+        char* d = data + pixoffsets[p];
+        for (unsigned int s = 0, n = nsamples[p]; s < n;
+             ++s, d += samplesize)
+            *(T*)d = convert_type<float, T>(*values++);
+    }
+}
+
+
+
+int64_t
+DeepData::total_samples(int64_t pixelbegin, int64_t pixelend) const
+{
+    if (!m_impl)
+        return 0;
+    if (pixelend < 0)
+        pixelend = m_npixels;
+    pixelbegin = clamp(pixelbegin, int64_t(0), m_npixels);
+    pixelend   = clamp(pixelend, pixelbegin, m_npixels);
+    const unsigned int* n = m_impl->m_nsamples.data();
+    return std::accumulate(n + pixelbegin, n + pixelend, int64_t(0));
+}
+
+
+
+bool
+DeepData::get_channel_values(int channel, span<float> values,
+                             int64_t pixelbegin, int64_t pixelend) const
+{
+    if (!m_impl || channel < 0 || channel >= m_nchannels)
+        return false;
+    if (pixelend < 0)
+        pixelend = m_npixels;
+    if (pixelbegin < 0 || pixelbegin > pixelend || pixelend > m_npixels)
+        return false;
+    if (int64_t(values.size()) < total_samples(pixelbegin, pixelend))
+        return false;
+    if (pixelbegin == pixelend)
+        return true;
+    m_impl->alloc(m_npixels);
+    int64_t npixels = pixelend - pixelbegin;
+    // Byte offset of this channel's first sample, for every pixel
+    std::unique_ptr<size_t[]> offsets(new size_t[npixels]);
+    for (int64_t p = 0; p < npixels; ++p)
+        offsets[p] = m_impl->data_offset(pixelbegin + p, channel, 0);
+    const char* data = m_impl->m_data.data();
+    const unsigned int* nsamps = m_impl->m_nsamples.data() + pixelbegin;
+    size_t ss                  = samplesize();
+    float* v                   = values.data();
+    switch (channeltype(channel).basetype) {
+    case TypeDesc::FLOAT:
+        gather_channel<float>(data, offsets.get(), nsamps, npixels, ss, v);
+        break;
+    case TypeDesc::HALF:
+        gather_channel<half>(data, offsets.get(), nsamps, npixels, ss, v);
+        break;
+    case TypeDesc::UINT:
+        gather_channel<uint32_t>(data, offsets.get(), nsamps, npixels, ss, v);
+        break;
+    case TypeDesc::UINT8:
+        gather_channel<uint8_t>(data, offsets.get(), nsamps, npixels, ss, v);
+        break;
+    case TypeDesc::UINT16:
+        gather_channel<uint16_t>(data, offsets.get(), nsamps, npixels, ss, v);
+        break;
+    default:
+        // Uncommon types go the slow way, one value at a time
+        for (int64_t p = pixelbegin; p < pixelend; ++p)
+            for (int s = 0, n = samples(p); s < n; ++s)
+                *v++ = deep_value(p, channel, s);
+        break;
+    }
+    return true;
+}
+
+
+
+bool
+DeepData::set_channel_values(int channel, cspan<float> values,
+                             int64_t pixelbegin, int64_t pixelend)
+{
+    if (!m_impl || channel < 0 || channel >= m_nchannels)
+        return false;
+    if (pixelend < 0)
+        pixelend = m_npixels;
+    if (pixelbegin < 0 || pixelbegin > pixelend || pixelend > m_npixels)
+        return false;
+    if (int64_t(values.size()) < total_samples(pixelbegin, pixelend))
+        return false;
+    if (pixelbegin == pixelend)
+        return true;
+    m_impl->alloc(m_npixels);
+    int64_t npixels = pixelend - pixelbegin;
+    std::unique_ptr<size_t[]> offsets(new size_t[npixels]);
+    for (int64_t p = 0; p < npixels; ++p)
+        offsets[p] = m_impl->data_offset(pixelbegin + p, channel, 0);
+    char* data                 = m_impl->m_data.data();
+    const unsigned int* nsamps = m_impl->m_nsamples.data() + pixelbegin;
+    size_t ss                  = samplesize();
+    const float* v             = values.data();
+    switch (channeltype(channel).basetype) {
+    case TypeDesc::FLOAT:
+        scatter_channel<float>(data, offsets.get(), nsamps, npixels, ss, v);
+        break;
+    case TypeDesc::HALF:
+        scatter_channel<half>(data, offsets.get(), nsamps, npixels, ss, v);
+        break;
+    case TypeDesc::UINT:
+        scatter_channel<uint32_t>(data, offsets.get(), nsamps, npixels, ss, v);
+        break;
+    case TypeDesc::UINT8:
+        scatter_channel<uint8_t>(data, offsets.get(), nsamps, npixels, ss, v);
+        break;
+    case TypeDesc::UINT16:
+        scatter_channel<uint16_t>(data, offsets.get(), nsamps, npixels, ss, v);
+        break;
+    default:
+        for (int64_t p = pixelbegin; p < pixelend; ++p)
+            for (int s = 0, n = samples(p); s < n; ++s)
+                set_deep_value(p, channel, s, *v++);
+        break;
+    }
+    return true;
+}
+
+
+
 cspan<TypeDesc>
 DeepData::all_channeltypes() const
 {
@@ -950,6 +1102,26 @@ DeepData::copy_deep_pixel(int64_t pixel, const DeepData& src, int64_t srcpixel)
 
 
 
+// Read channel c of the first n samples of a pixel into vals[]. Float
+// channels (by far the most common for Z and alpha) are read directly
+// rather than going through deep_value's per-value type dispatch.
+static void
+pixel_channel_values(const DeepData& dd, int64_t pixel, int c, int n,
+                     float* vals)
+{
+    if (n > 0 && dd.channeltype(c) == TypeFloat) {
+        const char* p = (const char*)dd.data_ptr(pixel, c, 0);
+        size_t stride = dd.samplesize();
+        for (int s = 0; s < n; ++s, p += stride)
+            vals[s] = *(const float*)p;
+    } else {
+        for (int s = 0; s < n; ++s)
+            vals[s] = dd.deep_value(pixel, c, s);
+    }
+}
+
+
+
 bool
 DeepData::split(int64_t pixel, float depth)
 {
@@ -962,6 +1134,20 @@ DeepData::split(int64_t pixel, float depth)
         return false;  // No channel labeled Z -- we don't know what to do
     if (zbackchan < 0)
         return false;  // The samples are not extended -- nothing to split
+    // Quick rejection: most calls (for example, every depth tried by
+    // merge_deep_pixels) find no sample straddling the depth.
+    {
+        int n     = samples(pixel);
+        float* zf = OIIO_ALLOCA(float, 2 * n);
+        float* zb = zf + n;
+        pixel_channel_values(*this, pixel, zchan, n, zf);
+        pixel_channel_values(*this, pixel, zbackchan, n, zb);
+        bool any = false;
+        for (int s = 0; s < n; ++s)
+            any |= (zf[s] < depth && zb[s] > depth);
+        if (!any)
+            return false;
+    }
     int nchans = channels();
     for (int s = 0; s < samples(pixel); ++s) {
         float zf = deep_value(pixel, zchan, s);      // z front
@@ -1025,63 +1211,53 @@ DeepData::split(int64_t pixel, float depth)
 
 
 
-namespace {
-
-// Comparator functor for depth sorting sample indices of a deep pixel.
-class SampleComparator {
-public:
-    SampleComparator(const DeepData& dd, int pixel, int zchan, int zbackchan)
-        : deepdata(dd)
-        , pixel(pixel)
-        , zchan(zchan)
-        , zbackchan(zbackchan)
-    {
-    }
-    bool operator()(int i, int j) const
-    {
-        // If either has a lower z, that's the lower
-        float iz = deepdata.deep_value(pixel, zchan, i);
-        float jz = deepdata.deep_value(pixel, zchan, j);
-        if (iz < jz)
-            return true;
-        if (iz > jz)
-            return false;
-        // If both z's are equal, sort based on zback
-        float izb = deepdata.deep_value(pixel, zbackchan, i);
-        float jzb = deepdata.deep_value(pixel, zbackchan, j);
-        return izb < jzb;
-    }
-
-private:
-    const DeepData& deepdata;
-    int pixel;
-    int zchan, zbackchan;
-};
-
-}  // namespace
-
-
-
 void
 DeepData::sort(int64_t pixel)
 {
     int zchan = m_impl->m_z_channel;
     if (zchan < 0)
         return;  // No channel labeled Z -- we don't know what to do
-    int zbackchan = m_impl->m_z_channel;
+    int zbackchan = m_impl->m_zback_channel;
     if (zbackchan < 0)
         zbackchan = zchan;
     int nsamples = samples(pixel);
     if (nsamples < 2)
         return;  // 0 or 1 samples -- no sort necessary
 
+    // Gather the sort keys once, and don't bother if already in order
+    // (which is the usual case for rendered deep images).
+    float* z  = OIIO_ALLOCA(float, 2 * nsamples);
+    float* zb = z + nsamples;
+    pixel_channel_values(*this, pixel, zchan, nsamples, z);
+    pixel_channel_values(*this, pixel, zbackchan, nsamples, zb);
+    auto less = [=](int i, int j) {
+        // If either has a lower z, that's the lower. If both z's are equal,
+        // sort based on zback.
+        return z[i] < z[j] || (z[i] == z[j] && zb[i] < zb[j]);
+    };
+    bool sorted = true;
+    for (int i = 1; i < nsamples && sorted; ++i)
+        sorted = !less(i, i - 1);
+    if (sorted)
+        return;
+
     // Ick, std::sort and friends take a custom comparator, but not a custom
     // swapper, so there's no way to std::sort a data type whose size is not
-    // known at compile time. So we just sort the indices!
+    // known at compile time. So we just sort the indices! Deep pixels
+    // usually have only a handful of samples, for which a (stable)
+    // insertion sort beats the general algorithm.
     int* sample_indices = OIIO_ALLOCA(int, nsamples);
     std::iota(sample_indices, sample_indices + nsamples, 0);
-    std::stable_sort(sample_indices, sample_indices + nsamples,
-                     SampleComparator(*this, pixel, zchan, zbackchan));
+    if (nsamples <= 16) {
+        for (int i = 1; i < nsamples; ++i) {
+            int v = sample_indices[i], j = i;
+            for (; j > 0 && less(v, sample_indices[j - 1]); --j)
+                sample_indices[j] = sample_indices[j - 1];
+            sample_indices[j] = v;
+        }
+    } else {
+        std::stable_sort(sample_indices, sample_indices + nsamples, less);
+    }
 
     // Now copy around using a temp buffer
     size_t samplebytes = samplesize();
@@ -1104,6 +1280,19 @@ DeepData::merge_overlaps(int64_t pixel)
         return;  // No channel labeled Z -- we don't know what to do
     if (zbackchan < 0)
         zbackchan = zchan;  // Missing Zback -- use Z
+    // Quick rejection if no adjacent samples share the same z range.
+    {
+        int n     = samples(pixel);
+        float* zf = OIIO_ALLOCA(float, 2 * n);
+        float* zb = zf + n;
+        pixel_channel_values(*this, pixel, zchan, n, zf);
+        pixel_channel_values(*this, pixel, zbackchan, n, zb);
+        bool any = false;
+        for (int s = 1; s < n; ++s)
+            any |= (zf[s] == zf[s - 1] && zb[s] == zb[s - 1]);
+        if (!any)
+            return;
+    }
     int nchans = channels();
     for (int s = 1 /* YES, 1 */; s < samples(pixel); ++s) {
         float zf = deep_value(pixel, zchan, s);      // z front
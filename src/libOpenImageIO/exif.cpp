@@ -1240,6 +1240,45 @@ decode_exif(cspan<uint8_t> exif, ImageSpec& spec)
 
 
 
+string_view
+metadata_hint(const ImageSpec& config)
+{
+    string_view hint = config.get_string_attribute("oiio:metadata");
+    for (string_view h : { "none", "basic", "lazy" })
+        if (Strutil::iequals(hint, h))
+            return h;
+    return "all";
+}
+
+
+
+bool
+decode_raw_metadata(ImageSpec& spec)
+{
+    // Copy each block out and erase it before decoding, since decoding
+    // adds attributes and may move the one we're reading from.
+    std::vector<uint8_t> data;
+    auto take = [&](string_view name) {
+        const ParamValue* p = spec.find_attribute(name);
+        if (!p || p->type().basetype != TypeDesc::UINT8)
+            return false;
+        const uint8_t* d = (const uint8_t*)p->data();
+        data.assign(d, d + p->type().basevalues());
+        spec.erase_attribute(name);
+        return true;
+    };
+    bool ok = true;
+    if (take("oiio:RawExif"))
+        ok &= decode_exif(data, spec);
+    if (take("oiio:RawIPTC"))
+        ok &= decode_iptc_iim(data.data(), int(data.size()), spec);
+    if (take("oiio:RawXMP"))
+        ok &= decode_xmp(cspan<uint8_t>(data), spec);
+    return ok;
+}
+
+
+
 // DEPRECATED (1.8)
 bool
 decode_exif(const void* exif, int length, ImageSpec& spec)
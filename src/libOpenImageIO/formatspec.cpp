@@ -1182,6 +1182,302 @@ ImageSpec::from_xml(const char* xml)
 
 
 
+// The binary encoding of an ImageSpec. Numbers are little endian.
+//
+//     "OISB", uint32 version
+//     int32 x, y, z, width, height, depth, full_x, full_y, full_z,
+//           full_width, full_height, full_depth, tile_width, tile_height,
+//           tile_depth
+//     type format, int32 nchannels, alpha_channel, z_channel, uint8 deep
+//     uint32 n, then n types         (channelformats)
+//     uint32 n, then n strings       (channelnames)
+//     uint32 n, then n attributes    (extra_attribs)
+//
+// A type is uint8 basetype, aggregate, vecsemantics, reserved, and int32
+// arraylen. A string is a uint32 length and that many bytes. An attribute
+// is its name string, type, int32 nvalues, uint8 interp, and then its
+// values: a string each for string and ustringhash types, or else the
+// raw data. A reader rejects encodings of a later version than its own.
+namespace {
+
+const char spec_binary_magic[4]        = { 'O', 'I', 'S', 'B' };
+constexpr uint32_t spec_binary_version = 1;
+
+// Swap each of the n elements of size elsize in place.
+inline void
+swap_elements(void* data, size_t elsize, size_t n)
+{
+    if (elsize == 2)
+        swap_endian((uint16_t*)data, int(n));
+    else if (elsize == 4)
+        swap_endian((uint32_t*)data, int(n));
+    else if (elsize == 8)
+        swap_endian((uint64_t*)data, int(n));
+}
+
+
+
+struct SpecWriter {
+    std::vector<unsigned char>& out;
+
+    void bytes(const void* data, size_t size)
+    {
+        const unsigned char* p = (const unsigned char*)data;
+        out.insert(out.end(), p, p + size);
+    }
+    template<typename T> void num(T val)
+    {
+        if (bigendian())
+            swap_elements(&val, sizeof(T), 1);
+        bytes(&val, sizeof(T));
+    }
+    void str(string_view s)
+    {
+        num(uint32_t(s.size()));
+        bytes(s.data(), s.size());
+    }
+    void type(TypeDesc t)
+    {
+        num(t.basetype);
+        num(t.aggregate);
+        num(t.vecsemantics);
+        num(t.reserved);
+        num(int32_t(t.arraylen));
+    }
+};
+
+
+
+struct SpecReader {
+    cspan<unsigned char> data;
+    size_t pos = 0;
+    bool ok    = true;
+
+    // Return a pointer to the next size bytes, or nullptr (and note the
+    // failure) if there aren't that many left.
+    const unsigned char* take(size_t size)
+    {
+        if (!ok || size > size_t(data.size()) - pos) {
+            ok = false;
+            return nullptr;
+        }
+        const unsigned char* p = data.data() + pos;
+        pos += size;
+        return p;
+    }
+    template<typename T> T num()
+    {
+        T val {};
+        if (const unsigned char* p = take(sizeof(T))) {
+            memcpy(&val, p, sizeof(T));
+            if (bigendian())
+                swap_elements(&val, sizeof(T), 1);
+        }
+        return val;
+    }
+    string_view str()
+    {
+        uint32_t size          = num<uint32_t>();
+        const unsigned char* p = take(size);
+        return p ? string_view((const char*)p, size) : string_view();
+    }
+    TypeDesc type()
+    {
+        unsigned char basetype     = num<unsigned char>();
+        unsigned char aggregate    = num<unsigned char>();
+        unsigned char vecsemantics = num<unsigned char>();
+        num<unsigned char>();  // reserved
+        int arraylen = num<int32_t>();
+        if (basetype >= TypeDesc::LASTBASE || aggregate < 1 || aggregate > 16
+            || arraylen < -1)
+            ok = false;
+        return ok ? TypeDesc(TypeDesc::BASETYPE(basetype),
+                             TypeDesc::AGGREGATE(aggregate),
+                             TypeDesc::VECSEMANTICS(vecsemantics), arraylen)
+                  : TypeUnknown;
+    }
+    // Is there room left for n items of at least minsize bytes each?
+    bool room(size_t n, size_t minsize)
+    {
+        if (minsize && n > (size_t(data.size()) - pos) / minsize)
+            ok = false;
+        return ok;
+    }
+    // Read a count of items that each take at least minsize bytes.
+    size_t count(size_t minsize)
+    {
+        size_t n = num<uint32_t>();
+        return room(n, minsize) ? n : 0;
+    }
+    // The total number of base elements in nvalues values of type t, each
+    // element taking at least minsize bytes, or 0 (and note the failure)
+    // if there isn't room left for them all. Each factor is checked
+    // against the bytes left before multiplying, so it can't overflow.
+    size_t elements(int nvalues, TypeDesc t, size_t minsize)
+    {
+        if (nvalues < 0)
+            ok = false;
+        if (!ok || nvalues == 0)
+            return 0;
+        size_t left = (size_t(data.size()) - pos)
+                      / std::max(minsize, size_t(1));
+        size_t per  = t.arraylen >= 1 ? size_t(t.arraylen) : 1;
+        if (per > left || t.aggregate > left / per
+            || size_t(nvalues) > left / (per * t.aggregate)) {
+            ok = false;
+            return 0;
+        }
+        return size_t(nvalues) * per * t.aggregate;
+    }
+};
+
+}  // namespace
+
+
+
+void
+ImageSpec::to_binary(std::vector<unsigned char>& out) const
+{
+    SpecWriter w { out };
+    w.bytes(spec_binary_magic, 4);
+    w.num(spec_binary_version);
+    for (int v : { x, y, z, width, height, depth, full_x, full_y, full_z,
+                   full_width, full_height, full_depth, tile_width,
+                   tile_height, tile_depth })
+        w.num(int32_t(v));
+    w.type(format);
+    w.num(int32_t(nchannels));
+    w.num(int32_t(alpha_channel));
+    w.num(int32_t(z_channel));
+    w.num(uint8_t(deep));
+    w.num(uint32_t(channelformats.size()));
+    for (TypeDesc t : channelformats)
+        w.type(t);
+    w.num(uint32_t(channelnames.size()));
+    for (const std::string& name : channelnames)
+        w.str(name);
+
+    auto is_ptr = [](const ParamValue& p) {
+        return p.type().basetype == TypeDesc::PTR;
+    };
+    w.num(uint32_t(extra_attribs.size()
+                   - std::count_if(extra_attribs.begin(), extra_attribs.end(),
+                                   is_ptr)));
+    for (const ParamValue& p : extra_attribs) {
+        if (is_ptr(p))
+            continue;
+        TypeDesc t = p.type();
+        w.str(p.name());
+        w.type(t);
+        w.num(int32_t(p.nvalues()));
+        w.num(uint8_t(p.interp()));
+        size_t n = size_t(p.nvalues()) * t.numelements() * t.aggregate;
+        if (t.basetype == TypeDesc::STRING) {
+            const ustring* strs = (const ustring*)p.data();
+            for (size_t i = 0; i < n; ++i)
+                w.str(strs[i]);
+        } else if (t.basetype == TypeDesc::USTRINGHASH) {
+            const ustringhash* hashes = (const ustringhash*)p.data();
+            for (size_t i = 0; i < n; ++i)
+                w.str(hashes[i]);
+        } else {
+            size_t start = out.size();
+            w.bytes(p.data(), n * t.basesize());
+            if (bigendian())
+                swap_elements(out.data() + start, t.basesize(), n);
+        }
+    }
+}
+
+
+
+size_t
+ImageSpec::from_binary(cspan<unsigned char> data)
+{
+    SpecReader r { data };
+    const unsigned char* magic = r.take(4);
+    if (!magic || memcmp(magic, spec_binary_magic, 4)
+        || r.num<uint32_t>() > spec_binary_version)
+        return 0;
+
+    ImageSpec spec;
+    for (int* v : { &spec.x, &spec.y, &spec.z, &spec.width, &spec.height,
+                    &spec.depth, &spec.full_x, &spec.full_y, &spec.full_z,
+                    &spec.full_width, &spec.full_height, &spec.full_depth,
+                    &spec.tile_width, &spec.tile_height, &spec.tile_depth })
+        *v = r.num<int32_t>();
+    spec.format        = r.type();
+    spec.nchannels     = r.num<int32_t>();
+    spec.alpha_channel = r.num<int32_t>();
+    spec.z_channel     = r.num<int32_t>();
+    spec.deep          = r.num<uint8_t>() != 0;
+    spec.channelformats.resize(r.count(8));
+    for (TypeDesc& t : spec.channelformats)
+        t = r.type();
+    spec.channelnames.resize(r.count(4));
+    for (std::string& name : spec.channelnames)
+        name = r.str();
+    // The channel fields must agree with each other, as they always do in
+    // a spec that to_binary() wrote.
+    auto valid_channel = [&](int c) {
+        return c == -1 || (c >= 0 && c < spec.nchannels);
+    };
+    if (spec.nchannels < 0 || size_t(spec.nchannels) != spec.channelnames.size()
+        || (spec.channelformats.size()
+            && spec.channelformats.size() != size_t(spec.nchannels))
+        || !valid_channel(spec.alpha_channel)
+        || !valid_channel(spec.z_channel))
+        r.ok = false;
+
+    // The smallest attribute is 14 bytes: an empty name, type, nvalues,
+    // and interp.
+    size_t nattribs = r.count(14);
+    spec.extra_attribs.reserve(nattribs);
+    std::vector<ustring> strs;
+    std::vector<ustringhash> hashes;
+    std::vector<unsigned char> swapped;
+    for (size_t a = 0; a < nattribs && r.ok; ++a) {
+        ustring name = ustring(r.str());
+        TypeDesc t   = r.type();
+        int nvalues  = r.num<int32_t>();
+        auto interp  = ParamValue::Interp(r.num<uint8_t>());
+        if (t.basetype == TypeDesc::PTR)
+            r.ok = false;
+        // Strings are stored as a 4 byte length and their characters
+        bool isstr = (t.basetype == TypeDesc::STRING
+                      || t.basetype == TypeDesc::USTRINGHASH);
+        size_t n   = r.elements(nvalues, t, isstr ? 4 : t.basesize());
+        const void* values = nullptr;
+        if (t.basetype == TypeDesc::STRING) {
+            strs.resize(n);
+            for (ustring& str : strs)
+                str = ustring(r.str());
+            values = strs.data();
+        } else if (t.basetype == TypeDesc::USTRINGHASH) {
+            hashes.resize(n);
+            for (ustringhash& hash : hashes)
+                hash = ustring(r.str());
+            values = hashes.data();
+        } else if (r.ok) {
+            const unsigned char* p = r.take(n * t.basesize());
+            values                 = p;
+            if (p && bigendian()) {
+                swapped.assign(p, p + n * t.basesize());
+                swap_elements(swapped.data(), t.basesize(), n);
+                values = swapped.data();
+            }
+        }
+        if (r.ok)
+            spec.extra_attribs.emplace_back(name, t, nvalues, interp, values);
+    }
+    if (!r.ok)
+        return 0;
+    *this = std::move(spec);
+    return r.pos;
+}
+
+
+
 std::pair<string_view, int>
 ImageSpec::decode_compression_metadata(string_view defaultcomp,
                                        int defaultqual) const
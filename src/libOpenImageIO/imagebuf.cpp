@@ -3,13 +3,29 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <condition_variable>
+#include <future>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+
+#ifdef _WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    define NOMINMAX
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
 
 #include <OpenImageIO/half.h>
 
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/deepdata.h>
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
@@ -19,6 +35,7 @@
 #include <OpenImageIO/simd.h>
 #include <OpenImageIO/strongparam.h>
 #include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/thread.h>
 
 #include "imageio_pvt.h"
@@ -31,6 +48,13 @@ OIIO_STRONG_PARAM_TYPE(DoLock, bool);
 namespace pvt {
 int imagebuf_print_uncaught_errors(1);
 int imagebuf_use_imagecache(0);
+int imagebuf_read_threads(1);
+int imagebuf_write_threads(2);
+int imagebuf_write_max_MB(2048);
+int imagebuf_allocator(0);
+int imagebuf_pool_max_MB(1024);
+int imagebuf_hugepages(0);
+int imagebuf_scanline_align(0);
 atomic_ll IB_local_mem_current;
 atomic_ll IB_local_mem_peak;
 std::atomic<float> IB_total_open_time(0.0f);
@@ -84,6 +108,207 @@ set_roi_full(ImageSpec& spec, const ROI& newroi)
 
 
 
+namespace {
+
+// Heap memory for pixels, aligned to a 64-byte cache line (enough for any
+// SIMD width). If imagebuf:hugepages is set, buffers spanning several huge
+// pages are instead aligned to 2 MB and, on Linux, marked as candidates
+// for transparent huge pages, saving TLB misses and page faults.
+static void*
+alloc_pixel_memory(size_t size)
+{
+    bool huge = pvt::imagebuf_hugepages && size >= (size_t(4) << 20);
+    void* ptr = aligned_malloc(size, huge ? (size_t(2) << 20) : 64);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (ptr && huge)
+        madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+    return ptr;
+}
+
+
+
+class HeapAllocator final : public ImageBufAllocator {
+public:
+    void* allocate(size_t size) override { return alloc_pixel_memory(size); }
+    void deallocate(void* ptr, size_t /*size*/) override { aligned_free(ptr); }
+};
+
+
+
+// Keeps freed buffers, binned by size class, to hand back out. Buffers
+// under 64 KB aren't worth it and go straight back to the heap.
+class PoolAllocator final : public ImageBufAllocator {
+public:
+    ~PoolAllocator() override { trim(0); }
+
+    void* allocate(size_t size) override
+    {
+        size_t cls = size_class(size);
+        if (cls) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto found = m_free.find(cls);
+            if (found != m_free.end() && found->second.size()) {
+                void* ptr = found->second.back();
+                found->second.pop_back();
+                m_free_bytes -= cls;
+                return ptr;
+            }
+        } else {
+            cls = size;
+        }
+        return alloc_pixel_memory(cls);
+    }
+
+    void deallocate(void* ptr, size_t size) override
+    {
+        size_t cls = size_class(size);
+        if (cls) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_free_bytes + cls <= max_bytes()) {
+                m_free[cls].push_back(ptr);
+                m_free_bytes += cls;
+                return;
+            }
+        }
+        aligned_free(ptr);
+    }
+
+    // Free held buffers, largest first, until at most maxbytes are held.
+    void trim(size_t maxbytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto c = m_free.rbegin(); c != m_free.rend(); ++c) {
+            while (m_free_bytes > maxbytes && c->second.size()) {
+                aligned_free(c->second.back());
+                c->second.pop_back();
+                m_free_bytes -= c->first;
+            }
+        }
+    }
+
+    static size_t max_bytes()
+    {
+        return size_t(pvt::imagebuf_pool_max_MB) << 20;
+    }
+
+private:
+    // Round up to the next of eight steps per power of two (so at most
+    // 12.5% is wasted), or 0 for sizes too small to pool.
+    static size_t size_class(size_t size)
+    {
+        if (size < (size_t(64) << 10))
+            return 0;
+        size_t pow2 = size_t(64) << 10;
+        while (pow2 <= size / 2)
+            pow2 *= 2;
+        return round_to_multiple(size, pow2 / 8);
+    }
+
+    std::mutex m_mutex;
+    std::map<size_t, std::vector<void*>> m_free;
+    size_t m_free_bytes = 0;
+};
+
+
+// Page-locked host memory, straight from the OS, that can't be paged out.
+// GPU APIs can then transfer it by DMA without first staging it in a
+// locked buffer of their own. If the OS won't lock any more (for example,
+// past RLIMIT_MEMLOCK), the memory is still returned, just unlocked.
+class PinnedAllocator final : public ImageBufAllocator {
+public:
+    void* allocate(size_t size) override
+    {
+        if (!size)
+            return nullptr;
+#ifdef _WIN32
+        void* ptr = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE,
+                                 PAGE_READWRITE);
+        if (ptr)
+            VirtualLock(ptr, size);
+#else
+        void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+            return nullptr;
+        ::mlock(ptr, size);
+#endif
+        return ptr;
+    }
+
+    void deallocate(void* ptr, size_t size) override
+    {
+        if (!ptr)
+            return;
+#ifdef _WIN32
+        VirtualUnlock(ptr, size);
+        VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+        ::munlock(ptr, size);
+        ::munmap(ptr, size);
+#endif
+    }
+};
+
+
+// Leaked on purpose, so that ImageBufs with static lifetimes can still
+// free their pixels at exit.
+static HeapAllocator* heap_allocator     = new HeapAllocator;
+static PoolAllocator* pool_allocator     = new PoolAllocator;
+static PinnedAllocator* pinned_allocator = new PinnedAllocator;
+
+}  // namespace
+
+
+
+ImageBufAllocator::~ImageBufAllocator() {}
+
+
+
+ImageBufAllocator*
+ImageBufAllocator::heap()
+{
+    return heap_allocator;
+}
+
+
+
+ImageBufAllocator*
+ImageBufAllocator::pool()
+{
+    return pool_allocator;
+}
+
+
+
+ImageBufAllocator*
+ImageBufAllocator::pinned()
+{
+    return pinned_allocator;
+}
+
+
+
+ImageBufAllocator*
+ImageBufAllocator::current()
+{
+    if (pvt::imagebuf_allocator == 1)
+        return pool_allocator;
+    if (pvt::imagebuf_allocator == 2)
+        return pinned_allocator;
+    return heap_allocator;
+}
+
+
+
+void
+pvt::imagebuf_pool_trim()
+{
+    pool_allocator->trim(PoolAllocator::max_bytes());
+}
+
+
+
 // Expansion of the opaque type that hides all the ImageBuf implementation
 // detail.
 class ImageBufImpl {
@@ -117,7 +342,7 @@ public:
               bool force = false, TypeDesc convert = TypeDesc::UNKNOWN,
               ProgressCallback progress_callback = nullptr,
               void* progress_callback_data       = nullptr,
-              DoLock do_lock                     = DoLock(true));
+              ROI window = ROI::All(), DoLock do_lock = DoLock(true));
     void copy_metadata(const ImageBufImpl& src);
 
     // Note: Uses std::format syntax
@@ -205,7 +430,8 @@ public:
             imp->m_current_subimage = 0;
         if (imp->m_current_miplevel < 0)
             imp->m_current_miplevel = 0;
-        return imp->read(m_current_subimage, m_current_miplevel,
+        return imp->read(m_current_subimage, m_current_miplevel, 0, -1,
+                         false, TypeUnknown, nullptr, nullptr, ROI::All(),
                          DoLock(false) /* we already hold the lock */);
     }
 
@@ -262,7 +488,9 @@ public:
 
     void eval_contiguous()
     {
-        m_contiguous = m_localpixels && m_storage == ImageBuf::LOCALBUFFER
+        m_contiguous = m_localpixels
+                       && (m_storage == ImageBuf::LOCALBUFFER
+                           || m_storage == ImageBuf::MMAPBUFFER)
                        && m_xstride == m_spec.nchannels * m_channel_stride
                        && m_ystride == m_xstride * m_spec.width
                        && m_zstride == m_ystride * m_spec.height;
@@ -284,7 +512,23 @@ private:
     mutable int m_threads;          ///< thread policy for this image
     ImageSpec m_spec;               ///< Describes the image (size, etc)
     ImageSpec m_nativespec;         ///< Describes the true native image
-    std::unique_ptr<char[]> m_pixels;  ///< Pixel data, if local and we own it
+    // Local pixel memory that we own. Copies of an ImageBuf share it until
+    // one of them needs to write, at which point unshare_pixels() gives the
+    // writer its own private copy. Whether the storage was ever handed to a
+    // second ImageBuf is recorded in `shared`, which is never cleared: the
+    // shared_ptr's use_count() can't tell us that no other thread is still
+    // reading the pixels, so a once-shared storage is always copied before
+    // a write, even if we have since become its only owner.
+    struct PixelStorage {
+        char* data;
+        size_t size;
+        ImageBufAllocator* allocator;   // nullptr if mapped from a file
+        void* map_handle = nullptr;     // for unmap_pixel_file()
+        std::atomic<bool> shared { false };
+        ~PixelStorage();
+    };
+    std::shared_ptr<PixelStorage> m_pixels;  ///< Pixel data, if local & owned
+    ImageBufAllocator* m_allocator = nullptr;  ///< From set_allocator()
     char* m_localpixels;               ///< Pointer to local pixels
     typedef std::recursive_mutex mutex_t;
     typedef std::unique_lock<mutex_t> lock_t;
@@ -307,6 +551,8 @@ private:
     int m_write_tile_width;
     int m_write_tile_height;
     int m_write_tile_depth;
+    std::shared_ptr<ColorProcessor> m_write_colorprocessor;
+    bool m_write_unpremult = true;
     std::unique_ptr<ImageSpec> m_configspec;  // Configuration spec
     Filesystem::IOProxy* m_rioproxy = nullptr;
     Filesystem::IOProxy* m_wioproxy = nullptr;
@@ -320,6 +566,21 @@ private:
     char* new_pixels(size_t size, const void* data = nullptr);
     // Private release of m_pixels.
     void free_pixels();
+    // Set the strides for newly allocated local pixels laid out as m_spec
+    // describes, padding scanlines to imagebuf:scanline_align bytes, and
+    // return the number of bytes those pixels need.
+    size_t layout_local_pixels();
+    // Like alloc(), but the pixels live in a read/write mapping of the
+    // given file (or of a scratch file, if path is empty).
+    bool alloc_mapped(const ImageSpec& spec, string_view path);
+    // Share src's owned local pixels rather than copying them.
+    void share_pixels(const ImageBufImpl& src);
+    // Become a view of region roi (including its channel range) of src's
+    // local pixels, referencing them in place with src's strides.
+    void make_view(const ImageBufImpl& src, ROI roi);
+    // If m_pixels was ever shared with another ImageBuf, replace it with a
+    // private copy. Called before anything may write through m_localpixels.
+    void unshare_pixels();
 
     TypeDesc write_format(int channel = 0) const
     {
@@ -421,6 +682,7 @@ ImageBufImpl::ImageBufImpl(const ImageBufImpl& src)
     , m_threads(src.m_threads)
     , m_spec(src.m_spec)
     , m_nativespec(src.m_nativespec)
+    , m_allocator(src.m_allocator)
     , m_badfile(src.m_badfile)
     , m_pixelaspect(src.m_pixelaspect)
     , m_xstride(src.m_xstride)
@@ -437,6 +699,8 @@ ImageBufImpl::ImageBufImpl(const ImageBufImpl& src)
     , m_write_tile_width(src.m_write_tile_width)
     , m_write_tile_height(src.m_write_tile_height)
     , m_write_tile_depth(src.m_write_tile_depth)
+    , m_write_colorprocessor(src.m_write_colorprocessor)
+    , m_write_unpremult(src.m_write_unpremult)
 // NO -- copy ctr does not transfer proxy   , m_rioproxy(src.m_rioproxy)
 // NO -- copy ctr does not transfer proxy   , m_wioproxy(src.m_wioproxy)
 {
@@ -448,8 +712,13 @@ ImageBufImpl::ImageBufImpl(const ImageBufImpl& src)
             // Source just wrapped the client app's pixels, we do the same
             m_localpixels = src.m_localpixels;
         } else {
-            // We own our pixels -- copy from source
-            new_pixels(src.m_spec.image_bytes(), src.m_pixels.get());
+            // We own our pixels -- share the source's until either of us
+            // writes to them.
+            m_pixels         = src.m_pixels;
+            m_allocated_size = src.m_allocated_size;
+            m_localpixels    = src.m_localpixels;
+            if (m_pixels)
+                m_pixels->shared = true;
         }
     } else {
         // Source was cache-based or deep
@@ -596,30 +865,151 @@ ImageBuf::operator=(ImageBuf&& src)
 
 
 
+// Map `size` bytes of the file `path` for reading and writing, creating or
+// resizing it as needed (but keeping its contents if the size is already
+// right). An empty path makes an unnamed scratch file in the temp
+// directory, which goes away once unmapped. Upon failure, return nullptr
+// and set `err`.
+static char*
+map_pixel_file(string_view path, size_t size, void*& handle, std::string& err)
+{
+    std::string filename(path);
+    if (path.empty())
+        filename = Filesystem::temp_directory_path() + "/"
+                   + Filesystem::unique_path("oiio-ib-%%%%-%%%%-%%%%.pix");
+    char* data = nullptr;
+    handle     = nullptr;
+#ifdef _WIN32
+    std::wstring wpath = Strutil::utf8_to_utf16wstring(filename);
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (path.empty())
+        flags = FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE;
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+                              nullptr, OPEN_ALWAYS, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        err = Strutil::fmt::format("could not open \"{}\"", filename);
+        return nullptr;
+    }
+    LARGE_INTEGER len, want;
+    want.QuadPart = LONGLONG(size);
+    if (!GetFileSizeEx(file, &len) || len.QuadPart != want.QuadPart) {
+        if (!SetFilePointerEx(file, want, nullptr, FILE_BEGIN)
+            || !SetEndOfFile(file)) {
+            err = Strutil::fmt::format("could not resize \"{}\"", filename);
+            CloseHandle(file);
+            return nullptr;
+        }
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0,
+                                        nullptr);
+    if (mapping) {
+        data = (char*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        CloseHandle(mapping);  // The view keeps the mapping alive
+    }
+    if (!data) {
+        err = Strutil::fmt::format("could not memory-map \"{}\"", filename);
+        CloseHandle(file);
+        return nullptr;
+    }
+    handle = file;  // Closing it deletes a scratch file
+#else
+    int fd = ::open(filename.c_str(),
+                    O_RDWR | O_CREAT | (path.empty() ? O_EXCL : 0), 0666);
+    if (fd < 0) {
+        err = Strutil::fmt::format("could not open \"{}\" ({})", filename,
+                                   std::strerror(errno));
+        return nullptr;
+    }
+    if (path.empty())
+        ::unlink(filename.c_str());  // Gone as soon as it's unmapped
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) != size) {
+        if (::ftruncate(fd, off_t(size)) != 0) {
+            err = Strutil::fmt::format("could not resize \"{}\" ({})",
+                                       filename, std::strerror(errno));
+            ::close(fd);
+            return nullptr;
+        }
+    }
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps its own reference to the file
+    if (p == MAP_FAILED) {
+        err = Strutil::fmt::format("could not memory-map \"{}\" ({})",
+                                   filename, std::strerror(errno));
+        return nullptr;
+    }
+    data = (char*)p;
+#endif
+    return data;
+}
+
+
+
+static void
+unmap_pixel_file(char* data, size_t size, void* handle)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    if (handle)
+        CloseHandle((HANDLE)handle);
+#else
+    ::munmap(data, size);
+#endif
+}
+
+
+
+ImageBufImpl::PixelStorage::~PixelStorage()
+{
+    if (!allocator) {
+        unmap_pixel_file(data, size, map_handle);
+        return;
+    }
+    if (pvt::oiio_print_debug > 1)
+        OIIO::debugfmt("IB freed {} MB, global IB memory now {} MB\n",
+                       size >> 20, (pvt::IB_local_mem_current - size) >> 20);
+    pvt::IB_local_mem_current -= size;
+    allocator->deallocate(data, size);
+}
+
+
+
 char*
 ImageBufImpl::new_pixels(size_t size, const void* data)
 {
     if (m_allocated_size)
         free_pixels();
-    try {
-        m_pixels.reset(size ? new char[size] : nullptr);
-    } catch (const std::exception& e) {
-        // Could not allocate enough memory. So don't allocate anything,
-        // consider this an uninitialized ImageBuf, issue an error, and hope
-        // it's handled well downstream.
-        m_pixels.reset();
-        OIIO::debugfmt("ImageBuf unable to allocate {} bytes ({})\n", size,
-                       e.what());
-        error("ImageBuf unable to allocate {} bytes ({})\n", size, e.what());
-        size = 0;
+    if (size) {
+        ImageBufAllocator* allocator = m_allocator
+                                           ? m_allocator
+                                           : ImageBufAllocator::current();
+        std::string why = "out of memory";
+        char* p         = nullptr;
+        try {
+            p = (char*)allocator->allocate(size);
+        } catch (const std::exception& e) {
+            p   = nullptr;
+            why = e.what();
+        }
+        if (p) {
+            pvt::IB_local_mem_current += size;
+            m_pixels.reset(new PixelStorage { p, size, allocator });
+        } else {
+            // Could not allocate enough memory. So don't allocate anything,
+            // consider this an uninitialized ImageBuf, issue an error, and
+            // hope it's handled well downstream.
+            OIIO::debugfmt("ImageBuf unable to allocate {} bytes ({})\n",
+                           size, why);
+            error("ImageBuf unable to allocate {} bytes ({})\n", size, why);
+            size = 0;
+        }
     }
     m_allocated_size = size;
-    pvt::IB_local_mem_current += m_allocated_size;
     atomic_max(pvt::IB_local_mem_peak, (long long)pvt::IB_local_mem_current);
+    m_localpixels = m_pixels ? m_pixels->data : nullptr;
     if (data && size)
-        memcpy(m_pixels.get(), data, size);
-    m_localpixels = m_pixels.get();
-    m_storage     = size ? ImageBuf::LOCALBUFFER : ImageBuf::UNINITIALIZED;
+        memcpy(m_localpixels, data, size);
+    m_storage = size ? ImageBuf::LOCALBUFFER : ImageBuf::UNINITIALIZED;
     if (pvt::oiio_print_debug > 1)
         OIIO::debugfmt("IB allocated {} MB, global IB memory now {} MB\n",
                        size >> 20, pvt::IB_local_mem_current >> 20);
@@ -628,18 +1018,12 @@ ImageBufImpl::new_pixels(size_t size, const void* data)
 }
 
 
+
 void
 ImageBufImpl::free_pixels()
 {
-    if (m_allocated_size) {
-        if (pvt::oiio_print_debug > 1)
-            OIIO::debugfmt("IB freed {} MB, global IB memory now {} MB\n",
-                           m_allocated_size >> 20,
-                           pvt::IB_local_mem_current >> 20);
-        pvt::IB_local_mem_current -= m_allocated_size;
-        m_allocated_size = 0;
-    }
     m_pixels.reset();
+    m_allocated_size = 0;
     m_deepdata.free();
     m_storage = ImageBuf::UNINITIALIZED;
     m_blackpixel.clear();
@@ -647,6 +1031,183 @@ ImageBufImpl::free_pixels()
 
 
 
+void
+ImageBufImpl::share_pixels(const ImageBufImpl& src)
+{
+    OIIO_DASSERT(src.m_pixels && src.m_contiguous);
+    reset(src.m_name, src.m_spec, &src.m_nativespec, src.m_localpixels);
+    m_pixels         = src.m_pixels;
+    m_allocated_size = src.m_allocated_size;
+    m_storage        = src.m_storage;
+    m_pixels->shared = true;
+    eval_contiguous();
+}
+
+
+
+// The spec of a view of region `roi` of an image with spec `src`.
+static ImageSpec
+view_spec(const ImageSpec& src, ROI roi)
+{
+    ImageSpec spec(src);
+    spec.x         = roi.xbegin;
+    spec.y         = roi.ybegin;
+    spec.z         = roi.zbegin;
+    spec.width     = roi.width();
+    spec.height    = roi.height();
+    spec.depth     = roi.depth();
+    spec.nchannels = roi.nchannels();
+    spec.channelnames.clear();
+    for (int c = roi.chbegin; c < roi.chend; ++c)
+        spec.channelnames.push_back(src.channel_name(c));
+    if (src.channelformats.size())
+        spec.channelformats.assign(src.channelformats.begin() + roi.chbegin,
+                                   src.channelformats.begin() + roi.chend);
+    spec.alpha_channel = (src.alpha_channel >= roi.chbegin
+                          && src.alpha_channel < roi.chend)
+                             ? src.alpha_channel - roi.chbegin
+                             : -1;
+    spec.z_channel     = (src.z_channel >= roi.chbegin
+                      && src.z_channel < roi.chend)
+                             ? src.z_channel - roi.chbegin
+                             : -1;
+    return spec;
+}
+
+
+
+void
+ImageBufImpl::make_view(const ImageBufImpl& src, ROI roi)
+{
+    OIIO_DASSERT(src.m_localpixels && src.m_spec.roi().contains(roi));
+    m_spec           = view_spec(src.m_spec, roi);
+    m_nativespec     = view_spec(src.m_nativespec, roi);
+    m_threads        = src.m_threads;
+    m_allocator      = src.m_allocator;
+    m_channel_stride = src.m_channel_stride;
+    m_xstride        = src.m_xstride;
+    m_ystride        = src.m_ystride;
+    m_zstride        = src.m_zstride;
+    m_localpixels    = src.m_localpixels
+                    + (roi.xbegin - src.m_spec.x) * m_xstride
+                    + (roi.ybegin - src.m_spec.y) * m_ystride
+                    + (roi.zbegin - src.m_spec.z) * m_zstride
+                    + roi.chbegin * m_channel_stride;
+    if (src.m_pixels) {
+        // Owned pixels are shared copy-on-write, like a copy would be, so
+        // the view keeps them alive and never sees the parent's later
+        // writes (nor the parent the view's).
+        m_pixels         = src.m_pixels;
+        m_allocated_size = src.m_allocated_size;
+        m_storage        = src.m_storage;
+        m_pixels->shared = true;
+    } else {
+        // Like the parent, we just wrap the application's buffer.
+        m_storage = ImageBuf::APPBUFFER;
+    }
+    m_blackpixel.resize(round_to_multiple(m_spec.pixel_bytes(),
+                                          OIIO_SIMD_MAX_SIZE_BYTES),
+                        0);
+    m_spec_valid   = true;
+    m_pixels_valid = true;
+    eval_contiguous();
+}
+
+
+
+void
+ImageBufImpl::unshare_pixels()
+{
+    if (!m_pixels || !m_pixels->shared)
+        return;  // Never shared, the common case
+    lock_t lock(m_mutex);
+    if (!m_pixels || !m_pixels->shared)
+        return;  // Another thread beat us to it
+    // Keep the shared storage alive while we copy out of it. Zeroing
+    // m_allocated_size first keeps new_pixels from tearing down the rest of
+    // our state (black pixel, deep data) via free_pixels().
+    std::shared_ptr<PixelStorage> shared;
+    shared.swap(m_pixels);
+    m_allocated_size = 0;
+    if (m_localpixels != shared->data || !m_contiguous
+        || m_spec.image_bytes() != shared->size) {
+        // We are a view of part of the shared pixels (or they are padded):
+        // copy out just our own region, laid out afresh.
+        const char* oldpixels = m_localpixels;
+        stride_t xstride = m_xstride, ystride = m_ystride, zstride = m_zstride;
+        if (new_pixels(layout_local_pixels()))
+            copy_image(m_spec.nchannels, m_spec.width, m_spec.height,
+                       m_spec.depth, oldpixels, m_spec.pixel_bytes(), xstride,
+                       ystride, zstride, m_localpixels, m_xstride, m_ystride,
+                       m_zstride);
+        return;
+    }
+    if (!shared->allocator) {
+        // Pixels too big for RAM get their private copy in a new scratch
+        // file, rather than in memory.
+        std::string err;
+        void* handle = nullptr;
+        char* p      = map_pixel_file("", shared->size, handle, err);
+        if (p) {
+            memcpy(p, shared->data, shared->size);
+            m_pixels.reset(new PixelStorage { p, shared->size, nullptr,
+                                              handle });
+            m_allocated_size = shared->size;
+            m_localpixels    = p;
+        } else {
+            error("ImageBuf unable to copy mapped pixels: {}", err);
+            m_localpixels = nullptr;
+            m_storage     = ImageBuf::UNINITIALIZED;
+        }
+        eval_contiguous();
+        return;
+    }
+    new_pixels(shared->size, shared->data);
+}
+
+
+
+bool
+ImageBufImpl::alloc_mapped(const ImageSpec& spec, string_view path)
+{
+    // Lay out the spec just as alloc() and realloc() would
+    m_spec           = spec;
+    m_spec.width     = std::max(1, m_spec.width);
+    m_spec.height    = std::max(1, m_spec.height);
+    m_spec.depth     = std::max(1, m_spec.depth);
+    m_spec.nchannels = std::max(1, m_spec.nchannels);
+    m_spec.channelformats.clear();  // native layout has one data type
+    m_nativespec     = m_spec;
+    size_t size      = m_spec.image_bytes();
+    m_channel_stride = m_spec.format.size();
+    m_xstride        = AutoStride;
+    m_ystride        = AutoStride;
+    m_zstride        = AutoStride;
+    ImageSpec::auto_stride(m_xstride, m_ystride, m_zstride, m_spec.format,
+                           m_spec.nchannels, m_spec.width, m_spec.height);
+    m_blackpixel.resize(round_to_multiple(m_xstride, OIIO_SIMD_MAX_SIZE_BYTES),
+                        0);
+    m_spec_valid = true;
+
+    std::string err;
+    void* handle = nullptr;
+    char* p      = map_pixel_file(path, size, handle, err);
+    if (!p) {
+        error("ImageBuf unable to map {} bytes: {}", size, err);
+        m_storage = ImageBuf::UNINITIALIZED;
+        return false;
+    }
+    m_pixels.reset(new PixelStorage { p, size, nullptr, handle });
+    m_allocated_size = size;
+    m_localpixels    = p;
+    m_pixels_valid   = true;
+    m_storage        = ImageBuf::MMAPBUFFER;
+    eval_contiguous();
+    return true;
+}
+
+
+
 static spin_mutex err_mutex;  ///< Protect m_err fields
 
 
@@ -725,24 +1286,25 @@ ImageBufImpl::clear()
     m_current_miplevel = -1;
     m_spec             = ImageSpec();
     m_nativespec       = ImageSpec();
-    m_pixels.reset();
-    m_localpixels    = nullptr;
-    m_spec_valid     = false;
-    m_pixels_valid   = false;
-    m_badfile        = false;
-    m_pixelaspect    = 1;
-    m_xstride        = 0;
-    m_ystride        = 0;
-    m_zstride        = 0;
-    m_channel_stride = 0;
-    m_contiguous     = false;
-    m_imagecache     = nullptr;
+    m_localpixels      = nullptr;
+    m_spec_valid       = false;
+    m_pixels_valid     = false;
+    m_badfile          = false;
+    m_pixelaspect      = 1;
+    m_xstride          = 0;
+    m_ystride          = 0;
+    m_zstride          = 0;
+    m_channel_stride   = 0;
+    m_contiguous       = false;
+    m_imagecache       = nullptr;
     m_deepdata.free();
     m_blackpixel.clear();
     m_write_format.clear();
     m_write_tile_width  = 0;
     m_write_tile_height = 0;
     m_write_tile_depth  = 0;
+    m_write_colorprocessor.reset();
+    m_write_unpremult   = true;
     m_rioproxy          = nullptr;
     m_wioproxy          = nullptr;
     m_configspec.reset();
@@ -880,16 +1442,44 @@ ImageBuf::reset(const ImageSpec& spec, void* buffer, stride_t xstride,
 
 
 
-void
-ImageBufImpl::realloc()
+bool
+ImageBuf::reset_mmap(const ImageSpec& spec, string_view path)
+{
+    clear();
+    if (!spec.image_bytes() || spec.deep) {
+        errorfmt("Could not initialize mapped ImageBuf: the provided "
+                 "ImageSpec needs a valid width, height, depth, nchannels, "
+                 "format, and may not be deep.");
+        return false;
+    }
+    return m_impl->alloc_mapped(spec, path);
+}
+
+
+
+size_t
+ImageBufImpl::layout_local_pixels()
 {
-    new_pixels(m_spec.deep ? size_t(0) : m_spec.image_bytes());
     m_channel_stride = m_spec.format.size();
     m_xstride        = AutoStride;
     m_ystride        = AutoStride;
     m_zstride        = AutoStride;
     ImageSpec::auto_stride(m_xstride, m_ystride, m_zstride, m_spec.format,
                            m_spec.nchannels, m_spec.width, m_spec.height);
+    if (pvt::imagebuf_scanline_align > 1) {
+        m_ystride = round_to_multiple(m_ystride,
+                                      stride_t(pvt::imagebuf_scanline_align));
+        m_zstride = m_ystride * m_spec.height;
+    }
+    return m_spec.deep ? size_t(0) : size_t(m_zstride) * m_spec.depth;
+}
+
+
+
+void
+ImageBufImpl::realloc()
+{
+    new_pixels(layout_local_pixels());
     m_blackpixel.resize(round_to_multiple(m_xstride, OIIO_SIMD_MAX_SIZE_BYTES),
                         0);
     // NB make it big enough for SSE
@@ -1088,11 +1678,179 @@ ImageBuf::init_spec(string_view filename, int subimage, int miplevel)
 
 
 
+// Read into `pixels` (of type `format`, with the given scanline and plane
+// strides) just the pixel window of `spec`, channels [chbegin,chend), from
+// an open file whose full data window is that of `nativespec`. Only the
+// scanlines or tiles overlapping the window are decoded, a band at a time,
+// so the scratch memory needed stays small no matter how large the file is.
+// If the progress callback asks to stop, the read fails with an error.
+static bool
+read_window(ImageInput* in, int subimage, int miplevel, int chbegin,
+            int chend, const ImageSpec& nativespec, const ImageSpec& spec,
+            TypeDesc format, char* pixels, stride_t ystride, stride_t zstride,
+            ProgressCallback progress_callback, void* progress_callback_data)
+{
+    const int nchans       = chend - chbegin;
+    const stride_t pixsize = stride_t(nchans * format.size());
+    std::vector<char> band;
+    bool ok = true;
+    if (!nativespec.tile_width) {
+        // Scanline file: read full-width bands of rows, keep the window
+        const stride_t linebytes = pixsize * nativespec.width;
+        const int chunk = std::max(1, int((16 << 20) / linebytes));
+        const int dx    = spec.x - nativespec.x;
+        band.resize(size_t(linebytes) * std::min(chunk, spec.height));
+        for (int z = spec.z; ok && z < spec.z + spec.depth; ++z) {
+            for (int y = spec.y; ok && y < spec.y + spec.height; y += chunk) {
+                int yend = std::min(y + chunk, spec.y + spec.height);
+                ok = in->read_scanlines(subimage, miplevel, y, yend, z,
+                                        chbegin, chend, format, band.data());
+                if (ok)
+                    copy_image(nchans, spec.width, yend - y, 1,
+                               band.data() + dx * pixsize, pixsize, pixsize,
+                               linebytes, AutoStride,
+                               pixels + (z - spec.z) * zstride
+                                   + (y - spec.y) * ystride,
+                               pixsize, ystride, zstride);
+                if (ok && progress_callback
+                    && progress_callback(progress_callback_data,
+                                         float(yend - spec.y)
+                                             / float(spec.height))) {
+                    in->errorfmt("Read aborted by the progress callback");
+                    return false;
+                }
+            }
+        }
+        return ok;
+    }
+
+    // Tiled file: expand the window to whole tiles, but read them one row
+    // (and slab) of tiles at a time.
+    const int tw    = nativespec.tile_width;
+    const int th    = nativespec.tile_height;
+    const int td    = std::max(1, nativespec.tile_depth);
+    auto tile_begin = [](int v, int origin, int t) {
+        return origin + ((v - origin) / t) * t;
+    };
+    const int xbegin = tile_begin(spec.x, nativespec.x, tw);
+    const int xend   = std::min(nativespec.x + nativespec.width,
+                                tile_begin(spec.x + spec.width - 1,
+                                           nativespec.x, tw)
+                                    + tw);
+    const int ybegin = tile_begin(spec.y, nativespec.y, th);
+    const int zbegin = tile_begin(spec.z, nativespec.z, td);
+    const int yend   = spec.y + spec.height;
+    const int zend   = spec.z + spec.depth;
+    const stride_t bandline = pixsize * (xend - xbegin);
+    band.resize(size_t(bandline) * th * td);
+    for (int tz = zbegin; ok && tz < zend; tz += td) {
+        int tzend = std::min(tz + td, nativespec.z + nativespec.depth);
+        for (int ty = ybegin; ok && ty < yend; ty += th) {
+            int tyend = std::min(ty + th, nativespec.y + nativespec.height);
+            ok = in->read_tiles(subimage, miplevel, xbegin, xend, ty, tyend,
+                                tz, tzend, chbegin, chend, format,
+                                band.data());
+            if (!ok)
+                break;
+            // Copy the overlap of this band of tiles with the window
+            int y0 = std::max(ty, spec.y), y1 = std::min(tyend, yend);
+            int z0 = std::max(tz, spec.z), z1 = std::min(tzend, zend);
+            stride_t bandz = bandline * (tyend - ty);
+            copy_image(nchans, spec.width, y1 - y0, z1 - z0,
+                       band.data() + (z0 - tz) * bandz
+                           + (y0 - ty) * bandline
+                           + (spec.x - xbegin) * pixsize,
+                       pixsize, pixsize, bandline, bandz,
+                       pixels + (z0 - spec.z) * zstride
+                           + (y0 - spec.y) * ystride,
+                       pixsize, ystride, zstride);
+            if (progress_callback
+                && progress_callback(progress_callback_data,
+                                     float(y1 - spec.y) / float(spec.height))) {
+                in->errorfmt("Read aborted by the progress callback");
+                return false;
+            }
+        }
+    }
+    return ok;
+}
+
+
+
+// Read all of the image, channels [chbegin,chend), into `pixels` (of type
+// `format`, with the given scanline and plane strides) in horizontal bands
+// of scanlines or rows
+// of tiles, up to `nthreads` at once (0 means the global thread count).
+// Each band is decoded by its own ImageInput, so that even a file format
+// whose reader is serial (such as a scanline file with many channels)
+// decodes on several cores. Return false if there are too few rows to be
+// worth splitting; otherwise return false, with `err` set, upon failure.
+static bool
+read_bands(string_view filename, const ImageSpec* config, int nthreads,
+           int subimage, int miplevel, int chbegin, int chend,
+           const ImageSpec& nativespec, TypeDesc format, char* pixels,
+           stride_t ystride, stride_t zstride, std::string& err)
+{
+    if (nthreads <= 0)
+        nthreads = pvt::oiio_threads;
+    // Keep bands to whole tiles, or to multiples of the largest common
+    // scanline chunk, so no chunk is decoded by two bands.
+    const int align = nativespec.tile_width ? nativespec.tile_height : 32;
+    int rows  = (nativespec.height + nthreads - 1) / nthreads;
+    rows      = round_to_multiple(std::max(rows, 1), align);
+    int bands = (nativespec.height + rows - 1) / rows;
+    if (bands < 2)
+        return false;
+
+    const stride_t pixsize = stride_t((chend - chbegin) * format.size());
+    std::mutex err_mutex;
+    std::atomic<bool> ok(true);
+    parallel_for(
+        int64_t(0), int64_t(bands),
+        [&](int64_t b) {
+            if (!ok)
+                return;
+            int ybegin = nativespec.y + int(b) * rows;
+            int yend   = std::min(ybegin + rows,
+                                  nativespec.y + nativespec.height);
+            char* band = pixels + (ybegin - nativespec.y) * ystride;
+            auto in    = ImageInput::open(filename, config);
+            bool bok   = false;
+            if (in) {
+                in->threads(1);  // we are the parallelism
+                if (nativespec.tile_width)
+                    bok = in->read_tiles(subimage, miplevel, nativespec.x,
+                                         nativespec.x + nativespec.width,
+                                         ybegin, yend, nativespec.z,
+                                         nativespec.z + nativespec.depth,
+                                         chbegin, chend, format, band,
+                                         pixsize, ystride, zstride);
+                else
+                    bok = in->read_scanlines(subimage, miplevel, ybegin,
+                                             yend, nativespec.z, chbegin,
+                                             chend, format, band, pixsize,
+                                             ystride);
+            }
+            if (!bok) {
+                std::lock_guard<std::mutex> lock(err_mutex);
+                if (ok)
+                    err = in ? in->geterror() : OIIO::geterror();
+                ok = false;
+            }
+        },
+        paropt(nthreads));
+    if (!ok && err.empty())
+        err = "unknown error";
+    return ok;
+}
+
+
+
 bool
 ImageBufImpl::read(int subimage, int miplevel, int chbegin, int chend,
                    bool force, TypeDesc convert,
                    ProgressCallback progress_callback,
-                   void* progress_callback_data, DoLock do_lock)
+                   void* progress_callback_data, ROI window, DoLock do_lock)
 {
     lock_t lock(m_mutex, std::defer_lock_t());
     if (do_lock)
@@ -1189,6 +1947,32 @@ ImageBufImpl::read(int subimage, int miplevel, int chbegin, int chend,
         }
     }
 
+    // Restricting the read to a window within the data window? Then only
+    // that window is allocated and decoded.
+    bool use_window = false;
+    if (window.defined()) {
+        ROI datawin    = get_roi(m_nativespec);
+        window         = roi_intersection(window, datawin);
+        window.chbegin = datawin.chbegin;
+        window.chend   = datawin.chend;
+        if (window.npixels() == 0) {
+            error("Read window does not overlap the data window of {}",
+                  m_name);
+            m_pixels_valid = false;
+            return false;
+        }
+        if (window != datawin) {
+            use_window    = true;
+            force         = true;
+            m_spec.x      = window.xbegin;
+            m_spec.y      = window.ybegin;
+            m_spec.z      = window.zbegin;
+            m_spec.width  = window.width();
+            m_spec.height = window.height();
+            m_spec.depth  = window.depth();
+        }
+    }
+
     if (convert != TypeDesc::UNKNOWN)
         m_spec.format = convert;
     else
@@ -1230,16 +2014,33 @@ ImageBufImpl::read(int subimage, int miplevel, int chbegin, int chend,
                                    m_rioproxy);
         if (in) {
             in->threads(threads());  // Pass on our thread policy
-            bool ok = in->read_image(subimage, miplevel, chbegin, chend,
-                                     m_spec.format, m_localpixels, AutoStride,
-                                     AutoStride, AutoStride, progress_callback,
-                                     progress_callback_data);
+            bool ok = false;
+            std::string banderr;
+            if (use_window)
+                ok = read_window(in.get(), subimage, miplevel, chbegin, chend,
+                                 m_nativespec, m_spec, m_spec.format,
+                                 m_localpixels, m_ystride, m_zstride,
+                                 progress_callback, progress_callback_data);
+            else if (pvt::imagebuf_read_threads != 1 && !m_rioproxy
+                     && !progress_callback
+                     && (m_nativespec.tile_width || m_nativespec.depth == 1)
+                     && read_bands(m_name, m_configspec.get(),
+                                   pvt::imagebuf_read_threads, subimage,
+                                   miplevel, chbegin, chend, m_nativespec,
+                                   m_spec.format, m_localpixels, m_ystride,
+                                   m_zstride, banderr))
+                ok = true;
+            else if (banderr.empty())
+                ok = in->read_image(subimage, miplevel, chbegin, chend,
+                                    m_spec.format, m_localpixels, m_xstride,
+                                    m_ystride, m_zstride, progress_callback,
+                                    progress_callback_data);
             in->close();
             if (ok) {
                 m_pixels_valid = true;
             } else {
                 m_pixels_valid = false;
-                error(in->geterror());
+                error(banderr.size() ? banderr : in->geterror());
             }
         } else {
             m_pixels_valid = false;
@@ -1275,7 +2076,8 @@ ImageBufImpl::read(int subimage, int miplevel, int chbegin, int chend,
                                  m_spec.x + m_spec.width, m_spec.y,
                                  m_spec.y + m_spec.height, m_spec.z,
                                  m_spec.z + m_spec.depth, chbegin, chend,
-                                 m_spec.format, m_localpixels)) {
+                                 m_spec.format, m_localpixels, m_xstride,
+                                 m_ystride, m_zstride)) {
         m_imagecache->close(m_name);
         m_pixels_valid = true;
     } else {
@@ -1293,7 +2095,7 @@ ImageBuf::read(int subimage, int miplevel, bool force, TypeDesc convert,
                ProgressCallback progress_callback, void* progress_callback_data)
 {
     return m_impl->read(subimage, miplevel, 0, -1, force, convert,
-                        progress_callback, progress_callback_data,
+                        progress_callback, progress_callback_data, ROI::All(),
                         DoLock(true) /* acquire the lock */);
 }
 
@@ -1305,7 +2107,23 @@ ImageBuf::read(int subimage, int miplevel, int chbegin, int chend, bool force,
                void* progress_callback_data)
 {
     return m_impl->read(subimage, miplevel, chbegin, chend, force, convert,
-                        progress_callback, progress_callback_data,
+                        progress_callback, progress_callback_data, ROI::All(),
+                        DoLock(true) /* acquire the lock */);
+}
+
+
+
+bool
+ImageBuf::read(int subimage, int miplevel, ROI roi, bool force,
+               TypeDesc convert, ProgressCallback progress_callback,
+               void* progress_callback_data)
+{
+    int chbegin = roi.defined() ? roi.chbegin : 0;
+    int chend   = roi.defined() ? roi.chend : -1;
+    // A window always needs an actual read of just those pixels
+    force = force || roi.defined();
+    return m_impl->read(subimage, miplevel, chbegin, chend, force, convert,
+                        progress_callback, progress_callback_data, roi,
                         DoLock(true) /* acquire the lock */);
 }
 
@@ -1339,6 +2157,16 @@ ImageBuf::set_write_tiles(int width, int height, int depth)
 
 
 
+void
+ImageBuf::set_write_colorprocessor(std::shared_ptr<ColorProcessor> processor,
+                                   bool unpremult)
+{
+    m_impl->m_write_colorprocessor = std::move(processor);
+    m_impl->m_write_unpremult      = unpremult;
+}
+
+
+
 void
 ImageBuf::set_write_ioproxy(Filesystem::IOProxy* ioproxy)
 {
@@ -1365,7 +2193,26 @@ ImageBuf::write(ImageOutput* out, ProgressCallback progress_callback,
     const ImageSpec& bufspec(m_impl->m_spec);
     const ImageSpec& outspec(out->spec());
     TypeDesc bufformat = spec().format;
-    if (m_impl->m_localpixels) {
+    // With a color transformation to apply, the pixels go through float
+    // strips, transformed in place on their way to the ImageOutput.
+    const ColorProcessor* processor = m_impl->m_write_colorprocessor.get();
+    if (processor && !deep())
+        bufformat = TypeFloat;
+    auto get_strip = [&](ROI strip, void* data) {
+        if (!get_pixels(strip, bufformat, data))
+            return false;
+        if (!processor)
+            return true;
+        ImageSpec stripspec = bufspec;
+        stripspec.set_format(bufformat);
+        stripspec.channelformats.clear();
+        set_roi(stripspec, strip);
+        ImageBuf stripbuf(stripspec, data);
+        return ImageBufAlgo::colorconvert(stripbuf, stripbuf, processor,
+                                          m_impl->m_write_unpremult, {},
+                                          threads());
+    };
+    if (m_impl->m_localpixels && !processor) {
         // In-core pixel buffer for the whole image
         ok = out->write_image(bufformat, m_impl->m_localpixels, pixel_stride(),
                               scanline_stride(), z_stride(), progress_callback,
@@ -1378,18 +2225,21 @@ ImageBuf::write(ImageOutput* out, ProgressCallback progress_callback,
         // immediately writing out a file from disk, possibly with file
         // format or data format conversion, but without any ImageBufAlgo
         // functions having been applied.
-        const imagesize_t budget = 1024 * 1024 * 64;  // 64 MB
-        imagesize_t imagesize    = bufspec.image_bytes();
-        if (imagesize <= budget) {
+        // (Or an in-core buffer whose pixels are color transformed as we
+        // go, which takes the same path.)
+        // Color transformed strips are kept small enough to stay in cache.
+        const imagesize_t budget = 1024 * 1024 * (processor ? 8 : 64);
+        imagesize_t pixelsize    = bufformat.size() * bufspec.nchannels;
+        imagesize_t imagesize    = pixelsize * bufspec.image_pixels();
+        if (imagesize <= budget && !processor) {
             // whole image can fit within our budget
             std::unique_ptr<char[]> tmp(new char[imagesize]);
-            ok &= get_pixels(roi(), bufformat, &tmp[0]);
+            ok &= get_strip(roi(), &tmp[0]);
             ok &= out->write_image(bufformat, &tmp[0], AutoStride, AutoStride,
                                    AutoStride, progress_callback,
                                    progress_callback_data);
         } else if (outspec.tile_width) {
             // Big tiled image: break up into tile strips
-            size_t pixelsize = bufspec.pixel_bytes();
             size_t chunksize = pixelsize * outspec.width * outspec.tile_height
                                * outspec.tile_depth;
             std::unique_ptr<char[]> tmp(new char[chunksize]);
@@ -1400,10 +2250,10 @@ ImageBuf::write(ImageOutput* out, ProgressCallback progress_callback,
                      y += outspec.tile_height) {
                     int yend = std::min(y + outspec.y + outspec.tile_height,
                                         outspec.y + outspec.height);
-                    ok &= get_pixels(ROI(outspec.x, outspec.x + outspec.width,
-                                         outspec.y + y, yend, outspec.z + z,
-                                         zend),
-                                     bufformat, &tmp[0]);
+                    ok &= get_strip(ROI(outspec.x, outspec.x + outspec.width,
+                                        outspec.y + y, yend, outspec.z + z,
+                                        zend),
+                                    &tmp[0]);
                     ok &= out->write_tiles(outspec.x, outspec.x + outspec.width,
                                            y + outspec.y, yend, z + outspec.z,
                                            zend, bufformat, &tmp[0]);
@@ -1417,7 +2267,7 @@ ImageBuf::write(ImageOutput* out, ProgressCallback progress_callback,
             }
         } else {
             // Big scanline image: break up into scanline strips
-            imagesize_t slsize = bufspec.scanline_bytes();
+            imagesize_t slsize = pixelsize * bufspec.width;
             int chunk = clamp(round_to_multiple(int(budget / slsize), 64), 1,
                               1024);
             std::unique_ptr<char[]> tmp(new char[chunk * slsize]);
@@ -1440,10 +2290,10 @@ ImageBuf::write(ImageOutput* out, ProgressCallback progress_callback,
                 for (int y = yLoopStart; y != yLoopEnd && ok; y += yDelta) {
                     int yend = std::min(y + outspec.y + chunk,
                                         outspec.y + outspec.height);
-                    ok &= get_pixels(ROI(outspec.x, outspec.x + outspec.width,
-                                         outspec.y + y, yend, outspec.z,
-                                         outspec.z + outspec.depth),
-                                     bufformat, &tmp[0]);
+                    ok &= get_strip(ROI(outspec.x, outspec.x + outspec.width,
+                                        outspec.y + y, yend, outspec.z,
+                                        outspec.z + outspec.depth),
+                                    &tmp[0]);
                     ok &= out->write_scanlines(y + outspec.y, yend,
                                                z + outspec.z, bufformat,
                                                &tmp[0]);
@@ -1577,6 +2427,89 @@ ImageBuf::write(string_view _filename, TypeDesc dtype, string_view _fileformat,
 
 
 
+namespace {
+
+// Runs ImageBuf::write_async() jobs on a thread pool of its own, so that
+// long encodes neither starve nor are starved by the default pool, and
+// bounds the memory held by snapshots waiting their turn.
+class AsyncWriter {
+public:
+    static AsyncWriter& instance()
+    {
+        static AsyncWriter* writer = new AsyncWriter;  // intentionally leak
+        return *writer;
+    }
+
+    std::future<std::string> push(std::shared_ptr<ImageBuf> img,
+                                  std::string filename, TypeDesc dtype,
+                                  std::string fileformat)
+    {
+        imagesize_t bytes = img->spec().image_bytes();
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            imagesize_t limit = imagesize_t(pvt::imagebuf_write_max_MB) << 20;
+            m_ready.wait(lock, [&]() {
+                return m_pending == 0 || m_pending_bytes + bytes <= limit;
+            });
+            ++m_pending;
+            m_pending_bytes += bytes;
+            if (m_pool.size() != pvt::imagebuf_write_threads)
+                m_pool.resize(pvt::imagebuf_write_threads);
+        }
+        return m_pool.push([this, img, filename, dtype, fileformat,
+                            bytes](int /*id*/) {
+            std::string err;
+            if (!img->write(filename, dtype, fileformat))
+                err = img->geterror();
+            img->reset();  // release the snapshot before we count it done
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_pending;
+            m_pending_bytes -= bytes;
+            m_ready.notify_all();
+            return err;
+        });
+    }
+
+private:
+    thread_pool m_pool { 0 };
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    int m_pending               = 0;
+    imagesize_t m_pending_bytes = 0;
+};
+
+}  // namespace
+
+
+
+std::future<std::string>
+ImageBuf::write_async(string_view filename, TypeDesc dtype,
+                      string_view fileformat) const
+{
+    // Snapshot the image. Copies share owned pixels copy-on-write, so
+    // this is cheap, and later changes to *this won't affect the file.
+    // But a copy of an APPBUFFER would still alias the app's memory, so
+    // that needs a real duplicate.
+    std::shared_ptr<ImageBuf> img;
+    if (storage() == APPBUFFER) {
+        img = std::make_shared<ImageBuf>();
+        img->copy(*this);
+        img->set_write_format(m_impl->m_write_format);
+        img->set_write_tiles(m_impl->m_write_tile_width,
+                             m_impl->m_write_tile_height,
+                             m_impl->m_write_tile_depth);
+        img->set_write_colorprocessor(m_impl->m_write_colorprocessor,
+                                      m_impl->m_write_unpremult);
+    } else {
+        img = std::make_shared<ImageBuf>(*this);
+    }
+    return AsyncWriter::instance().push(img, filename.size() ? filename
+                                                             : name(),
+                                        dtype, fileformat);
+}
+
+
+
 bool
 ImageBuf::make_writable(bool keep_cache_type)
 {
@@ -1584,6 +2517,7 @@ ImageBuf::make_writable(bool keep_cache_type)
         return read(subimage(), miplevel(), 0, -1, true /*force*/,
                     keep_cache_type ? m_impl->m_cachedpixeltype : TypeDesc());
     }
+    m_impl->unshare_pixels();
     return true;
 }
 
@@ -1839,6 +2773,7 @@ void*
 ImageBuf::localpixels()
 {
     m_impl->validate_pixels();
+    m_impl->unshare_pixels();
     return m_impl->m_localpixels;
 }
 
@@ -1946,6 +2881,22 @@ ImageBuf::threads() const
 
 
 
+void
+ImageBuf::set_allocator(ImageBufAllocator* allocator)
+{
+    m_impl->m_allocator = allocator;
+}
+
+
+
+ImageBufAllocator*
+ImageBuf::allocator() const
+{
+    return m_impl->m_allocator;
+}
+
+
+
 namespace {
 
 // Pixel-by-pixel copy fully templated by both data types.
@@ -1961,7 +2912,9 @@ copy_pixels_impl(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads = 0)
             // If both bufs are the same type, just directly copy the values
             if (src.localpixels() && roi.chbegin == 0
                 && roi.chend == dst.nchannels()
-                && roi.chend == src.nchannels()) {
+                && roi.chend == src.nchannels()
+                && dst.pixel_stride() == stride_t(sizeof(D) * roi.chend)
+                && src.pixel_stride() == stride_t(sizeof(S) * roi.chend)) {
                 // Extra shortcut -- totally local pixels for src, copying all
                 // channels, so we can copy memory around line by line, rather
                 // than value by value.
@@ -2060,6 +3013,15 @@ ImageBuf::copy(const ImageBuf& src, TypeDesc format)
         m_impl->m_deepdata = src.m_impl->m_deepdata;
         return true;
     }
+    if (src.m_impl->m_pixels && src.m_impl->m_contiguous
+        && (format.basetype == TypeDesc::UNKNOWN
+            || (format == src.spec().format
+                && src.spec().channelformats.empty()))) {
+        // Same data type and src owns its contiguous pixels: share them
+        // until one of the two bufs writes.
+        m_impl->share_pixels(*src.m_impl);
+        return true;
+    }
     if (format.basetype == TypeDesc::UNKNOWN || src.deep())
         m_impl->reset(src.name(), src.spec(), &src.nativespec());
     else {
@@ -2083,6 +3045,40 @@ ImageBuf::copy(TypeDesc format) const
 
 
 
+ImageBuf
+ImageBuf::view(ROI roi) const
+{
+    ImageBuf result;
+    if (!initialized()) {
+        result.errorfmt("Cannot make a view of an uninitialized ImageBuf");
+        return result;
+    }
+    roi = roi.defined() ? roi_intersection(roi, this->roi()) : this->roi();
+    if (roi.width() <= 0 || roi.height() <= 0 || roi.depth() <= 0
+        || roi.nchannels() <= 0) {
+        result.errorfmt("view() region {} does not overlap the image", roi);
+        return result;
+    }
+    if (deep()) {
+        result.errorfmt("view() is not supported for deep images");
+        return result;
+    }
+    if (localpixels()) {
+        result.m_impl->make_view(*m_impl, roi);
+    } else {
+        // Cache-backed images have no pixels to reference, so copy the
+        // region instead.
+        result.reset(view_spec(spec(), roi));
+        if (!get_pixels(roi, spec().format, result.localpixels(),
+                        result.pixel_stride(), result.scanline_stride(),
+                        result.z_stride()))
+            result.errorfmt("{}", geterror());
+    }
+    return result;
+}
+
+
+
 template<typename T>
 static inline float
 getchannel_(const ImageBuf& buf, int x, int y, int z, int c,
@@ -2806,10 +3802,25 @@ ImageBufImpl::pixeladdr(int x, int y, int z, int ch) const
 
 
 
+bool
+ImageBuf::scanline_span_ok(TypeDesc type, int xbegin, int xend, int y,
+                           int z) const
+{
+    const ImageSpec& spec(m_impl->spec());
+    return localpixels() && spec.format == type
+           && pixel_stride() == stride_t(spec.nchannels * type.size())
+           && xbegin >= spec.x && xend <= spec.x + spec.width
+           && xbegin <= xend && y >= spec.y && y < spec.y + spec.height
+           && z >= spec.z && z < spec.z + spec.depth;
+}
+
+
+
 void*
 ImageBufImpl::pixeladdr(int x, int y, int z, int ch)
 {
     validate_pixels();
+    unshare_pixels();
     if (cachedpixels())
         return nullptr;
     x -= m_spec.x;
@@ -3151,6 +4162,10 @@ ImageBuf::IteratorBase::init_ib(WrapMode wrap, bool write)
     m_localpixels = (m_ib->localpixels() != nullptr);
     // if (write)
     //      ensure_writable();  // Not here; do it lazily
+    // But pixels shared with another ImageBuf must be made private now,
+    // since pos() hands out raw pointers into them.
+    if (write && m_localpixels)
+        const_cast<ImageBufImpl*>(m_ib->m_impl.get())->unshare_pixels();
     m_img_xbegin   = spec.x;
     m_img_xend     = spec.x + spec.width;
     m_img_ybegin   = spec.y;
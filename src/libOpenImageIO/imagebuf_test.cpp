@@ -4,6 +4,7 @@
 
 
 #include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/color.h>
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
@@ -326,6 +327,240 @@ test_empty_iterator()
 
 
 
+void
+test_allocators()
+{
+    // An application allocator sees every allocation and its release
+    struct CountingAllocator final : public ImageBufAllocator {
+        int live = 0;
+        void* allocate(size_t size) override
+        {
+            ++live;
+            return heap()->allocate(size);
+        }
+        void deallocate(void* ptr, size_t size) override
+        {
+            --live;
+            heap()->deallocate(ptr, size);
+        }
+    } counter;
+    {
+        ImageBuf A;
+        A.set_allocator(&counter);
+        A.reset(ImageSpec(64, 64, 3, TypeDesc::FLOAT));
+        OIIO_CHECK_EQUAL(counter.live, 1);
+        ImageBuf B(A);  // copies share A's pixels until written...
+        OIIO_CHECK_EQUAL(counter.live, 1);
+        B.localpixels();  // ...then use the same allocator
+        OIIO_CHECK_EQUAL(counter.live, 2);
+        OIIO_CHECK_ASSERT(B.allocator() == &counter);
+    }
+    OIIO_CHECK_EQUAL(counter.live, 0);
+
+    // The pool hands a freed buffer back out for the next one its size
+    OIIO::attribute("imagebuf:allocator", "pool");
+    const void* first = nullptr;
+    {
+        ImageBuf A(ImageSpec(256, 256, 4, TypeDesc::FLOAT));
+        first = A.localpixels();
+    }
+    {
+        ImageBuf A(ImageSpec(256, 256, 4, TypeDesc::FLOAT));
+        OIIO_CHECK_ASSERT(A.localpixels() == first);
+    }
+    OIIO::attribute("imagebuf:allocator", "heap");
+    OIIO::attribute("imagebuf:pool_max_MB", 0);  // empty it
+    OIIO::attribute("imagebuf:pool_max_MB", 1024);
+
+    // Pinned memory works like any other, including for reads
+    const float gray[3] = { 0.5f, 0.5f, 0.5f };
+    ImageBuf P;
+    P.set_allocator(ImageBufAllocator::pinned());
+    P.reset(ImageSpec(64, 64, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::fill(P, gray);
+    P.write("tmp-pinned.tif");
+    ImageBuf Q("tmp-pinned.tif");
+    Q.set_allocator(ImageBufAllocator::pinned());
+    OIIO_CHECK_ASSERT(Q.read(0, 0, true, TypeDesc::FLOAT));
+    OIIO_CHECK_EQUAL(Q.getchannel(63, 63, 0, 2), 0.5f);
+    OIIO_CHECK_ASSERT(OIIO::attribute("imagebuf:allocator", "pinned"));
+    OIIO_CHECK_EQUAL(OIIO::get_string_attribute("imagebuf:allocator"),
+                     "pinned");
+    OIIO::attribute("imagebuf:allocator", "heap");
+    Filesystem::remove("tmp-pinned.tif");
+}
+
+
+
+void
+test_copy_on_write()
+{
+    const float red[3] = { 1, 0, 0 }, green[3] = { 0, 1, 0 };
+    ImageBuf A(ImageSpec(64, 64, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::fill(A, red);
+
+    // A copy shares the source's pixel memory...
+    ImageBuf B(A);
+    const ImageBuf& Bc(B);
+    const ImageBuf& Ac(A);
+    OIIO_CHECK_ASSERT(Bc.localpixels() == Ac.localpixels());
+    ImageBuf C;
+    C.copy(A);
+    OIIO_CHECK_ASSERT(C.storage() == ImageBuf::LOCALBUFFER);
+    OIIO_CHECK_ASSERT(((const ImageBuf&)C).localpixels() == Ac.localpixels());
+
+    // ...until it is written, which leaves the source untouched
+    B.setpixel(5, 5, green);
+    OIIO_CHECK_ASSERT(Bc.localpixels() != Ac.localpixels());
+    float pixel[3];
+    B.getpixel(5, 5, pixel);
+    OIIO_CHECK_EQUAL(pixel[1], 1.0f);
+    A.getpixel(5, 5, pixel);
+    OIIO_CHECK_EQUAL(pixel[1], 0.0f);
+    C.getpixel(5, 5, pixel);
+    OIIO_CHECK_EQUAL(pixel[1], 0.0f);
+
+    // Writing through the source unshares it from the remaining copy too
+    ImageBufAlgo::fill(A, green);
+    C.getpixel(5, 5, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    OIIO_CHECK_ASSERT(((const ImageBuf&)C).localpixels() != Ac.localpixels());
+
+    // A data type conversion can't share
+    ImageBuf D;
+    D.copy(C, TypeDesc::HALF);
+    OIIO_CHECK_EQUAL(D.spec().format, TypeDesc::HALF);
+    D.getpixel(5, 5, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+
+    // Pixels that were never shared are written in place...
+    const ImageBuf& Dc(D);
+    const void* Dpixels = Dc.localpixels();
+    D.setpixel(5, 5, green);
+    OIIO_CHECK_ASSERT(Dc.localpixels() == Dpixels);
+
+    // ...but once shared, they are copied before a write even after the
+    // other ImageBuf is gone.
+    {
+        ImageBuf E(D);
+    }
+    D.setpixel(5, 5, red);
+    OIIO_CHECK_ASSERT(Dc.localpixels() != Dpixels);
+    D.getpixel(5, 5, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+}
+
+
+
+void
+test_view()
+{
+    const float rgba[4] = { 0.1f, 0.2f, 0.3f, 1.0f }, five[2] = { 5, 5 };
+    ImageBuf A(ImageSpec(64, 64, 4, TypeDesc::FLOAT));
+    ImageBufAlgo::fill(A, rgba);
+    const ImageBuf& Ac(A);
+    float pixel[4];
+
+    // A view of channels G,B of a window references A's pixels in place
+    ImageBuf V = A.view(ROI(8, 24, 16, 32, 0, 1, 1, 3));
+    const ImageBuf& Vc(V);
+    OIIO_CHECK_ASSERT(!V.has_error());
+    OIIO_CHECK_EQUAL(V.roi(), ROI(8, 24, 16, 32, 0, 1, 0, 2));
+    OIIO_CHECK_EQUAL(V.spec().channelnames[0], "G");
+    OIIO_CHECK_EQUAL(V.spec().alpha_channel, -1);
+    OIIO_CHECK_EQUAL(V.storage(), ImageBuf::LOCALBUFFER);
+    OIIO_CHECK_EQUAL(V.pixel_stride(), A.pixel_stride());
+    OIIO_CHECK_ASSERT(Vc.localpixels() == Ac.pixeladdr(8, 16, 0, 1));
+    V.getpixel(10, 20, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 0.2f);
+    OIIO_CHECK_EQUAL(pixel[1], 0.3f);
+
+    // Writing to the view gives it a compact copy of just its region
+    V.setpixel(8, 16, five);
+    OIIO_CHECK_EQUAL(V.pixel_stride(), stride_t(2 * sizeof(float)));
+    V.getpixel(8, 16, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 5.0f);
+    V.getpixel(23, 31, pixel);
+    OIIO_CHECK_EQUAL(pixel[1], 0.3f);
+    A.getpixel(8, 16, pixel);
+    OIIO_CHECK_EQUAL(pixel[1], 0.2f);
+
+    // A view keeps the pixels alive after its parent goes away
+    {
+        ImageBuf P(A);
+        V = P.view(ROI(0, 4, 0, 4, 0, 1, 3, 4));
+    }
+    V.getpixel(2, 2, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+
+    // IBA channels() and crop() hand back views when they can
+    ImageBuf RGB = ImageBufAlgo::channels(A, 3, {});
+    OIIO_CHECK_EQUAL(RGB.nchannels(), 3);
+    OIIO_CHECK_ASSERT(((const ImageBuf&)RGB).localpixels()
+                      == Ac.localpixels());
+    ImageBuf Cr = ImageBufAlgo::crop(A, ROI(32, 64, 0, 16));
+    OIIO_CHECK_EQUAL(Cr.roi(), ROI(32, 64, 0, 16, 0, 1, 0, 4));
+    OIIO_CHECK_ASSERT(((const ImageBuf&)Cr).localpixels()
+                      == Ac.pixeladdr(32, 0));
+    ImageBuf Cu = ImageBufAlgo::cut(A, ROI(32, 64, 0, 16));
+    Cu.getpixel(0, 0, pixel);
+    OIIO_CHECK_EQUAL(pixel[2], 0.3f);
+
+    // No overlap is an error
+    ImageBuf E = A.view(ROI(100, 110, 100, 110));
+    OIIO_CHECK_ASSERT(E.has_error());
+    E.geterror();
+}
+
+
+
+void
+test_mmap_storage()
+{
+    const float gray[3] = { 0.5f, 0.5f, 0.5f };
+    ImageSpec spec(128, 64, 3, TypeDesc::FLOAT);
+    float pixel[3];
+
+    // Scratch mapping behaves like local storage, starting out black
+    ImageBuf A;
+    OIIO_CHECK_ASSERT(A.reset_mmap(spec));
+    OIIO_CHECK_EQUAL(A.storage(), ImageBuf::MMAPBUFFER);
+    OIIO_CHECK_ASSERT(A.localpixels() != nullptr);
+    A.getpixel(10, 10, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 0.0f);
+    ImageBufAlgo::fill(A, gray);
+    A.getpixel(10, 10, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 0.5f);
+
+    // Copies stay mapped, even once they are unshared
+    ImageBuf B(A);
+    B.setpixel(3, 3, pixel);
+    OIIO_CHECK_EQUAL(B.storage(), ImageBuf::MMAPBUFFER);
+
+    // A named file persists and is reused if it's the right size
+    std::string filename = "mmap_storage_test.pix";
+    {
+        ImageBuf C;
+        OIIO_CHECK_ASSERT(C.reset_mmap(spec, filename));
+        ImageBufAlgo::fill(C, gray);
+    }
+    OIIO_CHECK_EQUAL(Filesystem::file_size(filename), spec.image_bytes());
+    {
+        ImageBuf C;
+        OIIO_CHECK_ASSERT(C.reset_mmap(spec, filename));
+        C.getpixel(100, 50, pixel);
+        OIIO_CHECK_EQUAL(pixel[2], 0.5f);
+    }
+    Filesystem::remove(filename);
+
+    ImageBuf bad;
+    OIIO_CHECK_ASSERT(!bad.reset_mmap(ImageSpec()));
+    OIIO_CHECK_ASSERT(bad.has_error());
+    bad.geterror();
+}
+
+
+
 void
 print(const ImageBuf& A)
 {
@@ -463,6 +698,175 @@ test_roi()
 
 
 
+// Test reading just a window of a scanline or tiled file
+void
+test_read_window()
+{
+    // Pixel values encode their own coordinates and channel
+    ImageBuf src(ImageSpec(100, 80, 3, TypeDesc::FLOAT));
+    for (ImageBuf::Iterator<float> p(src); !p.done(); ++p)
+        for (int c = 0; c < 3; ++c)
+            p[c] = float(p.x() + 1000 * p.y() + 100000 * c);
+    src.write("tmp-window-scan.tif");
+    src.set_write_tiles(16, 16);
+    src.write("tmp-window-tile.tif");
+
+    for (auto name : { "tmp-window-scan.tif", "tmp-window-tile.tif" }) {
+        ImageBuf A(name);
+        OIIO_CHECK_ASSERT(A.read(0, 0, ROI(30, 57, 21, 45, 0, 1, 1, 3)));
+        OIIO_CHECK_EQUAL(A.storage(), ImageBuf::LOCALBUFFER);
+        OIIO_CHECK_EQUAL(A.roi(), ROI(30, 57, 21, 45, 0, 1, 0, 2));
+        OIIO_CHECK_EQUAL(A.spec().full_width, 100);
+        float pixel[2];
+        A.getpixel(30, 21, pixel);
+        OIIO_CHECK_EQUAL(pixel[0], 30.0f + 21000.0f + 100000.0f);
+        A.getpixel(56, 44, pixel);
+        OIIO_CHECK_EQUAL(pixel[1], 56.0f + 44000.0f + 200000.0f);
+
+        // A window hanging off the image is clipped to the data window
+        ImageBuf B(name);
+        OIIO_CHECK_ASSERT(B.read(0, 0, ROI(90, 200, -5, 3)));
+        OIIO_CHECK_EQUAL(B.roi(), ROI(90, 100, 0, 3, 0, 1, 0, 3));
+        B.getpixel(99, 2, pixel);
+        OIIO_CHECK_EQUAL(pixel[0], 99.0f + 2000.0f);
+
+        ImageBuf C(name);
+        OIIO_CHECK_ASSERT(!C.read(0, 0, ROI(200, 300, 0, 10)));
+        OIIO_CHECK_ASSERT(C.has_error());
+        C.geterror();
+
+        // Aborting from the progress callback fails the read
+        ImageBuf D(name);
+        auto abort = [](void*, float) -> bool { return true; };
+        OIIO_CHECK_ASSERT(!D.read(0, 0, ROI(10, 90, 5, 70), true,
+                                  TypeDesc::FLOAT, abort, nullptr));
+        OIIO_CHECK_ASSERT(D.has_error());
+        D.geterror();
+    }
+    Filesystem::remove("tmp-window-scan.tif");
+    Filesystem::remove("tmp-window-tile.tif");
+}
+
+
+
+void
+test_scanline_align()
+{
+    OIIO_CHECK_ASSERT(!OIIO::attribute("imagebuf:scanline_align", 48));
+    OIIO::attribute("imagebuf:scanline_align", 64);
+    // Five RGB float pixels are 60 bytes, padded out to 64 per scanline
+    ImageBuf A(ImageSpec(5, 4, 3, TypeDesc::FLOAT));
+    OIIO_CHECK_EQUAL(A.scanline_stride(), stride_t(64));
+    OIIO_CHECK_ASSERT(!A.contiguous());
+    for (ImageBuf::Iterator<float> p(A); !p.done(); ++p)
+        for (int c = 0; c < 3; ++c)
+            p[c] = float(p.x() + 10 * p.y() + 100 * c);
+    float packed[4][5][3];
+    OIIO_CHECK_ASSERT(A.get_pixels(A.roi(), TypeFloat, packed));
+    OIIO_CHECK_EQUAL(packed[3][4][2], 234.0f);
+
+    // Files read into padded buffers land on the right rows
+    A.write("tmp-align.tif");
+    ImageBuf B("tmp-align.tif");
+    OIIO_CHECK_ASSERT(B.read(0, 0, true, TypeDesc::FLOAT));
+    OIIO_CHECK_EQUAL(B.scanline_stride(), stride_t(64));
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(A, B, 0.0f, 0.0f).nfail, 0);
+
+    OIIO::attribute("imagebuf:scanline_align", 0);
+    ImageBuf C = B.copy(TypeDesc::FLOAT);
+    OIIO_CHECK_EQUAL(C.scanline_stride(), stride_t(60));
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(A, C, 0.0f, 0.0f).nfail, 0);
+    Filesystem::remove("tmp-align.tif");
+}
+
+
+
+void
+test_read_threads()
+{
+    // Enough rows, with a ragged last band, to be split among threads
+    ImageBuf src(ImageSpec(40, 300, 5, TypeDesc::FLOAT));
+    for (ImageBuf::Iterator<float> p(src); !p.done(); ++p)
+        for (int c = 0; c < 5; ++c)
+            p[c] = float(p.x() + 1000 * p.y() + 1000000 * c);
+    src.write("tmp-bands-scan.tif");
+    src.set_write_tiles(16, 16);
+    src.write("tmp-bands-tile.tif");
+
+    OIIO::attribute("imagebuf:read_threads", 4);
+    for (auto name : { "tmp-bands-scan.tif", "tmp-bands-tile.tif" }) {
+        ImageBuf A(name);
+        OIIO_CHECK_ASSERT(A.read(0, 0, true, TypeDesc::FLOAT));
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(A, src, 0.0f, 0.0f).nfail,
+                         0);
+        // Channel subsets are read in bands too
+        ImageBuf B(name);
+        OIIO_CHECK_ASSERT(B.read(0, 0, 2, 4, true, TypeDesc::FLOAT));
+        float pixel[2];
+        B.getpixel(39, 299, pixel);
+        OIIO_CHECK_EQUAL(pixel[1], 39.0f + 299000.0f + 3000000.0f);
+    }
+    OIIO::attribute("imagebuf:read_threads", 1);
+    Filesystem::remove("tmp-bands-scan.tif");
+    Filesystem::remove("tmp-bands-tile.tif");
+}
+
+
+
+void
+test_write_async()
+{
+    const float red[3] = { 1, 0, 0 }, green[3] = { 0, 1, 0 };
+    ImageBuf A(ImageSpec(64, 64, 3, TypeDesc::UINT8));
+    ImageBufAlgo::fill(A, red);
+    auto done = A.write_async("tmp-async.tif");
+    // Changes made right after the call don't leak into the file
+    ImageBufAlgo::fill(A, green);
+    OIIO_CHECK_EQUAL(done.get(), "");
+    ImageBuf B("tmp-async.tif");
+    float pixel[3];
+    B.getpixel(10, 10, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    B.reset();
+    Filesystem::remove("tmp-async.tif");
+
+    // Failures come back through the future
+    auto failed = A.write_async("no/such/dir/tmp-async.tif");
+    OIIO_CHECK_ASSERT(failed.get().size() > 0);
+}
+
+
+
+void
+test_write_colorprocessor()
+{
+    // Writing with a color processor matches colorconvert then write, and
+    // leaves the ImageBuf's own pixels alone.
+    ImageBuf A(ImageSpec(64, 48, 4, TypeDesc::FLOAT));
+    ImageBufAlgo::fill(A, cspan<float>({ 0.1f, 0.2f, 0.3f, 1.0f }),
+                       cspan<float>({ 0.8f, 0.5f, 0.05f, 0.5f }));
+    ColorConfig config;
+    auto processor = config.createColorProcessor("linear", "sRGB");
+    OIIO_CHECK_ASSERT(processor);
+    ImageBuf C = ImageBufAlgo::colorconvert(A, processor.get(), true);
+    C.write("tmp-cc-separate.tif", TypeUInt16);
+    A.set_write_colorprocessor(processor, true);
+    A.write("tmp-cc-fused.tif", TypeUInt16);
+    A.set_write_colorprocessor(nullptr);
+    ImageBuf separate("tmp-cc-separate.tif"), fused("tmp-cc-fused.tif");
+    auto comp = ImageBufAlgo::compare(separate, fused, 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    float pixel[4];
+    A.getpixel(0, 0, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 0.1f);
+    separate.reset();
+    fused.reset();
+    Filesystem::remove("tmp-cc-separate.tif");
+    Filesystem::remove("tmp-cc-fused.tif");
+}
+
+
+
 // Test what happens when we read, replace the image on disk, then read
 // again.
 void
@@ -707,7 +1111,16 @@ main(int /*argc*/, char* /*argv*/[])
 
     test_set_get_pixels();
     time_get_pixels();
-
+    test_allocators();
+    test_copy_on_write();
+    test_view();
+    test_mmap_storage();
+
+    test_read_window();
+    test_read_threads();
+    test_scanline_align();
+    test_write_async();
+    test_write_colorprocessor();
     test_write_over();
 
     test_uncaught_error();
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <atomic>
 #include <cmath>
 #include <memory>
 
@@ -357,6 +358,323 @@ ImageBufAlgo::type_merge(TypeDesc::BASETYPE a, TypeDesc::BASETYPE b)
 
 
 
+// Fetch channels [roi.chbegin, roi.chend) of scanline y of src, over
+// columns [xbegin, xend), as packed floats. Rows and columns outside src's
+// data window repeat its edge pixels, like WrapClamp.
+static void
+convolve_fetch_row(const ImageBuf& src, ROI roi, int xbegin, int xend, int y,
+                   float* row)
+{
+    const ROI srcroi = src.roi();
+    const int nchans = roi.nchannels();
+    y                = clamp(y, srcroi.ybegin, srcroi.yend - 1);
+    int x0           = std::max(xbegin, srcroi.xbegin);
+    int x1           = std::min(xend, srcroi.xend);
+    int offset       = x0 - xbegin;
+    if (x0 >= x1) {
+        // No overlap at all: every column is the nearest edge column.
+        x0     = xbegin >= srcroi.xend ? srcroi.xend - 1 : srcroi.xbegin;
+        x1     = x0 + 1;
+        offset = 0;
+    }
+    float* first = row + size_t(offset) * nchans;
+    src.get_pixels(ROI(x0, x1, y, y + 1, srcroi.zbegin, srcroi.zbegin + 1,
+                       roi.chbegin, roi.chend),
+                   TypeFloat, first);
+    const float* last = first + size_t(x1 - x0 - 1) * nchans;
+    for (float* p = row; p < first; p += nchans)
+        std::copy_n(first, nchans, p);
+    for (float* p = first + size_t(x1 - x0) * nchans;
+         p < row + size_t(xend - xbegin) * nchans; p += nchans)
+        std::copy_n(last, nchans, p);
+}
+
+
+
+// Store a packed float scanline segment, channels [roi.chbegin,
+// roi.chend), into dst's (writable, local) pixels.
+static void
+convolve_store_row(ImageBuf& dst, ROI roi, int xbegin, int xend, int y,
+                   const float* row)
+{
+    int nchans = roi.nchannels();
+    convert_image(nchans, xend - xbegin, 1, 1, row, TypeFloat,
+                  nchans * sizeof(float), AutoStride, AutoStride,
+                  dst.pixeladdr(xbegin, y, roi.zbegin, roi.chbegin),
+                  dst.spec().format, dst.pixel_stride(), AutoStride,
+                  AutoStride);
+}
+
+
+
+// If the 2D kernel k (kw x kh, row major) is the outer product of a
+// column and a row vector, return true and store them in col and row.
+static bool
+convolve_separate(const float* k, int kw, int kh, std::vector<float>& col,
+                  std::vector<float>& row)
+{
+    int pivot    = 0;
+    float maxabs = 0.0f;
+    for (int i = 0; i < kw * kh; ++i)
+        if (std::abs(k[i]) > maxabs) {
+            maxabs = std::abs(k[i]);
+            pivot  = i;
+        }
+    if (maxabs == 0.0f)
+        return false;
+    int pi = pivot % kw, pj = pivot / kw;
+    row.assign(k + pj * kw, k + pj * kw + kw);
+    col.resize(kh);
+    for (int j = 0; j < kh; ++j)
+        col[j] = k[j * kw + pi] / k[pivot];
+    const float eps = 1.0e-6f * maxabs;
+    for (int j = 0; j < kh; ++j)
+        for (int i = 0; i < kw; ++i)
+            if (std::abs(k[j * kw + i] - col[j] * row[i]) > eps)
+                return false;
+    return true;
+}
+
+
+
+// Convolve a 2D image a scanline at a time. Each source row needed by a
+// strip of the output is converted once to packed floats and kept in a
+// ring of kernel-height rows; every kernel tap then accumulates a whole
+// output row as one flat loop over packed floats, which the compiler can
+// vectorize whatever the source and destination pixel types. Rank-1
+// kernels (box, gaussian, binomial, ...) are applied in two 1D passes,
+// kw + kh taps per pixel instead of kw * kh, and zero taps are skipped.
+static bool
+convolve_rows(ImageBuf& dst, const ImageBuf& src, const float* k, ROI kroi,
+              float scale, ROI roi, int nthreads)
+{
+    const int kw = kroi.width(), kh = kroi.height();
+    std::vector<float> kcol, krow;
+    bool separable = convolve_separate(k, kw, kh, kcol, krow);
+    // The nonzero taps of a general kernel
+    struct Tap {
+        int i, j;
+        float w;
+    };
+    std::vector<Tap> taps;
+    if (!separable)
+        for (int j = 0; j < kh; ++j)
+            for (int i = 0; i < kw; ++i)
+                if (k[j * kw + i] != 0.0f)
+                    taps.push_back({ i, j, k[j * kw + i] });
+
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const int nchans     = roi.nchannels();
+        const size_t outvals = size_t(roi.width()) * nchans;
+        // Source columns under this strip, and floats per source row
+        const int sxbegin   = roi.xbegin + kroi.xbegin;
+        const int sxend     = roi.xend + kroi.xend - 1;
+        const size_t invals = size_t(sxend - sxbegin) * nchans;
+        // The ring holds source rows (general kernels) or horizontally
+        // filtered rows (separable ones), keyed by source row.
+        const size_t ringvals = separable ? outvals : invals;
+        std::vector<float> ring(ringvals * kh);
+        std::vector<int> ringrow(kh, std::numeric_limits<int>::min());
+        std::vector<float> srcrow(separable ? invals : 0);
+        std::vector<float> out(outvals);
+        const int ybase = roi.ybegin + kroi.ybegin;
+
+        // Return ring row for source row sy (not yet clamped), filling it
+        // if needed.
+        auto get_row = [&](int sy) -> const float* {
+            int r       = (sy - ybase) % kh;
+            float* slot = ring.data() + ringvals * r;
+            if (ringrow[r] == sy)
+                return slot;
+            ringrow[r] = sy;
+            if (!separable) {
+                convolve_fetch_row(src, roi, sxbegin, sxend, sy, slot);
+                return slot;
+            }
+            convolve_fetch_row(src, roi, sxbegin, sxend, sy, srcrow.data());
+            std::fill(slot, slot + outvals, 0.0f);
+            for (int i = 0; i < kw; ++i) {
+                float w = krow[i];
+                if (w == 0.0f)
+                    continue;
+                const float* p = srcrow.data() + size_t(i) * nchans;
+                for (size_t v = 0; v < outvals; ++v)
+                    slot[v] += w * p[v];
+            }
+            return slot;
+        };
+
+        for (int y = roi.ybegin; y < roi.yend; ++y) {
+            std::fill(out.begin(), out.end(), 0.0f);
+            if (separable) {
+                for (int j = 0; j < kh; ++j) {
+                    float w = kcol[j] * scale;
+                    if (w == 0.0f)
+                        continue;
+                    const float* p = get_row(y + kroi.ybegin + j);
+                    for (size_t v = 0; v < outvals; ++v)
+                        out[v] += w * p[v];
+                }
+            } else {
+                for (auto& t : taps) {
+                    float w        = t.w * scale;
+                    const float* p = get_row(y + kroi.ybegin + t.j)
+                                     + size_t(t.i) * nchans;
+                    for (size_t v = 0; v < outvals; ++v)
+                        out[v] += w * p[v];
+                }
+            }
+            convolve_store_row(dst, roi, roi.xbegin, roi.xend, y, out.data());
+        }
+    });
+    return true;
+}
+
+
+
+// Gather the first channel of a 2D float kernel as packed floats,
+// returning their sum.
+static float
+convolve_kernel_values(const ImageBuf& kernel, std::vector<float>& k)
+{
+    ROI kroi   = kernel.roi();
+    int kchans = kernel.nchannels();
+    std::vector<float> kvals(kroi.npixels() * kchans);
+    kernel.get_pixels(kroi, TypeFloat, kvals.data());
+    k.resize(kroi.npixels());
+    float sum = 0.0f;
+    for (size_t i = 0; i < k.size(); ++i) {
+        k[i] = kvals[i * kchans];
+        sum += k[i];
+    }
+    return sum;
+}
+
+
+
+// Smallest n >= minsize whose only prime factors are 2, 3, and 5, the
+// sizes kissfft transforms fastest.
+static int
+fft_good_size(int minsize)
+{
+    for (int n = std::max(1, minsize);; ++n) {
+        int m = n;
+        for (int f : { 2, 3, 5 })
+            while (m % f == 0)
+                m /= f;
+        if (m == 1)
+            return n;
+    }
+}
+
+
+
+// In-place 2D FFT of an n x n complex array, rows then columns.
+static void
+fft2d(kissfft<float>& F, std::complex<float>* data, int n,
+      std::complex<float>* tmp, std::complex<float>* col)
+{
+    for (int y = 0; y < n; ++y) {
+        F.transform(data + size_t(y) * n, tmp);
+        std::copy_n(tmp, n, data + size_t(y) * n);
+    }
+    for (int x = 0; x < n; ++x) {
+        for (int y = 0; y < n; ++y)
+            col[y] = data[size_t(y) * n + x];
+        F.transform(col, tmp);
+        for (int y = 0; y < n; ++y)
+            data[size_t(y) * n + x] = tmp[y];
+    }
+}
+
+
+
+// Convolve a 2D image by FFT, one output tile at a time. Each tile is the
+// valid part of the circular convolution of the N x N block of source
+// pixels under it -- "overlap-save" -- so tiles are independent and run
+// on separate threads with no summing of overlaps. Two channels at a time
+// ride in the real and imaginary parts, since the kernel is real.
+static bool
+fft_convolve_(ImageBuf& dst, const ImageBuf& src, const float* k, ROI kroi,
+              float scale, ROI roi, int nthreads)
+{
+    typedef std::complex<float> cpx;
+    const int kw = kroi.width(), kh = kroi.height();
+    const int kmax = std::max(kw, kh);
+    // Tiles of about 3x the kernel size keep most of each block valid
+    // without making the transforms needlessly big.
+    const int N  = fft_good_size(
+        kmax + std::min(std::max(roi.width(), roi.height()), 3 * kmax) - 1);
+    const int tw = N - kw + 1, th = N - kh + 1;
+
+    // The kernel's spectrum, reflected so that the circular convolution
+    // computes sum(k[j][i] * src[y+j][x+i]) as convolve() does, and
+    // prescaled by the normalization and the 1/(N*N) of the round trip.
+    std::vector<cpx> G(size_t(N) * N), tmp(N), col(N);
+    const float gscale = scale / (float(N) * float(N));
+    for (int j = 0; j < kh; ++j)
+        for (int i = 0; i < kw; ++i)
+            G[size_t((N - j) % N) * N + (N - i) % N] = k[j * kw + i] * gscale;
+    {
+        kissfft<float> F(N, false);
+        fft2d(F, G.data(), N, tmp.data(), col.data());
+    }
+
+    const int nchans = roi.nchannels();
+    parallel_for_chunked_2D(
+        roi.xbegin, roi.xend, tw, roi.ybegin, roi.yend, th,
+        [&](int64_t xb, int64_t xe, int64_t yb, int64_t ye) {
+            kissfft<float> Ffwd(N, false), Finv(N, true);
+            std::vector<cpx> block(size_t(N) * N), tmp(N), col(N);
+            const int w = int(xe - xb), h = int(ye - yb);
+            const int inw = w + kw - 1, inh = h + kh - 1;
+            // The source block (all channels), and the output tile
+            std::vector<float> in(size_t(inw) * inh * nchans);
+            std::vector<float> out(size_t(w) * h * nchans);
+            for (int v = 0; v < inh; ++v)
+                convolve_fetch_row(src, roi, int(xb) + kroi.xbegin,
+                                   int(xb) + kroi.xbegin + inw,
+                                   int(yb) + kroi.ybegin + v,
+                                   in.data() + size_t(v) * inw * nchans);
+            for (int c = 0; c < nchans; c += 2) {
+                bool pair = c + 1 < nchans;
+                std::fill(block.begin(), block.end(), cpx(0.0f));
+                for (int v = 0; v < inh; ++v) {
+                    const float* p = in.data() + size_t(v) * inw * nchans + c;
+                    cpx* b         = block.data() + size_t(v) * N;
+                    for (int u = 0; u < inw; ++u, p += nchans)
+                        b[u] = cpx(p[0], pair ? p[1] : 0.0f);
+                }
+                fft2d(Ffwd, block.data(), N, tmp.data(), col.data());
+                for (size_t i = 0, e = block.size(); i < e; ++i)
+                    block[i] *= G[i];
+                fft2d(Finv, block.data(), N, tmp.data(), col.data());
+                for (int v = 0; v < h; ++v) {
+                    const cpx* b = block.data() + size_t(v) * N;
+                    float* o     = out.data() + size_t(v) * w * nchans + c;
+                    for (int u = 0; u < w; ++u, o += nchans) {
+                        o[0] = b[u].real();
+                        if (pair)
+                            o[1] = b[u].imag();
+                    }
+                }
+            }
+            for (int v = 0; v < h; ++v)
+                convolve_store_row(dst, roi, int(xb), int(xe), int(yb) + v,
+                                   out.data() + size_t(v) * w * nchans);
+        },
+        paropt(nthreads));
+    return true;
+}
+
+
+
+// Kernels with at least this many nonzero taps that don't factor into 1D
+// passes are faster to apply by FFT.
+static const int fft_convolve_min_taps = 25 * 25;
+
+
+
 template<typename DSTTYPE, typename SRCTYPE>
 static bool
 convolve_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
@@ -365,9 +683,12 @@ convolve_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
     using namespace ImageBufAlgo;
     OIIO_DASSERT(kernel.spec().format == TypeDesc::FLOAT && kernel.localpixels()
                  && "kernel should be float and in local memory");
+    // Gather the kernel values, packed, however the kernel lays them out
+    ROI kroi   = kernel.roi();
+    int kchans = kernel.nchannels();
+    std::vector<float> kvals(kroi.npixels() * kchans);
+    kernel.get_pixels(kroi, TypeFloat, kvals.data());
     parallel_image(roi, nthreads, [&](ROI roi) {
-        ROI kroi   = kernel.roi();
-        int kchans = kernel.nchannels();
 
         float scale = 1.0f;
         if (normalize) {
@@ -383,7 +704,7 @@ convolve_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
         for (; !d.done(); ++d) {
             for (int c = roi.chbegin; c < roi.chend; ++c)
                 sum[c] = 0.0f;
-            const float* k = (const float*)kernel.localpixels();
+            const float* k = kvals.data();
             s.rerange(d.x() + kroi.xbegin, d.x() + kroi.xend,
                       d.y() + kroi.ybegin, d.y() + kroi.yend,
                       d.z() + kroi.zbegin, d.z() + kroi.zend,
@@ -409,6 +730,9 @@ ImageBufAlgo::convolve(ImageBuf& dst, const ImageBuf& src,
     pvt::LoggedTimer logtime("IBA::convolve");
     if (!IBAprep(roi, &dst, &src, IBAprep_REQUIRE_SAME_NCHANNELS))
         return false;
+    if (ComputeBackend* backend = compute_backend())
+        if (backend->convolve(dst, src, kernel, normalize, roi, nthreads))
+            return true;
     bool ok;
     // Ensure that the kernel is float and in local memory
     const ImageBuf* K = &kernel;
@@ -417,6 +741,25 @@ ImageBufAlgo::convolve(ImageBuf& dst, const ImageBuf& src,
         Ktmp.copy(kernel, TypeDesc::FLOAT);
         K = &Ktmp;
     }
+    if (K->spec().depth == 1 && roi.depth() == 1) {
+        // Planar images go a scanline at a time (see convolve_rows), or by
+        // FFT for big kernels that aren't separable.
+        ROI kroi = K->roi();
+        std::vector<float> k0, kcol, krow;
+        float sum   = convolve_kernel_values(*K, k0);
+        float scale = normalize ? 1.0f / sum : 1.0f;
+        // Give dst its own writable pixels now, before the strips write
+        // through pixeladdr().
+        dst.localpixels();
+        auto ntaps = std::count_if(k0.begin(), k0.end(),
+                                   [](float v) { return v != 0.0f; });
+        if (ntaps >= fft_convolve_min_taps
+            && !convolve_separate(k0.data(), kroi.width(), kroi.height(), kcol,
+                                  krow))
+            return fft_convolve_(dst, src, k0.data(), kroi, scale, roi,
+                                 nthreads);
+        return convolve_rows(dst, src, k0.data(), kroi, scale, roi, nthreads);
+    }
     OIIO_DISPATCH_COMMON_TYPES2(ok, "convolve", convolve_, dst.spec().format,
                                 src.spec().format, dst, src, *K, normalize, roi,
                                 nthreads);
@@ -438,6 +781,42 @@ ImageBufAlgo::convolve(const ImageBuf& src, const ImageBuf& kernel,
 
 
 
+bool
+ImageBufAlgo::fft_convolve(ImageBuf& dst, const ImageBuf& src,
+                           const ImageBuf& kernel, bool normalize, ROI roi,
+                           int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::fft_convolve");
+    if (!IBAprep(roi, &dst, &src,
+                 IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
+        return false;
+    if (!kernel.initialized() || kernel.spec().depth > 1) {
+        dst.errorfmt("fft_convolve needs a 2D kernel");
+        return false;
+    }
+    std::vector<float> k0;
+    float sum   = convolve_kernel_values(kernel, k0);
+    float scale = normalize ? 1.0f / sum : 1.0f;
+    dst.localpixels();
+    return fft_convolve_(dst, src, k0.data(), kernel.roi(), scale, roi,
+                         nthreads);
+}
+
+
+
+ImageBuf
+ImageBufAlgo::fft_convolve(const ImageBuf& src, const ImageBuf& kernel,
+                           bool normalize, ROI roi, int nthreads)
+{
+    ImageBuf result;
+    bool ok = fft_convolve(result, src, kernel, normalize, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::fft_convolve() error");
+    return result;
+}
+
+
+
 inline float
 binomial(int n, int k)
 {
@@ -653,54 +1032,302 @@ ImageBufAlgo::laplacian(const ImageBuf& src, ROI roi, int nthreads)
 
 
 
-template<class Rtype, class Atype>
-static bool
-median_filter_impl(ImageBuf& R, const ImageBuf& A, int width, int height,
-                   ROI roi, int nthreads)
+// How rank_filter() turns one channel's values into histogram levels and
+// back. 8- and 16-bit sources use their code values. Any other type uses
+// the ranks of its distinct values, which is exact when there are at most
+// 65536 of them and otherwise bins them into 65536 equally populated
+// levels (so the result is within one level of the true rank value).
+struct RankLevels {
+    float scale = 0.0f;          // level = value * scale, if nonzero
+    std::vector<float> distinct;  // else the sorted distinct values
+    std::vector<float> values;    // the value of each level
+
+    int nlevels() const { return int(values.size()); }
+
+    uint16_t level(float v) const
+    {
+        if (scale != 0.0f)
+            return uint16_t(clamp(v * scale + 0.5f, 0.0f, scale));
+        size_t i = std::lower_bound(distinct.begin(), distinct.end(), v)
+                   - distinct.begin();
+        i        = std::min(i, distinct.size() - 1);
+        return uint16_t(i * values.size() / distinct.size());
+    }
+};
+
+
+
+static std::vector<RankLevels>
+rank_levels(const ImageBuf& src, ROI roi, int xoff, int yoff, int width,
+            int height)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        if (width < 1)
-            width = 1;
-        if (height < 1)
-            height = width;
-        int w_2        = std::max(1, width / 2);
-        int h_2        = std::max(1, height / 2);
-        int windowsize = width * height;
-        int nchannels  = R.nchannels();
-        float** chans  = OIIO_ALLOCA(float*, nchannels);
-        for (int c = 0; c < nchannels; ++c)
-            chans[c] = OIIO_ALLOCA(float, windowsize);
+    int nchans = roi.nchannels();
+    std::vector<RankLevels> levels(nchans);
+    TypeDesc::BASETYPE type = TypeDesc::BASETYPE(src.spec().format.basetype);
+    if (type == TypeDesc::UINT8 || type == TypeDesc::UINT16) {
+        int maxval = type == TypeDesc::UINT8 ? 255 : 65535;
+        for (auto& lev : levels) {
+            lev.scale = float(maxval);
+            lev.values.resize(maxval + 1);
+            for (int i = 0; i <= maxval; ++i)
+                lev.values[i] = float(i) / float(maxval);
+        }
+        return levels;
+    }
+    // Every value the clamped windows can see: only the pixels of roi and
+    // its window-sized margin, read a scanline at a time. Each channel's
+    // list is sorted and deduplicated whenever it has doubled, so it holds
+    // about as many values as there are distinct ones, not one per pixel.
+    ROI vroi(roi.xbegin + xoff, roi.xend + xoff + width - 1,
+             roi.ybegin + yoff, roi.yend + yoff + height - 1, roi.zbegin,
+             roi.zend, roi.chbegin, roi.chend);
+    vroi = roi_intersection(vroi, src.roi());
+    std::vector<std::vector<float>> chans(nchans);
+    std::vector<size_t> ndistinct(nchans, 0);
+    auto compact = [&](int c) {
+        std::vector<float>& chan(chans[c]);
+        std::sort(chan.begin(), chan.end());
+        chan.erase(std::unique(chan.begin(), chan.end()), chan.end());
+        ndistinct[c] = chan.size();
+    };
+    std::vector<float> row(size_t(std::max(vroi.width(), 0)) * nchans);
+    for (int z = vroi.zbegin; z < vroi.zend && !row.empty(); ++z) {
+        for (int y = vroi.ybegin; y < vroi.yend; ++y) {
+            ROI rroi(vroi.xbegin, vroi.xend, y, y + 1, z, z + 1, roi.chbegin,
+                     roi.chend);
+            src.get_pixels(rroi, TypeFloat, row.data());
+            for (int c = 0; c < nchans; ++c) {
+                std::vector<float>& chan(chans[c]);
+                for (size_t i = c; i < row.size(); i += nchans)
+                    if (!std::isnan(row[i]))
+                        chan.push_back(row[i]);
+                if (chan.size() >= 2 * ndistinct[c] + 65536)
+                    compact(c);
+            }
+        }
+    }
+    for (int c = 0; c < nchans; ++c) {
+        std::vector<float>& chan(chans[c]);
+        if (chan.empty())
+            chan.push_back(0.0f);
+        compact(c);
+        RankLevels& lev(levels[c]);
+        lev.distinct = std::move(chan);
+        const std::vector<float>& distinct(lev.distinct);
+        size_t n = distinct.size();
+        if (n <= 65536) {
+            lev.values = distinct;
+        } else {
+            // Each level stands for the middle of its bin of values
+            lev.values.resize(65536);
+            for (size_t l = 0; l < 65536; ++l)
+                lev.values[l] = distinct[((2 * l + 1) * n) / (2 * 65536)];
+        }
+    }
+    return levels;
+}
 
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        for (ImageBuf::Iterator<Rtype> r(R, roi); !r.done(); ++r) {
-            a.rerange(r.x() - w_2, r.x() - w_2 + width, r.y() - h_2,
-                      r.y() - h_2 + height, r.z(), r.z() + 1,
-                      ImageBuf::WrapClamp);
-            int n = 0;
-            for (; !a.done(); ++a) {
-                if (a.exists()) {
-                    for (int c = 0; c < nchannels; ++c)
-                        chans[c][n] = a[c];
-                    ++n;
-                }
+
+
+// The lowest level with more than `rank` of the counts at or below it.
+static int
+rank_find(const uint32_t* hist, int nbins, int rank)
+{
+    int b = 0;
+    for (uint32_t sum = 0; b < nbins - 1; ++b) {
+        sum += hist[b];
+        if (sum > uint32_t(rank))
+            break;
+    }
+    return b;
+}
+
+
+
+// Rank filter one channel of a tile of levels with the Perreault & Hebert
+// constant-time algorithm: a histogram for every column covering `height`
+// rows slides down one row at a time, and the window histogram slides
+// across them by adding one column histogram and subtracting another.
+// lv is (w + width - 1) x (h + height - 1); out is w x h.
+static void
+rank_tile_columns(const uint16_t* lv, int w, int h, int width, int height,
+                  int nbins, int rank, uint16_t* out)
+{
+    const int lw = w + width - 1;
+    std::vector<uint32_t> cols(size_t(lw) * nbins, 0), kern(nbins);
+    for (int v = 0; v < height; ++v)
+        for (int u = 0; u < lw; ++u)
+            ++cols[size_t(u) * nbins + lv[size_t(v) * lw + u]];
+    for (int y = 0; y < h; ++y) {
+        if (y > 0) {
+            const uint16_t* older = lv + size_t(y - 1) * lw;
+            const uint16_t* newer = lv + size_t(y - 1 + height) * lw;
+            for (int u = 0; u < lw; ++u) {
+                --cols[size_t(u) * nbins + older[u]];
+                ++cols[size_t(u) * nbins + newer[u]];
             }
-            if (n) {
-                int mid = n / 2;
-                for (int c = 0; c < nchannels; ++c) {
-                    std::sort(chans[c] + 0, chans[c] + n);
-                    r[c] = chans[c][mid];
-                }
-            } else {
-                for (int c = 0; c < nchannels; ++c)
-                    r[c] = 0.0f;
+        }
+        std::fill(kern.begin(), kern.end(), 0);
+        for (int u = 0; u < width; ++u) {
+            const uint32_t* col = cols.data() + size_t(u) * nbins;
+            for (int b = 0; b < nbins; ++b)
+                kern[b] += col[b];
+        }
+        for (int x = 0; x < w; ++x) {
+            if (x > 0) {
+                const uint32_t* add = &cols[size_t(x + width - 1) * nbins];
+                const uint32_t* sub = &cols[size_t(x - 1) * nbins];
+                for (int b = 0; b < nbins; ++b)
+                    kern[b] += add[b] - sub[b];
             }
+            out[size_t(y) * w + x] = uint16_t(rank_find(kern.data(), nbins,
+                                                        rank));
         }
-    });
+    }
+}
+
+
+
+// Rank filter one channel of a tile of levels, for many levels: a single
+// two-tier (coarse and fine) window histogram snakes across the tile, so
+// each step adds and removes one row or column of the window and the
+// search looks at no more than 256 coarse and 256 fine bins.
+static void
+rank_tile_snake(const uint16_t* lv, int w, int h, int width, int height,
+                int nbins, int rank, uint16_t* out)
+{
+    const int lw = w + width - 1;
+    std::vector<uint32_t> fine(size_t(nbins) + 256, 0);
+    std::vector<uint32_t> coarse((nbins + 255) / 256, 0);
+    auto add = [&](uint16_t l) {
+        ++fine[l];
+        ++coarse[l >> 8];
+    };
+    auto sub = [&](uint16_t l) {
+        --fine[l];
+        --coarse[l >> 8];
+    };
+    auto column = [&](int u, int y, bool adding) {
+        for (int v = y; v < y + height; ++v)
+            adding ? add(lv[size_t(v) * lw + u]) : sub(lv[size_t(v) * lw + u]);
+    };
+    for (int v = 0; v < height; ++v)
+        for (int u = 0; u < width; ++u)
+            add(lv[size_t(v) * lw + u]);
+    int x = 0;
+    for (int y = 0; y < h; ++y) {
+        if (y > 0) {
+            for (int u = x; u < x + width; ++u) {
+                sub(lv[size_t(y - 1) * lw + u]);
+                add(lv[size_t(y - 1 + height) * lw + u]);
+            }
+        }
+        bool rightward = (y & 1) == 0;
+        for (int i = 0; i < w; ++i) {
+            if (i > 0 && rightward) {
+                column(x, y, false);
+                column(x + width, y, true);
+                ++x;
+            } else if (i > 0) {
+                column(x + width - 1, y, false);
+                column(x - 1, y, true);
+                --x;
+            }
+            int cb = 0;
+            int r  = rank;
+            for (; cb < int(coarse.size()) - 1 && r >= int(coarse[cb]); ++cb)
+                r -= int(coarse[cb]);
+            out[size_t(y) * w + x] = uint16_t(
+                cb * 256 + rank_find(fine.data() + cb * 256, 256, r));
+        }
+    }
+}
+
+
+
+static bool
+rank_filter_impl(ImageBuf& dst, const ImageBuf& src, float rank, int width,
+                 int height, ROI roi, int nthreads)
+{
+    if (width < 1)
+        width = 1;
+    if (height < 1)
+        height = width;
+    const int xoff = -(width / 2), yoff = -(height / 2);
+    const int nchans = roi.nchannels();
+    const int n      = width * height;
+    const int target = clamp(int(floorf(rank * (n - 1) + 0.5f)), 0, n - 1);
+    std::vector<RankLevels> levels = rank_levels(src, roi, xoff, yoff, width,
+                                                 height);
+    dst.localpixels();
+    parallel_for_chunked_2D(
+        roi.xbegin, roi.xend, 256, roi.ybegin, roi.yend, 64,
+        [&](int64_t xb, int64_t xe, int64_t yb, int64_t ye) {
+            const int w = int(xe - xb), h = int(ye - yb);
+            const int lw = w + width - 1, lh = h + height - 1;
+            std::vector<float> in(size_t(lw) * nchans);
+            std::vector<float> out(size_t(w) * h * nchans);
+            std::vector<uint16_t> lv(size_t(lw) * lh * nchans);
+            std::vector<uint16_t> lout(size_t(w) * h);
+            // Planes of levels, one per channel
+            for (int v = 0; v < lh; ++v) {
+                convolve_fetch_row(src, roi, int(xb) + xoff,
+                                   int(xb) + xoff + lw, int(yb) + yoff + v,
+                                   in.data());
+                for (int c = 0; c < nchans; ++c) {
+                    uint16_t* l = lv.data() + (size_t(c) * lh + v) * lw;
+                    for (int u = 0; u < lw; ++u)
+                        l[u] = levels[c].level(in[size_t(u) * nchans + c]);
+                }
+            }
+            for (int c = 0; c < nchans; ++c) {
+                const uint16_t* l = lv.data() + size_t(c) * lh * lw;
+                int nlevels       = levels[c].nlevels();
+                if (nlevels <= 256)
+                    rank_tile_columns(l, w, h, width, height, nlevels, target,
+                                      lout.data());
+                else
+                    rank_tile_snake(l, w, h, width, height, nlevels, target,
+                                    lout.data());
+                for (size_t i = 0, e = lout.size(); i < e; ++i)
+                    out[i * nchans + c] = levels[c].values[lout[i]];
+            }
+            for (int v = 0; v < h; ++v)
+                convolve_store_row(dst, roi, int(xb), int(xe), int(yb) + v,
+                                   out.data() + size_t(v) * w * nchans);
+        },
+        paropt(nthreads));
     return true;
 }
 
 
 
+bool
+ImageBufAlgo::rank_filter(ImageBuf& dst, const ImageBuf& src, float rank,
+                          int width, int height, ROI roi, int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::rank_filter");
+    if (!IBAprep(roi, &dst, &src,
+                 IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
+        return false;
+    return rank_filter_impl(dst, src, rank, width, height, roi, nthreads);
+}
+
+
+
+ImageBuf
+ImageBufAlgo::rank_filter(const ImageBuf& src, float rank, int width,
+                          int height, ROI roi, int nthreads)
+{
+    ImageBuf result;
+    bool ok = rank_filter(result, src, rank, width, height, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::rank_filter() error");
+    return result;
+}
+
+
+
 bool
 ImageBufAlgo::median_filter(ImageBuf& dst, const ImageBuf& src, int width,
                             int height, ROI roi, int nthreads)
@@ -709,12 +1336,7 @@ ImageBufAlgo::median_filter(ImageBuf& dst, const ImageBuf& src, int width,
     if (!IBAprep(roi, &dst, &src,
                  IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
         return false;
-
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "median_filter", median_filter_impl,
-                                dst.spec().format, src.spec().format, dst, src,
-                                width, height, roi, nthreads);
-    return ok;
+    return rank_filter_impl(dst, src, 0.5f, width, height, roi, nthreads);
 }
 
 
@@ -734,55 +1356,104 @@ ImageBufAlgo::median_filter(const ImageBuf& src, int width, int height, ROI roi,
 
 enum MorphOp { MorphDilate, MorphErode };
 
-template<class Rtype, class Atype>
+// The van Herk / Gil-Werman running max (or min, per `op`) over windows
+// of k elements: out[i] = op(in[i], ..., in[i+k-1]) for i in [0,n), where
+// each element is m contiguous floats compared separately. Splitting the
+// input into blocks of k, a window always spans the tail of one block and
+// the head of the next, so prefix and suffix runs within the blocks give
+// every window in about three comparisons per float, whatever k is.
+// g and h are scratch space for (n + k - 1) * m floats each.
+template<class Op>
+static void
+morph_run(const float* in, float* out, int n, int k, int m, float* g,
+          float* h, Op op)
+{
+    const int len = n + k - 1;
+    for (int b = 0; b < len; b += k) {
+        int e = std::min(b + k, len);
+        std::copy_n(in + size_t(b) * m, m, g + size_t(b) * m);
+        for (int i = b + 1; i < e; ++i)
+            for (int j = 0; j < m; ++j)
+                g[size_t(i) * m + j] = op(g[size_t(i - 1) * m + j],
+                                          in[size_t(i) * m + j]);
+        std::copy_n(in + size_t(e - 1) * m, m, h + size_t(e - 1) * m);
+        for (int i = e - 2; i >= b; --i)
+            for (int j = 0; j < m; ++j)
+                h[size_t(i) * m + j] = op(h[size_t(i + 1) * m + j],
+                                          in[size_t(i) * m + j]);
+    }
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < m; ++j)
+            out[size_t(i) * m + j] = op(h[size_t(i) * m + j],
+                                        g[size_t(i + k - 1) * m + j]);
+}
+
+
+
+// A rectangular dilate or erode is separable: run it along each row of the
+// tile (plus the rows the window reaches above and below), then down the
+// columns, treating each whole row as one element of the vertical run.
+template<class Op>
 static bool
-morph_impl(ImageBuf& R, const ImageBuf& A, int width, int height, MorphOp op,
+morph_rect(ImageBuf& dst, const ImageBuf& src, int width, int height, Op op,
            ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        if (width < 1)
-            width = 1;
-        if (height < 1)
-            height = width;
-        int w_2       = std::max(1, width / 2);
-        int h_2       = std::max(1, height / 2);
-        int nchannels = R.nchannels();
-        float* vals   = OIIO_ALLOCA(float, nchannels);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        for (ImageBuf::Iterator<Rtype> r(R, roi); !r.done(); ++r) {
-            a.rerange(r.x() - w_2, r.x() - w_2 + width, r.y() - h_2,
-                      r.y() - h_2 + height, r.z(), r.z() + 1,
-                      ImageBuf::WrapClamp);
-            if (op == MorphDilate) {
-                for (int c = 0; c < nchannels; ++c)
-                    vals[c] = -std::numeric_limits<float>::max();
-                for (; !a.done(); ++a) {
-                    if (a.exists()) {
-                        for (int c = 0; c < nchannels; ++c)
-                            vals[c] = std::max(vals[c], a[c]);
-                    }
-                }
-            } else if (op == MorphErode) {
-                for (int c = 0; c < nchannels; ++c)
-                    vals[c] = std::numeric_limits<float>::max();
-                for (; !a.done(); ++a) {
-                    if (a.exists()) {
-                        for (int c = 0; c < nchannels; ++c)
-                            vals[c] = std::min(vals[c], a[c]);
-                    }
-                }
-            } else {
-                OIIO_ASSERT(0 && "Unknown morphological operator");
+    if (width < 1)
+        width = 1;
+    if (height < 1)
+        height = width;
+    const int xoff = -(width / 2), yoff = -(height / 2);
+    const int nchans = roi.nchannels();
+    dst.localpixels();
+    parallel_for_chunked_2D(
+        roi.xbegin, roi.xend, 512, roi.ybegin, roi.yend,
+        std::max(64, height),
+        [&](int64_t xb, int64_t xe, int64_t yb, int64_t ye) {
+            const int w = int(xe - xb), h = int(ye - yb);
+            const int lw = w + width - 1, lh = h + height - 1;
+            const int rowlen = w * nchans;
+            std::vector<float> in(size_t(lw) * nchans);
+            std::vector<float> rows(size_t(lh) * rowlen);
+            std::vector<float> out(size_t(h) * rowlen);
+            // Scratch for whichever pass runs longer: a short, wide tile
+            // with a wide kernel can need more for a row than for columns.
+            std::vector<float> g(std::max(size_t(lh) * rowlen,
+                                          size_t(lw) * nchans)),
+                hh(g.size());
+            for (int v = 0; v < lh; ++v) {
+                convolve_fetch_row(src, roi, int(xb) + xoff,
+                                   int(xb) + xoff + lw, int(yb) + yoff + v,
+                                   in.data());
+                morph_run(in.data(), rows.data() + size_t(v) * rowlen, w,
+                          width, nchans, g.data(), hh.data(), op);
             }
-            for (int c = 0; c < nchannels; ++c)
-                r[c] = vals[c];
-        }
-    });
+            morph_run(rows.data(), out.data(), h, height, rowlen, g.data(),
+                      hh.data(), op);
+            for (int v = 0; v < h; ++v)
+                convolve_store_row(dst, roi, int(xb), int(xe), int(yb) + v,
+                                   out.data() + size_t(v) * rowlen);
+        },
+        paropt(nthreads));
     return true;
 }
 
 
 
+static bool
+morph_impl(ImageBuf& dst, const ImageBuf& src, int width, int height,
+           MorphOp op, ROI roi, int nthreads)
+{
+    if (op == MorphDilate)
+        return morph_rect(
+            dst, src, width, height,
+            [](float a, float b) { return std::max(a, b); }, roi, nthreads);
+    return morph_rect(
+        dst, src, width, height,
+        [](float a, float b) { return std::min(a, b); }, roi, nthreads);
+}
+
+
+
 bool
 ImageBufAlgo::dilate(ImageBuf& dst, const ImageBuf& src, int width, int height,
                      ROI roi, int nthreads)
@@ -792,11 +1463,7 @@ ImageBufAlgo::dilate(ImageBuf& dst, const ImageBuf& src, int width, int height,
                  IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
         return false;
 
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "dilate", morph_impl, dst.spec().format,
-                                src.spec().format, dst, src, width, height,
-                                MorphDilate, roi, nthreads);
-    return ok;
+    return morph_impl(dst, src, width, height, MorphDilate, roi, nthreads);
 }
 
 
@@ -823,11 +1490,7 @@ ImageBufAlgo::erode(ImageBuf& dst, const ImageBuf& src, int width, int height,
                  IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
         return false;
 
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "erode", morph_impl, dst.spec().format,
-                                src.spec().format, dst, src, width, height,
-                                MorphErode, roi, nthreads);
-    return ok;
+    return morph_impl(dst, src, width, height, MorphErode, roi, nthreads);
 }
 
 
@@ -853,11 +1516,8 @@ hfft_(ImageBuf& dst, const ImageBuf& src, bool inverse, bool unitary, ROI roi,
     OIIO_ASSERT(dst.spec().format.basetype == TypeDesc::FLOAT
                 && src.spec().format.basetype == TypeDesc::FLOAT
                 && dst.spec().nchannels == 2 && src.spec().nchannels == 2
-                && dst.roi() == src.roi()
-                && (dst.storage() == ImageBuf::LOCALBUFFER
-                    || dst.storage() == ImageBuf::APPBUFFER)
-                && (src.storage() == ImageBuf::LOCALBUFFER
-                    || src.storage() == ImageBuf::APPBUFFER));
+                && dst.roi() == src.roi() && dst.localpixels()
+                && src.localpixels());
 
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
         int width     = roi.width();
@@ -984,9 +1644,18 @@ ImageBufAlgo::ifft(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
     spec.channelnames.emplace_back("real");
     spec.channelnames.emplace_back("imag");
 
+    // hfft_ needs src's pixels in memory, packed
+    const ImageBuf* in = &src;
+    ImageBuf packed;
+    if (!src.localpixels()
+        || src.pixel_stride() != stride_t(2 * sizeof(float))) {
+        packed.copy(src);
+        in = &packed;
+    }
+
     // Inverse FFT the rows (into temp buffer B).
     ImageBuf B(spec);
-    hfft_(B, src, true /*inverse*/, true /*unitary*/, get_roi(B.spec()),
+    hfft_(B, *in, true /*inverse*/, true /*unitary*/, get_roi(B.spec()),
           nthreads);
 
     // Transpose and shift back to A
@@ -1182,51 +1851,63 @@ ImageBufAlgo::fillholes_pushpull(ImageBuf& dst, const ImageBuf& src, ROI roi,
                      | IBAprep_NO_SUPPORT_VOLUME);
     if (!IBAprep(roi, &dst, &src, req))
         return false;
-    // We generate a bunch of temp images to form an image pyramid.
-    // These give us a place to stash them and make sure they are
-    // auto-deleted when the function exits.
-    std::vector<std::shared_ptr<ImageBuf>> pyramid;
-
     // First, make a writable copy of the original image (converting
     // to float as a convenience) as the top level of the pyramid.
     ImageSpec topspec = src.spec();
     topspec.set_format(TypeDesc::FLOAT);
-    ImageBuf* top = new ImageBuf(topspec);
-    paste(*top, topspec.x, topspec.y, topspec.z, 0, src);
-    pyramid.emplace_back(top);
+    std::vector<ImageBuf> pyramid;
+    pyramid.emplace_back(topspec);
+    paste(pyramid[0], topspec.x, topspec.y, topspec.z, 0, src, ROI(), nthreads);
+
+    // The smaller levels all live in one arena, allocated up front, and
+    // the pull phase reuses a single scratch buffer the size of the top.
+    const int nc = src.nchannels();
+    std::vector<ImageSpec> smallspecs;
+    imagesize_t arenasize = 0;
+    for (int w = topspec.width, h = topspec.height; w > 1 || h > 1;) {
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+        smallspecs.emplace_back(w, h, nc, TypeDesc::FLOAT);
+        smallspecs.back().alpha_channel = topspec.alpha_channel;
+        arenasize += imagesize_t(w) * h * nc;
+    }
+    std::unique_ptr<float[]> arena(new float[arenasize]);
+    std::unique_ptr<float[]> scratch(
+        new float[topspec.image_pixels() * imagesize_t(nc)]);
 
     // Construct the rest of the pyramid by successive x/2 resizing and
     // then dividing nonzero alpha pixels by their alpha (this "spreads
     // out" the defined part of the image).
-    int w = src.spec().width, h = src.spec().height;
-    while (w > 1 || h > 1) {
-        w = std::max(1, w / 2);
-        h = std::max(1, h / 2);
-        ImageSpec smallspec(w, h, src.nchannels(), TypeDesc::FLOAT);
-        smallspec.alpha_channel = topspec.alpha_channel;
-        ImageBuf* small         = new ImageBuf(smallspec);
-        ImageBufAlgo::resize(*small, *pyramid.back(), "triangle");
-        divide_by_alpha(*small, get_roi(smallspec), nthreads);
-        pyramid.emplace_back(small);
-        // small->write(Strutil::fmt::format("push{:04d}.exr", small->spec().width));
+    float* next = arena.get();
+    for (const ImageSpec& smallspec : smallspecs) {
+        pyramid.emplace_back(smallspec, next);
+        next += smallspec.image_pixels() * imagesize_t(nc);
+        ImageBuf& small(pyramid.back());
+        ImageBufAlgo::resize(small, pyramid[pyramid.size() - 2], "triangle",
+                             0.0f, ROI(), nthreads);
+        divide_by_alpha(small, get_roi(smallspec), nthreads);
     }
 
     // Now pull back up the pyramid by doing an alpha composite of level
     // i over a resized level i+1, thus filling in the alpha holes.  By
     // time we get to the top, pixels whose original alpha are
     // unchanged, those with alpha < 1 are replaced by the blended
-    // colors of the higher pyramid levels.
+    // colors of the higher pyramid levels. The last composite goes
+    // straight into dst rather than back into the top level.
     for (int i = (int)pyramid.size() - 2; i >= 0; --i) {
-        ImageBuf &big(*pyramid[i]), &small(*pyramid[i + 1]);
-        ImageBuf blowup(big.spec());
-        ImageBufAlgo::resize(blowup, small, "triangle");
-        ImageBufAlgo::over(big, big, blowup);
-        // big.write(Strutil::sprintf("pull{:04}.exr", big.spec().width));
+        ImageBuf &big(pyramid[i]), &small(pyramid[i + 1]);
+        ImageBuf blowup(big.spec(), scratch.get());
+        ImageBufAlgo::resize(blowup, small, "triangle", 0.0f, ROI(), nthreads);
+        if (i > 0)
+            ImageBufAlgo::over(big, big, blowup, ROI(), nthreads);
+        else
+            ImageBufAlgo::over(dst, big, blowup, roi, nthreads);
+    }
+    if (pyramid.size() == 1) {
+        // A single pixel image has nothing to fill from
+        paste(dst, src.spec().x, src.spec().y, src.spec().z, 0, pyramid[0],
+              ROI(), nthreads);
     }
-
-    // Now copy the completed base layer of the pyramid back to the
-    // original requested output.
-    paste(dst, src.spec().x, src.spec().y, src.spec().z, 0, *pyramid[0]);
 
     return true;
 }
@@ -1244,4 +1925,88 @@ ImageBufAlgo::fillholes_pushpull(const ImageBuf& src, ROI roi, int nthreads)
 }
 
 
+
+
+static std::atomic<ImageBufAlgo::ComputeBackend*> compute_backend_ptr(nullptr);
+
+
+ImageBufAlgo::ComputeBackend*
+ImageBufAlgo::set_compute_backend(ComputeBackend* backend)
+{
+    return compute_backend_ptr.exchange(backend);
+}
+
+
+
+ImageBufAlgo::ComputeBackend*
+ImageBufAlgo::compute_backend()
+{
+    return compute_backend_ptr.load(std::memory_order_acquire);
+}
+
+
+
+ImageBufAlgo::ComputeBackend::~ComputeBackend() {}
+
+// By default, a backend declines everything.
+
+bool
+ImageBufAlgo::ComputeBackend::resize(ImageBuf&, const ImageBuf&,
+                                     const Filter2D*, ROI, int)
+{
+    return false;
+}
+
+bool
+ImageBufAlgo::ComputeBackend::convolve(ImageBuf&, const ImageBuf&,
+                                       const ImageBuf&, bool, ROI, int)
+{
+    return false;
+}
+
+bool
+ImageBufAlgo::ComputeBackend::colorconvert(ImageBuf&, const ImageBuf&,
+                                           const ColorProcessor*, bool, ROI,
+                                           int)
+{
+    return false;
+}
+
+bool
+ImageBufAlgo::ComputeBackend::over(ImageBuf&, const ImageBuf&,
+                                   const ImageBuf&, ROI, int)
+{
+    return false;
+}
+
+bool
+ImageBufAlgo::ComputeBackend::add(ImageBuf&, const Image_or_Const&,
+                                  const Image_or_Const&, ROI, int)
+{
+    return false;
+}
+
+bool
+ImageBufAlgo::ComputeBackend::sub(ImageBuf&, const Image_or_Const&,
+                                  const Image_or_Const&, ROI, int)
+{
+    return false;
+}
+
+bool
+ImageBufAlgo::ComputeBackend::mul(ImageBuf&, const Image_or_Const&,
+                                  const Image_or_Const&, ROI, int)
+{
+    return false;
+}
+
+bool
+ImageBufAlgo::ComputeBackend::mad(ImageBuf&, const Image_or_Const&,
+                                  const Image_or_Const&, const Image_or_Const&,
+                                  ROI, int)
+{
+    return false;
+}
+
+
 OIIO_NAMESPACE_END
@@ -29,14 +29,8 @@ static bool
 add_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::Iterator<Rtype> r(R, roi);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        ImageBuf::ConstIterator<Btype> b(B, roi);
-        for (; !r.done(); ++r, ++a, ++b)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = a[c] + b[c];
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype, Btype>(
+        R, A, B, roi, nthreads, [](float a, float b) { return a + b; });
     return true;
 }
 
@@ -46,13 +40,8 @@ template<class Rtype, class Atype>
 static bool
 add_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::Iterator<Rtype> r(R, roi);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        for (; !r.done(); ++r, ++a)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = a[c] + b[c];
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype>(
+        R, A, b, roi, nthreads, [](float a, float b) { return a + b; });
     return true;
 }
 
@@ -93,12 +82,22 @@ ImageBufAlgo::add(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
         const ImageBuf &A(A_.img()), &B(B_.img());
         if (!IBAprep(roi, &dst, &A, &B))
             return false;
+        if (ComputeBackend* backend = compute_backend())
+            if (backend->add(dst, A_, B_, roi, nthreads))
+                return true;
         ROI origroi = roi;
         roi.chend = std::min(roi.chend, std::min(A.nchannels(), B.nchannels()));
-        bool ok;
-        OIIO_DISPATCH_COMMON_TYPES3(ok, "add", add_impl, dst.spec().format,
-                                    A.spec().format, B.spec().format, dst, A, B,
-                                    roi, nthreads);
+        // uint8 and uint16 images add their code values directly, skipping
+        // the round trip through float.
+        bool ok = native_value_op<uint8_t>(dst, A, B, roi, nthreads,
+                                           unorm_add<uint8_t>)
+                  || native_value_op<uint16_t>(dst, A, B, roi, nthreads,
+                                               unorm_add<uint16_t>);
+        if (!ok) {
+            OIIO_DISPATCH_COMMON_TYPES3(ok, "add", add_impl, dst.spec().format,
+                                        A.spec().format, B.spec().format, dst,
+                                        A, B, roi, nthreads);
+        }
         if (roi.chend < origroi.chend && A.nchannels() != B.nchannels()) {
             // Edge case: A and B differed in nchannels, we allocated dst to be
             // the bigger of them, but adjusted roi to be the lesser. Now handle
@@ -129,6 +128,9 @@ ImageBufAlgo::add(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
             dst.deepdata()->set_all_samples(A.deepdata()->all_samples());
             return add_impl_deep(dst, A, b, roi, nthreads);
         }
+        if (ComputeBackend* backend = compute_backend())
+            if (backend->add(dst, A_, b, roi, nthreads))
+                return true;
         bool ok;
         OIIO_DISPATCH_COMMON_TYPES2(ok, "add", add_impl, dst.spec().format,
                                     A.spec().format, dst, A, b, roi, nthreads);
@@ -158,14 +160,8 @@ static bool
 sub_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::Iterator<Rtype> r(R, roi);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        ImageBuf::ConstIterator<Btype> b(B, roi);
-        for (; !r.done(); ++r, ++a, ++b)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = a[c] - b[c];
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype, Btype>(
+        R, A, B, roi, nthreads, [](float a, float b) { return a - b; });
     return true;
 }
 
@@ -180,6 +176,9 @@ ImageBufAlgo::sub(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
         const ImageBuf &A(A_.img()), &B(B_.img());
         if (!IBAprep(roi, &dst, &A, &B))
             return false;
+        if (ComputeBackend* backend = compute_backend())
+            if (backend->sub(dst, A_, B_, roi, nthreads))
+                return true;
         ROI origroi = roi;
         roi.chend = std::min(roi.chend, std::min(A.nchannels(), B.nchannels()));
         bool ok;
@@ -211,6 +210,9 @@ ImageBufAlgo::sub(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
                      IBAprep_CLAMP_MUTUAL_NCHANNELS | IBAprep_SUPPORT_DEEP))
             return false;
         IBA_FIX_PERCHAN_LEN_DEF(b, A.nchannels());
+        if (ComputeBackend* backend = compute_backend())
+            if (backend->sub(dst, A_, b, roi, nthreads))
+                return true;
         // Negate b (into a copy)
         int nc      = A.nchannels();
         float* vals = OIIO_ALLOCA(float, nc);
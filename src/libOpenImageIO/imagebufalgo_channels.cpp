@@ -29,7 +29,7 @@ static bool
 channels_(ImageBuf& dst, const ImageBuf& src, cspan<int> channelorder,
           cspan<float> channelvalues, ROI roi, int nthreads = 0)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI roi) {
         int nchannels = src.nchannels();
         ImageBuf::ConstIterator<DSTTYPE> s(src, roi);
         ImageBuf::Iterator<DSTTYPE> d(dst, roi);
@@ -98,6 +98,27 @@ ImageBufAlgo::channels(ImageBuf& dst, const ImageBuf& src, int nchannels,
         return dst.copy(src);
     }
 
+    // A run of consecutive source channels, keeping their names, can be
+    // a zero-copy view of src's pixels, as long as src owns them (so that
+    // the view shares them copy-on-write) and dst is free to be replaced.
+    bool run = channelorder[0] >= 0 && !src.deep()
+               && dst.storage() != ImageBuf::APPBUFFER;
+    for (int c = 0; run && c < nchannels; ++c) {
+        int csrc = channelorder[0] + c;
+        run &= (channelorder[c] == csrc && csrc < src.spec().nchannels);
+        if (run && newchannelnames.size() > c && newchannelnames[c].size())
+            run &= (newchannelnames[c] == src.spec().channel_name(csrc));
+    }
+    if (run && src.localpixels()
+        && (src.storage() == ImageBuf::LOCALBUFFER
+            || src.storage() == ImageBuf::MMAPBUFFER)) {
+        ROI roi     = src.roi();
+        roi.chbegin = channelorder[0];
+        roi.chend   = channelorder[0] + nchannels;
+        dst         = src.view(roi);
+        return !dst.has_error();
+    }
+
     // Construct a new ImageSpec that describes the desired channel ordering.
     ImageSpec newspec = src.spec();
     newspec.nchannels = nchannels;
@@ -205,7 +226,7 @@ static bool
 channel_append_impl(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
                     ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, &B, [&](ROI roi) {
         int na = A.nchannels(), nb = B.nchannels();
         int n = std::min(dst.nchannels(), na + nb);
         ImageBuf::Iterator<Rtype> r(dst, roi);
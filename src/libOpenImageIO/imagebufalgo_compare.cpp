@@ -6,9 +6,13 @@
 /// Implementation of ImageBufAlgo algorithms that analyze or compare
 /// images.
 
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <vector>
 
 #include <OpenImageIO/half.h>
 
@@ -43,23 +47,6 @@ ImageBufAlgo::PixelStats::reset(int nchannels)
 
 
 
-void
-ImageBufAlgo::PixelStats::merge(const ImageBufAlgo::PixelStats& p)
-{
-    OIIO_DASSERT(min.size() == p.min.size());
-    for (size_t c = 0, e = min.size(); c < e; ++c) {
-        min[c] = std::min(min[c], p.min[c]);
-        max[c] = std::max(max[c], p.max[c]);
-        nancount[c] += p.nancount[c];
-        infcount[c] += p.infcount[c];
-        finitecount[c] += p.finitecount[c];
-        sum[c] += p.sum[c];
-        sum2[c] += p.sum2[c];
-    }
-}
-
-
-
 const ImageBufAlgo::PixelStats&
 ImageBufAlgo::PixelStats::operator=(PixelStats&& other)
 {
@@ -118,6 +105,35 @@ finalize(ImageBufAlgo::PixelStats& p)
 
 
 
+void
+ImageBufAlgo::PixelStats::merge(const ImageBufAlgo::PixelStats& p)
+{
+    if (min.empty())
+        reset(int(p.min.size()));
+    OIIO_DASSERT(min.size() == p.min.size());
+    for (size_t c = 0, e = min.size(); c < e; ++c) {
+        // Stats without finite values have no meaningful min and max (a
+        // finalized one holds zeros there), so don't let them contribute.
+        if (p.finitecount[c]) {
+            if (finitecount[c]) {
+                min[c] = std::min(min[c], p.min[c]);
+                max[c] = std::max(max[c], p.max[c]);
+            } else {
+                min[c] = p.min[c];
+                max[c] = p.max[c];
+            }
+        }
+        nancount[c] += p.nancount[c];
+        infcount[c] += p.infcount[c];
+        finitecount[c] += p.finitecount[c];
+        sum[c] += p.sum[c];
+        sum2[c] += p.sum2[c];
+    }
+    finalize(*this);
+}
+
+
+
 template<class T>
 static bool
 computePixelStats_(const ImageBuf& src, ImageBufAlgo::PixelStats& stats,
@@ -158,21 +174,59 @@ computePixelStats_(const ImageBuf& src, ImageBufAlgo::PixelStats& stats,
         }, opt);
 
     } else {  // Non-deep case
-        parallel_for_chunked(roi.ybegin, roi.yend, 64,
-                             [&](int64_t ybegin, int64_t yend) {
-            ROI subroi(roi.xbegin, roi.xend, ybegin, yend, roi.zbegin,
-                       roi.zend, roi.chbegin, roi.chend);
+        // Each task fetches its pixels a scanline at a time as float, and
+        // runs through them in blocks of 8 pixels, keeping accumulators
+        // for each value position of a block. That lines the accumulators
+        // up with the interleaved channels, so the loop vectorizes; they
+        // are folded into their channels at the end. Only scanlines that
+        // hold a NaN or Inf test their values one at a time.
+        ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI subroi) {
+            const int nc    = subroi.nchannels();
+            const int block = 8 * nc;
+            const float inf = std::numeric_limits<float>::infinity();
+            std::vector<float> line(size_t(subroi.width()) * nc);
+            std::vector<float> bmin(block, inf), bmax(block, -inf);
+            std::vector<double> bsum(block, 0.0), bsum2(block, 0.0);
+            imagesize_t blockpixels = 0;
             ImageBufAlgo::PixelStats tmp(nchannels);
-            for (ImageBuf::ConstIterator<T> s(src, subroi); !s.done();
-                 ++s) {
-                for (int c = subroi.chbegin; c < subroi.chend; ++c) {
-                    float value = s[c];
-                    val(tmp, c, value);
+            for (int z = subroi.zbegin; z < subroi.zend; ++z) {
+                for (int y = subroi.ybegin; y < subroi.yend; ++y) {
+                    ROI lineroi(subroi.xbegin, subroi.xend, y, y + 1, z,
+                                z + 1, subroi.chbegin, subroi.chend);
+                    src.get_pixels(lineroi, TypeFloat, line.data());
+                    const size_t n = line.size();
+                    bool finite    = true;
+                    for (size_t i = 0; i < n; ++i)
+                        finite &= std::isfinite(line[i]);
+                    size_t nblocked = finite ? n - n % block : 0;
+                    for (size_t b = 0; b < nblocked; b += block) {
+                        const float* v = &line[b];
+                        for (int j = 0; j < block; ++j) {
+                            bmin[j] = std::min(bmin[j], v[j]);
+                            bmax[j] = std::max(bmax[j], v[j]);
+                            bsum[j] += v[j];
+                            bsum2[j] += double(v[j]) * double(v[j]);
+                        }
+                    }
+                    blockpixels += nblocked / nc;
+                    for (size_t i = nblocked; i < n; ++i)
+                        val(tmp, subroi.chbegin + int(i % nc), line[i]);
                 }
             }
+            if (blockpixels) {
+                for (int j = 0; j < block; ++j) {
+                    int c       = subroi.chbegin + j % nc;
+                    tmp.min[c]  = std::min(tmp.min[c], bmin[j]);
+                    tmp.max[c]  = std::max(tmp.max[c], bmax[j]);
+                    tmp.sum[c] += bsum[j];
+                    tmp.sum2[c] += bsum2[j];
+                }
+                for (int c = subroi.chbegin; c < subroi.chend; ++c)
+                    tmp.finitecount[c] += blockpixels;
+            }
             std::lock_guard<OIIO::spin_mutex> lock(mutex);
             stats.merge(tmp);
-        }, opt);
+        });
     }
 
     // Compute final results
@@ -276,6 +330,7 @@ template<class Atype, class Btype>
 static bool
 compare_(const ImageBuf& A, const ImageBuf& B, float failthresh,
          float warnthresh, float failrelative, float warnrelative,
+         imagesize_t maxfailures, bool skip_identical,
          ImageBufAlgo::CompareResults& result, ROI roi, int /*nthreads*/)
 {
     imagesize_t npels = roi.npixels();
@@ -298,41 +353,83 @@ compare_(const ImageBuf& A, const ImageBuf& B, float failthresh,
     // either image. The compare_value() function we call on every pixel value
     // will check and adjust our max as needed.
 
-    ImageBuf::ConstIterator<Atype> a(A, roi, ImageBuf::WrapBlack);
-    ImageBuf::ConstIterator<Btype> b(B, roi, ImageBuf::WrapBlack);
     bool deep = A.deep();
-    // Break up into batches to reduce cancellation errors as the error
-    // sums become too much larger than the error for individual pixels.
-    const int batchsize = 4096;  // As good a guess as any
-    for (; !a.done();) {
-        double batcherror     = 0;
-        double batch_sqrerror = 0;
-        if (deep) {
-            for (int i = 0; i < batchsize && !a.done(); ++i, ++a, ++b) {
-                bool warned = false, failed = false;  // For this pixel
-                auto nsamps = std::max(a.deep_samples(), b.deep_samples());
-                for (int c = roi.chbegin; c < roi.chend; ++c)
-                    for (int s = 0, e = nsamps; s < e; ++s) {
-                        compare_value(a, c, a.deep_value(c, s),
-                                      b.deep_value(c, s), result, maxval,
-                                      batcherror, batch_sqrerror, failed,
-                                      warned, failthresh, warnthresh,
+    // Compare the pixels of one region, returning false if we hit the
+    // failure limit and should stop.
+    auto compare_region = [&](ROI region) -> bool {
+        ImageBuf::ConstIterator<Atype> a(A, region, ImageBuf::WrapBlack);
+        ImageBuf::ConstIterator<Btype> b(B, region, ImageBuf::WrapBlack);
+        // Break up into batches to reduce cancellation errors as the error
+        // sums become too much larger than the error for individual pixels.
+        const int batchsize = 4096;  // As good a guess as any
+        bool stop           = false;
+        for (; !a.done() && !stop;) {
+            double batcherror     = 0;
+            double batch_sqrerror = 0;
+            if (deep) {
+                for (int i = 0; i < batchsize && !a.done() && !stop;
+                     ++i, ++a, ++b) {
+                    bool warned = false, failed = false;  // For this pixel
+                    auto nsamps = std::max(a.deep_samples(), b.deep_samples());
+                    for (int c = roi.chbegin; c < roi.chend; ++c)
+                        for (int s = 0, e = nsamps; s < e; ++s) {
+                            compare_value(a, c, a.deep_value(c, s),
+                                          b.deep_value(c, s), result, maxval,
+                                          batcherror, batch_sqrerror, failed,
+                                          warned, failthresh, warnthresh,
+                                          failrelative, warnrelative);
+                        }
+                    stop = maxfailures && result.nfail >= maxfailures;
+                }
+            } else {  // non-deep
+                for (int i = 0; i < batchsize && !a.done() && !stop;
+                     ++i, ++a, ++b) {
+                    bool warned = false, failed = false;  // For this pixel
+                    for (int c = roi.chbegin; c < roi.chend; ++c)
+                        compare_value(a, c, c < Achannels ? a[c] : 0.0f,
+                                      c < Bchannels ? b[c] : 0.0f, result,
+                                      maxval, batcherror, batch_sqrerror,
+                                      failed, warned, failthresh, warnthresh,
                                       failrelative, warnrelative);
-                    }
+                    stop = maxfailures && result.nfail >= maxfailures;
+                }
             }
-        } else {  // non-deep
-            for (int i = 0; i < batchsize && !a.done(); ++i, ++a, ++b) {
-                bool warned = false, failed = false;  // For this pixel
-                for (int c = roi.chbegin; c < roi.chend; ++c)
-                    compare_value(a, c, c < Achannels ? a[c] : 0.0f,
-                                  c < Bchannels ? b[c] : 0.0f, result, maxval,
-                                  batcherror, batch_sqrerror, failed, warned,
-                                  failthresh, warnthresh, failrelative,
-                                  warnrelative);
+            totalerror += batcherror;
+            totalsqrerror += batch_sqrerror;
+        }
+        return !stop;
+    };
+
+    // Byte comparison needs both images to store the same native pixels.
+    const ImageSpec &Aspec(A.spec()), &Bspec(B.spec());
+    if (skip_identical && !deep && Aspec.format == Bspec.format
+        && Achannels == Bchannels && Aspec.channelformats.empty()
+        && Bspec.channelformats.empty()) {
+        // Fetch bands of scanlines in their native format and only do the
+        // float comparison on bands whose bytes differ. Identical bands add
+        // nothing to the error sums.
+        const int bandheight = 64;
+        size_t bandbytes     = size_t(roi.width()) * bandheight
+                           * roi.nchannels() * Aspec.format.size();
+        std::unique_ptr<char[]> abuf(new char[bandbytes]);
+        std::unique_ptr<char[]> bbuf(new char[bandbytes]);
+        bool more = true;
+        for (int z = roi.zbegin; z < roi.zend && more; ++z) {
+            for (int y = roi.ybegin; y < roi.yend && more; y += bandheight) {
+                ROI band(roi.xbegin, roi.xend, y,
+                         std::min(y + bandheight, roi.yend), z, z + 1,
+                         roi.chbegin, roi.chend);
+                size_t nbytes = size_t(band.npixels()) * roi.nchannels()
+                                * Aspec.format.size();
+                if (A.get_pixels(band, Aspec.format, abuf.get())
+                    && B.get_pixels(band, Bspec.format, bbuf.get())
+                    && !memcmp(abuf.get(), bbuf.get(), nbytes))
+                    continue;
+                more = compare_region(band);
             }
         }
-        totalerror += batcherror;
-        totalsqrerror += batch_sqrerror;
+    } else {
+        compare_region(roi);
     }
     result.meanerror = totalerror / nvals;
     result.rms_error = sqrt(totalsqrerror / nvals);
@@ -356,6 +453,18 @@ ImageBufAlgo::CompareResults
 ImageBufAlgo::compare(const ImageBuf& A, const ImageBuf& B, float failthresh,
                       float warnthresh, float failrelative, float warnrelative,
                       ROI roi, int nthreads)
+{
+    return compare(A, B, failthresh, warnthresh, failrelative, warnrelative,
+                   0, false, roi, nthreads);
+}
+
+
+
+ImageBufAlgo::CompareResults
+ImageBufAlgo::compare(const ImageBuf& A, const ImageBuf& B, float failthresh,
+                      float warnthresh, float failrelative, float warnrelative,
+                      imagesize_t maxfailures, bool skip_identical, ROI roi,
+                      int nthreads)
 {
     pvt::LoggedTimer logtimer("IBA::compare");
     ImageBufAlgo::CompareResults result;
@@ -377,7 +486,8 @@ ImageBufAlgo::compare(const ImageBuf& A, const ImageBuf& B, float failthresh,
     OIIO_DISPATCH_COMMON_TYPES2_CONST(ok, "compare", compare_, A.spec().format,
                                       B.spec().format, A, B, failthresh,
                                       warnthresh, failrelative, warnrelative,
-                                      result, roi, nthreads);
+                                      maxfailures, skip_identical, result, roi,
+                                      nthreads);
     // FIXME - The nthreads argument is for symmetry with the rest of
     // ImageBufAlgo and for future expansion. But for right now, we
     // don't actually split by threads.  Maybe later.
@@ -403,11 +513,10 @@ static bool
 isConstantColor_(const ImageBuf& src, float threshold, span<float> color,
                  ROI roi, int nthreads)
 {
-    // Single flag that will be set to false by any of the threads if they
-    // discover that the image is non-constant, so the others can abort early. It
-    // does NOT need to be atomic, because the timing is not critical and we
-    // don't want to slow things down by locking.
-    bool result = true;
+    // Single flag that will be cleared by any of the threads if they
+    // discover that the image is non-constant. Every thread checks it
+    // before each scanline, so they all stop soon after a mismatch.
+    std::atomic<bool> result(true);
 
     imagesize_t npixels = roi.npixels();
     if (npixels == 0) {
@@ -416,7 +525,7 @@ isConstantColor_(const ImageBuf& src, float threshold, span<float> color,
     }
 
     // Record the value of the first pixel. That's what we'll compare against.
-    std::vector<T> constval(roi.nchannels());
+    std::vector<T> constval(src.nchannels());
     ImageBuf::ConstIterator<T, T> s(src, roi);
     for (int c = roi.chbegin; c < roi.chend; ++c)
         constval[c] = s[c];
@@ -436,31 +545,71 @@ isConstantColor_(const ImageBuf& src, float threshold, span<float> color,
         // One pixel? Yes, it's a constant color! Skip the image scan.
     } else if (threshold == 0.0f) {
         // For 0.0 threshold, use shortcut of avoiding the conversion
-        // to float, just compare original type values.
-        ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-            if (!result)
-                return;  // another parallel bucket already failed, don't bother
-            for (ImageBuf::ConstIterator<T, T> s(src, roi); result && !s.done();
-                 ++s) {
-                for (int c = roi.chbegin; c < roi.chend; ++c)
-                    if (s[c] != constval[c]) {
-                        result = false;
-                        return;
+        // to float, just compare original type values. If the pixels are
+        // in memory and we're checking all their channels, compare each
+        // scanline's bytes against a row of the constant color at once.
+        const int nc  = src.nchannels();
+        bool rowbytes = src.localpixels() && roi.chbegin == 0
+                        && roi.chend == nc
+                        && src.pixel_stride()
+                               == stride_t(src.spec().pixel_bytes());
+        std::vector<T> constrow;
+        if (rowbytes) {
+            constrow.resize(size_t(roi.width()) * nc);
+            for (size_t i = 0; i < constrow.size(); ++i)
+                constrow[i] = constval[i % nc];
+        }
+        ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI roi) {
+            for (int z = roi.zbegin; z < roi.zend; ++z) {
+                for (int y = roi.ybegin; y < roi.yend; ++y) {
+                    if (!result)
+                        return;  // another bucket already failed
+                    if (rowbytes) {
+                        const T* row = (const T*)src.pixeladdr(roi.xbegin, y,
+                                                                z);
+                        size_t n     = size_t(roi.width()) * nc;
+                        if (!memcmp(row, constrow.data(), n * sizeof(T)))
+                            continue;
+                        // Different bits may still be equal values (e.g.,
+                        // 0.0 and -0.0), so check before giving up.
+                        for (size_t i = 0; i < n; ++i)
+                            if (row[i] != constrow[i]) {
+                                result = false;
+                                return;
+                            }
+                        continue;
                     }
+                    for (ImageBuf::ConstIterator<T, T> s(src, roi.xbegin,
+                                                         roi.xend, y, y + 1, z,
+                                                         z + 1);
+                         !s.done(); ++s) {
+                        for (int c = roi.chbegin; c < roi.chend; ++c)
+                            if (s[c] != constval[c]) {
+                                result = false;
+                                return;
+                            }
+                    }
+                }
             }
         });
     } else {
         // Nonzero threshold case
-        ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-            if (!result)
-                return;  // another parallel bucket already failed, don't bother
-            for (ImageBuf::ConstIterator<T> s(src, roi); result && !s.done();
-                 ++s) {
-                for (int c = roi.chbegin; c < roi.chend; ++c)
-                    if (std::abs(s[c] - constval[c]) > threshold) {
-                        result = false;
-                        return;
+        ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI roi) {
+            for (int z = roi.zbegin; z < roi.zend; ++z) {
+                for (int y = roi.ybegin; y < roi.yend; ++y) {
+                    if (!result)
+                        return;  // another bucket already failed
+                    for (ImageBuf::ConstIterator<T> s(src, roi.xbegin,
+                                                      roi.xend, y, y + 1, z,
+                                                      z + 1);
+                         !s.done(); ++s) {
+                        for (int c = roi.chbegin; c < roi.chend; ++c)
+                            if (std::abs(s[c] - constval[c]) > threshold) {
+                                result = false;
+                                return;
+                            }
                     }
+                }
             }
         });
     }
@@ -507,7 +656,7 @@ isConstantChannel_(const ImageBuf& src, int channel, float val, float threshold,
                    ROI roi, int nthreads)
 {
     atomic_int result(true);
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI roi) {
         if (!result)
             return;  // another parallel bucket already failed, don't bother
         if (threshold == 0.0f) {
@@ -564,30 +713,54 @@ isMonochrome_(const ImageBuf& src, float threshold, ROI roi, int nthreads)
     if (nchannels < 2)
         return true;
 
-    atomic_int result(true);
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        if (!result)
-            return;  // another parallel bucket already failed, don't bother
-        if (threshold == 0.0f) {
-            // For 0.0 threshold, use shortcut of avoiding the conversion
-            // to float, just compare original type values.
-            for (ImageBuf::ConstIterator<T, T> s(src, roi); !s.done(); ++s) {
-                T constvalue = s[roi.chbegin];
-                for (int c = roi.chbegin + 1; c < roi.chend; ++c)
-                    if (s[c] != constvalue) {
-                        result = false;
-                        return;
+    // Cleared by whichever thread first finds a non-gray pixel; the
+    // others check it before each scanline and bail out.
+    std::atomic<bool> result(true);
+    ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI roi) {
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                if (!result)
+                    return;  // another parallel bucket already failed
+                if (threshold == 0.0f && src.localpixels()) {
+                    // For 0.0 threshold, compare the original type values
+                    // straight from memory, no iterator or conversion.
+                    const char* p = (const char*)src.pixeladdr(roi.xbegin, y,
+                                                               z, roi.chbegin);
+                    stride_t xstride = src.pixel_stride();
+                    for (int x = roi.xbegin; x < roi.xend; ++x, p += xstride) {
+                        const T* pix = (const T*)p;
+                        for (int c = 1; c < roi.nchannels(); ++c)
+                            if (pix[c] != pix[0]) {
+                                result = false;
+                                return;
+                            }
                     }
-            }
-        } else {
-            // Nonzero threshold case
-            for (ImageBuf::ConstIterator<T> s(src, roi); !s.done(); ++s) {
-                float constvalue = s[roi.chbegin];
-                for (int c = roi.chbegin + 1; c < roi.chend; ++c)
-                    if (std::abs(s[c] - constvalue) > threshold) {
-                        result = false;
-                        return;
+                } else if (threshold == 0.0f) {
+                    for (ImageBuf::ConstIterator<T, T> s(src, roi.xbegin,
+                                                         roi.xend, y, y + 1, z,
+                                                         z + 1);
+                         !s.done(); ++s) {
+                        T constvalue = s[roi.chbegin];
+                        for (int c = roi.chbegin + 1; c < roi.chend; ++c)
+                            if (s[c] != constvalue) {
+                                result = false;
+                                return;
+                            }
+                    }
+                } else {
+                    // Nonzero threshold case
+                    for (ImageBuf::ConstIterator<T> s(src, roi.xbegin,
+                                                      roi.xend, y, y + 1, z,
+                                                      z + 1);
+                         !s.done(); ++s) {
+                        float constvalue = s[roi.chbegin];
+                        for (int c = roi.chbegin + 1; c < roi.chend; ++c)
+                            if (std::abs(s[c] - constvalue) > threshold) {
+                                result = false;
+                                return;
+                            }
                     }
+                }
             }
         }
     });
@@ -621,7 +794,7 @@ static bool
 color_count_(const ImageBuf& src, atomic_ll* count, int ncolors,
              const float* color, const float* eps, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI roi) {
         int nchannels = src.nchannels();
         long long* n  = OIIO_ALLOCA(long long, ncolors);
         for (int col = 0; col < ncolors; ++col)
@@ -683,7 +856,7 @@ color_range_check_(const ImageBuf& src, atomic_ll* lowcount,
                    atomic_ll* highcount, atomic_ll* inrangecount,
                    const float* low, const float* high, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [=, &src](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &src, [=, &src](ROI roi) {
         long long lc = 0, hc = 0, inrange = 0;
         for (ImageBuf::ConstIterator<T> p(src, roi); !p.done(); ++p) {
             bool lowval = false, highval = false;
@@ -841,8 +1014,13 @@ simplePixelHashSHA1(const ImageBuf& src, string_view extrainfo, ROI roi)
     if (!roi.defined())
         roi = get_roi(src.spec());
 
-    bool localpixels           = src.localpixels();
     imagesize_t scanline_bytes = roi.width() * src.spec().pixel_bytes();
+    // Hash straight from memory only if the roi's scanlines are stored
+    // back to back there.
+    bool packed = src.pixel_stride() == stride_t(src.spec().pixel_bytes())
+                  && (roi.height() == 1
+                      || src.scanline_stride() == stride_t(scanline_bytes));
+    bool localpixels = src.localpixels() && packed;
     OIIO_ASSERT(scanline_bytes < std::numeric_limits<unsigned int>::max());
     // Do it a few scanlines at a time
     int chunk = std::max(1, int(16 * 1024 * 1024 / scanline_bytes));
@@ -913,43 +1091,197 @@ ImageBufAlgo::computePixelHashSHA1(const ImageBuf& src, string_view extrainfo,
 
 
 
-template<class Atype>
+namespace {
+
+// Fixed number of scanlines per independently hashed block. This must not
+// depend on the thread count, or the hash would change with it.
+static const int xxhash_block_scanlines = 64;
+
+// XXH64 of the scanlines [ybegin,yend) of one z slice, chained one scanline
+// at a time so that the result doesn't depend on whether the pixels are
+// contiguous in memory.
+unsigned long long
+xxhashScanlines(const ImageBuf& src, ROI roi, int ybegin, int yend, int z,
+                std::vector<unsigned char>& tmp)
+{
+    unsigned long long h = 1771;
+    if (src.deep()) {
+        size_t samplesize = src.deepdata()->samplesize();
+        for (int y = ybegin; y < yend; ++y) {
+            for (int x = roi.xbegin; x < roi.xend; ++x) {
+                unsigned int n = src.deep_samples(x, y, z);
+                h              = xxhash::XXH64(&n, sizeof(n), h);
+                if (n)
+                    h = xxhash::XXH64(src.deep_pixel_ptr(x, y, z, 0, 0),
+                                      n * samplesize, h);
+            }
+        }
+        return h;
+    }
+
+    size_t scanline_bytes = size_t(roi.width()) * src.spec().pixel_bytes();
+    bool localpixels      = src.localpixels()
+                       && src.pixel_stride()
+                              == stride_t(src.spec().pixel_bytes());
+    if (!localpixels)
+        tmp.resize(scanline_bytes);
+    for (int y = ybegin; y < yend; ++y) {
+        const void* p = nullptr;
+        if (localpixels) {
+            p = src.pixeladdr(roi.xbegin, y, z);
+        } else {
+            src.get_pixels(ROI(roi.xbegin, roi.xend, y, y + 1, z, z + 1),
+                           src.spec().format, tmp.data());
+            p = tmp.data();
+        }
+        h = xxhash::XXH64(p, scanline_bytes, h);
+    }
+    return h;
+}
+
+}  // namespace
+
+
+
+std::string
+ImageBufAlgo::computePixelHash(const ImageBuf& src, string_view hashtype,
+                               string_view extrainfo, ROI roi, int nthreads)
+{
+    pvt::LoggedTimer logtimer("IBA::computePixelHash");
+    if (Strutil::iequals(hashtype, "sha1"))
+        return computePixelHashSHA1(src, extrainfo, roi, 0, nthreads);
+    if (!Strutil::iequals(hashtype, "xxhash")
+        && !Strutil::iequals(hashtype, "xxh64")) {
+        src.errorfmt("computePixelHash: unknown hash type \"{}\"", hashtype);
+        return std::string();
+    }
+    if (!roi.defined())
+        roi = get_roi(src.spec());
+
+    // Blocks are numbered slice by slice, then by scanline band within the
+    // slice, and the block hashes are combined in that order.
+    int bands   = (roi.height() + xxhash_block_scanlines - 1)
+                / xxhash_block_scanlines;
+    int nblocks = bands * roi.depth();
+    std::vector<unsigned long long> results(std::max(nblocks, 0));
+    parallel_for(
+        int64_t(0), int64_t(nblocks),
+        [&](int64_t b) {
+            std::vector<unsigned char> tmp;
+            int z      = roi.zbegin + int(b / bands);
+            int ybegin = roi.ybegin + int(b % bands) * xxhash_block_scanlines;
+            int yend   = std::min(ybegin + xxhash_block_scanlines, roi.yend);
+            results[b] = xxhashScanlines(src, roi, ybegin, yend, z, tmp);
+        },
+        paropt(nthreads));
+
+    unsigned long long h = xxhash::XXH64(results.data(),
+                                         results.size() * sizeof(results[0]));
+    h = xxhash::XXH64(extrainfo.data(), extrainfo.size(), h);
+    return Strutil::fmt::format("{:016x}", h);
+}
+
+
+
+// Bin index of a value, for `bins` bins evenly covering [min,max].
+inline int
+histogram_bin(float val, float min, float max, float ratio, int bins_minus_1)
+{
+    val = clamp(val, min, max);
+    return clamp(int((val - min) * ratio), 0, bins_minus_1);
+}
+
+
+
+// Add the pixels of one scanline, with `nc` interleaved channels, to the
+// histograms `h` of channels [hbegin,hend), `bins` entries per channel.
+template<typename T, typename BIN>
+inline void
+histogram_scanline(const T* p, int npixels, int nc, int hbegin, int hend,
+                   int bins, ROI roi, bool ignore_empty, imagesize_t* h,
+                   BIN&& bin)
+{
+    for (int x = 0; x < npixels; ++x, p += nc) {
+        if (ignore_empty) {
+            bool allblack = true;
+            for (int c = roi.chbegin; c < roi.chend; ++c)
+                allblack &= (p[c] == T(0));
+            if (allblack)
+                continue;
+        }
+        imagesize_t* hc = h;
+        for (int c = hbegin; c < hend; ++c, hc += bins)
+            hc[bin(p[c])] += 1;
+    }
+}
+
+
+
+// Histogram the channels [hbegin,hend) of src in one pass, into `hist`,
+// which holds `bins` entries for each of those channels. Pixels are
+// "empty" if they are zero in all of roi's channels.
 static bool
-histogram_impl(const ImageBuf& src, int channel, std::vector<imagesize_t>& hist,
-               int bins, float min, float max, bool ignore_empty, ROI roi,
-               int nthreads)
+histogram_impl(const ImageBuf& src, int hbegin, int hend,
+               std::vector<imagesize_t>& hist, int bins, float min, float max,
+               bool ignore_empty, ROI roi, int nthreads)
 {
-    // Double check A's type.
-    if (src.spec().format != BaseTypeFromC<Atype>::value) {
-        src.errorfmt("Unsupported pixel data format '{}'", src.spec().format);
-        return false;
+    const int nc         = src.nchannels();
+    const float ratio    = bins / (max - min);
+    const int binsminus1 = bins - 1;
+
+    // 8 and 16 bit unsigned pixels have few enough values that we find the
+    // bin for each one up front, and bin the pixels straight from their
+    // native representation. Everything else is binned as float.
+    TypeDesc fmt = src.spec().format;
+    std::vector<int> lut;
+    if (fmt == TypeUInt8) {
+        lut.resize(256);
+        for (int v = 0; v < 256; ++v)
+            lut[v] = histogram_bin(convert_type<uint8_t, float>(uint8_t(v)),
+                                   min, max, ratio, binsminus1);
+    } else if (fmt == TypeUInt16) {
+        lut.resize(65536);
+        for (int v = 0; v < 65536; ++v)
+            lut[v] = histogram_bin(convert_type<uint16_t, float>(uint16_t(v)),
+                                   min, max, ratio, binsminus1);
+    } else {
+        fmt = TypeFloat;
     }
 
-    std::mutex mutex;  // thread safety for the histogram result
+    auto floatbin = [&](float v) {
+        return histogram_bin(v, min, max, ratio, binsminus1);
+    };
 
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        float ratio      = bins / (max - min);
-        int bins_minus_1 = bins - 1;
-
-        // Compute histogram to thread-local h.
-        std::vector<imagesize_t> h(bins, 0);
-        for (ImageBuf::ConstIterator<Atype> a(src, roi); !a.done(); a++) {
-            if (ignore_empty) {
-                bool allblack = true;
-                for (int c = roi.chbegin; c < roi.chend; ++c)
-                    allblack &= (a[c] == 0.0f);
-                if (allblack)
-                    continue;
+    std::mutex mutex;  // thread safety for the histogram result
+    ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI r) {
+        // Compute histograms to thread-local h, merged at the end.
+        std::vector<imagesize_t> h(hist.size(), 0);
+        std::vector<char> line(size_t(r.width()) * nc * fmt.size());
+        for (int z = r.zbegin; z < r.zend; ++z) {
+            for (int y = r.ybegin; y < r.yend; ++y) {
+                src.get_pixels(ROI(r.xbegin, r.xend, y, y + 1, z, z + 1, 0,
+                                   nc),
+                               fmt, line.data());
+                if (fmt == TypeUInt8)
+                    histogram_scanline((const uint8_t*)line.data(), r.width(),
+                                       nc, hbegin, hend, bins, roi,
+                                       ignore_empty, h.data(),
+                                       [&](uint8_t v) { return lut[v]; });
+                else if (fmt == TypeUInt16)
+                    histogram_scanline((const uint16_t*)line.data(), r.width(),
+                                       nc, hbegin, hend, bins, roi,
+                                       ignore_empty, h.data(),
+                                       [&](uint16_t v) { return lut[v]; });
+                else
+                    histogram_scanline((const float*)line.data(), r.width(),
+                                       nc, hbegin, hend, bins, roi,
+                                       ignore_empty, h.data(), floatbin);
             }
-            float val = a[channel];
-            val       = clamp(val, min, max);
-            int i     = clamp(int((val - min) * ratio), 0, bins_minus_1);
-            h[i] += 1;
         }
 
         // Safely update the master histogram
         lock_guard lock(mutex);
-        for (int i = 0; i < bins; ++i)
+        for (size_t i = 0, e = hist.size(); i < e; ++i)
             hist[i] += h[i];
     });
     return true;
@@ -957,6 +1289,27 @@ histogram_impl(const ImageBuf& src, int channel, std::vector<imagesize_t>& hist,
 
 
 
+// Shared argument checks for the histogram functions.
+static bool
+histogram_args_ok(const ImageBuf& src, int bins, float min, float max)
+{
+    if (src.nchannels() == 0) {
+        src.errorfmt("Input image must have at least 1 channel");
+        return false;
+    }
+    if (bins < 1) {
+        src.errorfmt("The number of bins must be at least 1");
+        return false;
+    }
+    if (max <= min) {
+        src.errorfmt("Invalid range, min must be strictly smaller than max");
+        return false;
+    }
+    return true;
+}
+
+
+
 std::vector<imagesize_t>
 ImageBufAlgo::histogram(const ImageBuf& src, int channel, int bins, float min,
                         float max, bool ignore_empty, ROI roi, int nthreads)
@@ -965,41 +1318,54 @@ ImageBufAlgo::histogram(const ImageBuf& src, int channel, int bins, float min,
     std::vector<imagesize_t> h;
 
     // Sanity checks
-    if (src.nchannels() == 0) {
-        src.errorfmt("Input image must have at least 1 channel");
+    if (!histogram_args_ok(src, bins, min, max))
         return h;
-    }
     if (channel < 0 || channel >= src.nchannels()) {
         src.errorfmt("Invalid channel {} for input image with channels 0 to {}",
                      channel, src.nchannels() - 1);
         return h;
     }
-    if (bins < 1) {
-        src.errorfmt("The number of bins must be at least 1");
-        return h;
-    }
-    if (max <= min) {
-        src.errorfmt("Invalid range, min must be strictly smaller than max");
-        return h;
-    }
 
     // Specified ROI -> use it. Unspecified ROI -> initialize from src.
     if (!roi.defined())
         roi = get_roi(src.spec());
+    roi.chend = std::min(roi.chend, src.nchannels());
 
     h.resize(bins);
-    bool ok = true;
-    OIIO_DISPATCH_TYPES(ok, "histogram", histogram_impl, src.spec().format, src,
-                        channel, h, bins, min, max, ignore_empty, roi,
-                        nthreads);
-
-    if (!ok && src.has_error())
-        h.clear();
+    histogram_impl(src, channel, channel + 1, h, bins, min, max, ignore_empty,
+                   roi, nthreads);
     return h;
 }
 
 
 
+std::vector<std::vector<imagesize_t>>
+ImageBufAlgo::histograms(const ImageBuf& src, int bins, float min, float max,
+                         bool ignore_empty, ROI roi, int nthreads)
+{
+    pvt::LoggedTimer logtimer("IBA::histograms");
+    std::vector<std::vector<imagesize_t>> result;
+    if (!histogram_args_ok(src, bins, min, max))
+        return result;
+
+    // Specified ROI -> use it. Unspecified ROI -> initialize from src.
+    if (!roi.defined())
+        roi = get_roi(src.spec());
+    roi.chend = std::min(roi.chend, src.nchannels());
+
+    // Accumulate all the channels into one array, then split it up.
+    std::vector<imagesize_t> h(size_t(roi.nchannels()) * bins, 0);
+    histogram_impl(src, roi.chbegin, roi.chend, h, bins, min, max,
+                   ignore_empty, roi, nthreads);
+    result.resize(roi.nchannels());
+    for (int c = 0; c < roi.nchannels(); ++c)
+        result[c].assign(h.begin() + size_t(c) * bins,
+                         h.begin() + size_t(c + 1) * bins);
+    return result;
+}
+
+
+
 /// histogram_impl -----------------------------------------------------------
 /// Fully type-specialized version of histogram.
 ///
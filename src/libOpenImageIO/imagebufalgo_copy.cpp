@@ -28,7 +28,7 @@ paste_(ImageBuf& dst, const ImageBuf& src, ROI dstroi, ROI srcroi, int nthreads)
     int relative_z = dstroi.zbegin - srcroi.zbegin;
 
     using namespace ImageBufAlgo;
-    parallel_image(srcroi, nthreads, [&](ROI roi) {
+    parallel_image(srcroi, nthreads, &src, [&](ROI roi) {
         ROI droi(roi.xbegin + relative_x, roi.xend + relative_x,
                  roi.ybegin + relative_y, roi.yend + relative_y,
                  roi.zbegin + relative_z, roi.zend + relative_z, dstroi.chbegin,
@@ -123,6 +123,25 @@ ImageBufAlgo::paste(ImageBuf& dst, int xbegin, int ybegin, int zbegin,
     if (!IBAprep(dstroi, &dst))
         return false;
 
+    if (&dst != &src && src.localpixels() && dst.localpixels()
+        && src.roi().contains(srcroi) && dst.roi().contains(dstroi_save)) {
+        // Easy case -- both buffers are in memory and every pixel and
+        // channel being pasted exists in both, so this is just a copy
+        // between strided rectangles. parallel_convert_image threads it,
+        // and it's a memcpy per scanline when the pixel layouts match.
+        return parallel_convert_image(
+            srcroi.nchannels(), srcroi.width(), srcroi.height(),
+            srcroi.depth(),
+            src.pixeladdr(srcroi.xbegin, srcroi.ybegin, srcroi.zbegin,
+                          srcroi.chbegin),
+            src.spec().format, src.pixel_stride(), src.scanline_stride(),
+            src.z_stride(),
+            dst.pixeladdr(dstroi_save.xbegin, dstroi_save.ybegin,
+                          dstroi_save.zbegin, dstroi_save.chbegin),
+            dst.spec().format, dst.pixel_stride(), dst.scanline_stride(),
+            dst.z_stride(), nthreads);
+    }
+
     // do the actual copying
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "paste", paste_, dst.spec().format,
@@ -138,7 +157,7 @@ static bool
 copy_(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads = 1)
 {
     using namespace ImageBufAlgo;
-    parallel_image(roi, nthreads, [&](ROI roi) {
+    parallel_image(roi, nthreads, &src, [&](ROI roi) {
         ImageBuf::ConstIterator<S, D> s(src, roi);
         ImageBuf::Iterator<D, D> d(dst, roi);
         for (; !d.done(); ++d, ++s) {
@@ -256,6 +275,28 @@ ImageBufAlgo::crop(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
     pvt::LoggedTimer logtime("IBA::crop");
     dst.clear();
     roi.chend = std::min(roi.chend, src.nchannels());
+    if (roi.defined() && roi.chbegin == 0 && roi.chend == src.nchannels()
+        && !src.deep() && src.localpixels() && src.roi().contains(roi)
+        && (src.storage() == ImageBuf::LOCALBUFFER
+            || src.storage() == ImageBuf::MMAPBUFFER)) {
+        // All channels of a window of pixels that src owns: dst can just
+        // be a view, sharing them copy-on-write.
+        dst = src.view(roi);
+        if (dst.has_error())
+            return false;
+        // Match the spec that IBAprep would have given an allocated dst.
+        ImageSpec& spec(dst.specmod());
+        spec.tile_width  = 0;
+        spec.tile_height = 0;
+        spec.tile_depth  = 0;
+        spec.erase_attribute("oiio:SHA-1");
+        std::string desc = spec.get_string_attribute("ImageDescription");
+        if (desc.size()) {
+            Strutil::excise_string_after_head(desc, "oiio:SHA-1=");
+            spec.attribute("ImageDescription", desc);
+        }
+        return true;
+    }
     if (!IBAprep(roi, &dst, &src, IBAprep_SUPPORT_DEEP))
         return false;
 
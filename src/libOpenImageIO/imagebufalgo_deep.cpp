@@ -45,40 +45,72 @@ flatten_(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
         float& ARval(val[AR_channel]);
         float& AGval(val[AG_channel]);
         float& ABval(val[AB_channel]);
+        ROI srcroi = src.roi();
+        // All samples of one row of pixels, one contiguous array per
+        // channel, so the loop below doesn't look up every value.
+        std::vector<float> rowvals;
+
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                // Range of src pixels (and their deep pixel indices) that
+                // this row covers.
+                int xb = std::max(roi.xbegin, srcroi.xbegin);
+                int xe = std::min(roi.xend, srcroi.xend);
+                if (y < srcroi.ybegin || y >= srcroi.yend || z < srcroi.zbegin
+                    || z >= srcroi.zend)
+                    xe = xb;
+                int64_t pbegin = xb < xe ? src.pixelindex(xb, y, z) : 0;
+                int64_t pend   = pbegin + std::max(xe - xb, 0);
+                int64_t nsamps = dd->total_samples(pbegin, pend);
+                rowvals.resize(size_t(nsamps) * nc);
+                for (int c = 0; c < nc; ++c)
+                    dd->get_channel_values(
+                        c, span<float>(rowvals.data() + c * nsamps, nsamps),
+                        pbegin, pend);
+
+                int64_t first = 0;  // first sample of this pixel in rowvals
+                ROI rowroi(roi.xbegin, roi.xend, y, y + 1, z, z + 1);
+                for (ImageBuf::Iterator<DSTTYPE> r(dst, rowroi); !r.done();
+                     ++r) {
+                    int x     = r.x();
+                    int samps = (x >= xb && x < xe)
+                                    ? dd->samples(pbegin + x - xb)
+                                    : 0;
+                    // Clear accumulated values for this pixel (0 for colors,
+                    // big for Z)
+                    memset(val, 0, nc * sizeof(float));
+                    if (Z_channel >= 0 && samps == 0)
+                        val[Z_channel] = 1.0e30;
+                    if (Zback_channel >= 0 && samps == 0)
+                        val[Zback_channel] = 1.0e30;
+                    for (int s = 0; s < samps; ++s) {
+                        float AR = ARval, AG = AGval, AB = ABval;  // copies
+                        float alpha = (AR + AG + AB) / 3.0f;
+                        if (alpha >= 1.0f)
+                            break;
+                        const float* v = rowvals.data() + first + s;
+                        for (int c = 0; c < nc; ++c, v += nsamps) {
+                            // Z are not premultiplied
+                            if (c == Z_channel || c == Zback_channel)
+                                val[c] *= alpha;
+                            float a;
+                            if (c == R_channel)
+                                a = AR;
+                            else if (c == G_channel)
+                                a = AG;
+                            else if (c == B_channel)
+                                a = AB;
+                            else
+                                a = alpha;
+                            val[c] += (1.0f - a) * (*v);
+                        }
+                    }
+                    first += samps;
 
-        for (ImageBuf::Iterator<DSTTYPE> r(dst, roi); !r.done(); ++r) {
-            int x = r.x(), y = r.y(), z = r.z();
-            int samps = src.deep_samples(x, y, z);
-            // Clear accumulated values for this pixel (0 for colors, big for Z)
-            memset(val, 0, nc * sizeof(float));
-            if (Z_channel >= 0 && samps == 0)
-                val[Z_channel] = 1.0e30;
-            if (Zback_channel >= 0 && samps == 0)
-                val[Zback_channel] = 1.0e30;
-            for (int s = 0; s < samps; ++s) {
-                float AR = ARval, AG = AGval, AB = ABval;  // make copies
-                float alpha = (AR + AG + AB) / 3.0f;
-                if (alpha >= 1.0f)
-                    break;
-                for (int c = 0; c < nc; ++c) {
-                    float v = src.deep_value(x, y, z, c, s);
-                    if (c == Z_channel || c == Zback_channel)
-                        val[c] *= alpha;  // because Z are not premultiplied
-                    float a;
-                    if (c == R_channel)
-                        a = AR;
-                    else if (c == G_channel)
-                        a = AG;
-                    else if (c == B_channel)
-                        a = AB;
-                    else
-                        a = alpha;
-                    val[c] += (1.0f - a) * v;
+                    for (int c = roi.chbegin; c < roi.chend; ++c)
+                        r[c] = val[c];
                 }
             }
-
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = val[c];
         }
     });
     return true;
@@ -258,7 +290,9 @@ ImageBufAlgo::deep_merge(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
 
     // First, set the capacity of the dst image to reserve enough space for
     // the segments of both source images, including any splits that may
-    // occur.
+    // occur. Counting the splits is quadratic in the samples per pixel, so
+    // it's done in parallel into a temporary array, and only the (locking)
+    // set_capacity calls are serial.
     DeepData& dstdd(*dst.deepdata());
     const DeepData& Add(*A.deepdata());
     const DeepData& Bdd(*B.deepdata());
@@ -266,84 +300,79 @@ ImageBufAlgo::deep_merge(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
     int Azbackchan = Add.Zback_channel();
     int Bzchan     = Bdd.Z_channel();
     int Bzbackchan = Bdd.Zback_channel();
+    std::vector<int> capacity(roi.npixels());
+    auto capindex = [&](int x, int y, int z) {
+        return ((imagesize_t(z - roi.zbegin) * roi.height()
+                 + imagesize_t(y - roi.ybegin))
+                    * roi.width()
+                + imagesize_t(x - roi.xbegin));
+    };
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI r) {
+        std::vector<float> zs;
+        for (int z = r.zbegin; z < r.zend; ++z)
+            for (int y = r.ybegin; y < r.yend; ++y)
+                for (int x = r.xbegin; x < r.xend; ++x) {
+                    int Apixel = A.pixelindex(x, y, z, true);
+                    int Bpixel = B.pixelindex(x, y, z, true);
+                    int Asamps = Add.samples(Apixel);
+                    int Bsamps = Bdd.samples(Bpixel);
+                    // Gather the depth ranges of all the samples of both
+                    // pixels, A's first.
+                    int n = Asamps + Bsamps;
+                    zs.resize(2 * size_t(n));
+                    float *zf = zs.data(), *zb = zs.data() + n;
+                    Add.get_channel_values(Azchan, span<float>(zf, Asamps),
+                                           Apixel, Apixel + 1);
+                    Add.get_channel_values(Azbackchan,
+                                           span<float>(zb, Asamps), Apixel,
+                                           Apixel + 1);
+                    Bdd.get_channel_values(Bzchan,
+                                           span<float>(zf + Asamps, Bsamps),
+                                           Bpixel, Bpixel + 1);
+                    Bdd.get_channel_values(Bzbackchan,
+                                           span<float>(zb + Asamps, Bsamps),
+                                           Bpixel, Bpixel + 1);
+                    // Every sample endpoint that lies strictly inside
+                    // another sample may split it. Counting over all pairs
+                    // covers A vs B as well as A vs A and B vs B (in case
+                    // samples of one image overlap each other).
+                    int nsplits = 0;
+                    for (int i = 0; i < n; ++i)
+                        for (int j = i + 1; j < n; ++j) {
+                            nsplits += (zf[j] > zf[i] && zf[j] < zb[i]);
+                            nsplits += (zb[j] > zf[i] && zb[j] < zb[i]);
+                            nsplits += (zf[i] > zf[j] && zf[i] < zb[j]);
+                            nsplits += (zb[i] > zf[j] && zb[i] < zb[j]);
+                        }
+                    capacity[capindex(x, y, z)] = n + nsplits;
+                }
+    });
     for (int z = roi.zbegin; z < roi.zend; ++z)
         for (int y = roi.ybegin; y < roi.yend; ++y)
-            for (int x = roi.xbegin; x < roi.xend; ++x) {
-                int dstpixel            = dst.pixelindex(x, y, z, true);
-                int Apixel              = A.pixelindex(x, y, z, true);
-                int Bpixel              = B.pixelindex(x, y, z, true);
-                int Asamps              = Add.samples(Apixel);
-                int Bsamps              = Bdd.samples(Bpixel);
-                int nsplits             = 0;
-                int self_overlap_splits = 0;
-                for (int s = 0; s < Asamps; ++s) {
-                    float src_z     = Add.deep_value(Apixel, Azchan, s);
-                    float src_zback = Add.deep_value(Apixel, Azbackchan, s);
-                    for (int d = 0; d < Bsamps; ++d) {
-                        float dst_z     = Bdd.deep_value(Bpixel, Bzchan, d);
-                        float dst_zback = Bdd.deep_value(Bpixel, Bzbackchan, d);
-                        if (src_z > dst_z && src_z < dst_zback)
-                            ++nsplits;
-                        if (src_zback > dst_z && src_zback < dst_zback)
-                            ++nsplits;
-                        if (dst_z > src_z && dst_z < src_zback)
-                            ++nsplits;
-                        if (dst_zback > src_z && dst_zback < src_zback)
-                            ++nsplits;
-                    }
-                    // Check for splits src vs src -- in case they overlap!
-                    for (int ss = s; ss < Asamps; ++ss) {
-                        float src_z2     = Add.deep_value(Apixel, Azchan, ss);
-                        float src_zback2 = Add.deep_value(Apixel, Azbackchan,
-                                                          ss);
-                        if (src_z2 > src_z && src_z2 < src_zback)
-                            ++self_overlap_splits;
-                        if (src_zback2 > src_z && src_zback2 < src_zback)
-                            ++self_overlap_splits;
-                        if (src_z > src_z2 && src_z < src_zback2)
-                            ++self_overlap_splits;
-                        if (src_zback > src_z2 && src_zback < src_zback2)
-                            ++self_overlap_splits;
-                    }
-                }
-                // Check for splits dst vs dst -- in case they overlap!
-                for (int d = 0; d < Bsamps; ++d) {
-                    float dst_z     = Bdd.deep_value(Bpixel, Bzchan, d);
-                    float dst_zback = Bdd.deep_value(Bpixel, Bzbackchan, d);
-                    for (int dd = d; dd < Bsamps; ++dd) {
-                        float dst_z2     = Bdd.deep_value(Bpixel, Bzchan, dd);
-                        float dst_zback2 = Bdd.deep_value(Bpixel, Bzbackchan,
-                                                          dd);
-                        if (dst_z2 > dst_z && dst_z2 < dst_zback)
-                            ++self_overlap_splits;
-                        if (dst_zback2 > dst_z && dst_zback2 < dst_zback)
-                            ++self_overlap_splits;
-                        if (dst_z > dst_z2 && dst_z < dst_zback2)
-                            ++self_overlap_splits;
-                        if (dst_zback > dst_z2 && dst_zback < dst_zback2)
-                            ++self_overlap_splits;
-                    }
-                }
-
-                dstdd.set_capacity(dstpixel, Asamps + Bsamps + nsplits
-                                                 + self_overlap_splits);
-            }
+            for (int x = roi.xbegin; x < roi.xend; ++x)
+                dstdd.set_capacity(dst.pixelindex(x, y, z, true),
+                                   capacity[capindex(x, y, z)]);
 
     bool ok = ImageBufAlgo::copy(dst, A, TypeDesc::UNKNOWN, roi, nthreads);
 
-    for (int z = roi.zbegin; z < roi.zend; ++z)
-        for (int y = roi.ybegin; y < roi.yend; ++y)
-            for (int x = roi.xbegin; x < roi.xend; ++x) {
-                int dstpixel = dst.pixelindex(x, y, z, true);
-                int Bpixel   = B.pixelindex(x, y, z, true);
-                OIIO_DASSERT(dstpixel >= 0);
-                // OIIO_UNUSED_OK int oldcap = dstdd.capacity (dstpixel);
-                dstdd.merge_deep_pixels(dstpixel, Bdd, Bpixel);
-                // OIIO_DASSERT (oldcap == dstdd.capacity(dstpixel) &&
-                //          "Broken: we did not preallocate enough capacity");
-                if (occlusion_cull)
-                    dstdd.occlusion_cull(dstpixel);
-            }
+    // With enough capacity reserved for every pixel, merging never has to
+    // reallocate the shared sample storage, so the pixels are independent
+    // and can be merged in parallel.
+    dstdd.all_data();  // make sure the storage is allocated up front
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI r) {
+        for (int z = r.zbegin; z < r.zend; ++z)
+            for (int y = r.ybegin; y < r.yend; ++y)
+                for (int x = r.xbegin; x < r.xend; ++x) {
+                    int dstpixel = dst.pixelindex(x, y, z, true);
+                    int Bpixel   = B.pixelindex(x, y, z, true);
+                    OIIO_DASSERT(dstpixel >= 0);
+                    OIIO_DASSERT(capacity[capindex(x, y, z)]
+                                 <= dstdd.capacity(dstpixel));
+                    dstdd.merge_deep_pixels(dstpixel, Bdd, Bpixel);
+                    if (occlusion_cull)
+                        dstdd.occlusion_cull(dstpixel);
+                }
+    });
     return ok;
 }
 
@@ -364,7 +393,7 @@ ImageBufAlgo::deep_merge(const ImageBuf& A, const ImageBuf& B,
 
 bool
 ImageBufAlgo::deep_holdout(ImageBuf& dst, const ImageBuf& src,
-                           const ImageBuf& thresh, ROI roi, int /*nthreads*/)
+                           const ImageBuf& thresh, ROI roi, int nthreads)
 {
     pvt::LoggedTimer logtime("IBA::deep_holdout");
     if (!src.deep() || !thresh.deep()) {
@@ -380,53 +409,95 @@ ImageBufAlgo::deep_holdout(ImageBuf& dst, const ImageBuf& src,
 
     DeepData& dstdd(*dst.deepdata());
     const DeepData& srcdd(*src.deepdata());
-    // First, reserve enough space in dst, to reduce the number of
-    // allocations we'll do later.
+    const DeepData& threshdd(*thresh.deepdata());
+    int Zchan     = dstdd.Z_channel();
+    int Zbackchan = dstdd.Zback_channel();
+
+    // First, reserve enough space in dst for the src samples plus one more
+    // for each sample that straddles the threshold depth (and so will be
+    // split). Then no pixel ever needs to reallocate the shared storage,
+    // and the pixels can be computed in parallel.
+    std::vector<float> zthresh(roi.npixels());
+    std::vector<int> capacity(roi.npixels());
+    auto index = [&](int x, int y, int z) {
+        return ((imagesize_t(z - roi.zbegin) * roi.height()
+                 + imagesize_t(y - roi.ybegin))
+                    * roi.width()
+                + imagesize_t(x - roi.xbegin));
+    };
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI r) {
+        std::vector<float> zs;
+        for (int z = r.zbegin; z < r.zend; ++z)
+            for (int y = r.ybegin; y < r.yend; ++y)
+                for (int x = r.xbegin; x < r.xend; ++x) {
+                    int srcpixel = src.pixelindex(x, y, z, true);
+                    int threshpixel = thresh.pixelindex(x, y, z, true);
+                    float zt        = threshdd.opaque_z(threshpixel);
+                    int n           = srcdd.samples(srcpixel);
+                    zs.resize(2 * size_t(n));
+                    srcdd.get_channel_values(Zchan, span<float>(zs.data(), n),
+                                             srcpixel, srcpixel + 1);
+                    srcdd.get_channel_values(Zbackchan,
+                                             span<float>(zs.data() + n, n),
+                                             srcpixel, srcpixel + 1);
+                    int nsplits = 0;
+                    for (int s = 0; s < n; ++s)
+                        nsplits += (zs[s] < zt && zs[n + s] > zt);
+                    zthresh[index(x, y, z)]  = zt;
+                    capacity[index(x, y, z)] = std::max(srcdd.capacity(srcpixel),
+                                                        n + nsplits);
+                }
+    });
     for (int z = roi.zbegin; z < roi.zend; ++z)
         for (int y = roi.ybegin; y < roi.yend; ++y)
             for (int x = roi.xbegin; x < roi.xend; ++x) {
                 int dstpixel = dst.pixelindex(x, y, z, true);
                 int srcpixel = src.pixelindex(x, y, z, true);
                 if (dstpixel >= 0 && srcpixel >= 0)
-                    dstdd.set_capacity(dstpixel, srcdd.capacity(srcpixel));
+                    dstdd.set_capacity(dstpixel, capacity[index(x, y, z)]);
             }
+    dstdd.all_data();  // make sure the storage is allocated up front
+
     // Now we compute each pixel: We copy the src pixel to dst, then split
     // any samples that span the opaque threshold, and then delete any
     // samples that lie beyond the threshold.
-    int Zchan     = dstdd.Z_channel();
-    int Zbackchan = dstdd.Zback_channel();
-    const DeepData& threshdd(*thresh.deepdata());
-    for (ImageBuf::Iterator<float> r(dst, roi); !r.done(); ++r) {
-        int x = r.x(), y = r.y(), z = r.z();
-        int srcpixel = src.pixelindex(x, y, z, true);
-        if (srcpixel < 0)
-            continue;  // Nothing in this pixel
-        int dstpixel = dst.pixelindex(x, y, z, true);
-        dstdd.copy_deep_pixel(dstpixel, srcdd, srcpixel);
-        int threshpixel = thresh.pixelindex(x, y, z, true);
-        if (threshpixel < 0)
-            continue;  // No threshold mask for this pixel
-        float zthresh = threshdd.opaque_z(threshpixel);
-        // Eliminate the samples that are entirely beyond the depth
-        // threshold. Do this before the split; that makes it less
-        // likely that the split will force a re-allocation.
-        for (int s = 0, n = dstdd.samples(dstpixel); s < n; ++s) {
-            if (dstdd.deep_value(dstpixel, Zchan, s) > zthresh) {
-                dstdd.set_samples(dstpixel, s);
-                break;
-            }
-        }
-        // Now split any samples that straddle the z.
-        if (dstdd.split(dstpixel, zthresh)) {
-            // If a split did occur, do another discard pass.
-            for (int s = 0, n = dstdd.samples(dstpixel); s < n; ++s) {
-                if (dstdd.deep_value(dstpixel, Zbackchan, s) > zthresh) {
-                    dstdd.set_samples(dstpixel, s);
-                    break;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI r) {
+        for (int z = r.zbegin; z < r.zend; ++z)
+            for (int y = r.ybegin; y < r.yend; ++y)
+                for (int x = r.xbegin; x < r.xend; ++x) {
+                    int srcpixel = src.pixelindex(x, y, z, true);
+                    if (srcpixel < 0)
+                        continue;  // Nothing in this pixel
+                    int dstpixel = dst.pixelindex(x, y, z, true);
+                    dstdd.copy_deep_pixel(dstpixel, srcdd, srcpixel);
+                    int threshpixel = thresh.pixelindex(x, y, z, true);
+                    if (threshpixel < 0)
+                        continue;  // No threshold mask for this pixel
+                    float zt = zthresh[index(x, y, z)];
+                    // Eliminate the samples that are entirely beyond the
+                    // depth threshold. Do this before the split; that
+                    // makes it less likely that the split will force a
+                    // re-allocation.
+                    for (int s = 0, n = dstdd.samples(dstpixel); s < n; ++s) {
+                        if (dstdd.deep_value(dstpixel, Zchan, s) > zt) {
+                            dstdd.set_samples(dstpixel, s);
+                            break;
+                        }
+                    }
+                    // Now split any samples that straddle the z.
+                    if (dstdd.split(dstpixel, zt)) {
+                        // If a split did occur, do another discard pass.
+                        for (int s = 0, n = dstdd.samples(dstpixel); s < n;
+                             ++s) {
+                            if (dstdd.deep_value(dstpixel, Zbackchan, s)
+                                > zt) {
+                                dstdd.set_samples(dstpixel, s);
+                                break;
+                            }
+                        }
+                    }
                 }
-            }
-        }
-    }
+    });
     return true;
 }
 
@@ -4,8 +4,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <limits>
 #include <set>
+#include <tuple>
 #include <unordered_map>
 
 #include <OpenImageIO/half.h>
@@ -17,6 +19,7 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/simd.h>
 #include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/thread.h>
 
@@ -566,22 +569,128 @@ hashnormal(int x, int y, int z, int c, int seed)
 
 
 
-template<typename T>
-static bool
-noise_uniform_(ImageBuf& dst, float min, float max, bool mono, int seed,
-               ROI roi, int nthreads)
+// SIMD version of bjhash::bjfinal, hashing 8 sets of values at once.
+OIIO_FORCEINLINE simd::vint8
+bjfinal8(simd::vint8 a, simd::vint8 b, simd::vint8 c)
+{
+    using simd::rotl;
+    c ^= b;
+    c -= rotl(b, 14);
+    a ^= c;
+    a -= rotl(c, 11);
+    b ^= a;
+    b -= rotl(a, 25);
+    c ^= b;
+    c -= rotl(b, 16);
+    a ^= c;
+    a -= rotl(c, 4);
+    b ^= a;
+    b -= rotl(a, 14);
+    c ^= b;
+    c -= rotl(b, 24);
+    return c;
+}
+
+
+// SIMD version of hashrand, yielding exactly the same values for 8 pixels
+// at once.
+OIIO_FORCEINLINE simd::vfloat8
+hashrand8(const simd::vint8& x, int y, int z, int c, const simd::vint8& seed)
+{
+    const int magic = 0xfffff;
+    simd::vint8 h   = bjfinal8(bjfinal8(x, simd::vint8(y), simd::vint8(z)),
+                               simd::vint8(c), seed)
+                    & simd::vint8(magic);
+    return simd::vfloat8(h) * (1.0f / (magic + 1));
+}
+
+
+// Fill vals[0..n) with hashrand(xbegin+i, y, z, c, seed).
+static void
+hashrand_span(float* vals, int xbegin, int n, int y, int z, int c, int seed)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        hashrand8(simd::vint8::Iota(xbegin + i), y, z, c, simd::vint8(seed))
+            .store(vals + i);
+    for (; i < n; ++i)
+        vals[i] = hashrand(xbegin + i, y, z, c, seed);
+}
+
+
+// Fill vals[0..n) with hashnormal(xbegin+i, y, z, c, seed). The polar
+// method rejection loop runs in lockstep, each lane bumping its own seed
+// just as the scalar version does, so the results are identical.
+static void
+hashnormal_span(float* vals, int xbegin, int n, int y, int z, int c, int seed)
+{
+    using namespace simd;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        vint8 x = vint8::Iota(xbegin + i);
+        vint8 s(seed);
+        vfloat8 xr = vfloat8::Zero(), yr = vfloat8::Zero(), r2;
+        vbool8 todo = vbool8::True();
+        do {
+            xr   = select(todo, 2.0f * hashrand8(x, y, z, c, s) - 1.0f, xr);
+            yr   = select(todo, 2.0f * hashrand8(x, y, z, c, s + 139) - 1.0f,
+                          yr);
+            r2   = xr * xr + yr * yr;
+            todo = (r2 > 1.0f) | (r2 == 0.0f);
+            s    = select(todo, s + 1, s);
+        } while (any(todo));
+        for (int k = 0; k < 8; ++k) {
+            float M     = sqrt(-2.0 * log(r2[k]) / r2[k]);
+            vals[i + k] = xr[k] * M;
+        }
+    }
+    for (; i < n; ++i)
+        vals[i] = hashnormal(xbegin + i, y, z, c, seed);
+}
+
+
+
+// Shared driver for the hash-based noise types: for each scanline, fill
+// a channel-major buffer with one span of hashed values per channel
+// (just the first if mono), then let apply(pixel, c, value) use them.
+template<typename T, typename GEN, typename APPLY>
+static void
+noise_by_scanline(ImageBuf& dst, bool mono, int seed, ROI roi, int nthreads,
+                  GEN gen, APPLY apply)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        for (ImageBuf::Iterator<T> p(dst, roi); !p.done(); ++p) {
-            int x = p.x(), y = p.y(), z = p.z();
-            float n = 0.0;
-            for (int c = roi.chbegin; c < roi.chend; ++c) {
-                if (c == roi.chbegin || !mono)
-                    n = lerp(min, max, hashrand(x, y, z, c, seed));
-                p[c] = p[c] + n;
+        int nx = roi.width();
+        int nc = mono ? 1 : roi.nchannels();
+        std::vector<float> vals(size_t(nx) * size_t(nc));
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                for (int c = 0; c < nc; ++c)
+                    gen(&vals[size_t(c) * nx], roi.xbegin, nx, y, z,
+                        roi.chbegin + c, seed);
+                ImageBuf::Iterator<T> p(dst, roi.xbegin, roi.xend, y, y + 1,
+                                        z, z + 1);
+                for (int i = 0; !p.done(); ++p, ++i) {
+                    for (int c = roi.chbegin; c < roi.chend; ++c) {
+                        int vc = mono ? 0 : c - roi.chbegin;
+                        apply(p, c, vals[size_t(vc) * nx + i]);
+                    }
+                }
             }
         }
     });
+}
+
+
+
+template<typename T>
+static bool
+noise_uniform_(ImageBuf& dst, float min, float max, bool mono, int seed,
+               ROI roi, int nthreads)
+{
+    noise_by_scanline<T>(dst, mono, seed, roi, nthreads, hashrand_span,
+                         [=](ImageBuf::Iterator<T>& p, int c, float h) {
+                             p[c] = p[c] + lerp(min, max, h);
+                         });
     return true;
 }
 
@@ -592,17 +701,10 @@ static bool
 noise_gaussian_(ImageBuf& dst, float mean, float stddev, bool mono, int seed,
                 ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        for (ImageBuf::Iterator<T> p(dst, roi); !p.done(); ++p) {
-            int x = p.x(), y = p.y(), z = p.z();
-            float n = 0.0;
-            for (int c = roi.chbegin; c < roi.chend; ++c) {
-                if (c == roi.chbegin || !mono)
-                    n = mean + stddev * hashnormal(x, y, z, c, seed);
-                p[c] = p[c] + n;
-            }
-        }
-    });
+    noise_by_scanline<T>(dst, mono, seed, roi, nthreads, hashnormal_span,
+                         [=](ImageBuf::Iterator<T>& p, int c, float h) {
+                             p[c] = p[c] + (mean + stddev * h);
+                         });
     return true;
 }
 
@@ -613,18 +715,11 @@ static bool
 noise_salt_(ImageBuf& dst, float saltval, float saltportion, bool mono,
             int seed, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        for (ImageBuf::Iterator<T> p(dst, roi); !p.done(); ++p) {
-            int x = p.x(), y = p.y(), z = p.z();
-            float n = 0.0;
-            for (int c = roi.chbegin; c < roi.chend; ++c) {
-                if (c == roi.chbegin || !mono)
-                    n = hashrand(x, y, z, c, seed);
-                if (n < saltportion)
-                    p[c] = saltval;
-            }
-        }
-    });
+    noise_by_scanline<T>(dst, mono, seed, roi, nthreads, hashrand_span,
+                         [=](ImageBuf::Iterator<T>& p, int c, float h) {
+                             if (h < saltportion)
+                                 p[c] = saltval;
+                         });
     return true;
 }
 
@@ -887,38 +982,130 @@ static const char* default_font_name[] = { "DroidSans", "cour", "Courier New",
 
 
 
-// Helper: given unicode and a font face, compute its size
+// Rasterized glyph coverage, cached process-wide by (font file, size,
+// codepoint), so that text stamped repeatedly (frame numbers, slates)
+// doesn't need to go back through FreeType every time. The cache is
+// guarded by ft_mutex.
+struct CachedGlyph {
+    int left = 0, top = 0;               // bitmap offset from the pen
+    int width = 0, rows = 0;             // bitmap resolution
+    int advance = 0;                     // pen advance, in pixels
+    bool valid  = false;                 // false if FT couldn't load it
+    std::vector<uint8_t> coverage;       // width*rows coverage values
+};
+
+typedef std::tuple<std::string, int, uint32_t> GlyphKey;
+
+struct GlyphKeyHasher {
+    size_t operator()(const GlyphKey& k) const
+    {
+        return size_t(bjhash::bjfinal64(Strutil::strhash64(std::get<0>(k)),
+                                        uint64_t(std::get<1>(k)),
+                                        uint64_t(std::get<2>(k)), 0));
+    }
+};
+
+static std::unordered_map<GlyphKey, CachedGlyph, GlyphKeyHasher> glyph_cache;
+static const size_t glyph_cache_max_size = 65536;
+
+
+
+// Find the cached glyphs for each character of utext in the given font
+// file and size, rasterizing (and caching) any we haven't seen before.
+// Newlines get a nullptr entry. The FT face is only opened if something
+// needs to be rasterized. Return false and set err if that fails.
+// Not thread-safe! The caller must use the mutex.
+static bool
+get_glyphs(cspan<uint32_t> utext, const std::string& font, int fontsize,
+           std::vector<const CachedGlyph*>& glyphs, std::string& err)
+{
+    glyphs.clear();
+    glyphs.reserve(utext.size());
+    // Crude bound on memory use: someone rendering every glyph of many
+    // fonts at many sizes just starts over.
+    if (glyph_cache.size() > glyph_cache_max_size)
+        glyph_cache.clear();
+
+    FT_Face face = nullptr;
+    bool ok      = true;
+    for (auto ch : utext) {
+        if (ch == '\n') {
+            glyphs.push_back(nullptr);
+            continue;
+        }
+        GlyphKey key(font, fontsize, ch);
+        auto found = glyph_cache.find(key);
+        if (found == glyph_cache.end()) {
+            if (!face) {
+                if (FT_New_Face(ft_library, font.c_str(), 0, &face)) {
+                    face = nullptr;
+                    err  = Strutil::fmt::format(
+                        "Could not set font face to \"{}\"", font);
+                    ok = false;
+                    break;
+                }
+                if (FT_Set_Pixel_Sizes(face, 0 /*width*/, fontsize)) {
+                    err = Strutil::fmt::format("Could not set font size to {}",
+                                               fontsize);
+                    ok  = false;
+                    break;
+                }
+            }
+            CachedGlyph g;
+            if (!FT_Load_Char(face, ch, FT_LOAD_RENDER)) {
+                FT_GlyphSlot slot = face->glyph;
+                g.valid           = true;
+                g.left            = slot->bitmap_left;
+                g.top             = slot->bitmap_top;
+                g.width           = int(slot->bitmap.width);
+                g.rows            = int(slot->bitmap.rows);
+                g.advance         = int(slot->advance.x >> 6);
+                g.coverage.resize(size_t(g.width) * size_t(g.rows));
+                for (int j = 0; j < g.rows; ++j)
+                    memcpy(g.coverage.data() + size_t(j) * g.width,
+                           slot->bitmap.buffer + slot->bitmap.pitch * j,
+                           size_t(g.width));
+            }
+            found = glyph_cache.emplace(std::move(key), std::move(g)).first;
+        }
+        glyphs.push_back(&found->second);
+    }
+    if (face)
+        FT_Done_Face(face);
+    return ok;
+}
+
+
+
+// Helper: given the glyphs of some text, compute its size
 static ROI
-text_size_from_unicode(cspan<uint32_t> utext, FT_Face face, int fontsize)
+text_size_from_glyphs(cspan<const CachedGlyph*> glyphs, int fontsize)
 {
     int y = 0;
     int x = 0;
     ROI size;
     size.xbegin = size.ybegin = std::numeric_limits<int>::max();
     size.xend = size.yend = std::numeric_limits<int>::min();
-    FT_GlyphSlot slot     = face->glyph;
-    for (auto ch : utext) {
-        if (ch == '\n') {
+    for (auto g : glyphs) {
+        if (!g) {
             x = 0;
             y += fontsize;
             continue;
         }
-        int error = FT_Load_Char(face, ch, FT_LOAD_RENDER);
-        if (error)
+        if (!g->valid)
             continue;  // ignore errors
-        size.ybegin = std::min(size.ybegin, y - slot->bitmap_top);
-        size.yend   = std::max(size.yend, y + int(slot->bitmap.rows)
-                                              - int(slot->bitmap_top) + 1);
-        size.xbegin = std::min(size.xbegin, x + int(slot->bitmap_left));
-        size.xend   = std::max(size.xend, x + int(slot->bitmap.width)
-                                              + int(slot->bitmap_left) + 1);
+        size.ybegin = std::min(size.ybegin, y - g->top);
+        size.yend   = std::max(size.yend, y + g->rows - g->top + 1);
+        size.xbegin = std::min(size.xbegin, x + g->left);
+        size.xend   = std::max(size.xend, x + g->width + g->left + 1);
         // increment pen position
-        x += slot->advance.x >> 6;
+        x += g->advance;
     }
-    return size;  // Font rendering not supported
+    return size;
 }
 
 
+
 // Given font name, resolve it to an existing font filename.
 // If found, return true and put the resolved filename in result.
 // If not found, return false and put an error message in result.
@@ -999,26 +1186,13 @@ ImageBufAlgo::text_size(string_view text, int fontsize, string_view font_)
         return size;
     }
 
-    int error = 0;
-    FT_Face face;  // handle to face object
-    error = FT_New_Face(ft_library, font.c_str(), 0 /* face index */, &face);
-    if (error) {
-        return size;  // couldn't open the face
-    }
-
-    error = FT_Set_Pixel_Sizes(face /*handle*/, 0 /*width*/,
-                               fontsize /*height*/);
-    if (error) {
-        FT_Done_Face(face);
-        return size;  // couldn't set the character size
-    }
-
     std::vector<uint32_t> utext;
     utext.reserve(text.size());
     Strutil::utf8_to_unicode(text, utext);
-    size = text_size_from_unicode(utext, face, fontsize);
-
-    FT_Done_Face(face);
+    std::vector<const CachedGlyph*> glyphs;
+    std::string err;
+    if (get_glyphs(utext, font, fontsize, glyphs, err))
+        size = text_size_from_glyphs(glyphs, fontsize);
 #endif
 
     return size;  // Font rendering not supported
@@ -1026,12 +1200,40 @@ ImageBufAlgo::text_size(string_view text, int fontsize, string_view font_)
 
 
 
+#ifdef USE_FREETYPE
+// Blend the rendered text coverage (textimg) and its alpha (alphaimg, which
+// is dilated for a drop shadow) into R in the given color.
+template<typename T>
+static bool
+render_text_blend_(ImageBuf& R, const ImageBuf& textimg,
+                   const ImageBuf& alphaimg, cspan<float> textcolor,
+                   float textalpha, ROI roi, int nthreads)
+{
+    int nchannels = R.nchannels();
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        ImageBuf::ConstIterator<float> t(textimg, roi, ImageBuf::WrapBlack);
+        ImageBuf::ConstIterator<float> a(alphaimg, roi, ImageBuf::WrapBlack);
+        for (ImageBuf::Iterator<T> r(R, roi); !r.done(); ++r, ++t, ++a) {
+            float val   = t[0];
+            float alpha = a[0] * textalpha;
+            if (val == 0.0f && alpha == 0.0f)
+                continue;  // nothing to blend
+            for (int c = 0; c < nchannels; ++c)
+                r[c] = val * textcolor[c] + (1.0f - alpha) * r[c];
+        }
+    });
+    return true;
+}
+#endif
+
+
+
 bool
 ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
                           int fontsize, string_view font_,
                           cspan<float> textcolor, TextAlignX alignx,
                           TextAlignY aligny, int shadow, ROI roi,
-                          int /*nthreads*/)
+                          int nthreads)
 {
     pvt::LoggedTimer logtime("IBA::render_text");
     if (R.spec().depth > 1) {
@@ -1051,23 +1253,6 @@ ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
         return false;
     }
 
-    int error = 0;
-    FT_Face face;  // handle to face object
-    error = FT_New_Face(ft_library, font.c_str(), 0 /* face index */, &face);
-    if (error) {
-        R.errorfmt("Could not set font face to \"{}\"", font);
-        return false;  // couldn't open the face
-    }
-
-    error = FT_Set_Pixel_Sizes(face /*handle*/, 0 /*width*/,
-                               fontsize /*height*/);
-    if (error) {
-        FT_Done_Face(face);
-        R.errorfmt("Could not set font size to {}", fontsize);
-        return false;  // couldn't set the character size
-    }
-
-    FT_GlyphSlot slot = face->glyph;  // a small shortcut
     int nchannels(R.nchannels());
     IBA_FIX_PERCHAN_LEN_DEF(textcolor, nchannels);
 
@@ -1089,8 +1274,16 @@ ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
     utext.reserve(text.size());
     Strutil::utf8_to_unicode(text, utext);
 
+    // Look up (rasterizing only if not already cached) all the glyphs
+    std::vector<const CachedGlyph*> glyphs;
+    std::string err;
+    if (!get_glyphs(utext, font, fontsize, glyphs, err)) {
+        R.errorfmt("{}", err);
+        return false;
+    }
+
     // Compute the size that the text will render as, into an ROI
-    ROI textroi     = text_size_from_unicode(utext, face, fontsize);
+    ROI textroi     = text_size_from_glyphs(glyphs, fontsize);
     textroi.zbegin  = 0;
     textroi.zend    = 1;
     textroi.chbegin = 0;
@@ -1118,29 +1311,30 @@ ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
     ImageBuf textimg(ImageSpec(textroi, TypeDesc::FLOAT));
     ImageBufAlgo::zero(textimg);
 
-    // Glyph by glyph, fill in our textimg buffer
+    // Glyph by glyph, copy the cached coverage into our textimg buffer
     int origx = x;
-    for (auto ch : utext) {
-        if (ch == '\n') {
+    for (auto g : glyphs) {
+        if (!g) {
             x = origx;
             y += fontsize;
             continue;
         }
-        int error = FT_Load_Char(face, ch, FT_LOAD_RENDER);
-        if (error)
+        if (!g->valid)
             continue;  // ignore errors
-        // now, draw to our target surface
-        for (int j = 0; j < static_cast<int>(slot->bitmap.rows); ++j) {
-            int ry = y + j - slot->bitmap_top;
-            for (int i = 0; i < static_cast<int>(slot->bitmap.width); ++i) {
-                int rx  = x + i + slot->bitmap_left;
-                float b = slot->bitmap.buffer[slot->bitmap.pitch * j + i]
-                          / 255.0f;
-                textimg.setpixel(rx, ry, &b, 1);
+        for (int j = 0; j < g->rows; ++j) {
+            int ry = y + j - g->top;
+            if (ry < textroi.ybegin || ry >= textroi.yend)
+                continue;
+            float* row = (float*)textimg.pixeladdr(textroi.xbegin, ry);
+            const uint8_t* cov = g->coverage.data() + size_t(j) * g->width;
+            for (int i = 0; i < g->width; ++i) {
+                int rx = x + i + g->left;
+                if (rx >= textroi.xbegin && rx < textroi.xend)
+                    row[rx - textroi.xbegin] = cov[i] / 255.0f;
             }
         }
         // increment pen position
-        x += slot->advance.x >> 6;
+        x += g->advance;
     }
 
     // Generate the alpha image -- if drop shadow is requested, dilate,
@@ -1157,22 +1351,11 @@ ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
         return false;
     roi = roi_intersection(textroi, R.roi());
 
-    // Now fill in the pixels of our destination image
-    float* pixelcolor = OIIO_ALLOCA(float, nchannels);
-    ImageBuf::ConstIterator<float> t(textimg, roi, ImageBuf::WrapBlack);
-    ImageBuf::ConstIterator<float> a(alphaimg, roi, ImageBuf::WrapBlack);
-    ImageBuf::Iterator<float> r(R, roi);
-    for (; !r.done(); ++r, ++t, ++a) {
-        float val   = t[0];
-        float alpha = a[0] * textalpha;
-        R.getpixel(r.x(), r.y(), pixelcolor);
-        for (int c = 0; c < nchannels; ++c)
-            pixelcolor[c] = val * textcolor[c] + (1.0f - alpha) * pixelcolor[c];
-        R.setpixel(r.x(), r.y(), pixelcolor);
-    }
-
-    FT_Done_Face(face);
-    return true;
+    // Now blend the text coverage into the pixels of our destination image
+    OIIO_DISPATCH_TYPES(ok, "render_text", render_text_blend_, R.spec().format,
+                        R, textimg, alphaimg, textcolor, textalpha, roi,
+                        nthreads);
+    return ok;
 
 #else
     R.errorfmt("OpenImageIO was not compiled with FreeType for font rendering");
@@ -0,0 +1,416 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+/// \file
+/// Implementation of ImageBufAlgo::Expr, lazily evaluated chains of
+/// per-pixel math that run in a single pass.
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <OpenImageIO/color.h>
+#include <OpenImageIO/dassert.h>
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imagebufalgo_util.h>
+
+#include "imageio_pvt.h"
+
+
+OIIO_NAMESPACE_BEGIN
+
+using ImageBufAlgo::Expr;
+
+
+struct Expr::Node {
+    enum Op { Image, Const, Add, Sub, Mul, Mad, Clamp, Pow, Invert, Color };
+    Op op;
+    const ImageBuf* img = nullptr;
+    std::vector<float> vals, vals2;  // constant, clamp min/max, exponents
+    bool flag                          = false;  // clampalpha01, unpremult
+    const ColorProcessor* processor    = nullptr;
+    std::shared_ptr<const Node> arg[3] = {};
+
+    Node(Op op) : op(op) {}
+};
+
+
+
+Expr::Expr(const ImageBuf& img)
+{
+    auto node = std::make_shared<Node>(Node::Image);
+    node->img = &img;
+    m_node    = node;
+}
+
+
+
+Expr::Expr(float val)
+    : Expr(cspan<float>(&val, 1))
+{
+}
+
+
+
+Expr::Expr(cspan<float> val)
+{
+    auto node = std::make_shared<Node>(Node::Const);
+    node->vals.assign(val.begin(), val.end());
+    m_node = node;
+}
+
+
+
+Expr
+Expr::binary(char op, const Expr& A, const Expr& B)
+{
+    auto node    = std::make_shared<Node>(op == '+'   ? Node::Add
+                                          : op == '-' ? Node::Sub
+                                                      : Node::Mul);
+    node->arg[0] = A.m_node;
+    node->arg[1] = B.m_node;
+    return Expr(node);
+}
+
+
+
+Expr
+Expr::mad(const Expr& A, const Expr& B, const Expr& C)
+{
+    auto node    = std::make_shared<Node>(Node::Mad);
+    node->arg[0] = A.m_node;
+    node->arg[1] = B.m_node;
+    node->arg[2] = C.m_node;
+    return Expr(node);
+}
+
+
+
+Expr
+Expr::clamp(cspan<float> min, cspan<float> max, bool clampalpha01) const
+{
+    auto node = std::make_shared<Node>(Node::Clamp);
+    node->vals.assign(min.begin(), min.end());
+    node->vals2.assign(max.begin(), max.end());
+    node->flag   = clampalpha01;
+    node->arg[0] = m_node;
+    return Expr(node);
+}
+
+
+
+Expr
+Expr::pow(cspan<float> b) const
+{
+    auto node = std::make_shared<Node>(Node::Pow);
+    node->vals.assign(b.begin(), b.end());
+    node->arg[0] = m_node;
+    return Expr(node);
+}
+
+
+
+Expr
+Expr::invert() const
+{
+    auto node    = std::make_shared<Node>(Node::Invert);
+    node->arg[0] = m_node;
+    return Expr(node);
+}
+
+
+
+Expr
+Expr::colorconvert(const ColorProcessor* processor, bool unpremult) const
+{
+    auto node       = std::make_shared<Node>(Node::Color);
+    node->processor = processor;
+    node->flag      = unpremult;
+    node->arg[0]    = m_node;
+    return Expr(node);
+}
+
+
+
+namespace {
+
+// The expression flattened into postfix order, to run as a little stack
+// machine whose registers are whole scanline segments.
+struct ExprProgram {
+    struct Instr {
+        const Expr::Node* node;
+        int image;        // index into images, for Image nodes
+        int vals, vals2;  // indices into consts, or -1
+    };
+    std::vector<Instr> code;
+    std::vector<const ImageBuf*> images;
+    std::vector<std::vector<float>> consts;  // padded to nchannels
+    int maxdepth   = 0;
+    bool has_color = false;
+
+    int add_image(const ImageBuf* img)
+    {
+        for (size_t i = 0; i < images.size(); ++i)
+            if (images[i] == img)
+                return int(i);
+        images.push_back(img);
+        return int(images.size()) - 1;
+    }
+
+    int add_const(const std::vector<float>& v, float dflt)
+    {
+        consts.emplace_back(v.size() ? v : std::vector<float>(1, dflt));
+        return int(consts.size()) - 1;
+    }
+
+    // Append the code for node, returning the stack depth it needs.
+    int compile(const Expr::Node* node, int depth)
+    {
+        using Node = Expr::Node;
+        int need = depth + 1;
+        for (int a = 0; a < 3 && node->arg[a]; ++a)
+            need = std::max(need, compile(node->arg[a].get(), depth + a));
+        Instr instr { node, -1, -1, -1 };
+        const float big = std::numeric_limits<float>::max();
+        if (node->op == Node::Image)
+            instr.image = add_image(node->img);
+        else if (node->op == Node::Const || node->op == Node::Pow)
+            instr.vals = add_const(node->vals, 0.0f);
+        else if (node->op == Node::Clamp) {
+            instr.vals  = add_const(node->vals, -big);
+            instr.vals2 = add_const(node->vals2, big);
+        } else if (node->op == Node::Color)
+            has_color = true;
+        code.push_back(instr);
+        maxdepth = std::max(maxdepth, need);
+        return need;
+    }
+
+    // Extend every constant to nchannels by repeating its last value.
+    void pad_consts(int nchannels)
+    {
+        for (auto& c : consts)
+            if (int(c.size()) < nchannels)
+                c.resize(nchannels, c.back());
+    }
+};
+
+
+
+// Load channels [roi.chbegin, roi.chend) of one scanline segment of img
+// into the packed float array out, with zeros where img has no data.
+void
+load_row(const ImageBuf& img, ROI roi, int y, int z, float* out)
+{
+    int nchans = roi.nchannels(), width = roi.width();
+    int chend  = std::min(roi.chend, img.nchannels());
+    ROI have   = roi_intersection(img.roi(), ROI(roi.xbegin, roi.xend, y,
+                                                 y + 1, z, z + 1, 0, chend));
+    if (!have.defined() || have.width() != width || chend < roi.chend
+        || roi.chbegin >= chend)
+        std::fill(out, out + size_t(width) * nchans, 0.0f);
+    if (!have.defined() || roi.chbegin >= chend)
+        return;
+    have.chbegin     = roi.chbegin;
+    float* dst       = out + size_t(have.xbegin - roi.xbegin) * nchans;
+    stride_t xstride = nchans * sizeof(float);
+    if (img.localpixels())
+        convert_image(have.nchannels(), have.width(), 1, 1,
+                      img.pixeladdr(have.xbegin, y, z, have.chbegin),
+                      img.spec().format, img.pixel_stride(), AutoStride,
+                      AutoStride, dst, TypeFloat, xstride, AutoStride,
+                      AutoStride);
+    else
+        img.get_pixels(have, TypeFloat, dst, xstride);
+}
+
+
+
+// Store a packed float scanline segment into dst.
+void
+store_row(ImageBuf& dst, ROI roi, int y, int z, const float* in)
+{
+    ROI row(roi.xbegin, roi.xend, y, y + 1, z, z + 1, roi.chbegin, roi.chend);
+    stride_t xstride = roi.nchannels() * sizeof(float);
+    if (dst.localpixels())
+        convert_image(roi.nchannels(), roi.width(), 1, 1, in, TypeFloat,
+                      xstride, AutoStride, AutoStride,
+                      dst.pixeladdr(roi.xbegin, y, z, roi.chbegin),
+                      dst.spec().format, dst.pixel_stride(), AutoStride,
+                      AutoStride);
+    else
+        dst.set_pixels(row, TypeFloat, in, xstride);
+}
+
+
+
+void
+apply_color(const Expr::Node* node, float* r, int width, int nchans)
+{
+    // Like colorconvert(): only the first four channels take part, and the
+    // fourth is unpremultiplied around the transform.
+    int cchans         = std::min(4, nchans);
+    bool unpremult     = node->flag && cchans == 4;
+    const float fltmin = std::numeric_limits<float>::min();
+    if (unpremult) {
+        for (int i = 0; i < width; ++i) {
+            float* p = r + size_t(i) * nchans;
+            float a  = p[3] >= fltmin ? p[3] : 1.0f;
+            p[0] /= a, p[1] /= a, p[2] /= a;
+        }
+    }
+    node->processor->apply(r, width, 1, cchans, sizeof(float),
+                           nchans * sizeof(float),
+                           size_t(width) * nchans * sizeof(float));
+    if (unpremult) {
+        for (int i = 0; i < width; ++i) {
+            float* p = r + size_t(i) * nchans;
+            float a  = p[3] >= fltmin ? p[3] : 1.0f;
+            p[0] *= a, p[1] *= a, p[2] *= a;
+        }
+    }
+}
+
+}  // namespace
+
+
+
+bool
+Expr::eval(ImageBuf& dst, ROI roi, int nthreads) const
+{
+    pvt::LoggedTimer logtime("IBA::Expr::eval");
+    ExprProgram prog;
+    prog.compile(m_node.get(), 0);
+    for (auto img : prog.images) {
+        if (img->deep()) {
+            dst.errorfmt("Expr::eval does not support deep images");
+            return false;
+        }
+    }
+    const ImageBuf* A = prog.images.size() > 0 ? prog.images[0] : nullptr;
+    const ImageBuf* B = prog.images.size() > 1 ? prog.images[1] : nullptr;
+    const ImageBuf* C = prog.images.size() > 2 ? prog.images[2] : nullptr;
+    if (!roi.defined() && !dst.initialized() && prog.images.size() > 3) {
+        // IBAprep only looks at three inputs; fold in the rest ourselves.
+        for (auto img : prog.images)
+            roi = roi.defined() ? roi_union(roi, img->roi()) : img->roi();
+    }
+    if (!IBAprep(roi, &dst, A, B, C))
+        return false;
+    if (prog.has_color && (roi.chbegin != 0 || roi.nchannels() < 3)) {
+        dst.errorfmt("Expr::colorconvert needs channels 0-2 in the roi");
+        return false;
+    }
+    prog.pad_consts(dst.nchannels());
+    const int alpha = dst.spec().alpha_channel;
+    // Get dst its own writable pixels now, rather than racing to do it
+    // from every thread.
+    dst.localpixels();
+
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        int nchans   = roi.nchannels();
+        int width    = roi.width();
+        size_t nvals = size_t(width) * nchans;
+        int chbegin  = roi.chbegin;
+        std::vector<float> regs(nvals * prog.maxdepth);
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                int sp = 0;  // stack pointer: number of live registers
+                for (auto& instr : prog.code) {
+                    const Node* node = instr.node;
+                    // r is the top of the stack, next the free register
+                    float* next    = regs.data() + nvals * sp;
+                    float* r       = sp ? next - nvals : nullptr;
+                    const float* k = nullptr;
+                    if (instr.vals >= 0)
+                        k = prog.consts[instr.vals].data() + chbegin;
+                    switch (node->op) {
+                    case Node::Image:
+                        load_row(*prog.images[instr.image], roi, y, z, next);
+                        ++sp;
+                        break;
+                    case Node::Const:
+                        for (size_t i = 0; i < nvals; i += nchans)
+                            for (int c = 0; c < nchans; ++c)
+                                next[i + c] = k[c];
+                        ++sp;
+                        break;
+                    case Node::Add:
+                    case Node::Sub:
+                    case Node::Mul: {
+                        // Both operands are on the stack: r - nvals is
+                        // the left one and receives the result.
+                        float* a       = r - nvals;
+                        const float* b = r;
+                        if (node->op == Node::Add)
+                            for (size_t i = 0; i < nvals; ++i)
+                                a[i] += b[i];
+                        else if (node->op == Node::Sub)
+                            for (size_t i = 0; i < nvals; ++i)
+                                a[i] -= b[i];
+                        else
+                            for (size_t i = 0; i < nvals; ++i)
+                                a[i] *= b[i];
+                        --sp;
+                        break;
+                    }
+                    case Node::Mad: {
+                        float* a       = r - 2 * nvals;
+                        const float* b = r - nvals;
+                        const float* c = r;
+                        for (size_t i = 0; i < nvals; ++i)
+                            a[i] = a[i] * b[i] + c[i];
+                        sp -= 2;
+                        break;
+                    }
+                    case Node::Clamp: {
+                        const float* hi = prog.consts[instr.vals2].data()
+                                          + chbegin;
+                        for (size_t i = 0; i < nvals; i += nchans)
+                            for (int c = 0; c < nchans; ++c)
+                                r[i + c] = OIIO::clamp(r[i + c], k[c], hi[c]);
+                        if (node->flag && alpha >= roi.chbegin
+                            && alpha < roi.chend)
+                            for (size_t i = alpha - chbegin; i < nvals;
+                                 i += nchans)
+                                r[i] = OIIO::clamp(r[i], 0.0f, 1.0f);
+                        break;
+                    }
+                    case Node::Pow:
+                        for (size_t i = 0; i < nvals; i += nchans)
+                            for (int c = 0; c < nchans; ++c)
+                                r[i + c] = std::pow(r[i + c], k[c]);
+                        break;
+                    case Node::Invert:
+                        for (size_t i = 0; i < nvals; ++i)
+                            r[i] = 1.0f - r[i];
+                        break;
+                    case Node::Color:
+                        apply_color(node, r, width, nchans);
+                        break;
+                    }
+                }
+                OIIO_DASSERT(sp == 1);
+                store_row(dst, roi, y, z, regs.data());
+            }
+        }
+    });
+    return true;
+}
+
+
+
+ImageBuf
+Expr::eval(ROI roi, int nthreads) const
+{
+    ImageBuf result;
+    bool ok = eval(result, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::Expr::eval() error");
+    return result;
+}
+
+
+OIIO_NAMESPACE_END
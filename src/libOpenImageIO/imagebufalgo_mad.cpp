@@ -5,6 +5,7 @@
 #include <cmath>
 #include <iostream>
 #include <limits>
+#include <vector>
 
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/half.h>
@@ -24,7 +25,7 @@ static bool
 mad_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, const ImageBuf& C,
          ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, &B, [&](ROI roi) {
         if ((is_same<Rtype, float>::value || is_same<Rtype, half>::value)
             && (is_same<ABCtype, float>::value || is_same<ABCtype, half>::value)
             // && R.localpixels() // has to be, because it's writable
@@ -34,7 +35,12 @@ mad_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, const ImageBuf& C,
             && A.contains_roi(roi) && B.contains_roi(roi) && C.contains_roi(roi)
             && roi.chbegin == 0 && roi.chend == R.nchannels()
             && roi.chend == A.nchannels() && roi.chend == B.nchannels()
-            && roi.chend == C.nchannels()) {
+            && roi.chend == C.nchannels()
+            // and the pixels are packed (not, say, a view of some channels)
+            && R.pixel_stride() == stride_t(sizeof(Rtype) * roi.chend)
+            && A.pixel_stride() == stride_t(sizeof(ABCtype) * roi.chend)
+            && B.pixel_stride() == stride_t(sizeof(ABCtype) * roi.chend)
+            && C.pixel_stride() == stride_t(sizeof(ABCtype) * roi.chend)) {
             // Special case when all inputs are either float or half, with in-
             // memory contiguous data and we're operating on the full channel
             // range: skip iterators: For these circumstances, we can operate on
@@ -87,7 +93,7 @@ static bool
 mad_impl_ici(ImageBuf& R, const ImageBuf& A, cspan<float> b, const ImageBuf& C,
              ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, &C, [&](ROI roi) {
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<ABCtype> a(A, roi);
         ImageBuf::ConstIterator<ABCtype> c(C, roi);
@@ -106,7 +112,7 @@ static bool
 mad_impl_icc(ImageBuf& R, const ImageBuf& A, cspan<float> b, cspan<float> c,
              ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, [&](ROI roi) {
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         for (; !r.done(); ++r, ++a)
@@ -123,7 +129,7 @@ static bool
 mad_impl_iic(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, cspan<float> c,
              ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, &B, [&](ROI roi) {
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         ImageBuf::ConstIterator<Atype> b(B, roi);
@@ -181,6 +187,9 @@ ImageBufAlgo::mad(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_,
 
     if (!IBAprep(roi, &dst, A, B ? B : C, C))
         return false;
+    if (ComputeBackend* backend = compute_backend())
+        if (backend->mad(dst, A_, B_, C_, roi, nthreads))
+            return true;
 
     // Note: A is always an image. That leaves 4 cases to deal with.
     bool ok;
@@ -229,11 +238,37 @@ ImageBufAlgo::mad(Image_or_Const A, Image_or_Const B, Image_or_Const C, ROI roi,
 
 
 
+template<class Rtype, class Atype>
+static bool
+invert_impl(ImageBuf& R, const ImageBuf& A, ROI roi, int nthreads)
+{
+    std::vector<float> one(roi.chend, 1.0f);
+    ImageBufAlgo::binary_value_op<Rtype, Atype>(
+        R, A, one, roi, nthreads, [](float a, float b) { return b - a; });
+    return true;
+}
+
+
+
 bool
 ImageBufAlgo::invert(ImageBuf& dst, const ImageBuf& A, ROI roi, int nthreads)
 {
-    // Calculate invert as simply 1-A == A*(-1)+1
-    return mad(dst, A, -1.0, 1.0, roi, nthreads);
+    pvt::LoggedTimer logtime("IBA::invert");
+    if (!IBAprep(roi, &dst, &A))
+        return false;
+    // For uint8 and uint16, 1-A is exactly the maximum code value minus A.
+    bool ok = native_value_op<uint8_t>(dst, A, roi, nthreads,
+                                       [](uint8_t a) { return uint8_t(~a); })
+              || native_value_op<uint16_t>(dst, A, roi, nthreads,
+                                           [](uint16_t a) {
+                                               return uint16_t(~a);
+                                           });
+    if (!ok) {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "invert", invert_impl,
+                                    dst.spec().format, A.spec().format, dst, A,
+                                    roi, nthreads);
+    }
+    return ok;
 }
 
 
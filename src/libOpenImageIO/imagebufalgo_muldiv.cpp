@@ -30,14 +30,8 @@ static bool
 mul_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::Iterator<Rtype> r(R, roi);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        ImageBuf::ConstIterator<Btype> b(B, roi);
-        for (; !r.done(); ++r, ++a, ++b)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = a[c] * b[c];
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype, Btype>(
+        R, A, B, roi, nthreads, [](float a, float b) { return a * b; });
     return true;
 }
 
@@ -47,12 +41,8 @@ template<class Rtype, class Atype>
 static bool
 mul_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        for (ImageBuf::Iterator<Rtype> r(R, roi); !r.done(); ++r, ++a)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = a[c] * b[c];
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype>(
+        R, A, b, roi, nthreads, [](float a, float b) { return a * b; });
     return true;
 }
 
@@ -93,10 +83,20 @@ ImageBufAlgo::mul(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
         const ImageBuf &A(A_.img()), &B(B_.img());
         if (!IBAprep(roi, &dst, &A, &B, IBAprep_CLAMP_MUTUAL_NCHANNELS))
             return false;
-        bool ok;
-        OIIO_DISPATCH_COMMON_TYPES3(ok, "mul", mul_impl, dst.spec().format,
-                                    A.spec().format, B.spec().format, dst, A, B,
-                                    roi, nthreads);
+        if (ComputeBackend* backend = compute_backend())
+            if (backend->mul(dst, A_, B_, roi, nthreads))
+                return true;
+        // uint8 and uint16 images multiply their code values directly,
+        // skipping the round trip through float.
+        bool ok = native_value_op<uint8_t>(dst, A, B, roi, nthreads,
+                                           unorm_mul<uint8_t>)
+                  || native_value_op<uint16_t>(dst, A, B, roi, nthreads,
+                                               unorm_mul<uint16_t>);
+        if (!ok) {
+            OIIO_DISPATCH_COMMON_TYPES3(ok, "mul", mul_impl, dst.spec().format,
+                                        A.spec().format, B.spec().format, dst,
+                                        A, B, roi, nthreads);
+        }
         return ok;
     }
     if (A_.is_val() && B_.is_img())  // canonicalize to A_img, B_val
@@ -113,6 +113,9 @@ ImageBufAlgo::mul(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
             dst.deepdata()->set_all_samples(A.deepdata()->all_samples());
             return mul_impl_deep(dst, A, b, roi, nthreads);
         }
+        if (ComputeBackend* backend = compute_backend())
+            if (backend->mul(dst, A_, b, roi, nthreads))
+                return true;
         bool ok;
         OIIO_DISPATCH_COMMON_TYPES2(ok, "mul", mul_impl, dst.spec().format,
                                     A.spec().format, dst, A, b, roi, nthreads);
@@ -142,7 +145,7 @@ static bool
 div_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, &B, [&](ROI roi) {
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         ImageBuf::ConstIterator<Btype> b(B, roi);
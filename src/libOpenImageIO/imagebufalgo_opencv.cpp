@@ -106,7 +106,7 @@ from_IplImage(const IplImage* ipl, TypeDesc convert)
     // Block copy and convert
     convert_image(spec.nchannels, spec.width, spec.height, 1, ipl->imageData,
                   srcformat, pixelsize, linestep, 0, dst.pixeladdr(0, 0),
-                  dstformat, spec.pixel_bytes(), spec.scanline_bytes(), 0);
+                  dstformat, dst.pixel_stride(), dst.scanline_stride(), 0);
     // FIXME - honor dataOrder.  I'm not sure if it is ever used by
     // OpenCV.  Fix when it becomes a problem.
 
@@ -192,11 +192,13 @@ to_IplImage(const ImageBuf& src)
     // standard OIIO origin-at-upper-left:
     size_t linestep = ipl->origin ? -ipl->widthStep : ipl->widthStep;
 
+    // Writable access may give tmp its own copy, with new strides, so get
+    // the pixel pointer before the strides.
+    const void* tmppixels = tmp.localpixels();
     bool converted = convert_image(spec.nchannels, spec.width, spec.height, 1,
-                                   tmp.localpixels(), spec.format,
-                                   spec.pixel_bytes(), spec.scanline_bytes(), 0,
-                                   ipl->imageData, dstSpecFormat, pixelsize,
-                                   linestep, 0);
+                                   tmppixels, spec.format, tmp.pixel_stride(),
+                                   tmp.scanline_stride(), 0, ipl->imageData,
+                                   dstSpecFormat, pixelsize, linestep, 0);
 
     if (!converted) {
         OIIO_DASSERT(0 && "convert_image failed.");
@@ -269,7 +271,7 @@ ImageBufAlgo::from_OpenCV(const cv::Mat& mat, TypeDesc convert, ROI roi,
     parallel_convert_image(spec.nchannels, spec.width, spec.height, 1,
                            mat.ptr(), srcformat, pixelsize, linestep, 0,
                            dst.pixeladdr(roi.xbegin, roi.ybegin), dstformat,
-                           spec.pixel_bytes(), spec.scanline_bytes(), 0, -1, -1,
+                           dst.pixel_stride(), dst.scanline_stride(), 0, -1, -1,
                            nthreads);
 
     // OpenCV uses BGR ordering
@@ -371,6 +373,96 @@ ImageBufAlgo::to_OpenCV(cv::Mat& dst, const ImageBuf& src, ROI roi,
 
 
 
+ImageBuf
+ImageBufAlgo::from_OpenCV_wrap(cv::Mat& mat)
+{
+    ImageBuf dst;
+#ifdef USE_OPENCV
+    TypeDesc format;
+    switch (mat.depth()) {
+    case CV_8U: format = TypeDesc::UINT8; break;
+    case CV_8S: format = TypeDesc::INT8; break;
+    case CV_16U: format = TypeDesc::UINT16; break;
+    case CV_16S: format = TypeDesc::INT16; break;
+    case CV_32S: format = TypeDesc::INT32; break;
+#    if OIIO_OPENCV_VERSION >= 40000
+    case CV_16F: format = TypeDesc::HALF; break;
+#    endif
+    case CV_32F: format = TypeDesc::FLOAT; break;
+    case CV_64F: format = TypeDesc::DOUBLE; break;
+    default:
+        dst.errorfmt("Unsupported OpenCV data type, depth={}", mat.depth());
+        return dst;
+    }
+    if (mat.empty() || mat.dims != 2) {
+        dst.errorfmt("from_OpenCV_wrap() needs a non-empty 2D cv::Mat");
+        return dst;
+    }
+
+    ImageSpec spec(mat.cols, mat.rows, mat.channels(), format);
+    // OpenCV uses BGR ordering. Say so instead of swapping.
+    if (spec.nchannels == 3 || spec.nchannels == 4) {
+        spec.channelnames[0] = "B";
+        spec.channelnames[2] = "R";
+    }
+    dst.reset(spec, mat.ptr(), AutoStride, stride_t(mat.step[0]));
+#else
+    dst.errorfmt(
+        "from_OpenCV_wrap() not supported -- no OpenCV support at compile time");
+#endif
+    return dst;
+}
+
+
+
+bool
+ImageBufAlgo::to_OpenCV_wrap(cv::Mat& dst, ImageBuf& src)
+{
+#ifdef USE_OPENCV
+    const ImageSpec& spec = src.spec();
+    int depth             = -1;
+    switch (spec.format.basetype) {
+    case TypeDesc::UINT8: depth = CV_8U; break;
+    case TypeDesc::INT8: depth = CV_8S; break;
+    case TypeDesc::UINT16: depth = CV_16U; break;
+    case TypeDesc::INT16: depth = CV_16S; break;
+    case TypeDesc::INT32: depth = CV_32S; break;
+#    if OIIO_OPENCV_VERSION >= 40000
+    case TypeDesc::HALF: depth = CV_16F; break;
+#    endif
+    case TypeDesc::FLOAT: depth = CV_32F; break;
+    case TypeDesc::DOUBLE: depth = CV_64F; break;
+    default: break;
+    }
+    if (depth < 0 || spec.deep || spec.depth > 1
+        || spec.nchannels > CV_CN_MAX) {
+        OIIO::pvt::errorfmt(
+            "to_OpenCV_wrap() can't make a cv::Mat of {} {}-channel {}",
+            spec.deep ? "deep" : (spec.depth > 1 ? "volumetric" : "flat"),
+            spec.nchannels, spec.format);
+        return false;
+    }
+    void* pixels = src.storage() == ImageBuf::IMAGECACHE ? nullptr
+                                                          : src.localpixels();
+    if (!pixels || src.pixel_stride() != stride_t(spec.pixel_bytes())
+        || src.scanline_stride() <= 0) {
+        OIIO::pvt::errorfmt(
+            "to_OpenCV_wrap() needs local, interleaved, top-down pixels");
+        return false;
+    }
+    dst = cv::Mat(spec.height, spec.width,
+                  CV_MAKETYPE(depth, spec.nchannels), pixels,
+                  size_t(src.scanline_stride()));
+    return true;
+#else
+    OIIO::pvt::errorfmt(
+        "to_OpenCV_wrap() not supported -- no OpenCV support at compile time");
+    return false;
+#endif
+}
+
+
+
 namespace {
 
 #ifdef USE_OPENCV
@@ -11,6 +11,7 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/simd.h>
 #include <OpenImageIO/thread.h>
 
 #include "imageio_pvt.h"
@@ -141,6 +142,131 @@ ImageBufAlgo::flop(const ImageBuf& src, ROI roi, int nthreads)
 
 
 
+// Copy a w x h block of pixels of Bytes bytes each (or of `bytes` bytes,
+// if Bytes is 0), where the source pixel for destination (x,y) is at
+// s + x * sxstride + y * systride.
+template<size_t Bytes>
+static void
+swapxy_block(char* d, stride_t dxstride, stride_t dystride, const char* s,
+             stride_t sxstride, stride_t systride, int w, int h, size_t bytes)
+{
+    for (int y = 0; y < h; ++y, d += dystride, s += systride) {
+        char* dp       = d;
+        const char* sp = s;
+        for (int x = 0; x < w; ++x, dp += dxstride, sp += sxstride)
+            memcpy(dp, sp, Bytes ? Bytes : bytes);
+    }
+}
+
+
+
+// Same, for 4-byte pixels (RGBA uint8, say) that are contiguous along x in
+// the destination and along y (either way) in the source: each 4x4 square
+// of pixels is a transpose of 32 bit words done in registers.
+static void
+swapxy_block4(char* d, stride_t dystride, const char* s, stride_t sxstride,
+              stride_t systride, int w, int h)
+{
+    using namespace simd;
+    int w4 = w & ~3, h4 = h & ~3;
+    for (int y = 0; y < h4; y += 4) {
+        // Source pointer to the lowest-addressed pixel of this row of
+        // squares, and the destination rows its words end up in.
+        const char* sp = s + (systride > 0 ? y : y + 3) * systride;
+        char* drow[4];
+        for (int j = 0; j < 4; ++j)
+            drow[j] = d + (systride > 0 ? y + j : y + 3 - j) * dystride;
+        for (int x = 0; x < w4; x += 4) {
+            vint4 a((const int*)(sp + (x + 0) * sxstride));
+            vint4 b((const int*)(sp + (x + 1) * sxstride));
+            vint4 c((const int*)(sp + (x + 2) * sxstride));
+            vint4 e((const int*)(sp + (x + 3) * sxstride));
+            transpose(a, b, c, e);
+            a.store((int*)(drow[0] + 4 * x));
+            b.store((int*)(drow[1] + 4 * x));
+            c.store((int*)(drow[2] + 4 * x));
+            e.store((int*)(drow[3] + 4 * x));
+        }
+    }
+    // The ragged right and bottom edges
+    swapxy_block<4>(d + 4 * w4, 4, dystride, s + w4 * sxstride, sxstride,
+                    systride, w - w4, h4, 4);
+    swapxy_block<4>(d + h4 * dystride, 4, dystride, s + h4 * systride,
+                    sxstride, systride, w, h - h4, 4);
+}
+
+
+
+// Fast path shared by rotate90, rotate270, and transpose, in which every
+// destination pixel (x,y) of roi is the source pixel
+//     (sx0 + sxdir * (y - roi.ybegin), sy0 + sydir * (x - roi.xbegin)),
+// so each destination row is a source column. Walking the destination in
+// order reads the source down a column, a new cache line (and on big
+// images, a new page) for every pixel. Instead, go a block at a time, with
+// blocks small enough that the source rows they touch stay in cache. This
+// needs both images in local memory with the same pixel type, and every
+// pixel involved to exist; it returns false, having done nothing, if not.
+static bool
+swapxy_blocked(ImageBuf& dst, const ImageBuf& src, ROI roi, int sx0,
+               int sxdir, int sy0, int sydir, int nthreads)
+{
+    int sx1 = sx0 + sxdir * (roi.height() - 1);
+    int sy1 = sy0 + sydir * (roi.width() - 1);
+    ROI sroi(std::min(sx0, sx1), std::max(sx0, sx1) + 1, std::min(sy0, sy1),
+             std::max(sy0, sy1) + 1, roi.zbegin, roi.zend, roi.chbegin,
+             roi.chend);
+    if (!dst.localpixels() || !src.localpixels() || dst.deep() || src.deep()
+        || dst.spec().format != src.spec().format
+        || !dst.roi().contains(roi) || !src.roi().contains(sroi))
+        return false;
+
+    // Pick a block copier that knows the pixel size at compile time.
+    size_t pixbytes = roi.nchannels() * dst.spec().format.size();
+    auto block      = swapxy_block<0>;
+    switch (pixbytes) {
+    case 1: block = swapxy_block<1>; break;
+    case 2: block = swapxy_block<2>; break;
+    case 3: block = swapxy_block<3>; break;
+    case 4: block = swapxy_block<4>; break;
+    case 6: block = swapxy_block<6>; break;
+    case 8: block = swapxy_block<8>; break;
+    case 12: block = swapxy_block<12>; break;
+    case 16: block = swapxy_block<16>; break;
+    }
+
+    stride_t dxs  = dst.pixel_stride();
+    stride_t dys  = dst.scanline_stride();
+    stride_t sxs  = sydir * src.scanline_stride();
+    stride_t sys  = sxdir * src.pixel_stride();
+    bool simd4    = pixbytes == 4 && dxs == 4 && (sys == 4 || sys == -4);
+    int blocksize = pixbytes > 4 ? 32 : 64;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI r) {
+        for (int z = r.zbegin; z < r.zend; ++z) {
+            char* d0 = (char*)dst.pixeladdr(roi.xbegin, roi.ybegin, z,
+                                            roi.chbegin);
+            const char* s0 = (const char*)src.pixeladdr(sx0, sy0, z,
+                                                        roi.chbegin);
+            for (int by = r.ybegin; by < r.yend; by += blocksize) {
+                int h = std::min(blocksize, r.yend - by);
+                for (int bx = r.xbegin; bx < r.xend; bx += blocksize) {
+                    int w   = std::min(blocksize, r.xend - bx);
+                    char* d = d0 + (bx - roi.xbegin) * dxs
+                              + (by - roi.ybegin) * dys;
+                    const char* s = s0 + (bx - roi.xbegin) * sxs
+                                    + (by - roi.ybegin) * sys;
+                    if (simd4)
+                        swapxy_block4(d, dys, s, sxs, sys, w, h);
+                    else
+                        block(d, dxs, dys, s, sxs, sys, w, h, pixbytes);
+                }
+            }
+        }
+    });
+    return true;
+}
+
+
+
 template<class D, class S = D>
 static bool
 rotate90_(ImageBuf& dst, const ImageBuf& src, ROI dst_roi, int /*nthreads*/)
@@ -193,6 +319,11 @@ ImageBufAlgo::rotate90(ImageBuf& dst, const ImageBuf& src, ROI roi,
     if (!dst_initialized)
         dst.set_roi_full(dst_roi_full);
 
+    // dst(x,y) = src(y, xend-1-x)
+    if (swapxy_blocked(dst, src, dst_roi, dst_roi.ybegin, 1,
+                       dst.roi_full().xend - 1 - dst_roi.xbegin, -1, nthreads))
+        return true;
+
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "rotate90", rotate90_, dst.spec().format,
                                 src.spec().format, dst, src, dst_roi, nthreads);
@@ -307,6 +438,12 @@ ImageBufAlgo::rotate270(ImageBuf& dst, const ImageBuf& src, ROI roi,
     if (!dst_initialized)
         dst.set_roi_full(dst_roi_full);
 
+    // dst(x,y) = src(yend-1-y, x)
+    if (swapxy_blocked(dst, src, dst_roi,
+                       dst.roi_full().yend - 1 - dst_roi.ybegin, -1,
+                       dst_roi.xbegin, 1, nthreads))
+        return true;
+
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "rotate270", rotate270_, dst.spec().format,
                                 src.spec().format, dst, src, dst_roi, nthreads);
@@ -435,6 +572,9 @@ ImageBufAlgo::transpose(ImageBuf& dst, const ImageBuf& src, ROI roi,
                          r.chbegin, r.chend);
         dst.set_roi_full(dst_roi_full);
     }
+    if (swapxy_blocked(dst, src, dst_roi, dst_roi.ybegin, 1, dst_roi.xbegin, 1,
+                       nthreads))
+        return true;
     bool ok;
     if (dst.spec().format == src.spec().format) {
         OIIO_DISPATCH_TYPES(ok, "transpose", transpose_, dst.spec().format, dst,
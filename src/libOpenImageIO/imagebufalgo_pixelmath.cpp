@@ -6,14 +6,18 @@
 /// Implementation of ImageBufAlgo algorithms that do math on
 /// single pixels at a time.
 
+#include <algorithm>
+#include <cctype>
 #include <cmath>
 #include <iostream>
 #include <limits>
+#include <vector>
 
 #include <OpenImageIO/half.h>
 
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/deepdata.h>
+#include <OpenImageIO/hash.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
@@ -30,14 +34,9 @@ static bool
 min_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::Iterator<Rtype> r(R, roi);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        ImageBuf::ConstIterator<Btype> b(B, roi);
-        for (; !r.done(); ++r, ++a, ++b)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = std::min(a[c], b[c]);
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype, Btype>(
+        R, A, B, roi, nthreads,
+        [](float a, float b) { return std::min(a, b); });
     return true;
 }
 
@@ -47,13 +46,9 @@ template<class Rtype, class Atype>
 static bool
 min_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::Iterator<Rtype> r(R, roi);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        for (; !r.done(); ++r, ++a)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = std::min(a[c], b[c]);
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype>(
+        R, A, b, roi, nthreads,
+        [](float a, float b) { return std::min(a, b); });
     return true;
 }
 
@@ -127,14 +122,9 @@ static bool
 max_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::Iterator<Rtype> r(R, roi);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        ImageBuf::ConstIterator<Btype> b(B, roi);
-        for (; !r.done(); ++r, ++a, ++b)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = std::max(a[c], b[c]);
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype, Btype>(
+        R, A, B, roi, nthreads,
+        [](float a, float b) { return std::max(a, b); });
     return true;
 }
 
@@ -144,13 +134,9 @@ template<class Rtype, class Atype>
 static bool
 max_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::Iterator<Rtype> r(R, roi);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        for (; !r.done(); ++r, ++a)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = std::max(a[c], b[c]);
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype>(
+        R, A, b, roi, nthreads,
+        [](float a, float b) { return std::max(a, b); });
     return true;
 }
 
@@ -224,7 +210,7 @@ static bool
 clamp_(ImageBuf& dst, const ImageBuf& src, const float* min, const float* max,
        bool clampalpha01, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI roi) {
         ImageBuf::ConstIterator<S> s(src, roi);
         for (ImageBuf::Iterator<D> d(dst, roi); !d.done(); ++d, ++s) {
             for (int c = roi.chbegin; c < roi.chend; ++c)
@@ -280,14 +266,9 @@ static bool
 absdiff_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
              int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::Iterator<Rtype> r(R, roi);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        ImageBuf::ConstIterator<Btype> b(B, roi);
-        for (; !r.done(); ++r, ++a, ++b)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = std::abs(a[c] - b[c]);
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype, Btype>(
+        R, A, B, roi, nthreads,
+        [](float a, float b) { return std::abs(a - b); });
     return true;
 }
 
@@ -297,13 +278,9 @@ static bool
 absdiff_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi,
              int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ImageBuf::Iterator<Rtype> r(R, roi);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        for (; !r.done(); ++r, ++a)
-            for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = std::abs(a[c] - b[c]);
-    });
+    ImageBufAlgo::binary_value_op<Rtype, Atype>(
+        R, A, b, roi, nthreads,
+        [](float a, float b) { return std::abs(a - b); });
     return true;
 }
 
@@ -398,7 +375,7 @@ template<class Rtype, class Atype>
 static bool
 pow_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, [&](ROI roi) {
         ImageBuf::ConstIterator<Atype> a(A, roi);
         for (ImageBuf::Iterator<Rtype> r(R, roi); !r.done(); ++r, ++a)
             for (int c = roi.chbegin; c < roi.chend; ++c)
@@ -438,7 +415,7 @@ static bool
 normalize_impl(ImageBuf& R, const ImageBuf& A, float inCenter, float outCenter,
                float scale, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, [&](ROI roi) {
         ImageBuf::ConstIterator<Rtype> a(A, roi);
         for (ImageBuf::Iterator<Rtype> r(R, roi); !r.done(); ++r, ++a) {
             float x = a[0] - inCenter;
@@ -505,7 +482,7 @@ static bool
 channel_sum_(ImageBuf& dst, const ImageBuf& src, cspan<float> weights, ROI roi,
              int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI roi) {
         ImageBuf::Iterator<D> d(dst, roi);
         ImageBuf::ConstIterator<S> s(src, roi);
         for (; !d.done(); ++d, ++s) {
@@ -557,6 +534,225 @@ ImageBufAlgo::channel_sum(const ImageBuf& src, cspan<float> weights, ROI roi,
 
 
 
+float
+ImageBufAlgo::cryptomatte_id(string_view name)
+{
+    // MurmurHash3_x86_32 with seed 0, per the Cryptomatte specification.
+    const unsigned char* data = (const unsigned char*)name.data();
+    const size_t len          = name.size();
+    const uint32_t c1 = 0xcc9e2d51, c2 = 0x1b873593;
+    uint32_t h = 0;
+    size_t i   = 0;
+    for (; i + 4 <= len; i += 4) {
+        uint32_t k = uint32_t(data[i]) | (uint32_t(data[i + 1]) << 8)
+                     | (uint32_t(data[i + 2]) << 16)
+                     | (uint32_t(data[i + 3]) << 24);
+        k *= c1;
+        k = rotl32(k, 15);
+        k *= c2;
+        h ^= k;
+        h = rotl32(h, 13);
+        h = h * 5 + 0xe6546b64;
+    }
+    uint32_t k = 0;
+    switch (len & 3) {
+    case 3: k ^= uint32_t(data[i + 2]) << 16; OIIO_FALLTHROUGH;
+    case 2: k ^= uint32_t(data[i + 1]) << 8; OIIO_FALLTHROUGH;
+    case 1:
+        k ^= uint32_t(data[i]);
+        k *= c1;
+        k = rotl32(k, 15);
+        k *= c2;
+        h ^= k;
+    }
+    h ^= uint32_t(len);
+    h = murmur::fmix(h);
+    // Keep the float from being a denormal, infinity, or NaN.
+    uint32_t exponent = (h >> 23) & 255;
+    if (exponent == 0 || exponent == 255)
+        h ^= 1 << 23;
+    return bitcast<float, uint32_t>(h);
+}
+
+
+
+// The Cryptomatte layer's rank channels come in (ID, coverage) pairs, the ID
+// being a float bit-cast of a 32-bit object hash. Each pixel looks up each
+// of its IDs in a small open-addressed table of the requested IDs, so the
+// cost is one pass over the rank channels no matter how many IDs we want.
+static bool
+cryptomatte_extract_(ImageBuf& dst, const ImageBuf& src, cspan<int> rankchans,
+                     cspan<float> ids, ROI roi, int nthreads)
+{
+    const int nids   = int(ids.size());
+    size_t tablesize = 4;
+    while (tablesize < 2 * size_t(nids))
+        tablesize *= 2;
+    const uint32_t mask = uint32_t(tablesize - 1);
+    std::vector<uint32_t> keys(tablesize, 0);  // 0 marks an empty slot
+    std::vector<int> slots(tablesize, -1);
+    std::vector<int> dupof(nids, -1);  // repeated IDs copy an earlier matte
+    for (int i = 0; i < nids; ++i) {
+        uint32_t bits = bitcast<uint32_t, float>(ids[i]);
+        if (!bits)
+            continue;  // 0 is "no object", never matches
+        uint32_t h = murmur::fmix(bits) & mask;
+        while (keys[h] && keys[h] != bits)
+            h = (h + 1) & mask;
+        if (keys[h] == bits) {
+            dupof[i] = slots[h];
+            continue;
+        }
+        keys[h]  = bits;
+        slots[h] = i;
+    }
+    bool anydups = std::any_of(dupof.begin(), dupof.end(),
+                               [](int d) { return d >= 0; });
+
+    const int npairs = int(rankchans.size()) / 2;
+    const int srcnch = src.nchannels();
+    // Work straight in the image memory when it's float, else a row at a
+    // time through a float buffer.
+    bool srcdirect = src.localpixels() && src.spec().format == TypeFloat;
+    bool dstdirect = dst.localpixels() && dst.spec().format == TypeFloat
+                     && dst.nchannels() == nids;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const int width = roi.width();
+        std::vector<float> srcrow(srcdirect ? 0 : size_t(width) * srcnch);
+        std::vector<float> dstrow(dstdirect ? 0 : size_t(width) * nids);
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                ROI row(roi.xbegin, roi.xend, y, y + 1, z, z + 1, 0, srcnch);
+                const float* s;
+                stride_t sstride;  // in floats
+                if (srcdirect) {
+                    s       = (const float*)src.pixeladdr(roi.xbegin, y, z);
+                    sstride = src.pixel_stride() / stride_t(sizeof(float));
+                } else {
+                    src.get_pixels(row, TypeFloat, srcrow.data());
+                    s       = srcrow.data();
+                    sstride = srcnch;
+                }
+                float* d = dstdirect ? (float*)dst.pixeladdr(roi.xbegin, y, z)
+                                     : dstrow.data();
+                const stride_t dstride
+                    = dstdirect ? dst.pixel_stride() / stride_t(sizeof(float))
+                                : nids;
+                for (int x = 0; x < width; ++x, s += sstride, d += dstride) {
+                    for (int i = 0; i < nids; ++i)
+                        d[i] = 0.0f;
+                    for (int p = 0; p < npairs; ++p) {
+                        uint32_t bits = bitcast<uint32_t, float>(
+                            s[rankchans[2 * p]]);
+                        float coverage = s[rankchans[2 * p + 1]];
+                        if (!bits || coverage == 0.0f)
+                            continue;
+                        for (uint32_t h = murmur::fmix(bits) & mask; keys[h];
+                             h = (h + 1) & mask) {
+                            if (keys[h] == bits) {
+                                d[slots[h]] += coverage;
+                                break;
+                            }
+                        }
+                    }
+                    if (anydups)
+                        for (int i = 0; i < nids; ++i)
+                            if (dupof[i] >= 0)
+                                d[i] = d[dupof[i]];
+                }
+                if (!dstdirect) {
+                    row.chend = nids;
+                    dst.set_pixels(row, TypeFloat, dstrow.data());
+                }
+            }
+        }
+    });
+    return true;
+}
+
+
+
+bool
+ImageBufAlgo::cryptomatte_extract(ImageBuf& dst, const ImageBuf& src,
+                                  string_view layer, cspan<float> ids, ROI roi,
+                                  int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::cryptomatte_extract");
+    // The rank channels are named <layer>NN.<channel>, and pair up in
+    // channel order as (ID, coverage).
+    const ImageSpec& srcspec(src.spec());
+    std::vector<int> rankchans;
+    for (int c = 0; c < srcspec.nchannels; ++c) {
+        string_view name = srcspec.channel_name(c);
+        if (name.size() > layer.size() + 3 && Strutil::starts_with(name, layer)
+            && isdigit((unsigned char)name[layer.size()])
+            && isdigit((unsigned char)name[layer.size() + 1])
+            && name[layer.size() + 2] == '.')
+            rankchans.push_back(c);
+    }
+    if (rankchans.empty() || rankchans.size() % 2) {
+        dst.errorfmt("cryptomatte_extract: no cryptomatte layer \"{}\"",
+                     layer);
+        return false;
+    }
+    for (int c : rankchans) {
+        if (srcspec.channelformat(c) != TypeFloat) {
+            dst.errorfmt(
+                "cryptomatte_extract: channel \"{}\" is not float, the IDs "
+                "can't be recovered",
+                srcspec.channel_name(c));
+            return false;
+        }
+    }
+    if (ids.empty()) {
+        dst.errorfmt("cryptomatte_extract: no IDs requested");
+        return false;
+    }
+
+    if (!roi.defined())
+        roi = get_roi(srcspec);
+    const int nids = int(ids.size());
+    ROI dstroi     = roi;
+    dstroi.chbegin = 0;
+    dstroi.chend   = nids;
+    if (!dst.initialized()) {
+        ImageSpec dstspec(dstroi, TypeFloat);
+        dstspec.set_roi_full(srcspec.roi_full());
+        if (nids == 1) {
+            dstspec.channelnames[0] = "A";
+            dstspec.alpha_channel   = 0;
+        } else {
+            for (int i = 0; i < nids; ++i)
+                dstspec.channelnames[i] = Strutil::fmt::format(
+                    "{}.{:08x}", layer, bitcast<uint32_t, float>(ids[i]));
+        }
+        dst.reset(dstspec);
+    }
+    if (!IBAprep(dstroi, &dst))
+        return false;
+    if (dst.nchannels() < nids) {
+        dst.errorfmt("cryptomatte_extract: destination needs {} channels",
+                     nids);
+        return false;
+    }
+    return cryptomatte_extract_(dst, src, rankchans, ids, roi, nthreads);
+}
+
+
+
+ImageBuf
+ImageBufAlgo::cryptomatte_extract(const ImageBuf& src, string_view layer,
+                                  cspan<float> ids, ROI roi, int nthreads)
+{
+    ImageBuf result;
+    bool ok = cryptomatte_extract(result, src, layer, ids, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("cryptomatte_extract error");
+    return result;
+}
+
+
+
 inline float
 rangecompress(float x)
 {
@@ -609,7 +805,7 @@ static bool
 rangecompress_(ImageBuf& R, const ImageBuf& A, bool useluma, ROI roi,
                int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, [&](ROI roi) {
         const ImageSpec& Aspec(A.spec());
         int alpha_channel = Aspec.alpha_channel;
         int z_channel     = Aspec.z_channel;
@@ -677,7 +873,7 @@ static bool
 rangeexpand_(ImageBuf& R, const ImageBuf& A, bool useluma, ROI roi,
              int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, [&](ROI roi) {
         const ImageSpec& Aspec(A.spec());
         int alpha_channel = Aspec.alpha_channel;
         int z_channel     = Aspec.z_channel;
@@ -796,11 +992,45 @@ ImageBufAlgo::rangeexpand(const ImageBuf& src, bool useluma, ROI roi,
 
 
 
+// Fast path for buffers of the same data type whose destination is in
+// memory: copy if needed, then run the shared premult kernel in place on
+// each scanline. Return false if the buffers don't qualify.
+static bool
+premult_local(ImageBuf& dst, const ImageBuf& src, bool divide,
+              bool preserve_alpha0, ROI roi, int nthreads)
+{
+    // The alpha is read from dst, so it must have been copied there too.
+    int alpha = src.spec().alpha_channel;
+    if (!dst.localpixels() || dst.deep()
+        || dst.spec().format != src.spec().format
+        || dst.nchannels() != src.nchannels()
+        || (&dst != &src && (alpha < roi.chbegin || alpha >= roi.chend)))
+        return false;
+    if (&dst != &src
+        && !ImageBufAlgo::paste(dst, roi.xbegin, roi.ybegin, roi.zbegin,
+                                roi.chbegin, src, roi, nthreads))
+        return false;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const ImageSpec& spec(src.spec());
+        for (int z = roi.zbegin; z < roi.zend; ++z)
+            for (int y = roi.ybegin; y < roi.yend; ++y)
+                pvt::premult_span(spec.format,
+                                  dst.pixeladdr(roi.xbegin, y, z),
+                                  roi.width(), spec.nchannels,
+                                  dst.pixel_stride(), roi.chbegin, roi.chend,
+                                  spec.alpha_channel, spec.z_channel, divide,
+                                  preserve_alpha0);
+    });
+    return true;
+}
+
+
+
 template<class Rtype, class Atype>
 static bool
 unpremult_(ImageBuf& R, const ImageBuf& A, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, [&](ROI roi) {
         int alpha_channel = A.spec().alpha_channel;
         int z_channel     = A.spec().z_channel;
         if (&R == &A) {
@@ -851,9 +1081,12 @@ ImageBufAlgo::unpremult(ImageBuf& dst, const ImageBuf& src, ROI roi,
                          roi.chbegin, src, roi, nthreads);
         return true;
     }
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "unpremult", unpremult_, dst.spec().format,
-                                src.spec().format, dst, src, roi, nthreads);
+    bool ok = premult_local(dst, src, true, false, roi, nthreads);
+    if (!ok) {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "unpremult", unpremult_,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, roi, nthreads);
+    }
     // Mark the output as having unassociated alpha
     dst.specmod().attribute("oiio:UnassociatedAlpha", 1);
     return ok;
@@ -878,7 +1111,7 @@ static bool
 premult_(ImageBuf& R, const ImageBuf& A, bool preserve_alpha0, ROI roi,
          int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, [&](ROI roi) {
         int alpha_channel = A.spec().alpha_channel;
         int z_channel     = A.spec().z_channel;
         if (&R == &A) {
@@ -926,10 +1159,12 @@ ImageBufAlgo::premult(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
                          roi.chbegin, src, roi, nthreads);
         return true;
     }
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "premult", premult_, dst.spec().format,
-                                src.spec().format, dst, src, false, roi,
-                                nthreads);
+    bool ok = premult_local(dst, src, false, false, roi, nthreads);
+    if (!ok) {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "premult", premult_, dst.spec().format,
+                                    src.spec().format, dst, src, false, roi,
+                                    nthreads);
+    }
     // Clear the output of any prior marking of associated alpha
     dst.specmod().erase_attribute("oiio:UnassociatedAlpha");
     return ok;
@@ -962,10 +1197,12 @@ ImageBufAlgo::repremult(ImageBuf& dst, const ImageBuf& src, ROI roi,
                          roi.chbegin, src, roi, nthreads);
         return true;
     }
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "repremult", premult_, dst.spec().format,
-                                src.spec().format, dst, src, true, roi,
-                                nthreads);
+    bool ok = premult_local(dst, src, false, true, roi, nthreads);
+    if (!ok) {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "repremult", premult_,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, true, roi, nthreads);
+    }
     // Clear the output of any prior marking of associated alpha
     dst.specmod().erase_attribute("oiio:UnassociatedAlpha");
     return ok;
@@ -1011,7 +1248,7 @@ contrast_remap_(ImageBuf& dst, const ImageBuf& src, cspan<float> black,
     bool use_sigmoid = !allspan(scontrast, 1.0f);
     bool do_minmax   = !(allspan(min, 0.0f) && allspan(max, 1.0f));
 
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI roi) {
         if (same_black_white) {
             // Special case -- black & white are the same value, which is
             // just a binary threshold.
@@ -1118,7 +1355,7 @@ static bool
 saturate_(ImageBuf& R, const ImageBuf& A, float scale, int firstchannel,
           ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, [&](ROI roi) {
         // Gross simplification: assume linear sRGB primaries. Ick -- but
         // what else to do if we don't really know the color space or its
         // characteristics?
@@ -1204,7 +1441,7 @@ static bool
 color_map_(ImageBuf& dst, const ImageBuf& src, int srcchannel, int nknots,
            int channels, cspan<float> knots, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &src, [&](ROI roi) {
         if (srcchannel < 0 && src.nchannels() < 3)
             srcchannel = 0;
         roi.chend = std::min(roi.chend, channels);
@@ -1422,14 +1659,60 @@ isfinite(half h)
 }
 
 
+// Bit pattern helpers for the fast nonfinite scan: a float of any size is
+// a NaN or Inf exactly when all of its exponent bits are set.
+template<typename T> struct NonFiniteBits {};
+template<> struct NonFiniteBits<float> {
+    typedef uint32_t type;
+    static constexpr type expmask = 0x7f800000;
+};
+template<> struct NonFiniteBits<half> {
+    typedef uint16_t type;
+    static constexpr type expmask = 0x7c00;
+};
+template<> struct NonFiniteBits<double> {
+    typedef uint64_t type;
+    static constexpr type expmask = 0x7ff0000000000000ULL;
+};
+
+
+// Are any of the n values starting at p a NaN or Inf? Only integer masks
+// and compares are used, in fixed-size runs without early exits, so that
+// the compiler can vectorize the inner loop.
+template<typename T>
+bool
+any_nonfinite(const T* p, size_t n)
+{
+    using Bits              = typename NonFiniteBits<T>::type;
+    constexpr Bits expmask  = NonFiniteBits<T>::expmask;
+    constexpr size_t runlen = 64;
+    const Bits* b           = reinterpret_cast<const Bits*>(p);
+    size_t i                = 0;
+    for (; i + runlen <= n; i += runlen) {
+        Bits hit = 0;
+        for (size_t j = 0; j < runlen; ++j)
+            hit |= Bits((b[i + j] & expmask) == expmask);
+        if (hit)
+            return true;
+    }
+    for (; i < n; ++i)
+        if ((b[i] & expmask) == expmask)
+            return true;
+    return false;
+}
+
+
+
 template<typename T>
 bool
 fixNonFinite_(ImageBuf& dst, ImageBufAlgo::NonFiniteFixMode mode,
               int* pixelsFixed, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        ROI dstroi = get_roi(dst.spec());
-        int count  = 0;  // Number of pixels with nonfinite values
+    // Check, and per the mode fix, the pixels of one region, returning the
+    // number of pixels that held a nonfinite value.
+    ROI dstroi = get_roi(dst.spec());
+    auto fix   = [&](ROI roi) -> int {
+        int count = 0;  // Number of pixels with nonfinite values
 
         if (mode == ImageBufAlgo::NONFINITE_NONE
             || mode == ImageBufAlgo::NONFINITE_ERROR) {
@@ -1489,6 +1772,28 @@ fixNonFinite_(ImageBuf& dst, ImageBufAlgo::NonFiniteFixMode mode,
                     ++count;
             }
         }
+        return count;
+    };
+
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        int count = 0;
+        if (dst.localpixels()
+            && dst.pixel_stride() == stride_t(dst.nchannels() * sizeof(T))) {
+            // Nearly all images have no NaN or Inf at all, so first scan
+            // each scanline span as a run of raw values, all channels at
+            // once, and only visit pixel by pixel the spans that need it.
+            size_t n = size_t(roi.width()) * dst.nchannels();
+            for (int z = roi.zbegin; z < roi.zend; ++z) {
+                for (int y = roi.ybegin; y < roi.yend; ++y) {
+                    const T* p = (const T*)dst.pixeladdr(roi.xbegin, y, z);
+                    if (any_nonfinite(p, n))
+                        count += fix(ROI(roi.xbegin, roi.xend, y, y + 1, z,
+                                         z + 1, roi.chbegin, roi.chend));
+                }
+            }
+        } else {
+            count = fix(roi);
+        }
 
         if (pixelsFixed) {
             // Update pixelsFixed atomically -- that's what makes this whole
@@ -1666,7 +1971,7 @@ over_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, bool zcomp,
                          ncolor_channels);
     bool has_z = (z_channel >= 0);
 
-    ImageBufAlgo::parallel_image(roi, nthreads, [=, &R, &A, &B](ROI roi) {
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, &B, [&](ROI roi) {
         ImageBuf::ConstIterator<Atype> a(A, roi);
         ImageBuf::ConstIterator<Btype> b(B, roi);
         ImageBuf::Iterator<Rtype> r(R, roi);
@@ -1708,34 +2013,55 @@ over_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, bool zcomp,
 
 
 
-// Special case -- 4 channel RGBA float, in-memory buffer, no wrapping.
-// Use loops and SIMD.
+// Special case -- 4 channel RGBA float or half, in-memory buffers, no
+// wrapping. Use loops and SIMD, two pixels at a time. Wherever both pixels
+// of A are opaque the result is just A, and wherever they are all zero it
+// is just B.
+template<typename T>
 static bool
-over_impl_rgbafloat(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
-                    int nthreads)
+over_impl_rgba(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
+               int nthreads)
 {
     using namespace simd;
     OIIO_DASSERT(A.localpixels() && B.localpixels()
-                 && A.spec().format == TypeFloat && A.nchannels() == 4
-                 && B.spec().format == TypeFloat && B.nchannels() == 4
-                 && A.spec().alpha_channel == 3 && A.spec().z_channel < 0
-                 && B.spec().alpha_channel == 3 && B.spec().z_channel < 0);
+                 && A.spec().format == BaseTypeFromC<T>::value
+                 && A.nchannels() == 4
+                 && B.spec().format == BaseTypeFromC<T>::value
+                 && B.nchannels() == 4 && A.spec().alpha_channel == 3
+                 && A.spec().z_channel < 0 && B.spec().alpha_channel == 3
+                 && B.spec().z_channel < 0);
     // const int nchannels = 4, alpha_channel = 3;
-    ImageBufAlgo::parallel_image(roi, nthreads, [=, &R, &A, &B](ROI roi) {
-        vfloat4 zero = vfloat4::Zero();
-        vfloat4 one  = vfloat4::One();
+    ImageBufAlgo::parallel_image(roi, nthreads, &A, &B, [&](ROI roi) {
+        vfloat8 zero = vfloat8::Zero();
+        vfloat8 one  = vfloat8::One();
         int w        = roi.width();
         for (int z = roi.zbegin; z < roi.zend; ++z) {
             for (int y = roi.ybegin; y < roi.yend; ++y) {
-                float* r       = (float*)R.pixeladdr(roi.xbegin, y, z);
-                const float* a = (const float*)A.pixeladdr(roi.xbegin, y, z);
-                const float* b = (const float*)B.pixeladdr(roi.xbegin, y, z);
-                for (int x = 0; x < w; ++x, r += 4, a += 4, b += 4) {
+                T* r       = (T*)R.pixeladdr(roi.xbegin, y, z);
+                const T* a = (const T*)A.pixeladdr(roi.xbegin, y, z);
+                const T* b = (const T*)B.pixeladdr(roi.xbegin, y, z);
+                int x      = 0;
+                for (; x + 2 <= w; x += 2, r += 8, a += 8, b += 8) {
+                    vfloat8 a_simd(a);
+                    vfloat8 alpha = shuffle<3, 3, 3, 3, 7, 7, 7, 7>(a_simd);
+                    if (all(alpha >= one)) {
+                        a_simd.store(r);
+                    } else if (none(a_simd != zero)) {
+                        vfloat8(b).store(r);
+                    } else {
+                        vfloat8 one_minus_alpha = one
+                                                  - clamp(alpha, zero, one);
+                        vfloat8 result = a_simd + one_minus_alpha * vfloat8(b);
+                        result.store(r);
+                    }
+                }
+                if (x < w) {
+                    // Odd pixel at the end of the scanline
                     vfloat4 a_simd(a);
                     vfloat4 b_simd(b);
-                    vfloat4 alpha           = shuffle<3>(a_simd);
-                    vfloat4 one_minus_alpha = one - clamp(alpha, zero, one);
-                    vfloat4 result          = a_simd + one_minus_alpha * b_simd;
+                    vfloat4 alpha = clamp(shuffle<3>(a_simd), vfloat4::Zero(),
+                                          vfloat4::One());
+                    vfloat4 result = a_simd + (vfloat4::One() - alpha) * b_simd;
                     result.store(r);
                 }
             }
@@ -1746,6 +2072,89 @@ over_impl_rgbafloat(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
 
 
 
+// Special case for zover -- float or half throughout, in-memory buffers,
+// alpha in channel 3 and z in a later channel. Skip the iterators and
+// composite the RGBA of each pixel with SIMD.
+template<typename T>
+static bool
+zover_impl_packed(ImageBuf& R, const ImageBuf& A, const ImageBuf& B,
+                  bool z_zeroisinf, ROI roi, int nthreads)
+{
+    using namespace simd;
+    const TypeDesc type = BaseTypeFromC<T>::value;
+    int nc = 0, alpha = 0, zc = 0, ncolors = 0;
+    decode_over_channels(R, nc, alpha, zc, ncolors);
+    if (R.spec().format != type || A.spec().format != type
+        || B.spec().format != type || alpha != 3 || zc < 4
+        || !ImageBufAlgo::scanline_spans_ok(roi, R, &A, &B))
+        return false;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        for (int z = roi.zbegin; z < roi.zend; ++z)
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                T* r       = (T*)R.pixeladdr(roi.xbegin, y, z);
+                const T* a = (const T*)A.pixeladdr(roi.xbegin, y, z);
+                const T* b = (const T*)B.pixeladdr(roi.xbegin, y, z);
+                for (int x = roi.xbegin; x < roi.xend;
+                     ++x, r += nc, a += nc, b += nc) {
+                    float az = a[zc], bz = b[zc];
+                    if (z_zeroisinf) {
+                        if (az == 0.0f)
+                            az = std::numeric_limits<float>::max();
+                        if (bz == 0.0f)
+                            bz = std::numeric_limits<float>::max();
+                    }
+                    const T* front = (az <= bz) ? a : b;
+                    const T* back  = (az <= bz) ? b : a;
+                    vfloat4 f(front), k(back);
+                    float falpha = clamp(float(front[3]), 0.0f, 1.0f);
+                    float one_minus_alpha = 1.0f - falpha;
+                    vfloat4 result        = f + vfloat4(one_minus_alpha) * k;
+                    result.store(r);
+                    for (int c = 4; c < nc; ++c)
+                        r[c] = T(float(front[c])
+                                 + one_minus_alpha * float(back[c]));
+                    r[zc] = (falpha != 0.0f) ? front[zc] : back[zc];
+                }
+            }
+    });
+    return true;
+}
+
+
+
+// Special case -- uint8 or uint16 throughout, in-memory buffers, no z
+// channel. Composite the code values directly in fixed point.
+template<typename T>
+static bool
+over_impl_unorm(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
+                int nthreads)
+{
+    const TypeDesc type = BaseTypeFromC<T>::value;
+    int nc = 0, alpha = 0, z = 0, ncolors = 0;
+    decode_over_channels(R, nc, alpha, z, ncolors);
+    if (R.spec().format != type || A.spec().format != type
+        || B.spec().format != type || z >= 0
+        || !ImageBufAlgo::scanline_spans_ok(roi, R, &A, &B))
+        return false;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        for (int z = roi.zbegin; z < roi.zend; ++z)
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                span<T> r  = R.scanline_span<T>(roi.xbegin, roi.xend, y, z);
+                cspan<T> a = A.scanline_span<T>(roi.xbegin, roi.xend, y, z);
+                cspan<T> b = B.scanline_span<T>(roi.xbegin, roi.xend, y, z);
+                for (size_t p = 0, n = r.size(); p < n; p += nc) {
+                    T a_alpha = a[p + alpha];
+                    for (int c = 0; c < nc; ++c)
+                        r[p + c] = ImageBufAlgo::unorm_over(a[p + c], a_alpha,
+                                                            b[p + c]);
+                }
+            }
+    });
+    return true;
+}
+
+
+
 bool
 ImageBufAlgo::over(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B, ROI roi,
                    int nthreads)
@@ -1754,20 +2163,33 @@ ImageBufAlgo::over(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B, ROI roi,
     if (!IBAprep(roi, &dst, &A, &B, NULL,
                  IBAprep_REQUIRE_ALPHA | IBAprep_REQUIRE_SAME_NCHANNELS))
         return false;
-
-    if (A.localpixels() && B.localpixels() && A.spec().format == TypeFloat
-        && A.nchannels() == 4 && B.spec().format == TypeFloat
-        && B.nchannels() == 4 && A.spec().alpha_channel == 3
-        && A.spec().z_channel < 0 && B.spec().alpha_channel == 3
-        && B.spec().z_channel < 0 && A.roi().contains(roi)
-        && B.roi().contains(roi) && roi.chbegin == 0 && roi.chend == 4) {
-        // Easy case -- both buffers are float, 4 channels, alpha is
-        // channel[3], no special z channel, and pixel data windows
+    if (ComputeBackend* backend = compute_backend())
+        if (backend->over(dst, A, B, roi, nthreads))
+            return true;
+
+    TypeDesc format = dst.spec().format;
+    if ((format == TypeFloat || format == TypeHalf) && A.localpixels()
+        && B.localpixels() && A.spec().format == format && A.nchannels() == 4
+        && B.spec().format == format && B.nchannels() == 4
+        && A.spec().alpha_channel == 3 && A.spec().z_channel < 0
+        && B.spec().alpha_channel == 3 && B.spec().z_channel < 0
+        && A.roi().contains(roi) && B.roi().contains(roi) && roi.chbegin == 0
+        && roi.chend == 4 && A.pixel_stride() == stride_t(4 * format.size())
+        && B.pixel_stride() == stride_t(4 * format.size())
+        && dst.pixel_stride() == stride_t(4 * format.size())) {
+        // Easy case -- all buffers are float (or all half), 4 channels,
+        // alpha is channel[3], no special z channel, and pixel data windows
         // completely cover the roi. This reduces to a simpler case we can
         // handle without iterators and taking advantage of SIMD.
-        return over_impl_rgbafloat(dst, A, B, roi, nthreads);
+        return format == TypeFloat
+                   ? over_impl_rgba<float>(dst, A, B, roi, nthreads)
+                   : over_impl_rgba<half>(dst, A, B, roi, nthreads);
     }
 
+    if (over_impl_unorm<uint8_t>(dst, A, B, roi, nthreads)
+        || over_impl_unorm<uint16_t>(dst, A, B, roi, nthreads))
+        return true;
+
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES3(ok, "over", over_impl, dst.spec().format,
                                 A.spec().format, B.spec().format, dst, A, B,
@@ -1789,6 +2211,116 @@ ImageBufAlgo::over(const ImageBuf& A, const ImageBuf& B, ROI roi, int nthreads)
 
 
 
+bool
+ImageBufAlgo::over(ImageBuf& dst, cspan<const ImageBuf*> layers, ROI roi,
+                   int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::over");
+    const size_t nlayers = layers.size();
+    if (!nlayers) {
+        dst.errorfmt("over() needs at least one layer");
+        return false;
+    }
+    if (nlayers == 2)
+        return over(dst, *layers[0], *layers[1], roi, nthreads);
+
+    // IBAprep only knows about three inputs, so check the rest here and
+    // size an uninitialized dst to cover all of them.
+    int prepflags = IBAprep_REQUIRE_ALPHA | IBAprep_REQUIRE_SAME_NCHANNELS;
+    for (const ImageBuf* L : layers) {
+        if (!L->initialized()) {
+            dst.errorfmt("Uninitialized input image");
+            return false;
+        }
+        if (L->deep()) {
+            dst.errorfmt("deep images not supported");
+            return false;
+        }
+        if (L->spec().alpha_channel < 0) {
+            dst.errorfmt("images must have alpha channels");
+            return false;
+        }
+        if (L->nchannels() != layers[0]->nchannels()) {
+            dst.errorfmt("images must have the same number of channels");
+            return false;
+        }
+        if (L->spec().format != layers[0]->spec().format)
+            prepflags |= IBAprep_DST_FLOAT_PIXELS;
+    }
+    if (!dst.initialized() && !roi.defined()) {
+        roi = layers[0]->roi();
+        for (const ImageBuf* L : layers)
+            roi = roi_union(roi, L->roi());
+    }
+    if (!IBAprep(roi, &dst, layers[0], nlayers > 1 ? layers[1] : nullptr,
+                 nlayers > 2 ? layers[2] : nullptr, nullptr, prepflags))
+        return false;
+
+    int nchannels = 0, alpha_channel = 0, z_channel = 0, ncolor_channels = 0;
+    decode_over_channels(dst, nchannels, alpha_channel, z_channel,
+                         ncolor_channels);
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        // Composite one scanline at a time, front to back, keeping the
+        // transmittance (the product of 1-alpha of the layers so far) of
+        // each pixel. Pixels stop taking more layers once it reaches zero,
+        // and the scanline stops once all its pixels have.
+        const int nc = nchannels, w = roi.width();
+        std::vector<float> result(size_t(w) * nc), layer(size_t(w) * nc);
+        std::vector<float> transmit(w);
+        std::vector<char> zfound(w);
+        for (int z = roi.zbegin; z < roi.zend; ++z)
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                std::fill(result.begin(), result.end(), 0.0f);
+                std::fill(transmit.begin(), transmit.end(), 1.0f);
+                std::fill(zfound.begin(), zfound.end(), 0);
+                ROI line(roi.xbegin, roi.xend, y, y + 1, z, z + 1, 0, nc);
+                int live = w;
+                for (size_t i = 0; i < nlayers && live; ++i) {
+                    layers[i]->get_pixels(line, TypeFloat, layer.data());
+                    for (int x = 0; x < w; ++x) {
+                        float t = transmit[x];
+                        if (t == 0.0f)
+                            continue;
+                        const float* l = &layer[size_t(x) * nc];
+                        float* r       = &result[size_t(x) * nc];
+                        for (int c = 0; c < nc; ++c)
+                            if (c != z_channel)
+                                r[c] += t * l[c];
+                        if (z_channel >= 0 && !zfound[x]) {
+                            // Depth comes from the frontmost layer with
+                            // nonzero alpha, as for nested over().
+                            r[z_channel] = l[z_channel];
+                            zfound[x]    = (l[alpha_channel] != 0.0f);
+                        }
+                        t *= 1.0f - clamp(l[alpha_channel], 0.0f, 1.0f);
+                        transmit[x] = t;
+                        if (t == 0.0f)
+                            --live;
+                    }
+                }
+                line.chbegin = roi.chbegin;
+                line.chend   = roi.chend;
+                dst.set_pixels(line, TypeFloat, result.data() + roi.chbegin,
+                               nc * sizeof(float));
+            }
+    });
+    return !dst.has_error();
+}
+
+
+
+ImageBuf
+ImageBufAlgo::over(cspan<const ImageBuf*> layers, ROI roi, int nthreads)
+{
+    ImageBuf result;
+    bool ok = over(result, layers, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::over() error");
+    return result;
+}
+
+
+
 bool
 ImageBufAlgo::zover(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
                     bool z_zeroisinf, ROI roi, int nthreads)
@@ -1798,6 +2330,9 @@ ImageBufAlgo::zover(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
                  IBAprep_REQUIRE_ALPHA | IBAprep_REQUIRE_Z
                      | IBAprep_REQUIRE_SAME_NCHANNELS))
         return false;
+    if (zover_impl_packed<float>(dst, A, B, z_zeroisinf, roi, nthreads)
+        || zover_impl_packed<half>(dst, A, B, z_zeroisinf, roi, nthreads))
+        return true;
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES3(ok, "zover", over_impl, dst.spec().format,
                                 A.spec().format, B.spec().format, dst, A, B,
@@ -3,9 +3,12 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
 #include <cstdio>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <sstream>
 #include <string>
 
 #include <OpenImageIO/platform.h>
@@ -18,9 +21,12 @@
 #    include <opencv2/opencv.hpp>
 #endif
 
+#include <OpenImageIO/Imath.h>
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/benchmark.h>
 #include <OpenImageIO/color.h>
+#include <OpenImageIO/deepdata.h>
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
@@ -368,6 +374,101 @@ test_paste()
 
 
 
+// paste between in-memory buffers is a strided copy, and a copy of whole
+// planes of the same format is a single memcpy per plane. Check those
+// against cut of the same region, and the edge cases that fall back to the
+// pixel-by-pixel paste.
+void
+test_paste_fast_path()
+{
+    std::cout << "test paste fast path\n";
+    const float gray[4] = { 0.1f, 0.2f, 0.3f, 0.4f };
+
+    // Converting the data format on the way
+    ImageBuf A(ImageSpec(37, 23, 4, TypeFloat));
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f);
+    ImageBuf B(ImageSpec(64, 48, 4, TypeHalf));
+    ImageBufAlgo::fill(B, gray);
+    OIIO_CHECK_ASSERT(ImageBufAlgo::paste(B, 5, 7, 0, 0, A));
+    auto comp = ImageBufAlgo::compare(ImageBufAlgo::cut(B, ROI(5, 42, 7, 30)),
+                                      A, 1e-3f, 1e-3f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    OIIO_CHECK_EQUAL(B.getchannel(4, 7, 0, 2), float(half(gray[2])));
+    OIIO_CHECK_EQUAL(B.getchannel(42, 29, 0, 0), float(half(gray[0])));
+
+    // Full-width scanlines of the same format, in a volume
+    ImageSpec Vspec(8, 8, 3, TypeFloat), Wspec(8, 8, 3, TypeFloat);
+    Vspec.depth = Vspec.full_depth = 4;
+    Wspec.depth = Wspec.full_depth = 6;
+    ImageBuf V(Vspec), W(Wspec);
+    ImageBufAlgo::noise(V, "uniform", 0.0f, 1.0f);
+    ImageBufAlgo::fill(W, gray);
+    OIIO_CHECK_ASSERT(ImageBufAlgo::paste(W, 0, 0, 1, 0, V));
+    comp = ImageBufAlgo::compare(ImageBufAlgo::cut(W, ROI(0, 8, 0, 8, 1, 5)),
+                                 V, 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    OIIO_CHECK_EQUAL(W.getchannel(3, 3, 0, 1), gray[1]);
+    OIIO_CHECK_EQUAL(W.getchannel(3, 3, 5, 1), gray[1]);
+
+    // Partly off the edge of dst: only the overlap is pasted
+    ImageBuf C(ImageSpec(64, 48, 4, TypeFloat));
+    ImageBufAlgo::fill(C, gray);
+    OIIO_CHECK_ASSERT(ImageBufAlgo::paste(C, 60, 45, 0, 0, A));
+    OIIO_CHECK_EQUAL(C.getchannel(63, 47, 0, 3), A.getchannel(3, 2, 0, 3));
+    OIIO_CHECK_EQUAL(C.getchannel(59, 47, 0, 3), gray[3]);
+
+    // Pasting just a region of the source
+    ImageBuf D(A);
+    OIIO_CHECK_ASSERT(ImageBufAlgo::paste(D, 0, 0, 0, 0, A,
+                                          ROI(10, 20, 10, 20)));
+    OIIO_CHECK_EQUAL(D.getchannel(0, 0, 0, 1), A.getchannel(10, 10, 0, 1));
+    OIIO_CHECK_EQUAL(D.getchannel(9, 9, 0, 2), A.getchannel(19, 19, 0, 2));
+}
+
+
+
+// transpose, rotate90 and rotate270 copy blocks of pixels at a time, with
+// a copier specialized for each pixel size. Check every one of them, on
+// images that are neither square nor a whole number of blocks.
+void
+test_transpose_rotate()
+{
+    std::cout << "test transpose, rotate90, rotate270\n";
+    const int w = 77, h = 131;
+    struct PixelType {
+        TypeDesc format;
+        int nchannels;
+    };
+    for (auto p : { PixelType { TypeUInt8, 1 }, PixelType { TypeUInt8, 2 },
+                    PixelType { TypeUInt8, 3 }, PixelType { TypeUInt8, 4 },
+                    PixelType { TypeFloat, 1 }, PixelType { TypeUInt16, 3 },
+                    PixelType { TypeUInt16, 4 }, PixelType { TypeFloat, 3 },
+                    PixelType { TypeFloat, 4 }, PixelType { TypeFloat, 5 } }) {
+        ImageBuf src(ImageSpec(w, h, p.nchannels, p.format));
+        ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f);
+        ImageBuf T    = ImageBufAlgo::transpose(src);
+        ImageBuf R90  = ImageBufAlgo::rotate90(src);
+        ImageBuf R270 = ImageBufAlgo::rotate270(src);
+        OIIO_CHECK_EQUAL(T.roi(), ROI(0, h, 0, w, 0, 1, 0, p.nchannels));
+        OIIO_CHECK_EQUAL(R90.roi(), T.roi());
+        OIIO_CHECK_EQUAL(R270.roi(), T.roi());
+        std::vector<float> a(p.nchannels), t(p.nchannels), r90(p.nchannels),
+            r270(p.nchannels);
+        int mismatches = 0;
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                src.getpixel(x, y, a.data());
+                T.getpixel(y, x, t.data());
+                R90.getpixel(h - 1 - y, x, r90.data());
+                R270.getpixel(y, w - 1 - x, r270.data());
+                mismatches += (t != a) + (r90 != a) + (r270 != a);
+            }
+        }
+        OIIO_CHECK_EQUAL(mismatches, 0);
+    }
+}
+
+
 void
 test_channel_append()
 {
@@ -391,6 +492,59 @@ test_channel_append()
 
 
 
+// Tests ImageBufAlgo::cryptomatte_extract and cryptomatte_id
+void
+test_cryptomatte_extract()
+{
+    std::cout << "test cryptomatte_extract\n";
+    // MurmurHash3_x86_32("hello", 0)
+    uint32_t hello = bitcast<uint32_t, float>(
+        ImageBufAlgo::cryptomatte_id("hello"));
+    OIIO_CHECK_EQUAL(hello, 0x248bfa47u);
+
+    float a = ImageBufAlgo::cryptomatte_id("a");
+    float b = ImageBufAlgo::cryptomatte_id("b");
+    float c = ImageBufAlgo::cryptomatte_id("c");
+    ImageSpec spec(4, 2, 8, TypeDesc::FLOAT);
+    spec.channelnames = { "R",
+                          "G",
+                          "B",
+                          "A",
+                          "CryptoObject00.R",
+                          "CryptoObject00.G",
+                          "CryptoObject00.B",
+                          "CryptoObject00.A" };
+    ImageBuf src(spec);
+    ImageBufAlgo::zero(src);
+    const float p0[8] = { 0, 0, 0, 0, a, 0.75f, b, 0.25f };
+    const float p1[8] = { 0, 0, 0, 0, b, 1.0f, 0, 0 };
+    src.setpixel(0, 0, p0);
+    src.setpixel(1, 0, p1);
+
+    ImageBuf R = ImageBufAlgo::cryptomatte_extract(src, "CryptoObject",
+                                                   { a, b, c });
+    OIIO_CHECK_ASSERT(!R.has_error());
+    OIIO_CHECK_EQUAL(R.nchannels(), 3);
+    OIIO_CHECK_EQUAL(R.getchannel(0, 0, 0, 0), 0.75f);
+    OIIO_CHECK_EQUAL(R.getchannel(0, 0, 0, 1), 0.25f);
+    OIIO_CHECK_EQUAL(R.getchannel(1, 0, 0, 1), 1.0f);
+    OIIO_CHECK_EQUAL(R.getchannel(1, 0, 0, 0), 0.0f);
+    OIIO_CHECK_EQUAL(R.getchannel(0, 0, 0, 2), 0.0f);
+    OIIO_CHECK_EQUAL(R.getchannel(3, 1, 0, 1), 0.0f);
+
+    // A single ID makes a one-channel alpha matte
+    ImageBuf M = ImageBufAlgo::cryptomatte_extract(src, "CryptoObject", b);
+    OIIO_CHECK_EQUAL(M.nchannels(), 1);
+    OIIO_CHECK_EQUAL(M.spec().channel_name(0), "A");
+    OIIO_CHECK_EQUAL(M.getchannel(0, 0, 0, 0), 0.25f);
+
+    ImageBuf E = ImageBufAlgo::cryptomatte_extract(src, "CryptoAsset", b);
+    OIIO_CHECK_ASSERT(E.has_error());
+    E.geterror();
+}
+
+
+
 // Tests ImageBufAlgo::add
 void
 test_add()
@@ -443,6 +597,50 @@ test_sub()
 
 
 
+// Tests ImageBufAlgo::for_each_scanline and the span fast paths of the
+// simple per-value operations
+void
+test_for_each_scanline()
+{
+    std::cout << "test for_each_scanline\n";
+
+    ImageBuf A(ImageSpec(64, 48, 3, TypeDesc::FLOAT));
+    bool ok = ImageBufAlgo::for_each_scanline<float>(
+        A, ROI(), [](span<float> row, int y, int /*z*/) {
+            for (size_t i = 0; i < row.size(); ++i)
+                row[i] = float(y) + 0.5f;
+        });
+    OIIO_CHECK_ASSERT(ok);
+    float pixel[3];
+    A.getpixel(63, 47, pixel);
+    OIIO_CHECK_EQUAL(pixel[2], 47.5f);
+
+    // Wrong type or non-local pixels are left to the caller
+    ImageBuf U(ImageSpec(8, 8, 3, TypeDesc::UINT8));
+    OIIO_CHECK_ASSERT(!ImageBufAlgo::for_each_scanline<float>(
+        U, ROI(), [](span<float>, int, int) {}));
+    OIIO_CHECK_ASSERT(U.scanline_span<float>(0, 8, 0).empty());
+    OIIO_CHECK_EQUAL(U.scanline_span<unsigned char>(2, 8, 0).size(),
+                     size_t(18));
+
+    // The span and iterator paths of add() agree, including for a
+    // channel subset, which can't use spans
+    const float Bval[] = { 0.25f, 0.5f, 0.75f };
+    ImageBuf Bh(ImageSpec(64, 48, 3, TypeDesc::HALF));
+    ImageBufAlgo::fill(Bh, Bval);
+    ImageBuf R = ImageBufAlgo::add(A, Bh);
+    ImageBuf S = ImageBufAlgo::add(A, Bval);
+    auto comp  = ImageBufAlgo::compare(R, S, 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.maxerror, 0.0f);
+    ImageBuf T = A;
+    ImageBufAlgo::add(T, A, Bval, ROI(0, 64, 0, 48, 0, 1, 1, 2));
+    T.getpixel(5, 7, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 7.5f);
+    OIIO_CHECK_EQUAL(pixel[1], 8.0f);
+}
+
+
+
 // Tests ImageBufAlgo::mul
 void
 test_mul()
@@ -470,6 +668,44 @@ test_mul()
 
 
 
+// Tests the uint8/uint16 fixed point and half batch paths of add, mul,
+// over, and invert against the same operations done in float
+void
+test_native_value_ops(TypeDesc type)
+{
+    std::cout << "test native value ops " << type << "\n";
+
+    ImageSpec spec(37, 19, 4, TypeDesc::FLOAT);
+    spec.alpha_channel = 3;
+    ImageBuf Af(spec), Bf(spec);
+    ImageBufAlgo::noise(Af, "uniform", 0.0f, 1.0f, false, 1);
+    ImageBufAlgo::noise(Bf, "uniform", 0.0f, 1.0f, false, 2);
+    ImageBuf A, B;
+    A.copy(Af, type);
+    B.copy(Bf, type);
+    Af.copy(A, TypeFloat);  // quantized, so both paths see the same values
+    Bf.copy(B, TypeFloat);
+
+    // One code value of slack: the float path can round uint16 products
+    // the other way, and half rounds each of its own results.
+    float tol = type == TypeHalf    ? 1.0e-3f
+                : type == TypeUInt8 ? 1.01f / 255.0f
+                                    : 1.01f / 65535.0f;
+    auto check = [&](const ImageBuf& R, const ImageBuf& Rf) {
+        OIIO_CHECK_EQUAL(R.spec().format, type);
+        ImageBuf Rq;
+        Rq.copy(Rf, type);
+        auto comp = ImageBufAlgo::compare(R, Rq, tol, tol);
+        OIIO_CHECK_EQUAL(comp.nfail, 0);
+    };
+    check(ImageBufAlgo::add(A, B), ImageBufAlgo::add(Af, Bf));
+    check(ImageBufAlgo::mul(A, B), ImageBufAlgo::mul(Af, Bf));
+    check(ImageBufAlgo::over(A, B), ImageBufAlgo::over(Af, Bf));
+    check(ImageBufAlgo::invert(A), ImageBufAlgo::invert(Af));
+}
+
+
+
 // Tests ImageBufAlgo::mad
 void
 test_mad()
@@ -507,6 +743,51 @@ test_mad()
 
 
 
+// Tests ImageBufAlgo::Expr
+void
+test_expr()
+{
+    std::cout << "test expr\n";
+    using ImageBufAlgo::Expr;
+    ImageSpec spec(64, 32, 3, TypeDesc::FLOAT);
+    ImageBuf A(spec);
+    for (ImageBuf::Iterator<float> p(A); !p.done(); ++p)
+        for (int c = 0; c < 3; ++c)
+            p[c] = (p.x() + 64 * p.y() + c) / 2048.0f;
+    ImageBuf B(spec);
+    const float Bval[3] = { 0.1f, -0.2f, 0.3f };
+    ImageBufAlgo::fill(B, Bval);
+
+    // The fused chain matches running the operations one at a time
+    Expr chain = (Expr(A) * 2.0f + B).clamp(0.0f, 1.0f).pow(2.0f).invert();
+    ImageBuf R = chain.eval();
+    ImageBuf S = ImageBufAlgo::invert(ImageBufAlgo::pow(
+        ImageBufAlgo::clamp(ImageBufAlgo::add(ImageBufAlgo::mul(A, 2.0f), B),
+                            0.0f, 1.0f),
+        2.0f));
+    OIIO_CHECK_ASSERT(!R.has_error());
+    OIIO_CHECK_EQUAL(R.roi(), A.roi());
+    auto comp = ImageBufAlgo::compare(R, S, 1e-6f, 1e-6f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // mad, sub, and an existing uint8 destination
+    ImageBuf D(ImageSpec(64, 32, 3, TypeDesc::UINT8));
+    OIIO_CHECK_ASSERT(Expr::mad(A, B, 0.5f).eval(D));
+    ImageBuf M = ImageBufAlgo::mad(A, B, 0.5f);
+    comp       = ImageBufAlgo::compare(D, M, 1.0f / 255.0f, 1.0f / 255.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    ImageBuf Z = (Expr(A) - A).eval(ROI(10, 20, 5, 6));
+    OIIO_CHECK_EQUAL(Z.roi(), ROI(10, 20, 5, 6, 0, 1, 0, 3));
+    OIIO_CHECK_EQUAL(Z.getchannel(15, 5, 0, 1), 0.0f);
+
+    // Constants alone give no region to evaluate over
+    ImageBuf E = (Expr(1.0f) + 2.0f).eval();
+    OIIO_CHECK_ASSERT(E.has_error());
+    E.geterror();
+}
+
+
+
 // Tests ImageBufAlgo::min
 void
 test_min()
@@ -602,6 +883,39 @@ test_over(TypeDesc dtype = TypeFloat)
 
 
 
+// Test the N-layer ImageBufAlgo::over against nested two-layer over
+void
+test_over_layers()
+{
+    std::cout << "test over layers\n";
+
+    ImageSpec spec(23, 17, 4, TypeFloat);
+    ImageBuf L[4];
+    for (int i = 0; i < 4; ++i) {
+        L[i].reset(spec);
+        ImageBufAlgo::noise(L[i], "uniform", 0.0f, 1.0f, false, i + 1);
+    }
+    // Make part of the front layer opaque and part of it empty, and shift
+    // the back layer so that the layers don't all cover the same pixels.
+    ImageBufAlgo::fill(L[0], { 0.25f, 0.5f, 0.75f, 1.0f }, ROI(0, 8, 0, 17));
+    ImageBufAlgo::zero(L[0], ROI(8, 12, 0, 17));
+    L[3].set_origin(5, 3);
+
+    ImageBuf nested = ImageBufAlgo::over(
+        L[0], ImageBufAlgo::over(L[1], ImageBufAlgo::over(L[2], L[3])));
+    ImageBuf R = ImageBufAlgo::over({ &L[0], &L[1], &L[2], &L[3] });
+    OIIO_CHECK_EQUAL(R.roi(), nested.roi());
+    auto comp = ImageBufAlgo::compare(R, nested, 1.0e-6f, 1.0e-6f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // Mismatched channel counts are an error
+    ImageBuf rgb(ImageSpec(23, 17, 3, TypeFloat));
+    ImageBuf bad = ImageBufAlgo::over({ &L[0], &L[1], &rgb });
+    OIIO_CHECK_ASSERT(bad.has_error());
+}
+
+
+
 // Test ImageBuf::zover
 void
 test_zover()
@@ -637,6 +951,103 @@ test_zover()
 
 
 
+// Test DeepData channel spans and ImageBufAlgo::flatten
+void
+test_deep_flatten()
+{
+    std::cout << "test deep flatten\n";
+
+    ImageSpec spec(2, 2, 5, TypeFloat);
+    spec.channelnames.assign({ "R", "G", "B", "A", "Z" });
+    spec.z_channel = 4;
+    spec.deep      = true;
+    ImageBuf D(spec);
+    // Pixel (0,0): half-transparent red in front of opaque red.
+    // Pixel (1,0): one faint sample. The bottom row stays empty.
+    D.set_deep_samples(0, 0, 0, 2);
+    D.set_deep_samples(1, 0, 0, 1);
+    const float samps[3][5] = { { 0.5f, 0.0f, 0.0f, 0.5f, 1.0f },
+                                { 1.0f, 0.0f, 0.0f, 1.0f, 2.0f },
+                                { 0.25f, 0.0f, 0.0f, 0.25f, 3.0f } };
+    for (int c = 0; c < 5; ++c) {
+        D.set_deep_value(0, 0, 0, c, 0, samps[0][c]);
+        D.set_deep_value(0, 0, 0, c, 1, samps[1][c]);
+        D.set_deep_value(1, 0, 0, c, 0, samps[2][c]);
+    }
+
+    DeepData* dd = D.deepdata();
+    OIIO_CHECK_EQUAL(dd->total_samples(), 3);
+    OIIO_CHECK_EQUAL(dd->total_samples(1, 2), 1);
+    float R[3];
+    OIIO_CHECK_ASSERT(dd->get_channel_values(0, R));
+    OIIO_CHECK_EQUAL(R[0], 0.5f);
+    OIIO_CHECK_EQUAL(R[1], 1.0f);
+    OIIO_CHECK_EQUAL(R[2], 0.25f);
+    OIIO_CHECK_ASSERT(!dd->get_channel_values(0, span<float>(R, 2)));
+    float Z[1] = { 4.0f };
+    OIIO_CHECK_ASSERT(dd->set_channel_values(4, Z, 1, 2));
+    OIIO_CHECK_EQUAL(D.deep_value(1, 0, 0, 4, 0), 4.0f);
+    OIIO_CHECK_EQUAL(D.deep_value(0, 0, 0, 4, 1), 2.0f);
+
+    ImageBuf F = ImageBufAlgo::flatten(D);
+    OIIO_CHECK_ASSERT(!F.has_error());
+    OIIO_CHECK_EQUAL(F.getchannel(0, 0, 0, 0), 1.0f);
+    OIIO_CHECK_EQUAL(F.getchannel(0, 0, 0, 3), 1.0f);
+    OIIO_CHECK_EQUAL(F.getchannel(1, 0, 0, 0), 0.25f);
+    OIIO_CHECK_EQUAL(F.getchannel(1, 0, 0, 3), 0.25f);
+    OIIO_CHECK_EQUAL(F.getchannel(0, 1, 0, 0), 0.0f);
+    OIIO_CHECK_EQUAL(F.getchannel(0, 1, 0, 4), 1.0e30f);
+}
+
+
+
+// Test ImageBufAlgo::deep_merge and deep_holdout
+void
+test_deep_merge()
+{
+    std::cout << "test deep merge\n";
+
+    ImageSpec spec(3, 2, 6, TypeFloat);
+    spec.channelnames.assign({ "R", "G", "B", "A", "Z", "Zback" });
+    spec.z_channel = 4;
+    spec.deep      = true;
+    auto make = [&](float zf, float zb, float a) {
+        ImageBuf D(spec);
+        for (int y = 0; y < 2; ++y)
+            for (int x = 0; x < 3; ++x) {
+                D.set_deep_samples(x, y, 0, 1);
+                const float v[6] = { a, a, a, a, zf, zb };
+                for (int c = 0; c < 6; ++c)
+                    D.set_deep_value(x, y, 0, c, 0, v[c]);
+            }
+        return D;
+    };
+    // B is in front of A, and their depth ranges overlap over [2,3].
+    ImageBuf A = make(2.0f, 4.0f, 0.5f);
+    ImageBuf B = make(1.0f, 3.0f, 0.5f);
+    ImageBuf M = ImageBufAlgo::deep_merge(A, B, false);
+    OIIO_CHECK_ASSERT(!M.has_error());
+    for (int y = 0; y < 2; ++y)
+        for (int x = 0; x < 3; ++x) {
+            // Split into [1,2], [2,3] (merged from both), [3,4]
+            OIIO_CHECK_EQUAL(M.deep_samples(x, y, 0), 3);
+            OIIO_CHECK_EQUAL(M.deep_value(x, y, 0, 4, 0), 1.0f);
+            OIIO_CHECK_EQUAL(M.deep_value(x, y, 0, 4, 1), 2.0f);
+            OIIO_CHECK_EQUAL(M.deep_value(x, y, 0, 5, 1), 3.0f);
+            OIIO_CHECK_EQUAL(M.deep_value(x, y, 0, 5, 2), 4.0f);
+        }
+
+    // Hold A out by an opaque surface at depth 3: [2,4] is split at 3.
+    ImageBuf T = make(3.0f, 3.0f, 1.0f);
+    ImageBuf H = ImageBufAlgo::deep_holdout(A, T);
+    OIIO_CHECK_ASSERT(!H.has_error());
+    OIIO_CHECK_EQUAL(H.deep_samples(1, 1, 0), 1);
+    OIIO_CHECK_EQUAL(H.deep_value(1, 1, 0, 4, 0), 2.0f);
+    OIIO_CHECK_EQUAL(H.deep_value(1, 1, 0, 5, 0), 3.0f);
+}
+
+
+
 // Tests ImageBufAlgo::compare
 void
 test_compare()
@@ -705,6 +1116,33 @@ test_compare()
     OIIO_CHECK_EQUAL(comp.maxx, 9);
     OIIO_CHECK_EQUAL(comp.maxy, 0);
     OIIO_CHECK_EQUAL_THRESH(comp.meanerror, 0.0045f, 1.0e-8f);
+
+    // Stopping after 2 failures
+    comp = ImageBufAlgo::compare(A, B, failthresh, warnthresh, 0.0f, 0.0f, 2,
+                                 false);
+    OIIO_CHECK_EQUAL(comp.nfail, 2);
+    OIIO_CHECK_EQUAL_THRESH(comp.maxerror, 0.06f, 1e-6f);
+
+    // Skipping identical bands gives the same answer when only a few
+    // scanlines of a taller image differ.
+    ImageBuf C(ImageSpec(64, 300, 3, TypeDesc::UINT16));
+    ImageBufAlgo::noise(C, "uniform", 0.0f, 1.0f);
+    ImageBuf D = C.copy(TypeUnknown);
+    D.setpixel(5, 170, cspan<float>({ 0.0f, 0.25f, 1.0f }));
+    D.setpixel(60, 290, cspan<float>({ 0.5f, 0.5f, 0.5f }));
+    auto full  = ImageBufAlgo::compare(C, D, 1e-6f, 1e-6f);
+    auto quick = ImageBufAlgo::compare(C, D, 1e-6f, 1e-6f, 0.0f, 0.0f, 0,
+                                       true);
+    OIIO_CHECK_EQUAL(quick.nfail, full.nfail);
+    OIIO_CHECK_EQUAL(quick.nwarn, full.nwarn);
+    OIIO_CHECK_EQUAL(quick.maxerror, full.maxerror);
+    OIIO_CHECK_EQUAL(quick.maxx, full.maxx);
+    OIIO_CHECK_EQUAL(quick.maxy, full.maxy);
+    OIIO_CHECK_EQUAL_THRESH(quick.meanerror, full.meanerror, 1e-12);
+    quick = ImageBufAlgo::compare(C, C.copy(TypeUnknown), 1e-6f, 1e-6f, 0.0f,
+                                  0.0f, 1, true);
+    OIIO_CHECK_EQUAL(quick.nfail, 0);
+    OIIO_CHECK_EQUAL(quick.maxerror, 0.0);
 }
 
 
@@ -738,6 +1176,18 @@ test_isConstantColor()
     // Make sure ROI works
     ROI roi(0, WIDTH, 0, 2, 0, 1, 0, CHANNELS);  // should match for this ROI
     OIIO_CHECK_EQUAL(ImageBufAlgo::isConstantColor(A, 0.0f, {}, roi), true);
+    // ... including a channel subset that skips the changed channel
+    OIIO_CHECK_EQUAL(ImageBufAlgo::isConstantColor(A, 0.0f, {},
+                                                   ROI(0, WIDTH, 0, HEIGHT, 0,
+                                                       1, 2, 3)),
+                     true);
+
+    // Values that are equal but differ in bits still count as constant
+    ImageBuf Z(spec);
+    ImageBufAlgo::zero(Z);
+    const float negzero[CHANNELS] = { -0.0f, 0.0f, -0.0f };
+    Z.setpixel(7, 8, 0, negzero, 3);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::isConstantColor(Z), true);
 }
 
 
@@ -825,6 +1275,181 @@ test_computePixelStats()
         OIIO_CHECK_EQUAL(stats.infcount[c], 0);
         OIIO_CHECK_EQUAL(stats.finitecount[c], 4);
     }
+
+    // A wide image, with NaN and Inf on some scanlines, agrees when its
+    // stats are merged from two halves
+    ImageBuf big(ImageSpec(203, 64, 3, TypeDesc::HALF));
+    ImageBufAlgo::noise(big, "uniform", -1.0f, 1.0f);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    big.setpixel(7, 3, cspan<float>({ nan, inf, 0.5f }));
+    big.setpixel(100, 40, cspan<float>({ -inf, 0.25f, nan }));
+    auto whole = ImageBufAlgo::computePixelStats(big);
+    OIIO_CHECK_EQUAL(whole.nancount[0], 1);
+    OIIO_CHECK_EQUAL(whole.infcount[1], 1);
+    OIIO_CHECK_EQUAL(whole.finitecount[2], imagesize_t(203 * 64 - 1));
+    ImageBufAlgo::PixelStats merged;
+    merged.merge(ImageBufAlgo::computePixelStats(big, ROI(0, 203, 0, 20)));
+    merged.merge(ImageBufAlgo::computePixelStats(big, ROI(0, 203, 20, 64)));
+    for (int c = 0; c < 3; ++c) {
+        OIIO_CHECK_EQUAL(merged.min[c], whole.min[c]);
+        OIIO_CHECK_EQUAL(merged.max[c], whole.max[c]);
+        OIIO_CHECK_EQUAL_THRESH(merged.avg[c], whole.avg[c], 1e-6f);
+        OIIO_CHECK_EQUAL_THRESH(merged.stddev[c], whole.stddev[c], 1e-6f);
+        OIIO_CHECK_EQUAL(merged.nancount[c], whole.nancount[c]);
+        OIIO_CHECK_EQUAL(merged.infcount[c], whole.infcount[c]);
+        OIIO_CHECK_EQUAL(merged.finitecount[c], whole.finitecount[c]);
+    }
+}
+
+
+
+// Tests ImageBufAlgo::fixNonFinite(), with the nonfinite values on a few
+// scanlines, both within the first full runs of the raw-value scan and in
+// its tail.
+void
+test_fixNonFinite(TypeDesc format)
+{
+    std::cout << "test fixNonFinite " << format << "\n";
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    ImageBuf img(ImageSpec(100, 20, 3, format));
+    ImageBufAlgo::fill(img, { 0.5f, 0.5f, 0.5f });
+    img.setpixel(10, 3, cspan<float>({ 0.5f, nan, 0.5f }));
+    img.setpixel(99, 3, cspan<float>({ 0.5f, 0.5f, inf }));
+    img.setpixel(50, 12, cspan<float>({ -inf, nan, 0.5f }));
+
+    // Counting leaves the pixels alone
+    int nfixed = -1;
+    ImageBuf counted(img);
+    OIIO_CHECK_ASSERT(ImageBufAlgo::fixNonFinite(counted, counted,
+                                                 ImageBufAlgo::NONFINITE_NONE,
+                                                 &nfixed));
+    OIIO_CHECK_EQUAL(nfixed, 3);
+    OIIO_CHECK_ASSERT(std::isnan(counted.getchannel(10, 3, 0, 1)));
+
+    // Only the pixels within the ROI are counted
+    ImageBufAlgo::fixNonFinite(counted, counted, ImageBufAlgo::NONFINITE_NONE,
+                               &nfixed, ROI(0, 60, 0, 20));
+    OIIO_CHECK_EQUAL(nfixed, 2);
+
+    // A clean image is found clean
+    ImageBuf clean(img.spec());
+    ImageBufAlgo::fill(clean, { 0.5f, 0.5f, 0.5f });
+    ImageBufAlgo::fixNonFinite(clean, clean, ImageBufAlgo::NONFINITE_NONE,
+                               &nfixed);
+    OIIO_CHECK_EQUAL(nfixed, 0);
+
+    // Black and box3 repair every nonfinite value and nothing else
+    ImageBuf black = ImageBufAlgo::fixNonFinite(img,
+                                                ImageBufAlgo::NONFINITE_BLACK,
+                                                &nfixed);
+    OIIO_CHECK_EQUAL(nfixed, 3);
+    OIIO_CHECK_EQUAL(black.getchannel(10, 3, 0, 1), 0.0f);
+    OIIO_CHECK_EQUAL(black.getchannel(99, 3, 0, 2), 0.0f);
+    OIIO_CHECK_EQUAL(black.getchannel(50, 12, 0, 0), 0.0f);
+    OIIO_CHECK_EQUAL(black.getchannel(50, 12, 0, 2), 0.5f);
+    ImageBuf box3 = ImageBufAlgo::fixNonFinite(img,
+                                               ImageBufAlgo::NONFINITE_BOX3,
+                                               &nfixed);
+    OIIO_CHECK_EQUAL(nfixed, 3);
+    auto comp = ImageBufAlgo::compare(box3, clean, 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // Asking for an error finds them but changes nothing
+    ImageBuf err;
+    OIIO_CHECK_ASSERT(!ImageBufAlgo::fixNonFinite(
+        err, img, ImageBufAlgo::NONFINITE_ERROR, &nfixed));
+    OIIO_CHECK_EQUAL(nfixed, 3);
+    OIIO_CHECK_ASSERT(std::isnan(err.getchannel(10, 3, 0, 1)));
+    OIIO_CHECK_ASSERT(err.has_error());
+    err.geterror();
+
+    // A buffer with padded pixels goes pixel by pixel, with the same result
+    if (format == TypeFloat) {
+        std::vector<float> padded(100 * 20 * 4, 0.5f);
+        padded[(3 * 100 + 10) * 4 + 1]  = nan;
+        padded[(3 * 100 + 99) * 4 + 2]  = inf;
+        padded[(12 * 100 + 50) * 4 + 0] = -inf;
+        ImageBuf wrapped(ImageSpec(100, 20, 3, TypeFloat), padded.data(),
+                         4 * sizeof(float));
+        ImageBufAlgo::fixNonFinite(wrapped, wrapped,
+                                   ImageBufAlgo::NONFINITE_BLACK, &nfixed);
+        OIIO_CHECK_EQUAL(nfixed, 3);
+        OIIO_CHECK_EQUAL(padded[(3 * 100 + 10) * 4 + 1], 0.0f);
+        OIIO_CHECK_EQUAL(padded[(12 * 100 + 50) * 4 + 0], 0.0f);
+    }
+}
+
+
+
+void
+test_computePixelHash()
+{
+    std::cout << "test computePixelHash\n";
+    ImageBuf img(ImageSpec(211, 150, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::noise(img, "uniform", 0.0f, 1.0f);
+    std::string h = ImageBufAlgo::computePixelHash(img, "xxhash");
+    OIIO_CHECK_EQUAL(h.size(), size_t(16));
+
+    // Independent of the thread count
+    OIIO_CHECK_EQUAL(ImageBufAlgo::computePixelHash(img, "xxhash", "", {}, 1),
+                     h);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::computePixelHash(img, "xxh64", "", {}, 7),
+                     h);
+
+    // Independent of the memory layout: wrap a copy with padded pixels
+    std::vector<float> padded(size_t(211) * 150 * 4);
+    img.get_pixels(img.roi(), TypeFloat, padded.data(), 4 * sizeof(float));
+    ImageBuf wrapped(img.spec(), padded.data(), 4 * sizeof(float));
+    OIIO_CHECK_EQUAL(ImageBufAlgo::computePixelHash(wrapped), h);
+
+    // Sensitive to pixel values and extra info
+    OIIO_CHECK_NE(ImageBufAlgo::computePixelHash(img, "xxhash", "extra"), h);
+    padded[4 * (211 * 100 + 17) + 1] += 0.5f;
+    OIIO_CHECK_NE(ImageBufAlgo::computePixelHash(wrapped), h);
+
+    // "sha1" is the same as computePixelHashSHA1
+    OIIO_CHECK_EQUAL(ImageBufAlgo::computePixelHash(img, "sha1"),
+                     ImageBufAlgo::computePixelHashSHA1(img));
+
+    // Unknown hash types are an error
+    OIIO_CHECK_EQUAL(ImageBufAlgo::computePixelHash(img, "bogus"), "");
+    OIIO_CHECK_ASSERT(img.has_error());
+    img.geterror();
+}
+
+
+
+void
+test_noise()
+{
+    std::cout << "test noise\n";
+    // The noise is a pure function of pixel position, channel and seed,
+    // so it shouldn't matter how the image is split up: region edges
+    // that aren't a multiple of the SIMD width move pixels between the
+    // vectorized and scalar code paths.
+    ImageSpec spec(37, 29, 3, TypeDesc::FLOAT);
+    for (auto type : { "uniform", "gaussian", "salt" }) {
+        for (bool mono : { false, true }) {
+            ImageBuf whole(spec), split(spec);
+            ImageBufAlgo::zero(whole);
+            ImageBufAlgo::zero(split);
+            ImageBufAlgo::noise(whole, type, 0.25f, 0.5f, mono, 42, {}, 1);
+            ImageBufAlgo::noise(split, type, 0.25f, 0.5f, mono, 42,
+                                ROI(0, 13, 0, 29, 0, 1, 0, 3), 1);
+            ImageBufAlgo::noise(split, type, 0.25f, 0.5f, mono, 42,
+                                ROI(13, 37, 0, 29, 0, 1, 0, 3), 4);
+            auto comp = ImageBufAlgo::compare(whole, split, 0.0f, 0.0f);
+            OIIO_CHECK_EQUAL(comp.maxerror, 0.0);
+            if (mono) {
+                float p[3];
+                whole.getpixel(21, 17, p);
+                OIIO_CHECK_EQUAL(p[0], p[1]);
+                OIIO_CHECK_EQUAL(p[0], p[2]);
+            }
+        }
+    }
 }
 
 
@@ -878,6 +1503,34 @@ histogram_computation_test()
 
 
 
+// Multi-channel histograms must match the single channel ones, for the
+// float path as well as the 8 and 16 bit integer paths.
+void
+test_histograms(TypeDesc format)
+{
+    std::cout << "test histograms " << format << "\n";
+    ImageBuf A(ImageSpec(97, 61, 3, format));
+    ImageBufAlgo::noise(A, "uniform", -0.1f, 1.1f);
+    ImageBufAlgo::zero(A, ROI(0, 10, 0, 10));
+    for (bool ignore_empty : { false, true }) {
+        auto hists = ImageBufAlgo::histograms(A, 37, 0.0f, 1.0f, ignore_empty);
+        OIIO_CHECK_EQUAL(hists.size(), size_t(3));
+        for (int c = 0; c < 3 && c < int(hists.size()); ++c) {
+            auto h = ImageBufAlgo::histogram(A, c, 37, 0.0f, 1.0f,
+                                             ignore_empty);
+            OIIO_CHECK_ASSERT(hists[c] == h);
+        }
+    }
+    // Channel subset
+    auto hists = ImageBufAlgo::histograms(A, 16, 0.0f, 1.0f, false,
+                                          ROI(0, 97, 0, 61, 0, 1, 1, 3));
+    OIIO_CHECK_EQUAL(hists.size(), size_t(2));
+    if (hists.size() == 2)
+        OIIO_CHECK_ASSERT(hists[1] == ImageBufAlgo::histogram(A, 2, 16));
+}
+
+
+
 // Test ability to do a maketx directly from an ImageBuf
 void
 test_maketx_from_imagebuf()
@@ -908,6 +1561,511 @@ test_maketx_from_imagebuf()
 
 
 
+// Streaming MIP generation must give the same levels as the in-memory
+// path, whether the next level is kept in memory or spooled to a
+// temporary file (a read_local_MB of 0 spools every level).
+void
+test_maketx_stream()
+{
+    std::cout << "test make_texture streaming\n";
+    ImageBuf A(ImageSpec(256, 128, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f);
+
+    ImageSpec configspec;
+    configspec.tile_width  = 16;
+    configspec.tile_height = 16;
+    configspec.attribute("maketx:filtername", "box");
+    const char* refname = "oiio-stream-ref.exr";
+    OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture,
+                                                 A, refname, configspec));
+    for (int local_mb : { 1024, 0 }) {
+        const char* name = "oiio-stream.exr";
+        ImageSpec config = configspec;
+        config.attribute("maketx:stream", 1);
+        config.attribute("maketx:read_local_MB", local_mb);
+        OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(
+            ImageBufAlgo::MakeTxTexture, A, name, config));
+        for (int m = 0; m < 9; ++m) {
+            ImageBuf ref(refname, 0, m), level(name, 0, m);
+            OIIO_CHECK_EQUAL(level.spec().width, 256 >> m);
+            OIIO_CHECK_EQUAL(level.spec().tile_width, 16);
+            auto comp = ImageBufAlgo::compare(level, ref, 1.0e-6f, 1.0e-6f);
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+        }
+        // No temporary level files are left behind
+        std::vector<std::string> files;
+        Filesystem::get_directory_entries(".", files);
+        for (auto& f : files)
+            OIIO_CHECK_ASSERT(!Strutil::ends_with(f, ".mip.exr"));
+        remove(name);
+    }
+    remove(refname);
+}
+
+
+
+// An untiled input too big to read locally (here, any input, with a
+// read_local_MB of 0) is read through a private autotiling cache, with
+// or without streaming, and must give the same texture as a local read.
+void
+test_maketx_autotile_input()
+{
+    std::cout << "test make_texture untiled input through autotiling cache\n";
+    ImageBuf A(ImageSpec(256, 128, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f);
+    const char* srcname = "oiio-autotile-src.tif";
+    A.write(srcname);
+
+    ImageSpec configspec;
+    configspec.tile_width  = 16;
+    configspec.tile_height = 16;
+    const char* refname    = "oiio-autotile-ref.exr";
+    OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture,
+                                                 srcname, refname,
+                                                 configspec));
+    for (int stream : { 0, 1 }) {
+        const char* name = "oiio-autotile.exr";
+        ImageSpec config = configspec;
+        config.attribute("maketx:read_local_MB", 0);
+        config.attribute("maketx:stream", stream);
+        config.attribute("maketx:verbose", 1);
+        std::ostringstream log;
+        OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(
+            ImageBufAlgo::MakeTxTexture, srcname, name, config, &log));
+        OIIO_CHECK_ASSERT(Strutil::contains(log.str(),
+                                            "Reading untiled input in 64x64"));
+        for (int m = 0; m < 9; ++m) {
+            ImageBuf ref(refname, 0, m), level(name, 0, m);
+            OIIO_CHECK_EQUAL(level.spec().width, 256 >> m);
+            auto comp = ImageBufAlgo::compare(level, ref, 1.0e-6f, 1.0e-6f);
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+        }
+        remove(name);
+    }
+    remove(refname);
+    remove(srcname);
+}
+
+
+
+// Bump slopes of a height map must match a 3x3 Sobel filter evaluated
+// pixel by pixel with clamped edges, and those of a normal map must come
+// straight from each normal.
+void
+test_maketx_bumpslopes()
+{
+    std::cout << "test make_texture bump slopes\n";
+    const char* name = "oiio-bumpslopes.exr";
+    const int w = 48, h = 40;
+    for (bool normal : { false, true }) {
+        ImageBuf src(ImageSpec(w, h, normal ? 3 : 1, TypeDesc::FLOAT));
+        ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f);
+        if (normal)
+            ImageBufAlgo::fill(src, { 0.0f, 0.0f, 1.0f },
+                               ROI(0, w, 0, h, 0, 1, 2, 3));
+        ImageSpec configspec;
+        configspec.attribute("maketx:bumpformat", normal ? "normal" : "height");
+        OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(
+            ImageBufAlgo::MakeTxBumpWithSlopes, src, name, configspec));
+        ImageBuf tex(name);
+        OIIO_CHECK_EQUAL(tex.nchannels(), 6);
+        int nwrong = 0;
+        for (ImageBuf::ConstIterator<float> t(tex); !t.done(); ++t) {
+            float height = -1.0f, ds = 0.0f, dt = 0.0f;
+            if (normal) {
+                float n[3];
+                src.getpixel(t.x(), t.y(), n, 3);
+                ds = -n[0] / n[2];
+                dt = -n[1] / n[2];
+            } else {
+                static const float wds[9] = { -1, 0, 1, -2, 0, 2, -1, 0, 1 };
+                static const float wdt[9] = { -1, -2, -1, 0, 0, 0, 1, 2, 1 };
+                ImageBuf::ConstIterator<float> s(src, t.x() - 1, t.x() + 2,
+                                                 t.y() - 1, t.y() + 2, 0, 1,
+                                                 ImageBuf::WrapClamp);
+                for (int i = 0; !s.done(); ++s, ++i) {
+                    ds += wds[i] * s[0];
+                    dt += wdt[i] * s[0];
+                }
+                height = src.getchannel(t.x(), t.y(), 0, 0);
+                ds /= 8.0f;
+                dt /= 8.0f;
+            }
+            const float want[6] = { height, ds, dt, ds * ds, dt * dt, ds * dt };
+            for (int c = 0; c < 6; ++c)
+                nwrong += std::abs(t[c] - want[c]) > 1.0e-5f;
+        }
+        OIIO_CHECK_EQUAL(nwrong, 0);
+    }
+    remove(name);
+}
+
+
+
+// Autotuning must record its choice, write the texture with the chosen
+// tile size and compression, and (for "size") never choose to leave a
+// smooth image uncompressed.
+void
+test_maketx_autotune()
+{
+    std::cout << "test make_texture autotune\n";
+    ImageBuf A(ImageSpec(512, 512, 3, TypeDesc::HALF));
+    ImageBufAlgo::fill(A, { 0.1f, 0.2f, 0.3f }, { 0.9f, 0.2f, 0.3f },
+                       { 0.1f, 0.8f, 0.3f }, { 0.9f, 0.8f, 0.7f });
+    const char* name = "oiio-autotune.exr";
+    for (const char* objective : { "size", "speed", "balanced" }) {
+        ImageSpec configspec;
+        configspec.attribute("maketx:autotune", objective);
+        OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(
+            ImageBufAlgo::MakeTxTexture, A, name, configspec));
+        ImageBuf tex(name);
+        std::string choice = tex.spec().get_string_attribute("oiio:Autotune");
+        auto fields        = Strutil::splits(choice, " ");
+        OIIO_CHECK_EQUAL(fields.size(), size_t(3));
+        if (fields.size() != 3)
+            continue;
+        OIIO_CHECK_EQUAL(fields[0], Strutil::fmt::format("objective={}",
+                                                         objective));
+        int tile = tex.spec().tile_width;
+        OIIO_CHECK_ASSERT(tile == 32 || tile == 64 || tile == 128);
+        OIIO_CHECK_EQUAL(fields[1], Strutil::fmt::format("tile={}x{}", tile,
+                                                         tile));
+        std::string comp = fields[2].substr(strlen("compression="));
+        OIIO_CHECK_ASSERT(Strutil::istarts_with(
+            tex.spec().get_string_attribute("compression"), comp));
+        if (!strcmp(objective, "size"))
+            OIIO_CHECK_NE(comp, "none");
+        // Whatever was chosen, the pixels survive (dwaa only nearly)
+        auto diff = ImageBufAlgo::compare(tex, A, 0.01f, 0.01f);
+        OIIO_CHECK_EQUAL(diff.nfail, 0);
+    }
+    remove(name);
+}
+
+
+
+// Unwrap a light probe whose pixels hold their own NDC coordinates, so
+// that each latlong pixel must hold the probe coordinates of its direction.
+// The pole rows and the meridian columns are then evened out. The CDF
+// tables must match a search of the inverse CDF for every bin.
+void
+test_maketx_lightprobe()
+{
+    std::cout << "test make_texture lightprobe and cdf\n";
+    const int res = 64;
+    ImageBuf probe(ImageSpec(res, res, 2, TypeDesc::FLOAT));
+    for (ImageBuf::Iterator<float> p(probe); !p.done(); ++p) {
+        p[0] = (p.x() + 0.5f) / res;
+        p[1] = (p.y() + 0.5f) / res;
+    }
+    const char* name = "oiio-lightprobe.exr";
+    ImageSpec configspec;
+    configspec.attribute("maketx:cdf", 1);
+    OIIO_CHECK_ASSERT(
+        ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxEnvLatlFromLightProbe,
+                                   probe, name, configspec));
+
+    ImageBuf latl(name);
+    OIIO_CHECK_EQUAL(latl.spec().width, res);
+    OIIO_CHECK_EQUAL(latl.spec().height, res / 2);
+    const float dw = res, dh = res / 2;
+    const float lo = 0.5f / res, hi = 1.0f - 0.5f / res;
+    int nwrong = 0;
+    for (int y = 1; y < res / 2 - 1; ++y) {
+        for (int x = 1; x < res - 1; ++x) {
+            float theta = float(2.0 * M_PI * (x + 0.5f) / dw);
+            float phi   = float(M_PI * (dh - 1.0f - y + 0.5f) / dh);
+            float V[3]  = { sinf(phi) * sinf(theta), cosf(phi),
+                            -sinf(phi) * cosf(theta) };
+            float r     = float(M_1_PI) * acosf(V[2]) / hypotf(V[0], V[1]);
+            float u     = OIIO::clamp((V[0] * r + 1.0f) * 0.5f, lo, hi);
+            float v     = OIIO::clamp((V[1] * r + 1.0f) * 0.5f, lo, hi);
+            nwrong += std::abs(latl.getchannel(x, y, 0, 0) - u) > 1.0e-4f
+                      || std::abs(latl.getchannel(x, y, 0, 1) - v) > 1.0e-4f;
+        }
+    }
+    OIIO_CHECK_EQUAL(nwrong, 0);
+    for (int c = 0; c < 2; ++c) {
+        for (int x = 1; x < res; ++x) {
+            OIIO_CHECK_EQUAL(latl.getchannel(x, 0, 0, c),
+                             latl.getchannel(0, 0, 0, c));
+            OIIO_CHECK_EQUAL(latl.getchannel(x, res / 2 - 1, 0, c),
+                             latl.getchannel(0, res / 2 - 1, 0, c));
+        }
+        for (int y = 0; y < res / 2; ++y)
+            OIIO_CHECK_EQUAL(latl.getchannel(0, y, 0, c),
+                             latl.getchannel(res - 1, y, 0, c));
+    }
+
+    const int bins = 1 << latl.spec().get_int_attribute("CDF_bits");
+    OIIO_CHECK_EQUAL(bins, 256);
+    for (int c = 0; c < 2; ++c) {
+        const ParamValue* inv = latl.spec().find_attribute(
+            Strutil::fmt::format("invCDF_{}", c));
+        const ParamValue* fwd = latl.spec().find_attribute(
+            Strutil::fmt::format("CDF_{}", c));
+        OIIO_CHECK_ASSERT(inv && fwd);
+        if (!inv || !fwd || inv->type() != TypeDesc(TypeDesc::FLOAT, bins)
+            || fwd->type() != TypeDesc(TypeDesc::FLOAT, bins))
+            continue;
+        cspan<float> invCDF((const float*)inv->data(), bins);
+        cspan<float> CDF((const float*)fwd->data(), bins);
+        OIIO_CHECK_ASSERT(std::is_sorted(invCDF.begin(), invCDF.end()));
+        for (int j = 0; j < bins; ++j) {
+            auto upper = std::upper_bound(invCDF.begin(), invCDF.end(),
+                                          float(j) / float(bins - 1));
+            OIIO_CHECK_EQUAL(CDF[j],
+                             OIIO::clamp(float(upper - invCDF.begin())
+                                             / float(bins - 1),
+                                         0.0f, 1.0f));
+        }
+    }
+    remove(name);
+}
+
+
+
+// With forcefloat off, uint8 MIP levels are made by averaging 2x2 blocks
+// in the integer domain, rounded to nearest. With linear_average, the
+// color channels of sRGB levels are averaged in linear space instead, and
+// alpha still as is.
+void
+test_maketx_int_box()
+{
+    std::cout << "test make_texture integer box MIP levels\n";
+    ImageSpec spec(64, 32, 4, TypeDesc::UINT8);
+    spec.attribute("oiio:ColorSpace", "sRGB");
+    ImageBuf A(spec);
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f);
+
+    const char* name = "oiio-intbox.tx";
+    for (int linear : { 0, 1 }) {
+        ImageSpec configspec;
+        configspec.tile_width  = 16;
+        configspec.tile_height = 16;
+        configspec.attribute("maketx:forcefloat", 0);
+        configspec.attribute("maketx:linear_average", linear);
+        OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(
+            ImageBufAlgo::MakeTxTexture, A, name, configspec));
+        int nwrong = 0;
+        for (int m = 1; m < 6; ++m) {
+            ImageBuf big(name, 0, m - 1), small(name, 0, m);
+            int w = small.spec().width, h = small.spec().height;
+            OIIO_CHECK_EQUAL(w, 64 >> m);
+            std::vector<unsigned char> b(size_t(4 * w * h * 4));
+            std::vector<unsigned char> s(size_t(4 * w * h));
+            big.get_pixels(big.roi(), TypeDesc::UINT8, b.data());
+            small.get_pixels(small.roi(), TypeDesc::UINT8, s.data());
+            for (int y = 0; y < h; ++y) {
+                for (int x = 0; x < w; ++x) {
+                    for (int c = 0; c < 4; ++c) {
+                        size_t i0 = size_t(((2 * y) * 2 * w + 2 * x) * 4 + c);
+                        size_t i1 = i0 + size_t(2 * w * 4);
+                        int v[4]  = { b[i0], b[i0 + 4], b[i1], b[i1 + 4] };
+                        int got   = s[size_t((y * w + x) * 4 + c)];
+                        int avg   = (v[0] + v[1] + v[2] + v[3] + 2) / 4;
+                        if (!linear || c == 3) {
+                            nwrong += got != avg;
+                        } else {
+                            float lin = 0.0f;
+                            for (int k = 0; k < 4; ++k)
+                                lin += 0.25f * sRGB_to_linear(v[k] / 255.0f);
+                            int want = int(linear_to_sRGB(lin) * 255.0f + 0.5f);
+                            nwrong += std::abs(got - want) > 1;
+                        }
+                    }
+                }
+            }
+        }
+        OIIO_CHECK_EQUAL(nwrong, 0);
+    }
+    remove(name);
+}
+
+
+
+// Content-hash updates skip a conversion whose output records the same
+// source and options, and a shared CAS directory lets an identical source
+// under another name reuse a texture instead of making it anew.
+void
+test_maketx_source_hash()
+{
+    std::cout << "test make_texture update_by_hash and cas_dir\n";
+    ImageBuf A(ImageSpec(64, 32, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f);
+    A.write("oiio-hash-a.exr");
+    std::string err;
+    Filesystem::copy("oiio-hash-a.exr", "oiio-hash-b.exr", err);
+    Filesystem::remove_all("oiio-cas", err);
+    Filesystem::create_directory("oiio-cas", err);
+
+    ImageSpec configspec;
+    configspec.tile_width  = 16;
+    configspec.tile_height = 16;
+    configspec.attribute("maketx:update_by_hash", 1);
+    configspec.attribute("maketx:cas_dir", "oiio-cas");
+    auto make = [&](const char* in, const char* out,
+                    const ImageSpec& config) -> std::string {
+        std::ostringstream log;
+        OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(
+            ImageBufAlgo::MakeTxTexture, in, out, config, &log));
+        return log.str();
+    };
+
+    // The first conversion records the hash and fills the cache
+    std::string log = make("oiio-hash-a.exr", "oiio-hash-a.tx", configspec);
+    OIIO_CHECK_ASSERT(!Strutil::contains(log, "no update required"));
+    std::string hash = ImageBuf("oiio-hash-a.tx")
+                           .spec()
+                           .get_string_attribute("oiio:SourceHash");
+    OIIO_CHECK_EQUAL(hash.size(), size_t(32));
+    OIIO_CHECK_ASSERT(Filesystem::exists("oiio-cas/" + hash + ".tx"));
+
+    // Converting again is skipped, even with a new file time
+    Filesystem::last_write_time("oiio-hash-a.exr", std::time(nullptr) + 10);
+    log = make("oiio-hash-a.exr", "oiio-hash-a.tx", configspec);
+    OIIO_CHECK_ASSERT(Strutil::contains(log, "no update required"));
+
+    // A byte-identical copy reuses the cached texture
+    log = make("oiio-hash-b.exr", "oiio-hash-b.tx", configspec);
+    OIIO_CHECK_ASSERT(Strutil::contains(log, "reused"));
+    auto comp = ImageBufAlgo::compare(ImageBuf("oiio-hash-b.tx"),
+                                      ImageBuf("oiio-hash-a.tx"), 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // Different conversion options give a different hash
+    ImageSpec other = configspec;
+    other.attribute("maketx:filtername", "box");
+    log = make("oiio-hash-b.exr", "oiio-hash-b.tx", other);
+    OIIO_CHECK_ASSERT(!Strutil::contains(log, "reused"));
+    OIIO_CHECK_ASSERT(!Strutil::contains(log, "no update required"));
+    OIIO_CHECK_NE(ImageBuf("oiio-hash-b.tx")
+                      .spec()
+                      .get_string_attribute("oiio:SourceHash"),
+                  hash);
+
+    for (auto f : { "oiio-hash-a.exr", "oiio-hash-b.exr", "oiio-hash-a.tx",
+                    "oiio-hash-b.tx" })
+        remove(f);
+    Filesystem::remove_all("oiio-cas", err);
+}
+
+
+
+// Batch conversion runs several jobs at once under a small memory budget.
+// Each output must match its own input, a bad input must fail alone with
+// its own error message, and empty output names default to ".tx".
+void
+test_maketx_batch()
+{
+    std::cout << "test make_texture_batch\n";
+    std::vector<std::string> inputs, outputs;
+    for (int i = 0; i < 4; ++i) {
+        const float color[] = { 0.1f * i, 0.2f, 0.3f + 0.1f * i };
+        ImageBuf A(ImageSpec(64 + 16 * i, 32, 3, TypeDesc::FLOAT));
+        ImageBufAlgo::fill(A, color);
+        inputs.push_back(Strutil::fmt::format("oiio-batch{}.exr", i));
+        outputs.push_back(Strutil::fmt::format("oiio-batch{}.tx", i));
+        A.write(inputs.back());
+    }
+    inputs.emplace_back("oiio-batch-missing.exr");
+    outputs.emplace_back("oiio-batch-missing.tx");
+
+    ImageSpec configspec;
+    configspec.tile_width  = 16;
+    configspec.tile_height = 16;
+    configspec.attribute("maketx:jobs", 3);
+    configspec.attribute("maketx:memory_MB", 1);
+    for (bool named : { true, false }) {
+        std::vector<std::string> errors;
+        std::ostringstream log;
+        bool ok = ImageBufAlgo::make_texture_batch(
+            ImageBufAlgo::MakeTxTexture, inputs,
+            named ? cspan<std::string>(outputs) : cspan<std::string>(),
+            configspec, &log, &errors);
+        OIIO_CHECK_ASSERT(!ok);
+        OIIO_CHECK_ASSERT(Strutil::contains(OIIO::geterror(),
+                                            "1 of 5 conversions failed"));
+        OIIO_CHECK_EQUAL(errors.size(), inputs.size());
+        for (size_t i = 0; i < errors.size(); ++i)
+            OIIO_CHECK_EQUAL(errors[i].empty(), i != 4);
+        OIIO_CHECK_ASSERT(Strutil::contains(log.str(), inputs[4]));
+
+        for (int i = 0; i < 4; ++i) {
+            ImageBuf in(inputs[i]), tx(outputs[i]);
+            OIIO_CHECK_EQUAL(tx.spec().width, in.spec().width);
+            OIIO_CHECK_EQUAL(tx.spec().tile_width, 16);
+            auto comp = ImageBufAlgo::compare(tx, in, 1.0e-6f, 1.0e-6f);
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+            remove(outputs[i].c_str());
+        }
+        OIIO_CHECK_ASSERT(!Filesystem::exists(outputs[4]));
+    }
+    for (auto& f : inputs)
+        remove(f.c_str());
+}
+
+
+
+// Test the maketx path that writes each MIP level while the next one is
+// being computed: every level must arrive intact, and the verbose report
+// of each write must come out whole and in order.
+void
+test_maketx_overlapped_write()
+{
+    std::cout << "test make_texture overlapped MIP writes\n";
+    const float color[] = { 0.25f, 0.5f, 0.75f };
+    ImageBuf A(ImageSpec(256, 128, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::fill(A, color);
+
+    const char* name = "oiio-overlap.tx";
+    remove(name);
+    ImageSpec configspec;
+    configspec.tile_width  = 16;
+    configspec.tile_height = 16;
+    configspec.attribute("maketx:filtername", "lanczos3");
+    configspec.attribute("maketx:verbose", 1);
+    std::ostringstream log;
+    OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture,
+                                                 A, name, configspec, &log));
+
+    // One report line per level, largest first
+    std::vector<std::string> writes;
+    for (auto line : Strutil::splits(log.str(), "\n"))
+        if (Strutil::contains(line, " write "))
+            writes.push_back(line);
+    OIIO_CHECK_EQUAL(writes.size(), size_t(9));
+    for (int m = 0; m < 9 && m < int(writes.size()); ++m) {
+        std::string res = Strutil::fmt::format("    {}x{} ", 256 >> m,
+                                               std::max(128 >> m, 1));
+        OIIO_CHECK_ASSERT(Strutil::starts_with(writes[m], res));
+    }
+
+    // Every level is still the constant color
+    for (int m = 0; m < 9; ++m) {
+        ImageBuf level(name, 0, m);
+        OIIO_CHECK_EQUAL(level.spec().width, 256 >> m);
+        float pixmin[3], pixmax[3];
+        for (int c = 0; c < 3; ++c) {
+            pixmin[c] = 1.0f;
+            pixmax[c] = 0.0f;
+        }
+        for (ImageBuf::ConstIterator<float> p(level); !p.done(); ++p) {
+            for (int c = 0; c < 3; ++c) {
+                pixmin[c] = std::min(pixmin[c], p[c]);
+                pixmax[c] = std::max(pixmax[c], p[c]);
+            }
+        }
+        for (int c = 0; c < 3; ++c) {
+            OIIO_CHECK_EQUAL_THRESH(pixmin[c], color[c], 1.0e-3f);
+            OIIO_CHECK_EQUAL_THRESH(pixmax[c], color[c], 1.0e-3f);
+        }
+    }
+    remove(name);  // clean up
+}
+
+
+
 // Test various IBAprep features
 void
 test_IBAprep()
@@ -993,6 +2151,349 @@ test_IBAprep()
 
 
 
+// Tests ImageBufAlgo::convolve
+void
+test_convolve()
+{
+    std::cout << "test convolve\n";
+    ImageBuf A(ImageSpec(31, 17, 3, TypeDesc::HALF));
+    for (ImageBuf::Iterator<float> p(A); !p.done(); ++p)
+        for (int c = 0; c < 3; ++c)
+            p[c] = float(p.x() + 2 * p.y() + c);
+
+    // A box kernel (separable) averages, clamping at the edges
+    ImageBuf box = ImageBufAlgo::make_kernel("box", 3, 3);
+    ImageBuf B   = ImageBufAlgo::convolve(A, box);
+    OIIO_CHECK_EQUAL(B.spec().format, TypeDesc::HALF);
+    OIIO_CHECK_EQUAL_THRESH(B.getchannel(10, 8, 0, 1), 10 + 16 + 1, 1e-2f);
+    OIIO_CHECK_EQUAL_THRESH(B.getchannel(0, 0, 0, 0), 1.0f, 1e-2f);
+
+    // The laplacian (not separable) of a linear ramp is zero inside
+    ImageBuf L = ImageBufAlgo::laplacian(A);
+    OIIO_CHECK_EQUAL(L.getchannel(10, 8, 0, 2), 0.0f);
+
+    // A non-separable kernel gives the same result as a separable one
+    // that happens to have the same values, up to rounding
+    ImageBuf K = box.copy(TypeDesc::FLOAT);
+    K.setpixel(-1, -1, cspan<float>(1.0f / 9.0f + 1e-3f));
+    ImageBuf N = ImageBufAlgo::convolve(A, K, false, ROI(2, 29, 2, 15));
+    ImageBuf S = ImageBufAlgo::convolve(A, box, false, ROI(2, 29, 2, 15));
+    auto comp  = ImageBufAlgo::compare(N, S, 0.1f, 0.1f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+}
+
+
+
+// Tests ImageBufAlgo::fft_convolve
+void
+test_fft_convolve()
+{
+    std::cout << "test fft_convolve\n";
+    ImageBuf A(ImageSpec(45, 38, 3, TypeDesc::FLOAT));
+    for (ImageBuf::Iterator<float> p(A); !p.done(); ++p)
+        for (int c = 0; c < 3; ++c)
+            p[c] = float((p.x() * 7 + p.y() * 13 + c * 5) % 17);
+
+    // Matches direct convolution, including the clamped edges, for both
+    // the paired channels and the odd one out
+    ImageBuf disk = ImageBufAlgo::make_kernel("disk", 9, 7);
+    ImageBuf D    = ImageBufAlgo::convolve(A, disk);
+    ImageBuf F    = ImageBufAlgo::fft_convolve(A, disk);
+    auto comp     = ImageBufAlgo::compare(D, F, 1e-3f, 1e-3f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // A subregion, unnormalized
+    ROI roi(5, 40, 3, 30);
+    D    = ImageBufAlgo::convolve(A, disk, false, roi);
+    F    = ImageBufAlgo::fft_convolve(A, disk, false, roi);
+    comp = ImageBufAlgo::compare(D, F, 1e-2f, 1e-2f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+}
+
+
+
+// Tests ImageBufAlgo::rank_filter and median_filter against sorting
+void
+test_rank_filter()
+{
+    std::cout << "test rank_filter\n";
+    for (TypeDesc type : { TypeUInt8, TypeUInt16, TypeHalf, TypeFloat }) {
+        ImageBuf A(ImageSpec(41, 23, 2, type));
+        for (ImageBuf::Iterator<float> p(A); !p.done(); ++p)
+            for (int c = 0; c < 2; ++c)
+                p[c] = float((p.x() * 37 + p.y() * 101 + c * 7) % 251)
+                       / 255.0f;
+        const int w = 5, h = 3;
+        for (float rank : { 0.0f, 0.5f, 0.8f, 1.0f }) {
+            ImageBuf R = rank == 0.5f
+                             ? ImageBufAlgo::median_filter(A, w, h)
+                             : ImageBufAlgo::rank_filter(A, rank, w, h);
+            int r    = int(floorf(rank * (w * h - 1) + 0.5f));
+            int nbad = 0;
+            for (ImageBuf::ConstIterator<float> p(R); !p.done(); ++p) {
+                for (int c = 0; c < 2; ++c) {
+                    std::vector<float> v;
+                    for (int j = -h / 2; j < h - h / 2; ++j)
+                        for (int i = -w / 2; i < w - w / 2; ++i)
+                            v.push_back(A.getchannel(
+                                clamp(p.x() + i, 0, 40),
+                                clamp(p.y() + j, 0, 22), 0, c));
+                    std::sort(v.begin(), v.end());
+                    nbad += p[c] != v[r];
+                }
+            }
+            OIIO_CHECK_EQUAL(nbad, 0);
+        }
+        // Filtering just a region, which reads only the pixels around it,
+        // gives the same result there as filtering the whole image
+        ROI roi(10, 30, 5, 15, 0, 1, 0, 2);
+        ImageBuf S = ImageBufAlgo::rank_filter(A, 0.8f, w, h, roi);
+        ImageBuf F = ImageBufAlgo::rank_filter(A, 0.8f, w, h);
+        OIIO_CHECK_EQUAL(S.roi(), roi);
+        auto comp = ImageBufAlgo::compare(S, F, 0.0f, 0.0f, roi);
+        OIIO_CHECK_EQUAL(comp.nfail, 0);
+    }
+}
+
+
+
+// Tests ImageBufAlgo::dilate and erode, which should match the highest and
+// lowest rank filters for any window
+void
+test_morphology()
+{
+    std::cout << "test dilate/erode\n";
+    ImageBuf A(ImageSpec(61, 47, 3, TypeDesc::FLOAT));
+    for (ImageBuf::Iterator<float> p(A); !p.done(); ++p)
+        for (int c = 0; c < 3; ++c)
+            p[c] = float((p.x() * 29 + p.y() * 83 + c * 11) % 97);
+    for (int w : { 1, 2, 5, 24 }) {
+        int h      = w == 24 ? 7 : w + 1;
+        ImageBuf D = ImageBufAlgo::dilate(A, w, h);
+        ImageBuf E = ImageBufAlgo::erode(A, w, h);
+        auto dcomp = ImageBufAlgo::compare(
+            D, ImageBufAlgo::rank_filter(A, 1.0f, w, h), 0.0f, 0.0f);
+        auto ecomp = ImageBufAlgo::compare(
+            E, ImageBufAlgo::rank_filter(A, 0.0f, w, h), 0.0f, 0.0f);
+        OIIO_CHECK_EQUAL(dcomp.nfail, 0);
+        OIIO_CHECK_EQUAL(ecomp.nfail, 0);
+    }
+    // Short, odd-sized images with a kernel much wider than it is tall,
+    // where one padded row is longer than the whole tile.
+    for (int ht : { 1, 3 }) {
+        ImageBuf B(ImageSpec(5, ht, 3, TypeDesc::FLOAT));
+        for (ImageBuf::Iterator<float> p(B); !p.done(); ++p)
+            for (int c = 0; c < 3; ++c)
+                p[c] = float((p.x() * 7 + p.y() * 13 + c * 5) % 11);
+        ImageBuf D = ImageBufAlgo::dilate(B, 15, 1);
+        ImageBuf E = ImageBufAlgo::erode(B, 15, 1);
+        auto dcomp = ImageBufAlgo::compare(
+            D, ImageBufAlgo::rank_filter(B, 1.0f, 15, 1), 0.0f, 0.0f);
+        auto ecomp = ImageBufAlgo::compare(
+            E, ImageBufAlgo::rank_filter(B, 0.0f, 15, 1), 0.0f, 0.0f);
+        OIIO_CHECK_EQUAL(dcomp.nfail, 0);
+        OIIO_CHECK_EQUAL(ecomp.nfail, 0);
+    }
+}
+
+
+
+// Tests ImageBufAlgo::resize
+void
+test_resize()
+{
+    std::cout << "test resize\n";
+    ImageBuf A(ImageSpec(37, 23, 4, TypeDesc::FLOAT));
+    for (ImageBuf::Iterator<float> p(A); !p.done(); ++p)
+        for (int c = 0; c < 4; ++c)
+            p[c] = float(p.x() + 100 * p.y() + 10000 * c);
+
+    // Same size with a unit box is the identity, including at the edges
+    ParamValue box[] = { { "filtername", "box" }, { "filterwidth", 1.0f } };
+    ImageBuf B = ImageBufAlgo::resize(A, box, A.roi());
+    auto comp  = ImageBufAlgo::compare(A, B, 1e-3f, 1e-3f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // Wide filters keep a constant image constant, in both directions
+    const float val[3] = { 0.25f, 0.5f, 1.0f };
+    ImageBuf C(ImageSpec(40, 30, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::fill(C, val);
+    for (ROI roi : { ROI(0, 7, 0, 5), ROI(0, 81, 0, 47) }) {
+        ImageBuf R = ImageBufAlgo::resize(C, {}, roi);
+        OIIO_CHECK_ASSERT(ImageBufAlgo::isConstantColor(R, 1e-5f));
+        OIIO_CHECK_EQUAL_THRESH(R.getchannel(0, roi.yend - 1, 0, 2), 1.0f,
+                                1e-5f);
+    }
+}
+
+
+
+// Tests the "usemip" option of resize and fit: from a MIP-mapped file, the
+// result is filtered from the smallest level at least as big as itself,
+// exactly as if that level had been resized directly.
+void
+test_resize_usemip()
+{
+    std::cout << "test resize usemip\n";
+    ImageBuf A(ImageSpec(256, 256, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f },
+                       { 0.0f, 1.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+    const char* txname = "oiio-usemip.tx";
+    ImageSpec configspec;
+    OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture,
+                                                 A, txname, configspec));
+
+    // Levels are 256, 128, 64, 32, ...: a 48x48 result comes from 64x64
+    ImageBuf T(txname), T2(txname, 0, 2);
+    OIIO_CHECK_EQUAL(T2.spec().width, 64);
+    ROI roi(0, 48, 0, 48, 0, 1, 0, 3);
+    ParamValue usemip[] = { { "usemip", 1 } };
+    ImageBuf R  = ImageBufAlgo::resize(T, usemip, roi);
+    ImageBuf R2 = ImageBufAlgo::resize(T2, {}, roi);
+    auto comp   = ImageBufAlgo::compare(R, R2, 1e-6f, 1e-6f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    // ... and is close to the full resolution result
+    ImageBuf R0 = ImageBufAlgo::resize(T, {}, roi);
+    comp        = ImageBufAlgo::compare(R, R0, 0.02f, 0.02f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    ImageBuf F  = ImageBufAlgo::fit(T, usemip, roi);
+    ImageBuf F2 = ImageBufAlgo::fit(T2, {}, roi);
+    comp        = ImageBufAlgo::compare(F, F2, 1e-6f, 1e-6f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // Without MIP levels to use, usemip changes nothing
+    ImageBuf RA  = ImageBufAlgo::resize(A, usemip, roi);
+    ImageBuf RA0 = ImageBufAlgo::resize(A, {}, roi);
+    comp         = ImageBufAlgo::compare(RA, RA0, 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    T.reset();
+    T2.reset();
+    remove(txname);
+}
+
+
+
+// Tests that parallel_image splits the work for an ImageCache-backed image
+// on its tile grid, covering every pixel of the ROI exactly once.
+void
+test_parallel_image_tiles()
+{
+    std::cout << "test parallel_image on cache tiles\n";
+    ImageBuf A(ImageSpec(100, 70, 1, TypeDesc::FLOAT));
+    ImageBufAlgo::fill(A, { 0.5f });
+    A.set_write_tiles(16, 16);
+    A.write("tmp-iba-tiles.tif");
+    ImageCache* ic = ImageCache::create();
+    ic->invalidate(ustring("tmp-iba-tiles.tif"));
+    ImageBuf T("tmp-iba-tiles.tif", 0, 0, ic);
+    OIIO_CHECK_EQUAL(T.storage(), ImageBuf::IMAGECACHE);
+
+    ROI roi(3, 97, 5, 66);
+    std::vector<std::atomic<int>> hits(size_t(roi.npixels()));
+    std::atomic<int> straddles(0);
+    ImageBufAlgo::parallel_image(roi, 4, &T, [&](ROI r) {
+        if (r.ybegin / 16 != (r.yend - 1) / 16)
+            ++straddles;
+        for (int y = r.ybegin; y < r.yend; ++y)
+            for (int x = r.xbegin; x < r.xend; ++x)
+                ++hits[size_t(y - roi.ybegin) * roi.width() + x - roi.xbegin];
+    });
+    OIIO_CHECK_EQUAL(straddles, 0);
+    OIIO_CHECK_EQUAL(size_t(std::count(hits.begin(), hits.end(), 1)),
+                     hits.size());
+
+    // And the IBA functions get the same results from the cached image
+    ImageBuf S = ImageBufAlgo::add(T, 0.25f, roi, 4);
+    float color = 0.0f;
+    OIIO_CHECK_ASSERT(ImageBufAlgo::isConstantColor(S, 0.0f, color));
+    OIIO_CHECK_EQUAL(color, 0.75f);
+    Filesystem::remove("tmp-iba-tiles.tif");
+}
+
+
+
+// Test warp's bilinear preview mode
+void
+test_warp_bilinear()
+{
+    std::cout << "test warp bilinear" << std::endl;
+    ImageBuf src(ImageSpec(16, 8, 1, TypeDesc::FLOAT));
+    for (int y = 0; y < 8; ++y)
+        for (int x = 0; x < 16; ++x)
+            src.setpixel(x, y, cspan<float>({ float(x) }));
+
+    // Shifting by half a pixel averages horizontal neighbors
+    Imath::M33f M;
+    M.translate(Imath::V2f(-0.5f, 0.0f));
+    ImageBuf dst = ImageBufAlgo::warp(src, M, { { "filtername", "bilinear" },
+                                                { "wrap", "clamp" } });
+    OIIO_CHECK_ASSERT(!dst.has_error());
+    OIIO_CHECK_EQUAL(dst.getchannel(3, 2, 0, 0), 3.5f);
+    OIIO_CHECK_EQUAL(dst.getchannel(10, 7, 0, 0), 10.5f);
+
+    // Unknown filters are still an error
+    ImageBuf bad = ImageBufAlgo::warp(src, M, { { "filtername", "nope" } });
+    OIIO_CHECK_ASSERT(bad.has_error());
+}
+
+
+
+// Test st_warp's TextureSystem mode
+void
+test_st_warp_texture()
+{
+    std::cout << "test st_warp texture" << std::endl;
+    // A 1-pixel checkerboard, squeezed 8x by the st map, should come out
+    // as an even gray rather than aliasing.
+    ImageBuf src(ImageSpec(256, 256, 1, TypeDesc::FLOAT));
+    ImageBufAlgo::checker(src, 1, 1, 1, cspan<float>({ 0.0f }),
+                          cspan<float>({ 1.0f }));
+    ImageBuf ST(ImageSpec(32, 32, 2, TypeDesc::FLOAT));
+    for (int y = 0; y < 32; ++y)
+        for (int x = 0; x < 32; ++x)
+            ST.setpixel(x, y, cspan<float>({ (x + 0.5f) / 32.0f,
+                                             (y + 0.5f) / 32.0f }));
+    ImageBuf dst = ImageBufAlgo::st_warp(src, ST, "texture");
+    OIIO_CHECK_ASSERT(!dst.has_error());
+    auto stats = ImageBufAlgo::computePixelStats(dst, ROI(2, 30, 2, 30));
+    OIIO_CHECK_EQUAL_THRESH(stats.min[0], 0.5f, 0.05f);
+    OIIO_CHECK_EQUAL_THRESH(stats.max[0], 0.5f, 0.05f);
+
+    // An identity st map reproduces a linear ramp, away from the edges.
+    ImageBuf ramp(ImageSpec(64, 64, 1, TypeDesc::FLOAT));
+    ImageBufAlgo::fill(ramp, cspan<float>({ 0.0f }), cspan<float>({ 1.0f }),
+                       ROI(0, 64, 0, 64, 0, 1, 0, 1));
+    ImageBuf ST2(ImageSpec(64, 64, 2, TypeDesc::FLOAT));
+    for (int y = 0; y < 64; ++y)
+        for (int x = 0; x < 64; ++x)
+            ST2.setpixel(x, y, cspan<float>({ (x + 0.5f) / 64.0f,
+                                              (y + 0.5f) / 64.0f }));
+    ImageBuf warped = ImageBufAlgo::st_warp(ramp, ST2, "texture");
+    auto comp = ImageBufAlgo::compare(warped, ramp, 2e-3f, 2e-3f,
+                                      ROI(4, 60, 4, 60));
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // st spans the source's full window, wherever its origin is.
+    ImageSpec offspec(64, 64, 1, TypeDesc::FLOAT);
+    offspec.x = offspec.full_x = 100;
+    offspec.y = offspec.full_y = 50;
+    ImageBuf offramp(offspec);
+    ImageBufAlgo::fill(offramp, cspan<float>({ 0.0f }),
+                       cspan<float>({ 1.0f }), offramp.roi());
+    ImageBuf offwarped = ImageBufAlgo::st_warp(offramp, ST2, "texture");
+    OIIO_CHECK_ASSERT(!offwarped.has_error());
+    int nbad = 0;
+    for (int y = 4; y < 60; ++y)
+        for (int x = 4; x < 60; ++x)
+            nbad += fabsf(offwarped.getchannel(x, y, 0, 0)
+                          - offramp.getchannel(x + 100, y + 50, 0, 0))
+                    > 2e-3f;
+    OIIO_CHECK_EQUAL(nbad, 0);
+}
+
+
+
 // Test extra validation checks done by `st_warp`
 void
 test_validate_st_warp_checks()
@@ -1109,6 +2610,18 @@ test_opencv()
     OIIO_CHECK_EQUAL(comp.error, false);
     OIIO_CHECK_EQUAL(comp.maxerror, 0.0f);
 
+    // Wrapping in either direction shares the pixels rather than copying
+    // them, and names the BGR channels instead of swapping them.
+    ImageBuf wrapped = ImageBufAlgo::from_OpenCV_wrap(mat);
+    OIIO_CHECK_ASSERT(!wrapped.has_error());
+    OIIO_CHECK_EQUAL(wrapped.localpixels(), (void*)mat.ptr());
+    OIIO_CHECK_EQUAL(wrapped.spec().channelnames[0], "B");
+    OIIO_CHECK_EQUAL(wrapped.getchannel(0, 0, 0, 2), 1.0f);  // red corner
+    cv::Mat matview;
+    OIIO_CHECK_ASSERT(ImageBufAlgo::to_OpenCV_wrap(matview, src));
+    OIIO_CHECK_EQUAL((void*)matview.ptr(), src.localpixels());
+    OIIO_CHECK_EQUAL(matview.at<cv::Vec3f>(0, 0)[0], 1.0f);  // still RGB
+
     // Regression test: reading from ImageBuf-backed image to OpenCV
     auto loaded_image = OIIO::ImageBuf("../../testsuite/common/tahoe-tiny.tif",
                                        0, 0, ImageCache::create());
@@ -1169,6 +2682,203 @@ test_color_management()
 
 
 
+// Compare colorconvert of integer images, which bakes the processor into
+// lookup tables, against transforming each pixel as float.
+static void
+test_colorconvert_lut()
+{
+    print("Testing colorconvert with baked LUTs\n");
+    ColorConfig config;
+    // Without crosstalk: exact 1D tables. A diagonal matrix will do.
+    Imath::M44f diag(0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 2.0f, 0.0f, 0.0f,
+                     0.0f, 0.0f, 0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    // With crosstalk: an interpolated 3D LUT, which is exact for a matrix.
+    Imath::M44f mix(0.6f, 0.2f, 0.1f, 0.0f, 0.3f, 0.7f, 0.1f, 0.0f,
+                    0.1f, 0.1f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    for (const Imath::M44f* M : { &diag, &mix }) {
+        auto processor = config.createMatrixTransform(*M);
+        OIIO_CHECK_EQUAL(processor->hasChannelCrosstalk(), M == &mix);
+        for (TypeDesc type : { TypeUInt8, TypeUInt16, TypeHalf }) {
+            ImageBuf src(ImageSpec(256, 256, 4, type));
+            ImageBufAlgo::fill(src, { 0.0f, 0.0f, 0.0f, 1.0f },
+                               { 1.0f, 0.0f, 1.0f, 0.5f },
+                               { 0.0f, 1.0f, 0.0f, 1.0f },
+                               { 1.0f, 1.0f, 0.5f, 0.0f });
+            ImageBuf baked(ImageSpec(256, 256, 4, TypeFloat));
+            OIIO::attribute("colorconvert:lut3d", 17);
+            ImageBufAlgo::colorconvert(baked, src, processor.get(), false);
+            OIIO::attribute("colorconvert:lut3d", 0);
+            ImageBuf ref = ImageBufAlgo::colorconvert(
+                ImageBufAlgo::copy(src, TypeFloat), processor.get(), false);
+            auto comp = ImageBufAlgo::compare(baked, ref, 1.0e-5f, 1.0e-5f);
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+        }
+    }
+}
+
+
+
+// Channels beyond the first four pass through colorconvert unaltered, and
+// a matrix transform reports channel crosstalk exactly when it mixes
+// channels.
+static void
+test_colorconvert_extra_channels()
+{
+    print("Testing colorconvert of extra channels and matrix crosstalk\n");
+    ColorConfig config;
+    Imath::M44f diag(0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 2.0f, 0.0f, 0.0f,
+                     0.0f, 0.0f, 0.25f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    Imath::M44f mix(diag);
+    mix[1][0] = 0.5f;  // green feeds red
+    auto processor = config.createMatrixTransform(diag);
+    OIIO_CHECK_ASSERT(!processor->hasChannelCrosstalk());
+    OIIO_CHECK_ASSERT(config.createMatrixTransform(mix)->hasChannelCrosstalk());
+
+    for (TypeDesc type : { TypeFloat, TypeHalf, TypeUInt8 }) {
+        ImageBuf src(ImageSpec(8, 8, 6, type));
+        ImageBufAlgo::fill(src, { 0.25f, 0.25f, 0.75f, 1.0f, 0.3f, 0.6f });
+        ImageBuf dst = ImageBufAlgo::colorconvert(src, processor.get(), false);
+        float pixel[6];
+        dst.getpixel(3, 5, pixel);
+        float tol = type == TypeUInt8 ? 1.0f / 255.0f : 1.0e-3f;
+        OIIO_CHECK_EQUAL_THRESH(pixel[0], 0.125f, tol);
+        OIIO_CHECK_EQUAL_THRESH(pixel[1], 0.5f, tol);
+        OIIO_CHECK_EQUAL_THRESH(pixel[2], 0.1875f, tol);
+        OIIO_CHECK_EQUAL_THRESH(pixel[3], 1.0f, tol);
+        OIIO_CHECK_EQUAL_THRESH(pixel[4], 0.3f, tol);
+        OIIO_CHECK_EQUAL_THRESH(pixel[5], 0.6f, tol);
+    }
+}
+
+
+
+// Check the scanline-at-a-time colorconvert of local float and half
+// images against converting each pixel on its own.
+static void
+test_colorconvert_local()
+{
+    print("Testing colorconvert of local float and half images\n");
+    Imath::M44f M(0.6f, 0.2f, 0.1f, 0.0f, 0.3f, 0.7f, 0.1f, 0.0f, 0.1f, 0.1f,
+                  0.8f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    auto processor = ColorConfig().createMatrixTransform(M);
+    for (TypeDesc type : { TypeFloat, TypeHalf }) {
+        for (int nc : { 3, 4 }) {
+            ImageBuf src(ImageSpec(64, 64, nc, type));
+            ImageBufAlgo::fill(src, { 0.0f, 0.0f, 0.0f, 1.0f },
+                               { 1.0f, 0.0f, 1.0f, 0.5f },
+                               { 0.0f, 1.0f, 0.0f, 0.0f },
+                               { 1.0f, 1.0f, 0.5f, 0.25f });
+            ImageBuf dst = ImageBufAlgo::colorconvert(src, processor.get(),
+                                                      true);
+            float tol = type == TypeHalf ? 2.0e-3f : 1.0e-6f;
+            for (ImageBuf::ConstIterator<float> s(src), d(dst); !s.done();
+                 ++s, ++d) {
+                float pixel[4];
+                for (int c = 0; c < nc; ++c)
+                    pixel[c] = s[c];
+                ImageBufAlgo::colorconvert(span<float>(pixel, nc),
+                                           processor.get(), true);
+                for (int c = 0; c < nc; ++c)
+                    OIIO_CHECK_EQUAL_THRESH(d[c], pixel[c], tol);
+            }
+        }
+    }
+}
+
+
+
+// Check Expr::colorconvert, fused into a chain, against running the same
+// operations one at a time.
+static void
+test_expr_colorconvert()
+{
+    print("Testing Expr colorconvert\n");
+    using ImageBufAlgo::Expr;
+    Imath::M44f M(0.6f, 0.2f, 0.1f, 0.0f, 0.3f, 0.7f, 0.1f, 0.0f, 0.1f, 0.1f,
+                  0.8f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    auto processor = ColorConfig().createMatrixTransform(M);
+    for (int nc : { 3, 4, 5 }) {
+        for (bool unpremult : { false, true }) {
+            ImageBuf src(ImageSpec(64, 64, nc, TypeFloat));
+            ImageBufAlgo::fill(src, { 0.0f, 0.0f, 0.0f, 1.0f, 0.5f },
+                               { 1.0f, 0.0f, 1.0f, 0.5f, 0.5f },
+                               { 0.0f, 1.0f, 0.0f, 0.0f, 0.5f },
+                               { 1.0f, 1.0f, 0.5f, 0.25f, 0.5f });
+            ImageBuf R = (Expr(src) * 0.5f + 0.1f)
+                             .colorconvert(processor.get(), unpremult)
+                             .eval();
+            ImageBuf S = ImageBufAlgo::colorconvert(
+                ImageBufAlgo::mad(src, 0.5f, 0.1f), processor.get(),
+                unpremult);
+            OIIO_CHECK_ASSERT(!R.has_error());
+            auto comp = ImageBufAlgo::compare(R, S, 1.0e-6f, 1.0e-6f);
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+        }
+    }
+
+    // The color channels must be in the evaluation region
+    ImageBuf src(ImageSpec(16, 16, 4, TypeFloat));
+    ROI roi     = src.roi();
+    roi.chbegin = 1;
+    ImageBuf R  = Expr(src).colorconvert(processor.get()).eval(roi);
+    OIIO_CHECK_ASSERT(R.has_error());
+    R.geterror();
+}
+
+
+// Check premult, unpremult and repremult, in place and into a new buffer,
+// for the SIMD-handled types and an alpha channel that is not last.
+static void
+test_premult()
+{
+    print("Testing premult/unpremult/repremult\n");
+    for (TypeDesc type : { TypeFloat, TypeHalf, TypeUInt8, TypeUInt16 }) {
+        for (int alpha : { 3, 1 }) {
+            ImageSpec spec(64, 64, 6, type);
+            spec.alpha_channel = alpha;
+            ImageBuf src(spec);
+            ImageBufAlgo::fill(src, { 0.2f, 0.0f, 0.6f, 0.8f, 1.0f, 0.4f },
+                               { 0.4f, 0.5f, 0.2f, 1.0f, 0.0f, 0.8f },
+                               { 1.0f, 1.0f, 0.0f, 0.5f, 0.5f, 0.2f },
+                               { 0.0f, 0.3f, 0.9f, 0.25f, 0.75f, 1.0f });
+            float tol = type == TypeHalf ? 2.0e-3f : 1.0e-6f;
+            if (type == TypeUInt8 || type == TypeUInt16)
+                tol = 0.51f / float(type == TypeUInt8 ? 255 : 65535);
+            ImageBuf pre = ImageBufAlgo::premult(src);
+            ImageBuf inplace;
+            inplace.copy(src);
+            ImageBufAlgo::premult(inplace, inplace);
+            for (ImageBuf::ConstIterator<float> s(src), p(pre), q(inplace);
+                 !s.done(); ++s, ++p, ++q) {
+                for (int c = 0; c < spec.nchannels; ++c) {
+                    float v = c == alpha ? s[c] : s[c] * s[alpha];
+                    OIIO_CHECK_EQUAL_THRESH(p[c], v, tol);
+                    OIIO_CHECK_EQUAL(q[c], p[c]);
+                }
+            }
+            // Alpha 0 colors are kept by repremult, and crushed by premult.
+            ImageBuf un = ImageBufAlgo::unpremult(pre);
+            ImageBuf re = ImageBufAlgo::repremult(src);
+            for (ImageBuf::ConstIterator<float> p(pre), u(un), r(re), s(src);
+                 !s.done(); ++s, ++p, ++u, ++r) {
+                float a = s[alpha];
+                for (int c = 0; c < spec.nchannels; ++c) {
+                    if (a != 0.0f)
+                        OIIO_CHECK_EQUAL(r[c], p[c]);
+                    else
+                        OIIO_CHECK_EQUAL(r[c], s[c]);
+                    if (a == 0.0f || a == 1.0f)
+                        OIIO_CHECK_EQUAL(u[c], p[c]);
+                    else if (type == TypeFloat)
+                        OIIO_CHECK_EQUAL_THRESH(u[c], s[c], 1.0e-6f);
+                }
+            }
+        }
+    }
+}
+
+
+
 static void
 test_yee()
 {
@@ -1187,6 +2897,100 @@ test_yee()
 
 
 
+// Tests ImageBufAlgo::render_text into buffers of different types, and
+// that rendering again from the glyph cache gives the same pixels.
+static void
+test_render_text()
+{
+    print("Testing render_text\n");
+    ImageSpec spec(64, 32, 3, TypeDesc::FLOAT);
+    ImageBuf F(spec);
+    ImageBufAlgo::zero(F);
+    const float color[] = { 1.0f, 0.5f, 0.25f };
+    if (!ImageBufAlgo::render_text(F, 4, 24, "Hi!", 16, "", color)) {
+        print("  skipping: {}\n", F.geterror());
+        return;
+    }
+    auto stats = ImageBufAlgo::computePixelStats(F);
+    OIIO_CHECK_EQUAL(stats.max[0], 1.0f);
+
+    // Same text again, now drawn from the glyph cache
+    ImageBuf F2(spec);
+    ImageBufAlgo::zero(F2);
+    OIIO_CHECK_ASSERT(ImageBufAlgo::render_text(F2, 4, 24, "Hi!", 16, "",
+                                                color));
+    auto comp = ImageBufAlgo::compare(F, F2, 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // A uint8 buffer should get the float result, quantized
+    spec.set_format(TypeUInt8);
+    ImageBuf U(spec);
+    ImageBufAlgo::zero(U);
+    OIIO_CHECK_ASSERT(ImageBufAlgo::render_text(U, 4, 24, "Hi!", 16, "",
+                                                color));
+    comp = ImageBufAlgo::compare(U, F, 0.51f / 255.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+}
+
+
+
+// Trace callback for test_trace: appends the span names to the
+// std::vector<std::string> passed as userdata.
+static void
+trace_collect(cspan<TraceSpan> spans, void* userdata)
+{
+    auto names = (std::vector<std::string>*)userdata;
+    for (const TraceSpan& span : spans) {
+        OIIO_CHECK_LE(span.begin, span.end);
+        names->emplace_back(span.name);
+    }
+}
+
+
+
+// Tests that IBA functions record trace spans, both to a callback and to
+// the "trace_file", and that nothing is recorded once tracing is off.
+static void
+test_trace()
+{
+    print("Testing tracing\n");
+    ImageBuf A(ImageSpec(64, 64, 3, TypeDesc::FLOAT));
+    const float red[] = { 1.0f, 0.0f, 0.0f };
+
+    std::vector<std::string> names;
+    set_trace_callback(trace_collect, &names);
+    ImageBufAlgo::fill(A, red);
+    ImageBufAlgo::zero(A);
+    trace_flush();
+    set_trace_callback(nullptr);
+    OIIO_CHECK_EQUAL(names.size(), size_t(2));
+    OIIO_CHECK_ASSERT(std::find(names.begin(), names.end(), "IBA::fill")
+                      != names.end());
+    OIIO_CHECK_ASSERT(std::find(names.begin(), names.end(), "IBA::zero")
+                      != names.end());
+
+    // Tracing is off again: no more spans
+    names.clear();
+    ImageBufAlgo::fill(A, red);
+    trace_flush();
+    OIIO_CHECK_ASSERT(names.empty());
+
+    // Spans written to a trace file as Chrome trace event JSON
+    std::string filename = "trace_test.json";
+    OIIO::attribute("trace_file", filename);
+    ImageBufAlgo::fill(A, red);
+    trace_flush();
+    OIIO::attribute("trace_file", "");
+    std::string contents;
+    OIIO_CHECK_ASSERT(Filesystem::read_text_file(filename, contents));
+    OIIO_CHECK_ASSERT(Strutil::starts_with(contents, "[\n"));
+    OIIO_CHECK_ASSERT(Strutil::contains(contents, "\"name\":\"IBA::fill\""));
+    OIIO_CHECK_ASSERT(Strutil::contains(contents, "\"ph\":\"X\""));
+    Filesystem::remove(filename);
+}
+
+
+
 int
 main(int argc, char** argv)
 {
@@ -1205,28 +3009,72 @@ main(int argc, char** argv)
     test_copy();
     test_crop();
     test_paste();
+    test_paste_fast_path();
+    test_transpose_rotate();
     test_channel_append();
+    test_cryptomatte_extract();
     test_add();
     test_sub();
+    test_for_each_scanline();
     test_mul();
+    test_native_value_ops(TypeUInt8);
+    test_native_value_ops(TypeUInt16);
+    test_native_value_ops(TypeHalf);
     test_mad();
+    test_expr();
     test_min();
     test_max();
     test_over(TypeFloat);
     test_over(TypeHalf);
+    test_over_layers();
     test_zover();
+    test_deep_flatten();
+    test_deep_merge();
     test_compare();
     test_isConstantColor();
     test_isConstantChannel();
     test_isMonochrome();
     test_computePixelStats();
+    test_computePixelHash();
+    test_fixNonFinite(TypeFloat);
+    test_fixNonFinite(TypeHalf);
+    test_fixNonFinite(TypeDesc::DOUBLE);
+    test_noise();
     histogram_computation_test();
+    test_histograms(TypeFloat);
+    test_histograms(TypeUInt8);
+    test_histograms(TypeUInt16);
     test_maketx_from_imagebuf();
+    test_maketx_overlapped_write();
+    test_maketx_stream();
+    test_maketx_batch();
+    test_maketx_source_hash();
+    test_maketx_int_box();
+    test_maketx_lightprobe();
+    test_maketx_autotune();
+    test_maketx_bumpslopes();
+    test_maketx_autotile_input();
+    test_convolve();
+    test_fft_convolve();
+    test_rank_filter();
+    test_morphology();
+    test_resize();
+    test_resize_usemip();
+    test_parallel_image_tiles();
     test_IBAprep();
+    test_warp_bilinear();
     test_validate_st_warp_checks();
+    test_st_warp_texture();
     test_opencv();
     test_color_management();
+    test_colorconvert_lut();
+    test_colorconvert_extra_channels();
+    test_colorconvert_local();
+    test_expr_colorconvert();
+    test_premult();
     test_yee();
+    test_render_text();
+    test_trace();
 
     benchmark_parallel_image(64, iterations * 64);
     benchmark_parallel_image(512, iterations * 16);
@@ -17,6 +17,9 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/simd.h>
+#include <OpenImageIO/texture.h>
 #include <OpenImageIO/thread.h>
 
 #include <Imath/ImathBox.h>
@@ -33,6 +36,7 @@ static const ustring filtername_us("filtername");
 static const ustring filterptr_us("filterptr");
 static const ustring filterwidth_us("filterwidth");
 static const ustring recompute_roi_us("recompute_roi");
+static const ustring usemip_us("usemip");
 static const ustring wrap_us("wrap");
 
 
@@ -258,17 +262,16 @@ transform(const Imath::M33f& M, ROI roi)
 template<typename SRCTYPE>
 inline void
 filtered_sample(const ImageBuf& src, float s, float t, float dsdx, float dtdx,
-                float dsdy, float dtdy, const Filter2D* filter,
+                float dsdy, float dtdy, const Filter2D::Table& filter,
                 ImageBuf::WrapMode wrap, bool edgeclamp, float* result)
 {
-    OIIO_DASSERT(filter);
     // Just use isotropic filtering
     float ds          = std::max(1.0f, std::max(fabsf(dsdx), fabsf(dsdy)));
     float dt          = std::max(1.0f, std::max(fabsf(dtdx), fabsf(dtdy)));
     float ds_inv      = 1.0f / ds;
     float dt_inv      = 1.0f / dt;
-    float filterrad_s = 0.5f * ds * filter->width();
-    float filterrad_t = 0.5f * dt * filter->width();
+    float filterrad_s = 0.5f * ds * filter.width();
+    float filterrad_t = 0.5f * dt * filter.width();
     int smin          = (int)floorf(s - filterrad_s);
     int smax          = (int)ceilf(s + filterrad_s);
     int tmin          = (int)floorf(t - filterrad_t);
@@ -302,12 +305,31 @@ filtered_sample(const ImageBuf& src, float s, float t, float dsdx, float dtdx,
     float* sum = OIIO_ALLOCA(float, nc);
     memset(sum, 0, nc * sizeof(float));
     float total_w = 0.0f;
-    for (; !samp.done(); ++samp) {
-        float w = (*filter)(ds_inv * (samp.x() + 0.5f - s),
-                            dt_inv * (samp.y() + 0.5f - t));
-        for (int c = 0; c < nc; ++c)
-            sum[c] += w * samp[c];
-        total_w += w;
+    int ns = smax - smin, nt = tmax - tmin;
+    if (filter.separable() && ns > 0 && nt > 0 && ns + nt <= 4096) {
+        // A separable filter's weight is the product of its horizontal and
+        // vertical weights, so evaluate each of those just once per column
+        // and row of the footprint rather than once per sample.
+        float* wx = OIIO_ALLOCA(float, ns + nt);
+        float* wy = wx + ns;
+        for (int i = 0; i < ns; ++i)
+            wx[i] = filter.xfilt(ds_inv * (smin + i + 0.5f - s));
+        for (int j = 0; j < nt; ++j)
+            wy[j] = filter.yfilt(dt_inv * (tmin + j + 0.5f - t));
+        for (; !samp.done(); ++samp) {
+            float w = wx[samp.x() - smin] * wy[samp.y() - tmin];
+            for (int c = 0; c < nc; ++c)
+                sum[c] += w * samp[c];
+            total_w += w;
+        }
+    } else {
+        for (; !samp.done(); ++samp) {
+            float w = filter(ds_inv * (samp.x() + 0.5f - s),
+                             dt_inv * (samp.y() + 0.5f - t));
+            for (int c = 0; c < nc; ++c)
+                sum[c] += w * samp[c];
+            total_w += w;
+        }
     }
     if (total_w > 0.0f)
         for (int c = 0; c < nc; ++c)
@@ -345,25 +367,63 @@ get_warp_filter(string_view filtername_, float filterwidth, ImageBuf& dst)
 
 
 
+// Sample src at s,t with the given derivatives, using the filter table, or
+// plain bilinear interpolation if filter is null.
+template<typename SRCTYPE>
+inline void
+warp_sample(const ImageBuf& src, float s, float t, float dsdx, float dtdx,
+            float dsdy, float dtdy, const Filter2D::Table* filter,
+            ImageBuf::WrapMode wrap, bool edgeclamp, float* result)
+{
+    if (filter)
+        filtered_sample<SRCTYPE>(src, s, t, dsdx, dtdx, dsdy, dtdy, *filter,
+                                 wrap, edgeclamp, result);
+    else
+        src.interppixel(s, t, result, wrap);
+}
+
+
+
 template<typename DSTTYPE, typename SRCTYPE>
 static bool
 warp_(ImageBuf& dst, const ImageBuf& src, const Imath::M33f& M,
-      const Filter2D* filter, ImageBuf::WrapMode wrap, bool edgeclamp, ROI roi,
-      int nthreads)
+      const Filter2D::Table* filter, ImageBuf::WrapMode wrap, bool edgeclamp,
+      ROI roi, int nthreads)
 {
+    Imath::M33f Minv = M.inverse();
+    // An affine transform has the same derivatives everywhere, so those
+    // are computed once rather than with per-pixel Dual2 math. (Positions
+    // are still computed per pixel, in the same order of operations as
+    // robust_multVecMatrix, so results match the general path exactly.)
+    bool affine = Minv[0][2] == 0.0f && Minv[1][2] == 0.0f
+                  && Minv[2][2] != 0.0f;
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
         int nc     = dst.nchannels();
         float* pel = OIIO_ALLOCA(float, nc);
         memset(pel, 0, nc * sizeof(float));
-        Imath::M33f Minv = M.inverse();
+        if (affine) {
+            float winv = 1.0f / Minv[2][2];
+            float dsdx = Minv[0][0] * winv, dtdx = Minv[0][1] * winv;
+            float dsdy = Minv[1][0] * winv, dtdy = Minv[1][1] * winv;
+            ImageBuf::Iterator<DSTTYPE> out(dst, roi);
+            for (; !out.done(); ++out) {
+                float x = out.x() + 0.5f, y = out.y() + 0.5f;
+                float s = (x * Minv[0][0] + y * Minv[1][0] + Minv[2][0]) * winv;
+                float t = (x * Minv[0][1] + y * Minv[1][1] + Minv[2][1]) * winv;
+                warp_sample<SRCTYPE>(src, s, t, dsdx, dtdx, dsdy, dtdy, filter,
+                                     wrap, edgeclamp, pel);
+                for (int c = roi.chbegin; c < roi.chend; ++c)
+                    out[c] = pel[c];
+            }
+            return;
+        }
         ImageBuf::Iterator<DSTTYPE> out(dst, roi);
         for (; !out.done(); ++out) {
             Dual2 x(out.x() + 0.5f, 1.0f, 0.0f);
             Dual2 y(out.y() + 0.5f, 0.0f, 1.0f);
             robust_multVecMatrix(Minv, x, y, x, y);
-            filtered_sample<SRCTYPE>(src, x.val(), y.val(), x.dx(), y.dx(),
-                                     x.dy(), y.dy(), filter, wrap, edgeclamp,
-                                     pel);
+            warp_sample<SRCTYPE>(src, x.val(), y.val(), x.dx(), y.dx(),
+                                 x.dy(), y.dy(), filter, wrap, edgeclamp, pel);
             for (int c = roi.chbegin; c < roi.chend; ++c)
                 out[c] = pel[c];
         }
@@ -376,7 +436,7 @@ warp_(ImageBuf& dst, const ImageBuf& src, const Imath::M33f& M,
 static bool
 warp_impl(ImageBuf& dst, const ImageBuf& src, const Imath::M33f& M,
           const Filter2D* filter, bool recompute_roi, ImageBuf::WrapMode wrap,
-          bool edgeclamp, ROI roi, int nthreads)
+          bool edgeclamp, ROI roi, int nthreads, bool bilinear = false)
 {
     pvt::LoggedTimer logtime("IBA::warp");
     ROI src_roi_full = src.roi_full();
@@ -399,15 +459,24 @@ warp_impl(ImageBuf& dst, const ImageBuf& src, const Imath::M33f& M,
     // Set up a shared pointer with custom deleter to make sure any
     // filter we allocate here is properly destroyed.
     std::shared_ptr<Filter2D> filterptr((Filter2D*)NULL, Filter2D::destroy);
-    if (filter == NULL) {
+    if (bilinear) {
+        // A null filter tells warp_ to just interpolate bilinearly
+        filter = nullptr;
+    } else if (filter == NULL) {
         // If no filter was provided, punt and use lanczos3
         filterptr.reset(Filter2D::create("lanczos3", 6.0f, 6.0f));
         filter = filterptr.get();
     }
 
+    // Sample the filter through a table of its weights.
+    Filter2D::Table table;
+    if (filter)
+        table = filter->make_table();
+    const Filter2D::Table* tableptr = filter ? &table : nullptr;
+
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "warp", warp_, dst.spec().format,
-                                src.spec().format, dst, src, M, filter, wrap,
+                                src.spec().format, dst, src, M, tableptr, wrap,
                                 edgeclamp, dst_roi, nthreads);
     return ok;
 }
@@ -470,14 +539,19 @@ ImageBufAlgo::warp(ImageBuf& dst, const ImageBuf& src, M33fParam M,
                                           recompute_roi_us, filterptr_us };
     IBA_check_optional(options, recognized);
 
+    // "bilinear" isn't a Filter2D, it asks for plain bilinear interpolation
+    // of the source, ignoring the transform's derivatives.
     Filter2D::ref filterptr = get_filterptr_option(options);
-    if (!filterptr) {
+    bool bilinear
+        = !filterptr
+          && Strutil::iequals(options.get_string(filtername_us), "bilinear");
+    if (!filterptr && !bilinear) {
         filterptr = get_warp_filter(options.get_string(filtername_us),
                                     options.get_float(filterwidth_us), dst);
         if (!filterptr)
             return false;  // error issued in get_warp_filter
     }
-    if (!filterptr) {
+    if (!filterptr && !bilinear) {
         dst.errorfmt("Invalid filter");
         return false;
     }
@@ -494,7 +568,7 @@ ImageBufAlgo::warp(ImageBuf& dst, const ImageBuf& src, M33fParam M,
     bool edgeclamp     = options.get_int(edgeclamp_us, 0);
 
     return warp_impl(dst, src, M, filterptr.get(), recompute_roi, wrap,
-                     edgeclamp, roi, nthreads);
+                     edgeclamp, roi, nthreads, bilinear);
 }
 
 
@@ -576,6 +650,9 @@ ImageBufAlgo::warp(ImageBuf& dst, const ImageBuf& src, M33fParam M,
                    bool recompute_roi, ImageBuf::WrapMode wrap, bool edgeclamp,
                    ROI roi, int nthreads)
 {
+    if (Strutil::iequals(filtername, "bilinear"))
+        return warp_impl(dst, src, M, nullptr, recompute_roi, wrap, edgeclamp,
+                         roi, nthreads, true);
     // Set up a shared pointer with custom deleter to make sure any
     // filter we allocate here is properly destroyed.
     auto filter = get_warp_filter(filtername, filterwidth, dst);
@@ -635,11 +712,51 @@ ImageBufAlgo::rotate(ImageBuf& dst, const ImageBuf& src, float angle,
 
 
 
+// Set o[0..nchannels-1] to the sum over ntaps pixels p (packed, nchannels
+// apart) weighted by w.
+template<typename T>
+static inline void
+resize_taps_generic(T* o, const T* p, const float* w, int ntaps,
+                    int nchannels)
+{
+    for (int c = 0; c < nchannels; ++c)
+        o[c] = T(0);
+    for (int i = 0; i < ntaps; ++i, p += nchannels)
+        for (int c = 0; c < nchannels; ++c)
+            o[c] += w[i] * p[c];
+}
+
+template<typename T>
+static inline void
+resize_taps(T* o, const T* p, const float* w, int ntaps, int nchannels)
+{
+    resize_taps_generic(o, p, w, ntaps, nchannels);
+}
+
+static inline void
+resize_taps(float* o, const float* p, const float* w, int ntaps,
+            int nchannels)
+{
+    if (nchannels == 4) {
+        // The common RGBA case sums whole pixels at a time.
+        simd::vfloat4 sum(0.0f);
+        for (int i = 0; i < ntaps; ++i, p += 4)
+            sum = madd(simd::vfloat4(w[i]), simd::vfloat4(p), sum);
+        sum.store(o);
+    } else {
+        resize_taps_generic(o, p, w, ntaps, nchannels);
+    }
+}
+
+
+
 template<typename DSTTYPE, typename SRCTYPE>
 static bool
 resize_(ImageBuf& dst, const ImageBuf& src, const Filter2D* filter, ROI roi,
         int nthreads)
 {
+    // Evaluate the filter weights from a table, not by virtual calls.
+    const Filter2D::Table table = filter->make_table();
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
         const ImageSpec& srcspec(src.spec());
         const ImageSpec& dstspec(dst.spec());
@@ -692,7 +809,7 @@ resize_(ImageBuf& dst, const ImageBuf& src, const Filter2D* filter, ROI roi,
                 float src_xf_frac   = floorfrac(src_xf, &src_x);
                 float totalweight_x = 0.0f;
                 for (int i = 0; i < xtaps; ++i) {
-                    float w = filter->xfilt(
+                    float w = table.xfilt(
                         xratio * (i - radi - (src_xf_frac - 0.5f)));
                     xfiltval[i] = w;
                     totalweight_x += w;
@@ -750,19 +867,82 @@ resize_(ImageBuf& dst, const ImageBuf& src, const Filter2D* filter, ROI roi,
         //
         // Separate cases for separable and non-separable filters.
         if (separable) {
+            // Filter in two passes. Each source row this strip of the
+            // output needs is first filtered horizontally, to one value per
+            // output column, into a ring of ytaps intermediate rows; each
+            // output scanline is then the weighted sum of its ytaps rows.
+            // That is xtaps + ytaps multiplies per output pixel rather
+            // than xtaps * ytaps, and both inner loops run over packed
+            // memory. Out-of-range source pixels repeat the edge, as with
+            // WrapClamp.
+            const ROI srcroi     = src.roi();
+            const int width      = roi.width();
+            const size_t rowvals = size_t(width) * nchannels;
+            const TypeDesc acctype(TypeDescFromC<Acc_t>::value());
+            const stride_t accxstride = nchannels * sizeof(Acc_t);
+
+            // The first source column under each output column, and the
+            // range of source columns (within the data window) needed.
+            std::unique_ptr<int[]> xfirst(new int[width]);
+            int sx0 = std::numeric_limits<int>::max();
+            int sx1 = std::numeric_limits<int>::min();
+            for (int x = roi.xbegin; x < roi.xend; ++x) {
+                float s   = (x - dstfx + 0.5f) * dstpixelwidth;
+                int first = ifloor(srcfx + s * srcfw) - radi;
+
+                xfirst[x - roi.xbegin] = first;
+                sx0                    = std::min(sx0, first);
+                sx1                    = std::max(sx1, first + xtaps);
+            }
+            sx0 = clamp(sx0, srcroi.xbegin, srcroi.xend - 1);
+            sx1 = clamp(sx1, sx0 + 1, srcroi.xend);
+            ROI srcrowroi(sx0, sx1, 0, 1, srcroi.zbegin, srcroi.zbegin + 1, 0,
+                          std::min(nchannels, src.nchannels()));
+
+            std::vector<Acc_t> srcrow(size_t(sx1 - sx0) * nchannels, Acc_t(0));
+            std::vector<Acc_t> ring(rowvals * ytaps);
+            std::vector<int> ringrow(ytaps, std::numeric_limits<int>::min());
+            std::vector<Acc_t> outrow(rowvals);
+            Acc_t* gathered = OIIO_ALLOCA(Acc_t, xtaps * nchannels);
+
+            // Horizontally filter source row sy into ring slot.
+            auto filter_row = [&](int sy, Acc_t* slot) {
+                srcrowroi.ybegin = sy;
+                srcrowroi.yend   = sy + 1;
+                src.get_pixels(srcrowroi, acctype, srcrow.data(), accxstride);
+                for (int x = 0; x < width; ++x) {
+                    const float* xfiltval = xfiltval_all.get() + x * xtaps;
+                    Acc_t* o              = slot + size_t(x) * nchannels;
+                    int first             = xfirst[x];
+                    const Acc_t* p;
+                    if (first >= sx0 && first + xtaps <= sx1) {
+                        p = srcrow.data() + size_t(first - sx0) * nchannels;
+                    } else {
+                        // Near an edge: gather the clamped columns.
+                        for (int i = 0; i < xtaps; ++i) {
+                            int sx = clamp(first + i, sx0, sx1 - 1);
+                            std::copy_n(srcrow.data()
+                                            + size_t(sx - sx0) * nchannels,
+                                        nchannels, gathered + i * nchannels);
+                        }
+                        p = gathered;
+                    }
+                    resize_taps(o, p, xfiltval, xtaps, nchannels);
+                }
+            };
+
             ImageBuf::Iterator<DSTTYPE> out(dst, roi);
-            ImageBuf::ConstIterator<SRCTYPE> srcpel(src, ImageBuf::WrapClamp);
             for (int y = roi.ybegin; y < roi.yend; ++y) {
                 float t      = (y - dstfy + 0.5f) * dstpixelheight;
                 float src_yf = srcfy + t * srcfh;
                 int src_y;
                 float src_yf_frac = floorfrac(src_yf, &src_y);
-                // If using separable filters, our vertical set of filter tap
-                // weights will be the same for the whole scanline we're on.  Just
-                // compute and normalize them once.
+                // The vertical filter tap weights are the same for the
+                // whole scanline we're on. Just compute and normalize them
+                // once.
                 float totalweight_y = 0.0f;
                 for (int j = 0; j < ytaps; ++j) {
-                    float w = filter->yfilt(
+                    float w = table.yfilt(
                         yratio * (j - radj - (src_yf_frac - 0.5f)));
                     yfiltval[j] = w;
                     totalweight_y += w;
@@ -771,47 +951,32 @@ resize_(ImageBuf& dst, const ImageBuf& src, const Filter2D* filter, ROI roi,
                     for (int i = 0; i < ytaps; ++i)
                         yfiltval[i] /= totalweight_y;
 
-                for (int x = roi.xbegin; x < roi.xend; ++x, ++out) {
-                    float s      = (x - dstfx + 0.5f) * dstpixelwidth;
-                    float src_xf = srcfx + s * srcfw;
-                    int src_x    = ifloor(src_xf);
-                    for (int c = 0; c < nchannels; ++c)
-                        pel[c] = 0.0f;
-                    const float* xfiltval = xfiltval_all.get()
-                                            + (x - roi.xbegin) * xtaps;
-                    float totalweight_x = 0.0f;
-                    for (int i = 0; i < xtaps; ++i)
-                        totalweight_x += xfiltval[i];
-                    if (totalweight_x != 0.0f) {
-                        srcpel.rerange(src_x - radi, src_x + radi + 1,
-                                       src_y - radj, src_y + radj + 1, 0, 1,
-                                       ImageBuf::WrapClamp);
-                        for (int j = -radj; j <= radj; ++j) {
-                            float wy = yfiltval[j + radj];
-                            if (wy == 0.0f) {
-                                // 0 weight for this y tap -- move to next line
-                                srcpel.pos(srcpel.x(), srcpel.y() + 1,
-                                           srcpel.z());
-                                continue;
-                            }
-                            for (int i = 0; i < xtaps; ++i, ++srcpel) {
-                                float w = wy * xfiltval[i];
-                                if (w)
-                                    for (int c = 0; c < nchannels; ++c)
-                                        pel[c] += w * srcpel[c];
-                            }
-                        }
-                    }
-                    // Copy the pixel value (already normalized) to the output.
-                    OIIO_DASSERT(out.x() == x && out.y() == y);
-                    if (totalweight_y == 0.0f) {
-                        // zero it out
-                        for (int c = 0; c < nchannels; ++c)
-                            out[c] = 0.0f;
-                    } else {
-                        for (int c = 0; c < nchannels; ++c)
-                            out[c] = pel[c];
+                std::fill(outrow.begin(), outrow.end(), Acc_t(0));
+                for (int j = 0; j < ytaps; ++j) {
+                    float wy = yfiltval[j];
+                    if (wy == 0.0f)
+                        continue;
+                    // The rows under one scanline's taps are consecutive,
+                    // only ever move forward, and number at most ytaps, so
+                    // they never collide in the ring.
+                    int sy      = clamp(src_y - radj + j, srcroi.ybegin,
+                                        srcroi.yend - 1);
+                    int r       = (sy - srcroi.ybegin) % ytaps;
+                    Acc_t* slot = ring.data() + rowvals * r;
+                    if (ringrow[r] != sy) {
+                        filter_row(sy, slot);
+                        ringrow[r] = sy;
                     }
+                    for (size_t i = 0; i < rowvals; ++i)
+                        outrow[i] += wy * slot[i];
+                }
+
+                // Copy the (already normalized) values to the output.
+                const Acc_t* v = outrow.data();
+                for (int x = 0; x < width; ++x, ++out, v += nchannels) {
+                    OIIO_DASSERT(out.x() == x + roi.xbegin && out.y() == y);
+                    for (int c = 0; c < nchannels; ++c)
+                        out[c] = v[c];
                 }
             }
 
@@ -838,9 +1003,8 @@ resize_(ImageBuf& dst, const ImageBuf& src, const Filter2D* filter, ROI roi,
                         for (int i = -radi; i <= radi; ++i, ++srcpel) {
                             OIIO_DASSERT(!srcpel.done());
                             float w
-                                = (*filter)(xratio * (i - (src_xf_frac - 0.5f)),
-                                            yratio
-                                                * (j - (src_yf_frac - 0.5f)));
+                                = table(xratio * (i - (src_xf_frac - 0.5f)),
+                                        yratio * (j - (src_yf_frac - 0.5f)));
                             if (w) {
                                 totalweight += w;
                                 for (int c = 0; c < nchannels; ++c)
@@ -903,6 +1067,35 @@ get_resize_filter(string_view filtername, float fwidth, ImageBuf& dst,
 
 
 
+// When downsizing an ImageCache-backed MIP-mapped image, there's no need to
+// filter the full-resolution level: the coarsest MIP level that is still at
+// least `width` x `height` holds everything the result can show. If there
+// is such a level below the one `src` refers to, point `mipbuf` at it and
+// return it, otherwise return `src` itself.
+static const ImageBuf&
+resize_source(const ImageBuf& src, int width, int height, ImageBuf& mipbuf)
+{
+    if (src.storage() != ImageBuf::IMAGECACHE || src.deep()
+        || src.nmiplevels() <= src.miplevel() + 1 || !src.imagecache())
+        return src;
+    ImageCache* ic = src.imagecache();
+    ustring name(src.name());
+    int level      = src.miplevel();
+    for (int m = level + 1; m < src.nmiplevels(); ++m) {
+        const ImageSpec* spec = ic->imagespec(name, src.subimage(), m);
+        if (!spec || spec->full_width < width || spec->full_height < height)
+            break;
+        level = m;
+    }
+    if (level == src.miplevel())
+        return src;
+    mipbuf.reset(src.name(), src.subimage(), level, ic);
+    if (!mipbuf.init_spec(src.name(), src.subimage(), level))
+        return src;
+    return mipbuf;
+}
+
+
 bool
 ImageBufAlgo::resize(ImageBuf& dst, const ImageBuf& src, KWArgs options,
                      ROI roi, int nthreads)
@@ -913,6 +1106,7 @@ ImageBufAlgo::resize(ImageBuf& dst, const ImageBuf& src, KWArgs options,
         filtername_us,
         filterwidth_us,
         filterptr_us,
+        usemip_us,
 #if 0 /* Not currently recognized */
         wrap_us,
         edgeclamp_us,
@@ -924,7 +1118,12 @@ ImageBufAlgo::resize(ImageBuf& dst, const ImageBuf& src, KWArgs options,
     if (!IBAprep(roi, &dst, &src,
                  IBAprep_NO_SUPPORT_VOLUME | IBAprep_NO_COPY_ROI_FULL))
         return false;
-    const ImageSpec& srcspec(src.spec());
+    ImageBuf mipbuf;
+    const ImageBuf& srcmip(options.get_int(usemip_us)
+                               ? resize_source(src, dst.spec().full_width,
+                                               dst.spec().full_height, mipbuf)
+                               : src);
+    const ImageSpec& srcspec(srcmip.spec());
     const ImageSpec& dstspec(dst.spec());
 
     Filter2D::ref filterptr = get_filterptr_option(options);
@@ -952,9 +1151,13 @@ ImageBufAlgo::resize(ImageBuf& dst, const ImageBuf& src, KWArgs options,
     bool edgeclamp     = options.get_int(edgeclamp_us, 0);
 #endif
 
+    if (ComputeBackend* backend = compute_backend())
+        if (backend->resize(dst, srcmip, filterptr.get(), roi, nthreads))
+            return true;
+
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "resize", resize_, dst.spec().format,
-                                src.spec().format, dst, src, filterptr.get(),
+                                srcspec.format, dst, srcmip, filterptr.get(),
                                 roi, nthreads);
     return ok;
 }
@@ -1025,6 +1228,7 @@ ImageBufAlgo::fit(ImageBuf& dst, const ImageBuf& src, KWArgs options, ROI roi,
         filterptr_us,
         fillmode_us,
         exact_us,
+        usemip_us,
 #if 0 /* Not currently recognized */
         wrap_us,
         edgeclamp_us,
@@ -1079,6 +1283,14 @@ ImageBufAlgo::fit(ImageBuf& dst, const ImageBuf& src, KWArgs options, ROI roi,
         yoff = float(fit_full_height - scale * srcspec.full_height) / 2.0f;
     }
 
+    // Filter from the smallest MIP level that still covers the result
+    ImageBuf mipbuf;
+    const ImageBuf& srcmip(options.get_int(usemip_us)
+                               ? resize_source(src, resize_full_width,
+                                               resize_full_height, mipbuf)
+                               : src);
+    const ImageSpec& mipspec(srcmip.spec());
+
     ROI newroi(fit_full_x, fit_full_x + fit_full_width, fit_full_y,
                fit_full_y + fit_full_height, 0, 1, 0, srcspec.nchannels);
     // std::cout << "  Fitting " << srcspec.roi()
@@ -1088,8 +1300,8 @@ ImageBufAlgo::fit(ImageBuf& dst, const ImageBuf& src, KWArgs options, ROI roi,
     Filter2D::ref filterptr = get_filterptr_option(options);
     if (!filterptr) {
         // If no filter was provided, punt and just linearly interpolate.
-        float wratio = float(resize_full_width) / float(srcspec.full_width);
-        float hratio = float(resize_full_height) / float(srcspec.full_height);
+        float wratio = float(resize_full_width) / float(mipspec.full_width);
+        float hratio = float(resize_full_height) / float(mipspec.full_height);
         filterptr    = get_resize_filter(options.get_string(filtername_us),
                                          options.get_float(filterwidth_us), dst,
                                          wratio, hratio);
@@ -1103,15 +1315,21 @@ ImageBufAlgo::fit(ImageBuf& dst, const ImageBuf& src, KWArgs options, ROI roi,
         // ratio and exactly centers the padded image, but might make the
         // edges of the resized area blurry because it's not a whole number
         // of pixels.
-        Imath::M33f M(scale, 0.0f, 0.0f, 0.0f, scale, 0.0f, xoff, yoff, 1.0f);
+        // The scale is relative to level 0; rescale it for the MIP level
+        // actually read (whose size may be rounded in each direction).
+        float xscale = scale * srcspec.full_width / mipspec.full_width;
+        float yscale = scale * srcspec.full_height / mipspec.full_height;
+        Imath::M33f M(xscale, 0.0f, 0.0f, 0.0f, yscale, 0.0f, xoff, yoff,
+                      1.0f);
         // std::cout << "   Fit performing warp with " << M << "\n";
         ImageSpec newspec = srcspec;
         newspec.set_roi(newroi);
         newspec.set_roi_full(newroi);
         dst.reset(newspec);
         ImageBuf::WrapMode wrap = ImageBuf::WrapMode_from_string("black");
-        ok &= warp_impl(dst, src, M, filterptr.get(), /*recompute_roi*/ false,
-                        wrap, /*edgeclamp*/ true, /*roi*/ {}, nthreads);
+        ok &= warp_impl(dst, srcmip, M, filterptr.get(),
+                        /*recompute_roi*/ false, wrap, /*edgeclamp*/ true,
+                        /*roi*/ {}, nthreads);
     } else {
         // Full pixel resize -- gives the sharpest result, but for odd-sized
         // destination resolution, may not be exactly centered and will only
@@ -1128,7 +1346,7 @@ ImageBufAlgo::fit(ImageBuf& dst, const ImageBuf& src, KWArgs options, ROI roi,
             dst.reset(newspec);
             logtime.stop();  // it will be picked up again by the next call...
             const Filter2D* filterraw = filterptr.get();
-            ok &= ImageBufAlgo::resize(dst, src,
+            ok &= ImageBufAlgo::resize(dst, srcmip,
                                        { make_pv(filterptr_us, filterraw) },
                                        resizeroi, nthreads);
         } else {
@@ -1489,10 +1707,9 @@ ImageBufAlgo::rotate(const ImageBuf& src, float angle, string_view filtername,
 template<typename DSTTYPE, typename SRCTYPE, typename STTYPE>
 static bool
 st_warp_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& stbuf, int chan_s,
-         int chan_t, bool flip_s, bool flip_t, const Filter2D* filter, ROI roi,
-         int nthreads)
+         int chan_t, bool flip_s, bool flip_t, const Filter2D::Table& filter,
+         ROI roi, int nthreads)
 {
-    OIIO_DASSERT(filter);
     OIIO_DASSERT(dst.spec().nchannels >= roi.chend);
 
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
@@ -1512,8 +1729,8 @@ st_warp_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& stbuf, int chan_s,
         // The horizontal and vertical filter radii, in source pixels.
         // We will sample and filter the source over
         //   [x-filterrad_x, x+filterrad_x] X [y-filterrad_y,y+filterrad_y].
-        const int filterrad_x = (int)ceilf(filter->width() / 2.0f / xscale);
-        const int filterrad_y = (int)ceilf(filter->height() / 2.0f / yscale);
+        const int filterrad_x = (int)ceilf(filter.width() / 2.0f / xscale);
+        const int filterrad_y = (int)ceilf(filter.height() / 2.0f / yscale);
 
         // Accumulation buffer for filter samples, typed to maintain the
         // necessary precision.
@@ -1559,8 +1776,8 @@ st_warp_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& stbuf, int chan_s,
             memset(sample_accum, 0, nchannels * sizeof(Acc_t));
             float total_weight = 0.0f;
             for (; !src_iter.done(); ++src_iter) {
-                const float weight = (*filter)(src_iter.x() - src_x + 0.5f,
-                                               src_iter.y() - src_y + 0.5f);
+                const float weight = filter(src_iter.x() - src_x + 0.5f,
+                                            src_iter.y() - src_y + 0.5f);
                 total_weight += weight;
                 for (int idx = 0, chan = roi.chbegin; chan < roi.chend;
                      ++chan, ++idx) {
@@ -1585,6 +1802,190 @@ st_warp_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& stbuf, int chan_s,
 
 
 
+// Creator of the "null" ImageInput that stands in for the in-memory
+// texture used by st_warp_texture, whose tiles are all added by hand.
+static ImageInput*
+st_warp_null_creator()
+{
+    return ImageInput::create("0.null").release();
+}
+
+
+
+// The TextureSystem that st_warp_texture samples through, with its own
+// private ImageCache. It's made on first use and then kept (never freed),
+// so each call doesn't pay to set one up. Calls take turns with it, each
+// sizing its cache for its own texture and emptying it again when done.
+static std::mutex st_warp_ts_mutex;
+
+static TextureSystem*
+st_warp_texturesys()
+{
+    static TextureSystem* ts = TextureSystem::create(false /* private */);
+    return ts;
+}
+
+
+
+// st_warp by way of the batched TextureSystem: src is MIP-mapped into a
+// private ImageCache, and each destination scanline is looked up in
+// Tex::BatchWidth groups, with derivatives taken from finite differences
+// of neighboring ST values, so minified regions are properly filtered.
+static bool
+st_warp_texture(ImageBuf& dst, const ImageBuf& src, const ImageBuf& stbuf,
+                int chan_s, int chan_t, bool flip_s, bool flip_t, ROI roi,
+                int nthreads)
+{
+    const ImageSpec& srcspec(src.spec());
+    const int nc       = srcspec.nchannels;
+    const int tilesize = 64;
+    int width = srcspec.full_width, height = srcspec.full_height;
+
+    // ST [0,1] spans the full (display) window of src, so that's the
+    // extent of the texture's highest resolution level.
+    std::vector<ImageBuf> levels;
+    levels.emplace_back(ImageSpec(width, height, nc, TypeFloat));
+    src.get_pixels(ROI(srcspec.full_x, srcspec.full_x + width, srcspec.full_y,
+                       srcspec.full_y + height, 0, 1, 0, nc),
+                   TypeFloat, levels.back().localpixels());
+    imagesize_t totalbytes = levels.back().spec().image_bytes();
+    while (width > 1 || height > 1) {
+        width  = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels.push_back(
+            ImageBufAlgo::resize(levels.back(), { { "filtername", "box" } },
+                                 ROI(0, width, 0, height, 0, 1, 0, nc)));
+        if (levels.back().has_error()) {
+            dst.errorfmt("st_warp: {}", levels.back().geterror());
+            return false;
+        }
+        totalbytes += levels.back().spec().image_bytes();
+    }
+
+    // Whichever way we leave, free all of our tiles before letting the
+    // next call have the TextureSystem.
+    std::lock_guard<std::mutex> lock(st_warp_ts_mutex);
+    TextureSystem* ts = st_warp_texturesys();
+    struct Release {
+        TextureSystem* ts;
+        ~Release() { ts->invalidate_all(true); }
+    } release { ts };
+    ImageCache* ic = ts->imagecache();
+    // Nothing may be evicted, since the proxy ImageInput can't reread it.
+    ic->attribute("max_memory_MB", float(totalbytes / (1024 * 1024) * 2 + 64));
+    ImageSpec config(srcspec.full_width, srcspec.full_height, nc, TypeFloat);
+    config.tile_width  = tilesize;
+    config.tile_height = tilesize;
+    config.tile_depth  = 1;
+    // The same name every time, replacing the last call's texture.
+    static ustring name("st_warp.null?MIP=1");
+    if (!ic->add_file(name, st_warp_null_creator, &config, true)) {
+        dst.errorfmt("st_warp: {}", ic->geterror());
+        return false;
+    }
+    std::vector<float> tile(size_t(tilesize) * tilesize * nc);
+    for (int m = 0, nlevels = int(levels.size()); m < nlevels; ++m) {
+        const ImageBuf& level(levels[m]);
+        for (int ty = 0; ty < level.spec().height; ty += tilesize) {
+            for (int tx = 0; tx < level.spec().width; tx += tilesize) {
+                // Edge tiles are padded with zeros to the full tile size.
+                std::fill(tile.begin(), tile.end(), 0.0f);
+                level.get_pixels(ROI(tx,
+                                     std::min(tx + tilesize,
+                                              level.spec().width),
+                                     ty,
+                                     std::min(ty + tilesize,
+                                              level.spec().height),
+                                     0, 1, 0, nc),
+                                 TypeFloat, tile.data(), nc * sizeof(float),
+                                 tilesize * nc * sizeof(float));
+                if (!ic->add_tile(name, 0, m, tx, ty, 0, 0, nc, TypeFloat,
+                                  tile.data())) {
+                    dst.errorfmt("st_warp: {}", ic->geterror());
+                    return false;
+                }
+            }
+        }
+    }
+
+    const int BW = Tex::BatchWidth;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI r) {
+        const int stnc   = stbuf.nchannels();
+        const int nchans = r.nchannels();
+        const int n      = r.width();
+        // One extra ST pixel to the right, if there is one, for the x
+        // differences.
+        const int nst = std::min(r.xend + 1, stbuf.xend()) - r.xbegin;
+        std::vector<float> row(size_t(nst) * stnc), nextrow(row.size());
+        std::vector<float> outrow(size_t(n) * nchans);
+        std::vector<float> result(size_t(nchans) * BW);
+        float s[BW], t[BW], dsdx[BW], dtdx[BW], dsdy[BW], dtdy[BW];
+        TextureOptBatch opt;
+        opt.firstchannel = r.chbegin;
+        opt.swrap        = Tex::Wrap::Clamp;
+        opt.twrap        = Tex::Wrap::Clamp;
+
+        auto st = [&](const std::vector<float>& rw, int i, float& ss,
+                      float& tt) {
+            ss = rw[size_t(i) * stnc + chan_s];
+            tt = rw[size_t(i) * stnc + chan_t];
+            if (flip_s)
+                ss = 1.0f - ss;
+            if (flip_t)
+                tt = 1.0f - tt;
+        };
+        for (int z = r.zbegin; z < r.zend; ++z) {
+            for (int y = r.ybegin; y < r.yend; ++y) {
+                // Differences in y are forward, except on the last row.
+                int ynext   = y + 1 < stbuf.yend() ? y + 1 : y - 1;
+                float ysign = 1.0f;
+                if (ynext < stbuf.ybegin())
+                    ynext = y;
+                else if (ynext < y)
+                    ysign = -1.0f;
+                stbuf.get_pixels(ROI(r.xbegin, r.xbegin + nst, y, y + 1, z,
+                                     z + 1),
+                                 TypeFloat, row.data());
+                stbuf.get_pixels(ROI(r.xbegin, r.xbegin + nst, ynext,
+                                     ynext + 1, z, z + 1),
+                                 TypeFloat, nextrow.data());
+                for (int x0 = 0; x0 < n; x0 += BW) {
+                    int nb = std::min(BW, n - x0);
+                    for (int i = 0; i < nb; ++i) {
+                        int ix      = x0 + i;
+                        int ixnext  = ix + 1 < nst ? ix + 1 : ix - 1;
+                        float xsign = ixnext < ix ? -1.0f : 1.0f;
+                        if (ixnext < 0)
+                            ixnext = ix;
+                        float sn, tn;
+                        st(row, ix, s[i], t[i]);
+                        st(row, ixnext, sn, tn);
+                        dsdx[i] = (sn - s[i]) * xsign;
+                        dtdx[i] = (tn - t[i]) * xsign;
+                        st(nextrow, ix, sn, tn);
+                        dsdy[i] = (sn - s[i]) * ysign;
+                        dtdy[i] = (tn - t[i]) * ysign;
+                    }
+                    Tex::RunMask mask = nb == BW ? Tex::RunMaskOn
+                                                 : (Tex::RunMask(1) << nb) - 1;
+                    ts->texture(name, opt, mask, s, t, dsdx, dtdx, dsdy, dtdy,
+                                nchans, result.data());
+                    for (int i = 0; i < nb; ++i)
+                        for (int c = 0; c < nchans; ++c)
+                            outrow[size_t(x0 + i) * nchans + c]
+                                = result[size_t(c) * BW + i];
+                }
+                dst.set_pixels(ROI(r.xbegin, r.xend, y, y + 1, z, z + 1,
+                                   r.chbegin, r.chend),
+                               TypeFloat, outrow.data());
+            }
+        }
+    });
+    return true;
+}
+
+
+
 static bool
 check_st_warp_args(ImageBuf& dst, const ImageBuf& src, const ImageBuf& stbuf,
                    int chan_s, int chan_t, ROI& roi)
@@ -1653,11 +2054,14 @@ ImageBufAlgo::st_warp(ImageBuf& dst, const ImageBuf& src, const ImageBuf& stbuf,
         filter = filterptr.get();
     }
 
+    // Sample the filter through a table of its weights.
+    const Filter2D::Table table = filter->make_table();
+
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES3(ok, "st_warp", st_warp_, dst.spec().format,
                                 src.spec().format, stbuf.spec().format, dst,
                                 src, stbuf, chan_s, chan_t, flip_s, flip_t,
-                                filter, roi, nthreads);
+                                table, roi, nthreads);
     return ok;
 }
 
@@ -1669,6 +2073,13 @@ ImageBufAlgo::st_warp(ImageBuf& dst, const ImageBuf& src, const ImageBuf& stbuf,
                       int chan_t, bool flip_s, bool flip_t, ROI roi,
                       int nthreads)
 {
+    if (Strutil::iequals(filtername, "texture")) {
+        pvt::LoggedTimer logtime("IBA::st_warp");
+        if (!check_st_warp_args(dst, src, stbuf, chan_s, chan_t, roi))
+            return false;
+        return st_warp_texture(dst, src, stbuf, chan_s, chan_t, flip_s,
+                               flip_t, roi, nthreads);
+    }
     // Set up a shared pointer with custom deleter to make sure any
     // filter we allocate here is properly destroyed.
     auto filter = get_warp_filter(filtername, filterwidth, dst);
@@ -8,9 +8,12 @@
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/texture.h>
 #include <OpenImageIO/unittest.h>
 
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 using namespace OIIO;
 
@@ -245,6 +248,51 @@ test_custom_threadinfo()
 
 
 
+void
+test_thread_context()
+{
+    Strutil::print("\nTesting ImageCache::ThreadContext\n");
+    ImageCache* imagecache = ImageCache::create(false);
+    auto implicit          = imagecache->get_perthread_info();
+    {
+        ImageCache::ThreadContext ctx(*imagecache);
+        OIIO_CHECK_ASSERT(ctx.thread_info() != nullptr);
+        OIIO_CHECK_ASSERT(ctx.thread_info() != implicit);
+        // Calls that aren't passed a Perthread use the bound one
+        OIIO_CHECK_EQUAL(imagecache->get_perthread_info(), ctx.thread_info());
+        // Other threads are unaffected
+        ImageCache::Perthread* other = nullptr;
+        std::thread([&]() {
+            other = imagecache->get_perthread_info();
+        }).join();
+        OIIO_CHECK_ASSERT(other != ctx.thread_info());
+    }
+    // Once unbound, the thread goes back to the Perthread it had
+    OIIO_CHECK_EQUAL(imagecache->get_perthread_info(), implicit);
+
+    // Binding over and over, reading as we go, mustn't pile up Perthreads
+    // or the tiles their microcaches hold on to.
+    float pixel[3];
+    int tiles0 = -1, tiles = -1;
+    for (int i = 0; i < 20; ++i) {
+        {
+            ImageCache::ThreadContext ctx(*imagecache);
+            OIIO_CHECK_ASSERT(imagecache->get_pixels(checkertex, 0, 0, 17, 18,
+                                                     1, 2, 0, 1, TypeFloat,
+                                                     pixel));
+        }
+        OIIO_CHECK_EQUAL(imagecache->get_perthread_info(), implicit);
+        OIIO_CHECK_ASSERT(
+            imagecache->getattribute("stat:tiles_current", TypeInt, &tiles));
+        if (i == 0)
+            tiles0 = tiles;
+        OIIO_CHECK_EQUAL(tiles, tiles0);
+    }
+    ImageCache::destroy(imagecache);
+}
+
+
+
 void
 test_tileptr()
 {
@@ -332,6 +380,955 @@ test_imagespec()
 
 
 
+static void
+test_prefetch()
+{
+    Strutil::print("\nTesting prefetch\n");
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    int queued0 = 0, queued1 = 0;
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:prefetch_tiles", queued0));
+    OIIO_CHECK_ASSERT(ic->prefetch(checkertex, 0, 0));
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:prefetch_tiles", queued1));
+    OIIO_CHECK_ASSERT(queued1 > queued0);
+
+    // A second prefetch of the same tiles should not queue anything new
+    auto hand = ic->get_image_handle(checkertex);
+    OIIO_CHECK_ASSERT(ic->prefetch(hand, nullptr, 0, 0));
+    int queued2 = 0;
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:prefetch_tiles", queued2));
+    OIIO_CHECK_EQUAL(queued2, queued1);
+
+    // Lookups of prefetched tiles must see the right pixels
+    float pixel[3] = { -1.0f, -1.0f, -1.0f };
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 17, 18, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+
+    // Batch variety, and error cases
+    ROI rois[] = { ROI(0, 16, 0, 16), ROI(200, 256, 200, 256, 0, 1, 0, 1) };
+    OIIO_CHECK_ASSERT(ic->prefetch(hand, nullptr, 0, 1, rois));
+    OIIO_CHECK_FALSE(ic->prefetch(hand, nullptr, 0, 100));
+    OIIO_CHECK_ASSERT(ic->has_error());
+    Strutil::print("prefetch of out-of-range miplevel:\n  {}\n",
+                   ic->geterror());
+    OIIO_CHECK_FALSE(ic->prefetch(ustring("noexist.exr"), 0, 0));
+    OIIO_CHECK_ASSERT(ic->has_error());
+    Strutil::print("prefetch of non-existant file:\n  {}\n", ic->geterror());
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_diskcache()
+{
+    Strutil::print("\nTesting disk tile cache\n");
+    std::string dir = "imagecache_test_diskcache";
+    Filesystem::remove_all(dir);
+
+    // The first cache reads from the file and populates the disk cache
+    float pixel[3] = { -1.0f, -1.0f, -1.0f };
+    long long hits = 0, writes = 0;
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    OIIO_CHECK_ASSERT(ic->attribute("diskcache:path", dir));
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 17, 18, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:diskcache_writes", TypeInt64, &writes));
+    OIIO_CHECK_ASSERT(writes > 0);
+    ImageCache::destroy(ic);
+
+    // A second, separate cache should find the tile on disk
+    ic = ImageCache::create(false /* not shared */);
+    OIIO_CHECK_ASSERT(ic->attribute("diskcache:path", dir));
+    pixel[0] = -1.0f;
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 17, 18, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:diskcache_hits", TypeInt64, &hits));
+    OIIO_CHECK_ASSERT(hits > 0);
+
+    // Shrinking the limit to nothing trims everything
+    long long used = 1;
+    OIIO_CHECK_ASSERT(ic->attribute("diskcache:size", 0.0f));
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:diskcache_bytes_used", TypeInt64,
+                                       &used));
+    OIIO_CHECK_EQUAL(used, 0);
+    ImageCache::destroy(ic);
+    Filesystem::remove_all(dir);
+}
+
+
+
+static void
+test_file_attributes()
+{
+    Strutil::print("\nTesting per-file cache attributes\n");
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    auto hand      = ic->get_image_handle(checkertex);
+    OIIO_CHECK_ASSERT(hand);
+    int priority = 0;
+    float quota  = 0.0f;
+    priority = 3;
+    OIIO_CHECK_ASSERT(
+        ic->attribute(hand, "evict_priority", TypeInt, &priority));
+    priority = 0;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute(hand, "evict_priority", TypeInt, &priority));
+    OIIO_CHECK_EQUAL(priority, 3);
+    OIIO_CHECK_FALSE(ic->attribute(hand, "bogus", TypeInt, &priority));
+
+    // A quota smaller than one tile means the file's tiles don't stay.
+    quota = 0.1f;
+    OIIO_CHECK_ASSERT(
+        ic->attribute(hand, "max_memory_MB", TypeFloat, &quota));
+    quota = 0.0f;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute(hand, "max_memory_MB", TypeFloat, &quota));
+    OIIO_CHECK_EQUAL(quota, 0.1f);
+    priority = 0;
+    OIIO_CHECK_ASSERT(
+        ic->attribute(hand, "evict_priority", TypeInt, &priority));
+    float pixel[3] = { -1.0f, -1.0f, -1.0f };
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 17, 18, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    long long evicted = 0;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:tiles_evicted", TypeInt64, &evicted));
+    OIIO_CHECK_ASSERT(evicted > 0);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_get_tiles()
+{
+    Strutil::print("\nTesting get_tiles\n");
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    ic->attribute("autotile", 64);
+    auto hand = ic->get_image_handle(checkertex);
+    OIIO_CHECK_ASSERT(hand);
+
+    // Not enough room: just report how many are needed
+    ImageCache::Tile* tiles[16] = {};
+    OIIO_CHECK_EQUAL(ic->get_tiles(hand, nullptr, 0, 0, ROI(), { tiles, 2 }),
+                     16);
+    OIIO_CHECK_ASSERT(tiles[0] == nullptr);
+
+    // A region straddling four tiles, in z, y, x order
+    int n = ic->get_tiles(hand, nullptr, 0, 0, ROI(60, 70, 60, 70, 0, 1, 0, 3),
+                          tiles);
+    OIIO_CHECK_EQUAL(n, 4);
+    for (int i = 0; i < n; ++i) {
+        OIIO_CHECK_ASSERT(tiles[i]);
+        ROI r = ic->tile_roi(tiles[i]);
+        OIIO_CHECK_EQUAL(r.xbegin, 64 * (i % 2));
+        OIIO_CHECK_EQUAL(r.ybegin, 64 * (i / 2));
+        OIIO_CHECK_EQUAL(r.nchannels(), 3);
+        ic->release_tile(tiles[i]);
+    }
+
+    // The whole image
+    OIIO_CHECK_EQUAL(ic->get_tiles(hand, nullptr, 0, 0, ROI(), tiles), 16);
+    for (auto t : tiles)
+        ic->release_tile(t);
+    OIIO_CHECK_EQUAL(ic->get_tiles(hand, nullptr, 0, 100, ROI(), tiles), -1);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_microcache()
+{
+    Strutil::print("\nTesting microcache_size\n");
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    ic->attribute("autotile", 64);
+    // Cycle among four tiles: after the first round, each one is found in
+    // the microcache, unless it only keeps the last tile.
+    auto cycle = [&]() {
+        ic->reset_stats();
+        for (int round = 0; round < 3; ++round) {
+            for (int t = 0; t < 4; ++t) {
+                auto tile = ic->get_tile(checkertex, 0, 0, 64 * t + 1, 1, 0);
+                OIIO_CHECK_ASSERT(tile);
+                ic->release_tile(tile);
+            }
+        }
+        long long hits = -1;
+        OIIO_CHECK_ASSERT(ic->getattribute("stat:find_tile_microcache_hits",
+                                           TypeInt64, &hits));
+        return hits;
+    };
+    int size = 0;
+    OIIO_CHECK_ASSERT(ic->getattribute("microcache_size", size));
+    OIIO_CHECK_EQUAL(size, 16);
+    OIIO_CHECK_EQUAL(cycle(), 8);
+    ic->attribute("microcache_size", 0);
+    OIIO_CHECK_EQUAL(cycle(), 0);
+    ImageCache::destroy(ic);
+}
+
+
+static void
+test_resident_tiles()
+{
+    Strutil::print("\nTesting get_resident_tiles\n");
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    ic->attribute("autotile", 64);
+    TextureSystem* ts = TextureSystem::create(false, ic);
+    auto perthread    = ts->get_perthread_info();
+    auto hand         = ts->get_texture_handle(checkertex, perthread);
+    OIIO_CHECK_ASSERT(hand);
+    const size_t tilebytes = 64 * 64 * 3 * TypeHalf.size();
+
+    // Nothing has been read yet
+    std::vector<unsigned char> pagetable, staging;
+    std::vector<int> newtiles;
+    OIIO_CHECK_ASSERT(ts->get_resident_tiles(hand, perthread, 0, 0,
+                                             pagetable, newtiles, staging));
+    OIIO_CHECK_EQUAL(pagetable.size(), size_t(16));
+    OIIO_CHECK_EQUAL(newtiles.size(), size_t(0));
+    OIIO_CHECK_EQUAL(staging.size(), size_t(0));
+
+    // Read a region straddling four tiles
+    float pixels[10 * 10 * 3];
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 60, 70, 60, 70, 0, 1,
+                                     TypeFloat, pixels));
+    OIIO_CHECK_ASSERT(ts->get_resident_tiles(hand, perthread, 0, 0,
+                                             pagetable, newtiles, staging));
+    OIIO_CHECK_ASSERT(newtiles == std::vector<int>({ 0, 1, 4, 5 }));
+    OIIO_CHECK_EQUAL(staging.size(), 4 * tilebytes);
+    for (int i = 0; i < 16; ++i) {
+        bool read = (i == 0 || i == 1 || i == 4 || i == 5);
+        OIIO_CHECK_EQUAL(int(pagetable[i]), int(read));
+    }
+
+    // Only tiles that weren't in the previous page table are new
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 200, 210, 10, 20, 0, 1,
+                                     TypeFloat, pixels));
+    OIIO_CHECK_ASSERT(ts->get_resident_tiles(hand, perthread, 0, 0,
+                                             pagetable, newtiles, staging));
+    OIIO_CHECK_ASSERT(newtiles == std::vector<int>({ 3 }));
+    OIIO_CHECK_EQUAL(staging.size(), tilebytes);
+    OIIO_CHECK_ASSERT(pagetable[0] && pagetable[3]);
+
+    // The staged tile holds the cached pixels: (192,0) is black and
+    // (208,0) is white on this 16 pixel checkerboard.
+    const half* texels = (const half*)staging.data();
+    OIIO_CHECK_EQUAL(float(texels[0]), 0.0f);
+    OIIO_CHECK_EQUAL(float(texels[16 * 3]), 1.0f);
+
+    // No such MIP level
+    OIIO_CHECK_ASSERT(!ts->get_resident_tiles(hand, perthread, 0, 100,
+                                              pagetable, newtiles, staging));
+    OIIO_CHECK_ASSERT(ts->has_error());
+    ts->geterror();
+    TextureSystem::destroy(ts);
+    ImageCache::destroy(ic);
+}
+
+
+static void
+test_texture_file_stats()
+{
+    Strutil::print("\nTesting per-file texture statistics\n");
+    ImageCache* ic    = ImageCache::create(false /* not shared */);
+    TextureSystem* ts = TextureSystem::create(false, ic);
+    ts->attribute("statistics:level", 3);
+    auto perthread = ts->get_perthread_info();
+    auto hand      = ts->get_texture_handle(checkertex, perthread);
+    OIIO_CHECK_ASSERT(hand);
+
+    // A batch of bilinear lookups, which can all be done at once
+    TextureOptBatch opt;
+    opt.mipmode    = Tex::MipMode::OneLevel;
+    opt.interpmode = Tex::InterpMode::Bilinear;
+    opt.swrap = opt.twrap = Tex::Wrap::Clamp;
+    alignas(Tex::BatchAlign) float s[Tex::BatchWidth], t[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float d[Tex::BatchWidth], zero[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float result[3 * Tex::BatchWidth];
+    for (int i = 0; i < Tex::BatchWidth; ++i) {
+        s[i]    = (i + 0.5f) / Tex::BatchWidth;
+        t[i]    = 0.5f;
+        d[i]    = 1.0f / 256;
+        zero[i] = 0.0f;
+    }
+    OIIO_CHECK_ASSERT(ts->texture(hand, perthread, opt, Tex::RunMaskOn, s, t,
+                                  d, zero, zero, d, 3, result));
+    auto get = [&](string_view name, TypeDesc type, void* val) {
+        return ts->get_texture_info(hand, perthread, 0, ustring(name), type,
+                                    val);
+    };
+    long long queries = 0, probes = 0, miphits[2] = { 0, 0 };
+    float time        = 0.0f;
+    OIIO_CHECK_ASSERT(get("stat:texture_queries", TypeInt64, &queries));
+    OIIO_CHECK_ASSERT(get("stat:texture_probes", TypeInt64, &probes));
+    OIIO_CHECK_ASSERT(get("stat:texture_time", TypeFloat, &time));
+    OIIO_CHECK_ASSERT(get("stat:texture_mip_hits",
+                          TypeDesc(TypeDesc::INT64, 2), miphits));
+    OIIO_CHECK_EQUAL(queries, Tex::BatchWidth);
+    OIIO_CHECK_EQUAL(probes, Tex::BatchWidth);
+    OIIO_CHECK_EQUAL(miphits[0], Tex::BatchWidth);
+    OIIO_CHECK_EQUAL(miphits[1], 0);
+    OIIO_CHECK_GT(time, 0.0f);
+
+    // A single-point lookup adds to the same counters
+    TextureOpt sopt;
+    sopt.mipmode    = TextureOpt::MipModeOneLevel;
+    sopt.interpmode = TextureOpt::InterpBilinear;
+    float time1     = time;
+    OIIO_CHECK_ASSERT(ts->texture(hand, perthread, sopt, 0.5f, 0.5f, d[0], 0.0f,
+                                  0.0f, d[0], 3, result));
+    OIIO_CHECK_ASSERT(get("stat:texture_queries", TypeInt64, &queries));
+    OIIO_CHECK_ASSERT(get("stat:texture_time", TypeFloat, &time));
+    OIIO_CHECK_EQUAL(queries, Tex::BatchWidth + 1);
+    OIIO_CHECK_GT(time, time1);
+    TextureSystem::destroy(ts);
+    ImageCache::destroy(ic);
+}
+
+
+static void
+test_texture3d_batch()
+{
+    Strutil::print("\nTesting batched texture3d\n");
+    // A volume whose tiles don't divide it evenly, so that some batches
+    // have lanes in several tiles and lanes straddling tile edges.
+    ImageSpec spec(20, 18, 3, TypeFloat);
+    spec.depth = spec.full_depth = 12;
+    ImageBuf vol(spec);
+    for (ImageBuf::Iterator<float> p(vol); !p.done(); ++p)
+        for (int c = 0; c < 3; ++c)
+            p[c] = float((p.x() * 7 + p.y() * 13 + p.z() * 29 + c * 5) % 17);
+    vol.set_write_tiles(8, 8, 8);
+    OIIO_CHECK_ASSERT(vol.write("tmp-volume.tif"));
+
+    ImageCache* ic    = ImageCache::create(false /* not shared */);
+    TextureSystem* ts = TextureSystem::create(false, ic);
+    auto perthread    = ts->get_perthread_info();
+    auto hand = ts->get_texture_handle(ustring("tmp-volume.tif"), perthread);
+    OIIO_CHECK_ASSERT(hand);
+
+    constexpr int BW = Tex::BatchWidth;
+    alignas(Tex::BatchAlign) float P[3 * BW], dPdx[3 * BW], dPdy[3 * BW],
+        dPdz[3 * BW];
+    alignas(Tex::BatchAlign) float result[3 * BW], drds[3 * BW],
+        drdt[3 * BW], drdr[3 * BW];
+    for (int i = 0; i < BW; ++i) {
+        P[i]          = 0.05f + 0.9f * float(i) / BW;
+        P[BW + i]     = 0.3f + 0.037f * i;
+        P[2 * BW + i] = 0.6f - 0.029f * i;
+        for (int k = 0; k < 3; ++k) {
+            dPdx[k * BW + i] = k == 0 ? 0.01f : 0.0f;
+            dPdy[k * BW + i] = k == 1 ? 0.01f : 0.0f;
+            dPdz[k * BW + i] = k == 2 ? 0.01f : 0.0f;
+        }
+    }
+    // Trilinear lanes take the lane-parallel path, closest ones don't
+    for (auto interp :
+         { Tex::InterpMode::Bilinear, Tex::InterpMode::Closest }) {
+        TextureOptBatch opt;
+        opt.interpmode = interp;
+        OIIO_CHECK_ASSERT(ts->texture3d(hand, perthread, opt, Tex::RunMaskOn,
+                                        P, dPdx, dPdy, dPdz, 3, result, drds,
+                                        drdt, drdr));
+        // Every lane matches a one-point lookup
+        TextureOpt sopt;
+        sopt.interpmode = TextureOpt::InterpMode(interp);
+        for (int i = 0; i < BW; ++i) {
+            auto lane = [&](const float* v) {
+                return V3fParam(v[i], v[BW + i], v[2 * BW + i]);
+            };
+            float r[3], ds[3], dt[3], dr[3];
+            OIIO_CHECK_ASSERT(ts->texture3d(hand, perthread, sopt, lane(P),
+                                            lane(dPdx), lane(dPdy),
+                                            lane(dPdz), 3, r, ds, dt, dr));
+            for (int c = 0; c < 3; ++c) {
+                OIIO_CHECK_EQUAL_THRESH(result[c * BW + i], r[c], 1.0e-4f);
+                OIIO_CHECK_EQUAL_THRESH(drds[c * BW + i], ds[c], 1.0e-3f);
+                OIIO_CHECK_EQUAL_THRESH(drdt[c * BW + i], dt[c], 1.0e-3f);
+                OIIO_CHECK_EQUAL_THRESH(drdr[c * BW + i], dr[c], 1.0e-3f);
+            }
+        }
+    }
+    TextureSystem::destroy(ts);
+    ImageCache::destroy(ic);
+    Filesystem::remove("tmp-volume.tif");
+}
+
+
+// Batched texture3d of a sparse volume: a constant value everywhere but
+// one brick. Lanes whose corners straddle bricks (including the varying
+// one) must match one-point lookups, and a batch touching only constant
+// bricks is exactly that constant, with zero derivatives.
+static void
+test_texture3d_sparse_bricks()
+{
+    Strutil::print("\nTesting batched texture3d across sparse bricks\n");
+    const int res = 24;
+    ImageSpec spec(res, res, 1, TypeFloat);
+    spec.depth = spec.full_depth = res;
+    ImageBuf vol(spec);
+    for (ImageBuf::Iterator<float> p(vol); !p.done(); ++p) {
+        bool brick = p.x() >= 8 && p.x() < 16 && p.y() >= 8 && p.y() < 16
+                     && p.z() >= 8 && p.z() < 16;
+        p[0] = brick ? float((p.x() * 3 + p.y() * 5 + p.z() * 7) % 11) / 10
+                     : 0.25f;
+    }
+    vol.set_write_tiles(8, 8, 8);
+    OIIO_CHECK_ASSERT(vol.write("tmp-sparse.tif"));
+
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    OIIO_CHECK_ASSERT(ic->attribute("share_constant_tiles", 1));
+    TextureSystem* ts = TextureSystem::create(false, ic);
+    auto perthread    = ts->get_perthread_info();
+    auto hand = ts->get_texture_handle(ustring("tmp-sparse.tif"), perthread);
+    OIIO_CHECK_ASSERT(hand);
+
+    constexpr int BW = Tex::BatchWidth;
+    alignas(Tex::BatchAlign) float P[3 * BW], dPdx[3 * BW], dPdy[3 * BW],
+        dPdz[3 * BW];
+    alignas(Tex::BatchAlign) float result[BW], drds[BW], drdt[BW], drdr[BW];
+    for (int i = 0; i < 3 * BW; ++i) {
+        int k   = i / BW;
+        dPdx[i] = k == 0 ? 0.001f : 0.0f;
+        dPdy[i] = k == 1 ? 0.001f : 0.0f;
+        dPdz[i] = k == 2 ? 0.001f : 0.0f;
+    }
+    TextureOptBatch opt;
+    opt.interpmode = Tex::InterpMode::Bilinear;
+
+    // Along the edge shared by the constant bricks at y = 0 and y = 8,
+    // away from the varying brick
+    for (int i = 0; i < BW; ++i) {
+        P[i]          = (17.0f + 6.0f * i / BW) / res;
+        P[BW + i]     = 8.0f / res;
+        P[2 * BW + i] = (2.0f + 0.3f * i) / res;
+    }
+    OIIO_CHECK_ASSERT(ts->texture3d(hand, perthread, opt, Tex::RunMaskOn, P,
+                                    dPdx, dPdy, dPdz, 1, result, drds, drdt,
+                                    drdr));
+    for (int i = 0; i < BW; ++i) {
+        OIIO_CHECK_EQUAL(result[i], 0.25f);
+        OIIO_CHECK_EQUAL(drds[i], 0.0f);
+        OIIO_CHECK_EQUAL(drdt[i], 0.0f);
+        OIIO_CHECK_EQUAL(drdr[i], 0.0f);
+    }
+
+    // Around the varying brick's corner at (8,8,8) and its faces, where
+    // the eight corners of a lane can come from up to eight bricks
+    for (int i = 0; i < BW; ++i) {
+        P[i]          = (8.0f + 0.37f * (i % 3) - 0.3f) / res;
+        P[BW + i]     = (8.0f + 0.41f * (i % 4) - 0.6f) / res;
+        P[2 * BW + i] = (8.0f + 0.29f * (i % 5) - 0.5f) / res;
+    }
+    OIIO_CHECK_ASSERT(ts->texture3d(hand, perthread, opt, Tex::RunMaskOn, P,
+                                    dPdx, dPdy, dPdz, 1, result, drds, drdt,
+                                    drdr));
+    TextureOpt sopt;
+    sopt.interpmode = TextureOpt::InterpBilinear;
+    for (int i = 0; i < BW; ++i) {
+        auto lane = [&](const float* v) {
+            return V3fParam(v[i], v[BW + i], v[2 * BW + i]);
+        };
+        float r, ds, dt, dr;
+        OIIO_CHECK_ASSERT(ts->texture3d(hand, perthread, sopt, lane(P),
+                                        lane(dPdx), lane(dPdy), lane(dPdz), 1,
+                                        &r, &ds, &dt, &dr));
+        OIIO_CHECK_EQUAL_THRESH(result[i], r, 1.0e-4f);
+        OIIO_CHECK_EQUAL_THRESH(drds[i], ds, 1.0e-3f);
+        OIIO_CHECK_EQUAL_THRESH(drdt[i], dt, 1.0e-3f);
+        OIIO_CHECK_EQUAL_THRESH(drdr[i], dr, 1.0e-3f);
+    }
+    TextureSystem::destroy(ts);
+    ImageCache::destroy(ic);
+    Filesystem::remove("tmp-sparse.tif");
+}
+
+
+
+static void
+test_read_ahead()
+{
+    Strutil::print("\nTesting tile read-ahead\n");
+    ustring tiledtif("imagecache_test_tiled.tif");
+    ImageBuf check(ImageSpec(256, 256, 3, TypeUInt8));
+    ImageBufAlgo::checker(check, 16, 16, 1, { 0.0f, 0.0f, 0.0f },
+                          { 1.0f, 1.0f, 1.0f }, 0, 0, 0);
+    check.set_write_tiles(64, 64);
+    OIIO_CHECK_ASSERT(check.write(tiledtif));
+    files_to_delete.push_back(tiledtif);
+
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    OIIO_CHECK_ASSERT(ic->attribute("read_ahead_tiles", 4));
+    // One miss at the start of a 4-tile row brings in the whole row
+    float pixel[3] = { -1.0f, -1.0f, -1.0f };
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtif, 0, 0, 17, 18, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    long long ahead = 0;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:tiles_read_ahead", TypeInt64, &ahead));
+    OIIO_CHECK_EQUAL(ahead, 3);
+    // ... and the read-ahead tiles hold the right pixels
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtif, 0, 0, 200, 201, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 0.0f);
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:tiles_read_ahead", TypeInt64, &ahead));
+    OIIO_CHECK_EQUAL(ahead, 3);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_mmap_tiles()
+{
+    Strutil::print("\nTesting memory-mapped tiles\n");
+    // An uncompressed tiled TIFF can be used straight from the mapping
+    ustring rawtif("imagecache_test_mmap.tif");
+    ImageBuf check(ImageSpec(256, 256, 3, TypeUInt8));
+    ImageBufAlgo::checker(check, 16, 16, 1, { 0.0f, 0.0f, 0.0f },
+                          { 1.0f, 1.0f, 1.0f }, 0, 0, 0);
+    check.set_write_tiles(64, 64);
+    check.specmod().attribute("compression", "none");
+    OIIO_CHECK_ASSERT(check.write(rawtif));
+    files_to_delete.push_back(rawtif);
+
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    OIIO_CHECK_ASSERT(ic->attribute("mmap_tiles", 1));
+    float pixel[3] = { -1.0f, -1.0f, -1.0f };
+    OIIO_CHECK_ASSERT(ic->get_pixels(rawtif, 0, 0, 17, 18, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    OIIO_CHECK_ASSERT(ic->get_pixels(rawtif, 0, 0, 1, 2, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 0.0f);
+    long long mapped = 0, mem = -1;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:tiles_mmapped", TypeInt64, &mapped));
+    OIIO_CHECK_ASSERT(mapped > 0);
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:cache_memory_used", TypeInt64, &mem));
+    OIIO_CHECK_EQUAL(mem, 0);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_io_uring()
+{
+    Strutil::print("\nTesting io_uring reads\n");
+    // Results must match regardless of whether the kernel supports it
+    ustring tiledtif("imagecache_test_mmap.tif");  // from test_mmap_tiles
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    OIIO_CHECK_ASSERT(ic->attribute("io_uring", 1));
+    float pixel[3] = { -1.0f, -1.0f, -1.0f };
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtif, 0, 0, 17, 18, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtif, 0, 0, 1, 2, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 0.0f);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_tile_trace()
+{
+    Strutil::print("\nTesting tile access trace\n");
+    ustring tiledtif("imagecache_test_tiled.tif");  // from test_read_ahead
+    std::string tracefile = "imagecache_test_trace.json";
+    ImageCache* ic        = ImageCache::create(false /* not shared */);
+    OIIO_CHECK_ASSERT(ic->attribute("trace_tiles", 100));
+    float pixel[3];
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtif, 0, 0, 17, 18, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_ASSERT(ic->write_tile_trace(tracefile));
+    std::string trace;
+    OIIO_CHECK_ASSERT(Filesystem::read_text_file(tracefile, trace));
+    OIIO_CHECK_ASSERT(Strutil::contains(trace, tiledtif));
+    OIIO_CHECK_ASSERT(Strutil::contains(trace, "\"records\""));
+    OIIO_CHECK_ASSERT(Strutil::contains(trace, ", 0, 0, 0, 0, 0, 0, 0, "));
+    ImageCache::destroy(ic);
+    Filesystem::remove(tracefile);
+}
+
+
+
+static void
+test_numa_local_tiles()
+{
+    Strutil::print("\nTesting NUMA-local tiles\n");
+    ustring tiledtif("imagecache_test_tiled.tif");  // from test_read_ahead
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    OIIO_CHECK_ASSERT(ic->attribute("numa_local_tiles", 1));
+    // Visit three tiles, then go back to the first, which has fallen out
+    // of the two-tile microcache and so is a hit in the main cache.
+    float pixel[3];
+    for (int x : { 17, 81, 145, 17 })
+        OIIO_CHECK_ASSERT(ic->get_pixels(tiledtif, 0, 0, x, x + 1, 1, 2, 0,
+                                         1, TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    long long local = 0, remote = 0;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:numa_local_hits", TypeInt64, &local));
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:numa_remote_hits", TypeInt64, &remote));
+    OIIO_CHECK_ASSERT(local + remote >= 1);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_share_constant_tiles()
+{
+    Strutil::print("\nTesting shared constant tiles\n");
+    // Checker squares that line up with the tiles make every tile one of
+    // two constant values.
+    ustring flattif("imagecache_test_flat.tif");
+    ImageBuf check(ImageSpec(256, 256, 3, TypeUInt8));
+    ImageBufAlgo::checker(check, 64, 64, 1, { 0.0f, 0.0f, 0.0f },
+                          { 1.0f, 1.0f, 1.0f }, 0, 0, 0);
+    check.set_write_tiles(64, 64);
+    OIIO_CHECK_ASSERT(check.write(flattif));
+    files_to_delete.push_back(flattif);
+
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    OIIO_CHECK_ASSERT(ic->attribute("share_constant_tiles", 1));
+    std::vector<float> pixels(256 * 256 * 3, -1.0f);
+    OIIO_CHECK_ASSERT(ic->get_pixels(flattif, 0, 0, 0, 256, 0, 256, 0, 1,
+                                     TypeFloat, pixels.data()));
+    OIIO_CHECK_EQUAL(pixels[(17 * 256 + 17) * 3], 0.0f);
+    OIIO_CHECK_EQUAL(pixels[(17 * 256 + 81) * 3], 1.0f);
+    OIIO_CHECK_EQUAL(pixels[(81 * 256 + 81) * 3], 0.0f);
+    long long shared = 0, mem = -1;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:tiles_constant_shared", TypeInt64, &shared));
+    OIIO_CHECK_EQUAL(shared, 16);
+    // Only the two distinct blocks are charged to the cache
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:cache_memory_used", TypeInt64, &mem));
+    OIIO_CHECK_ASSERT(mem > 0 && mem < 3 * 64 * 64 * 3);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_maketx_constant_tiles()
+{
+    Strutil::print("\nTesting maketx tile stats and synthesized tiles\n");
+    // A 64x64 RGBA texture of 16x16 tiles, all one opaque color except:
+    // tile 2 has noisy color but opaque alpha, tile 3 is a constant
+    // transparent color, and tile 4 is noisy in every channel.
+    const float color[] = { 0.25f, 0.5f, 0.75f, 1.0f };
+    const float clear[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    ImageBuf src(ImageSpec(64, 64, 4, TypeFloat));
+    ImageBufAlgo::fill(src, color);
+    ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f, true, 1,
+                        ROI(32, 48, 0, 16, 0, 1, 0, 3));
+    ImageBufAlgo::fill(src, clear, ROI(48, 64, 0, 16));
+    ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f, false, 2,
+                        ROI(0, 16, 16, 32));
+
+    ustring tex("imagecache_test_tilestats.exr");
+    ImageSpec config;
+    config.tile_width  = 16;
+    config.tile_height = 16;
+    config.attribute("maketx:tile_stats", 1);
+    OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture,
+                                                 src, tex, config));
+    files_to_delete.push_back(tex);
+
+    ImageCache* ic        = ImageCache::create(false /* not shared */);
+    const ImageSpec* spec = ic->imagespec(tex);
+    OIIO_CHECK_ASSERT(spec);
+    if (!spec) {
+        ImageCache::destroy(ic);
+        return;
+    }
+    OIIO_CHECK_EQUAL(spec->get_string_attribute("oiio:TileAlpha"),
+                     "oot-oooooooooooo");
+    auto consttiles = Strutil::splits(
+        spec->get_string_attribute("oiio:ConstantTiles"), " ");
+    OIIO_CHECK_EQUAL(consttiles.size(), size_t(14));
+    OIIO_CHECK_ASSERT(std::find(consttiles.begin(), consttiles.end(),
+                                "3:0,0,0,0")
+                      != consttiles.end());
+
+    // The constant tiles are filled in without reading, and the whole
+    // level still matches the source.
+    std::vector<float> pixels(64 * 64 * 4, -1.0f);
+    OIIO_CHECK_ASSERT(ic->get_pixels(tex, 0, 0, 0, 64, 0, 64, 0, 1,
+                                     TypeFloat, pixels.data()));
+    ImageBuf cached(ImageSpec(64, 64, 4, TypeFloat), pixels.data());
+    auto comp = ImageBufAlgo::compare(cached, src, 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    long long synthesized = 0;
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:tiles_constant_synthesized",
+                                       TypeInt64, &synthesized));
+    OIIO_CHECK_EQUAL(synthesized, 14);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_release_jpeg()
+{
+    Strutil::print("\nTesting JPEG reads with few open files\n");
+    // The JPEG reader needs a real file proxy, so the cache must open it
+    // the usual way rather than through a proxy it can detach.
+    ustring jpg("imagecache_test_release.jpg");
+    ustring tiledtif("imagecache_test_tiled.tif");  // from test_read_ahead
+    ImageBuf check(ImageSpec(128, 128, 3, TypeUInt8));
+    ImageBufAlgo::checker(check, 32, 32, 1, { 0.0f, 0.0f, 0.0f },
+                          { 1.0f, 1.0f, 1.0f }, 0, 0, 0);
+    OIIO_CHECK_ASSERT(check.write(jpg));
+    files_to_delete.push_back(jpg);
+
+    for (int uring : { 0, 1 }) {
+        ImageCache* ic = ImageCache::create(false /* not shared */);
+        OIIO_CHECK_ASSERT(ic->attribute("max_open_files", 1));
+        OIIO_CHECK_ASSERT(ic->attribute("io_uring", uring));
+        // Alternate files so each read finds the other one open
+        float pixel[3] = { -1.0f, -1.0f, -1.0f };
+        for (int i = 0; i < 4; ++i) {
+            OIIO_CHECK_ASSERT(ic->get_pixels(jpg, 0, 0, 48, 49, 16, 17, 0, 1,
+                                             TypeFloat, pixel));
+            OIIO_CHECK_EQUAL_THRESH(pixel[0], 1.0f, 0.02f);
+            OIIO_CHECK_ASSERT(ic->get_pixels(jpg, 0, 0, 16, 17, 16, 17, 0, 1,
+                                             TypeFloat, pixel));
+            OIIO_CHECK_EQUAL_THRESH(pixel[0], 0.0f, 0.02f);
+            OIIO_CHECK_ASSERT(ic->get_pixels(tiledtif, 0, 0, 17, 18, 1, 2, 0,
+                                             1, TypeFloat, pixel));
+            OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+            ic->invalidate(jpg);  // reopen it next time around
+        }
+        ImageCache::destroy(ic);
+    }
+}
+
+
+
+static void
+test_invalidate_all_force()
+{
+    Strutil::print("\nTesting invalidate_all(force) memory release\n");
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    std::vector<float> pixels(256 * 256 * 3);
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 0, 256, 0, 256, 0, 1,
+                                     TypeFloat, pixels.data()));
+    long long before = 0, after = -1;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:cache_memory_used", TypeInt64, &before));
+    OIIO_CHECK_ASSERT(before > 0);
+    // Forced, the tiles go right away rather than waiting for a sweep
+    ic->invalidate_all(true);
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:cache_memory_used", TypeInt64, &after));
+    OIIO_CHECK_EQUAL(after, 0);
+    // And the file reads back just the same
+    float pixel[3] = { -1.0f, -1.0f, -1.0f };
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 17, 18, 1, 2, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_slab_memory()
+{
+    Strutil::print("\nTesting autotile slab memory accounting\n");
+    // Each 64-scanline row of this image decodes into a 3 MB slab, which
+    // lives as long as any one of its tiles does.
+    ustring scanfile("imagecache_test_slabs.tif");
+    ImageBuf big(ImageSpec(4096, 1024, 3, TypeFloat));
+    ImageBufAlgo::fill(big, { 0.5f, 0.25f, 0.125f });
+    OIIO_CHECK_ASSERT(big.write(scanfile));
+    files_to_delete.push_back(scanfile);
+
+    ImageCache* ic = ImageCache::create(false /* not shared */);
+    OIIO_CHECK_ASSERT(ic->attribute("autotile", 64));
+    OIIO_CHECK_ASSERT(ic->attribute("max_memory_MB", 10.0f));
+    // Touch just the first tile of each row. If a slab were charged only
+    // for its live tiles, all 16 would stay in memory.
+    float pixel[3];
+    for (int y = 0; y < 1024; y += 64)
+        OIIO_CHECK_ASSERT(ic->get_pixels(scanfile, 0, 0, 0, 1, y, y + 1, 0,
+                                         1, TypeFloat, pixel));
+    // A neighbor whose own tile is gone comes back from its row's slab
+    // only if the slab is still alive.
+    long long fromslab = -1;
+    for (int y = 0; y < 1024; y += 64)
+        OIIO_CHECK_ASSERT(ic->get_pixels(scanfile, 0, 0, 64, 65, y, y + 1, 0,
+                                         1, TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[1], 0.25f);
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:tiles_from_slab", TypeInt64, &fromslab));
+    OIIO_CHECK_ASSERT(fromslab >= 0 && fromslab <= 8);
+    long long mem = -1;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:cache_memory_used", TypeInt64, &mem));
+    OIIO_CHECK_ASSERT(mem <= 16 * 1024 * 1024);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_headerindex()
+{
+    Strutil::print("\nTesting the persistent header index\n");
+    std::string dir = "imagecache_test_headerindex";
+    Filesystem::remove_all(dir);
+    ustring file("imagecache_test_hdx.tif");
+    ImageBuf buf(ImageSpec(64, 64, 3, TypeUInt8));
+    buf.specmod().attribute("compression", "none");
+    ImageBufAlgo::fill(buf, { 0.5f, 0.5f, 0.5f });
+    OIIO_CHECK_ASSERT(buf.write(file));
+    files_to_delete.push_back(file);
+
+    // Open a file with a fresh cache and return its spec, counting how
+    // the index was used.
+    long long hits, misses, writes;
+    auto openspec = [&](ImageSpec& spec) {
+        ImageCache* ic = ImageCache::create(false /* not shared */);
+        OIIO_CHECK_ASSERT(ic->attribute("headerindex:path", dir));
+        bool ok = ic->get_imagespec(file, spec);
+        ic->getattribute("stat:headerindex_hits", TypeInt64, &hits);
+        ic->getattribute("stat:headerindex_misses", TypeInt64, &misses);
+        ic->getattribute("stat:headerindex_writes", TypeInt64, &writes);
+        ImageCache::destroy(ic);
+        return ok;
+    };
+
+    // The first cache misses and records the file; the next one hits
+    ImageSpec spec;
+    OIIO_CHECK_ASSERT(openspec(spec));
+    OIIO_CHECK_EQUAL(misses, 1);
+    OIIO_CHECK_EQUAL(writes, 1);
+    OIIO_CHECK_ASSERT(openspec(spec));
+    OIIO_CHECK_EQUAL(hits, 1);
+    OIIO_CHECK_EQUAL(spec.width, 64);
+
+    // Rewriting the file, even to the same size within the same second,
+    // makes the entry stale.
+    int64_t mtime = Filesystem::last_write_time_ns(file);
+    ImageBufAlgo::fill(buf, { 0.25f, 0.25f, 0.25f });
+    OIIO_CHECK_ASSERT(buf.write(file));
+    if (Filesystem::last_write_time_ns(file) != mtime) {
+        OIIO_CHECK_ASSERT(openspec(spec));
+        OIIO_CHECK_EQUAL(hits, 0);
+        OIIO_CHECK_EQUAL(misses, 1);
+        OIIO_CHECK_EQUAL(writes, 1);
+    }
+
+    // A truncated entry is a miss, not a crash, and is rewritten
+    std::vector<std::string> entries;
+    Filesystem::get_directory_entries(dir, entries, true, "\\.hdr$");
+    OIIO_CHECK_EQUAL(entries.size(), 1);
+    for (auto& e : entries) {
+        std::string contents;
+        OIIO_CHECK_ASSERT(Filesystem::read_text_file(e, contents));
+        Filesystem::write_text_file(e, contents.substr(0, 40));
+    }
+    OIIO_CHECK_ASSERT(openspec(spec));
+    OIIO_CHECK_EQUAL(hits, 0);
+    OIIO_CHECK_EQUAL(misses, 1);
+    OIIO_CHECK_EQUAL(writes, 1);
+    OIIO_CHECK_EQUAL(spec.width, 64);
+    OIIO_CHECK_ASSERT(openspec(spec));
+    OIIO_CHECK_EQUAL(hits, 1);
+    Filesystem::remove_all(dir);
+}
+
+
+
+// get_pixels of regions spanning many rows of tiles, reaching outside the
+// image, and of a channel subset into a strided buffer, must match the
+// file's pixels both when all the tiles are looked up in one batch (in a
+// big cache) and when they go a row of tiles at a time (in a small one).
+static void
+test_get_pixels_regions()
+{
+    Strutil::print("\nTesting IC get_pixels of multi-row regions\n");
+    ustring file("imagecache_test_regions.tif");
+    const int W = 1000, H = 700;
+    ImageBuf A(ImageSpec(W, H, 4, TypeUInt16));
+    ImageBufAlgo::fill(A, { 0.0f, 0.1f, 0.2f, 1.0f },
+                       { 1.0f, 0.3f, 0.0f, 1.0f }, { 0.0f, 0.9f, 1.0f, 0.5f },
+                       { 0.5f, 0.5f, 0.5f, 0.0f });
+    A.set_write_tiles(64, 64);
+    OIIO_CHECK_ASSERT(A.write(file));
+    files_to_delete.push_back(file);
+    ImageBuf B(file.string());
+    OIIO_CHECK_ASSERT(B.read(0, 0, true, TypeFloat));
+
+    // Check a result of channels [chbegin,chend) of the region, stored
+    // `pixelfloats` floats apart.
+    auto check = [&](const std::vector<float>& result, int xbegin, int xend,
+                     int ybegin, int yend, int chbegin, int chend,
+                     int pixelfloats) {
+        int nwrong = 0;
+        for (int y = ybegin; y < yend; ++y)
+            for (int x = xbegin; x < xend; ++x)
+                for (int c = chbegin; c < chend; ++c) {
+                    bool inside  = x >= 0 && x < W && y >= 0 && y < H;
+                    float v      = inside ? B.getchannel(x, y, 0, c) : 0.0f;
+                    size_t pixel = size_t(y - ybegin) * (xend - xbegin)
+                                   + (x - xbegin);
+                    nwrong += result[pixel * pixelfloats + c - chbegin] != v;
+                }
+        OIIO_CHECK_EQUAL(nwrong, 0);
+    };
+
+    for (float max_memory_MB : { 1024.0f, 10.0f }) {
+        Strutil::print("  with a {} MB cache\n", max_memory_MB);
+        ImageCache* ic = ImageCache::create(false /* not shared */);
+        OIIO_CHECK_ASSERT(ic->attribute("max_memory_MB", max_memory_MB));
+
+        // Inside the image, straddling tile boundaries
+        std::vector<float> result(size_t(980) * 660 * 4, -1.0f);
+        OIIO_CHECK_ASSERT(ic->get_pixels(file, 0, 0, 10, 990, 5, 665, 0, 1,
+                                         TypeFloat, result.data()));
+        check(result, 10, 990, 5, 665, 0, 4, 4);
+
+        // Reaching past every edge, so the margins must be zeroed
+        result.assign(size_t(W + 16) * (H + 12) * 4, -1.0f);
+        OIIO_CHECK_ASSERT(ic->get_pixels(file, 0, 0, -8, W + 8, -4, H + 8, 0,
+                                         1, TypeFloat, result.data()));
+        check(result, -8, W + 8, -4, H + 8, 0, 4, 4);
+
+        // Channels 1-2 into every other pair of floats of the result
+        result.assign(size_t(300) * 400 * 4, -1.0f);
+        OIIO_CHECK_ASSERT(ic->get_pixels(file, 0, 0, 600, 900, 100, 500, 0, 1,
+                                         1, 3, TypeFloat, result.data(),
+                                         4 * sizeof(float)));
+        check(result, 600, 900, 100, 500, 1, 3, 4);
+        int untouched = 0;
+        for (size_t i = 2; i < result.size(); i += 4)
+            untouched += result[i] == -1.0f && result[i + 1] == -1.0f;
+        OIIO_CHECK_EQUAL(untouched, 300 * 400);
+        ImageCache::destroy(ic);
+    }
+}
+
+
+
 int
 main(int /*argc*/, char* /*argv*/[])
 {
@@ -348,7 +1345,29 @@ main(int /*argc*/, char* /*argv*/[])
     test_tileptr();
     test_get_pixels_errors();
     test_custom_threadinfo();
+    test_thread_context();
     test_imagespec();
+    test_prefetch();
+    test_diskcache();
+    test_file_attributes();
+    test_get_tiles();
+    test_microcache();
+    test_resident_tiles();
+    test_texture_file_stats();
+    test_texture3d_batch();
+    test_texture3d_sparse_bricks();
+    test_mmap_tiles();
+    test_io_uring();
+    test_read_ahead();
+    test_tile_trace();
+    test_numa_local_tiles();
+    test_share_constant_tiles();
+    test_maketx_constant_tiles();
+    test_release_jpeg();
+    test_invalidate_all_force();
+    test_slab_memory();
+    test_headerindex();
+    test_get_pixels_regions();
 
     ImageCache* ic = ImageCache::create();
     Strutil::print("\n\n{}\n", ic->getstats(5));
@@ -10,12 +10,17 @@
 
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/deepdata.h>
 #include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/half.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/tiffutils.h>
 #include <OpenImageIO/unittest.h>
 
+#include "imageio_pvt.h"
+
 using namespace OIIO;
 
 
@@ -524,6 +529,1266 @@ test_read_tricky_sizes()
 
 
 
+// Test the asynchronous read calls against the synchronous ones.
+void
+test_read_async()
+{
+    std::cout << "Testing read_scanlines_async / read_tiles_async\n";
+    const int res = 64;
+    ImageBuf src(ImageSpec(res, res, 3, TypeFloat));
+    ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f);
+    char filename[] = "tmp_async.exr";
+    for (bool tiled : { false, true }) {
+        if (tiled)
+            src.set_write_tiles(16, 16);
+        src.write(filename);
+        auto imgin = ImageInput::open(filename);
+        OIIO_CHECK_ASSERT(imgin);
+        if (!imgin)
+            continue;
+        // Start reads of four horizontal bands at once, then wait
+        std::vector<float> buf(res * res * 3, -1.0f);
+        std::vector<std::future<bool>> reads;
+        for (int y = 0; y < res; y += 16) {
+            float* band = buf.data() + y * res * 3;
+            if (tiled)
+                reads.push_back(imgin->read_tiles_async(0, 0, 0, res, y,
+                                                        y + 16, 0, 1, 0, 3,
+                                                        TypeFloat, band));
+            else
+                reads.push_back(imgin->read_scanlines_async(0, 0, y, y + 16,
+                                                            0, 0, 3, TypeFloat,
+                                                            band));
+        }
+        for (auto& r : reads)
+            OIIO_CHECK_ASSERT(r.get());
+        std::vector<float> expected(res * res * 3);
+        src.get_pixels(src.roi(), TypeFloat, expected.data());
+        OIIO_CHECK_ASSERT(buf == expected);
+        // Asking for tiles from a scanline file fails through the future
+        if (!tiled) {
+            OIIO_CHECK_ASSERT(!imgin->read_tiles_async(0, 0, 0, 16, 0, 16, 0,
+                                                       1, 0, 3, TypeFloat,
+                                                       buf.data())
+                                   .get());
+            imgin->geterror();
+        }
+    }
+    Filesystem::remove(filename);
+}
+
+
+// Test reading through a memory-mapped proxy via the open hint.
+void
+test_read_mmap_hint()
+{
+    std::cout << "Testing oiio:ioproxy:mmap\n";
+    ImageBuf src(ImageSpec(37, 19, 3, TypeUInt8));
+    ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f);
+    for (auto ext : { "tga", "bmp", "ppm", "dpx" }) {
+        std::string filename = Strutil::fmt::format("tmp_mmap.{}", ext);
+        src.write(filename);
+        ImageSpec config;
+        config["oiio:ioproxy:mmap"] = 1;
+        ImageBuf mapped(filename, 0, 0, nullptr, &config);
+        OIIO_CHECK_ASSERT(mapped.read(0, 0, true, TypeUInt8));
+        auto comp = ImageBufAlgo::compare(src, mapped, 0.0f, 0.0f);
+        OIIO_CHECK_EQUAL(comp.maxerror, 0.0);
+        Filesystem::remove(filename);
+    }
+}
+
+
+// The common type pairs have vectorized kernels with a scalar tail; make
+// sure both halves round-trip and agree with the scalar conversions.
+void
+test_convert_pixel_values()
+{
+    std::cout << "Testing convert_pixel_values\n";
+    const int n = 37;  // not a multiple of the SIMD width
+    std::vector<uint8_t> u8(n), u8back(n);
+    std::vector<uint16_t> u16(n), u16back(n);
+    std::vector<half> h(n);
+    std::vector<float> f(n);
+    for (int i = 0; i < n; ++i) {
+        u8[i]  = uint8_t(i * 7);
+        u16[i] = uint16_t(i * 1771);
+    }
+    OIIO_CHECK_ASSERT(convert_pixel_values(TypeUInt8, u8.data(), TypeHalf,
+                                           h.data(), n));
+    OIIO_CHECK_ASSERT(convert_pixel_values(TypeHalf, h.data(), TypeUInt8,
+                                           u8back.data(), n));
+    OIIO_CHECK_ASSERT(u8 == u8back);
+    OIIO_CHECK_ASSERT(convert_pixel_values(TypeUInt16, u16.data(), TypeFloat,
+                                           f.data(), n));
+    for (int i = 0; i < n; ++i)
+        OIIO_CHECK_EQUAL(f[i], (convert_type<uint16_t, float>(u16[i])));
+    OIIO_CHECK_ASSERT(convert_pixel_values(TypeFloat, f.data(), TypeUInt16,
+                                           u16back.data(), n));
+    OIIO_CHECK_ASSERT(u16 == u16back);
+    for (int i = 0; i < n; ++i)
+        f[i] = i / float(n - 1) * 1.25f - 0.125f;  // include out of range
+    OIIO_CHECK_ASSERT(convert_pixel_values(TypeFloat, f.data(), TypeUInt8,
+                                           u8.data(), n));
+    OIIO_CHECK_ASSERT(convert_pixel_values(TypeFloat, f.data(), TypeHalf,
+                                           h.data(), n));
+    for (int i = 0; i < n; ++i) {
+        OIIO_CHECK_EQUAL(int(u8[i]), int(convert_type<float, uint8_t>(f[i])));
+        OIIO_CHECK_EQUAL(float(h[i]), float(half(f[i])));
+    }
+}
+
+
+// The plugin manifest is written after a scan of the plugin searchpath,
+// and then stands in for the scan while it's up to date.
+void
+test_plugin_manifest()
+{
+    std::cout << "Testing plugin_manifest\n";
+    std::string manifest = "tmp_plugin_manifest.txt";
+    Filesystem::remove(manifest);
+    OIIO::attribute("plugin_manifest", manifest);
+    // An unrecognized extension makes ImageInput::create rescan plugins
+    OIIO_CHECK_ASSERT(!ImageInput::create("nonexistent.nosuchformat"));
+    std::string text;
+    OIIO_CHECK_ASSERT(Filesystem::read_text_file(manifest, text));
+    OIIO_CHECK_ASSERT(
+        Strutil::starts_with(text, "# OpenImageIO plugin manifest"));
+    OIIO_CHECK_ASSERT(!ImageInput::create("nonexistent.nosuchformat"));
+    OIIO_CHECK_ASSERT(ImageInput::create("tga") != nullptr);
+    OIIO_CHECK_ASSERT(ImageOutput::create("tga") != nullptr);
+    (void)OIIO::geterror();
+    OIIO::attribute("plugin_manifest", "");
+    Filesystem::remove(manifest);
+}
+
+
+// The "oiio:metadata" open hint controls how much Exif is decoded.
+void
+test_metadata_hint()
+{
+    std::cout << "Testing oiio:metadata\n";
+    ImageBuf src(ImageSpec(16, 16, 3, TypeUInt8));
+    src.specmod().attribute("Exif:FNumber", 2.8f);
+    std::string filename = "tmp_metadata.jpg";
+    OIIO_CHECK_ASSERT(src.write(filename));
+    for (string_view hint : { "all", "basic", "lazy", "none" }) {
+        ImageSpec config;
+        config["oiio:metadata"] = hint;
+        auto in = ImageInput::open(filename, &config);
+        OIIO_CHECK_ASSERT(in);
+        if (!in)
+            continue;
+        ImageSpec spec  = in->spec();
+        bool lazy       = hint == "lazy";
+        bool has_fnum   = spec.find_attribute("Exif:FNumber") != nullptr;
+        bool has_raw    = spec.find_attribute("oiio:RawExif") != nullptr;
+        bool wants_fnum = hint == "all" || hint == "basic";
+        OIIO_CHECK_EQUAL(has_fnum, wants_fnum);
+        OIIO_CHECK_EQUAL(has_raw, lazy);
+        if (lazy) {
+            OIIO_CHECK_ASSERT(decode_raw_metadata(spec));
+            OIIO_CHECK_EQUAL_APPROX(spec.get_float_attribute("Exif:FNumber"),
+                                    2.8f);
+            OIIO_CHECK_ASSERT(!spec.find_attribute("oiio:RawExif"));
+        }
+    }
+
+    // Writing a lazily read spec decodes the raw blocks rather than
+    // passing them through to the new file.
+    ImageSpec config;
+    config["oiio:metadata"] = "lazy";
+    auto in                 = ImageInput::open(filename, &config);
+    OIIO_CHECK_ASSERT(in);
+    if (in) {
+        ImageSpec lazyspec = in->spec();
+        in.reset();
+        for (string_view outname : { "tmp_metadata2.jpg", "tmp_metadata2.tif",
+                                     "tmp_metadata2.exr" }) {
+            auto out = ImageOutput::create(outname);
+            OIIO_CHECK_ASSERT(out && out->open(outname, lazyspec));
+            if (!out)
+                continue;
+            OIIO_CHECK_ASSERT(!out->spec().find_attribute("oiio:RawExif"));
+            OIIO_CHECK_ASSERT(out->write_image(TypeUInt8, src.localpixels()));
+            out->close();
+            auto reread = ImageInput::open(outname);
+            OIIO_CHECK_ASSERT(reread);
+            if (reread) {
+                const ImageSpec& spec(reread->spec());
+                OIIO_CHECK_ASSERT(!spec.find_attribute("oiio:RawExif"));
+                if (!Strutil::ends_with(outname, ".exr"))
+                    OIIO_CHECK_EQUAL_APPROX(
+                        spec.get_float_attribute("Exif:FNumber"), 2.8f);
+            }
+            reread.reset();
+            Filesystem::remove(outname);
+        }
+    }
+    Filesystem::remove(filename);
+}
+
+
+// probe_spec must agree with open() on the basic shape of the image.
+void
+test_probe_spec()
+{
+    std::cout << "Testing probe_spec\n";
+    for (string_view ext : { "png", "jpg", "tga" }) {
+        for (int nchans : { 1, 3, 4 }) {
+            if (nchans == 4 && ext == "jpg")
+                continue;
+            ImageBuf src(ImageSpec(37, 19, nchans, TypeUInt8));
+            std::string filename = Strutil::fmt::format("tmp_probe.{}", ext);
+            OIIO_CHECK_ASSERT(src.write(filename));
+            ImageSpec probed;
+            OIIO_CHECK_ASSERT(ImageInput::probe_spec(filename, probed));
+            auto in = ImageInput::open(filename);
+            OIIO_CHECK_ASSERT(in);
+            if (in) {
+                OIIO_CHECK_EQUAL(probed.width, in->spec().width);
+                OIIO_CHECK_EQUAL(probed.height, in->spec().height);
+                OIIO_CHECK_EQUAL(probed.nchannels, in->spec().nchannels);
+                OIIO_CHECK_EQUAL(probed.format, in->spec().format);
+            }
+            Filesystem::remove(filename);
+        }
+    }
+    ImageSpec probed;
+    OIIO_CHECK_ASSERT(!ImageInput::probe_spec("nonexistent.png", probed));
+    OIIO_CHECK_ASSERT(OIIO::geterror().size());
+}
+
+
+
+// Files written through the OpenEXR core library output must read back
+// exactly, for scanline and tiled files, several compression methods, and
+// scanlines that arrive one at a time (so chunks are assembled piecemeal).
+void
+test_exr_core_output()
+{
+    if (!is_imageio_format_name("openexr"))
+        return;
+    std::cout << "Testing openexr:core_output\n";
+    int saved = OIIO::get_int_attribute("openexr:core_output");
+    OIIO::attribute("openexr:core_output", 1);
+    ImageBuf src(ImageSpec(67, 45, 4, TypeHalf));
+    ImageBufAlgo::fill(src, { 0.1f, 0.2f, 0.3f, 1.0f },
+                       { 0.9f, 0.8f, 0.7f, 0.5f }, { 0.0f, 0.5f, 1.0f, 1.0f },
+                       { 1.0f, 1.0f, 0.0f, 0.0f });
+    std::string filename = "tmp_coreout.exr";
+    for (string_view comp : { "none", "rle", "zip", "piz" }) {
+        for (int tile : { 0, 16 }) {
+            ImageBuf out(src);
+            out.specmod()["compression"] = comp;
+            out.set_write_tiles(tile, tile);
+            OIIO_CHECK_ASSERT(out.write(filename));
+            ImageBuf back(filename);
+            auto cr = ImageBufAlgo::compare(back, src, 0.0f, 0.0f);
+            OIIO_CHECK_EQUAL(cr.nfail, 0);
+            OIIO_CHECK_EQUAL(back.spec().tile_width, tile);
+        }
+    }
+    {
+        ImageSpec spec      = src.spec();
+        spec["compression"] = "zip";
+        auto out            = ImageOutput::create(filename);
+        OIIO_CHECK_ASSERT(out && out->open(filename, spec));
+        for (int y = 0; out && y < spec.height; ++y)
+            OIIO_CHECK_ASSERT(out->write_scanline(y, 0, TypeHalf,
+                                                  src.pixeladdr(0, y)));
+        if (out)
+            OIIO_CHECK_ASSERT(out->close());
+        ImageBuf back(filename);
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(back, src, 0.0f, 0.0f).nfail,
+                         0);
+    }
+    OIIO::attribute("openexr:core_output", saved);
+    if (!nodelete)
+        Filesystem::remove(filename);
+}
+
+
+
+// The "jpeg:reduce" hint decodes at a power-of-two fraction of full size,
+// and "jpeg:miplevels" exposes the remaining scales as MIP levels.
+void
+test_jpeg_reduce()
+{
+    std::cout << "Testing jpeg:reduce\n";
+    ImageBuf src(ImageSpec(203, 97, 3, TypeUInt8));
+    ImageBufAlgo::fill(src, { 0.2f, 0.4f, 0.6f });
+    std::string filename = "tmp_reduce.jpg";
+    OIIO_CHECK_ASSERT(src.write(filename));
+
+    ImageSpec config;
+    config["jpeg:reduce"] = 2;
+    ImageSpec probed;
+    OIIO_CHECK_ASSERT(ImageInput::probe_spec(filename, probed, &config));
+    OIIO_CHECK_EQUAL(probed.width, 51);
+    OIIO_CHECK_EQUAL(probed.height, 25);
+    ImageBuf reduced(filename, 0, 0, nullptr, &config);
+    OIIO_CHECK_ASSERT(reduced.read());
+    OIIO_CHECK_EQUAL(reduced.spec().width, 51);
+    OIIO_CHECK_EQUAL(reduced.spec().height, 25);
+    OIIO_CHECK_EQUAL_THRESH(reduced.getchannel(25, 12, 0, 1), 0.4f, 0.02f);
+
+    config["jpeg:reduce"]    = 1;
+    config["jpeg:miplevels"] = 1;
+    auto in                  = ImageInput::open(filename, &config);
+    OIIO_CHECK_ASSERT(in);
+    if (in) {
+        int widths[] = { 102, 51, 26 };
+        for (int m = 2; m >= 0; --m) {
+            OIIO_CHECK_ASSERT(in->seek_subimage(0, m));
+            OIIO_CHECK_EQUAL(in->spec().width, widths[m]);
+            std::vector<unsigned char> pixels(in->spec().image_pixels() * 3);
+            OIIO_CHECK_ASSERT(
+                in->read_image(0, m, 0, 3, TypeUInt8, pixels.data()));
+        }
+        OIIO_CHECK_ASSERT(!in->seek_subimage(0, 3));
+    }
+    in.reset();
+    Filesystem::remove(filename);
+}
+
+
+
+// "jpeg:rawycc" reads the Y, Cb, Cr planes at native subsampling as three
+// subimages, and the JPEG writer accepts the same planes back.
+void
+test_jpeg_rawycc()
+{
+    std::cout << "Testing jpeg:rawycc\n";
+    ImageSpec spec(203, 97, 3, TypeUInt8);
+    spec["jpeg:subsampling"] = "4:2:0";
+    ImageBuf src(spec);
+    ImageBufAlgo::fill(src, { 0.2f, 0.4f, 0.6f }, { 0.8f, 0.6f, 0.1f },
+                       ROI(0, 203, 0, 97));
+    std::string filename = "tmp_rawycc.jpg";
+    OIIO_CHECK_ASSERT(src.write(filename));
+
+    ImageSpec config;
+    config["jpeg:rawycc"] = 1;
+    auto in               = ImageInput::open(filename, &config);
+    OIIO_CHECK_ASSERT(in);
+    if (!in)
+        return;
+    int widths[] = { 203, 102, 102 }, heights[] = { 97, 49, 49 };
+    ImageSpec specs[3];
+    std::vector<unsigned char> planes[3];
+    for (int c = 0; c < 3; ++c) {
+        OIIO_CHECK_ASSERT(in->seek_subimage(c, 0));
+        specs[c] = in->spec();
+        OIIO_CHECK_EQUAL(specs[c].nchannels, 1);
+        OIIO_CHECK_EQUAL(specs[c].width, widths[c]);
+        OIIO_CHECK_EQUAL(specs[c].height, heights[c]);
+        planes[c].resize(specs[c].image_pixels());
+        OIIO_CHECK_ASSERT(
+            in->read_image(c, 0, 0, 1, TypeUInt8, planes[c].data()));
+    }
+    OIIO_CHECK_ASSERT(!in->seek_subimage(3, 0));
+    in.reset();
+
+    // Write the planes back out untouched and make sure they survive.
+    auto out = ImageOutput::create(filename);
+    OIIO_CHECK_ASSERT(out);
+    if (!out)
+        return;
+    for (int c = 0; c < 3; ++c) {
+        OIIO_CHECK_ASSERT(out->open(filename, specs[c],
+                                    c ? ImageOutput::AppendSubimage
+                                      : ImageOutput::Create));
+        OIIO_CHECK_ASSERT(out->write_image(TypeUInt8, planes[c].data()));
+    }
+    OIIO_CHECK_ASSERT(out->close());
+    in = ImageInput::open(filename, &config);
+    OIIO_CHECK_ASSERT(in);
+    if (in) {
+        for (int c = 0; c < 3; ++c) {
+            std::vector<unsigned char> reread(planes[c].size());
+            OIIO_CHECK_ASSERT(
+                in->read_image(c, 0, 0, 1, TypeUInt8, reread.data()));
+            int maxdiff = 0;
+            for (size_t i = 0; i < reread.size(); ++i)
+                maxdiff = std::max(maxdiff, std::abs(reread[i] - planes[c][i]));
+            OIIO_CHECK_LE(maxdiff, 3);
+        }
+    }
+    in.reset();
+    Filesystem::remove(filename);
+}
+
+
+
+// "jpeg2000:miplevels" exposes the codestream's wavelet resolution levels
+// as MIP levels, each decoded at its own reduced size.
+void
+test_jpeg2000_miplevels()
+{
+    if (!is_imageio_format_name("jpeg2000"))
+        return;
+    std::cout << "Testing jpeg2000:miplevels\n";
+    ImageBuf src(ImageSpec(203, 97, 3, TypeUInt8));
+    ImageBufAlgo::fill(src, { 0.2f, 0.4f, 0.6f });
+    std::string filename = "tmp_miplevels.jp2";
+    OIIO_CHECK_ASSERT(src.write(filename));
+
+    ImageSpec config;
+    config["jpeg2000:miplevels"] = 1;
+    auto in                      = ImageInput::open(filename, &config);
+    OIIO_CHECK_ASSERT(in);
+    if (in) {
+        int nlevels = 0;
+        while (in->seek_subimage(0, nlevels)) {
+            int m = nlevels++;
+            OIIO_CHECK_EQUAL(in->spec().width, (203 + (1 << m) - 1) >> m);
+            OIIO_CHECK_EQUAL(in->spec().height, (97 + (1 << m) - 1) >> m);
+            std::vector<unsigned char> pixels(in->spec().image_pixels() * 3);
+            OIIO_CHECK_ASSERT(
+                in->read_image(0, m, 0, 3, TypeUInt8, pixels.data()));
+            OIIO_CHECK_LE(std::abs(int(pixels[1]) - 102), 2);
+        }
+        OIIO_CHECK_GE(nlevels, 2);
+    }
+    in.reset();
+
+    // Without the hint, it's still just the one full-size image.
+    in = ImageInput::open(filename);
+    OIIO_CHECK_ASSERT(in);
+    if (in)
+        OIIO_CHECK_ASSERT(!in->seek_subimage(0, 1));
+    in.reset();
+    Filesystem::remove(filename);
+}
+
+
+
+void
+test_jpeg2000_tiles()
+{
+    if (!is_imageio_format_name("jpeg2000"))
+        return;
+    std::cout << "Testing jpeg2000:tiles\n";
+    ImageSpec spec(200, 130, 3, TypeUInt8);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf src(spec);
+    ImageBufAlgo::fill(src, { 0.1f, 0.3f, 0.9f }, { 0.8f, 0.5f, 0.2f },
+                       { 0.0f, 1.0f, 0.5f }, { 1.0f, 0.0f, 0.0f });
+    std::string filename = "tmp_tiles.jp2";
+    OIIO_CHECK_ASSERT(src.write(filename));
+
+    // The whole image, decoded the usual way
+    ImageBuf whole(filename);
+    OIIO_CHECK_ASSERT(whole.read());
+    OIIO_CHECK_EQUAL(whole.spec().tile_width, 0);
+
+    // Codestream tiles as native tiles, decoded one at a time, must give
+    // the same pixels, and each MIP level keeps uniform tiles.
+    ImageSpec config;
+    config["jpeg2000:tiles"]     = 1;
+    config["jpeg2000:miplevels"] = 1;
+    auto in                      = ImageInput::open(filename, &config);
+    OIIO_CHECK_ASSERT(in);
+    if (in) {
+        OIIO_CHECK_EQUAL(in->spec().tile_width, 64);
+        OIIO_CHECK_EQUAL(in->spec().tile_height, 64);
+        std::vector<unsigned char> pixels(200 * 130 * 3);
+        OIIO_CHECK_ASSERT(
+            in->read_image(0, 0, 0, 3, TypeUInt8, pixels.data()));
+        ImageBuf tiled(ImageSpec(200, 130, 3, TypeUInt8), pixels.data());
+        auto comp = ImageBufAlgo::compare(tiled, whole, 0.0f, 0.0f);
+        OIIO_CHECK_EQUAL(comp.nfail, 0);
+        int nlevels = 0;
+        while (in->seek_subimage(0, nlevels)) {
+            int m = nlevels++;
+            OIIO_CHECK_EQUAL(in->spec().tile_width, 64 >> m);
+            OIIO_CHECK_ASSERT(
+                in->read_image(0, m, 0, 3, TypeUInt8, pixels.data()));
+        }
+        OIIO_CHECK_GE(nlevels, 2);
+    }
+    in.reset();
+    Filesystem::remove(filename);
+}
+
+
+
+// Append one SGI RLE channel scanline (units of bpc big-endian bytes) to
+// `out`: runs of three or more equal values are repeated, the rest are
+// copied literally, and a zero count ends the scanline.
+static void
+sgi_rle_encode(const std::vector<uint16_t>& vals, int bpc,
+               std::vector<unsigned char>& out)
+{
+    auto put = [&](unsigned int v) {
+        if (bpc == 2)
+            out.push_back((unsigned char)(v >> 8));
+        out.push_back((unsigned char)(v & 0xff));
+    };
+    size_t i = 0, n = vals.size();
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && run < 127 && vals[i + run] == vals[i])
+            ++run;
+        if (run >= 3) {
+            put(unsigned(run));
+            put(vals[i]);
+            i += run;
+            continue;
+        }
+        size_t lit = 0;
+        while (i + lit < n && lit < 127
+               && !(i + lit + 2 < n && vals[i + lit] == vals[i + lit + 1]
+                    && vals[i + lit] == vals[i + lit + 2]))
+            ++lit;
+        put(0x80 | unsigned(lit));
+        for (size_t j = 0; j < lit; ++j)
+            put(vals[i + j]);
+        i += lit;
+    }
+    put(0);
+}
+
+
+
+// SGI and RLA decode RLE scanlines in parallel when several are read at
+// once. Both the multi-scanline and the single-scanline reads must give
+// back the original pixels.
+static void
+check_rle_read(const std::string& filename,
+               const std::vector<uint16_t>& expected)
+{
+    auto in = ImageInput::open(filename);
+    OIIO_CHECK_ASSERT(in);
+    if (!in)
+        return;
+    const ImageSpec& spec(in->spec());
+    std::vector<uint16_t> pixels(expected.size());
+    OIIO_CHECK_ASSERT(in->read_image(0, 0, 0, spec.nchannels, TypeUInt16,
+                                     pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == expected);
+    std::fill(pixels.begin(), pixels.end(), 0);
+    size_t rowvalues = size_t(spec.width) * spec.nchannels;
+    for (int y = 0; y < spec.height; ++y)
+        OIIO_CHECK_ASSERT(
+            in->read_scanline(y, 0, TypeUInt16, &pixels[y * rowvalues]));
+    OIIO_CHECK_ASSERT(pixels == expected);
+    // A range that doesn't start at the top
+    OIIO_CHECK_ASSERT(in->read_scanlines(0, 0, 5, spec.height, 0, 0,
+                                         spec.nchannels, TypeUInt16,
+                                         pixels.data()));
+    OIIO_CHECK_ASSERT(std::equal(expected.begin() + 5 * rowvalues,
+                                 expected.end(), pixels.begin()));
+    OIIO_CHECK_FALSE(in->has_error());
+}
+
+
+
+void
+test_rle_scanlines()
+{
+    std::cout << "Testing parallel RLE scanline reads\n";
+    const int width = 37, height = 23, nchans = 3;
+    for (int bpc : { 1, 2 }) {
+        // Runs of equal values on the left, literals on the right
+        std::vector<uint16_t> expected(size_t(width) * height * nchans);
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                for (int c = 0; c < nchans; ++c) {
+                    int v = x < 16 ? (x / 4) * 37 + y * 11 + c * 50
+                                   : x * 7 + y * 3 + c;
+                    expected[(size_t(y) * width + x) * nchans + c]
+                        = uint16_t(bpc == 1 ? (v & 0xff) * 257
+                                            : (v * 251) & 0xffff);
+                }
+
+        // There's no SGI RLE writer, so build that file by hand: header,
+        // start and length tables, then the runs. A big gap in the middle
+        // of the data makes some channels' runs too scattered to read in
+        // one piece.
+        if (is_imageio_format_name("sgi")) {
+            const int ntab = height * nchans;
+            std::vector<unsigned char> file(512 + 8 * ntab, 0);
+            auto put16 = [&](size_t pos, unsigned int v) {
+                file[pos]     = (unsigned char)(v >> 8);
+                file[pos + 1] = (unsigned char)(v & 0xff);
+            };
+            auto put32 = [&](size_t pos, unsigned int v) {
+                put16(pos, v >> 16);
+                put16(pos + 2, v & 0xffff);
+            };
+            put16(0, 0x01DA);
+            file[2] = 1;  // RLE
+            file[3] = (unsigned char)bpc;
+            put16(4, 3);
+            put16(6, width);
+            put16(8, height);
+            put16(10, nchans);
+            put32(16, bpc == 1 ? 255 : 65535);
+            for (int i = 0; i < ntab; ++i) {
+                if (i == ntab / 2)
+                    file.resize(file.size() + 100000, 0);
+                // Table entries are bottom-up rows, channel by channel
+                int c = i / height, y = height - 1 - i % height;
+                std::vector<uint16_t> vals(width);
+                for (int x = 0; x < width; ++x) {
+                    uint16_t v = expected[(size_t(y) * width + x) * nchans + c];
+                    vals[x]    = bpc == 1 ? v >> 8 : v;
+                }
+                size_t start = file.size();
+                sgi_rle_encode(vals, bpc, file);
+                put32(512 + 4 * i, unsigned(start));
+                put32(512 + 4 * (ntab + i), unsigned(file.size() - start));
+            }
+            std::string filename = "tmp_rle.sgi";
+            OIIO_CHECK_ASSERT(Filesystem::write_binary_file(filename, file));
+            check_rle_read(filename, expected);
+            Filesystem::remove(filename);
+        }
+
+        // The RLA writer always RLE-compresses
+        if (is_imageio_format_name("rla")) {
+            ImageSpec spec(width, height, nchans,
+                           bpc == 1 ? TypeUInt8 : TypeUInt16);
+            std::string filename = "tmp_rle.rla";
+            auto out             = ImageOutput::create(filename);
+            OIIO_CHECK_ASSERT(out);
+            if (!out)
+                return;
+            OIIO_CHECK_ASSERT(out->open(filename, spec));
+            OIIO_CHECK_ASSERT(out->write_image(TypeUInt16, expected.data()));
+            out->close();
+            out.reset();
+            check_rle_read(filename, expected);
+            Filesystem::remove(filename);
+        }
+    }
+}
+
+
+
+// Animated GIF frames are composited over the frames before them, and a
+// reader resumes from saved snapshots of that state rather than decoding
+// again from the first frame. Frames read out of order through one reader
+// must match the same frames read from a fresh reader.
+void
+test_gif_random_frames()
+{
+    if (!is_imageio_format_name("gif"))
+        return;
+    std::cout << "Testing gif random frame access\n";
+    const int nframes = 40, width = 48, height = 24;
+    std::string filename = "tmp_frames.gif";
+    auto out             = ImageOutput::create(filename);
+    OIIO_CHECK_ASSERT(out);
+    if (!out)
+        return;
+    // A box moving over a fixed background, so that later frames only
+    // change part of the canvas.
+    ImageSpec spec(width, height, 3, TypeUInt8);
+    std::vector<ImageSpec> specs(nframes, spec);
+    OIIO_CHECK_ASSERT(out->open(filename, nframes, specs.data()));
+    for (int f = 0; f < nframes; ++f) {
+        if (f)
+            OIIO_CHECK_ASSERT(out->open(filename, spec,
+                                        ImageOutput::AppendSubimage));
+        ImageBuf frame(spec);
+        ImageBufAlgo::fill(frame, { 0.2f, 0.4f, 0.6f });
+        ImageBufAlgo::fill(frame, { 1.0f, float(f % 5) / 4.0f, 0.0f },
+                           ROI(f, f + 8, 4 + f % 12, 12 + f % 12));
+        OIIO_CHECK_ASSERT(frame.write(out.get()));
+    }
+    out->close();
+    out.reset();
+
+    const size_t nbytes = size_t(width) * height * 4;
+    std::vector<std::vector<unsigned char>> frames(nframes);
+    for (int f = 0; f < nframes; ++f) {
+        auto in = ImageInput::open(filename);
+        OIIO_CHECK_ASSERT(in && in->seek_subimage(f, 0));
+        if (!in)
+            return;
+        frames[f].resize(nbytes);
+        OIIO_CHECK_ASSERT(
+            in->read_image(f, 0, 0, 4, TypeUInt8, frames[f].data()));
+    }
+
+    // Back and forth past snapshots, stepping back through recent frames,
+    // and repeats.
+    auto in = ImageInput::open(filename);
+    OIIO_CHECK_ASSERT(in);
+    if (!in)
+        return;
+    std::vector<unsigned char> pixels(nbytes);
+    for (int f : { 35, 3, 4, 2, 30, 29, 28, 27, 39, 0, 17, 17, 16, 9, 38 }) {
+        OIIO_CHECK_ASSERT(in->read_image(f, 0, 0, 4, TypeUInt8, pixels.data()));
+        OIIO_CHECK_ASSERT(pixels == frames[f]);
+    }
+    in.reset();
+    Filesystem::remove(filename);
+}
+
+
+
+// FITS, PNM and BMP read runs of scanlines straight into the caller's
+// buffer and fix up the byte order and row order in place. Check the
+// whole-image, partial and single-scanline reads, through a plain file
+// and a memory mapping, for each kind of data.
+void
+test_direct_scanline_reads()
+{
+    std::cout << "Testing direct scanline reads\n";
+    struct Case {
+        const char* ext;
+        TypeDesc type;
+        int nchannels, width;
+    };
+    const Case cases[] = {
+        { "fits", TypeFloat, 1, 37 },  { "fits", TypeInt16, 1, 36 },
+        { "pgm", TypeUInt8, 1, 37 },   { "ppm", TypeUInt16, 3, 37 },
+        { "pfm", TypeFloat, 3, 37 },   { "bmp", TypeUInt8, 3, 37 },
+        { "bmp", TypeUInt8, 3, 36 },   { "bmp", TypeUInt8, 4, 37 },
+    };
+    const int height = 19;
+    for (const Case& c : cases) {
+        std::string format = c.ext[0] == 'p' ? "pnm" : c.ext;
+        if (!is_imageio_format_name(format))
+            continue;
+        std::string filename = Strutil::fmt::format("tmp_direct.{}", c.ext);
+        ImageBuf src(ImageSpec(c.width, height, c.nchannels, c.type));
+        ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f);
+        // FITS gets a second subimage, found by skipping the first's data
+        ImageBuf src2(ImageSpec(13, 11, c.nchannels, c.type));
+        ImageBufAlgo::noise(src2, "uniform", 0.0f, 1.0f, false, 1);
+        if (format == "fits") {
+            auto out = ImageOutput::create(filename);
+            OIIO_CHECK_ASSERT(out);
+            if (!out)
+                continue;
+            ImageSpec specs[2] = { src.spec(), src2.spec() };
+            OIIO_CHECK_ASSERT(out->open(filename, 2, specs));
+            OIIO_CHECK_ASSERT(src.write(out.get()));
+            OIIO_CHECK_ASSERT(
+                out->open(filename, specs[1], ImageOutput::AppendSubimage));
+            OIIO_CHECK_ASSERT(src2.write(out.get()));
+            out->close();
+        } else {
+            OIIO_CHECK_ASSERT(src.write(filename));
+        }
+        std::vector<float> expected(src.spec().image_pixels() * c.nchannels);
+        src.get_pixels(src.roi(), TypeFloat, expected.data());
+        size_t rowvalues = size_t(c.width) * c.nchannels;
+
+        for (int mmap : { 0, 1 }) {
+            ImageSpec config;
+            config["oiio:ioproxy:mmap"] = mmap;
+            auto in                     = ImageInput::open(filename, &config);
+            OIIO_CHECK_ASSERT(in);
+            if (!in)
+                continue;
+            std::vector<float> pixels(expected.size());
+            OIIO_CHECK_ASSERT(in->read_image(0, 0, 0, c.nchannels, TypeFloat,
+                                             pixels.data()));
+            OIIO_CHECK_ASSERT(pixels == expected);
+            std::fill(pixels.begin(), pixels.end(), 0.0f);
+            OIIO_CHECK_ASSERT(in->read_scanlines(0, 0, 3, height - 2, 0, 0,
+                                                 c.nchannels, TypeFloat,
+                                                 pixels.data()));
+            OIIO_CHECK_ASSERT(std::equal(expected.begin() + 3 * rowvalues,
+                                         expected.end() - 2 * rowvalues,
+                                         pixels.begin()));
+            for (int y = height - 1; y >= 0; --y)
+                OIIO_CHECK_ASSERT(in->read_scanline(y, 0, TypeFloat,
+                                                    &pixels[y * rowvalues]));
+            OIIO_CHECK_ASSERT(pixels == expected);
+            if (format == "fits") {
+                OIIO_CHECK_ASSERT(in->seek_subimage(1, 0));
+                ImageBuf back(in->spec());
+                OIIO_CHECK_ASSERT(in->read_image(1, 0, 0, c.nchannels,
+                                                 back.spec().format,
+                                                 back.localpixels()));
+                auto comp = ImageBufAlgo::compare(back, src2, 0.0f, 0.0f);
+                OIIO_CHECK_EQUAL(comp.nfail, 0);
+            }
+        }
+        Filesystem::remove(filename);
+    }
+}
+
+
+
+// The OpenEXRCore reader sizes a multi-chunk deep read's DeepData once and
+// decodes every chunk in place. Write deep scanline and tiled files with
+// the default writer, with sample counts that vary from pixel to pixel
+// (including empty pixels), and read them back with the core reader.
+void
+test_exr_core_deep_read()
+{
+    if (!is_imageio_format_name("openexr"))
+        return;
+    std::cout << "Testing openexr:core deep reads\n";
+    const int width = 37, height = 41, nchans = 5;
+    ImageSpec spec(width, height, nchans, TypeFloat);
+    spec.channelnames   = { "R", "G", "B", "A", "Z" };
+    spec.alpha_channel  = 3;
+    spec.z_channel      = 4;
+    spec.deep           = true;
+    spec["compression"] = "zip";  // 16 scanlines per chunk
+
+    auto nsamples = [](int x, int y) { return (x + 2 * y) % 4; };
+    auto value    = [](int64_t p, int c, int s) {
+        return p * 0.01f + c + s * 0.1f;
+    };
+    DeepData src(spec);
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            src.set_samples(y * width + x, nsamples(x, y));
+    for (int64_t p = 0; p < src.pixels(); ++p)
+        for (int c = 0; c < nchans; ++c)
+            for (int s = 0; s < src.samples(p); ++s)
+                src.set_deep_value(p, c, s, value(p, c, s));
+
+    // Does `dd` hold the pixels of [xbegin,xend) x [ybegin,yend)?
+    auto matches = [&](const DeepData& dd, int xbegin, int xend, int ybegin,
+                       int yend) {
+        int64_t i = 0;
+        for (int y = ybegin; y < yend; ++y)
+            for (int x = xbegin; x < xend; ++x, ++i) {
+                int64_t p = int64_t(y) * width + x;
+                if (dd.samples(i) != src.samples(p))
+                    return false;
+                for (int c = 0; c < nchans; ++c)
+                    for (int s = 0; s < src.samples(p); ++s)
+                        if (dd.deep_value(i, c, s) != value(p, c, s))
+                            return false;
+            }
+        return true;
+    };
+
+    int saved            = OIIO::get_int_attribute("openexr:core");
+    std::string filename = "tmp_coredeep.exr";
+    for (int tile : { 0, 16 }) {
+        ImageSpec s   = spec;
+        s.tile_width  = tile;
+        s.tile_height = tile;
+        OIIO::attribute("openexr:core", 0);
+        auto out = ImageOutput::create(filename);
+        OIIO_CHECK_ASSERT(out && out->open(filename, s));
+        if (!out)
+            continue;
+        OIIO_CHECK_ASSERT(out->write_deep_image(src));
+        out->close();
+        out.reset();
+
+        OIIO::attribute("openexr:core", 1);
+        auto in = ImageInput::open(filename);
+        OIIO_CHECK_ASSERT(in);
+        if (!in)
+            continue;
+        DeepData back;
+        OIIO_CHECK_ASSERT(in->read_native_deep_image(0, 0, back));
+        OIIO_CHECK_ASSERT(matches(back, 0, width, 0, height));
+        // A region that starts and ends in the middle of chunks
+        DeepData part;
+        if (tile) {
+            OIIO_CHECK_ASSERT(in->read_native_deep_tiles(0, 0, 16, width, 16,
+                                                         height, 0, 1, 0,
+                                                         nchans, part));
+            OIIO_CHECK_ASSERT(matches(part, 16, width, 16, height));
+        } else {
+            OIIO_CHECK_ASSERT(in->read_native_deep_scanlines(0, 0, 5, 38, 0,
+                                                             0, nchans, part));
+            OIIO_CHECK_ASSERT(matches(part, 0, width, 5, 38));
+        }
+    }
+    OIIO::attribute("openexr:core", saved);
+    if (!nodelete)
+        Filesystem::remove(filename);
+}
+
+
+
+// The OpenEXRCore reader reads only the byte span of the requested channels
+// from uncompressed tiles. Read channel subsets of files with mixed channel
+// formats, whose file order (alphabetical) differs from the spec's, and
+// with partial tiles on the right and bottom, and check them against the
+// same channels of a read of all of them.
+void
+test_exr_core_channel_tiles()
+{
+    if (!is_imageio_format_name("openexr"))
+        return;
+    std::cout << "Testing openexr:core channel subsets of tiles\n";
+    const int width = 50, height = 37, nchans = 6;
+    ImageSpec spec(width, height, nchans, TypeHalf);
+    spec.channelnames   = { "R", "G", "B", "A", "Z", "mask" };
+    spec.channelformats = { TypeHalf, TypeHalf,  TypeHalf,
+                            TypeHalf, TypeFloat, TypeHalf };
+    spec.alpha_channel  = 3;
+    spec.z_channel      = 4;
+    spec.tile_width     = 16;
+    spec.tile_height    = 16;
+    std::vector<float> pixels(size_t(width) * height * nchans);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = float(i % 1021) / 64.0f;
+
+    int saved            = OIIO::get_int_attribute("openexr:core");
+    std::string filename = "tmp_corechans.exr";
+    for (const char* compression : { "none", "zip" }) {
+        ImageSpec s(spec);
+        s["compression"] = compression;
+        OIIO::attribute("openexr:core", 0);
+        auto out = ImageOutput::create(filename);
+        OIIO_CHECK_ASSERT(out && out->open(filename, s));
+        if (!out)
+            continue;
+        OIIO_CHECK_ASSERT(out->write_image(TypeFloat, pixels.data()));
+        out->close();
+        out.reset();
+
+        OIIO::attribute("openexr:core", 1);
+        auto in = ImageInput::open(filename);
+        OIIO_CHECK_ASSERT(in);
+        if (!in)
+            continue;
+        const ImageSpec& inspec(in->spec());
+        size_t npixels = size_t(width) * height;
+        std::vector<unsigned char> all(npixels * inspec.pixel_bytes(true));
+        OIIO_CHECK_ASSERT(in->read_native_tiles(0, 0, 0, width, 0, height, 0,
+                                                1, 0, nchans, all.data()));
+        for (auto range : { std::pair<int, int>(1, 3), { 4, 5 }, { 3, 6 },
+                            { 0, 1 }, { 5, 6 } }) {
+            int chbegin = range.first, chend = range.second;
+            size_t pixelbytes = inspec.pixel_bytes(chbegin, chend, true);
+            size_t offset     = inspec.pixel_bytes(0, chbegin, true);
+            std::vector<unsigned char> some(npixels * pixelbytes);
+            OIIO_CHECK_ASSERT(in->read_native_tiles(0, 0, 0, width, 0, height,
+                                                    0, 1, chbegin, chend,
+                                                    some.data()));
+            size_t mismatches = 0;
+            for (size_t p = 0; p < npixels; ++p)
+                mismatches += memcmp(&some[p * pixelbytes],
+                                     &all[p * inspec.pixel_bytes(true)
+                                          + offset],
+                                     pixelbytes)
+                              != 0;
+            OIIO_CHECK_EQUAL(mismatches, size_t(0));
+        }
+    }
+    OIIO::attribute("openexr:core", saved);
+    if (!nodelete)
+        Filesystem::remove(filename);
+}
+
+
+
+// The HDR reader locates each scanline by walking the RLE structure and
+// then decodes them independently, whichever way each one is encoded.
+// Write by hand a file whose scanlines are flat, RLE with only literals,
+// and RLE with runs, at a width that isn't a multiple of four, and read it
+// in full, as scanline ranges in random order, and truncated.
+void
+test_hdr_rgbe()
+{
+    if (!is_imageio_format_name("hdr"))
+        return;
+    std::cout << "Testing HDR RGBE decoding\n";
+    const int width = 13, height = 6;
+    auto rgbe = [](int x, int y, int c) -> unsigned char {
+        if (c == 3)
+            return (x == 7 && y == 2) ? 0 : 120 + (x + y) % 16;
+        if (c == 0)
+            return 3 + (x * 37 + y * 11) % 250;
+        if (c == 1)
+            return 3 + (x * 13 + y * 7) % 250;
+        return 3 + (x * 5 + y * 29) % 250;
+    };
+    std::string file = Strutil::fmt::format(
+        "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y {} +X {}\n", height, width);
+    for (int y = 0; y < height; ++y) {
+        if (y % 3 == 0) {  // flat
+            for (int x = 0; x < width; ++x)
+                for (int c = 0; c < 4; ++c)
+                    file += char(rgbe(x, y, c));
+            continue;
+        }
+        file += { 2, 2, char(width >> 8), char(width & 0xff) };
+        for (int c = 0; c < 4; ++c) {
+            int x = 0;
+            if (y % 3 == 2) {
+                // Five copies of the first value, as a run
+                file += { char(128 + 5), char(rgbe(0, y, c)) };
+                x = 5;
+            }
+            file += char(width - x);
+            for (; x < width; ++x)
+                file += char(rgbe(x, y, c));
+        }
+    }
+    auto expected = [&](int x, int y, int c) {
+        if (y % 3 == 2 && x < 5)
+            x = 0;  // in the run
+        unsigned char e = rgbe(x, y, 3);
+        return e ? rgbe(x, y, c) * std::ldexp(1.0f, e - 136) : 0.0f;
+    };
+    auto matches = [&](const std::vector<float>& pixels, int ybegin,
+                       int yend) {
+        int nbad = 0;
+        for (int y = ybegin; y < yend; ++y)
+            for (int x = 0; x < width; ++x)
+                for (int c = 0; c < 3; ++c)
+                    nbad += pixels[((y - ybegin) * width + x) * 3 + c]
+                            != expected(x, y, c);
+        return nbad == 0;
+    };
+
+    auto bytes = [](const std::string& str) {
+        return cspan<char>(str.data(), str.size());
+    };
+    std::string filename = "tmp_rgbe.hdr";
+    OIIO_CHECK_ASSERT(Filesystem::write_binary_file(filename, bytes(file)));
+    std::vector<float> pixels(width * height * 3);
+    auto in = ImageInput::open(filename);
+    OIIO_CHECK_ASSERT(in);
+    if (in) {
+        OIIO_CHECK_ASSERT(in->read_image(0, 0, 0, 3, TypeFloat, pixels.data()));
+        OIIO_CHECK_ASSERT(matches(pixels, 0, height));
+    }
+    // A fresh reader jumping around, so it has to find scanlines it hasn't
+    // decoded yet, and then go back to ones it has
+    in = ImageInput::open(filename);
+    OIIO_CHECK_ASSERT(in);
+    if (in) {
+        for (auto range : { std::pair<int, int>(3, 6), { 1, 2 }, { 0, 6 },
+                            { 2, 5 } }) {
+            std::fill(pixels.begin(), pixels.end(), -1.0f);
+            OIIO_CHECK_ASSERT(in->read_scanlines(0, 0, range.first,
+                                                 range.second, 0, 0, 3,
+                                                 TypeFloat, pixels.data()));
+            OIIO_CHECK_ASSERT(matches(pixels, range.first, range.second));
+        }
+    }
+    in.reset();
+
+    // Cut off partway through the fifth scanline
+    file.resize(file.size() - (width * 4 + 10));
+    OIIO_CHECK_ASSERT(Filesystem::write_binary_file(filename, bytes(file)));
+    in = ImageInput::open(filename);
+    OIIO_CHECK_ASSERT(in);
+    if (in) {
+        OIIO_CHECK_ASSERT(in->read_scanlines(0, 0, 0, 3, 0, 0, 3, TypeFloat,
+                                             pixels.data()));
+        OIIO_CHECK_ASSERT(!in->read_image(0, 0, 0, 3, TypeFloat,
+                                          pixels.data()));
+        OIIO_CHECK_ASSERT(in->has_error());
+        in->geterror();
+    }
+    in.reset();
+    if (!nodelete)
+        Filesystem::remove(filename);
+}
+
+
+
+// 10-bit filled DPX data unpacks a whole 32-bit word (three datums) at a
+// time, with a per-datum tail for rows whose datum count isn't a multiple
+// of three. Round trip some odd widths through both the block read and the
+// single-scanline read.
+void
+test_dpx_10bit()
+{
+    if (!is_imageio_format_name("dpx"))
+        return;
+    std::cout << "Testing dpx 10-bit filled unpacking\n";
+    for (int nchans : { 3, 4 }) {
+        for (int width : { 5, 7, 64 }) {
+            const int height = 3;
+            ImageSpec spec(width, height, nchans, TypeUInt16);
+            spec.attribute("oiio:BitsPerSample", 10);
+            size_t nvalues = spec.image_pixels() * nchans;
+            std::vector<uint16_t> orig(nvalues), expected(nvalues);
+            for (size_t i = 0; i < nvalues; ++i) {
+                uint16_t d  = uint16_t((i * 37 + 11) & 0x3ff);
+                orig[i]     = uint16_t(d << 6);
+                expected[i] = uint16_t((d << 6) | (d >> 4));
+            }
+            std::string filename = "tmp_10bit.dpx";
+            auto out             = ImageOutput::create(filename);
+            OIIO_CHECK_ASSERT(out);
+            if (!out)
+                return;
+            OIIO_CHECK_ASSERT(out->open(filename, spec));
+            OIIO_CHECK_ASSERT(out->write_image(TypeUInt16, orig.data()));
+            out->close();
+            out.reset();
+
+            auto in = ImageInput::open(filename);
+            OIIO_CHECK_ASSERT(in);
+            if (!in)
+                return;
+            std::vector<uint16_t> pixels(nvalues);
+            OIIO_CHECK_ASSERT(
+                in->read_image(0, 0, 0, nchans, TypeUInt16, pixels.data()));
+            OIIO_CHECK_ASSERT(pixels == expected);
+            std::fill(pixels.begin(), pixels.end(), 0);
+            size_t rowvalues = size_t(width) * nchans;
+            for (int y = 0; y < height; ++y)
+                OIIO_CHECK_ASSERT(in->read_scanline(y, 0, TypeUInt16,
+                                                    &pixels[y * rowvalues]));
+            OIIO_CHECK_ASSERT(pixels == expected);
+            in.reset();
+            Filesystem::remove(filename);
+        }
+    }
+}
+
+
+
+// DPX output packs bands of 64 scanlines in parallel, and write_scanlines
+// converts the caller's pixels straight into the element buffer. Write
+// images spanning several bands at each bit depth and packing, from float
+// both all at once and a scanline at a time, and check that every value
+// reads back exactly.
+void
+test_dpx_write_bands()
+{
+    if (!is_imageio_format_name("dpx"))
+        return;
+    std::cout << "Testing dpx banded writes\n";
+    const int width = 7, height = 150, nchans = 3;
+    size_t nvalues = size_t(width) * height * nchans;
+    struct Case {
+        int bits;
+        const char* packing;
+    };
+    for (Case t : { Case { 8, "Packed" }, Case { 10, "Filled, method A" },
+                    Case { 10, "Filled, method B" },
+                    Case { 12, "Filled, method A" }, Case { 16, "Packed" } }) {
+        ImageSpec spec(width, height, nchans,
+                       t.bits == 8 ? TypeUInt8 : TypeUInt16);
+        spec.attribute("oiio:BitsPerSample", t.bits);
+        spec.attribute("dpx:Packing", t.packing);
+        float maxval = float((1 << t.bits) - 1);
+        std::vector<float> orig(nvalues);
+        for (size_t i = 0; i < nvalues; ++i)
+            orig[i] = float((i * 37 + 11) % ((1 << t.bits) - 1)) / maxval;
+
+        std::string filename = "tmp_bands.dpx";
+        for (bool by_scanline : { false, true }) {
+            auto out = ImageOutput::create(filename);
+            OIIO_CHECK_ASSERT(out && out->open(filename, spec));
+            if (!out)
+                return;
+            if (by_scanline) {
+                for (int y = 0; y < height; ++y)
+                    OIIO_CHECK_ASSERT(out->write_scanline(
+                        y, 0, TypeFloat, &orig[size_t(y) * width * nchans]));
+            } else {
+                OIIO_CHECK_ASSERT(out->write_image(TypeFloat, orig.data()));
+            }
+            out->close();
+            out.reset();
+
+            auto in = ImageInput::open(filename);
+            OIIO_CHECK_ASSERT(in);
+            if (!in)
+                return;
+            std::vector<float> pixels(nvalues);
+            OIIO_CHECK_ASSERT(
+                in->read_image(0, 0, 0, nchans, TypeFloat, pixels.data()));
+            size_t nbad = 0;
+            for (size_t i = 0; i < nvalues; ++i)
+                nbad += std::abs(pixels[i] - orig[i]) > 0.25f / maxval;
+            if (nbad)
+                std::cout << "  " << t.bits << " bits, " << t.packing
+                          << (by_scanline ? ", by scanline" : "") << "\n";
+            OIIO_CHECK_EQUAL(nbad, size_t(0));
+            in.reset();
+            if (!nodelete)
+                Filesystem::remove(filename);
+        }
+    }
+}
+
+
+
+// Codec-internal threading goes through pvt::codec_threads() and
+// pvt::codec_parallel_run(): every value must be visited exactly once, a
+// thread_id must never be in use by two threads at once, and from inside a
+// pool worker everything runs serially.
+void
+test_codec_threading()
+{
+    std::cout << "Testing codec threading\n";
+    thread_pool* pool = default_thread_pool();
+    OIIO_CHECK_EQUAL(pvt::codec_threads(1), 1);
+    OIIO_CHECK_EQUAL(pvt::codec_threads(1000), pool->size() + 1);
+    OIIO_CHECK_GE(pvt::codec_threads(), 1);
+
+    const int nthreads = 4;
+    std::vector<std::atomic<int>> visits(1000);
+    std::atomic<int> busy[nthreads], badid(0), overlap(0);
+    for (auto& b : busy)
+        b = 0;
+    pvt::codec_parallel_run(0, 1000, nthreads, [&](uint32_t v, int id) {
+        if (id < 0 || id >= nthreads) {
+            ++badid;
+            return;
+        }
+        if (busy[id]++)
+            ++overlap;
+        ++visits[v];
+        --busy[id];
+    });
+    OIIO_CHECK_EQUAL(badid, 0);
+    OIIO_CHECK_EQUAL(overlap, 0);
+    int wrongcount = 0;
+    for (auto& v : visits)
+        wrongcount += (v != 1);
+    OIIO_CHECK_EQUAL(wrongcount, 0);
+
+    // Issued from a pool worker: no nested fan-out
+    int workerthreads = 0, nonzeroids = 0, count = 0;
+    auto job = pool->push([&](int /*id*/) {
+        workerthreads = pvt::codec_threads(8);
+        pvt::codec_parallel_run(10, 20, 8, [&](uint32_t, int id) {
+            nonzeroids += (id != 0);
+            ++count;
+        });
+    });
+    job.wait();
+    OIIO_CHECK_EQUAL(workerthreads, 1);
+    OIIO_CHECK_EQUAL(nonzeroids, 0);
+    OIIO_CHECK_EQUAL(count, 10);
+
+    // Round trip through JPEG XL, which runs its jobs via the adaptor
+    if (is_imageio_format_name("jpegxl")) {
+        ImageBuf src(ImageSpec(256, 192, 3, TypeUInt8));
+        ImageBufAlgo::fill(src, { 0.1f, 0.3f, 0.9f }, { 0.8f, 0.5f, 0.2f },
+                           { 0.0f, 1.0f, 0.5f }, { 1.0f, 0.0f, 0.0f });
+        std::string filename = "tmp_threads.jxl";  // lossless by default
+        auto out             = ImageOutput::create(filename);
+        OIIO_CHECK_ASSERT(out);
+        if (!out)
+            return;
+        out->threads(nthreads);
+        OIIO_CHECK_ASSERT(out->open(filename, src.spec()));
+        OIIO_CHECK_ASSERT(src.write(out.get()));
+        out->close();
+        out.reset();
+        ImageBuf in(filename);
+        in.threads(nthreads);
+        auto comp = ImageBufAlgo::compare(in, src, 1.0f / 255.0f, 0.0f);
+        OIIO_CHECK_FALSE(comp.error);
+        OIIO_CHECK_EQUAL(comp.nfail, 0);
+        Filesystem::remove(filename);
+    }
+}
+
+
+
 int
 main(int argc, char* argv[])
 {
@@ -531,6 +1796,26 @@ main(int argc, char* argv[])
 
     test_all_formats();
     test_read_tricky_sizes();
+    test_read_async();
+    test_read_mmap_hint();
+    test_convert_pixel_values();
+    test_plugin_manifest();
+    test_metadata_hint();
+    test_probe_spec();
+    test_exr_core_output();
+    test_jpeg_reduce();
+    test_jpeg_rawycc();
+    test_jpeg2000_miplevels();
+    test_jpeg2000_tiles();
+    test_dpx_10bit();
+    test_dpx_write_bands();
+    test_rle_scanlines();
+    test_gif_random_frames();
+    test_direct_scanline_reads();
+    test_exr_core_deep_read();
+    test_exr_core_channel_tiles();
+    test_hdr_rgbe();
+    test_codec_threading();
 
     return unit_test_failures;
 }
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -48,6 +49,8 @@ public:
     // The "local" proxy that we will create to use if the user didn't
     // supply a proxy for us to use.
     std::unique_ptr<Filesystem::IOProxy> m_io_local;
+    // Should a local proxy memory-map the file ("oiio:ioproxy:mmap")?
+    bool m_io_mmap = false;
 };
 
 
@@ -145,6 +148,41 @@ ImageInput::valid_file(Filesystem::IOProxy* ioproxy) const
 
 
 
+bool
+ImageInput::probe_spec(string_view filename, ImageSpec& spec,
+                       const ImageSpec* hints)
+{
+    auto in = create(filename, false, hints);
+    if (!in)
+        return false;  // create() set the error
+    bool ok = in->probe_header(filename, spec, hints ? *hints : ImageSpec());
+    if (!ok) {
+        std::string err = in->geterror();
+        if (err.empty())
+            err = Strutil::fmt::format("Could not read header of \"{}\"",
+                                       filename);
+        OIIO::pvt::errorfmt("{}", err);
+    }
+    return ok;
+}
+
+
+
+bool
+ImageInput::probe_header(string_view filename, ImageSpec& spec,
+                         const ImageSpec& config)
+{
+    ImageSpec myconfig(config);
+    if (!myconfig.find_attribute("oiio:metadata"))
+        myconfig.attribute("oiio:metadata", "none");
+    bool ok = open(std::string(filename), spec, myconfig);
+    if (ok)
+        close();
+    return ok;
+}
+
+
+
 std::unique_ptr<ImageInput>
 ImageInput::open(const std::string& filename, const ImageSpec* config,
                  Filesystem::IOProxy* ioproxy)
@@ -311,6 +349,7 @@ ImageInput::read_scanlines(int subimage, int miplevel, int ybegin, int yend,
                            int z, int chbegin, int chend, TypeDesc format,
                            void* data, stride_t xstride, stride_t ystride)
 {
+    pvt::TraceScope trace("ImageInput::read_scanlines");
     ImageSpec spec;
     int rps = 0;
     {
@@ -616,6 +655,7 @@ ImageInput::read_tiles(int subimage, int miplevel, int xbegin, int xend,
                        int chend, TypeDesc format, void* data, stride_t xstride,
                        stride_t ystride, stride_t zstride)
 {
+    pvt::TraceScope trace("ImageInput::read_tiles");
     ImageSpec spec = spec_dimensions(subimage, miplevel);  // thread-safe
     if (spec.undefined())
         return false;
@@ -772,6 +812,36 @@ ImageInput::read_tiles(int subimage, int miplevel, int xbegin, int xend,
 
 
 
+std::future<bool>
+ImageInput::read_scanlines_async(int subimage, int miplevel, int ybegin,
+                                 int yend, int z, int chbegin, int chend,
+                                 TypeDesc format, void* data, stride_t xstride,
+                                 stride_t ystride)
+{
+    return default_thread_pool()->push([=](int /*id*/) {
+        return read_scanlines(subimage, miplevel, ybegin, yend, z, chbegin,
+                              chend, format, data, xstride, ystride);
+    });
+}
+
+
+
+std::future<bool>
+ImageInput::read_tiles_async(int subimage, int miplevel, int xbegin, int xend,
+                             int ybegin, int yend, int zbegin, int zend,
+                             int chbegin, int chend, TypeDesc format,
+                             void* data, stride_t xstride, stride_t ystride,
+                             stride_t zstride)
+{
+    return default_thread_pool()->push([=](int /*id*/) {
+        return read_tiles(subimage, miplevel, xbegin, xend, ybegin, yend,
+                          zbegin, zend, chbegin, chend, format, data, xstride,
+                          ystride, zstride);
+    });
+}
+
+
+
 bool
 ImageInput::read_native_tile(int /*subimage*/, int /*miplevel*/, int /*x*/,
                              int /*y*/, int /*z*/, void* /*data*/)
@@ -783,6 +853,18 @@ ImageInput::read_native_tile(int /*subimage*/, int /*miplevel*/, int /*x*/,
 }
 
 
+
+bool
+ImageInput::native_tile_location(int /*subimage*/, int /*miplevel*/,
+                                 int /*x*/, int /*y*/, int /*z*/,
+                                 int64_t& /*offset*/, int64_t& /*size*/)
+{
+    // By default, we don't know where tiles live in the file, so the
+    // caller must go through read_native_tile.
+    return false;
+}
+
+
 bool
 ImageInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
                               int ybegin, int yend, int zbegin, int zend,
@@ -936,6 +1018,7 @@ ImageInput::read_image(int subimage, int miplevel, int chbegin, int chend,
                        ProgressCallback progress_callback,
                        void* progress_callback_data)
 {
+    pvt::TraceScope trace("ImageInput::read_image");
     ImageSpec spec;
     int rps = 0;
     {
@@ -1229,6 +1312,7 @@ ImageInput::ioproxy_retrieve_from_config(const ImageSpec& config)
 {
     if (auto p = config.find_attribute("oiio:ioproxy", TypeDesc::PTR))
         set_ioproxy(p->get<Filesystem::IOProxy*>());
+    m_impl->m_io_mmap = config.get_int_attribute("oiio:ioproxy:mmap") != 0;
 }
 
 
@@ -1237,6 +1321,15 @@ bool
 ImageInput::ioproxy_use_or_open(string_view name)
 {
     Filesystem::IOProxy*& m_io(m_impl->m_io);
+    if (!m_io && m_impl->m_io_mmap) {
+        // Memory-map the file if asked to, but if that can't be done
+        // (empty file, unsupported file system), quietly use an IOFile.
+        m_impl->m_io_local.reset(new Filesystem::IOMMapReader(name));
+        if (m_impl->m_io_local->opened())
+            m_io = m_impl->m_io_local.get();
+        else
+            m_impl->m_io_local.reset();
+    }
     if (!m_io) {
         // If no proxy was supplied, create an IOFile
         m_io = new Filesystem::IOFile(name, Filesystem::IOProxy::Mode::Read);
@@ -1252,6 +1345,19 @@ ImageInput::ioproxy_use_or_open(string_view name)
 
 
 
+cspan<unsigned char>
+ImageInput::ioproxy_buffer() const
+{
+    const Filesystem::IOProxy* io = m_impl->m_io;
+    if (io
+        && (!strcmp(io->proxytype(), "memreader")
+            || !strcmp(io->proxytype(), "mmapreader")))
+        return static_cast<const Filesystem::IOMemReader*>(io)->buffer();
+    return {};
+}
+
+
+
 bool
 ImageInput::ioread(void* buf, size_t itemsize, size_t nitems)
 {
@@ -2,19 +2,23 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <mutex>
 
 #include <OpenImageIO/half.h>
 
 #include <OpenImageIO/color.h>
 #include <OpenImageIO/dassert.h>
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/filter.h>
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/hash.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/optparser.h>
 #include <OpenImageIO/parallel.h>
+#include <OpenImageIO/simd.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/thread.h>
@@ -48,20 +52,26 @@ atomic_int oiio_try_all_readers(1);
 #endif
 // Should we use "Exr core C library"?
 int openexr_core(OIIO_OPENEXR_CORE_DEFAULT);
+// Should we also write through the "Exr core C library"?
+int openexr_core_output(0);
 int tiff_half(0);
 int tiff_multithread(1);
 int dds_bc5normal(0);
+int colorconvert_lut3d(0);
+int ptex_max_memory_MB(64);
 int limit_channels(1024);
 int limit_imagesize_MB(std::min(32 * 1024,
                                 int(Sysutil::physical_memory() >> 20)));
 ustring font_searchpath(Sysutil::getenv("OPENIMAGEIO_FONTS"));
 ustring plugin_searchpath(OIIO_DEFAULT_PLUGIN_SEARCHPATH);
+ustring plugin_manifest(Sysutil::getenv("OPENIMAGEIO_PLUGIN_MANIFEST"));
 std::string format_list;         // comma-separated list of all formats
 std::string input_format_list;   // comma-separated list of readable formats
 std::string output_format_list;  // comma-separated list of writable formats
 std::string extension_list;      // list of all extensions for all formats
 std::string library_list;        // list of all libraries for all formats
 int oiio_log_times = Strutil::stoi(Sysutil::getenv("OPENIMAGEIO_LOG_TIMES"));
+int oiio_trace(0);
 int oiio_print_uncaught_errors(1);
 std::vector<float> oiio_missingcolor;
 }  // namespace pvt
@@ -127,6 +137,110 @@ static TimingLog timing_log;
 
 
 
+// Tracing: each thread gathers its spans in its own small buffer, and
+// hands them a batch at a time to the callback set by set_trace_callback()
+// and/or appends them to the "trace_file". The state is never destroyed,
+// so that threads that exit late in the program's shutdown can still
+// flush their buffers.
+class TraceLog {
+public:
+    std::mutex mutex;
+    TraceCallback callback = nullptr;
+    void* userdata         = nullptr;
+    std::string filename;
+    FILE* file = nullptr;
+    bool file_empty;
+    int64_t file_epoch;
+    atomic_int nthreads { 0 };
+
+    // Call with the mutex held.
+    void update_enabled() { oiio_trace = (callback || file) ? 1 : 0; }
+
+    // Call with the mutex held.
+    void set_file(string_view name)
+    {
+        if (file)
+            fclose(file);
+        file     = nullptr;
+        filename = name;
+        if (name.size()) {
+            file = Filesystem::fopen(filename, "w");
+            if (file) {
+                // Chrome trace event format, as an array of "complete"
+                // events. The closing bracket is optional.
+                fputs("[\n", file);
+                file_empty = true;
+                file_epoch = trace_clock();
+            }
+        }
+        update_enabled();
+    }
+
+    void deliver(cspan<TraceSpan> spans)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (callback)
+            callback(spans, userdata);
+        if (file) {
+            for (const TraceSpan& span : spans) {
+                print(file,
+                      "{}{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,"
+                      "\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                      file_empty ? "" : ",\n",
+                      Strutil::escape_chars(span.name), span.thread,
+                      (span.begin - file_epoch) * 1.0e-3,
+                      (span.end - span.begin) * 1.0e-3);
+                file_empty = false;
+            }
+            fflush(file);
+        }
+    }
+};
+
+static TraceLog&
+trace_log()
+{
+    static TraceLog* log = new TraceLog;
+    return *log;
+}
+
+// Turn on tracing at startup if OPENIMAGEIO_TRACE names a file.
+static bool trace_env_init = []() {
+    std::string filename = Sysutil::getenv("OPENIMAGEIO_TRACE");
+    if (filename.size()) {
+        std::lock_guard<std::mutex> lock(trace_log().mutex);
+        trace_log().set_file(filename);
+    }
+    return true;
+}();
+
+// Trace spans recorded by one thread but not yet delivered.
+class TraceBuffer {
+public:
+    static constexpr size_t capacity = 256;
+    std::vector<TraceSpan> spans;
+    int thread;
+
+    TraceBuffer()
+        : thread(trace_log().nthreads++)
+    {
+        spans.reserve(capacity);
+    }
+    ~TraceBuffer() { flush(); }
+
+    void flush()
+    {
+        if (spans.size()) {
+            trace_log().deliver(spans);
+            spans.clear();
+        }
+    }
+};
+
+static thread_local TraceBuffer trace_buffer;
+
+
+
 // Pipe-fitting class to set global options, for the sake of optparser.
 struct GlobalOptSetter {
 public:
@@ -371,6 +485,49 @@ pvt::log_time(string_view key, const Timer& timer, int count)
 
 
 
+int64_t
+pvt::trace_clock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+
+
+void
+pvt::trace_span(string_view name, int64_t begin)
+{
+    int64_t end = trace_clock();
+    TraceBuffer& buffer(trace_buffer);
+    buffer.spans.push_back(
+        { ustring(name).c_str(), begin, end, buffer.thread });
+    if (buffer.spans.size() >= TraceBuffer::capacity)
+        buffer.flush();
+}
+
+
+
+void
+set_trace_callback(TraceCallback callback, void* userdata)
+{
+    TraceLog& log(trace_log());
+    std::lock_guard<std::mutex> lock(log.mutex);
+    log.callback = callback;
+    log.userdata = userdata;
+    log.update_enabled();
+}
+
+
+
+void
+trace_flush()
+{
+    trace_buffer.flush();
+}
+
+
+
 bool
 attribute(string_view name, TypeDesc type, const void* val)
 {
@@ -399,6 +556,10 @@ attribute(string_view name, TypeDesc type, const void* val)
         plugin_searchpath = ustring(*(const char**)val);
         return true;
     }
+    if (name == "plugin_manifest" && type == TypeString) {
+        plugin_manifest = ustring(*(const char**)val);
+        return true;
+    }
     if (name == "exr_threads" && type == TypeInt) {
         oiio_exr_threads = OIIO::clamp(*(const int*)val, -1, maxthreads);
         return true;
@@ -407,6 +568,10 @@ attribute(string_view name, TypeDesc type, const void* val)
         openexr_core = *(const int*)val;
         return true;
     }
+    if (name == "openexr:core_output" && type == TypeInt) {
+        openexr_core_output = *(const int*)val;
+        return true;
+    }
     if (name == "tiff:half" && type == TypeInt) {
         tiff_half = *(const int*)val;
         return true;
@@ -419,6 +584,17 @@ attribute(string_view name, TypeDesc type, const void* val)
         dds_bc5normal = *(const int*)val;
         return true;
     }
+    if (name == "ptex:max_memory_MB" && type == TypeInt) {
+        ptex_max_memory_MB = std::max(0, *(const int*)val);
+        return true;
+    }
+    if (name == "colorconvert:lut3d" && type == TypeInt) {
+        int size = *(const int*)val;
+        if (size != 0 && (size < 2 || size > 129))
+            return false;
+        colorconvert_lut3d = size;
+        return true;
+    }
     if (name == "limits:channels" && type == TypeInt) {
         limit_channels = *(const int*)val;
         return true;
@@ -439,10 +615,59 @@ attribute(string_view name, TypeDesc type, const void* val)
         imagebuf_use_imagecache = *(const int*)val;
         return true;
     }
+    if (name == "imagebuf:allocator" && type == TypeString) {
+        string_view alloc(*(const char**)val);
+        if (alloc == "heap")
+            imagebuf_allocator = 0;
+        else if (alloc == "pool")
+            imagebuf_allocator = 1;
+        else if (alloc == "pinned")
+            imagebuf_allocator = 2;
+        else
+            return false;
+        return true;
+    }
+    if (name == "imagebuf:pool_max_MB" && type == TypeInt) {
+        imagebuf_pool_max_MB = std::max(0, *(const int*)val);
+        imagebuf_pool_trim();
+        return true;
+    }
+    if ((name == "imagebuf:hugepages" || name == "imagebuf:pool_hugepages")
+        && type == TypeInt) {
+        imagebuf_hugepages = *(const int*)val;
+        return true;
+    }
+    if (name == "imagebuf:scanline_align" && type == TypeInt) {
+        int align = *(const int*)val;
+        if (align < 0 || (align & (align - 1)))
+            return false;  // must be zero or a power of 2
+        imagebuf_scanline_align = align;
+        return true;
+    }
+    if (name == "imagebuf:read_threads" && type == TypeInt) {
+        imagebuf_read_threads = std::max(0, *(const int*)val);
+        return true;
+    }
+    if (name == "imagebuf:write_threads" && type == TypeInt) {
+        imagebuf_write_threads = std::max(0, *(const int*)val);
+        return true;
+    }
+    if (name == "imagebuf:write_max_MB" && type == TypeInt) {
+        imagebuf_write_max_MB = std::max(0, *(const int*)val);
+        return true;
+    }
     if (name == "use_tbb" && type == TypeInt) {
         oiio_use_tbb = *(const int*)val;
         return true;
     }
+    if (name == "nested_parallelism" && type == TypeInt) {
+        oiio_nested_parallelism = *(const int*)val;
+        return true;
+    }
+    if (name == "thread_budget" && type == TypeInt) {
+        thread_budget(*(const int*)val);
+        return true;
+    }
     if (name == "debug" && type == TypeInt) {
         oiio_print_debug = *(const int*)val;
         return true;
@@ -451,6 +676,15 @@ attribute(string_view name, TypeDesc type, const void* val)
         oiio_log_times = *(const int*)val;
         return true;
     }
+    if (name == "trace_file" && type == TypeString) {
+        std::lock_guard<std::mutex> lock(trace_log().mutex);
+        trace_log().set_file(*(const char**)val);
+        return true;
+    }
+    if (name == "dircache_ttl" && type == TypeFloat) {
+        Filesystem::set_directory_cache_ttl(*(const float*)val);
+        return true;
+    }
     if (name == "missingcolor" && type.basetype == TypeDesc::FLOAT) {
         // missingcolor as float array
         oiio_missingcolor.assign((const float*)val,
@@ -498,6 +732,10 @@ getattribute(string_view name, TypeDesc type, void* val)
         *(ustring*)val = plugin_searchpath;
         return true;
     }
+    if (name == "plugin_manifest" && type == TypeString) {
+        *(ustring*)val = plugin_manifest;
+        return true;
+    }
     if (name == "format_list" && type == TypeString) {
         if (format_list.empty())
             pvt::catalog_all_plugins(plugin_searchpath.string());
@@ -555,6 +793,10 @@ getattribute(string_view name, TypeDesc type, void* val)
         *(int*)val = openexr_core;
         return true;
     }
+    if (name == "openexr:core_output" && type == TypeInt) {
+        *(int*)val = openexr_core_output;
+        return true;
+    }
     if (name == "tiff:half" && type == TypeInt) {
         *(int*)val = tiff_half;
         return true;
@@ -575,6 +817,14 @@ getattribute(string_view name, TypeDesc type, void* val)
         *(int*)val = dds_bc5normal;
         return true;
     }
+    if (name == "ptex:max_memory_MB" && type == TypeInt) {
+        *(int*)val = ptex_max_memory_MB;
+        return true;
+    }
+    if (name == "colorconvert:lut3d" && type == TypeInt) {
+        *(int*)val = colorconvert_lut3d;
+        return true;
+    }
     if (name == "oiio:print_uncaught_errors" && type == TypeInt) {
         *(int*)val = oiio_print_uncaught_errors;
         return true;
@@ -587,10 +837,48 @@ getattribute(string_view name, TypeDesc type, void* val)
         *(int*)val = imagebuf_use_imagecache;
         return true;
     }
+    if (name == "imagebuf:allocator" && type == TypeString) {
+        static const char* names[] = { "heap", "pool", "pinned" };
+        *(ustring*)val = ustring(names[imagebuf_allocator]);
+        return true;
+    }
+    if (name == "imagebuf:pool_max_MB" && type == TypeInt) {
+        *(int*)val = imagebuf_pool_max_MB;
+        return true;
+    }
+    if ((name == "imagebuf:hugepages" || name == "imagebuf:pool_hugepages")
+        && type == TypeInt) {
+        *(int*)val = imagebuf_hugepages;
+        return true;
+    }
+    if (name == "imagebuf:scanline_align" && type == TypeInt) {
+        *(int*)val = imagebuf_scanline_align;
+        return true;
+    }
+    if (name == "imagebuf:read_threads" && type == TypeInt) {
+        *(int*)val = imagebuf_read_threads;
+        return true;
+    }
+    if (name == "imagebuf:write_threads" && type == TypeInt) {
+        *(int*)val = imagebuf_write_threads;
+        return true;
+    }
+    if (name == "imagebuf:write_max_MB" && type == TypeInt) {
+        *(int*)val = imagebuf_write_max_MB;
+        return true;
+    }
     if (name == "use_tbb" && type == TypeInt) {
         *(int*)val = oiio_use_tbb;
         return true;
     }
+    if (name == "nested_parallelism" && type == TypeInt) {
+        *(int*)val = oiio_nested_parallelism;
+        return true;
+    }
+    if (name == "thread_budget" && type == TypeInt) {
+        *(int*)val = thread_budget();
+        return true;
+    }
     if (name == "debug" && type == TypeInt) {
         *(int*)val = oiio_print_debug;
         return true;
@@ -599,6 +887,15 @@ getattribute(string_view name, TypeDesc type, void* val)
         *(int*)val = oiio_log_times;
         return true;
     }
+    if (name == "trace_file" && type == TypeString) {
+        std::lock_guard<std::mutex> lock(trace_log().mutex);
+        *(ustring*)val = ustring(trace_log().filename);
+        return true;
+    }
+    if (name == "dircache_ttl" && type == TypeFloat) {
+        *(float*)val = float(Filesystem::directory_cache_ttl());
+        return true;
+    }
     if (name == "timing_report" && type == TypeString) {
         *(ustring*)val = ustring(timing_log.report());
         return true;
@@ -845,6 +1142,102 @@ pvt::parallel_convert_from_float(const float* src, void* dst, size_t nvals,
 
 
 
+namespace {
+
+// Load 8 values as float, remapping integer types to [0,1].
+template<typename S>
+OIIO_FORCEINLINE simd::vfloat8
+load_normalized8(const S* src)
+{
+    simd::vfloat8 v(src);
+    if constexpr (std::is_integral<S>::value)
+        v *= simd::vfloat8(1.0f / float(std::numeric_limits<S>::max()));
+    return v;
+}
+
+// Store 8 floats, remapping [0,1] to the full range of integer types,
+// rounding exactly as the vfloat4 convert_type<float,uint8_t/uint16_t>
+// specializations do.
+template<typename D>
+OIIO_FORCEINLINE void
+store_normalized8(const simd::vfloat8& v, D* dst)
+{
+    if constexpr (std::is_integral<D>::value) {
+        const simd::vfloat8 max(float(std::numeric_limits<D>::max()));
+        simd::vfloat8 s = clamp(simd::round(v * max), simd::vfloat8::Zero(),
+                                max);
+        simd::vint8(s).store(dst);
+    } else {
+        v.store(dst);
+    }
+}
+
+template<typename S, typename D>
+void
+convert_simd8(const void* src_, void* dst_, size_t n)
+{
+    const S* src = (const S*)src_;
+    D* dst       = (D*)dst_;
+    for (; n >= 8; n -= 8, src += 8, dst += 8)
+        store_normalized8(load_normalized8(src), dst);
+    for (; n; --n)
+        *dst++ = convert_type<float, D>(convert_type<S, float>(*src++));
+}
+
+// half <-> float have their own bulk kernels, which can go wider than 8.
+void
+convert_half_float(const void* src, void* dst, size_t n)
+{
+    convert_half_to_float(cspan<half>((const half*)src, n),
+                          span<float>((float*)dst, n));
+}
+
+void
+convert_float_half(const void* src, void* dst, size_t n)
+{
+    convert_float_to_half(cspan<float>((const float*)src, n),
+                          span<half>((half*)dst, n));
+}
+
+}  // namespace
+
+
+
+// Direct conversions for the pairs that nearly every reader and writer
+// hits, a vfloat8 (or wider) at a time and without bouncing through a
+// float scratch buffer. Which instructions back them (AVX-512, AVX2/F16C,
+// SSE, NEON) is fixed at build time, as reported by the "oiio:simd"
+// attribute. Return false if the pair has no kernel.
+static bool
+convert_pixel_values_simd(TypeDesc src_type, const void* src,
+                          TypeDesc dst_type, void* dst, size_t n)
+{
+    using conv_fn = void (*)(const void*, void*, size_t);
+    conv_fn fn    = nullptr;
+    // clang-format off
+    switch (src_type.basetype << 8 | dst_type.basetype) {
+#define OIIO_CONV_PAIR(S, D, s, d) \
+    case TypeDesc::S << 8 | TypeDesc::D: fn = convert_simd8<s, d>; break
+    case TypeDesc::HALF << 8 | TypeDesc::FLOAT: fn = convert_half_float; break;
+    case TypeDesc::FLOAT << 8 | TypeDesc::HALF: fn = convert_float_half; break;
+    OIIO_CONV_PAIR(UINT8,  FLOAT,  uint8_t,  float);
+    OIIO_CONV_PAIR(FLOAT,  UINT8,  float,    uint8_t);
+    OIIO_CONV_PAIR(UINT16, FLOAT,  uint16_t, float);
+    OIIO_CONV_PAIR(FLOAT,  UINT16, float,    uint16_t);
+    OIIO_CONV_PAIR(UINT8,  HALF,   uint8_t,  half);
+    OIIO_CONV_PAIR(HALF,   UINT8,  half,     uint8_t);
+    OIIO_CONV_PAIR(UINT16, HALF,   uint16_t, half);
+    OIIO_CONV_PAIR(HALF,   UINT16, half,     uint16_t);
+#undef OIIO_CONV_PAIR
+    default: return false;
+    }
+    // clang-format on
+    fn(src, dst, n);
+    return true;
+}
+
+
+
 bool
 convert_pixel_values(TypeDesc src_type, const void* src, TypeDesc dst_type,
                      void* dst, int n)
@@ -855,6 +1248,12 @@ convert_pixel_values(TypeDesc src_type, const void* src, TypeDesc dst_type,
         return true;
     }
 
+    // Common pairs of scalar types have direct vectorized kernels
+    if (src_type.aggregate == TypeDesc::SCALAR && !src_type.arraylen
+        && dst_type.aggregate == TypeDesc::SCALAR && !dst_type.arraylen
+        && convert_pixel_values_simd(src_type, src, dst_type, dst, n))
+        return true;
+
     if (dst_type == TypeFloat) {
         // Special case -- converting non-float to float
         pvt::convert_to_float(src, (float*)dst, n, src_type);
@@ -983,6 +1382,50 @@ parallel_convert_image(int nchannels, int width, int height, int depth,
 
 
 
+int
+pvt::codec_threads(int requested)
+{
+    thread_pool* pool = default_thread_pool();
+    if (pool->is_worker())
+        return 1;  // Already one of many parallel jobs -- don't nest
+    int nthreads = requested > 0 ? requested : int(oiio_threads);
+    nthreads     = clamp(nthreads, 1, pool->size() + 1);
+    // Codecs with threads of their own can't be tracked while they run, so
+    // just don't start them with more than the budget has left right now.
+    return 1 + std::min(thread_budget_available(), nthreads - 1);
+}
+
+
+
+void
+pvt::codec_parallel_run(uint32_t begin, uint32_t end, int nthreads,
+                        function_view<void(uint32_t value, int thread_id)> func)
+{
+    if (end <= begin)
+        return;
+    thread_pool* pool = default_thread_pool();
+    nthreads = std::min(nthreads, int(end - begin));
+    if (nthreads <= 1 || pool->is_worker()) {
+        for (uint32_t v = begin; v < end; ++v)
+            func(v, 0);
+        return;
+    }
+    // Each participating thread owns one thread_id for its whole life and
+    // pulls values from a shared counter, so a thread_id is never in use
+    // by two threads at once, no matter how the work is scheduled. Running
+    // the thread_ids as a parallel loop lets the thread budget and any
+    // executor lent to OIIO govern them like any other parallel work.
+    std::atomic<uint32_t> next(begin);
+    auto worker = [&](int64_t tbegin, int64_t tend) {
+        for (int64_t t = tbegin; t < tend; ++t)
+            for (uint32_t v = next++; v < end; v = next++)
+                func(v, int(t));
+    };
+    parallel_for_chunked(0, nthreads, 1, worker, paropt(nthreads));
+}
+
+
+
 bool
 copy_image(int nchannels, int width, int height, int depth, const void* src,
            stride_t pixelsize, stride_t src_xstride, stride_t src_ystride,
@@ -996,6 +1439,15 @@ copy_image(int nchannels, int width, int height, int depth, const void* src,
                            nchannels, width, height);
     bool contig = (src_xstride == dst_xstride
                    && src_xstride == (stride_t)pixelsize);
+    // Whole planes with no gaps between the scanlines go in one piece.
+    stride_t planebytes = stride_t(width) * pixelsize * height;
+    if (contig && src_ystride == dst_ystride
+        && src_ystride == stride_t(width) * pixelsize) {
+        for (int z = 0; z < depth; ++z)
+            memcpy((char*)dst + z * dst_zstride,
+                   (const char*)src + z * src_zstride, planebytes);
+        return true;
+    }
     for (int z = 0; z < depth; ++z) {
         for (int y = 0; y < height; ++y) {
             const char* f = (const char*)src
@@ -1098,28 +1550,142 @@ add_dither(int nchannels, int width, int height, int depth, float* data,
 
 
 
-template<typename T>
+// Load 4 channel values as normalized floats, and store them back with
+// the same rounding and clamping as convert_type().
+inline simd::vfloat4
+premult_load(const float* p)
+{
+    return simd::vfloat4(p);
+}
+
+inline simd::vfloat4
+premult_load(const half* p)
+{
+    return simd::vfloat4(p);
+}
+
+inline simd::vfloat4
+premult_load(const unsigned char* p)
+{
+    return simd::vfloat4(p) * (1.0f / 255.0f);
+}
+
+inline simd::vfloat4
+premult_load(const unsigned short* p)
+{
+    return simd::vfloat4(p) * (1.0f / 65535.0f);
+}
+
+inline void
+premult_store(const simd::vfloat4& v, float* p)
+{
+    v.store(p);
+}
+
+inline void
+premult_store(const simd::vfloat4& v, half* p)
+{
+    v.store(p);
+}
+
+inline void
+premult_store(const simd::vfloat4& v, unsigned char* p)
+{
+    using namespace simd;
+    vint4(clamp(v * 255.0f + 0.5f, vfloat4::Zero(), vfloat4(255.0f))).store(p);
+}
+
+inline void
+premult_store(const simd::vfloat4& v, unsigned short* p)
+{
+    using namespace simd;
+    vint4(clamp(v * 65535.0f + 0.5f, vfloat4::Zero(), vfloat4(65535.0f)))
+        .store(p);
+}
+
+
+
+// Multiply or divide the color channels of a run of pixels by alpha. The
+// types with premult_load/premult_store overloads do four channels at a
+// time; the rest, and any leftover channels, go through DataArrayProxy.
+template<typename T, bool Simd>
 static void
-premult_impl(int width, int height, int depth, int chbegin, int chend, T* data,
-             stride_t xstride, stride_t ystride, stride_t zstride,
-             int alpha_channel, int z_channel)
+premult_span_impl(T* data, int npixels, stride_t xstride, int chbegin,
+                  int chend, int alpha_channel, int z_channel, bool divide,
+                  bool preserve_alpha0)
 {
-    char* plane = (char*)data;
-    for (int z = 0; z < depth; ++z, plane += zstride) {
-        char* scanline = plane;
-        for (int y = 0; y < height; ++y, scanline += ystride) {
-            char* pixel = scanline;
-            for (int x = 0; x < width; ++x, pixel += xstride) {
-                DataArrayProxy<T, float> val((T*)pixel);
-                float alpha = val[alpha_channel];
-                for (int c = chbegin; c < chend; ++c) {
-                    if (c == alpha_channel || c == z_channel)
-                        continue;
-                    val[c] = alpha * val[c];
-                }
+    using namespace simd;
+    // Which lanes of each 4-channel block are colors to be altered.
+    const int maxblocks = 16;
+    int nblocks         = 0;
+    vbool4 lanes[maxblocks];
+    if constexpr (Simd) {
+        for (; nblocks < maxblocks && chbegin + 4 * nblocks + 4 <= chend;
+             ++nblocks) {
+            int bits = 0;
+            for (int i = 0; i < 4; ++i) {
+                int c = chbegin + 4 * nblocks + i;
+                if (c != alpha_channel && c != z_channel)
+                    bits |= 1 << i;
             }
+            lanes[nblocks] = vbool4::from_bitmask(bits);
         }
     }
+    const int chscalar = chbegin + 4 * nblocks;
+    char* pixel        = (char*)data;
+    for (int x = 0; x < npixels; ++x, pixel += xstride) {
+        DataArrayProxy<T, float> val((T*)pixel);
+        float alpha = val[alpha_channel];
+        if (alpha == 1.0f || ((divide || preserve_alpha0) && alpha == 0.0f))
+            continue;
+        if constexpr (Simd) {
+            vfloat4 a(alpha);
+            for (int b = 0; b < nblocks; ++b) {
+                T* p      = (T*)pixel + chbegin + 4 * b;
+                vfloat4 v = premult_load(p);
+                premult_store(select(lanes[b], divide ? v / a : v * a, v), p);
+            }
+        }
+        for (int c = chscalar; c < chend; ++c) {
+            if (c == alpha_channel || c == z_channel)
+                continue;
+            val[c] = divide ? val[c] / alpha : val[c] * alpha;
+        }
+    }
+}
+
+
+
+void
+pvt::premult_span(TypeDesc format, void* data, int npixels, int nchannels,
+                  stride_t xstride, int chbegin, int chend, int alpha_channel,
+                  int z_channel, bool divide, bool preserve_alpha0)
+{
+    if (alpha_channel < 0 || alpha_channel >= nchannels)
+        return;  // nothing to do
+    if (xstride == AutoStride)
+        xstride = stride_t(format.size()) * nchannels;
+    chbegin = std::max(chbegin, 0);
+    chend   = std::min(chend, nchannels);
+#define PREMULT_SPAN(T, S)                                              \
+    premult_span_impl<T, S>((T*)data, npixels, xstride, chbegin, chend, \
+                            alpha_channel, z_channel, divide,           \
+                            preserve_alpha0)
+    switch (format.basetype) {
+    case TypeDesc::FLOAT: PREMULT_SPAN(float, true); break;
+    case TypeDesc::UINT8: PREMULT_SPAN(unsigned char, true); break;
+    case TypeDesc::UINT16: PREMULT_SPAN(unsigned short, true); break;
+    case TypeDesc::HALF: PREMULT_SPAN(half, true); break;
+    case TypeDesc::INT8: PREMULT_SPAN(char, false); break;
+    case TypeDesc::INT16: PREMULT_SPAN(short, false); break;
+    case TypeDesc::INT: PREMULT_SPAN(int, false); break;
+    case TypeDesc::UINT: PREMULT_SPAN(unsigned int, false); break;
+    case TypeDesc::INT64: PREMULT_SPAN(int64_t, false); break;
+    case TypeDesc::UINT64: PREMULT_SPAN(uint64_t, false); break;
+    case TypeDesc::DOUBLE: PREMULT_SPAN(double, false); break;
+    default: OIIO_ASSERT(0 && "OIIO::premult() of an unsupported type"); break;
+    }
+#undef PREMULT_SPAN
 }
 
 
@@ -1133,53 +1699,12 @@ premult(int nchannels, int width, int height, int depth, int chbegin, int chend,
         return;  // nothing to do
     ImageSpec::auto_stride(xstride, ystride, zstride, datatype.size(),
                            nchannels, width, height);
-    switch (datatype.basetype) {
-    case TypeDesc::FLOAT:
-        premult_impl(width, height, depth, chbegin, chend, (float*)data,
-                     xstride, ystride, zstride, alpha_channel, z_channel);
-        break;
-    case TypeDesc::UINT8:
-        premult_impl(width, height, depth, chbegin, chend, (unsigned char*)data,
-                     xstride, ystride, zstride, alpha_channel, z_channel);
-        break;
-    case TypeDesc::UINT16:
-        premult_impl(width, height, depth, chbegin, chend,
-                     (unsigned short*)data, xstride, ystride, zstride,
-                     alpha_channel, z_channel);
-        break;
-    case TypeDesc::HALF:
-        premult_impl(width, height, depth, chbegin, chend, (half*)data, xstride,
-                     ystride, zstride, alpha_channel, z_channel);
-        break;
-    case TypeDesc::INT8:
-        premult_impl(width, height, depth, chbegin, chend, (char*)data, xstride,
-                     ystride, zstride, alpha_channel, z_channel);
-        break;
-    case TypeDesc::INT16:
-        premult_impl(width, height, depth, chbegin, chend, (short*)data,
-                     xstride, ystride, zstride, alpha_channel, z_channel);
-        break;
-    case TypeDesc::INT:
-        premult_impl(width, height, depth, chbegin, chend, (int*)data, xstride,
-                     ystride, zstride, alpha_channel, z_channel);
-        break;
-    case TypeDesc::UINT:
-        premult_impl(width, height, depth, chbegin, chend, (unsigned int*)data,
-                     xstride, ystride, zstride, alpha_channel, z_channel);
-        break;
-    case TypeDesc::INT64:
-        premult_impl(width, height, depth, chbegin, chend, (int64_t*)data,
-                     xstride, ystride, zstride, alpha_channel, z_channel);
-        break;
-    case TypeDesc::UINT64:
-        premult_impl(width, height, depth, chbegin, chend, (uint64_t*)data,
-                     xstride, ystride, zstride, alpha_channel, z_channel);
-        break;
-    case TypeDesc::DOUBLE:
-        premult_impl(width, height, depth, chbegin, chend, (double*)data,
-                     xstride, ystride, zstride, alpha_channel, z_channel);
-        break;
-    default: OIIO_ASSERT(0 && "OIIO::premult() of an unsupported type"); break;
+    char* plane = (char*)data;
+    for (int z = 0; z < depth; ++z, plane += zstride) {
+        char* scanline = plane;
+        for (int y = 0; y < height; ++y, scanline += ystride)
+            pvt::premult_span(datatype, scanline, width, nchannels, xstride,
+                              chbegin, chend, alpha_channel, z_channel);
     }
 }
 
@@ -4,6 +4,7 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <ctime>
 #include <map>
 #include <set>
 #include <string>
@@ -14,6 +15,7 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/plugin.h>
 #include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
 
 #include "imageio_pvt.h"
 
@@ -51,6 +53,40 @@ static std::set<std::string> procedural_plugins;
 static std::string pattern = Strutil::fmt::format(".imageio.{}",
                                                   Plugin::plugin_extension());
 
+// What one plugin DSO provides, as recorded in the plugin manifest.
+struct ManifestEntry {
+    std::string path;
+    std::time_t mtime = 0;
+    uint64_t size     = 0;
+    std::string format;
+    std::vector<std::string> input_extensions, output_extensions;
+    bool has_input = false, has_output = false, procedural = false;
+    std::string lib_version;
+    // Registered from the manifest but not yet loaded, and the names and
+    // extensions whose catalog entries are placeholders for it.
+    bool deferred = false;
+    std::vector<std::string> input_keys, output_keys;
+};
+
+// Map format name to manifest entry, for every plugin loaded from a DSO
+// or registered from the manifest.
+static std::map<std::string, ManifestEntry> plugin_manifest_entries;
+
+// Placeholder creators for formats registered from the manifest whose
+// plugins haven't been loaded yet. Finding one of these in input_formats
+// or output_formats means "load the plugin, then look again."
+static ImageInput*
+deferred_input_create()
+{
+    return nullptr;
+}
+
+static ImageOutput*
+deferred_output_create()
+{
+    return nullptr;
+}
+
 
 inline void
 add_if_missing(std::vector<std::string>& vec, const std::string& val)
@@ -233,14 +269,276 @@ catalog_plugin(const std::string& format_name,
         = (const char**)Plugin::getsym(handle,
                                        format_name + "_output_extensions");
 
-    if (input_creator || output_creator)
+    if (input_creator || output_creator) {
+        const char* lib_version = plugin_lib_version ? plugin_lib_version()
+                                                     : NULL;
         declare_imageio_format_locked(format_name, input_creator,
                                       input_extensions, output_creator,
-                                      output_extensions,
-                                      plugin_lib_version ? plugin_lib_version()
-                                                         : NULL);
-    else
+                                      output_extensions, lib_version);
+        // Remember what it provides, for the plugin manifest
+        ManifestEntry entry;
+        entry.path       = plugin_fullpath;
+        entry.mtime      = Filesystem::last_write_time(plugin_fullpath);
+        entry.size       = Filesystem::file_size(plugin_fullpath);
+        entry.format     = format_name;
+        entry.has_input  = input_creator != nullptr;
+        entry.has_output = output_creator != nullptr;
+        for (const char** e = input_extensions; e && *e; ++e)
+            entry.input_extensions.emplace_back(Strutil::lower(*e));
+        for (const char** e = output_extensions; e && *e; ++e)
+            entry.output_extensions.emplace_back(Strutil::lower(*e));
+        if (lib_version)
+            entry.lib_version = lib_version;
+        plugin_manifest_entries[format_name] = std::move(entry);
+    } else {
         Plugin::close(handle);  // not useful
+    }
+}
+
+
+
+// Load the plugin for a format that was registered from the manifest and
+// replace its placeholder creators with the real ones. If it can't be
+// loaded, its placeholders are removed, as if it had never been found.
+// Call with imageio_mutex held.
+static void
+load_deferred_plugin_locked(ManifestEntry& entry)
+{
+    entry.deferred = false;
+    ImageInput::Creator input_creator   = nullptr;
+    ImageOutput::Creator output_creator = nullptr;
+    Plugin::Handle handle               = Plugin::open(entry.path);
+    if (handle) {
+        std::string version_function = entry.format + "_imageio_version";
+        int* plugin_version          = (int*)Plugin::getsym(handle,
+                                                   version_function.c_str());
+        if (plugin_version && *plugin_version == OIIO_PLUGIN_VERSION) {
+            input_creator = (ImageInput::Creator)Plugin::getsym(
+                handle, entry.format + "_input_imageio_create");
+            output_creator = (ImageOutput::Creator)Plugin::getsym(
+                handle, entry.format + "_output_imageio_create");
+        }
+        if (input_creator || output_creator)
+            plugin_handles[entry.format] = handle;
+        else
+            Plugin::close(handle);
+    }
+    if (!input_creator && !output_creator)
+        OIIO::debugfmt("OpenImageIO: could not load plugin \"{}\" listed "
+                       "in the plugin manifest\n",
+                       entry.path);
+    for (const auto& key : entry.input_keys) {
+        auto found = input_formats.find(key);
+        if (found == input_formats.end()
+            || found->second != deferred_input_create)
+            continue;
+        if (input_creator)
+            found->second = input_creator;
+        else
+            input_formats.erase(found);
+    }
+    for (const auto& key : entry.output_keys) {
+        auto found = output_formats.find(key);
+        if (found == output_formats.end()
+            || found->second != deferred_output_create)
+            continue;
+        if (output_creator)
+            found->second = output_creator;
+        else
+            output_formats.erase(found);
+    }
+}
+
+
+
+// Return the ImageInput creator for a format name or extension, loading
+// its plugin first if it's only known from the manifest. Call with
+// imageio_mutex held.
+static ImageInput::Creator
+input_creator_locked(const std::string& key)
+{
+    auto found = input_formats.find(key);
+    if (found != input_formats.end()
+        && found->second == deferred_input_create) {
+        for (auto& e : plugin_manifest_entries)
+            if (e.second.deferred
+                && std::find(e.second.input_keys.begin(),
+                             e.second.input_keys.end(), key)
+                       != e.second.input_keys.end())
+                load_deferred_plugin_locked(e.second);
+        found = input_formats.find(key);
+    }
+    return found != input_formats.end() ? found->second : nullptr;
+}
+
+
+
+// Return the ImageOutput creator for a format name or extension, loading
+// its plugin first if it's only known from the manifest. Call with
+// imageio_mutex held.
+static ImageOutput::Creator
+output_creator_locked(const std::string& key)
+{
+    auto found = output_formats.find(key);
+    if (found != output_formats.end()
+        && found->second == deferred_output_create) {
+        for (auto& e : plugin_manifest_entries)
+            if (e.second.deferred
+                && std::find(e.second.output_keys.begin(),
+                             e.second.output_keys.end(), key)
+                       != e.second.output_keys.end())
+                load_deferred_plugin_locked(e.second);
+        found = output_formats.find(key);
+    }
+    return found != output_formats.end() ? found->second : nullptr;
+}
+
+
+
+static std::string
+plugin_manifest_header()
+{
+    return Strutil::fmt::format("# OpenImageIO plugin manifest {} {}",
+                                OIIO_VERSION_STRING, OIIO_PLUGIN_VERSION);
+}
+
+
+
+// Register every format listed in the plugin manifest, without loading
+// any plugins, if the manifest is up to date for the directories in
+// `dirs`. Return false (registering nothing) if it isn't. Call with
+// imageio_mutex held.
+static bool
+catalog_from_manifest_locked(const std::string& manifest,
+                             const std::vector<std::string>& dirs)
+{
+    std::string text;
+    if (!Filesystem::read_text_file(manifest, text))
+        return false;
+    std::vector<std::string> lines = Strutil::splits(text, "\n");
+    if (lines.empty() || lines[0] != plugin_manifest_header())
+        return false;
+
+    // First validate everything: same directories, none of them or their
+    // plugins modified since the manifest was written.
+    size_t ndirs = 0;
+    std::vector<ManifestEntry> entries;
+    for (size_t i = 1; i < lines.size(); ++i) {
+        if (lines[i].empty())
+            continue;
+        std::vector<std::string> f = Strutil::splits(lines[i], "\t");
+        if (f[0] == "dir" && f.size() == 3) {
+            if (ndirs >= dirs.size() || f[1] != dirs[ndirs]
+                || Strutil::from_string<int64_t>(f[2])
+                       != int64_t(Filesystem::last_write_time(dirs[ndirs])))
+                return false;
+            ++ndirs;
+        } else if (f[0] == "plugin" && f.size() == 9) {
+            ManifestEntry e;
+            e.path  = f[1];
+            e.mtime = std::time_t(Strutil::from_string<int64_t>(f[2]));
+            e.size  = Strutil::from_string<uint64_t>(f[3]);
+            if (e.mtime != Filesystem::last_write_time(e.path)
+                || e.size != Filesystem::file_size(e.path))
+                return false;
+            e.format            = f[4];
+            e.has_input         = Strutil::contains(f[5], "i");
+            e.has_output        = Strutil::contains(f[5], "o");
+            e.procedural        = Strutil::contains(f[5], "p");
+            e.input_extensions  = Strutil::splits(f[6], ",");
+            e.output_extensions = Strutil::splits(f[7], ",");
+            e.lib_version       = f[8];
+            entries.push_back(std::move(e));
+        } else {
+            return false;
+        }
+    }
+    if (ndirs != dirs.size())
+        return false;
+
+    // It's good. Register each format with placeholder creators.
+    for (auto& e : entries) {
+        if (plugin_filepaths.find(e.format) != plugin_filepaths.end())
+            continue;  // already cataloged
+        plugin_filepaths[e.format] = e.path;
+        std::vector<const char*> inexts, outexts;
+        for (const auto& x : e.input_extensions)
+            inexts.push_back(x.c_str());
+        for (const auto& x : e.output_extensions)
+            outexts.push_back(x.c_str());
+        inexts.push_back(nullptr);
+        outexts.push_back(nullptr);
+        // Note which names and extensions are still free, which are the
+        // ones this plugin will own once it's declared.
+        if (e.has_input) {
+            for (const auto& k : e.input_extensions)
+                if (input_formats.find(k) == input_formats.end())
+                    add_if_missing(e.input_keys, k);
+            if (input_formats.find(e.format) == input_formats.end())
+                add_if_missing(e.input_keys, e.format);
+        }
+        if (e.has_output) {
+            for (const auto& k : e.output_extensions)
+                if (output_formats.find(k) == output_formats.end())
+                    add_if_missing(e.output_keys, k);
+            if (output_formats.find(e.format) == output_formats.end())
+                add_if_missing(e.output_keys, e.format);
+        }
+        declare_imageio_format_locked(
+            e.format, e.has_input ? deferred_input_create : nullptr,
+            inexts.data(), e.has_output ? deferred_output_create : nullptr,
+            outexts.data(),
+            e.lib_version.size() ? e.lib_version.c_str() : nullptr);
+        if (e.procedural)
+            for (const auto& k : e.input_keys)
+                procedural_plugins.insert(k);
+        e.deferred                        = true;
+        plugin_manifest_entries[e.format] = std::move(e);
+    }
+    return true;
+}
+
+
+
+// Write the manifest for the given plugins found in `dirs`, unless it's
+// already identical. Call with imageio_mutex held.
+static void
+write_plugin_manifest_locked(const std::string& manifest,
+                             const std::vector<std::string>& dirs,
+                             const std::vector<std::string>& formats)
+{
+    std::string text = plugin_manifest_header() + "\n";
+    for (const auto& dir : dirs)
+        text += Strutil::fmt::format("dir\t{}\t{}\n", dir,
+                                     int64_t(Filesystem::last_write_time(dir)));
+    for (const auto& format : formats) {
+        ManifestEntry& e = plugin_manifest_entries[format];
+        e.procedural = procedural_plugins.count(e.format) > 0;
+        std::string flags = Strutil::fmt::format("{}{}{}",
+                                                 e.has_input ? "i" : "",
+                                                 e.has_output ? "o" : "",
+                                                 e.procedural ? "p" : "");
+        std::string lib_version = Strutil::replace(
+            Strutil::replace(e.lib_version, "\t", " ", true), "\n", " ", true);
+        text += Strutil::fmt::format(
+            "plugin\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\n", e.path,
+            int64_t(e.mtime), e.size, e.format, flags,
+            Strutil::join(e.input_extensions, ","),
+            Strutil::join(e.output_extensions, ","), lib_version);
+    }
+    std::string old;
+    if (Filesystem::read_text_file(manifest, old) && old == text)
+        return;
+    // Write to a temporary and rename, so that other processes reading
+    // the manifest never see it half written.
+    std::string tmp = manifest + Filesystem::unique_path(".%%%%-%%%%.tmp");
+    std::string err;
+    if (!Filesystem::write_text_file(tmp, text)
+        || !Filesystem::rename(tmp, manifest, err)) {
+        Filesystem::remove(tmp);
+        OIIO::debugfmt("OpenImageIO: could not write plugin manifest \"{}\"\n",
+                       manifest);
+    }
 }
 
 
@@ -352,7 +650,7 @@ catalog_builtin_plugins()
     DECLAREPLUG_RO (cineon);
 #endif
 #if !defined(DISABLE_DDS)
-    DECLAREPLUG_RO (dds);
+    DECLAREPLUG (dds);
 #endif
 #if defined(USE_DCMTK) && !defined(DISABLE_DICOM)
     DECLAREPLUG_RO (dicom);
@@ -473,7 +771,17 @@ pvt::catalog_all_plugins(std::string searchpath)
     size_t patlen = pattern.length();
     std::vector<std::string> dirs;
     Filesystem::searchpath_split(searchpath, dirs, true);
+
+    // If there's an up-to-date plugin manifest, it tells us everything
+    // the directory scan below would, without loading any plugins.
+    std::string manifest = plugin_manifest.string();
+    bool from_manifest   = manifest.size()
+                         && catalog_from_manifest_locked(manifest, dirs);
+
+    std::vector<std::string> scanned;  // plugins found, for the manifest
     for (const auto& dir : dirs) {
+        if (from_manifest)
+            break;
         std::vector<std::string> dir_entries;
         Filesystem::get_directory_entries(dir, dir_entries);
         for (const auto& full_filename : dir_entries) {
@@ -484,13 +792,20 @@ pvt::catalog_all_plugins(std::string searchpath)
                 std::string pluginname(leaf.begin(),
                                        leaf.begin() + leaf.length() - patlen);
                 catalog_plugin(pluginname, full_filename);
+                auto entry = plugin_manifest_entries.find(pluginname);
+                if (entry != plugin_manifest_entries.end()
+                    && entry->second.path == full_filename)
+                    scanned.push_back(pluginname);
             }
         }
     }
 
-    // Inventory the procedural plugins
+    // Inventory the procedural plugins (skipping any not yet loaded,
+    // which the manifest already told us about).
     auto current_input_formats = input_formats;  // do a copy
     for (auto&& f : current_input_formats) {
+        if (f.second == deferred_input_create)
+            continue;
         lock.unlock();
         // ImageInput::create will take a lock of imageio_mutex
         auto inp = ImageInput::create(f.first);
@@ -498,6 +813,9 @@ pvt::catalog_all_plugins(std::string searchpath)
         if (inp->supports("procedural"))
             procedural_plugins.insert(f.first);
     }
+
+    if (manifest.size() && !from_manifest)
+        write_plugin_manifest_locked(manifest, dirs, scanned);
 }
 
 
@@ -552,9 +870,9 @@ ImageOutput::create(string_view filename, Filesystem::IOProxy* ioproxy,
             lock.lock();
             found = output_formats.find(format);
         }
-        if (found != output_formats.end()) {
-            create_function = found->second;
-        } else {
+        if (found != output_formats.end())
+            create_function = output_creator_locked(format);
+        if (!create_function) {
             if (output_formats.empty()) {
                 // This error is so fundamental, we echo it to stderr in
                 // case the app is too dumb to do so.
@@ -694,7 +1012,7 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
             found = input_formats.find(format);
         }
         if (found != input_formats.end())
-            create_function = found->second;
+            create_function = input_creator_locked(format);
     }
 
     // Remember which prototypes we've already tried, so we don't double dip.
@@ -757,20 +1075,20 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
         myconfig.attribute("nowait", (int)1);
         std::lock_guard<std::recursive_mutex> lock(imageio_mutex);
         for (auto f : format_list_vector) {
-            auto plugin = input_formats.find(f.string());
-            if (plugin == input_formats.end() || !plugin->second)
+            ImageInput::Creator plugin_create = input_creator_locked(
+                f.string());
+            if (!plugin_create)
                 continue;  // format that's output only
             // If we already tried this create function, don't do it again
             if (std::find(formats_tried.begin(), formats_tried.end(),
-                          plugin->second)
+                          plugin_create)
                 != formats_tried.end())
                 continue;
-            formats_tried.push_back(plugin->second);  // remember
+            formats_tried.push_back(plugin_create);  // remember
 
             ImageSpec tmpspec;
             try {
-                ImageInput::Creator create_function = plugin->second;
-                in = std::unique_ptr<ImageInput>(create_function());
+                in = std::unique_ptr<ImageInput>(plugin_create());
             } catch (...) {
                 // Safety in case the ctr throws an exception
             }
@@ -782,7 +1100,7 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
                 if (pvt::oiio_print_debug > 1)
                     OIIO::debugfmt(
                         "ImageInput::create: \"{}\" did not open using format \"{}\" {} [valid_file was false].\n",
-                        filename, plugin->first, in->format_name());
+                        filename, f, in->format_name());
                 in.reset();
                 continue;
             }
@@ -796,13 +1114,13 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
                 if (pvt::oiio_print_debug > 1)
                     OIIO::debugfmt(
                         "ImageInput::create: \"{}\" succeeded using format \"{}\".\n",
-                        filename, plugin->first);
+                        filename, f);
                 return in;
             }
             if (pvt::oiio_print_debug > 1)
                 OIIO::debugfmt(
                     "ImageInput::create: \"{}\" did not open using format \"{}\" {}.\n",
-                    filename, plugin->first, in->format_name());
+                    filename, f, in->format_name());
             in.reset();
         }
     }
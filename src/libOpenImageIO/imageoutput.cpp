@@ -19,6 +19,7 @@
 #include <OpenImageIO/plugin.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/thread.h>
+#include <OpenImageIO/tiffutils.h>
 #include <OpenImageIO/typedesc.h>
 
 #include "imageio_pvt.h"
@@ -115,6 +116,7 @@ ImageOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
                              const void* data, stride_t xstride,
                              stride_t ystride)
 {
+    pvt::TraceScope trace("ImageOutput::write_scanlines");
     // Default implementation: write each scanline individually
     stride_t native_pixel_bytes = (stride_t)m_spec.pixel_bytes(true);
     if (format == TypeDesc::UNKNOWN && xstride == AutoStride)
@@ -148,6 +150,7 @@ ImageOutput::write_tiles(int xbegin, int xend, int ybegin, int yend, int zbegin,
                          int zend, TypeDesc format, const void* data,
                          stride_t xstride, stride_t ystride, stride_t zstride)
 {
+    pvt::TraceScope trace("ImageOutput::write_tiles");
     if (!m_spec.valid_tile_range(xbegin, xend, ybegin, yend, zbegin, zend))
         return false;
 
@@ -482,6 +485,7 @@ ImageOutput::write_image(TypeDesc format, const void* data, stride_t xstride,
                          ProgressCallback progress_callback,
                          void* progress_callback_data)
 {
+    pvt::TraceScope trace("ImageOutput::write_image");
     bool native          = (format == TypeDesc::UNKNOWN);
     stride_t pixel_bytes = native ? (stride_t)m_spec.pixel_bytes(native)
                                   : format.size() * m_spec.nchannels;
@@ -868,6 +872,12 @@ ImageOutput::check_open(OpenMode mode, const ImageSpec& userspec, ROI range,
     // Note: we only overwrite m_spec if the requested mode was valid.
     m_spec = userspec;
 
+    // A reader opened with the "lazy" metadata hint may have left
+    // undecoded Exif/XMP/IPTC blocks in the spec. They aren't metadata to
+    // write out as they are, so decode them into ordinary attributes
+    // (which also removes them) for the writer to handle as usual.
+    decode_raw_metadata(m_spec);
+
     // Check for sensible resolutions, etc.
     if (m_spec.width > range.width() || m_spec.height > range.height()) {
         errorfmt("{} image resolution may not exceed {}x{}, you asked for {}x{}",
@@ -328,6 +328,121 @@ test_imagespec_from_xml()
 
 
 
+static void
+test_imagespec_binary()
+{
+    std::cout << "test_imagespec_binary\n";
+    ImageSpec spec(640, 480, 4, TypeHalf);
+    spec.x               = -10;
+    spec.full_width      = 1024;
+    spec.tile_width      = 64;
+    spec.tile_height     = 64;
+    spec.channelformats  = { TypeHalf, TypeHalf, TypeHalf, TypeFloat };
+    spec.channelnames[3] = "A.weird";
+    spec.attribute("oiio:ColorSpace", "scene_linear");
+    spec.attribute("compression", "zip");
+    spec.attribute("Orientation", 3);
+    const float matrix[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                               15, 16 };
+    spec.attribute("worldtocamera", TypeMatrix, matrix);
+    ustring names[2] = { ustring("one"), ustring("two") };
+    spec.attribute("names", TypeDesc(TypeDesc::STRING, 2), names);
+    int dummy = 0;
+    void* ptr = &dummy;
+    spec.attribute("pointer", TypeDesc::PTR, &ptr);
+
+    std::vector<unsigned char> buf;
+    spec.to_binary(buf);
+    size_t encoded = buf.size();
+    buf.push_back(42);  // extra trailing bytes are left alone
+
+    ImageSpec copy;
+    OIIO_CHECK_EQUAL(copy.from_binary(buf), encoded);
+    OIIO_CHECK_EQUAL(copy.x, -10);
+    OIIO_CHECK_EQUAL(copy.width, 640);
+    OIIO_CHECK_EQUAL(copy.full_width, 1024);
+    OIIO_CHECK_EQUAL(copy.tile_height, 64);
+    OIIO_CHECK_EQUAL(copy.format, TypeHalf);
+    OIIO_CHECK_EQUAL(copy.alpha_channel, 3);
+    OIIO_CHECK_EQUAL(copy.channelformats.size(), 4);
+    OIIO_CHECK_EQUAL(copy.channelformats[3], TypeFloat);
+    OIIO_CHECK_EQUAL(copy.channelnames[3], "A.weird");
+    OIIO_CHECK_EQUAL(copy.get_string_attribute("oiio:ColorSpace"),
+                     "scene_linear");
+    OIIO_CHECK_EQUAL(copy.get_int_attribute("Orientation"), 3);
+    const ParamValue* p = copy.find_attribute("worldtocamera", TypeMatrix);
+    OIIO_CHECK_ASSERT(p && ((const float*)p->data())[15] == 16.0f);
+    p = copy.find_attribute("names");
+    OIIO_CHECK_ASSERT(p && p->type() == TypeDesc(TypeDesc::STRING, 2));
+    OIIO_CHECK_EQUAL(p ? ((const ustring*)p->data())[1] : ustring(),
+                     ustring("two"));
+    OIIO_CHECK_ASSERT(copy.find_attribute("pointer") == nullptr);
+    OIIO_CHECK_EQUAL(copy.extra_attribs.size(), spec.extra_attribs.size() - 1);
+
+    // Truncated or corrupted encodings are rejected without changing the
+    // spec.
+    for (size_t len : { size_t(0), size_t(3), size_t(20), encoded - 1 }) {
+        ImageSpec bad(8, 8, 1, TypeUInt8);
+        OIIO_CHECK_EQUAL(bad.from_binary(cspan<unsigned char>(buf.data(), len)),
+                         0);
+        OIIO_CHECK_EQUAL(bad.width, 8);
+    }
+    buf[4] = 99;  // a version from the future
+    OIIO_CHECK_EQUAL(copy.from_binary(buf), 0);
+
+    // An attribute whose value count times array length overflows must be
+    // rejected, not read past the end of the buffer. The last attribute
+    // is laid out as name (4+1 bytes), type (basetype, aggregate,
+    // vecsemantics, reserved, int32 arraylen), int32 nvalues, uint8
+    // interp, then its 4 bytes of data.
+    ImageSpec one(8, 8, 1, TypeUInt8);
+    one.extra_attribs.clear();
+    one.attribute("a", 1);
+    buf.clear();
+    one.to_binary(buf);
+    auto put32 = [&](size_t offset, uint32_t v) {
+        for (int b = 0; b < 4; ++b)
+            buf[offset + b] = (unsigned char)(v >> (8 * b));
+    };
+    size_t attr = buf.size() - 22;
+    buf[attr + 6] = 16;            // aggregate
+    put32(attr + 9, 0x40000000);   // arraylen
+    put32(attr + 13, 0x40000000);  // nvalues: the product wraps to 0
+    OIIO_CHECK_EQUAL(copy.from_binary(buf), 0);
+    put32(attr + 9, 0);
+    put32(attr + 13, 1000);  // merely more values than there are bytes
+    OIIO_CHECK_EQUAL(copy.from_binary(buf), 0);
+
+    // Channel fields that disagree with each other are rejected. After the
+    // magic, version, 15 int32 dimensions and the format come int32
+    // nchannels, alpha_channel and z_channel.
+    one.alpha_channel = 0;
+    buf.clear();
+    one.to_binary(buf);
+    OIIO_CHECK_EQUAL(copy.from_binary(buf), buf.size());
+    const std::vector<unsigned char> good = buf;
+    const size_t chans                    = 4 + 4 + 15 * 4 + 8;
+    for (uint32_t nch : { uint32_t(-1), 0u, 2u }) {
+        buf = good;
+        put32(chans, nch);  // nchannels disagrees with channelnames
+        OIIO_CHECK_EQUAL(copy.from_binary(buf), 0);
+    }
+    for (size_t field : { chans + 4, chans + 8 }) {
+        for (uint32_t c : { uint32_t(-2), 1u }) {
+            buf = good;
+            put32(field, c);  // alpha or z channel out of range
+            OIIO_CHECK_EQUAL(copy.from_binary(buf), 0);
+        }
+    }
+    one.channelformats = { TypeUInt8, TypeHalf };  // more than nchannels
+    buf.clear();
+    one.to_binary(buf);
+    OIIO_CHECK_EQUAL(copy.from_binary(buf), 0);
+    OIIO_CHECK_EQUAL(copy.nchannels, 1);  // still the last good decode
+}
+
+
+
 int
 main(int /*argc*/, char* /*argv*/[])
 {
@@ -337,6 +452,7 @@ main(int /*argc*/, char* /*argv*/[])
     test_get_attribute();
     test_imagespec_from_ROI();
     test_imagespec_from_xml();
+    test_imagespec_binary();
 
     return unit_test_failures;
 }
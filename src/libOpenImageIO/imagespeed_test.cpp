@@ -5,28 +5,48 @@
 
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/texture.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/timer.h>
 #include <OpenImageIO/unittest.h>
 #include <OpenImageIO/ustring.h>
 
+#include <atomic>
+#include <cmath>
 #include <functional>
 #include <iostream>
+#include <random>
 #include <vector>
 
 using namespace OIIO;
 
-static bool verbose      = false;
-static int iterations    = 1;
-static int ntrials       = 1;
-static int numthreads    = 0;
-static int autotile_size = 64;
-static bool iter_only    = false;
-static bool no_iter      = false;
+static bool verbose       = false;
+static int iterations     = 1;
+static int ntrials        = 1;
+static int numthreads     = 0;
+static int autotile_size  = 64;
+static bool iter_only     = false;
+static bool no_iter       = false;
+static bool no_iba        = false;
+static bool no_convert    = false;
+static bool no_premult    = false;
+static bool no_icrandom   = false;
+static bool no_texture    = false;
+static bool no_codecs     = false;
+static bool scaling       = false;
+static bool hugepages     = false;
+static int scanline_align = 0;
+static float working_set  = 256;
+static std::string codecs = "tif,exr,png,jpg";
+static std::string json_filename;
 static std::string conversionname;
 static TypeDesc conversion = TypeDesc::UNKNOWN;  // native by default
 static std::vector<ustring> input_filename;
@@ -65,6 +85,30 @@ getargs(int argc, char* argv[])
       .help("Run ImageBuf iteration tests only (not read tests)");
     ap.arg("--noiter", &no_iter)
       .help("Don't run ImageBuf iteration tests");
+    ap.arg("--noiba", &no_iba)
+      .help("Don't run ImageBufAlgo (resize, convolve) tests");
+    ap.arg("--noconvert", &no_convert)
+      .help("Don't run pixel data type conversion tests");
+    ap.arg("--nopremult", &no_premult)
+      .help("Don't run alpha premultiplication tests");
+    ap.arg("--noicrandom", &no_icrandom)
+      .help("Don't run multithreaded ImageCache random tile access tests");
+    ap.arg("--notexture", &no_texture)
+      .help("Don't run TextureSystem lookup tests");
+    ap.arg("--nocodecs", &no_codecs)
+      .help("Don't run per-format encode/decode tests");
+    ap.arg("--workingset %f:MB", &working_set)
+      .help(Strutil::fmt::format("Size of the tiles touched by the random tile access tests, in MB (default: {}; compare to --cache)", working_set));
+    ap.arg("--codecs %s:EXT,...", &codecs)
+      .help(Strutil::fmt::format("File formats (by extension) for the encode/decode tests (default: {})", codecs));
+    ap.arg("--scaling", &scaling)
+      .help("Run the threaded tests at each thread count from 1 up to the number of cores");
+    ap.arg("--json %s:FILE", &json_filename)
+      .help("Also record the benchmark results in FILE, as Benchmarker JSON");
+    ap.arg("--hugepages", &hugepages)
+      .help("Use huge pages for large ImageBuf allocations (sets imagebuf:hugepages)");
+    ap.arg("--scanline-align %d", &scanline_align)
+      .help("Pad ImageBuf scanlines to this many bytes (sets imagebuf:scanline_align)");
     ap.arg("--convert %s", &conversionname)
       .help("Convert to named type upon read (default: native)");
     ap.arg("--cache %f", &cache_size)
@@ -450,6 +494,350 @@ test_pixel_iteration(const std::string& explanation,
 
 
 
+static void
+test_iba(const std::string& explanation,
+         const std::function<void(const ImageBuf&)>& func, int iters = 4)
+{
+    // Load the first image as float so the ops work on the memory layout
+    // chosen by the imagebuf:hugepages and imagebuf:scanline_align attributes.
+    ImageBuf src(input_filename[0].string());
+    src.read(0, 0, true, TypeFloat);
+    auto iterfunc = [&]() {
+        for (int i = 0; i < iters; ++i)
+            func(src);
+    };
+    double t    = time_trial(iterfunc, ntrials);
+    double rate = double(src.spec().image_pixels()) / (t / iters);
+    print("  {}: {} = {:5.1f} Mpel/s\n", explanation,
+          Strutil::timeintervalformat(t / iters, 3), rate / 1.0e6);
+}
+
+
+
+// Count the pixels of an (autotiled) ImageCache image with channel 0 above
+// zero, with parallel_image either splitting into bands of scanlines or
+// splitting on the cache's tile grid, and report the time the cache spent
+// finding tiles and waiting on tile locks, which is where threads that
+// share tiles contend.
+static void
+test_ic_split(const std::string& explanation, bool tilesplit, int iters = 4)
+{
+    imagecache->attribute("autotile", autotile_size);
+    imagecache->attribute("autoscanline", 0);
+    imagecache->invalidate_all(true);
+    ImageBuf src(input_filename[0].string(), 0, 0, imagecache);
+    std::atomic<imagesize_t> nonzero(0);
+    auto count = [&](ROI roi) {
+        imagesize_t n = 0;
+        for (ImageBuf::ConstIterator<float> p(src, roi); !p.done(); ++p)
+            n += p[0] > 0.0f;
+        nonzero += n;
+    };
+    auto iterfunc = [&]() {
+        for (int i = 0; i < iters; ++i) {
+            if (tilesplit)
+                ImageBufAlgo::parallel_image(src.roi(), numthreads, &src,
+                                             count);
+            else
+                ImageBufAlgo::parallel_image(src.roi(), numthreads, count);
+        }
+    };
+    iterfunc();  // read all the tiles first, so we time only the lookups
+
+    auto stats = [&](float& findtime, float& locktime, long long& misses) {
+        imagecache->getattribute("stat:find_tile_time", TypeFloat, &findtime);
+        imagecache->getattribute("stat:tile_locking_time", TypeFloat,
+                                 &locktime);
+        imagecache->getattribute("stat:find_tile_microcache_misses",
+                                 TypeInt64, &misses);
+    };
+    float find0 = 0.0f, lock0 = 0.0f, find1 = 0.0f, lock1 = 0.0f;
+    long long misses0 = 0, misses1 = 0;
+    stats(find0, lock0, misses0);
+    double t = time_trial(iterfunc, ntrials);
+    stats(find1, lock1, misses1);
+    double rate = double(src.spec().image_pixels()) / (t / iters);
+    print("  {}: {} = {:5.1f} Mpel/s\n", explanation,
+          Strutil::timeintervalformat(t / iters, 3), rate / 1.0e6);
+    print("      find_tile {:.3f}s, tile locking {:.3f}s, "
+          "microcache misses {}\n",
+          find1 - find0, lock1 - lock0, misses1 - misses0);
+    imagecache->attribute("autotile", 0);
+    imagecache->invalidate_all(true);
+}
+
+
+
+// Time convert_image between two pixel data types, over a buffer the size
+// of the first input image, as every ImageInput read with a requested
+// format other than native does.
+static void
+test_convert(TypeDesc from, TypeDesc to, int iters = 8)
+{
+    const ImageSpec& spec(bufspec);
+    imagesize_t nvals = spec.image_pixels() * spec.nchannels;
+    std::vector<char> src(nvals * from.size()), dst(nvals * to.size());
+    // Fill with a ramp so half/float sources are not all zero
+    std::vector<float> ramp(nvals);
+    for (imagesize_t i = 0; i < nvals; ++i)
+        ramp[i] = float(i % 1024) / 1023.0f;
+    convert_pixel_values(TypeFloat, ramp.data(), from, src.data(), int(nvals));
+    auto iterfunc = [&]() {
+        for (int i = 0; i < iters; ++i)
+            convert_image(spec.nchannels, spec.width, spec.height, spec.depth,
+                          src.data(), from, AutoStride, AutoStride,
+                          AutoStride, dst.data(), to, AutoStride, AutoStride,
+                          AutoStride);
+    };
+    double t    = time_trial(iterfunc, ntrials);
+    double rate = double(nvals) / (t / iters);
+    print("  {:>6} -> {:<6}: {} = {:6.1f} Mvals/s\n", from.c_str(),
+          to.c_str(), Strutil::timeintervalformat(t / iters, 3),
+          rate / 1.0e6);
+}
+
+
+
+// Time an unpremult followed by a premult, in place, of an RGBA buffer of
+// the given type the size of the first input image, both through the
+// ImageBufAlgo functions and the OIIO::premult() used by readers.
+static void
+test_premult(TypeDesc format, int iters = 8)
+{
+    ImageSpec spec(bufspec.width, bufspec.height, 4, format);
+    spec.alpha_channel = 3;
+    imagesize_t nvals  = spec.image_pixels() * 4;
+    // Fill with a ramp, which also makes some alphas 0 and some 1
+    std::vector<float> ramp(nvals);
+    for (imagesize_t i = 0; i < nvals; ++i)
+        ramp[i] = float(i % 1024) / 1023.0f;
+    std::vector<char> pixels(nvals * format.size());
+    convert_pixel_values(TypeFloat, ramp.data(), format, pixels.data(),
+                         int(nvals));
+    ImageBuf buf(spec, pixels.data());
+    auto ibafunc = [&]() {
+        for (int i = 0; i < iters; ++i) {
+            ImageBufAlgo::unpremult(buf, buf, {}, numthreads);
+            ImageBufAlgo::premult(buf, buf, {}, numthreads);
+        }
+    };
+    auto rawfunc = [&]() {
+        for (int i = 0; i < iters; ++i)
+            premult(4, spec.width, spec.height, 1, 0, 4, format,
+                    pixels.data(), AutoStride, AutoStride, AutoStride, 3);
+    };
+    double t    = time_trial(ibafunc, ntrials);
+    double rate = double(spec.image_pixels()) / (t / iters);
+    print("  {:>6} IBA unpremult+premult: {} = {:6.1f} Mpel/s\n",
+          format.c_str(), Strutil::timeintervalformat(t / iters, 3),
+          rate / 1.0e6);
+    t    = time_trial(rawfunc, ntrials);
+    rate = double(spec.image_pixels()) / (t / iters);
+    print("  {:>6} OIIO::premult        : {} = {:6.1f} Mpel/s\n",
+          format.c_str(), Strutil::timeintervalformat(t / iters, 3),
+          rate / 1.0e6);
+}
+
+
+
+// Time func with a Benchmarker, so that the result is also recorded under
+// name by --json (or OIIO_BENCHMARK_JSON), and print the rate at which it
+// gets through `work` units.
+static double
+bench(string_view name, const std::function<void()>& func, double work,
+      string_view units)
+{
+    Benchmarker bm;
+    bm.iterations(1).trials(std::max(ntrials, 3)).verbose(0);
+    bm.exclude_outliers(ntrials >= 5 ? 1 : 0);
+    bm.work(size_t(work));
+    double t = bm(name, func);
+    print("  {:<44}: {} = {:7.2f} M{}/s\n", name,
+          Strutil::timeintervalformat(t, 3), work / t / 1.0e6, units);
+    return t;
+}
+
+
+
+// Run task(begin, end) over [0, n), split evenly across nthreads threads of
+// our own, rather than the thread pool, so that the count is exact.
+static void
+run_threads(int nthreads, int64_t n,
+            const std::function<void(int64_t, int64_t)>& task)
+{
+    if (nthreads <= 1) {
+        task(0, n);
+        return;
+    }
+    thread_group threads;
+    for (int i = 0; i < nthreads; ++i)
+        threads.create_thread(task, n * i / nthreads, n * (i + 1) / nthreads);
+    threads.join_all();
+}
+
+
+
+// Get random tiles from the ImageCache with nthreads threads at once. The
+// tiles come from a "null" image, so there is no disk I/O or decoding,
+// sized so that all its tiles total --workingset MB. With a working set
+// larger than the cache (--cache), this measures eviction and re-reading
+// as well as finding tiles and contending for their locks.
+static void
+test_ic_random(int nthreads, int lookups = 1 << 20)
+{
+    const int tilesize    = 64;
+    imagesize_t tilebytes = tilesize * tilesize * 4 * sizeof(float);
+    int ntiles = std::max(1, int(working_set * 1024 * 1024 / tilebytes));
+    int tilesx = std::max(1, int(std::sqrt(double(ntiles))));
+    int tilesy = std::max(1, ntiles / tilesx);
+    ustring name(Strutil::fmt::format(
+        "icrandom.null?RES={}x{}&TILE={}x{}&CHANNELS=4&TYPE=float",
+        tilesx * tilesize, tilesy * tilesize, tilesize, tilesize));
+    auto task = [&](int64_t begin, int64_t end) {
+        auto perthread = imagecache->get_perthread_info();
+        auto handle    = imagecache->get_image_handle(name, perthread);
+        std::minstd_rand rng(uint32_t(begin + 1));
+        for (int64_t i = begin; i < end; ++i) {
+            int x = int(rng() % tilesx) * tilesize;
+            int y = int(rng() % tilesy) * tilesize;
+            auto tile = imagecache->get_tile(handle, perthread, 0, 0, x, y,
+                                             0);
+            if (tile)
+                imagecache->release_tile(tile);
+        }
+    };
+    imagecache->invalidate_all(true);
+    imagecache->attribute("autotile", 0);
+    run_threads(nthreads, lookups, task);  // warm the cache
+    bench(Strutil::fmt::format("random tiles, {} threads", nthreads),
+          [&]() { run_threads(nthreads, lookups, task); }, lookups, "tiles");
+}
+
+
+
+// Texture lookups at random points of a MIP-mapped "null" texture, both
+// one point per call and Tex::BatchWidth points per call, with nthreads
+// threads at once.
+static void
+test_texture(int nthreads, int npoints = 1 << 20)
+{
+    ustring name("texture.null?RES=4096x4096&TILE=64x64&CHANNELS=4"
+                 "&TYPE=float&MIP=1");
+    TextureSystem* texsys = TextureSystem::create(false, imagecache);
+    std::vector<float> s(npoints), t(npoints);
+    std::minstd_rand rng(1);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    for (int i = 0; i < npoints; ++i) {
+        s[i] = uniform(rng);
+        t[i] = uniform(rng);
+    }
+    // A filter footprint of a few texels on the top level
+    const float d = 4.0f / 4096.0f;
+    TextureOpt opt;
+    auto scalar = [&](int64_t begin, int64_t end) {
+        auto perthread = texsys->get_perthread_info();
+        auto handle    = texsys->get_texture_handle(name, perthread);
+        TextureOpt options(opt);
+        float result[4];
+        for (int64_t i = begin; i < end; ++i)
+            texsys->texture(handle, perthread, options, s[i], t[i], d, 0.0f,
+                            0.0f, d, 4, result);
+    };
+    auto batched = [&](int64_t begin, int64_t end) {
+        auto perthread = texsys->get_perthread_info();
+        auto handle    = texsys->get_texture_handle(name, perthread);
+        TextureOptBatch options;
+        alignas(Tex::BatchAlign) float dx[Tex::BatchWidth];
+        alignas(Tex::BatchAlign) float zero[Tex::BatchWidth];
+        alignas(Tex::BatchAlign) float result[4 * Tex::BatchWidth];
+        std::fill_n(dx, Tex::BatchWidth, d);
+        std::fill_n(zero, Tex::BatchWidth, 0.0f);
+        // Whole batches only, so the ranges of the threads don't overlap
+        begin -= begin % Tex::BatchWidth;
+        end -= end % Tex::BatchWidth;
+        for (int64_t i = begin; i < end; i += Tex::BatchWidth)
+            texsys->texture(handle, perthread, options, Tex::RunMaskOn,
+                            &s[i], &t[i], dx, zero, zero, dx, 4, result);
+    };
+    scalar(0, npoints);  // warm the cache
+    bench(Strutil::fmt::format("texture(), {} threads", nthreads),
+          [&]() { run_threads(nthreads, npoints, scalar); }, npoints,
+          "lookups");
+    bench(Strutil::fmt::format("batched texture(), {} threads", nthreads),
+          [&]() { run_threads(nthreads, npoints, batched); }, npoints,
+          "lookups");
+    TextureSystem::destroy(texsys);
+}
+
+
+
+// Encode the first input image in memory with the writer for each format
+// named (by extension) in --codecs, then decode it again, and report the
+// rates in pixels of the image.
+static void
+test_codecs()
+{
+    ImageBuf src(input_filename[0].string());
+    src.read(0, 0, true);
+    const ImageSpec& spec(src.spec());
+    double pixels = double(spec.image_pixels());
+    std::vector<char> decoded(spec.image_pixels() * spec.nchannels
+                              * sizeof(double));
+    for (auto ext : Strutil::splitsv(codecs, ",")) {
+        std::string filename = Strutil::fmt::format("imagespeed.{}", ext);
+        std::vector<unsigned char> file;
+        auto encode = [&]() {
+            file.clear();
+            Filesystem::IOVecOutput vecout(file);
+            auto out = ImageOutput::create(filename, &vecout);
+            if (out && out->open(filename, spec)) {
+                out->write_image(spec.format, src.localpixels());
+                out->close();
+            }
+        };
+        auto decode = [&]() {
+            Filesystem::IOMemReader memreader(file.data(), file.size());
+            auto in = ImageInput::open(filename, nullptr, &memreader);
+            if (in)
+                in->read_image(0, 0, 0, spec.nchannels, TypeUnknown,
+                               decoded.data());
+        };
+        auto out = ImageOutput::create(filename);
+        if (!out || !out->supports("ioproxy")) {
+            print("  {:<44}: skipped, no in-memory writer\n", ext);
+            continue;
+        }
+        encode();
+        if (file.empty()) {
+            print("  {:<44}: skipped, could not write it\n", ext);
+            continue;
+        }
+        bench(Strutil::fmt::format("encode {} ({:.1f} MB)", ext,
+                                   file.size() / 1048576.0),
+              encode, pixels, "pel");
+        bench(Strutil::fmt::format("decode {}", ext), decode, pixels, "pel");
+    }
+}
+
+
+
+// The thread counts to try: the --threads count (or all the cores), or
+// with --scaling, powers of two up to the number of cores and then that.
+static std::vector<int>
+thread_counts()
+{
+    int cores = int(Sysutil::hardware_concurrency());
+    if (!scaling)
+        return { numthreads > 0 ? numthreads : cores };
+    std::vector<int> counts;
+    for (int n = 1; n < cores; n *= 2)
+        counts.push_back(n);
+    counts.push_back(cores);
+    return counts;
+}
+
+
+
 static void
 set_dataformat(const std::string& output_format, ImageSpec& outspec)
 {
@@ -480,9 +868,15 @@ main(int argc, char** argv)
         std::cout << "Error: Must supply a filename.\n";
         return -1;
     }
+    if (json_filename.size())
+        Benchmarker::json_output(json_filename);
 
     OIIO::attribute("threads", numthreads);
     OIIO::attribute("exr_threads", numthreads);
+    if (hugepages)
+        OIIO::attribute("imagebuf:hugepages", 1);
+    if (scanline_align)
+        OIIO::attribute("imagebuf:scanline_align", scanline_align);
     conversion.fromstring(conversionname);
 
     imagecache = ImageCache::create();
@@ -608,6 +1002,111 @@ main(int argc, char** argv)
         test_pixel_iteration("Iterate over a cache image (incr slave) ",
                              time_iterate_pixels_slave_incr, false, iters);
     }
+
+    if (!no_iba) {
+        std::cout << "Timing ImageBufAlgo operations on a loaded image";
+        if (hugepages || scanline_align)
+            print(" (hugepages {}, scanline_align {})", int(hugepages),
+                  scanline_align);
+        std::cout << ":\n";
+        test_iba("resize to half resolution              ",
+                 [](const ImageBuf& src) {
+                     ROI roi      = src.roi();
+                     roi.xend     = roi.xbegin + std::max(1, roi.width() / 2);
+                     roi.yend     = roi.ybegin + std::max(1, roi.height() / 2);
+                     ImageBuf dst = ImageBufAlgo::resize(src, {}, roi);
+                 });
+        ImageBuf kernel = ImageBufAlgo::make_kernel("gaussian", 5.0f, 5.0f);
+        test_iba("convolve with 5x5 gaussian             ",
+                 [&](const ImageBuf& src) {
+                     ImageBuf dst = ImageBufAlgo::convolve(src, kernel);
+                 });
+        test_iba("colorconvert linear to sRGB            ",
+                 [](const ImageBuf& src) {
+                     ImageBuf dst = ImageBufAlgo::colorconvert(src, "linear",
+                                                               "sRGB");
+                 });
+        std::cout << std::endl;
+
+        if (scaling) {
+            ImageBuf src(input_filename[0].string());
+            src.read(0, 0, true, TypeFloat);
+            ROI half  = src.roi();
+            half.xend = half.xbegin + std::max(1, half.width() / 2);
+            half.yend = half.ybegin + std::max(1, half.height() / 2);
+            print("Timing ImageBufAlgo thread scaling:\n");
+            for (int n : thread_counts()) {
+                double pixels = double(src.spec().image_pixels());
+                bench(Strutil::fmt::format("resize, {} threads", n),
+                      [&]() { ImageBufAlgo::resize(src, {}, half, n); },
+                      pixels, "pel");
+                bench(Strutil::fmt::format("convolve, {} threads", n),
+                      [&]() { ImageBufAlgo::convolve(src, kernel, true, {},
+                                                     n); },
+                      pixels, "pel");
+                bench(Strutil::fmt::format("colorconvert, {} threads", n),
+                      [&]() {
+                          ImageBufAlgo::colorconvert(src, "linear", "sRGB",
+                                                     true, "", "", nullptr,
+                                                     {}, n);
+                      },
+                      pixels, "pel");
+            }
+            std::cout << std::endl;
+        }
+
+        print("Timing parallel_image over a cached image ({}x{} tiles):\n",
+              autotile_size, autotile_size);
+        test_ic_split("split into bands of scanlines         ", false);
+        test_ic_split("split on the cache's tile grid        ", true);
+        std::cout << std::endl;
+    }
+    if (!no_convert) {
+        print("Timing pixel data type conversions ({}):\n",
+              OIIO::get_string_attribute("oiio:simd"));
+        imagecache->get_imagespec(input_filename[0], bufspec, 0, 0, true);
+        const TypeDesc pairs[][2] = {
+            { TypeHalf, TypeFloat },  { TypeFloat, TypeHalf },
+            { TypeUInt8, TypeFloat }, { TypeFloat, TypeUInt8 },
+            { TypeUInt16, TypeFloat }, { TypeFloat, TypeUInt16 },
+            { TypeUInt8, TypeHalf },  { TypeHalf, TypeUInt8 },
+            { TypeUInt16, TypeHalf }, { TypeHalf, TypeUInt16 },
+        };
+        for (auto& p : pairs)
+            test_convert(p[0], p[1]);
+        std::cout << std::endl;
+    }
+    if (!no_premult) {
+        print("Timing alpha premultiplication ({}):\n",
+              OIIO::get_string_attribute("oiio:simd"));
+        imagecache->get_imagespec(input_filename[0], bufspec, 0, 0, true);
+        for (TypeDesc t : { TypeFloat, TypeHalf, TypeUInt8, TypeUInt16 })
+            test_premult(t);
+        std::cout << std::endl;
+    }
+    if (!no_icrandom) {
+        float cache_MB = 0.0f;
+        imagecache->getattribute("max_memory_MB", cache_MB);
+        print("Timing random ImageCache tile access (working set {} MB, "
+              "cache {} MB):\n",
+              working_set, cache_MB);
+        for (int n : thread_counts())
+            test_ic_random(n);
+        std::cout << std::endl;
+    }
+    if (!no_texture) {
+        print("Timing TextureSystem lookups (batch width {}):\n",
+              Tex::BatchWidth);
+        for (int n : thread_counts())
+            test_texture(n);
+        std::cout << std::endl;
+    }
+    if (!no_codecs) {
+        print("Timing in-memory encode and decode of {}:\n",
+              input_filename[0]);
+        test_codecs();
+        std::cout << std::endl;
+    }
     if (verbose)
         std::cout << "\n" << imagecache->getstats(2) << "\n";
 
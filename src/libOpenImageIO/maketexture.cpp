@@ -4,12 +4,15 @@
 
 #include <cmath>
 #include <cstdio>
+#include <condition_variable>
 #include <cstdlib>
 #include <iostream>
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 #include <OpenImageIO/Imath.h>
 #include <OpenImageIO/argparse.h>
@@ -18,9 +21,11 @@
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/filter.h>
 #include <OpenImageIO/fmath.h>
+#include <OpenImageIO/hash.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
@@ -32,9 +37,6 @@
 using namespace OIIO;
 
 
-static spin_mutex maketx_mutex;  // for anything that needs locking
-
-
 
 static Filter2D*
 setup_filter(const ImageSpec& dstspec, const ImageSpec& srcspec,
@@ -248,12 +250,126 @@ halve_scanline(const SRCTYPE* s, const int nchannels, size_t sw, float* dst)
 
 
 
+// Average 2x2 blocks of integer pixels from rows s0 and s1 directly in
+// their native type, rounding to nearest. The loops are over a fixed
+// channel count and have no conversions, so the compiler vectorizes them.
+template<class T, int NC>
+static void
+halve_rows_int(const T* s0, const T* s1, T* d, size_t dw)
+{
+    for (size_t x = 0; x < dw; ++x, s0 += 2 * NC, s1 += 2 * NC, d += NC)
+        for (int c = 0; c < NC; ++c)
+            d[c] = T((uint32_t(s0[c]) + s0[c + NC] + s1[c] + s1[c + NC] + 2)
+                     >> 2);
+}
+
+
+
+template<class T>
+static void
+halve_rows_int(const T* s0, const T* s1, T* d, size_t dw, int nchannels)
+{
+    switch (nchannels) {
+    case 1: halve_rows_int<T, 1>(s0, s1, d, dw); return;
+    case 2: halve_rows_int<T, 2>(s0, s1, d, dw); return;
+    case 3: halve_rows_int<T, 3>(s0, s1, d, dw); return;
+    case 4: halve_rows_int<T, 4>(s0, s1, d, dw); return;
+    }
+    const size_t n = size_t(nchannels);
+    for (size_t x = 0; x < dw; ++x, s0 += 2 * n, s1 += 2 * n, d += n)
+        for (size_t c = 0; c < n; ++c)
+            d[c] = T((uint32_t(s0[c]) + s0[c + n] + s1[c] + s1[c + n] + 2)
+                     >> 2);
+}
+
+
+
+// Tables for averaging sRGB-encoded uint8 values in linear space.
+struct SRGB8Tables {
+    enum { LinearBits = 14 };
+    float tolinear[256];
+    unsigned char fromlinear[(1 << LinearBits) + 1];
+    SRGB8Tables()
+    {
+        for (int i = 0; i < 256; ++i)
+            tolinear[i] = sRGB_to_linear(i / 255.0f);
+        for (int i = 0; i <= (1 << LinearBits); ++i)
+            fromlinear[i] = (unsigned char)(
+                linear_to_sRGB(float(i) / (1 << LinearBits)) * 255.0f + 0.5f);
+    }
+    static const SRGB8Tables& get()
+    {
+        static const SRGB8Tables tables;
+        return tables;
+    }
+};
+
+
+
+// Average 2x2 blocks of sRGB-encoded uint8 pixels in linear space (except
+// for the alpha channel, which is averaged as is).
+static void
+halve_rows_srgb8(const unsigned char* s0, const unsigned char* s1,
+                 unsigned char* d, size_t dw, int nchannels, int alpha)
+{
+    const SRGB8Tables& t(SRGB8Tables::get());
+    const float scale = 0.25f * (1 << SRGB8Tables::LinearBits);
+    const size_t n    = size_t(nchannels);
+    for (size_t x = 0; x < dw; ++x, s0 += 2 * n, s1 += 2 * n, d += n) {
+        for (size_t c = 0; c < n; ++c) {
+            if (int(c) == alpha) {
+                d[c] = (unsigned char)((uint32_t(s0[c]) + s0[c + n] + s1[c]
+                                        + s1[c + n] + 2)
+                                       >> 2);
+            } else {
+                float sum = t.tolinear[s0[c]] + t.tolinear[s0[c + n]]
+                            + t.tolinear[s1[c]] + t.tolinear[s1[c + n]];
+                d[c]      = t.fromlinear[int(sum * scale + 0.5f)];
+            }
+        }
+    }
+}
+
+
+
+// Overloads to select a native-type kernel for a halving row pair. Return
+// false if there is none for the type, and the caller should go through
+// float.
+template<class T>
+inline bool
+halve_rows(const T*, const T*, T*, size_t, int, int, bool)
+{
+    return false;
+}
+
+inline bool
+halve_rows(const unsigned char* s0, const unsigned char* s1, unsigned char* d,
+           size_t dw, int nchannels, int alpha, bool srgb_average)
+{
+    if (srgb_average)
+        halve_rows_srgb8(s0, s1, d, dw, nchannels, alpha);
+    else
+        halve_rows_int(s0, s1, d, dw, nchannels);
+    return true;
+}
+
+inline bool
+halve_rows(const unsigned short* s0, const unsigned short* s1,
+           unsigned short* d, size_t dw, int nchannels, int /*alpha*/,
+           bool /*srgb_average*/)
+{
+    halve_rows_int(s0, s1, d, dw, nchannels);
+    return true;
+}
+
+
+
 // Bilinear resize performed as a 2-pass filter.
 // Optimized to assume that the images are contiguous.
 template<class SRCTYPE>
 static bool
 resize_block_2pass(ImageBuf& dst, const ImageBuf& src, ROI roi,
-                   bool allow_shift)
+                   bool allow_shift, bool srgb_average)
 {
     // Two-pass filtering introduces a half-pixel shift for odd resolutions.
     // Revert to correct bilerp sampling unless shift is explicitly allowed.
@@ -268,24 +384,25 @@ resize_block_2pass(ImageBuf& dst, const ImageBuf& src, ROI roi,
     std::unique_ptr<float[]> S0(new float[row_elem]);
     std::unique_ptr<float[]> S1(new float[row_elem]);
 
-    // We know that the buffers created for mipmapping are all contiguous,
+    // We know that the buffers created for mipmapping have packed pixels,
     // so we can skip the iterators for a bilerp resize entirely along with
     // any NDC -> pixel math, and just directly traverse pixels.
-    const SRCTYPE* s = (const SRCTYPE*)src.localpixels();
-    SRCTYPE* d       = (SRCTYPE*)dst.localpixels();
-    OIIO_DASSERT(s && d);                                 // Assume contig bufs
-    d += roi.ybegin * dst.spec().width * nchannels;       // Top of dst ROI
-    const size_t ystride = src.spec().width * nchannels;  // Scanline offset
-    s += 2 * roi.ybegin * ystride;                        // Top of src ROI
 
     // Run through destination rows, doing the two-pass bilerp filter
     const size_t dw = roi.width(), dh = roi.height();  // Loop invariants
     const size_t sw = dw * 2;                          // Handle odd res
     for (size_t y = 0; y < dh; ++y) {                  // For each dst ROI row
+        int dy           = roi.ybegin + int(y);
+        const SRCTYPE* s = (const SRCTYPE*)src.pixeladdr(0, 2 * dy);
+        SRCTYPE* d       = (SRCTYPE*)dst.pixeladdr(0, dy);
+        OIIO_DASSERT(s && d);
+        // 8 and 16 bit integer images are averaged without converting
+        if (halve_rows(s, (const SRCTYPE*)src.pixeladdr(0, 2 * dy + 1), d, dw,
+                       nchannels, src.spec().alpha_channel, srgb_average))
+            continue;
         halve_scanline<SRCTYPE>(s, nchannels, sw, &S0[0]);
-        s += ystride;
+        s = (const SRCTYPE*)src.pixeladdr(0, 2 * dy + 1);
         halve_scanline<SRCTYPE>(s, nchannels, sw, &S1[0]);
-        s += ystride;
         const float *s0 = &S0[0], *s1 = &S1[0];
         for (size_t x = 0; x < dw; ++x) {  // For each dst ROI col
             for (int i = 0; i < nchannels; ++i, ++s0, ++s1, ++d)
@@ -298,9 +415,12 @@ resize_block_2pass(ImageBuf& dst, const ImageBuf& src, ROI roi,
 
 
 
+// Resize src into dst for the region roi. If srgb_average is true, and
+// both are uint8, 2x downsizing averages the color channels in linear
+// space rather than in their sRGB encoding.
 static bool
 resize_block(ImageBuf& dst, const ImageBuf& src, ROI roi, bool envlatlmode,
-             bool allow_shift)
+             bool allow_shift, bool srgb_average = false)
 {
     const ImageSpec& srcspec(src.spec());
     const ImageSpec& dstspec(dst.spec());
@@ -313,12 +433,15 @@ resize_block(ImageBuf& dst, const ImageBuf& src, ROI roi, bool envlatlmode,
         dstspec.width == roi.width() &&          // Full width ROI
         dstspec.width == (srcspec.width / 2) &&  // Src is 2x resize
         dstspec.format == srcspec.format &&      // Same formats
+        src.pixel_stride() == stride_t(srcspec.pixel_bytes()) &&  // Packed
+        dst.pixel_stride() == stride_t(dstspec.pixel_bytes()) &&
         dstspec.x == 0 && dstspec.y == 0 &&      // Not a crop or overscan
         srcspec.x == 0 && srcspec.y == 0) {
         // If all these conditions are met, we have a special case that
         // can be more highly optimized.
         OIIO_DISPATCH_TYPES(ok, "resize_block_2pass", resize_block_2pass,
-                            srcspec.format, dst, src, roi, allow_shift);
+                            srcspec.format, dst, src, roi, allow_shift,
+                            srgb_average);
     } else {
         OIIO_ASSERT(dst.spec().format == TypeFloat);
         OIIO_DISPATCH_TYPES(ok, "resize_block", resize_block_, srcspec.format,
@@ -329,46 +452,6 @@ resize_block(ImageBuf& dst, const ImageBuf& src, ROI roi, bool envlatlmode,
 
 
 
-// Copy src into dst, but only for the range [x0,x1) x [y0,y1).
-static void
-check_nan_block(const ImageBuf& src, ROI roi, int& found_nonfinite)
-{
-    int x0 = roi.xbegin, x1 = roi.xend, y0 = roi.ybegin, y1 = roi.yend;
-    const ImageSpec& spec(src.spec());
-    float* pel = OIIO_ALLOCA(float, spec.nchannels);
-    for (int y = y0; y < y1; ++y) {
-        for (int x = x0; x < x1; ++x) {
-            src.getpixel(x, y, pel);
-            for (int c = 0; c < spec.nchannels; ++c) {
-                if (!isfinite(pel[c])) {
-                    spin_lock lock(maketx_mutex);
-                    // if (found_nonfinite < 3)
-                    //     std::cerr << "maketx ERROR: Found " << pel[c]
-                    //               << " at (x=" << x << ", y=" << y << ")\n";
-                    ++found_nonfinite;
-                    break;  // skip other channels, there's no point
-                }
-            }
-        }
-    }
-}
-
-
-
-inline Imath::V3f
-latlong_to_dir(float s, float t, bool y_is_up = true)
-{
-    float theta = 2.0f * M_PI * s;
-    float phi   = t * M_PI;
-    float sinphi, cosphi;
-    sincos(phi, &sinphi, &cosphi);
-    if (y_is_up)
-        return Imath::V3f(sinphi * sinf(theta), cosphi, -sinphi * cosf(theta));
-    else
-        return Imath::V3f(-sinphi * cosf(theta), -sinphi * sinf(theta), cosphi);
-}
-
-
 
 template<class SRCTYPE>
 static bool
@@ -381,17 +464,34 @@ lightprobe_to_envlatl(ImageBuf& dst, const ImageBuf& src, bool y_is_up,
     roi.chend = std::min(roi.chend, dst.nchannels());
     OIIO_ASSERT(dst.spec().format == TypeDesc::FLOAT);
 
+    // The direction of each latlong pixel is factored into a table of the
+    // longitude (theta) terms of each column, and the latitude (phi) terms
+    // computed once per row.
+    const ImageSpec& dstspec(dst.spec());
+    float dw = dstspec.width, dh = dstspec.height;
+    std::vector<float> sintheta(dstspec.width), costheta(dstspec.width);
+    for (int x = 0; x < dstspec.width; ++x)
+        sincos(float(2.0f * M_PI * ((x + dstspec.x + 0.5f) / dw)),
+               &sintheta[x], &costheta[x]);
+
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        const ImageSpec& dstspec(dst.spec());
         int nchannels = dstspec.nchannels;
-
-        float* pixel = OIIO_ALLOCA(float, nchannels);
-        float dw = dstspec.width, dh = dstspec.height;
+        float* pixel  = OIIO_ALLOCA(float, nchannels);
+        int y         = roi.ybegin - 1;
+        float sinphi = 0.0f, cosphi = 0.0f;
         for (ImageBuf::Iterator<float> d(dst, roi); !d.done(); ++d) {
-            Imath::V3f V = latlong_to_dir((d.x() + 0.5f) / dw,
-                                          (dh - 1.0f - d.y() + 0.5f) / dh,
-                                          y_is_up);
-            float r      = M_1_PI * acosf(V[2]) / hypotf(V[0], V[1]);
+            if (d.y() != y) {
+                y = d.y();
+                sincos(float(M_PI * ((dh - 1.0f - y + 0.5f) / dh)), &sinphi,
+                       &cosphi);
+            }
+            int x = d.x() - dstspec.x;
+            Imath::V3f V
+                = y_is_up ? Imath::V3f(sinphi * sintheta[x], cosphi,
+                                       -sinphi * costheta[x])
+                          : Imath::V3f(-sinphi * costheta[x],
+                                       -sinphi * sintheta[x], cosphi);
+            float r = M_1_PI * acosf(V[2]) / hypotf(V[0], V[1]);
             float u      = (V[0] * r + 1.0f) * 0.5f;
             float v      = (V[1] * r + 1.0f) * 0.5f;
             interppixel_NDC_clamped<SRCTYPE>(src, float(u), float(v), pixel,
@@ -406,68 +506,125 @@ lightprobe_to_envlatl(ImageBuf& dst, const ImageBuf& src, bool y_is_up,
 
 
 
-// compute slopes in pixel space using a Sobel gradient filter
-template<class SRCTYPE>
+// Fetch channel 0 of source rows ybegin-1 .. yend (inclusive), each for x
+// in [xbegin-1, xend+1), into rows (a row after another). Coordinates
+// outside the data window are treated as an iterator with WrapClamp would:
+// clamped to the display window, and zero if that is still outside the
+// data window.
 static void
-sobel_gradient(const ImageBuf& src, const ImageBuf::Iterator<float>& dstpix,
-               float* h, float* dh_ds, float* dh_dt)
+get_clamped_rows(const ImageBuf& src, int xbegin, int xend, int ybegin,
+                 int yend, std::vector<float>& rows)
 {
-    static const float sobelweight_ds[9] = { -1.0f, 0.0f,  1.0f, -2.0f, 0.0f,
-                                             2.0f,  -1.0f, 0.0f, 1.0f };
-    static const float sobelweight_dt[9] = { -1.0f, -2.0f, -1.0f, 0.0f, 0.0f,
-                                             0.0f,  1.0f,  2.0f,  1.0f };
-
-    *dh_ds = *dh_dt = 0.0f;
-
-    ImageBuf::ConstIterator<SRCTYPE> srcpix(src, dstpix.x() - 1, dstpix.x() + 2,
-                                            dstpix.y() - 1, dstpix.y() + 2, 0,
-                                            1, ImageBuf::WrapClamp);
-    for (int i = 0; !srcpix.done(); ++srcpix, ++i) {
-        // accumulate to dh_ds and dh_dt using corresponding sobel 3x3 weights
-        float srcval = srcpix[0];
-        *dh_ds += sobelweight_ds[i] * srcval;
-        *dh_dt += sobelweight_dt[i] * srcval;
-        if (i == 4)
-            *h = srcval;
-    }
-
-    *dh_ds = *dh_ds / 8.0f;  // sobel normalization
-    *dh_dt = *dh_dt / 8.0f;
+    const ImageSpec& spec(src.spec());
+    const int w = xend - xbegin + 2;
+    rows.resize(size_t(w) * (yend - ybegin + 2));
+    std::vector<float> line(spec.width);
+    for (int j = 0; j < yend - ybegin + 2; ++j) {
+        float* r = &rows[size_t(j) * w];
+        int y    = clamp(ybegin - 1 + j, spec.full_y,
+                         spec.full_y + spec.full_height - 1);
+        if (y < spec.y || y >= spec.y + spec.height) {
+            std::fill(r, r + w, 0.0f);
+            continue;
+        }
+        src.get_pixels(ROI(spec.x, spec.x + spec.width, y, y + 1, spec.z,
+                           spec.z + 1, 0, 1),
+                       TypeFloat, line.data());
+        for (int i = 0; i < w; ++i) {
+            int x = clamp(xbegin - 1 + i, spec.full_x,
+                          spec.full_x + spec.full_width - 1);
+            r[i]  = (x >= spec.x && x < spec.x + spec.width) ? line[x - spec.x]
+                                                             : 0.0f;
+        }
+    }
 }
 
 
 
-// compute slopes from normal in s,t space
-// Note: because we use getpixel(), it works for all src pixel types.
+// Compute the bump slopes of rows [roi.ybegin, roi.yend) of dst, which
+// has the same data window as src. For a height map (channel 0 of src),
+// the slopes in pixel space come from a 3x3 Sobel filter; for a tangent
+// space normal map, from the normal's x and y over its z. Each band of
+// rows is fetched once as floats and the gradients are evaluated over
+// contiguous row arrays, which the compiler can vectorize.
 static void
-normal_gradient(const ImageBuf& src, const ImageBuf::Iterator<float>& dstpix,
-                float* h, float* dh_ds, float* dh_dt)
+bump_slopes_rows(ImageBuf& dst, const ImageBuf& src, bool from_normal,
+                 float res_x, float res_y, ROI roi)
 {
-    // assume a normal defined in the tangent space
-    float n[3];
-    src.getpixel(dstpix.x(), dstpix.y(), n, 3);
-    *h     = -1.0f;
-    *dh_ds = -n[0] / n[2];
-    *dh_dt = -n[1] / n[2];
+    const int w = roi.width();
+    std::vector<float> h(w), dhds(w), dhdt(w);
+    std::vector<float> rows;
+    if (from_normal)
+        rows.resize(size_t(w) * 3);
+    else
+        get_clamped_rows(src, roi.xbegin, roi.xend, roi.ybegin, roi.yend,
+                         rows);
+    for (int y = roi.ybegin; y < roi.yend; ++y) {
+        if (from_normal) {
+            // assume a normal defined in the tangent space
+            src.get_pixels(ROI(roi.xbegin, roi.xend, y, y + 1, roi.zbegin,
+                               roi.zbegin + 1, 0, 3),
+                           TypeFloat, rows.data());
+            const float* n = rows.data();
+            for (int x = 0; x < w; ++x) {
+                h[x]    = -1.0f;
+                dhds[x] = -n[3 * x + 0] / n[3 * x + 2];
+                dhdt[x] = -n[3 * x + 1] / n[3 * x + 2];
+            }
+        } else {
+            // Sobel weights, summed in the same order as a 3x3 loop would:
+            //   d/ds: -1 0 1 / -2 0 2 / -1 0 1
+            //   d/dt: -1 -2 -1 / 0 0 0 / 1 2 1
+            const size_t stride = size_t(w) + 2;
+            const float* r0     = &rows[(y - roi.ybegin) * stride] + 1;
+            const float* r1     = r0 + stride;
+            const float* r2     = r1 + stride;
+            for (int x = 0; x < w; ++x) {
+                float ds = -r0[x - 1];
+                ds += r0[x + 1];
+                ds += -2.0f * r1[x - 1];
+                ds += 2.0f * r1[x + 1];
+                ds += -r2[x - 1];
+                ds += r2[x + 1];
+                float dt = -r0[x - 1];
+                dt += -2.0f * r0[x];
+                dt += -r0[x + 1];
+                dt += r2[x - 1];
+                dt += 2.0f * r2[x];
+                dt += r2[x + 1];
+                h[x]    = r1[x];
+                dhds[x] = ds / 8.0f;  // sobel normalization
+                dhdt[x] = dt / 8.0f;
+            }
+        }
+        float* d = (float*)dst.pixeladdr(roi.xbegin, y, roi.zbegin);
+        for (int x = 0; x < w; ++x, d += 6) {
+            // h = height or h = -1.0f if a normal map
+            d[0] = h[x];
+            // first moments
+            d[1] = dhds[x] * res_x;
+            d[2] = dhdt[x] * res_y;
+            // second moments
+            d[3] = dhds[x] * dhds[x] * res_x * res_x;
+            d[4] = dhdt[x] * dhdt[x] * res_y * res_y;
+            d[5] = dhds[x] * dhdt[x] * res_x * res_y;
+        }
+    }
 }
 
 
 
-template<class SRCTYPE>
 static bool
 bump_to_bumpslopes(ImageBuf& dst, const ImageBuf& src,
                    const ImageSpec& configspec, std::ostream& outstream,
                    ROI roi = ROI::All(), int nthreads = 0)
 {
     if (!dst.initialized() || dst.nchannels() != 6
-        || dst.spec().format != TypeDesc::FLOAT)
+        || dst.spec().format != TypeDesc::FLOAT || !dst.localpixels())
         return false;
 
     // detect bump input format according to channel count
-    void (*bump_filter)(const ImageBuf&, const ImageBuf::Iterator<float>&,
-                        float*, float*, float*);
-
-    bump_filter = &sobel_gradient<SRCTYPE>;
+    bool from_normal = false;  // default: height value in channel 0
 
     float res_x = 1.0f;
     float res_y = 1.0f;
@@ -476,21 +633,20 @@ bump_to_bumpslopes(ImageBuf& dst, const ImageBuf& src,
         "maketx:bumpformat");
 
     if (Strutil::iequals(bumpformat, "height"))
-        bump_filter = &sobel_gradient<
-            SRCTYPE>;  // default one considering height value in channel 0
+        from_normal = false;
     else if (Strutil::iequals(bumpformat, "normal")) {
         if (src.spec().nchannels < 3) {
             outstream
                 << "maketx ERROR: normal map requires 3 channels input map.\n";
             return false;
         }
-        bump_filter = &normal_gradient;
+        from_normal = true;
     } else if (Strutil::iequals(
                    bumpformat,
                    "auto")) {  // guess input bump format by analyzing channel count and component
         if (src.spec().nchannels > 2
             && !ImageBufAlgo::isMonochrome(src))  // maybe it's a normal map?
-            bump_filter = &normal_gradient;
+            from_normal = true;
     } else {
         outstream << "maketx ERROR: Unknown input bump format " << bumpformat
                   << ". Valid formats are height, normal or auto\n";
@@ -502,7 +658,7 @@ bump_to_bumpslopes(ImageBuf& dst, const ImageBuf& src,
         configspec.get_float_attribute("uvslopes_scale"));
 
     // If the input is an height map, does the derivatives needs to be UV normalized and scaled?
-    if (bump_filter == &sobel_gradient<SRCTYPE> && uv_scale != 0) {
+    if (!from_normal && uv_scale != 0) {
         if (uv_scale < 0) {
             outstream
                 << "maketx ERROR: Invalid uvslopes_scale value. The value must be >=0.\n";
@@ -514,23 +670,10 @@ bump_to_bumpslopes(ImageBuf& dst, const ImageBuf& src,
         res_y = (float)src.spec().height / uv_scale;
     }
 
+    if (!roi.defined())
+        roi = dst.roi();
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        // iterate on destination image
-        for (ImageBuf::Iterator<float> d(dst, roi); !d.done(); ++d) {
-            float h;
-            float dhds;
-            float dhdt;
-            bump_filter(src, d, &h, &dhds, &dhdt);
-            // h = height or h = -1.0f if a normal map
-            d[0] = h;
-            // first moments
-            d[1] = dhds * res_x;
-            d[2] = dhdt * res_y;
-            // second moments
-            d[3] = dhds * dhds * res_x * res_x;
-            d[4] = dhdt * dhdt * res_y * res_y;
-            d[5] = dhds * dhdt * res_x * res_y;
-        }
+        bump_slopes_rows(dst, src, from_normal, res_x, res_y, roi);
     });
     return true;
 }
@@ -538,41 +681,41 @@ bump_to_bumpslopes(ImageBuf& dst, const ImageBuf& src,
 
 
 static void
-fix_latl_edges(ImageBuf& buf)
+fix_latl_edges(ImageBuf& buf, int nthreads = 0)
 {
-    int n        = buf.nchannels();
-    float* left  = OIIO_ALLOCA(float, n);
-    float* right = OIIO_ALLOCA(float, n);
+    int n = buf.nchannels();
 
     // Make the whole first and last row be solid, since they are exactly
-    // on the pole
+    // on the pole. Each row is fetched in one go and summed in order.
     float wscale = 1.0f / (buf.spec().width);
+    std::vector<float> row(size_t(buf.spec().width) * n);
+    std::vector<float> avg(n);
     for (int j = 0; j <= 1; ++j) {
         int y = (j == 0) ? buf.ybegin() : buf.yend() - 1;
-        // use left for the sum, right for each new pixel
-        for (int c = 0; c < n; ++c)
-            left[c] = 0.0f;
-        for (int x = buf.xbegin(); x < buf.xend(); ++x) {
-            buf.getpixel(x, y, right);
+        ROI rowroi(buf.xbegin(), buf.xend(), y, y + 1, buf.zbegin(),
+                   buf.zbegin() + 1, 0, n);
+        buf.get_pixels(rowroi, TypeFloat, row.data());
+        std::fill(avg.begin(), avg.end(), 0.0f);
+        for (size_t i = 0, e = row.size(); i < e; i += n)
             for (int c = 0; c < n; ++c)
-                left[c] += right[c];
-        }
+                avg[c] += row[i + c];
         for (int c = 0; c < n; ++c)
-            left[c] *= wscale;
-        for (int x = buf.xbegin(); x < buf.xend(); ++x)
-            buf.setpixel(x, y, left);
+            avg[c] *= wscale;
+        ImageBufAlgo::fill(buf, avg, rowroi, 1);
     }
 
     // Make the left and right match, since they are both right on the
     // prime meridian.
-    for (int y = buf.ybegin(); y < buf.yend(); ++y) {
+    parallel_for(buf.ybegin(), buf.yend(), [&](int y) {
+        float* left  = OIIO_ALLOCA(float, n);
+        float* right = OIIO_ALLOCA(float, n);
         buf.getpixel(buf.xbegin(), y, left);
         buf.getpixel(buf.xend() - 1, y, right);
         for (int c = 0; c < n; ++c)
             left[c] = 0.5f * left[c] + 0.5f * right[c];
         buf.setpixel(buf.xbegin(), y, left);
         buf.setpixel(buf.xend() - 1, y, left);
-    }
+    }, paropt(nthreads));
 }
 
 
@@ -607,6 +750,196 @@ maketx_merge_spec(ImageSpec& dstspec, const ImageSpec& srcspec)
 
 
 
+// Write img and (if mipmap is true) all of its successively halved MIP
+// levels to out, which has already been opened with outspec for the top
+// level. Rather than holding each whole level in memory, a level is
+// streamed through in bands of two tile rows: each band is read (through
+// the ImageCache, if img is cache-backed), written as output tiles, and
+// box-filtered into one tile row of the next level. A next level that is
+// bigger than local_bytes is spooled to a temporary tiled file next to the
+// output, which is then read back through the ImageCache to produce the
+// level after it. Peak memory is thus bounded to a couple of bands plus
+// the cache, at the cost of temporary disk space for the largest levels.
+static bool
+write_mipmap_streamed(std::shared_ptr<ImageBuf> img, ImageSpec outspec,
+                      const std::string& outputfilename, ImageOutput* out,
+                      TypeDesc outputdatatype, bool mipmap, bool clamp_half,
+                      imagesize_t local_bytes, bool verbose,
+                      std::ostream& outstream, double& stat_writetime,
+                      double& stat_miptime, size_t& peak_mem)
+{
+    using OIIO::pvt::errorfmt;
+    using OIIO::Strutil::sync::print;  // Be sure to use synchronized one
+    std::string imgtmpfile;  // Temp file backing img, if any
+    auto remove_tmp = [](const std::string& filename) {
+        if (filename.size()) {
+            ImageCache::create()->invalidate(ustring(filename));
+            Filesystem::remove(filename);
+        }
+    };
+
+    bool ok = true;
+    for (;;) {
+        const ImageSpec spec = img->spec();
+        const int nc         = spec.nchannels;
+        bool lastlevel       = !mipmap || (spec.width <= 1 && spec.height <= 1);
+        Timer writetimer(Timer::DontStartNow), miptimer(Timer::DontStartNow);
+
+        // Set up the destination of the next level: in memory if it's
+        // small enough, otherwise a temporary file.
+        ImageSpec nextspec;
+        std::shared_ptr<ImageBuf> next;
+        std::unique_ptr<ImageOutput> nextout;
+        std::string nexttmpfile;
+        if (!lastlevel) {
+            nextspec        = outspec;
+            nextspec.width  = std::max(1, spec.width / 2);
+            nextspec.height = std::max(1, spec.height / 2);
+            nextspec.depth  = spec.depth;
+            nextspec.x = nextspec.y = nextspec.full_x = nextspec.full_y = 0;
+            nextspec.full_width  = nextspec.width;
+            nextspec.full_height = nextspec.height;
+            nextspec.full_depth  = nextspec.depth;
+            nextspec.set_format(TypeFloat);
+            if (nextspec.image_bytes() <= local_bytes) {
+                next.reset(new ImageBuf(nextspec));
+            } else {
+                nexttmpfile = Filesystem::unique_path(
+                    Filesystem::replace_extension(outputfilename,
+                                                  ".%%%%%%%%.mip.exr"));
+                ImageSpec tmpspec(nextspec.width, nextspec.height, nc,
+                                  TypeFloat);
+                tmpspec.channelnames = nextspec.channelnames;
+                tmpspec.tile_width   = outspec.tile_width;
+                tmpspec.tile_height  = outspec.tile_height;
+                tmpspec.attribute("compression", "none");
+                nextout = ImageOutput::create("openexr");
+                if (!nextout || !nextout->open(nexttmpfile, tmpspec)) {
+                    errorfmt("Could not open temporary file \"{}\" : {}",
+                             nexttmpfile,
+                             nextout ? nextout->geterror() : geterror());
+                    ok = false;
+                    break;
+                }
+            }
+            // Same trick as in write_mipmap: make the display and pixel
+            // windows of the bigger level match for the sake of the resize.
+            img->set_full(img->xbegin(), img->xend(), img->ybegin(),
+                          img->yend(), img->zbegin(), img->zend());
+        }
+
+        // Stream through the level, two tile rows at a time, so that each
+        // band yields one tile row of the next level.
+        int bandrows = 2 * std::max(outspec.tile_height, 1);
+        std::vector<float> band;
+        for (int yb = spec.y; ok && yb < spec.y + spec.height; yb += bandrows) {
+            int ye = std::min(yb + bandrows, spec.y + spec.height);
+            ROI broi(spec.x, spec.x + spec.width, yb, ye, spec.z,
+                     spec.z + spec.depth, 0, nc);
+            writetimer.start();
+            band.resize(broi.npixels() * nc);
+            ok &= img->get_pixels(broi, TypeFloat, band.data());
+            if (clamp_half)
+                for (auto& v : band)
+                    v = clamp(v, -float(HALF_MAX), float(HALF_MAX));
+            if (ok
+                && !out->write_tiles(broi.xbegin, broi.xend, yb, ye,
+                                     broi.zbegin, broi.zend, TypeFloat,
+                                     band.data())) {
+                errorfmt("Error writing \"{}\" : {}", outputfilename,
+                         out->geterror());
+                ok = false;
+            }
+            writetimer.stop();
+            if (!ok || lastlevel)
+                continue;
+
+            miptimer.start();
+            int nyb = (yb - spec.y) / 2;
+            int nye = (ye == spec.y + spec.height) ? nextspec.height
+                                                   : (ye - spec.y) / 2;
+            ImageSpec bandspec = nextspec;
+            bandspec.y         = nyb;
+            bandspec.height    = nye - nyb;
+            ImageBuf nextband(bandspec);
+            // N.B. no pixel shift allowed: every band must be filtered
+            // the same way, regardless of which resize path it takes.
+            ImageBufAlgo::parallel_image(nextband.roi(),
+                                         std::bind(resize_block,
+                                                   std::ref(nextband),
+                                                   std::cref(*img), _1, false,
+                                                   false, false));
+            miptimer.stop();
+            writetimer.start();
+            if (next) {
+                next->set_pixels(nextband.roi(), TypeFloat,
+                                 nextband.localpixels());
+            } else if (!nextout->write_tiles(0, nextspec.width, nyb, nye, 0,
+                                             nextspec.depth, TypeFloat,
+                                             nextband.localpixels())) {
+                errorfmt("Error writing \"{}\" : {}", nexttmpfile,
+                         nextout->geterror());
+                ok = false;
+            }
+            writetimer.stop();
+        }
+        if (!ok && img->has_error())
+            errorfmt("{}", img->geterror());
+        if (nextout && !nextout->close() && ok) {
+            errorfmt("Error writing \"{}\" : {}", nexttmpfile,
+                     nextout->geterror());
+            ok = false;
+        }
+        nextout.reset();
+
+        stat_writetime += writetimer();
+        stat_miptime += miptimer();
+        if (verbose) {
+            size_t mem = Sysutil::memory_used(true);
+            peak_mem   = std::max(peak_mem, mem);
+            print(outstream, "    {:15s} ({})  streamed, downres {} write {}\n",
+                  formatres(outspec), Strutil::memformat(mem),
+                  Strutil::timeintervalformat(miptimer(), 2),
+                  Strutil::timeintervalformat(writetimer(), 2));
+        }
+
+        // Done with this level and its temp file (if it had one)
+        img.reset();
+        remove_tmp(imgtmpfile);
+        imgtmpfile.clear();
+        if (!ok || lastlevel) {
+            remove_tmp(nexttmpfile);
+            break;
+        }
+
+        // Move on to the next level
+        if (next) {
+            img = next;
+        } else {
+            img.reset(new ImageBuf(nexttmpfile));
+            img->read(0, 0, false, TypeFloat);
+            imgtmpfile = nexttmpfile;
+        }
+        outspec = nextspec;
+        outspec.set_format(outputdatatype);
+        // If the format explicitly supports MIP-maps, use that, otherwise
+        // try to simulate MIP-mapping with multi-image.
+        ImageOutput::OpenMode mode = out->supports("mipmap")
+                                         ? ImageOutput::AppendMIPLevel
+                                         : ImageOutput::AppendSubimage;
+        if (!out->open(outputfilename, outspec, mode)) {
+            errorfmt("Could not append \"{}\" : {}", outputfilename,
+                     out->geterror());
+            remove_tmp(imgtmpfile);
+            ok = false;
+            break;
+        }
+    }
+    return ok;
+}
+
+
+
 static bool
 write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
              const ImageSpec& outspec_template, std::string outputfilename,
@@ -701,27 +1034,131 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
               outspec.height);
     }
 
+    // Streaming mode, if asked for and all the levels are plain box-filtered
+    // halvings of the top level.
+    if (configspec.get_int_attribute("maketx:stream")) {
+        if (filtername == "box" && !orig_was_overscan && sharpen <= 0.0f
+            && !do_highlight_compensation && !envlatlmode
+            && configspec.get_string_attribute("maketx:mipimages").empty()) {
+            int local_mb = configspec.get_int_attribute("maketx:read_local_MB",
+                                                        1024);
+            bool ok = write_mipmap_streamed(img, outspec, outputfilename, out,
+                                            outputdatatype, mipmap, clamp_half,
+                                            imagesize_t(local_mb) * 1024 * 1024,
+                                            verbose, outstream, stat_writetime,
+                                            stat_miptime, peak_mem);
+            img.reset();
+            writetimer.reset();
+            writetimer.start();
+            if (!out->close() && ok) {
+                errorfmt("Error writing \"{}\" : {}", outputfilename,
+                         out->geterror());
+                ok = false;
+            }
+            stat_writetime += writetimer();
+            if (ok && verbose)
+                print(outstream, "  Wrote file: {}  ({})\n", outputfilename,
+                      Strutil::memformat(Sysutil::memory_used(true)));
+            return ok;
+        }
+        if (verbose)
+            print(outstream, "  Streaming is only supported for the plain "
+                             "\"box\" filter; not streaming.\n");
+    }
+
     if (clamp_half) {
         std::shared_ptr<ImageBuf> tmp(new ImageBuf);
         ImageBufAlgo::clamp(*tmp, *img, -HALF_MAX, HALF_MAX, true);
         std::swap(tmp, img);
     }
-    if (!img->write(out)) {
-        // ImageBuf::write transfers any errors from the ImageOutput to
-        // the ImageBuf.
-        errorfmt("Write failed: {}", img->geterror());
-        out->close();
-        return false;
-    }
 
-    double wtime = writetimer();
-    stat_writetime += wtime;
-    if (verbose) {
-        size_t mem = Sysutil::memory_used(true);
-        peak_mem   = std::max(peak_mem, mem);
-        print(outstream, "    {:-15s} ({})  write {}\n", formatres(outspec),
-              Strutil::memformat(mem), Strutil::timeintervalformat(wtime, 2));
-    }
+    // Each level is compressed and written by a separate thread while the
+    // next level is computed from it, so that the conversion takes about
+    // as long as the slower of the two rather than their sum. At most one
+    // write is in flight: a level is handed off only after the previous
+    // one is done, and levels are never modified once handed off. The
+    // writer only fills in the write_* variables; the statistics and the
+    // verbose report are updated by this thread once it has been joined.
+    std::thread writer;
+    bool write_ok = true;
+    std::string write_error, write_report;
+    double write_time = 0.0;
+    size_t write_mem  = 0;
+
+    auto start_write = [&](std::shared_ptr<ImageBuf> level, ImageSpec spec,
+                           bool append, double miptime) {
+        writer = std::thread([&, level, spec, append, miptime]() {
+            Timer writetimer;
+            // If the format explicitly supports MIP-maps, use that,
+            // otherwise try to simulate MIP-mapping with multi-image.
+            ImageOutput::OpenMode mode = out->supports("mipmap")
+                                             ? ImageOutput::AppendMIPLevel
+                                             : ImageOutput::AppendSubimage;
+            if (append && !out->open(outputfilename, spec, mode)) {
+                write_error = Strutil::fmt::format(
+                    "Could not append \"{}\" : {}", outputfilename,
+                    out->geterror());
+                write_ok = false;
+                return;
+            }
+            if (!level->write(out)) {
+                // ImageBuf::write transfers any errors from the
+                // ImageOutput to the ImageBuf.
+                write_error = Strutil::fmt::format(
+                    "Error writing \"{}\" : {}", outputfilename,
+                    level->geterror());
+                write_ok = false;
+                return;
+            }
+            write_time = writetimer();
+            if (verbose) {
+                write_mem = Sysutil::memory_used(true);
+                if (append)
+                    write_report = Strutil::fmt::format(
+                        "    {:15s} ({})  downres {} write {}\n",
+                        formatres(spec), Strutil::memformat(write_mem),
+                        Strutil::timeintervalformat(miptime, 2),
+                        Strutil::timeintervalformat(write_time, 2));
+                else
+                    write_report = Strutil::fmt::format(
+                        "    {:15s} ({})  write {}\n", formatres(spec),
+                        Strutil::memformat(write_mem),
+                        Strutil::timeintervalformat(write_time, 2));
+            }
+        });
+    };
+    // Wait for the write in flight, if any, and report how it went.
+    auto finish_write = [&]() -> bool {
+        if (writer.joinable())
+            writer.join();
+        stat_writetime += write_time;
+        peak_mem = std::max(peak_mem, write_mem);
+        print(outstream, "{}", write_report);
+        write_time = 0.0;
+        write_report.clear();
+        if (!write_ok) {
+            errorfmt("{}", write_error);
+            write_error.clear();
+            out->close();
+        }
+        return write_ok;
+    };
+
+    // Trick: to get the resize of each level working properly, we reset
+    // both display and pixel windows to match, and have 0 offset, AND
+    // doctor the bigger image to have its display and pixel windows match.
+    // Don't worry, the texture engine doesn't care what the upper MIP
+    // levels have for the window sizes, it uses level 0 to determine the
+    // relatinship between texture 0-1 space (display window) and the
+    // pixels. The doctoring is done before a level is handed to the
+    // writer, which only looks at the pixel window.
+    auto match_full = [](ImageBuf& buf) {
+        buf.set_full(buf.xbegin(), buf.xend(), buf.ybegin(), buf.yend(),
+                     buf.zbegin(), buf.zend());
+    };
+    if (mipmap)
+        match_full(*img);
+    start_write(img, outspec, false, 0.0);
 
     if (mipmap) {  // Mipmap levels:
         if (verbose)
@@ -733,6 +1170,10 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
             Strutil::split(mipimages_unsplit, mipimages, ";");
         bool allow_shift
             = configspec.get_int_attribute("maketx:allow_pixel_shift") != 0;
+        bool srgb_average
+            = configspec.get_int_attribute("maketx:linear_average")
+              && ColorConfig::default_colorconfig().equivalent(
+                  outspec.get_string_attribute("oiio:ColorSpace"), "sRGB");
 
         std::shared_ptr<ImageBuf> small(new ImageBuf);
         while (outspec.width > 1 || outspec.height > 1) {
@@ -769,25 +1210,18 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                 smallspec.full_width  = smallspec.width;
                 smallspec.full_height = smallspec.height;
                 smallspec.full_depth  = smallspec.depth;
-                if (!allow_shift
-                    || configspec.get_int_attribute("maketx:forcefloat", 1))
+                // Levels are kept in the native type only if they can be
+                // made by the exact 2x box path (resize_block_ needs float).
+                if (configspec.get_int_attribute("maketx:forcefloat", 1)
+                    || (!allow_shift
+                        && (img->spec().width % 2 || img->spec().height % 2)))
                     smallspec.set_format(TypeDesc::FLOAT);
-
-                // Trick: to get the resize working properly, we reset
-                // both display and pixel windows to match, and have 0
-                // offset, AND doctor the big image to have its display
-                // and pixel windows match.  Don't worry, the texture
-                // engine doesn't care what the upper MIP levels have
-                // for the window sizes, it uses level 0 to determine
-                // the relatinship between texture 0-1 space (display
-                // window) and the pixels.
+                // See the "Trick" comment above match_full.
                 smallspec.x      = 0;
                 smallspec.y      = 0;
                 smallspec.full_x = 0;
                 smallspec.full_y = 0;
                 small->reset(smallspec);  // Realocate with new size
-                img->set_full(img->xbegin(), img->xend(), img->ybegin(),
-                              img->yend(), img->zbegin(), img->zend());
 
                 if (filtername == "box" && !orig_was_overscan
                     && sharpen <= 0.0f) {
@@ -796,11 +1230,13 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                                                            std::ref(*small),
                                                            std::cref(*img), _1,
                                                            envlatlmode,
-                                                           allow_shift));
+                                                           allow_shift,
+                                                           srgb_average));
                 } else {
                     Filter2D* filter = setup_filter(small->spec(), img->spec(),
                                                     filtername);
                     if (!filter) {
+                        finish_write();
                         errorfmt("Could not make filter \"{}\"", filtername);
                         return false;
                     }
@@ -816,8 +1252,12 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                                 (sharpen_first ? "before" : "after"));
                         print(outstream, "\n");
                     }
-                    if (do_highlight_compensation)
-                        ImageBufAlgo::rangecompress(*img, *img);
+                    if (do_highlight_compensation) {
+                        // Not in place: img may still be being written.
+                        std::shared_ptr<ImageBuf> comp(new ImageBuf);
+                        ImageBufAlgo::rangecompress(*comp, *img);
+                        std::swap(img, comp);
+                    }
                     if (sharpen > 0.0f && sharpen_first) {
                         std::shared_ptr<ImageBuf> sharp(new ImageBuf);
                         bool uok = ImageBufAlgo::unsharp_mask(*sharp, *img,
@@ -855,40 +1295,19 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
             outspec.set_format(outputdatatype);
             if (envlatlmode && src_samples_border)
                 fix_latl_edges(*small);
+            match_full(*small);
 
-            Timer writetimer;
-            // If the format explicitly supports MIP-maps, use that,
-            // otherwise try to simulate MIP-mapping with multi-image.
-            ImageOutput::OpenMode mode = out->supports("mipmap")
-                                             ? ImageOutput::AppendMIPLevel
-                                             : ImageOutput::AppendSubimage;
-            if (!out->open(outputfilename.c_str(), outspec, mode)) {
-                errorfmt("Could not append \"{}\" : {}", outputfilename,
-                         out->geterror());
-                return false;
-            }
-            if (!small->write(out)) {
-                // ImageBuf::write transfers any errors from the
-                // ImageOutput to the ImageBuf.
-                errorfmt("Error writing \"{}\" : {}", outputfilename,
-                         small->geterror());
-                out->close();
+            // Hand the new level to the writer once the previous one is
+            // out, and compute the next level from it meanwhile.
+            if (!finish_write())
                 return false;
-            }
-            double wtime = writetimer();
-            stat_writetime += wtime;
-            if (verbose) {
-                size_t mem = Sysutil::memory_used(true);
-                peak_mem   = std::max(peak_mem, mem);
-                print(outstream, "    {:-15s} ({})  downres {} write {}\n",
-                      formatres(smallspec), Strutil::memformat(mem),
-                      Strutil::timeintervalformat(this_miptime, 2),
-                      Strutil::timeintervalformat(wtime, 2));
-            }
+            start_write(small, outspec, true, this_miptime);
             std::swap(img, small);
         }
     }
 
+    if (!finish_write())
+        return false;
     if (verbose)
         print(outstream, "  Wrote file: {}  ({})\n", outputfilename,
               Strutil::memformat(Sysutil::memory_used(true)));
@@ -972,6 +1391,278 @@ stripdir_cmd_line(string_view cmdline)
 
 
 
+// Compute the key used by "maketx:update_by_hash" and "maketx:cas_dir": a
+// fast hash of the bytes of the source file, plus a hash of the conversion
+// parameters in configspec (leaving out the ones that don't change the
+// result, or that hold paths or times). Unlike file modification times,
+// this survives copying files between sites. Return "" if the source
+// can't be read.
+static std::string
+source_content_hash(const std::string& filename, const ImageSpec& configspec)
+{
+    Filesystem::IOFile in(filename, Filesystem::IOProxy::Read);
+    if (!in.opened())
+        return std::string();
+    const size_t chunksize = 4 * 1024 * 1024;
+    std::unique_ptr<char[]> buf(new char[chunksize]);
+    unsigned long long contenthash = 0;
+    for (size_t n; (n = in.read(buf.get(), chunksize)) > 0;)
+        contenthash = xxhash::XXH64(buf.get(), n, contenthash);
+
+    ImageSpec params = configspec;
+    for (auto name :
+         { "maketx:verbose", "maketx:runstats", "maketx:stats",
+           "maketx:updatemode", "maketx:update_by_hash", "maketx:cas_dir",
+           "maketx:full_command_line", "maketx:jobs", "maketx:memory_MB",
+           "maketx:stream", "maketx:read_local_MB", "Software",
+           "Exif:ImageHistory", "DateTime" })
+        params.erase_attribute(name);
+    std::string paramstr = params.serialize(ImageSpec::SerialText,
+                                            ImageSpec::SerialDetailed);
+    unsigned long long paramhash = xxhash::XXH64(paramstr.data(),
+                                                 paramstr.size());
+    return Strutil::fmt::format("{:016x}{:016x}", contenthash, paramhash);
+}
+
+
+
+// Retrieve the source hash recorded in an existing texture file, or "" if
+// there is none.
+static std::string
+recorded_source_hash(const std::string& filename)
+{
+    auto in = ImageInput::open(filename);
+    if (!in)
+        return std::string();
+    const ImageSpec& spec(in->spec());
+    std::string hash = spec.get_string_attribute("oiio:SourceHash");
+    if (hash.empty()) {
+        // Formats without arbitrary metadata keep it in the description
+        string_view desc = spec.get_string_attribute("ImageDescription");
+        size_t pos       = desc.find("oiio:SourceHash=");
+        if (pos != string_view::npos) {
+            desc.remove_prefix(pos + 16);
+            hash = Strutil::parse_until(desc, " ");
+        }
+    }
+    return hash;
+}
+
+
+
+// Per-tile statistics of the top MIP level (for "maketx:tile_stats").
+// consttiles gets space-separated "tileindex:v0,v1,..." entries for each
+// tile that is one constant color, and tilealpha one character per tile
+// classifying its alpha: 'o' if all opaque, 't' if all transparent, '-'
+// otherwise (or is left empty if there is no alpha channel). Tiles of
+// size tw x th are indexed in x-major order from the data window origin.
+static void
+compute_tile_stats(const ImageBuf& img, int tw, int th,
+                   std::string& consttiles, std::string& tilealpha)
+{
+    const ImageSpec& spec(img.spec());
+    int nxtiles = (spec.width + tw - 1) / tw;
+    int nytiles = (spec.height + th - 1) / th;
+    int ntiles  = nxtiles * nytiles;
+    int nc      = spec.nchannels;
+    int alpha   = spec.alpha_channel;
+    std::vector<float> colors(size_t(ntiles) * nc);
+    std::vector<char> isconst(ntiles, 0);
+    std::string alphas(alpha >= 0 ? ntiles : 0, '-');
+    parallel_for(0, ntiles, [&](int t) {
+        ROI roi(spec.x + (t % nxtiles) * tw, 0, spec.y + (t / nxtiles) * th,
+                0, spec.z, spec.z + 1, 0, nc);
+        roi.xend = std::min(roi.xbegin + tw, spec.x + spec.width);
+        roi.yend = std::min(roi.ybegin + th, spec.y + spec.height);
+        span<float> color(&colors[size_t(t) * nc], nc);
+        isconst[t] = ImageBufAlgo::isConstantColor(img, 0.0f, color, roi, 1);
+        if (alpha < 0)
+            return;
+        if (isconst[t] ? color[alpha] == 1.0f
+                       : ImageBufAlgo::isConstantChannel(img, alpha, 1.0f,
+                                                         roi, 1))
+            alphas[t] = 'o';
+        else if (isconst[t] ? color[alpha] == 0.0f
+                            : ImageBufAlgo::isConstantChannel(img, alpha, 0.0f,
+                                                              roi, 1))
+            alphas[t] = 't';
+    });
+    consttiles.clear();
+    for (int t = 0; t < ntiles; ++t) {
+        if (isconst[t])
+            consttiles += Strutil::fmt::format(
+                "{}{}:{}", consttiles.size() ? " " : "", t,
+                Strutil::join(cspan<float>(&colors[size_t(t) * nc], nc), ","));
+    }
+    tilealpha = alphas;
+}
+
+
+
+// "maketx:autotune": trial-encode a sample of img (up to four 256x256
+// regions from the centers of its quadrants) with each combination of
+// candidate tile size and compression method for the output format,
+// measuring the encoded size and the time to decode it again on one
+// thread (as the TextureSystem would), and set the tile size in dstspec
+// and the compression in configspec to the best candidate for the
+// objective: "size", "speed", or "balanced" (the smallest product of
+// size and decode time, each relative to the best seen). Return a
+// description of the choice, or an empty string if nothing could be
+// measured (leaving the settings alone).
+static std::string
+autotune_output(const ImageBuf& img, string_view outformat,
+                TypeDesc out_dataformat, string_view objective,
+                ImageSpec& dstspec, ImageSpec& configspec, bool verbose,
+                std::ostream& outstream)
+{
+    using OIIO::Strutil::sync::print;
+    auto out = ImageOutput::create(outformat);
+    if (!out || !out->supports("ioproxy")) {
+        if (verbose)
+            print(outstream, "  Autotune: {} output can't be measured\n",
+                  outformat);
+        return {};
+    }
+    std::string fmtname = out->format_name();
+    out.reset();
+
+    // Assemble the sample
+    const ImageSpec& spec(img.spec());
+    const int rw = std::min(256, (spec.width + 1) / 2);
+    const int rh = std::min(256, (spec.height + 1) / 2);
+    ImageBuf sample(ImageSpec(2 * rw, 2 * rh, spec.nchannels, TypeFloat));
+    for (int q = 0; q < 4; ++q) {
+        int x0 = spec.x + ((q & 1) * 2 + 1) * spec.width / 4 - rw / 2;
+        int y0 = spec.y + ((q >> 1) * 2 + 1) * spec.height / 4 - rh / 2;
+        x0     = clamp(x0, spec.x, spec.x + spec.width - rw);
+        y0     = clamp(y0, spec.y, spec.y + spec.height - rh);
+        ImageBufAlgo::paste(sample, (q & 1) * rw, (q >> 1) * rh, 0, 0, img,
+                            ROI(x0, x0 + rw, y0, y0 + rh, spec.z, spec.z + 1));
+    }
+
+    // The candidates. The current choice is listed first so that it wins
+    // ties.
+    // Compression names without any ":quality" suffix
+    auto method = [](string_view comp) {
+        auto parts = Strutil::splitsv(comp, ":");
+        return parts.size() ? std::string(parts[0]) : std::string();
+    };
+    std::string curcomp = configspec.get_string_attribute("compression",
+                                                          "zip");
+    std::vector<std::string> comps { curcomp };
+    if (fmtname == "openexr")
+        comps.insert(comps.end(), { "none", "zip", "piz", "dwaa" });
+    else if (fmtname == "tiff")
+        comps.insert(comps.end(), { "none", "lzw", "zip" });
+    std::vector<int> tiles { dstspec.tile_width, 32, 64, 128 };
+
+    struct Trial {
+        int tile;
+        std::string comp;
+        size_t bytes;
+        double seconds;
+    };
+    std::vector<Trial> trials;
+    for (int tile : tiles) {
+        for (const std::string& comp : comps) {
+            bool dup = false;
+            for (auto& t : trials)
+                dup |= (t.tile == tile
+                        && Strutil::iequals(t.comp, method(comp)));
+            if (dup)
+                continue;
+            ImageSpec trialspec = dstspec;
+            maketx_merge_spec(trialspec, configspec);
+            trialspec.copy_dimensions(sample.spec());
+            trialspec.alpha_channel = dstspec.alpha_channel;
+            trialspec.z_channel     = dstspec.z_channel;
+            trialspec.tile_width    = tile;
+            trialspec.tile_height   = tile;
+            trialspec.tile_depth    = 1;
+            trialspec.set_format(out_dataformat);
+            trialspec.attribute("compression", comp);
+
+            std::vector<unsigned char> encoded;
+            Filesystem::IOVecOutput vecout(encoded);
+            auto o = ImageOutput::create(fmtname);
+            if (!o || !o->set_ioproxy(&vecout)
+                || !o->open("autotune", trialspec) || !sample.write(o.get())
+                || !o->close())
+                continue;
+            o.reset();
+
+            Filesystem::IOMemReader memreader(encoded);
+            auto in = ImageInput::create(fmtname, false, nullptr, &memreader);
+            ImageSpec inspec;
+            if (!in || !in->open("autotune", inspec))
+                continue;
+            // The plugin may have substituted another method for one it
+            // doesn't know.
+            std::string reqcomp = method(comp);
+            if (comp != curcomp
+                && !Strutil::iequals(method(inspec.get_string_attribute(
+                                         "compression", comp)),
+                                     reqcomp))
+                continue;
+            in->threads(1);
+            std::unique_ptr<char[]> pixels(new char[inspec.image_bytes()]);
+            double best = 1.0e30;
+            bool ok     = true;
+            for (int rep = 0; rep < 3 && ok; ++rep) {
+                Timer timer;
+                ok   = in->read_image(0, 0, 0, inspec.nchannels, inspec.format,
+                                      pixels.get());
+                best = std::min(best, timer());
+            }
+            if (ok)
+                trials.push_back({ tile, reqcomp, encoded.size(), best });
+        }
+    }
+    if (trials.empty())
+        return {};
+
+    size_t minbytes = trials[0].bytes;
+    double minsecs  = trials[0].seconds;
+    for (auto& t : trials) {
+        minbytes = std::min(minbytes, t.bytes);
+        minsecs  = std::min(minsecs, t.seconds);
+    }
+    auto score = [&](const Trial& t) {
+        if (objective == "size")
+            return double(t.bytes);
+        if (objective == "speed")
+            return t.seconds;
+        return (double(t.bytes) / std::max(minbytes, size_t(1)))
+               * (t.seconds / std::max(minsecs, 1.0e-9));
+    };
+    const Trial* choice = &trials[0];
+    for (auto& t : trials) {
+        if (score(t) < score(*choice))
+            choice = &t;
+        if (verbose)
+            print(outstream, "  Autotune: tile {:3d} {:8s} {:>9s} {:8.5f}s\n",
+                  t.tile, t.comp, Strutil::memformat(t.bytes), t.seconds);
+    }
+
+    dstspec.tile_width     = choice->tile;
+    dstspec.tile_height    = choice->tile;
+    configspec.tile_width  = choice->tile;
+    configspec.tile_height = choice->tile;
+    if (!Strutil::iequals(choice->comp, method(curcomp)))
+        configspec.attribute("compression", choice->comp);
+    std::string result = Strutil::fmt::format("objective={} tile={}x{} "
+                                              "compression={}",
+                                              objective.size() ? objective
+                                                               : "balanced",
+                                              choice->tile, choice->tile,
+                                              choice->comp);
+    if (verbose)
+        print(outstream, "  Autotune chose: {}\n", result);
+    return result;
+}
+
+
+
 static bool
 make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
                   std::string filename, std::string outputfilename,
@@ -993,7 +1684,7 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         size_t mem = Sysutil::memory_used(true);            \
         peak_mem   = std::max(peak_mem, mem);               \
         if (verbose)                                        \
-            print(outstream, "  {:-25s} {}   ({})\n", task, \
+            print(outstream, "  {:25s} {}   ({})\n", task, \
                   Strutil::timeintervalformat(timer, 2),    \
                   Strutil::memformat(mem));                 \
     }
@@ -1023,19 +1714,19 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         return false;
     }
 
+    // Private cache for huge untiled inputs (see below). Declared first so
+    // that it outlives every ImageBuf that refers to it.
+    std::shared_ptr<ImageCache> srccache;
     std::shared_ptr<ImageBuf> src;
     if (input == NULL) {
         // No buffer supplied -- create one to read the file
         src.reset(new ImageBuf(filename, 0, 0, nullptr, &inconfig));
         src->init_spec(filename, 0, 0);  // force it to get the spec, not read
-    } else if (input->cachedpixels()) {
-        // Image buffer supplied that's backed by ImageCache -- create a
-        // copy (very light weight, just another cache reference)
-        src.reset(new ImageBuf(*input));
     } else {
-        // Image buffer supplied that has pixels -- wrap it
-        src.reset(new ImageBuf(input->name(), input->spec(),
-                               (void*)input->localpixels()));
+        // Image buffer supplied -- create a copy, which is very light
+        // weight: just another cache reference if it's backed by ImageCache,
+        // or else it shares (or wraps) the same pixels, with their strides.
+        src.reset(new ImageBuf(*input));
     }
     OIIO_DASSERT(src.get());
 
@@ -1099,6 +1790,42 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         }
     }
 
+    // Content-hash update mode: skip making the texture if the output
+    // already exists and records the same source content and conversion
+    // parameters. With a content-addressed cache directory, a texture
+    // already made from identical source and parameters (perhaps under
+    // another name) is reused by copying it.
+    bool hashupdate     = configspec.get_int_attribute("maketx:update_by_hash");
+    std::string cas_dir = configspec.get_string_attribute("maketx:cas_dir");
+    std::string source_hash;
+    std::string cas_filename;
+    if ((hashupdate || cas_dir.size()) && from_filename)
+        source_hash = source_content_hash(filename, configspec);
+    if (source_hash.size()) {
+        if (hashupdate && Filesystem::exists(outputfilename)
+            && recorded_source_hash(outputfilename) == source_hash) {
+            outstream << "maketx: no update required for \"" << outputfilename
+                      << "\"\n";
+            return true;
+        }
+        if (cas_dir.size()) {
+            cas_filename = Strutil::fmt::format("{}/{}{}", cas_dir,
+                                                source_hash, extension);
+            if (Filesystem::exists(cas_filename)
+                && recorded_source_hash(cas_filename) == source_hash) {
+                std::string err;
+                if (Filesystem::copy(cas_filename, tmpfilename, err)
+                    && Filesystem::rename(tmpfilename, outputfilename, err)) {
+                    outstream << "maketx: reused \"" << cas_filename
+                              << "\" for \"" << outputfilename << "\"\n";
+                    return true;
+                }
+                // If that failed for some reason, just make it anew
+                Filesystem::remove(tmpfilename);
+            }
+        }
+    }
+
     bool shadowmode  = (mode == ImageBufAlgo::MakeTxShadow);
     bool envlatlmode = (mode == ImageBufAlgo::MakeTxEnvLatl
                         || mode == ImageBufAlgo::MakeTxEnvLatlFromLightProbe);
@@ -1143,6 +1870,25 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     bool verbose       = configspec.get_int_attribute("maketx:verbose") != 0;
     double misc_time_1 = alltime.lap();
     STATUS("prep", misc_time_1);
+    // Through the shared ImageCache, an untiled file is one "tile" of the
+    // whole image, which would have to be entirely resident. For a file
+    // too big to read locally, use a private cache that breaks it into
+    // virtual tiles instead (reading each tile row of scanlines just once),
+    // so that the resize and MIP steps pull in only the parts they are
+    // working on, within the usual cache memory limit.
+    if (from_filename && !read_local && src->nativespec().tile_width == 0) {
+        float maxmem = 1024.0f;
+        ImageCache::create(true)->getattribute("max_memory_MB", maxmem);
+        srccache.reset(ImageCache::create(false),
+                       [](ImageCache* ic) { ImageCache::destroy(ic); });
+        srccache->attribute("max_memory_MB", maxmem);
+        srccache->attribute("autotile", 64);
+        srccache->attribute("autoscanline", 0);
+        src.reset(new ImageBuf(filename, 0, 0, srccache.get(), &inconfig));
+        if (verbose)
+            print(outstream, "  Reading untiled input in 64x64 tiles through "
+                  "a {} MB cache\n", maxmem);
+    }
     if (from_filename) {
         if (verbose)
             outstream << "Reading file: " << src->name() << std::endl;
@@ -1188,11 +1934,8 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         newspec.channelnames.push_back("b4_dhdt2");
         newspec.channelnames.push_back("b5_dh2dsdt");
         std::shared_ptr<ImageBuf> bumpslopes(new ImageBuf(newspec));
-        bool ok;
-        OIIO_DISPATCH_COMMON_TYPES(ok, "bump_to_bumpslopes", bump_to_bumpslopes,
-                                   src->spec().format, *bumpslopes, *src,
-                                   configspec, outstream);
-        // bump_to_bumpslopes(*bumpslopes, *src);
+        if (!bump_to_bumpslopes(*bumpslopes, *src, configspec, outstream))
+            return false;
         mode = ImageBufAlgo::MakeTxTexture;
         src  = bumpslopes;
     }
@@ -1230,12 +1973,25 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         const int channels = is_bumpslopes ? 6
                                            : std::min(4, src->spec().nchannels);
 
-        std::vector<float> invCDF(bins);
-        std::vector<float> CDF(bins);
-        std::vector<imagesize_t> hist;
+        // Bin all the channels in one parallel pass over the image (each
+        // thread accumulates its own rows' counts, summed at the end),
+        // then make the tables for each channel in parallel.
+        ROI cdfroi = get_roi(src->spec());
+        cdfroi.chend = std::min(cdfroi.chend, channels);
+        std::vector<std::vector<imagesize_t>> hists
+            = ImageBufAlgo::histograms(*src, bins, 0.0f, 1.0f, false, cdfroi);
+        if (int(hists.size()) != channels) {
+            errorfmt("Could not compute CDF: {}", src->geterror());
+            return false;
+        }
+        std::vector<std::vector<float>> invCDFs(channels), CDFs(channels);
 
-        for (int i = 0; i < channels; i++) {
-            hist = ImageBufAlgo::histogram(*src, i, bins, 0.0f, 1.0f);
+        parallel_for(0, channels, [&](int i) {
+            std::vector<imagesize_t>& hist(hists[i]);
+            std::vector<float>& invCDF(invCDFs[i]);
+            std::vector<float>& CDF(CDFs[i]);
+            invCDF.resize(bins);
+            CDF.resize(bins);
 
             // Turn the histogram into a non-normalized CDF
             for (uint64_t j = 1; j < bins; j++) {
@@ -1257,21 +2013,28 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
                                 * fast_ierf(c_sigma_inv * (2.0f * u - 1.0f));
                 invCDF[j] = std::min(1.0f, std::max(0.0f, g));
             }
-            configspec.attribute("invCDF_" + std::to_string(i),
-                                 TypeDesc(TypeDesc::FLOAT, bins),
-                                 invCDF.data());
 
             // Store the forward CDF as a lookup table to transform back to
             // the original image distribution from a Gaussian distribution.
+            // The lookups are in increasing order, so rather than searching
+            // for each one, just walk along the (monotonic) invCDF.
+            auto upper = invCDF.begin();
             for (uint64_t j = 0; j < bins; j++) {
-                auto upper = std::upper_bound(invCDF.begin(), invCDF.end(),
-                                              float(j) / (float(bins - 1)));
+                float val = float(j) / (float(bins - 1));
+                while (upper != invCDF.end() && !(val < *upper))
+                    ++upper;
                 CDF[j] = clamp(float(upper - invCDF.begin()) / float(bins - 1),
                                0.0f, 1.0f);
             }
+        });
 
+        for (int i = 0; i < channels; i++) {
+            configspec.attribute("invCDF_" + std::to_string(i),
+                                 TypeDesc(TypeDesc::FLOAT, bins),
+                                 invCDFs[i].data());
             configspec.attribute("CDF_" + std::to_string(i),
-                                 TypeDesc(TypeDesc::FLOAT, bins), CDF.data());
+                                 TypeDesc(TypeDesc::FLOAT, bins),
+                                 CDFs[i].data());
         }
 
         configspec["CDF_bits"] = cdf_bits;
@@ -1581,9 +2344,8 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
             || srcspec.format.basetype == TypeDesc::HALF
             || srcspec.format.basetype == TypeDesc::DOUBLE)) {
         int found_nonfinite = 0;
-        ImageBufAlgo::parallel_image(get_roi(srcspec),
-                                     std::bind(check_nan_block, std::ref(*src),
-                                               _1, std::ref(found_nonfinite)));
+        ImageBufAlgo::fixNonFinite(*src, *src, ImageBufAlgo::NONFINITE_NONE,
+                                   &found_nonfinite);
         if (found_nonfinite) {
             errorfmt("maketx ERROR: Nan/Inf at {} pixels", found_nonfinite);
             return false;
@@ -1726,6 +2488,10 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         // No resize needed, no format conversion needed -- just stick to
         // the image we've already got
         toplevel = src;
+    } else if (!do_resize && configspec.get_int_attribute("maketx:stream")) {
+        // Streaming mode will convert the pixels a band at a time as they
+        // are written, so don't make a whole converted copy.
+        toplevel = src;
     } else if (!do_resize) {
         // Need format conversion, but no resize -- just copy the pixels
         if (verbose)
@@ -1747,7 +2513,7 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
             ImageBufAlgo::parallel_image(
                 get_roi(dstspec),
                 std::bind(resize_block, std::ref(*toplevel), std::cref(*src),
-                          _1, envlatlmode, allow_shift != 0));
+                          _1, envlatlmode, allow_shift != 0, false));
         } else {
             Filter2D* filter = setup_filter(toplevel->spec(), src->spec(),
                                             resize_filter);
@@ -1781,6 +2547,9 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     dstspec.erase_attribute("AverageColor=");
     dstspec.erase_attribute("oiio:SHA-1=");
     dstspec.erase_attribute("SHA-1=");
+    dstspec.erase_attribute("oiio:SourceHash");
+    dstspec.erase_attribute("oiio:ConstantTiles");
+    dstspec.erase_attribute("oiio:TileAlpha");
     if (desc.size()) {
         Strutil::excise_string_after_head(desc, "oiio:ConstantColor=");
         Strutil::excise_string_after_head(desc, "ConstantColor=");
@@ -1788,6 +2557,7 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         Strutil::excise_string_after_head(desc, "AverageColor=");
         Strutil::excise_string_after_head(desc, "oiio:SHA-1=");
         Strutil::excise_string_after_head(desc, "SHA-1=");
+        Strutil::excise_string_after_head(desc, "oiio:SourceHash=");
         updatedDesc = true;
     }
 
@@ -1873,6 +2643,53 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
             outstream << "  Handed: " << handed << std::endl;
     }
 
+    std::string autotune = configspec.get_string_attribute("maketx:autotune");
+    if (autotune.size()) {
+        if (autotune == "1")
+            autotune = "balanced";
+        Timer autotunetimer;
+        std::string choice = autotune_output(*toplevel, outformat,
+                                             out_dataformat, autotune, dstspec,
+                                             configspec, verbose, outstream);
+        if (choice.size()) {
+            if (out->supports("arbitrary_metadata")) {
+                dstspec.attribute("oiio:Autotune", choice);
+            } else {
+                desc += Strutil::fmt::format("{}oiio:Autotune={}",
+                                             desc.length() ? " " : "",
+                                             Strutil::replace(choice, " ",
+                                                              ",", true));
+                updatedDesc = true;
+            }
+        }
+        STATUS("autotune", autotunetimer());
+    }
+
+    // Per-tile stats are too bulky for the ImageDescription, so they are
+    // only recorded in formats that take arbitrary metadata.
+    if (configspec.get_int_attribute("maketx:tile_stats")
+        && out->supports("arbitrary_metadata") && dstspec.tile_width
+        && dstspec.depth == 1) {
+        std::string consttiles, tilealpha;
+        compute_tile_stats(*toplevel, dstspec.tile_width, dstspec.tile_height,
+                           consttiles, tilealpha);
+        if (consttiles.size())
+            dstspec.attribute("oiio:ConstantTiles", consttiles);
+        if (tilealpha.size())
+            dstspec.attribute("oiio:TileAlpha", tilealpha);
+    }
+
+    if (source_hash.size()) {
+        if (out->supports("arbitrary_metadata")) {
+            dstspec.attribute("oiio:SourceHash", source_hash);
+        } else {
+            desc += Strutil::fmt::format("{}oiio:SourceHash={}",
+                                         desc.length() ? " " : "",
+                                         source_hash);
+            updatedDesc = true;
+        }
+    }
+
     if (updatedDesc) {
         dstspec.attribute("ImageDescription", desc);
     }
@@ -1911,6 +2728,21 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     if (!ok)
         Filesystem::remove(tmpfilename);
 
+    // Deposit a copy in the content-addressed cache directory (via a temp
+    // file, so other processes never see a partial one).
+    if (ok && cas_filename.size() && !Filesystem::exists(cas_filename)) {
+        std::string err;
+        std::string castmp = Filesystem::unique_path(cas_filename
+                                                     + ".%%%%%%%%.temp");
+        if (!Filesystem::copy(outputfilename, castmp, err)
+            || !Filesystem::rename(castmp, cas_filename, err)) {
+            Filesystem::remove(castmp);
+            if (verbose)
+                outstream << "  Could not add to texture cache \""
+                          << cas_filename << "\": " << err << "\n";
+        }
+    }
+
     if (verbose || configspec.get_int_attribute("maketx:runstats")
         || configspec.get_int_attribute("maketx:stats")) {
         double all = alltime();
@@ -1987,3 +2819,121 @@ ImageBufAlgo::make_texture(ImageBufAlgo::MakeTextureMode mode,
     }
     return ok;
 }
+
+
+
+bool
+ImageBufAlgo::make_texture_batch(ImageBufAlgo::MakeTextureMode mode,
+                                 cspan<std::string> filenames,
+                                 cspan<std::string> outputfilenames,
+                                 const ImageSpec& configspec,
+                                 std::ostream* outstream,
+                                 std::vector<std::string>* errors)
+{
+    pvt::LoggedTimer logtime("IBA::make_texture_batch");
+    using OIIO::Strutil::sync::print;  // Be sure to use synchronized one
+    size_t nfiles = filenames.size();
+    if (errors)
+        errors->assign(nfiles, std::string());
+    if (!nfiles)
+        return true;
+    if (outputfilenames.size() && size_t(outputfilenames.size()) != nfiles) {
+        pvt::errorfmt("make_texture_batch: {} input files but {} outputs",
+                      nfiles, outputfilenames.size());
+        return false;
+    }
+
+    // How many conversions to run at once. Each one's pixel loops already
+    // share the global thread pool, so a few concurrent jobs is enough to
+    // hide their serial parts (reading, writing, hashing).
+    int nthreads = OIIO::get_int_attribute("threads");
+    int jobs     = configspec.get_int_attribute("maketx:jobs");
+    if (jobs <= 0)
+        jobs = std::max(1, std::min(nthreads / 4, 8));
+    jobs = std::min(jobs, int(nfiles));
+
+    // Memory budget for the jobs running at once. The footprint of a job
+    // is estimated from its input's header: the top level in float plus
+    // room for the next MIP level (or the local-read threshold in
+    // streaming mode). A job that alone exceeds the budget runs by itself.
+    imagesize_t budget = imagesize_t(
+                             configspec.get_int_attribute("maketx:memory_MB"))
+                         * 1024 * 1024;
+    if (!budget)
+        budget = Sysutil::physical_memory() / 2;
+    bool streaming   = configspec.get_int_attribute("maketx:stream") != 0;
+    imagesize_t local_thresh
+        = imagesize_t(
+              configspec.get_int_attribute("maketx:read_local_MB", 1024))
+          * 1024 * 1024;
+    auto estimate = [&](const std::string& filename) -> imagesize_t {
+        auto in = ImageInput::open(filename);
+        if (!in)
+            return 0;  // will fail quickly anyway
+        const ImageSpec& spec(in->spec());
+        imagesize_t bytes = spec.image_pixels() * spec.nchannels
+                            * sizeof(float);
+        bytes += bytes / 2;
+        return streaming ? std::min(bytes, local_thresh) : bytes;
+    };
+
+    std::mutex mutex;
+    std::condition_variable budget_cv;
+    imagesize_t inuse = 0;
+    std::atomic<size_t> next_file(0);
+    std::atomic<int> nfailed(0);
+
+    auto worker = [&]() {
+        for (size_t i; (i = next_file++) < nfiles;) {
+            const std::string& filename(filenames[i]);
+            std::string outname = outputfilenames.size() ? outputfilenames[i]
+                                                         : std::string();
+            imagesize_t need = estimate(filename);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                budget_cv.wait(lock, [&]() {
+                    return inuse == 0 || inuse + need <= budget;
+                });
+                inuse += need;
+            }
+            // Capture each job's output, so that concurrent jobs don't
+            // interleave their messages.
+            std::ostringstream jobstream;
+            OIIO::geterror(true);  // start with a clean error slate
+            bool ok = make_texture_impl(mode, nullptr, filename, outname,
+                                        configspec, &jobstream);
+            std::string err = ok ? std::string() : OIIO::geterror(true);
+            if (!ok && err.empty())
+                err = "unknown error";
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                inuse -= need;
+                if (errors)
+                    (*errors)[i] = err;
+                if (outstream) {
+                    *outstream << jobstream.str();
+                    if (!ok)
+                        print(*outstream, "make_texture ERROR (\"{}\"): {}\n",
+                              filename, err);
+                }
+            }
+            budget_cv.notify_all();
+            if (!ok)
+                ++nfailed;
+        }
+    };
+
+    if (jobs <= 1) {
+        worker();
+    } else {
+        thread_group workers;
+        for (int j = 0; j < jobs; ++j)
+            workers.create_thread(worker);
+        workers.join_all();
+    }
+
+    if (nfailed)
+        pvt::errorfmt("make_texture_batch: {} of {} conversions failed",
+                      int(nfailed), nfiles);
+    return nfailed == 0;
+}
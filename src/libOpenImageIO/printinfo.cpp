@@ -72,6 +72,42 @@ compute_sha1(ImageInput* input, int subimage, int miplevel, std::string& err)
 
 
 
+std::string
+compute_pixel_hash(ImageInput* input, int subimage, int miplevel,
+                   string_view hashtype, std::string& err)
+{
+    if (Strutil::iequals(hashtype, "sha1"))
+        return compute_sha1(input, subimage, miplevel, err);
+
+    ImageSpec spec = input->spec_dimensions(subimage, miplevel);
+    bool ok        = true;
+    ImageBuf buf;
+    if (spec.deep) {
+        buf.reset(spec);
+        ok = input->read_native_deep_image(subimage, miplevel,
+                                           *buf.deepdata());
+    } else {
+        // Per-channel formats are read as the overall format, so that the
+        // buffer can be described by a plain ImageSpec.
+        spec.channelformats.clear();
+        buf.reset(spec, InitializePixels::No);
+        ok = input->read_image(subimage, miplevel, 0, spec.nchannels,
+                               spec.format, buf.localpixels());
+    }
+    if (!ok) {
+        err = input->geterror();
+        if (err.empty())
+            err = "could not read image";
+        return std::string();
+    }
+    std::string hash = computePixelHash(buf, hashtype);
+    if (hash.empty())
+        err = buf.geterror();
+    return hash;
+}
+
+
+
 static std::string
 stats_num(float val, int maxval, bool round)
 {
@@ -23,6 +23,7 @@
 #include <OpenImageIO/varyingref.h>
 
 #include "imagecache_pvt.h"
+#include "imageio_pvt.h"
 #include "texture_pvt.h"
 
 
@@ -589,6 +590,7 @@ TextureSystemImpl::environment(TextureHandle* texture_handle,
                                int nchannels, float* result, float* dresultds,
                                float* dresultdt)
 {
+    pvt::TraceScope trace("TS::environment_batch");
     // (FIXME) CHEAT! Texture points individually
     TextureOpt opt;
     opt.firstchannel        = options.firstchannel;
@@ -603,38 +605,58 @@ TextureSystemImpl::environment(TextureHandle* texture_handle,
     opt.fill                = options.fill;
     opt.missingcolor        = options.missingcolor;
 
-    bool ok          = true;
-    Tex::RunMask bit = 1;
-    float* r         = OIIO_ALLOCA(float, 3 * nchannels * Tex::BatchWidth);
-    float* drds      = r + nchannels * Tex::BatchWidth;
-    float* drdt      = r + 2 * nchannels * Tex::BatchWidth;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            opt.rnd    = options.rnd[i];
+    bool ok     = true;
+    float* r    = OIIO_ALLOCA(float, 3 * nchannels * Tex::BatchWidth);
+    float* drds = r + nchannels * Tex::BatchWidth;
+    float* drdt = r + 2 * nchannels * Tex::BatchWidth;
+    float s[Tex::BatchWidth], t[Tex::BatchWidth], filtwidth[Tex::BatchWidth];
+    TextureFile* texturefile = (TextureFile*)texture_handle;
+    if (m_coherent_batches && texturefile) {
+        // Approximate where each direction lands in the latlong map, and
+        // how wide its footprint is, so lanes can be sorted by tile.
+        for (int i = 0; i < Tex::BatchWidth; ++i) {
             Imath::V3f R_(R[i], R[i + Tex::BatchWidth],
                           R[i + 2 * Tex::BatchWidth]);
             Imath::V3f dRdx_(dRdx[i], dRdx[i + Tex::BatchWidth],
                              dRdx[i + 2 * Tex::BatchWidth]);
             Imath::V3f dRdy_(dRdy[i], dRdy[i + Tex::BatchWidth],
                              dRdy[i + 2 * Tex::BatchWidth]);
-            if (dresultds) {
-                ok &= environment(texture_handle, thread_info, opt, R_, dRdx_,
-                                  dRdy_, nchannels, r, drds, drdt);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
-                }
-            } else {
-                ok &= environment(texture_handle, thread_info, opt, R_, dRdx_,
-                                  dRdy_, nchannels, r);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
-                }
+            vector_to_latlong(R_, texturefile->m_y_up, s[i], t[i]);
+            float len    = std::max(R_.length(), 1.0e-6f);
+            filtwidth[i] = std::max(dRdx_.length(), dRdy_.length())
+                           / (len * float(M_PI));
+        }
+    }
+    int order[Tex::BatchWidth];
+    int nlanes = batch_lane_order(texture_handle, (PerThreadInfo*)thread_info,
+                                  options.subimage, mask, s, t, filtwidth,
+                                  order);
+    for (int n = 0; n < nlanes; ++n) {
+        int i = order[n];
+        opt.sblur  = options.sblur[i];
+        opt.tblur  = options.tblur[i];
+        opt.swidth = options.swidth[i];
+        opt.twidth = options.twidth[i];
+        opt.rnd    = options.rnd[i];
+        Imath::V3f R_(R[i], R[i + Tex::BatchWidth],
+                      R[i + 2 * Tex::BatchWidth]);
+        Imath::V3f dRdx_(dRdx[i], dRdx[i + Tex::BatchWidth],
+                         dRdx[i + 2 * Tex::BatchWidth]);
+        Imath::V3f dRdy_(dRdy[i], dRdy[i + Tex::BatchWidth],
+                         dRdy[i + 2 * Tex::BatchWidth]);
+        if (dresultds) {
+            ok &= environment(texture_handle, thread_info, opt, R_, dRdx_,
+                              dRdy_, nchannels, r, drds, drdt);
+            for (int c = 0; c < nchannels; ++c) {
+                result[c * Tex::BatchWidth + i]    = r[c];
+                dresultds[c * Tex::BatchWidth + i] = drds[c];
+                dresultdt[c * Tex::BatchWidth + i] = drdt[c];
+            }
+        } else {
+            ok &= environment(texture_handle, thread_info, opt, R_, dRdx_,
+                              dRdy_, nchannels, r);
+            for (int c = 0; c < nchannels; ++c) {
+                result[c * Tex::BatchWidth + i] = r[c];
             }
         }
     }
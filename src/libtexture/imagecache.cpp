@@ -4,12 +4,16 @@
 
 
 #include <cstring>
+#include <ctime>
 #include <memory>
 #include <regex>
+#include <shared_mutex>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include <zlib.h>
+
 #include <OpenImageIO/Imath.h>
 
 #include <OpenImageIO/color.h>
@@ -21,6 +25,7 @@
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/optparser.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/simd.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
@@ -70,6 +75,19 @@ static ustring s_constantalpha("constantalpha");
 static std::atomic_int64_t imagecache_next_id = 0;
 static thread_local tsl::robin_map<uint64_t, ImageCachePerThreadInfo*>
     imagecache_per_thread_infos;
+// The calling thread's Perthread for the ImageCache it used last, checked
+// before the map above, so that a thread working with one cache finds its
+// Perthread with a single compare.
+struct PerThreadInfoSlot {
+    uint64_t imagecache_id               = ~uint64_t(0);
+    ImageCachePerThreadInfo* thread_info = nullptr;
+};
+static thread_local PerThreadInfoSlot imagecache_per_thread_slot;
+// For each ImageCache this thread has bound a Perthread to, the entry of
+// imagecache_per_thread_infos that the binding displaced (maybe null), to
+// put back when it is unbound.
+static thread_local tsl::robin_map<uint64_t, ImageCachePerThreadInfo*>
+    imagecache_unbound_thread_infos;
 
 
 // Functor to compare filenames
@@ -118,6 +136,14 @@ redundantbytes_compare(const ImageCacheFileRef& a, const ImageCacheFileRef& b)
 }
 
 
+// Functor to compare time spent in texture lookups, sort in descending order
+static bool
+texturetime_compare(const ImageCacheFileRef& a, const ImageCacheFileRef& b)
+{
+    return a->texture_time() > b->texture_time();
+}
+
+
 };  // end anonymous namespace
 
 
@@ -131,6 +157,7 @@ ImageCacheStatistics::init()
     // ImageCache stats:
     find_tile_calls             = 0;
     find_tile_microcache_misses = 0;
+    find_tile_microcache_hits   = 0;
     find_tile_cache_misses      = 0;
     //    tiles_created = 0;
     //    tiles_current = 0;
@@ -148,6 +175,21 @@ ImageCacheStatistics::init()
     tile_locking_time = 0;
     find_file_time    = 0;
     find_tile_time    = 0;
+    tiles_mmapped      = 0;
+    tiles_constant_shared = 0;
+    tiles_constant_synthesized = 0;
+    tiles_read_ahead   = 0;
+    tiles_from_slab    = 0;
+    numa_local_hits    = 0;
+    numa_remote_hits   = 0;
+    tiles_compressed   = 0;
+    tiles_uncompressed = 0;
+    compress_bytes_in  = 0;
+    compress_bytes_out = 0;
+    compress_time      = 0;
+    uncompress_time    = 0;
+    tiles_colorconverted = 0;
+    colorconvert_time    = 0;
 
     // TextureSystem stats:
     texture_queries     = 0;
@@ -177,6 +219,7 @@ ImageCacheStatistics::merge(const ImageCacheStatistics& s)
     // ImageCache stats:
     find_tile_calls += s.find_tile_calls;
     find_tile_microcache_misses += s.find_tile_microcache_misses;
+    find_tile_microcache_hits += s.find_tile_microcache_hits;
     find_tile_cache_misses += s.find_tile_cache_misses;
     //    tiles_created += s.tiles_created;
     //    tiles_current += s.tiles_current;
@@ -194,6 +237,21 @@ ImageCacheStatistics::merge(const ImageCacheStatistics& s)
     tile_locking_time += s.tile_locking_time;
     find_file_time += s.find_file_time;
     find_tile_time += s.find_tile_time;
+    tiles_mmapped += s.tiles_mmapped;
+    tiles_constant_shared += s.tiles_constant_shared;
+    tiles_constant_synthesized += s.tiles_constant_synthesized;
+    tiles_read_ahead += s.tiles_read_ahead;
+    tiles_from_slab += s.tiles_from_slab;
+    numa_local_hits += s.numa_local_hits;
+    numa_remote_hits += s.numa_remote_hits;
+    tiles_compressed += s.tiles_compressed;
+    tiles_uncompressed += s.tiles_uncompressed;
+    compress_bytes_in += s.compress_bytes_in;
+    compress_bytes_out += s.compress_bytes_out;
+    compress_time += s.compress_time;
+    uncompress_time += s.uncompress_time;
+    tiles_colorconverted += s.tiles_colorconverted;
+    colorconvert_time += s.colorconvert_time;
 
     // TextureSystem stats:
     texture_queries += s.texture_queries;
@@ -269,6 +327,11 @@ ImageCacheFile::LevelInfo::LevelInfo(const LevelInfo& src)
 
 
 
+struct ImageCacheFile::SlabMap
+    : public tsl::robin_map<TileID, std::weak_ptr<char>, TileID::Hasher> {};
+
+
+
 ImageCacheFile::ImageCacheFile(ImageCacheImpl& imagecache,
                                ImageCachePerThreadInfo* /*thread_info*/,
                                ustring filename, ImageInput::Creator creator,
@@ -331,6 +394,133 @@ ImageCacheFile::reset(ImageInput::Creator creator, const ImageSpec* config)
 
 
 
+/// IOProxy that the cache gives the ImageInput for a local file, so that
+/// when too many files are open, it can close just the file descriptor and
+/// keep the ImageInput open with all its parsed state (specs, directory and
+/// offset tables, codec setup). The next read reopens the file, which costs
+/// only an open() call rather than a whole ImageInput::open(). All reads go
+/// through pread() on the underlying IOFile, so nothing depends on its
+/// position surviving the close.
+class DetachableFileProxy final : public Filesystem::IOProxy {
+public:
+    DetachableFileProxy(ustring filename, ImageCacheImpl& imagecache)
+        : IOProxy(filename, Closed)
+        , m_imagecache(imagecache)
+    {
+        m_file.reset(new Filesystem::IOFile(filename, Read));
+        if (m_file->opened()) {
+            m_size     = m_file->size();
+            m_mode     = Read;
+            m_attached = true;
+        } else {
+            error(m_file->error());
+            m_file.reset();
+        }
+    }
+    ~DetachableFileProxy() override
+    {
+        // set_imageinput() counted our ImageInput as an open file, and will
+        // uncount it when it closes. If we had already uncounted it when
+        // closing the descriptor, put it back to keep the tally right.
+        if (m_detached)
+            m_imagecache.fd_reattached(false);
+    }
+    const char* proxytype() const override { return "detachablefile"; }
+    void close() override
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_file.reset();
+        m_attached = false;
+        m_mode     = Closed;
+    }
+    bool seek(int64_t offset) override
+    {
+        m_pos = offset;
+        return true;
+    }
+    size_t read(void* buf, size_t size) override
+    {
+        size = pread(buf, size, m_pos);
+        m_pos += size;
+        return size;
+    }
+    size_t pread(void* buf, size_t size, int64_t offset) override
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        while (!m_file) {
+            lock.unlock();
+            if (!reattach())
+                return 0;
+            lock.lock();
+        }
+        return m_file->pread(buf, size, offset);
+    }
+    size_t size() const override { return m_size; }
+
+    /// Does it currently hold an open file descriptor?
+    bool attached() const { return m_attached; }
+
+    /// Close the file descriptor, unless it's being read from right now.
+    /// Return true if it was closed.
+    bool detach()
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex, std::try_to_lock);
+        if (!lock.owns_lock() || !m_file)
+            return false;
+        m_file.reset();
+        m_attached = false;
+        if (!m_detached) {
+            m_detached = true;
+            m_imagecache.fd_detached();
+        }
+        return true;
+    }
+
+private:
+    ImageCacheImpl& m_imagecache;
+    std::unique_ptr<Filesystem::IOFile> m_file;
+    std::shared_mutex m_mutex;  // readers share it, detach/reattach own it
+    size_t m_size = 0;
+    std::atomic<bool> m_attached { false };
+    bool m_detached = false;  // Closed by detach() and not yet reopened
+
+    bool reattach()
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        if (m_file)
+            return true;  // Somebody beat us to it
+        if (m_mode == Closed)
+            return false;
+        std::unique_ptr<Filesystem::IOFile> f(
+            new Filesystem::IOFile(m_filename, Read));
+        if (!f->opened()) {
+            error(f->error());
+            return false;
+        }
+        m_file     = std::move(f);
+        m_attached = true;
+        if (m_detached) {
+            m_detached = false;
+            m_imagecache.fd_reattached();
+        }
+        return true;
+    }
+};
+
+
+
+// Some readers accept a proxy but only know how to use a plain IOFile or
+// IOMemReader, reaching past the IOProxy interface for the FILE* or the
+// buffer. The cache must not hand those readers one of its own proxies.
+static bool
+reader_takes_any_proxy(const ImageInput* inp)
+{
+    string_view fmt = inp->format_name();
+    return fmt != "jpeg" && fmt != "jpegxl";
+}
+
+
+
 std::shared_ptr<ImageInput>
 ImageCacheFile::get_imageinput(ImageCachePerThreadInfo* /*thread_info*/)
 {
@@ -349,7 +539,8 @@ ImageCacheFile::get_imageinput(ImageCachePerThreadInfo* /*thread_info*/)
 
 
 void
-ImageCacheFile::set_imageinput(std::shared_ptr<ImageInput> newval)
+ImageCacheFile::set_imageinput(std::shared_ptr<ImageInput> newval,
+                               std::shared_ptr<DetachableFileProxy> fdproxy)
 {
     if (newval)
         imagecache().incr_open_files();
@@ -360,11 +551,13 @@ ImageCacheFile::set_imageinput(std::shared_ptr<ImageInput> newval)
     std::shared_ptr<ImageInput> oldval;
     {
         recursive_timed_lock_guard guard(m_input_mutex);
-        oldval  = m_input;
-        m_input = newval;
+        oldval    = m_input;
+        m_input   = newval;
+        m_fdproxy = fdproxy;
     }
 #else
     // True C++11: can atomically exchange a shared_ptr safely.
+    std::atomic_store(&m_fdproxy, fdproxy);
     auto oldval = std::atomic_exchange(&m_input, newval);
 #endif
     if (oldval)
@@ -441,6 +634,28 @@ ImageCacheFile::SubimageInfo::init(ImageCacheFile& icfile,
             has_average_color = true;
     }
 
+    // See if maketx recorded which tiles of the top level are constant
+    // ("tileindex:v0,v1,... ..."), so they can be made without reading.
+    string_view consttiles = spec.get_string_attribute("oiio:ConstantTiles");
+    if (from_maketx && consttiles.size() && spec.tile_width
+        && spec.depth == 1) {
+        std::vector<float> vals;
+        int tile;
+        while (Strutil::parse_int(consttiles, tile)
+               && Strutil::parse_char(consttiles, ':')) {
+            vals.clear();
+            float val;
+            while (Strutil::parse_float(consttiles, val)) {
+                vals.push_back(val);
+                if (!Strutil::parse_char(consttiles, ','))
+                    break;
+            }
+            if (vals.size() != size_t(spec.nchannels))
+                break;
+            constant_tiles[tile] = vals;
+        }
+    }
+
     const ParamValue* p = spec.find_attribute("worldtolocal", TypeMatrix);
     if (p) {
         Imath::M44f c2w;
@@ -452,6 +667,25 @@ ImageCacheFile::SubimageInfo::init(ImageCacheFile& icfile,
 
 
 
+// Build the HeaderIndex key for a file. Besides the absolute path (so the
+// same relative name from two working directories can't collide), it
+// includes what can change the headers a reader reports for the same file:
+// the library version and the configuration hints the cache passes to
+// open().
+static std::string
+headerindex_key(const ImageCacheFile& file)
+{
+    string_view name(file.filename());
+    std::string dir = Filesystem::path_is_absolute(name)
+                          ? std::string()
+                          : Filesystem::current_path() + "/";
+    return Strutil::fmt::format("{}{}|oiio={} unassoc={}", dir, name,
+                                OIIO_VERSION_STRING,
+                                int(file.imagecache().unassociatedalpha()));
+}
+
+
+
 std::shared_ptr<ImageInput>
 ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
 {
@@ -461,8 +695,14 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     std::shared_ptr<ImageInput> inp = get_imageinput(thread_info);
     if (m_broken)
         return {};
-    if (inp)
+    if (inp) {
+        // If its file descriptor was closed, the next read will reopen
+        // it, so make room for it under the open files limit.
+        auto fdproxy = std::atomic_load(&m_fdproxy);
+        if (fdproxy && !fdproxy->attached())
+            imagecache().check_max_files(thread_info);
         return inp;
+    }
 
     // The file wasn't already opened and in a good state.
 
@@ -514,6 +754,54 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
         return {};
     }
 
+    // With the "io_uring" option, do this file's reads through the cache's
+    // shared ring, if the reader accepts a proxy. The proxy must outlive
+    // the ImageInput, so bundle the two together and hand out an aliased
+    // pointer to the ImageInput that keeps the bundle alive.
+    if (auto ring = imagecache().io_uring_ring()) {
+        if (!configspec.find_attribute("oiio:ioproxy")
+            && inp->supports("ioproxy") && reader_takes_any_proxy(inp.get())) {
+            struct InputWithProxy {
+                std::unique_ptr<Filesystem::IOProxy> proxy;
+                std::shared_ptr<ImageInput> input;  // destroyed first
+            };
+            auto bundle   = std::make_shared<InputWithProxy>();
+            bundle->proxy.reset(new Filesystem::IOUringReader(m_filename,
+                                                              ring));
+            if (bundle->proxy->opened()) {
+                void* ptr = bundle->proxy.get();
+                configspec.attribute("oiio:ioproxy", TypeDesc::PTR, &ptr);
+                bundle->input = std::move(inp);
+                inp = std::shared_ptr<ImageInput>(bundle,
+                                                  bundle->input.get());
+            }
+        }
+    }
+
+    // Otherwise, if the reader accepts a proxy, read a local file through
+    // one whose descriptor can be closed when there are too many files
+    // open, without closing the ImageInput. Bundle them like above.
+    std::shared_ptr<DetachableFileProxy> fdproxy;
+    if (m_allow_release && !configspec.find_attribute("oiio:ioproxy")
+        && inp->supports("ioproxy") && reader_takes_any_proxy(inp.get())) {
+        fdproxy = std::make_shared<DetachableFileProxy>(m_filename,
+                                                        imagecache());
+        if (fdproxy->opened()) {
+            struct InputWithFdProxy {
+                std::shared_ptr<DetachableFileProxy> proxy;
+                std::shared_ptr<ImageInput> input;  // destroyed first
+            };
+            auto bundle   = std::make_shared<InputWithFdProxy>();
+            bundle->proxy = fdproxy;
+            void* ptr     = fdproxy.get();
+            configspec.attribute("oiio:ioproxy", TypeDesc::PTR, &ptr);
+            bundle->input = std::move(inp);
+            inp = std::shared_ptr<ImageInput>(bundle, bundle->input.get());
+        } else {
+            fdproxy.reset();  // Not a plain file, open it the usual way
+        }
+    }
+
     ImageSpec nativespec, tempspec;
     mark_not_broken();
     bool ok = true;
@@ -543,13 +831,55 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     // If we are simply re-opening a closed file, and the spec is still
     // valid, we're done, no need to reread the subimage and mip headers.
     if (validspec()) {
-        set_imageinput(inp);
+        set_imageinput(inp, fdproxy);
         return inp;
     }
 
     // From here on, we know that we've opened this file for the very
     // first time.  So read all the subimages, fill out all the fields
-    // of the ImageCacheFile.
+    // of the ImageCacheFile. If there's a header index, record the native
+    // specs as we go, for the benefit of later processes.
+    HeaderIndex& index(imagecache().headerindex());
+    bool record = index.enabled() && !m_inputcreator && !m_configspec;
+    HeaderIndex::Entry entry;
+    // Note the file's size and modification time before reading the
+    // headers, so that a change while we read them can't be recorded as
+    // matching them.
+    int64_t size  = record ? int64_t(Filesystem::file_size(m_filename)) : 0;
+    int64_t mtime = record ? Filesystem::last_write_time_ns(m_filename) : 0;
+    if (record)
+        entry.specs.resize(1, { nativespec });
+    ok = init_subimages(thread_info, nativespec, inp->format_name(),
+                        [&](int subimage, int miplevel, ImageSpec& spec) {
+                            if (!inp->seek_subimage(subimage, miplevel, spec))
+                                return false;
+                            if (record) {
+                                entry.specs.resize(subimage + 1);
+                                entry.specs[subimage].push_back(spec);
+                            }
+                            return true;
+                        });
+    if (!ok)
+        return {};
+    init_from_spec();  // Fill in the rest of the fields
+    if (record) {
+        entry.format = m_fileformat.string();
+        if (Strutil::starts_with(m_fingerprint, "xxh64:"))
+            entry.fingerprint = m_fingerprint.string();
+        index.write(headerindex_key(*this), size, mtime, entry);
+    }
+    set_imageinput(inp, fdproxy);
+    return inp;
+}
+
+
+
+bool
+ImageCacheFile::init_subimages(ImageCachePerThreadInfo* thread_info,
+                               ImageSpec nativespec, string_view formatname,
+                               function_view<bool(int, int, ImageSpec&)> seek)
+{
+    ImageSpec tempspec;
     m_subimages.clear();
     int nsubimages = 0;
 
@@ -612,18 +942,17 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
                 && tempspec.nchannels != spec(nsubimages, 0).nchannels) {
                 // No idea what to do with a subimage that doesn't have the
                 // same number of channels as the others, so just skip it.
-                inp.reset();
                 mark_broken(
                     "Subimages don't all have the same number of channels");
                 invalidate_spec();
-                return {};
+                return false;
             }
             // ImageCache can't store differing formats per channel
             tempspec.channelformats.clear();
             LevelInfo levelinfo(tempspec, nativespec);
             si.levels.push_back(levelinfo);
             ++nmip;
-        } while (inp->seek_subimage(nsubimages, nmip, nativespec));
+        } while (seek(nsubimages, nmip, nativespec));
 
         // Special work for non-MIPmapped images -- but only if "automip"
         // is on, it's a non-mipmapped image, and it doesn't have a
@@ -670,16 +999,14 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
         if (si.untiled && !imagecache().accept_untiled()) {
             mark_broken("image was untiled");
             invalidate_spec();
-            inp.reset();
-            return {};
+            return false;
         }
         if (si.unmipped && !imagecache().accept_unmipped() &&
             // Allow unmip-mapped for null inputs (user buffers)
-            strcmp(inp->format_name(), "null")) {
+            formatname != "null") {
             mark_broken("image was not MIP-mapped");
             invalidate_spec();
-            inp.reset();
-            return {};
+            return false;
         }
         si.n_mip_levels = nmip;
         // Make sure we didn't set the subimage's mip_mip_level past the end
@@ -691,7 +1018,7 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
             si.minwh[m] = std::min(si.spec(m).width, si.spec(m).height);
         si.minwh[nmip] = 0;  // One past the end, set to 0
         ++nsubimages;
-    } while (inp->seek_subimage(nsubimages, 0, nativespec));
+    } while (seek(nsubimages, 0, nativespec));
     OIIO_DASSERT((size_t)nsubimages == m_subimages.size());
 
     m_total_imagesize_ondisk = imagesize_t(Filesystem::file_size(m_filename));
@@ -701,9 +1028,47 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     thread_info->m_stats.files_totalsize_ondisk -= old_total_imagesize_ondisk;
     thread_info->m_stats.files_totalsize_ondisk += m_total_imagesize_ondisk;
 
-    init_from_spec();  // Fill in the rest of the fields
-    set_imageinput(inp);
-    return inp;
+    return true;
+}
+
+
+
+bool
+ImageCacheFile::open_from_index(ImageCachePerThreadInfo* thread_info)
+{
+    HeaderIndex& index(imagecache().headerindex());
+    if (!index.enabled() || m_inputcreator || m_configspec)
+        return false;
+    // An entry is only good while the file's size and modification time
+    // (to the nanosecond, where the filesystem keeps it) match what was
+    // recorded. (A missing file won't match anything, and is left for
+    // open() to report.)
+    int64_t size  = int64_t(Filesystem::file_size(m_filename));
+    int64_t mtime = Filesystem::last_write_time_ns(m_filename);
+    HeaderIndex::Entry entry;
+    if (!index.read(headerindex_key(*this), size, mtime, entry))
+        return false;
+
+    mark_not_broken();
+    m_fileformat = ustring(entry.format);
+    const auto& specs(entry.specs);
+    bool ok = init_subimages(
+        thread_info, specs[0][0], entry.format,
+        [&](int subimage, int miplevel, ImageSpec& spec) {
+            if (subimage >= int(specs.size())
+                || miplevel >= int(specs[subimage].size()))
+                return false;
+            spec = specs[subimage][miplevel];
+            return true;
+        });
+    // A file the headers show to be unusable is broken just as if we had
+    // opened it, so there's nothing more to do in that case.
+    if (ok) {
+        if (entry.fingerprint.size() && imagecache().fingerprint_files())
+            m_fingerprint = ustring(entry.fingerprint);
+        init_from_spec();
+    }
+    return true;
 }
 
 
@@ -783,6 +1148,15 @@ ImageCacheFile::init_from_spec()
     string_view fing = spec.get_string_attribute("oiio:SHA-1");
     if (fing.length())
         m_fingerprint = ustring(fing);
+    // If not, and we were asked to, fingerprint the file's contents so
+    // that byte-identical copies can still be deduplicated. Custom input
+    // creators and configuration hints may make identical files read
+    // differently, so those are never fingerprinted this way.
+    unsigned long long filehash = 0;
+    if (m_fingerprint.empty() && m_imagecache.fingerprint_files()
+        && !m_inputcreator && !m_configspec
+        && xxhash::file_hash(m_filename, filehash))
+        m_fingerprint = ustring::fmtformat("xxh64:{:016x}", filehash);
 
     m_mod_time = Filesystem::last_write_time(m_filename);
 
@@ -803,6 +1177,7 @@ bool
 ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info,
                           const TileID& id, void* data)
 {
+    pvt::TraceScope trace("IC::read_tile");
     OIIO_DASSERT(id.chend() > id.chbegin());
 
     // Mark if we ever use a mip level that's not the first
@@ -819,6 +1194,30 @@ ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info,
     if (subinfo.unmipped && miplevel != 0)
         return read_unmipped(thread_info, id, data);
 
+    // Tiles that maketx recorded as constant are filled in without
+    // opening or reading the file at all.
+    if (miplevel == 0 && subinfo.constant_tiles.size()) {
+        const LevelInfo& lev(levelinfo(subimage, 0));
+        int whichtile = (id.x() - lev.spec.x) / lev.spec.tile_width
+                        + ((id.y() - lev.spec.y) / lev.spec.tile_height)
+                              * lev.nxtiles;
+        auto found = subinfo.constant_tiles.find(whichtile);
+        if (found != subinfo.constant_tiles.end()) {
+            int nc           = id.chend() - id.chbegin();
+            TypeDesc format  = datatype(subimage);
+            size_t pixelsize = nc * format.size();
+            char* pixel      = OIIO_ALLOCA(char, pixelsize);
+            convert_pixel_values(TypeFloat, &found->second[id.chbegin()],
+                                 format, pixel, nc);
+            char* d = (char*)data;
+            for (imagesize_t p = 0, e = lev.spec.tile_pixels(); p < e;
+                 ++p, d += pixelsize)
+                memcpy(d, pixel, pixelsize);
+            ++thread_info->m_stats.tiles_constant_synthesized;
+            return true;
+        }
+    }
+
     std::shared_ptr<ImageInput> inp = open(thread_info);
     if (!inp)
         return false;
@@ -837,10 +1236,34 @@ ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info,
 
     bool ok = true;
     const ImageSpec& spec(this->spec(subimage, miplevel));
+
+    // On a miss, the tiles to the right are likely to be wanted soon, too.
+    // If asked to, extend the read over the run of them that isn't cached
+    // yet, so that one read_tiles call (which the readers can decode in
+    // parallel) replaces several separate reads.
+    int ntiles = 1;
+    for (int ahead = imagecache().read_ahead_tiles(); ntiles < ahead;
+         ++ntiles) {
+        int nx = x + ntiles * spec.tile_width;
+        if (nx >= spec.x + spec.width
+            || imagecache().tile_in_cache(TileID(*this, subimage, miplevel,
+                                                 nx, y, z, chbegin, chend,
+                                                 id.colortransformid()),
+                                          thread_info))
+            break;
+    }
+    size_t pixelsize    = size_t(chend - chbegin) * format.size();
+    stride_t stripwidth = stride_t(ntiles) * spec.tile_width;
+    std::unique_ptr<char[]> strip;
+    if (ntiles > 1)
+        strip.reset(new char[stripwidth * pixelsize * spec.tile_height
+                             * spec.tile_depth]);
+    void* readbuf = ntiles > 1 ? strip.get() : data;
+
     for (int tries = 0; tries <= imagecache().failure_retries(); ++tries) {
-        ok = inp->read_tiles(subimage, miplevel, x, x + spec.tile_width, y,
+        ok = inp->read_tiles(subimage, miplevel, x, x + int(stripwidth), y,
                              y + spec.tile_height, z, z + spec.tile_depth,
-                             chbegin, chend, format, data);
+                             chbegin, chend, format, readbuf);
         if (ok) {
             if (tries)  // succeeded, but only after a failure!
                 ++thread_info->m_stats.tile_retry_success;
@@ -863,22 +1286,52 @@ ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info,
     }
 
     if (ok) {
-        size_t b = spec.tile_bytes();
+        size_t b = spec.tile_bytes() * ntiles;
         thread_info->m_stats.bytes_read += b;
         m_bytesread += b;
-        ++m_tilesread;
+        m_tilesread += ntiles;
         if (id.colortransformid() > 0) {
-            // print("CONVERT id {} {},{} to cs {}\n", filename(), id.x(), id.y(),
-            //       id.colortransformid());
-            ImageBuf wrapper(ImageSpec(spec.tile_width, spec.tile_height,
-                                       spec.nchannels, format),
-                             data);
-            ImageBufAlgo::colorconvert(
-                wrapper, wrapper,
-                ColorConfig::default_colorconfig().getColorSpaceNameByIndex(
-                    (id.colortransformid() >> 16) - 1),
-                m_imagecache.colorspace(), true, string_view(), string_view(),
-                nullptr, ROI(), 1);
+            // Convert the whole strip of tiles once, as it's read. The
+            // cache then holds a converted copy of each tile for this
+            // transform, and lookups never pay for the conversion.
+            Timer timer;
+            ColorProcessorHandle processor
+                = imagecache().colortransform_processor(id.colortransformid());
+            if (processor) {
+                ImageSpec wspec(int(stripwidth),
+                                spec.tile_height * spec.tile_depth,
+                                chend - chbegin, format);
+                wspec.alpha_channel = spec.alpha_channel >= chbegin
+                                              && spec.alpha_channel < chend
+                                          ? spec.alpha_channel - chbegin
+                                          : -1;
+                ImageBuf wrapper(wspec, readbuf);
+                ImageBufAlgo::colorconvert(wrapper, wrapper, processor.get(),
+                                           true, ROI(), 1);
+            }
+            thread_info->m_stats.tiles_colorconverted += ntiles;
+            thread_info->m_stats.colorconvert_time += timer();
+        }
+    }
+    if (ok && ntiles > 1) {
+        // The first tile of the strip is the one we were asked for; the
+        // rest go into the cache as tiles of their own.
+        stride_t ystride = stripwidth * pixelsize;
+        stride_t zstride = ystride * spec.tile_height;
+        copy_image(chend - chbegin, spec.tile_width, spec.tile_height,
+                   spec.tile_depth, strip.get(), pixelsize, pixelsize,
+                   ystride, zstride, data, pixelsize,
+                   pixelsize * spec.tile_width,
+                   pixelsize * spec.tile_width * spec.tile_height);
+        for (int i = 1; i < ntiles; ++i) {
+            TileID nid(*this, subimage, miplevel, x + i * spec.tile_width, y,
+                       z, chbegin, chend, id.colortransformid());
+            ImageCacheTileRef tile = new ImageCacheTile(
+                nid, strip.get() + i * spec.tile_width * pixelsize, format,
+                pixelsize, ystride, zstride);
+            if (tile->valid()
+                && imagecache().add_tile_to_cache(tile, thread_info))
+                ++thread_info->m_stats.tiles_read_ahead;
         }
     }
     return ok;
@@ -886,6 +1339,200 @@ ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info,
 
 
 
+const char*
+ImageCacheFile::map_tile(ImageCachePerThreadInfo* thread_info,
+                         const TileID& id,
+                         std::shared_ptr<Filesystem::IOMMapReader>& mapping)
+{
+    // Only tiles that the cache would hold byte-for-byte as stored: real
+    // (not emulated) tiles, all channels in the native data type, and no
+    // color conversion.
+    int subimage = id.subimage();
+    int miplevel = id.miplevel();
+    const SubimageInfo& subinfo(subimageinfo(subimage));
+    if (subinfo.untiled || (subinfo.unmipped && miplevel != 0)
+        || id.colortransformid() > 0)
+        return nullptr;
+    const ImageSpec& spec(this->spec(subimage, miplevel));
+    if (id.chbegin() != 0 || id.chend() != spec.nchannels
+        || spec.channelformats.size() || datatype(subimage) != spec.format)
+        return nullptr;
+
+    std::shared_ptr<ImageInput> inp = open(thread_info);
+    int64_t offset = 0, size = 0;
+    if (!inp
+        || !inp->native_tile_location(subimage, miplevel, id.x(), id.y(),
+                                      id.z(), offset, size))
+        return nullptr;
+
+    std::shared_ptr<Filesystem::IOMMapReader> map;
+    {
+        Timer input_mutex_timer;
+        recursive_timed_lock_guard guard(m_input_mutex);
+        m_mutex_wait_time += input_mutex_timer();
+        if (!m_mmap && !m_mmap_failed) {
+            m_mmap = std::make_shared<Filesystem::IOMMapReader>(m_filename);
+            if (!m_mmap->opened()) {
+                m_mmap.reset();
+                m_mmap_failed = true;
+            }
+        }
+        map = m_mmap;
+    }
+    // Lookups may SIMD-load a little past the last pixel, so that much of
+    // the mapping has to follow the tile, and the pixels must be aligned
+    // for their data type.
+    if (!map || size_t(size) != spec.tile_bytes()
+        || offset % int64_t(spec.format.size())
+        || size_t(offset + size) + OIIO_SIMD_MAX_SIZE_BYTES > map->size())
+        return nullptr;
+    mapping = std::move(map);
+    return (const char*)mapping->buffer().data() + offset;
+}
+
+
+
+bool
+ImageCacheFile::slab_tile(ImageCachePerThreadInfo* thread_info,
+                          const TileID& id, std::shared_ptr<char>& slab,
+                          const char*& pixels)
+{
+    // Only emulated tiles of autotiled scanline images. Leave them to
+    // read_untiled if there's a disk cache, which stores them one by one.
+    int subimage = id.subimage();
+    int miplevel = id.miplevel();
+    const SubimageInfo& subinfo(subimageinfo(subimage));
+    if (!subinfo.untiled || !subinfo.autotiled
+        || (subinfo.unmipped && miplevel != 0)
+        || imagecache().diskcache().enabled())
+        return false;
+    const ImageSpec& spec(this->spec(subimage, miplevel));
+    if (spec.depth > 1)
+        return false;  // FIXME(volume)
+
+    // The slab holds the row's tiles one after another, each laid out just
+    // as a tile of its own would be, plus padding so that SIMD loads of
+    // the last pixel don't run off the end.
+    const int tw = spec.tile_width, th = spec.tile_height;
+    const int ntiles       = (spec.width + tw - 1) / tw;
+    const int whichtile    = (id.x() - spec.x) / tw;
+    const TypeDesc format  = datatype(subimage);
+    const size_t pixelsize = size_t(id.nchannels()) * format.size();
+    const size_t tilebytes = size_t(tw) * th * pixelsize;
+    TileID rowid(*this, subimage, miplevel, spec.x, id.y(), id.z(),
+                 id.chbegin(), id.chend(), id.colortransformid());
+
+    // If the row is still in memory, because some of its tiles are, this
+    // tile can have its part of it back for free.
+    {
+        spin_lock lock(m_slabs_mutex);
+        if (m_slabs) {
+            auto found = m_slabs->find(rowid);
+            if (found != m_slabs->end() && (slab = found->second.lock())) {
+                pixels = slab.get() + whichtile * tilebytes;
+                ++thread_info->m_stats.tiles_from_slab;
+                return true;
+            }
+        }
+    }
+
+    pixels                          = nullptr;
+    std::shared_ptr<ImageInput> inp = open(thread_info);
+    if (!inp)
+        return true;
+    // The slab is charged to the cache in full for as long as any of its
+    // tiles is alive, since evicting some of them frees none of it. Each
+    // tile's part is charged to that tile's shard, so that every shard
+    // holding some of the row sweeps its tiles when it's over its share.
+    // The tiles themselves are charged nothing, like shared constant tiles.
+    ImageCacheImpl& ic(imagecache());
+    const bool colorconv = id.colortransformid() > 0;
+    std::vector<int> shards(ntiles);
+    for (int i = 0; i < ntiles; ++i)
+        shards[i] = ic.tile_shard(TileID(*this, subimage, miplevel,
+                                         spec.x + i * tw, id.y(), id.z(),
+                                         id.chbegin(), id.chend(),
+                                         id.colortransformid()));
+    const size_t slabbytes = ntiles * tilebytes + OIIO_SIMD_MAX_SIZE_BYTES;
+    for (int s : shards)
+        ic.incr_mem(tilebytes, s);
+    ic.incr_mem(OIIO_SIMD_MAX_SIZE_BYTES, shards[0]);
+    incr_tile_mem(slabbytes);
+    if (colorconv)
+        ic.incr_colorconvert_mem(slabbytes);
+    slab.reset(new char[slabbytes], [this, shards, tilebytes, slabbytes,
+                                     colorconv](char* p) {
+        delete[] p;
+        for (int s : shards)
+            imagecache().decr_mem(tilebytes, s);
+        imagecache().decr_mem(OIIO_SIMD_MAX_SIZE_BYTES, shards[0]);
+        incr_tile_mem(-(long long)slabbytes);
+        if (colorconv)
+            imagecache().incr_colorconvert_mem(-(long long)slabbytes);
+    });
+    memset(slab.get() + ntiles * tilebytes, 0, OIIO_SIMD_MAX_SIZE_BYTES);
+
+    // Read the whole tile row worth of scanlines. If it's only one tile
+    // wide, the scanlines are already laid out as the tile and can go
+    // right into the slab. Otherwise, each tile is copied out of them.
+    int y0 = id.y(), y1 = std::min(id.y() + th, spec.y + spec.height);
+    stride_t scanlinesize = stride_t(ntiles) * tw * pixelsize;
+    std::unique_ptr<char[]> band;
+    if (ntiles > 1)
+        band.reset(new char[scanlinesize * th]);
+    bool ok = inp->read_scanlines(subimage, miplevel, y0, y1, id.z(),
+                                  id.chbegin(), id.chend(), format,
+                                  band ? band.get() : slab.get(), pixelsize,
+                                  scanlinesize);
+    if (!ok) {
+        std::string err = inp->geterror();
+        if (!err.empty() && errors_should_issue())
+            imagecache().error("{}", err);
+        slab.reset();
+        return true;
+    }
+    size_t b = (y1 - y0) * spec.scanline_bytes();
+    thread_info->m_stats.bytes_read += b;
+    m_bytesread += b;
+    ++m_tilesread;
+    for (int i = 0; band && i < ntiles; ++i)
+        copy_image(id.nchannels(), tw, th, 1, &band[i * tw * pixelsize],
+                   pixelsize, pixelsize, scanlinesize, scanlinesize * th,
+                   slab.get() + i * tilebytes, pixelsize, pixelsize * tw,
+                   tilebytes);
+
+    {
+        spin_lock lock(m_slabs_mutex);
+        if (!m_slabs)
+            m_slabs.reset(new SlabMap);
+        // Now and then, forget the rows whose slabs are all gone
+        if (m_slabs->size() >= 64 && m_slabs->size() % 64 == 0) {
+            for (auto s = m_slabs->begin(); s != m_slabs->end();)
+                s = s->second.expired() ? m_slabs->erase(s) : std::next(s);
+        }
+        (*m_slabs)[rowid] = slab;
+    }
+
+    // The other tiles of the row go into the cache too, if not already
+    // present, on the assumption that they'll soon be wanted.
+    for (int i = 0; i < ntiles; ++i) {
+        if (i == whichtile)
+            continue;
+        TileID tid(*this, subimage, miplevel, spec.x + i * tw, id.y(), id.z(),
+                   id.chbegin(), id.chend(), id.colortransformid());
+        if (!imagecache().tile_in_cache(tid, thread_info)) {
+            ImageCacheTileRef tile = new ImageCacheTile(tid, slab,
+                                                        slab.get()
+                                                            + i * tilebytes);
+            (void)imagecache().add_tile_to_cache(tile, thread_info);
+        }
+    }
+    pixels = slab.get() + whichtile * tilebytes;
+    return true;
+}
+
+
+
 bool
 ImageCacheFile::read_unmipped(ImageCachePerThreadInfo* thread_info,
                               const TileID& id, void* data)
@@ -939,8 +1586,7 @@ ImageCacheFile::read_unmipped(ImageCachePerThreadInfo* thread_info,
     // tile after the pixels are read.  Well, except that below our call
     // to get_pixels may recursively trigger more tiles to be read, and
     // totally change the microcache.  Simple solution: save & restore it.
-    ImageCacheTileRef oldtile     = thread_info->tile;
-    ImageCacheTileRef oldlasttile = thread_info->lasttile;
+    ImageCacheTileRef oldtile = thread_info->tile;
 
     // Auto-mipping will totally thrash the cache if the user unwisely
     // sets it to be too small compared to the image file that needs to
@@ -979,8 +1625,7 @@ ImageCacheFile::read_unmipped(ImageCachePerThreadInfo* thread_info,
     lores.get_pixels(ROI(0, tw, 0, th, 0, 1, 0, nchans), format, data);
 
     // Restore the microcache to the way it was before.
-    thread_info->tile     = oldtile;
-    thread_info->lasttile = oldlasttile;
+    thread_info->tile = oldtile;
 
     return ok;
 }
@@ -1126,10 +1771,15 @@ ImageCacheFile::release()
         // pressure on the cache, it'll get freed next time around.
         return;
     }
-    if (m_used)
+    if (m_used) {
         m_used = false;
-    else if (m_allow_release)
+    } else if (auto fdproxy = std::atomic_load(&m_fdproxy)) {
+        // Just close the file descriptor, keeping the ImageInput and all
+        // its state. The next read from it will reopen the file.
+        fdproxy->detach();
+    } else if (m_allow_release) {
         close();
+    }
     m_input_mutex.unlock();
 }
 
@@ -1146,6 +1796,9 @@ ImageCacheFile::invalidate()
     mark_not_broken();
     m_fingerprint.clear();
     duplicate(NULL);
+    // Tiles still using the old mapping hold their own reference to it.
+    m_mmap.reset();
+    m_mmap_failed = false;
 
     m_filename = m_imagecache.resolve_filename(m_filename_original.string());
 
@@ -1153,6 +1806,10 @@ ImageCacheFile::invalidate()
     while (!imagecache().geterror().empty())
         ;
     m_errors_issued = 0;  // start error count fresh
+
+    // Last, now that the spec is cleared, retire all existing tiles of the
+    // file: lookups from here on are for the new generation.
+    ++m_generation;
 }
 
 
@@ -1310,7 +1967,8 @@ ImageCacheImpl::verify_file(ImageCacheFile* tf,
         recursive_timed_lock_guard guard(tf->m_input_mutex);
         tf->m_mutex_wait_time += input_mutex_timer();
         if (!tf->validspec()) {
-            tf->open(thread_info);
+            if (!tf->open_from_index(thread_info))
+                tf->open(thread_info);
             OIIO_DASSERT(tf->m_broken || tf->validspec());
             double createtime = timer();
             ImageCacheStatistics& stats(thread_info->m_stats);
@@ -1412,180 +2070,775 @@ ImageCacheImpl::check_max_files(ImageCachePerThreadInfo* /*thread_info*/)
         // Early out if we aren't exceeding the open file handle limit
         return;
     }
-    if (!m_max_open_files_strict || open_files < m_max_open_files + 16) {
-        // If we're only exceeding the open files limit by a little bit (or by
-        // any amount if we aren't trying to be strict about), try to grab the
-        // file_sweep_mutex lock. If we get it, we do the cleanup. But if
-        // somebody else holds it, just return rather than blocking, leaving
-        // the handle limit enforcement to whomever is already in this
-        // function or gets here next. No need for two threads to do it at
-        // once or to block. If this means we may ephemerally be over the
-        // handle limit, so be it.
-        if (!m_file_sweep_mutex.try_lock())
-            return;
-    } else {
-        // But if we're already quite a bit over the limit, we don't want to
-        // keep deferring, because if there are a large number of threads and
-        // a low max_open_files, we may go significantly over the limit if we
-        // are too quick to shirk our duty. So grab the lock unconditionally
-        // and do the work to close some of those handles.
-        m_file_sweep_mutex.lock();
-    }
 
     // Now, what we want to do is have a "clock hand" that sweeps across
-    // the cache, releasing files that haven't been used for a long
-    // time.  Because of multi-thread, rather than keep an iterator
-    // around for this (which could be invalidated since the last time
-    // we used it), we just remember the filename of the next file to
-    // check, then look it up fresh.  That is m_file_sweep_name.
-
-    // Get a (locked) iterator for the next tile to be examined.
-    FilenameMap::iterator sweep;
-    if (!m_file_sweep_name.empty()) {
-        // We saved the sweep_id. Find the iterator corresponding to it.
-        sweep = m_files.find(m_file_sweep_name);
-        // Note: if the sweep_id is no longer in the table, sweep will be an
-        // empty iterator. That's ok, it will be fixed early in the main
-        // loop below.
-    }
-
-
-    // Loop while we still have too many files open.  Also, be careful
-    // of looping for too long, exit the loop if we just keep spinning
-    // uncontrollably.
-    int full_loops = 0;
-    while (m_stat_open_files_current >= m_max_open_files && full_loops <= 100) {
-        // If we have fallen off the end of the cache, loop back to the
-        // beginning and increment our full_loops count.
-        if (!sweep) {
-            sweep = m_files.begin();
-            ++full_loops;
-        }
-        // If we're STILL at the end, it must be that somehow the entire
-        // cache is empty.  So just declare ourselves done.
-        if (!sweep)
-            break;
-        OIIO_DASSERT(sweep->second);
-        sweep->second->release();  // May reduce open files
-        ++sweep;
-        // Note: This loop is a lot less complicated than the one in
-        // ImageCacheImpl::check_max_mem. That's because for the file
-        // cache, we just need to release old ones, we don't actually
-        // erase entries from the cache, so there is no tricky lock/unlock,
-        // erasure, or invalidation of iterators.
+    // the cache, releasing files that haven't been used for a long time
+    // (which, for most files, just closes their descriptor). There's one
+    // hand per bin of the file map, and each sweeper claims a bin with its
+    // sweep lock, so there is no global lock: several threads over the
+    // limit at once each sweep a different bin. Because an iterator could
+    // be invalidated since the last time we used it, each hand is the
+    // filename of the next file to check, which we look up fresh.
+    //
+    // If we're only exceeding the open files limit by a little bit (or by
+    // any amount if we aren't trying to be strict about it), skip any bin
+    // that somebody else is already sweeping rather than block, leaving
+    // the enforcement to them. If this means we may ephemerally be over
+    // the handle limit, so be it. But if we're already quite a bit over
+    // the limit, we don't want to keep deferring, because if there are a
+    // large number of threads and a low max_open_files, we may go
+    // significantly over the limit if we are too quick to shirk our duty.
+    // So then wait for the bin's lock and do the work.
+    const bool wait = m_max_open_files_strict
+                      && open_files >= m_max_open_files + 16;
+    const unsigned int nbins = FilenameMap::nbins();
+    const unsigned int start = m_file_sweep_hint++;
+    for (unsigned int i = 0;
+         i < nbins && m_stat_open_files_current >= m_max_open_files; ++i) {
+        unsigned int b = (start + i) % nbins;
+        FileSweep& fs(m_file_sweeps[b]);
+        if (wait)
+            fs.sweep_mutex.lock();
+        else if (!fs.sweep_mutex.try_lock())
+            continue;
+        m_files.read_bin(b, [&](const FilenameMap::BinMap_t& bin) {
+            if (bin.empty())
+                return;
+            auto sweep = fs.sweep_name.empty() ? bin.end()
+                                               : bin.find(fs.sweep_name);
+            // Two full passes over the bin are enough to clear the
+            // "recently used" marks on everything and then release it.
+            size_t budget = 2 * bin.size() + 1;
+            while (m_stat_open_files_current >= m_max_open_files
+                   && budget-- > 0) {
+                // If we have fallen off the end of the bin, loop back to
+                // the beginning.
+                if (sweep == bin.end())
+                    sweep = bin.begin();
+                OIIO_DASSERT(sweep->second);
+                sweep->second->release();  // May reduce open files
+                ++sweep;
+            }
+            fs.sweep_name = (sweep == bin.end() ? ustring() : sweep->first);
+        });
+        fs.sweep_mutex.unlock();
     }
+}
+
+
+
+void
+ImageCacheImpl::set_min_cache_size(long long newsize)
+{
+    atomic_max(m_max_memory_bytes, newsize);
+}
+
+
 
-    // OK, by this point we have either closed enough files to be below
-    // the limit again, or the cache is empty, or we've looped over the
-    // cache too many times and are giving up.
+namespace {
+// Header that begins every file in the DiskTileCache. It is followed by
+// the key string and then the tile data.
+struct DiskTileHeader {
+    char magic[8];     // "OIIOTIL1"
+    uint32_t keylen;   // length of the key that follows
+    uint32_t pad;      // unused, zero
+    uint64_t datalen;  // length of the tile data following the key
+};
+static const char disktile_magic[8] = { 'O', 'I', 'I', 'O',
+                                        'T', 'I', 'L', '1' };
+}  // namespace
+
+
+
+bool
+DiskTileCache::init(string_view path, int64_t max_bytes, std::string& err)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_enabled = false;
+    m_path.clear();
+    m_lru.clear();
+    m_index.clear();
+    m_bytes_used = 0;
+    m_max_bytes  = max_bytes;
+    if (path.empty())
+        return true;
 
-    // Now we must save the filename for next time.  Just set it to an
-    // empty string if we don't have a valid iterator at this point.
-    m_file_sweep_name = (sweep ? sweep->first : ustring());
-    m_file_sweep_mutex.unlock();
+    std::string dir(path);
+    if (!Filesystem::is_directory(dir)
+        && !Filesystem::create_directory(dir, err))
+        return false;
 
-    // N.B. As we exit, the iterators will go out of scope and we will
-    // retain no locks on the cache.
+    // Index the tiles left by earlier processes, using their modification
+    // times (which we refresh whenever we read a tile) to order the LRU.
+    // Also clean up the temporary files of writers that died before
+    // renaming them into place. Another process sharing the directory may
+    // still be writing a recent one, so leave those alone.
+    std::vector<std::string> files;
+    if (!Filesystem::get_directory_entries(dir, files, true,
+                                           "\\.tile(\\..*\\.tmp)?$")) {
+        err = Strutil::fmt::format("Could not read directory \"{}\"", dir);
+        return false;
+    }
+    const std::time_t stale_tmp = std::time(nullptr) - 3600;
+    std::vector<std::pair<std::time_t, Entry>> found;
+    found.reserve(files.size());
+    for (auto& f : files) {
+        std::time_t mtime = Filesystem::last_write_time(f);
+        if (Strutil::ends_with(f, ".tmp")) {
+            if (mtime < stale_tmp)
+                Filesystem::remove(f);
+            continue;
+        }
+        found.push_back(
+            { mtime, Entry { f, int64_t(Filesystem::file_size(f)) } });
+    }
+    std::sort(found.begin(), found.end(),
+              [](const std::pair<std::time_t, Entry>& a,
+                 const std::pair<std::time_t, Entry>& b) {
+                  return a.first > b.first;
+              });
+    for (auto& f : found) {
+        m_lru.push_back(f.second);
+        m_index[f.second.name] = std::prev(m_lru.end());
+        m_bytes_used += f.second.size;
+    }
+    m_path    = dir;
+    m_enabled = true;
+    trim();
+    return true;
 }
 
 
 
 void
-ImageCacheImpl::set_min_cache_size(long long newsize)
+DiskTileCache::set_max_bytes(int64_t max_bytes)
 {
-    atomic_max(m_max_memory_bytes, newsize);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_max_bytes = max_bytes;
+    trim();
 }
 
 
 
-ImageCacheTile::ImageCacheTile(const TileID& id)
-    : m_id(id)
-    , m_valid(true)
+std::string
+DiskTileCache::path() const
 {
-    id.file().imagecache().incr_tiles(0);  // mem counted separately in read
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_path;
 }
 
 
 
-ImageCacheTile::ImageCacheTile(const TileID& id, const void* pels,
-                               TypeDesc format, stride_t xstride,
-                               stride_t ystride, stride_t zstride, bool copy)
-    : m_id(id)
+std::string
+DiskTileCache::tilename(string_view key) const
 {
-    ImageCacheFile& file(m_id.file());
-    const ImageSpec& spec(file.spec(id.subimage(), id.miplevel()));
-    m_channelsize = file.datatype(id.subimage()).size();
-    m_pixelsize   = id.nchannels() * m_channelsize;
-    m_tile_width  = spec.tile_width;
-    if (copy) {
-        size_t size = memsize_needed();
-        OIIO_ASSERT_MSG(size > 0 && memsize() == 0,
-                        "size was %llu, memsize = %llu",
-                        (unsigned long long)size,
-                        (unsigned long long)memsize());
-        m_pixels_size = size;
-        m_pixels.reset(new char[m_pixels_size]);
-        m_valid
-            = convert_image(id.nchannels(), spec.tile_width, spec.tile_height,
-                            spec.tile_depth, pels, format, xstride, ystride,
-                            zstride, &m_pixels[0], file.datatype(id.subimage()),
-                            m_pixelsize, m_pixelsize * spec.tile_width,
-                            m_pixelsize * spec.tile_width * spec.tile_height);
-    } else {
-        m_nofree      = true;  // Don't free the pointer!
-        m_pixels_size = 0;
-        m_pixels.reset((char*)pels);
-        m_valid = true;
-    }
-    id.file().imagecache().incr_tiles(m_pixels_size);
-    m_pixels_ready = true;  // Caller sent us the pixels, no read necessary
-    // FIXME -- for shadow, fill in mindepth, maxdepth
+    // Spread the tiles over 256 subdirectories so that none of them gets
+    // unwieldy.
+    uint64_t h = Strutil::strhash64(key.size(), key.data());
+    return Strutil::fmt::format("{}/{:02x}/{:016x}.tile", m_path,
+                                unsigned(h >> 56), h);
 }
 
 
 
-ImageCacheTile::~ImageCacheTile()
+void
+DiskTileCache::touch(const std::string& name, int64_t size)
 {
-    m_id.file().imagecache().decr_tiles(memsize());
-    if (m_nofree)
-        m_pixels.release();  // release without freeing
+    auto found = m_index.find(name);
+    if (found != m_index.end()) {
+        LRUList::iterator e = found->second;
+        m_bytes_used += size - e->size;
+        e->size = size;
+        m_lru.splice(m_lru.begin(), m_lru, e);
+    } else {
+        m_lru.push_front(Entry { name, size });
+        m_index[name] = m_lru.begin();
+        m_bytes_used += size;
+    }
 }
 
 
 
-size_t
-ImageCacheTile::memsize_needed() const
+void
+DiskTileCache::trim()
 {
-    const ImageSpec& spec(file().spec(m_id.subimage(), m_id.miplevel()));
-    size_t s = spec.tile_pixels() * pixelsize();
-    // N.B. Round up so we can use a SIMD fetch for the last pixel and
-    // channel without running off the end.
-    s += OIIO_SIMD_MAX_SIZE_BYTES;
-    return s;
+    while (m_bytes_used > m_max_bytes && !m_lru.empty()) {
+        Entry& e(m_lru.back());
+        Filesystem::remove(e.name);
+        m_bytes_used -= e.size;
+        m_index.erase(e.name);
+        m_lru.pop_back();
+        ++m_stat_evictions;
+    }
 }
 
 
 
 bool
-ImageCacheTile::read(ImageCachePerThreadInfo* thread_info)
+DiskTileCache::read(string_view key, void* data, size_t size)
 {
-    ImageCacheFile& file(m_id.file());
-    m_channelsize = file.datatype(id().subimage()).size();
-    m_pixelsize   = m_id.nchannels() * m_channelsize;
-    size_t size   = memsize_needed();
-    OIIO_ASSERT(memsize() == 0 && size > OIIO_SIMD_MAX_SIZE_BYTES);
-    m_pixels.reset(new char[m_pixels_size = size]);
-    // Clear the end pad values so there aren't NaNs sucked up by simd loads
-    memset(m_pixels.get() + size - OIIO_SIMD_MAX_SIZE_BYTES, 0,
-           OIIO_SIMD_MAX_SIZE_BYTES);
-    m_valid = file.read_tile(thread_info, m_id, &m_pixels[0]);
-    file.imagecache().incr_mem(size);
-    if (m_valid) {
-        ImageCacheFile::LevelInfo& lev(
-            file.levelinfo(m_id.subimage(), m_id.miplevel()));
-        m_tile_width = lev.spec.tile_width;
-        OIIO_DASSERT(m_tile_width > 0);
-        int whichtile = ((m_id.x() - lev.spec.x) / lev.spec.tile_width)
+    if (!enabled())
+        return false;
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_path.empty())
+            return false;
+        name = tilename(key);
+    }
+    FILE* file = Filesystem::fopen(name, "rb");
+    if (!file) {
+        ++m_stat_misses;
+        return false;
+    }
+    DiskTileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+              && !memcmp(header.magic, disktile_magic, sizeof(disktile_magic))
+              && header.keylen == key.size() && header.datalen == size;
+    if (ok) {
+        // The name is just a hash, so check that the full key matches.
+        std::string filekey(key.size(), '\0');
+        ok = fread(&filekey[0], 1, filekey.size(), file) == filekey.size()
+             && filekey == key;
+    }
+    if (ok)
+        ok = fread(data, 1, size, file) == size;
+    fclose(file);
+    if (!ok) {
+        ++m_stat_misses;
+        return false;
+    }
+    ++m_stat_hits;
+    m_stat_bytes_read += size;
+    // Record the use on disk, too, for the benefit of future processes.
+    Filesystem::last_write_time(name, std::time(nullptr));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    touch(name, int64_t(sizeof(header) + key.size() + size));
+    return true;
+}
+
+
+
+void
+DiskTileCache::write(string_view key, const void* data, size_t size)
+{
+    if (!enabled())
+        return;
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_path.empty())
+            return;
+        name = tilename(key);
+    }
+    std::string dir = Filesystem::parent_path(name);
+    if (!Filesystem::is_directory(dir))
+        Filesystem::create_directory(dir);
+
+    // Write to a temporary file and rename it into place, so that no
+    // reader (in this process or another) can see a partial tile.
+    std::string tmpname = Strutil::fmt::format("{}.{}.tmp", name,
+                                               Filesystem::unique_path());
+    FILE* file = Filesystem::fopen(tmpname, "wb");
+    if (!file)
+        return;
+    DiskTileHeader header;
+    memcpy(header.magic, disktile_magic, sizeof(disktile_magic));
+    header.keylen  = uint32_t(key.size());
+    header.pad     = 0;
+    header.datalen = size;
+    bool ok        = fwrite(&header, sizeof(header), 1, file) == 1
+              && fwrite(key.data(), 1, key.size(), file) == key.size()
+              && fwrite(data, 1, size, file) == size;
+    ok &= (fclose(file) == 0);
+    if (ok)
+        ok = Filesystem::rename(tmpname, name);
+    if (!ok) {
+        Filesystem::remove(tmpname);
+        return;
+    }
+    int64_t total = int64_t(sizeof(header) + key.size() + size);
+    ++m_stat_writes;
+    m_stat_bytes_written += total;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    touch(name, total);
+    trim();
+}
+
+
+
+// Build the DiskTileCache key for a tile. It must capture everything that
+// determines the tile's decoded pixels: the file contents (as identified
+// by its fingerprint if it has one, or else by its name and modification
+// time), which tile it is, and the cache settings that affect decoding.
+static std::string
+diskcache_key(const ImageCacheFile& file, const TileID& id)
+{
+    const ImageSpec& spec(file.spec(id.subimage(), id.miplevel()));
+    const ImageCacheImpl& ic(file.imagecache());
+    std::string filekey
+        = file.fingerprint().size()
+              ? Strutil::fmt::format("sha1:{}", file.fingerprint())
+              : Strutil::fmt::format("file:{}@{}", file.filename(),
+                                     int64_t(file.mod_time()));
+    return Strutil::fmt::format(
+        "{}|si={} mip={} xyz={},{},{} ch={}-{} tile={}x{}x{} type={} cs={}:{}"
+        " unassoc={}",
+        filekey, id.subimage(), id.miplevel(), id.x(), id.y(), id.z(),
+        id.chbegin(), id.chend(), spec.tile_width, spec.tile_height,
+        spec.tile_depth, file.datatype(id.subimage()), id.colortransformid(),
+        ic.colorspace(), int(ic.unassociatedalpha()));
+}
+
+
+
+namespace {
+// Header that begins every file in the HeaderIndex. It is followed by the
+// key string and then the serialized entry.
+struct HeaderIndexHeader {
+    char magic[8];     // "OIIOHDX3"
+    uint32_t keylen;   // length of the key that follows
+    uint32_t pad;      // unused, zero
+    uint64_t datalen;  // length of the entry data following the key
+    int64_t filesize;  // size of the image file when recorded
+    int64_t mtime;     // modification time (ns) of the image file then
+};
+static const char headerindex_magic[8] = { 'O', 'I', 'I', 'O',
+                                           'H', 'D', 'X', '3' };
+
+
+// Helpers to serialize a HeaderIndex::Entry into a byte string and back.
+// The entry is only ever read by the same build that wrote it (the
+// version is part of the key), so native byte order is fine for these;
+// the specs themselves use ImageSpec's own binary encoding.
+template<typename T>
+inline void
+put_pod(std::string& out, const T& val)
+{
+    out.append((const char*)&val, sizeof(T));
+}
+
+inline void
+put(std::string& out, string_view s)
+{
+    put_pod(out, uint32_t(s.size()));
+    out.append(s.data(), s.size());
+}
+
+template<typename T>
+inline bool
+get_pod(string_view& in, T& val)
+{
+    if (in.size() < sizeof(T))
+        return false;
+    memcpy(&val, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+
+inline bool
+get(string_view& in, std::string& s)
+{
+    uint32_t len = 0;
+    if (!get_pod(in, len) || in.size() < len)
+        return false;
+    s.assign(in.data(), len);
+    in.remove_prefix(len);
+    return true;
+}
+
+// Read a count of items, each of which takes at least minsize bytes of
+// what's left, so that a corrupted count can't make us allocate more than
+// the entry could possibly hold.
+inline bool
+get_count(string_view& in, uint32_t& n, size_t minsize)
+{
+    return get_pod(in, n) && n > 0 && n <= in.size() / minsize;
+}
+}  // namespace
+
+
+
+bool
+HeaderIndex::init(string_view path, std::string& err)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_enabled = false;
+    m_path.clear();
+    if (path.empty())
+        return true;
+    std::string dir(path);
+    if (!Filesystem::is_directory(dir)
+        && !Filesystem::create_directory(dir, err))
+        return false;
+    m_path    = dir;
+    m_enabled = true;
+    return true;
+}
+
+
+
+std::string
+HeaderIndex::path() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_path;
+}
+
+
+
+std::string
+HeaderIndex::entryname(string_view key) const
+{
+    // Spread the entries over 256 subdirectories, as for the DiskTileCache.
+    uint64_t h = Strutil::strhash64(key.size(), key.data());
+    return Strutil::fmt::format("{}/{:02x}/{:016x}.hdr", m_path,
+                                unsigned(h >> 56), h);
+}
+
+
+
+bool
+HeaderIndex::read(string_view key, int64_t size, int64_t mtime, Entry& entry)
+{
+    if (!enabled())
+        return false;
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_path.empty())
+            return false;
+        name = entryname(key);
+    }
+    FILE* file = Filesystem::fopen(name, "rb");
+    if (!file) {
+        ++m_stat_misses;
+        return false;
+    }
+    HeaderIndexHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+              && !memcmp(header.magic, headerindex_magic,
+                         sizeof(headerindex_magic))
+              && header.keylen == key.size() && header.filesize == size
+              && header.mtime == mtime;
+    std::string data;
+    if (ok) {
+        // The name is just a hash, so check that the full key matches.
+        std::string filekey(key.size(), '\0');
+        ok = fread(&filekey[0], 1, filekey.size(), file) == filekey.size()
+             && filekey == key;
+    }
+    if (ok) {
+        // Don't trust the recorded length beyond what the file holds; it
+        // may be truncated or corrupted.
+        int64_t pos = Filesystem::ftell(file);
+        int64_t end = Filesystem::fseek(file, 0, SEEK_END) == 0
+                          ? Filesystem::ftell(file)
+                          : -1;
+        ok = pos >= 0 && end >= pos && header.datalen == uint64_t(end - pos)
+             && Filesystem::fseek(file, pos, SEEK_SET) == 0;
+    }
+    if (ok) {
+        data.resize(header.datalen);
+        ok = fread(&data[0], 1, data.size(), file) == data.size();
+    }
+    fclose(file);
+
+    // Every subimage takes at least its 4 byte level count, and every
+    // level at least the 4 byte magic of its encoded spec.
+    string_view in(data);
+    uint32_t nsubimages = 0;
+    ok = ok && get(in, entry.format) && get(in, entry.fingerprint)
+         && get_count(in, nsubimages, 4);
+    if (ok) {
+        entry.specs.clear();
+        entry.specs.resize(nsubimages);
+        for (auto& levels : entry.specs) {
+            uint32_t nlevels = 0;
+            if (!(ok = get_count(in, nlevels, 4)))
+                break;
+            levels.resize(nlevels);
+            for (auto& spec : levels) {
+                size_t used = spec.from_binary(
+                    cspan<unsigned char>((const unsigned char*)in.data(),
+                                         in.size()));
+                if (!(ok = used > 0))
+                    break;
+                in.remove_prefix(used);
+            }
+            if (!ok)
+                break;
+        }
+    }
+    if (!ok) {
+        ++m_stat_misses;
+        return false;
+    }
+    ++m_stat_hits;
+    return true;
+}
+
+
+
+void
+HeaderIndex::write(string_view key, int64_t size, int64_t mtime,
+                   const Entry& entry)
+{
+    if (!enabled())
+        return;
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_path.empty())
+            return;
+        name = entryname(key);
+    }
+    std::string data;
+    put(data, string_view(entry.format));
+    put(data, string_view(entry.fingerprint));
+    put_pod(data, uint32_t(entry.specs.size()));
+    std::vector<unsigned char> specbuf;
+    for (auto& levels : entry.specs) {
+        put_pod(data, uint32_t(levels.size()));
+        for (auto& spec : levels) {
+            specbuf.clear();
+            spec.to_binary(specbuf);
+            data.append((const char*)specbuf.data(), specbuf.size());
+        }
+    }
+
+    std::string dir = Filesystem::parent_path(name);
+    if (!Filesystem::is_directory(dir))
+        Filesystem::create_directory(dir);
+    // Write to a temporary file and rename it into place, so that no
+    // reader (in this process or another) can see a partial entry.
+    std::string tmpname = Strutil::fmt::format("{}.{}.tmp", name,
+                                               Filesystem::unique_path());
+    FILE* file = Filesystem::fopen(tmpname, "wb");
+    if (!file)
+        return;
+    HeaderIndexHeader header;
+    memcpy(header.magic, headerindex_magic, sizeof(headerindex_magic));
+    header.keylen   = uint32_t(key.size());
+    header.pad      = 0;
+    header.datalen  = data.size();
+    header.filesize = size;
+    header.mtime    = mtime;
+    bool ok         = fwrite(&header, sizeof(header), 1, file) == 1
+              && fwrite(key.data(), 1, key.size(), file) == key.size()
+              && fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok &= (fclose(file) == 0);
+    if (ok)
+        ok = Filesystem::rename(tmpname, name);
+    if (!ok) {
+        Filesystem::remove(tmpname);
+        return;
+    }
+    ++m_stat_writes;
+}
+
+
+
+ImageCacheTile::ImageCacheTile(const TileID& id)
+    : m_id(id)
+    , m_valid(true)
+{
+    ImageCacheImpl& ic(id.file().imagecache());
+    m_shard = ic.tile_shard(id);
+    ic.incr_tiles(0, m_shard);  // mem counted separately in read
+}
+
+
+
+ImageCacheTile::ImageCacheTile(const TileID& id, const void* pels,
+                               TypeDesc format, stride_t xstride,
+                               stride_t ystride, stride_t zstride, bool copy)
+    : m_id(id)
+{
+    ImageCacheFile& file(m_id.file());
+    const ImageSpec& spec(file.spec(id.subimage(), id.miplevel()));
+    m_shard       = file.imagecache().tile_shard(id);
+    m_channelsize = file.datatype(id.subimage()).size();
+    m_pixelsize   = id.nchannels() * m_channelsize;
+    m_tile_width  = spec.tile_width;
+    if (copy) {
+        size_t size = memsize_needed();
+        OIIO_ASSERT_MSG(size > 0 && memsize() == 0,
+                        "size was %llu, memsize = %llu",
+                        (unsigned long long)size,
+                        (unsigned long long)memsize());
+        m_pixels_size = size;
+        m_pixels.reset(new char[m_pixels_size]);
+        m_valid
+            = convert_image(id.nchannels(), spec.tile_width, spec.tile_height,
+                            spec.tile_depth, pels, format, xstride, ystride,
+                            zstride, &m_pixels[0], file.datatype(id.subimage()),
+                            m_pixelsize, m_pixelsize * spec.tile_width,
+                            m_pixelsize * spec.tile_width * spec.tile_height);
+    } else {
+        m_nofree      = true;  // Don't free the pointer!
+        m_pixels_size = 0;
+        m_pixels.reset((char*)pels);
+        m_valid = true;
+    }
+    id.file().imagecache().incr_tiles(m_pixels_size, m_shard);
+    id.file().incr_tile_mem(m_pixels_size);
+    if (id.colortransformid() > 0)
+        id.file().imagecache().incr_colorconvert_mem(m_pixels_size);
+    m_read_claimed = true;
+    m_pixels_ready = true;  // Caller sent us the pixels, no read necessary
+    // FIXME -- for shadow, fill in mindepth, maxdepth
+}
+
+
+
+ImageCacheTile::ImageCacheTile(const TileID& id, std::shared_ptr<char> slab,
+                               const char* pels)
+    : m_id(id)
+    , m_slab(std::move(slab))
+{
+    ImageCacheFile& file(m_id.file());
+    const ImageSpec& spec(file.spec(id.subimage(), id.miplevel()));
+    m_shard       = file.imagecache().tile_shard(id);
+    m_channelsize = file.datatype(id.subimage()).size();
+    m_pixelsize   = id.nchannels() * m_channelsize;
+    m_tile_width  = spec.tile_width;
+    m_nofree      = true;  // The slab owns the pixels, and is charged
+    m_pixels.reset(const_cast<char*>(pels));
+    m_slab_share  = spec.tile_pixels() * m_pixelsize;
+    m_valid       = true;
+    file.imagecache().incr_tiles(m_pixels_size, m_shard);
+    file.incr_tile_mem(m_pixels_size);
+    if (id.colortransformid() > 0)
+        file.imagecache().incr_colorconvert_mem(m_pixels_size);
+    m_read_claimed = true;
+    m_pixels_ready = true;
+}
+
+
+
+ImageCacheTile::~ImageCacheTile()
+{
+    m_id.file().imagecache().decr_tiles(memsize(), m_shard);
+    m_id.file().incr_tile_mem(-(long long)memsize());
+    if (m_id.colortransformid() > 0)
+        m_id.file().imagecache().incr_colorconvert_mem(
+            -(long long)memsize());
+    if (m_nofree)
+        m_pixels.release();  // release without freeing
+}
+
+
+
+size_t
+ImageCacheTile::memsize_needed() const
+{
+    const ImageSpec& spec(file().spec(m_id.subimage(), m_id.miplevel()));
+    size_t s = spec.tile_pixels() * pixelsize();
+    // N.B. Round up so we can use a SIMD fetch for the last pixel and
+    // channel without running off the end.
+    s += OIIO_SIMD_MAX_SIZE_BYTES;
+    return s;
+}
+
+
+
+bool
+ImageCacheTile::read(ImageCachePerThreadInfo* thread_info)
+{
+    Timer timer;
+    ImageCacheFile& file(m_id.file());
+    m_channelsize = file.datatype(id().subimage()).size();
+    m_pixelsize   = m_id.nchannels() * m_channelsize;
+    OIIO_ASSERT(memsize() == 0);
+    size_t size = 0;
+    // A raw tile in a memory-mapped file is used right where it is, and
+    // costs the cache no memory.
+    const char* mapped = file.imagecache().mmap_tiles()
+                             ? file.map_tile(thread_info, m_id, m_mapping)
+                             : nullptr;
+    // An autotiled scanline image's tile is part of a slab holding its
+    // whole row of tiles, which it shares with its neighbors.
+    const char* inslab = nullptr;
+    if (mapped) {
+        m_nofree = true;  // The mapping owns the pixels
+        m_pixels.reset(const_cast<char*>(mapped));
+        m_valid = true;
+        ++thread_info->m_stats.tiles_mmapped;
+    } else if (file.slab_tile(thread_info, m_id, m_slab, inslab)) {
+        m_nofree = true;  // The slab owns the pixels, and is charged
+        m_pixels.reset(const_cast<char*>(inslab));
+        m_valid      = inslab != nullptr;
+        m_slab_share = m_valid ? memsize_needed() - OIIO_SIMD_MAX_SIZE_BYTES
+                               : 0;
+    } else {
+        size = memsize_needed();
+        OIIO_ASSERT(size > OIIO_SIMD_MAX_SIZE_BYTES);
+        char* pixels = nullptr;
+        if (file.imagecache().numa_local_tiles()) {
+            // Whole pages of its own let the tile live on the reading
+            // thread's NUMA node, whatever the allocator recycled.
+            const size_t page = 4096;
+            pixels = (char*)aligned_malloc(round_to_multiple(size, page), page);
+            if (pixels) {
+                m_pixels.get_deleter().aligned = true;
+                m_numa_node = short(Sysutil::current_numa_node());
+                Sysutil::numa_prefer_node(pixels,
+                                          round_to_multiple(size, page),
+                                          m_numa_node);
+            }
+        }
+        m_pixels.reset(pixels ? pixels : new char[size]);
+        m_pixels_size = size;
+        // Clear the end pad values so there aren't NaNs sucked up by simd
+        // loads
+        memset(m_pixels.get() + size - OIIO_SIMD_MAX_SIZE_BYTES, 0,
+               OIIO_SIMD_MAX_SIZE_BYTES);
+        // Look among the compressed cold tiles and then in the disk cache,
+        // if there is one, before reading from the file, and save what we
+        // read from the file for next time.
+        DiskTileCache& diskcache(file.imagecache().diskcache());
+        std::string diskkey;
+        size_t tilebytes = size - OIIO_SIMD_MAX_SIZE_BYTES;
+        m_valid = file.imagecache().uncompress_tile(m_id, m_shard,
+                                                    &m_pixels[0], tilebytes,
+                                                    thread_info);
+        if (!m_valid && diskcache.enabled()) {
+            diskkey = diskcache_key(file, m_id);
+            m_valid = diskcache.read(diskkey, &m_pixels[0], tilebytes);
+        }
+        if (!m_valid) {
+            m_valid = file.read_tile(thread_info, m_id, &m_pixels[0]);
+            if (m_valid && diskkey.size())
+                diskcache.write(diskkey, &m_pixels[0], tilebytes);
+        }
+        // A tile whose pixels are all the same trades its own copy for
+        // the cache's one shared block of that value. Comparing the
+        // buffer against itself shifted by one pixel checks every pixel.
+        if (m_valid && file.imagecache().share_constant_tiles()
+            && tilebytes > size_t(m_pixelsize)
+            && !memcmp(&m_pixels[0], &m_pixels[m_pixelsize],
+                       tilebytes - m_pixelsize)) {
+            m_shared_pixels = file.imagecache().shared_constant_tile(
+                &m_pixels[0], m_pixelsize, size, m_shard);
+            m_pixels.reset(const_cast<char*>(m_shared_pixels.get()));
+            m_nofree      = true;  // The shared block owns the pixels
+            m_numa_node   = -1;
+            m_pixels_size = 0;
+            size          = 0;
+            ++thread_info->m_stats.tiles_constant_shared;
+        }
+    }
+    file.imagecache().incr_mem(size, m_shard);
+    file.incr_tile_mem(size);
+    if (m_id.colortransformid() > 0)
+        file.imagecache().incr_colorconvert_mem(size);
+    if (m_valid) {
+        ImageCacheFile::LevelInfo& lev(
+            file.levelinfo(m_id.subimage(), m_id.miplevel()));
+        m_tile_width = lev.spec.tile_width;
+        OIIO_DASSERT(m_tile_width > 0);
+        int whichtile = ((m_id.x() - lev.spec.x) / lev.spec.tile_width)
                         + ((m_id.y() - lev.spec.y) / lev.spec.tile_height)
                               * lev.nxtiles
                         + ((m_id.z() - lev.spec.z) / lev.spec.tile_depth)
@@ -1615,6 +2868,7 @@ ImageCacheTile::read(ImageCachePerThreadInfo* thread_info)
 #endif
     }
     m_pixels_ready = true;
+    file.imagecache().trace_tile(thread_info, m_id, false, float(timer()));
     // FIXME -- for shadow, fill in mindepth, maxdepth
     return m_valid;
 }
@@ -1684,6 +2938,11 @@ ImageCacheImpl::init()
     m_autoscanline         = false;
     m_automip              = false;
     m_forcefloat           = false;
+    m_mmap_tiles           = false;
+    m_read_ahead_tiles     = 0;
+    m_microcache_size      = 16;
+    m_numa_local_tiles     = false;
+    m_share_constant_tiles = false;
     m_accept_untiled       = true;
     m_accept_unmipped      = true;
     m_deduplicate          = true;
@@ -1693,6 +2952,8 @@ ImageCacheImpl::init()
     m_Mw2c.makeIdentity();
     m_colorspace              = ustring("scene_linear");
     m_mem_used                = 0;
+    m_max_compressed_bytes    = 0;
+    m_compressed_mem          = 0;
     m_statslevel              = 0;
     m_max_errors_per_file     = 100;
     m_stat_tiles_created      = 0;
@@ -1701,6 +2962,9 @@ ImageCacheImpl::init()
     m_stat_open_files_created = 0;
     m_stat_open_files_current = 0;
     m_stat_open_files_peak    = 0;
+    m_stat_prefetch_tiles     = 0;
+    m_stat_prefetch_reads     = 0;
+    m_prefetch_pending        = 0;
     m_max_open_files_strict   = false;
 
     // Allow environment variable to override default options
@@ -1713,6 +2977,8 @@ ImageCacheImpl::init()
 
 ImageCacheImpl::~ImageCacheImpl()
 {
+    // Don't pull the rug out from under any prefetch still in flight.
+    wait_for_prefetches();
     printstats();
     // All the per_thread_infos get destroyed here, regardless of if they were created implicitly
     // or manually by the caller
@@ -1826,6 +3092,19 @@ ImageCacheImpl::onefile_stat_line(const ImageCacheFileRef& file, int i,
 
 
 
+void
+ImageCacheImpl::shard_evictions(int shard, long long& tiles,
+                                long long& sweeps, double& time) const
+{
+    const TileShard& sh(m_tile_shards[shard]);
+    spin_lock lock(sh.sweep_mutex);
+    tiles  = sh.tiles_evicted;
+    sweeps = sh.sweeps;
+    time   = sh.evict_time;
+}
+
+
+
 std::string
 ImageCacheImpl::getstats(int level) const
 {
@@ -1898,15 +3177,28 @@ ImageCacheImpl::getstats(int level) const
     opt += Strutil::fmt::format(#name "=\"{}\" ", m_##name)
         opt += Strutil::fmt::format("max_memory_MB={:0.1f} ",
                                     m_max_memory_bytes / (1024.0 * 1024.0));
+        if (m_max_compressed_bytes)
+            opt += Strutil::fmt::format("max_compressed_memory_MB={:0.1f} ",
+                                        m_max_compressed_bytes
+                                            / (1024.0 * 1024.0));
         INTOPT(max_open_files);
         BOOLOPT(max_open_files_strict);
         INTOPT(autotile);
         INTOPT(autoscanline);
         INTOPT(automip);
         INTOPT(forcefloat);
+        BOOLOPT(mmap_tiles);
+        BOOLOPT(io_uring);
+        BOOLOPT(numa_local_tiles);
+        BOOLOPT(share_constant_tiles);
+        if (m_read_ahead_tiles > 1)
+            INTOPT(read_ahead_tiles);
+        if (m_microcache_size != 16)
+            INTOPT(microcache_size);
         INTOPT(accept_untiled);
         INTOPT(accept_unmipped);
         INTOPT(deduplicate);
+        BOOLOPT(fingerprint_files);
         INTOPT(unassociatedalpha);
         INTOPT(failure_retries);
         opt += Strutil::fmt::format("openexr:core={} ",
@@ -1921,6 +3213,11 @@ ImageCacheImpl::getstats(int level) const
             print(out, "    ImageInputs : {} created, {} current, {} peak\n",
                   int(m_stat_open_files_created),
                   int(m_stat_open_files_current), int(m_stat_open_files_peak));
+            if (m_stat_fds_detached)
+                print(out,
+                      "    Idle file handles closed : {}, reopened : {}\n",
+                      m_stat_fds_detached.load(),
+                      m_stat_fds_reattached.load());
             print(out,
                   "    Total pixel data size of all images referenced : {}\n",
                   Strutil::memformat(stats.files_totalsize));
@@ -1968,6 +3265,15 @@ ImageCacheImpl::getstats(int level) const
                       stats.find_tile_microcache_misses,
                       100.0 * stats.find_tile_microcache_misses
                           / (double)stats.find_tile_calls);
+            if (stats.find_tile_calls)
+                print(out,
+                      "    micro-cache hit rate : {:.1f}% ({} hits past the "
+                      "last tile, {} entries per thread)\n",
+                      100.0
+                          * (stats.find_tile_calls
+                             - stats.find_tile_microcache_misses)
+                          / (double)stats.find_tile_calls,
+                      stats.find_tile_microcache_hits, m_microcache_size);
             if (stats.find_tile_cache_misses)
                 print(out, "    main cache misses : {} ({:.1f}%)\n",
                       stats.find_tile_cache_misses,
@@ -1985,6 +3291,103 @@ ImageCacheImpl::getstats(int level) const
         if (stats.find_tile_time > 0.001 || level > 2)
             print(out, "    Find tile time : {}\n",
                   Strutil::timeintervalformat(stats.find_tile_time));
+        if (m_stat_prefetch_tiles || level > 2)
+            print(out, "    Prefetched tiles : {} queued, {} read by pool\n",
+                  int(m_stat_prefetch_tiles), int(m_stat_prefetch_reads));
+        if (m_numa_local_tiles || level > 2) {
+            long long hits = stats.numa_local_hits + stats.numa_remote_hits;
+            print(out,
+                  "    NUMA tile hits ({} nodes) : {} local, {} remote "
+                  "({:.1f}%)\n",
+                  Sysutil::numa_nodes(), stats.numa_local_hits,
+                  stats.numa_remote_hits,
+                  hits ? 100.0 * stats.numa_remote_hits / hits : 0.0);
+        }
+        if (stats.tiles_read_ahead || level > 2)
+            print(out, "    Tiles read ahead of being needed : {}\n",
+                  stats.tiles_read_ahead);
+        if (stats.tiles_from_slab || level > 2)
+            print(out, "    Autotiles reused from decoded slabs : {}\n",
+                  stats.tiles_from_slab);
+        if (stats.tiles_mmapped || level > 2)
+            print(out, "    Tiles used in place from mapped files : {}\n",
+                  stats.tiles_mmapped);
+        if (stats.tiles_constant_shared || level > 2)
+            print(out, "    Constant tiles sharing pixels : {}\n",
+                  stats.tiles_constant_shared);
+        if (stats.tiles_constant_synthesized || level > 2)
+            print(out, "    Constant tiles made without reading : {}\n",
+                  stats.tiles_constant_synthesized);
+        if (stats.tiles_compressed || level > 2) {
+            print(out,
+                  "    Compressed cold tiles : {} compressed ({:.1f}:1), "
+                  "{} restored, {} now held\n",
+                  stats.tiles_compressed,
+                  stats.compress_bytes_out
+                      ? double(stats.compress_bytes_in)
+                            / double(stats.compress_bytes_out)
+                      : 0.0,
+                  stats.tiles_uncompressed,
+                  Strutil::memformat(m_compressed_mem));
+            print(out, "        compress time {}, uncompress time {}\n",
+                  Strutil::timeintervalformat(stats.compress_time),
+                  Strutil::timeintervalformat(stats.uncompress_time));
+        }
+        if (stats.tiles_colorconverted || level > 2)
+            print(out,
+                  "    Color converted tiles : {} converted as read, {} "
+                  "now held, conversion time {}\n",
+                  stats.tiles_colorconverted,
+                  Strutil::memformat(m_colorconvert_mem),
+                  Strutil::timeintervalformat(stats.colorconvert_time));
+        if (m_diskcache.enabled()) {
+            print(out, "    Disk tile cache : \"{}\", {} used of {}\n",
+                  m_diskcache.path(),
+                  Strutil::memformat(m_diskcache.bytes_used()),
+                  Strutil::memformat(m_diskcache.max_bytes()));
+            print(out,
+                  "        {} hits ({} read), {} misses, {} written, "
+                  "{} trimmed\n",
+                  m_diskcache.m_stat_hits.load(),
+                  Strutil::memformat(m_diskcache.m_stat_bytes_read),
+                  m_diskcache.m_stat_misses.load(),
+                  m_diskcache.m_stat_writes.load(),
+                  m_diskcache.m_stat_evictions.load());
+        }
+        if (m_headerindex.enabled())
+            print(out,
+                  "    Header index : \"{}\", {} hits, {} misses, "
+                  "{} written\n",
+                  m_headerindex.path(), m_headerindex.m_stat_hits.load(),
+                  m_headerindex.m_stat_misses.load(),
+                  m_headerindex.m_stat_writes.load());
+        {
+            long long evicted = 0, sweeps = 0;
+            double evict_time = 0.0, max_shard_time = 0.0;
+            long long shard_tiles[TILE_CACHE_SHARDS], shard_sweeps;
+            double shard_time[TILE_CACHE_SHARDS];
+            for (int s = 0; s < TILE_CACHE_SHARDS; ++s) {
+                shard_evictions(s, shard_tiles[s], shard_sweeps,
+                                shard_time[s]);
+                evicted += shard_tiles[s];
+                sweeps += shard_sweeps;
+                evict_time += shard_time[s];
+                max_shard_time = std::max(max_shard_time, shard_time[s]);
+            }
+            if (evicted || level > 2)
+                print(out,
+                      "    Tiles evicted : {} in {} sweeps, {} "
+                      "(max {} in one shard)\n",
+                      evicted, sweeps, Strutil::timeintervalformat(evict_time),
+                      Strutil::timeintervalformat(max_shard_time));
+            if (evicted && level > 3) {
+                for (int s = 0; s < TILE_CACHE_SHARDS; ++s)
+                    if (shard_tiles[s])
+                        print(out, "        shard {:3}: {:8} tiles, {}\n", s,
+                              shard_tiles[s],
+                              Strutil::timeintervalformat(shard_time[s]));
+            }
+        }
         if (stats.file_retry_success || stats.tile_retry_success)
             print(out,
                   "    Failure reads followed by unexplained success:"
@@ -2105,6 +3508,30 @@ ImageCacheImpl::getstats(int level) const
                 }
             }
         }
+        if (level > 2) {
+            // Only kept by a TextureSystem whose statistics:level is >= 3
+            std::sort(files.begin(), files.end(), texturetime_compare);
+            int nprinted = 0;
+            for (const ImageCacheFileRef& file : files) {
+                if (!file->texture_queries())
+                    continue;
+                if (nprinted++ == 0)
+                    print(out, "  Textures by lookup time (time, queries, "
+                               "probes per query, hits per MIP level):\n");
+                print(out, "    {:3} {:9} {:9} {:8.2f}  [", nprinted,
+                      Strutil::timeintervalformat(file->texture_time()),
+                      file->texture_queries(),
+                      double(file->texture_probes())
+                          / double(file->texture_queries()));
+                int nmip = ImageCacheFile::texture_mip_counters;
+                while (nmip > 1 && !file->texture_mip_hits(nmip - 1))
+                    --nmip;
+                for (int m = 0; m < nmip; ++m)
+                    print(out, "{}{}", (m ? "," : ""),
+                          file->texture_mip_hits(m));
+                print(out, "]  {}\n", file->filename());
+            }
+        }
         int nbroken = 0;
         for (const ImageCacheFileRef& file : files) {
             if (file->broken())
@@ -2144,8 +3571,11 @@ ImageCacheImpl::reset_stats()
     {
         spin_lock lock(m_perthread_info_mutex);
         for (size_t i = 0; i < m_all_perthread_info.size(); ++i)
-            if (m_all_perthread_info[i])
+            if (m_all_perthread_info[i]) {
                 m_all_perthread_info[i]->m_stats.init();
+                spin_lock tlock(m_all_perthread_info[i]->m_trace_mutex);
+                m_all_perthread_info[i]->m_trace_count = 0;
+            }
     }
 
     {
@@ -2156,8 +3586,108 @@ ImageCacheImpl::reset_stats()
             file->m_tilesread   = 0;
             file->m_bytesread   = 0;
             file->m_iotime      = 0;
+            file->m_texture_queries     = 0;
+            file->m_texture_probes      = 0;
+            file->m_texture_nanoseconds = 0;
+            for (auto& hits : file->m_texture_mip_hits)
+                hits = 0;
         }
     }
+
+    for (auto& sh : m_tile_shards) {
+        spin_lock lock(sh.sweep_mutex);
+        sh.tiles_evicted = 0;
+        sh.sweeps        = 0;
+        sh.evict_time    = 0.0;
+    }
+}
+
+
+
+void
+ImageCacheImpl::record_tile_trace(ImageCachePerThreadInfo* thread_info,
+                                  const TileID& id, bool hit, float latency)
+{
+    if (!thread_info)
+        return;
+    size_t len = size_t(m_trace_tiles.load());
+    spin_lock lock(thread_info->m_trace_mutex);
+    auto& trace(thread_info->m_trace);
+    if (trace.size() != len) {
+        // First record since tracing was turned on or resized
+        trace.assign(len, TileTraceRecord());
+        thread_info->m_trace_count = 0;
+    }
+    if (!len)
+        return;
+    TileTraceRecord& r(trace[thread_info->m_trace_count++ % len]);
+    r.time     = m_trace_timer();
+    r.file     = &id.file();
+    r.latency  = latency;
+    r.x        = id.x();
+    r.y        = id.y();
+    r.z        = id.z();
+    r.subimage = short(id.subimage());
+    r.miplevel = short(id.miplevel());
+    r.hit      = hit;
+}
+
+
+
+bool
+ImageCacheImpl::write_tile_trace(string_view filename) const
+{
+    // Gather every thread's records, oldest first, and merge them by time.
+    std::vector<TileTraceRecord> records;
+    {
+        spin_lock lock(m_perthread_info_mutex);
+        for (auto& p : m_all_perthread_info) {
+            if (!p)
+                continue;
+            spin_lock tlock(p->m_trace_mutex);
+            size_t len   = p->m_trace.size();
+            size_t count = std::min(p->m_trace_count, len);
+            size_t first = p->m_trace_count - count;
+            for (size_t i = 0; i < count; ++i)
+                records.push_back(p->m_trace[(first + i) % len]);
+        }
+    }
+    std::stable_sort(records.begin(), records.end(),
+                     [](const TileTraceRecord& a, const TileTraceRecord& b) {
+                         return a.time < b.time;
+                     });
+
+    // Files are listed once and referred to by index.
+    tsl::robin_map<const ImageCacheFile*, size_t> fileindex;
+    std::vector<const ImageCacheFile*> files;
+    for (auto& r : records)
+        if (fileindex.emplace(r.file, files.size()).second)
+            files.push_back(r.file);
+
+    std::ostringstream out;
+    out.imbue(std::locale::classic());  // Force "C" locale with '.' decimal
+    out << "{\n  \"files\": [";
+    for (size_t f = 0; f < files.size(); ++f)
+        out << (f ? ",\n    \"" : "\n    \"")
+            << Strutil::escape_chars(files[f]->filename()) << '"';
+    out << "\n  ],\n  \"fields\": [\"time\", \"file\", \"subimage\", "
+           "\"miplevel\", \"x\", \"y\", \"z\", \"hit\", \"latency\"],\n"
+           "  \"records\": [";
+    for (size_t i = 0; i < records.size(); ++i) {
+        const TileTraceRecord& r(records[i]);
+        out << (i ? ",\n    " : "\n    ")
+            << Strutil::fmt::format("[{:.6f}, {}, {}, {}, {}, {}, {}, {}, "
+                                    "{:g}]",
+                                    r.time, fileindex[r.file], r.subimage,
+                                    r.miplevel, r.x, r.y, r.z, int(r.hit),
+                                    r.latency);
+    }
+    out << "\n  ]\n}\n";
+    if (!Filesystem::write_text_file(filename, out.str())) {
+        error("Could not write tile trace to \"{}\"", filename);
+        return false;
+    }
+    return true;
 }
 
 
@@ -2188,6 +3718,14 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
         size = std::max(size, 1.0f);  // But let developers debugging do it
 #endif
         m_max_memory_bytes = (long long)(size * (long long)(1024 * 1024));
+    } else if (name == "max_compressed_memory_MB"
+               && (type == TypeDesc::FLOAT || type == TypeDesc::INT)) {
+        float size = type == TypeDesc::FLOAT ? *(const float*)val
+                                             : float(*(const int*)val);
+        m_max_compressed_bytes = (long long)(std::max(size, 0.0f)
+                                             * (long long)(1024 * 1024));
+        if (!m_max_compressed_bytes)
+            drop_compressed_tiles(nullptr);
     } else if (name == "searchpath" && type == TypeDesc::STRING) {
         std::string s = std::string(*(const char**)val);
         if (s != m_searchpath) {
@@ -2245,12 +3783,45 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
             m_accept_unmipped = a;
             do_invalidate     = true;
         }
+    } else if (name == "trace_tiles" && type == TypeDesc::INT) {
+        m_trace_timer.reset();
+        m_trace_timer.start();
+        m_trace_tiles = std::max(*(const int*)val, 0);
+    } else if (name == "numa_local_tiles" && type == TypeDesc::INT) {
+        m_numa_local_tiles = (*(const int*)val != 0);
+    } else if (name == "read_ahead_tiles" && type == TypeDesc::INT) {
+        m_read_ahead_tiles = clamp(*(const int*)val, 0, 64);
+    } else if (name == "microcache_size" && type == TypeDesc::INT) {
+        int size = clamp(*(const int*)val, 0, 1024);
+        if (size != m_microcache_size) {
+            m_microcache_size = size;
+            purge_perthread_microcaches();  // resized on their next use
+        }
+    } else if (name == "mmap_tiles" && type == TypeDesc::INT) {
+        m_mmap_tiles = (*(const int*)val != 0);
+    } else if (name == "share_constant_tiles" && type == TypeDesc::INT) {
+        m_share_constant_tiles = (*(const int*)val != 0);
+    } else if (name == "io_uring" && type == TypeDesc::INT) {
+        m_io_uring = (*(const int*)val != 0);
+        std::shared_ptr<Filesystem::IOUring> ring;
+        if (m_io_uring) {
+            ring = std::make_shared<Filesystem::IOUring>(256);
+            if (!ring->valid())
+                ring.reset();  // not supported here, so don't bother
+        }
+        std::atomic_store(&m_io_uring_ring, ring);
     } else if (name == "deduplicate" && type == TypeDesc::INT) {
         bool r = (*(const int*)val != 0);
         if (r != m_deduplicate) {
             m_deduplicate = r;
             do_invalidate = true;
         }
+    } else if (name == "fingerprint_files" && type == TypeDesc::INT) {
+        bool r = (*(const int*)val != 0);
+        if (r != m_fingerprint_files) {
+            m_fingerprint_files = r;
+            do_invalidate       = true;
+        }
     } else if (name == "unassociatedalpha" && type == TypeDesc::INT) {
         bool r = (*(const int*)val != 0);
         if (r != m_unassociatedalpha) {
@@ -2290,6 +3861,32 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
     } else if (name == "max_mip_res" && type == TypeInt) {
         m_max_mip_res = *(const int*)val;
         do_invalidate = true;
+    } else if (name == "diskcache:path" && type == TypeDesc::STRING) {
+        string_view path(*(const char**)val);
+        if (path != m_diskcache.path()) {
+            std::string err;
+            if (!m_diskcache.init(path, m_diskcache.max_bytes(), err)) {
+                error("Could not use \"{}\" for the disk tile cache: {}",
+                      path, err);
+                return false;
+            }
+        }
+    } else if (name == "diskcache:size" && type == TypeDesc::FLOAT) {
+        float size = std::max(*(const float*)val, 0.0f);
+        m_diskcache.set_max_bytes(int64_t(double(size) * (1024 * 1024)));
+    } else if (name == "diskcache:size" && type == TypeDesc::INT) {
+        int size = std::max(*(const int*)val, 0);
+        m_diskcache.set_max_bytes(int64_t(size) * (1024 * 1024));
+    } else if (name == "headerindex:path" && type == TypeDesc::STRING) {
+        string_view path(*(const char**)val);
+        if (path != m_headerindex.path()) {
+            std::string err;
+            if (!m_headerindex.init(path, err)) {
+                error("Could not use \"{}\" for the header index: {}", path,
+                      err);
+                return false;
+            }
+        }
     } else {
         // Otherwise, unknown name
         return false;
@@ -2308,6 +3905,7 @@ ImageCacheImpl::getattributetype(string_view name) const
     static std::unordered_map<std::string, TypeDesc> attr_types {
         { "max_open_files", TypeInt },
         { "max_memory_MB", TypeFloat },
+        { "max_compressed_memory_MB", TypeFloat },
         { "statistics:level", TypeInt },
         { "max_errors_per_file", TypeInt },
         { "autotile", TypeInt },
@@ -2316,7 +3914,15 @@ ImageCacheImpl::getattributetype(string_view name) const
         { "forcefloat", TypeInt },
         { "accept_untiled", TypeInt },
         { "accept_unmipped", TypeInt },
+        { "mmap_tiles", TypeInt },
+        { "io_uring", TypeInt },
+        { "read_ahead_tiles", TypeInt },
+        { "microcache_size", TypeInt },
+        { "numa_local_tiles", TypeInt },
+        { "share_constant_tiles", TypeInt },
+        { "trace_tiles", TypeInt },
         { "deduplicate", TypeInt },
+        { "fingerprint_files", TypeInt },
         { "unassociatedalpha", TypeInt },
         { "trust_file_extensions", TypeInt },
         { "failure_retries", TypeInt },
@@ -2328,15 +3934,33 @@ ImageCacheImpl::getattributetype(string_view name) const
         { "commontoworld", TypeMatrix },
         { "latlong_up", TypeString },
         { "substitute_image", TypeString },
+        { "diskcache:path", TypeString },
+        { "diskcache:size", TypeFloat },
+        { "headerindex:path", TypeString },
         { "stat:cache_memory_used", TypeInt64 },
+        { "stat:compressed_memory_used", TypeInt64 },
+        { "stat:colorconvert_memory_used", TypeInt64 },
+        { "stat:tiles_colorconverted", TypeInt64 },
+        { "stat:tiles_mmapped", TypeInt64 },
+        { "stat:tiles_constant_shared", TypeInt64 },
+        { "stat:tiles_constant_synthesized", TypeInt64 },
+        { "stat:tiles_read_ahead", TypeInt64 },
+        { "stat:tiles_from_slab", TypeInt64 },
+        { "stat:numa_local_hits", TypeInt64 },
+        { "stat:numa_remote_hits", TypeInt64 },
+        { "stat:tiles_compressed", TypeInt64 },
+        { "stat:tiles_uncompressed", TypeInt64 },
         { "stat:tiles_created", TypeInt },
         { "stat:tiles_current", TypeInt },
         { "stat:tiles_peak", TypeInt },
         { "stat:open_files_created", TypeInt },
         { "stat:open_files_current", TypeInt },
         { "stat:open_files_peak", TypeInt },
+        { "stat:fds_detached", TypeInt64 },
+        { "stat:fds_reattached", TypeInt64 },
         { "stat:find_tile_calls", TypeInt64 },
         { "stat:find_tile_microcache_misses", TypeInt64 },
+        { "stat:find_tile_microcache_hits", TypeInt64 },
         { "stat:find_tile_cache_misses", TypeInt },
         { "stat:files_totalsize", TypeInt64 },
         { "stat:image_size", TypeInt64 },
@@ -2349,6 +3973,21 @@ ImageCacheImpl::getattributetype(string_view name) const
         { "stat:tile_locking_time", TypeFloat },
         { "stat:find_file_time", TypeFloat },
         { "stat:find_tile_time", TypeFloat },
+        { "stat:prefetch_tiles", TypeInt },
+        { "stat:prefetch_reads", TypeInt },
+        { "stat:tiles_evicted", TypeInt64 },
+        { "stat:diskcache_hits", TypeInt64 },
+        { "stat:diskcache_misses", TypeInt64 },
+        { "stat:diskcache_writes", TypeInt64 },
+        { "stat:diskcache_evictions", TypeInt64 },
+        { "stat:diskcache_bytes_read", TypeInt64 },
+        { "stat:diskcache_bytes_used", TypeInt64 },
+        { "stat:headerindex_hits", TypeInt64 },
+        { "stat:headerindex_misses", TypeInt64 },
+        { "stat:headerindex_writes", TypeInt64 },
+        { "stat:eviction_time", TypeFloat },
+        { "stat:shard_eviction_time",
+          TypeDesc(TypeDesc::FLOAT, TILE_CACHE_SHARDS) },
         { "stat:texture_queries", TypeInt64 },
         { "stat:texture3d_queries", TypeInt64 },
         { "stat:environment_queries", TypeInt64 },
@@ -2386,6 +4025,10 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
     ATTR_DECODE("max_open_files", int, m_max_open_files);
     ATTR_DECODE("max_memory_MB", float, m_max_memory_bytes / (1024.0 * 1024.0));
     ATTR_DECODE("max_memory_MB", int, m_max_memory_bytes / (1024 * 1024));
+    ATTR_DECODE("max_compressed_memory_MB", float,
+                m_max_compressed_bytes / (1024.0 * 1024.0));
+    ATTR_DECODE("max_compressed_memory_MB", int,
+                m_max_compressed_bytes / (1024 * 1024));
     ATTR_DECODE("statistics:level", int, m_statslevel);
     ATTR_DECODE("max_errors_per_file", int, m_max_errors_per_file);
     ATTR_DECODE("autotile", int, m_autotile);
@@ -2394,7 +4037,15 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
     ATTR_DECODE("forcefloat", int, m_forcefloat);
     ATTR_DECODE("accept_untiled", int, m_accept_untiled);
     ATTR_DECODE("accept_unmipped", int, m_accept_unmipped);
+    ATTR_DECODE("mmap_tiles", int, m_mmap_tiles);
+    ATTR_DECODE("io_uring", int, m_io_uring);
+    ATTR_DECODE("read_ahead_tiles", int, m_read_ahead_tiles);
+    ATTR_DECODE("microcache_size", int, m_microcache_size);
+    ATTR_DECODE("numa_local_tiles", int, m_numa_local_tiles);
+    ATTR_DECODE("share_constant_tiles", int, m_share_constant_tiles);
+    ATTR_DECODE("trace_tiles", int, m_trace_tiles);
     ATTR_DECODE("deduplicate", int, m_deduplicate);
+    ATTR_DECODE("fingerprint_files", int, m_fingerprint_files);
     ATTR_DECODE("unassociatedalpha", int, m_unassociatedalpha);
     ATTR_DECODE("trust_file_extensions", int, m_trust_file_extensions);
     ATTR_DECODE("max_open_files_strict", int, m_max_open_files_strict);
@@ -2437,6 +4088,17 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         *(const char**)val = m_colorspace.c_str();
         return true;
     }
+    if (name == "diskcache:path" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_diskcache.path()).c_str();
+        return true;
+    }
+    ATTR_DECODE("diskcache:size", float,
+                m_diskcache.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("diskcache:size", int, m_diskcache.max_bytes() / (1024 * 1024));
+    if (name == "headerindex:path" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_headerindex.path()).c_str();
+        return true;
+    }
     if (name == "all_filenames" && type.basetype == TypeDesc::STRING
         && type.is_sized_array()) {
         ustring* names = (ustring*)val;
@@ -2451,12 +4113,58 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
     if (Strutil::starts_with(name, "stat:")) {
         // Stats we can just grab
         ATTR_DECODE("stat:cache_memory_used", long long, m_mem_used);
+        ATTR_DECODE("stat:compressed_memory_used", long long,
+                    m_compressed_mem);
+        ATTR_DECODE("stat:colorconvert_memory_used", long long,
+                    m_colorconvert_mem);
         ATTR_DECODE("stat:tiles_created", int, m_stat_tiles_created);
         ATTR_DECODE("stat:tiles_current", int, m_stat_tiles_current);
         ATTR_DECODE("stat:tiles_peak", int, m_stat_tiles_peak);
         ATTR_DECODE("stat:open_files_created", int, m_stat_open_files_created);
         ATTR_DECODE("stat:open_files_current", int, m_stat_open_files_current);
         ATTR_DECODE("stat:open_files_peak", int, m_stat_open_files_peak);
+        ATTR_DECODE("stat:fds_detached", long long, m_stat_fds_detached);
+        ATTR_DECODE("stat:fds_reattached", long long, m_stat_fds_reattached);
+        ATTR_DECODE("stat:prefetch_tiles", int, m_stat_prefetch_tiles);
+        ATTR_DECODE("stat:prefetch_reads", int, m_stat_prefetch_reads);
+        ATTR_DECODE("stat:diskcache_hits", long long,
+                    m_diskcache.m_stat_hits);
+        ATTR_DECODE("stat:diskcache_misses", long long,
+                    m_diskcache.m_stat_misses);
+        ATTR_DECODE("stat:diskcache_writes", long long,
+                    m_diskcache.m_stat_writes);
+        ATTR_DECODE("stat:diskcache_evictions", long long,
+                    m_diskcache.m_stat_evictions);
+        ATTR_DECODE("stat:diskcache_bytes_read", long long,
+                    m_diskcache.m_stat_bytes_read);
+        ATTR_DECODE("stat:diskcache_bytes_used", long long,
+                    m_diskcache.bytes_used());
+        ATTR_DECODE("stat:headerindex_hits", long long,
+                    m_headerindex.m_stat_hits);
+        ATTR_DECODE("stat:headerindex_misses", long long,
+                    m_headerindex.m_stat_misses);
+        ATTR_DECODE("stat:headerindex_writes", long long,
+                    m_headerindex.m_stat_writes);
+        if (name == "stat:tiles_evicted" || name == "stat:eviction_time"
+            || name == "stat:shard_eviction_time") {
+            long long evicted = 0, tiles, sweeps;
+            float shard_time[TILE_CACHE_SHARDS];
+            double time, total_time = 0.0;
+            for (int s = 0; s < TILE_CACHE_SHARDS; ++s) {
+                shard_evictions(s, tiles, sweeps, time);
+                evicted += tiles;
+                total_time += time;
+                shard_time[s] = float(time);
+            }
+            ATTR_DECODE("stat:tiles_evicted", long long, evicted);
+            ATTR_DECODE("stat:eviction_time", float, total_time);
+            if (name == "stat:shard_eviction_time"
+                && type == TypeDesc(TypeDesc::FLOAT, TILE_CACHE_SHARDS)) {
+                memcpy(val, shard_time, sizeof(shard_time));
+                return true;
+            }
+            return false;
+        }
 
         // All the other stats are those that need to be summed from all
         // the threads.
@@ -2465,6 +4173,8 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         ATTR_DECODE("stat:find_tile_calls", long long, stats.find_tile_calls);
         ATTR_DECODE("stat:find_tile_microcache_misses", long long,
                     stats.find_tile_microcache_misses);
+        ATTR_DECODE("stat:find_tile_microcache_hits", long long,
+                    stats.find_tile_microcache_hits);
         ATTR_DECODE("stat:find_tile_cache_misses", int,
                     stats.find_tile_cache_misses);
         ATTR_DECODE("stat:files_totalsize", long long,
@@ -2479,6 +4189,23 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         ATTR_DECODE("stat:tile_locking_time", float, stats.tile_locking_time);
         ATTR_DECODE("stat:find_file_time", float, stats.find_file_time);
         ATTR_DECODE("stat:find_tile_time", float, stats.find_tile_time);
+        ATTR_DECODE("stat:tiles_mmapped", long long, stats.tiles_mmapped);
+        ATTR_DECODE("stat:tiles_constant_shared", long long,
+                    stats.tiles_constant_shared);
+        ATTR_DECODE("stat:tiles_constant_synthesized", long long,
+                    stats.tiles_constant_synthesized);
+        ATTR_DECODE("stat:tiles_read_ahead", long long,
+                    stats.tiles_read_ahead);
+        ATTR_DECODE("stat:tiles_from_slab", long long, stats.tiles_from_slab);
+        ATTR_DECODE("stat:numa_local_hits", long long, stats.numa_local_hits);
+        ATTR_DECODE("stat:numa_remote_hits", long long,
+                    stats.numa_remote_hits);
+        ATTR_DECODE("stat:tiles_compressed", long long,
+                    stats.tiles_compressed);
+        ATTR_DECODE("stat:tiles_uncompressed", long long,
+                    stats.tiles_uncompressed);
+        ATTR_DECODE("stat:tiles_colorconverted", long long,
+                    stats.tiles_colorconverted);
         ATTR_DECODE("stat:texture_queries", long long, stats.texture_queries);
         ATTR_DECODE("stat:texture3d_queries", long long,
                     stats.texture3d_queries);
@@ -2496,6 +4223,57 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
 
 
 
+bool
+ImageCacheImpl::attribute(ImageHandle* file, string_view name, TypeDesc type,
+                          const void* val)
+{
+    if (!file)
+        return false;
+    // Tiles of a duplicate file are really the tiles of the original.
+    if (file->duplicate())
+        file = file->duplicate();
+    if (name == "evict_priority" && type == TypeDesc::INT) {
+        file->evict_priority(*(const int*)val);
+        return true;
+    }
+    if (name == "max_memory_MB"
+        && (type == TypeDesc::FLOAT || type == TypeDesc::INT)) {
+        float size = type == TypeDesc::FLOAT ? *(const float*)val
+                                             : float(*(const int*)val);
+        file->max_tile_mem(
+            (long long)(std::max(size, 0.0f) * (long long)(1024 * 1024)));
+        return true;
+    }
+    return false;
+}
+
+
+
+bool
+ImageCacheImpl::getattribute(ImageHandle* file, string_view name,
+                             TypeDesc type, void* val) const
+{
+    if (!file)
+        return false;
+    if (file->duplicate())
+        file = file->duplicate();
+    if (name == "evict_priority" && type == TypeDesc::INT) {
+        *(int*)val = file->evict_priority();
+        return true;
+    }
+    if (name == "max_memory_MB" && type == TypeDesc::FLOAT) {
+        *(float*)val = float(file->max_tile_mem() / (1024.0 * 1024.0));
+        return true;
+    }
+    if (name == "max_memory_MB" && type == TypeDesc::INT) {
+        *(int*)val = int(file->max_tile_mem() / (1024 * 1024));
+        return true;
+    }
+    return false;
+}
+
+
+
 bool
 ImageCacheImpl::find_tile_main_cache(const TileID& id, ImageCacheTileRef& tile,
                                      ImageCachePerThreadInfo* thread_info)
@@ -2519,7 +4297,14 @@ ImageCacheImpl::find_tile_main_cache(const TileID& id, ImageCacheTileRef& tile,
             // released the lock (above) before calling wait_pixels_ready,
             // otherwise we could deadlock if another thread reading the
             // pixels needs to lock the cache because it's doing automip.
-            tile->wait_pixels_ready();
+            // If it's a prefetched tile that the thread pool hasn't gotten
+            // to yet, we do the read ourselves rather than wait for it.
+            bool ok;
+            if (finish_tile_read(tile.get(), thread_info, ok))
+                check_max_mem(thread_info, tile.get());
+            else
+                trace_tile(thread_info, id, true);
+            count_numa_hit(thread_info, tile.get());
             tile->use();
             OIIO_DASSERT(id == tile->id());
             OIIO_DASSERT(tile);
@@ -2559,27 +4344,208 @@ ImageCacheImpl::add_tile_to_cache(ImageCacheTileRef& tile,
     // somebody else to read the pixels.
     bool ok = true;
     if (ourtile) {
-        if (!tile->pixels_ready()) {
-            Timer timer;
-            ok              = tile->read(thread_info);
-            double readtime = timer();
-            thread_info->m_stats.fileio_time += readtime;
-            tile->id().file().iotime() += readtime;
-        }
-        check_max_mem(thread_info);
+        finish_tile_read(tile.get(), thread_info, ok);
+        check_max_mem(thread_info, tile.get());
     } else {
         // Somebody else already added the tile to the cache before we
         // could, so we'll use their reference, but we need to wait until it
-        // has read in the pixels.
-        tile->wait_pixels_ready();
+        // has read in the pixels (or read them ourselves if it's a
+        // prefetched tile that nobody has started on).
+        bool theirs_ok;
+        if (finish_tile_read(tile.get(), thread_info, theirs_ok))
+            check_max_mem(thread_info, tile.get());
+    }
+    return ok;
+}
+
+
+
+bool
+ImageCacheImpl::find_tiles(cspan<TileID> ids, span<ImageCacheTileRef> tiles,
+                           ImageCachePerThreadInfo* thread_info)
+{
+    OIIO_DASSERT(tiles.size() >= ids.size());
+    const size_t n = ids.size();
+    if (n == 1) {
+        // Not much of a batch, don't bother with the machinery
+        bool ok  = find_tile(ids[0], thread_info, true);
+        tiles[0] = thread_info->tile;
+        return ok;
+    }
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    stats.find_tile_calls += n;
+
+    // Collapse duplicate ids, so that each distinct tile is looked up only
+    // once. slot[i] is the index within `unique` of ids[i].
+    std::vector<size_t> slot(n);
+    std::vector<size_t> unique;  // index in ids of each distinct tile
+    unique.reserve(n);
+    if (n <= 16) {
+        for (size_t i = 0; i < n; ++i) {
+            size_t u = 0;
+            while (u < unique.size() && ids[unique[u]] != ids[i])
+                ++u;
+            if (u == unique.size())
+                unique.push_back(i);
+            slot[i] = u;
+        }
+    } else {
+        tsl::robin_map<TileID, size_t, TileID::Hasher> seen;
+        for (size_t i = 0; i < n; ++i) {
+            auto f = seen.emplace(ids[i], unique.size());
+            if (f.second)
+                unique.push_back(i);
+            slot[i] = f.first->second;
+        }
+    }
+    const size_t nunique = unique.size();
+    std::vector<ImageCacheTileRef> found(nunique);
+
+    // Check the per-thread microcache, and sort what's left by shard.
+    std::vector<std::pair<size_t, size_t>> misses;  // (shard, unique idx)
+    misses.reserve(nunique);
+    for (size_t u = 0; u < nunique; ++u) {
+        const TileID& id(ids[unique[u]]);
+        if (thread_info->tile && thread_info->tile->id() == id)
+            found[u] = thread_info->tile;
+        else if (ImageCacheTile* t = thread_info->microcache_peek(id))
+            found[u] = t;
+        else
+            misses.emplace_back(m_tilecache.bin_of(id), u);
+    }
+    stats.find_tile_microcache_misses += misses.size();
+    std::sort(misses.begin(), misses.end());
+
+    // Look up the rest in the main cache, locking each shard just once.
+    for (size_t m = 0, mend = 0; m < misses.size(); m = mend) {
+        for (mend = m + 1;
+             mend < misses.size() && misses[mend].first == misses[m].first;
+             ++mend)
+            ;
+        m_tilecache.read_bin(misses[m].first,
+                             [&](const TileCache::BinMap_t& bin) {
+                                 for (size_t i = m; i < mend; ++i) {
+                                     size_t u = misses[i].second;
+                                     auto f   = bin.find(ids[unique[u]]);
+                                     if (f != bin.end()) {
+                                         found[u] = f->second;
+                                         trace_tile(thread_info, f->first,
+                                                    true);
+                                         count_numa_hit(thread_info,
+                                                        f->second.get());
+                                     }
+                                 }
+                             });
+    }
+
+    // Add tiles for the ones that aren't in the cache. Whether we added it
+    // or somebody beat us to it, any tile whose pixels aren't ready needs
+    // to be read (or waited for).
+    std::vector<ImageCacheTile*> unready;
+    for (auto& m : misses) {
+        ImageCacheTileRef& tile(found[m.second]);
+        if (!tile) {
+            ++stats.find_tile_cache_misses;
+            tile = new ImageCacheTile(ids[unique[m.second]]);
+            m_tilecache.insert_retrieve(tile->id(), tile, tile);
+        }
+        if (!tile->pixels_ready())
+            unready.push_back(tile.get());
+    }
+
+    // Read the missing tiles concurrently. Each worker uses its own
+    // per-thread info, as the prefetch tasks do.
+    if (unready.size() == 1) {
+        bool ok;
+        if (finish_tile_read(unready[0], thread_info, ok))
+            check_max_mem(thread_info, unready[0]);
+    } else if (unready.size() > 1) {
+        parallel_for(int64_t(0), int64_t(unready.size()), [&](int64_t i) {
+            ImageCachePerThreadInfo* ti = get_perthread_info();
+            bool ok;
+            if (finish_tile_read(unready[i], ti, ok))
+                check_max_mem(ti, unready[i]);
+        });
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < n; ++i) {
+        tiles[i] = found[slot[i]];
+        tiles[i]->use();
+        ok &= tiles[i]->valid();
     }
     return ok;
 }
 
 
 
+bool
+ImageCacheImpl::finish_tile_read(ImageCacheTile* tile,
+                                 ImageCachePerThreadInfo* thread_info,
+                                 bool& ok)
+{
+    ok = true;
+    if (tile->pixels_ready()) {
+        ok = tile->valid();
+        return false;
+    }
+    if (!tile->claim_read()) {
+        // Somebody else is already reading it
+        tile->wait_pixels_ready();
+        ok = tile->valid();
+        return false;
+    }
+    Timer timer;
+    ok              = tile->read(thread_info);
+    double readtime = timer();
+    thread_info->m_stats.fileio_time += readtime;
+    tile->id().file().iotime() += readtime;
+    return true;
+}
+
+
+
+void
+ImageCacheImpl::prefetch_task(ImageCacheTileRef tile)
+{
+    // N.B. This runs on a thread pool worker, which gets its own
+    // per-thread info (and therefore its own stats) just like any other
+    // thread that uses the cache.
+    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+    if (!tile->pixels_ready() && tile->claim_read()) {
+        Timer timer;
+        bool ok         = tile->read(thread_info);
+        double readtime = timer();
+        thread_info->m_stats.fileio_time += readtime;
+        tile->id().file().iotime() += readtime;
+        ++m_stat_prefetch_reads;
+        if (ok)
+            check_max_mem(thread_info, tile.get());
+    }
+    if (--m_prefetch_pending == 0) {
+        // Take the lock so the wakeup can't slip in between a waiter's
+        // check of the count and its going to sleep.
+        std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+        m_prefetch_done.notify_all();
+    }
+}
+
+
+
+void
+ImageCacheImpl::wait_for_prefetches()
+{
+    // Sleep rather than spin: a large prefetch may keep the pool busy
+    // reading for a long time.
+    std::unique_lock<std::mutex> lock(m_prefetch_mutex);
+    m_prefetch_done.wait(lock, [&]() { return m_prefetch_pending <= 0; });
+}
+
+
+
 void
-ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
+ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* thread_info,
+                              const ImageCacheTile* tile)
 {
     OIIO_DASSERT(m_mem_used < (long long)m_max_memory_bytes * 10);  // sanity
 #if 0
@@ -2587,90 +4553,334 @@ ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
     if (! (n++ % 64) || m_mem_used >= (long long)m_max_memory_bytes)
         std::cerr << "mem used: " << m_mem_used << ", max = " << m_max_memory_bytes << "\n";
 #endif
+    int shard = tile->shard();
+
+    // If the file has its own tile memory quota and has gone over it,
+    // make it give up some of its own tiles, starting with this shard.
+    // Its tiles are spread over all the shards, so keep going until it's
+    // back within its quota.
+    const ImageCacheFile& file(tile->file());
+    const long long file_max = file.max_tile_mem();
+    for (int i = 0; i < TILE_CACHE_SHARDS && file_max > 0
+                    && file.tile_mem() > file_max;
+         ++i)
+        evict_from_shard((shard + i) & (TILE_CACHE_SHARDS - 1), 0,
+                         thread_info, &file, file_max);
     // Early out if the cache is empty
     if (m_tilecache.empty())
         return;
     // Early out if we aren't exceeding the tile memory limit
-    if (m_mem_used < (long long)m_max_memory_bytes)
+    const long long max_bytes = m_max_memory_bytes;
+    if (m_mem_used < max_bytes)
         return;
 
-    // Try to grab the tile_sweep_mutex lock. If somebody else holds it,
-    // just return -- leave the memory limit enforcement to whomever is
-    // already in this function, no need for two threads to do it at
-    // once.  If this means we may ephemerally be over the memory limit
-    // (because another thread adds a tile before we have freed enough
-    // here), so be it.
-    if (!m_tile_sweep_mutex.try_lock())
+    // Each shard is held to its fair share of the memory limit. We'd
+    // prefer to evict from the shard we just added a tile to, but if it
+    // isn't over its share, then some other shard must be, so find one
+    // (starting from a rotating hint, so that the work gets spread out).
+    const long long shard_max = max_bytes / TILE_CACHE_SHARDS;
+    if (m_tile_shards[shard].mem_used < shard_max) {
+        int start = m_evict_shard_hint++ & (TILE_CACHE_SHARDS - 1);
+        shard     = -1;
+        for (int i = 0; i < TILE_CACHE_SHARDS; ++i) {
+            int s = (start + i) & (TILE_CACHE_SHARDS - 1);
+            if (m_tile_shards[s].mem_used >= shard_max) {
+                shard = s;
+                break;
+            }
+        }
+        if (shard < 0)
+            return;
+    }
+    evict_from_shard(shard, shard_max, thread_info);
+}
+
+
+
+void
+ImageCacheImpl::evict_from_shard(int shard, long long shard_max,
+                                 ImageCachePerThreadInfo* thread_info,
+                                 const ImageCacheFile* file,
+                                 long long file_max)
+{
+    TileShard& sh(m_tile_shards[shard]);
+
+    // Try to grab the shard's sweep lock. If somebody else holds it, just
+    // return -- leave the enforcement for this shard to whomever is
+    // already sweeping it. If this means we may ephemerally be over the
+    // memory limit, so be it.
+    if (!sh.sweep_mutex.try_lock())
         return;
 
-    // Now, what we want to do is have a "clock hand" that sweeps across
-    // the cache, releasing tiles that haven't been used for a long
-    // time.  Because of multi-thread, rather than keep an iterator
-    // around for this (which could be invalidated since the last time
-    // we used it), we just remember the tileID of the next tile to
-    // check, then look it up fresh.  That is m_tile_sweep_id.
-
-    // Get a (locked) iterator for the next tile to be examined.
-    TileCache::iterator sweep;
-    if (!m_tile_sweep_id.empty()) {
-        // We saved the sweep_id. Find the iterator corresponding to it.
-        sweep = m_tilecache.find(m_tile_sweep_id);
-        // Note: if the sweep_id is no longer in the table, sweep will be an
-        // empty iterator. That's ok, it will be fixed early in the main
-        // loop below.
-    }
-
-    // Loop while we still use too much tile memory.  Also, be careful
-    // of looping for too long, exit the loop if we just keep spinning
-    // uncontrollably.
-    int full_loops = 0;
-    while (m_mem_used >= (long long)m_max_memory_bytes && full_loops < 100) {
-        // If we have fallen off the end of the cache, loop back to the
-        // beginning and increment our full_loops count.
-        if (!sweep) {
-            sweep = m_tilecache.begin();
-            ++full_loops;
-        }
-        // If we're STILL at the end, it must be that somehow the entire
-        // cache is empty.  So just declare ourselves done.
-        if (!sweep)
-            break;
-        OIIO_DASSERT(sweep->second);
-
-        if (!sweep->second->release()) {
-            // This is a tile we should delete.  To keep iterating
-            // safely, we have a good trick:
-            // 1. remember the TileID of the tile to delete
-            TileID todelete = sweep->first;
-            size_t size     = sweep->second->memsize();
-            OIIO_DASSERT(m_mem_used >= (long long)size);
-            // 2. Find the TileID of the NEXT item. We do this by
-            // incrementing the sweep iterator and grabbing its id.
-            ++sweep;
-            m_tile_sweep_id = (sweep ? sweep->first : TileID());
-            // 3. Release the bin lock and erase the tile we wish to delete.
-            sweep.unlock();
-            m_tilecache.erase(todelete);
-            // 4. Re-establish a locked iterator for the next item, since
-            // the old iterator may have been invalidated by the erasure.
-            if (!m_tile_sweep_id.empty())
-                sweep = m_tilecache.find(m_tile_sweep_id);
-        } else {
-            ++sweep;
+    Timer timer;
+    long long evicted = 0;
+
+    // Evicted tiles are removed from the bin but hang on to our reference
+    // until we let go of the locks, so that freeing their pixels (or
+    // compressing them, if we keep compressed cold tiles) doesn't hold up
+    // other threads looking for tiles in this shard. Until then their
+    // memory isn't freed, so count it as freed already.
+    std::vector<ImageCacheTileRef> victims;
+    long long pending_free = 0;
+    bool compress          = m_max_compressed_bytes > 0 && thread_info;
+    auto over_limit        = [&]() {
+        return file ? file->tile_mem() - pending_free > file_max
+                           : sh.mem_used - pending_free >= shard_max;
+    };
+
+    // The "clock hand" for this shard is the TileID of the next tile to
+    // examine, since an iterator would not survive between calls. We
+    // hold the shard's bin lock for the duration of the sweep, which lets
+    // us remove tiles as we walk the bin without re-finding our place.
+    m_tilecache.modify_bin(shard, [&](TileCache::BinMap_t& bin) {
+        if (bin.empty())
+            return;
+        auto sweep = sh.sweep_id.empty() ? bin.end() : bin.find(sh.sweep_id);
+        // Bound the work: two full passes over the bin are enough to clear
+        // the "recently used" marks on everything and then free it.
+        size_t budget = 2 * bin.size() + 1;
+        while (over_limit() && budget-- > 0 && !bin.empty()) {
+            // If we have fallen off the end of the bin, loop back to the
+            // beginning.
+            if (sweep == bin.end())
+                sweep = bin.begin();
+            OIIO_DASSERT(sweep->second);
+            if (file && &sweep->second->file() != file) {
+                ++sweep;  // Only enforcing one file's quota, skip others
+            } else if (!sweep->second->release()) {
+                // Not recently used -- remove it. N.B. the tile may still
+                // live on if somebody else holds a reference to it.
+                pending_free += sweep->second->evict_credit();
+                victims.push_back(sweep->second);
+                sweep = bin.erase(sweep);
+                ++evicted;
+            } else {
+                ++sweep;
+            }
+        }
+        // Save the clock hand for next time.
+        sh.sweep_id = (sweep != bin.end()) ? sweep->first : TileID();
+    });
+
+    sh.tiles_evicted += evicted;
+    sh.sweeps += 1;
+    sh.evict_time += timer();
+    sh.sweep_mutex.unlock();
+
+    for (auto& tile : victims) {
+        if (compress && !tile->nofree() && !tile->stale())
+            compress_tile(tile.get(), thread_info);
+        tile.reset();  // frees the tile unless somebody else holds it
+    }
+}
+
+
+
+namespace {
+// Cold tiles are compressed by first shuffling the bytes of the pixel data
+// so that each byte of every channel value is grouped with the same byte
+// of the others (as Blosc does), which makes smooth or flat float and half
+// data compress far better, and then deflating with zlib's fastest
+// setting.
+void
+shuffle_bytes(const char* src, char* dst, size_t size, int elsize)
+{
+    size_t n = size / elsize;
+    for (size_t i = 0; i < n; ++i)
+        for (int b = 0; b < elsize; ++b)
+            dst[b * n + i] = src[i * elsize + b];
+    // Any ragged end is copied as-is
+    memcpy(dst + n * elsize, src + n * elsize, size - n * elsize);
+}
+
+void
+unshuffle_bytes(const char* src, char* dst, size_t size, int elsize)
+{
+    size_t n = size / elsize;
+    for (size_t i = 0; i < n; ++i)
+        for (int b = 0; b < elsize; ++b)
+            dst[i * elsize + b] = src[b * n + i];
+    memcpy(dst + n * elsize, src + n * elsize, size - n * elsize);
+}
+}  // namespace
+
+
+
+ColorProcessorHandle
+ImageCacheImpl::colortransform_processor(int colortransformid)
+{
+    {
+        spin_rw_read_lock lock(m_colorprocs_mutex);
+        auto found = m_colorprocs.find(colortransformid);
+        if (found != m_colorprocs.end())
+            return found->second;
+    }
+    // The id holds the from and to color space indices, each plus one.
+    const ColorConfig& cc(ColorConfig::default_colorconfig());
+    int from = (colortransformid >> 16) - 1;
+    int to   = (colortransformid & 0xffff) - 1;
+    ColorProcessorHandle processor;
+    if (from >= 0 && to >= 0)
+        processor = cc.createColorProcessor(cc.getColorSpaceNameByIndex(from),
+                                            cc.getColorSpaceNameByIndex(to));
+    spin_rw_write_lock lock(m_colorprocs_mutex);
+    return m_colorprocs.emplace(colortransformid, processor).first->second;
+}
+
+
+
+std::shared_ptr<const char>
+ImageCacheImpl::shared_constant_tile(const char* pixel, int pixelsize,
+                                     size_t size, int shard)
+{
+    std::string key(reinterpret_cast<const char*>(&size), sizeof(size));
+    key.append(pixel, pixelsize);
+    std::lock_guard<std::mutex> lock(m_constant_tiles_mutex);
+    std::shared_ptr<const char> block = m_constant_tiles[key].lock();
+    if (!block) {
+        // Drop entries whose blocks have died before the table grows.
+        if (m_constant_tiles.size() > 1024) {
+            for (auto i = m_constant_tiles.begin();
+                 i != m_constant_tiles.end();) {
+                if (i->second.expired() && i->first != key)
+                    i = m_constant_tiles.erase(i);
+                else
+                    ++i;
+            }
+        }
+        char* pixels     = new char[size];
+        size_t tilebytes = size - OIIO_SIMD_MAX_SIZE_BYTES;
+        for (size_t p = 0; p < tilebytes; p += pixelsize)
+            memcpy(pixels + p, pixel, pixelsize);
+        memset(pixels + tilebytes, 0, OIIO_SIMD_MAX_SIZE_BYTES);
+        block.reset(pixels, [this, size, shard](const char* p) {
+            decr_mem(size, shard);
+            delete[] p;
+        });
+        incr_mem(size, shard);
+        m_constant_tiles[key] = block;
+    }
+    return block;
+}
+
+
+
+void
+ImageCacheImpl::compress_tile(const ImageCacheTile* tile,
+                              ImageCachePerThreadInfo* thread_info)
+{
+    if (!tile->valid() || !tile->pixels_ready() || !tile->memsize())
+        return;
+    Timer timer;
+    const char* pixels = (const char*)tile->data();
+    size_t size        = tile->memsize() - OIIO_SIMD_MAX_SIZE_BYTES;
+    std::unique_ptr<char[]> shuffled(new char[size]);
+    shuffle_bytes(pixels, shuffled.get(), size, tile->channelsize());
+    uLongf zsize = compressBound(uLong(size));
+    std::unique_ptr<char[]> zbuf(new char[zsize]);
+    bool ok = compress2((Bytef*)zbuf.get(), &zsize,
+                        (const Bytef*)shuffled.get(), uLong(size),
+                        Z_BEST_SPEED)
+              == Z_OK;
+    // Not worth keeping unless it saves at least a quarter of the memory
+    ok &= (zsize < size - size / 4);
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    if (ok) {
+        CompressedTile ctile;
+        ctile.data.reset(new char[zsize]);
+        ctile.size = zsize;
+        memcpy(ctile.data.get(), zbuf.get(), zsize);
+        stats.tiles_compressed += 1;
+        stats.compress_bytes_in += size;
+        stats.compress_bytes_out += zsize;
+
+        // Each shard gets its share of the compressed memory limit, and
+        // the oldest compressed tiles make way for new ones.
+        TileShard& sh(m_tile_shards[tile->shard()]);
+        const long long shard_max = m_max_compressed_bytes / TILE_CACHE_SHARDS;
+        spin_lock lock(sh.compressed_mutex);
+        while (sh.compressed_mem + (long long)zsize > shard_max
+               && !sh.cold.empty()) {
+            auto oldest = sh.compressed.find(sh.cold.front());
+            OIIO_DASSERT(oldest != sh.compressed.end());
+            sh.compressed_mem -= oldest->second.size;
+            m_compressed_mem -= oldest->second.size;
+            sh.compressed.erase(oldest);
+            sh.cold.pop_front();
         }
+        if (sh.compressed_mem + (long long)zsize <= shard_max
+            && sh.compressed.find(tile->id()) == sh.compressed.end()) {
+            sh.cold.push_back(tile->id());
+            ctile.age = std::prev(sh.cold.end());
+            sh.compressed_mem += zsize;
+            m_compressed_mem += zsize;
+            sh.compressed.emplace(tile->id(), std::move(ctile));
+        }
+    }
+    stats.compress_time += timer();
+}
+
+
+
+bool
+ImageCacheImpl::uncompress_tile(const TileID& id, int shard, char* pixels,
+                                size_t size,
+                                ImageCachePerThreadInfo* thread_info)
+{
+    if (!m_compressed_mem)
+        return false;  // Nothing is compressed, don't bother locking
+    Timer timer;
+    CompressedTile ctile;
+    {
+        TileShard& sh(m_tile_shards[shard]);
+        spin_lock lock(sh.compressed_mutex);
+        auto found = sh.compressed.find(id);
+        if (found == sh.compressed.end())
+            return false;
+        // The tile is about to go back into the main cache, so it no
+        // longer needs to be kept here.
+        ctile = std::move(found.value());
+        sh.cold.erase(ctile.age);
+        sh.compressed_mem -= ctile.size;
+        m_compressed_mem -= ctile.size;
+        sh.compressed.erase(found);
+    }
+    std::unique_ptr<char[]> shuffled(new char[size]);
+    uLongf usize = uLongf(size);
+    bool ok = uncompress((Bytef*)shuffled.get(), &usize,
+                         (const Bytef*)ctile.data.get(), uLong(ctile.size))
+                  == Z_OK
+              && usize == size;
+    if (ok)
+        unshuffle_bytes(shuffled.get(), pixels, size,
+                        int(id.file().datatype(id.subimage()).size()));
+    if (thread_info) {
+        thread_info->m_stats.tiles_uncompressed += ok;
+        thread_info->m_stats.uncompress_time += timer();
     }
+    return ok;
+}
 
-    // OK, by this point we have either freed enough tiles to be below
-    // the limit again, or the cache is empty, or we've looped over the
-    // cache too many times and are giving up.
 
-    // Now we must save the tileid for next time.  Just set it to an
-    // empty ID if we don't have a valid iterator at this point.
-    m_tile_sweep_id = (sweep ? sweep->first : TileID());
-    m_tile_sweep_mutex.unlock();
 
-    // N.B. As we exit, the iterators will go out of scope and we will
-    // retain no locks on the cache.
+void
+ImageCacheImpl::drop_compressed_tiles(const ImageCacheFile* file)
+{
+    for (auto& sh : m_tile_shards) {
+        spin_lock lock(sh.compressed_mutex);
+        for (auto c = sh.cold.begin(); c != sh.cold.end();) {
+            if (file && &c->file() != file) {
+                ++c;
+                continue;
+            }
+            auto found = sh.compressed.find(*c);
+            OIIO_DASSERT(found != sh.compressed.end());
+            sh.compressed_mem -= found->second.size;
+            m_compressed_mem -= found->second.size;
+            sh.compressed.erase(found);
+            c = sh.cold.erase(c);
+        }
+    }
 }
 
 
@@ -2756,6 +4966,20 @@ ImageCacheImpl::get_image_info(ImageCacheFile* file,
         ATTR_DECODE("stat:image_size", long long, file->m_total_imagesize);
         ATTR_DECODE("stat:file_size", long long,
                     file->m_total_imagesize_ondisk);
+        ATTR_DECODE("stat:texture_queries", long long,
+                    file->texture_queries());
+        ATTR_DECODE("stat:texture_probes", long long, file->texture_probes());
+        ATTR_DECODE("stat:texture_time", float, file->texture_time());
+        if (dataname == "stat:texture_mip_hits"
+            && datatype.basetype == TypeDesc::INT64) {
+            int n = int(datatype.basevalues());
+            for (int m = 0; m < n; ++m)
+                ((long long*)data)[m]
+                    = m < ImageCacheFile::texture_mip_counters
+                          ? file->texture_mip_hits(m)
+                          : 0;
+            return true;
+        }
     }
 
     if (file->broken()) {
@@ -3226,93 +5450,156 @@ ImageCacheImpl::get_pixels(ImageCacheFile* file,
     stride_t zplanesize         = (yend - ybegin) * scanlinesize;
     OIIO_DASSERT(spec.depth >= 1 && spec.tile_depth >= 1);
 
-    imagesize_t npixelsread = 0;
-    char* zptr              = (char*)result;
+    // Zero a scanline (or part of one) of the result that lies outside
+    // the image.
+    auto zero_pixels = [&](char* xptr, int npixels) {
+        if (xstride == result_pixelsize) {
+            // Can zero out the span in one shot
+            memset(xptr, 0, npixels * result_pixelsize);
+        } else {
+            // Non-contiguous strides -- zero out individual pixels
+            for (int x = 0; x < npixels; ++x, xptr += xstride)
+                memset(xptr, 0, result_pixelsize);
+        }
+    };
+
+    // Copy scanline y of plane z, which must lie within the image, to
+    // yptr. rowtiles are the tiles of its row of tiles, the first of which
+    // starts at x == row_tx0.
+    auto copy_scanline = [&](int y, int z, char* yptr,
+                             const ImageCacheTileRef* rowtiles, int row_tx0) {
+        int old_tx                 = -100000;
+        const ImageCacheTile* tile = nullptr;
+        char* xptr                 = yptr;
+        const char* data           = NULL;
+        for (int x = xbegin; x < xend; ++x, xptr += xstride) {
+            if (x < spec.x || x >= (spec.x + spec.width)) {
+                // nonexistent columns
+                memset(xptr, 0, result_pixelsize);
+                continue;
+            }
+            int tx = x - ((x - spec.x) % spec.tile_width);
+            if (old_tx != tx) {
+                // Only re-setup the data pointer when we move across
+                // a tile boundary.
+                tile   = rowtiles[(tx - row_tx0) / spec.tile_width].get();
+                old_tx = tx;
+                data   = NULL;
+            }
+            if (!data) {
+                OIIO_DASSERT(tile);
+                data = (const char*)tile->data(x, y, z, chbegin);
+                OIIO_DASSERT(data);
+            }
+            if (xcontig) {
+                // Special case for a contiguous span within one tile
+                int spanend   = std::min(tx + spec.tile_width, xend);
+                stride_t span = spanend - x;
+                convert_types(cachetype, data, format, xptr,
+                              result_nchans * span);
+                x += (span - 1);
+                xptr += xstride * (span - 1);
+                // no need to increment data, since next read will
+                // be from a different tile
+            } else {
+                convert_types(cachetype, data, format, xptr, result_nchans);
+                data += cache_stride;
+            }
+        }
+    };
+
+    // The grid of tiles overlapping the part of the request that lies
+    // within the image.
+    const int tw = spec.tile_width, th = spec.tile_height;
+    const int td = spec.tile_depth;
+    int xb = std::max(xbegin, spec.x), xe = std::min(xend, spec.x + spec.width);
+    int yb = std::max(ybegin, spec.y);
+    int ye = std::min(yend, spec.y + spec.height);
+    int zb = std::max(zbegin, spec.z), ze = std::min(zend, spec.z + spec.depth);
+    int tx0 = xb - ((xb - spec.x) % tw);
+    int ty0 = yb - ((yb - spec.y) % th);
+    int tz0 = zb - ((zb - spec.z) % td);
+    int ntx = xe > xb ? (xe - tx0 + tw - 1) / tw : 0;
+    int nty = ye > yb ? (ye - ty0 + th - 1) / th : 0;
+    int ntz = ze > zb ? (ze - tz0 + td - 1) / td : 0;
+    size_t ntiles       = size_t(ntx) * nty * ntz;
+    imagesize_t tilemem = imagesize_t(tw) * th * td * cache_stride;
+
+    // When the request spans several rows of tiles, look up all its tiles
+    // in one batch, so that all the misses are read concurrently, then
+    // copy the scanlines out in parallel. All those tiles stay referenced
+    // until we're done, so this is only for requests that are modest
+    // relative to the cache size; bigger ones go a row of tiles at a time.
+    if (nty * ntz > 1
+        && ntiles * tilemem <= imagesize_t(m_max_memory_bytes) / 4) {
+        std::vector<TileID> ids;
+        ids.reserve(ntiles);
+        for (int tz = tz0; tz < ze; tz += td)
+            for (int ty = ty0; ty < ye; ty += th)
+                for (int tx = tx0; tx < xe; tx += tw)
+                    ids.emplace_back(*file, subimage, miplevel, tx, ty, tz,
+                                     cache_chbegin, cache_chend);
+        std::vector<ImageCacheTileRef> tiles(ntiles);
+        if (!find_tiles(ids, tiles, thread_info))
+            return false;  // Just stop if file read failed
+        const int64_t height = yend - ybegin;
+        parallel_for_chunked(
+            0, int64_t(zend - zbegin) * height, th,
+            [&](int64_t begin, int64_t end) {
+                for (int64_t r = begin; r < end; ++r) {
+                    int z      = zbegin + int(r / height);
+                    int y      = ybegin + int(r % height);
+                    char* yptr = (char*)result + (z - zbegin) * zstride
+                                 + (y - ybegin) * ystride;
+                    if (z < zb || z >= ze || y < yb || y >= ye) {
+                        // nonexistent planes or scanlines
+                        zero_pixels(yptr, xend - xbegin);
+                        continue;
+                    }
+                    size_t row = (size_t((z - tz0) / td) * nty
+                                  + (y - ty0) / th)
+                                 * ntx;
+                    copy_scanline(y, z, yptr, &tiles[row], tx0);
+                }
+            });
+        return ok;
+    }
+
+    char* zptr = (char*)result;
+    std::vector<TileID> row_ids;
+    std::vector<ImageCacheTileRef> row_tiles;
     for (int z = zbegin; z < zend; ++z, zptr += zstride) {
         if (z < spec.z || z >= (spec.z + spec.depth)) {
             // nonexistent planes
-            if (xstride == result_pixelsize && ystride == scanlinesize) {
-                // Can zero out the plane in one shot
-                memset(zptr, 0, zplanesize);
-            } else {
-                // Non-contiguous strides -- zero out individual pixels
-                char* yptr = zptr;
-                for (int y = ybegin; y < yend; ++y, yptr += ystride) {
-                    char* xptr = yptr;
-                    for (int x = xbegin; x < xend; ++x, xptr += xstride)
-                        memset(xptr, 0, result_pixelsize);
-                }
-            }
+            char* yptr = zptr;
+            for (int y = ybegin; y < yend; ++y, yptr += ystride)
+                zero_pixels(yptr, xend - xbegin);
             continue;
         }
-        int old_tx = -100000, old_ty = -100000, old_tz = -100000;
-        int tz     = z - ((z - spec.z) % spec.tile_depth);
+        int row_ty = -100000;
+        int tz     = z - ((z - spec.z) % td);
         char* yptr = zptr;
-        int ty     = ybegin - ((ybegin - spec.y) % spec.tile_height);
-        int tyend  = ty + spec.tile_height;
         for (int y = ybegin; y < yend; ++y, yptr += ystride) {
-            if (y == tyend) {
-                ty = tyend;
-                tyend += spec.tile_height;
-            }
             if (y < spec.y || y >= (spec.y + spec.height)) {
                 // nonexistent scanlines
-                if (xstride == result_pixelsize) {
-                    // Can zero out the scanline in one shot
-                    memset(yptr, 0, scanlinesize);
-                } else {
-                    // Non-contiguous strides -- zero out individual pixels
-                    char* xptr = yptr;
-                    for (int x = xbegin; x < xend; ++x, xptr += xstride)
-                        memset(xptr, 0, result_pixelsize);
-                }
+                zero_pixels(yptr, xend - xbegin);
                 continue;
             }
-            // int ty = y - ((y - spec.y) % spec.tile_height);
-            char* xptr       = yptr;
-            const char* data = NULL;
-            for (int x = xbegin; x < xend;
-                 ++x, xptr += xstride, ++npixelsread) {
-                if (x < spec.x || x >= (spec.x + spec.width)) {
-                    // nonexistent columns
-                    memset(xptr, 0, result_pixelsize);
-                    continue;
-                }
-                int tx = x - ((x - spec.x) % spec.tile_width);
-                if (old_tx != tx || old_ty != ty || old_tz != tz) {
-                    // Only do a find_tile and re-setup of the data
-                    // pointer when we move across a tile boundary.
-                    TileID tileid(*file, subimage, miplevel, tx, ty, tz,
-                                  cache_chbegin, cache_chend);
-                    ok &= find_tile(tileid, thread_info, npixelsread == 0);
-                    if (!ok)
-                        return false;  // Just stop if file read failed
-                    old_tx = tx;
-                    old_ty = ty;
-                    old_tz = tz;
-                    data   = NULL;
-                }
-                if (!data) {
-                    ImageCacheTileRef& tile(thread_info->tile);
-                    OIIO_DASSERT(tile);
-                    data = (const char*)tile->data(x, y, z, chbegin);
-                    OIIO_DASSERT(data);
-                }
-                if (xcontig) {
-                    // Special case for a contiguous span within one tile
-                    int spanend   = std::min(tx + spec.tile_width, xend);
-                    stride_t span = spanend - x;
-                    convert_types(cachetype, data, format, xptr,
-                                  result_nchans * span);
-                    x += (span - 1);
-                    xptr += xstride * (span - 1);
-                    // no need to increment data, since next read will
-                    // be from a different tile
-                } else {
-                    convert_types(cachetype, data, format, xptr, result_nchans);
-                    data += cache_stride;
-                }
+            int ty = y - ((y - spec.y) % th);
+            if (ty != row_ty) {
+                // Entering a new row of tiles: look up all the tiles of
+                // the row that the request touches, in one batch.
+                row_ids.clear();
+                for (int tx = tx0; tx < xe; tx += tw)
+                    row_ids.emplace_back(*file, subimage, miplevel, tx, ty, tz,
+                                         cache_chbegin, cache_chend);
+                row_tiles.resize(row_ids.size());
+                if (row_ids.size()
+                    && !find_tiles(row_ids, row_tiles, thread_info))
+                    return false;  // Just stop if file read failed
+                row_ty = ty;
             }
+            copy_scanline(y, z, yptr, row_tiles.data(), tx0);
         }
     }
 
@@ -3370,6 +5657,53 @@ ImageCacheImpl::get_tile(ImageHandle* file, Perthread* thread_info,
 
 
 
+int
+ImageCacheImpl::get_tiles(ImageHandle* file, Perthread* thread_info,
+                          int subimage, int miplevel, ROI roi,
+                          span<Tile*> tiles)
+{
+    if (!thread_info)
+        thread_info = get_perthread_info();
+    file = verify_file(file, thread_info);
+    if (!file || file->broken() || file->is_udim())
+        return -1;
+    if (subimage < 0 || subimage >= file->subimages() || miplevel < 0
+        || miplevel >= file->miplevels(subimage))
+        return -1;
+    const ImageSpec& spec(file->spec(subimage, miplevel));
+    roi = roi.defined() ? roi_intersection(roi, get_roi(spec)) : get_roi(spec);
+    if (roi.width() <= 0 || roi.height() <= 0 || roi.depth() <= 0
+        || roi.nchannels() <= 0)
+        return 0;
+
+    // Snap to the tile grid and list all the tiles
+    const int tw = spec.tile_width, th = spec.tile_height;
+    const int td = std::max(spec.tile_depth, 1);
+    std::vector<TileID> ids;
+    for (int z = roi.zbegin - ((roi.zbegin - spec.z) % td); z < roi.zend;
+         z += td)
+        for (int y = roi.ybegin - ((roi.ybegin - spec.y) % th); y < roi.yend;
+             y += th)
+            for (int x = roi.xbegin - ((roi.xbegin - spec.x) % tw);
+                 x < roi.xend; x += tw)
+                ids.emplace_back(*file, subimage, miplevel, x, y, z,
+                                 roi.chbegin, roi.chend);
+    int ntiles = int(ids.size());
+    if (tiles.size() < ids.size())
+        return ntiles;
+
+    std::vector<ImageCacheTileRef> refs(ids.size());
+    if (!find_tiles(ids, refs, thread_info))
+        return -1;
+    for (int i = 0; i < ntiles; ++i) {
+        refs[i]->_incref();  // Fake an extra reference count
+        tiles[i] = (ImageCache::Tile*)refs[i].get();
+    }
+    return ntiles;
+}
+
+
+
 void
 ImageCacheImpl::release_tile(ImageCache::Tile* tile) const
 {
@@ -3466,6 +5800,97 @@ ImageCacheImpl::add_tile(ustring filename, int subimage, int miplevel, int x,
 
 
 
+bool
+ImageCacheImpl::prefetch(ustring filename, int subimage, int miplevel, ROI roi)
+{
+    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+    ImageCacheFile* file                 = find_file(filename, thread_info);
+    return prefetch(file, thread_info, subimage, miplevel, cspan<ROI>(roi));
+}
+
+
+
+bool
+ImageCacheImpl::prefetch(ImageHandle* file, Perthread* thread_info,
+                         int subimage, int miplevel, ROI roi)
+{
+    return prefetch(file, thread_info, subimage, miplevel, cspan<ROI>(roi));
+}
+
+
+
+bool
+ImageCacheImpl::prefetch(ImageHandle* file, Perthread* thread_info,
+                         int subimage, int miplevel, cspan<ROI> rois)
+{
+    if (!thread_info)
+        thread_info = get_perthread_info();
+    file = verify_file(file, thread_info);
+    if (!file || file->broken()) {
+        if (file && file->errors_should_issue())
+            error("Invalid image file \"{}\": {}", file->filename(),
+                  file->broken_error_message());
+        return false;
+    }
+    if (file->is_udim()) {
+        error("Cannot prefetch() a UDIM-like virtual file");
+        return false;
+    }
+    if (subimage < 0 || subimage >= file->subimages() || miplevel < 0
+        || miplevel >= file->miplevels(subimage)) {
+        if (file->errors_should_issue())
+            error("prefetch asked for nonexistent subimage {} MIP level {} "
+                  "of \"{}\"",
+                  subimage, miplevel, file->filename());
+        return false;
+    }
+
+    const ImageSpec& spec(file->spec(subimage, miplevel));
+    const ROI imageroi = get_roi(spec);
+    thread_pool* pool  = default_thread_pool();
+    for (ROI roi : rois) {
+        int chbegin = 0, chend = spec.nchannels;
+        if (roi.defined()) {
+            chbegin = std::max(roi.chbegin, 0);
+            chend   = std::min(roi.chend, spec.nchannels);
+            roi     = roi_intersection(roi, imageroi);
+        } else {
+            roi = imageroi;
+        }
+        if (roi.width() <= 0 || roi.height() <= 0 || roi.depth() <= 0
+            || chend <= chbegin)
+            continue;
+        // Walk the tiles overlapping the ROI, snapped to the tile grid
+        int tw = spec.tile_width, th = spec.tile_height, td = spec.tile_depth;
+        int x0 = spec.x + ((roi.xbegin - spec.x) / tw) * tw;
+        int y0 = spec.y + ((roi.ybegin - spec.y) / th) * th;
+        int z0 = spec.z + ((roi.zbegin - spec.z) / td) * td;
+        for (int z = z0; z < roi.zend; z += td) {
+            for (int y = y0; y < roi.yend; y += th) {
+                for (int x = x0; x < roi.xend; x += tw) {
+                    TileID id(*file, subimage, miplevel, x, y, z, chbegin,
+                              chend);
+                    if (tile_in_cache(id, thread_info))
+                        continue;
+                    // Enter a placeholder tile into the cache. If somebody
+                    // beat us to it, there's nothing for us to do.
+                    ImageCacheTileRef tile = new ImageCacheTile(id);
+                    if (!m_tilecache.insert_retrieve(id, tile, tile))
+                        continue;
+                    ++m_stat_prefetch_tiles;
+                    ++m_prefetch_pending;
+                    pool->push([this, tile](int /*id*/) {
+                        prefetch_task(tile);
+                    });
+                }
+            }
+        }
+    }
+    return true;
+}
+
+
+
 void
 ImageCacheImpl::invalidate(ustring filename, bool force)
 {
@@ -3495,19 +5920,14 @@ ImageCacheImpl::invalidate(ImageHandle* handle, bool force)
             return;
     }
 
-    // Iterate over the entire tilecache, record the TileID's of all
-    // tiles that are from the file we are invalidating.
-    std::vector<TileID> tiles_to_delete;
-    for (TileCache::iterator tci = m_tilecache.begin(), e = m_tilecache.end();
-         tci != e; ++tci) {
-        if (&(*tci).second->file() == file)
-            tiles_to_delete.push_back((*tci).second->id());
-    }
-    // N.B. at this point, we hold no locks!
-
-    // Safely erase all the tiles we found
-    for (const TileID& id : tiles_to_delete)
-        m_tilecache.erase(id);
+    // There's no need to hunt down the file's tiles in the tile cache, or
+    // to purge the per-thread microcaches, which would stall every thread
+    // using the cache. Invalidating the file advances its generation, and
+    // since that's part of every TileID, lookups will no longer match any
+    // of its existing tiles, and the cache sweep frees each of them as
+    // soon as it comes across it, without the usual second chance.
+    // Compressed tiles are kept apart, so drop those now.
+    drop_compressed_tiles(file.get());
 
     const ustring fingerprint = file->fingerprint();
 
@@ -3519,8 +5939,6 @@ ImageCacheImpl::invalidate(ImageHandle* handle, bool force)
         spin_lock lock(m_fingerprints_mutex);
         m_fingerprints.erase(fingerprint);
     }
-
-    purge_perthread_microcaches();
 }
 
 
@@ -3529,16 +5947,23 @@ void
 ImageCacheImpl::invalidate_all(bool force)
 {
     // Special case: invalidate EVERYTHING -- we can take some shortcuts
-    // to do it all in one shot.
+    // to do it all in one shot. Unlike for single files, whose tiles are
+    // left for the sweep, the caller wants all the memory back, so remove
+    // every tile now and have each thread flush its microcache.
     if (force) {
-        // Clear the whole tile cache
-        std::vector<TileID> tiles_to_delete;
-        for (TileCache::iterator t = m_tilecache.begin(), e = m_tilecache.end();
-             t != e; ++t) {
-            tiles_to_delete.push_back(t->second->id());
-        }
-        for (const TileID& id : tiles_to_delete)
-            m_tilecache.erase(id);
+        // Hang on to the tiles until the bin locks are released, so that
+        // freeing them doesn't hold up other threads.
+        std::vector<ImageCacheTileRef> victims;
+        victims.reserve(m_tilecache.size());
+        for (int b = 0; b < TILE_CACHE_SHARDS; ++b) {
+            m_tilecache.modify_bin(b, [&](TileCache::BinMap_t& bin) {
+                for (auto& t : bin)
+                    victims.push_back(t.second);
+                bin.clear();
+            });
+        }
+        purge_perthread_microcaches();
+        drop_compressed_tiles(nullptr);
         // Invalidate (close and clear spec) all individual files
         for (FilenameMap::iterator fileit = m_files.begin(), e = m_files.end();
              fileit != e; ++fileit) {
@@ -3546,8 +5971,10 @@ ImageCacheImpl::invalidate_all(bool force)
         }
         // Clear fingerprints list
         clear_fingerprints();
-        // Mark the per-thread microcaches as invalid
-        purge_perthread_microcaches();
+        victims.clear();  // frees the tiles nobody else holds
+        // Other threads flush their microcaches when next they use the
+        // cache, but the calling thread can do so right now.
+        get_perthread_info();
         return;
     }
 
@@ -3606,9 +6033,6 @@ ImageCacheImpl::invalidate_all(bool force)
         // print(stderr, "Invalidating {}\n", f);
         invalidate(f, true);
     }
-
-    // Mark the per-thread microcaches as invalid
-    purge_perthread_microcaches();
 }
 
 
@@ -3640,7 +6064,7 @@ ImageCacheFile::udim_setup()
 
     // If it's a literal, existing file, always treat it as a regular
     // texture, even if it has what looks like udim pattern markers.
-    if (Filesystem::exists(m_filename)) {
+    if (Filesystem::cached_exists(m_filename)) {
         return;
     }
 
@@ -3758,6 +6182,10 @@ ImageCacheImpl::resolve_udim(ImageCacheFile* udimfile, Perthread* thread_info,
         || vtile >= udimfile->m_udim_nvtiles)
         return nullptr;  // out of range
 
+    ImageCacheFile* realfile = nullptr;
+    if (thread_info && thread_info->find_udim(udimfile, utile, vtile, realfile))
+        return realfile;
+
     // If udimfile exists, then we've already inventoried the matching
     // files and filled in udimfile->udim_lookup. That vector, and the
     // filename fields, are set and can be accessed without locks. The
@@ -3767,14 +6195,15 @@ ImageCacheImpl::resolve_udim(ImageCacheFile* udimfile, Perthread* thread_info,
     UdimInfo& udiminfo(udimfile->m_udim_lookup[index]);
 
     // An empty filename in the record means that tile is not populated.
-    if (udiminfo.filename.empty())
-        return nullptr;
-
-    ImageCacheFile* realfile = udiminfo.icfile;
-    if (!realfile) {
-        realfile        = find_file(udiminfo.filename, thread_info);
-        udiminfo.icfile = realfile;
+    if (!udiminfo.filename.empty()) {
+        realfile = udiminfo.icfile;
+        if (!realfile) {
+            realfile        = find_file(udiminfo.filename, thread_info);
+            udiminfo.icfile = realfile;
+        }
     }
+    if (thread_info)
+        thread_info->remember_udim(udimfile, utile, vtile, realfile);
     return realfile;
 }
 
@@ -3803,12 +6232,43 @@ ImageCacheImpl::inventory_udim(ImageCacheFile* udimfile, Perthread* thread_info,
 
 
 
+void
+ImageCacheImpl::resident_tiles(const ImageCacheFile* file, int subimage,
+                               int miplevel,
+                               std::vector<ImageCacheTileRef>& tiles)
+{
+    if (!file)
+        return;
+    int nchannels = file->spec(subimage, miplevel).nchannels;
+    for (TileCache::iterator t = m_tilecache.begin(), e = m_tilecache.end();
+         t != e; ++t) {
+        const ImageCacheTileRef& tile((*t).second);
+        const TileID& id(tile->id());
+        if (id.file_ptr() == file && id.subimage() == subimage
+            && id.miplevel() == miplevel && id.chbegin() == 0
+            && id.chend() == nchannels && id.colortransformid() == 0
+            && tile->pixels_ready() && tile->valid())
+            tiles.push_back(tile);
+    }
+}
+
+
+
 ImageCachePerThreadInfo*
 ImageCacheImpl::create_thread_info()
 {
     ImageCachePerThreadInfo* p = new ImageCachePerThreadInfo;
+    p->reset_microcache(m_microcache_size);
     // printf ("New perthread %p\n", (void *)p);
     spin_lock lock(m_perthread_info_mutex);
+    // Reuse the slot of one that was destroyed, so that apps that make a
+    // ThreadContext per task don't grow the list without bound.
+    for (auto& slot : m_all_perthread_info) {
+        if (!slot) {
+            slot.reset(p);
+            return p;
+        }
+    }
     m_all_perthread_info.emplace_back(p);
     return p;
 }
@@ -3823,6 +6283,10 @@ ImageCacheImpl::destroy_thread_info(ImageCachePerThreadInfo* thread_info)
     // the ImageCache owns the thread_infos associated with it,
     // so all we need to do is find the entry and reset the unique pointer
     // to fully destroy the object
+    // Don't leave a dangling binding if this thread was still bound to it.
+    PerThreadInfoSlot& slot(imagecache_per_thread_slot);
+    if (slot.imagecache_id == imagecache_id && slot.thread_info == thread_info)
+        bind_thread_info(nullptr);
     spin_lock lock(m_perthread_info_mutex);
     for (auto& p : m_all_perthread_info) {
         if (p.get() == thread_info) {
@@ -3834,29 +6298,69 @@ ImageCacheImpl::destroy_thread_info(ImageCachePerThreadInfo* thread_info)
 
 
 
+void
+ImageCacheImpl::bind_thread_info(ImageCachePerThreadInfo* thread_info)
+{
+    PerThreadInfoSlot& slot(imagecache_per_thread_slot);
+    if (thread_info) {
+        ImageCachePerThreadInfo*& ptr
+            = imagecache_per_thread_infos[imagecache_id];
+        // Remember what we displaced, unless it was itself a binding
+        if (imagecache_unbound_thread_infos.find(imagecache_id)
+            == imagecache_unbound_thread_infos.end())
+            imagecache_unbound_thread_infos[imagecache_id] = ptr;
+        ptr                = thread_info;
+        slot.imagecache_id = imagecache_id;
+        slot.thread_info   = thread_info;
+    } else {
+        // Go back to the Perthread the thread had before it was bound,
+        // rather than leaving it to make (and leak) a new one.
+        auto saved = imagecache_unbound_thread_infos.find(imagecache_id);
+        if (saved != imagecache_unbound_thread_infos.end() && saved->second) {
+            imagecache_per_thread_infos[imagecache_id] = saved->second;
+        } else {
+            imagecache_per_thread_infos.erase(imagecache_id);
+        }
+        if (saved != imagecache_unbound_thread_infos.end())
+            imagecache_unbound_thread_infos.erase(saved);
+        if (slot.imagecache_id == imagecache_id)
+            slot = PerThreadInfoSlot();
+    }
+}
+
+
+
 ImageCachePerThreadInfo*
 ImageCacheImpl::get_perthread_info(ImageCachePerThreadInfo* p)
 {
     if (!p) {
         // user has not provided an ImageCachePerThreadInfo yet
-        ImageCachePerThreadInfo*& ptr
-            = imagecache_per_thread_infos[imagecache_id];
-        p = ptr;
-        if (!p) {
-            // this thread doesn't have a ImageCachePerThreadInfo for this ImageCacheImpl yet
-            ptr = p = new ImageCachePerThreadInfo;
-            // printf ("New perthread %p\n", (void *)p);
-            spin_lock lock(m_perthread_info_mutex);
-            m_all_perthread_info.emplace_back(p);
+        PerThreadInfoSlot& slot(imagecache_per_thread_slot);
+        if (slot.imagecache_id == imagecache_id) {
+            p = slot.thread_info;
+        } else {
+            ImageCachePerThreadInfo*& ptr
+                = imagecache_per_thread_infos[imagecache_id];
+            p = ptr;
+            if (!p) {
+                // this thread doesn't have a ImageCachePerThreadInfo for this ImageCacheImpl yet
+                ptr = p = new ImageCachePerThreadInfo;
+                p->reset_microcache(m_microcache_size);
+                // printf ("New perthread %p\n", (void *)p);
+                spin_lock lock(m_perthread_info_mutex);
+                m_all_perthread_info.emplace_back(p);
+            }
+            slot.imagecache_id = imagecache_id;
+            slot.thread_info   = p;
         }
     }
     if (p->purge) {  // has somebody requested a tile purge?
         // This is safe, because it's our thread.
         spin_lock lock(m_perthread_info_mutex);
-        p->tile     = NULL;
-        p->lasttile = NULL;
-        p->purge    = 0;
+        p->reset_microcache(m_microcache_size);
+        p->purge = 0;
         p->m_thread_files.clear();
+        p->clear_udims();
     }
     return p;
 }
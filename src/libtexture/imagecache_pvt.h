@@ -10,13 +10,22 @@
 #ifndef OPENIMAGEIO_IMAGECACHE_PVT_H
 #define OPENIMAGEIO_IMAGECACHE_PVT_H
 
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 #include <tsl/robin_map.h>
 
 #include <OpenImageIO/Imath.h>
+#include <OpenImageIO/color.h>
 #include <OpenImageIO/export.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/function_view.h>
 #include <OpenImageIO/hash.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/refcnt.h>
+#include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/texture.h>
 #include <OpenImageIO/timer.h>
 #include <OpenImageIO/unordered_map_concurrent.h>
@@ -41,6 +50,7 @@ namespace pvt {
 
 struct TileID;
 class ImageCacheImpl;
+class DetachableFileProxy;
 class ImageCachePerThreadInfo;
 
 const char*
@@ -59,6 +69,7 @@ struct ImageCacheStatistics {
     // First, the ImageCache-specific fields:
     long long find_tile_calls;
     long long find_tile_microcache_misses;
+    long long find_tile_microcache_hits;  // found in the set-assoc. part
     int find_tile_cache_misses;
     long long files_totalsize;
     long long files_totalsize_ondisk;
@@ -78,6 +89,21 @@ struct ImageCacheStatistics {
     double tile_locking_time;
     double find_file_time;
     double find_tile_time;
+    long long tiles_mmapped;         // tiles pointing into a file mapping
+    long long tiles_constant_shared;  // constant tiles sharing their pixels
+    long long tiles_constant_synthesized;  // constant tiles made w/o reading
+    long long tiles_read_ahead;      // neighbors read along with a miss
+    long long tiles_from_slab;       // autotiles revived without decoding
+    long long numa_local_hits;       // hits on tiles on our NUMA node
+    long long numa_remote_hits;      // hits on tiles on another node
+    long long tiles_compressed;      // cold tiles compressed, not dropped
+    long long tiles_uncompressed;    // compressed tiles brought back
+    long long compress_bytes_in;     // raw bytes of tiles compressed
+    long long compress_bytes_out;    // bytes they compressed to
+    double compress_time;
+    double uncompress_time;
+    long long tiles_colorconverted;  // tiles color converted as read
+    double colorconvert_time;
 
     // TextureSystem-specific fields below:
     long long texture_queries;
@@ -192,6 +218,25 @@ public:
     bool read_tile(ImageCachePerThreadInfo* thread_info, const TileID& id,
                    void* data);
 
+    /// If the tile is stored raw in the file, exactly as the cache would
+    /// hold it, return a pointer to its pixels in a read-only memory
+    /// mapping of the file, and set `mapping` to the mapping so the tile
+    /// can keep it alive. Otherwise return nullptr.
+    const char*
+    map_tile(ImageCachePerThreadInfo* thread_info, const TileID& id,
+             std::shared_ptr<Filesystem::IOMMapReader>& mapping);
+
+    /// If the tile is emulated for an autotiled scanline image, set
+    /// `pixels` to point to it within the "slab" holding its whole row of
+    /// tiles, set `slab` to the slab so the tile can keep it alive, and
+    /// return true. The row is decoded into a new slab (whose other tiles
+    /// are added to the cache, too) unless a live slab already holds it.
+    /// If the decode fails, `pixels` is set to nullptr. Return false for
+    /// any other kind of tile. The whole slab is charged to the cache
+    /// until the last tile holding it is freed.
+    bool slab_tile(ImageCachePerThreadInfo* thread_info, const TileID& id,
+                   std::shared_ptr<char>& slab, const char*& pixels);
+
     /// Mark the file as recently used.
     ///
     void use(void) { m_used = true; }
@@ -223,6 +268,12 @@ public:
 
     void invalidate();
 
+    /// The file's generation, which invalidate() advances. Tiles remember
+    /// the generation they were made in (in their TileID), so that once the
+    /// file is invalidated, lookups no longer match them, and the cache
+    /// sweep reclaims them at its leisure.
+    int generation() const { return m_generation; }
+
     size_t timesopened() const { return m_timesopened; }
     size_t tilesread() const { return m_tilesread; }
     imagesize_t bytesread() const { return m_bytesread; }
@@ -238,8 +289,49 @@ public:
         m_redundant_bytesread += (long long)bytesread;
     }
 
+    /// Texture lookup statistics for this file, which the TextureSystem
+    /// only keeps when its "statistics:level" is 3 or more. Hits on MIP
+    /// levels past the last counter are lumped into it.
+    enum { texture_mip_counters = 16 };
+    void count_texture_query(long long probes, long long nanoseconds)
+    {
+        m_texture_queries += 1;
+        m_texture_probes += probes;
+        m_texture_nanoseconds += nanoseconds;
+    }
+    void count_texture_queries(long long queries, long long probes,
+                               long long nanoseconds)
+    {
+        m_texture_queries += queries;
+        m_texture_probes += probes;
+        m_texture_nanoseconds += nanoseconds;
+    }
+    void count_texture_miplevel(int miplevel)
+    {
+        m_texture_mip_hits[std::min(miplevel, texture_mip_counters - 1)] += 1;
+    }
+    long long texture_queries() const { return m_texture_queries.load(); }
+    long long texture_probes() const { return m_texture_probes.load(); }
+    double texture_time() const { return m_texture_nanoseconds * 1.0e-9; }
+    long long texture_mip_hits(int miplevel) const
+    {
+        return m_texture_mip_hits[miplevel].load();
+    }
+
     std::time_t mod_time() const { return m_mod_time; }
     ustring fingerprint() const { return m_fingerprint; }
+
+    /// Eviction priority hint: > 0 keeps this file's tiles longer, < 0
+    /// evicts them as soon as possible.
+    int evict_priority() const { return m_evict_priority; }
+    void evict_priority(int p) { m_evict_priority = p; }
+    /// Tile memory quota for this file (0 means no quota).
+    long long max_tile_mem() const { return m_max_tile_mem; }
+    void max_tile_mem(long long bytes) { m_max_tile_mem = bytes; }
+    /// Memory used by this file's tiles.
+    long long tile_mem() const { return m_tile_mem; }
+    void incr_tile_mem(long long bytes) { m_tile_mem += bytes; }
+
     void duplicate(ImageCacheFile* dup) { m_duplicate = dup; }
     ImageCacheFile* duplicate() const { return m_duplicate; }
 
@@ -279,6 +371,9 @@ public:
         bool is_constant_image   = false;  ///< Is the image a constant color?
         bool has_average_color   = false;  ///< We have an average color
         std::vector<float> average_color;  ///< Average color
+        /// Tiles of MIP level 0 that maketx recorded as one constant
+        /// color, with their values, by tile index.
+        std::unordered_map<int, std::vector<float>> constant_tiles;
         spin_mutex average_color_mutex;    ///< protect average_color
         std::unique_ptr<Imath::M44f> Mlocal;  ///< shadows/volumes: world-to-local
         // The scale/offset accounts for crops or overscans, converting
@@ -372,6 +467,14 @@ private:
         // access directly. ALWAYS retrieve its value with get_imageinput
         // (it's thread-safe to use that result) and set its value with
         // set_imageinput -- those are guaranteed thread-safe.
+#endif
+    // The proxy m_input reads through, if the cache can close its file
+    // descriptor without closing m_input. Set along with m_input (by
+    // set_imageinput), and likewise only accessed atomically.
+#if __cpp_lib_atomic_shared_ptr >= 201711L
+    std::atomic<std::shared_ptr<DetachableFileProxy>> m_fdproxy;
+#else
+    std::shared_ptr<DetachableFileProxy> m_fdproxy;
 #endif
     std::vector<SubimageInfo> m_subimages;  ///< Info on each subimage
     TexFormat m_texformat;                  ///< Which texture format
@@ -385,6 +488,7 @@ private:
     short m_udim_nvtiles;         ///< Number of v tiles (0 if not a udim)
     ustring m_fileformat;         ///< File format name
     size_t m_tilesread;           ///< Tiles read from this file
+    atomic_int m_generation { 0 };  ///< Times the file was invalidated
     imagesize_t m_bytesread;      ///< Bytes read from this file
     atomic_ll m_redundant_tiles;  ///< Redundant tile reads
     atomic_ll m_redundant_bytesread;     ///< Redundant bytes read
@@ -401,6 +505,22 @@ private:
     std::time_t m_mod_time;         ///< Time file was last updated
     ustring m_fingerprint;          ///< Optional cryptographic fingerprint
     ImageCacheFile* m_duplicate;    ///< Is this a duplicate?
+    std::atomic<int> m_evict_priority { 0 };  ///< Eviction priority hint
+    atomic_ll m_max_tile_mem { 0 };            ///< Tile memory quota
+    atomic_ll m_texture_queries { 0 };         ///< Texture lookups
+    atomic_ll m_texture_probes { 0 };          ///< Samples of those lookups
+    atomic_ll m_texture_nanoseconds { 0 };     ///< Time spent in them
+    atomic_ll m_texture_mip_hits[texture_mip_counters] {};  ///< Per level
+    atomic_ll m_tile_mem { 0 };               ///< Tile memory in use
+    std::shared_ptr<Filesystem::IOMMapReader> m_mmap;  ///< File mapping
+    bool m_mmap_failed = false;  ///< Don't keep trying to map the file
+    // Slabs of decoded scanlines, each shared by the tiles of one tile row
+    // of an autotiled image (keyed by the ID of the row's first tile), so
+    // that a tile evicted while its neighbors live on comes back without
+    // decoding anything.
+    struct SlabMap;  // map of TileID to weak_ptr, in imagecache.cpp
+    spin_mutex m_slabs_mutex;          ///< Protects m_slabs
+    std::unique_ptr<SlabMap> m_slabs;  ///< Created on first use
     imagesize_t m_total_imagesize;  ///< Total size, uncompressed
     imagesize_t m_total_imagesize_ondisk;  ///< Total size, compressed on disk
     ImageInput::Creator m_inputcreator;    ///< Custom ImageInput-creator
@@ -415,9 +535,11 @@ private:
     get_imageinput(ImageCachePerThreadInfo* thread_info);
 
     // Safely replace the existing ImageInput shared pointer with the one in
-    // newval. Ensure that the cache still knows how many open ImageInputs
-    // there are in total.
-    void set_imageinput(std::shared_ptr<ImageInput> newval);
+    // newval (and the proxy it reads through, if it's one whose descriptor
+    // the cache may close). Ensure that the cache still knows how many
+    // open ImageInputs there are in total.
+    void set_imageinput(std::shared_ptr<ImageInput> newval,
+                        std::shared_ptr<DetachableFileProxy> fdproxy = {});
 
     /// Retrieve a shared pointer to the file's open ImageInput (opening if
     /// necessary, and maintaining the limit on number of open files). For a
@@ -425,6 +547,21 @@ private:
     /// requires no external lock.
     std::shared_ptr<ImageInput> open(ImageCachePerThreadInfo* thread_info);
 
+    /// If the cache's header index has a current entry for this file, set
+    /// up the subimages from it without opening the file (marking the file
+    /// broken if they show it to be unusable, as open() would), and return
+    /// true. The caller must hold m_input_mutex.
+    bool open_from_index(ImageCachePerThreadInfo* thread_info);
+
+    /// Fill in m_subimages from the file's native specs, applying the
+    /// cache's tiling and MIP-mapping policies. `nativespec` holds the
+    /// spec of subimage 0, MIP level 0; `seek` retrieves the others,
+    /// returning false past the last level or subimage. On failure, mark
+    /// the file broken and return false.
+    bool init_subimages(ImageCachePerThreadInfo* thread_info,
+                        ImageSpec nativespec, string_view formatname,
+                        function_view<bool(int, int, ImageSpec&)> seek);
+
     /// Release the ImageInput, if currently open. It will close and destroy
     /// when the last thread holding it is done with its shared ptr. This
     /// is thread-safe, no need to hold a lock to call it. It will close the
@@ -497,6 +634,7 @@ struct TileID {
         , m_chbegin(chbegin)
         , m_chend(chend)
         , m_colortransformid(colortransformid)
+        , m_generation(file.generation())
         , m_file(&file)
     {
         if (chend < chbegin) {
@@ -520,6 +658,7 @@ struct TileID {
     int chend() const { return m_chend; }
     int nchannels() const { return m_chend - m_chbegin; }
     int colortransformid() const { return m_colortransformid; }
+    int generation() const { return m_generation; }
 
     void x(int v) { m_x = v; }
     void y(int v) { m_y = v; }
@@ -549,7 +688,8 @@ struct TileID {
                 && a.m_subimage == b.m_subimage && a.m_miplevel == b.m_miplevel
                 && (a.m_file == b.m_file) && a.m_chbegin == b.m_chbegin
                 && a.m_chend == b.m_chend
-                && a.m_colortransformid == b.m_colortransformid);
+                && a.m_colortransformid == b.m_colortransformid
+                && a.m_generation == b.m_generation);
     }
 
     /// Do the two ID's refer to the same tile?
@@ -563,7 +703,8 @@ struct TileID {
         static constexpr size_t member_size
             = sizeof(m_x) + sizeof(m_y) + sizeof(m_z) + sizeof(m_subimage)
               + sizeof(m_miplevel) + sizeof(m_chbegin) + sizeof(m_chend)
-              + sizeof(m_colortransformid) + sizeof(m_padding) + sizeof(m_file);
+              + sizeof(m_colortransformid) + sizeof(m_generation)
+              + sizeof(m_file);
         static_assert(
             sizeof(*this) == member_size,
             "All TileID members must be accounted for so we can hash the entire class.");
@@ -596,12 +737,27 @@ private:
     int m_miplevel;            ///< MIP-map level
     short m_chbegin, m_chend;  ///< Channel range
     int m_colortransformid;    ///< Colorspace id (0 == default)
-    int m_padding = 0;         ///< Unused
+    int m_generation = 0;      ///< File generation the tile belongs to
     ImageCacheFile* m_file;    ///< Which ImageCacheFile we refer to
 };
 
 
 
+/// Frees the pixels of a tile, which are page-aligned when they were
+/// placed on a NUMA node.
+struct TilePixelsDeleter {
+    bool aligned = false;
+    void operator()(char* p) const
+    {
+        if (aligned)
+            aligned_free(p);
+        else
+            delete[] p;
+    }
+};
+
+
+
 /// Record for a single image tile.
 ///
 class ImageCacheTile final : public RefCnt {
@@ -615,6 +771,11 @@ public:
                    stride_t xstride, stride_t ystride, stride_t zstride,
                    bool copy = true);
 
+    /// Construct a tile whose pixels are at `pels` within a slab shared
+    /// with the other tiles of its row (see ImageCacheFile::slab_tile).
+    ImageCacheTile(const TileID& id, std::shared_ptr<char> slab,
+                   const char* pels);
+
     ~ImageCacheTile();
 
     /// Actually read the pixels.  The caller had better be the thread that
@@ -652,6 +813,15 @@ public:
 
     const ImageCacheFile& file() const { return m_id.file(); }
 
+    /// Which shard of the tile cache holds this tile?
+    int shard() const { return m_shard; }
+
+    /// Does somebody else own the pixel memory?
+    bool nofree() const { return m_nofree; }
+
+    /// Are the pixels a constant block shared with other tiles?
+    bool shared_constant() const { return m_shared_pixels != nullptr; }
+
     /// Return the actual allocated memory size for this tile's pixels.
     ///
     size_t memsize() const { return m_pixels_size; }
@@ -660,20 +830,45 @@ public:
     ///
     size_t memsize_needed() const;
 
+    /// Return how much evicting this tile goes toward freeing memory: its
+    /// own pixels or, if they're in a slab, its part of the slab, which
+    /// is freed along with the last tile holding it.
+    size_t evict_credit() const { return m_pixels_size + m_slab_share; }
+
     /// Mark the tile as recently used.
     ///
     void use() { m_used = 1; }
 
+    /// Has the tile's file been invalidated since the tile was made?
+    bool stale() const { return m_id.generation() != file().generation(); }
+
     /// Mark the tile as not recently used, return its previous value.
-    ///
+    /// The file's eviction priority adjusts this: a negative priority
+    /// lets the tile go right away, and a positive one gives it that many
+    /// extra sweeps of grace after its last use.
     bool release()
     {
-        if (!pixels_ready() || !valid())
-            return true;  // Don't really release invalid or unready tiles
+        if (!pixels_ready())
+            return true;  // Don't really release unready tiles
+        if (stale())
+            return false;  // The file was invalidated, let it go right away
+        if (!valid())
+            return true;  // Don't really release invalid tiles
+        int priority = file().evict_priority();
+        if (priority < 0)
+            return false;
         // If m_used is 1, set it to zero and return true.  If it was already
-        // zero, it's fine and return false.
+        // zero, it's fine and return false (unless there is grace left).
         int one = 1;
-        return m_used.compare_exchange_strong(one, 0);
+        if (m_used.compare_exchange_strong(one, 0)) {
+            m_grace = priority;
+            return true;
+        }
+        if (m_grace > 0) {
+            --m_grace;
+            return true;
+        }
+        return false;
     }
 
     /// Has this tile been recently used?
@@ -690,9 +885,17 @@ public:
     ///
     void wait_pixels_ready() const;
 
+    /// Claim responsibility for reading this tile's pixels. Only the first
+    /// caller will get `true` back and must then call read(); everybody
+    /// else should call wait_pixels_ready().
+    bool claim_read() { return !m_read_claimed.exchange(true); }
+
     int channelsize() const { return m_channelsize; }
     int pixelsize() const { return m_pixelsize; }
 
+    /// NUMA node the pixels were placed on, or -1 if they weren't.
+    int numa_node() const { return m_numa_node; }
+
     // 1D index of the 2D tile coordinate. 64 bit safe.
     imagesize_t pixel_index(int tile_s, int tile_t) const
     {
@@ -707,18 +910,26 @@ public:
     }
 
 private:
-    TileID m_id;                       ///< ID of this tile
-    std::unique_ptr<char[]> m_pixels;  ///< The pixel data
+    TileID m_id;  ///< ID of this tile
+    std::unique_ptr<char[], TilePixelsDeleter> m_pixels;  ///< The pixel data
     size_t m_pixels_size { 0 };        ///< How much m_pixels has allocated
     int m_channelsize { 0 };           ///< How big is each channel (bytes)
     int m_pixelsize { 0 };             ///< How big is each pixel (bytes)
     int m_tile_width { 0 };            ///< Tile width
+    int m_shard { 0 };                 ///< Tile cache shard holding the tile
     bool m_valid { false };            ///< Valid pixels
     bool m_nofree { false };  ///< We do NOT own the pixels, do not free!
     volatile bool m_pixels_ready {
         false
     };                        ///< The pixels have been read from disk
     atomic_int m_used { 1 };  ///< Used recently
+    int m_grace { 0 };        ///< Sweeps to survive unused (priority)
+    short m_numa_node { -1 };  ///< NUMA node of the pixels (-1 if unplaced)
+    std::shared_ptr<Filesystem::IOMMapReader> m_mapping;  ///< Mapped pixels
+    std::shared_ptr<const char> m_shared_pixels;  ///< Shared constant pixels
+    std::shared_ptr<char> m_slab;  ///< Tile row slab holding the pixels
+    size_t m_slab_share { 0 };     ///< Our part of m_slab, in bytes
+    std::atomic<bool> m_read_claimed { false };  ///< Somebody is reading it
 };
 
 
@@ -737,6 +948,18 @@ typedef unordered_map_concurrent<
     TileCache;
 
 
+/// One entry of the optional per-thread tile access trace.
+struct TileTraceRecord {
+    double time;                 ///< Seconds since tracing started
+    const ImageCacheFile* file;  ///< File the tile belongs to
+    float latency;               ///< Seconds to read it (misses only)
+    int x, y, z;                 ///< Tile origin
+    short subimage, miplevel;
+    bool hit;  ///< Found in the cache (otherwise it was read)
+};
+
+
+
 /// A very small amount of per-thread data that saves us from locking
 /// the mutex quite as often.  We store things here used by both
 /// ImageCache and TextureSystem, so they don't each need a costly
@@ -751,11 +974,51 @@ public:
     using ThreadFilenameMap = tsl::robin_map<ustring, ImageCacheFile*>;
     ThreadFilenameMap m_thread_files;
 
-    // We have a two-tile "microcache", storing the last two tiles needed.
-    ImageCacheTileRef tile, lasttile;
+    // The tile needed most recently. Those needed before it are kept in a
+    // small set-associative "microcache": a TileID's hash picks one set of
+    // microcache_ways entries, ordered most recently used first. Lookups
+    // that cycle among a handful of tiles (the ones a filter footprint
+    // straddles, or tiles of several textures at once) mostly stay here
+    // rather than going to the shared tile cache.
+    ImageCacheTileRef tile;
+    static constexpr int microcache_ways = 4;
+    std::vector<ImageCacheTileRef> m_microcache;  // sets * ways entries
+    size_t m_microcache_setmask = 0;
     atomic_int purge;  // If set, tile ptrs need purging!
     ImageCacheStatistics m_stats;
 
+    // Ring buffer of recent tile accesses, when tracing is on. The mutex
+    // is only ever contended while the trace is being written out.
+    std::vector<TileTraceRecord> m_trace;
+    size_t m_trace_count = 0;  // Records added since the buffer was sized
+    spin_mutex m_trace_mutex;
+
+    // The NUMA node this thread runs on, re-checked every so often since
+    // threads can migrate.
+    int numa_node()
+    {
+        if (m_numa_node < 0 || ++m_numa_checks >= 256) {
+            m_numa_node   = Sysutil::current_numa_node();
+            m_numa_checks = 0;
+        }
+        return m_numa_node;
+    }
+    int m_numa_node   = -1;
+    int m_numa_checks = 0;
+
+    // A few recently resolved UDIM tiles, so that runs of lookups landing
+    // on the same tile skip the shared UdimInfo table. Tiles that aren't
+    // populated are remembered too, as nullptr.
+    struct UdimCacheEntry {
+        const ImageCacheFile* udimfile = nullptr;
+        int generation                 = 0;  // udimfile's, when resolved
+        int utile = -1, vtile = -1;
+        ImageCacheFile* file = nullptr;
+    };
+    static constexpr int udim_cache_size = 4;
+    UdimCacheEntry m_udim_cache[udim_cache_size];
+    int m_udim_cache_next = 0;
+
     ImageCachePerThreadInfo()
     {
         // std::cout << "Creating PerThreadInfo " << (void*)this << "\n";
@@ -767,6 +1030,73 @@ public:
         // std::cout << "Destroying PerThreadInfo " << (void*)this << "\n";
     }
 
+    // Drop all tile refs and size the tile microcache to hold about
+    // `entries` tiles besides `tile` (rounded up to whole sets of a power
+    // of two count; 0 disables it).
+    void reset_microcache(int entries)
+    {
+        tile = nullptr;
+        m_microcache.clear();
+        int sets = entries > 0 ? ceil2((entries + microcache_ways - 1)
+                                       / microcache_ways)
+                               : 0;
+        m_microcache.resize(size_t(sets) * microcache_ways);
+        m_microcache_setmask = sets ? size_t(sets - 1) : 0;
+    }
+
+    // The microcache set that a tile with the given TileID hash maps to.
+    ImageCacheTileRef* microcache_set(size_t hash)
+    {
+        return &m_microcache[(hash & m_microcache_setmask) * microcache_ways];
+    }
+
+    // Put t in the microcache as the most recently used of its set,
+    // evicting the least recently used one.
+    void microcache_insert(ImageCacheTileRef&& t)
+    {
+        if (!t || m_microcache.empty())
+            return;
+        ImageCacheTileRef* set = microcache_set(t->id().hash());
+        for (int w = microcache_ways - 1; w > 0; --w)
+            set[w] = std::move(set[w - 1]);
+        set[0] = std::move(t);
+    }
+
+    // If the microcache holds the tile for id, make it the current `tile`
+    // (retiring the old one to the microcache) and return true.
+    bool microcache_find(const TileID& id)
+    {
+        if (m_microcache.empty())
+            return false;
+        ImageCacheTileRef* set = microcache_set(id.hash());
+        for (int w = 0; w < microcache_ways && set[w]; ++w) {
+            if (set[w]->id() == id) {
+                ImageCacheTileRef found(std::move(set[w]));
+                for (; w < microcache_ways - 1; ++w)
+                    set[w] = std::move(set[w + 1]);
+                set[microcache_ways - 1] = nullptr;
+                microcache_insert(std::move(tile));
+                tile = std::move(found);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The microcache entry for id (or nullptr), without reordering.
+    ImageCacheTile* microcache_peek(const TileID& id) const
+    {
+        if (m_microcache.empty())
+            return nullptr;
+        const ImageCacheTileRef* set
+            = &m_microcache[(id.hash() & m_microcache_setmask)
+                            * microcache_ways];
+        for (int w = 0; w < microcache_ways && set[w]; ++w)
+            if (set[w]->id() == id)
+                return set[w].get();
+        return nullptr;
+    }
+
     // Add a new filename/fileptr pair to our microcache
     void remember_filename(ustring n, ImageCacheFile* f)
     {
@@ -779,6 +1109,168 @@ public:
         auto f = m_thread_files.find(n);
         return f == m_thread_files.end() ? nullptr : f->second;
     }
+
+    // See if a UDIM tile is in the microcache. Return true and set `file`
+    // if it is.
+    bool find_udim(const ImageCacheFile* udimfile, int utile, int vtile,
+                   ImageCacheFile*& file) const
+    {
+        for (const auto& e : m_udim_cache) {
+            if (e.udimfile == udimfile && e.utile == utile
+                && e.vtile == vtile
+                && e.generation == udimfile->generation()) {
+                file = e.file;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Add a resolved UDIM tile to the microcache, replacing the oldest.
+    void remember_udim(const ImageCacheFile* udimfile, int utile, int vtile,
+                       ImageCacheFile* file)
+    {
+        UdimCacheEntry& e(m_udim_cache[m_udim_cache_next]);
+        e.udimfile        = udimfile;
+        e.generation      = udimfile->generation();
+        e.utile           = utile;
+        e.vtile           = vtile;
+        e.file            = file;
+        m_udim_cache_next = (m_udim_cache_next + 1) % udim_cache_size;
+    }
+
+    void clear_udims()
+    {
+        for (auto& e : m_udim_cache)
+            e = UdimCacheEntry();
+        m_udim_cache_next = 0;
+    }
+};
+
+
+
+/// A persistent, size-bounded store of decoded tiles on local disk, which
+/// serves as a second level of caching beneath the in-memory tile cache.
+/// Each tile is a file, named by a hash of a key string (which the caller
+/// builds from the file fingerprint and TileID) and containing the full
+/// key so that hash collisions are detected. Because the tiles persist,
+/// successive processes on the same machine can share them, which spares
+/// them from repeating network reads and decompression.
+///
+/// All methods are thread-safe. The directory may also be shared by
+/// several processes: tiles are written to a temporary file and renamed
+/// into place, so readers never see a partial tile. Each process trims
+/// the store to its size limit, least recently used tiles first, based on
+/// what it found when the directory was opened plus what it has since
+/// read or written.
+class DiskTileCache {
+public:
+    DiskTileCache() {}
+    DiskTileCache(const DiskTileCache&) = delete;
+
+    /// Use the given directory (creating it if needed) for the store,
+    /// holding at most `max_bytes`. An empty path disables the store.
+    /// Return true for success, false (and disable the store) if the
+    /// directory could not be used, setting `err` to say why.
+    bool init(string_view path, int64_t max_bytes, std::string& err);
+
+    /// Change the size limit, trimming the store if necessary.
+    void set_max_bytes(int64_t max_bytes);
+
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    std::string path() const;
+    int64_t max_bytes() const { return m_max_bytes; }
+    int64_t bytes_used() const { return m_bytes_used; }
+
+    /// Look for the tile with the given key, and if it is present and
+    /// exactly `size` bytes, read it into `data` and return true.
+    bool read(string_view key, void* data, size_t size);
+
+    /// Store `size` bytes of tile data under the given key.
+    void write(string_view key, const void* data, size_t size);
+
+    atomic_ll m_stat_hits { 0 };          ///< Tiles read from disk cache
+    atomic_ll m_stat_misses { 0 };        ///< Tiles not in the disk cache
+    atomic_ll m_stat_writes { 0 };        ///< Tiles written to disk cache
+    atomic_ll m_stat_evictions { 0 };     ///< Tiles trimmed from the store
+    atomic_ll m_stat_bytes_read { 0 };    ///< Bytes read from disk cache
+    atomic_ll m_stat_bytes_written { 0 };  ///< Bytes written to disk cache
+
+private:
+    struct Entry {
+        std::string name;  ///< Full path of the tile file
+        int64_t size;      ///< Bytes on disk
+    };
+    typedef std::list<Entry> LRUList;
+
+    // These must be called with m_mutex held.
+    std::string tilename(string_view key) const;
+    void touch(const std::string& name, int64_t size);
+    void trim();
+
+    mutable std::mutex m_mutex;  ///< Protects everything below
+    std::string m_path;          ///< Directory holding the store
+    LRUList m_lru;               ///< Tiles, most recently used first
+    tsl::robin_map<std::string, LRUList::iterator> m_index;  ///< Find in LRU
+    std::atomic<bool> m_enabled { false };  ///< Is the store in use?
+    atomic_ll m_max_bytes { 4096LL << 20 };  ///< Size limit
+    atomic_ll m_bytes_used { 0 };           ///< Sum of sizes in m_lru
+};
+
+
+
+/// HeaderIndex is an optional persistent index of image file headers: the
+/// native ImageSpec of every subimage and MIP level of each file the cache
+/// opens, kept in a directory so that later processes can set up a file
+/// (answering get_imagespec, get_image_info, and texture lookups' setup)
+/// without opening it until its pixels are needed.
+///
+/// Entries are keyed by filename and are used only while the file's size
+/// and modification time match those recorded. Like the DiskTileCache,
+/// each entry is a separate file written under a temporary name and
+/// renamed into place, so the directory may be shared by several
+/// processes and needs no explicit saving.
+class HeaderIndex {
+public:
+    struct Entry {
+        std::string format;       ///< Format name of the file's reader
+        std::string fingerprint;  ///< Content fingerprint, if computed
+        /// Native spec of each MIP level of each subimage
+        std::vector<std::vector<ImageSpec>> specs;
+    };
+
+    HeaderIndex() {}
+    HeaderIndex(const HeaderIndex&) = delete;
+
+    /// Use the given directory (creating it if needed) for the index. An
+    /// empty path disables the index. Return true for success, false (and
+    /// disable the index) if the directory could not be used, setting
+    /// `err` to say why.
+    bool init(string_view path, std::string& err);
+
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    std::string path() const;
+
+    /// Look for the entry with the given key, and if it is present and
+    /// was recorded for a file of this size and modification time, fill
+    /// in `entry` and return true.
+    bool read(string_view key, int64_t size, int64_t mtime, Entry& entry);
+
+    /// Store the entry for a file of the given size and modification time
+    /// under the given key.
+    void write(string_view key, int64_t size, int64_t mtime,
+               const Entry& entry);
+
+    atomic_ll m_stat_hits { 0 };    ///< Files set up from the index
+    atomic_ll m_stat_misses { 0 };  ///< Files not (validly) in the index
+    atomic_ll m_stat_writes { 0 };  ///< Entries written to the index
+
+private:
+    std::string entryname(string_view key) const;
+
+    mutable std::mutex m_mutex;             ///< Protects m_path
+    std::string m_path;                     ///< Directory holding the index
+    std::atomic<bool> m_enabled { false };  ///< Is the index in use?
 };
 
 
@@ -816,6 +1308,11 @@ public:
 
     TypeDesc getattributetype(string_view name) const override;
 
+    bool attribute(ImageHandle* file, string_view name, TypeDesc type,
+                   const void* val) override;
+    bool getattribute(ImageHandle* file, string_view name, TypeDesc type,
+                      void* val) const override;
+
     bool getattribute(string_view name, TypeDesc type,
                       void* val) const override;
     bool getattribute(string_view name, int& val) const override
@@ -856,10 +1353,22 @@ public:
     bool autoscanline() const { return m_autoscanline; }
     bool automip() const { return m_automip; }
     bool forcefloat() const { return m_forcefloat; }
+    bool mmap_tiles() const { return m_mmap_tiles; }
+    /// The shared io_uring ring, if the "io_uring" option is on and the
+    /// platform supports it, otherwise null.
+    std::shared_ptr<Filesystem::IOUring> io_uring_ring() const
+    {
+        return std::atomic_load(&m_io_uring_ring);
+    }
+    int read_ahead_tiles() const { return m_read_ahead_tiles; }
+    int microcache_size() const { return m_microcache_size; }
+    bool numa_local_tiles() const { return m_numa_local_tiles; }
+    bool share_constant_tiles() const { return m_share_constant_tiles; }
     bool accept_untiled() const { return m_accept_untiled; }
     bool accept_unmipped() const { return m_accept_unmipped; }
     bool unassociatedalpha() const { return m_unassociatedalpha; }
     bool trust_file_extensions() const { return m_trust_file_extensions; }
+    bool fingerprint_files() const { return m_fingerprint_files; }
     int failure_retries() const { return m_failure_retries; }
     bool latlong_y_up_default() const { return m_latlong_y_up_default; }
     void get_commontoworld(Imath::M44f& result) const { result = m_Mc2w; }
@@ -905,6 +1414,13 @@ public:
                         std::vector<ustring>& filenames, int& nutiles,
                         int& nvtiles);
 
+    /// Append to `tiles` every tile of the given file, subimage, and MIP
+    /// level that is in the tile cache with its pixels read, holding all of
+    /// the file's channels and no color transform. This walks the whole
+    /// tile cache.
+    void resident_tiles(const ImageCacheFile* file, int subimage,
+                        int miplevel, std::vector<ImageCacheTileRef>& tiles);
+
     bool get_thumbnail(ustring filename, ImageBuf& thumbnail,
                        int subimage = 0) override;
     bool get_thumbnail(ImageHandle* file, Perthread* thread_info,
@@ -1003,30 +1519,40 @@ public:
     {
         ++thread_info->m_stats.find_tile_calls;
         ImageCacheTileRef& tile(thread_info->tile);
-        if (tile) {
-            if (tile->id() == id) {
-                if (mark_same_tile_used)
-                    tile->use();
-                return true;  // already have the tile we want
-            }
-            // Tile didn't match, maybe lasttile will?  Swap tile
-            // and last tile.  Then the new one will either match,
-            // or we'll fall through and replace tile.
-            tile.swap(thread_info->lasttile);
-            if (tile && tile->id() == id) {
+        if (tile && tile->id() == id) {
+            if (mark_same_tile_used)
                 tile->use();
-                return true;
-            }
+            return true;  // already have the tile we want
         }
+        // Tile didn't match, maybe one in the microcache will? If so, it
+        // trades places with the current tile. Otherwise retire the
+        // current tile to the microcache and fall through to replace it.
+        if (thread_info->microcache_find(id)) {
+            ++thread_info->m_stats.find_tile_microcache_hits;
+            tile->use();
+            return true;
+        }
+        thread_info->microcache_insert(std::move(tile));
         return find_tile_main_cache(id, tile, thread_info);
         // N.B. find_tile_main_cache marks the tile as used
     }
 
+    /// Batch version of find_tile: find (reading if necessary) the tiles
+    /// with all the given ids, storing references to them in the
+    /// corresponding elements of `tiles`. Duplicate ids are looked up only
+    /// once, each shard of the tile cache is locked only once, and tiles
+    /// that must be read are read concurrently. Return true if all the
+    /// tiles were found and are valid.
+    bool find_tiles(cspan<TileID> ids, span<ImageCacheTileRef> tiles,
+                    ImageCachePerThreadInfo* thread_info);
+
     Tile* get_tile(ustring filename, int subimage, int miplevel, int x, int y,
                    int z, int chbegin, int chend) override;
     Tile* get_tile(ImageHandle* file, Perthread* thread_info, int subimage,
                    int miplevel, int x, int y, int z, int chbegin,
                    int chend) override;
+    int get_tiles(ImageHandle* file, Perthread* thread_info, int subimage,
+                  int miplevel, ROI roi, span<Tile*> tiles) override;
     void release_tile(Tile* tile) const override;
     TypeDesc tile_format(const Tile* tile) const override;
     ROI tile_roi(const Tile* tile) const override;
@@ -1037,6 +1563,12 @@ public:
                   int z, int chbegin, int chend, TypeDesc format,
                   const void* buffer, stride_t xstride, stride_t ystride,
                   stride_t zstride, bool copy) override;
+    bool prefetch(ustring filename, int subimage, int miplevel,
+                  ROI roi) override;
+    bool prefetch(ImageHandle* file, Perthread* thread_info, int subimage,
+                  int miplevel, ROI roi) override;
+    bool prefetch(ImageHandle* file, Perthread* thread_info, int subimage,
+                  int miplevel, cspan<ROI> rois) override;
 
     /// Return the numerical subimage index for the given subimage name,
     /// as stored in the "oiio:subimagename" metadata.  Return -1 if no
@@ -1047,6 +1579,28 @@ public:
     std::string geterror(bool clear = true) const override;
     std::string getstats(int level = 1) const override;
     void reset_stats() override;
+    bool write_tile_trace(string_view filename) const override;
+
+    /// If tiles are being placed on NUMA nodes, count a cache hit on
+    /// `tile` as local or remote to the calling thread.
+    void count_numa_hit(ImageCachePerThreadInfo* thread_info,
+                        const ImageCacheTile* tile)
+    {
+        if (m_numa_local_tiles && tile->numa_node() >= 0) {
+            if (tile->numa_node() == thread_info->numa_node())
+                ++thread_info->m_stats.numa_local_hits;
+            else
+                ++thread_info->m_stats.numa_remote_hits;
+        }
+    }
+
+    /// If tracing is on, add an access of tile `id` to the thread's trace.
+    void trace_tile(ImageCachePerThreadInfo* thread_info, const TileID& id,
+                    bool hit, float latency = 0.0f)
+    {
+        if (m_trace_tiles)
+            record_tile_trace(thread_info, id, hit, latency);
+    }
     void invalidate(ustring filename, bool force) override;
     void invalidate(ImageHandle* file, bool force) override;
     void invalidate_all(bool force = false) override;
@@ -1057,6 +1611,10 @@ public:
     ///
     void mergestats(ImageCacheStatistics& merged) const;
 
+    /// Retrieve the eviction statistics for one shard of the tile cache.
+    void shard_evictions(int shard, long long& tiles, long long& sweeps,
+                         double& time) const;
+
     void operator delete(void* todel) { ::delete ((char*)todel); }
 
     /// Called when a new file is opened, so that the system can track
@@ -1071,25 +1629,81 @@ public:
     /// the number of simultaneously-opened files.
     void decr_open_files(void) { --m_stat_open_files_current; }
 
+    /// Called when an idle file's descriptor is closed without closing its
+    /// ImageInput, or reopened by the next read from it (if `reopened` is
+    /// false, it's just going away along with its ImageInput). Only open
+    /// descriptors count toward max_open_files.
+    void fd_detached()
+    {
+        --m_stat_open_files_current;
+        ++m_stat_fds_detached;
+    }
+    void fd_reattached(bool reopened = true)
+    {
+        atomic_max(m_stat_open_files_peak, ++m_stat_open_files_current);
+        if (reopened)
+            ++m_stat_fds_reattached;
+    }
+
+    /// The second-level, on-disk tile cache.
+    DiskTileCache& diskcache() { return m_diskcache; }
+
+    /// The persistent index of file headers.
+    HeaderIndex& headerindex() { return m_headerindex; }
+
+    /// Which shard of the tile cache will hold the tile with this id?
+    int tile_shard(const TileID& id) { return int(m_tilecache.bin_of(id)); }
+
     /// Called when a new tile is created, to update all the stats.
     ///
-    void incr_tiles(size_t size)
+    void incr_tiles(size_t size, int shard)
     {
         ++m_stat_tiles_created;
         atomic_max(m_stat_tiles_peak, ++m_stat_tiles_current);
-        m_mem_used += size;
+        incr_mem(size, shard);
     }
 
     /// Called when a tile's pixel memory is allocated, but a new tile
     /// is not created.
-    void incr_mem(size_t size) { m_mem_used += size; }
+    void incr_mem(size_t size, int shard)
+    {
+        m_mem_used += size;
+        m_tile_shards[shard].mem_used += size;
+    }
+
+    /// Called when pixel memory not owned by a tile is freed.
+    void decr_mem(size_t size, int shard)
+    {
+        m_mem_used -= size;
+        m_tile_shards[shard].mem_used -= size;
+        OIIO_DASSERT(m_mem_used >= 0);
+    }
+
+    /// Return the pixel block, shared by all tiles of `size` bytes whose
+    /// every pixel equals the `pixelsize` bytes at `pixel`. The block is
+    /// made (and its memory charged to `shard`, once) if no live tile is
+    /// already using it, and is freed along with the last tile that does.
+    std::shared_ptr<const char> shared_constant_tile(const char* pixel,
+                                                     int pixelsize,
+                                                     size_t size, int shard);
+
+    /// Called when a tile holding color converted pixels gains or loses
+    /// pixel memory (in addition to the usual accounting).
+    void incr_colorconvert_mem(long long size) { m_colorconvert_mem += size; }
+
+    /// Return the ColorProcessor for a TextureOpt::colortransformid (as
+    /// made by TextureSystem::get_colortransform_id), or an empty handle
+    /// if it names no transform. Each is looked up in the color config
+    /// only once, and keeps its baked LUTs for every tile that uses it.
+    ColorProcessorHandle colortransform_processor(int colortransformid);
 
     /// Called when a tile is destroyed, to update all the stats.
     ///
-    void decr_tiles(size_t size)
+    void decr_tiles(size_t size, int shard)
     {
         --m_stat_tiles_current;
         m_mem_used -= size;
+        m_tile_shards[shard].mem_used -= size;
         OIIO_DASSERT(m_mem_used >= 0);
     }
 
@@ -1107,6 +1721,7 @@ public:
     Perthread* get_perthread_info(Perthread* thread_info = NULL) override;
     Perthread* create_thread_info() override;
     void destroy_thread_info(Perthread* thread_info) override;
+    void bind_thread_info(Perthread* thread_info) override;
 
     /// Ensure that the max_memory_bytes is at least newsize bytes.
     /// Override the previous value if necessary, with thread-safety.
@@ -1128,8 +1743,60 @@ private:
     bool find_tile_main_cache(const TileID& id, ImageCacheTileRef& tile,
                               ImageCachePerThreadInfo* thread_info);
 
-    /// Enforce the max memory for tile data.
-    void check_max_mem(ImageCachePerThreadInfo* thread_info);
+    /// Enforce the max memory for tile data (and the tile's file's own
+    /// quota, if any, sweeping as many shards as it takes), after the tile
+    /// was added to the cache.
+    void check_max_mem(ImageCachePerThreadInfo* thread_info,
+                       const ImageCacheTile* tile);
+
+    /// Run the clock sweep over one shard of the tile cache, evicting
+    /// tiles until the shard is within `shard_max` bytes (or we have made
+    /// two passes over it). If `file` is not null, consider only its
+    /// tiles, and stop when the file is within `file_max` bytes instead.
+    /// If another thread is already sweeping that shard, return
+    /// immediately.
+    void evict_from_shard(int shard, long long shard_max,
+                          ImageCachePerThreadInfo* thread_info,
+                          const ImageCacheFile* file = nullptr,
+                          long long file_max         = 0);
+
+    /// Compress the pixels of a tile that is being evicted, and keep them
+    /// in its shard's store of compressed cold tiles (if they compress
+    /// well enough to be worth it), making room there if needed.
+    void compress_tile(const ImageCacheTile* tile,
+                       ImageCachePerThreadInfo* thread_info);
+
+public:
+    /// If the tile with the given id is in the compressed cold tile store,
+    /// remove it from there, uncompress `size` bytes of its pixels into
+    /// `pixels`, and return true.
+    bool uncompress_tile(const TileID& id, int shard, char* pixels,
+                         size_t size, ImageCachePerThreadInfo* thread_info);
+
+private:
+    /// Add an entry to the thread's tile trace (the out-of-line part of
+    /// trace_tile()).
+    void record_tile_trace(ImageCachePerThreadInfo* thread_info,
+                           const TileID& id, bool hit, float latency);
+
+    /// Throw away all compressed cold tiles from the given file (or from
+    /// all files, if file is nullptr).
+    void drop_compressed_tiles(const ImageCacheFile* file);
+
+    /// Make sure the pixels of a tile that is already in the cache are
+    /// ready to use: if nobody has yet claimed the read (for example, a
+    /// prefetched tile whose task has not run yet), read it right here,
+    /// otherwise wait for whoever is reading it. Return true if we did
+    /// the read ourselves, and store the success of the read in `ok`.
+    bool finish_tile_read(ImageCacheTile* tile,
+                          ImageCachePerThreadInfo* thread_info, bool& ok);
+
+    /// Body of the tasks queued by prefetch(): read the pixels of the
+    /// placeholder tile, unless a lookup already got to it.
+    void prefetch_task(ImageCacheTileRef tile);
+
+    /// Block until every queued prefetch task has finished.
+    void wait_for_prefetches();
 
     /// Internal statistics printing routine
     ///
@@ -1166,12 +1833,25 @@ private:
     bool m_autoscanline;       ///< autotile using full width tiles
     bool m_automip;            ///< auto-mipmap on demand?
     bool m_forcefloat;         ///< force all cache tiles to be float
+    bool m_mmap_tiles = false;  ///< map raw tiles instead of reading them
+    bool m_io_uring   = false;  ///< read through a shared io_uring ring?
+    std::shared_ptr<Filesystem::IOUring> m_io_uring_ring;  ///< The ring
+    int m_read_ahead_tiles = 0;  ///< max tiles in a row to read on a miss
+    int m_microcache_size  = 16;  ///< per-thread tile microcache entries
+    bool m_numa_local_tiles = false;  ///< place tiles on the reader's node
+    bool m_share_constant_tiles = false;  ///< dedup constant-valued tiles
+    std::mutex m_constant_tiles_mutex;    ///< Guards m_constant_tiles
+    /// Live shared constant pixel blocks, keyed by tile size and pixel value
+    std::unordered_map<std::string, std::weak_ptr<const char>> m_constant_tiles;
+    atomic_int m_trace_tiles { 0 };  ///< Per-thread tile trace length
+    Timer m_trace_timer;             ///< Clock for the tile trace
     bool m_accept_untiled;     ///< Accept untiled images?
     bool m_accept_unmipped;    ///< Accept unmipped images?
     bool m_deduplicate;        ///< Detect duplicate files?
     bool m_unassociatedalpha;  ///< Keep unassociated alpha files as they are?
     bool m_latlong_y_up_default;  ///< Is +y the default "up" for latlong?
     bool m_trust_file_extensions = false;  ///< Assume file extensions don't lie?
+    bool m_fingerprint_files = false;      ///< Hash files lacking a SHA-1?
     bool m_max_open_files_strict = false;  ///< Be strict about open files limit?
     int m_failure_retries;                 ///< Times to re-try disk failures
     int m_max_mip_res = 1 << 30;  ///< Don't use MIP levels higher than this
@@ -1182,15 +1862,54 @@ private:
     ustring m_colorconfigname;    ///< Filename of color config to use
 
     mutable FilenameMap m_files;    ///< Map file names to ImageCacheFile's
-    ustring m_file_sweep_name;      ///< Sweeper for "clock" paging algorithm
-    spin_mutex m_file_sweep_mutex;  ///< Ensure only one in check_max_files
+    // Each bin of m_files has its own "clock hand" for check_max_files,
+    // so that several threads may sweep different bins at once.
+    struct FileSweep {
+        OIIO_CACHE_ALIGN spin_mutex sweep_mutex;  ///< One sweeper per bin
+        ustring sweep_name;  ///< Sweeper for "clock" paging algorithm
+    };
+    FileSweep m_file_sweeps[FILE_CACHE_SHARDS];
+    atomic_int m_file_sweep_hint { 0 };  ///< Bin for the next sweep to start
 
     spin_mutex m_fingerprints_mutex;  ///< Protect m_fingerprints
     FingerprintMap m_fingerprints;    ///< Map fingerprints to files
 
-    TileCache m_tilecache;          ///< Our in-memory tile cache
-    TileID m_tile_sweep_id;         ///< Sweeper for "clock" paging algorithm
-    spin_mutex m_tile_sweep_mutex;  ///< Ensure only one in check_max_mem
+    TileCache m_tilecache;  ///< Our in-memory tile cache
+
+    /// Per-shard state for tile eviction. Each shard (bin) of m_tilecache
+    /// has its own "clock hand" and its own tally of tile memory, and is
+    /// held to its fair share of the memory limit, so eviction work is
+    /// spread among the threads adding tiles rather than all falling on
+    /// whichever one wins a single global sweep lock.
+    ///
+    /// Each shard also keeps the tiles that eviction compressed rather than
+    /// dropped (see compress_tile and uncompress_tile), oldest first.
+    struct CompressedTile {
+        std::unique_ptr<char[]> data;     ///< Compressed pixels
+        size_t size = 0;                  ///< Bytes in data
+        std::list<TileID>::iterator age;  ///< Position in TileShard::cold
+    };
+    struct TileShard {
+        OIIO_CACHE_ALIGN mutable spin_mutex sweep_mutex;  ///< One sweeper
+        TileID sweep_id;             ///< Sweeper for "clock" paging algorithm
+        atomic_ll mem_used { 0 };    ///< Memory being used for tiles
+        long long tiles_evicted = 0;  ///< Evicted tiles (under sweep_mutex)
+        long long sweeps        = 0;  ///< Sweeps done (under sweep_mutex)
+        double evict_time       = 0;  ///< Time evicting (under sweep_mutex)
+        spin_mutex compressed_mutex;  ///< Protects compressed and cold
+        tsl::robin_map<TileID, CompressedTile, TileID::Hasher> compressed;
+        std::list<TileID> cold;          ///< Compressed tiles, oldest first
+        long long compressed_mem = 0;    ///< Bytes held in compressed
+    };
+    TileShard m_tile_shards[TILE_CACHE_SHARDS];
+    DiskTileCache m_diskcache;  ///< Optional persistent local tile store
+    HeaderIndex m_headerindex;  ///< Optional persistent header index
+    atomic_ll m_max_compressed_bytes;  ///< Limit for compressed cold tiles
+    atomic_ll m_compressed_mem;        ///< Memory used by compressed tiles
+    atomic_ll m_colorconvert_mem { 0 };  ///< Memory of converted tiles
+    spin_rw_mutex m_colorprocs_mutex;    ///< Protects m_colorprocs
+    std::unordered_map<int, ColorProcessorHandle> m_colorprocs;
+    atomic_int m_evict_shard_hint { 0 };  ///< Where to look for a fat shard
 
     atomic_ll m_mem_used;       ///< Memory being used for tiles
     int m_statslevel;           ///< Statistics level
@@ -1206,6 +1925,13 @@ private:
     atomic_int m_stat_open_files_created;
     atomic_int m_stat_open_files_current;
     atomic_int m_stat_open_files_peak;
+    atomic_ll m_stat_fds_detached { 0 };    ///< Descriptors closed when idle
+    atomic_ll m_stat_fds_reattached { 0 };  ///< ... and reopened later
+    atomic_int m_stat_prefetch_tiles;
+    atomic_int m_stat_prefetch_reads;
+    atomic_int m_prefetch_pending;            ///< Queued prefetches not done
+    std::mutex m_prefetch_mutex;              ///< For m_prefetch_done
+    std::condition_variable m_prefetch_done;  ///< Signaled when pending is 0
 
     // Simulate an atomic double with a long long!
     void incr_time_stat(double& stat, double incr)
@@ -21,6 +21,7 @@
 #include <OpenImageIO/varyingref.h>
 
 #include "imagecache_pvt.h"
+#include "imageio_pvt.h"
 #include "texture_pvt.h"
 
 OIIO_NAMESPACE_BEGIN
@@ -691,6 +692,271 @@ TextureSystemImpl::accum3d_sample_bilinear(
 
 
 
+bool
+TextureSystemImpl::texture3d_batch_trilinear(
+    TextureHandle* texture_handle_, Perthread* thread_info_,
+    TextureOptBatch& options, Tex::RunMask& mask, const float* P,
+    int nchannels, float* result, float* dresultds, float* dresultdt,
+    float* dresultdr)
+{
+    using vfloat_t    = simd::VecType<float, Tex::BatchWidth>::type;
+    using vint_t      = simd::VecType<int, Tex::BatchWidth>::type;
+    using vbool_t     = simd::VecType<bool, Tex::BatchWidth>::type;
+    constexpr int BWd = Tex::BatchWidth;
+
+    // Only trilinear lookups are handled here; everything else goes point
+    // by point.
+    if (nchannels > 4 || !options.subimagename.empty()
+        || options.interpmode == Tex::InterpMode::Closest
+        || (dresultds && !(dresultdt && dresultdr)))
+        return true;
+    TextureFile* texturefile = (TextureFile*)texture_handle_;
+    if (!texturefile)
+        return true;
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info_);
+    texturefile = verify_texturefile(texturefile, thread_info);
+    if (!texturefile || texturefile->broken() || options.subimage < 0
+        || options.subimage >= texturefile->subimages())
+        return true;  // Let the per-point path sort out the errors
+
+    const ImageSpec& spec(texturefile->spec(options.subimage, 0));
+    int firstchannel   = options.firstchannel;
+    int actualchannels = OIIO::clamp(spec.nchannels - firstchannel, 0,
+                                     nchannels);
+    if (spec.nchannels > m_max_tile_channels || spec.tile_width <= 0
+        || spec.tile_height <= 0 || spec.tile_depth <= 0
+        || (actualchannels < nchannels && firstchannel == 0
+            && m_gray_to_rgb))
+        return true;
+
+    Tex::Wrap wrap[3]     = { options.swrap, options.twrap, options.rwrap };
+    Tex::Wrap filewrap[3] = { (Tex::Wrap)texturefile->swrap(),
+                              (Tex::Wrap)texturefile->twrap(),
+                              (Tex::Wrap)texturefile->rwrap() };
+    int res[3]            = { spec.width, spec.height, spec.depth };
+    for (int k = 0; k < 3; ++k) {
+        if (wrap[k] == Tex::Wrap::Default)
+            wrap[k] = filewrap[k];
+        if (wrap[k] == Tex::Wrap::Periodic && ispow2(res[k]))
+            wrap[k] = Tex::Wrap::PeriodicPow2;
+        if (!wrap_batch_supported(wrap[k]))
+            return true;
+    }
+
+    auto lanes = [](int bits) {
+        return (vint_t(bits) & vint_t::Giota()) != vint_t::Zero();
+    };
+    vbool_t active = lanes(int(mask & Tex::RunMaskOn));
+
+    // Transform all the lookup points to local space at once
+    vfloat_t px(P), py(P + BWd), pz(P + 2 * BWd);
+    const auto& si(texturefile->subimageinfo(options.subimage));
+    if (si.Mlocal) {
+        const Imath::M44f& M(*si.Mlocal);
+        vfloat_t a = px * M[0][0] + py * M[1][0] + pz * M[2][0] + M[3][0];
+        vfloat_t b = px * M[0][1] + py * M[1][1] + pz * M[2][1] + M[3][1];
+        vfloat_t c = px * M[0][2] + py * M[1][2] + pz * M[2][2] + M[3][2];
+        vfloat_t w = px * M[0][3] + py * M[1][3] + pz * M[2][3] + M[3][3];
+        px         = a / w;
+        py         = b / w;
+        pz         = c / w;
+    }
+
+    // Texel coordinates and trilinear weights, as accum3d_sample_bilinear
+    vfloat_t sx = px * float(spec.full_width) + float(spec.full_x) - 0.5f;
+    vfloat_t ty = py * float(spec.full_height) + float(spec.full_y) - 0.5f;
+    vfloat_t rz = pz * float(spec.full_depth) + float(spec.full_z) - 0.5f;
+    vint_t tex[3][2];
+    vfloat_t sfrac = floorfrac(sx, &tex[0][0]);
+    vfloat_t tfrac = floorfrac(ty, &tex[1][0]);
+    vfloat_t rfrac = floorfrac(rz, &tex[2][0]);
+    vint_t origin[3] = { vint_t(spec.x), vint_t(spec.y), vint_t(spec.z) };
+    vint_t tilesize[3] = { vint_t(spec.tile_width), vint_t(spec.tile_height),
+                           vint_t(spec.tile_depth) };
+    bool full_pixel_range
+        = texturefile->levelinfo(options.subimage, 0).full_pixel_range;
+    bool tilepow2 = ispow2(spec.tile_width) && ispow2(spec.tile_height)
+                    && ispow2(spec.tile_depth);
+    vbool_t valid = active;
+    vint_t intile[3][2], tileorigin[3][2];
+    for (int k = 0; k < 3; ++k) {
+        tex[k][1] = tex[k][0] + 1;
+        for (int e = 0; e < 2; ++e) {
+            valid &= wrap_batch(wrap[k], tex[k][e], origin[k],
+                                vint_t(res[k]));
+            vint_t local = tex[k][e] - origin[k];
+            if (!full_pixel_range)  // Account for crop windows
+                valid &= (local >= vint_t::Zero()) & (local < vint_t(res[k]));
+            intile[k][e] = tilepow2 ? (local & (tilesize[k] - 1))
+                                    : (local % tilesize[k]);
+            tileorigin[k][e] = local - intile[k][e] + origin[k];
+        }
+    }
+
+    // Find each distinct tile (a brick, for volumes) once, and gather from
+    // it every corner texel of every lane that lands on it. A lane's eight
+    // corners may straddle up to eight bricks. Corner q = r*4 + t*2 + s,
+    // so along axis k it uses endpoint (q >> k) & 1.
+    TypeDesc::BASETYPE pixeltype = texturefile->pixeltype(options.subimage);
+    size_t channelsize = texturefile->channelsize(options.subimage);
+    auto texelvalue    = [&](const unsigned char* p, int c) -> float {
+        switch (pixeltype) {
+        case TypeDesc::UINT8: return uchar2float(p[c]);
+        case TypeDesc::UINT16: return ushort2float(((const uint16_t*)p)[c]);
+        case TypeDesc::HALF: return half2float(((const half*)p)[c]);
+        default: return ((const float*)p)[c];
+        }
+    };
+    alignas(Tex::BatchAlign) float texels[8][4][BWd] = {};
+    int fastbits = valid.bitmask();
+    int need[8];
+    for (int q = 0; q < 8; ++q)
+        need[q] = fastbits;
+    // While every brick touched is a shared constant one of the same
+    // value (empty space in a sparse volume), the whole batch is that
+    // value and the interpolation can be skipped.
+    bool uniform = true, have_uniform = false;
+    float uniformval[4];
+    for (int q0 = 0; q0 < 8; ++q0) {
+        while (need[q0]) {
+            int i = 0;
+            while (!(need[q0] & (1 << i)))
+                ++i;
+            int bx = tileorigin[0][q0 & 1][i];
+            int by = tileorigin[1][(q0 >> 1) & 1][i];
+            int bz = tileorigin[2][q0 >> 2][i];
+            TileID id(*texturefile, options.subimage, 0, bx, by, bz, 0,
+                      spec.nchannels, options.colortransformid);
+            if (!find_tile(id, thread_info, true))
+                error("{}", m_imagecache->geterror());
+            TileRef& tile(thread_info->tile);
+            bool ok                   = tile && tile->valid();
+            const unsigned char* data = ok ? tile->bytedata() : nullptr;
+            bool constant             = ok && tile->shared_constant();
+            float cval[4];
+            if (constant) {
+                // Every texel of the brick is the same; read it just once.
+                const unsigned char* p = data + firstchannel * channelsize;
+                for (int c = 0; c < actualchannels; ++c)
+                    cval[c] = texelvalue(p, c);
+                if (!have_uniform) {
+                    std::copy(cval, cval + actualchannels, uniformval);
+                    have_uniform = true;
+                } else if (!std::equal(cval, cval + actualchannels,
+                                       uniformval)) {
+                    uniform = false;
+                }
+            } else {
+                uniform = false;
+            }
+            vint_t vbx(bx), vby(by), vbz(bz);
+            for (int q = q0; q < 8; ++q) {
+                vbool_t same = (tileorigin[0][q & 1] == vbx)
+                               & (tileorigin[1][(q >> 1) & 1] == vby)
+                               & (tileorigin[2][q >> 2] == vbz);
+                int group = need[q] & same.bitmask();
+                if (!group)
+                    continue;
+                if (!ok) {
+                    // Leave these lanes for the per-point path to report on
+                    fastbits &= ~group;
+                    for (int qq = 0; qq < 8; ++qq)
+                        need[qq] &= ~group;
+                    continue;
+                }
+                need[q] &= ~group;
+                for (int j = 0; j < BWd; ++j) {
+                    if (!(group & (1 << j)))
+                        continue;
+                    if (constant) {
+                        for (int c = 0; c < actualchannels; ++c)
+                            texels[q][c][j] = cval[c];
+                        continue;
+                    }
+                    imagesize_t tilepel
+                        = (intile[2][q >> 2][j] * spec.tile_height
+                           + imagesize_t(intile[1][(q >> 1) & 1][j]))
+                              * spec.tile_width
+                          + intile[0][q & 1][j];
+                    const unsigned char* p
+                        = data
+                          + (spec.nchannels * tilepel + firstchannel)
+                                * channelsize;
+                    for (int c = 0; c < actualchannels; ++c)
+                        texels[q][c][j] = texelvalue(p, c);
+                }
+            }
+        }
+    }
+    vbool_t done = lanes(fastbits);
+    uniform &= have_uniform;
+
+    // Lane-parallel trilinear interpolation. The derivative formulas are
+    // the same as trilerp_accum's, so results match the per-point path.
+    vfloat_t accum[4], daccumds[4], daccumdt[4], daccumdr[4];
+    for (int c = 0; c < actualchannels; ++c) {
+        if (uniform) {
+            accum[c]    = vfloat_t(uniformval[c]);
+            daccumds[c] = daccumdt[c] = daccumdr[c] = vfloat_t::Zero();
+            continue;
+        }
+        vfloat_t v[8];
+        for (int q = 0; q < 8; ++q)
+            v[q] = vfloat_t(texels[q][c]);
+        accum[c] = trilerp(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
+                           sfrac, tfrac, rfrac);
+        if (dresultds) {
+            daccumds[c] = float(spec.full_width)
+                          * bilerp(v[1] - v[0], v[3] - v[2], v[5] - v[4],
+                                   v[7] - v[6], tfrac, rfrac);
+            daccumdt[c] = float(spec.full_height)
+                          * bilerp(v[2] - v[0], v[3] - v[1], v[6] - v[4],
+                                   v[7] - v[5], sfrac, rfrac);
+            daccumdr[c] = float(spec.full_depth)
+                          * bilerp(v[2] - v[6], v[3] - v[7], v[1] - v[4],
+                                   v[3] - v[7], sfrac, tfrac);
+        }
+    }
+    vfloat_t fill = vfloat_t::Zero();
+    if (nchannels > actualchannels && options.fill) {
+        vfloat_t one = vfloat_t::One();
+        fill = trilerp(one, one, one, one, one, one, one, one, sfrac, tfrac,
+                       rfrac)
+               * options.fill;
+    }
+    for (int c = actualchannels; c < nchannels; ++c) {
+        accum[c]    = fill;
+        daccumds[c] = daccumdt[c] = daccumdr[c] = vfloat_t::Zero();
+    }
+
+    for (int c = 0; c < nchannels; ++c) {
+        accum[c].store_mask(done, result + c * BWd);
+        if (dresultds) {
+            daccumds[c].store_mask(done, dresultds + c * BWd);
+            daccumdt[c].store_mask(done, dresultdt + c * BWd);
+            daccumdr[c].store_mask(done, dresultdr + c * BWd);
+        }
+    }
+    mask &= ~Tex::RunMask(done.bitmask());
+
+    int ndone = reduce_add(blend0(vint_t::One(), done));
+    if (!ndone)
+        return true;
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    ++stats.texture3d_batches;
+    stats.texture3d_queries += ndone;
+    stats.aniso_queries += ndone;
+    stats.aniso_probes += ndone;
+    if (options.interpmode == Tex::InterpMode::Bicubic)
+        stats.cubic_interps += ndone;
+    else
+        stats.bilinear_interps += ndone;
+    return true;
+}
+
+
+
 bool
 TextureSystemImpl::texture3d(TextureHandle* texture_handle,
                              Perthread* thread_info, TextureOptBatch& options,
@@ -700,7 +966,16 @@ TextureSystemImpl::texture3d(TextureHandle* texture_handle,
                              float* dresultds, float* dresultdt,
                              float* dresultdr)
 {
-    // (FIXME) CHEAT! Texture points individually
+    pvt::TraceScope trace("TS::texture3d_batch");
+    // Handle whatever we can for all lanes at once. Lanes it leaves in
+    // the mask fall through to the point-by-point loop below.
+    bool ok = texture3d_batch_trilinear(texture_handle, thread_info, options,
+                                        mask, P, nchannels, result, dresultds,
+                                        dresultdt, dresultdr);
+    if (!mask)
+        return ok;
+
+    // Texture the remaining points individually
     TextureOpt opt;
     opt.firstchannel        = options.firstchannel;
     opt.subimage            = options.subimage;
@@ -715,7 +990,6 @@ TextureSystemImpl::texture3d(TextureHandle* texture_handle,
     opt.missingcolor        = options.missingcolor;
     opt.rwrap               = (TextureOpt::Wrap)options.rwrap;
 
-    bool ok          = true;
     Tex::RunMask bit = 1;
     float* r         = OIIO_ALLOCA(float, 4 * nchannels * Tex::BatchWidth);
     float* drds      = r + 1 * nchannels * Tex::BatchWidth;
@@ -135,11 +135,29 @@ public:
                       : ustring();
     }
 
+    bool attribute(TextureHandle* texture_handle, string_view name,
+                   TypeDesc type, const void* val) override
+    {
+        return m_imagecache->attribute((ImageCache::ImageHandle*)
+                                           texture_handle,
+                                       name, type, val);
+    }
+    bool getattribute(TextureHandle* texture_handle, string_view name,
+                      TypeDesc type, void* val) const override
+    {
+        return m_imagecache->getattribute((ImageCache::ImageHandle*)
+                                              texture_handle,
+                                          name, type, val);
+    }
+
     int get_colortransform_id(ustring fromspace,
                               ustring tospace) const override;
     int get_colortransform_id(ustringhash fromspace,
                               ustringhash tospace) const override;
 
+    Sampler* create_sampler(const TextureOpt& options) override;
+    void destroy_sampler(Sampler* sampler) override;
+
     bool texture(ustring filename, TextureOpt& options, float s, float t,
                  float dsdx, float dtdx, float dsdy, float dtdy, int nchannels,
                  float* result, float* dresultds = NULL,
@@ -148,6 +166,11 @@ public:
                  TextureOpt& options, float s, float t, float dsdx, float dtdx,
                  float dsdy, float dtdy, int nchannels, float* result,
                  float* dresultds = NULL, float* dresultdt = NULL) override;
+    bool texture(TextureHandle* texture_handle, Perthread* thread_info,
+                 const Sampler* sampler, float s, float t, float dsdx,
+                 float dtdx, float dsdy, float dtdy, int nchannels,
+                 float* result, float* dresultds = nullptr,
+                 float* dresultdt = nullptr) override;
     bool texture(ustring filename, TextureOptBatch& options, Tex::RunMask mask,
                  const float* s, const float* t, const float* dsdx,
                  const float* dtdx, const float* dsdy, const float* dtdy,
@@ -159,6 +182,12 @@ public:
                  const float* dsdy, const float* dtdy, int nchannels,
                  float* result, float* dresultds = nullptr,
                  float* dresultdt = nullptr) override;
+    bool texture(TextureHandle* texture_handle, Perthread* thread_info,
+                 const Sampler* sampler, Tex::RunMask mask, const float* s,
+                 const float* t, const float* dsdx, const float* dtdx,
+                 const float* dsdy, const float* dtdy, int nchannels,
+                 float* result, float* dresultds = nullptr,
+                 float* dresultdt = nullptr) override;
     bool texture(ustring filename, TextureOptions& options, Runflag* runflags,
                  int beginactive, int endactive, VaryingRef<float> s,
                  VaryingRef<float> t, VaryingRef<float> dsdx,
@@ -310,12 +339,20 @@ public:
                     TextureOpt& options, int miplevel, int xbegin, int xend,
                     int ybegin, int yend, int zbegin, int zend, int chbegin,
                     int chend, TypeDesc format, void* result) override;
+    bool get_resident_tiles(TextureHandle* texture_handle,
+                            Perthread* thread_info, int subimage,
+                            int miplevel, std::vector<unsigned char>& pagetable,
+                            std::vector<int>& newtiles,
+                            std::vector<unsigned char>& staging) override;
 
     bool is_udim(ustring filename) override;
     bool is_udim(TextureHandle* udimfile) override;
     TextureHandle* resolve_udim(ustring filename, float s, float t) override;
     TextureHandle* resolve_udim(TextureHandle* udimfile, Perthread* thread_info,
                                 float s, float t) override;
+    void resolve_udim(TextureHandle* udimfile, Perthread* thread_info,
+                      Tex::RunMask mask, const float* s, const float* t,
+                      TextureHandle** result) override;
     void inventory_udim(ustring udimpattern, std::vector<ustring>& filenames,
                         int& nutiles, int& nvtiles) override;
     void inventory_udim(TextureHandle* udimfile, Perthread* thread_info,
@@ -418,6 +455,97 @@ private:
         float _dsdx, float _dtdx, float _dsdy, float _dtdy, float* result,
         float* dresultds, float* resultdt);
 
+    /// Return the lookup function to use for the given mip mode.
+    static texture_lookup_prototype lookup_function(TextureOpt::MipMode mode);
+
+    /// The guts of the single-point texture() once the lookup function
+    /// has been chosen and nchannels is known to be at most 4.
+    bool texture_with_lookup(TextureHandle* texture_handle,
+                             Perthread* thread_info, TextureOpt& options,
+                             texture_lookup_prototype lookup, float s,
+                             float t, float dsdx, float dtdx, float dsdy,
+                             float dtdy, int nchannels, float* result,
+                             float* dresultds, float* dresultdt);
+
+    /// What a TextureSystem::Sampler really is: a validated copy of the
+    /// options (also broadcast into a TextureOptBatch for the batched
+    /// calls) along with the lookup function they select. Wrap modes that
+    /// depend on the file (Default, or Periodic on a power-of-2 image) are
+    /// still resolved per lookup, since a Sampler isn't tied to one file.
+    struct SamplerImpl {
+        TextureOpt options;
+        TextureOptBatch batchoptions;
+        texture_lookup_prototype lookup;
+    };
+
+    /// Batched isotropic bilinear/trilinear lookup, computing footprints,
+    /// MIP levels and weights for all lanes at once and finding each
+    /// distinct tile only once. Lanes it can't handle are left set in
+    /// `mask` for the caller's per-point loop; lanes that were fully
+    /// resolved are cleared.
+    bool texture_batch_bilinear(TextureHandle* texture_handle,
+                                Perthread* thread_info,
+                                const TextureOptBatch& options,
+                                Tex::RunMask& mask,
+                                const float* s, const float* t,
+                                const float* dsdx, const float* dtdx,
+                                const float* dsdy, const float* dtdy,
+                                int nchannels, float* result,
+                                float* dresultds, float* dresultdt);
+
+    /// For a UDIM texture, resolve every lane of `mask` to its tile file
+    /// and call `lookup(handle, submask, s, t)` once per distinct file,
+    /// with s and t already made relative to that tile. Lanes that were
+    /// looked up are cleared from `mask`, and lanes landing on no tile are
+    /// left for the caller to report as missing.
+    template<typename LOOKUP>
+    bool texture_batch_udim(TextureHandle* texture_handle,
+                            Perthread* thread_info, Tex::RunMask& mask,
+                            const float* s, const float* t, LOOKUP&& lookup);
+
+    /// Compute each lane's approximate filter width for
+    /// batch_lane_order(), but only if "coherent_batches" is on.
+    void batch_filtwidths(const TextureOptBatch& options, const float* dsdx,
+                          const float* dtdx, const float* dsdy,
+                          const float* dtdy, float* filtwidth);
+
+    /// Fill `order` with the active lanes of `mask`, returning how many
+    /// there are. If "coherent_batches" is on, they are sorted so that
+    /// lanes likely to touch the same MIP level and tile are adjacent,
+    /// given each lane's (s,t) and approximate filter width; otherwise
+    /// they are in lane order.
+    int batch_lane_order(TextureHandle* texture_handle,
+                         PerThreadInfo* thread_info, int subimage,
+                         Tex::RunMask mask, const float* s, const float* t,
+                         const float* filtwidth, int* order);
+
+    struct CaptureFile;
+
+    /// Open (or, for an empty name, close) the "capture" file.
+    bool set_capture(string_view filename);
+
+    /// The open "capture" file, if any, which stays open for as long as
+    /// the caller holds on to it.
+    std::shared_ptr<CaptureFile> capture_file();
+
+    /// Append one 2D lookup to an open capture file.
+    void capture_write(CaptureFile& file, const TextureFile* texturefile,
+                       const TextureOpt& options, float s, float t,
+                       float dsdx, float dtdx, float dsdy, float dtdy,
+                       int nchannels);
+
+    /// Append one 2D lookup to the "capture" file, if there is one. Check
+    /// m_capturing first to keep this off the path of ordinary lookups.
+    void capture(const TextureFile* texturefile, const TextureOpt& options,
+                 float s, float t, float dsdx, float dtdx, float dsdy,
+                 float dtdy, int nchannels);
+    /// Append the lanes of a batch that are on in `lanes`.
+    void capture(const TextureFile* texturefile,
+                 const TextureOptBatch& options, Tex::RunMask lanes,
+                 const float* s, const float* t, const float* dsdx,
+                 const float* dtdx, const float* dsdy, const float* dtdy,
+                 int nchannels);
+
     // For the samplers, it's guaranteed that all float* inputs and outputs
     // are padded to length 'simd' and aligned to a simd*4-byte boundary
     // (for example, 4 for SSE). This means that the functions can behave AS
@@ -462,6 +590,15 @@ private:
                                 const Imath::V3f& dPdy, const Imath::V3f& dPdz,
                                 float* result, float* dresultds,
                                 float* dresultdt, float* dresultdr);
+    /// Batched trilinear volume lookup, the texture3d counterpart of
+    /// texture_batch_bilinear: lanes it resolves are cleared from `mask`.
+    bool texture3d_batch_trilinear(TextureHandle* texture_handle,
+                                   Perthread* thread_info,
+                                   TextureOptBatch& options,
+                                   Tex::RunMask& mask, const float* P,
+                                   int nchannels, float* result,
+                                   float* dresultds, float* dresultdt,
+                                   float* dresultdr);
     typedef bool (TextureSystemImpl::*accum3d_prototype)(
         const Imath::V3f& P, int level, TextureFile& texturefile,
         PerThreadInfo* thread_info, TextureOpt& options, int nchannels_result,
@@ -499,6 +636,14 @@ private:
                      const ImageSpec& spec, int& i, int& j, float& ifrac,
                      float& jfrac);
 
+    /// Stochastically choose one of the four texels of the bilinear
+    /// footprint at (s,t), each with probability equal to its bilinear
+    /// weight, and move (s,t) to its center, so that a closest-texel probe
+    /// there is an unbiased estimate of the bilinear one. The random
+    /// deviate `rnd` is rescaled so that it may be used again.
+    void stochastic_texel(TextureFile& texturefile, const ImageSpec& spec,
+                          float& s, float& t, float& rnd);
+
     /// Called when the requested texture is missing, fills in the
     /// results.
     bool missing_texture(TextureOpt& options, int nchannels, float* result,
@@ -560,6 +705,11 @@ private:
     int m_max_tile_channels;  ///< narrow tile ID channel range when
                               ///<   the file has more channels
     int m_stochastic;
+    bool m_coherent_batches;  ///< Sort batched lanes by tile first?
+    ustring m_capture;                           ///< Capture file name
+    std::shared_ptr<CaptureFile> m_capturefile;  ///< Open capture file
+    spin_mutex m_capture_mutex;  ///< Guards m_capture and m_capturefile
+    std::atomic<bool> m_capturing { false };  ///< Is m_capturefile set?
     static EightBitConverter<float> uchar2float;
 
     enum StochasticStrategyBits {
@@ -646,6 +796,77 @@ TextureSystemImpl::st_to_texel(float s, float t, TextureFile& texturefile,
 
 
 
+inline void
+TextureSystemImpl::stochastic_texel(TextureFile& texturefile,
+                                    const ImageSpec& spec, float& s, float& t,
+                                    float& rnd)
+{
+    int i, j;
+    float ifrac, jfrac;
+    st_to_texel(s, t, texturefile, spec, i, j, ifrac, jfrac);
+    // Pick left or right with probability (1-ifrac, ifrac), then reuse the
+    // rescaled deviate to pick top or bottom likewise.
+    auto choose = [&](float frac) {
+        float step;
+        if (rnd < frac) {
+            step = 1.0f - frac;
+            rnd  = rnd / frac;
+        } else {
+            step = -frac;
+            rnd  = (rnd - frac) / (1.0f - frac);
+        }
+        rnd = OIIO::clamp(rnd, 0.0f, 1.0f);
+        return step;
+    };
+    float sstep = choose(ifrac);
+    float tstep = choose(jfrac);
+    // Convert the texel-space step back to st, by the same scale that
+    // st_to_texel used.
+    int sres = texturefile.m_sample_border ? spec.width - 1 : spec.width;
+    int tres = texturefile.m_sample_border ? spec.height - 1 : spec.height;
+    if (sres > 0)
+        s += sstep / float(sres);
+    if (tres > 0)
+        t += tstep / float(tres);
+}
+
+
+
+// Wrap a whole batch of texel coordinates at once. Only the wrap modes
+// that the batched fast paths accept are implemented.
+template<typename VINT>
+inline typename simd::VecType<bool, VINT::elements>::type
+wrap_batch(Tex::Wrap wrap, VINT& coord, const VINT& origin, const VINT& width)
+{
+    using vbool_t = typename simd::VecType<bool, VINT::elements>::type;
+    VINT c = coord - origin;
+    switch (wrap) {
+    case Tex::Wrap::Clamp:
+        c = blend(c, VINT::Zero(), c < VINT::Zero());
+        c = blend(c, width - 1, c >= width);
+        break;
+    case Tex::Wrap::Periodic:
+        c = c % width;
+        c = blend(c, c + width, c < VINT::Zero());
+        break;
+    case Tex::Wrap::PeriodicPow2: c = c & (width - 1); break;
+    default:  // Black
+        return (c >= VINT::Zero()) & (c < width);
+    }
+    coord = c + origin;
+    return vbool_t::True();
+}
+
+
+inline bool
+wrap_batch_supported(Tex::Wrap wrap)
+{
+    return wrap == Tex::Wrap::Black || wrap == Tex::Wrap::Clamp
+           || wrap == Tex::Wrap::Periodic || wrap == Tex::Wrap::PeriodicPow2;
+}
+
+
+
 }  // end namespace pvt
 
 OIIO_NAMESPACE_END
@@ -3,6 +3,7 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <list>
@@ -14,6 +15,7 @@
 
 #include <OpenImageIO/color.h>
 #include <OpenImageIO/dassert.h>
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/filter.h>
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imagebuf.h>
@@ -31,7 +33,9 @@
 #include <OpenImageIO/varyingref.h>
 
 #include "imagecache_pvt.h"
+#include "imageio_pvt.h"
 #include "texture_pvt.h"
+#include "texturecapture_pvt.h"
 
 #define TEX_FAST_MATH 1
 
@@ -73,6 +77,58 @@ ushort2float4(const unsigned short* s)
 }
 
 
+// Load the first four channels of a texel of the given type, as float.
+// Integer types are normalized to [0,1].
+OIIO_FORCEINLINE vfloat4
+load_texel(TypeDesc::BASETYPE pixeltype, const unsigned char* p)
+{
+    if (pixeltype == TypeDesc::UINT8)
+        return uchar2float4(p);
+    if (pixeltype == TypeDesc::UINT16)
+        return ushort2float4((const unsigned short*)p);
+    if (pixeltype == TypeDesc::HALF)
+        return vfloat4((const half*)p);
+    OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
+    return vfloat4((const float*)p);
+}
+
+
+// Load two texels (a in the low half, b in the high half) the way
+// load_texel() would, but where the hardware allows, convert both with a
+// single 8-wide instruction, so half and 8/16 bit tiles are fetched at
+// nearly the cost of float ones.
+OIIO_FORCEINLINE vfloat8
+load_texel_pair(TypeDesc::BASETYPE pixeltype, const unsigned char* a,
+                const unsigned char* b)
+{
+#if OIIO_SIMD_AVX >= 2
+    if (pixeltype == TypeDesc::UINT8) {
+        int32_t ia, ib;
+        memcpy(&ia, a, 4);
+        memcpy(&ib, b, 4);
+        __m128i v = _mm_unpacklo_epi32(_mm_cvtsi32_si128(ia),
+                                       _mm_cvtsi32_si128(ib));
+        return vfloat8(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)))
+               * vfloat8(1.0f / 255.0f);
+    }
+    if (pixeltype == TypeDesc::UINT16) {
+        __m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)a),
+                                       _mm_loadl_epi64((const __m128i*)b));
+        return vfloat8(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v)))
+               * vfloat8(1.0f / 65535.0f);
+    }
+#endif
+#if OIIO_SIMD_AVX && OIIO_F16C_ENABLED
+    if (pixeltype == TypeDesc::HALF) {
+        __m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)a),
+                                       _mm_loadl_epi64((const __m128i*)b));
+        return vfloat8(_mm256_cvtph_ps(v));
+    }
+#endif
+    return vfloat8(load_texel(pixeltype, a), load_texel(pixeltype, b));
+}
+
+
 static const OIIO_SIMD4_ALIGN vbool4 channel_masks[5] = {
     vbool4(false, false, false, false), vbool4(true, false, false, false),
     vbool4(true, true, false, false),   vbool4(true, true, true, false),
@@ -325,6 +381,181 @@ texture_type_name(TexFormat f)
 
 
 
+struct TextureSystemImpl::CaptureFile {
+    FILE* file = nullptr;
+    ustring name;
+    mutex write_mutex;
+    std::unordered_map<ustring, uint32_t> strings;
+    bool failed = false;  // A write failed, so stop writing
+
+    ~CaptureFile()
+    {
+        if (file)
+            fclose(file);
+    }
+
+    // Return the index of `str`, writing it to the file the first time.
+    // The caller holds the mutex. Clear `ok` if the write fails.
+    uint32_t string_index(ustring str, bool& ok)
+    {
+        auto found = strings.find(str);
+        if (found != strings.end())
+            return found->second;
+        uint32_t index = uint32_t(strings.size());
+        strings[str]   = index;
+        uint32_t len   = uint32_t(str.length());
+        ok &= fputc('S', file) != EOF;
+        ok &= fwrite(&len, sizeof(len), 1, file) == 1;
+        ok &= fwrite(str.c_str(), 1, len, file) == len;
+        return index;
+    }
+
+    // Append one lookup. Return false only for the first write to fail;
+    // after that, lookups are silently dropped.
+    bool write(ustring filename, ustring subimagename,
+               TextureCaptureRecord& rec)
+    {
+        lock_guard lock(write_mutex);
+        if (failed)
+            return true;
+        bool ok          = true;
+        rec.filename     = string_index(filename, ok);
+        rec.subimagename = subimagename.empty()
+                               ? -1
+                               : int32_t(string_index(subimagename, ok));
+        ok &= fputc('T', file) != EOF;
+        ok &= fwrite(&rec, sizeof(rec), 1, file) == 1;
+        failed = !ok;
+        return ok;
+    }
+};
+
+
+
+bool
+TextureSystemImpl::set_capture(string_view filename)
+{
+    std::shared_ptr<CaptureFile> capturefile;
+    bool ok = true;
+    if (filename.size()) {
+        capturefile.reset(new CaptureFile);
+        capturefile->name = ustring(filename);
+        capturefile->file = Filesystem::fopen(filename, "wb");
+        if (!capturefile->file
+            || fwrite(texture_capture_magic, 1, 8, capturefile->file) != 8) {
+            error("Could not open texture capture file \"{}\"", filename);
+            capturefile.reset();
+            ok = false;
+        }
+    }
+    // Lookups in flight hold their own reference, so the old file is
+    // closed when the last of them is done with it.
+    spin_lock lock(m_capture_mutex);
+    m_capturefile = capturefile;
+    m_capture     = capturefile ? capturefile->name : ustring();
+    m_capturing   = bool(capturefile);
+    return ok;
+}
+
+
+
+std::shared_ptr<TextureSystemImpl::CaptureFile>
+TextureSystemImpl::capture_file()
+{
+    spin_lock lock(m_capture_mutex);
+    return m_capturefile;
+}
+
+
+
+void
+TextureSystemImpl::capture_write(CaptureFile& file,
+                                 const TextureFile* texturefile,
+                                 const TextureOpt& options, float s, float t,
+                                 float dsdx, float dtdx, float dsdy,
+                                 float dtdy, int nchannels)
+{
+    TextureCaptureRecord rec;
+    rec.subimage            = options.subimage;
+    rec.firstchannel        = options.firstchannel;
+    rec.nchannels           = nchannels;
+    rec.swrap               = options.swrap;
+    rec.twrap               = options.twrap;
+    rec.mipmode             = options.mipmode;
+    rec.interpmode          = options.interpmode;
+    rec.anisotropic         = options.anisotropic;
+    rec.conservative_filter = options.conservative_filter;
+    rec.colortransformid    = options.colortransformid;
+    rec.s                   = s;
+    rec.t                   = t;
+    rec.dsdx                = dsdx;
+    rec.dtdx                = dtdx;
+    rec.dsdy                = dsdy;
+    rec.dtdy                = dtdy;
+    rec.sblur               = options.sblur;
+    rec.tblur               = options.tblur;
+    rec.swidth              = options.swidth;
+    rec.twidth              = options.twidth;
+    rec.fill                = options.fill;
+    rec.rnd                 = options.rnd;
+    if (!file.write(texturefile->filename(), options.subimagename, rec))
+        error("Could not write texture capture file \"{}\", "
+              "no more lookups will be recorded",
+              file.name);
+}
+
+
+
+void
+TextureSystemImpl::capture(const TextureFile* texturefile,
+                           const TextureOpt& options, float s, float t,
+                           float dsdx, float dtdx, float dsdy, float dtdy,
+                           int nchannels)
+{
+    if (std::shared_ptr<CaptureFile> file = capture_file())
+        capture_write(*file, texturefile, options, s, t, dsdx, dtdx, dsdy,
+                      dtdy, nchannels);
+}
+
+
+
+void
+TextureSystemImpl::capture(const TextureFile* texturefile,
+                           const TextureOptBatch& options, Tex::RunMask lanes,
+                           const float* s, const float* t, const float* dsdx,
+                           const float* dtdx, const float* dsdy,
+                           const float* dtdy, int nchannels)
+{
+    std::shared_ptr<CaptureFile> file = capture_file();
+    if (!file)
+        return;
+    TextureOpt opt;
+    opt.firstchannel        = options.firstchannel;
+    opt.subimage            = options.subimage;
+    opt.subimagename        = options.subimagename;
+    opt.swrap               = (TextureOpt::Wrap)options.swrap;
+    opt.twrap               = (TextureOpt::Wrap)options.twrap;
+    opt.mipmode             = (TextureOpt::MipMode)options.mipmode;
+    opt.interpmode          = (TextureOpt::InterpMode)options.interpmode;
+    opt.anisotropic         = options.anisotropic;
+    opt.conservative_filter = options.conservative_filter;
+    opt.fill                = options.fill;
+    opt.colortransformid    = options.colortransformid;
+    for (int i = 0; i < Tex::BatchWidth; ++i) {
+        if (!(lanes & (Tex::RunMask(1) << i)))
+            continue;
+        opt.sblur  = options.sblur[i];
+        opt.tblur  = options.tblur[i];
+        opt.swidth = options.swidth[i];
+        opt.twidth = options.twidth[i];
+        opt.rnd    = options.rnd[i];
+        capture_write(*file, texturefile, opt, s[i], t[i], dsdx[i], dtdx[i],
+                      dsdy[i], dtdy[i], nchannels);
+    }
+}
+
+
+
 TextureSystemImpl::TextureSystemImpl(ImageCache* imagecache)
     : m_id(++txsys_next_id)
 {
@@ -342,6 +573,7 @@ TextureSystemImpl::init()
     m_flip_t            = false;
     m_max_tile_channels = 6;
     m_stochastic        = StochasticStrategy_None;
+    m_coherent_batches  = false;
     hq_filter.reset(Filter1D::create("b-spline", 4));
     m_statslevel = 0;
 
@@ -396,6 +628,8 @@ TextureSystemImpl::getstats(int level, bool icstats) const
         INTOPT(flip_t);
         INTOPT(max_tile_channels);
         INTOPT(stochastic);
+        BOOLOPT(coherent_batches);
+        STROPT(capture);
 #undef BOOLOPT
 #undef INTOPT
 #undef STROPT
@@ -485,6 +719,12 @@ TextureSystemImpl::attribute(string_view name, TypeDesc type, const void* val)
         m_stochastic = *(const int*)val;
         return true;
     }
+    if (name == "coherent_batches" && type == TypeInt) {
+        m_coherent_batches = *(const int*)val;
+        return true;
+    }
+    if (name == "capture" && type == TypeString)
+        return set_capture(*(const char**)val);
     if (name == "statistics:level" && type == TypeInt) {
         m_statslevel = *(const int*)val;
         // DO NOT RETURN! pass the same message to the image cache
@@ -516,6 +756,8 @@ TextureSystemImpl::getattributetype(string_view name) const
         { "flip_t", TypeInt },
         { "max_tile_channels", TypeInt },
         { "stochastic", TypeInt },
+        { "coherent_batches", TypeInt },
+        { "capture", TypeString },
     };
     // clang-format on
 
@@ -565,6 +807,15 @@ TextureSystemImpl::getattribute(string_view name, TypeDesc type,
         *(int*)val = m_stochastic;
         return true;
     }
+    if (name == "coherent_batches" && type == TypeInt) {
+        *(int*)val = m_coherent_batches;
+        return true;
+    }
+    if (name == "capture" && type == TypeString) {
+        spin_lock lock(m_capture_mutex);
+        *(ustring*)val = m_capture;
+        return true;
+    }
 
     // If not one of these, maybe it's an attribute meant for the image cache?
     return m_imagecache->getattribute(name, type, val);
@@ -754,6 +1005,74 @@ TextureSystemImpl::resolve_udim(TextureHandle* udimfile, Perthread* thread_info,
 
 
 
+void
+TextureSystemImpl::resolve_udim(TextureHandle* udimfile, Perthread* thread_info,
+                                Tex::RunMask mask, const float* s,
+                                const float* t, TextureHandle** result)
+{
+    PerThreadInfo* ptinfo = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info);
+    // Lanes of a batch are usually spread over very few tiles, so a short
+    // list of the distinct ones seen so far is all the lookup we need.
+    int ntiles = 0;
+    int tileu[Tex::BatchWidth], tilev[Tex::BatchWidth];
+    TextureHandle* tilefile[Tex::BatchWidth];
+    for (int i = 0; i < Tex::BatchWidth; ++i) {
+        result[i] = nullptr;
+        if (!(mask & (1 << i)))
+            continue;
+        int utile = std::max(0, int(s[i]));
+        int vtile = std::max(0, int(t[i]));
+        int n     = 0;
+        while (n < ntiles && (tileu[n] != utile || tilev[n] != vtile))
+            ++n;
+        if (n == ntiles) {
+            tileu[n]    = utile;
+            tilev[n]    = vtile;
+            tilefile[n] = (TextureHandle*)m_imagecache->resolve_udim(
+                (ImageCache::ImageHandle*)udimfile, ptinfo, utile, vtile);
+            ++ntiles;
+        }
+        result[i] = tilefile[n];
+    }
+}
+
+
+
+template<typename LOOKUP>
+bool
+TextureSystemImpl::texture_batch_udim(TextureHandle* texture_handle,
+                                      Perthread* thread_info,
+                                      Tex::RunMask& mask, const float* s,
+                                      const float* t, LOOKUP&& lookup)
+{
+    TextureHandle* files[Tex::BatchWidth];
+    resolve_udim(texture_handle, thread_info, mask, s, t, files);
+    // Each lane's coordinates within its own tile
+    alignas(Tex::BatchAlign) float stile[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float ttile[Tex::BatchWidth];
+    for (int i = 0; i < Tex::BatchWidth; ++i) {
+        stile[i] = s[i] - floorf(s[i]);
+        ttile[i] = t[i] - floorf(t[i]);
+    }
+    bool ok           = true;
+    Tex::RunMask todo = mask;
+    for (int i = 0; i < Tex::BatchWidth; ++i) {
+        if (!(todo & (1 << i)) || !files[i])
+            continue;
+        Tex::RunMask group = 0;
+        for (int j = i; j < Tex::BatchWidth; ++j)
+            if ((todo & (1 << j)) && files[j] == files[i])
+                group |= (1 << j);
+        todo &= ~group;
+        mask &= ~group;
+        ok &= lookup(files[i], group, stile, ttile);
+    }
+    return ok;
+}
+
+
+
 void
 TextureSystemImpl::inventory_udim(ustring udimpattern,
                                   std::vector<ustring>& filenames, int& nutiles,
@@ -906,6 +1225,77 @@ TextureSystemImpl::get_texels(TextureHandle* texture_handle_,
 
 
 
+bool
+TextureSystemImpl::get_resident_tiles(TextureHandle* texture_handle_,
+                                      Perthread* thread_info_, int subimage,
+                                      int miplevel,
+                                      std::vector<unsigned char>& pagetable,
+                                      std::vector<int>& newtiles,
+                                      std::vector<unsigned char>& staging)
+{
+    newtiles.clear();
+    staging.clear();
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info_);
+    TextureFile* texfile = verify_texturefile((TextureFile*)texture_handle_,
+                                              thread_info);
+    if (!texfile) {
+        error("Invalid texture handle NULL");
+        return false;
+    }
+    if (texfile->broken() || texfile->is_udim()) {
+        if (texfile->errors_should_issue())
+            error("Invalid texture file \"{}\"", texfile->filename());
+        return false;
+    }
+    if (subimage < 0 || subimage >= texfile->subimages()
+        || miplevel < 0 || miplevel >= texfile->miplevels(subimage)) {
+        error("get_resident_tiles asked for nonexistent subimage {} MIP "
+              "level {} of \"{}\"",
+              subimage, miplevel, texfile->filename());
+        return false;
+    }
+    const ImageSpec& spec(texfile->spec(subimage, miplevel));
+    int ntilesx = (spec.width + spec.tile_width - 1) / spec.tile_width;
+    int ntilesy = (spec.height + spec.tile_height - 1) / spec.tile_height;
+    size_t ntiles = size_t(ntilesx) * size_t(ntilesy);
+
+    std::vector<ImageCacheTileRef> tiles;
+    m_imagecache->resident_tiles(texfile, subimage, miplevel, tiles);
+
+    // Anything not in a page table of the right size counts as new.
+    std::vector<unsigned char> previous;
+    previous.swap(pagetable);
+    if (previous.size() != ntiles)
+        previous.assign(ntiles, 0);
+    pagetable.assign(ntiles, 0);
+    std::vector<const ImageCacheTileRef*> bytile(ntiles, nullptr);
+    for (const ImageCacheTileRef& tile : tiles) {
+        const TileID& id(tile->id());
+        if (id.z() != spec.z)
+            continue;  // only the first slice of a volume
+        int tx = (id.x() - spec.x) / spec.tile_width;
+        int ty = (id.y() - spec.y) / spec.tile_height;
+        if (tx < 0 || tx >= ntilesx || ty < 0 || ty >= ntilesy)
+            continue;
+        int index        = tx + ty * ntilesx;
+        pagetable[index] = 1;
+        bytile[index]    = &tile;
+    }
+
+    size_t tilebytes = spec.tile_pixels() * texfile->pixelsize(subimage);
+    for (size_t i = 0; i < ntiles; ++i) {
+        if (pagetable[i] && !previous[i]) {
+            newtiles.push_back(int(i));
+            const unsigned char* p = (*bytile[i])->bytedata();
+            staging.insert(staging.end(), p, p + tilebytes);
+        }
+    }
+    return true;
+}
+
+
+
 bool
 TextureSystemImpl::has_error() const
 {
@@ -1168,6 +1558,17 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
         return true;
     }
 
+    return texture_with_lookup(texture_handle_, thread_info_, options,
+                               lookup_function(options.mipmode), s, t, dsdx,
+                               dtdx, dsdy, dtdy, nchannels, result, dresultds,
+                               dresultdt);
+}
+
+
+
+TextureSystemImpl::texture_lookup_prototype
+TextureSystemImpl::lookup_function(TextureOpt::MipMode mode)
+{
     static const texture_lookup_prototype lookup_functions[] = {
         // Must be in the same order as Mipmode enum
         &TextureSystemImpl::texture_lookup,
@@ -1178,11 +1579,24 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
         &TextureSystemImpl::texture_lookup_trilinear_mipmap,
         &TextureSystemImpl::texture_lookup
     };
-    texture_lookup_prototype lookup = lookup_functions[(int)options.mipmode];
+    return lookup_functions[(int)mode];
+}
+
 
+
+bool
+TextureSystemImpl::texture_with_lookup(
+    TextureHandle* texture_handle_, Perthread* thread_info_,
+    TextureOpt& options, texture_lookup_prototype lookup, float s, float t,
+    float dsdx, float dtdx, float dsdy, float dtdy, int nchannels,
+    float* result, float* dresultds, float* dresultdt)
+{
     PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
         (PerThreadInfo*)thread_info_);
     TextureFile* texturefile = (TextureFile*)texture_handle_;
+    if (m_capturing.load(std::memory_order_relaxed) && texturefile)
+        capture(texturefile, options, s, t, dsdx, dtdx, dsdy, dtdy,
+                nchannels);
     if (texturefile->is_udim()) {
         texturefile = (TextureFile*)resolve_udim((TextureHandle*)texture_handle_,
                                                  (Perthread*)thread_info, s, t);
@@ -1269,6 +1683,13 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
         dtdy *= subinfo.tscale;
     }
 
+    // Per-file statistics cost a clock read and a few shared atomics per
+    // lookup, so they are only kept at the highest statistics levels.
+    bool filestats           = (m_statslevel >= 3);
+    long long interps_before = stats.closest_interps + stats.bilinear_interps
+                               + stats.cubic_interps;
+    Timer timer(filestats ? Timer::StartNow : Timer::DontStartNow);
+
     bool ok;
     // Everything from the lookup function on down will assume that there
     // is space for a vfloat4 in all of the result locations, so if that's
@@ -1314,11 +1735,103 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
             *(vfloat4*)dresultdt = -(*(vfloat4*)dresultdt);
     }
 
+    if (filestats)
+        texturefile->count_texture_query(stats.closest_interps
+                                             + stats.bilinear_interps
+                                             + stats.cubic_interps
+                                             - interps_before,
+                                         (long long)(timer() * 1.0e9));
     return ok;
 }
 
 
 
+TextureSystem::Sampler*
+TextureSystemImpl::create_sampler(const TextureOpt& options)
+{
+    SamplerImpl* sampler = new SamplerImpl;
+    TextureOpt& opt(sampler->options);
+    opt = options;
+    // Out-of-range modes would index past the dispatch tables, so sanitize
+    // them once here rather than trusting them on every lookup.
+    auto validwrap = [](TextureOpt::Wrap w) {
+        return (w >= TextureOpt::WrapDefault && w < TextureOpt::WrapLast)
+                   ? w
+                   : TextureOpt::WrapDefault;
+    };
+    opt.swrap = validwrap(opt.swrap);
+    opt.twrap = validwrap(opt.twrap);
+    opt.rwrap = validwrap(opt.rwrap);
+    if (opt.mipmode < TextureOpt::MipModeDefault
+        || opt.mipmode > TextureOpt::MipModeStochasticAniso)
+        opt.mipmode = TextureOpt::MipModeDefault;
+    if (opt.interpmode < TextureOpt::InterpClosest
+        || opt.interpmode > TextureOpt::InterpSmartBicubic)
+        opt.interpmode = TextureOpt::InterpSmartBicubic;
+    sampler->lookup = lookup_function(opt.mipmode);
+
+    TextureOptBatch& bopt(sampler->batchoptions);
+    for (int i = 0; i < Tex::BatchWidth; ++i) {
+        bopt.sblur[i]  = opt.sblur;
+        bopt.tblur[i]  = opt.tblur;
+        bopt.rblur[i]  = opt.rblur;
+        bopt.swidth[i] = opt.swidth;
+        bopt.twidth[i] = opt.twidth;
+        bopt.rwidth[i] = opt.rwidth;
+        bopt.rnd[i]    = opt.rnd;
+    }
+    bopt.firstchannel        = opt.firstchannel;
+    bopt.subimage            = opt.subimage;
+    bopt.subimagename        = opt.subimagename;
+    bopt.swrap               = (Tex::Wrap)opt.swrap;
+    bopt.twrap               = (Tex::Wrap)opt.twrap;
+    bopt.rwrap               = (Tex::Wrap)opt.rwrap;
+    bopt.mipmode             = (Tex::MipMode)opt.mipmode;
+    bopt.interpmode          = (Tex::InterpMode)opt.interpmode;
+    bopt.anisotropic         = opt.anisotropic;
+    bopt.conservative_filter = opt.conservative_filter;
+    bopt.fill                = opt.fill;
+    bopt.missingcolor        = opt.missingcolor;
+    bopt.colortransformid    = opt.colortransformid;
+    return (Sampler*)sampler;
+}
+
+
+
+void
+TextureSystemImpl::destroy_sampler(Sampler* sampler)
+{
+    delete (SamplerImpl*)sampler;
+}
+
+
+
+bool
+TextureSystemImpl::texture(TextureHandle* texture_handle,
+                           Perthread* thread_info, const Sampler* sampler_,
+                           float s, float t, float dsdx, float dtdx,
+                           float dsdy, float dtdy, int nchannels,
+                           float* result, float* dresultds, float* dresultdt)
+{
+    const SamplerImpl* sampler = (const SamplerImpl*)sampler_;
+    if (!sampler) {
+        error("texture() called with a null Sampler");
+        return false;
+    }
+    // The lookup may resolve per-file details (default wraps, subimage
+    // names) into the options, so it gets its own copy.
+    TextureOpt options(sampler->options);
+    if (nchannels > 4)
+        return texture(texture_handle, thread_info, options, s, t, dsdx,
+                       dtdx, dsdy, dtdy, nchannels, result, dresultds,
+                       dresultdt);
+    return texture_with_lookup(texture_handle, thread_info, options,
+                               sampler->lookup, s, t, dsdx, dtdx, dsdy, dtdy,
+                               nchannels, result, dresultds, dresultdt);
+}
+
+
+
 bool
 TextureSystemImpl::texture(ustring filename, TextureOptBatch& options,
                            Tex::RunMask mask, const float* s, const float* t,
@@ -1341,7 +1854,32 @@ TextureSystemImpl::texture(TextureHandle* texture_handle,
                            const float* dsdy, const float* dtdy, int nchannels,
                            float* result, float* dresultds, float* dresultdt)
 {
-    // (FIXME) CHEAT! Texture points individually
+    pvt::TraceScope trace("TS::texture_batch");
+    bool ok = true;
+    if (is_udim(texture_handle)) {
+        // Look up each tile's lanes as their own batch, which can then
+        // take the fast path. Lanes on missing tiles fall through.
+        ok = texture_batch_udim(
+            texture_handle, thread_info, mask, s, t,
+            [&](TextureHandle* file, Tex::RunMask m, const float* ss,
+                const float* tt) {
+                return texture(file, thread_info, options, m, ss, tt, dsdx,
+                               dtdx, dsdy, dtdy, nchannels, result,
+                               dresultds, dresultdt);
+            });
+        if (!mask)
+            return ok;
+    }
+
+    // Handle whatever we can for all lanes at once. Lanes it leaves in
+    // the mask fall through to the point-by-point loop below.
+    ok &= texture_batch_bilinear(texture_handle, thread_info, options, mask,
+                                 s, t, dsdx, dtdx, dsdy, dtdy, nchannels,
+                                 result, dresultds, dresultdt);
+    if (!mask)
+        return ok;
+
+    // Texture the remaining points individually
     TextureOpt opt;
     opt.firstchannel        = options.firstchannel;
     opt.subimage            = options.subimage;
@@ -1357,34 +1895,102 @@ TextureSystemImpl::texture(TextureHandle* texture_handle,
     opt.colortransformid    = options.colortransformid;
     // rwrap not needed for 2D texture
 
-    bool ok          = true;
-    Tex::RunMask bit = 1;
-    float* r         = OIIO_ALLOCA(float, 3 * nchannels);
-    float* drds      = r + nchannels;
-    float* drdt      = drds + nchannels;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            opt.rnd    = options.rnd[i];
-            // rblur, rwidth not needed for 2D texture
-            if (dresultds) {
-                ok &= texture(texture_handle, thread_info, opt, s[i], t[i],
-                              dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r,
-                              drds, drdt);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
-                }
-            } else {
-                ok &= texture(texture_handle, thread_info, opt, s[i], t[i],
-                              dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
-                }
+    float* r    = OIIO_ALLOCA(float, 3 * nchannels);
+    float* drds = r + nchannels;
+    float* drdt = drds + nchannels;
+    float filtwidth[Tex::BatchWidth];
+    batch_filtwidths(options, dsdx, dtdx, dsdy, dtdy, filtwidth);
+    int order[Tex::BatchWidth];
+    int nlanes = batch_lane_order(texture_handle, (PerThreadInfo*)thread_info,
+                                  options.subimage, mask, s, t, filtwidth,
+                                  order);
+    for (int n = 0; n < nlanes; ++n) {
+        int i = order[n];
+        opt.sblur  = options.sblur[i];
+        opt.tblur  = options.tblur[i];
+        opt.swidth = options.swidth[i];
+        opt.twidth = options.twidth[i];
+        opt.rnd    = options.rnd[i];
+        // rblur, rwidth not needed for 2D texture
+        if (dresultds) {
+            ok &= texture(texture_handle, thread_info, opt, s[i], t[i],
+                          dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r,
+                          drds, drdt);
+            for (int c = 0; c < nchannels; ++c) {
+                result[c * Tex::BatchWidth + i]    = r[c];
+                dresultds[c * Tex::BatchWidth + i] = drds[c];
+                dresultdt[c * Tex::BatchWidth + i] = drdt[c];
+            }
+        } else {
+            ok &= texture(texture_handle, thread_info, opt, s[i], t[i],
+                          dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r);
+            for (int c = 0; c < nchannels; ++c) {
+                result[c * Tex::BatchWidth + i] = r[c];
+            }
+        }
+    }
+    return ok;
+}
+
+
+
+bool
+TextureSystemImpl::texture(TextureHandle* texture_handle,
+                           Perthread* thread_info, const Sampler* sampler_,
+                           Tex::RunMask mask, const float* s, const float* t,
+                           const float* dsdx, const float* dtdx,
+                           const float* dsdy, const float* dtdy, int nchannels,
+                           float* result, float* dresultds, float* dresultdt)
+{
+    pvt::TraceScope trace("TS::texture_batch");
+    const SamplerImpl* sampler = (const SamplerImpl*)sampler_;
+    if (!sampler) {
+        error("texture() called with a null Sampler");
+        return false;
+    }
+    bool ok = true;
+    if (is_udim(texture_handle)) {
+        ok = texture_batch_udim(
+            texture_handle, thread_info, mask, s, t,
+            [&](TextureHandle* file, Tex::RunMask m, const float* ss,
+                const float* tt) {
+                return texture(file, thread_info, sampler_, m, ss, tt, dsdx,
+                               dtdx, dsdy, dtdy, nchannels, result,
+                               dresultds, dresultdt);
+            });
+        if (!mask)
+            return ok;
+    }
+    ok &= texture_batch_bilinear(texture_handle, thread_info,
+                                 sampler->batchoptions, mask, s, t, dsdx,
+                                 dtdx, dsdy, dtdy, nchannels, result,
+                                 dresultds, dresultdt);
+    if (!mask)
+        return ok;
+
+    // Every lane shares the sampler's options, so unlike the TextureOptBatch
+    // version there is nothing to gather per lane.
+    float* r    = OIIO_ALLOCA(float, 3 * nchannels);
+    float* drds = r + nchannels;
+    float* drdt = drds + nchannels;
+    float filtwidth[Tex::BatchWidth];
+    batch_filtwidths(sampler->batchoptions, dsdx, dtdx, dsdy, dtdy,
+                     filtwidth);
+    int order[Tex::BatchWidth];
+    int nlanes = batch_lane_order(texture_handle, (PerThreadInfo*)thread_info,
+                                  sampler->options.subimage, mask, s, t,
+                                  filtwidth, order);
+    for (int n = 0; n < nlanes; ++n) {
+        int i = order[n];
+        ok &= texture(texture_handle, thread_info, sampler_, s[i], t[i],
+                      dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r,
+                      dresultds ? drds : nullptr, dresultds ? drdt : nullptr);
+        for (int c = 0; c < nchannels; ++c)
+            result[c * Tex::BatchWidth + i] = r[c];
+        if (dresultds) {
+            for (int c = 0; c < nchannels; ++c) {
+                dresultds[c * Tex::BatchWidth + i] = drds[c];
+                dresultdt[c * Tex::BatchWidth + i] = drdt[c];
             }
         }
     }
@@ -1393,6 +1999,421 @@ TextureSystemImpl::texture(TextureHandle* texture_handle,
 
 
 
+void
+TextureSystemImpl::batch_filtwidths(const TextureOptBatch& options,
+                                    const float* dsdx, const float* dtdx,
+                                    const float* dsdy, const float* dtdy,
+                                    float* filtwidth)
+{
+    if (!m_coherent_batches)
+        return;  // batch_lane_order() won't look at them
+    bool aniso = (options.mipmode == Tex::MipMode::Default
+                  || options.mipmode == Tex::MipMode::Aniso
+                  || options.mipmode == Tex::MipMode::StochasticAniso);
+    for (int i = 0; i < Tex::BatchWidth; ++i) {
+        float sfilt  = std::max(fabsf(dsdx[i]), fabsf(dsdy[i]))
+                      * options.swidth[i];
+        float tfilt  = std::max(fabsf(dtdx[i]), fabsf(dtdy[i]))
+                      * options.twidth[i];
+        filtwidth[i] = aniso ? std::min(sfilt, tfilt) : std::max(sfilt, tfilt);
+    }
+}
+
+
+
+bool
+TextureSystemImpl::texture_batch_bilinear(
+    TextureHandle* texture_handle_, Perthread* thread_info_,
+    const TextureOptBatch& options, Tex::RunMask& mask, const float* s_,
+    const float* t_, const float* dsdx_, const float* dtdx_,
+    const float* dsdy_, const float* dtdy_, int nchannels, float* result,
+    float* dresultds, float* dresultdt)
+{
+    using vfloat_t    = simd::VecType<float, Tex::BatchWidth>::type;
+    using vint_t      = simd::VecType<int, Tex::BatchWidth>::type;
+    using vbool_t     = simd::VecType<bool, Tex::BatchWidth>::type;
+    constexpr int BWd = Tex::BatchWidth;
+
+    // Only isotropic bilinear lookups are handled here. Anything fancier
+    // (including the default anisotropic mode) goes point by point.
+    if (nchannels > 4 || !options.subimagename.empty()
+        || (options.mipmode != Tex::MipMode::NoMIP
+            && options.mipmode != Tex::MipMode::OneLevel
+            && options.mipmode != Tex::MipMode::Trilinear)
+        || (options.interpmode != Tex::InterpMode::Bilinear
+            && options.interpmode != Tex::InterpMode::SmartBicubic))
+        return true;
+
+    TextureFile* texturefile = (TextureFile*)texture_handle_;
+    if (!texturefile || texturefile->is_udim())
+        return true;
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info_);
+    texturefile = verify_texturefile(texturefile, thread_info);
+    if (!texturefile || texturefile->broken() || options.subimage < 0
+        || options.subimage >= texturefile->subimages())
+        return true;  // Let the per-point path sort out the errors
+    // As in texture_with_lookup, per-file time is only kept at the highest
+    // statistics levels.
+    Timer timer(m_statslevel >= 3 ? Timer::StartNow : Timer::DontStartNow);
+
+    const ImageCacheFile::SubimageInfo& subinfo(
+        texturefile->subimageinfo(options.subimage));
+    const ImageSpec& spec(texturefile->spec(options.subimage, 0));
+    int firstchannel   = options.firstchannel;
+    int actualchannels = OIIO::clamp(spec.nchannels - firstchannel, 0,
+                                     nchannels);
+    if (subinfo.is_constant_image || !subinfo.full_pixel_range
+        || (actualchannels < nchannels && firstchannel == 0
+            && m_gray_to_rgb))
+        return true;
+
+    Tex::Wrap swrap = options.swrap, twrap = options.twrap;
+    if (swrap == Tex::Wrap::Default)
+        swrap = (Tex::Wrap)texturefile->swrap();
+    if (swrap == Tex::Wrap::Periodic && ispow2(spec.width))
+        swrap = Tex::Wrap::PeriodicPow2;
+    if (twrap == Tex::Wrap::Default)
+        twrap = (Tex::Wrap)texturefile->twrap();
+    if (twrap == Tex::Wrap::Periodic && ispow2(spec.height))
+        twrap = Tex::Wrap::PeriodicPow2;
+    if (!wrap_batch_supported(swrap) || !wrap_batch_supported(twrap))
+        return true;
+
+    auto lanes = [](int bits) {
+        return (vint_t(bits) & vint_t::Giota()) != vint_t::Zero();
+    };
+    vbool_t active = lanes(int(mask & Tex::RunMaskOn));
+    bool trilinear = (options.mipmode == Tex::MipMode::Trilinear);
+    if (((trilinear && (m_stochastic & StochasticStrategy_MIP))
+         || (m_stochastic & StochasticStrategy_Texel))
+        && any(active & (vfloat_t(options.rnd) >= vfloat_t::Zero())))
+        return true;
+
+    // Per-level dimensions, so each lane can fetch those of its own level.
+    int nmiplevels    = subinfo.n_mip_levels;
+    int min_mip_level = subinfo.min_mip_level;
+    struct LevelDims {
+        int x, y, width, height, tile_width, tile_height;
+        bool ok;
+    };
+    LevelDims* dims = OIIO_ALLOCA(LevelDims, nmiplevels);
+    bool tilepow2   = true;
+    for (int m = 0; m < nmiplevels; ++m) {
+        const ImageSpec& mspec(texturefile->spec(options.subimage, m));
+        LevelDims& d(dims[m]);
+        d.x           = mspec.x;
+        d.y           = mspec.y;
+        d.width       = mspec.width;
+        d.height      = mspec.height;
+        d.tile_width  = mspec.tile_width;
+        d.tile_height = mspec.tile_height;
+        d.ok          = mspec.tile_width > 0 && mspec.tile_height > 0
+               && texturefile->levelinfo(options.subimage, m).full_pixel_range;
+        tilepow2 &= ispow2(d.tile_width) && ispow2(d.tile_height);
+    }
+
+    vfloat_t s(s_), t(t_), dsdx(dsdx_), dtdx(dtdx_), dsdy(dsdy_),
+        dtdy(dtdy_);
+    if (m_flip_t) {
+        t    = 1.0f - t;
+        dtdx = -dtdx;
+        dtdy = -dtdy;
+    }
+
+    // Choose the MIP level(s) and their weights for every lane, exactly as
+    // compute_miplevels does for one point.
+    vint_t miplevel[2];
+    vfloat_t levelweight[2];
+    if (options.mipmode == Tex::MipMode::NoMIP) {
+        miplevel[0]    = vint_t(min_mip_level);
+        miplevel[1]    = miplevel[0];
+        levelweight[0] = vfloat_t::One();
+        levelweight[1] = vfloat_t::Zero();
+    } else {
+        vfloat_t swidth(options.swidth), twidth(options.twidth);
+        vfloat_t sfilt = max(abs(dsdx * swidth), abs(dsdy * swidth));
+        vfloat_t tfilt = max(abs(dtdx * twidth), abs(dtdy * twidth));
+        vfloat_t filtwidth = options.conservative_filter ? max(sfilt, tfilt)
+                                                         : min(sfilt, tfilt);
+        filtwidth += max(vfloat_t(options.sblur), vfloat_t(options.tblur));
+        vint_t level1(nmiplevels - 1);
+        vfloat_t blend = vfloat_t::Zero();
+        vbool_t found  = !active;
+        for (int m = min_mip_level; m < nmiplevels && !all(found); ++m) {
+            vfloat_t filtwidth_ras = filtwidth * float(subinfo.minwh[m]);
+            vbool_t here = (filtwidth_ras <= 1.0f) & !found;
+            level1       = select(here, vint_t(m), level1);
+            vfloat_t b   = min(max(2.0f * filtwidth_ras - 1.0f,
+                                   vfloat_t::Zero()),
+                               vfloat_t::One());
+            blend        = select(here, b, blend);
+            found |= here;
+        }
+        // Lanes that never got small enough use the coarsest level, and
+        // lanes that want more resolution than we have use the finest.
+        vbool_t single = !found | (level1 <= vint_t(min_mip_level));
+        if (!trilinear)
+            single = vbool_t::True();
+        miplevel[0]    = select(single, level1, level1 - 1);
+        miplevel[1]    = level1;
+        levelweight[0] = select(single, vfloat_t::One(), 1.0f - blend);
+        levelweight[1] = select(single, vfloat_t::Zero(), blend);
+    }
+
+    int tile_chbegin = 0, tile_chend = spec.nchannels;
+    if (spec.nchannels > m_max_tile_channels) {
+        // For files with many channels, narrow the range we cache
+        tile_chbegin = firstchannel;
+        tile_chend   = firstchannel + actualchannels;
+    }
+    TypeDesc::BASETYPE pixeltype = texturefile->pixeltype(options.subimage);
+    size_t channelsize = texturefile->channelsize(options.subimage);
+    size_t choffset    = channelsize * (firstchannel - tile_chbegin);
+    float fill         = (nchannels > actualchannels) ? options.fill : 0.0f;
+
+    vfloat_t accum[4], daccumds[4], daccumdt[4];
+    for (int c = 0; c < nchannels; ++c) {
+        accum[c]    = vfloat_t::Zero();
+        daccumds[c] = vfloat_t::Zero();
+        daccumdt[c] = vfloat_t::Zero();
+    }
+    // Texels gathered per corner, channel, and lane
+    alignas(Tex::BatchAlign) float texels[4][4][BWd] = {};
+    vbool_t slow  = !active;  // Lanes left for the per-point path
+    int nsamples  = 0;
+    for (int level = 0; level < 2; ++level) {
+        vbool_t need = !slow & (levelweight[level] > vfloat_t::Zero());
+        if (!any(need))
+            continue;
+        const vint_t& lev(miplevel[level]);
+        alignas(Tex::BatchAlign) int lx[BWd], ly[BWd], lw[BWd], lh[BWd];
+        alignas(Tex::BatchAlign) int ltw[BWd], lth[BWd], lok[BWd];
+        for (int i = 0; i < BWd; ++i) {
+            const LevelDims& d(dims[lev[i]]);
+            lx[i]  = d.x;
+            ly[i]  = d.y;
+            lw[i]  = d.width;
+            lh[i]  = d.height;
+            ltw[i] = d.tile_width;
+            lth[i] = d.tile_height;
+            lok[i] = d.ok;
+        }
+        vint_t xorigin(lx), yorigin(ly), width(lw), height(lh);
+        vint_t tilew(ltw), tileh(lth);
+        vfloat_t fwidth(width), fheight(height);
+
+        // Texel coordinates and bilinear weights, as st_to_texel_simd
+        vfloat_t sx, ty;
+        if (texturefile->sample_border() == 0) {
+            sx = s * fwidth + (vfloat_t(xorigin) - 0.5f);
+            ty = t * fheight + (vfloat_t(yorigin) - 0.5f);
+        } else {
+            sx = s * (fwidth - 1.0f) + vfloat_t(xorigin);
+            ty = t * (fheight - 1.0f) + vfloat_t(yorigin);
+        }
+        vint_t s0, t0;
+        vfloat_t sfrac = floorfrac(sx, &s0);
+        vfloat_t tfrac = floorfrac(ty, &t0);
+        vint_t s1 = s0 + 1, t1 = t0 + 1;
+        vbool_t valid = wrap_batch(swrap, s0, xorigin, width)
+                        & wrap_batch(swrap, s1, xorigin, width)
+                        & wrap_batch(twrap, t0, yorigin, height)
+                        & wrap_batch(twrap, t1, yorigin, height);
+
+        // Tile-relative texel coordinates. A lane is handled here only if
+        // all four of its texels are valid and live on the same tile.
+        s0 -= xorigin;
+        s1 -= xorigin;
+        t0 -= yorigin;
+        t1 -= yorigin;
+        vint_t ts0, ts1, tt0, tt1;
+        if (tilepow2) {
+            ts0 = s0 & (tilew - 1);
+            ts1 = s1 & (tilew - 1);
+            tt0 = t0 & (tileh - 1);
+            tt1 = t1 & (tileh - 1);
+        } else {
+            ts0 = s0 % tilew;
+            ts1 = s1 % tilew;
+            tt0 = t0 % tileh;
+            tt1 = t1 % tileh;
+        }
+        vint_t tilex = s0 - ts0, tiley = t0 - tt0;
+        vbool_t fast = need & valid & (vint_t(lok) != vint_t::Zero())
+                       & (tilex == s1 - ts1) & (tiley == t1 - tt1);
+        tilex += xorigin;
+        tiley += yorigin;
+
+        // Find each distinct tile once and gather the texels of every lane
+        // that lands on it.
+        int fastbits = fast.bitmask();
+        int pending  = fastbits;
+        while (pending) {
+            int i = 0;
+            while (!(pending & (1 << i)))
+                ++i;
+            vbool_t same = (lev == vint_t(lev[i]))
+                           & (tilex == vint_t(tilex[i]))
+                           & (tiley == vint_t(tiley[i]));
+            int group = pending & same.bitmask();
+            pending &= ~group;
+            TileID id(*texturefile, options.subimage, lev[i], tilex[i],
+                      tiley[i], 0, tile_chbegin, tile_chend,
+                      options.colortransformid);
+            if (!find_tile(id, thread_info, true))
+                error("{}", m_imagecache->geterror());
+            TileRef& tile(thread_info->tile);
+            if (!tile->valid()) {
+                // Leave these for the per-point path to report on
+                fastbits &= ~group;
+                continue;
+            }
+            const unsigned char* data = tile->bytedata() + choffset;
+            for (int j = i; j < BWd; ++j) {
+                if (!(group & (1 << j)))
+                    continue;
+                const unsigned char* p[4]
+                    = { data + tile->pixel_offset(ts0[j], tt0[j]),
+                        data + tile->pixel_offset(ts1[j], tt0[j]),
+                        data + tile->pixel_offset(ts0[j], tt1[j]),
+                        data + tile->pixel_offset(ts1[j], tt1[j]) };
+                for (int k = 0; k < 4; ++k) {
+                    vfloat4 texel;
+                    if (pixeltype == TypeDesc::UINT8)
+                        texel = uchar2float4(p[k]);
+                    else if (pixeltype == TypeDesc::UINT16)
+                        texel = ushort2float4((const uint16_t*)p[k]);
+                    else if (pixeltype == TypeDesc::HALF)
+                        texel = vfloat4((const half*)p[k]);
+                    else
+                        texel.load((const float*)p[k]);
+                    for (int c = 0; c < actualchannels; ++c)
+                        texels[k][c][j] = texel[c];
+                }
+            }
+        }
+        fast = lanes(fastbits);
+        slow |= need & !fast;
+        nsamples += reduce_add(blend0(vint_t::One(), fast));
+
+        // Lane-parallel bilinear interpolation, weighted by level
+        vfloat_t lweight = blend0(levelweight[level], fast);
+        for (int c = 0; c < actualchannels; ++c) {
+            vfloat_t t00(texels[0][c]), t01(texels[1][c]);
+            vfloat_t t10(texels[2][c]), t11(texels[3][c]);
+            accum[c] += blend0(lweight * bilerp(t00, t01, t10, t11, sfrac,
+                                                tfrac),
+                               fast);
+            if (dresultds) {
+                daccumds[c] += blend0(lweight
+                                          * (fwidth
+                                             * lerp(t01 - t00, t11 - t10,
+                                                    tfrac)),
+                                      fast);
+                daccumdt[c] += blend0(lweight
+                                          * (fheight
+                                             * lerp(t10 - t00, t11 - t01,
+                                                    sfrac)),
+                                      fast);
+            }
+        }
+        for (int c = actualchannels; c < nchannels; ++c)
+            accum[c] += lweight * fill;
+    }
+
+    // Store the lanes we finished and hand the rest back to the caller.
+    vbool_t done = active & !slow;
+    for (int c = 0; c < nchannels; ++c) {
+        accum[c].store_mask(done, result + c * BWd);
+        if (dresultds) {
+            if (m_flip_t)
+                daccumdt[c] = -daccumdt[c];
+            daccumds[c].store_mask(done, dresultds + c * BWd);
+            daccumdt[c].store_mask(done, dresultdt + c * BWd);
+        }
+    }
+    mask &= ~Tex::RunMask(done.bitmask());
+
+    int ndone = reduce_add(blend0(vint_t::One(), done));
+    if (!ndone)
+        return true;
+    if (m_capturing.load(std::memory_order_relaxed))
+        capture(texturefile, options, Tex::RunMask(done.bitmask()), s_, t_,
+                dsdx_, dtdx_, dsdy_, dtdy_, nchannels);
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    ++stats.texture_batches;
+    stats.texture_queries += ndone;
+    stats.aniso_queries += nsamples;
+    stats.aniso_probes += nsamples;
+    stats.bilinear_interps += nsamples;
+    if (m_statslevel >= 3) {
+        texturefile->count_texture_queries(ndone, nsamples,
+                                           (long long)(timer() * 1.0e9));
+        for (int i = 0; i < BWd; ++i) {
+            if (!done[i])
+                continue;
+            texturefile->count_texture_miplevel(miplevel[0][i]);
+            if (levelweight[1][i] > 0.0f)
+                texturefile->count_texture_miplevel(miplevel[1][i]);
+        }
+    }
+    return true;
+}
+
+
+
+int
+TextureSystemImpl::batch_lane_order(TextureHandle* texture_handle,
+                                    PerThreadInfo* thread_info, int subimage,
+                                    Tex::RunMask mask, const float* s,
+                                    const float* t, const float* filtwidth,
+                                    int* order)
+{
+    int nlanes = 0;
+    for (int i = 0; i < Tex::BatchWidth; ++i)
+        if (mask & (Tex::RunMask(1) << i))
+            order[nlanes++] = i;
+    if (!m_coherent_batches || nlanes < 3)
+        return nlanes;
+    TextureFile* texturefile = (TextureFile*)texture_handle;
+    if (!texturefile || texturefile->is_udim())
+        return nlanes;
+    thread_info = m_imagecache->get_perthread_info(thread_info);
+    texturefile = m_imagecache->verify_file(texturefile, thread_info);
+    if (!texturefile || texturefile->broken() || subimage < 0
+        || subimage >= texturefile->subimages())
+        return nlanes;
+
+    // Key each lane by the MIP level its filter width will most likely
+    // select and by the tile its center falls in on that level. This
+    // needn't be exact: it only has to put lanes that will hit the same
+    // tile next to each other, so that their lookups come straight from
+    // the per-thread microcache.
+    const ImageCacheFile::SubimageInfo& subinfo(
+        texturefile->subimageinfo(subimage));
+    uint32_t key[Tex::BatchWidth];
+    for (int n = 0; n < nlanes; ++n) {
+        int i = order[n];
+        int m = subinfo.min_mip_level;
+        while (m < subinfo.n_mip_levels - 1
+               && filtwidth[i] * subinfo.minwh[m] > 1.0f)
+            ++m;
+        const ImageSpec& spec(texturefile->spec(subimage, m));
+        int tx = ifloor(OIIO::clamp(s[i], -1.0e6f, 1.0e6f) * spec.width)
+                 / std::max(spec.tile_width, 1);
+        int ty = ifloor(OIIO::clamp(t[i], -1.0e6f, 1.0e6f) * spec.height)
+                 / std::max(spec.tile_height, 1);
+        key[i] = (uint32_t(m) << 24) | (uint32_t(ty & 0xfff) << 12)
+                 | uint32_t(tx & 0xfff);
+    }
+    std::stable_sort(order, order + nlanes,
+                     [&](int a, int b) { return key[a] < key[b]; });
+    return nlanes;
+}
+
+
+
 bool
 TextureSystemImpl::texture_lookup_nomip(
     TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& options,
@@ -1415,13 +2436,23 @@ TextureSystemImpl::texture_lookup_nomip(
         &TextureSystemImpl::sample_bicubic,
         &TextureSystemImpl::sample_bilinear,
     };
-    sampler_prototype sampler      = sample_functions[(int)options.interpmode];
-    OIIO_SIMD4_ALIGN float sval[4] = { s, 0.0f, 0.0f, 0.0f };
-    OIIO_SIMD4_ALIGN float tval[4] = { t, 0.0f, 0.0f, 0.0f };
+    TextureOpt::InterpMode interpmode = options.interpmode;
+    OIIO_SIMD4_ALIGN float sval[4]    = { s, 0.0f, 0.0f, 0.0f };
+    OIIO_SIMD4_ALIGN float tval[4]    = { t, 0.0f, 0.0f, 0.0f };
     static OIIO_SIMD4_ALIGN float weight[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
     ImageCacheFile::SubimageInfo& subinfo(
         texturefile.subimageinfo(options.subimage));
     int min_mip_level = subinfo.min_mip_level;
+    if (options.rnd >= 0.0f && (m_stochastic & StochasticStrategy_Texel)
+        && !dresultds) {
+        stochastic_texel(texturefile,
+                         texturefile.spec(options.subimage, min_mip_level),
+                         sval[0], tval[0], options.rnd);
+        interpmode = TextureOpt::InterpClosest;
+    }
+    sampler_prototype sampler = sample_functions[(int)interpmode];
+    if (m_statslevel >= 3)
+        texturefile.count_texture_miplevel(min_mip_level);
     bool ok = (this->*sampler)(1, sval, tval, min_mip_level, texturefile,
                                thread_info, options, nchannels_result,
                                actualchannels, weight, (vfloat4*)result,
@@ -1431,7 +2462,7 @@ TextureSystemImpl::texture_lookup_nomip(
     ImageCacheStatistics& stats(thread_info->m_stats);
     ++stats.aniso_queries;
     ++stats.aniso_probes;
-    switch (options.interpmode) {
+    switch (interpmode) {
     case TextureOpt::InterpClosest: ++stats.closest_interps; break;
     case TextureOpt::InterpBilinear: ++stats.bilinear_interps; break;
     case TextureOpt::InterpBicubic: ++stats.cubic_interps; break;
@@ -1657,8 +2688,13 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
         ((simd::vfloat4*)dresultdt)->clear();
     }
 
-    bool stoch_mip = (options.rnd >= 0.0f
-                      && (m_stochastic & StochasticStrategy_MIP));
+    bool stoch       = (options.rnd >= 0.0f);
+    bool stoch_mip   = stoch
+                     && (m_stochastic
+                         & (StochasticStrategy_MIP | StochasticStrategy_Texel));
+    bool stoch_texel = stoch && (m_stochastic & StochasticStrategy_Texel)
+                       && !dresultds
+                       && options.interpmode != TextureOpt::InterpClosest;
 
     adjust_width(dsdx, dtdx, dsdy, dtdy, options.swidth, options.twidth);
 
@@ -1684,6 +2720,8 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
         &TextureSystemImpl::sample_bilinear,
     };
     sampler_prototype sampler = sample_functions[(int)options.interpmode];
+    if (stoch_texel)
+        sampler = &TextureSystemImpl::sample_closest;
 
     // FIXME -- support for smart cubic?
 
@@ -1702,6 +2740,17 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
         if (!levelweight[level])  // No contribution from this level, skip it
             continue;
         vfloat4 r, drds, drdt;
+        if (stoch_texel) {
+            // Only one level is on, so rnd is ours to use.
+            sval[0] = s;
+            tval[0] = t;
+            stochastic_texel(texturefile,
+                             texturefile.spec(options.subimage,
+                                              miplevel[level]),
+                             sval[0], tval[0], options.rnd);
+        }
+        if (m_statslevel >= 3)
+            texturefile.count_texture_miplevel(miplevel[level]);
         ok &= (this->*sampler)(1, sval, tval, miplevel[level], texturefile,
                                thread_info, options, nchannels_result,
                                actualchannels, weight, &r,
@@ -1726,6 +2775,10 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
     ImageCacheStatistics& stats(thread_info->m_stats);
     stats.aniso_queries += npointson;
     stats.aniso_probes += npointson;
+    if (stoch_texel) {
+        stats.closest_interps += npointson;
+        return ok;
+    }
     switch (options.interpmode) {
     case TextureOpt::InterpClosest: stats.closest_interps += npointson; break;
     case TextureOpt::InterpBilinear: stats.bilinear_interps += npointson; break;
@@ -1876,9 +2929,15 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
     int naturalsres    = (int)(1.0f / sfilt_noblur);
     int naturaltres    = (int)(1.0f / tfilt_noblur);
 
+    // A single texel tap implies a single MIP level and a single probe.
     bool stoch       = (options.rnd >= 0.0f);
-    bool stoch_mip   = stoch && (m_stochastic & StochasticStrategy_MIP);
-    bool stoch_aniso = stoch && (m_stochastic & StochasticStrategy_Aniso);
+    int strategy     = stoch ? m_stochastic : StochasticStrategy_None;
+    bool stoch_texel = (strategy & StochasticStrategy_Texel) && !dresultds
+                       && options.interpmode != TextureOpt::InterpClosest;
+    if (strategy & StochasticStrategy_Texel)
+        strategy |= StochasticStrategy_MIP | StochasticStrategy_Aniso;
+    bool stoch_mip   = (strategy & StochasticStrategy_MIP);
+    bool stoch_aniso = (strategy & StochasticStrategy_Aniso);
     // Scale by 'width'
     adjust_width(dsdx, dtdx, dsdy, dtdy, options.swidth, options.twidth);
 
@@ -1958,7 +3017,20 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
         ++npointson;
         vfloat4 r, drds, drdt;
         int lev = miplevel[level];
-        switch (options.interpmode) {
+        if (m_statslevel >= 3)
+            texturefile.count_texture_miplevel(lev);
+        if (stoch_texel) {
+            // The probe position already used rnd, so pick the texel with
+            // its low-order digits, which are uncorrelated with it. A
+            // closest-texel probe there is then all we need.
+            float rnd = options.rnd * 4096.0f;
+            rnd -= floorf(rnd);
+            stochastic_texel(texturefile,
+                             texturefile.spec(options.subimage, lev), sval[0],
+                             tval[0], rnd);
+        }
+        switch (stoch_texel ? TextureOpt::InterpClosest
+                            : options.interpmode) {
         case TextureOpt::InterpClosest:
             ok &= sample_closest(nsamples, sval, tval, lev, texturefile,
                                  thread_info, options, nchannels_result,
@@ -2063,20 +3135,29 @@ TextureSystemImpl::pole_color(TextureFile& texturefile,
                     p[c] = 0.0f;
                 const unsigned char* texel = tile->bytedata()
                                              + y * spec.tile_width * pixelsize;
-                for (int i = 0; i < width; ++i, texel += pixelsize)
-                    for (int c = 0; c < spec.nchannels; ++c) {
-                        if (pixeltype == TypeDesc::UINT8)
-                            p[c] += uchar2float(texel[c]);
-                        else if (pixeltype == TypeDesc::UINT16)
-                            p[c] += convert_type<uint16_t, float>(
-                                ((const uint16_t*)texel)[c]);
-                        else if (pixeltype == TypeDesc::HALF)
-                            p[c] += ((const half*)texel)[c];
-                        else {
-                            OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
-                            p[c] += ((const float*)texel)[c];
+                if (pixeltype == TypeDesc::HALF) {
+                    // Convert the whole row at once rather than per value
+                    std::vector<float> row(size_t(width) * spec.nchannels);
+                    convert_half_to_float(cspan<half>((const half*)texel,
+                                                      row.size()),
+                                          row);
+                    for (int i = 0; i < width; ++i)
+                        for (int c = 0; c < spec.nchannels; ++c)
+                            p[c] += row[size_t(i) * spec.nchannels + c];
+                } else {
+                    for (int i = 0; i < width; ++i, texel += pixelsize)
+                        for (int c = 0; c < spec.nchannels; ++c) {
+                            if (pixeltype == TypeDesc::UINT8)
+                                p[c] += uchar2float(texel[c]);
+                            else if (pixeltype == TypeDesc::UINT16)
+                                p[c] += convert_type<uint16_t, float>(
+                                    ((const uint16_t*)texel)[c]);
+                            else {
+                                OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
+                                p[c] += ((const float*)texel)[c];
+                            }
                         }
-                    }
+                }
                 for (int c = 0; c < spec.nchannels; ++c)
                     p[c] *= scale;
             }
@@ -2383,32 +3464,15 @@ TextureSystemImpl::sample_bilinear(
             const unsigned char* p = tile->bytedata() + offset
                                      + channelsize
                                            * (firstchannel - id.chbegin());
-            if (pixeltype == TypeDesc::UINT8) {
-                texel_simd[0][0] = uchar2float4(p);
-                texel_simd[0][1] = uchar2float4(p + pixelsize);
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = uchar2float4(p);
-                texel_simd[1][1] = uchar2float4(p + pixelsize);
-            } else if (pixeltype == TypeDesc::UINT16) {
-                texel_simd[0][0] = ushort2float4((uint16_t*)p);
-                texel_simd[0][1] = ushort2float4((uint16_t*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = ushort2float4((uint16_t*)p);
-                texel_simd[1][1] = ushort2float4((uint16_t*)(p + pixelsize));
-            } else if (pixeltype == TypeDesc::HALF) {
-                texel_simd[0][0] = vfloat4((half*)p);
-                texel_simd[0][1] = vfloat4((half*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = vfloat4((half*)p);
-                texel_simd[1][1] = vfloat4((half*)(p + pixelsize));
-            } else {
-                OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
-                texel_simd[0][0].load((const float*)p);
-                texel_simd[0][1].load((const float*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0].load((const float*)p);
-                texel_simd[1][1].load((const float*)(p + pixelsize));
-            }
+            // Fetch each column's two rows together
+            const unsigned char* p1 = p + pixelsize * spec.tile_width;
+            simd::vfloat8 left  = load_texel_pair(pixeltype, p, p1);
+            simd::vfloat8 right = load_texel_pair(pixeltype, p + pixelsize,
+                                                  p1 + pixelsize);
+            texel_simd[0][0]    = left.lo();
+            texel_simd[1][0]    = left.hi();
+            texel_simd[0][1]    = right.lo();
+            texel_simd[1][1]    = right.hi();
         } else {
             bool noreusetile      = (options.swrap == TextureOpt::WrapMirror);
             simd::vint4 tile_st   = (sttex - xy) % tilewh;
@@ -2444,20 +3508,8 @@ TextureSystemImpl::sample_bilinear(
                     imagesize_t offset = tile->pixel_offset(tile_s, tile_t);
                     offset += (firstchannel - id.chbegin()) * channelsize;
                     OIIO_DASSERT(offset < spec.tile_bytes());
-                    if (pixeltype == TypeDesc::UINT8)
-                        texel_simd[j][i] = uchar2float4(
-                            (const unsigned char*)(tile->bytedata() + offset));
-                    else if (pixeltype == TypeDesc::UINT16)
-                        texel_simd[j][i] = ushort2float4(
-                            (const unsigned short*)(tile->bytedata() + offset));
-                    else if (pixeltype == TypeDesc::HALF)
-                        texel_simd[j][i] = vfloat4(
-                            (const half*)(tile->bytedata() + offset));
-                    else {
-                        OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
-                        texel_simd[j][i].load(
-                            (const float*)(tile->bytedata() + offset));
-                    }
+                    texel_simd[j][i] = load_texel(pixeltype,
+                                                  tile->bytedata() + offset);
                 }
             }
         }
@@ -2477,6 +3529,23 @@ TextureSystemImpl::sample_bilinear(
         }
 
         simd::vfloat4 weight_simd = weight;
+#if OIIO_SIMD_AVX
+        // With 8-wide registers, pair up the two rows so each lerp along s
+        // does both at once. The arithmetic is the same as bilerp().
+        simd::vfloat8 left(texel_simd[0][0], texel_simd[1][0]);
+        simd::vfloat8 right(texel_simd[0][1], texel_simd[1][1]);
+        simd::vfloat8 rows = left * (1.0f - sfrac) + right * sfrac;
+        accum += weight_simd * ((1.0f - tfrac) * rows.lo() + tfrac * rows.hi());
+        if (daccumds_) {
+            simd::vfloat4 scalex = weight_simd * float(spec.width);
+            simd::vfloat4 scaley = weight_simd * float(spec.height);
+            simd::vfloat8 ds     = right - left;
+            daccumds += scalex * lerp(ds.lo(), ds.hi(), tfrac);
+            daccumdt += scaley
+                        * lerp(left.hi() - left.lo(), right.hi() - right.lo(),
+                               sfrac);
+        }
+#else
         accum += weight_simd
                  * bilerp(texel_simd[0][0], texel_simd[0][1], texel_simd[1][0],
                           texel_simd[1][1], sfrac, tfrac);
@@ -2490,6 +3559,7 @@ TextureSystemImpl::sample_bilinear(
                         * lerp(texel_simd[1][0] - texel_simd[0][0],
                                texel_simd[1][1] - texel_simd[0][1], sfrac);
         }
+#endif
         if (use_fill && !all(stvalid)) {
             // Compute appropriate amount of "fill" color to extra channels in
             // non-"black"-wrapped regions.
@@ -2749,32 +3819,17 @@ TextureSystemImpl::sample_bicubic(
             const unsigned char* base = tile->bytedata() + offset
                                         + firstchannel_offset_bytes;
             OIIO_DASSERT(tile->data());
-            if (pixeltype == TypeDesc::UINT8) {
-                for (int j = 0, j_offset = 0; j < 4;
-                     ++j, j_offset += pixelsize * spec.tile_width)
-                    for (int i = 0, i_offset = j_offset; i < 4;
-                         ++i, i_offset += pixelsize)
-                        texel_simd[j][i] = uchar2float4(base + i_offset);
-            } else if (pixeltype == TypeDesc::UINT16) {
-                for (int j = 0, j_offset = 0; j < 4;
-                     ++j, j_offset += pixelsize * spec.tile_width)
-                    for (int i = 0, i_offset = j_offset; i < 4;
-                         ++i, i_offset += pixelsize)
-                        texel_simd[j][i] = ushort2float4(
-                            (const uint16_t*)(base + i_offset));
-            } else if (pixeltype == TypeDesc::HALF) {
-                for (int j = 0, j_offset = 0; j < 4;
-                     ++j, j_offset += pixelsize * spec.tile_width)
-                    for (int i = 0, i_offset = j_offset; i < 4;
-                         ++i, i_offset += pixelsize)
-                        texel_simd[j][i] = vfloat4(
-                            (const half*)(base + i_offset));
-            } else {
-                for (int j = 0, j_offset = 0; j < 4;
-                     ++j, j_offset += pixelsize * spec.tile_width)
-                    for (int i = 0, i_offset = j_offset; i < 4;
-                         ++i, i_offset += pixelsize)
-                        texel_simd[j][i].load((const float*)(base + i_offset));
+            // Fetch pairs of rows of each column together
+            int rowbytes = pixelsize * spec.tile_width;
+            for (int j = 0; j < 4; j += 2) {
+                for (int i = 0; i < 4; ++i) {
+                    const unsigned char* p = base + j * rowbytes
+                                             + i * pixelsize;
+                    simd::vfloat8 rows = load_texel_pair(pixeltype, p,
+                                                         p + rowbytes);
+                    texel_simd[j][i]     = rows.lo();
+                    texel_simd[j + 1][i] = rows.hi();
+                }
             }
         } else {
             simd::vint4 tile_s, tile_t;  // texel offset WITHIN its tile
@@ -2817,19 +3872,8 @@ TextureSystemImpl::sample_bicubic(
                     OIIO_DASSERT(tile->data());
                     imagesize_t offset = row_offset_bytes
                                          + column_offset_bytes[i];
-                    // const unsigned char *pixelptr = tile->bytedata() + offset[i];
-                    if (pixeltype == TypeDesc::UINT8)
-                        texel_simd[j][i] = uchar2float4(tile->bytedata()
-                                                        + offset);
-                    else if (pixeltype == TypeDesc::UINT16)
-                        texel_simd[j][i] = ushort2float4(
-                            (const uint16_t*)(tile->bytedata() + offset));
-                    else if (pixeltype == TypeDesc::HALF)
-                        texel_simd[j][i] = vfloat4(
-                            (const half*)(tile->bytedata() + offset));
-                    else
-                        texel_simd[j][i].load(
-                            (const float*)(tile->bytedata() + offset));
+                    texel_simd[j][i] = load_texel(pixeltype,
+                                                  tile->bytedata() + offset);
                 }
             }
         }
@@ -2904,6 +3948,23 @@ TextureSystemImpl::sample_bicubic(
         vfloat4 wx13_wy13 = AxyBxy(wx_1302, wy_1302);
         vfloat4 h         = wx13_wy13 / g;  // [ h0x h1x h0y h1y ]
 
+#if OIIO_SIMD_AVX >= 512
+        // With 16-wide registers, gather each column of the footprint (the
+        // RGBA of all four rows) into one vfloat16, so that the lerps along
+        // s are done for all rows at once.
+        simd::vfloat16 column[4];
+        for (int i = 0; i < 4; ++i)
+            column[i] = simd::vfloat16(texel_simd[0][i], texel_simd[1][i],
+                                       texel_simd[2][i], texel_simd[3][i]);
+        simd::vfloat16 lx = lerp(column[0], column[1],
+                                 simd::vfloat16(extract<0>(h)) /*h0x*/);
+        simd::vfloat16 rx = lerp(column[2], column[3],
+                                 simd::vfloat16(extract<1>(h)) /*h1x*/);
+        simd::vfloat16 cols = lerp(lx, rx,
+                                   simd::vfloat16(extract<1>(g)) /*g1x*/);
+        simd::vfloat4 col[4] = { cols.lo().lo(), cols.lo().hi(),
+                                 cols.hi().lo(), cols.hi().hi() };
+#else
         simd::vfloat4 col[4];
         for (int j = 0; j < 4; ++j) {
             simd::vfloat4 lx = lerp(texel_simd[j][0], texel_simd[j][1],
@@ -2912,10 +3973,33 @@ TextureSystemImpl::sample_bicubic(
                                     shuffle<1>(h) /*h1x*/);
             col[j]           = lerp(lx, rx, shuffle<1>(g) /*g1x*/);
         }
+#endif
         simd::vfloat4 ly          = lerp(col[0], col[1], shuffle<2>(h) /*h0y*/);
         simd::vfloat4 ry          = lerp(col[2], col[3], shuffle<3>(h) /*h1y*/);
         simd::vfloat4 weight_simd = weight;
         accum += weight_simd * lerp(ly, ry, shuffle<3>(g) /*g1y*/);
+#if OIIO_SIMD_AVX >= 512
+        if (daccumds_) {
+            // Each derivative is a quad-wise sum over the rows of the
+            // columns weighted by one axis's weights (or derivatives), then
+            // scaled by the other's.
+            auto quadsum = [](const simd::vfloat16& v) {
+                simd::vfloat16 ab = v + simd::shuffle4<1, 0, 3, 2>(v);
+                return (ab + simd::shuffle4<2, 3, 0, 1>(ab)).lo().lo();
+            };
+            simd::vfloat16 wy16 { shuffle<0>(wy), shuffle<1>(wy),
+                                  shuffle<2>(wy), shuffle<3>(wy) };
+            simd::vfloat16 dwy16 { shuffle<0>(dwy), shuffle<1>(dwy),
+                                   shuffle<2>(dwy), shuffle<3>(dwy) };
+            simd::vfloat16 dcol = dwx[0] * column[0] + dwx[1] * column[1]
+                                  + dwx[2] * column[2] + dwx[3] * column[3];
+            simd::vfloat16 wcol = wx[0] * column[0] + wx[1] * column[1]
+                                  + wx[2] * column[2] + wx[3] * column[3];
+            daccumds += weight_simd * float(spec.width) * quadsum(wy16 * dcol);
+            daccumdt += weight_simd * float(spec.height)
+                        * quadsum(dwy16 * wcol);
+        }
+#else
         if (daccumds_) {
             simd::vfloat4 scalex = weight_simd * float(spec.width);
             simd::vfloat4 scaley = weight_simd * float(spec.height);
@@ -2962,6 +4046,7 @@ TextureSystemImpl::sample_bicubic(
                                     + wx[2] * texel_simd[3][2]
                                     + wx[3] * texel_simd[3][3]));
         }
+#endif
 
         // Compute appropriate amount of "fill" color to extra channels in
         // non-"black"-wrapped regions.
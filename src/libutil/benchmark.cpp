@@ -2,11 +2,16 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <map>
+#include <mutex>
 #include <numeric>
 
 #include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/thread.h>
 
 
@@ -96,6 +101,7 @@ Benchmarker::compute_stats(std::vector<double>& times, size_t iterations)
         m_stddev    = sqrt(sum2 / (nt - 1));
         m_range     = times[last - 1] - times[first];
     }
+    m_samples = nt;
 
     if (m_trials & 1)  // odd
         m_median = times[m_trials / 2];
@@ -110,6 +116,259 @@ Benchmarker::compute_stats(std::vector<double>& times, size_t iterations)
 
 
 
+namespace {
+
+// One benchmark's results, as recorded by json_output or read back from a
+// baseline by compare_baseline.
+struct BenchRecord {
+    std::string name;
+    double avg        = 0.0;
+    double median     = 0.0;
+    double stddev     = 0.0;
+    double range      = 0.0;
+    size_t trials     = 0;
+    size_t samples    = 0;
+    size_t iterations = 0;
+    size_t work       = 1;
+};
+
+
+
+// The process-wide state behind Benchmarker::json_output and
+// compare_baseline. The JSON file is written when it is destroyed, at exit.
+struct BenchReport {
+    std::mutex mutex;
+    std::string json_filename;
+    std::vector<BenchRecord> results;
+    std::map<std::string, int> name_counts;
+    std::string baseline_filename;
+    std::map<std::string, BenchRecord> baseline;
+    double threshold = 0.05;
+    double nsigma    = 3.0;
+    int compared     = 0;
+    int regressions  = 0;
+
+    BenchReport();
+    ~BenchReport();
+    bool read_baseline(string_view filename);
+    void write_json() const;
+};
+
+
+
+BenchReport&
+bench_report()
+{
+    static BenchReport report;
+    return report;
+}
+
+
+
+BenchReport::BenchReport()
+{
+    json_filename = Sysutil::getenv("OIIO_BENCHMARK_JSON");
+    std::string compare(Sysutil::getenv("OIIO_BENCHMARK_COMPARE"));
+    if (compare.size() && !read_baseline(compare))
+        print(stderr, "Benchmarker: could not read baseline \"{}\"\n",
+              compare);
+}
+
+
+
+BenchReport::~BenchReport()
+{
+    if (json_filename.size())
+        write_json();
+    if (baseline_filename.size()) {
+        fflush(stdout);
+        print(stderr,
+              "Benchmarker: {} of {} benchmarks regressed from baseline "
+              "\"{}\"\n",
+              regressions, compared, baseline_filename);
+    }
+}
+
+
+
+void
+BenchReport::write_json() const
+{
+    std::string out = "{\n  \"time_units\": \"seconds per iteration\",\n"
+                      "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchRecord& r(results[i]);
+        out += Strutil::fmt::format(
+            "{}\n    {{ \"name\": \"{}\", \"avg\": {:.9g}, "
+            "\"median\": {:.9g}, \"stddev\": {:.9g}, \"range\": {:.9g}, "
+            "\"trials\": {}, \"samples\": {}, \"iterations\": {}, "
+            "\"work\": {} }}",
+            i ? "," : "", Strutil::escape_chars(r.name), r.avg, r.median,
+            r.stddev, r.range, r.trials, r.samples, r.iterations, r.work);
+    }
+    out += "\n  ]\n}\n";
+    if (!Filesystem::write_text_file(json_filename, out))
+        print(stderr, "Benchmarker: could not write \"{}\"\n",
+              json_filename);
+}
+
+
+
+// Read the "benchmarks" array of a file written by write_json. Its records
+// are flat objects whose fields are strings or numbers; unknown fields are
+// ignored, so that the format may grow.
+bool
+BenchReport::read_baseline(string_view filename)
+{
+    std::string text;
+    if (!Filesystem::read_text_file(filename, text))
+        return false;
+    string_view p(text);
+    if (!Strutil::parse_until_char(p, '[') || !Strutil::parse_char(p, '['))
+        return false;
+    std::map<std::string, BenchRecord> records;
+    while (Strutil::parse_char(p, '{')) {
+        BenchRecord r;
+        while (!Strutil::parse_char(p, '}')) {
+            string_view key, strval;
+            Strutil::skip_whitespace(p);
+            if (!p.size() || p.front() != '\"'
+                || !Strutil::parse_string(p, key)
+                || !Strutil::parse_char(p, ':'))
+                return false;
+            Strutil::skip_whitespace(p);
+            if (p.size() && p.front() == '\"') {
+                if (!Strutil::parse_string(p, strval))
+                    return false;
+                if (key == "name")
+                    r.name = Strutil::unescape_chars(strval);
+            } else {
+                size_t pos = 0;
+                double val = Strutil::stod(p.substr(0, 32), &pos);
+                if (!pos)
+                    return false;
+                p.remove_prefix(pos);
+                if (key == "avg")
+                    r.avg = val;
+                else if (key == "median")
+                    r.median = val;
+                else if (key == "stddev")
+                    r.stddev = val;
+                else if (key == "range")
+                    r.range = val;
+                else if (key == "trials")
+                    r.trials = size_t(val);
+                else if (key == "samples")
+                    r.samples = size_t(val);
+                else if (key == "iterations")
+                    r.iterations = size_t(val);
+                else if (key == "work")
+                    r.work = size_t(val);
+            }
+            Strutil::parse_char(p, ',');
+        }
+        if (r.name.size())
+            records[r.name] = r;
+        Strutil::parse_char(p, ',');
+    }
+    if (!Strutil::parse_char(p, ']'))
+        return false;
+    baseline          = std::move(records);
+    baseline_filename = filename;
+    return true;
+}
+
+}  // namespace
+
+
+
+void
+Benchmarker::json_output(string_view filename)
+{
+    BenchReport& report(bench_report());
+    std::lock_guard<std::mutex> lock(report.mutex);
+    report.json_filename = filename;
+}
+
+
+
+bool
+Benchmarker::compare_baseline(string_view filename, double threshold,
+                              double nsigma)
+{
+    BenchReport& report(bench_report());
+    std::lock_guard<std::mutex> lock(report.mutex);
+    report.threshold = threshold;
+    report.nsigma    = nsigma;
+    return report.read_baseline(filename);
+}
+
+
+
+int
+Benchmarker::regressions()
+{
+    BenchReport& report(bench_report());
+    std::lock_guard<std::mutex> lock(report.mutex);
+    return report.regressions;
+}
+
+
+
+void
+Benchmarker::record_result() const
+{
+    BenchReport& report(bench_report());
+    std::lock_guard<std::mutex> lock(report.mutex);
+    if (report.json_filename.empty() && report.baseline_filename.empty())
+        return;
+
+    // A program may run several benchmarks with the same name; number the
+    // repeats so that each can be matched with its own baseline.
+    BenchRecord r;
+    r.name    = name();
+    int count = ++report.name_counts[r.name];
+    if (count > 1)
+        r.name += Strutil::fmt::format("#{}", count);
+    r.avg        = avg();
+    r.median     = median();
+    r.stddev     = stddev();
+    r.range      = range();
+    r.trials     = trials();
+    r.samples    = m_samples;
+    r.iterations = iterations();
+    r.work       = work();
+    if (report.json_filename.size())
+        report.results.push_back(r);
+
+    auto found = report.baseline.find(r.name);
+    if (found == report.baseline.end())
+        return;
+    // Compare per unit of work, in case the work per iteration changed.
+    const BenchRecord& b(found->second);
+    double work     = double(std::max(r.work, size_t(1)));
+    double bwork    = double(std::max(b.work, size_t(1)));
+    double avg      = r.avg / work;
+    double bavg     = b.avg / bwork;
+    double sdev     = r.stddev / work;
+    double bsdev    = b.stddev / bwork;
+    double nsamples = double(std::max(r.samples, size_t(1)));
+    double bsamples = double(std::max(b.samples, size_t(1)));
+    // Standard error of the difference between the two averages
+    double err = std::sqrt(sdev * sdev / nsamples + bsdev * bsdev / bsamples);
+    ++report.compared;
+    if (bavg > 0.0 && avg > bavg * (1.0 + report.threshold)
+        && avg - bavg > report.nsigma * err) {
+        ++report.regressions;
+        if (verbose())
+            print("{}{:16}  REGRESSION: {:.1f}% slower than baseline\n",
+                  std::string(indent(), ' '), r.name,
+                  100.0 * (avg / bavg - 1.0));
+    }
+}
+
+
+
 OIIO_API
 std::ostream&
 operator<<(std::ostream& out, const Benchmarker& bench)
@@ -3,7 +3,10 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <fcntl.h>
@@ -12,12 +15,15 @@
 #include <random>
 #include <regex>
 #include <string>
+#include <unordered_map>
 
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/platform.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/ustring.h>
 
 #ifdef _WIN32
@@ -29,12 +35,25 @@
 #    include <sys/types.h>
 #    include <sys/utime.h>
 #else
+#    include <sys/mman.h>
 #    include <sys/stat.h>
 #    include <sys/types.h>
 #    include <unistd.h>
 #    include <utime.h>
 #endif
 
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#    include <linux/io_uring.h>
+#    include <sys/syscall.h>
+#    include <sys/uio.h>
+#endif
+#if defined(__linux__) && defined(__NR_io_uring_setup) \
+    && defined(__NR_io_uring_enter)
+#    define OIIO_HAS_IO_URING 1
+#else
+#    define OIIO_HAS_IO_URING 0
+#endif
+
 namespace filesystem = std::filesystem;
 using std::error_code;
 
@@ -182,6 +201,163 @@ Filesystem::searchpath_split(string_view searchpath, bool validonly)
 
 
 
+namespace {
+
+// One entry of a directory listing.
+struct DirEntry {
+    std::string path;  // as returned by get_directory_entries
+    std::string name;  // just the filename part
+    bool regular;      // a regular file (or a symlink to one)
+    bool subdir;       // a directory, and not a symlink to one
+};
+
+// A directory's entries, sorted by name.
+typedef std::vector<DirEntry> DirListing;
+typedef std::shared_ptr<const DirListing> DirListingRef;
+
+// Process-wide cache of directory listings, and when each was read, used
+// when the TTL is nonzero.
+struct DirCache {
+    typedef std::chrono::steady_clock::time_point time_point;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::pair<DirListingRef, time_point>>
+        listings;
+};
+
+DirCache&
+dir_cache()
+{
+    static DirCache cache;
+    return cache;
+}
+
+std::atomic<double>&
+dir_cache_ttl()
+{
+    static std::atomic<double> ttl(
+        Strutil::stof(Sysutil::getenv("OPENIMAGEIO_DIRCACHE_TTL")));
+    return ttl;
+}
+
+
+
+// Read the directory's entries. The file types come from the directory
+// itself where the platform provides them, so on most systems this does
+// not need to stat every file. Return nullptr if it can't be read.
+DirListingRef
+read_directory(const std::string& dirname)
+{
+    filesystem::path dirpath(dirname.size() ? u8path(dirname)
+                                            : filesystem::path("."));
+    auto listing = std::make_shared<DirListing>();
+    try {
+        error_code ec;
+        filesystem::directory_iterator s(dirpath, ec), end;
+        if (ec)
+            return nullptr;
+        for (; !ec && s != end; s.increment(ec)) {
+            error_code tec;
+            DirEntry entry;
+            entry.path    = pathstr(s->path());
+            entry.name    = pathstr(s->path().filename());
+            entry.regular = s->is_regular_file(tec);
+            entry.subdir  = s->is_directory(tec) && !s->is_symlink(tec);
+            listing->push_back(std::move(entry));
+        }
+    } catch (...) {
+        return nullptr;
+    }
+    std::sort(listing->begin(), listing->end(),
+              [](const DirEntry& a, const DirEntry& b) {
+                  return a.name < b.name;
+              });
+    return listing;
+}
+
+
+
+// Return the entries of the directory, from the cache if it's enabled and
+// has a listing that's young enough, otherwise by reading it (and caching
+// the result if enabled).
+DirListingRef
+list_directory(const std::string& dirname)
+{
+    double ttl = dir_cache_ttl().load();
+    if (ttl <= 0.0)
+        return read_directory(dirname);
+    DirCache& cache(dir_cache());
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto found = cache.listings.find(dirname);
+        if (found != cache.listings.end()
+            && std::chrono::duration<double>(now - found->second.second).count()
+                   < ttl)
+            return found->second.first;
+    }
+    DirListingRef listing = read_directory(dirname);
+    if (listing) {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.listings[dirname] = { listing, now };
+    }
+    return listing;
+}
+
+}  // namespace
+
+
+
+void
+Filesystem::set_directory_cache_ttl(double seconds)
+{
+    dir_cache_ttl() = seconds;
+    if (seconds <= 0.0)
+        clear_directory_cache();
+}
+
+
+
+double
+Filesystem::directory_cache_ttl()
+{
+    return dir_cache_ttl().load();
+}
+
+
+
+void
+Filesystem::clear_directory_cache()
+{
+    DirCache& cache(dir_cache());
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.listings.clear();
+}
+
+
+
+// Look for path in the (cached) listing of its parent directory. Return 0
+// if it's not there, 1 if it is, or 2 if it is and is a regular file, or
+// -1 if the path can't be looked up this way (and needs a real stat).
+static int
+find_listed(string_view path)
+{
+    std::string name = Filesystem::filename(path);
+    if (name.empty() || name == "." || name == "..")
+        return -1;
+    DirListingRef listing = list_directory(Filesystem::parent_path(path));
+    if (!listing)
+        return 0;
+    auto found = std::lower_bound(listing->begin(), listing->end(), name,
+                                  [](const DirEntry& e, const std::string& n) {
+                                      return e.name < n;
+                                  });
+    if (found == listing->end() || found->name != name)
+        return 0;
+    return found->regular ? 2 : 1;
+}
+
+
+
 std::string
 Filesystem::searchpath_find(const std::string& filename_utf8,
                             const std::vector<std::string>& dirs, bool testcwd,
@@ -203,7 +379,9 @@ Filesystem::searchpath_find(const std::string& filename_utf8,
         const filesystem::path d(u8path(d_utf8));
         filesystem::path f = d / filename;
         error_code ec;
-        if (filesystem::is_regular_file(f, ec)) {
+        int listed = dir_cache_ttl().load() > 0.0 ? find_listed(pathstr(f))
+                                                  : -1;
+        if (listed < 0 ? filesystem::is_regular_file(f, ec) : listed == 2) {
             return pathstr(f);
         }
 
@@ -264,6 +442,15 @@ Filesystem::find_program(string_view program)
 
 
 
+bool
+Filesystem::cached_exists(string_view path)
+{
+    int listed = dir_cache_ttl().load() > 0.0 ? find_listed(path) : -1;
+    return listed < 0 ? exists(path) : listed > 0;
+}
+
+
+
 bool
 Filesystem::get_directory_entries(const std::string& dirname,
                                   std::vector<std::string>& filenames,
@@ -271,33 +458,54 @@ Filesystem::get_directory_entries(const std::string& dirname,
                                   const std::string& filter_regex)
 {
     filenames.clear();
-    if (dirname.size() && !is_directory(dirname))
-        return false;
-    filesystem::path dirpath(dirname.size() ? u8path(dirname)
-                                            : filesystem::path("."));
     std::regex re;
     try {
         re = std::regex(filter_regex);
-        if (recursive) {
-            error_code ec;
-            for (filesystem::recursive_directory_iterator s(dirpath, ec), end;
-                 !ec && s != end; s.increment(ec)) {
-                std::string file = pathstr(s->path());
-                if (!filter_regex.size() || std::regex_search(file, re))
-                    filenames.push_back(file);
-            }
-        } else {
-            error_code ec;
-            for (filesystem::directory_iterator s(dirpath, ec), end;
-                 !ec && s != end; s.increment(ec)) {
-                std::string file = pathstr(s->path());
-                if (!filter_regex.size() || std::regex_search(file, re))
-                    filenames.push_back(file);
-            }
-        }
     } catch (...) {
         return false;
     }
+    auto keep = [&](const std::string& file) {
+        try {
+            return !filter_regex.size() || std::regex_search(file, re);
+        } catch (...) {
+            return false;
+        }
+    };
+
+    DirListingRef listing = list_directory(dirname);
+    if (!listing)
+        return false;
+    std::vector<std::string> subdirs;
+    for (const DirEntry& e : *listing) {
+        if (keep(e.path))
+            filenames.push_back(e.path);
+        if (recursive && e.subdir)
+            subdirs.push_back(e.path);
+    }
+
+    // Walk the tree a level at a time, listing all the directories of each
+    // level in parallel, since on a network file system each listing
+    // spends most of its time waiting. Each directory's entries come after
+    // its parent's, as they would from a serial walk.
+    while (subdirs.size()) {
+        std::vector<DirListingRef> listings(subdirs.size());
+        parallel_for(
+            int64_t(0), int64_t(subdirs.size()),
+            [&](int64_t i) { listings[i] = list_directory(subdirs[i]); },
+            paropt(0, paropt::SplitDir::Y, 1));
+        std::vector<std::string> next;
+        for (auto& l : listings) {
+            if (!l)
+                continue;
+            for (const DirEntry& e : *l) {
+                if (keep(e.path))
+                    filenames.push_back(e.path);
+                if (e.subdir)
+                    next.push_back(e.path);
+            }
+        }
+        subdirs.swap(next);
+    }
     return true;
 }
 
@@ -728,6 +936,29 @@ Filesystem::last_write_time(string_view path) noexcept
 
 
 
+int64_t
+Filesystem::last_write_time_ns(string_view path) noexcept
+{
+#ifdef _WIN32
+    struct __stat64 st;
+    if (_wstat64(u8path(path).c_str(), &st) != 0)
+        return 0;
+    return int64_t(st.st_mtime) * 1000000000;
+#else
+    struct stat st;
+    if (stat(u8path(path).c_str(), &st) != 0)
+        return 0;
+#    ifdef __APPLE__
+    const struct timespec& t(st.st_mtimespec);
+#    else
+    const struct timespec& t(st.st_mtim);
+#    endif
+    return int64_t(t.tv_sec) * 1000000000 + int64_t(t.tv_nsec);
+#endif
+}
+
+
+
 void
 Filesystem::last_write_time(string_view path, std::time_t time) noexcept
 {
@@ -1060,13 +1291,12 @@ Filesystem::scan_for_matching_filenames(const std::string& pattern_,
     // are badly structured and might throw an exception.
     try {
         std::regex pattern_re(pattern_re_str);
-        error_code ec;
-        for (filesystem::directory_iterator it(u8path(directory), ec), end_it;
-             !ec && it != end_it; ++it) {
-            std::string itpath = Filesystem::generic_filepath(
-                it->path().string());
-            if (filesystem::is_regular_file(itpath, ec)) {
-                const std::string f = pathstr(itpath);
+        DirListingRef listing = list_directory(directory);
+        if (!listing)
+            return false;
+        for (const DirEntry& entry : *listing) {
+            if (entry.regular) {
+                const std::string f = Filesystem::generic_filepath(entry.path);
                 std::match_results<std::string::const_iterator> frame_match;
                 if (regex_match(f, frame_match, pattern_re)) {
                     std::string thenumber(frame_match[1].first,
@@ -1377,4 +1607,697 @@ Filesystem::IOMemReader::pread(void* buf, size_t size, int64_t offset)
 }
 
 
+
+Filesystem::IOMMapReader::IOMMapReader(string_view filename)
+    : IOMemReader(nullptr, 0)
+{
+    m_filename = filename;
+    m_mode     = Closed;
+#ifdef _WIN32
+    std::wstring wpath = Strutil::utf8_to_utf16wstring(filename);
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error("could not open file");
+        return;
+    }
+    LARGE_INTEGER len;
+    if (GetFileSizeEx(file, &len) && len.QuadPart > 0) {
+        m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0,
+                                       nullptr);
+        if (m_mapping) {
+            m_map = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+            if (m_map)
+                m_mapsize = size_t(len.QuadPart);
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = Filesystem::open(filename, O_RDONLY);
+    if (fd < 0) {
+        error(std::strerror(errno));
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED,
+                         fd, 0);
+        if (p != MAP_FAILED) {
+            m_map     = p;
+            m_mapsize = size_t(st.st_size);
+        }
+    }
+    ::close(fd);  // The mapping keeps its own reference to the file
+#endif
+    if (!m_map) {
+        close();
+        error("could not memory-map file");
+        return;
+    }
+    m_buf  = cspan<unsigned char>((const unsigned char*)m_map, m_mapsize);
+    m_mode = Read;
+}
+
+
+
+Filesystem::IOMMapReader::~IOMMapReader() { close(); }
+
+
+
+void
+Filesystem::IOMMapReader::close()
+{
+#ifdef _WIN32
+    if (m_map)
+        UnmapViewOfFile(m_map);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    m_mapping = nullptr;
+#else
+    if (m_map)
+        ::munmap(m_map, m_mapsize);
+#endif
+    m_map     = nullptr;
+    m_mapsize = 0;
+    m_buf     = cspan<unsigned char>();
+    m_mode    = Closed;
+}
+
+
+
+// The pool that IORangeReader read-ahead runs on. A pread() that needs a
+// block being read ahead waits for it, so if read-ahead were queued on the
+// default pool, a caller reading from every worker of that pool at once
+// could leave nobody free to run it. Read-ahead tasks only fetch and never
+// wait, so this pool always makes progress.
+static thread_pool*
+readahead_thread_pool()
+{
+    static std::unique_ptr<thread_pool> pool(new thread_pool(4));
+    return pool.get();
+}
+
+
+
+class Filesystem::IORangeReader::Impl {
+public:
+    typedef std::shared_ptr<const std::vector<unsigned char>> BlockData;
+    struct Block {
+        BlockData data;        // null while pending
+        uint64_t lastuse = 0;  // for LRU eviction
+        bool pending     = true;
+    };
+    typedef std::pair<int64_t, int64_t> Run;  // inclusive block range
+
+    Impl(size_t filesize, FetchFunc fetch, size_t blocksize, size_t maxblocks,
+         int readahead)
+        : m_fetch(std::move(fetch))
+        , m_filesize(filesize)
+        , m_blocksize(std::max(blocksize, size_t(1)))
+        , m_maxblocks(std::max(maxblocks, size_t(1)))
+        , m_readahead(std::max(readahead, 0))
+    {
+    }
+
+    ~Impl()
+    {
+        // Don't go away while read-ahead tasks still refer to us
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&]() { return m_inflight == 0; });
+    }
+
+    int64_t nblocks() const
+    {
+        return int64_t((m_filesize + m_blocksize - 1) / m_blocksize);
+    }
+
+    // Claim (mark as pending) any of blocks [first,last] that aren't in
+    // the cache yet, appending runs of adjacent claimed blocks to `runs`.
+    // Must hold the lock.
+    void claim(int64_t first, int64_t last, std::vector<Run>& runs,
+               bool count_stats)
+    {
+        for (int64_t b = first; b <= last; ++b) {
+            auto found = m_blocks.find(b);
+            if (found != m_blocks.end()) {
+                if (count_stats && !found->second.pending)
+                    ++m_stats.block_hits;
+                continue;
+            }
+            m_blocks[b] = Block();
+            if (count_stats)
+                ++m_stats.block_misses;
+            if (runs.size() && runs.back().second == b - 1)
+                runs.back().second = b;
+            else
+                runs.emplace_back(b, b);
+        }
+    }
+
+    // Fetch a run of claimed blocks with a single request and put them in
+    // the cache (and also in `out`, indexed from block `outfirst`, if
+    // supplied). Blocks that couldn't be fully fetched are dropped again.
+    // Must NOT hold the lock.
+    void fetch_run(const Run& run, std::vector<BlockData>* out = nullptr,
+                   int64_t outfirst = 0)
+    {
+        int64_t start = run.first * int64_t(m_blocksize);
+        size_t len    = std::min(size_t(run.second - run.first + 1)
+                                     * m_blocksize,
+                                 m_filesize - size_t(start));
+        std::vector<unsigned char> buf(len);
+        size_t got = m_fetch ? m_fetch(buf.data(), len, start) : 0;
+        got        = std::min(got, len);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.requests += 1;
+        m_stats.bytes_fetched += int64_t(got);
+        for (int64_t b = run.first; b <= run.second; ++b) {
+            size_t boff = size_t(b - run.first) * m_blocksize;
+            size_t blen = std::min(m_blocksize, len - boff);
+            auto& block = m_blocks[b];
+            if (boff + blen <= got) {
+                block.data = std::make_shared<std::vector<unsigned char>>(
+                    buf.begin() + boff, buf.begin() + boff + blen);
+                block.pending = false;
+                block.lastuse = ++m_clock;
+                if (out)
+                    (*out)[b - outfirst] = block.data;
+            } else {
+                m_blocks.erase(b);
+            }
+        }
+        evict();
+        m_cv.notify_all();
+    }
+
+    // Drop least recently used blocks until we're within budget. Must
+    // hold the lock.
+    void evict()
+    {
+        while (m_blocks.size() > m_maxblocks) {
+            auto lru = m_blocks.end();
+            for (auto b = m_blocks.begin(); b != m_blocks.end(); ++b)
+                if (!b->second.pending
+                    && (lru == m_blocks.end()
+                        || b->second.lastuse < lru->second.lastuse))
+                    lru = b;
+            if (lru == m_blocks.end())
+                break;  // everything is in flight
+            m_blocks.erase(lru);
+        }
+    }
+
+    FetchFunc m_fetch;
+    size_t m_filesize;
+    size_t m_blocksize;
+    size_t m_maxblocks;
+    int m_readahead;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::unordered_map<int64_t, Block> m_blocks;
+    uint64_t m_clock    = 0;
+    int64_t m_lastblock = -2;  // last block of the previous read
+    int m_inflight      = 0;   // read-ahead tasks not yet finished
+    Stats m_stats;
+};
+
+
+
+Filesystem::IORangeReader::IORangeReader(string_view filename,
+                                         size_t filesize, FetchFunc fetch,
+                                         size_t blocksize, size_t maxblocks,
+                                         int readahead)
+    : IOProxy(filename, Read)
+    , m_impl(new Impl(filesize, std::move(fetch), blocksize, maxblocks,
+                      readahead))
+{
+}
+
+
+
+Filesystem::IORangeReader::~IORangeReader() {}
+
+
+
+size_t
+Filesystem::IORangeReader::size() const
+{
+    return m_impl->m_filesize;
+}
+
+
+
+Filesystem::IORangeReader::Stats
+Filesystem::IORangeReader::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_stats;
+}
+
+
+
+size_t
+Filesystem::IORangeReader::read(void* buf, size_t size)
+{
+    size = pread(buf, size, m_pos);
+    m_pos += size;
+    return size;
+}
+
+
+
+size_t
+Filesystem::IORangeReader::pread(void* buf, size_t size, int64_t offset)
+{
+    Impl& impl(*m_impl);
+    if (!size || offset < 0 || size_t(offset) >= impl.m_filesize)
+        return 0;
+    size          = std::min(size, impl.m_filesize - size_t(offset));
+    int64_t bs    = int64_t(impl.m_blocksize);
+    int64_t first = offset / bs;
+    int64_t last  = (offset + int64_t(size) - 1) / bs;
+
+    // Claim what we need, fetch it (outside the lock), then wait for any
+    // blocks that other threads or read-ahead tasks are still fetching.
+    // Blocks fetched by others might be evicted again before we get to
+    // them, so make one more pass for anything we still don't hold.
+    std::vector<Impl::BlockData> data(size_t(last - first + 1));
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<Impl::Run> runs, ahead;
+        {
+            std::lock_guard<std::mutex> lock(impl.m_mutex);
+            for (int64_t b = first; b <= last; ++b)
+                if (!data[b - first])
+                    impl.claim(b, b, runs, pass == 0);
+            // Sequential access? Get a head start on the blocks after this.
+            if (pass == 0 && impl.m_readahead
+                && (first == impl.m_lastblock
+                    || first == impl.m_lastblock + 1)) {
+                int64_t aend = std::min(last + impl.m_readahead,
+                                        impl.nblocks() - 1);
+                if (aend > last)
+                    impl.claim(last + 1, aend, ahead, false);
+                impl.m_inflight += int(ahead.size());
+            }
+            if (pass == 0)
+                impl.m_lastblock = last;
+        }
+        for (auto& run : ahead)
+            readahead_thread_pool()->push([&impl, run](int /*id*/) {
+                impl.fetch_run(run);
+                std::lock_guard<std::mutex> lock(impl.m_mutex);
+                --impl.m_inflight;
+                impl.m_cv.notify_all();
+            });
+        for (auto& run : runs)
+            impl.fetch_run(run, &data, first);
+
+        std::unique_lock<std::mutex> lock(impl.m_mutex);
+        impl.m_cv.wait(lock, [&]() {
+            for (int64_t b = first; b <= last; ++b) {
+                auto found = impl.m_blocks.find(b);
+                if (!data[b - first] && found != impl.m_blocks.end()
+                    && found->second.pending)
+                    return false;
+            }
+            return true;
+        });
+        bool complete = true;
+        for (int64_t b = first; b <= last; ++b) {
+            auto found = impl.m_blocks.find(b);
+            if (found != impl.m_blocks.end() && found->second.data) {
+                data[b - first]       = found->second.data;
+                found->second.lastuse = ++impl.m_clock;
+            }
+            complete &= bool(data[b - first]);
+        }
+        if (complete)
+            break;
+    }
+
+    // Copy out of the blocks we now hold references to, stopping at the
+    // first one that couldn't be fetched.
+    size_t nread = 0;
+    for (int64_t b = first; b <= last && nread < size; ++b) {
+        const auto& d = data[b - first];
+        if (!d) {
+            error(Strutil::fmt::format(
+                "Could not fetch bytes {}-{} of \"{}\"", b * bs,
+                std::min(size_t((b + 1) * bs), impl.m_filesize) - 1,
+                filename()));
+            break;
+        }
+        size_t boff = size_t(offset) + nread - size_t(b * bs);
+        size_t n    = std::min(size - nread, d->size() - boff);
+        memcpy((char*)buf + nread, d->data() + boff, n);
+        nread += n;
+    }
+    std::lock_guard<std::mutex> lock(impl.m_mutex);
+    impl.m_stats.bytes_read += int64_t(nread);
+    return nread;
+}
+
+
+
+#if OIIO_HAS_IO_URING
+
+// Minimal raw-syscall io_uring: one submission queue, one completion
+// queue, READV requests only. Any thread may submit; whichever waiting
+// thread gets to it first reaps the completions for everybody.
+class Filesystem::IOUring::Impl {
+public:
+    struct Pending {
+        Request* req;
+        iovec iov;
+        bool done = false;
+    };
+
+    Impl(unsigned int entries)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        m_fd = int(syscall(__NR_io_uring_setup, entries, &params));
+        if (m_fd < 0)
+            return;  // No io_uring (old kernel, or not permitted)
+        m_sq_entries = params.sq_entries;
+        m_cq_entries = params.cq_entries;
+        m_sq_size    = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_size    = params.cq_off.cqes
+                    + params.cq_entries * sizeof(io_uring_cqe);
+        bool single  = (params.features & IORING_FEAT_SINGLE_MMAP);
+        if (single)
+            m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+        m_sq = ::mmap(nullptr, m_sq_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        m_cq = single ? m_sq
+                      : ::mmap(nullptr, m_cq_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, m_fd,
+                               IORING_OFF_CQ_RING);
+        m_sqes = ::mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe),
+                        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        m_fd, IORING_OFF_SQES);
+        if (m_sq == MAP_FAILED || m_cq == MAP_FAILED || m_sqes == MAP_FAILED) {
+            teardown();
+            return;
+        }
+        char* sq        = (char*)m_sq;
+        char* cq        = (char*)m_cq;
+        m_sq_head       = (unsigned*)(sq + params.sq_off.head);
+        m_sq_tail       = (unsigned*)(sq + params.sq_off.tail);
+        m_sq_mask       = (unsigned*)(sq + params.sq_off.ring_mask);
+        m_sq_array      = (unsigned*)(sq + params.sq_off.array);
+        m_cq_head       = (unsigned*)(cq + params.cq_off.head);
+        m_cq_tail       = (unsigned*)(cq + params.cq_off.tail);
+        m_cq_mask       = (unsigned*)(cq + params.cq_off.ring_mask);
+        m_cqes          = (io_uring_cqe*)(cq + params.cq_off.cqes);
+        m_valid         = true;
+    }
+
+    ~Impl() { teardown(); }
+
+    void teardown()
+    {
+        if (m_sqes && m_sqes != MAP_FAILED)
+            ::munmap(m_sqes, m_sq_entries * sizeof(io_uring_sqe));
+        if (m_cq && m_cq != MAP_FAILED && m_cq != m_sq)
+            ::munmap(m_cq, m_cq_size);
+        if (m_sq && m_sq != MAP_FAILED)
+            ::munmap(m_sq, m_sq_size);
+        if (m_fd >= 0)
+            ::close(m_fd);
+        m_sq = m_cq = m_sqes = nullptr;
+        m_fd                 = -1;
+        m_valid              = false;
+    }
+
+    // Queue and submit as many of `todo` as there is room for, starting
+    // at `next`. Must hold the lock.
+    void submit(std::vector<Pending>& todo, size_t& next)
+    {
+        unsigned tail    = *m_sq_tail;
+        unsigned head    = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+        unsigned queued  = 0;
+        io_uring_sqe* sq = (io_uring_sqe*)m_sqes;
+        while (next < todo.size() && tail - head < m_sq_entries
+               && m_inflight < m_cq_entries) {
+            Pending& p         = todo[next++];
+            unsigned index     = tail & *m_sq_mask;
+            io_uring_sqe& sqe  = sq[index];
+            memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode         = IORING_OP_READV;
+            sqe.fd             = p.req->fd;
+            sqe.addr           = (unsigned long long)&p.iov;
+            sqe.len            = 1;
+            sqe.off            = (unsigned long long)p.req->offset;
+            sqe.user_data      = (unsigned long long)&p;
+            m_sq_array[index]  = index;
+            ++tail;
+            ++queued;
+            ++m_inflight;
+        }
+        if (!queued)
+            return;
+        __atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+        int r = int(syscall(__NR_io_uring_enter, m_fd, queued, 0, 0,
+                            nullptr, 0));
+        if (r < int(queued)) {
+            // The kernel didn't take them all (or failed outright). Take
+            // the rest back and do them the slow way.
+            unsigned taken = r > 0 ? unsigned(r) : 0;
+            for (size_t i = next - (queued - taken); i < next; ++i) {
+                todo[i].req->result = -2;  // retry synchronously
+                todo[i].done        = true;
+            }
+            __atomic_store_n(m_sq_tail, tail - (queued - taken),
+                             __ATOMIC_RELEASE);
+            m_inflight -= queued - taken;
+        }
+    }
+
+    // Reap whatever completions are ready. Must hold the lock.
+    void reap()
+    {
+        unsigned head = *m_cq_head;
+        unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            io_uring_cqe& cqe = m_cqes[head & *m_cq_mask];
+            Pending* p        = (Pending*)cqe.user_data;
+            // On error, leave it to be retried synchronously
+            p->req->result    = cqe.res < 0 ? -2 : int64_t(cqe.res);
+            p->done           = true;
+            --m_inflight;
+        }
+        __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    void read(span<Request> requests)
+    {
+        std::vector<Pending> todo(requests.size());
+        for (size_t i = 0; i < todo.size(); ++i) {
+            todo[i].req         = &requests[i];
+            todo[i].iov.iov_base = requests[i].buf;
+            todo[i].iov.iov_len  = requests[i].size;
+        }
+        auto alldone = [&]() {
+            for (auto& p : todo)
+                if (!p.done)
+                    return false;
+            return true;
+        };
+        size_t next = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            submit(todo, next);
+            // Only reap if nobody is waiting in the kernel, or we might
+            // take the completion they are waiting for.
+            if (!m_reaping)
+                reap();
+            if (next == todo.size() && alldone())
+                break;
+            if (m_reaping) {
+                // Somebody else is waiting in the kernel; they'll reap
+                // our completions too and wake us.
+                m_cv.wait(lock);
+                continue;
+            }
+            if (!m_inflight)
+                continue;  // room to submit more, nothing to wait for
+            m_reaping = true;
+            lock.unlock();
+            syscall(__NR_io_uring_enter, m_fd, 0, 1, IORING_ENTER_GETEVENTS,
+                    nullptr, 0);
+            lock.lock();
+            m_reaping = false;
+            reap();
+            m_cv.notify_all();
+        }
+    }
+
+    bool m_valid = false;
+
+private:
+    int m_fd = -1;
+    void* m_sq   = nullptr;
+    void* m_cq   = nullptr;
+    void* m_sqes = nullptr;
+    size_t m_sq_size = 0, m_cq_size = 0;
+    unsigned m_sq_entries = 0, m_cq_entries = 0;
+    unsigned *m_sq_head = nullptr, *m_sq_tail = nullptr;
+    unsigned *m_sq_mask = nullptr, *m_sq_array = nullptr;
+    unsigned *m_cq_head = nullptr, *m_cq_tail = nullptr;
+    unsigned* m_cq_mask  = nullptr;
+    io_uring_cqe* m_cqes = nullptr;
+    unsigned m_inflight  = 0;
+    bool m_reaping       = false;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
+
+#else
+
+class Filesystem::IOUring::Impl {
+public:
+    Impl(unsigned int) {}
+    void read(span<Request>) {}
+    bool m_valid = false;
+};
+
+#endif
+
+
+
+Filesystem::IOUring::IOUring(unsigned int entries)
+    : m_impl(new Impl(std::max(entries, 1u)))
+{
+}
+
+
+
+Filesystem::IOUring::~IOUring() {}
+
+
+
+bool
+Filesystem::IOUring::valid() const
+{
+    return m_impl->m_valid;
+}
+
+
+
+// Finish any short reads, and anything io_uring couldn't take (marked
+// with result -2), with plain synchronous reads.
+static void
+finish_reads(span<Filesystem::IOUring::Request> requests)
+{
+    for (auto& r : requests) {
+        if (r.result == -1 || r.result == int64_t(r.size))
+            continue;
+        size_t done = r.result > 0 ? size_t(r.result) : 0;
+#ifdef _WIN32
+        r.result = done ? int64_t(done) : -1;
+#else
+        ssize_t n = 0;
+        while (done < r.size) {
+            n = ::pread(r.fd, (char*)r.buf + done, r.size - done,
+                        off_t(r.offset + done));
+            if (n <= 0)
+                break;
+            done += size_t(n);
+        }
+        r.result = (done || n >= 0) ? int64_t(done) : -1;
+#endif
+    }
+}
+
+
+
+void
+Filesystem::IOUring::read(span<Request> requests)
+{
+    for (auto& r : requests)
+        r.result = -2;
+    if (valid())
+        m_impl->read(requests);
+    finish_reads(requests);
+}
+
+
+
+Filesystem::IOUringReader::IOUringReader(string_view filename,
+                                         std::shared_ptr<IOUring> ring)
+    : IOProxy(filename, Closed)
+    , m_ring(std::move(ring))
+{
+#ifdef _WIN32
+    error("IOUringReader is not supported on Windows");
+#else
+    m_fd = Filesystem::open(filename, O_RDONLY);
+    if (m_fd < 0) {
+        error(std::strerror(errno));
+        return;
+    }
+    struct stat st;
+    if (fstat(m_fd, &st) == 0)
+        m_size = size_t(st.st_size);
+    m_mode = Read;
+#endif
+}
+
+
+
+Filesystem::IOUringReader::~IOUringReader() { close(); }
+
+
+
+void
+Filesystem::IOUringReader::close()
+{
+#ifndef _WIN32
+    if (m_fd >= 0)
+        ::close(m_fd);
+#endif
+    m_fd   = -1;
+    m_mode = Closed;
+}
+
+
+
+size_t
+Filesystem::IOUringReader::read(void* buf, size_t size)
+{
+    size = pread(buf, size, m_pos);
+    m_pos += size;
+    return size;
+}
+
+
+
+size_t
+Filesystem::IOUringReader::pread(void* buf, size_t size, int64_t offset)
+{
+    if (m_fd < 0 || !size || offset < 0 || size_t(offset) >= m_size)
+        return 0;
+    IOUring::Request req;
+    req.fd     = m_fd;
+    req.buf    = buf;
+    req.size   = std::min(size, m_size - size_t(offset));
+    req.offset = offset;
+    req.result = -2;
+    if (m_ring)
+        m_ring->read(span<IOUring::Request>(&req, 1));
+    else
+        finish_reads(span<IOUring::Request>(&req, 1));
+    if (req.result < 0) {
+        error(Strutil::fmt::format("Read error at offset {} of \"{}\"",
+                                   offset, filename()));
+        return 0;
+    }
+    return size_t(req.result);
+}
+
+
+
 OIIO_NAMESPACE_END
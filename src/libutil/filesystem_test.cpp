@@ -2,16 +2,21 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/platform.h>
 #include <OpenImageIO/unittest.h>
 
 #ifndef _WIN32
+#    include <fcntl.h>
 #    include <sys/stat.h>
+#    include <unistd.h>
 #endif
 
 using namespace OIIO;
@@ -566,6 +571,48 @@ test_scan_sequences()
 
 
 
+void
+test_directory_listing()
+{
+    std::cout << "Testing directory listing and the directory cache:\n";
+    Filesystem::create_directory("dirtest");
+    Filesystem::create_directory("dirtest/a");
+    Filesystem::create_directory("dirtest/a/b");
+    create_test_file("dirtest/x.txt");
+    create_test_file("dirtest/a/y.txt");
+    create_test_file("dirtest/a/b/z.txt");
+    create_test_file("dirtest/a/b/z.dat");
+
+    std::vector<std::string> files;
+    OIIO_CHECK_ASSERT(
+        Filesystem::get_directory_entries("dirtest", files, true, "\\.txt$"));
+    std::sort(files.begin(), files.end());
+    OIIO_CHECK_EQUAL(Strutil::join(files, " "),
+                     "dirtest/a/b/z.txt dirtest/a/y.txt dirtest/x.txt");
+    OIIO_CHECK_ASSERT(!Filesystem::get_directory_entries("nodir", files));
+
+    // With the cache on, a file created after its directory was listed
+    // isn't seen until the listing expires or the cache is cleared.
+    Filesystem::set_directory_cache_ttl(3600.0);
+    OIIO_CHECK_ASSERT(Filesystem::cached_exists("dirtest/x.txt"));
+    OIIO_CHECK_ASSERT(!Filesystem::cached_exists("dirtest/new.txt"));
+    create_test_file("dirtest/new.txt");
+    OIIO_CHECK_ASSERT(!Filesystem::cached_exists("dirtest/new.txt"));
+    Filesystem::get_directory_entries("dirtest", files);
+    OIIO_CHECK_EQUAL(files.size(), 2);
+    Filesystem::clear_directory_cache();
+    OIIO_CHECK_ASSERT(Filesystem::cached_exists("dirtest/new.txt"));
+    Filesystem::set_directory_cache_ttl(0.0);
+    OIIO_CHECK_ASSERT(Filesystem::cached_exists("dirtest/a/b"));
+
+    for (auto f : { "dirtest/a/b/z.txt", "dirtest/a/b/z.dat", "dirtest/a/b",
+                    "dirtest/a/y.txt", "dirtest/a", "dirtest/x.txt",
+                    "dirtest/new.txt", "dirtest" })
+        Filesystem::remove(f);
+}
+
+
+
 void
 test_mem_proxies()
 {
@@ -594,6 +641,132 @@ test_mem_proxies()
 
 
 
+void
+test_range_proxy()
+{
+    std::cout << "Testing range request proxy:\n";
+    std::vector<unsigned char> remote(1000);
+    for (size_t i = 0; i < remote.size(); ++i)
+        remote[i] = (unsigned char)(i * 7 + 3);
+    auto fetch = [&](void* buf, size_t size, int64_t offset) -> size_t {
+        size = std::min(size, remote.size() - size_t(offset));
+        memcpy(buf, remote.data() + offset, size);
+        return size;
+    };
+
+    // No read-ahead, so the statistics are deterministic
+    Filesystem::IORangeReader in("remote.bin", remote.size(), fetch,
+                                 /*blocksize=*/100, /*maxblocks=*/4,
+                                 /*readahead=*/0);
+    OIIO_CHECK_EQUAL(in.size(), remote.size());
+    unsigned char b[350];
+    // Spans blocks 1-4, which should be fetched with one request
+    OIIO_CHECK_EQUAL(in.pread(b, 320, 150), size_t(320));
+    OIIO_CHECK_ASSERT(!memcmp(b, remote.data() + 150, 320));
+    auto stats = in.stats();
+    OIIO_CHECK_EQUAL(stats.requests, 1);
+    OIIO_CHECK_EQUAL(stats.bytes_fetched, 400);
+    OIIO_CHECK_EQUAL(stats.bytes_read, 320);
+    // Entirely within cached blocks: no new requests
+    OIIO_CHECK_EQUAL(in.pread(b, 100, 200), size_t(100));
+    OIIO_CHECK_ASSERT(!memcmp(b, remote.data() + 200, 100));
+    OIIO_CHECK_EQUAL(in.stats().requests, 1);
+    OIIO_CHECK_EQUAL(in.stats().block_hits, 1);
+    // Read past the end is truncated; the last block is short
+    in.seek(950);
+    OIIO_CHECK_EQUAL(in.read(b, 100), size_t(50));
+    OIIO_CHECK_ASSERT(!memcmp(b, remote.data() + 950, 50));
+    OIIO_CHECK_EQUAL(in.tell(), 1000);
+    OIIO_CHECK_EQUAL(in.stats().bytes_fetched, 500);
+
+    // With read-ahead, read the whole thing sequentially in small pieces
+    Filesystem::IORangeReader seq("remote.bin", remote.size(), fetch, 64, 8,
+                                  3);
+    std::vector<unsigned char> all;
+    size_t len = 0;
+    while ((len = seq.read(b, 37)))
+        all.insert(all.end(), b, b + len);
+    OIIO_CHECK_ASSERT(all == remote);
+    OIIO_CHECK_EQUAL(seq.stats().bytes_read, 1000);
+
+    // Sequential readers on every default pool thread at once, waited on
+    // without helping out, so that read-ahead queued on that pool could
+    // never run.
+    thread_pool* pool = default_thread_pool();
+    int ntasks        = std::max(pool->size(), 1);
+    std::vector<std::future<bool>> done;
+    for (int t = 0; t < ntasks; ++t) {
+        done.push_back(pool->push([&](int /*id*/) {
+            Filesystem::IORangeReader r("remote.bin", remote.size(), fetch,
+                                        16, 8, 4);
+            std::vector<unsigned char> got;
+            unsigned char piece[10];
+            size_t n = 0;
+            while ((n = r.read(piece, sizeof(piece))))
+                got.insert(got.end(), piece, piece + n);
+            return got == remote;
+        }));
+    }
+    for (auto& d : done)
+        OIIO_CHECK_ASSERT(d.get());
+}
+
+
+#ifndef _WIN32
+void
+test_uring_proxy()
+{
+    std::cout << "Testing io_uring proxy:\n";
+    std::string contents;
+    for (int i = 0; i < 20000; ++i)
+        contents += char('a' + i % 23);
+    Filesystem::write_text_file("oiio-uring.txt", contents);
+
+    auto ring = std::make_shared<Filesystem::IOUring>(8);
+    std::cout << "  io_uring " << (ring->valid() ? "is" : "is not")
+              << " available\n";
+    for (auto r : { ring, std::shared_ptr<Filesystem::IOUring>() }) {
+        Filesystem::IOUringReader in("oiio-uring.txt", r);
+        OIIO_CHECK_ASSERT(in.opened());
+        OIIO_CHECK_EQUAL(in.size(), contents.size());
+        // Many concurrent reads, more than the ring has room for
+        std::vector<std::string> got(40);
+        parallel_for(0, 40, [&](int64_t i) {
+            std::string& g(got[i]);
+            g.resize(777);
+            size_t n = in.pread(&g[0], g.size(), i * 500);
+            g.resize(n);
+        });
+        for (int i = 0; i < 40; ++i)
+            OIIO_CHECK_EQUAL(got[i], contents.substr(i * 500, 777));
+        // Sequential read past the end is truncated
+        char buf[100];
+        in.seek(contents.size() - 10);
+        OIIO_CHECK_EQUAL(in.read(buf, 100), size_t(10));
+    }
+
+    // Batched requests on one ring
+    Filesystem::IOUringReader in("oiio-uring.txt", ring);
+    std::vector<std::string> bufs(20, std::string(1000, ' '));
+    std::vector<Filesystem::IOUring::Request> reqs(20);
+    int fd = Filesystem::open("oiio-uring.txt", O_RDONLY);
+    for (int i = 0; i < 20; ++i) {
+        reqs[i].fd     = fd;
+        reqs[i].buf    = &bufs[i][0];
+        reqs[i].size   = 1000;
+        reqs[i].offset = (19 - i) * 1000;
+    }
+    ring->read(reqs);
+    for (int i = 0; i < 20; ++i) {
+        OIIO_CHECK_EQUAL(reqs[i].result, 1000);
+        OIIO_CHECK_EQUAL(bufs[i], contents.substr((19 - i) * 1000, 1000));
+    }
+    ::close(fd);
+    Filesystem::remove("oiio-uring.txt");
+}
+#endif
+
+
 void
 test_last_write_time()
 {
@@ -615,7 +788,12 @@ main(int /*argc*/, char* /*argv*/[])
     test_file_status();
     test_frame_sequences();
     test_scan_sequences();
+    test_directory_listing();
     test_mem_proxies();
+    test_range_proxy();
+#ifndef _WIN32
+    test_uring_proxy();
+#endif
     test_last_write_time();
 
     return unit_test_failures;
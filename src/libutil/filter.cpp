@@ -992,6 +992,40 @@ Filter2D::create_shared(string_view filtername, float width, float height)
 
 
 
+Filter2D::Table
+Filter2D::make_table(int resolution) const
+{
+    // An odd number of samples puts one right at the center, where most
+    // filters peak. The end samples are taken just inside the support, so
+    // that filters that drop to zero only past its edge (like gaussian)
+    // interpolate well right up to it; the values exactly at the edges are
+    // kept separately.
+    int n = std::max(resolution, 3) | 1;
+    Table table;
+    auto fill = [&](Table::Axis& axis, float size, bool vertical) {
+        auto f = [&](float x) { return vertical ? yfilt(x) : xfilt(x); };
+
+        axis.radius  = 0.5f * size;
+        axis.scale   = size > 0.0f ? float(n - 1) / size : 0.0f;
+        axis.edge[0] = f(-axis.radius);
+        axis.edge[1] = f(axis.radius);
+        axis.weights.resize(n);
+        for (int i = 0; i < n; ++i) {
+            float x = size * float(i) / float(n - 1) - axis.radius;
+            if (i == 0 || i == n - 1)
+                x = std::nextafter(i ? axis.radius : -axis.radius, 0.0f);
+            axis.weights[i] = f(x);
+        }
+    };
+    fill(table.m_x, width(), false);
+    fill(table.m_y, height(), true);
+    if (!separable())
+        table.m_filter = this;
+    return table;
+}
+
+
+
 // Filter2D::create is the static method that, given a filter name,
 // width, and height, returns an allocated and instantiated filter of
 // the correct implementation.  If the name is not recognized, return
@@ -188,6 +188,36 @@ graph_2d()
 
 
 
+// Check that a filter table matches the filter it was made from, inside
+// its support, exactly at its edges, and outside.
+void
+test_table()
+{
+    print("\nTesting filter tables\n");
+    for (int i = 0, e = Filter2D::num_filters(); i < e; ++i) {
+        FilterDesc filtdesc;
+        Filter2D::get_filterdesc(i, &filtdesc);
+        auto filter = Filter2D::create_shared(filtdesc.name, filtdesc.width,
+                                              2.0f * filtdesc.width);
+        auto table  = filter->make_table();
+        OIIO_CHECK_EQUAL(table.width(), filter->width());
+        OIIO_CHECK_EQUAL(table.height(), filter->height());
+        OIIO_CHECK_EQUAL(table.separable(), filter->separable());
+        float w = filter->width(), h = filter->height();
+        for (int j = -1200; j <= 1200; ++j) {
+            float x = j * w / 2000.0f, y = j * h / 2000.0f;
+            OIIO_CHECK_EQUAL_THRESH(table.xfilt(x), filter->xfilt(x), 1.0e-5f);
+            OIIO_CHECK_EQUAL_THRESH(table.yfilt(y), filter->yfilt(y), 1.0e-5f);
+            OIIO_CHECK_EQUAL_THRESH(table(x, 0.5f * y), (*filter)(x, 0.5f * y),
+                                    1.0e-5f);
+        }
+        OIIO_CHECK_EQUAL(table.xfilt(0.5f * w), filter->xfilt(0.5f * w));
+        OIIO_CHECK_EQUAL(table.yfilt(-0.5f * h), filter->yfilt(-0.5f * h));
+    }
+}
+
+
+
 void
 bench_1d()
 {
@@ -220,6 +250,9 @@ bench_2d()
                                               filtdesc.width);
         auto f      = filter.get();
         bench(filtdesc.name, [=]() { DoNotOptimize((*f)(0.25f, 0.25f)); });
+        auto table = filter->make_table();
+        bench(Strutil::fmt::format("{} table", filtdesc.name),
+              [&]() { DoNotOptimize(table(0.25f, 0.25f)); });
     }
 }
 
@@ -240,6 +273,7 @@ main(int argc, char* argv[])
 
     test_1d();
     test_2d();
+    test_table();
     if (graph) {
         test_1d();
         test_2d();
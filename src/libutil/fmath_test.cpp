@@ -28,6 +28,8 @@ using namespace OIIO;
 static int iterations = 1000000;
 static int ntrials    = 5;
 static bool verbose   = false;
+static std::string json_filename;
+static std::string baseline_filename;
 
 
 
@@ -45,9 +47,20 @@ getargs(int argc, char* argv[])
       .help(Strutil::fmt::format("Number of iterations (default: {})", iterations));
     ap.arg("--trials %d", &ntrials)
       .help("Number of trials");
+    ap.arg("--json %s:FILENAME", &json_filename)
+      .help("Save the benchmark results as JSON");
+    ap.arg("--compare %s:FILENAME", &baseline_filename)
+      .help("Compare benchmarks to a JSON baseline, fail if any regressed");
     // clang-format on
 
     ap.parse(argc, (const char**)argv);
+    if (json_filename.size())
+        Benchmarker::json_output(json_filename);
+    if (baseline_filename.size()
+        && !Benchmarker::compare_baseline(baseline_filename)) {
+        print(stderr, "Could not read baseline \"{}\"\n", baseline_filename);
+        exit(EXIT_FAILURE);
+    }
 }
 
 
@@ -548,6 +561,36 @@ test_half_convert_accuracy()
 
 
 
+void
+test_half_bulk_convert()
+{
+    // An odd count exercises every SIMD width plus the scalar tail, and
+    // values that aren't representable exercise the rounding.
+    const size_t n = 1001;
+    std::vector<float> F(n);
+    for (size_t i = 0; i < n; ++i)
+        F[i] = float(i) * 0.0137f - 6.5f;
+    std::vector<half> H(n + 1, half(-1.0f));
+    convert_float_to_half(F, span<half>(H.data(), n));
+    std::vector<float> F2(n);
+    convert_half_to_float(cspan<half>(H.data(), n), F2);
+    int nwrong = 0;
+    for (size_t i = 0; i < n; ++i) {
+        half h = half(F[i]);  // scalar conversion from Imath
+        if (bitcast<uint16_t, half>(h) != bitcast<uint16_t, half>(H[i])
+            || float(h) != F2[i])
+            ++nwrong;
+    }
+    OIIO_CHECK_EQUAL(nwrong, 0);
+    // Only min(src.size(), dst.size()) values are converted
+    OIIO_CHECK_EQUAL(H[n], -1.0f);
+    F2[3] = 42.0f;
+    convert_half_to_float(H, span<float>(F2.data(), 3));
+    OIIO_CHECK_EQUAL(F2[3], 42.0f);
+}
+
+
+
 static void
 test_bitcast()
 {
@@ -746,6 +789,7 @@ main(int argc, char* argv[])
     test_convert_type<float, unsigned int>();
 
     test_half_convert_accuracy();
+    test_half_bulk_convert();
 
     benchmark_convert_type<unsigned char, float>();
     benchmark_convert_type<float, unsigned char>();
@@ -775,5 +819,5 @@ main(int argc, char* argv[])
 
     test_vecparam();
 
-    return unit_test_failures != 0;
+    return unit_test_failures != 0 || Benchmarker::regressions() != 0;
 }
@@ -3,6 +3,7 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
 #include <cstdio>
 #include <functional>
 #include <iostream>
@@ -11,6 +12,7 @@
 
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/hash.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/timer.h>
@@ -358,5 +360,34 @@ main(int argc, char* argv[])
         ++stringno;
     }
 
+    print("\nTesting incremental XXH64\n");
+    {
+        const char* bytes = reinterpret_cast<const char*>(data.data());
+        for (size_t len : { 0, 1, 31, 32, 33, 100, 1000, 4099 }) {
+            xxhash::XXH64Hasher h;
+            for (size_t pos = 0, step = 1; pos < len; pos += step, step += 7)
+                h.append(bytes + pos, std::min(step, len - pos));
+            OIIO_CHECK_EQUAL(h.digest(), xxhash::XXH64(bytes, len));
+        }
+    }
+
+    print("\nTesting file_hash\n");
+    {
+        std::string filename = "hash_test_file.bin";
+        const char* bytes    = reinterpret_cast<const char*>(data.data());
+        std::vector<char> contents(bytes, bytes + 10000);
+        Filesystem::write_binary_file(filename, contents);
+        unsigned long long h1 = 0, h2 = 0, h3 = 0;
+        OIIO_CHECK_ASSERT(xxhash::file_hash(filename, h1, 4096));
+        OIIO_CHECK_ASSERT(xxhash::file_hash(filename, h2, 4096));
+        OIIO_CHECK_EQUAL(h1, h2);
+        contents[9000] ^= 1;
+        Filesystem::write_binary_file(filename, contents);
+        OIIO_CHECK_ASSERT(xxhash::file_hash(filename, h3, 4096));
+        OIIO_CHECK_NE(h1, h3);
+        Filesystem::remove(filename);
+        OIIO_CHECK_ASSERT(!xxhash::file_hash(filename, h3, 4096));
+    }
+
     return unit_test_failures;
 }
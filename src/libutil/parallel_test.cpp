@@ -140,6 +140,139 @@ test_thread_pool_recursion()
 
 
 
+void
+test_nested_task_sets()
+{
+    std::cout << "\nTesting task_sets waited on by pool threads" << std::endl;
+    // A pool of our own, so the default pool's size is left alone
+    thread_pool pool(2);
+    // More outer tasks than threads, each of which pushes its own subtasks
+    // and waits for them. Every pool thread ends up waiting, so this only
+    // finishes because the waiting threads run queued subtasks themselves.
+    atomic_int count(0);
+    const int nouter = 16, ninner = 8;
+    task_set ts(&pool);
+    for (int i = 0; i < nouter; ++i)
+        ts.push(pool.push([&](int /*id*/) {
+            task_set inner(&pool);
+            for (int j = 0; j < ninner; ++j)
+                inner.push(pool.push([&](int /*id*/) { count += 1; }));
+            inner.wait();
+        }));
+    ts.wait();
+    OIIO_CHECK_EQUAL(count, nouter * ninner);
+}
+
+
+
+void
+test_nested_parallel_for()
+{
+    std::cout << "\nTesting recursive nested parallel_for" << std::endl;
+    thread_pool* pool(default_thread_pool());
+    pool->resize(3);
+    // Three levels of parallel_for, all allowed to use the pool. Every
+    // element must be visited exactly once.
+    const int n = 12;
+    std::vector<atomic_int> visits(n * n * n);
+    paropt opt = paropt().recursive(true).minitems(1);
+    parallel_for(
+        0, n,
+        [&](int i) {
+            parallel_for(
+                0, n,
+                [&](int j) {
+                    parallel_for(
+                        0, n, [&](int k) { visits[(i * n + j) * n + k] += 1; },
+                        opt);
+                },
+                opt);
+        },
+        opt);
+    bool all_one = true;
+    for (auto& v : visits)
+        all_one &= (v == 1);
+    OIIO_CHECK_ASSERT(all_one);
+}
+
+
+
+void
+test_thread_budget()
+{
+    std::cout << "\nTesting the thread budget" << std::endl;
+    thread_pool* pool(default_thread_pool());
+    pool->resize(7);
+    thread_budget(2);
+    // With a budget of 2 helpers, no more than 3 threads (counting the
+    // caller) may ever be inside the loop at once.
+    atomic_int inside(0), peak(0), count(0);
+    parallel_for_chunked(0, 1000, 10, [&](int64_t b, int64_t e) {
+        int n = ++inside;
+        for (int p = peak; n > p && !peak.compare_exchange_weak(p, n);)
+            ;
+        count += int(e - b);
+        Sysutil::usleep(100);
+        --inside;
+    });
+    OIIO_CHECK_EQUAL(count, 1000);
+    OIIO_CHECK_LE(peak, 3);
+    OIIO_CHECK_EQUAL(thread_budget_active(), 0);
+    {
+        thread_budget_claim claim(5);
+        OIIO_CHECK_EQUAL(claim.granted(), 2);
+        OIIO_CHECK_EQUAL(thread_budget_available(), 0);
+    }
+    OIIO_CHECK_EQUAL(thread_budget_available(), 2);
+    // Every tile of a 2D loop is still visited exactly once
+    std::vector<atomic_int> visits(37 * 23);
+    parallel_for_2D(0, 37, 0, 23,
+                    [&](int64_t x, int64_t y) { visits[y * 37 + x] += 1; });
+    bool all_one = true;
+    for (auto& v : visits)
+        all_one &= (v == 1);
+    OIIO_CHECK_ASSERT(all_one);
+    thread_budget(0);
+    // Uncapped, a claim is granted in full and never counted
+    {
+        thread_budget_claim claim(5);
+        OIIO_CHECK_EQUAL(claim.granted(), 5);
+        OIIO_CHECK_EQUAL(thread_budget_active(), 0);
+    }
+    OIIO_CHECK_EQUAL(thread_budget_active(), 0);
+}
+
+
+
+void
+test_parallel_executor()
+{
+    std::cout << "\nTesting a lent parallel executor" << std::endl;
+    atomic_int ncalls(0);
+    set_parallel_executor(
+        [&](int64_t b, int64_t e, int64_t chunksize,
+            function_view<void(int64_t, int64_t)> task) {
+            ++ncalls;
+            for (; b < e; b += chunksize)
+                task(b, std::min(e, b + chunksize));
+        },
+        4);
+    OIIO_CHECK_ASSERT(has_parallel_executor());
+    atomic_int count(0);
+    parallel_for(0, 5000, [&](int) { count += 1; });
+    OIIO_CHECK_EQUAL(count, 5000);
+    OIIO_CHECK_EQUAL(ncalls, 1);
+    // Loops that ask for OIIO's own pool don't use the executor
+    parallel_for(0, 5000, [&](int) { count += 1; },
+                 paropt(paropt::ParStrategy::OIIOpool));
+    OIIO_CHECK_EQUAL(count, 10000);
+    OIIO_CHECK_EQUAL(ncalls, 1);
+    set_parallel_executor(nullptr, 0);
+    OIIO_CHECK_ASSERT(!has_parallel_executor());
+}
+
+
+
 void
 test_empty_thread_pool()
 {
@@ -194,6 +327,10 @@ main(int argc, char** argv)
     test_parallel_for_2D();
     time_parallel_for();
     test_thread_pool_recursion();
+    test_nested_task_sets();
+    test_nested_parallel_for();
+    test_thread_budget();
+    test_parallel_executor();
     test_empty_thread_pool();
     test_thread_pool_shutdown();
 
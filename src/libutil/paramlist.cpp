@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <memory>
+#include <unordered_map>
 
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/half.h>
@@ -133,10 +135,11 @@ parse_elements(string_view value, ParamValue& p)
     // Erase any leading whitespace
     value.remove_prefix(value.find_first_not_of(" \t"));
     for (int i = 0; i < num_items; ++i) {
-        // Make a temporary copy so we for sure have a 0-terminated string.
-        std::string temp = value;
-        // Grab the first value from it
-        data[i] = from_string<T>(temp);
+        // Convert just this value's token. Handing the converter the whole
+        // remainder would cost time proportional to the rest of the list
+        // for every element.
+        string_view token = value.substr(0, value.find_first_of(" ,\t"));
+        data[i]           = from_string<T>(token);
         // Skip the value (eat until we find a delimiter -- space, comma, tab)
         value.remove_prefix(value.find_first_of(" ,\t"));
         // Skip the delimiter
@@ -383,23 +386,131 @@ ParamValue::clear_value() noexcept
 
 
 
-ParamValueList::const_iterator
-ParamValueList::find(ustring name, TypeDesc type, bool casesensitive) const
+// Lists shorter than this are searched linearly; building and probing a
+// hash table doesn't pay for itself until there are more entries.
+static constexpr size_t name_index_threshold = 16;
+
+
+
+// Map from entry name to the position of the first entry with that name.
+// Names are hashed and compared case-insensitively, so one index serves
+// both kinds of lookup: the first case-insensitive match is where a
+// case-sensitive search has to start, too. The keys point to the
+// characters of the entries' ustring names, which live forever.
+struct ParamValueList::NameIndex {
+    struct Hash {
+        size_t operator()(string_view s) const noexcept
+        {
+            uint64_t h = 14695981039346656037ULL;  // FNV-1a
+            for (char c : s) {
+                if (c >= 'A' && c <= 'Z')
+                    c += 'a' - 'A';
+                h = (h ^ (unsigned char)c) * 1099511628211ULL;
+            }
+            return size_t(h);
+        }
+    };
+    struct Equal {
+        bool operator()(string_view a, string_view b) const noexcept
+        {
+            return Strutil::iequals(a, b);
+        }
+    };
+    std::unordered_map<string_view, size_t, Hash, Equal> first;
+    size_t size = 0;  // Number of list entries accounted for
+
+    void add(ustring name)
+    {
+        first.emplace(string_view(name), size);
+        ++size;
+    }
+};
+
+
+
+void
+ParamValueList::invalidate_index() noexcept
 {
-    if (casesensitive) {
-        for (const_iterator i = cbegin(), e = cend(); i != e; ++i) {
-            if (i->name() == name
-                && (type == TypeDesc::UNKNOWN || type == i->type()))
+    delete m_index.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+
+
+void
+ParamValueList::index_appended()
+{
+    // Appending is common enough (and merging lists appends repeatedly
+    // between lookups) that it's worth extending the index in place
+    // rather than discarding it.
+    NameIndex* index = m_index.load(std::memory_order_relaxed);
+    if (index && index->size + 1 == size())
+        index->add(back().name());
+    else
+        invalidate_index();
+}
+
+
+
+const ParamValueList::NameIndex*
+ParamValueList::name_index() const
+{
+    if (size() < name_index_threshold)
+        return nullptr;
+    NameIndex* index = m_index.load(std::memory_order_acquire);
+    if (!index) {
+        // Const lookups in a shared list (such as an ImageCache file's
+        // spec) may race to build the index; the losers discard theirs.
+        std::unique_ptr<NameIndex> fresh(new NameIndex);
+        fresh->first.reserve(size());
+        for (const auto& pv : *this)
+            fresh->add(pv.name());
+        if (m_index.compare_exchange_strong(index, fresh.get(),
+                                            std::memory_order_acq_rel))
+            index = fresh.release();
+    }
+    // An index that doesn't match the list was outdated by modification
+    // through the underlying std::vector; don't trust it.
+    return index->size == size() ? index : nullptr;
+}
+
+
+
+template<typename Name>
+size_t
+ParamValueList::find_pos(Name name, TypeDesc type, bool casesensitive) const
+{
+    const size_t n       = size();
+    const ParamValue* pv = data();
+
+    auto scan = [&](size_t i) {
+        for (; i < n; ++i) {
+            if ((casesensitive ? pv[i].name() == name
+                               : Strutil::iequals(pv[i].name(), name))
+                && (type == TypeDesc::UNKNOWN || type == pv[i].type()))
                 return i;
         }
-    } else {
-        for (const_iterator i = cbegin(), e = cend(); i != e; ++i) {
-            if (Strutil::iequals(i->name(), name)
-                && (type == TypeDesc::UNKNOWN || type == i->type()))
+        return n;
+    };
+    if (const NameIndex* index = name_index()) {
+        auto f = index->first.find(string_view(name));
+        if (f != index->first.end()) {
+            size_t i = scan(f->second);
+            if (i < n)
                 return i;
         }
+        // The index is only a hint. Entries changed through the underlying
+        // std::vector (in a way that kept the size the same) are invisible
+        // to it, so a miss must still be confirmed by a full search.
     }
-    return cend();
+    return scan(0);
+}
+
+
+
+ParamValueList::const_iterator
+ParamValueList::find(ustring name, TypeDesc type, bool casesensitive) const
+{
+    return cbegin() + find_pos(name, type, casesensitive);
 }
 
 
@@ -407,16 +518,7 @@ ParamValueList::find(ustring name, TypeDesc type, bool casesensitive) const
 ParamValueList::const_iterator
 ParamValueList::find(string_view name, TypeDesc type, bool casesensitive) const
 {
-    if (casesensitive) {
-        return find(ustring(name), type, casesensitive);
-    } else {
-        for (const_iterator i = cbegin(), e = cend(); i != e; ++i) {
-            if (Strutil::iequals(i->name(), name)
-                && (type == TypeDesc::UNKNOWN || type == i->type()))
-                return i;
-        }
-    }
-    return cend();
+    return cbegin() + find_pos(name, type, casesensitive);
 }
 
 
@@ -424,20 +526,7 @@ ParamValueList::find(string_view name, TypeDesc type, bool casesensitive) const
 ParamValueList::iterator
 ParamValueList::find(ustring name, TypeDesc type, bool casesensitive)
 {
-    if (casesensitive) {
-        for (iterator i = begin(), e = end(); i != e; ++i) {
-            if (i->name() == name
-                && (type == TypeDesc::UNKNOWN || type == i->type()))
-                return i;
-        }
-    } else {
-        for (iterator i = begin(), e = end(); i != e; ++i) {
-            if (Strutil::iequals(i->name(), name)
-                && (type == TypeDesc::UNKNOWN || type == i->type()))
-                return i;
-        }
-    }
-    return end();
+    return begin() + find_pos(name, type, casesensitive);
 }
 
 
@@ -445,16 +534,7 @@ ParamValueList::find(ustring name, TypeDesc type, bool casesensitive)
 ParamValueList::iterator
 ParamValueList::find(string_view name, TypeDesc type, bool casesensitive)
 {
-    if (casesensitive) {
-        return find(ustring(name), type, casesensitive);
-    } else {
-        for (iterator i = begin(), e = end(); i != e; ++i) {
-            if (Strutil::iequals(i->name(), name)
-                && (type == TypeDesc::UNKNOWN || type == i->type()))
-                return i;
-        }
-    }
-    return end();
+    return begin() + find_pos(name, type, casesensitive);
 }
 
 
@@ -624,6 +704,7 @@ ParamValueList::getattribute_indexed(string_view name, int index,
 void
 ParamValueList::sort(bool casesensitive)
 {
+    invalidate_index();
     if (casesensitive)
         std::sort(begin(), end(),
                   [&](const ParamValue& a, const ParamValue& b) -> bool {
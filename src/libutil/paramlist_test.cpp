@@ -339,6 +339,79 @@ test_paramlist()
 
 
 
+// Long lists are searched through a name index. Make sure lookups stay
+// right as the list is modified in all the ways that must keep the index
+// up to date.
+static void
+test_paramlist_index()
+{
+    std::cout << "test_paramlist_index\n";
+    ParamValueList pl;
+    for (int i = 0; i < 100; ++i)
+        pl.emplace_back(Strutil::fmt::format("attr{}", i), i);
+    OIIO_CHECK_EQUAL(pl.get_int("attr0"), 0);
+    OIIO_CHECK_EQUAL(pl.get_int("attr77"), 77);
+    OIIO_CHECK_EQUAL(pl.get_int("ATTR77"), 77);  // case-insensitive default
+    OIIO_CHECK_ASSERT(pl.find("ATTR77", TypeUnknown, true) == pl.cend());
+    OIIO_CHECK_ASSERT(pl.find(ustring("attr77")) == pl.cbegin() + 77);
+    OIIO_CHECK_ASSERT(pl.find("attr77", TypeFloat) == pl.cend());
+    OIIO_CHECK_ASSERT(!pl.contains("attr100"));
+
+    // Appending extends the index; the first of duplicate names wins, and
+    // a case-sensitive search must skip a case-insensitive earlier match.
+    pl.emplace_back("attr100", 100);
+    pl.emplace_back("attr5", 500);
+    pl.emplace_back("Attr6", 600);
+    pl.emplace_back("attr7", 7.0f);
+    OIIO_CHECK_EQUAL(pl.get_int("attr100"), 100);
+    OIIO_CHECK_EQUAL(pl.get_int("attr5"), 5);
+    OIIO_CHECK_EQUAL(pl.get_int("Attr6", 0, true), 600);
+    OIIO_CHECK_EQUAL(pl.get_int("attr6", 0, true), 6);
+    OIIO_CHECK_EQUAL(pl.get_float("attr7", 0.0f, true, false), 7.0f);
+
+    // Removal, insertion, reordering, and wholesale replacement
+    pl.remove("attr0");
+    OIIO_CHECK_ASSERT(!pl.contains("attr0"));
+    OIIO_CHECK_EQUAL(pl.get_int("attr1"), 1);
+    OIIO_CHECK_EQUAL(pl.get_int("attr99"), 99);
+    pl.insert(pl.begin(), ParamValue("attr0", 1000));
+    OIIO_CHECK_EQUAL(pl.get_int("attr0"), 1000);
+    OIIO_CHECK_EQUAL(pl.get_int("attr5"), 5);
+    pl.sort();
+    OIIO_CHECK_EQUAL(pl.get_int("attr42"), 42);
+    OIIO_CHECK_EQUAL(pl.find("attr42")->get_int(), 42);
+    int late = 1;
+    pl.resize(pl.size() + 1);
+    pl.back().init("late", TypeInt, 1, &late);
+    OIIO_CHECK_ASSERT(pl.contains("late"));
+    ParamValueList copy = pl;
+    OIIO_CHECK_EQUAL(copy.get_int("attr42"), 42);
+    ParamValueList other;
+    other.emplace_back("solo", 1);
+    copy.swap(other);
+    OIIO_CHECK_ASSERT(copy.contains("solo"));
+    OIIO_CHECK_ASSERT(!copy.contains("attr42"));
+    OIIO_CHECK_EQUAL(other.get_int("attr42"), 42);
+    copy = std::move(other);
+    OIIO_CHECK_EQUAL(copy.get_int("attr42"), 42);
+    copy.clear();
+    OIIO_CHECK_ASSERT(!copy.contains("attr42"));
+
+    // Changes made through the underlying std::vector that keep the size
+    // the same go unnoticed by the index, but must not hide entries.
+    std::vector<ParamValue>& vec(pl);
+    OIIO_CHECK_EQUAL(pl.get_int("attr42"), 42);
+    vec[10] = ParamValue("renamed", 4242);
+    OIIO_CHECK_ASSERT(pl.contains("renamed"));
+    OIIO_CHECK_EQUAL(pl.get_int("renamed"), 4242);
+    OIIO_CHECK_EQUAL(pl.find("renamed") - pl.begin(), 10);
+    std::swap(vec[20], vec.back());
+    OIIO_CHECK_ASSERT(pl.contains("late"));
+    OIIO_CHECK_EQUAL(pl.get_int("late"), 1);
+}
+
+
+
 static void
 test_delegates()
 {
@@ -522,6 +595,7 @@ main(int /*argc*/, char* /*argv*/[])
     test_value_types();
     test_from_string();
     test_paramlist();
+    test_paramlist_index();
     test_delegates();
     test_implied_construction();
     test_paramlistspan();
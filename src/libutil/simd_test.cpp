@@ -28,6 +28,8 @@ using namespace OIIO::simd;
 
 static int iterations = 1000000;
 static int ntrials    = 5;
+static std::string json_filename;
+static std::string baseline_filename;
 static Sysutil::Term term(std::cout);
 OIIO_SIMD16_ALIGN float dummy_float[16];
 OIIO_SIMD16_ALIGN float dummy_float2[16];
@@ -47,8 +49,19 @@ getargs(int argc, char* argv[])
       .help(Strutil::fmt::format("Number of iterations (default: {})", iterations));
     ap.arg("--trials %d", &ntrials)
       .help("Number of trials");
+    ap.arg("--json %s:FILENAME", &json_filename)
+      .help("Save the benchmark results as JSON");
+    ap.arg("--compare %s:FILENAME", &baseline_filename)
+      .help("Compare benchmarks to a JSON baseline, fail if any regressed");
 
     ap.parse_args(argc, (const char**)argv);
+    if (json_filename.size())
+        Benchmarker::json_output(json_filename);
+    if (baseline_filename.size()
+        && !Benchmarker::compare_baseline(baseline_filename)) {
+        print(stderr, "Could not read baseline \"{}\"\n", baseline_filename);
+        exit(EXIT_FAILURE);
+    }
 }
 
 
@@ -1639,6 +1652,9 @@ void test_mathfuncs ()
                            mkvec<vint_t>(0, -1, -1, -2));
     benchmark ("float ifloor", [](float&v){ return ifloor(v); }, 1.1f);
     benchmark ("simd ifloor", [](const VEC&v){ return simd::ifloor(v); }, VEC(1.1f));
+    OIIO_CHECK_SIMD_EQUAL (rint(mkvec<VEC>(0.4f, 0.6f, -1.4f, -1.6f)),
+                           mkvec<vint_t>(0, 1, -1, -2));
+    benchmark ("simd rint", [](const VEC&v){ return simd::rint(v); }, VEC(1.1f));
 
     int iscalar;
     vint_t ival;
@@ -2120,5 +2136,5 @@ main(int argc, char* argv[])
     std::cout << "\nTotal time: " << Strutil::timeintervalformat(timer())
               << "\n";
 
-    return unit_test_failures;
+    return unit_test_failures + Benchmarker::regressions();
 }
@@ -14,6 +14,7 @@ OIIO_CLANG_PRAGMA(clang diagnostic ignored "-Wdeprecated-declarations")
 OIIO_PRAGMA_WARNING_POP
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <cstdarg>
 #include <cstdint>
@@ -54,6 +55,14 @@ OIIO_PRAGMA_WARNING_POP
 
 #include "stb_sprintf.h"
 
+// std::from_chars for floating point arrived later than the integer
+// versions in some standard libraries.
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#    define OIIO_HAS_FLOAT_FROM_CHARS 1
+#else
+#    define OIIO_HAS_FLOAT_FROM_CHARS 0
+#endif
+
 
 OIIO_NAMESPACE_BEGIN
 
@@ -1692,42 +1701,75 @@ Strutil::strtod(const char* nptr, char** endptr) noexcept
 
 
 
+// Convert the number at the start of s into val, returning the number of
+// characters consumed, or 0 if there was no number. This accepts the same
+// text as strtof/strtod in the "C" locale. Where std::from_chars is
+// available it does the work, which is much faster, never allocates, and
+// doesn't need a terminating null. The cases where from_chars behaves
+// differently -- hex floats and out-of-range values -- take the slow path.
+template<typename T>
+static size_t
+parse_number(string_view s, T& val)
+{
+#if OIIO_HAS_FLOAT_FROM_CHARS
+    const char* begin = s.data();
+    const char* end   = begin + s.size();
+    const char* p     = begin;
+    while (p != end && (*p == ' ' || (*p >= '\t' && *p <= '\r')))
+        ++p;
+    // from_chars accepts a leading '-' but not a '+'.
+    if (p != end && *p == '+' && ++p != end && *p == '-')
+        return 0;
+    const char* q = (p != end && *p == '-') ? p + 1 : p;
+    bool hex      = end - q >= 2 && q[0] == '0' && (q[1] == 'x' || q[1] == 'X');
+    if (!hex) {
+        T v;
+        auto r = std::from_chars(p, end, v);
+        if (r.ec == std::errc()) {
+            val = v;
+            return size_t(r.ptr - begin);
+        }
+        if (r.ec == std::errc::invalid_argument)
+            return 0;
+    }
+#endif
+    std::string str(s);
+    char* endptr = nullptr;
+    T v;
+    if constexpr (std::is_same<T, float>::value)
+        v = Strutil::strtof(str.c_str(), &endptr);
+    else
+        v = Strutil::strtod(str.c_str(), &endptr);
+    if (endptr == str.c_str())
+        return 0;
+    val = v;
+    return size_t(endptr - str.c_str());
+}
+
+
+
 float
 Strutil::stof(const char* s, size_t* pos)
 {
-    if (s) {
-        char* endptr;
-        float r = Strutil::strtof(s, &endptr);
-        if (endptr != s) {
-            if (pos)
-                *pos = size_t(endptr - s);
-            return r;
-        }
-    }
-    // invalid
-    if (pos)
-        *pos = 0;
-    return 0;
+    return Strutil::stof(s ? string_view(s) : string_view(), pos);
 }
 
 
 float
 Strutil::stof(const std::string& s, size_t* pos)
 {
-    return Strutil::stof(s.c_str(), pos);
+    return Strutil::stof(string_view(s), pos);
 }
 
 
 float
 Strutil::stof(string_view s, size_t* pos)
 {
-    // string_view can't be counted on to end with a terminating null, so
-    // for safety, create a temporary string. This looks wasteful, but it's
-    // not as bad as you think -- fully compliant C++ >= 11 implementations
-    // will use the "short string optimization", meaning that this string
-    // creation will NOT need an allocation/free for most strings we expect
-    // to hold a text representation of a float.
-    return Strutil::stof(std::string(s), pos);
+    float r    = 0.0f;
+    size_t len = parse_number(s, r);
+    if (pos)
+        *pos = len;
+    return len ? r : 0.0f;
 }
 
 
@@ -1735,39 +1777,74 @@ Strutil::stof(string_view s, size_t* pos)
 double
 Strutil::stod(const char* s, size_t* pos)
 {
-    if (s) {
-        char* endptr;
-        double r = Strutil::strtod(s, &endptr);
-        if (endptr != s) {
-            if (pos)
-                *pos = size_t(endptr - s);
-            return r;
-        }
-    }
-    // invalid
-    if (pos)
-        *pos = 0;
-    return 0;
+    return Strutil::stod(s ? string_view(s) : string_view(), pos);
 }
 
 
 double
 Strutil::stod(const std::string& s, size_t* pos)
 {
-    return Strutil::stod(s.c_str(), pos);
+    return Strutil::stod(string_view(s), pos);
 }
 
 
 double
 Strutil::stod(string_view s, size_t* pos)
 {
-    // string_view can't be counted on to end with a terminating null, so
-    // for safety, create a temporary string. This looks wasteful, but it's
-    // not as bad as you think -- fully compliant C++ >= 11 implementations
-    // will use the "short string optimization", meaning that this string
-    // creation will NOT need an allocation/free for most strings we expect
-    // to hold a text representation of a float.
-    return Strutil::stod(std::string(s).c_str(), pos);
+    double r   = 0.0;
+    size_t len = parse_number(s, r);
+    if (pos)
+        *pos = len;
+    return len ? r : 0.0;
+}
+
+
+
+template<typename T>
+static size_t
+parse_list(string_view s, span<T> values, string_view sep)
+{
+    // Whitespace around numbers is always skipped, so a separator that is
+    // nothing but whitespace means the numbers are whitespace-separated.
+    sep      = Strutil::strip(sep);
+    size_t n = 0;
+    while (n < values.size()) {
+        size_t len = 0;
+        if constexpr (std::is_same<T, int>::value)
+            values[n] = Strutil::stoi(s, &len);
+        else
+            len = parse_number(s, values[n]);
+        if (!len)
+            break;
+        ++n;
+        s.remove_prefix(len);
+        Strutil::skip_whitespace(s);
+        if (sep.size() && !Strutil::parse_prefix(s, sep))
+            break;
+    }
+    return n;
+}
+
+
+size_t
+Strutil::from_string_list(string_view s, span<float> values, string_view sep)
+{
+    return parse_list(s, values, sep);
+}
+
+
+size_t
+Strutil::from_string_list(string_view s, span<double> values,
+                          string_view sep)
+{
+    return parse_list(s, values, sep);
+}
+
+
+size_t
+Strutil::from_string_list(string_view s, span<int> values, string_view sep)
+{
+    return parse_list(s, values, sep);
 }
 
 
@@ -973,6 +973,21 @@ test_numeric_conversion()
     // stress case!
     OIIO_CHECK_EQUAL (Strutil::stof("100000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001E-200"), 1.0f);
     OIIO_CHECK_EQUAL (Strutil::stof("0.00000000000000000001"), 1.0e-20f);
+    // Corners where a from_chars-based parse must still act like strtof
+    OIIO_CHECK_EQUAL(Strutil::stof("+2.5", &pos), 2.5f);
+    OIIO_CHECK_EQUAL(pos, 4);
+    OIIO_CHECK_EQUAL(Strutil::stof("+-2.5", &pos), 0.0f);
+    OIIO_CHECK_EQUAL(pos, 0);
+    OIIO_CHECK_EQUAL(Strutil::stof("\t\n 2.5", &pos), 2.5f);
+    OIIO_CHECK_EQUAL(pos, 6);
+    OIIO_CHECK_EQUAL(Strutil::stof("0x10", &pos), 16.0f);
+    OIIO_CHECK_EQUAL(pos, 4);
+    OIIO_CHECK_EQUAL(Strutil::stof("-inf"), -std::numeric_limits<float>::infinity());
+    OIIO_CHECK_EQUAL(Strutil::stof("1e100"), std::numeric_limits<float>::infinity());
+    OIIO_CHECK_EQUAL(Strutil::stof("1e-100"), 0.0f);
+    OIIO_CHECK_ASSERT(std::isnan(Strutil::stof("nan")));
+    OIIO_CHECK_EQUAL(Strutil::stof(string_view("1.5678", 3)), 1.5f);
+    OIIO_CHECK_EQUAL(Strutil::stod(string_view("1.5678", 3)), 1.5);
 
     OIIO_CHECK_EQUAL(Strutil::strtod("314.25"), 314.25);
     OIIO_CHECK_EQUAL(Strutil::strtod("hi"), 0.0);
@@ -1010,6 +1025,7 @@ test_numeric_conversion()
     bench ("Strutil::stof(string) - locale-independent", [&](){ return DoNotOptimize(Strutil::stof(numstring)); });
     bench ("Strutil::stof(char*) - locale-independent", [&](){ return DoNotOptimize(Strutil::stof(numcstr)); });
     bench ("Strutil::stof(string_view) - locale-independent", [&](){ return DoNotOptimize(Strutil::stof(string_view(numstring))); });
+    bench ("Strutil::stod(string_view) - locale-independent", [&](){ return DoNotOptimize(Strutil::stod(string_view(numstring))); });
     bench ("locale switch (to classic)", [&](){ std::locale::global (std::locale::classic()); });
 }
 
@@ -1091,6 +1107,49 @@ test_extract()
 
 
 
+void
+test_from_string_list()
+{
+    std::cout << "Testing from_string_list\n";
+    float f[4] = { -1, -1, -1, -1 };
+    OIIO_CHECK_EQUAL(Strutil::from_string_list("1, 2.5 ,-3,4e1", f), 4);
+    OIIO_CHECK_EQUAL(f[0], 1.0f);
+    OIIO_CHECK_EQUAL(f[1], 2.5f);
+    OIIO_CHECK_EQUAL(f[2], -3.0f);
+    OIIO_CHECK_EQUAL(f[3], 40.0f);
+    // Stops when the span is full, or at the first non-number
+    OIIO_CHECK_EQUAL(Strutil::from_string_list("5,6,7,8,9", f), 4);
+    OIIO_CHECK_EQUAL(f[3], 8.0f);
+    OIIO_CHECK_EQUAL(Strutil::from_string_list("1,x,3", f), 1);
+    OIIO_CHECK_EQUAL(Strutil::from_string_list("1 2", f), 1);
+    OIIO_CHECK_EQUAL(Strutil::from_string_list("", f), 0);
+    // Whitespace separated
+    double d[3];
+    OIIO_CHECK_EQUAL(Strutil::from_string_list(" 1.5  2.5\t3.5 ", d, " "), 3);
+    OIIO_CHECK_EQUAL(d[2], 3.5);
+    int i[3];
+    OIIO_CHECK_EQUAL(Strutil::from_string_list("10;20;30", i, ";"), 3);
+    OIIO_CHECK_EQUAL(i[1], 20);
+
+    std::vector<float> big(10000);
+    std::string list;
+    for (size_t j = 0; j < big.size(); ++j)
+        list += Strutil::fmt::format("{}{}", j ? "," : "", j * 0.25f);
+    OIIO_CHECK_EQUAL(Strutil::from_string_list(list, big), big.size());
+    OIIO_CHECK_EQUAL(big[9999], 9999 * 0.25f);
+
+    Benchmarker bench;
+    bench.indent(2);
+    bench.units(Benchmarker::Unit::us);
+    bench("from_string_list 10k floats",
+          [&]() { DoNotOptimize(Strutil::from_string_list(list, big)); });
+    bench("extract_from_list_string 10k floats", [&]() {
+        DoNotOptimize(Strutil::extract_from_list_string(big, list));
+    });
+}
+
+
+
 void
 test_safe_strcpy()
 {
@@ -1748,6 +1807,7 @@ main(int /*argc*/, char* /*argv*/[])
     test_numeric_conversion();
     test_to_string();
     test_extract();
+    test_from_string_list();
     test_safe_strcpy();
     test_safe_strcat();
     test_safe_strlen();
@@ -18,6 +18,7 @@
 
 #ifdef __linux__
 #    include <sys/ioctl.h>
+#    include <sys/syscall.h>
 #    include <sys/sysinfo.h>
 #    include <unistd.h>
 #endif
@@ -617,6 +618,83 @@ Sysutil::max_open_files()
 
 
 
+int
+Sysutil::numa_nodes()
+{
+    static int nodes = []() {
+        int n = 1;
+#if defined(__linux__)
+        // The file holds a list of ranges like "0-1" or "0,2-3".
+        std::string online;
+        if (Filesystem::read_text_file("/sys/devices/system/node/online",
+                                       online)) {
+            int count = 0;
+            for (auto range : Strutil::splitsv(Strutil::strip(online), ",")) {
+                auto ends = Strutil::splitsv(range, "-");
+                if (ends.size() == 1)
+                    ++count;
+                else if (ends.size() == 2)
+                    count += Strutil::stoi(ends[1]) - Strutil::stoi(ends[0])
+                             + 1;
+            }
+            n = std::max(count, 1);
+        }
+#elif defined(_WIN32)
+        ULONG highest = 0;
+        if (GetNumaHighestNodeNumber(&highest))
+            n = int(highest) + 1;
+#endif
+        return n;
+    }();
+    return nodes;
+}
+
+
+
+int
+Sysutil::current_numa_node()
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned int cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+        return int(node);
+#elif defined(_WIN32)
+    PROCESSOR_NUMBER proc;
+    GetCurrentProcessorNumberEx(&proc);
+    USHORT node = 0;
+    if (GetNumaProcessorNodeEx(&proc, &node))
+        return int(node);
+#endif
+    return 0;
+}
+
+
+
+bool
+Sysutil::numa_prefer_node(void* ptr, size_t size, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    // Spelled out rather than taken from <numaif.h>, which would make us
+    // depend on libnuma just for these constants.
+    const int mpol_preferred    = 1;
+    const unsigned mpol_mf_move = 1 << 1;
+    const int maxnode           = 8 * sizeof(unsigned long);
+    if (node < 0 || node >= maxnode || !ptr || !size)
+        return false;
+    unsigned long nodemask = 1UL << node;
+    return syscall(SYS_mbind, ptr, size, mpol_preferred, &nodemask,
+                   (unsigned long)maxnode, mpol_mf_move)
+           == 0;
+#else
+    (void)ptr;
+    (void)size;
+    (void)node;
+    return false;
+#endif
+}
+
+
+
 void*
 aligned_malloc(std::size_t size, std::size_t align)
 {
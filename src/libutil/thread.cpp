@@ -18,9 +18,11 @@
 #    define _ENABLE_ATOMIC_ALIGNMENT_FIX /* Avoid MSVS error, ugh */
 #endif
 
+#include <atomic>
 #include <exception>
 #include <functional>
 #include <future>
+#include <limits>
 #include <memory>
 
 #include <OpenImageIO/parallel.h>
@@ -41,6 +43,7 @@
 
 
 #include <queue>
+#include <vector>
 
 OIIO_NAMESPACE_BEGIN
 namespace pvt {
@@ -81,6 +84,119 @@ private:
     Mutex mutex;
 };
 
+
+
+// A Chase-Lev work-stealing deque of pointers (see Chase & Lev, "Dynamic
+// Circular Work-Stealing Deque", SPAA 2005, and Le et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models", PPoPP 2013, whose C11
+// formulation this follows). Only the owning thread may push() and take(),
+// which work at the bottom without locking; any thread may steal() from
+// the top. Arrays outgrown by push() are kept until the deque is
+// destroyed, since a thief may still be reading from one.
+template<typename T> class WorkStealingDeque {
+public:
+    WorkStealingDeque()
+    {
+        m_arrays.emplace_back(new Array(256));
+        m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    // Owner only: add to the bottom.
+    void push(T value)
+    {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        Array* a  = m_array.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1)
+            a = grow(a, t, b);
+        a->put(b, value);
+        m_bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // Owner only: remove from the bottom (most recently pushed).
+    bool take(T& value)
+    {
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Array* a  = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        if (t > b) {  // empty
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        value = a->get(b);
+        if (t == b) {
+            // Last item: race any thieves for it.
+            bool won = m_top.compare_exchange_strong(t, t + 1,
+                                                     std::memory_order_seq_cst,
+                                                     std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread: remove from the top (least recently pushed).
+    bool steal(T& value)
+    {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return false;
+        Array* a = m_array.load(std::memory_order_acquire);
+        T v      = a->get(t);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                           std::memory_order_relaxed))
+            return false;  // lost the race to the owner or another thief
+        value = v;
+        return true;
+    }
+
+    size_t size() const
+    {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return b > t ? size_t(b - t) : 0;
+    }
+
+private:
+    struct Array {
+        explicit Array(int64_t capacity)
+            : capacity(capacity)
+            , items(new std::atomic<T>[capacity])
+        {
+        }
+        T get(int64_t i) const
+        {
+            return items[i & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+        void put(int64_t i, T v)
+        {
+            items[i & (capacity - 1)].store(v, std::memory_order_relaxed);
+        }
+        int64_t capacity;
+        std::unique_ptr<std::atomic<T>[]> items;
+    };
+
+    Array* grow(Array* a, int64_t t, int64_t b)
+    {
+        m_arrays.emplace_back(new Array(2 * a->capacity));
+        Array* bigger = m_arrays.back().get();
+        for (int64_t i = t; i < b; ++i)
+            bigger->put(i, a->get(i));
+        m_array.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    std::atomic<int64_t> m_top { 0 };
+    std::atomic<int64_t> m_bottom { 0 };
+    std::atomic<Array*> m_array { nullptr };
+    std::vector<std::unique_ptr<Array>> m_arrays;  // owner only
+};
+
+
 }  // namespace pvt
 OIIO_NAMESPACE_END
 
@@ -90,6 +206,7 @@ OIIO_NAMESPACE_BEGIN
 
 namespace pvt {
 OIIO_UTIL_API int oiio_use_tbb(0);  // Use TBB if available
+OIIO_UTIL_API int oiio_nested_parallelism(0);  // Off: nested loops run serially
 }
 
 
@@ -105,10 +222,39 @@ threads_default()
 
 
 
+// What the calling thread is doing for a thread_pool: if it is one of a
+// pool's workers, which pool (its Impl), its index, and its own deque.
+struct WorkerState {
+    const void* pool = nullptr;
+    int index        = -1;
+    void* deque      = nullptr;
+};
+static thread_local WorkerState this_worker;
+
+// How deeply the calling thread is nested in running tasks on behalf of a
+// task_set it is waiting on. Helping is cut off past a limit, so that
+// waits within helped tasks within waits can't exhaust the stack.
+static thread_local int task_help_depth = 0;
+static const int max_task_help_depth    = 8;
+
+
+
+// Each worker thread has its own deque. Tasks pushed by a worker go onto
+// its deque, where it runs them newest-first (they are the most likely to
+// be in its cache, and are usually what it is waiting for), while idle
+// workers steal the oldest ones. Tasks pushed by other threads go onto a
+// single shared queue. Workers push and pop their own tasks without
+// locking, so many threads splitting work at once don't all contend on
+// one queue.
 class thread_pool::Impl {
 public:
+    typedef std::function<void(int id)> Task;
+    typedef pvt::WorkStealingDeque<Task*> Deque;
+    typedef std::vector<std::shared_ptr<Deque>> DequeList;
+
     Impl(int nThreads = 0, int queueSize = 1024)
         : q(queueSize)
+        , m_deques(std::make_shared<DequeList>())
     {
         this->init();
         this->resize(nThreads);
@@ -142,9 +288,15 @@ public:
                 <= nThreads) {  // if the number of threads is increased
                 this->threads.resize(nThreads);
                 this->flags.resize(nThreads);
+                auto deques = std::make_shared<DequeList>(*deque_list());
+                deques->resize(nThreads);
+                for (int i = oldNThreads; i < nThreads; ++i)
+                    (*deques)[i] = std::make_shared<Deque>();
+                std::atomic_store(&m_deques,
+                                  std::shared_ptr<const DequeList>(deques));
                 for (int i = oldNThreads; i < nThreads; ++i) {
                     this->flags[i] = std::make_shared<std::atomic<bool>>(false);
-                    this->set_thread(i);
+                    this->set_thread(i, (*deques)[i]);
                 }
             } else {  // the number of threads is decreased
                 std::vector<std::unique_ptr<std::thread>> terminating_threads;
@@ -154,19 +306,28 @@ public:
                     this->threads.erase(this->threads.begin() + i);
                 }
                 {
-                    // stop the detached threads that were waiting
+                    // wake the departing threads that were waiting
                     std::unique_lock<std::mutex> lock(this->mutex);
                     this->cv.notify_all();
                 }
-                // wait for the terminated threads to finish
+                // A departing thread that is in the middle of a task keeps
+                // running it; it only sees its flag once that task returns.
+                // Then it hands whatever is left on its own deque to the
+                // shared queue and exits. Joining waits for all of that.
                 for (auto& thread : terminating_threads) {
                     if (thread->joinable())
                         thread->join();
                 }
-                this->threads.resize(
-                    nThreads);  // safe to delete because the threads are detached
-                this->flags.resize(
-                    nThreads);  // safe to delete because the threads have copies of shared_ptr of the flags, not originals
+                this->threads.resize(nThreads);
+                // safe to delete because the threads have copies of
+                // shared_ptr of the flags, not originals
+                this->flags.resize(nThreads);
+                // The departed threads have exited, and nothing can push
+                // to their deques any more, so the deques can go.
+                auto deques = std::make_shared<DequeList>(*deque_list());
+                deques->resize(nThreads);
+                std::atomic_store(&m_deques,
+                                  std::shared_ptr<const DequeList>(deques));
             }
         }
         m_size = nThreads;
@@ -180,11 +341,20 @@ public:
             delete _f;  // empty the queue
     }
 
+    // empty the worker deques -- only safe once the workers have stopped
+    void clear_deques()
+    {
+        Task* _f;
+        for (auto& d : *deque_list())
+            while (d->take(_f))
+                delete _f;
+    }
+
     // pops a functional wrapper to the original function
     std::function<void(int)> pop()
     {
         std::function<void(int id)>* _f = nullptr;
-        this->q.pop(_f);
+        this->find_task(_f);
         std::unique_ptr<std::function<void(int id)>> func(
             _f);  // at return, delete the function even if an exception occurred
         std::function<void(int)> f;
@@ -242,15 +412,26 @@ public:
         // if there were no threads in the pool but some functors in the queue, the functors are not deleted by the threads
         // therefore delete them here
         this->clear_queue();
+        this->clear_deques();
         this->threads.clear();
         this->flags.clear();
     }
 
     void push_queue_and_notify(std::function<void(int id)>* f)
     {
-        this->q.push(f);
-        std::unique_lock<std::mutex> lock(this->mutex);
-        this->cv.notify_one();
+        if (this_worker.pool == this)
+            static_cast<Deque*>(this_worker.deque)->push(f);
+        else
+            this->q.push(f);
+        // Only bother with the mutex if someone may be asleep. The fence
+        // pairs with the one a sleeping worker passes through (in steal())
+        // after counting itself in nWaiting, so that either we see it or
+        // it sees the new task.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->nWaiting.load() > 0) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->cv.notify_one();
+        }
     }
 
     // If any tasks are on the queue, pop and run one with the calling
@@ -258,13 +439,15 @@ public:
     bool run_one_task(std::thread::id id)
     {
         std::function<void(int)>* f = nullptr;
-        bool isPop                  = this->q.pop(f);
+        bool isPop                  = this->find_task(f);
         if (isPop) {
             OIIO_DASSERT(f);
             std::unique_ptr<std::function<void(int id)>> func(
                 f);  // at return, delete the function even if an exception occurred
             register_worker(id);
-            (*f)(-1);
+            ++task_help_depth;
+            (*f)(this_worker.pool == this ? this_worker.index : -1);
+            --task_help_depth;
             deregister_worker(id);
         } else {
             OIIO_DASSERT(f == nullptr);
@@ -288,7 +471,13 @@ public:
         return m_worker_threadids[id] != 0;
     }
 
-    size_t jobs_in_queue() const { return q.size(); }
+    size_t jobs_in_queue() const
+    {
+        size_t n = q.size();
+        for (auto& d : *deque_list())
+            n += d->size();
+        return n;
+    }
 
     bool very_busy() const { return jobs_in_queue() > size_t(4 * m_size); }
 
@@ -298,15 +487,54 @@ private:
     Impl& operator=(const Impl&) = delete;
     Impl& operator=(Impl&&)      = delete;
 
-    void set_thread(int i)
+    // The current list of worker deques. It is replaced, never modified,
+    // when the pool is resized, so holding on to it keeps it valid.
+    std::shared_ptr<const DequeList> deque_list() const
+    {
+        return std::atomic_load(&m_deques);
+    }
+
+    // Find a task for the calling thread: its own newest, else the oldest
+    // on the shared queue, else one stolen from a randomly chosen worker.
+    bool find_task(Task*& f)
+    {
+        Deque* mine = this_worker.pool == this
+                          ? static_cast<Deque*>(this_worker.deque)
+                          : nullptr;
+        if (mine && mine->take(f))
+            return true;
+        if (this->q.pop(f))
+            return true;
+        auto deques = deque_list();
+        size_t n    = deques->size();
+        if (!n)
+            return false;
+        static thread_local uint32_t rng = uint32_t(
+            std::hash<std::thread::id>()(std::this_thread::get_id()) | 1);
+        rng ^= rng << 13;  // xorshift32
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        for (size_t k = 0, start = rng % n; k < n; ++k) {
+            Deque* d = (*deques)[(start + k) % n].get();
+            if (d != mine && d->steal(f))
+                return true;
+        }
+        return false;
+    }
+
+    void set_thread(int i, std::shared_ptr<Deque> deque)
     {
         std::shared_ptr<std::atomic<bool>> flag(
             this->flags[i]);  // a copy of the shared ptr to the flag
-        auto f = [this, i, flag /* a copy of the shared ptr to the flag */]() {
+        auto f = [this, i, flag /* a copy of the shared ptr to the flag */,
+                  deque]() {
+            this_worker.pool  = this;
+            this_worker.index = i;
+            this_worker.deque = deque.get();
             register_worker(std::this_thread::get_id());
             std::atomic<bool>& _flag = *flag;
             std::function<void(int id)>* _f;
-            bool isPop = this->q.pop(_f);
+            bool isPop = this->find_task(_f);
             while (true) {
                 while (isPop) {  // if there is anything in the queue
                     std::unique_ptr<std::function<void(int id)>> func(
@@ -314,23 +542,39 @@ private:
                     (*_f)(i);
                     if (_flag) {
                         // the thread is wanted to stop, return even if the queue is not empty yet
-                        return;
+                        isPop = false;
+                        break;
                     } else {
-                        isPop = this->q.pop(_f);
+                        isPop = this->find_task(_f);
                     }
                 }
+                if (_flag)
+                    break;
                 // the queue is empty here, wait for the next command
                 std::unique_lock<std::mutex> lock(this->mutex);
                 ++this->nWaiting;
                 this->cv.wait(lock, [this, &_f, &isPop, &_flag]() {
-                    isPop = this->q.pop(_f);
+                    isPop = this->find_task(_f);
                     return isPop || this->isDone || _flag;
                 });
                 --this->nWaiting;
                 if (!isPop)
                     break;  // if the queue is empty and this->isDone == true or *flag then return
             }
+            // Hand anything still on our deque to the threads that remain.
+            if (!this->isStop) {
+                bool handed_off = false;
+                while (deque->take(_f)) {
+                    this->q.push(_f);
+                    handed_off = true;
+                }
+                if (handed_off) {
+                    std::unique_lock<std::mutex> lock(this->mutex);
+                    this->cv.notify_all();
+                }
+            }
             deregister_worker(std::this_thread::get_id());
+            this_worker = WorkerState();
         };
         this->threads[i].reset(
             new std::thread(f));  // compiler may not support std::make_unique()
@@ -346,6 +590,7 @@ private:
     std::vector<std::unique_ptr<std::thread>> threads;
     std::vector<std::shared_ptr<std::atomic<bool>>> flags;
     mutable pvt::ThreadsafeQueue<std::function<void(int id)>*> q;
+    std::shared_ptr<const DequeList> m_deques;  // use deque_list()
     std::atomic<bool> isDone;
     std::atomic<bool> isStop;
     std::atomic<int> nWaiting;  // how many threads are waiting
@@ -495,7 +740,7 @@ task_set::wait_for_task(size_t taskindex, bool block)
     if (taskindex >= m_futures.size())
         return;  // nothing to wait for
     auto& f(m_futures[taskindex]);
-    if (block || m_pool->is_worker(m_submitter_thread)) {
+    if (block || task_help_depth >= max_task_help_depth) {
         // Block on completion of all the task and don't try to do any
         // of the work with the calling thread.
         f.wait();
@@ -531,8 +776,8 @@ task_set::wait(bool block)
 {
     OIIO_DASSERT(submitter() == std::this_thread::get_id());
     const std::chrono::milliseconds wait_time(0);
-    if (m_pool->is_worker(m_submitter_thread))
-        block = true;  // don't get into recursive work stealing
+    if (task_help_depth >= max_task_help_depth)
+        block = true;  // don't get into unbounded recursive work stealing
     if (block == false) {
         int tries = 0;
         while (1) {
@@ -591,21 +836,202 @@ task_set::wait(bool block)
 static int
 parallel_recursive_depth(int change = 0)
 {
-    thread_local int depth = 0;  // let's only allow one level of parallel work
+    thread_local int depth = 0;
     depth += change;
     return depth;
 }
 
 
 
+// May parallel loops nested within the tasks of other parallel loops split
+// their work onto the pool too? That is safe, because waiting pool threads
+// run queued tasks rather than blocking, and nested tasks go to the
+// waiting thread's own deque, to be stolen by whichever threads are idle.
+// Beyond a few levels, though, there's nothing left to gain.
+static bool
+nested_parallelism_allowed(const paropt& opt, int depth)
+{
+    const int max_nesting = 4;
+    if (opt.recursive() || pvt::oiio_nested_parallelism)
+        return depth <= max_nesting;
+    return depth <= 1;  // let's only allow one level of parallel work
+}
+
+
+
+// The process-wide thread budget (0 means uncapped), and the number of
+// helper threads currently claimed against it.
+static std::atomic<int> thread_budget_cap(0);
+static std::atomic<int> thread_budget_used(0);
+
+
+
+void
+thread_budget(int nthreads)
+{
+    thread_budget_cap = std::max(0, nthreads);
+}
+
+
+
+int
+thread_budget()
+{
+    return thread_budget_cap;
+}
+
+
+
+int
+thread_budget_active()
+{
+    return thread_budget_used;
+}
+
+
+
+int
+thread_budget_available()
+{
+    int cap = thread_budget_cap;
+    if (cap <= 0)
+        return std::numeric_limits<int>::max();
+    return std::max(0, cap - thread_budget_used);
+}
+
+
+
+int
+thread_budget_acquire(int nthreads, bool* counted)
+{
+    if (counted)
+        *counted = false;
+    if (nthreads <= 0)
+        return 0;
+    int cap = thread_budget_cap;
+    if (cap <= 0) {
+        // Uncapped: a caller that can tell it wasn't counted needn't touch
+        // the shared counter at all.
+        if (counted)
+            return nthreads;
+        thread_budget_used += nthreads;
+        return nthreads;
+    }
+    int used = thread_budget_used;
+    int granted;
+    do {
+        granted = std::max(0, std::min(cap - used, nthreads));
+    } while (granted
+             && !thread_budget_used.compare_exchange_weak(used,
+                                                          used + granted));
+    if (counted)
+        *counted = granted > 0;
+    return granted;
+}
+
+
+
+void
+thread_budget_release(int nthreads)
+{
+    if (nthreads > 0)
+        thread_budget_used -= nthreads;
+}
+
+
+
+// The executor lent to us by the application, if any. Loops take their own
+// reference to it, so it may be replaced while they are running.
+struct LentExecutor {
+    parallel_executor executor;
+    int nthreads;
+};
+
+static spin_mutex lent_executor_mutex;
+static std::shared_ptr<const LentExecutor> lent_executor_ptr;
+static std::atomic<bool> lent_executor_set(false);
+
+
+
+void
+set_parallel_executor(parallel_executor executor, int nthreads)
+{
+    std::shared_ptr<const LentExecutor> lent;
+    if (executor)
+        lent.reset(new LentExecutor { std::move(executor),
+                                      std::max(1, nthreads) });
+    spin_lock lock(lent_executor_mutex);
+    lent_executor_ptr = lent;
+    lent_executor_set = bool(lent);
+}
+
+
+
+bool
+has_parallel_executor()
+{
+    return lent_executor_set;
+}
+
+
+
+// The lent executor that a loop with these options should run on, or null
+// if it should use a thread pool. Loops that name their own pool, or that
+// ask for OIIO's pool specifically, never use the executor.
+static std::shared_ptr<const LentExecutor>
+lent_executor(const paropt& opt)
+{
+    if (!lent_executor_set || opt.pool()
+        || opt.strategy() == paropt::ParStrategy::OIIOpool)
+        return nullptr;
+    spin_lock lock(lent_executor_mutex);
+    return lent_executor_ptr;
+}
+
+
+
+// Run task(id, b, e) over [begin,end) in pieces of chunksize, on the lent
+// executor if there is one, and otherwise on the calling thread plus at
+// most nhelpers pool threads, each taking the next chunk as it finishes
+// the last. Unlike pushing every chunk onto the pool, this never puts more
+// than nhelpers pool threads to work on the loop at once, which is what
+// keeps us within the thread budget.
+static void
+run_chunks_limited(int64_t begin, int64_t end, int64_t chunksize,
+                   int nhelpers, thread_pool* pool, const LentExecutor* lent,
+                   function_view<void(int id, int64_t b, int64_t e)> task)
+{
+    if (lent) {
+        lent->executor(begin, end, chunksize,
+                       [&](int64_t b, int64_t e) { task(-1, b, e); });
+        return;
+    }
+    std::atomic<int64_t> next(begin);
+    auto worker = [&](int id) {
+        for (int64_t b = next.fetch_add(chunksize); b < end;
+             b = next.fetch_add(chunksize))
+            task(id, b, std::min(end, b + chunksize));
+    };
+    int64_t nchunks = (end - begin + chunksize - 1) / chunksize;
+    nhelpers        = int(std::min(int64_t(nhelpers), nchunks - 1));
+    task_set ts(pool);
+    for (int t = 0; t < nhelpers; ++t)
+        ts.push(pool->push(worker));
+    worker(-1);
+    ts.wait();
+}
+
+
+
 void
 paropt::resolve()
 {
+    std::shared_ptr<const LentExecutor> lent = lent_executor(*this);
     if (m_pool == nullptr)
         m_pool = default_thread_pool();
-    if (m_maxthreads <= 0)
-        m_maxthreads = m_pool->size() + 1;  // pool size + caller
-    if (!m_recursive && m_pool->is_worker())
+    if (m_maxthreads <= 0)  // executor or pool size, plus caller
+        m_maxthreads = lent ? lent->nthreads : m_pool->size() + 1;
+    if (!m_recursive && !pvt::oiio_nested_parallelism && m_pool->is_worker())
         m_maxthreads = 1;
 }
 
@@ -616,9 +1042,13 @@ parallel_for_chunked_id(int64_t begin, int64_t end, int64_t chunksize,
                         std::function<void(int id, int64_t b, int64_t e)>&& task,
                         paropt opt)
 {
-    if (parallel_recursive_depth(1) > 1)
+    if (!nested_parallelism_allowed(opt, parallel_recursive_depth(1)))
         opt.maxthreads(1);
+    std::shared_ptr<const LentExecutor> lent = lent_executor(opt);
     opt.resolve();
+    // Helper threads beyond the caller come out of the process-wide budget
+    thread_budget_claim claim(opt.maxthreads() - 1);
+    opt.maxthreads(claim.granted() + 1);
     chunksize = std::min(chunksize, end - begin);
     if (chunksize < 1) {           // If caller left chunk size to us...
         if (opt.singlethread()) {  // Single thread: do it all in one shot
@@ -630,6 +1060,13 @@ parallel_for_chunked_id(int64_t begin, int64_t end, int64_t chunksize,
     }
     // N.B. If chunksize was specified, honor it, even for the single
     // threaded case.
+    if ((lent || thread_budget() > 0) && !opt.singlethread()
+        && chunksize < end - begin) {
+        run_chunks_limited(begin, end, chunksize, claim.granted(),
+                           opt.pool(), lent.get(), task);
+        parallel_recursive_depth(-1);
+        return;
+    }
     for (task_set ts(opt.pool()); begin < end; begin += chunksize) {
         int64_t e = std::min(end, begin + chunksize);
         if (e == end || opt.singlethread() || opt.pool()->very_busy()) {
@@ -681,11 +1118,16 @@ parallel_for_impl(Index begin, Index end, function_view<void(Index)> task,
         return;
     }
 #if OIIO_TBB
-    if (opt.strategy() == paropt::ParStrategy::TryTBB
-        || (opt.strategy() == paropt::ParStrategy::Default
-            && pvt::oiio_use_tbb)) {
-        if (opt.maxthreads()) {
-            tbb::task_arena arena(opt.maxthreads());
+    if (!has_parallel_executor()
+        && (opt.strategy() == paropt::ParStrategy::TryTBB
+            || (opt.strategy() == paropt::ParStrategy::Default
+                && pvt::oiio_use_tbb))) {
+        if (opt.maxthreads() || thread_budget() > 0) {
+            int nthreads = opt.maxthreads()
+                               ? opt.maxthreads()
+                               : tbb::this_task_arena::max_concurrency();
+            thread_budget_claim claim(nthreads - 1);
+            tbb::task_arena arena(claim.granted() + 1);
             arena.execute([=] { tbb::parallel_for(begin, end, task); });
         } else {
             tbb::parallel_for(begin, end, task);
@@ -829,9 +1271,12 @@ parallel_for_chunked_2D_id(
     std::function<void(int id, int64_t, int64_t, int64_t, int64_t)>&& task,
     paropt opt)
 {
-    if (parallel_recursive_depth(1) > 1)
+    if (!nested_parallelism_allowed(opt, parallel_recursive_depth(1)))
         opt.maxthreads(1);
+    std::shared_ptr<const LentExecutor> lent = lent_executor(opt);
     opt.resolve();
+    thread_budget_claim claim(opt.maxthreads() - 1);
+    opt.maxthreads(claim.granted() + 1);
     if (opt.singlethread()
         || (xchunksize >= (xend - xbegin) && ychunksize >= (yend - ybegin))
         || opt.pool()->very_busy()) {
@@ -847,6 +1292,23 @@ parallel_for_chunked_2D_id(
         int64_t nx = std::max(int64_t(1), opt.maxthreads() / ny);
         xchunksize = std::max(int64_t(1), (xend - xbegin) / nx);
     }
+    if (lent || thread_budget() > 0) {
+        // Number the tiles and hand them out like a 1D loop
+        int64_t nx = (xend - xbegin + xchunksize - 1) / xchunksize;
+        int64_t ny = (yend - ybegin + ychunksize - 1) / ychunksize;
+        run_chunks_limited(
+            0, nx * ny, 1, claim.granted(), opt.pool(), lent.get(),
+            [&](int id, int64_t b, int64_t e) {
+                for (int64_t i = b; i < e; ++i) {
+                    int64_t x = xbegin + (i % nx) * xchunksize;
+                    int64_t y = ybegin + (i / nx) * ychunksize;
+                    task(id, x, std::min(xend, x + xchunksize), y,
+                         std::min(yend, y + ychunksize));
+                }
+            });
+        parallel_recursive_depth(-1);
+        return;
+    }
     task_set ts(opt.pool());
     for (auto y = ybegin; y < yend; y += ychunksize) {
         int64_t ychunkend = std::min(yend, y + ychunksize);
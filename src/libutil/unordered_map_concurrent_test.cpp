@@ -0,0 +1,161 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/thread.h>
+#include <OpenImageIO/unittest.h>
+#include <OpenImageIO/unordered_map_concurrent.h>
+
+
+using namespace OIIO;
+
+// Few bins, so that each one grows well past the size at which rehashing
+// is done outside the write lock.
+typedef unordered_map_concurrent<int, int, std::hash<int>, std::equal_to<int>,
+                                 4>
+    IntMap;
+
+
+
+static void
+test_basics()
+{
+    std::cout << "Testing basic operations\n";
+    IntMap map;
+    OIIO_CHECK_ASSERT(map.empty());
+    for (int i = 0; i < 5000; ++i)
+        OIIO_CHECK_ASSERT(map.insert(i, 2 * i));
+    OIIO_CHECK_EQUAL(map.size(), size_t(5000));
+    OIIO_CHECK_ASSERT(!map.insert(17, 0));  // already there
+
+    int value = -1;
+    OIIO_CHECK_ASSERT(map.retrieve(4999, value));
+    OIIO_CHECK_EQUAL(value, 2 * 4999);
+    OIIO_CHECK_ASSERT(!map.retrieve(5000, value));
+    {
+        auto found = map.find(1234);
+        OIIO_CHECK_ASSERT(found);
+        OIIO_CHECK_EQUAL(found->second, 2468);
+    }
+
+    map.erase(17);
+    OIIO_CHECK_ASSERT(!map.retrieve(17, value));
+    OIIO_CHECK_EQUAL(map.size(), size_t(4999));
+
+    // Iteration visits every entry once
+    long long sum = 0;
+    size_t count  = 0;
+    for (auto it = map.begin(); it != map.end(); ++it, ++count)
+        sum += it->second;
+    OIIO_CHECK_EQUAL(count, size_t(4999));
+    OIIO_CHECK_EQUAL(sum, 4999LL * 5000 - 2 * 17);
+}
+
+
+
+// Writers insert disjoint ranges of keys while readers keep looking up the
+// keys already published. The bins grow many times along the way, and no
+// lookup may ever miss or see a wrong value, nor may any insert be lost.
+static void
+test_concurrent_growth(int nwriters, int nreaders, int keys_per_writer)
+{
+    std::cout << "Testing growth under concurrent lookups with " << nwriters
+              << " writers and " << nreaders << " readers\n";
+    IntMap map;
+    std::vector<std::atomic<int>> published(nwriters);
+    for (auto& p : published)
+        p = 0;
+    std::atomic<int> writers_done(0), bad_lookups(0);
+
+    thread_group threads;
+    for (int w = 0; w < nwriters; ++w) {
+        threads.create_thread([&, w]() {
+            for (int i = 0; i < keys_per_writer; ++i) {
+                int key = w * keys_per_writer + i;
+                if (!map.insert(key, 2 * key))
+                    ++bad_lookups;
+                published[w] = i + 1;
+            }
+            ++writers_done;
+        });
+    }
+    for (int r = 0; r < nreaders; ++r) {
+        threads.create_thread([&, r]() {
+            unsigned int seed = 12345 + r;
+            while (writers_done < nwriters) {
+                for (int w = 0; w < nwriters; ++w) {
+                    int n = published[w];
+                    if (!n)
+                        continue;
+                    seed      = seed * 1664525u + 1013904223u;
+                    int key   = w * keys_per_writer + int(seed % unsigned(n));
+                    int value = -1;
+                    if (!map.retrieve(key, value) || value != 2 * key)
+                        ++bad_lookups;
+                }
+            }
+        });
+    }
+    threads.join_all();
+
+    OIIO_CHECK_EQUAL(bad_lookups, 0);
+    OIIO_CHECK_EQUAL(map.size(), size_t(nwriters * keys_per_writer));
+    int missing = 0;
+    for (int key = 0; key < nwriters * keys_per_writer; ++key) {
+        int value = -1;
+        missing += !map.retrieve(key, value) || value != 2 * key;
+    }
+    OIIO_CHECK_EQUAL(missing, 0);
+}
+
+
+
+// Threads racing to insert the same keys: exactly one insert of each key
+// succeeds, and every thread gets back the winner's value.
+static void
+test_racing_inserts(int nthreads, int nkeys)
+{
+    std::cout << "Testing " << nthreads << " threads inserting the same "
+              << nkeys << " keys\n";
+    IntMap map;
+    std::vector<std::atomic<int>> winners(nkeys);
+    for (auto& w : winners)
+        w = -1;
+    std::atomic<int> inserted(0), mismatched(0);
+    thread_group threads;
+    for (int t = 0; t < nthreads; ++t) {
+        threads.create_thread([&, t]() {
+            for (int key = 0; key < nkeys; ++key) {
+                int value = nthreads * key + t, mapvalue = -1;
+                if (map.insert_retrieve(key, value, mapvalue))
+                    ++inserted;
+                // value is now the one in the map, whoever put it there
+                int expected = -1;
+                if (!winners[key].compare_exchange_strong(expected, value)
+                    && expected != value)
+                    ++mismatched;
+            }
+        });
+    }
+    threads.join_all();
+    OIIO_CHECK_EQUAL(inserted, nkeys);
+    OIIO_CHECK_EQUAL(mismatched, 0);
+    OIIO_CHECK_EQUAL(map.size(), size_t(nkeys));
+}
+
+
+
+int
+main(int /*argc*/, char* /*argv*/[])
+{
+    test_basics();
+    test_concurrent_growth(4, 4, 50000);
+    test_racing_inserts(8, 20000);
+    return unit_test_failures;
+}
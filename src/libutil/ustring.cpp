@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -14,10 +16,9 @@
 
 OIIO_NAMESPACE_BEGIN
 
-// Use rw spin locks
-typedef spin_rw_mutex ustring_mutex_t;
-typedef spin_rw_read_lock ustring_read_lock_t;
-typedef spin_rw_write_lock ustring_write_lock_t;
+// Only insertions lock; lookups don't.
+typedef spin_mutex ustring_mutex_t;
+typedef spin_lock ustring_lock_t;
 
 
 #define PREVENT_HASH_COLLISIONS 1
@@ -32,16 +33,23 @@ template<class T> struct identity {
 // #define USTRING_TRACK_NUM_LOOKUPS
 
 
+// Open-addressed hash table of TableRep pointers. Lookups take no lock at
+// all: each slot is an atomic pointer that, once set, never changes, and
+// the slot array itself is reached through an atomic pointer. Insertions
+// are serialized by a lock. To grow, an inserter builds a complete new
+// array and then publishes it; the old array is never freed (just as
+// ustrings themselves never are), so a reader still probing it is safe,
+// and at worst misses a string added since -- and a miss just sends
+// make_unique on to insert(), which re-checks under the lock.
 template<unsigned BASE_CAPACITY, unsigned POOL_SIZE> struct TableRepMap {
     static_assert((BASE_CAPACITY & (BASE_CAPACITY - 1)) == 0,
                   "BASE_CAPACITY must be a power of 2");
 
     TableRepMap()
-        : entries(static_cast<ustring::TableRep**>(
-            calloc(BASE_CAPACITY, sizeof(ustring::TableRep*))))
+        : table(new Table(BASE_CAPACITY - 1))
         , pool(static_cast<char*>(malloc(POOL_SIZE)))
-        , memory_usage(sizeof(*this) + POOL_SIZE
-                       + sizeof(ustring::TableRep*) * BASE_CAPACITY)
+        , memory_usage(sizeof(*this) + POOL_SIZE + sizeof(Table)
+                       + sizeof(Slot) * BASE_CAPACITY)
     {
     }
 
@@ -51,27 +59,22 @@ template<unsigned BASE_CAPACITY, unsigned POOL_SIZE> struct TableRepMap {
 
     size_t get_memory_usage()
     {
-        ustring_read_lock_t lock(mutex);
+        ustring_lock_t lock(mutex);
         return memory_usage;
     }
 
     size_t get_num_entries()
     {
-        ustring_read_lock_t lock(mutex);
+        ustring_lock_t lock(mutex);
         return num_entries;
     }
 
 #ifdef USTRING_TRACK_NUM_LOOKUPS
-    size_t get_num_lookups()
-    {
-        ustring_read_lock_t lock(mutex);
-        return num_lookups;
-    }
+    size_t get_num_lookups() { return num_lookups; }
 #endif
 
     const char* lookup(string_view str, uint64_t hash)
     {
-        ustring_read_lock_t lock(mutex);
 #ifdef USTRING_TRACK_NUM_LOOKUPS
         // NOTE: this simple increment adds a substantial amount of overhead
         // so keep it off by default, unless the user really wants it
@@ -79,17 +82,18 @@ template<unsigned BASE_CAPACITY, unsigned POOL_SIZE> struct TableRepMap {
         // can skew the number of lookups compared to release builds
         ++num_lookups;
 #endif
-        size_t pos = hash & mask, dist = 0;
+        const Table* t = table.load(std::memory_order_acquire);
+        size_t pos = hash & t->mask, dist = 0;
         for (;;) {
-            if (entries[pos] == 0)
+            const ustring::TableRep* rep = t->slots[pos].load(
+                std::memory_order_acquire);
+            if (rep == 0)
                 return 0;
-            if (entries[pos]->hashed == hash
-                && entries[pos]->length == str.length()
-                && strncmp(entries[pos]->c_str(), str.data(), str.length())
-                       == 0)
-                return entries[pos]->c_str();
+            if (rep->hashed == hash && rep->length == str.length()
+                && strncmp(rep->c_str(), str.data(), str.length()) == 0)
+                return rep->c_str();
             ++dist;
-            pos = (pos + dist) & mask;  // quadratic probing
+            pos = (pos + dist) & t->mask;  // quadratic probing
         }
     }
 
@@ -98,7 +102,6 @@ template<unsigned BASE_CAPACITY, unsigned POOL_SIZE> struct TableRepMap {
     // the hash.
     const char* lookup(uint64_t hash)
     {
-        ustring_read_lock_t lock(mutex);
 #ifdef USTRING_TRACK_NUM_LOOKUPS
         // NOTE: this simple increment adds a substantial amount of overhead
         // so keep it off by default, unless the user really wants it
@@ -106,71 +109,91 @@ template<unsigned BASE_CAPACITY, unsigned POOL_SIZE> struct TableRepMap {
         // can skew the number of lookups compared to release builds
         ++num_lookups;
 #endif
-        size_t pos = hash & mask, dist = 0;
+        const Table* t = table.load(std::memory_order_acquire);
+        size_t pos = hash & t->mask, dist = 0;
         for (;;) {
-            if (entries[pos] == 0)
+            const ustring::TableRep* rep = t->slots[pos].load(
+                std::memory_order_acquire);
+            if (rep == 0)
                 return 0;
-            if (entries[pos]->hashed == hash)
-                return entries[pos]->c_str();
+            if (rep->hashed == hash)
+                return rep->c_str();
             ++dist;
-            pos = (pos + dist) & mask;  // quadratic probing
+            pos = (pos + dist) & t->mask;  // quadratic probing
         }
     }
 
     const char* insert(string_view str, uint64_t hash)
     {
-        ustring_write_lock_t lock(mutex);
-        size_t pos = hash & mask, dist = 0;
+        ustring_lock_t lock(mutex);
+        // Only inserters (holding the lock) change the table pointer.
+        Table* t   = table.load(std::memory_order_relaxed);
+        size_t pos = hash & t->mask, dist = 0;
         for (;;) {
-            if (entries[pos] == 0)
+            ustring::TableRep* rep = t->slots[pos].load(
+                std::memory_order_relaxed);
+            if (rep == 0)
                 break;  // found insert pos
-            if (entries[pos]->hashed == hash
-                && entries[pos]->length == str.length()
-                && !strncmp(entries[pos]->c_str(), str.data(), str.length())) {
+            if (rep->hashed == hash && rep->length == str.length()
+                && !strncmp(rep->c_str(), str.data(), str.length())) {
                 // same string is already inserted, return the one that is
                 // already in the table
-                return entries[pos]->c_str();
+                return rep->c_str();
             }
             ++dist;
-            pos = (pos + dist) & mask;  // quadratic probing
+            pos = (pos + dist) & t->mask;  // quadratic probing
         }
 
         ustring::TableRep* rep = make_rep(str, hash);
-        entries[pos]           = rep;
+        // Release, so a lookup that sees the pointer sees the whole rep.
+        t->slots[pos].store(rep, std::memory_order_release);
         ++num_entries;
-        if (2 * num_entries > mask)
-            grow();           // maintain 0.5 load factor
+        if (2 * num_entries > t->mask)
+            grow(t);          // maintain 0.5 load factor
         return rep->c_str();  // rep is now in the table
     }
 
 private:
-    void grow()
+    typedef std::atomic<ustring::TableRep*> Slot;
+
+    struct Table {
+        explicit Table(size_t mask)
+            : mask(mask)
+            , slots(new Slot[mask + 1]())
+        {
+        }
+        size_t mask;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    void grow(Table* old)
     {
-        size_t new_mask = mask * 2 + 1;
+        size_t new_mask = old->mask * 2 + 1;
 
-        // NOTE: only increment by half because we are doubling the entries and freeing the old
-        memory_usage += (mask + 1) * sizeof(ustring::TableRep*);
+        // NOTE: the old array is retired, not freed, since lookups may
+        // still be reading it, so count all of the new one.
+        memory_usage += sizeof(Table) + (new_mask + 1) * sizeof(Slot);
 
-        ustring::TableRep** new_entries = static_cast<ustring::TableRep**>(
-            calloc(new_mask + 1, sizeof(ustring::TableRep*)));
+        Table* t       = new Table(new_mask);
         size_t to_copy = num_entries;
         for (size_t i = 0; to_copy != 0; i++) {
-            if (entries[i] == 0)
+            ustring::TableRep* rep = old->slots[i].load(
+                std::memory_order_relaxed);
+            if (rep == 0)
                 continue;
-            size_t pos = entries[i]->hashed & new_mask, dist = 0;
+            size_t pos = rep->hashed & new_mask, dist = 0;
             for (;;) {
-                if (new_entries[pos] == 0)
+                if (t->slots[pos].load(std::memory_order_relaxed) == 0)
                     break;
                 ++dist;
                 pos = (pos + dist) & new_mask;  // quadratic probing
             }
-            new_entries[pos] = entries[i];
+            t->slots[pos].store(rep, std::memory_order_relaxed);
             to_copy--;
         }
 
-        free(entries);
-        entries = new_entries;
-        mask    = new_mask;
+        // Publish the filled-in table; lookups that acquire it see it all.
+        table.store(t, std::memory_order_release);
     }
 
     ustring::TableRep* make_rep(string_view str, uint64_t hash)
@@ -200,15 +223,17 @@ private:
         return result;
     }
 
+    // The table pointer gets its own cache line, apart from the lock and
+    // the inserters' bookkeeping, so that lookups only ever read lines
+    // that change when the table grows.
+    OIIO_CACHE_ALIGN std::atomic<Table*> table;
     OIIO_CACHE_ALIGN mutable ustring_mutex_t mutex;
-    size_t mask = BASE_CAPACITY - 1;
-    ustring::TableRep** entries;
     size_t num_entries = 0;
     char* pool;
     size_t pool_offset = 0;
     size_t memory_usage;
 #ifdef USTRING_TRACK_NUM_LOOKUPS
-    size_t num_lookups = 0;
+    std::atomic<size_t> num_lookups { 0 };
 #endif
 };
 
@@ -300,6 +300,42 @@ benchmark_threaded_ustring_creation()
 
 
 
+static void
+lookup_hot_ustrings(int iterations)
+{
+    // Every thread repeatedly looks up the same few existing strings, as a
+    // renderer does with its common names, so they all hit the same table
+    // entries at once.
+    static const char* hot[] = { "P", "N", "Cd", "u", "v", "dPdu", "dPdv",
+                                 "time", "object", "camera", "world", "st" };
+    const int nhot = int(sizeof(hot) / sizeof(hot[0]));
+    size_t h       = 0;
+    for (int i = 0; i < iterations; ++i)
+        h += ustring(hot[i % nhot]).hash();
+    if (verbose)
+        Strutil::printf("checksum %08x\n", unsigned(h));
+}
+
+
+
+void
+benchmark_contended_ustring_lookup()
+{
+    std::cout << "\nContended lookups of a few existing ustrings:\n";
+    lookup_hot_ustrings(100);  // make sure they already exist
+    if (wedge) {
+        timed_thread_wedge(lookup_hot_ustrings, numthreads, iterations,
+                           ntrials);
+    } else {
+        timed_thread_wedge(lookup_hot_ustrings, numthreads, iterations,
+                           ntrials,
+                           numthreads /* just this one thread count */);
+    }
+    OIIO_CHECK_ASSERT(true);  // If we make it here without crashing, pass
+}
+
+
+
 void
 verify_no_collisions()
 {
@@ -328,6 +364,7 @@ main(int argc, char* argv[])
     test_ustringhash();
     verify_no_collisions();
     benchmark_threaded_ustring_creation();
+    benchmark_contended_ustring_lookup();
     verify_no_collisions();
 
     std::cout << "\n" << ustring::getstats(true) << "\n";
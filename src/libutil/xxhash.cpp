@@ -80,7 +80,14 @@ You can contact the author at :
 //**************************************
 // Includes & Memory related functions
 //**************************************
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/hash.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/strutil.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
 
 
 #include <cstddef>   /* size_t */
@@ -98,13 +105,13 @@ typedef struct { long long ll[11]; } XXH64_state_t;
 #include <cstdlib>
 static void* XXH_malloc(size_t s) { return malloc(s); }
 static void  XXH_free  (void* p)  { free(p); }
+#endif  /* OIIO_DOES_NOT_NEED_THESE */
 // for memcpy()
 #include <cstring>
 static void* XXH_memcpy(void* dest, const void* src, size_t size)
 {
     return memcpy(dest,src,size);
 }
-#endif  /* OIIO_DOES_NOT_NEED_THESE */
 
 
 //**************************************
@@ -517,10 +524,9 @@ unsigned long long XXH64 (const void* input, size_t len, unsigned long long seed
 }
 
 
-#ifdef OIIO_DOES_NOT_NEED_THESE
-
 /****************************************************
  *  Advanced Hash Functions
+ *  (OIIO only needs the streaming XXH64, for xxhash::XXH64Hasher)
 ****************************************************/
 
 /*** Allocation ***/
@@ -549,6 +555,7 @@ typedef struct
 } XXH_istate64_t;
 
 
+#ifdef OIIO_DOES_NOT_NEED_THESE
 XXH32_state_t* XXH32_createState(void)
 {
     XXH_STATIC_ASSERT(sizeof(XXH32_state_t) >= sizeof(XXH_istate32_t));   // A compilation error here means XXH32_state_t is not large enough
@@ -587,7 +594,9 @@ XXH_errorcode XXH32_reset(XXH32_state_t* state_in, U32 seed)
     return XXH_OK;
 }
 
-XXH_errorcode XXH64_reset(XXH64_state_t* state_in, unsigned long long seed)
+#endif  /* OIIO_DOES_NOT_NEED_THESE */
+
+static XXH_errorcode XXH64_reset(XXH64_state_t* state_in, unsigned long long seed)
 {
     XXH_istate64_t* state = (XXH_istate64_t*) state_in;
     state->seed = seed;
@@ -601,6 +610,7 @@ XXH_errorcode XXH64_reset(XXH64_state_t* state_in, unsigned long long seed)
 }
 
 
+#ifdef OIIO_DOES_NOT_NEED_THESE
 FORCE_INLINE XXH_errorcode XXH32_update_endian (XXH32_state_t* state_in, const void* input, size_t len, XXH_endianess endian)
 {
     XXH_istate32_t* state = (XXH_istate32_t *) state_in;
@@ -755,6 +765,8 @@ U32 XXH32_digest (const XXH32_state_t* state_in)
 }
 
 
+#endif  /* OIIO_DOES_NOT_NEED_THESE */
+
 FORCE_INLINE XXH_errorcode XXH64_update_endian (XXH64_state_t* state_in, const void* input, size_t len, XXH_endianess endian)
 {
     XXH_istate64_t * state = (XXH_istate64_t *) state_in;
@@ -844,7 +856,7 @@ FORCE_INLINE XXH_errorcode XXH64_update_endian (XXH64_state_t* state_in, const v
     return XXH_OK;
 }
 
-XXH_errorcode XXH64_update (XXH64_state_t* state_in, const void* input, size_t len)
+static XXH_errorcode XXH64_update (XXH64_state_t* state_in, const void* input, size_t len)
 {
     XXH_endianess endian_detected = (XXH_endianess)XXH_CPU_LITTLE_ENDIAN;
 
@@ -938,7 +950,7 @@ FORCE_INLINE U64 XXH64_digest_endian (const XXH64_state_t* state_in, XXH_endiane
 }
 
 
-unsigned long long XXH64_digest (const XXH64_state_t* state_in)
+static unsigned long long XXH64_digest (const XXH64_state_t* state_in)
 {
     XXH_endianess endian_detected = (XXH_endianess)XXH_CPU_LITTLE_ENDIAN;
 
@@ -948,7 +960,72 @@ unsigned long long XXH64_digest (const XXH64_state_t* state_in)
         return XXH64_digest_endian(state_in, XXH_bigEndian);
 }
 
-#endif  /* OIIO_DOES_NOT_NEED_THESE */
+
+
+
+static_assert(sizeof(XXH64_state_t) == sizeof(long long) * 11,
+              "XXH64Hasher state storage does not match XXH64_state_t");
+
+void
+XXH64Hasher::reset(unsigned long long seed)
+{
+    XXH64_reset((XXH64_state_t*)m_state, seed);
+}
+
+
+void
+XXH64Hasher::append(const void* data, size_t size)
+{
+    if (size)
+        XXH64_update((XXH64_state_t*)m_state, data, size);
+}
+
+
+unsigned long long
+XXH64Hasher::digest() const
+{
+    return XXH64_digest((const XXH64_state_t*)m_state);
+}
+
+
+std::string
+XXH64Hasher::hexdigest() const
+{
+    return Strutil::fmt::format("{:016x}", digest());
+}
+
+
+
+bool
+file_hash(string_view filename, unsigned long long& hash, size_t blocksize)
+{
+    uint64_t size = Filesystem::file_size(filename);
+    if (size == uint64_t(-1))
+        return false;
+    blocksize        = std::max(blocksize, size_t(4096));
+    uint64_t nblocks = std::max(uint64_t(1),
+                                (size + blocksize - 1) / blocksize);
+    std::vector<unsigned long long> blockhash(nblocks);
+    std::atomic<bool> ok(true);
+    parallel_for(uint64_t(0), nblocks, [&](uint64_t b) {
+        if (!ok)
+            return;
+        uint64_t pos = b * blocksize;
+        size_t n     = size_t(std::min(uint64_t(blocksize), size - pos));
+        std::unique_ptr<char[]> buf(new char[std::max(n, size_t(1))]);
+        if (Filesystem::read_bytes(filename, buf.get(), n, pos) != n)
+            ok = false;
+        else
+            blockhash[b] = XXH64(buf.get(), n, b);
+    });
+    if (!ok)
+        return false;
+    XXH64Hasher h;
+    h.append(&size, sizeof(size));
+    h.append(cspan<unsigned long long>(blockhash));
+    hash = h.digest();
+    return true;
+}
 
 
 } // namespace xxhash
@@ -36,6 +36,7 @@ using namespace OIIO;
 // Basic runtime options
 static std::string full_command_line;
 static std::vector<std::string> filenames;
+static std::vector<std::string> outputfilenames;  // only for batches
 static std::string outputfilename;
 static bool verbose  = false;
 static bool runstats = false;
@@ -155,6 +156,8 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     int tile[3] = { 64, 64, 1 };  // FIXME if we ever support volume MIPmaps
     std::string compression = "zip";
     bool updatemode         = false;
+    bool update_by_hash     = false;
+    std::string cas_dir;
     bool checknan           = false;
     std::string fixnan;  // none, black, box3
     bool set_full_to_pixels        = false;
@@ -169,11 +172,19 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     Imath::M44f Mcam(0.0f), Mscr(0.0f), MNDC(0.0f);  // Initialize to 0
     bool separate              = false;
     bool nomipmap              = false;
+    bool stream                = false;
+    int forcefloat             = 1;
+    bool linear_average        = false;
+    std::string manifest;
+    int jobs      = 0;
+    int memory_MB = 0;
     bool prman_metadata        = false;
     bool constant_color_detect = false;
     bool monochrome_detect     = false;
     bool opaque_detect         = false;
     bool compute_average       = true;
+    bool tile_stats            = false;
+    std::string autotune;
     int nchannels              = -1;
     bool prman                 = false;
     bool oiio                  = false;
@@ -218,8 +229,18 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
       .help("Output filename");
     ap.arg("--threads %d:NUMTHREADS", &nthreads)
       .help("Number of threads (default: #cores)");
+    ap.arg("--manifest %s:FILENAME", &manifest)
+      .help("Convert all the files listed in a manifest (one \"input [output]\" per line)");
+    ap.arg("--jobs %d:N", &jobs)
+      .help("Max number of files to convert at once (default: 0 = auto)");
+    ap.arg("--memory %d:MB", &memory_MB)
+      .help("Memory budget for the files converted at once (default: 0 = half of RAM)");
     ap.arg("-u", &updatemode)
       .help("Update mode");
+    ap.arg("--update-by-hash", &update_by_hash)
+      .help("Update mode based on a hash of the input contents and options");
+    ap.arg("--cas-dir %s:DIR", &cas_dir)
+      .help("Directory of textures shared by source content hash");
     ap.arg("--format %s:FILEFORMAT", &fileformatname)
       .help("Specify output file format (default: guess from extension)");
     ap.arg("--nchannels %d:N", &nchannels)
@@ -234,6 +255,8 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
       .help("Use planarconfig separate (default: contiguous)");
     ap.arg("--compression %s:NAME", &compression)
       .help("Set the compression method (default = zip, if possible)");
+    ap.arg("--autotune %s:OBJECTIVE", &autotune)
+      .help("Choose tile size and compression by trial encoding (size, speed, balanced)");
     ap.arg("--fovcot %f:FOVCAT", &fovcot)
       .help("Override the frame aspect ratio. Default is width/height.");
     ap.arg("--wrap %s:WRAP", &wrap)
@@ -254,6 +277,12 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
       .help("Sharpen MIP levels (default = 0.0 = no)");
     ap.arg("--nomipmap", &nomipmap)
       .help("Do not make multiple MIP-map levels");
+    ap.arg("--stream", &stream)
+      .help("Stream the MIP levels through bounded memory (for huge images)");
+    ap.arg("--forcefloat %d:BOOL", &forcefloat)
+      .help("Compute MIP levels in float (default: 1; 0 = keep 8/16 bit data type)");
+    ap.arg("--linear-average", &linear_average)
+      .help("Average 8 bit sRGB MIP levels in linear space");
     ap.arg("--checknan", &checknan)
       .help("Check for NaN/Inf values (abort if found)");
     ap.arg("--fixnan %s:STRATEGY", &fixnan)
@@ -298,6 +327,8 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
       .help("Drop alpha channel that is always 1.0");
     ap.arg("--no-compute-average %!", &compute_average)
       .help("Don't compute and store average color");
+    ap.arg("--tile-stats", &tile_stats)
+      .help("Record which tiles are constant, and per-tile alpha coverage");
     ap.arg("--ignore-unassoc", &ignore_unassoc)
       .help("Ignore unassociated alpha tags in input (don't autoconvert)");
     ap.arg("--runstats", &runstats)
@@ -349,6 +380,31 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
 
     // clang-format on
     ap.parse(argc, (const char**)argv);
+    outputfilenames.clear();
+    if (manifest.size()) {
+        // Each manifest line names an input file, optionally followed by
+        // its output file. Blank lines and '#' comments are ignored.
+        std::string contents;
+        if (!Filesystem::read_text_file(manifest, contents)) {
+            std::cerr << "maketx ERROR: Could not read manifest \""
+                      << manifest << "\"\n";
+            exit(EXIT_FAILURE);
+        }
+        std::vector<std::string> ins, outs;
+        for (string_view line : Strutil::splitsv(contents, "\n")) {
+            line = Strutil::strip(line);
+            if (line.empty() || line.front() == '#')
+                continue;
+            auto words = Strutil::splitsv(line);
+            ins.emplace_back(words[0]);
+            outs.emplace_back(words.size() > 1 ? words[1] : string_view());
+        }
+        // Inputs from the command line (if any) come first
+        outputfilenames.assign(filenames.size(), std::string());
+        filenames.insert(filenames.end(), ins.begin(), ins.end());
+        outputfilenames.insert(outputfilenames.end(), outs.begin(),
+                               outs.end());
+    }
     if (filenames.empty()) {
         ap.briefusage();
         std::cout << "\nFor detailed help: maketx --help\n";
@@ -376,9 +432,21 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
         exit(EXIT_FAILURE);
     }
 
-    if (filenames.size() != 1) {
-        std::cerr << "maketx ERROR: requires exactly one input filename\n";
-        exit(EXIT_FAILURE);
+    if (filenames.size() > 1 && outputfilename.size()) {
+        // With several inputs, -o may only name a directory to put all the
+        // outputs in.
+        if (!Filesystem::is_directory(outputfilename)) {
+            std::cerr << "maketx ERROR: with multiple inputs, -o must name "
+                         "a directory\n";
+            exit(EXIT_FAILURE);
+        }
+        outputfilenames.resize(filenames.size());
+        for (size_t i = 0; i < filenames.size(); ++i) {
+            if (outputfilenames[i].empty())
+                outputfilenames[i] = Filesystem::replace_extension(
+                    outputfilename + "/" + Filesystem::filename(filenames[i]),
+                    ".tx");
+        }
     }
 
 
@@ -428,11 +496,22 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     configspec.attribute("maketx:runstats", runstats);
     configspec.attribute("maketx:resize", doresize);
     configspec.attribute("maketx:nomipmap", nomipmap);
+    configspec.attribute("maketx:stream", stream);
+    configspec.attribute("maketx:forcefloat", forcefloat);
+    configspec.attribute("maketx:linear_average", linear_average);
+    configspec.attribute("maketx:jobs", jobs);
+    configspec.attribute("maketx:memory_MB", memory_MB);
     configspec.attribute("maketx:updatemode", updatemode);
+    configspec.attribute("maketx:update_by_hash", update_by_hash);
+    if (cas_dir.size())
+        configspec.attribute("maketx:cas_dir", cas_dir);
     configspec.attribute("maketx:constant_color_detect", constant_color_detect);
     configspec.attribute("maketx:monochrome_detect", monochrome_detect);
     configspec.attribute("maketx:opaque_detect", opaque_detect);
     configspec.attribute("maketx:compute_average", compute_average);
+    configspec.attribute("maketx:tile_stats", tile_stats);
+    if (autotune.size())
+        configspec.attribute("maketx:autotune", autotune);
     configspec.attribute("maketx:unpremult", unpremult);
     configspec.attribute("maketx:incolorspace", incolorspace);
     configspec.attribute("maketx:outcolorspace", outcolorspace);
@@ -546,10 +625,22 @@ main(int argc, char* argv[])
     if (bumpslopesmode)
         mode = ImageBufAlgo::MakeTxBumpWithSlopes;
 
-    bool ok = ImageBufAlgo::make_texture(mode, filenames[0], outputfilename,
-                                         configspec, &std::cout);
-    if (!ok)
-        std::cout << "make_texture ERROR: " << OIIO::geterror() << "\n";
+    bool ok;
+    if (filenames.size() == 1 && outputfilenames.empty()) {
+        ok = ImageBufAlgo::make_texture(mode, filenames[0], outputfilename,
+                                        configspec, &std::cout);
+        if (!ok)
+            std::cout << "make_texture ERROR: " << OIIO::geterror() << "\n";
+    } else {
+        // Many files: convert them all in this one process. Errors were
+        // already reported for each file as it finished.
+        std::vector<std::string> errors;
+        ok = ImageBufAlgo::make_texture_batch(mode, filenames,
+                                              outputfilenames, configspec,
+                                              &std::cout, &errors);
+        if (!ok)
+            std::cout << "maketx ERROR: " << OIIO::geterror() << "\n";
+    }
     if (runstats)
         std::cout << "\n" << ic->getstats();
 
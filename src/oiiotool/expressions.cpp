@@ -4,9 +4,11 @@
 
 
 #include <algorithm>
+#include <mutex>
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 
 #include "oiiotool.h"
 
@@ -45,6 +47,164 @@ parse_function_start_if(string_view& str, string_view name)
 
 
 
+// Retrieve global OIIO attribute `name` as a string. Return false if
+// there is no such attribute.
+static bool
+express_getattribute(string_view name, std::string& result)
+{
+    std::string rs;
+    int ri;
+    float rf;
+    if (OIIO::getattribute(name, rs))
+        result = rs;
+    else if (OIIO::getattribute(name, ri))
+        result = Strutil::to_string(ri);
+    else if (OIIO::getattribute(name, rf))
+        result = Strutil::to_string(rf);
+    else
+        return false;
+    return true;
+}
+
+
+
+// The expansion of FRAME_NUMBER_PAD.
+static std::string
+padded_frame_number(int frame_number, int frame_padding)
+{
+    std::string fmt = frame_padding == 0
+                          ? std::string("{}")
+                          : Strutil::fmt::format("\"{{:0{}d}}\"",
+                                                 frame_padding);
+    return Strutil::fmt::format(fmt, frame_number);
+}
+
+
+
+// Retrieve the named metadata (or one of the special names like
+// "MINCOLOR" or "META") of img into result. Return false if there is no
+// such metadata, which is an error unless using_bracket.
+bool
+Oiiotool::express_metadata(ImageRecRef img, string_view metadata,
+                           bool using_bracket, std::string& result)
+{
+    std::string key = Strutil::fmt::format("{}|{}|{}", (const void*)img.get(),
+                                           using_bracket, metadata);
+    auto memo       = m_expr_metadata.find(key);
+    if (memo != m_expr_metadata.end()) {
+        if (memo->second.first)
+            result = memo->second.second;
+        return memo->second.first;
+    }
+
+    bool ok = true;
+    read(img);
+    ParamValue tmpparam;
+    if (metadata == "nativeformat") {
+        result = img->nativespec(0, 0)->format.c_str();
+    } else if (auto p = img->spec(0, 0)->find_attribute(metadata, tmpparam)) {
+        std::string val = ImageSpec::metadata_val(*p);
+        if (p->type().basetype == TypeDesc::STRING) {
+            // metadata_val returns strings double quoted, strip
+            val.erase(0, 1);
+            val.erase(val.size() - 1, 1);
+        }
+        result = val;
+    } else if (metadata == "filename")
+        result = img->name();
+    else if (metadata == "file_extension")
+        result = Filesystem::extension(img->name());
+    else if (metadata == "file_noextension") {
+        std::string filename = img->name();
+        std::string ext      = Filesystem::extension(img->name());
+        result = filename.substr(0, filename.size() - ext.size());
+    } else if (metadata == "MINCOLOR") {
+        auto pixstat = ImageBufAlgo::computePixelStats((*img)(0, 0));
+        std::stringstream out;
+        for (size_t i = 0; i < pixstat.min.size(); ++i)
+            out << (i ? "," : "") << pixstat.min[i];
+        result = out.str();
+    } else if (metadata == "MAXCOLOR") {
+        auto pixstat = ImageBufAlgo::computePixelStats((*img)(0, 0));
+        std::stringstream out;
+        for (size_t i = 0; i < pixstat.max.size(); ++i)
+            out << (i ? "," : "") << pixstat.max[i];
+        result = out.str();
+    } else if (metadata == "AVGCOLOR") {
+        auto pixstat = ImageBufAlgo::computePixelStats((*img)(0, 0));
+        std::stringstream out;
+        for (size_t i = 0; i < pixstat.avg.size(); ++i)
+            out << (i ? "," : "") << pixstat.avg[i];
+        result = out.str();
+    } else if (metadata == "NONFINITE_COUNT") {
+        auto pixstat    = ImageBufAlgo::computePixelStats((*img)(0, 0));
+        imagesize_t sum = std::accumulate(pixstat.nancount.begin(),
+                                          pixstat.nancount.end(), 0)
+                          + std::accumulate(pixstat.infcount.begin(),
+                                            pixstat.infcount.end(), 0);
+        result = Strutil::to_string(sum);
+    } else if (metadata == "META" || metadata == "METANATIVE") {
+        std::stringstream out;
+        print_info_options opt;
+        opt.verbose   = true;
+        opt.subimages = true;
+        opt.native    = (metadata == "METANATIVE");
+        std::string error;
+        OiioTool::print_info(out, *this, img.get(), opt, error);
+        result = out.str();
+        if (result.size() && result.back() == '\n')
+            result.pop_back();
+    } else if (metadata == "METABRIEF" || metadata == "METANATIVEBRIEF") {
+        std::stringstream out;
+        print_info_options opt;
+        opt.verbose   = false;
+        opt.subimages = false;
+        opt.native    = (metadata == "METANATIVEBRIEF");
+        std::string error;
+        OiioTool::print_info(out, *this, img.get(), opt, error);
+        result = out.str();
+        if (result.size() && result.back() == '\n')
+            result.pop_back();
+    } else if (metadata == "STATS") {
+        std::stringstream out;
+        // OiioTool::print_stats(out, *this, (*img)());
+
+        std::string err;
+        if (!pvt::print_stats(out, "", (*img)(), (*img)().nativespec(), ROI(),
+                              err))
+            errorfmt("stats", "unable to compute: {}", err);
+
+        result = out.str();
+        if (result.size() && result.back() == '\n')
+            result.pop_back();
+    } else if (using_bracket) {
+        // For the TOP[meta] syntax, if the metadata doesn't exist,
+        // return the empty string, and do not make an error.
+        result = "";
+    } else {
+        ok = false;
+    }
+    m_expr_metadata[key] = { ok, ok ? result : std::string() };
+    return ok;
+}
+
+
+
+// The image named by IMG[label]: a labeled image, or else the named file.
+ImageRecRef
+Oiiotool::express_labeled_image(string_view label)
+{
+    auto found = image_labels.find(label);
+    if (found != image_labels.end())
+        return found->second;
+    ImageRecRef& img(m_expr_images[label]);
+    if (!img)
+        img = ImageRecRef(new ImageRec(label, imagecache));
+    return img;
+}
+
+
+
 bool
 Oiiotool::express_parse_atom(const string_view expr, string_view& s,
                              std::string& result)
@@ -94,19 +254,8 @@ Oiiotool::express_parse_atom(const string_view expr, string_view& s,
         else {
             name = Strutil::parse_until(s, ")");
         }
-        if (name.size()) {
-            std::string rs;
-            int ri;
-            float rf;
-            if (OIIO::getattribute(name, rs))
-                result = rs;
-            else if (OIIO::getattribute(name, ri))
-                result = Strutil::to_string(ri);
-            else if (OIIO::getattribute(name, rf))
-                result = Strutil::to_string(rf);
-            else
-                ok = false;
-        }
+        if (name.size() && !express_getattribute(name, result))
+            ok = false;
         return Strutil::parse_char(s, ')') && ok;
     } else if (parse_function_start_if(s, "var")) {
         // "{var(name)}" retrieves user variable `name`
@@ -164,11 +313,7 @@ Oiiotool::express_parse_atom(const string_view expr, string_view& s,
                     img = image_stack[image_stack.size() - index];
             } else {
                 string_view name = Strutil::parse_until(s, "]");
-                auto found       = image_labels.find(name);
-                if (found != image_labels.end())
-                    img = found->second;
-                else
-                    img = ImageRecRef(new ImageRec(name, imagecache));
+                img              = express_labeled_image(name);
                 Strutil::parse_char(s, ']');
             }
         }
@@ -199,99 +344,13 @@ Oiiotool::express_parse_atom(const string_view expr, string_view& s,
                 return false;
             }
         }
-        if (metadata.size()) {
-            read(img);
-            ParamValue tmpparam;
-            if (metadata == "nativeformat") {
-                result = img->nativespec(0, 0)->format.c_str();
-            } else if (auto p = img->spec(0, 0)->find_attribute(metadata,
-                                                                tmpparam)) {
-                std::string val = ImageSpec::metadata_val(*p);
-                if (p->type().basetype == TypeDesc::STRING) {
-                    // metadata_val returns strings double quoted, strip
-                    val.erase(0, 1);
-                    val.erase(val.size() - 1, 1);
-                }
-                result = val;
-            } else if (metadata == "filename")
-                result = img->name();
-            else if (metadata == "file_extension")
-                result = Filesystem::extension(img->name());
-            else if (metadata == "file_noextension") {
-                std::string filename = img->name();
-                std::string ext      = Filesystem::extension(img->name());
-                result = filename.substr(0, filename.size() - ext.size());
-            } else if (metadata == "MINCOLOR") {
-                auto pixstat = ImageBufAlgo::computePixelStats((*img)(0, 0));
-                std::stringstream out;
-                for (size_t i = 0; i < pixstat.min.size(); ++i)
-                    out << (i ? "," : "") << pixstat.min[i];
-                result = out.str();
-            } else if (metadata == "MAXCOLOR") {
-                auto pixstat = ImageBufAlgo::computePixelStats((*img)(0, 0));
-                std::stringstream out;
-                for (size_t i = 0; i < pixstat.max.size(); ++i)
-                    out << (i ? "," : "") << pixstat.max[i];
-                result = out.str();
-            } else if (metadata == "AVGCOLOR") {
-                auto pixstat = ImageBufAlgo::computePixelStats((*img)(0, 0));
-                std::stringstream out;
-                for (size_t i = 0; i < pixstat.avg.size(); ++i)
-                    out << (i ? "," : "") << pixstat.avg[i];
-                result = out.str();
-            } else if (metadata == "NONFINITE_COUNT") {
-                auto pixstat    = ImageBufAlgo::computePixelStats((*img)(0, 0));
-                imagesize_t sum = std::accumulate(pixstat.nancount.begin(),
-                                                  pixstat.nancount.end(), 0)
-                                  + std::accumulate(pixstat.infcount.begin(),
-                                                    pixstat.infcount.end(), 0);
-                result = Strutil::to_string(sum);
-            } else if (metadata == "META" || metadata == "METANATIVE") {
-                std::stringstream out;
-                print_info_options opt;
-                opt.verbose   = true;
-                opt.subimages = true;
-                opt.native    = (metadata == "METANATIVE");
-                std::string error;
-                OiioTool::print_info(out, *this, img.get(), opt, error);
-                result = out.str();
-                if (result.size() && result.back() == '\n')
-                    result.pop_back();
-            } else if (metadata == "METABRIEF"
-                       || metadata == "METANATIVEBRIEF") {
-                std::stringstream out;
-                print_info_options opt;
-                opt.verbose   = false;
-                opt.subimages = false;
-                opt.native    = (metadata == "METANATIVEBRIEF");
-                std::string error;
-                OiioTool::print_info(out, *this, img.get(), opt, error);
-                result = out.str();
-                if (result.size() && result.back() == '\n')
-                    result.pop_back();
-            } else if (metadata == "STATS") {
-                std::stringstream out;
-                // OiioTool::print_stats(out, *this, (*img)());
-
-                std::string err;
-                if (!pvt::print_stats(out, "", (*img)(), (*img)().nativespec(),
-                                      ROI(), err))
-                    errorfmt("stats", "unable to compute: {}", err);
-
-                result = out.str();
-                if (result.size() && result.back() == '\n')
-                    result.pop_back();
-            } else if (using_bracket) {
-                // For the TOP[meta] syntax, if the metadata doesn't exist,
-                // return the empty string, and do not make an error.
-                result = "";
-            } else {
-                express_error(expr, s,
-                              Strutil::fmt::format("unknown attribute name '{}'",
-                                                   metadata));
-                result = orig;
-                return false;
-            }
+        if (metadata.size()
+            && !express_metadata(img, metadata, using_bracket, result)) {
+            express_error(expr, s,
+                          Strutil::fmt::format("unknown attribute name '{}'",
+                                               metadata));
+            result = orig;
+            return false;
         }
     } else if (Strutil::parse_float(s, floatval)) {
         result = Strutil::fmt::format("{:g}", floatval);
@@ -305,11 +364,7 @@ Oiiotool::express_parse_atom(const string_view expr, string_view& s,
     else if (Strutil::parse_identifier_if(s, "FRAME_NUMBER")) {
         result = Strutil::to_string(frame_number);
     } else if (Strutil::parse_identifier_if(s, "FRAME_NUMBER_PAD")) {
-        std::string fmt = frame_padding == 0
-                              ? std::string("{}")
-                              : Strutil::fmt::format("\"{{:0{}d}}\"",
-                                                     frame_padding);
-        result          = Strutil::fmt::format(fmt, frame_number);
+        result = padded_frame_number(frame_number, frame_padding);
     } else if (Strutil::parse_identifier_if(s, "NIMAGES")) {
         result = Strutil::to_string(image_stack_depth());
     } else {
@@ -501,15 +556,414 @@ Oiiotool::express_parse_summands(const string_view expr, string_view& s,
 
 
 
+// An expression compiled to a tree, so that evaluating the same
+// expression again (typically, for each frame of a sequence) needn't parse
+// it again. The tree mirrors the recursive descent of
+// express_parse_summands() and friends, and is evaluated by
+// express_eval(). It covers only the successful evaluations: whenever
+// evaluating it fails, or the interpreter would have parsed the text
+// differently (which depends on whether values turn out to be numbers),
+// express_eval() returns false and the expression is run through the
+// interpreter instead, which also takes care of any error messages. Images
+// and metadata the compiled form already looked up are reused rather than
+// fetched again (see express_metadata).
+struct Oiiotool::ExprNode {
+    enum Kind {
+        Summands,        // kids[0] ops[0] kids[1] ... (factors)
+        Factors,         // kids[0] ops[0] kids[1] ... (atoms)
+        Paren,           // ( kids[0] )
+        GetAttribute,    // getattribute(text)
+        Var,             // var(text)
+        Eq,              // eq(kids[0], kids[1])
+        Neq,             // neq(kids[0], kids[1])
+        Not,             // not(kids[0])
+        Top,             // TOP.text
+        ImgIndex,        // IMG[index].text
+        ImgLabel,        // IMG[label].text
+        Constant,        // number or string literal
+        FrameNumber,     // FRAME_NUMBER
+        FrameNumberPad,  // FRAME_NUMBER_PAD
+        NImages,         // NIMAGES
+        UserVar          // text
+    };
+    Kind kind;
+    bool negative = false;  // atom prefixes
+    bool invert   = false;
+    bool bracket  = false;  // TOP[meta] rather than TOP.meta
+    int index     = 0;
+    std::string text;
+    std::string label;
+    std::vector<std::string> ops;
+    std::vector<ExprNode> kids;
+};
+
+using ExprNode = Oiiotool::ExprNode;
+
+static bool
+compile_summands(string_view& s, ExprNode& node);
+static bool
+compile_atom(string_view& s, ExprNode& node);
+
+
+
+// The rest of "getattribute(name)" or "var(name)", after the paren.
+static bool
+compile_function_name(string_view& s, ExprNode& node)
+{
+    Strutil::skip_whitespace(s);
+    string_view name;
+    if (s.size() && (s.front() == '\"' || s.front() == '\'')) {
+        if (!Strutil::parse_string(s, name))
+            return false;
+    } else {
+        name = Strutil::parse_until(s, ")");
+    }
+    node.text = name;
+    return Strutil::parse_char(s, ')');
+}
+
+
+
+// The rest of "eq(a,b)" or "neq(a,b)", after the paren.
+static bool
+compile_comparison(string_view& s, ExprNode& node)
+{
+    node.kids.resize(2);
+    return compile_atom(s, node.kids[0]) && Strutil::parse_char(s, ',')
+           && compile_atom(s, node.kids[1]) && Strutil::parse_char(s, ')');
+}
+
+
+
+static bool
+compile_atom(string_view& s, ExprNode& node)
+{
+    Strutil::skip_whitespace(s);
+    while (s.size()) {
+        if (Strutil::parse_char(s, '-'))
+            node.negative = !node.negative;
+        else if (Strutil::parse_char(s, '+')) {
+            // no op
+        } else if (Strutil::parse_char(s, '!'))
+            node.invert = !node.invert;
+        else
+            break;
+    }
+
+    float floatval;
+    if (Strutil::parse_char(s, '(')) {
+        node.kind = ExprNode::Paren;
+        node.kids.resize(1);
+        return compile_summands(s, node.kids[0]) && Strutil::parse_char(s, ')');
+    } else if (parse_function_start_if(s, "getattribute")) {
+        node.kind = ExprNode::GetAttribute;
+        return compile_function_name(s, node);
+    } else if (parse_function_start_if(s, "var")) {
+        node.kind = ExprNode::Var;
+        return compile_function_name(s, node);
+    } else if (parse_function_start_if(s, "eq")) {
+        node.kind = ExprNode::Eq;
+        return compile_comparison(s, node);
+    } else if (parse_function_start_if(s, "neq")) {
+        node.kind = ExprNode::Neq;
+        return compile_comparison(s, node);
+    } else if (parse_function_start_if(s, "not")) {
+        node.kind = ExprNode::Not;
+        node.kids.resize(1);
+        return compile_summands(s, node.kids[0]) && Strutil::parse_char(s, ')');
+    } else if (Strutil::starts_with(s, "TOP")
+               || Strutil::starts_with(s, "IMG[")) {
+        if (Strutil::parse_prefix(s, "TOP")) {
+            node.kind = ExprNode::Top;
+        } else {
+            Strutil::parse_prefix(s, "IMG[");
+            if (Strutil::parse_int(s, node.index)) {
+                // The interpreter's handling of an index out of range
+                // depends on the stack depth, so leave that to it.
+                if (!Strutil::parse_char(s, ']') || node.index < 0)
+                    return false;
+                node.kind = ExprNode::ImgIndex;
+            } else {
+                node.kind  = ExprNode::ImgLabel;
+                node.label = Strutil::parse_until(s, "]");
+                Strutil::parse_char(s, ']');
+            }
+        }
+        if (Strutil::parse_char(s, '['))
+            node.bracket = true;
+        else if (!Strutil::parse_char(s, '.'))
+            return false;
+        string_view metadata;
+        if (s.size() && (s.front() == '\"' || s.front() == '\''))
+            Strutil::parse_string(s, metadata);
+        else
+            metadata = Strutil::parse_identifier(s, ":");
+        node.text = metadata;
+        return !node.bracket || Strutil::parse_char(s, ']');
+    } else if (Strutil::parse_float(s, floatval)) {
+        node.kind = ExprNode::Constant;
+        node.text = Strutil::fmt::format("{:g}", floatval);
+    } else if (Strutil::parse_char(s, '\"', true, false)
+               || Strutil::parse_char(s, '\'', true, false)) {
+        string_view r;
+        Strutil::parse_string(s, r);
+        node.kind = ExprNode::Constant;
+        node.text = r;
+    } else if (Strutil::parse_identifier_if(s, "FRAME_NUMBER")) {
+        node.kind = ExprNode::FrameNumber;
+    } else if (Strutil::parse_identifier_if(s, "FRAME_NUMBER_PAD")) {
+        node.kind = ExprNode::FrameNumberPad;
+    } else if (Strutil::parse_identifier_if(s, "NIMAGES")) {
+        node.kind = ExprNode::NImages;
+    } else {
+        string_view id = Strutil::parse_identifier(s, true);
+        if (id.empty())
+            return false;
+        node.kind = ExprNode::UserVar;
+        node.text = id;
+    }
+    return true;
+}
+
+
+
+static bool
+compile_factors(string_view& s, ExprNode& node)
+{
+    node.kind = ExprNode::Factors;
+    node.kids.emplace_back();
+    if (!compile_atom(s, node.kids.back()))
+        return false;
+    while (s.size()) {
+        if (Strutil::parse_char(s, '*'))
+            node.ops.emplace_back("*");
+        else if (Strutil::parse_prefix(s, "//"))
+            node.ops.emplace_back("//");
+        else if (Strutil::parse_char(s, '/'))
+            node.ops.emplace_back("/");
+        else if (Strutil::parse_char(s, '%'))
+            node.ops.emplace_back("%");
+        else
+            break;
+        node.kids.emplace_back();
+        if (!compile_atom(s, node.kids.back()))
+            return false;
+    }
+    return true;
+}
+
+
+
+static bool
+compile_summands(string_view& s, ExprNode& node)
+{
+    node.kind = ExprNode::Summands;
+    node.kids.emplace_back();
+    if (!compile_factors(s, node.kids.back()))
+        return false;
+    while (s.size()) {
+        Strutil::skip_whitespace(s);
+        string_view op = Strutil::parse_while(s, "+-<=>!&|");
+        if (op == "")
+            break;
+        node.ops.emplace_back(op);
+        node.kids.emplace_back();
+        if (!compile_factors(s, node.kids.back()))
+            return false;
+    }
+    return true;
+}
+
+
+
+// Return the compiled form of expression expr, or nullptr if it could not
+// be compiled. Compiling only depends on the text, so the cache is shared
+// by all Oiiotool instances (frame iterations, served jobs).
+static std::shared_ptr<const ExprNode>
+compiled_expression(string_view expr)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const ExprNode>>
+        cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = cache.find(expr);
+    if (found != cache.end())
+        return found->second;
+    auto node     = std::make_shared<ExprNode>();
+    string_view s = expr;
+    if (!compile_summands(s, *node))
+        node.reset();
+    if (cache.size() >= 10000)
+        cache.clear();  // Don't grow without bound in a long-lived server
+    cache.emplace(expr, node);
+    return node;
+}
+
+
+
+bool
+Oiiotool::express_eval(const ExprNode& node, std::string& result)
+{
+    switch (node.kind) {
+    case ExprNode::Summands:
+    case ExprNode::Factors: {
+        bool summands = node.kind == ExprNode::Summands;
+        std::string atom;
+        if (!express_eval(node.kids[0], atom))
+            return false;
+        if (!Strutil::string_is<float>(atom)) {
+            // The interpreter stops at a non-number, leaving any remaining
+            // operators unparsed for its caller to choke on.
+            if (node.ops.size())
+                return false;
+            if (summands && atom.size() >= 2 && atom.front() == '\"'
+                && atom.back() == '\"')
+                atom = atom.substr(1, atom.size() - 2);
+            result = atom;
+            return true;
+        }
+        float lval = Strutil::from_string<float>(atom);
+        for (size_t i = 0; i < node.ops.size(); ++i) {
+            if (!express_eval(node.kids[i + 1], atom)
+                || !Strutil::string_is<float>(atom))
+                return false;
+            float rval = Strutil::from_string<float>(atom);
+            const std::string& op(node.ops[i]);
+            if (op == "*")
+                lval *= rval;
+            else if (op == "/")
+                lval /= rval;
+            else if (op == "//") {
+                int ilval(lval), irval(rval);
+                lval = float(rval ? ilval / irval : 0);
+            } else if (op == "%") {
+                int ilval(lval), irval(rval);
+                lval = float(rval ? ilval % irval : 0);
+            } else if (op == "+")
+                lval += rval;
+            else if (op == "-")
+                lval -= rval;
+            else if (op == "<")
+                lval = (lval < rval) ? 1 : 0;
+            else if (op == ">")
+                lval = (lval > rval) ? 1 : 0;
+            else if (op == "<=")
+                lval = (lval <= rval) ? 1 : 0;
+            else if (op == ">=")
+                lval = (lval >= rval) ? 1 : 0;
+            else if (op == "==")
+                lval = (lval == rval) ? 1 : 0;
+            else if (op == "!=")
+                lval = (lval != rval) ? 1 : 0;
+            else if (op == "<=>")
+                lval = (lval < rval) ? -1 : (lval > rval ? 1 : 0);
+            else if (op == "&&" || op == "&")
+                lval = (lval != 0.0f && rval != 0.0f) ? 1 : 0;
+            else if (op == "||" || op == "|")
+                lval = (lval != 0.0f || rval != 0.0f) ? 1 : 0;
+        }
+        result = Strutil::fmt::format("{:g}", lval);
+        return true;
+    }
+    case ExprNode::GetAttribute:
+        // Like var(), ignores any prefix operators.
+        return node.text.empty() || express_getattribute(node.text, result);
+    case ExprNode::Var:
+        if (node.text.size())
+            result = uservars[node.text];
+        return true;
+    default: break;
+    }
+
+    // The remaining kinds are atoms, which honor prefix operators.
+    switch (node.kind) {
+    case ExprNode::Paren:
+        if (!express_eval(node.kids[0], result))
+            return false;
+        break;
+    case ExprNode::Eq:
+    case ExprNode::Neq: {
+        std::string left, right;
+        if (!express_eval(node.kids[0], left)
+            || !express_eval(node.kids[1], right))
+            return false;
+        result = ((left == right) == (node.kind == ExprNode::Eq)) ? "1" : "0";
+        break;
+    }
+    case ExprNode::Not: {
+        std::string val;
+        if (!express_eval(node.kids[0], val))
+            return false;
+        result = Strutil::eval_as_bool(val) ? "0" : "1";
+        break;
+    }
+    case ExprNode::Top:
+    case ExprNode::ImgIndex:
+    case ExprNode::ImgLabel: {
+        ImageRecRef img;
+        if (node.kind == ExprNode::Top) {
+            img = curimg;
+        } else if (node.kind == ExprNode::ImgIndex) {
+            if (node.index > (int)image_stack.size())
+                return false;
+            img = node.index ? image_stack[image_stack.size() - node.index]
+                             : curimg;
+        } else {
+            img = express_labeled_image(node.label);
+        }
+        if (!img)
+            return false;
+        // STATS may print an error, which must come from the interpreter
+        // only. Computing them dwarfs the parsing anyway.
+        if (node.text == "STATS")
+            return false;
+        if (node.text.size()
+            && !express_metadata(img, node.text, node.bracket, result))
+            return false;
+        break;
+    }
+    case ExprNode::Constant: result = node.text; break;
+    case ExprNode::FrameNumber:
+        result = Strutil::to_string(frame_number);
+        break;
+    case ExprNode::FrameNumberPad:
+        result = padded_frame_number(frame_number, frame_padding);
+        break;
+    case ExprNode::NImages:
+        result = Strutil::to_string(image_stack_depth());
+        break;
+    case ExprNode::UserVar:
+        if (!uservars.contains(node.text))
+            return false;
+        result = uservars[node.text];
+        break;
+    default: return false;
+    }
+    if (node.negative)
+        result = "-" + result;
+    if (node.invert)
+        result = Strutil::eval_as_bool(result) ? "0" : "1";
+    return true;
+}
+
+
+
 // Expression evaluation and substitution for a single expression
 std::string
 Oiiotool::express_impl(string_view s)
 {
     std::string result;
-    string_view orig = s;
-    if (!express_parse_summands(orig, s, result)) {
-        result = orig;
+    auto compiled = compiled_expression(s);
+    if (!compiled || !express_eval(*compiled, result)) {
+        string_view orig = s;
+        result.clear();
+        if (!express_parse_summands(orig, s, result)) {
+            result = orig;
+        }
     }
+    // Images and metadata may change before the next expression.
+    m_expr_images.clear();
+    m_expr_metadata.clear();
     return result;
 }
 
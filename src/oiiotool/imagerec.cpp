@@ -286,6 +286,12 @@ ImageRec::read(ReadPolicy readpolicy, string_view channel_set)
                 = m_imagecache->imagespec(uname, s, m)->image_bytes();
             bool forceread = (s == 0 && m == 0
                               && imgbytes * subimages < 50 * 1024 * 1024);
+            // But if the pixels were already prefetched into the cache,
+            // it's quicker to copy them out of it than to read the file
+            // again.
+            bool copy_from_cache = forceread && (readpolicy & ReadPrefetched);
+            if (copy_from_cache)
+                forceread = false;
             ImageBufRef ib(
                 new ImageBuf(name(), s, m, m_imagecache, configspec()));
 
@@ -338,6 +344,9 @@ ImageRec::read(ReadPolicy readpolicy, string_view channel_set)
             }
 
             bool ok = ib->read(s, m, chbegin, chend, forceread, convert);
+            if (ok && copy_from_cache && !forceread
+                && ib->storage() == ImageBuf::IMAGECACHE)
+                ok = ib->make_writable(true);
             if (ok && post_channel_set_action) {
                 ImageBufRef allchan_buf(new ImageBuf);
                 std::swap(allchan_buf, ib);
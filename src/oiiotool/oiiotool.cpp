@@ -4,8 +4,11 @@
 
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
@@ -36,6 +39,7 @@
 #include <OpenImageIO/simd.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/timer.h>
 
 #ifndef NDEBUG
@@ -72,36 +76,55 @@ using pvt::print_info_options;
         op();                                                        \
     }
 
+// Like OIIOTOOL_OP, for a pointwise op whose lambda works just as well
+// with img[0] and img[1] the same ImageBuf, so that its result may simply
+// overwrite an input image that nothing else refers to.
+#define OIIOTOOL_POINTWISE_OP(name, ninputs, ...)                    \
+    static void action_##name(Oiiotool& ot, cspan<const char*> argv) \
+    {                                                                \
+        if (ot.postpone_callback(ninputs, action_##name, argv))      \
+            return;                                                  \
+        OiiotoolOp op(ot, "-" #name, argv, ninputs, __VA_ARGS__);    \
+        op.reuse_input(true);                                        \
+        op();                                                        \
+    }
+
 // Canned setup for an op that uses one image on the stack.
 #define UNARY_IMAGE_OP(name, impl)                                 \
     OIIOTOOL_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) { \
         return impl(*img[0], *img[1]);                             \
     })
 
+// Canned setup for a pointwise op that uses one image on the stack.
+#define UNARY_POINTWISE_OP(name, impl)                                       \
+    OIIOTOOL_POINTWISE_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) { \
+        return impl(*img[0], *img[1]);                                       \
+    })
+
 // Canned setup for an op that uses two images on the stack.
 #define BINARY_IMAGE_OP(name, impl)                                \
     OIIOTOOL_OP(name, 2, [](OiiotoolOp& op, span<ImageBuf*> img) { \
         return impl(*img[0], *img[1], *img[2]);                    \
     })
 
-// Canned setup for an op that uses one image on the stack and one float
-// on the command line.
-#define BINARY_IMAGE_FLOAT_OP(name, impl)                          \
-    OIIOTOOL_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) { \
-        float val = Strutil::stof(op.args(1));                     \
-        return impl(*img[0], *img[1], val);                        \
+// Canned setup for a pointwise op that uses one image on the stack and
+// one float on the command line.
+#define BINARY_IMAGE_FLOAT_OP(name, impl)                                    \
+    OIIOTOOL_POINTWISE_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) { \
+        float val = Strutil::stof(op.args(1));                               \
+        return impl(*img[0], *img[1], val);                                  \
     })
 
-// Canned setup for an op that uses one image on the stack and one color
-// on the command line.
-#define BINARY_IMAGE_COLOR_OP(name, impl, defaultval)                   \
-    OIIOTOOL_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) {      \
-        int nchans = img[1]->spec().nchannels;                          \
-        std::vector<float> val(nchans, defaultval);                     \
-        int nvals = Strutil::extract_from_list_string(val, op.args(1)); \
-        val.resize(nvals);                                              \
-        val.resize(nchans, val.size() == 1 ? val.back() : defaultval);  \
-        return impl(*img[0], *img[1], val, ROI(), 0);                   \
+// Canned setup for a pointwise op that uses one image on the stack and one
+// color on the command line.
+#define BINARY_IMAGE_COLOR_OP(name, impl, defaultval)                        \
+    OIIOTOOL_POINTWISE_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) { \
+        int nchans = img[1]->spec().nchannels;                               \
+        std::vector<float> val(nchans, defaultval);                          \
+        int nvals = Strutil::extract_from_list_string(val, op.args(1));      \
+        val.resize(nvals);                                                   \
+        val.resize(nchans, val.size() == 1 ? val.back() : defaultval);       \
+        return impl(*img[0], *img[1], val, ROI(), 0);                        \
     })
 
 // Macro to fully set up the "action" function that straightforwardly
@@ -137,6 +160,7 @@ Oiiotool::clear_options()
     dumpdata_showempty = true;
     dumpdata_C         = false;
     hash               = false;
+    hashtype           = "sha1";
     updatemode         = false;
     autoorient         = false;
     autocc             = false;
@@ -370,14 +394,31 @@ Oiiotool::read(ImageRecRef img, ReadPolicy readpolicy, string_view channel_set)
     float pre_ic_time, post_ic_time;
     imagecache->getattribute("stat:fileio_time", pre_ic_time);
     total_readtime.start();
-    if (nativeread)
-        readpolicy = ReadPolicy(readpolicy | ReadNative);
-    bool ok = img->read(readpolicy, channel_set);
+    bool ok = img->read(adjust_read_policy(img, readpolicy), channel_set);
     total_readtime.stop();
     imagecache->getattribute("stat:fileio_time", post_ic_time);
     total_imagecache_readtime += post_ic_time - pre_ic_time;
     total_readtime.add_seconds(pre_ic_time - post_ic_time);
+    return finish_read(img, ok);
+}
+
+
+
+ReadPolicy
+Oiiotool::adjust_read_policy(ImageRecRef img, ReadPolicy readpolicy) const
+{
+    if (nativeread)
+        readpolicy = ReadPolicy(readpolicy | ReadNative);
+    if (prefetched.count(img->name()))
+        readpolicy = ReadPolicy(readpolicy | ReadPrefetched);
+    return readpolicy;
+}
 
+
+
+bool
+Oiiotool::finish_read(ImageRecRef img, bool ok)
+{
     // If this is the first tiled image we have come across, use it to
     // set our tile size (unless the user explicitly set a tile size, or
     // explicitly instructed scanline output).
@@ -504,9 +545,359 @@ Oiiotool::process_pending()
 
 
 
+// A chain of pointwise commands collected by --lazy. The chain reads the
+// pixels of src; result is the image standing in for it on the stack,
+// whose spec is kept current but which has no pixels until
+// materialize_deferred(). The ops are kept as a function that builds the
+// Expr from its source, so that write_deferred() can feed it from a
+// different ImageBuf reading the same pixels.
+struct Oiiotool::DeferredOps {
+    using Chain = std::function<ImageBufAlgo::Expr(const ImageBufAlgo::Expr&)>;
+    ImageRecRef src;
+    ImageRecRef result;
+    Chain chain;
+    std::vector<ColorProcessorHandle> processors;  // used by chain
+    std::string commands;                          // for errors and timing
+
+    DeferredOps(const ImageRecRef& src, const ImageRecRef& result)
+        : src(src)
+        , result(result)
+        , chain([](const ImageBufAlgo::Expr& e) { return e; })
+    {
+    }
+};
+
+
+
+bool
+Oiiotool::defer_pointwise(cspan<const char*> argv)
+{
+    using ImageBufAlgo::Expr;
+    if (!lazy && !m_deferred)
+        return false;
+    string_view command = argv[0];
+    string_view name    = command.substr(0, command.find(':'));
+    while (Strutil::parse_char(name, '-'))
+        ;
+    // Plain -o decides for itself whether it can stream the chain.
+    if (name == "o")
+        return false;
+    static const string_view pointwise[]
+        = { "addc", "cadd", "subc",   "csub",  "mulc",        "cmul",
+            "powc", "cpow", "invert", "clamp", "colorconvert" };
+    ParamValueList options = extract_options(command);
+    bool fusable = lazy && curimg && !allsubimages
+                   && !options.contains("subimages")
+                   && std::find(std::begin(pointwise), std::end(pointwise),
+                                name)
+                          != std::end(pointwise);
+    // Expressions may look at the pixels of the top image, so they need
+    // the chain to be evaluated first.
+    for (const char* arg : argv)
+        fusable &= strchr(arg, '{') == nullptr;
+    bool chaining = fusable && is_deferred(curimg);
+    if (fusable && !chaining) {
+        // Start a new chain, if the top image is one that Expr can read.
+        materialize_deferred();
+        fusable = read() && curimg->subimages() == 1
+                  && curimg->miplevels(0) == 1 && !(*curimg)(0, 0).deep();
+    }
+    if (!fusable) {
+        materialize_deferred();
+        return false;
+    }
+
+    const ImageSpec& spec = *curimg->spec(0, 0);
+    int nchans            = spec.nchannels;
+    DeferredOps::Chain step;
+    ColorProcessorHandle processor;
+    std::string tospace;
+    if (name == "invert") {
+        // Like --invert, only channels [chbegin,chend) are changed, so
+        // write it as x * -1 + 1 on those and x * 1 + 0 on the rest.
+        int chbegin = options.get_int("chbegin", 0);
+        int chend   = options.get_int("chend", std::min(3, nchans));
+        std::vector<float> scale(nchans, 1.0f), offset(nchans, 0.0f);
+        for (int c = std::max(chbegin, 0); c < std::min(chend, nchans); ++c) {
+            scale[c]  = -1.0f;
+            offset[c] = 1.0f;
+        }
+        step = [=](const Expr& e) {
+            return Expr::mad(e, Expr(scale), Expr(offset));
+        };
+    } else if (name == "clamp") {
+        const float big = std::numeric_limits<float>::max();
+        std::vector<float> min(nchans, -big);
+        std::vector<float> max(nchans, big);
+        Strutil::extract_from_list_string(min, options.get_string("min"));
+        Strutil::extract_from_list_string(max, options.get_string("max"));
+        bool clampalpha01 = options.get_int("clampalpha");
+        step = [=](const Expr& e) { return e.clamp(min, max, clampalpha01); };
+    } else if (name == "colorconvert") {
+        std::string fromspace = express(argv[1]);
+        tospace               = express(argv[2]);
+        bool unpremult        = options.get_int("unpremult");
+        if (fromspace == tospace)
+            return true;  // nothing to do, just like the eager version
+        if (fromspace.empty() || fromspace == "current")
+            fromspace = spec.get_string_attribute("oiio:Colorspace", "linear");
+        // Leave the warnings, errors, and non-strict fallback to the usual
+        // code path.
+        if (nchans < 3 || tospace.empty()
+            || (unpremult && spec.get_int_attribute("oiio:UnassociatedAlpha")
+                && spec.alpha_channel >= 0)) {
+            materialize_deferred();
+            return false;
+        }
+        processor = colorconfig().createColorProcessor(
+            colorconfig().resolve(fromspace), colorconfig().resolve(tospace),
+            options.get_string("key"), options.get_string("value"));
+        if (!processor) {
+            colorconfig().geterror();  // will be reported again by the op
+            materialize_deferred();
+            return false;
+        }
+        const ColorProcessor* p = processor.get();
+        step = [=](const Expr& e) { return e.colorconvert(p, unpremult); };
+    } else {
+        // --addc, --subc, --mulc, --powc, with their arguments filled out
+        // to all channels exactly as BINARY_IMAGE_COLOR_OP does.
+        bool mul   = name == "mulc" || name == "cmul";
+        bool pow   = name == "powc" || name == "cpow";
+        bool add   = name == "addc" || name == "cadd";
+        float dflt = mul || pow ? 1.0f : 0.0f;
+        std::vector<float> val(nchans, dflt);
+        int nvals = Strutil::extract_from_list_string(val, express(argv[1]));
+        val.resize(nvals);
+        val.resize(nchans, val.size() == 1 ? val.back() : dflt);
+        step = [=](const Expr& e) {
+            return pow   ? e.pow(val)
+                   : mul ? e * Expr(val)
+                   : add ? e + Expr(val)
+                         : e - Expr(val);
+        };
+    }
+
+    if (!chaining) {
+        // The stand-in for the result gets the spec now, and pixels only
+        // when they are needed.
+        ImageRecRef src = curimg;
+        ImageRecRef result(new ImageRec(src->name(), 1));
+        *result->spec(0, 0) = spec;
+        result->pixels_modified(true);
+        m_deferred = std::make_shared<DeferredOps>(src, result);
+        pop();
+        push(result);
+    }
+    DeferredOps::Chain prev = std::move(m_deferred->chain);
+    m_deferred->chain       = [prev, step](const Expr& e) {
+        return step(prev(e));
+    };
+    if (processor)
+        m_deferred->processors.push_back(processor);
+    if (!tospace.empty()) {
+        curimg->spec(0, 0)->set_colorspace(tospace);
+        curimg->metadata_modified(true);
+    }
+    if (m_deferred->commands.size())
+        m_deferred->commands += ' ';
+    m_deferred->commands += command;
+    if (debug)
+        print("Deferring '{}'\n", command);
+    return true;
+}
+
+
+
+bool
+Oiiotool::materialize_deferred()
+{
+    if (!m_deferred)
+        return true;
+    std::shared_ptr<DeferredOps> deferred = std::move(m_deferred);
+    m_deferred.reset();
+    OTScopedTimer timer(*this, "-lazy");
+    ImageBuf& dst = (*deferred->result)(0, 0);
+    dst.reset(*deferred->result->spec(0, 0), InitializePixels::No);
+    bool ok = deferred->chain(ImageBufAlgo::Expr((*deferred->src)(0, 0)))
+                  .eval(dst);
+    if (!ok)
+        errorfmt(deferred->commands, "{}", dst.geterror());
+    deferred->result->update_spec_from_imagebuf(0, 0);
+    if (debug)
+        print("    fused '{}' in one pass\n", deferred->commands);
+    return ok;
+}
+
+
+
+bool
+Oiiotool::is_deferred(const ImageRecRef& img) const
+{
+    return m_deferred && img && m_deferred->result == img;
+}
+
+
+
+bool
+Oiiotool::can_stream(const ImageRecRef& img) const
+{
+    if (!img || img->subimages() != 1 || img->miplevels(0) != 1)
+        return false;
+    bool deferred       = is_deferred(img);
+    const ImageBuf& src = (*(deferred ? m_deferred->src : img))(0, 0);
+    if (src.deep() || src.spec().depth != 1)
+        return false;
+    return deferred
+           || (lazy && src.storage() == ImageBuf::IMAGECACHE
+               && src.nativespec().tile_width == 0);
+}
+
+
+
+bool
+Oiiotool::write_streamed(string_view command, const ImageRecRef& img,
+                         ImageOutput* out, const ColorProcessor* processor,
+                         bool unpremult)
+{
+    using ImageBufAlgo::Expr;
+    OIIO_DASSERT(can_stream(img));
+    bool deferred            = is_deferred(img);
+    const ImageRecRef& src   = deferred ? m_deferred->src : img;
+    const ImageSpec& outspec = out->spec();
+    ImageSpec bandspec       = *img->spec(0, 0);
+    bandspec.set_format(TypeFloat);
+    bandspec.channelformats.clear();
+    int nchans = bandspec.nchannels;
+
+    // Bands of about 64 MB (like ImageBuf::write), whole tiles high.
+    const imagesize_t budget = imagesize_t(64) << 20;
+    imagesize_t rowbytes     = std::max(imagesize_t(1),
+                                        imagesize_t(outspec.width) * nchans
+                                            * sizeof(float));
+    int band = clamp(round_to_multiple(int(budget / rowbytes), 64), 1, 1024);
+    if (outspec.tile_width)
+        band = round_to_multiple(band, std::max(1, outspec.tile_height));
+    float cachemb = clamp(4.0f * float(band * rowbytes) / float(1 << 20),
+                          256.0f, float(std::max(cachesize, 256)));
+
+    // Through the shared ImageCache, an untiled file is a single "tile" of
+    // the whole image, so a big one would end up entirely resident. Read
+    // it through a private cache of virtual tiles instead, each row of
+    // tiles taking just one pass over the scanlines.
+    const ImageBuf* srcbuf = &(*src)(0, 0);
+    std::shared_ptr<ImageCache> srccache;
+    std::unique_ptr<ImageBuf> tiledsrc;
+    if (srcbuf->storage() == ImageBuf::IMAGECACHE
+        && srcbuf->nativespec().tile_width == 0
+        && srcbuf->spec().image_pixels() * nchans * sizeof(float)
+               > imagesize_t(cachemb) << 20) {
+        srccache.reset(ImageCache::create(false),
+                       [](ImageCache* ic) { ImageCache::destroy(ic); });
+        srccache->attribute("max_memory_MB", cachemb);
+        srccache->attribute("autotile", 64);
+        srccache->attribute("autoscanline", 0);
+        srccache->attribute("forcefloat", 1);
+        tiledsrc.reset(new ImageBuf(srcbuf->name(), srcbuf->subimage(),
+                                    srcbuf->miplevel(), srccache.get(),
+                                    src->configspec()));
+        srcbuf = tiledsrc.get();
+    }
+    Expr expr = deferred ? m_deferred->chain(Expr(*srcbuf)) : Expr(*srcbuf);
+    bool fold = processor && nchans >= 3;
+    if (fold)
+        expr = expr.colorconvert(processor, unpremult);
+    if (debug)
+        print("    streaming {} in bands of {} scanlines\n", img->name(),
+              band);
+
+    // Special handling for flipped vertical scanline order, as in
+    // ImageBuf::write().
+    const bool isDecreasingY = !strcmp(out->format_name(), "openexr")
+                               && outspec.get_string_attribute(
+                                      "openexr:lineOrder")
+                                      == "decreasingY";
+    int nbands = (outspec.height + band - 1) / band;
+    std::vector<float> bufs[2];
+    std::future<bool> writing;  // the previous band, in the background
+    bool ok = true, wrote = true;
+    for (int b = 0; b < nbands; ++b) {
+        int y    = outspec.y + (isDecreasingY ? nbands - 1 - b : b) * band;
+        int yend = std::min(y + band, outspec.y + outspec.height);
+        ROI roi(outspec.x, outspec.x + outspec.width, y, yend, outspec.z,
+                outspec.z + 1, 0, nchans);
+        ImageSpec spec = bandspec;
+        set_roi(spec, roi);
+        // Alternate between two buffers: the one being written belongs to
+        // the previous band.
+        std::vector<float>& buf = bufs[b & 1];
+        buf.resize(roi.npixels() * nchans);
+        ImageBuf bandbuf(spec, buf.data());
+        ok = expr.eval(bandbuf, roi);
+        if (ok && processor && !fold)
+            ok = ImageBufAlgo::colorconvert(bandbuf, bandbuf, processor,
+                                            unpremult);
+        if (!ok) {
+            errorfmt(command, "{}", bandbuf.geterror());
+            break;
+        }
+        if (writing.valid() && !(wrote = writing.get()))
+            break;
+        const float* data = buf.data();
+        writing = default_thread_pool()->push([=, &outspec](int /*id*/) {
+            return outspec.tile_width
+                       ? out->write_tiles(roi.xbegin, roi.xend, roi.ybegin,
+                                          roi.yend, roi.zbegin, roi.zend,
+                                          TypeFloat, data)
+                       : out->write_scanlines(roi.ybegin, roi.yend,
+                                              roi.zbegin, TypeFloat, data);
+        });
+        check_peak_memory();
+    }
+    if (writing.valid())
+        wrote &= writing.get();
+    if (!wrote)
+        errorfmt(command, "{}", out->geterror());
+    return ok && wrote;
+}
+
+
+
+void
+Oiiotool::finish_async_writes(string_view filename)
+{
+    for (auto w = async_writes.begin(); w != async_writes.end();) {
+        if (filename.size() && w->filename != filename) {
+            ++w;
+            continue;
+        }
+        std::string err = w->result.get();
+        if (err.empty()
+            && !Filesystem::rename(w->tmpfilename, w->filename, err))
+            err = Strutil::fmt::format("could not move temp file {}: {}",
+                                       w->tmpfilename, err);
+        if (err.size()) {
+            errorfmt("-o", "Could not write {}: {}", w->filename, err);
+            Filesystem::remove(w->tmpfilename);
+        }
+        // Forget anything the cache saw of the file before it was done
+        imagecache->invalidate(ustring(w->filename), true);
+        w = async_writes.erase(w);
+    }
+}
+
+
+
+// Keeps the lines of messages from concurrently running ops (or frames)
+// from interleaving.
+static std::mutex message_mutex;
+
+
+
 void
 Oiiotool::error(string_view command, string_view explanation) const
 {
+    std::lock_guard<std::mutex> lock(message_mutex);
     auto& errstream(nostderr ? std::cout : std::cerr);
     errstream << "oiiotool ERROR";
     if (command.size())
@@ -531,6 +922,7 @@ Oiiotool::error(string_view command, string_view explanation) const
 void
 Oiiotool::warning(string_view command, string_view explanation) const
 {
+    std::lock_guard<std::mutex> lock(message_mutex);
     auto& errstream(nostderr ? std::cout : std::cerr);
     errstream << "oiiotool WARNING";
     if (command.size())
@@ -2161,9 +2553,10 @@ static void
 set_colorconfig(Oiiotool& ot, cspan<const char*> argv)
 {
     OIIO_DASSERT(argv.size() == 2);
-    ot.colorconfig.reset(argv[1]);
-    if (ot.colorconfig.has_error()) {
-        ot.errorfmt("--colorconfig", "{}", ot.colorconfig.geterror());
+    // Replace rather than reset, since the config may be shared.
+    ot.colorconfig_ref = std::make_shared<ColorConfig>(argv[1]);
+    if (ot.colorconfig().has_error()) {
+        ot.errorfmt("--colorconfig", "{}", ot.colorconfig().geterror());
     }
 }
 
@@ -2248,7 +2641,7 @@ public:
         }
         bool ok = ImageBufAlgo::colorconvert(*img[0], *img[1], fromspace,
                                              tospace, unpremult, contextkey,
-                                             contextvalue, &ot.colorconfig);
+                                             contextvalue, &ot.colorconfig());
         if (!ok && !strict) {
             // The color transform failed, but we were told not to be
             // strict, so ignore the error and just copy destination to
@@ -2285,7 +2678,7 @@ action_tocolorspace(Oiiotool& ot, cspan<const char*> argv)
 
 
 // --ccmatrix
-OIIOTOOL_OP(ccmatrix, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
+OIIOTOOL_POINTWISE_OP(ccmatrix, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
     bool unpremult = op.options().get_int("unpremult");
     auto M         = Strutil::extract_from_list_string<float>(op.args(1));
     Imath::M44f MM;
@@ -2323,7 +2716,7 @@ OIIOTOOL_OP(ociolook, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
         tospace = img[1]->spec().get_string_attribute("oiio:Colorspace");
     return ImageBufAlgo::ociolook(*img[0], *img[1], lookname, fromspace,
                                   tospace, unpremult, inverse, contextkey,
-                                  contextvalue, &ot.colorconfig);
+                                  contextvalue, &ot.colorconfig());
 });
 
 
@@ -2342,7 +2735,8 @@ OIIOTOOL_OP(ociodisplay, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
         fromspace = img[1]->spec().get_string_attribute("oiio:Colorspace");
     return ImageBufAlgo::ociodisplay(*img[0], *img[1], displayname, viewname,
                                      fromspace, looks, unpremult, inverse,
-                                     contextkey, contextvalue, &ot.colorconfig);
+                                     contextkey, contextvalue,
+                                     &ot.colorconfig());
 });
 
 
@@ -2353,7 +2747,7 @@ OIIOTOOL_OP(ociofiletransform, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
     bool inverse     = op.options().get_int("inverse");
     bool unpremult   = op.options().get_int("unpremult");
     return ImageBufAlgo::ociofiletransform(*img[0], *img[1], name, unpremult,
-                                           inverse, &ot.colorconfig);
+                                           inverse, &ot.colorconfig());
 });
 
 
@@ -3022,13 +3416,13 @@ BINARY_IMAGE_COLOR_OP(absdiffc, ImageBufAlgo::absdiff, 0);  // --absdiffc
 BINARY_IMAGE_COLOR_OP(powc, ImageBufAlgo::pow, 1.0f);       // --powc
 BINARY_IMAGE_FLOAT_OP(saturate, ImageBufAlgo::saturate);    // --saturate
 
-UNARY_IMAGE_OP(abs, ImageBufAlgo::abs);  // --abs
+UNARY_POINTWISE_OP(abs, ImageBufAlgo::abs);  // --abs
 
-UNARY_IMAGE_OP(premult, ImageBufAlgo::premult);      // --premult
-UNARY_IMAGE_OP(repremult, ImageBufAlgo::repremult);  // --repremult
+UNARY_POINTWISE_OP(premult, ImageBufAlgo::premult);      // --premult
+UNARY_POINTWISE_OP(repremult, ImageBufAlgo::repremult);  // --repremult
 
 // --unpremult
-OIIOTOOL_OP(unpremult, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
+OIIOTOOL_POINTWISE_OP(unpremult, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
     if (img[1]->spec().get_int_attribute("oiio:UnassociatedAlpha")
         && img[1]->spec().alpha_channel >= 0) {
         ot.warning(
@@ -3046,13 +3440,13 @@ OIIOTOOL_OP(mad, 3, [&](OiiotoolOp& op, span<ImageBuf*> img) {
 
 
 // --invert
-OIIOTOOL_OP(invert, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
+OIIOTOOL_POINTWISE_OP(invert, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
     ROI roi = img[1]->roi();
     // By default, we only invert channels [0,3), but this can be overridden
     // by optional modifiers chbegin and chend.
     int chbegin = op.options().get_int("chbegin", 0);
     int chend   = op.options().get_int("chend", std::min(3, roi.chend));
-    if (roi.chbegin < chbegin || roi.chend > chend) {
+    if ((roi.chbegin < chbegin || roi.chend > chend) && img[0] != img[1]) {
         // If the image has channels beyond what we're inverting, start by
         // copying src to dst first, so we dont lose channels along the way.
         ImageBufAlgo::copy(*img[0], *img[1]);
@@ -3964,6 +4358,7 @@ public:
         std::string filtername = options()["filter"];
         bool highlightcomp     = options().get_int("highlightcomp");
         bool edgeclamp         = options().get_int("edgeclamp");
+        int usemip             = options().get_int("usemip");
         bool ok                = true;
         ImageBuf tmpimg;
         ImageBuf* src = img[1];
@@ -3979,7 +4374,9 @@ public:
                                      filtername, 0.0f, false,
                                      ImageBuf::WrapDefault, edgeclamp);
         else
-            ok &= ImageBufAlgo::resize(*img[0], *src, filtername, 0.0f,
+            ok &= ImageBufAlgo::resize(*img[0], *src,
+                                       { { "filtername", filtername },
+                                         { "usemip", usemip } },
                                        img[0]->roi());
         if (highlightcomp && ok) {
             // re-expand the range in place
@@ -4538,52 +4935,161 @@ action_mosaic(Oiiotool& ot, cspan<const char*> argv)
         ot.push(blank_img);
     }
 
-    int widest = 0, highest = 0, nchannels = 0;
-    TypeDesc outtype = TypeUnknown;
     std::vector<ImageRecRef> images(nimages);
-    for (int i = nimages - 1; i >= 0; --i) {
-        ImageRecRef img = ot.pop();
-        images[i]       = img;
-        ot.read(img);
-        widest    = std::max(widest, img->spec()->full_width);
-        highest   = std::max(highest, img->spec()->full_height);
-        nchannels = std::max(nchannels, img->spec()->nchannels);
-        outtype   = TypeDesc::basetype_merge(outtype, img->spec()->format);
-    }
+    for (int i = nimages - 1; i >= 0; --i)
+        images[i] = ot.pop();
 
     auto options = ot.extract_options(command);
     int pad      = options.get_int("pad");
-
+    bool reduce  = options.get_int("reduce", 1);
+    int fitw = 0, fith = 0;
     std::string fit = options["fit"];
-    if (fit.size()) {
-        int fitw = 0, fith = 0;
-        if (scan_resolution(fit, fitw, fith) && fitw >= 1 && fith >= 1) {
-            widest  = fitw;
-            highest = fith;
-            // Do the equivalent of a --fit on each image
-            const char* fitargs[] = { "--fit:allsubimages=0:pad=1",
-                                      fit.c_str() };
-            for (int i = 0; i < nimages; ++i) {
-                ot.push(images[i]);
-                action_fit(ot, fitargs);
-                images[i] = ot.pop();
+    if (fit.size()
+        && !(scan_resolution(fit, fitw, fith) && fitw >= 1 && fith >= 1))
+        fitw = fith = 0;
+
+    // Each cell is an input (possibly shared with other cells) and, when
+    // fitting, the fitted image that gets pasted. When a cell will be
+    // shrunk, we read it at the smallest MIP level or JPEG DCT reduction
+    // that is still at least as big as the cell, instead of reading the
+    // whole image only to throw most of it away.
+    struct Cell {
+        ImageRecRef img;
+        int reduced_miplevel = -1;  // >= 0: read this MIP level directly
+        int jpeg_reduce      = 0;   // > 0: read with this "jpeg:reduce"
+        ImageBuf src;               // the reduced read, if any
+        ImageBuf fitted;            // the fitted cell, if fitting
+        bool ok = true;
+    };
+    std::vector<Cell> cells(nimages);
+    std::vector<ImageRecRef> fullreads;
+    for (int i = 0; i < nimages; ++i) {
+        Cell& cell(cells[i]);
+        cell.img = images[i];
+        if (!ot.read_nativespec(cell.img))
+            return;
+        const ImageSpec* spec = cell.img->spec(0, 0);
+        if (fitw && reduce && !cell.img->elaborated()
+            && !cell.img->configspec() && !cell.img->input_dataformat()
+            && !spec->deep) {
+            float scale = std::min(float(fitw) / spec->full_width,
+                                   float(fith) / spec->full_height);
+            int wantw   = int(ceilf(spec->full_width * scale));
+            int wanth   = int(ceilf(spec->full_height * scale));
+            for (int m = cell.img->miplevels(0) - 1; m > 0; --m) {
+                const ImageSpec* mspec = cell.img->spec(0, m);
+                if (mspec->full_width >= wantw && mspec->full_height >= wanth) {
+                    cell.reduced_miplevel = m;
+                    break;
+                }
+            }
+            if (cell.reduced_miplevel < 0
+                && (*cell.img)(0, 0).file_format_name() == "jpeg") {
+                for (int r = 3; r > 0 && !cell.jpeg_reduce; --r) {
+                    int d = 1 << r;
+                    if ((spec->full_width + d - 1) / d >= wantw
+                        && (spec->full_height + d - 1) / d >= wanth)
+                        cell.jpeg_reduce = r;
+                }
+            }
+        }
+        if (cell.reduced_miplevel < 0 && !cell.jpeg_reduce
+            && !cell.img->elaborated()
+            && std::find(fullreads.begin(), fullreads.end(), cell.img)
+                   == fullreads.end())
+            fullreads.push_back(cell.img);
+    }
+
+    // Read all the inputs at once, then fit all the cells at once.
+    std::vector<char> fullread_ok(fullreads.size());
+    ot.total_readtime.start();
+    parallel_for(0, int(fullreads.size()) + nimages, [&](int64_t i) {
+        if (i < int64_t(fullreads.size())) {
+            ImageRecRef img = fullreads[i];
+            fullread_ok[i] = img->read(ot.adjust_read_policy(img,
+                                                             ReadDefault));
+            return;
+        }
+        Cell& cell(cells[i - fullreads.size()]);
+        if (cell.reduced_miplevel < 0 && !cell.jpeg_reduce)
+            return;
+        TypeDesc fmt = ot.nativeread ? cell.img->spec(0, 0)->format
+                                     : TypeFloat;
+        if (cell.jpeg_reduce) {
+            ImageSpec config;
+            config.attribute("jpeg:reduce", cell.jpeg_reduce);
+            cell.src.reset(cell.img->name(), 0, 0, nullptr, &config);
+            cell.ok = cell.src.read(0, 0, true, fmt);
+        } else {
+            cell.src.reset(cell.img->name(), 0, cell.reduced_miplevel,
+                           ot.imagecache);
+            cell.ok = cell.src.read(0, cell.reduced_miplevel, true, fmt);
+        }
+    });
+    ot.total_readtime.stop();
+    for (size_t i = 0; i < fullreads.size(); ++i)
+        if (!ot.finish_read(fullreads[i], fullread_ok[i]))
+            return;
+    for (auto& cell : cells) {
+        if (!cell.ok) {
+            ot.error(command, ot.format_read_error(cell.img->name(),
+                                                   cell.src.geterror()));
+            return;
+        }
+    }
+
+    if (fitw) {
+        parallel_for(0, nimages, [&](int64_t i) {
+            Cell& cell(cells[i]);
+            const ImageBuf& src(cell.src.initialized() ? cell.src
+                                                       : (*cell.img)(0, 0));
+            const ImageSpec* full = cell.img->spec(0, 0);
+            ImageSpec newspec     = src.spec();
+            newspec.width = newspec.full_width = fitw;
+            newspec.height = newspec.full_height = fith;
+            newspec.x = newspec.full_x = full->full_x;
+            newspec.y = newspec.full_y = full->full_y;
+            cell.fitted.reset(newspec);
+            cell.ok = ImageBufAlgo::fit(cell.fitted, src, "", 0.0f, "", false);
+        });
+        for (auto& cell : cells) {
+            if (!cell.ok) {
+                ot.error(command, cell.fitted.geterror());
+                return;
             }
         }
     }
 
+    int widest = fitw, highest = fith, nchannels = 0;
+    TypeDesc outtype = TypeUnknown;
+    for (auto& cell : cells) {
+        const ImageSpec& spec(fitw ? cell.fitted.spec()
+                                   : *cell.img->spec(0, 0));
+        if (!fitw) {
+            widest  = std::max(widest, spec.full_width);
+            highest = std::max(highest, spec.full_height);
+        }
+        nchannels = std::max(nchannels, spec.nchannels);
+        outtype   = TypeDesc::basetype_merge(outtype, spec.format);
+    }
+
     ImageSpec Rspec(ximages * widest + (ximages - 1) * pad,
                     yimages * highest + (yimages - 1) * pad, nchannels,
                     outtype);
     ImageRecRef R(new ImageRec("mosaic", Rspec, ot.imagecache));
     ot.push(R);
 
+    // A fitted cell's data window is exactly its fitw x fith display
+    // window, so it pastes straight into place.
     ImageBufAlgo::zero((*R)());
     for (int j = 0; j < yimages; ++j) {
         int y = j * (highest + pad);
         for (int i = 0; i < ximages; ++i) {
-            int x   = i * (widest + pad);
+            int x = i * (widest + pad);
+            Cell& cell(cells[j * ximages + i]);
             bool ok = ImageBufAlgo::paste((*R)(), x, y, 0, 0,
-                                          (*images[j * ximages + i])(0));
+                                          fitw ? cell.fitted
+                                               : (*cell.img)(0));
             if (!ok) {
                 ot.error(command, (*R)().geterror());
                 return;
@@ -4746,13 +5252,15 @@ action_clamp(Oiiotool& ot, cspan<const char*> argv)
 
 
 // --rangecompress
-OIIOTOOL_OP(rangecompress, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
-    bool useluma = op.options().get_int("luma");
-    return ImageBufAlgo::rangecompress(*img[0], *img[1], useluma);
-});
+OIIOTOOL_POINTWISE_OP(rangecompress, 1,
+                      [&](OiiotoolOp& op, span<ImageBuf*> img) {
+                          bool useluma = op.options().get_int("luma");
+                          return ImageBufAlgo::rangecompress(*img[0], *img[1],
+                                                             useluma);
+                      });
 
 // --rangeexpand
-OIIOTOOL_OP(rangeexpand, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
+OIIOTOOL_POINTWISE_OP(rangeexpand, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
     bool useluma = op.options().get_int("luma");
     return ImageBufAlgo::rangeexpand(*img[0], *img[1], useluma);
 });
@@ -4904,7 +5412,8 @@ input_file(Oiiotool& ot, cspan<const char*> argv)
     for (int i = 0; i < argv.size(); i++) {  // FIXME: this loop is pointless
         OTScopedTimer timer(ot, command);
         string_view filename = ot.express(argv[i]);
-        auto found           = ot.image_labels.find(filename);
+        ot.finish_async_writes(filename);  // in case we're reading it back
+        auto found = ot.image_labels.find(filename);
         if (found != ot.image_labels.end()) {
             if (ot.debug)
                 std::cout << "Referencing labeled image " << filename << "\n";
@@ -5029,7 +5538,7 @@ input_file(Oiiotool& ot, cspan<const char*> argv)
         if (autocc) {
             // Try to deduce the color space it's in
             std::string colorspace(
-                ot.colorconfig.getColorSpaceFromFilepath(filename));
+                ot.colorconfig().getColorSpaceFromFilepath(filename));
             if (colorspace.size() && ot.debug)
                 print("  From {}, we deduce color space \"{}\"\n", filename,
                       colorspace);
@@ -5041,9 +5550,9 @@ input_file(Oiiotool& ot, cspan<const char*> argv)
                     print("  Metadata of {} indicates color space \"{}\"\n",
                           colorspace, filename);
             }
-            std::string linearspace = ot.colorconfig.resolve("linear");
+            std::string linearspace = ot.colorconfig().resolve("linear");
             if (colorspace.size()
-                && !ot.colorconfig.equivalent(colorspace, linearspace)) {
+                && !ot.colorconfig().equivalent(colorspace, linearspace)) {
                 std::string cmd = "colorconvert:strict=0";
                 if (autoccunpremult)
                     cmd += ":unpremult=1";
@@ -5087,6 +5596,7 @@ prep_texture_config(Oiiotool& ot, ImageSpec& configspec,
     configspec.attribute("maketx:runstats", ot.runstats);
     configspec.attribute("maketx:resize", fileoptions.get_int("resize"));
     configspec.attribute("maketx:nomipmap", fileoptions.get_int("nomipmap"));
+    configspec.attribute("maketx:stream", fileoptions.get_int("stream"));
     configspec.attribute("maketx:updatemode",
                          fileoptions.get_int("updatemode"));
     configspec.attribute("maketx:constant_color_detect",
@@ -5185,6 +5695,13 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
     bool do_shad       = Strutil::starts_with(stripped_command, "oshad");
     bool do_bumpslopes = Strutil::starts_with(stripped_command, "obump");
 
+    // A chain deferred by --lazy may be streamed to a plain image file as
+    // it's written (see write_streamed() below). Anything else needs its
+    // pixels now, as do the automatic transformations further down.
+    if (do_tex || do_latlong || do_bumpslopes || fileoptions.contains("all")
+        || fileoptions.get_int("async"))
+        ot.materialize_deferred();
+
     if (ot.debug)
         std::cout << "Output: " << filename << "\n";
     if (!ot.curimg.get()) {
@@ -5278,6 +5795,7 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
                                    chanlist.c_str() };
             void action_channels(Oiiotool & ot,
                                  cspan<const char*> argv);  // forward decl
+            ot.materialize_deferred();
             action_channels(ot, argv);
             ir = ot.curimg;
         }
@@ -5286,6 +5804,7 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
     // Handle --autotrim
     int autotrim = fileoptions.get_int("autotrim", ot.output_autotrim);
     if (supports_displaywindow && autotrim) {
+        ot.materialize_deferred();
         ROI roi           = nonzero_region_all_subimages(ir);
         bool crops_needed = false;
         for (int s = 0; s < ir->subimages(); ++s)
@@ -5317,6 +5836,7 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
         const char* argv[] = { "croptofull:allsubimages=1" };
         void action_croptofull(Oiiotool & ot,
                                cspan<const char*> argv);  // forward decl
+        ot.materialize_deferred();
         action_croptofull(ot, argv);
         ir = ot.curimg;
     }
@@ -5327,12 +5847,12 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
     // automatically set -d based on the name if --autocc is used.
     bool autocc          = fileoptions.get_int("autocc", ot.autocc);
     bool autoccunpremult = fileoptions.get_int("unpremult", ot.autoccunpremult);
-    std::string outcolorspace = ot.colorconfig.getColorSpaceFromFilepath(
+    std::string outcolorspace = ot.colorconfig().getColorSpaceFromFilepath(
         filename);
     if (autocc && outcolorspace.size()) {
         TypeDesc type;
         int bits;
-        type = ot.colorconfig.getColorSpaceDataType(outcolorspace, &bits);
+        type = ot.colorconfig().getColorSpaceDataType(outcolorspace, &bits);
         if (type.basetype != TypeDesc::UNKNOWN) {
             if (ot.debug)
                 std::cout << "  Deduced data type " << type << " (" << bits
@@ -5350,7 +5870,7 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
         }
     }
     if (autocc) {
-        string_view linearspace = ot.colorconfig.resolve("linear");
+        string_view linearspace = ot.colorconfig().resolve("linear");
         std::string currentspace
             = ir->spec()->get_string_attribute("oiio:ColorSpace", linearspace);
         // Special cases where we know formats should be particular color
@@ -5375,8 +5895,41 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
                 cmd += ":unpremult=1";
             const char* argv[] = { cmd.c_str(), currentspace.c_str(),
                                    outcolorspace.c_str() };
+            ot.materialize_deferred();
+            action_colorconvert(ot, argv);
+            ir = ot.curimg;
+        }
+    }
+
+    // Handle -o:colorconvert=: transform the pixels as they are written,
+    // rather than in a separate pass over the whole image. (Textures are
+    // built from the whole image anyway, so they get the separate pass.)
+    ColorProcessorHandle writeprocessor;
+    std::string writespace = fileoptions.get_string("colorconvert");
+    if (writespace.size()) {
+        string_view linearspace = ot.colorconfig().resolve("linear");
+        std::string currentspace
+            = ir->spec()->get_string_attribute("oiio:ColorSpace", linearspace);
+        if (currentspace == writespace) {
+            writespace.clear();
+        } else if (do_tex || do_latlong || do_bumpslopes) {
+            std::string cmd = "colorconvert:strict=0:allsubimages=1";
+            if (autoccunpremult)
+                cmd += ":unpremult=1";
+            const char* argv[] = { cmd.c_str(), currentspace.c_str(),
+                                   writespace.c_str() };
             action_colorconvert(ot, argv);
             ir = ot.curimg;
+            writespace.clear();
+        } else {
+            writeprocessor = ot.colorconfig().createColorProcessor(currentspace,
+                                                                 writespace);
+            if (!writeprocessor) {
+                ot.errorfmt(command, "Could not convert from {} to {}: {}",
+                            currentspace, writespace,
+                            ot.colorconfig().geterror());
+                return;
+            }
         }
     }
 
@@ -5400,6 +5953,7 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
         const char* argv[] = { "crop:allsubimages=1", crop.c_str() };
         void action_crop(Oiiotool & ot,
                          cspan<const char*> argv);  // forward decl
+        ot.materialize_deferred();
         action_crop(ot, argv);
         ir = ot.curimg;
     }
@@ -5418,6 +5972,21 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
     // FIXME -- the various automatic transformations above neglect to handle
     // MIPmaps or subimages with full generality.
 
+    // Write the output to a temp file first, then rename it to the
+    // final destination (same directory). This improves robustness.
+    // There is less chance a crash during execution will leave behind a
+    // partially formed file, and it also protects us against corrupting
+    // an input if they are "oiiotooling in place" (especially
+    // problematic for large files that are ImageCache-based and so only
+    // partially read at the point that we open the file. We also force
+    // a unique filename to protect against multiple processes running
+    // at the same time on the same file. (Texture output does this
+    // itself.)
+    std::string extension   = Filesystem::extension(filename);
+    std::string tmpfilename = Filesystem::replace_extension(
+        filename, ".%%%%%%%%.temp" + extension);
+    tmpfilename = Filesystem::unique_path(tmpfilename);
+
     bool ok = true;
     if (do_tex || do_latlong || do_bumpslopes) {
         ImageSpec configspec;
@@ -5446,6 +6015,34 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
         // N.B. make_texture already internally writes to a temp file and
         // then atomically moves it to the final destination, so we don't
         // need to explicitly do that here.
+    } else if (fileoptions.get_int("async") && ir->subimages() == 1
+               && ir->miplevels(0) == 1 && !procedural
+               && !ot.output_adjust_time) {
+        // Simple single image output requested in the background: hand a
+        // (copy-on-write) snapshot to ImageBuf::write_async() and move
+        // right along. finish_async_writes() collects the outcome.
+        ImageSpec spec = *ir->spec(0, 0);
+        adjust_output_options(filename, spec, ir->nativespec(0, 0), ot,
+                              supports_tiles, fileoptions,
+                              (*ir)[0].was_direct_read());
+        // A single level is never a MIP-mapped texture
+        spec.erase_attribute("textureformat");
+        ImageBuf img((*ir)(0, 0));
+        if (writeprocessor) {
+            img.set_write_colorprocessor(writeprocessor, autoccunpremult);
+            spec.attribute("oiio:ColorSpace", writespace);
+        }
+        img.specmod().extra_attribs = spec.extra_attribs;
+        if (spec.channelformats.size())
+            img.set_write_format(spec.channelformats);
+        else
+            img.set_write_format(spec.format);
+        img.set_write_tiles(spec.tile_width, spec.tile_height,
+                            spec.tile_depth);
+        // finish_async_writes() renames the temp file into place.
+        ot.async_writes.push_back(
+            { filename, tmpfilename,
+              img.write_async(tmpfilename, TypeUnknown, formatname) });
     } else {
         // Non-texture case
         std::vector<ImageSpec> subimagespecs(ir->subimages());
@@ -5457,24 +6054,11 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
             // If it's not tiled and MIP-mapped, remove any "textureformat"
             if (!spec.tile_pixels() || ir->miplevels(s) <= 1)
                 spec.erase_attribute("textureformat");
+            if (writeprocessor)
+                spec.attribute("oiio:ColorSpace", writespace);
             subimagespecs[s] = spec;
         }
 
-        // Write the output to a temp file first, then rename it to the
-        // final destination (same directory). This improves robustness.
-        // There is less chance a crash during execution will leave behind a
-        // partially formed file, and it also protects us against corrupting
-        // an input if they are "oiiotooling in place" (especially
-        // problematic for large files that are ImageCache-based and so only
-        // partially read at the point that we open the file. We also force
-        // a unique filename to protect against multiple processes running
-        // at the same time on the same file.
-        std::string extension = Filesystem::extension(filename);
-        std::string tmpfilename
-            = Filesystem::replace_extension(filename,
-                                            ".%%%%%%%%.temp" + extension);
-        tmpfilename = Filesystem::unique_path(tmpfilename);
-
         // Do the initial open
         ImageOutput::OpenMode mode = ImageOutput::Create;
         if (ir->subimages() > 1 && out->supports("multiimage")) {
@@ -5489,6 +6073,20 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
             }
         }
 
+        // Subimages whose pixels are still just as they were read can be
+        // handed to copy_image() straight from the file they came from,
+        // which lets a same-format output pass the compressed data through
+        // untouched (making metadata-only edits little more than a copy).
+        std::unique_ptr<ImageInput> rawsrc;
+        if (!writeprocessor && !ir->configspec() && !ot.can_stream(ir)
+            && Filesystem::exists(ir->name())) {
+            rawsrc = ImageInput::open(ir->name());
+            if (!rawsrc)
+                (void)OIIO::geterror();  // not an error for us, clear it
+            else if (string_view(rawsrc->format_name()) != out->format_name())
+                rawsrc.reset();
+        }
+
         // Output all the subimages and MIP levels
         for (int s = 0, send = ir->subimages(); s < send; ++s) {
             for (int m = 0, mend = ir->miplevels(s); m < mend && ok; ++m) {
@@ -5496,6 +6094,8 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
                 adjust_output_options(filename, spec, ir->nativespec(s, m), ot,
                                       supports_tiles, fileoptions,
                                       (*ir)[s].was_direct_read());
+                if (writeprocessor)
+                    spec.attribute("oiio:ColorSpace", writespace);
                 if (s > 0 || m > 0) {  // already opened first subimage/level
                     if (!out->open(tmpfilename, spec, mode)) {
                         ot.error(command, out->geterror());
@@ -5503,8 +6103,32 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
                         break;
                     }
                 }
-                if (!(*ir)(s, m).write(out.get())) {
-                    ot.error(command, (*ir)(s, m).geterror());
+                bool wrote = false;
+                if (rawsrc && (*ir)[s].was_direct_read()
+                    && rawsrc->seek_subimage(s, m)
+                    && rawsrc->spec().width == out->spec().width
+                    && rawsrc->spec().height == out->spec().height
+                    && rawsrc->spec().depth == out->spec().depth
+                    && rawsrc->spec().nchannels == out->spec().nchannels) {
+                    wrote = out->copy_image(rawsrc.get());
+                    if (!wrote)
+                        ot.error(command, out->geterror());
+                } else if (ot.can_stream(ir)) {
+                    // Compute and write in bands, never holding the whole
+                    // image.
+                    wrote = ot.write_streamed(command, ir, out.get(),
+                                              writeprocessor.get(),
+                                              autoccunpremult);
+                } else {
+                    ImageBuf& img((*ir)(s, m));
+                    img.set_write_colorprocessor(writeprocessor,
+                                                 autoccunpremult);
+                    wrote = img.write(out.get());
+                    img.set_write_colorprocessor(nullptr);
+                    if (!wrote)
+                        ot.error(command, img.geterror());
+                }
+                if (!wrote) {
                     ok = false;
                     break;
                 }
@@ -5566,6 +6190,12 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
     }
 
     ot.check_peak_memory();
+    if (ot.profiling()) {
+        // For a synchronous write, what came out is the file itself.
+        bool wrote = ok && !ot.dryrun && !fileoptions.get_int("async");
+        timer.set_bytes(ir->image_bytes(),
+                        wrote ? Filesystem::file_size(filename) : 0);
+    }
     ot.curimg               = saveimg;
     ot.output_dataformat    = saved_output_dataformat;
     ot.output_bitspersample = saved_bitspersample;
@@ -5846,24 +6476,24 @@ print_ocio_info(Oiiotool& ot, std::ostream& out)
     using Strutil::print;
     int columns = Sysutil::terminal_columns() - 1;
 
-    int ociover = ot.colorconfig.OpenColorIO_version_hex();
+    int ociover = ot.colorconfig().OpenColorIO_version_hex();
     if (ociover)
         out << "OpenColorIO " << (ociover >> 24) << '.'
             << ((ociover >> 16) & 0xff) << '.' << ((ociover >> 8) & 0xff);
     else
         out << "No OpenColorIO";
-    out << "\nColor config: " << ot.colorconfig.configname() << "\n";
+    out << "\nColor config: " << ot.colorconfig().configname() << "\n";
     out << "Known color spaces: \n";
-    const char* linear = ot.colorconfig.getColorSpaceNameByRole("linear");
-    for (int i = 0, e = ot.colorconfig.getNumColorSpaces(); i < e; ++i) {
-        const char* n = ot.colorconfig.getColorSpaceNameByIndex(i);
+    const char* linear = ot.colorconfig().getColorSpaceNameByRole("linear");
+    for (int i = 0, e = ot.colorconfig().getNumColorSpaces(); i < e; ++i) {
+        const char* n = ot.colorconfig().getColorSpaceNameByIndex(i);
         out << "    - " << quote_if_spaces(n);
-        if ((linear && !ot.colorconfig.equivalent(n, "linear")
-             && ot.colorconfig.equivalent(n, linear))
-            || ot.colorconfig.isColorSpaceLinear(n))
+        if ((linear && !ot.colorconfig().equivalent(n, "linear")
+             && ot.colorconfig().equivalent(n, linear))
+            || ot.colorconfig().isColorSpaceLinear(n))
             out << " (linear)";
         out << "\n";
-        auto aliases = ot.colorconfig.getAliases(n);
+        auto aliases = ot.colorconfig().getAliases(n);
         if (aliases.size()) {
             std::stringstream s;
             s << "      aliases: " << join_with_quotes(aliases, ", ");
@@ -5871,41 +6501,41 @@ print_ocio_info(Oiiotool& ot, std::ostream& out)
         }
     }
 
-    int roles = ot.colorconfig.getNumRoles();
+    int roles = ot.colorconfig().getNumRoles();
     if (roles) {
         print(out, "Known roles:\n");
         for (int i = 0; i < roles; ++i) {
-            const char* r = ot.colorconfig.getRoleByIndex(i);
+            const char* r = ot.colorconfig().getRoleByIndex(i);
             print(out, "    - {} -> {}\n", quote_if_spaces(r),
-                  quote_if_spaces(ot.colorconfig.getColorSpaceNameByRole(r)));
+                  quote_if_spaces(ot.colorconfig().getColorSpaceNameByRole(r)));
         }
     }
 
-    int nlooks = ot.colorconfig.getNumLooks();
+    int nlooks = ot.colorconfig().getNumLooks();
     if (nlooks) {
         print(out, "Known looks:\n");
         for (int i = 0; i < nlooks; ++i)
             print(out, "    - {}\n",
-                  quote_if_spaces(ot.colorconfig.getLookNameByIndex(i)));
+                  quote_if_spaces(ot.colorconfig().getLookNameByIndex(i)));
     }
 
-    const char* default_display = ot.colorconfig.getDefaultDisplayName();
-    int ndisplays               = ot.colorconfig.getNumDisplays();
+    const char* default_display = ot.colorconfig().getDefaultDisplayName();
+    int ndisplays               = ot.colorconfig().getNumDisplays();
     if (ndisplays) {
         out << "Known displays: (* indicates default)\n";
         for (int i = 0; i < ndisplays; ++i) {
-            const char* d = ot.colorconfig.getDisplayNameByIndex(i);
+            const char* d = ot.colorconfig().getDisplayNameByIndex(i);
             out << "    - " << quote_if_spaces(d);
             if (!strcmp(d, default_display))
                 out << " (*)";
-            const char* default_view = ot.colorconfig.getDefaultViewName(d);
-            int nviews               = ot.colorconfig.getNumViews(d);
+            const char* default_view = ot.colorconfig().getDefaultViewName(d);
+            int nviews               = ot.colorconfig().getNumViews(d);
             if (nviews) {
                 out << "\n      ";
                 std::stringstream s;
                 s << "views: ";
                 for (int i = 0; i < nviews; ++i) {
-                    const char* v = ot.colorconfig.getViewNameByIndex(d, i);
+                    const char* v = ot.colorconfig().getViewNameByIndex(d, i);
                     s << quote_if_spaces(v);
                     if (!strcmp(v, default_view))
                         s << " (*)";
@@ -5917,7 +6547,7 @@ print_ocio_info(Oiiotool& ot, std::ostream& out)
             out << "\n";
         }
     }
-    if (!ot.colorconfig.supportsOpenColorIO())
+    if (!ot.colorconfig().supportsOpenColorIO())
         out << "No OpenColorIO support was enabled at build time.\n";
 }
 
@@ -5967,12 +6597,12 @@ print_help_end(Oiiotool& ot, std::ostream& out)
     out << formatted_format_list("Input", "input_format_list") << "\n";
     out << formatted_format_list("Output", "output_format_list") << "\n";
 
-    if (int ociover = ot.colorconfig.OpenColorIO_version_hex())
+    if (int ociover = ot.colorconfig().OpenColorIO_version_hex())
         print(out, "OpenColorIO {}.{}.{}\n", (ociover >> 24),
               ((ociover >> 16) & 0xff), ((ociover >> 8) & 0xff));
     else
         print(out, "No OpenColorIO\n");
-    print(out, "    Color config: {}\n", ot.colorconfig.configname());
+    print(out, "    Color config: {}\n", ot.colorconfig().configname());
     print(out, "    Run `oiiotool --colorconfiginfo` for a "
                "full color management inventory.\n");
 
@@ -6049,9 +6679,14 @@ Oiiotool::getargs(int argc, char* argv[])
 {
     Oiiotool& ot(*this);  // Local reference alias for *this
 
-// Macro that wraps a call to prepend a ref to the ot
-#define OTACTION(act) \
-    action([&ot](cspan<const char*> argv) { return act(ot, argv); })
+// Macro that wraps a call to prepend a ref to the ot. With --lazy, a
+// pointwise command may be deferred instead of run, and any other command
+// first evaluates the deferred ones.
+#define OTACTION(act)                       \
+    action([&ot](cspan<const char*> argv) { \
+        if (!ot.defer_pointwise(argv))      \
+            act(ot, argv);                  \
+    })
 // Macro that wraps a call to an ot method
 #define OTMACTION(act) \
     action([&ot](cspan<const char*> argv) { return ot.act(argv); })
@@ -6059,9 +6694,13 @@ Oiiotool::getargs(int argc, char* argv[])
     bool help = false;
 
     bool sansattrib = false;
-    for (int i = 0; i < argc; ++i)
+    for (int i = 0; i < argc; ++i) {
         if (!strcmp(argv[i], "--sansattrib") || !strcmp(argv[i], "-sansattrib"))
             sansattrib = true;
+        // Start profiling from the first command, wherever --profile is.
+        if (!strcmp(argv[i], "--profile") && i + 1 < argc)
+            ot.profile_filename = argv[i + 1];
+    }
     ot.full_command_line = command_line_string(argc, argv, sansattrib);
 
     // clang-format off
@@ -6105,6 +6744,18 @@ Oiiotool::getargs(int argc, char* argv[])
       .help("Debug mode");
     ap.arg("--runstats", &ot.runstats)
       .help("Print runtime statistics");
+    ap.arg("--profile %s:FILENAME", &ot.profile_filename)
+      .help("Write a per-command timing trace (Chrome trace-event JSON)");
+    ap.arg("--serve %s:SOCKET")
+      .help("Run as a server for --connect clients (must be the only argument)")
+      .action([&](cspan<const char*> argv){
+            ot.errorfmt(argv[0], "must be the only argument");
+        });
+    ap.arg("--connect %s:SOCKET")
+      .help("Send the rest of the command line to a --serve server (must be first)")
+      .action([&](cspan<const char*> argv){
+            ot.errorfmt(argv[0], "must be the first argument");
+        });
     ap.arg("--buildinfo")
       .help("Print OIIO build information")
       .action([&](cspan<const char*>){
@@ -6128,6 +6779,8 @@ Oiiotool::getargs(int argc, char* argv[])
       .OTACTION(set_dumpdata);
     ap.arg("--hash", &ot.hash)
       .help("Print SHA-1 hash of each input image");
+    ap.arg("--hashtype %s:NAME", &ot.hashtype)
+      .help("Hash algorithm used by --hash: sha1 (default), xxhash");
     ap.arg("-u", &ot.updatemode)
       .help("Update mode: skip outputs when the file exists and is newer than all inputs");
     ap.arg("--no-clobber", &ot.noclobber)
@@ -6163,6 +6816,8 @@ Oiiotool::getargs(int argc, char* argv[])
       .OTACTION(set_autotile);
     ap.arg("--metamerge", &ot.metamerge)
       .help("Always merge metadata of all inputs into output");
+    ap.arg("--lazy", &ot.lazy)
+      .help("Fuse runs of pointwise ops (--addc, --mulc, --clamp, --colorconvert, etc.) into a single pass");
     ap.arg("--oiioattrib %s:NAME %s:VALUE")
       .help("Sets global OpenImageIO attribute (options: type=...)")
       .OTACTION(set_oiio_attribute);
@@ -6213,6 +6868,8 @@ Oiiotool::getargs(int argc, char* argv[])
       .help("Skip to next frame in range if there's an error, rather than exiting");
     ap.arg("--parallel-frames")
       .help("Parallelize evaluation of frame range");
+    ap.arg("--parallel-frames-memory %d:MB")
+      .help("Memory cap for frames run in parallel (default: 3/4 of physical memory)");
     ap.arg("--wildcardoff")
       .help("Disable numeric wildcard expansion for subsequent command line arguments");
     ap.arg("--wildcardon")
@@ -6240,8 +6897,9 @@ Oiiotool::getargs(int argc, char* argv[])
     ap.separator("Commands that write images:");
     ap.arg("-o %s:FILENAME")
       .help("Output the current image to the named file (options: "
-            "all=, autocc=, autocrop=, autotrim=, bits=, contig=, datatype=, "
-            "dither=, fileformatname=, scanline=, separate=, tile=, unpremult=)")
+            "all=, async=, autocc=, autocrop=, autotrim=, bits=, "
+            "colorconvert=, contig=, datatype=, dither=, fileformatname=, "
+            "scanline=, separate=, tile=, unpremult=)")
       .OTACTION(output_file);
     ap.arg("-otex %s:FILENAME")
       .help("Output the current image as a texture")
@@ -6525,7 +7183,7 @@ Oiiotool::getargs(int argc, char* argv[])
       .help("Resample (640x480, 50%) (options: interp=0)")
       .OTACTION(action_resample);
     ap.arg("--resize %s:GEOM")
-      .help("Resize (640x480, 50%) (options: from=<geom>, to=<geom>, filter=%s, highlightcomp=%d, edgeclamp=%d)")
+      .help("Resize (640x480, 50%) (options: from=<geom>, to=<geom>, filter=%s, highlightcomp=%d, edgeclamp=%d, usemip=%d)")
       .OTACTION(action_resize);
     ap.arg("--fit %s:GEOM")
       .help("Resize to fit within a window size (options: filter=%s, pad=%d, fillmode=%s, exact=%d, highlightcomp=%d)")
@@ -6770,6 +7428,8 @@ Oiiotool::merge_stats(const Oiiotool& ot)
         function_times[t.first] += t.second;
     }
     peak_memory = std::max(peak_memory, ot.peak_memory);
+    profile_events.insert(profile_events.end(), ot.profile_events.begin(),
+                          ot.profile_events.end());
     if (ot.return_value != EXIT_SUCCESS)
         return_value = ot.return_value;
     num_outputs += ot.num_outputs;
@@ -6778,7 +7438,92 @@ Oiiotool::merge_stats(const Oiiotool& ot)
 
 
 
-static void
+// Microseconds since the first call, the time base of --profile traces.
+static double
+profile_clock()
+{
+    using clock                                  = std::chrono::steady_clock;
+    static const clock::time_point profile_epoch = clock::now();
+    return std::chrono::duration<double, std::micro>(clock::now()
+                                                     - profile_epoch)
+        .count();
+}
+
+
+
+void
+Oiiotool::profile_begin(ProfileEvent& ev)
+{
+    // Number the threads in the order they first record an event, which
+    // reads better in a trace viewer than the OS thread ids.
+    static std::atomic<int> next_tid(0);
+    thread_local int tid = next_tid++;
+    ev.frame             = frame_number;
+    ev.tid               = tid;
+    ev.threads           = OIIO::get_int_attribute("threads");
+    ev.start_us          = profile_clock();
+    int misses = 0;
+    imagecache->getattribute("stat:find_tile_calls", TypeInt64, &ev.ic_hits);
+    imagecache->getattribute("stat:find_tile_cache_misses", misses);
+    imagecache->getattribute("stat:bytes_read", TypeInt64, &ev.ic_bytes_read);
+    ev.ic_misses = misses;
+}
+
+
+
+void
+Oiiotool::profile_end(ProfileEvent& ev)
+{
+    ev.dur_us     = profile_clock() - ev.start_us;
+    int64_t calls = 0;
+    int64_t bytes = 0;
+    int misses    = 0;
+    imagecache->getattribute("stat:find_tile_calls", TypeInt64, &calls);
+    imagecache->getattribute("stat:find_tile_cache_misses", misses);
+    imagecache->getattribute("stat:bytes_read", TypeInt64, &bytes);
+    ev.ic_misses     = misses - ev.ic_misses;
+    ev.ic_hits       = calls - ev.ic_hits - ev.ic_misses;
+    ev.ic_bytes_read = bytes - ev.ic_bytes_read;
+    ev.peak_memory   = check_peak_memory();
+    profile_events.push_back(std::move(ev));
+}
+
+
+
+bool
+Oiiotool::write_profile()
+{
+    // Chrome trace-event format: complete ("X") events, one per command,
+    // loadable by chrome://tracing, Perfetto, and similar viewers.
+    std::string out = "{\"traceEvents\":[\n";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+           "\"args\":{\"name\":\"oiiotool\"}}";
+    for (auto& ev : profile_events) {
+        out += Strutil::fmt::format(
+            ",\n{{\"name\":\"{}\",\"cat\":\"oiiotool\",\"ph\":\"X\","
+            "\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{},"
+            "\"args\":{{\"frame\":{},\"threads\":{},\"bytes_in\":{},"
+            "\"bytes_out\":{},\"ic_hits\":{},\"ic_misses\":{},"
+            "\"ic_bytes_read\":{},\"peak_memory\":{}}}}}",
+            Strutil::escape_chars(ev.name), ev.start_us, ev.dur_us, ev.tid,
+            ev.frame, ev.threads, ev.bytes_in, ev.bytes_out, ev.ic_hits,
+            ev.ic_misses, ev.ic_bytes_read, ev.peak_memory);
+    }
+    out += Strutil::fmt::format(
+        "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{{"
+        "\"command\":\"{}\",\"total_time\":{:.6f},\"peak_memory\":{}}}}}\n",
+        Strutil::escape_chars(full_command_line), total_runtime(),
+        peak_memory);
+    if (!Filesystem::write_text_file(profile_filename, out)) {
+        errorfmt("--profile", "Could not write \"{}\"", profile_filename);
+        return false;
+    }
+    return true;
+}
+
+// Run one iteration of a frame sequence. Return the peak memory (of the
+// whole process) seen while it ran.
+static size_t
 one_sequence_iteration(Oiiotool& otmain, size_t i, int frame_number,
                        cspan<int>(sequence_args),
                        cspan<std::vector<std::string>> filenames,
@@ -6787,7 +7532,7 @@ one_sequence_iteration(Oiiotool& otmain, size_t i, int frame_number,
     // If another iteration being processed asked us all to abort, don't
     // launch this iteration.
     if (otmain.ap.aborted())
-        return;
+        return 0;
 
     if (otmain.debug)
         print("Begin sequence iteration {}\n", i);
@@ -6803,7 +7548,16 @@ one_sequence_iteration(Oiiotool& otmain, size_t i, int frame_number,
     Oiiotool otit;  // Oiiotool for this iteration
     otit.imagecache   = otmain.imagecache;
     otit.frame_number = frame_number;
+    otit.prefetched   = otmain.prefetched;
+    {
+        // Share one ColorConfig among all the frames rather than load the
+        // OCIO config again for each.
+        std::lock_guard<std::mutex> lock(otmain.m_stat_mutex);
+        otmain.colorconfig();
+        otit.colorconfig_ref = otmain.colorconfig_ref;
+    }
     otit.getargs((int)seq_argv.size(), (char**)&seq_argv[0]);
+    otit.finish_async_writes();
 
     if (otit.ap.aborted()) {
         if (!otit.skip_bad_frames) {
@@ -6824,6 +7578,7 @@ one_sequence_iteration(Oiiotool& otmain, size_t i, int frame_number,
     }
 
     // Merge this iteration's stats into the main OT
+    otit.check_peak_memory();
     otmain.merge_stats(otit);
 
     // A few settings that may have occurred in the iteration oiiotool must be
@@ -6835,6 +7590,10 @@ one_sequence_iteration(Oiiotool& otmain, size_t i, int frame_number,
         otmain.debug = true;
     if (otit.noerrexit)
         otmain.noerrexit = true;
+    if (otit.profiling()) {
+        std::lock_guard<std::mutex> lock(otmain.m_stat_mutex);
+        otmain.profile_filename = otit.profile_filename;
+    }
     if (otit.runstats) {
         std::lock_guard<std::mutex> lock(otmain.m_stat_mutex);
         otmain.runstats = true;
@@ -6845,6 +7604,122 @@ one_sequence_iteration(Oiiotool& otmain, size_t i, int frame_number,
     } else if (otmain.debug) {
         print("\n");
     }
+    return otit.peak_memory;
+}
+
+
+
+// Run the iterations of a frame sequence concurrently. Each running frame
+// gets its own thread rather than one from the shared pool, so that the
+// operations within a frame can still fan out over the pool, which then
+// balances the work of all the running frames among the cores. Each frame
+// thread takes the next frame from a shared counter when it finishes the
+// last one, so frames of uneven cost balance themselves. A new frame is
+// only started while the running ones, by estimate, fit under the memory
+// cap. The estimate for one frame is the largest share of the process's
+// peak memory growth seen by any finished frame. Until a frame has
+// finished, an explicitly requested cap admits just one frame at a time.
+static void
+parallel_sequence_iterations(Oiiotool& ot, size_t nframes,
+                             cspan<int> frame_numbers, cspan<int> sequence_args,
+                             cspan<std::vector<std::string>> filenames,
+                             cspan<const char*> argv)
+{
+    const bool capped     = ot.parallel_frames_memory_MB > 0;
+    const size_t cap      = capped
+                                ? size_t(ot.parallel_frames_memory_MB) << 20
+                                : Sysutil::physical_memory() / 4 * 3;
+    const size_t baseline = Sysutil::memory_used();
+    int nthreads          = OIIO::get_int_attribute("threads");
+    size_t maxframes      = std::min(nframes, size_t(std::max(1, nthreads)));
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t next = 0, running = 0;
+    size_t per_frame = 0;  // estimated memory of one frame (0 = unknown)
+    auto admit       = [&]() {
+        if (next >= nframes || ot.ap.aborted() || running == 0)
+            return true;
+        if (per_frame == 0)
+            return !capped;
+        return baseline + per_frame * (running + 1) <= cap
+               && Sysutil::memory_used() + per_frame <= cap;
+    };
+    auto frame_thread = [&]() {
+        for (;;) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, admit);
+                if (next >= nframes || ot.ap.aborted())
+                    break;
+                i = next++;
+                ++running;
+            }
+            size_t peak = one_sequence_iteration(ot, i, frame_numbers[i],
+                                                 sequence_args, filenames,
+                                                 argv);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (peak > baseline)
+                    per_frame = std::max(per_frame,
+                                         (peak - baseline) / running);
+                --running;
+            }
+            cv.notify_all();
+        }
+        cv.notify_all();
+    };
+
+    if (ot.debug)
+        print("Running {} frames, up to {} at a time, memory cap {}\n",
+              nframes, maxframes, Strutil::memformat(cap));
+    thread_group frame_threads;
+    for (size_t t = 0; t < maxframes; ++t)
+        frame_threads.create_thread(frame_thread);
+    frame_threads.join_all();
+}
+
+
+
+// Start reading the inputs of frame i of a sequence into the ImageCache,
+// in the background, so that opening the files and reading their pixels
+// overlaps the computation of the frame before it. Each whole image is
+// prefetched if it takes at most a quarter of the cache; for bigger ones,
+// just the first row of tiles, or only the header if untiled (which the
+// cache would read as one huge tile). Return the names of the inputs.
+static std::set<std::string>
+prefetch_sequence_frame(Oiiotool& ot, size_t i, cspan<int> sequence_args,
+                        const std::vector<bool>& sequence_is_output,
+                        cspan<std::vector<std::string>> filenames)
+{
+    std::set<std::string> names;
+    ImageCache* ic     = ot.imagecache;
+    imagesize_t budget = imagesize_t(ot.cachesize) * 1024 * 1024 / 4;
+    for (size_t j = 0; j < sequence_is_output.size(); ++j) {
+        const std::string& name = filenames[sequence_args[j]][i];
+        if (sequence_is_output[j] || !Filesystem::exists(name)
+            || !names.insert(name).second)
+            continue;
+        default_thread_pool()->push([=](int /*id*/) {
+            ustring uname(name);
+            const ImageSpec* spec = ic->imagespec(uname, 0, 0);
+            if (!spec) {
+                ic->geterror();  // not an image; the frame will say so
+                return;
+            }
+            ROI roi = get_roi(*spec);
+            if (spec->image_pixels() * spec->nchannels * sizeof(float)
+                > budget) {
+                if (!spec->tile_width)
+                    return;
+                roi.yend = std::min(roi.yend, roi.ybegin + spec->tile_height);
+            }
+            if (!ic->prefetch(uname, 0, 0, roi))
+                ic->geterror();
+        });
+    }
+    return names;
 }
 
 
@@ -6913,6 +7788,10 @@ handle_sequence(Oiiotool& ot, int argc, const char** argv)
         } else if (strarg == "--parallel-frames"
                    || strarg == "-parallel-frames") {
             ot.parallel_frames = true;
+        } else if ((strarg == "--parallel-frames-memory"
+                    || strarg == "-parallel-frames-memory")
+                   && a < argc - 1) {
+            ot.parallel_frames_memory_MB = Strutil::stoi(argv[++a]);
         } else if (strarg == "--wildcardon" || strarg == "-wildcardon") {
             wildcard_on = true;
         } else if (wildcard_on && !is_output_all
@@ -7007,23 +7886,21 @@ handle_sequence(Oiiotool& ot, int argc, const char** argv)
     // every time.
     // Note: nfilenames really means, number of frame number iterations.
     if (ot.parallel_frames) {
-        // If --parframes was used, run the iterations in parallel.
-        if (ot.debug)
-            print("Running {} frames in parallel\n", nfilenames);
-        parallel_for(
-            uint64_t(0), uint64_t(nfilenames),
-            [&](uint64_t i) {
-                one_sequence_iteration(ot, i, frame_numbers[0][i],
-                                       sequence_args, filenames,
-                                       { argv, argv + argc });
-            },
-            paropt().minitems(1));
+        // If --parallel-frames was used, run the iterations in parallel.
+        parallel_sequence_iterations(ot, nfilenames, frame_numbers[0],
+                                     sequence_args, filenames,
+                                     { argv, argv + argc });
     } else {
         // Fully serialized over the frame range, multithreaded for each frame
-        // individually.
+        // individually, while the inputs of the next frame are prefetched.
         for (size_t i = 0; i < nfilenames; ++i) {
+            std::set<std::string> next;
+            if (i + 1 < nfilenames && !ot.ap.aborted())
+                next = prefetch_sequence_frame(ot, i + 1, sequence_args,
+                                               sequence_is_output, filenames);
             one_sequence_iteration(ot, i, frame_numbers[0][i], sequence_args,
                                    filenames, { argv, argv + argc });
+            ot.prefetched = std::move(next);
         }
     }
     return true;
@@ -7031,56 +7908,21 @@ handle_sequence(Oiiotool& ot, int argc, const char** argv)
 
 
 
-int
-main(int argc, char* argv[])
+// Set up the shared ImageCache the way oiiotool expects it by default.
+void
+OiioTool::configure_imagecache(Oiiotool& ot)
 {
-#if OIIO_SIMD_SSE && !OIIO_F16C_ENABLED
-    // We've found old versions of libopenjpeg (either by itself, or
-    // pulled in by ffmpeg libraries that link against it) that upon its
-    // dso load will turn on the cpu mode that causes floating point
-    // denormals get crushed to 0.0 in certain ops, and leave it that
-    // way! This can give us the wrong results for the particular
-    // sequence of SSE intrinsics we use to convert half->float for exr
-    // files containing pixels with denorm values. Can't fix everywhere,
-    // but at least for oiiotool we know it's safe to just fix the flag
-    // for our app. We only need to do this if using sse instructions and
-    // the f16c hardware half<->float ops are not enabled. This does not
-    // seem to be a problem in libopenjpeg > 1.5.
-    simd::set_denorms_zero_mode(false);
-#endif
-    {
-        // DEBUG -- this checks some problematic half->float values if the
-        // denorms zero mode is not set correctly. Leave this fragment in
-        // case we ever need to check it again.
-        // using namespace OIIO::simd;
-        const unsigned short bad[] = { 59, 12928, 2146, 32805 };
-        const half* h              = (half*)bad;
-        simd::vfloat4 vf(h);
-        if (vf[0] == 0.0f || *h != vf[0])
-            Strutil::print(stderr,
-                           "Bad half conversion, code {} {} -> {} "
-                           "(suspect badly set DENORMS_ZERO_MODE)\n",
-                           bad[0], float(h[0]), vf[0]);
-    }
-
-    // Helpful for debugging to make sure that any crashes dump a stack
-    // trace.
-    Sysutil::setup_crash_stacktrace("stdout");
-
-    // Globally force classic "C" locale, and turn off all formatting
-    // internationalization, for the entire oiiotool application.
-    std::locale::global(std::locale::classic());
-
-    Oiiotool ot;
-
-    ot.imagecache = ImageCache::create();
-    OIIO_DASSERT(ot.imagecache);
     ot.imagecache->attribute("forcefloat", 1);
     ot.imagecache->attribute("max_memory_MB", float(ot.cachesize));
     ot.imagecache->attribute("autotile", ot.autotile);
     ot.imagecache->attribute("autoscanline", int(ot.autotile ? 1 : 0));
+}
 
-    Filesystem::convert_native_arguments(argc, (const char**)argv);
+
+
+int
+OiioTool::run_command_line(Oiiotool& ot, int argc, char* argv[])
+{
     if (handle_sequence(ot, argc, (const char**)argv)) {
         // Deal with sequence
 
@@ -7097,6 +7939,7 @@ main(int argc, char* argv[])
                               ot.control_stack.top().command);
         }
     }
+    ot.finish_async_writes();
 
     if (!ot.printinfo && !ot.printstats && !ot.dumpdata && !ot.dryrun
         && !ot.printed_info && !ot.ap.aborted()) {
@@ -7145,6 +7988,8 @@ main(int argc, char* argv[])
         }
         print("\n{}\n", ot.imagecache->getstats(2));
     }
+    if (ot.profiling())
+        ot.write_profile();
 
     // Release references of images that might hold onto a shared
     // image cache. Otherwise they would get released at static destruction
@@ -7153,6 +7998,67 @@ main(int argc, char* argv[])
     ot.curimg = nullptr;
     ot.image_stack.clear();
     ot.image_labels.clear();
+    return ot.return_value;
+}
+
+
+
+int
+main(int argc, char* argv[])
+{
+#if OIIO_SIMD_SSE && !OIIO_F16C_ENABLED
+    // We've found old versions of libopenjpeg (either by itself, or
+    // pulled in by ffmpeg libraries that link against it) that upon its
+    // dso load will turn on the cpu mode that causes floating point
+    // denormals get crushed to 0.0 in certain ops, and leave it that
+    // way! This can give us the wrong results for the particular
+    // sequence of SSE intrinsics we use to convert half->float for exr
+    // files containing pixels with denorm values. Can't fix everywhere,
+    // but at least for oiiotool we know it's safe to just fix the flag
+    // for our app. We only need to do this if using sse instructions and
+    // the f16c hardware half<->float ops are not enabled. This does not
+    // seem to be a problem in libopenjpeg > 1.5.
+    simd::set_denorms_zero_mode(false);
+#endif
+    {
+        // DEBUG -- this checks some problematic half->float values if the
+        // denorms zero mode is not set correctly. Leave this fragment in
+        // case we ever need to check it again.
+        // using namespace OIIO::simd;
+        const unsigned short bad[] = { 59, 12928, 2146, 32805 };
+        const half* h              = (half*)bad;
+        simd::vfloat4 vf(h);
+        if (vf[0] == 0.0f || *h != vf[0])
+            Strutil::print(stderr,
+                           "Bad half conversion, code {} {} -> {} "
+                           "(suspect badly set DENORMS_ZERO_MODE)\n",
+                           bad[0], float(h[0]), vf[0]);
+    }
+
+    // Helpful for debugging to make sure that any crashes dump a stack
+    // trace.
+    Sysutil::setup_crash_stacktrace("stdout");
+
+    // Globally force classic "C" locale, and turn off all formatting
+    // internationalization, for the entire oiiotool application.
+    std::locale::global(std::locale::classic());
+
+    // A client of a running `oiiotool --serve` only forwards its command
+    // line, so do that before any other setup.
+    if (argc >= 3 && !strcmp(argv[1], "--connect"))
+        return connect_and_run(argv[2], argc - 2, argv + 2);
+
+    Oiiotool ot;
+
+    ot.imagecache = ImageCache::create();
+    OIIO_DASSERT(ot.imagecache);
+    configure_imagecache(ot);
+
+    Filesystem::convert_native_arguments(argc, (const char**)argv);
+    if (argc == 3 && !strcmp(argv[1], "--serve"))
+        ot.return_value = serve(ot, argv[2]);
+    else
+        run_command_line(ot, argc, argv);
     shutdown();
     return ot.return_value;
 }
@@ -6,7 +6,9 @@
 #pragma once
 
 #include <functional>
+#include <future>
 #include <memory>
+#include <set>
 #include <stack>
 
 #include <tsl/robin_set.h>
@@ -18,6 +20,7 @@
 #include <OpenImageIO/errorhandler.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/timer.h>
 
@@ -46,6 +49,9 @@ enum ReadPolicy {
                             //<   but still subject to format conversion.
     ReadNativeNoCache = 3,  //< No cache, no conversion. Do it all now.
                             //<   You better know what you're doing.
+    ReadPrefetched = 4,     //< The pixels were prefetched into the cache,
+                            //<   so copy "small" images from there rather
+                            //<   than reading the file again.
 };
 
 
@@ -77,17 +83,21 @@ public:
     int cachesize;
     int autotile;
     int frame_padding;
-    bool eval_enable;              // Enable evaluation of expressions
-    bool parallel_frames = false;  // Parallelize over frame iteration
-    bool skip_bad_frames = false;  // Just skip a bad frame, don't exit
-    bool nostderr        = false;  // If true, use stdout for errors
-    bool noerrexit       = false;  // Don't exit on error
+    bool eval_enable;                       // Enable evaluation of expressions
+    bool parallel_frames          = false;  // Parallelize over frame iteration
+    int parallel_frames_memory_MB = 0;      // Memory cap for parallel frames
+    bool lazy                     = false;  // Fuse runs of pointwise ops
+    bool skip_bad_frames          = false;  // Just skip a bad frame, don't exit
+    bool nostderr                 = false;  // If true, use stdout for errors
+    bool noerrexit                = false;  // Don't exit on error
     std::string dumpdata_C_name;
     std::string full_command_line;
     std::string printinfo_metamatch;
     std::string printinfo_nometamatch;
     std::string printinfo_format;
+    std::string hashtype;  // Hash algorithm for --hash
     std::string missingfile_policy;
+    std::string profile_filename;  // --profile: write a trace here
     ImageSpec input_config;  // configuration options for reading
     ImageSpec first_input_dimensions;
     std::string input_channel_set;  // Optional input channel set
@@ -141,7 +151,16 @@ public:
     std::vector<ImageRecRef> image_stack;  // stack of previous images
     std::map<std::string, ImageRecRef> image_labels;  // labeled images
     ImageCache* imagecache = nullptr;                 // back ptr to ImageCache
-    ColorConfig colorconfig;                          // OCIO color config
+    // OCIO color config, loaded on first use. Frame iterations and served
+    // jobs share their parent's; --colorconfig gives an ot its own.
+    std::shared_ptr<ColorConfig> colorconfig_ref;
+    ColorConfig& colorconfig()
+    {
+        std::lock_guard<std::mutex> lock(m_colorconfig_mutex);
+        if (!colorconfig_ref)
+            colorconfig_ref = std::make_shared<ColorConfig>();
+        return *colorconfig_ref;
+    }
     Timer total_runtime;
     // total_readtime is the amount of time for direct reads, and does not
     // count time spent inside ImageCache.
@@ -150,9 +169,33 @@ public:
     double total_imagecache_readtime = 0.0;
     typedef std::map<std::string, double> TimingMap;
     TimingMap function_times;
+    // One timed command, as recorded for --profile
+    struct ProfileEvent {
+        std::string name;
+        int frame             = 0;
+        int tid               = 0;    // small per-thread index
+        int threads           = 0;
+        double start_us       = 0.0;  // microseconds since process start
+        double dur_us         = 0.0;
+        imagesize_t bytes_in  = 0;    // pixel size of the input images
+        imagesize_t bytes_out = 0;    // pixel size of the result
+        int64_t ic_hits       = 0;
+        int64_t ic_misses     = 0;
+        int64_t ic_bytes_read = 0;
+        size_t peak_memory    = 0;
+    };
+    std::vector<ProfileEvent> profile_events;
     size_t peak_memory          = 0;
     int return_value            = EXIT_SUCCESS;  // oiiotool command return code
     int num_outputs             = 0;             // Count of outputs written
+    // Outputs still being written in the background, each to a temp file
+    // that is renamed to the final filename once it's done.
+    struct AsyncWrite {
+        std::string filename;
+        std::string tmpfilename;
+        std::future<std::string> result;  // error message, or empty
+    };
+    std::vector<AsyncWrite> async_writes;
     int frame_number            = 0;
     bool enable_function_timing = true;
     bool input_config_set       = false;
@@ -161,9 +204,13 @@ public:
     TypeDesc input_dataformat;
     int input_bitspersample = 0;
     std::map<std::string, std::string> input_channelformats;
+    // Inputs whose pixels a frame sequence has already prefetched into
+    // the ImageCache
+    std::set<std::string> prefetched;
 
     // stat_mutex guards when we are merging another ot's stats into this one
     std::mutex m_stat_mutex;
+    std::mutex m_colorconfig_mutex;  // guards creating colorconfig_ref
 
     Oiiotool();
 
@@ -207,6 +254,12 @@ public:
         return true;
     }
 
+    // The pieces of read(), for reading images some other way (e.g.,
+    // several at once): the policy to pass to ImageRec::read(), and the
+    // bookkeeping (and error reporting) after it. Returns ok.
+    ReadPolicy adjust_read_policy(ImageRecRef img, ReadPolicy readpolicy) const;
+    bool finish_read(ImageRecRef img, bool ok);
+
     /// Force partial read of image (if it hasn't been yet), just enough
     /// that the nativespec can be examined.
     bool read_nativespec(ImageRecRef img);
@@ -231,6 +284,36 @@ public:
     // Process any pending commands.
     void process_pending();
 
+    // With --lazy, if argv is a pointwise command (--addc, --mulc, --clamp,
+    // --colorconvert, etc.) that can be folded into a fused chain on the
+    // top image, record it without computing any pixels and return true.
+    // Otherwise, evaluate any chain in progress and return false so the
+    // command runs normally.
+    bool defer_pointwise(cspan<const char*> argv);
+
+    // Compute the pixels of any deferred chain of pointwise commands.
+    bool materialize_deferred();
+
+    // Is img the stand-in for a chain of commands deferred by --lazy?
+    bool is_deferred(const ImageRecRef& img) const;
+
+    // Can img be written by write_streamed()? That's the case for a
+    // deferred chain on a single flat image, and (with --lazy) for an
+    // unmodified untiled file that would otherwise be read whole.
+    bool can_stream(const ImageRecRef& img) const;
+
+    // Write img to the opened out a band of scanlines at a time, each
+    // band computed through any deferred chain and the optional color
+    // processor while the previous one is being written. Only a few bands
+    // are in memory at once, and a deferred chain stays deferred.
+    bool write_streamed(string_view command, const ImageRecRef& img,
+                        ImageOutput* out, const ColorProcessor* processor,
+                        bool unpremult);
+
+    // Wait for outputs handed off by -o:async=1 (only those going to
+    // `filename`, if it's not empty) and report any that failed.
+    void finish_async_writes(string_view filename = string_view());
+
     CallbackFunction pending_callback() const { return m_pending_callback; }
     const char* pending_callback_name() const { return m_pending_argv[0]; }
 
@@ -319,6 +402,15 @@ public:
         warning(command, Strutil::fmt::format(fmt, args...));
     }
 
+    bool profiling() const { return !profile_filename.empty(); }
+    // Start and finish a --profile event. Between the two calls, the IC
+    // counters in ev hold their values at the start; profile_end() turns
+    // them into deltas and appends ev to profile_events.
+    void profile_begin(ProfileEvent& ev);
+    void profile_end(ProfileEvent& ev);
+    // Write profile_events as a Chrome trace-event JSON file.
+    bool write_profile();
+
     size_t check_peak_memory()
     {
         size_t mem  = Sysutil::memory_used();
@@ -346,6 +438,7 @@ public:
         opt.verbose            = verbose || printinfo_verbose;
         opt.subimages          = allsubimages;
         opt.compute_sha1       = hash;
+        opt.hashtype           = hashtype;
         opt.compute_stats      = printstats;
         opt.dumpdata           = dumpdata;
         opt.dumpdata_showempty = dumpdata_showempty;
@@ -362,6 +455,8 @@ public:
 private:
     CallbackFunction m_pending_callback;
     std::vector<const char*> m_pending_argv;
+    struct DeferredOps;
+    std::shared_ptr<DeferredOps> m_deferred;  // --lazy chain on the top image
 
     void express_error(const string_view expr, const string_view s,
                        string_view explanation);
@@ -374,6 +469,23 @@ private:
                                 std::string& result);
 
     std::string express_impl(string_view s);
+
+public:
+    struct ExprNode;  // A compiled expression
+
+private:
+    bool express_eval(const ExprNode& node, std::string& result);
+    bool express_metadata(ImageRecRef img, string_view metadata,
+                          bool using_bracket, std::string& result);
+    ImageRecRef express_labeled_image(string_view label);
+
+    // Images opened by IMG[filename] and metadata values looked up while
+    // evaluating one expression. When the compiled form of an expression
+    // fails partway and the interpreter evaluates it again, these keep
+    // the files from being read and the pixel stats from being computed
+    // a second time. Cleared by express_impl().
+    std::map<std::string, ImageRecRef> m_expr_images;
+    std::map<std::string, std::pair<bool, std::string>> m_expr_metadata;
 };
 
 
@@ -498,7 +610,31 @@ public:
     // Remove a subimage from the list
     void erase_subimage(int i) { m_subimages.erase(m_subimages.begin() + i); }
 
+    // Total size of the pixels of all subimages and MIP levels
+    imagesize_t image_bytes() const
+    {
+        imagesize_t bytes = 0;
+        for (int s = 0; s < subimages(); ++s)
+            for (int m = 0; m < miplevels(s); ++m)
+                if (const ImageSpec* sp = spec(s, m))
+                    bytes += sp->image_bytes();
+        return bytes;
+    }
+
     string_view name() const { return m_name; }
+    void name(string_view name) { m_name = name; }
+
+    // Is every subimage and MIP level held in a local buffer that nothing
+    // else references, so that it may be overwritten in place?
+    bool pixels_unshared() const
+    {
+        for (auto& sub : m_subimages)
+            for (auto& ib : sub.m_miplevels)
+                if (!ib || ib.use_count() != 1
+                    || ib->storage() != ImageBuf::LOCALBUFFER)
+                    return false;
+        return m_subimages.size() > 0;
+    }
 
     // Has the ImageRec been actually read or evaluated?  (Until needed,
     // it's lazily kept as name only, without reading the file.)
@@ -562,6 +698,7 @@ public:
     {
         m_input_dataformat = dataformat;
     }
+    TypeDesc input_dataformat() const { return m_input_dataformat; }
 
     // This should be called if for some reason the underlying
     // ImageBuf's spec may have been modified in place.  We need to
@@ -637,6 +774,29 @@ print_stats(std::ostream& out, Oiiotool& ot, const std::string& filename,
             int subimage = 0, int miplevel = 0, string_view indent = "",
             ROI roi = {});
 
+// Set ot.imagecache's attributes to oiiotool's defaults.
+void
+configure_imagecache(Oiiotool& ot);
+
+// Run a whole oiiotool command line (argv[0] is the program name) in ot,
+// which must already have its imagecache. Return the exit status.
+int
+run_command_line(Oiiotool& ot, int argc, char* argv[]);
+
+// serve.cpp: Run as a daemon that accepts command lines on the local
+// socket at socketpath and runs each one as if oiiotool had been launched
+// with it, sharing ot's ImageCache and ColorConfig. Returns only on error
+// (or after a client's --shutdown), with the exit status.
+int
+serve(Oiiotool& ot, string_view socketpath);
+
+// serve.cpp: Send the command line (argv[0] is ignored) to the server at
+// socketpath, wait for it to finish, and return its exit status. The
+// server's output goes to our own stdout and stderr.
+int
+connect_and_run(string_view socketpath, int argc, char* argv[]);
+
+
 
 inline bool
 same_size(const ImageBuf& A, const ImageBuf& B)
@@ -705,6 +865,11 @@ public:
     {
         if (m_ot.enable_function_timing)
             start();
+        if (m_ot.profiling() && m_ot.enable_function_timing) {
+            m_profile.reset(new Oiiotool::ProfileEvent);
+            m_profile->name = m_name;
+            m_ot.profile_begin(*m_profile);
+        }
     }
 
     // Exit scope: record the results.
@@ -713,6 +878,17 @@ public:
         stop();
         m_ot.function_times[m_name] += m_timer() - m_io_time;
         m_ot.function_times["-i"] += m_io_time;
+        if (m_profile)
+            m_ot.profile_end(*m_profile);
+    }
+
+    // Note the pixel memory consumed and produced, for --profile.
+    void set_bytes(imagesize_t bytes_in, imagesize_t bytes_out)
+    {
+        if (m_profile) {
+            m_profile->bytes_in  = bytes_in;
+            m_profile->bytes_out = bytes_out;
+        }
     }
 
     // Explicit start of the timer.
@@ -747,6 +923,7 @@ private:
     double m_pre_input_time = 0.0f;
     double m_pre_ic_time    = 0.0f;
     double m_io_time        = 0.0f;
+    std::unique_ptr<Oiiotool::ProfileEvent> m_profile;
 };
 
 
@@ -831,6 +1008,14 @@ public:
                 // If instructed to operate in place, just make the output
                 // another reference to the first input image.
                 m_ir[0] = m_ir[1];
+            } else if (input_reusable()) {
+                // A pointwise op whose input nothing else will ever see
+                // again can simply overwrite it.
+                m_ir[0] = m_ir[1];
+                if (!preserve_miplevels())
+                    m_ir[0]->name(opname());
+                for (int s = 0; s < subimages; ++s)
+                    (*m_ir[0])[s].was_direct_read(false);
             } else {
                 // Not in-place, so make a new output image.
                 m_ir[0] = new_output_imagerec();
@@ -855,6 +1040,12 @@ public:
 
         if (ot.debug || ot.runstats)
             ot.check_peak_memory();
+        if (ot.profiling()) {
+            imagesize_t bytes_in = 0;
+            for (int i = 1; i < nimages(); ++i)
+                bytes_in += ir(i)->image_bytes();
+            timer.set_bytes(bytes_in, nimages() ? ir(0)->image_bytes() : 0);
+        }
 
         // Optional cleanup after processing all the subimages
         cleanup();
@@ -870,42 +1061,91 @@ public:
 
     virtual void traverse_subimages(int subimages)
     {
-        // For each subimage, find the ImageBuf's for input and output
-        // images, and call impl().
+        // Gather the (subimage, miplevel) parts to process, and for each,
+        // the ImageBuf's for its output and input images.
+        struct Part {
+            int subimage, miplevel;
+            std::vector<ImageBuf*> img;
+            bool ok = true;
+        };
+        std::vector<Part> parts;
         for (int s = 0; s < subimages; ++s) {
-            m_current_subimage = s;
-            // Get pointers for the ImageBufs for this subimage
-            m_img.resize(nimages());
             for (int m = 0, nmip = ir(0)->miplevels(); m < nmip; ++m) {
-                m_current_miplevel = m;
-                for (int i = 0; i < nimages(); ++i)
-                    m_img[i] = &((*ir(i))(std::min(s, ir(i)->subimages() - 1),
-                                          std::min(m, ir(i)->miplevels(s))));
-
-                if (subimage_is_active(s)) {
-                    // Call the impl kernel for this subimage
-                    bool ok = impl(m_img);
-                    if (!ok)
-                        ot.errorfmt(opname(), "{}", m_img[0]->geterror());
-
-                    // Merge metadata if called for
-                    if (ot.metamerge)
-                        for (int i = 1; i < nimages(); ++i)
-                            m_img[0]->specmod().extra_attribs.merge(
-                                m_img[i]->spec().extra_attribs);
-                } else {
-                    // Inactive subimage, just copy.
-                    if (nimages() >= 2)
-                        m_img[0]->copy(*m_img[1]);
+                Part part { s, m, std::vector<ImageBuf*>(nimages()) };
+                for (int i = 0; i < nimages(); ++i) {
+                    int si      = std::min(s, ir(i)->subimages() - 1);
+                    int mi      = std::min(m, ir(i)->miplevels(s));
+                    part.img[i] = &((*ir(i))(si, mi));
                 }
-                m_ir[0]->update_spec_from_imagebuf(s, m);
+                parts.push_back(std::move(part));
             }
+        }
 
+        // A part big enough to keep all the threads busy by itself is
+        // processed alone, as its op is internally parallel. Small parts
+        // (many little subimages, or the upper levels of a MIP pyramid)
+        // would leave most threads idle that way, so run those
+        // concurrently, one thread each. That is only safe for the plain
+        // impl functions, which keep no state of their own in the op.
+        std::vector<Part*> small_parts;
+        for (auto& part : parts) {
+            if (m_impl_func && nimages() >= 2
+                && part.img[1]->spec().image_pixels() < 512 * 512) {
+                small_parts.push_back(&part);
+            } else {
+                m_current_subimage = part.subimage;
+                m_current_miplevel = part.miplevel;
+                m_img              = part.img;
+                part.ok            = process_part(part.subimage, part.img);
+            }
+        }
+        if (small_parts.size() > 1) {
+            parallel_for(int64_t(0), int64_t(small_parts.size()),
+                         [&](int64_t i) {
+                             Part& part(*small_parts[i]);
+                             part.ok = process_part(part.subimage, part.img);
+                         });
+        } else if (small_parts.size() == 1) {
+            Part& part(*small_parts[0]);
+            m_current_subimage = part.subimage;
+            m_current_miplevel = part.miplevel;
+            m_img              = part.img;
+            part.ok            = process_part(part.subimage, part.img);
+        }
+
+        // Collect the results in order.
+        for (size_t p = 0; p < parts.size(); ++p) {
+            Part& part(parts[p]);
+            if (!part.ok)
+                ot.errorfmt(opname(), "{}", part.img[0]->geterror());
+            m_ir[0]->update_spec_from_imagebuf(part.subimage, part.miplevel);
             // Make sure to forward any errors missed by the impl
-            for (auto& im : m_img)
-                if (im->has_error())
-                    ot.errorfmt(opname(), "{}", im->geterror());
+            if (p + 1 == parts.size()
+                || parts[p + 1].subimage != part.subimage)
+                for (auto& im : part.img)
+                    if (im->has_error())
+                        ot.errorfmt(opname(), "{}", im->geterror());
+        }
+    }
+
+    // Process one subimage/miplevel, with img[0] the destination and
+    // img[1..] the inputs. Return false if impl() failed.
+    bool process_part(int subimage, span<ImageBuf*> img)
+    {
+        if (!subimage_is_active(subimage)) {
+            // Inactive subimage, just copy.
+            if (nimages() >= 2)
+                img[0]->copy(*img[1]);
+            return true;
         }
+        // Call the impl kernel for this subimage
+        bool ok = impl(img);
+        // Merge metadata if called for
+        if (ot.metamerge)
+            for (int i = 1; i < nimages(); ++i)
+                img[0]->specmod().extra_attribs.merge(
+                    img[i]->spec().extra_attribs);
+        return ok;
     }
 
     // THIS is the method that needs to be separately overloaded for each
@@ -1013,6 +1253,24 @@ public:
         return true;
     }
 
+    // Can the output just be the input, overwritten? The input must be
+    // uniquely ours, and have exactly the subimages and MIP levels that
+    // a new output would have.
+    bool input_reusable()
+    {
+        if (!reuse_input() || nimages() != 2 || m_ir[1].use_count() != 1
+            || !ir(1)->elaborated() || ir(1)->spec()->deep
+            || !ir(1)->pixels_unshared()
+            || ir(1)->subimages() != compute_subimages()
+            || subimage_includes.size() || subimage_excludes.size())
+            return false;
+        if (!preserve_miplevels())
+            for (int s = 0; s < ir(1)->subimages(); ++s)
+                if (ir(1)->miplevels(s) != 1)
+                    return false;
+        return true;
+    }
+
     int subimage_index(string_view name)
     {
         // For each image on the stack, check if the names of any of its
@@ -1076,6 +1334,14 @@ public:
     void inplace(bool val) { m_inplace = val; }
     bool inplace() const { return m_inplace; }
 
+    // Call reuse_input(true) if the impl may be run with img[0] and img[1]
+    // being the same ImageBuf (e.g., a pointwise op on one image). The
+    // result then overwrites the input, rather than a new image, whenever
+    // the input is referenced nowhere else (not labeled, not still on the
+    // stack, not shared with another image).
+    void reuse_input(bool val) { m_reuse_input = val; }
+    bool reuse_input() const { return m_reuse_input; }
+
     int current_subimage() const { return m_current_subimage; }
     int current_miplevel() const { return m_current_miplevel; }
 
@@ -1087,6 +1353,7 @@ protected:
     bool m_preserve_miplevels = false;
     bool m_skip_impl          = false;
     bool m_inplace            = false;
+    bool m_reuse_input        = false;
     std::vector<ImageRecRef> m_ir;
     std::vector<ImageBuf*> m_img;
     std::vector<string_view> m_args;
@@ -312,13 +312,20 @@ print_info_subimage(std::ostream& out, Oiiotool& ot, int current_subimage,
         // Before sha-1, be sure to point back to the highest-res MIP level
         ImageSpec tmpspec;
         std::string err;
-        std::string sha = compute_sha1(input, current_subimage, 0, err);
+        std::string sha   = compute_pixel_hash(input, current_subimage, 0,
+                                               opt.hashtype, err);
+        bool sha1         = Strutil::iequals(opt.hashtype, "sha1");
+        std::string label = sha1 ? std::string("SHA-1") : opt.hashtype;
         if (!err.empty())
-            ot.errorfmt("-info", "SHA-1: {}", err);
+            ot.errorfmt("-info", "{}: {}", label, err);
         else if (serformat == ImageSpec::SerialText)
-            lines.insert(lines.begin() + 1, format("    SHA-1: {}", sha));
-        else if (serformat == ImageSpec::SerialXML)
+            lines.insert(lines.begin() + 1, format("    {}: {}", label, sha));
+        else if (serformat == ImageSpec::SerialXML && sha1)
             lines.insert(lines.begin() + 1, format("<SHA1>{}</SHA1>", sha));
+        else if (serformat == ImageSpec::SerialXML)
+            lines.insert(lines.begin() + 1,
+                         format("<PixelHash type=\"{}\">{}</PixelHash>",
+                                opt.hashtype, sha));
     }
 
     // Count MIP levels
@@ -0,0 +1,402 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+// oiiotool --serve / --connect: a long-running oiiotool that runs command
+// lines sent to it over a local socket, so that many small jobs don't each
+// pay for process start-up, plugin discovery, loading the OCIO config, and
+// a cold ImageCache.
+//
+// The protocol is deliberately minimal. The client sends a 4-byte payload
+// length, accompanied (as SCM_RIGHTS ancillary data) by its own stdout and
+// stderr file descriptors, then the payload: its working directory and
+// its arguments, each NUL-terminated. The server runs the job with its
+// stdout and stderr redirected to the client's, so output appears exactly
+// as it would have from a local oiiotool, then replies with the 4-byte
+// exit status. Jobs run one at a time; each still uses the whole thread
+// pool.
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#    include <sys/socket.h>
+#    include <sys/stat.h>
+#    include <sys/time.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+#include "oiiotool.h"
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+
+using namespace OIIO;
+using namespace OiioTool;
+
+
+
+#ifndef _WIN32
+
+// Fill in addr for a socket at path. Return false if the path is too long.
+static bool
+socket_address(string_view path, sockaddr_un& addr)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    memcpy(addr.sun_path, path.data(), path.size());
+    return true;
+}
+
+
+
+// Read or write exactly n bytes, retrying on short transfers.
+static bool
+read_fully(int fd, void* buf, size_t n)
+{
+    char* p = (char*)buf;
+    while (n) {
+        ssize_t r = ::read(fd, p, n);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        n -= size_t(r);
+    }
+    return true;
+}
+
+
+static bool
+write_fully(int fd, const void* buf, size_t n)
+{
+    const char* p = (const char*)buf;
+    while (n) {
+        ssize_t r = ::write(fd, p, n);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        n -= size_t(r);
+    }
+    return true;
+}
+
+
+
+// Close every descriptor passed in msg's SCM_RIGHTS control messages, so
+// that a malformed header doesn't leak them into the server.
+static void
+close_received_fds(msghdr& msg)
+{
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+         cmsg          = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS
+            || cmsg->cmsg_len < CMSG_LEN(0))
+            continue;
+        size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < n; ++i) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            close(fd);
+        }
+    }
+}
+
+
+
+// Is the process at the other end of conn running as the same user as
+// this one? The socket file's permissions already keep other users out,
+// but some systems ignore the permissions on sockets.
+static bool
+peer_is_same_user(int conn)
+{
+#    if defined(__linux__)
+    ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0)
+        return false;
+    return cred.uid == geteuid();
+#    else
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(conn, &uid, &gid) != 0)
+        return false;
+    return uid == geteuid();
+#    endif
+}
+
+
+
+// Receive one job's header from conn: the payload length and the client's
+// stdout/stderr descriptors.
+static bool
+receive_header(int conn, uint32_t& length, int fds[2])
+{
+    char control[CMSG_SPACE(2 * sizeof(int))];
+    iovec iov { &length, sizeof(length) };
+    msghdr msg {};
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t r;
+    do {
+        r = recvmsg(conn, &msg, MSG_WAITALL);
+    } while (r < 0 && errno == EINTR);
+    if (r < 0)
+        return false;
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (r != ssize_t(sizeof(length)) || (msg.msg_flags & MSG_CTRUNC)
+        || !cmsg || cmsg->cmsg_level != SOL_SOCKET
+        || cmsg->cmsg_type != SCM_RIGHTS
+        || cmsg->cmsg_len != CMSG_LEN(2 * sizeof(int))
+        || CMSG_NXTHDR(&msg, cmsg)) {
+        close_received_fds(msg);
+        return false;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), 2 * sizeof(int));
+    return true;
+}
+
+
+
+// Run one command line in a fresh Oiiotool that borrows the server's
+// ImageCache and ColorConfig, with stdout and stderr sent to fds.
+static int
+run_job(Oiiotool& server, std::vector<std::string>& args, const int fds[2])
+{
+    std::vector<char*> argv;
+    for (auto& a : args)
+        argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+
+    // Files may have changed on disk since the last job saw them, and
+    // the last job may have changed the cache's settings.
+    server.imagecache->invalidate_all(false);
+    Oiiotool job;
+    job.imagecache      = server.imagecache;
+    job.colorconfig_ref = server.colorconfig_ref;
+    configure_imagecache(job);
+    int threads = OIIO::get_int_attribute("threads");
+
+    fflush(stdout);
+    std::cout.flush();
+    std::cerr.flush();
+    int saved_stdout = dup(1);
+    int saved_stderr = dup(2);
+    dup2(fds[0], 1);
+    dup2(fds[1], 2);
+
+    int status = run_command_line(job, int(argv.size()) - 1, argv.data());
+
+    fflush(stdout);
+    fflush(stderr);
+    std::cout.flush();
+    std::cerr.flush();
+    dup2(saved_stdout, 1);
+    dup2(saved_stderr, 2);
+    close(saved_stdout);
+    close(saved_stderr);
+    OIIO::attribute("threads", threads);
+    return status;
+}
+
+
+
+int
+OiioTool::serve(Oiiotool& ot, string_view socketpath)
+{
+    sockaddr_un addr;
+    if (!socket_address(socketpath, addr)) {
+        ot.errorfmt("--serve", "socket path too long: \"{}\"", socketpath);
+        return EXIT_FAILURE;
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        ot.errorfmt("--serve", "could not create socket: {}", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    // A socket file left by a server that has gone away is removed, but
+    // don't steal the path from one that is still running.
+    if (Filesystem::exists(socketpath)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool live = connect(probe, (sockaddr*)&addr, sizeof(addr)) == 0;
+        close(probe);
+        if (live) {
+            ot.errorfmt("--serve", "a server is already running at \"{}\"",
+                        socketpath);
+            close(listener);
+            return EXIT_FAILURE;
+        }
+        unlink(addr.sun_path);
+    }
+    // Jobs run with the server's privileges, so only its own user may
+    // connect. Create the socket file as 0600 rather than chmod it after
+    // bind, which would leave a window where anyone could connect.
+    mode_t oldmask = umask(0177);
+    bool bound     = bind(listener, (sockaddr*)&addr, sizeof(addr)) == 0;
+    int binderr    = errno;
+    umask(oldmask);
+    if (!bound || listen(listener, 64) != 0) {
+        ot.errorfmt("--serve", "could not listen on \"{}\": {}", socketpath,
+                    strerror(bound ? errno : binderr));
+        close(listener);
+        return EXIT_FAILURE;
+    }
+
+    // A client that goes away mid-job must not take the server with it.
+    signal(SIGPIPE, SIG_IGN);
+    // Do the expensive one-time setup now rather than in the first job.
+    ot.colorconfig();
+    OIIO::get_string_attribute("format_list");
+    std::string cwd = Filesystem::current_path();
+
+    for (;;) {
+        int conn = accept(listener, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            ot.errorfmt("--serve", "accept failed: {}", strerror(errno));
+            break;
+        }
+        if (!peer_is_same_user(conn)) {
+            close(conn);
+            continue;
+        }
+        // A client that stalls partway through its request must not hold
+        // up everyone else; the request is simply refused.
+        timeval timeout { 10, 0 };
+        setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        uint32_t length = 0;
+        int fds[2]      = { -1, -1 };
+        std::string payload;
+        if (receive_header(conn, length, fds) && length <= (1 << 24)) {
+            payload.resize(length);
+            if (!read_fully(conn, &payload[0], length))
+                payload.clear();
+        }
+        // The payload is the client's working directory followed by its
+        // arguments, all NUL-terminated.
+        std::vector<std::string> args;
+        for (size_t pos = 0; pos < payload.size();) {
+            size_t end = payload.find('\0', pos);
+            if (end == std::string::npos)
+                break;
+            args.emplace_back(payload, pos, end - pos);
+            pos = end + 1;
+        }
+        int32_t status = EXIT_FAILURE;
+        if (args.size() >= 2 && fds[0] >= 0
+            && Filesystem::is_directory(args[0])
+            && chdir(args[0].c_str()) == 0) {
+            args.erase(args.begin());
+            status = run_job(ot, args, fds);
+            if (chdir(cwd.c_str()) != 0)
+                ot.warningfmt("--serve", "could not return to \"{}\"", cwd);
+        }
+        if (fds[0] >= 0) {
+            close(fds[0]);
+            close(fds[1]);
+        }
+        write_fully(conn, &status, sizeof(status));
+        close(conn);
+    }
+    close(listener);
+    return EXIT_FAILURE;
+}
+
+
+
+int
+OiioTool::connect_and_run(string_view socketpath, int argc, char* argv[])
+{
+    sockaddr_un addr;
+    int conn = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (!socket_address(socketpath, addr) || conn < 0
+        || connect(conn, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        Strutil::print(stderr,
+                       "oiiotool ERROR: --connect : could not connect to "
+                       "\"{}\": {}\n",
+                       socketpath, strerror(errno));
+        if (conn >= 0)
+            close(conn);
+        return EXIT_FAILURE;
+    }
+
+    std::string payload = Filesystem::current_path();
+    payload += '\0';
+    payload += "oiiotool";
+    payload += '\0';
+    for (int i = 1; i < argc; ++i) {
+        payload += argv[i];
+        payload += '\0';
+    }
+
+    uint32_t length = uint32_t(payload.size());
+    int fds[2]      = { 1, 2 };
+    char control[CMSG_SPACE(2 * sizeof(int))];
+    memset(control, 0, sizeof(control));
+    iovec iov { &length, sizeof(length) };
+    msghdr msg {};
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg      = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level   = SOL_SOCKET;
+    cmsg->cmsg_type    = SCM_RIGHTS;
+    cmsg->cmsg_len     = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    int32_t status = EXIT_FAILURE;
+    fflush(stdout);
+    if (sendmsg(conn, &msg, 0) != ssize_t(sizeof(length))
+        || !write_fully(conn, payload.data(), payload.size())
+        || !read_fully(conn, &status, sizeof(status))) {
+        Strutil::print(stderr,
+                       "oiiotool ERROR: --connect : lost connection to "
+                       "\"{}\"\n",
+                       socketpath);
+        status = EXIT_FAILURE;
+    }
+    close(conn);
+    return status;
+}
+
+#else
+
+int
+OiioTool::serve(Oiiotool& ot, string_view socketpath)
+{
+    ot.errorfmt("--serve", "not supported on this platform");
+    return EXIT_FAILURE;
+}
+
+
+
+int
+OiioTool::connect_and_run(string_view socketpath, int argc, char* argv[])
+{
+    Strutil::print(stderr, "oiiotool ERROR: --connect : not supported on "
+                           "this platform\n");
+    return EXIT_FAILURE;
+}
+
+#endif
@@ -240,4 +240,20 @@ private:
 
 
 
+// Create an output that writes through the OpenEXR C++ library. The core
+// library output uses one of these for the cases it leaves to Imf (deep
+// files, for example).
+ImageOutput*
+openexr_imf_output_create();
+
+// Using an output made by openexr_imf_output_create(), doctor the specs and
+// translate them into Imf headers exactly as that output's open() would.
+// Errors are reported to imfout.
+bool
+openexr_output_headers(ImageOutput* imfout, int subimages,
+                       const ImageSpec* specs, std::vector<ImageSpec>& outspecs,
+                       std::vector<Imf::Header>& headers);
+
+
+
 OIIO_PLUGIN_NAMESPACE_END
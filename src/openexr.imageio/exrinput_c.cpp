@@ -22,6 +22,7 @@
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/deepdata.h>
 #include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/strutil.h>
@@ -136,6 +137,8 @@ public:
     bool read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
                            int ybegin, int yend, int zbegin, int zend,
                            int chbegin, int chend, void* data) override;
+    bool native_tile_location(int subimage, int miplevel, int x, int y, int z,
+                              int64_t& offset, int64_t& size) override;
     bool read_native_deep_scanlines(int subimage, int miplevel, int ybegin,
                                     int yend, int z, int chbegin, int chend,
                                     DeepData& deepdata) override;
@@ -225,6 +228,17 @@ private:
                             int zbegin, int zend, int chbegin, int chend,
                             void* data, stride_t xstride, stride_t ystride);
 
+    // Read only channels [chbegin,chend) of an uncompressed chunk, straight
+    // from the file into data, rather than having the decoder read and
+    // unpack every channel. Returns false if the chunk isn't laid out so
+    // that this is possible or would save anything (or the read fails), in
+    // which case the caller should decode it as usual.
+    bool read_uncompressed_channels(const exr_chunk_info_t& cinfo,
+                                    const exr_decode_pipeline_t& decoder,
+                                    const ImageSpec& spec, int chbegin,
+                                    int chend, uint8_t* data, size_t pixelbytes,
+                                    size_t linebytes);
+
     // Helper struct to destroy decoder upon scope exit
     class DecoderDestroyer {
     public:
@@ -1393,6 +1407,39 @@ OpenEXRCoreInput::read_native_tile(int subimage, int miplevel, int x, int y,
 
 
 
+bool
+OpenEXRCoreInput::native_tile_location(int subimage, int miplevel, int x,
+                                       int y, int /*z*/, int64_t& offset,
+                                       int64_t& size)
+{
+    if (!m_exr_context)
+        return false;
+    const ImageSpec& spec = init_part(subimage, miplevel);
+    // Uncompressed EXR tiles store each scanline channel-planar, so the
+    // raw bytes only match our interleaved layout for one channel. They
+    // are little-endian, and edge tiles are cropped to the data window.
+    if (spec.nchannels != 1 || !spec.tile_width || !littleendian()
+        || spec.deep)
+        return false;
+    int32_t tx = (x - spec.x) / spec.tile_width;
+    int32_t ty = (y - spec.y) / spec.tile_height;
+    exr_chunk_info_t cinfo;
+    if (exr_read_tile_chunk_info(m_exr_context, subimage, tx, ty, miplevel,
+                                 miplevel, &cinfo)
+        != EXR_ERR_SUCCESS)
+        return false;
+    uint64_t bytes = uint64_t(spec.tile_bytes(true));
+    if (cinfo.compression != EXR_COMPRESSION_NONE
+        || cinfo.width != spec.tile_width || cinfo.height != spec.tile_height
+        || cinfo.packed_size != bytes || !cinfo.data_offset)
+        return false;
+    offset = int64_t(cinfo.data_offset);
+    size   = int64_t(bytes);
+    return true;
+}
+
+
+
 bool
 OpenEXRCoreInput::read_native_tiles(int subimage, int miplevel, int xbegin,
                                     int xend, int ybegin, int yend, int zbegin,
@@ -1480,6 +1527,11 @@ OpenEXRCoreInput::read_native_tiles(int subimage, int miplevel, int xbegin,
             if (rv == EXR_ERR_SUCCESS)
                 rv = exr_decoding_initialize(m_exr_context, subimage, &cinfo,
                                              &decoder);
+            if (rv == EXR_ERR_SUCCESS && chend - chbegin < spec.nchannels
+                && read_uncompressed_channels(cinfo, decoder, spec, chbegin,
+                                              chend, curtilestart, pixelbytes,
+                                              scanlinebytes))
+                return;
             if (rv == EXR_ERR_SUCCESS) {
                 size_t chanoffset = 0;
                 for (int c = chbegin; c < chend; ++c) {
@@ -1528,6 +1580,80 @@ OpenEXRCoreInput::read_native_tiles(int subimage, int miplevel, int xbegin,
 
 
 
+bool
+OpenEXRCoreInput::read_uncompressed_channels(
+    const exr_chunk_info_t& cinfo, const exr_decode_pipeline_t& decoder,
+    const ImageSpec& spec, int chbegin, int chend, uint8_t* data,
+    size_t pixelbytes, size_t linebytes)
+{
+    // Other compression methods have to decompress the whole chunk anyway,
+    // and then the decoder already skips unpacking the channels that
+    // weren't asked for. Uncompressed data is little-endian.
+    if (cinfo.compression != EXR_COMPRESSION_NONE || !littleendian()
+        || !m_userdata.m_io)
+        return false;
+
+    // Each scanline of the chunk holds the channels one after another, in
+    // file order. Find where in it each channel's values start.
+    size_t* fileoffset = OIIO_ALLOCA(size_t, decoder.channel_count);
+    size_t packedline  = 0;
+    for (int dc = 0; dc < decoder.channel_count; ++dc) {
+        const exr_coding_channel_info_t& chan(decoder.channels[dc]);
+        if (chan.x_samples != 1 || chan.y_samples != 1
+            || chan.width != cinfo.width || chan.height != cinfo.height)
+            return false;
+        fileoffset[dc] = packedline;
+        packedline += size_t(chan.width) * chan.bytes_per_element;
+    }
+    if (packedline * size_t(cinfo.height) != cinfo.packed_size)
+        return false;
+
+    // Match the requested channels to the file's, and find the span of
+    // each scanline that covers all of them.
+    struct ChanCopy {
+        size_t src, dst, bytes;
+    };
+    int nchans       = chend - chbegin;
+    ChanCopy* copy   = OIIO_ALLOCA(ChanCopy, nchans);
+    size_t lo        = packedline, hi = 0;
+    size_t dstoffset = 0;
+    for (int c = chbegin; c < chend; ++c) {
+        string_view cname = spec.channel_name(c);
+        int dc            = 0;
+        while (dc < decoder.channel_count
+               && cname != decoder.channels[dc].channel_name)
+            ++dc;
+        size_t bytes = spec.channelformat(c).size();
+        if (dc == decoder.channel_count
+            || size_t(decoder.channels[dc].bytes_per_element) != bytes)
+            return false;
+        size_t src        = fileoffset[dc];
+        lo                = std::min(lo, src);
+        hi                = std::max(hi, src + size_t(cinfo.width) * bytes);
+        copy[c - chbegin] = { src, dstoffset, bytes };
+        dstoffset += bytes;
+    }
+    if (hi - lo >= packedline)
+        return false;  // needs the whole chunk anyway
+
+    std::unique_ptr<uint8_t[]> span(new uint8_t[hi - lo]);
+    for (int y = 0; y < cinfo.height; ++y) {
+        int64_t offset = int64_t(cinfo.data_offset + y * packedline + lo);
+        if (m_userdata.m_io->pread(span.get(), hi - lo, offset) != hi - lo)
+            return false;
+        uint8_t* dst = data + y * linebytes;
+        for (int c = 0; c < nchans; ++c) {
+            const uint8_t* src = span.get() + (copy[c].src - lo);
+            for (int x = 0; x < cinfo.width; ++x)
+                memcpy(dst + x * pixelbytes + copy[c].dst,
+                       src + x * copy[c].bytes, copy[c].bytes);
+        }
+    }
+    return true;
+}
+
+
+
 bool
 OpenEXRCoreInput::check_fill_missing(int xbegin, int xend, int ybegin, int yend,
                                      int /*zbegin*/, int /*zend*/, int chbegin,
@@ -1571,8 +1697,10 @@ struct deepdecode_userdata {
     const ImageSpec* spec;
     DeepData* deepdata;
     std::vector<void*> linepointers;
+    // When the whole region was sized up front, the sample pointers for
+    // every pixel and channel of the region (fullwidth pixels per line).
+    void** allpointers;
     bool firstisfullread;
-    bool samplesset;
 };
 
 static exr_result_t
@@ -1581,44 +1709,33 @@ realloc_deepdata(exr_decode_pipeline_t* decode)
     deepdecode_userdata* ud = static_cast<deepdecode_userdata*>(
         decode->decoding_user_data);
 
-    // TODO: In order to read an entire image in, this is not as
-    // efficient as it will cause a number of re-allocations. But
-    // hopefully people are asking for an individual scanline at a
-    // time.
-    int w            = decode->chunk.width;
-    int h            = decode->chunk.height;
-    int chans        = ud->nchans;
-    size_t fullwidth = ud->fullwidth;
-    size_t xoff      = ud->xoff;
-    ud->linepointers.resize(w * h * chans);
+    int w     = decode->chunk.width;
+    int h     = decode->chunk.height;
+    int chans = ud->nchans;
+    void** cdata;
+    size_t linewidth;
     if (ud->firstisfullread) {
+        // A single chunk: its count table is the whole region.
+        ud->linepointers.resize(size_t(w) * size_t(h) * size_t(chans));
         ud->deepdata->set_all_samples(
             cspan<unsigned int>((const uint32_t*)decode->sample_count_table,
                                 (const uint32_t*)decode->sample_count_table
                                     + w * h));
         ud->deepdata->get_pointers(ud->linepointers);
+        cdata     = ud->linepointers.data();
+        linewidth = size_t(w);
     } else {
-        // this is super slow, read the sample counts up front and set the counts once
-        // unless that is hard...
-        if (!ud->samplesset) {
-            for (int y = 0; y < h; ++y)
-                for (int x = 0; x < w; ++x)
-                    ud->deepdata->set_samples(
-                        (y + ud->cury) * fullwidth + xoff + x,
-                        decode->sample_count_table[y * w + x]);
-        }
-        for (int y = 0; y < h; ++y)
-            for (int x = 0; x < w; ++x)
-                for (int c = 0; c < chans; ++c)
-                    ud->linepointers[(y * w + x) * chans + c]
-                        = ud->deepdata->data_ptr((y + ud->cury) * fullwidth
-                                                     + xoff + x,
-                                                 c, 0);
+        // The DeepData was sized once for the whole region before any
+        // chunk was decoded, so every chunk just decodes in place through
+        // its window of the shared pointer table.
+        OIIO_DASSERT(ud->allpointers);
+        cdata = ud->allpointers
+                + (size_t(ud->cury) * ud->fullwidth + ud->xoff) * chans;
+        linewidth = ud->fullwidth;
     }
 
     const ImageSpec& spec = *(ud->spec);
     size_t chanoffset     = 0;
-    void** cdata          = &(ud->linepointers[0]);
     for (int c = ud->chbegin; c < ud->chend; ++c) {
         string_view cname = spec.channel_name(c);
         for (int dc = 0; dc < decode->channel_count; ++dc) {
@@ -1629,7 +1746,7 @@ realloc_deepdata(exr_decode_pipeline_t* decode)
                     cdata + chanoffset);
                 curchan.user_bytes_per_element = ud->deepdata->samplesize();
                 curchan.user_pixel_stride      = size_t(chans) * sizeof(void*);
-                curchan.user_line_stride       = (size_t(w) * size_t(chans)
+                curchan.user_line_stride       = (linewidth * size_t(chans)
                                             * sizeof(void*));
                 chanoffset += 1;
                 break;
@@ -1669,15 +1786,15 @@ OpenEXRCoreInput::read_native_deep_scanlines(int subimage, int miplevel,
                   spec.channelnames);
 
     deepdecode_userdata ud;
-    ud.cury       = 0;
-    ud.nchans     = nchans;
-    ud.chbegin    = chbegin;
-    ud.chend      = chend;
-    ud.spec       = &spec;
-    ud.fullwidth  = spec.width;
-    ud.xoff       = 0;
-    ud.deepdata   = &deepdata;
-    ud.samplesset = false;
+    ud.cury        = 0;
+    ud.nchans      = nchans;
+    ud.chbegin     = chbegin;
+    ud.chend       = chend;
+    ud.spec        = &spec;
+    ud.fullwidth   = spec.width;
+    ud.xoff        = 0;
+    ud.deepdata    = &deepdata;
+    ud.allpointers = nullptr;
 
     int32_t scansperchunk;
     exr_result_t rv = exr_get_scanlines_per_chunk(m_exr_context, subimage,
@@ -1692,8 +1809,11 @@ OpenEXRCoreInput::read_native_deep_scanlines(int subimage, int miplevel,
 
     std::atomic<bool> ok(true);
     ud.firstisfullread = (yend - ybegin) == scansperchunk;
-    // it is very slow to update the number of samples one at a time, so when not
-    // only reading one line, make a pass and load all the sample counts
+    // When reading more than one chunk, first fetch the sample counts of
+    // every chunk (in parallel), so that the DeepData can be sized exactly
+    // once, and then decode all the sample data in parallel straight into
+    // its final place.
+    std::vector<void*> allpointers;
     if (!ud.firstisfullread) {
         std::vector<unsigned int> all_samples(npixels);
         parallel_for_chunked(
@@ -1747,7 +1867,8 @@ OpenEXRCoreInput::read_native_deep_scanlines(int subimage, int miplevel,
             return false;
         }
         deepdata.set_all_samples(all_samples);
-        ud.samplesset = true;
+        deepdata.get_pointers(allpointers);
+        ud.allpointers = allpointers.data();
     }
 
     parallel_for_chunked(
@@ -1866,12 +1987,15 @@ OpenEXRCoreInput::read_native_deep_tiles(int subimage, int miplevel, int xbegin,
     ud.xoff            = 0;
     ud.deepdata        = &deepdata;
     ud.firstisfullread = nxtiles == 1 && nytiles == 1;
-    ud.samplesset      = false;
+    ud.allpointers     = nullptr;
 
     std::atomic<bool> ok(true);
 
-    // it is very slow to update the number of samples one at a time, so when not
-    // only reading one line, make a pass and load all the sample counts
+    // When reading more than one tile, first fetch the sample counts of
+    // every tile (in parallel), so that the DeepData can be sized exactly
+    // once, and then decode all the sample data in parallel straight into
+    // its final place.
+    std::vector<void*> allpointers;
     if (!ud.firstisfullread) {
         std::vector<uint32_t> all_samples(npixels);
         parallel_for_2D(
@@ -1915,10 +2039,14 @@ OpenEXRCoreInput::read_native_deep_tiles(int subimage, int miplevel, int xbegin,
                 }
             },
             threads());
-        if (!ok)
+        if (!ok) {
+            geterror(true);  // clear the error, issue our own
+            errorfmt("Some tiles were missing or corrupted");
             return false;
+        }
         deepdata.set_all_samples(all_samples);
-        ud.samplesset = true;
+        deepdata.get_pointers(allpointers);
+        ud.allpointers = allpointers.data();
     }
 
     parallel_for_2D(
@@ -60,11 +60,17 @@ OIIO_GCC_PRAGMA(GCC diagnostic ignored "-Wunused-parameter")
 OIIO_PRAGMA_WARNING_POP
 OIIO_PRAGMA_VISIBILITY_POP
 
+#if OPENEXR_CODED_VERSION >= 30100 && defined(OIIO_USE_EXR_C_API)
+#    define USE_OPENEXR_CORE
+#endif
+
+#include "imageio_pvt.h"
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/deepdata.h>
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/thread.h>
@@ -135,6 +141,13 @@ public:
         return true;
     }
 
+    // Doctor the specs and build the Imf headers exactly as open() would,
+    // but without opening any file. The core library output uses this so
+    // that both write paths agree on the metadata they emit.
+    bool make_headers(int subimages, const ImageSpec* specs,
+                      std::vector<ImageSpec>& outspecs,
+                      std::vector<Imf::Header>& headers);
+
 private:
     std::unique_ptr<OpenEXROutputStream>
         m_output_stream;  ///< Stream for output file
@@ -158,6 +171,7 @@ private:
     std::vector<unsigned char> m_scratch;     ///< Scratch space for us to use
     std::vector<ImageSpec> m_subimagespecs;   ///< Saved subimage specs
     std::vector<Imf::Header> m_headers;
+    bool m_copied_all_levels;  ///< copy_image already wrote every MIP level
     Filesystem::IOProxy* m_io = nullptr;
     std::unique_ptr<Filesystem::IOProxy> m_local_io;
 
@@ -172,9 +186,10 @@ private:
         m_tiled_output_part.reset();
         m_deep_scanline_output_part.reset();
         m_deep_tiled_output_part.reset();
-        m_levelmode = Imf::ONE_LEVEL;
-        m_subimage  = -1;
-        m_miplevel  = -1;
+        m_levelmode         = Imf::ONE_LEVEL;
+        m_subimage          = -1;
+        m_miplevel          = -1;
+        m_copied_all_levels = false;
         m_subimagespecs.clear();
         m_subimagespecs.shrink_to_fit();
         m_headers.clear();
@@ -227,6 +242,12 @@ OIIO_PLUGIN_EXPORTS_BEGIN
 OIIO_EXPORT ImageOutput*
 openexr_output_imageio_create()
 {
+#ifdef USE_OPENEXR_CORE
+    if (pvt::openexr_core_output) {
+        extern ImageOutput* openexrcore_output_imageio_create();
+        return openexrcore_output_imageio_create();
+    }
+#endif
     return new OpenEXROutput;
 }
 
@@ -263,6 +284,9 @@ set_exr_threads()
     } else if (oiio_threads == -1) {
         oiio_threads = 0;
     }
+    // OpenEXR's own pool counts against the OIIO thread budget, if any
+    if (thread_budget() > 0)
+        oiio_threads = std::min(oiio_threads, thread_budget());
     spin_lock lock(exr_threads_mutex);
     if (exr_threads != oiio_threads) {
         exr_threads = oiio_threads;
@@ -293,6 +317,25 @@ set_exr_threads()
 
 
 
+ImageOutput*
+openexr_imf_output_create()
+{
+    return new OpenEXROutput;
+}
+
+
+
+bool
+openexr_output_headers(ImageOutput* imfout, int subimages,
+                       const ImageSpec* specs, std::vector<ImageSpec>& outspecs,
+                       std::vector<Imf::Header>& headers)
+{
+    return static_cast<OpenEXROutput*>(imfout)->make_headers(subimages, specs,
+                                                             outspecs, headers);
+}
+
+
+
 OpenEXROutput::OpenEXROutput()
 {
     pvt::set_exr_threads();
@@ -443,26 +486,28 @@ OpenEXROutput::open(const std::string& name, const ImageSpec& userspec,
             errorfmt("More subimages than originally declared.");
             return false;
         }
-        // Close the current subimage, open the next one
+        // Close the current subimage, open the next one. Parts needn't all
+        // be of the same kind, so go by the new part's own spec.
+        const ImageSpec& partspec(m_subimagespecs[m_subimage]);
+        m_scanline_output_part.reset();
+        m_tiled_output_part.reset();
+        m_deep_scanline_output_part.reset();
+        m_deep_tiled_output_part.reset();
         try {
-            if (m_tiled_output_part) {
-                m_tiled_output_part.reset(
-                    new Imf::TiledOutputPart(*m_output_multipart, m_subimage));
-            } else if (m_scanline_output_part) {
-                m_scanline_output_part.reset(
-                    new Imf::OutputPart(*m_output_multipart, m_subimage));
-            } else if (m_deep_tiled_output_part) {
+            if (partspec.deep && partspec.tile_width) {
                 m_deep_tiled_output_part.reset(
                     new Imf::DeepTiledOutputPart(*m_output_multipart,
                                                  m_subimage));
-            } else if (m_deep_scanline_output_part) {
+            } else if (partspec.deep) {
                 m_deep_scanline_output_part.reset(
                     new Imf::DeepScanLineOutputPart(*m_output_multipart,
                                                     m_subimage));
+            } else if (partspec.tile_width) {
+                m_tiled_output_part.reset(
+                    new Imf::TiledOutputPart(*m_output_multipart, m_subimage));
             } else {
-                errorfmt(
-                    "Called open with AppendSubimage mode, but no appropriate part is found. Application bug?");
-                return false;
+                m_scanline_output_part.reset(
+                    new Imf::OutputPart(*m_output_multipart, m_subimage));
             }
         } catch (const std::exception& e) {
             errorfmt("OpenEXR exception: {}", e.what());
@@ -638,6 +683,38 @@ OpenEXROutput::open(const std::string& name, int subimages,
 
 
 
+bool
+OpenEXROutput::make_headers(int subimages, const ImageSpec* specs,
+                            std::vector<ImageSpec>& outspecs,
+                            std::vector<Imf::Header>& headers)
+{
+    if (subimages < 1) {
+        errorfmt("OpenEXR does not support {} subimages.", subimages);
+        return false;
+    }
+    m_nsubimages = subimages;
+    outspecs.resize(subimages);
+    headers.resize(subimages);
+    for (int s = 0; s < subimages; ++s) {
+        if (!copy_and_check_spec(specs[s], m_spec))
+            return false;
+        sanity_check_channelnames();
+        outspecs[s] = m_spec;
+        if (!spec_to_header(outspecs[s], s, headers[s]))
+            return false;
+        if (subimages > 1 || outspecs[s].deep) {
+            bool tiled = outspecs[s].tile_width;
+            headers[s].setType(
+                outspecs[s].deep
+                    ? (tiled ? Imf::DEEPTILE : Imf::DEEPSCANLINE)
+                    : (tiled ? Imf::TILEDIMAGE : Imf::SCANLINEIMAGE));
+        }
+    }
+    return true;
+}
+
+
+
 Imf::PixelType
 OpenEXROutput::imfpixeltype(TypeDesc type)
 {
@@ -1409,15 +1486,29 @@ OpenEXROutput::copy_image(ImageInput* in)
 {
     if (in && !strcmp(in->format_name(), "openexr")) {
         if (OpenEXRInput* exr_in = dynamic_cast<OpenEXRInput*>(in)) {
-            // Copy over pixels without decompression.
+            // A tiled copyPixels moves every MIP level of the part at once,
+            // so the copies for the levels appended after it have nothing
+            // left to do.
+            if (m_miplevel > 0 && m_copied_all_levels)
+                return true;
+            m_copied_all_levels = false;
+            // Copy over the compressed chunks without decompression. The
+            // input is always read through parts, which OpenEXR lets us
+            // copy into either a single-part file or any output part. It
+            // only requires the data window, channels, compression, line
+            // order and tiling to agree; other metadata may differ freely.
+            // For tiled images, the level structures must match too, and
+            // the copy has to start at the top level of both files.
+            bool tiled_ok = (m_miplevel == 0 && in->current_miplevel() == 0);
             try {
                 if (m_output_scanline && exr_in->m_scanline_input_part) {
                     m_output_scanline->copyPixels(
                         *exr_in->m_scanline_input_part);
                     return true;
                 } else if (m_output_tiled && exr_in->m_tiled_input_part
-                           && m_nmiplevels == 0) {
+                           && tiled_ok) {
                     m_output_tiled->copyPixels(*exr_in->m_tiled_input_part);
+                    m_copied_all_levels = true;
                     return true;
                 } else if (m_scanline_output_part
                            && exr_in->m_scanline_input_part) {
@@ -1425,9 +1516,10 @@ OpenEXROutput::copy_image(ImageInput* in)
                         *exr_in->m_scanline_input_part);
                     return true;
                 } else if (m_tiled_output_part && exr_in->m_tiled_input_part
-                           && m_nmiplevels == 0) {
+                           && tiled_ok) {
                     m_tiled_output_part->copyPixels(
                         *exr_in->m_tiled_input_part);
+                    m_copied_all_levels = true;
                     return true;
                 } else if (m_deep_scanline_output_part
                            && exr_in->m_deep_scanline_input_part) {
@@ -1435,21 +1527,16 @@ OpenEXROutput::copy_image(ImageInput* in)
                         *exr_in->m_deep_scanline_input_part);
                     return true;
                 } else if (m_deep_tiled_output_part
-                           && exr_in->m_deep_tiled_input_part
-                           && m_nmiplevels == 0) {
+                           && exr_in->m_deep_tiled_input_part && tiled_ok) {
                     m_deep_tiled_output_part->copyPixels(
                         *exr_in->m_deep_tiled_input_part);
+                    m_copied_all_levels = true;
                     return true;
                 }
-            } catch (const std::exception& e) {
-                errorfmt(
-                    "Failed OpenEXR copy: {}, falling back to the default image copy routine.",
-                    e.what());
-                return false;
-            } catch (...) {  // catch-all for edge cases or compiler bugs
-                errorfmt(
-                    "Failed OpenEXR copy: unknown exception, falling back to the default image copy routine.");
-                return false;
+            } catch (...) {
+                // OpenEXR checks that the headers are compatible before it
+                // writes anything, so a mismatch leaves nothing behind and
+                // we can still decode and re-encode the pixels below.
             }
         }
     }
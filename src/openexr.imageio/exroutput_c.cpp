@@ -0,0 +1,1173 @@
+// Copyright 2021-present Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <OpenImageIO/Imath.h>
+#include <OpenImageIO/platform.h>
+
+#include "exr_pvt.h"
+
+#include <OpenEXR/openexr.h>
+
+// The way that OpenEXR uses dynamic casting for attributes requires
+// temporarily suspending "hidden" symbol visibility mode.
+OIIO_PRAGMA_VISIBILITY_PUSH
+OIIO_PRAGMA_WARNING_PUSH
+OIIO_GCC_PRAGMA(GCC diagnostic ignored "-Wunused-parameter")
+#include <OpenEXR/ImfBoxAttribute.h>
+#include <OpenEXR/ImfChannelList.h>
+#include <OpenEXR/ImfChromaticitiesAttribute.h>
+#include <OpenEXR/ImfDoubleAttribute.h>
+#include <OpenEXR/ImfEnvmapAttribute.h>
+#include <OpenEXR/ImfFloatAttribute.h>
+#include <OpenEXR/ImfFloatVectorAttribute.h>
+#include <OpenEXR/ImfHeader.h>
+#include <OpenEXR/ImfIntAttribute.h>
+#include <OpenEXR/ImfKeyCodeAttribute.h>
+#include <OpenEXR/ImfMatrixAttribute.h>
+#include <OpenEXR/ImfRationalAttribute.h>
+#include <OpenEXR/ImfStringAttribute.h>
+#include <OpenEXR/ImfStringVectorAttribute.h>
+#include <OpenEXR/ImfTimeCodeAttribute.h>
+#include <OpenEXR/ImfVecAttribute.h>
+OIIO_PRAGMA_WARNING_POP
+OIIO_PRAGMA_VISIBILITY_POP
+
+#include "imageio_pvt.h"
+#include <OpenImageIO/dassert.h>
+#include <OpenImageIO/deepdata.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/fmath.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/thread.h>
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+struct oiioexr_outbuf_struct {
+    ImageOutput* m_img        = nullptr;
+    Filesystem::IOProxy* m_io = nullptr;
+};
+
+static void
+oiio_exr_output_error_handler(exr_const_context_t ctxt, exr_result_t code,
+                              const char* msg = nullptr)
+{
+    void* userdata;
+    if (EXR_ERR_SUCCESS == exr_get_user_data(ctxt, &userdata)) {
+        if (userdata) {
+            oiioexr_outbuf_struct* fb = static_cast<oiioexr_outbuf_struct*>(
+                userdata);
+            if (fb->m_img) {
+                fb->m_img->errorfmt("EXR Error ({}): {} {}",
+                                    (fb->m_io ? fb->m_io->filename().c_str()
+                                              : "<unknown>"),
+                                    exr_get_error_code_as_string(code),
+                                    msg ? msg
+                                        : exr_get_default_error_message(code));
+            }
+        }
+    }
+}
+
+static int64_t
+oiio_exr_write_func(exr_const_context_t ctxt, void* userdata,
+                    const void* buffer, uint64_t sz, uint64_t offset,
+                    exr_stream_error_func_ptr_t error_cb)
+{
+    oiioexr_outbuf_struct* fb = static_cast<oiioexr_outbuf_struct*>(userdata);
+    int64_t nwritten          = -1;
+    if (fb) {
+        Filesystem::IOProxy* io = fb->m_io;
+        if (io) {
+            size_t retval = io->pwrite(buffer, sz, offset);
+            if (retval == size_t(sz)) {
+                nwritten = static_cast<int64_t>(retval);
+            } else {
+                std::string err = io->error();
+                error_cb(ctxt, EXR_ERR_WRITE_IO,
+                         "Could not write to file: \"%s\" (%s)",
+                         io->filename().c_str(),
+                         err.empty() ? "<unknown error>" : err.c_str());
+            }
+        }
+    }
+    return nwritten;
+}
+
+// The encoding pipeline normally writes each chunk as soon as it is
+// compressed, from whichever thread compressed it. We write the chunks
+// ourselves, in file order, so the pipeline's own write step does nothing.
+static exr_result_t
+oiio_exr_defer_write(exr_encode_pipeline_t* /*encoder*/)
+{
+    return EXR_ERR_SUCCESS;
+}
+
+
+
+class OpenEXRCoreOutput final : public ImageOutput {
+public:
+    OpenEXRCoreOutput();
+    ~OpenEXRCoreOutput() override;
+    const char* format_name(void) const override { return "openexr"; }
+    int supports(string_view feature) const override;
+    bool open(const std::string& name, const ImageSpec& spec,
+              OpenMode mode = Create) override;
+    bool open(const std::string& name, int subimages,
+              const ImageSpec* specs) override;
+    bool close() override;
+    bool write_scanline(int y, int z, TypeDesc format, const void* data,
+                        stride_t xstride) override;
+    bool write_scanlines(int ybegin, int yend, int z, TypeDesc format,
+                         const void* data, stride_t xstride,
+                         stride_t ystride) override;
+    bool write_tile(int x, int y, int z, TypeDesc format, const void* data,
+                    stride_t xstride, stride_t ystride,
+                    stride_t zstride) override;
+    bool write_tiles(int xbegin, int xend, int ybegin, int yend, int zbegin,
+                     int zend, TypeDesc format, const void* data,
+                     stride_t xstride, stride_t ystride,
+                     stride_t zstride) override;
+    bool write_deep_scanlines(int ybegin, int yend, int z,
+                              const DeepData& deepdata) override;
+    bool write_deep_tiles(int xbegin, int xend, int ybegin, int yend,
+                          int zbegin, int zend,
+                          const DeepData& deepdata) override;
+    bool set_ioproxy(Filesystem::IOProxy* ioproxy) override
+    {
+        OIIO_ASSERT(!m_exr_context);
+        m_userdata.m_io = ioproxy;
+        return true;
+    }
+
+private:
+    // One chunk (a tile, or a block of scanlines) to encode and write.
+    struct ChunkJob {
+        int64_t index = 0;  ///< Chunk index within the part, in file order
+        int x         = 0;  ///< Tile x index (tiled files)
+        int y         = 0;  ///< Tile y index, or first scanline of the chunk
+        const unsigned char* pixels = nullptr;  ///< Native, contiguous pixels
+        stride_t linestride         = 0;        ///< Bytes between lines
+        std::vector<unsigned char> storage;     ///< Owns pixels, if needed
+        exr_encode_pipeline_t encoder = EXR_ENCODE_PIPELINE_INITIALIZER;
+        exr_result_t result           = EXR_ERR_SUCCESS;
+        bool initialized              = false;
+    };
+
+    // An encoded chunk that arrived before the ones preceding it in the
+    // file, held until it can be written in order.
+    struct PendingChunk {
+        int x, y, level;
+        std::vector<unsigned char> bytes;
+    };
+
+    exr_context_t m_exr_context = nullptr;
+    oiioexr_outbuf_struct m_userdata;
+    std::unique_ptr<Filesystem::IOProxy> m_local_io;
+    std::unique_ptr<ImageOutput> m_imf;  ///< C++ library output, if delegating
+    bool m_delegate = false;             ///< Is m_imf doing all the work?
+    int m_subimage;                      ///< What subimage we're writing now
+    int m_nsubimages;                    ///< How many subimages are there?
+    int m_miplevel;                      ///< What miplevel we're writing now
+    int m_nmiplevels;                    ///< How many mip levels are there?
+    int m_levelmode;                     ///< Level mode of current subimage
+    int m_chunklines;                    ///< Scanlines per chunk
+    std::vector<ImageSpec> m_subimagespecs;  ///< Doctored subimage specs
+    std::vector<Imf::Header> m_headers;      ///< Headers they translate to
+    std::vector<exr_pixel_type_t> m_pixeltype;  ///< Pixel type per channel
+    std::vector<int64_t> m_level_firstchunk;  ///< First chunk of each level
+    std::vector<int> m_level_xtiles;          ///< Tiles across each level
+    int64_t m_next_chunk;                     ///< Next chunk to write
+    std::map<int64_t, PendingChunk> m_pending;
+    std::vector<unsigned char> m_partial;  ///< Incomplete scanline chunk
+    int m_partial_y;                       ///< First scanline of m_partial
+    int m_partial_lines;                   ///< Scanlines filled in m_partial
+    std::vector<unsigned char> m_scratch;  ///< Scratch space for us to use
+
+    // Initialize private members to pre-opened state
+    void init(void)
+    {
+        m_exr_context    = nullptr;
+        m_userdata.m_img = this;
+        m_userdata.m_io  = nullptr;
+        m_local_io.reset();
+        m_delegate   = false;
+        m_subimage   = -1;
+        m_nsubimages = 0;
+        m_miplevel   = -1;
+        m_nmiplevels = 1;
+        m_levelmode  = EXR_TILE_ONE_LEVEL;
+        m_chunklines = 1;
+        m_subimagespecs.clear();
+        m_headers.clear();
+        m_pending.clear();
+        m_partial.clear();
+        m_partial_y     = 0;
+        m_partial_lines = 0;
+    }
+
+    // Pass along the result of (and any error from) a call that was
+    // forwarded to the C++ library output.
+    bool delegated(bool ok)
+    {
+        if (m_imf->has_error())
+            errorfmt("{}", m_imf->geterror());
+        m_spec = m_imf->spec();
+        return ok;
+    }
+
+    // Are there features in these headers that we leave to the C++
+    // library?
+    static bool needs_imf(const std::vector<Imf::Header>& headers);
+
+    // Define part `subimage` of the file from its Imf header.
+    bool add_part(int subimage);
+
+    // Translate one Imf header attribute into a core library attribute.
+    void put_attribute(int part, const char* name,
+                       const Imf::Attribute& attr);
+
+    // Get ready to write the pixels of the current subimage.
+    bool begin_part();
+
+    // Write any incomplete scanline chunk and check that nothing was left
+    // unwritten in the current part.
+    bool end_part();
+
+    // Compress all the jobs (in parallel, when possible) and write them
+    // to the file in chunk order.
+    bool encode_and_write(std::vector<ChunkJob>& jobs);
+
+    // Write an encoded chunk, or hold it if its predecessors aren't out yet.
+    bool write_chunk(int64_t index, int x, int y, int level, const void* data,
+                     size_t size);
+    bool write_raw_chunk(int x, int y, int level, const void* data,
+                         size_t size);
+
+    // Finish the file for real (close() may leave a MIP-mapped file open).
+    bool finish();
+};
+
+
+
+OIIO_EXPORT ImageOutput*
+openexrcore_output_imageio_create()
+{
+    return new OpenEXRCoreOutput;
+}
+
+
+
+OpenEXRCoreOutput::OpenEXRCoreOutput() { init(); }
+
+
+
+OpenEXRCoreOutput::~OpenEXRCoreOutput()
+{
+    // Close, if not already done.
+    finish();
+}
+
+
+
+int
+OpenEXRCoreOutput::supports(string_view feature) const
+{
+    // Deep files are handed off to the C++ library, so we support
+    // everything that OpenEXROutput does.
+    if (feature == "tiles" || feature == "mipmap" || feature == "alpha"
+        || feature == "nchannels" || feature == "channelformats"
+        || feature == "displaywindow" || feature == "origin"
+        || feature == "negativeorigin" || feature == "arbitrary_metadata"
+        || feature == "exif"  // Because of arbitrary_metadata
+        || feature == "iptc"  // Because of arbitrary_metadata
+        || feature == "multiimage" || feature == "deepdata"
+        || feature == "ioproxy")
+        return true;
+
+    // EXR supports random write order iff lineOrder is set to 'random Y'
+    // and it's a tiled file.
+    if (feature == "random_access" && m_spec.tile_width != 0)
+        return Strutil::iequals(m_spec.get_string_attribute(
+                                    "openexr:lineOrder"),
+                                "randomY");
+
+    return false;
+}
+
+
+
+bool
+OpenEXRCoreOutput::needs_imf(const std::vector<Imf::Header>& headers)
+{
+    for (const auto& h : headers) {
+        // No deep support here.
+        if (h.hasType()
+            && (h.type() == Imf::DEEPSCANLINE || h.type() == Imf::DEEPTILE))
+            return true;
+        // Decreasing-Y files need their chunks written last to first,
+        // which the C++ library arranges for us.
+        if (h.lineOrder() == Imf::DECREASING_Y)
+            return true;
+        // Rip-mapped levels aren't written by this path.
+        if (h.hasTileDescription()
+            && h.tileDescription().mode == Imf::RIPMAP_LEVELS)
+            return true;
+#if OPENEXR_CODED_VERSION < 30110
+        // The core library only properly encodes DWA as of 3.1.10.
+        if (h.compression() == Imf::DWAA_COMPRESSION
+            || h.compression() == Imf::DWAB_COMPRESSION)
+            return true;
+#endif
+    }
+    return false;
+}
+
+
+
+bool
+OpenEXRCoreOutput::open(const std::string& name, const ImageSpec& userspec,
+                        OpenMode mode)
+{
+    if (mode == Create)
+        return open(name, 1, &userspec);
+
+    if (m_delegate)
+        return delegated(m_imf->open(name, userspec, mode));
+
+    if (mode == AppendSubimage) {
+        if (!m_exr_context) {
+            errorfmt("{} not opened properly for subimages", format_name());
+            return false;
+        }
+        if (m_subimage + 1 >= m_nsubimages) {
+            errorfmt("More subimages than originally declared.");
+            return false;
+        }
+        if (!end_part())
+            return false;
+        ++m_subimage;
+        return begin_part();
+    }
+
+    if (mode == AppendMIPLevel) {
+        if (!m_exr_context) {
+            errorfmt("Cannot append a MIP level if no file has been opened");
+            return false;
+        }
+        if (m_spec.tile_width && m_levelmode != EXR_TILE_ONE_LEVEL
+            && m_miplevel + 1 < m_nmiplevels) {
+            // OpenEXR does not support differing tile sizes on different
+            // MIP-map levels.  Reject the open() if not using the original
+            // tile sizes.
+            if (userspec.tile_width != m_spec.tile_width
+                || userspec.tile_height != m_spec.tile_height) {
+                errorfmt(
+                    "OpenEXR tiles must have the same size on all MIPmap levels");
+                return false;
+            }
+            // Copy the new mip level size.  Keep everything else from the
+            // original level.
+            m_spec.width  = userspec.width;
+            m_spec.height = userspec.height;
+            ++m_miplevel;
+            return true;
+        } else {
+            errorfmt("Cannot add MIP level to a non-MIPmapped file");
+            return false;
+        }
+    }
+
+    errorfmt("Unknown open mode {}", int(mode));
+    return false;
+}
+
+
+
+bool
+OpenEXRCoreOutput::open(const std::string& name, int subimages,
+                        const ImageSpec* specs)
+{
+    if (m_exr_context || m_delegate)
+        finish();
+
+    // Let the C++ library output decide exactly what the headers should
+    // be, so that both paths write identical metadata.
+    m_imf.reset(openexr_imf_output_create());
+    m_imf->threads(threads());
+    if (!openexr_output_headers(m_imf.get(), subimages, specs,
+                                m_subimagespecs, m_headers)) {
+        if (m_imf->has_error())
+            errorfmt("{}", m_imf->geterror());
+        return false;
+    }
+    if (needs_imf(m_headers)) {
+        DBGEXR("exr core output: delegating \"{}\" to Imf\n", name);
+        m_delegate = true;
+        if (m_userdata.m_io)
+            m_imf->set_ioproxy(m_userdata.m_io);
+        return delegated(m_imf->open(name, subimages, specs));
+    }
+
+    // Establish an output stream. If we weren't given an IOProxy, create
+    // one now that just writes to the file.
+    if (!m_userdata.m_io) {
+        if (const ParamValue* param
+            = specs[0].find_attribute("oiio:ioproxy", TypeDesc::PTR))
+            m_userdata.m_io = param->get<Filesystem::IOProxy*>();
+    }
+    if (!m_userdata.m_io) {
+        m_userdata.m_io = new Filesystem::IOFile(name,
+                                                 Filesystem::IOProxy::Write);
+        m_local_io.reset(m_userdata.m_io);
+    }
+    if (m_userdata.m_io->mode() != Filesystem::IOProxy::Write) {
+        // If the proxy couldn't be opened in write mode, try to
+        // return an error.
+        std::string e = m_userdata.m_io->error();
+        errorfmt("Could not open \"{}\" ({})", name,
+                 e.size() ? e : std::string("unknown error"));
+        m_local_io.reset();
+        m_userdata.m_io = nullptr;
+        return false;
+    }
+
+    m_userdata.m_img                = this;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &oiio_exr_output_error_handler;
+    cinit.user_data                 = &m_userdata;
+    cinit.write_fn                  = &oiio_exr_write_func;
+
+    exr_result_t rv = exr_start_write(&m_exr_context, name.c_str(),
+                                      EXR_WRITE_FILE_DIRECTLY, &cinit);
+    if (rv != EXR_ERR_SUCCESS) {
+        // the error handler would have already reported the error into us
+        m_exr_context = nullptr;
+        m_local_io.reset();
+        m_userdata.m_io = nullptr;
+        return false;
+    }
+    m_nsubimages = subimages;
+    for (int s = 0; s < subimages; ++s)
+        if (!add_part(s))
+            return false;
+    rv = exr_write_header(m_exr_context);
+    if (rv != EXR_ERR_SUCCESS)
+        return false;
+
+    m_subimage = 0;
+    return begin_part();
+}
+
+
+
+bool
+OpenEXRCoreOutput::add_part(int subimage)
+{
+    const Imf::Header& header(m_headers[subimage]);
+    const ImageSpec& spec(m_subimagespecs[subimage]);
+    bool tiled           = spec.tile_width != 0;
+    const char* partname = header.hasName() ? header.name().c_str() : nullptr;
+    int part             = 0;
+    exr_result_t rv      = exr_add_part(m_exr_context, partname,
+                                        tiled ? EXR_STORAGE_TILED
+                                                   : EXR_STORAGE_SCANLINE,
+                                        &part);
+    if (rv != EXR_ERR_SUCCESS)
+        return false;
+    OIIO_DASSERT(part == subimage);
+
+    exr_attr_box2i_t displaywindow, datawindow;
+    displaywindow.min.x = header.displayWindow().min.x;
+    displaywindow.min.y = header.displayWindow().min.y;
+    displaywindow.max.x = header.displayWindow().max.x;
+    displaywindow.max.y = header.displayWindow().max.y;
+    datawindow.min.x    = header.dataWindow().min.x;
+    datawindow.min.y    = header.dataWindow().min.y;
+    datawindow.max.x    = header.dataWindow().max.x;
+    datawindow.max.y    = header.dataWindow().max.y;
+    exr_attr_v2f_t swc;
+    swc.x = header.screenWindowCenter().x;
+    swc.y = header.screenWindowCenter().y;
+    rv    = exr_initialize_required_attr(
+        m_exr_context, part, &displaywindow, &datawindow,
+        header.pixelAspectRatio(), &swc, header.screenWindowWidth(),
+        exr_lineorder_t(header.lineOrder()),
+        exr_compression_t(header.compression()));
+    if (rv != EXR_ERR_SUCCESS)
+        return false;
+
+    for (auto c = header.channels().begin(); c != header.channels().end();
+         ++c) {
+        const Imf::Channel& chan(c.channel());
+        rv = exr_add_channel(m_exr_context, part, c.name(),
+                             exr_pixel_type_t(chan.type),
+                             chan.pLinear ? EXR_PERCEPTUALLY_LINEAR
+                                          : EXR_PERCEPTUALLY_LOGARITHMIC,
+                             chan.xSampling, chan.ySampling);
+        if (rv != EXR_ERR_SUCCESS)
+            return false;
+    }
+
+    if (tiled) {
+        const Imf::TileDescription& td(header.tileDescription());
+        rv = exr_set_tile_descriptor(m_exr_context, part, td.xSize, td.ySize,
+                                     exr_tile_level_mode_t(td.mode),
+                                     exr_tile_round_mode_t(td.roundingMode));
+        if (rv != EXR_ERR_SUCCESS)
+            return false;
+    }
+
+#if OPENEXR_CODED_VERSION >= 30103
+    if (header.compression() == Imf::ZIP_COMPRESSION
+        || header.compression() == Imf::ZIPS_COMPRESSION)
+        exr_set_zip_compression_level(m_exr_context, part,
+                                      header.zipCompressionLevel());
+#endif
+    if (auto dwa = header.findTypedAttribute<Imf::FloatAttribute>(
+            "dwaCompressionLevel"))
+        exr_set_dwa_compression_level(m_exr_context, part, dwa->value());
+
+    // Everything else is ordinary metadata.
+    static const char* required[] = { "channels",
+                                      "compression",
+                                      "dataWindow",
+                                      "displayWindow",
+                                      "lineOrder",
+                                      "pixelAspectRatio",
+                                      "screenWindowCenter",
+                                      "screenWindowWidth",
+                                      "tiles",
+                                      "name",
+                                      "type",
+                                      "version",
+                                      "chunkCount" };
+    for (auto a = header.begin(); a != header.end(); ++a) {
+        bool skip = false;
+        for (const char* r : required)
+            skip |= !strcmp(a.name(), r);
+        if (!skip)
+            put_attribute(part, a.name(), a.attribute());
+    }
+    return true;
+}
+
+
+
+void
+OpenEXRCoreOutput::put_attribute(int part, const char* name,
+                                 const Imf::Attribute& attr)
+{
+    exr_context_t ctx = m_exr_context;
+    exr_result_t rv   = EXR_ERR_SUCCESS;
+    if (auto a = dynamic_cast<const Imf::StringAttribute*>(&attr)) {
+        rv = exr_attr_set_string(ctx, part, name, a->value().c_str());
+    } else if (auto a = dynamic_cast<const Imf::IntAttribute*>(&attr)) {
+        rv = exr_attr_set_int(ctx, part, name, a->value());
+    } else if (auto a = dynamic_cast<const Imf::FloatAttribute*>(&attr)) {
+        rv = exr_attr_set_float(ctx, part, name, a->value());
+    } else if (auto a = dynamic_cast<const Imf::DoubleAttribute*>(&attr)) {
+        rv = exr_attr_set_double(ctx, part, name, a->value());
+    } else if (auto a = dynamic_cast<const Imf::M33fAttribute*>(&attr)) {
+        exr_attr_m33f_t m;
+        memcpy(m.m, a->value().getValue(), sizeof(m.m));
+        rv = exr_attr_set_m33f(ctx, part, name, &m);
+    } else if (auto a = dynamic_cast<const Imf::M33dAttribute*>(&attr)) {
+        exr_attr_m33d_t m;
+        memcpy(m.m, a->value().getValue(), sizeof(m.m));
+        rv = exr_attr_set_m33d(ctx, part, name, &m);
+    } else if (auto a = dynamic_cast<const Imf::M44fAttribute*>(&attr)) {
+        exr_attr_m44f_t m;
+        memcpy(m.m, a->value().getValue(), sizeof(m.m));
+        rv = exr_attr_set_m44f(ctx, part, name, &m);
+    } else if (auto a = dynamic_cast<const Imf::M44dAttribute*>(&attr)) {
+        exr_attr_m44d_t m;
+        memcpy(m.m, a->value().getValue(), sizeof(m.m));
+        rv = exr_attr_set_m44d(ctx, part, name, &m);
+    } else if (auto a = dynamic_cast<const Imf::V2iAttribute*>(&attr)) {
+        exr_attr_v2i_t v;
+        v.x = a->value().x;
+        v.y = a->value().y;
+        rv  = exr_attr_set_v2i(ctx, part, name, &v);
+    } else if (auto a = dynamic_cast<const Imf::V2fAttribute*>(&attr)) {
+        exr_attr_v2f_t v;
+        v.x = a->value().x;
+        v.y = a->value().y;
+        rv  = exr_attr_set_v2f(ctx, part, name, &v);
+    } else if (auto a = dynamic_cast<const Imf::V2dAttribute*>(&attr)) {
+        exr_attr_v2d_t v;
+        v.x = a->value().x;
+        v.y = a->value().y;
+        rv  = exr_attr_set_v2d(ctx, part, name, &v);
+    } else if (auto a = dynamic_cast<const Imf::V3iAttribute*>(&attr)) {
+        exr_attr_v3i_t v;
+        v.x = a->value().x;
+        v.y = a->value().y;
+        v.z = a->value().z;
+        rv  = exr_attr_set_v3i(ctx, part, name, &v);
+    } else if (auto a = dynamic_cast<const Imf::V3fAttribute*>(&attr)) {
+        exr_attr_v3f_t v;
+        v.x = a->value().x;
+        v.y = a->value().y;
+        v.z = a->value().z;
+        rv  = exr_attr_set_v3f(ctx, part, name, &v);
+    } else if (auto a = dynamic_cast<const Imf::V3dAttribute*>(&attr)) {
+        exr_attr_v3d_t v;
+        v.x = a->value().x;
+        v.y = a->value().y;
+        v.z = a->value().z;
+        rv  = exr_attr_set_v3d(ctx, part, name, &v);
+    } else if (auto a = dynamic_cast<const Imf::Box2iAttribute*>(&attr)) {
+        exr_attr_box2i_t b;
+        b.min.x = a->value().min.x;
+        b.min.y = a->value().min.y;
+        b.max.x = a->value().max.x;
+        b.max.y = a->value().max.y;
+        rv      = exr_attr_set_box2i(ctx, part, name, &b);
+    } else if (auto a = dynamic_cast<const Imf::Box2fAttribute*>(&attr)) {
+        exr_attr_box2f_t b;
+        b.min.x = a->value().min.x;
+        b.min.y = a->value().min.y;
+        b.max.x = a->value().max.x;
+        b.max.y = a->value().max.y;
+        rv      = exr_attr_set_box2f(ctx, part, name, &b);
+    } else if (auto a
+               = dynamic_cast<const Imf::ChromaticitiesAttribute*>(&attr)) {
+        const Imf::Chromaticities& c(a->value());
+        exr_attr_chromaticities_t ec;
+        ec.red_x   = c.red.x;
+        ec.red_y   = c.red.y;
+        ec.green_x = c.green.x;
+        ec.green_y = c.green.y;
+        ec.blue_x  = c.blue.x;
+        ec.blue_y  = c.blue.y;
+        ec.white_x = c.white.x;
+        ec.white_y = c.white.y;
+        rv         = exr_attr_set_chromaticities(ctx, part, name, &ec);
+    } else if (auto a = dynamic_cast<const Imf::RationalAttribute*>(&attr)) {
+        exr_attr_rational_t r;
+        r.num   = a->value().n;
+        r.denom = a->value().d;
+        rv      = exr_attr_set_rational(ctx, part, name, &r);
+    } else if (auto a = dynamic_cast<const Imf::TimeCodeAttribute*>(&attr)) {
+        exr_attr_timecode_t t;
+        t.time_and_flags = a->value().timeAndFlags();
+        t.user_data      = a->value().userData();
+        rv               = exr_attr_set_timecode(ctx, part, name, &t);
+    } else if (auto a = dynamic_cast<const Imf::KeyCodeAttribute*>(&attr)) {
+        const Imf::KeyCode& k(a->value());
+        exr_attr_keycode_t ek;
+        ek.film_mfc_code   = k.filmMfcCode();
+        ek.film_type       = k.filmType();
+        ek.prefix          = k.prefix();
+        ek.count           = k.count();
+        ek.perf_offset     = k.perfOffset();
+        ek.perfs_per_frame = k.perfsPerFrame();
+        ek.perfs_per_count = k.perfsPerCount();
+        rv                 = exr_attr_set_keycode(ctx, part, name, &ek);
+    } else if (auto a
+               = dynamic_cast<const Imf::StringVectorAttribute*>(&attr)) {
+        std::vector<const char*> strs;
+        for (const auto& s : a->value())
+            strs.push_back(s.c_str());
+        rv = exr_attr_set_string_vector(ctx, part, name, int32_t(strs.size()),
+                                        strs.data());
+    } else if (auto a = dynamic_cast<const Imf::FloatVectorAttribute*>(&attr)) {
+        rv = exr_attr_set_float_vector(ctx, part, name,
+                                       int32_t(a->value().size()),
+                                       a->value().data());
+    } else if (auto a = dynamic_cast<const Imf::EnvmapAttribute*>(&attr)) {
+        rv = exr_attr_set_envmap(ctx, part, name, exr_envmap_t(a->value()));
+    } else {
+        DBGEXR("exr core output: skipping attribute {} of type {}\n", name,
+               attr.typeName());
+    }
+    if (rv != EXR_ERR_SUCCESS)
+        DBGEXR("exr core output: could not set attribute {}\n", name);
+}
+
+
+
+bool
+OpenEXRCoreOutput::begin_part()
+{
+    m_spec     = m_subimagespecs[m_subimage];
+    m_miplevel = 0;
+    m_pixeltype.clear();
+    for (int c = 0; c < m_spec.nchannels; ++c) {
+        TypeDesc t = m_spec.channelformat(c);
+        m_pixeltype.push_back(t.basetype == TypeDesc::UINT ? EXR_PIXEL_UINT
+                              : (t.basetype == TypeDesc::FLOAT
+                                 || t.basetype == TypeDesc::DOUBLE)
+                                  ? EXR_PIXEL_FLOAT
+                                  : EXR_PIXEL_HALF);
+    }
+    m_next_chunk = 0;
+    m_pending.clear();
+    m_partial.clear();
+    m_partial_lines = 0;
+    m_level_firstchunk.assign(1, 0);
+    m_level_xtiles.clear();
+    m_nmiplevels = 1;
+    m_levelmode  = EXR_TILE_ONE_LEVEL;
+    exr_result_t rv;
+    if (m_spec.tile_width) {
+        const Imf::TileDescription& td(
+            m_headers[m_subimage].tileDescription());
+        m_levelmode = int(td.mode);
+        int32_t nxlevels = 1, nylevels = 1;
+        rv = exr_get_tile_levels(m_exr_context, m_subimage, &nxlevels,
+                                 &nylevels);
+        if (rv != EXR_ERR_SUCCESS)
+            return false;
+        m_nmiplevels = nxlevels;
+        for (int level = 0; level < m_nmiplevels; ++level) {
+            int32_t nx = 0, ny = 0;
+            rv = exr_get_tile_counts(m_exr_context, m_subimage, level, level,
+                                     &nx, &ny);
+            if (rv != EXR_ERR_SUCCESS)
+                return false;
+            m_level_xtiles.push_back(nx);
+            m_level_firstchunk.push_back(m_level_firstchunk.back()
+                                         + int64_t(nx) * ny);
+        }
+    } else {
+        rv = exr_get_scanlines_per_chunk(m_exr_context, m_subimage,
+                                         &m_chunklines);
+        if (rv != EXR_ERR_SUCCESS)
+            return false;
+    }
+    return true;
+}
+
+
+
+bool
+OpenEXRCoreOutput::end_part()
+{
+    bool ok = true;
+    if (m_partial_lines > 0) {
+        // The caller never supplied the rest of this chunk. Write what we
+        // have (the remainder is zero), as the C++ library would.
+        std::vector<ChunkJob> jobs(1);
+        jobs[0].index      = (m_partial_y - m_spec.y) / m_chunklines;
+        jobs[0].y          = m_partial_y;
+        jobs[0].storage    = std::move(m_partial);
+        jobs[0].pixels     = jobs[0].storage.data();
+        jobs[0].linestride = stride_t(m_spec.scanline_bytes(true));
+        m_partial_lines    = 0;
+        ok &= encode_and_write(jobs);
+    }
+    if (m_pending.size()) {
+        errorfmt("{} chunks of subimage {} could not be written because "
+                 "earlier ones are missing",
+                 m_pending.size(), m_subimage);
+        m_pending.clear();
+        ok = false;
+    }
+    return ok;
+}
+
+
+
+bool
+OpenEXRCoreOutput::write_raw_chunk(int x, int y, int level, const void* data,
+                                   size_t size)
+{
+    exr_result_t rv;
+    if (m_spec.tile_width)
+        rv = exr_write_tile_chunk(m_exr_context, m_subimage, x, y, level,
+                                  level, data, uint64_t(size));
+    else
+        rv = exr_write_scanline_chunk(m_exr_context, m_subimage, y, data,
+                                      uint64_t(size));
+    // On failure, the error handler will have reported the details.
+    return rv == EXR_ERR_SUCCESS;
+}
+
+
+
+bool
+OpenEXRCoreOutput::write_chunk(int64_t index, int x, int y, int level,
+                               const void* data, size_t size)
+{
+    if (index != m_next_chunk) {
+        // Not its turn yet. Hold a copy until the chunks before it arrive.
+        const unsigned char* d = (const unsigned char*)data;
+        m_pending[index] = PendingChunk {
+            x, y, level, std::vector<unsigned char>(d, d + size)
+        };
+        return true;
+    }
+    if (!write_raw_chunk(x, y, level, data, size))
+        return false;
+    ++m_next_chunk;
+    // Write any held chunks that are now next in line.
+    for (auto p = m_pending.begin();
+         p != m_pending.end() && p->first == m_next_chunk;
+         p = m_pending.erase(p), ++m_next_chunk) {
+        if (!write_raw_chunk(p->second.x, p->second.y, p->second.level,
+                             p->second.bytes.data(), p->second.bytes.size()))
+            return false;
+    }
+    return true;
+}
+
+
+
+bool
+OpenEXRCoreOutput::encode_and_write(std::vector<ChunkJob>& jobs)
+{
+    if (jobs.empty())
+        return true;
+    bool tiled        = m_spec.tile_width != 0;
+    size_t pixelbytes = m_spec.pixel_bytes(true);
+
+    // Set up all the encoders here on the calling thread, since that
+    // consults the context. Only the pack-and-compress step runs on the
+    // thread pool. N.B. `jobs` must not be resized from here on, since
+    // the encoders may point into themselves.
+    bool ok = true;
+    for (auto& job : jobs) {
+        exr_chunk_info_t cinfo;
+        exr_result_t rv
+            = tiled ? exr_write_tile_chunk_info(m_exr_context, m_subimage,
+                                                job.x, job.y, m_miplevel,
+                                                m_miplevel, &cinfo)
+                    : exr_write_scanline_chunk_info(m_exr_context,
+                                                    m_subimage, job.y, &cinfo);
+        if (rv == EXR_ERR_SUCCESS)
+            rv = exr_encoding_initialize(m_exr_context, m_subimage, &cinfo,
+                                         &job.encoder);
+        if (rv != EXR_ERR_SUCCESS) {
+            ok = false;
+            break;
+        }
+        job.initialized   = true;
+        size_t chanoffset = 0;
+        for (int c = 0; c < m_spec.nchannels; ++c) {
+            size_t chanbytes  = m_spec.channelformat(c).size();
+            string_view cname = m_spec.channel_name(c);
+            for (int ec = 0; ec < job.encoder.channel_count; ++ec) {
+                exr_coding_channel_info_t& curchan = job.encoder.channels[ec];
+                if (cname == curchan.channel_name) {
+                    curchan.encode_from_ptr   = job.pixels + chanoffset;
+                    curchan.user_pixel_stride = int32_t(pixelbytes);
+                    curchan.user_line_stride  = int32_t(job.linestride);
+                    curchan.user_data_type    = int16_t(m_pixeltype[c]);
+                    curchan.user_bytes_per_element
+                        = int16_t(m_pixeltype[c] == EXR_PIXEL_HALF ? 2 : 4);
+                    break;
+                }
+            }
+            chanoffset += chanbytes;
+        }
+        rv = exr_encoding_choose_default_routines(m_exr_context, m_subimage,
+                                                  &job.encoder);
+        if (rv != EXR_ERR_SUCCESS) {
+            ok = false;
+            break;
+        }
+        job.encoder.write_fn = &oiio_exr_defer_write;
+    }
+
+    auto encode = [&](ChunkJob& job) {
+        job.result = exr_encoding_run(m_exr_context, m_subimage,
+                                      &job.encoder);
+    };
+    auto write = [&](ChunkJob& job) -> bool {
+        if (job.result != EXR_ERR_SUCCESS) {
+            errorfmt("EXR Error ({}): {}", m_userdata.m_io->filename(),
+                     exr_get_error_code_as_string(job.result));
+            return false;
+        }
+        const exr_encode_pipeline_t& e(job.encoder);
+        bool packed_only = !e.compressed_buffer;
+        return write_chunk(job.index, job.x, job.y, m_miplevel,
+                           packed_only ? e.packed_buffer : e.compressed_buffer,
+                           packed_only ? size_t(e.packed_bytes)
+                                       : size_t(e.compressed_bytes));
+    };
+
+    if (ok) {
+        thread_pool* pool = default_thread_pool();
+        bool parallel = jobs.size() > 1 && pool->size() > 1
+                        && !pool->is_worker() && threads() != 1;
+        // The encoding helpers come out of the process-wide thread budget.
+        int nhelpers = int(std::min(jobs.size(), size_t(pool->size()))) - 1;
+        thread_budget_claim claim(parallel ? nhelpers : 0);
+        if (claim.granted() > 0) {
+            // Compress the chunks in parallel using the thread pool, with
+            // no more in flight than we were granted helpers, writing each
+            // one as soon as it and all before it are done.
+            size_t inflight = size_t(claim.granted());
+            task_set tasks(pool);
+            size_t pushed = 0;
+            for (size_t i = 0; ok && i < jobs.size(); ++i) {
+                for (; pushed < jobs.size() && pushed < i + inflight;
+                     ++pushed)
+                    tasks.push(pool->push(
+                        [&, pushed](int /*id*/) { encode(jobs[pushed]); }));
+                // Non-blocking wait: steals queued work while it waits.
+                tasks.wait_for_task(i);
+                ok &= write(jobs[i]);
+            }
+            tasks.wait();
+        } else {
+            for (size_t i = 0; ok && i < jobs.size(); ++i) {
+                encode(jobs[i]);
+                ok &= write(jobs[i]);
+            }
+        }
+    }
+
+    for (auto& job : jobs)
+        if (job.initialized)
+            exr_encoding_destroy(m_exr_context, &job.encoder);
+    return ok;
+}
+
+
+
+bool
+OpenEXRCoreOutput::write_scanline(int y, int z, TypeDesc format,
+                                  const void* data, stride_t xstride)
+{
+    return write_scanlines(y, y + 1, z, format, data, xstride, AutoStride);
+}
+
+
+
+bool
+OpenEXRCoreOutput::write_scanlines(int ybegin, int yend, int z,
+                                   TypeDesc format, const void* data,
+                                   stride_t xstride, stride_t ystride)
+{
+    if (m_delegate)
+        return delegated(m_imf->write_scanlines(ybegin, yend, z, format, data,
+                                                xstride, ystride));
+    if (!m_exr_context || m_spec.tile_width) {
+        errorfmt(
+            "called OpenEXRCoreOutput::write_scanlines without an open scanline file");
+        return false;
+    }
+
+    yend = std::min(yend, m_spec.y + m_spec.height);
+    if (ybegin >= yend)
+        return true;
+    bool native               = (format == TypeDesc::UNKNOWN);
+    imagesize_t scanlinebytes = m_spec.scanline_bytes(true);
+    size_t pixel_bytes        = m_spec.pixel_bytes(true);
+    if (native && xstride == AutoStride)
+        xstride = (stride_t)pixel_bytes;
+    stride_t zstride = AutoStride;
+    m_spec.auto_stride(xstride, ystride, zstride, format, m_spec.nchannels,
+                       m_spec.width, m_spec.height);
+    const unsigned char* lines = (const unsigned char*)to_native_rectangle(
+        m_spec.x, m_spec.x + m_spec.width, ybegin, yend, z, z + 1, format,
+        data, xstride, ystride, zstride, m_scratch);
+
+    // Whole chunks are encoded straight from the caller's (native) data.
+    // Lines of chunks that are only partly covered by this call are
+    // collected in m_partial until the chunk is complete.
+    std::vector<ChunkJob> jobs;
+    const int imgend = m_spec.y + m_spec.height;
+    for (int y = ybegin; y < yend;) {
+        int chunkbegin = m_spec.y
+                         + round_down_to_multiple(y - m_spec.y, m_chunklines);
+        int chunkend   = std::min(chunkbegin + m_chunklines, imgend);
+        const unsigned char* src = lines + (y - ybegin) * scanlinebytes;
+        if (y == chunkbegin && chunkend <= yend) {
+            jobs.emplace_back();
+            jobs.back().pixels = src;
+            y                  = chunkend;
+        } else {
+            if (m_partial_lines == 0 || m_partial_y != chunkbegin) {
+                m_partial.assign(scanlinebytes * m_chunklines, 0);
+                m_partial_y     = chunkbegin;
+                m_partial_lines = 0;
+            }
+            int n = std::min(yend, chunkend) - y;
+            memcpy(m_partial.data() + (y - chunkbegin) * scanlinebytes, src,
+                   n * scanlinebytes);
+            m_partial_lines += n;
+            y += n;
+            if (m_partial_lines < chunkend - chunkbegin)
+                continue;
+            jobs.emplace_back();
+            jobs.back().storage = std::move(m_partial);
+            jobs.back().pixels  = jobs.back().storage.data();
+            m_partial.clear();
+            m_partial_lines = 0;
+        }
+        jobs.back().index      = (chunkbegin - m_spec.y) / m_chunklines;
+        jobs.back().y          = chunkbegin;
+        jobs.back().linestride = stride_t(scanlinebytes);
+    }
+    bool ok = encode_and_write(jobs);
+
+    // If we allocated more than 1M, free the memory.  It's not wasteful,
+    // because it means we're writing big chunks at a time, and therefore
+    // there will be few allocations and deletions.
+    if (m_scratch.size() > 1 * 1024 * 1024) {
+        std::vector<unsigned char> dummy;
+        std::swap(m_scratch, dummy);
+    }
+    return ok;
+}
+
+
+
+bool
+OpenEXRCoreOutput::write_tile(int x, int y, int z, TypeDesc format,
+                              const void* data, stride_t xstride,
+                              stride_t ystride, stride_t zstride)
+{
+    if (m_delegate)
+        return delegated(
+            m_imf->write_tile(x, y, z, format, data, xstride, ystride, zstride));
+    bool native = (format == TypeDesc::UNKNOWN);
+    if (native && xstride == AutoStride)
+        xstride = (stride_t)m_spec.pixel_bytes(native);
+    m_spec.auto_stride(xstride, ystride, zstride, format, spec().nchannels,
+                       m_spec.tile_width, m_spec.tile_height);
+    return write_tiles(
+        x, std::min(x + m_spec.tile_width, m_spec.x + m_spec.width), y,
+        std::min(y + m_spec.tile_height, m_spec.y + m_spec.height), z,
+        std::min(z + m_spec.tile_depth, m_spec.z + m_spec.depth), format, data,
+        xstride, ystride, zstride);
+}
+
+
+
+bool
+OpenEXRCoreOutput::write_tiles(int xbegin, int xend, int ybegin, int yend,
+                               int zbegin, int zend, TypeDesc format,
+                               const void* data, stride_t xstride,
+                               stride_t ystride, stride_t zstride)
+{
+    if (m_delegate)
+        return delegated(m_imf->write_tiles(xbegin, xend, ybegin, yend, zbegin,
+                                            zend, format, data, xstride,
+                                            ystride, zstride));
+    if (!m_exr_context || !m_spec.tile_width) {
+        errorfmt(
+            "called OpenEXRCoreOutput::write_tiles without an open tiled file");
+        return false;
+    }
+    if (!m_spec.valid_tile_range(xbegin, xend, ybegin, yend, zbegin, zend)) {
+        errorfmt(
+            "called OpenEXRCoreOutput::write_tiles with an invalid tile range");
+        return false;
+    }
+
+    bool native            = (format == TypeDesc::UNKNOWN);
+    size_t user_pixelbytes = m_spec.pixel_bytes(native);
+    size_t pixelbytes      = m_spec.pixel_bytes(true);
+    if (native && xstride == AutoStride)
+        xstride = (stride_t)user_pixelbytes;
+    m_spec.auto_stride(xstride, ystride, zstride, format, spec().nchannels,
+                       (xend - xbegin), (yend - ybegin));
+    data = to_native_rectangle(xbegin, xend, ybegin, yend, zbegin, zend, format,
+                               data, xstride, ystride, zstride, m_scratch);
+    stride_t widthbytes = stride_t(xend - xbegin) * pixelbytes;
+
+    // clamp to the image edge
+    xend           = std::min(xend, m_spec.x + m_spec.width);
+    yend           = std::min(yend, m_spec.y + m_spec.height);
+    int firstxtile = (xbegin - m_spec.x) / m_spec.tile_width;
+    int firstytile = (ybegin - m_spec.y) / m_spec.tile_height;
+    int nxtiles = (xend - xbegin + m_spec.tile_width - 1) / m_spec.tile_width;
+    int nytiles = (yend - ybegin + m_spec.tile_height - 1) / m_spec.tile_height;
+
+    // Edge tiles are smaller than the tile size, and the encoder only
+    // reads as much of each tile as is inside the image, so the native
+    // rectangle can be used directly with no padding.
+    std::vector<ChunkJob> jobs(size_t(nxtiles) * size_t(nytiles));
+    for (int ty = 0, j = 0; ty < nytiles; ++ty) {
+        for (int tx = 0; tx < nxtiles; ++tx, ++j) {
+            ChunkJob& job(jobs[j]);
+            job.x          = firstxtile + tx;
+            job.y          = firstytile + ty;
+            job.index      = m_level_firstchunk[m_miplevel]
+                        + int64_t(job.y) * m_level_xtiles[m_miplevel] + job.x;
+            job.pixels     = (const unsigned char*)data
+                         + stride_t(ty) * m_spec.tile_height * widthbytes
+                         + stride_t(tx) * m_spec.tile_width * pixelbytes;
+            job.linestride = widthbytes;
+        }
+    }
+    return encode_and_write(jobs);
+}
+
+
+
+bool
+OpenEXRCoreOutput::write_deep_scanlines(int ybegin, int yend, int z,
+                                        const DeepData& deepdata)
+{
+    if (m_delegate)
+        return delegated(
+            m_imf->write_deep_scanlines(ybegin, yend, z, deepdata));
+    errorfmt("called OpenEXRCoreOutput::write_deep_scanlines for a non-deep file");
+    return false;
+}
+
+
+
+bool
+OpenEXRCoreOutput::write_deep_tiles(int xbegin, int xend, int ybegin, int yend,
+                                    int zbegin, int zend,
+                                    const DeepData& deepdata)
+{
+    if (m_delegate)
+        return delegated(m_imf->write_deep_tiles(xbegin, xend, ybegin, yend,
+                                                 zbegin, zend, deepdata));
+    errorfmt("called OpenEXRCoreOutput::write_deep_tiles for a non-deep file");
+    return false;
+}
+
+
+
+bool
+OpenEXRCoreOutput::close()
+{
+    if (m_delegate)
+        return delegated(m_imf->close());
+
+    // Like the C++ library output, leave MIP-map files open until all of
+    // the levels have been written, since appending cannot be done via a
+    // re-open like it can with TIFF files.
+    if (m_exr_context && m_levelmode != EXR_TILE_ONE_LEVEL
+        && m_miplevel + 1 < m_nmiplevels)
+        return true;
+    return finish();
+}
+
+
+
+bool
+OpenEXRCoreOutput::finish()
+{
+    bool ok = true;
+    if (m_exr_context) {
+        ok &= end_part();
+        ok &= (exr_finish(&m_exr_context) == EXR_ERR_SUCCESS);
+    }
+    m_imf.reset();  // finishes any delegated file
+    init();         // re-initialize
+    return ok;
+}
+
+
+OIIO_PLUGIN_NAMESPACE_END
@@ -76,6 +76,9 @@ public:
                               void* data) override;
     bool read_native_tile(int subimage, int miplevel, int x, int y, int z,
                           void* data) override;
+    bool read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
+                           int ybegin, int yend, int zbegin, int zend,
+                           void* data) override;
 
     ImageSpec spec(int subimage, int miplevel) override;
     ImageSpec spec_dimensions(int subimage, int miplevel) override;
@@ -197,20 +200,37 @@ template<typename GridType> struct VDBReader {
 
     static bool readTile(const GridType& grid, int x, int y, int z,
                          ValueType* values)
+    {
+        typename GridType::ConstAccessor cache = grid.getConstAccessor();
+        return readTile(grid, cache, x, y, z, values);
+    }
+
+    // Read one leaf-sized tile using a caller-supplied accessor, so that a
+    // run of neighboring tiles shares the accessor's cached path down the
+    // tree. Regions held as inactive/constant tile values in the upper
+    // nodes, and leaves whose voxels are all identical, are filled with a
+    // single value rather than densified voxel by voxel.
+    static bool readTile(const GridType& grid,
+                         typename GridType::ConstAccessor& cache, int x, int y,
+                         int z, ValueType* values)
     {
         // Probe for a cell-centered voxel
         enum { kOffset = LeafType::DIM / 2 };
-        // const int kOffset = LeafType::DIM / 2;
         const openvdb::Coord xyz(x + kOffset, y + kOffset, z + kOffset);
         const RootType& root = grid.tree().root();
         // Use the GridType::ConstAccessor so only one query needs to be done.
         // From that query, check the node type from 'most interesting' to least
-        typename GridType::ConstAccessor cache = grid.getConstAccessor();
         if (auto* leaf = root.probeConstLeafAndCache(xyz, cache)) {
             CoordBBox bbox = leaf->getNodeBoundingBox();
             if (bbox.min().x() != x || bbox.min().y() != y
                 || bbox.min().z() != z || bbox.dim() != Coord(LeafType::DIM))
                 return false;  // unaligned or unexpected tile dimensions
+            ValueType value;
+            bool state;
+            if (leaf->isConstant(value, state)) {
+                setTile(values, value);
+                return true;
+            }
             // Have OpenVDB fill the dense block, into the values pointer
             DenseT dense(bbox, values);
             leaf->copyToDense(bbox, dense);
@@ -219,6 +239,42 @@ template<typename GridType> struct VDBReader {
         return true;
     }
 
+    // Read the tiles covering [xbegin,xend)x[ybegin,yend)x[zbegin,zend)
+    // into contiguous pixel order, sharing one accessor across the tiles.
+    static bool readTiles(const GridType& grid, int xbegin, int xend,
+                          int ybegin, int yend, int zbegin, int zend,
+                          ValueType* values)
+    {
+        enum { kDim = LeafType::DIM };
+        typename GridType::ConstAccessor cache = grid.getConstAccessor();
+        std::unique_ptr<ValueType[]> tile(new ValueType[LeafType::SIZE]);
+        const size_t xstride = size_t(xend - xbegin);
+        const size_t ystride = xstride * size_t(yend - ybegin);
+        for (int z = zbegin; z < zend; z += kDim) {
+            for (int y = ybegin; y < yend; y += kDim) {
+                for (int x = xbegin; x < xend; x += kDim) {
+                    if (!readTile(grid, cache, x, y, z, tile.get()))
+                        return false;
+                    const int nx = std::min(int(kDim), xend - x);
+                    const int ny = std::min(int(kDim), yend - y);
+                    const int nz = std::min(int(kDim), zend - z);
+                    for (int tz = 0; tz < nz; ++tz) {
+                        for (int ty = 0; ty < ny; ++ty) {
+                            const ValueType* src
+                                = tile.get() + (tz * kDim + ty) * kDim;
+                            ValueType* dst
+                                = values + size_t(z - zbegin + tz) * ystride
+                                  + size_t(y - ybegin + ty) * xstride
+                                  + size_t(x - xbegin);
+                            std::copy(src, src + nx, dst);
+                        }
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
     static void fillSpec(const CoordBBox& bounds, const Coord& dim,
                          ImageSpec& spec)
     {
@@ -520,6 +576,17 @@ OpenVDBInput::open(const std::string& filename, ImageSpec& newspec)
                 channelnames.back() = layer.name;
 
             readMetaData(*layer.grid, layer, layerspec);
+
+            // Advertise where the data actually lives, so that clients can
+            // skip the (uniform background) space outside of it.
+            const int activebbox[6]
+                = { bounds.min().x(), bounds.min().y(), bounds.min().z(),
+                    bounds.max().x(), bounds.max().y(), bounds.max().z() };
+            layerspec.attribute("openvdb:activebbox",
+                                TypeDesc(TypeDesc::INT, 6), activebbox);
+            const int64_t activevoxels = layer.grid->activeVoxelCount();
+            layerspec.attribute("openvdb:activevoxels", TypeDesc::INT64,
+                                &activevoxels);
         }
     } catch (const std::exception& e) {
         init();  // Reset to initial state
@@ -579,6 +646,36 @@ OpenVDBInput::read_native_tile(int subimage, int miplevel, int x, int y, int z,
 
 
 
+bool
+OpenVDBInput::read_native_tiles(int subimage, int miplevel, int xbegin,
+                                int xend, int ybegin, int yend, int zbegin,
+                                int zend, void* data)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage_nolock(subimage, miplevel))
+        return false;
+    if (!m_spec.valid_tile_range(xbegin, xend, ybegin, yend, zbegin, zend))
+        return false;
+
+    // The far edge of the range may be clamped to the data window rather
+    // than tile-aligned; readTiles copies only the in-range part of each.
+    const layerrecord& lay = m_layers[m_subimage];
+    switch (lay.spec.nchannels) {
+    case 1:
+        return VDBReader<FloatGrid>::readTiles(
+            *gridPtrCast<ScalarGrid>(lay.grid), xbegin, xend, ybegin, yend,
+            zbegin, zend, reinterpret_cast<float*>(data));
+    case 3:
+        return VDBReader<Vec3fGrid>::readTiles(
+            *gridPtrCast<Vec3fGrid>(lay.grid), xbegin, xend, ybegin, yend,
+            zbegin, zend, reinterpret_cast<Vec3f*>(data));
+    default: break;
+    }
+    return false;
+}
+
+
+
 // Obligatory material to make this a recognizable imageio plugin:
 OIIO_PLUGIN_EXPORTS_BEGIN
 
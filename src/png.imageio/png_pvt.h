@@ -408,6 +408,31 @@ read_next_scanline(png_structp& sp, void* buffer)
 
 
 
+/// Reads the next `nrows` scanlines from an open PNG file, in a single call
+/// to libpng, into the buffer whose rows are `ystride` bytes apart.
+/// \return empty string on success, error message on failure.
+///
+inline const std::string
+read_next_scanlines(png_structp& sp, void* buffer, int nrows, stride_t ystride)
+{
+    // Temp space for the row pointers. Must be declared before the setjmp
+    // to ensure it's destroyed if the jump is taken.
+    std::vector<png_bytep> row_pointers(nrows);
+    for (int i = 0; i < nrows; ++i)
+        row_pointers[i] = (png_bytep)buffer + i * ystride;
+
+    // Must call this setjmp in every function that does PNG reads
+    if (setjmp(png_jmpbuf(sp)))  // NOLINT(cert-err52-cpp)
+        return "PNG library error";
+
+    png_read_rows(sp, row_pointers.data(), NULL, png_uint_32(nrows));
+
+    // success
+    return "";
+}
+
+
+
 /// Destroys a PNG read struct.
 ///
 inline void
@@ -749,6 +774,21 @@ write_rows(png_structp& sp, png_byte* data, int nrows = 0, stride_t ystride = 0)
 
 
 
+/// Write a complete chunk of already-encoded data, such as an IDAT that
+/// we compressed ourselves.
+inline bool
+write_chunk(png_structp& sp, const char* name, const png_byte* data,
+            size_t length)
+{
+    if (setjmp(png_jmpbuf(sp))) {  // NOLINT(cert-err52-cpp)
+        return false;
+    }
+    png_write_chunk(sp, (png_const_bytep)name, data, length);
+    return true;
+}
+
+
+
 /// Helper function - error-catching wrapper for png_write_end
 inline void
 write_end(png_structp& sp, png_infop& ip)
@@ -6,6 +6,8 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include <OpenImageIO/parallel.h>
+
 #include "png_pvt.h"
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
@@ -21,6 +23,8 @@ public:
         return (feature == "ioproxy" || feature == "exif");
     }
     bool valid_file(Filesystem::IOProxy* ioproxy) const override;
+    bool probe_header(string_view filename, ImageSpec& spec,
+                      const ImageSpec& config) override;
     bool open(const std::string& name, ImageSpec& newspec) override;
     bool open(const std::string& name, ImageSpec& newspec,
               const ImageSpec& config) override;
@@ -32,6 +36,8 @@ public:
     }
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin,
+                               int yend, int z, void* data) override;
 
 private:
     std::string m_filename;            ///< Stash the filename
@@ -67,6 +73,14 @@ private:
     ///
     bool readimg();
 
+    /// Helper function: close and re-open the file to start reading from
+    /// the first scanline again.
+    bool rewind(int miplevel);
+
+    /// Helper function: convert unassociated alpha in `nrows` rows of
+    /// native pixels to associated, unless asked not to.
+    void associate_alpha(void* data, int nrows);
+
     /// Extract the background color.
     ///
     bool get_background(float* red, float* green, float* blue);
@@ -122,6 +136,66 @@ PNGInput::valid_file(Filesystem::IOProxy* ioproxy) const
 
 
 
+bool
+PNGInput::probe_header(string_view filename, ImageSpec& spec,
+                       const ImageSpec& config)
+{
+    // The IHDR chunk, which must come first, has nearly all we need. The
+    // rest is whether a tRNS chunk (which becomes alpha) precedes the
+    // image data, which we can tell from the chunk headers alone.
+    auto be32 = [](const unsigned char* p) {
+        return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16
+               | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+    };
+    ioproxy_retrieve_from_config(config);
+    if (!ioproxy_use_or_open(filename))
+        return false;
+    Filesystem::IOProxy* io = ioproxy();
+    unsigned char hdr[33];  // signature, then the IHDR chunk
+    if (io->pread(hdr, sizeof(hdr), 0) != sizeof(hdr)
+        || png_sig_cmp(hdr, 0, 8) || memcmp(hdr + 12, "IHDR", 4)) {
+        errorfmt("Not a PNG file");
+        ioproxy_clear();
+        return false;
+    }
+    int bit_depth  = hdr[24];
+    int color_type = hdr[25];
+    int nchannels  = 0;
+    switch (color_type) {
+    case PNG_COLOR_TYPE_GRAY: nchannels = 1; break;
+    case PNG_COLOR_TYPE_GRAY_ALPHA: nchannels = 2; break;
+    case PNG_COLOR_TYPE_RGB:
+    case PNG_COLOR_TYPE_PALETTE: nchannels = 3; break;
+    case PNG_COLOR_TYPE_RGB_ALPHA: nchannels = 4; break;
+    default: errorfmt("Unknown PNG color type {}", color_type); break;
+    }
+    if (nchannels == 1 || nchannels == 3) {
+        unsigned char chunk[8];
+        for (int64_t pos = sizeof(hdr); io->pread(chunk, 8, pos) == 8;
+             pos += 12 + int64_t(be32(chunk))) {
+            if (!memcmp(chunk + 4, "IDAT", 4))
+                break;
+            if (!memcmp(chunk + 4, "tRNS", 4)) {
+                ++nchannels;
+                break;
+            }
+        }
+    }
+    ioproxy_clear();
+    if (!nchannels)
+        return false;
+    spec = ImageSpec(int(be32(hdr + 16)), int(be32(hdr + 20)), nchannels,
+                     bit_depth == 16 ? TypeDesc::UINT16 : TypeDesc::UINT8);
+    if (nchannels == 2) {
+        spec.channelnames[0] = "Y";
+        spec.channelnames[1] = "A";
+        spec.alpha_channel   = 1;
+    }
+    return true;
+}
+
+
+
 bool
 PNGInput::open(const std::string& name, ImageSpec& newspec)
 {
@@ -151,6 +225,20 @@ PNGInput::open(const std::string& name, ImageSpec& newspec)
     // Tell libpng to use our read callback to read from the IOProxy
     png_set_read_fn(m_png, this, PngReadCallback);
 
+#if OIIO_LIBPNG_VERSION >= 10600
+    // Hand zlib large pieces of big IDAT chunks rather than the 8KB
+    // default, to cut the per-call overhead of inflate and our callback.
+    png_set_compression_buffer_size(m_png, 1 << 20);
+#endif
+    if (m_config && m_config->get_int_attribute("png:fast")) {
+        // Trust the file: don't verify the chunk CRCs or the zlib Adler-32,
+        // which are a noticeable fraction of decode time.
+        png_set_crc_action(m_png, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+#if defined(PNG_IGNORE_ADLER32) && defined(PNG_SET_OPTION_SUPPORTED)
+        png_set_option(m_png, PNG_IGNORE_ADLER32, PNG_OPTION_ON);
+#endif
+    }
+
     bool ok = PNG_pvt::read_info(m_png, m_info, m_bit_depth, m_color_type,
                                  m_interlace_type, m_bg, m_spec,
                                  m_keep_unassociated_alpha);
@@ -264,20 +352,8 @@ PNGInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
         memcpy(data, &m_buf[0] + y * size, size);
     } else {
         // Not an interlaced image -- read just one row
-        if (m_next_scanline > y) {
-            // User is trying to read an earlier scanline than the one we're
-            // up to.  Easy fix: close the file and re-open.
-            // Don't forget to save and restore any configuration settings.
-            ImageSpec configsave;
-            if (m_config)
-                configsave = *m_config;
-            ImageSpec dummyspec;
-            int subimage = current_subimage();
-            if (!close() || !open(m_filename, dummyspec, configsave)
-                || !seek_subimage(subimage, miplevel))
-                return false;  // Somehow, the re-open failed
-            assert(m_next_scanline == 0 && current_subimage() == subimage);
-        }
+        if (m_next_scanline > y && !rewind(miplevel))
+            return false;
         while (m_next_scanline <= y) {
             // Keep reading until we're read the scanline we really need
             // std::cerr << "reading scanline " << m_next_scanline << "\n";
@@ -292,19 +368,96 @@ PNGInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
         }
     }
 
-    // PNG specifically dictates unassociated (un-"premultiplied") alpha.
-    // Convert to associated unless we were requested not to do so.
-    if (m_spec.alpha_channel != -1 && !m_keep_unassociated_alpha) {
-        float gamma = m_spec.get_float_attribute("oiio:Gamma", 1.0f);
-        if (m_spec.format == TypeDesc::UINT16)
-            png_associateAlpha((unsigned short*)data, m_spec.width,
-                               m_spec.nchannels, m_spec.alpha_channel, gamma);
-        else
-            png_associateAlpha((unsigned char*)data, m_spec.width,
-                               m_spec.nchannels, m_spec.alpha_channel, gamma);
+    associate_alpha(data, 1);
+    return true;
+}
+
+
+
+bool
+PNGInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                int yend, int z, void* data)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel))
+        return false;
+    // Interlaced images are buffered whole anyway, so the scanline at a
+    // time default is fine for them.
+    if (m_interlace_type != 0)
+        return ImageInput::read_native_scanlines(subimage, miplevel, ybegin,
+                                                 yend, z, data);
+
+    ybegin -= m_spec.y;
+    yend -= m_spec.y;
+    if (ybegin < 0 || yend > m_spec.height || ybegin >= yend)
+        return false;
+    if (m_next_scanline > ybegin && !rewind(miplevel))
+        return false;
+
+    // Skip up to the first requested row (using the caller's buffer as
+    // scratch), then let libpng decode the whole range in one call.
+    std::string s;
+    while (s.empty() && m_next_scanline < ybegin) {
+        s = PNG_pvt::read_next_scanline(m_png, data);
+        ++m_next_scanline;
     }
+    stride_t ystride = m_spec.scanline_bytes();
+    if (s.empty())
+        s = PNG_pvt::read_next_scanlines(m_png, data, yend - ybegin, ystride);
+    if (s.length()) {
+        errorfmt("{}", s);
+        return false;
+    }
+    if (m_err)
+        return false;  // error is already registered
+    m_next_scanline = yend;
 
+    associate_alpha(data, yend - ybegin);
     return true;
 }
 
+
+
+bool
+PNGInput::rewind(int miplevel)
+{
+    // User is trying to read an earlier scanline than the one we're up to.
+    // Easy fix: close the file and re-open. Don't forget to save and
+    // restore any configuration settings.
+    ImageSpec configsave;
+    if (m_config)
+        configsave = *m_config;
+    ImageSpec dummyspec;
+    int subimage = current_subimage();
+    if (!close() || !open(m_filename, dummyspec, configsave)
+        || !seek_subimage(subimage, miplevel))
+        return false;  // Somehow, the re-open failed
+    OIIO_DASSERT(m_next_scanline == 0 && current_subimage() == subimage);
+    return true;
+}
+
+
+
+void
+PNGInput::associate_alpha(void* data, int nrows)
+{
+    // PNG specifically dictates unassociated (un-"premultiplied") alpha.
+    // Convert to associated unless we were requested not to do so.
+    if (m_spec.alpha_channel == -1 || m_keep_unassociated_alpha)
+        return;
+    float gamma       = m_spec.get_float_attribute("oiio:Gamma", 1.0f);
+    size_t rowbytes   = m_spec.scanline_bytes();
+    bool is16         = m_spec.format == TypeDesc::UINT16;
+    const ImageSpec& spec(m_spec);
+    parallel_for(0, nrows, [&](int r) {
+        void* row = (char*)data + r * rowbytes;
+        if (is16)
+            png_associateAlpha((unsigned short*)row, spec.width,
+                               spec.nchannels, spec.alpha_channel, gamma);
+        else
+            png_associateAlpha((unsigned char*)row, spec.width,
+                               spec.nchannels, spec.alpha_channel, gamma);
+    }, paropt(threads()));
+}
+
 OIIO_PLUGIN_NAMESPACE_END
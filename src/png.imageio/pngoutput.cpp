@@ -7,6 +7,9 @@
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
+#include <limits>
+
+#include <OpenImageIO/parallel.h>
 
 #include "png_pvt.h"
 
@@ -52,6 +55,9 @@ private:
     std::vector<png_text> m_pngtext;
     std::vector<unsigned char> m_tilebuffer;
     bool m_err = false;
+    bool m_parallel;                       ///< Compress IDAT ourselves?
+    int m_zlevel, m_zstrategy, m_filters;  ///< For parallel compression
+    std::vector<unsigned char> m_imagebuf;  ///< Native pixels, if parallel
 
     // Initialize private members to pre-opened state
     void init(void)
@@ -61,7 +67,9 @@ private:
         m_convert_alpha = true;
         m_need_swap     = false;
         m_gamma         = 1.0;
+        m_parallel      = false;
         m_pngtext.clear();
+        std::vector<unsigned char>().swap(m_imagebuf);
         ioproxy_clear();
         m_err = false;
     }
@@ -88,6 +96,10 @@ private:
         pngoutput->ioproxy()->flush();
     }
 
+    // Filter and deflate the buffered image in parallel bands, and write
+    // the result as IDAT chunks followed by IEND.
+    bool write_parallel_idat();
+
     template<class T>
     void deassociateAlpha(T* data, size_t npixels, int channels,
                           int alpha_channel, float gamma);
@@ -154,39 +166,41 @@ PNGOutput::open(const std::string& name, const ImageSpec& userspec,
 
     png_set_write_fn(m_png, this, PngWriteCallback, PngFlushCallback);
 
-    png_set_compression_level(
-        m_png, std::max(std::min(m_spec.get_int_attribute(
+    m_zlevel = std::max(std::min(m_spec.get_int_attribute(
                                      "png:compressionLevel",
                                      6 /* medium speed vs size tradeoff */),
                                  Z_BEST_COMPRESSION),
-                        Z_NO_COMPRESSION));
+                        Z_NO_COMPRESSION);
+    m_zstrategy             = Z_DEFAULT_STRATEGY;
     std::string compression = m_spec.get_string_attribute("compression");
     if (compression.empty()) {
-        png_set_compression_strategy(m_png, Z_DEFAULT_STRATEGY);
+        m_zstrategy = Z_DEFAULT_STRATEGY;
     } else if (Strutil::iequals(compression, "default")) {
-        png_set_compression_strategy(m_png, Z_DEFAULT_STRATEGY);
+        m_zstrategy = Z_DEFAULT_STRATEGY;
     } else if (Strutil::iequals(compression, "filtered")) {
-        png_set_compression_strategy(m_png, Z_FILTERED);
+        m_zstrategy = Z_FILTERED;
     } else if (Strutil::iequals(compression, "huffman")) {
-        png_set_compression_strategy(m_png, Z_HUFFMAN_ONLY);
+        m_zstrategy = Z_HUFFMAN_ONLY;
     } else if (Strutil::iequals(compression, "rle")) {
-        png_set_compression_strategy(m_png, Z_RLE);
+        m_zstrategy = Z_RLE;
     } else if (Strutil::iequals(compression, "fixed")) {
-        png_set_compression_strategy(m_png, Z_FIXED);
+        m_zstrategy = Z_FIXED;
     } else if (Strutil::iequals(compression, "pngfast")) {
-        png_set_compression_strategy(m_png, Z_DEFAULT_STRATEGY);
-        png_set_compression_level(m_png, Z_BEST_SPEED);
+        m_zstrategy = Z_DEFAULT_STRATEGY;
+        m_zlevel    = Z_BEST_SPEED;
     } else if (Strutil::iequals(compression, "none")) {
-        png_set_compression_strategy(m_png, Z_NO_COMPRESSION);
-        png_set_compression_level(m_png, 0);
+        m_zstrategy = Z_NO_COMPRESSION;
+        m_zlevel    = 0;
     } else {
-        png_set_compression_strategy(m_png, Z_DEFAULT_STRATEGY);
+        m_zstrategy = Z_DEFAULT_STRATEGY;
     }
+    png_set_compression_level(m_png, m_zlevel);
+    png_set_compression_strategy(m_png, m_zstrategy);
 
     m_need_swap = (m_spec.format == TypeDesc::UINT16 && littleendian());
 
-    png_set_filter(m_png, 0,
-                   spec().get_int_attribute("png:filter", PNG_NO_FILTERS));
+    m_filters = spec().get_int_attribute("png:filter", PNG_NO_FILTERS);
+    png_set_filter(m_png, 0, m_filters);
     // https://www.w3.org/TR/PNG-Encoders.html#E.Filter-selection
     // https://www.w3.org/TR/PNG-Rationale.html#R.Filtering
     // The official advice is to PNG_NO_FILTER for palette or < 8 bpp
@@ -234,6 +248,15 @@ PNGOutput::open(const std::string& name, const ImageSpec& userspec,
     if (m_spec.tile_width && m_spec.tile_height)
         m_tilebuffer.resize(m_spec.image_bytes());
 
+    // With "png:threads" other than 1, buffer the native scanlines and
+    // compress them ourselves at close(), in bands on the thread pool.
+    thread_pool* pool = default_thread_pool();
+    m_parallel        = m_spec.get_int_attribute("png:threads", 1) != 1
+                 && this->threads() != 1 && pool->size() > 1
+                 && m_spec.height > 1;
+    if (m_parallel)
+        m_imagebuf.resize(m_spec.image_bytes());
+
     return true;
 }
 
@@ -256,6 +279,14 @@ PNGOutput::close()
         std::vector<unsigned char>().swap(m_tilebuffer);
     }
 
+    if (m_png && m_parallel) {
+        // write_parallel_idat also writes IEND, in place of write_end.
+        ok &= write_parallel_idat();
+        PNG_pvt::destroy_write_struct(m_png, m_info);
+        m_png  = nullptr;
+        m_info = nullptr;
+    }
+
     if (m_png) {
         PNG_pvt::write_end(m_png, m_info);
         if (m_png || m_info)
@@ -348,6 +379,12 @@ PNGOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
     if (m_need_swap)
         swap_endian((unsigned short*)data, m_spec.width * m_spec.nchannels);
 
+    if (m_parallel) {
+        memcpy(&m_imagebuf[size_t(y - m_spec.y) * m_spec.scanline_bytes()],
+               data, m_spec.scanline_bytes());
+        return true;
+    }
+
     if (!PNG_pvt::write_row(m_png, (png_byte*)data)) {
         errorfmt("PNG library error");
         return false;
@@ -415,6 +452,12 @@ PNGOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
     if (m_need_swap)
         swap_endian((unsigned short*)data, nvals);
 
+    if (m_parallel) {
+        memcpy(&m_imagebuf[size_t(ybegin - m_spec.y) * m_spec.scanline_bytes()],
+               data, nvals * m_spec.format.size());
+        return true;
+    }
+
     if (!PNG_pvt::write_rows(m_png, (png_byte*)data, yend - ybegin,
                              stride_t(m_spec.width) * m_spec.nchannels
                                  * m_spec.format.size())) {
@@ -428,6 +471,180 @@ PNGOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
 
 
 
+// Apply PNG filter `type` to one row of `rowbytes` bytes with `bpp` bytes
+// per pixel, given the previous (unfiltered) row, or nullptr for the first.
+static void
+filter_row(int type, const unsigned char* row, const unsigned char* prev,
+           size_t rowbytes, size_t bpp, unsigned char* out)
+{
+    for (size_t i = 0; i < rowbytes; ++i) {
+        int a = i >= bpp ? row[i - bpp] : 0;           // left
+        int b = prev ? prev[i] : 0;                    // above
+        int c = prev && i >= bpp ? prev[i - bpp] : 0;  // above left
+        int pred;
+        switch (type) {
+        case PNG_FILTER_VALUE_SUB: pred = a; break;
+        case PNG_FILTER_VALUE_UP: pred = b; break;
+        case PNG_FILTER_VALUE_AVG: pred = (a + b) / 2; break;
+        case PNG_FILTER_VALUE_PAETH: {
+            int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b),
+                pc = std::abs(p - c);
+            pred = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+            break;
+        }
+        default: pred = 0; break;
+        }
+        out[i] = (unsigned char)(row[i] - pred);
+    }
+}
+
+
+
+bool
+PNGOutput::write_parallel_idat()
+{
+    // Which filters may we use? This follows png_set_filter's reading of
+    // its argument: a lone filter value 0-4, or else a mask of PNG_FILTER_*.
+    int filtermask;
+    switch (m_filters & (PNG_ALL_FILTERS | 0x07)) {
+    case PNG_FILTER_VALUE_SUB: filtermask = PNG_FILTER_SUB; break;
+    case PNG_FILTER_VALUE_UP: filtermask = PNG_FILTER_UP; break;
+    case PNG_FILTER_VALUE_AVG: filtermask = PNG_FILTER_AVG; break;
+    case PNG_FILTER_VALUE_PAETH: filtermask = PNG_FILTER_PAETH; break;
+    default: filtermask = m_filters & PNG_ALL_FILTERS; break;
+    }
+    if (!filtermask)
+        filtermask = PNG_FILTER_NONE;
+
+    // Filter every row, each prefixed by its filter type byte. When more
+    // than one filter is allowed, pick the one with the smallest sum of
+    // absolute (signed) residuals, as libpng does.
+    size_t rowbytes  = m_spec.scanline_bytes();
+    size_t bpp       = m_spec.pixel_bytes();
+    int height       = m_spec.height;
+    size_t frowbytes = rowbytes + 1;
+    std::vector<unsigned char> filtered(frowbytes * height);
+    parallel_for(0, height, [&](int64_t y) {
+        const unsigned char* row  = &m_imagebuf[y * rowbytes];
+        const unsigned char* prev = y ? row - rowbytes : nullptr;
+        unsigned char* out        = &filtered[y * frowbytes];
+        uint64_t bestsum          = std::numeric_limits<uint64_t>::max();
+        std::vector<unsigned char> trial;
+        for (int type = PNG_FILTER_VALUE_NONE; type <= PNG_FILTER_VALUE_PAETH;
+             ++type) {
+            if (!(filtermask & (PNG_FILTER_NONE << type)))
+                continue;
+            if (bestsum == std::numeric_limits<uint64_t>::max()
+                && (filtermask >> (4 + type)) == 0) {
+                // Only one candidate: no need to measure it
+                out[0] = type;
+                filter_row(type, row, prev, rowbytes, bpp, out + 1);
+                break;
+            }
+            trial.resize(rowbytes);
+            filter_row(type, row, prev, rowbytes, bpp, trial.data());
+            uint64_t sum = 0;
+            for (unsigned char v : trial)
+                sum += v < 128 ? v : 256 - v;
+            if (sum < bestsum) {
+                bestsum = sum;
+                out[0]  = type;
+                memcpy(out + 1, trial.data(), rowbytes);
+            }
+        }
+    });
+    std::vector<unsigned char>().swap(m_imagebuf);
+
+    // Deflate bands of rows independently, pigz style: each band is a raw
+    // deflate stream primed with the previous 32KB as its dictionary and
+    // ended with a sync flush (the last one with a finish), so that the
+    // concatenation is one valid zlib stream. The zlib header and the
+    // Adler-32 of the whole (combined from per-band checksums) go around it.
+    int bandrows = std::max(1, int((256 * 1024) / frowbytes));
+    int nbands   = (height + bandrows - 1) / bandrows;
+    std::vector<std::vector<unsigned char>> bands(nbands);
+    std::vector<uLong> adlers(nbands);
+    bool ok           = true;
+    thread_pool* pool = default_thread_pool();
+    task_set tasks(pool);
+    for (int b = 0; b < nbands; ++b) {
+        tasks.push(pool->push([&, b](int /*id*/) {
+            size_t begin = size_t(b) * bandrows * frowbytes;
+            size_t len   = std::min(size_t(bandrows) * frowbytes,
+                                    filtered.size() - begin);
+            const Bytef* in = filtered.data() + begin;
+            adlers[b]       = adler32(adler32(0, Z_NULL, 0), in, uInt(len));
+            z_stream z;
+            memset(&z, 0, sizeof(z));
+            if (deflateInit2(&z, m_zlevel, Z_DEFLATED, -15, 8, m_zstrategy)
+                != Z_OK) {
+                ok = false;
+                return;
+            }
+            if (b > 0) {
+                size_t dictlen = std::min(begin, size_t(32768));
+                deflateSetDictionary(&z, in - dictlen, uInt(dictlen));
+            }
+            bands[b].resize(deflateBound(&z, uLong(len)) + 64);
+            z.next_in   = const_cast<Bytef*>(in);
+            z.avail_in  = uInt(len);
+            z.next_out  = bands[b].data();
+            z.avail_out = uInt(bands[b].size());
+            int flush   = b == nbands - 1 ? Z_FINISH : Z_SYNC_FLUSH;
+            int zerr    = deflate(&z, flush);
+            if (zerr != (flush == Z_FINISH ? Z_STREAM_END : Z_OK)
+                || z.avail_in)
+                ok = false;
+            bands[b].resize(z.total_out);
+            deflateEnd(&z);
+        }));
+    }
+
+    // Write the bands as IDAT chunks, in order, as each is done.
+    uLong adler = adler32(0, Z_NULL, 0);
+    for (int b = 0; b < nbands; ++b) {
+        tasks.wait_for_task(b);
+        if (!ok)
+            break;
+        std::vector<unsigned char>& chunk(bands[b]);
+        size_t len = std::min(size_t(bandrows) * frowbytes,
+                              filtered.size() - size_t(b) * bandrows
+                                                    * frowbytes);
+        adler = adler32_combine(adler, adlers[b], z_off_t(len));
+        if (b == 0) {
+            // zlib header: deflate with a 32KB window, and a level hint
+            int flevel = (m_zstrategy >= Z_HUFFMAN_ONLY || m_zlevel < 2) ? 0
+                         : m_zlevel < 6                                  ? 1
+                         : m_zlevel == 6                                 ? 2
+                                                                         : 3;
+            int header = (0x78 << 8) | (flevel << 6);
+            header += 31 - header % 31;
+            chunk.insert(chunk.begin(),
+                         { (unsigned char)(header >> 8),
+                           (unsigned char)(header & 0xff) });
+        }
+        if (b == nbands - 1) {
+            for (int shift = 24; shift >= 0; shift -= 8)
+                chunk.push_back((unsigned char)(adler >> shift));
+        }
+        if (!PNG_pvt::write_chunk(m_png, "IDAT", chunk.data(), chunk.size())) {
+            ok = false;
+            break;
+        }
+        std::vector<unsigned char>().swap(chunk);
+    }
+    tasks.wait();
+    if (ok)
+        ok = PNG_pvt::write_chunk(m_png, "IEND", nullptr, 0);
+    if (!ok || m_err) {
+        errorfmt("PNG compression error");
+        return false;
+    }
+    return true;
+}
+
+
+
 bool
 PNGOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
                       stride_t xstride, stride_t ystride, stride_t zstride)
@@ -174,16 +174,18 @@ inline void
 unpack_floats(const unsigned char* read, float* write, imagesize_t numsamples,
               float scaling_factor)
 {
-    float* read_floats = (float*)read;
-
+    // Copy first and fix up in place, since the file bytes may be a
+    // read-only memory mapping.
+    memcpy(write, read, numsamples * sizeof(float));
     if ((scaling_factor < 0 && bigendian())
         || (scaling_factor > 0 && littleendian())) {
-        swap_endian(read_floats, numsamples);
+        swap_endian(write, numsamples);
     }
 
     float absfactor = fabs(scaling_factor);
-    for (imagesize_t i = 0; i < numsamples; i++) {
-        write[i] = absfactor * read_floats[i];
+    if (absfactor != 1.0f) {
+        for (imagesize_t i = 0; i < numsamples; i++)
+            write[i] *= absfactor;
     }
 }
 
@@ -200,33 +202,40 @@ PNMInput::read_file_scanline(void* data, int y)
         m_y_next    = 0;
     }
 
-    std::vector<unsigned char> buf;
+    const unsigned char* buf = nullptr;
+
     int nsamples = m_spec.width * m_spec.nchannels;
     bool good    = true;
+    bool binary  = (m_pnm_type >= P4 && m_pnm_type <= P6) || m_pnm_type == PF
+                  || m_pnm_type == Pf;
+
+    size_t numbytes = 0;
+    if (m_pnm_type == P4)
+        numbytes = (m_spec.width + 7) / 8;
+    else if (m_pnm_type == PF || m_pnm_type == Pf)
+        numbytes = size_t(m_spec.nchannels) * 4 * m_spec.width;
+    else if (binary)
+        numbytes = m_spec.scanline_bytes();
+    if (binary) {
+        // Binary scanlines are all the same size, so go right to the one
+        // we want rather than decoding the ones before it. PFM files are
+        // bottom-to-top, so we need to seek to the right spot.
+        int file_scanline = y - m_spec.y;
+        if ((m_pnm_type == PF || m_pnm_type == Pf) && m_pfm_flip)
+            file_scanline = m_spec.height - 1 - (y - m_spec.y);
+        size_t offset = size_t(file_scanline) * numbytes;
+        if (offset > m_after_header.size())
+            return false;
+        m_remaining = m_after_header.substr(offset);
+        m_y_next    = y;
+    }
     // If y is farther ahead, skip scanlines to get to it
     for (; good && m_y_next <= y; ++m_y_next) {
-        // PFM files are bottom-to-top, so we need to seek to the right spot
-        if (m_pnm_type == PF || m_pnm_type == Pf) {
-            if (m_pfm_flip) {
-                int file_scanline = m_spec.height - 1 - (y - m_spec.y);
-                auto offset       = file_scanline * m_spec.scanline_bytes();
-                m_remaining       = m_after_header.substr(offset);
-            }
-        }
-
-        if ((m_pnm_type >= P4 && m_pnm_type <= P6) || m_pnm_type == PF
-            || m_pnm_type == Pf) {
-            int numbytes;
-            if (m_pnm_type == P4)
-                numbytes = (m_spec.width + 7) / 8;
-            else if (m_pnm_type == PF || m_pnm_type == Pf)
-                numbytes = m_spec.nchannels * 4 * m_spec.width;
-            else
-                numbytes = m_spec.scanline_bytes();
-            if (size_t(numbytes) > m_remaining.size())
+        if (binary) {
+            if (numbytes > m_remaining.size())
                 return false;
-            buf.assign(m_remaining.begin(), m_remaining.begin() + numbytes);
-
+            // Decode right from the file bytes, no intermediate copy
+            buf = (const unsigned char*)m_remaining.data();
             m_remaining.remove_prefix(numbytes);
         }
 
@@ -246,23 +255,29 @@ PNMInput::read_file_scanline(void* data, int y)
                                      (unsigned char)m_max_val);
             break;
         //Raw
-        case P4: unpack(&buf[0], (unsigned char*)data, nsamples); break;
+        case P4: unpack(buf, (unsigned char*)data, nsamples); break;
         case P5:
         case P6:
             if (m_max_val > std::numeric_limits<unsigned char>::max()) {
+                // Copy, then swap and rescale in place in the caller's
+                // buffer (the file bytes may be a read-only mapping).
+                unsigned short* out = (unsigned short*)data;
+                memcpy(out, buf, numbytes);
                 if (littleendian())
-                    swap_endian((unsigned short*)&buf[0], nsamples);
-                raw_to_raw((unsigned short*)&buf[0], (unsigned short*)data,
-                           nsamples, (unsigned short)m_max_val);
+                    swap_endian(out, nsamples);
+                if (m_max_val != std::numeric_limits<unsigned short>::max())
+                    raw_to_raw(out, out, nsamples, (unsigned short)m_max_val);
+            } else if (m_max_val == std::numeric_limits<unsigned char>::max()) {
+                memcpy(data, buf, numbytes);
             } else {
-                raw_to_raw((unsigned char*)&buf[0], (unsigned char*)data,
-                           nsamples, (unsigned char)m_max_val);
+                raw_to_raw(buf, (unsigned char*)data, nsamples,
+                           (unsigned char)m_max_val);
             }
             break;
         //Floating point
         case Pf:
         case PF:
-            unpack_floats(&buf[0], (float*)data, nsamples, m_scaling_factor);
+            unpack_floats(buf, (float*)data, nsamples, m_scaling_factor);
             break;
         default: return false;
         }
@@ -367,11 +382,19 @@ PNMInput::open(const std::string& name, ImageSpec& newspec)
     if (!ioproxy_use_or_open(name))
         return false;
 
-    // Read the whole file's contents into m_file_contents
-    Filesystem::IOProxy* m_io = ioproxy();
-    m_file_contents.resize(m_io->size());
-    m_io->pread(m_file_contents.data(), m_file_contents.size(), 0);
-    m_remaining = string_view(m_file_contents.data(), m_file_contents.size());
+    // Parse a file that is already in memory (or memory-mapped) in place;
+    // otherwise read the whole file's contents into m_file_contents.
+    cspan<unsigned char> contents = ioproxy_buffer();
+    if (contents.size()) {
+        m_remaining = string_view((const char*)contents.data(),
+                                  contents.size());
+    } else {
+        Filesystem::IOProxy* m_io = ioproxy();
+        m_file_contents.resize(m_io->size());
+        m_io->pread(m_file_contents.data(), m_file_contents.size(), 0);
+        m_remaining = string_view(m_file_contents.data(),
+                                  m_file_contents.size());
+    }
 
     if (!read_file_header())
         return false;
@@ -19,6 +19,7 @@
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/span_util.h>
 #include <OpenImageIO/tiffutils.h>
 
@@ -134,10 +135,12 @@ private:
         uint32_t width;
         uint32_t height;
 
-        // This data is only relevant for the compression
-        // codecs zip and zipprediction as we need to preallocate
-        // the memory this vector is already decompressed and byteswapped
+        // For layer channels compressed with RLE, zip or zipprediction,
+        // open() only notes where the data is (deferred). The whole
+        // channel is decompressed (and byteswapped) into this vector the
+        // first time its layer is read.
         std::vector<char> decompressed_data;
+        bool deferred = false;
 
         std::vector<uint32_t> rle_lengths;
         std::vector<int64_t> row_pos;
@@ -207,6 +210,8 @@ private:
     //psd:RawData config option, indicates that the user wants the raw,
     //unconverted channel data
     bool m_WantRaw;
+    //oiio:metadata config option, how much Exif/XMP to decode
+    string_view m_metadata = "all";
     TypeDesc m_type_desc;
     //This holds all the ChannelInfos for all subimages
     //Example: m_channels[subimg][channel]
@@ -224,6 +229,8 @@ private:
     ColorModeData m_color_data;
     LayerMaskInfo m_layer_mask_info;
     std::vector<Layer> m_layers;
+    //The layer subimage whose deferred channels are decompressed, if any
+    int m_decoded_subimage;
     GlobalMaskInfo m_global_mask_info;
     ImageDataSection m_image_data;
     ImageBuf m_thumbnail;
@@ -280,6 +287,11 @@ private:
     bool load_layer_channels(Layer& layer);
     bool load_layer_channel(Layer& layer, ChannelInfo& channel_info);
     bool read_rle_lengths(uint32_t height, std::vector<uint32_t>& rle_lengths);
+    // Decompress the deferred channels of a layer subimage, in parallel,
+    // releasing those of the previously decompressed layer.
+    bool decode_layer_channels(int subimage);
+    bool decode_channel(ChannelInfo& channel_info, span<char> src,
+                        std::string& err) const;
 
     //Global Mask Info
     bool load_global_mask_info();
@@ -433,14 +445,18 @@ private:
     // Swap a planar bytespan representing the bytes of a float vector to its
     // interleaved byte order. This is per scanline
     void float_planar_to_interleaved(span<char> data, size_t width,
-                                     size_t height);
+                                     size_t height) const;
 
-    // All the compression modes known to photoshop
+    // All the compression modes known to photoshop. These may run on
+    // several threads at once, so rather than setting the error state,
+    // they return any error message in err.
     bool decompress_packbits(const char* src, char* dst, uint32_t packed_length,
-                             uint32_t unpacked_length);
-    bool decompress_zip(span<char> src, span<char> dest);
+                             uint32_t unpacked_length, std::string& err) const;
+    bool decompress_zip(span<char> src, span<char> dest,
+                        std::string& err) const;
     bool decompress_zip_prediction(span<char> src, span<char> dest,
-                                   const uint32_t width, const uint32_t height);
+                                   const uint32_t width, const uint32_t height,
+                                   std::string& err) const;
 
     // These are AdditionalInfo entries that, for PSBs, have an 8-byte length
     static const char* additional_info_psb[];
@@ -638,6 +654,7 @@ PSDInput::open(const std::string& name, ImageSpec& newspec,
 {
     m_WantRaw = config.get_int_attribute("psd:RawData")
                 || config.get_int_attribute("oiio:RawColor");
+    m_metadata = metadata_hint(config);
 
     if (config.get_int_attribute("oiio:UnassociatedAlpha", 0) == 1)
         m_keep_unassociated_alpha = true;
@@ -774,6 +791,9 @@ PSDInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
         return false;
     }
 
+    if (subimage > 0 && !decode_layer_channels(subimage))
+        return false;
+
     // Buffers for channel data, one per channel
     std::vector<std::vector<unsigned char>> channel_buffers;
     channel_buffers.resize(m_channels[subimage].size());
@@ -902,8 +922,10 @@ PSDInput::init()
     m_subimage       = -1;
     m_subimage_count = 0;
     m_specs.clear();
-    m_WantRaw = false;
+    m_WantRaw  = false;
+    m_metadata = "all";
     m_layers.clear();
+    m_decoded_subimage = -1;
     m_image_data.channel_info.clear();
     m_image_data.transparency = false;
     m_channels.clear();
@@ -1273,8 +1295,13 @@ PSDInput::load_resource_1058(uint32_t length)
     if (!ioread(&data[0], length))
         return false;
 
-    if (!decode_exif(data, m_composite_attribs)
-        || !decode_exif(data, m_common_attribs)) {
+    if (m_metadata == "lazy") {
+        TypeDesc type(TypeDesc::UINT8, length);
+        m_composite_attribs.attribute("oiio:RawExif", type, data.data());
+        m_common_attribs.attribute("oiio:RawExif", type, data.data());
+    } else if (m_metadata != "none"
+               && (!decode_exif(data, m_composite_attribs)
+                   || !decode_exif(data, m_common_attribs))) {
         errorfmt("Failed to decode Exif data");
         return false;
     }
@@ -1300,8 +1327,13 @@ PSDInput::load_resource_1060(uint32_t length)
         return false;
 
     // Store the XMP data for the composite and all other subimages
-    if (!decode_xmp(data, m_composite_attribs)
-        || !decode_xmp(data, m_common_attribs)) {
+    if (m_metadata == "lazy") {
+        TypeDesc type(TypeDesc::UINT8, length);
+        m_composite_attribs.attribute("oiio:RawXMP", type, data.data());
+        m_common_attribs.attribute("oiio:RawXMP", type, data.data());
+    } else if (m_metadata == "all"
+               && (!decode_xmp(data, m_composite_attribs)
+                   || !decode_xmp(data, m_common_attribs))) {
         errorfmt("Failed to decode XMP data");
         return false;
     }
@@ -1604,7 +1636,6 @@ PSDInput::load_layer_channels(Layer& layer)
 bool
 PSDInput::load_layer_channel(Layer& layer, ChannelInfo& channel_info)
 {
-    int64_t start_pos = iotell();
     if (channel_info.data_length >= 2) {
         if (!read_bige<uint16_t>(channel_info.compression))
             return false;
@@ -1645,83 +1676,149 @@ PSDInput::load_layer_channel(Layer& layer, ChannelInfo& channel_info)
             return false;
         break;
     case Compression_RLE:
-        // RLE lengths are stored before the channel data
-        if (!read_rle_lengths(height, channel_info.rle_lengths))
-            return false;
-
-        // channel data is located after the RLE lengths
-        channel_info.data_pos = iotell();
-        // subtract the RLE lengths read above
-        channel_info.data_length = channel_info.data_length
-                                   - (channel_info.data_pos - start_pos);
-        if (height) {
-            channel_info.row_pos[0] = channel_info.data_pos;
-            for (uint32_t i = 1; i < height; ++i)
-                channel_info.row_pos[i] = channel_info.row_pos[i - 1]
-                                          + channel_info.rle_lengths[i - 1];
-        }
-
+    case Compression_ZIP:
+    case Compression_ZIP_Predict:
+        // Don't read or decompress anything yet, just note where the data
+        // is (for RLE, the row lengths followed by the rows) and skip it.
+        // We subtract the compression marker from the data length
+        channel_info.data_length -= 2;
+        channel_info.deferred = true;
         if (!ioseek(channel_info.data_length, SEEK_CUR))
             return false;
         break;
-    case Compression_ZIP: {
-        // We subtract the compression marker from the data length
-        channel_info.data_length -= 2;
+    default:
+        errorfmt("[Layer Channel] unsupported compression {}",
+                 channel_info.compression);
+        return false;
+    }
+    return true;
+}
 
-        // Unlike with raw and rle compression we cannot access each scanline
-        // randomly so we parse the data up-front and store it
-        std::vector<char> compressed_data(channel_info.data_length);
-        channel_info.decompressed_data = std::vector<char>(
-            width * height * (m_header.depth / 8));
 
-        if (!ioseek(channel_info.data_pos))
-            return false;
-        if (!ioread(compressed_data.data(), channel_info.data_length))
-            return false;
 
-        decompress_zip(compressed_data, channel_info.decompressed_data);
-    } break;
-    case Compression_ZIP_Predict: {
-        // We subtract the compression marker from the data length
-        channel_info.data_length -= 2;
+bool
+PSDInput::read_rle_lengths(uint32_t height, std::vector<uint32_t>& rle_lengths)
+{
+    // The lengths are 16 bits in PSD files, 32 bits in PSB files. Read
+    // them all at once rather than a value at a time.
+    size_t bytes = m_header.version == 1 ? 2 : 4;
+    std::vector<unsigned char> buf(bytes * height);
+    if (!ioread(buf.data(), buf.size()))
+        return false;
+    rle_lengths.resize(height);
+    for (uint32_t row = 0; row < height; ++row) {
+        const unsigned char* b = &buf[row * bytes];
+        rle_lengths[row] = bytes == 2 ? (uint32_t(b[0]) << 8) | b[1]
+                                      : (uint32_t(b[0]) << 24)
+                                            | (uint32_t(b[1]) << 16)
+                                            | (uint32_t(b[2]) << 8) | b[3];
+    }
+    return true;
+}
+
 
-        // Unlike with raw and rle compression we cannot access each scanline
-        // randomly so we parse the data up-front and store it
-        std::vector<char> compressed_data(channel_info.data_length);
-        channel_info.decompressed_data = std::vector<char>(
-            width * height * (m_header.depth / 8));
 
-        if (!ioseek(channel_info.data_pos))
+bool
+PSDInput::decode_layer_channels(int subimage)
+{
+    lock_guard lock(*this);
+    if (subimage == m_decoded_subimage)
+        return true;
+
+    // Only one layer's channels are kept decompressed at a time.
+    if (m_decoded_subimage > 0) {
+        for (ChannelInfo* channel_info : m_channels[m_decoded_subimage]) {
+            if (channel_info && channel_info->decompressed_data.size()) {
+                channel_info->decompressed_data = std::vector<char>();
+                channel_info->deferred          = true;
+            }
+        }
+        m_decoded_subimage = -1;
+    }
+
+    // Read the compressed data of all the layer's deferred channels, then
+    // decompress the channels in parallel.
+    std::vector<ChannelInfo*> channels;
+    for (ChannelInfo* channel_info : m_channels[subimage])
+        if (channel_info && channel_info->deferred
+            && std::find(channels.begin(), channels.end(), channel_info)
+                   == channels.end())
+            channels.push_back(channel_info);
+    std::vector<std::vector<char>> compressed(channels.size());
+    for (size_t c = 0; c < channels.size(); ++c) {
+        compressed[c].resize(channels[c]->data_length);
+        if (!ioseek(channels[c]->data_pos)
+            || !ioread(compressed[c].data(), compressed[c].size()))
             return false;
-        if (!ioread(compressed_data.data(), channel_info.data_length))
+    }
+    std::vector<std::string> errors(channels.size());
+    parallel_for(
+        int64_t(0), int64_t(channels.size()),
+        [&](int64_t c) {
+            if (decode_channel(*channels[c], compressed[c], errors[c]))
+                channels[c]->deferred = false;
+        },
+        paropt(threads()));
+    for (size_t c = 0; c < channels.size(); ++c) {
+        if (channels[c]->deferred) {
+            errorfmt("[Layer Channel] {}", errors[c]);
             return false;
-
-        decompress_zip_prediction(compressed_data,
-                                  channel_info.decompressed_data, width,
-                                  height);
-    } break;
-    default:
-        errorfmt("[Layer Channel] unsupported compression {}",
-                 channel_info.compression);
-        return false;
+        }
     }
+    m_decoded_subimage = subimage;
     return true;
 }
 
 
 
 bool
-PSDInput::read_rle_lengths(uint32_t height, std::vector<uint32_t>& rle_lengths)
+PSDInput::decode_channel(ChannelInfo& channel_info, span<char> src,
+                         std::string& err) const
 {
-    rle_lengths.resize(height);
-    bool ok = true;
-    for (uint32_t row = 0; row < height && ok; ++row) {
-        if (m_header.version == 1)
-            ok &= read_bige<uint16_t>(rle_lengths[row]);
-        else
-            ok &= read_bige<uint32_t>(rle_lengths[row]);
+    uint32_t width  = channel_info.width;
+    uint32_t height = channel_info.height;
+    std::vector<char>& dest(channel_info.decompressed_data);
+    switch (channel_info.compression) {
+    case Compression_RLE: {
+        // The row lengths (16 bits in PSD files, 32 bits in PSB files)
+        // come first, followed by the packbits compressed rows.
+        size_t bytes   = m_header.version == 1 ? 2 : 4;
+        size_t srcsize = src.size();
+        if (srcsize < bytes * height) {
+            err = "not enough data for the RLE row lengths";
+            return false;
+        }
+        dest.resize(size_t(channel_info.row_length) * height);
+        size_t pos = bytes * height;
+        for (uint32_t row = 0; row < height; ++row) {
+            const unsigned char* b = (const unsigned char*)&src[row * bytes];
+            uint32_t length = 0;
+            for (size_t i = 0; i < bytes; ++i)
+                length = (length << 8) | b[i];
+            if (length > srcsize - pos) {
+                err = "not enough data for the RLE rows";
+                return false;
+            }
+            if (!decompress_packbits(&src[pos],
+                                     &dest[size_t(row)
+                                           * channel_info.row_length],
+                                     length, channel_info.row_length, err))
+                return false;
+            pos += length;
+        }
+        return true;
     }
-    return ok;
+    case Compression_ZIP:
+        dest.resize(size_t(width) * height * (m_header.depth / 8));
+        return decompress_zip(src, dest, err);
+    case Compression_ZIP_Predict:
+        dest.resize(size_t(width) * height * (m_header.depth / 8));
+        return decompress_zip_prediction(src, dest, width, height, err);
+    default: break;
+    }
+    err = Strutil::fmt::format("unsupported compression {}",
+                               channel_info.compression);
+    return false;
 }
 
 
@@ -2047,15 +2144,27 @@ PSDInput::read_channel_row(ChannelInfo& channel_info, uint32_t row, char* data)
             }
             break;
         case Compression_RLE: {
+            if (channel_info.decompressed_data.size()) {
+                // A layer channel, already decompressed in full
+                std::memcpy(data,
+                            channel_info.decompressed_data.data()
+                                + uint64_t(row) * channel_info.row_length,
+                            channel_info.row_length);
+                break;
+            }
             if (!ioseek(channel_info.row_pos[row]))
                 return false;
             uint32_t rle_length = channel_info.rle_lengths[row];
             char* rle_buffer;
             OIIO_ALLOCATE_STACK_OR_HEAP(rle_buffer, char, rle_length);
-            if (!ioread(rle_buffer, rle_length)
-                || !decompress_packbits(rle_buffer, data, rle_length,
-                                        channel_info.row_length))
+            if (!ioread(rle_buffer, rle_length))
+                return false;
+            std::string err;
+            if (!decompress_packbits(rle_buffer, data, rle_length,
+                                     channel_info.row_length, err)) {
+                errorfmt("{}", err);
                 return false;
+            }
         } break;
         case Compression_ZIP: {
             OIIO_ASSERT(channel_info.decompressed_data.size()
@@ -2198,7 +2307,7 @@ PSDInput::read_pascal_string(std::string& s, uint16_t mod_padding)
 
 void
 PSDInput::float_planar_to_interleaved(span<char> data, size_t width,
-                                      size_t height)
+                                      size_t height) const
 {
     std::vector<char> buffer(data.size());
 
@@ -2223,8 +2332,10 @@ PSDInput::float_planar_to_interleaved(span<char> data, size_t width,
 
 bool
 PSDInput::decompress_packbits(const char* src, char* dst,
-                              uint32_t packed_length, uint32_t unpacked_length)
+                              uint32_t packed_length, uint32_t unpacked_length,
+                              std::string& err) const
 {
+    char* dst_start = dst;
     int32_t src_remaining = packed_length;
     int32_t dst_remaining = unpacked_length;
     int16_t header;
@@ -2243,7 +2354,7 @@ PSDInput::decompress_packbits(const char* src, char* dst,
             src_remaining -= length;
             dst_remaining -= length;
             if (src_remaining < 0 || dst_remaining < 0) {
-                errorfmt(
+                err = Strutil::fmt::format(
                     "unable to decode packbits (case 1, literal bytes: src_rem={}, dst_rem={}, len={})",
                     src_remaining, dst_remaining, length);
                 return false;
@@ -2258,7 +2369,7 @@ PSDInput::decompress_packbits(const char* src, char* dst,
             src_remaining--;
             dst_remaining -= length;
             if (src_remaining < 0 || dst_remaining < 0) {
-                errorfmt(
+                err = Strutil::fmt::format(
                     "unable to decode packbits (case 2, repeating byte: src_rem={}, dst_rem={}, len={})",
                     src_remaining, dst_remaining, length);
                 return false;
@@ -2272,8 +2383,12 @@ PSDInput::decompress_packbits(const char* src, char* dst,
 
     if (!bigendian()) {
         switch (m_header.depth) {
-        case 16: swap_endian((uint16_t*)dst, m_spec.width); break;
-        case 32: swap_endian((uint32_t*)dst, m_spec.width); break;
+        case 16:
+            swap_endian((uint16_t*)dst_start, unpacked_length / 2);
+            break;
+        case 32:
+            swap_endian((uint32_t*)dst_start, unpacked_length / 4);
+            break;
         }
     }
 
@@ -2283,7 +2398,8 @@ PSDInput::decompress_packbits(const char* src, char* dst,
 
 
 bool
-PSDInput::decompress_zip(span<char> src, span<char> dest)
+PSDInput::decompress_zip(span<char> src, span<char> dest,
+                         std::string& err) const
 {
     z_stream stream {};
     stream.zfree     = Z_NULL;
@@ -2294,21 +2410,21 @@ PSDInput::decompress_zip(span<char> src, span<char> dest)
     stream.next_out  = (Bytef*)dest.data();
 
     if (inflateInit(&stream) != Z_OK) {
-        errorfmt(
+        err = Strutil::fmt::format(
             "zip compression inflate init failed with: src_size={}, dst_size={}",
             src.size(), dest.size());
         return false;
     }
 
     if (inflate(&stream, Z_FINISH) != Z_STREAM_END) {
-        errorfmt(
+        err = Strutil::fmt::format(
             "unable to decode zip compressed data: src_size={}, dst_size={}",
             src.size(), dest.size());
         return false;
     }
 
     if (inflateEnd(&stream) != Z_OK) {
-        errorfmt(
+        err = Strutil::fmt::format(
             "zip compression inflate cleanup failed with: src_size={}, dst_size={}",
             src.size(), dest.size());
         return false;
@@ -2321,13 +2437,14 @@ PSDInput::decompress_zip(span<char> src, span<char> dest)
 
 bool
 PSDInput::decompress_zip_prediction(span<char> src, span<char> dest,
-                                    const uint32_t width, const uint32_t height)
+                                    const uint32_t width, const uint32_t height,
+                                    std::string& err) const
 {
     OIIO_ASSERT(width * height * (m_header.depth / 8) == dest.size());
     bool ok = true;
     // Decompress into dest first and then apply the prediction decoding
     // on dest
-    ok &= decompress_zip(src, dest);
+    ok &= decompress_zip(src, dest, err);
 
     switch (m_header.depth) {
     case 8:
@@ -2378,7 +2495,8 @@ PSDInput::decompress_zip_prediction(span<char> src, span<char> dest,
                                dest.size() / 4));
     } break;
     default:
-        errorfmt("Unknown bitdepth: {} encountered", m_header.depth);
+        err = Strutil::fmt::format("Unknown bitdepth: {} encountered",
+                                   m_header.depth);
         return false;
     }
 
@@ -13,11 +13,7 @@ OIIO_PLUGIN_NAMESPACE_BEGIN
 
 class PtexInput final : public ImageInput {
 public:
-    PtexInput()
-        : m_ptex(NULL)
-    {
-        init();
-    }
+    PtexInput() { init(); }
     ~PtexInput() override { close(); }
     const char* format_name(void) const override { return "ptex"; }
     int supports(string_view feature) const override
@@ -45,7 +41,7 @@ public:
                           void* data) override;
 
 private:
-    PtexTexture* m_ptex;
+    std::string m_filename;
     int m_subimage;
     int m_miplevel;
     int m_numFaces;
@@ -60,16 +56,37 @@ private:
     ///
     void init()
     {
-        if (m_ptex)
-            m_ptex->release();
-        m_ptex     = NULL;
+        m_filename.clear();
         m_subimage = -1;
         m_miplevel = -1;
     }
+
+    /// Borrow the texture from the shared cache. Release it as soon as
+    /// the call at hand is done with it: the cache can only prune the face
+    /// data of textures that nobody holds.
+    PtexTexture* texture();
 };
 
 
 
+// All Ptex files are read through one process-wide cache, so that the
+// memory Ptex keeps for face data is bounded over all open files together
+// (by the "ptex:max_memory_MB" attribute), rather than growing without
+// limit in each file, outside the ImageCache's budget.
+static PtexCache*
+shared_ptex_cache()
+{
+    static PtexCache* cache = PtexCache::create(
+        100 /*max files*/,
+        size_t(std::max(0, OIIO::get_int_attribute("ptex:max_memory_MB",
+                                                   64)))
+            * 1024 * 1024,
+        true /*premultiply*/);
+    return cache;
+}
+
+
+
 // Obligatory material to make this a recognizable imageio plugin:
 OIIO_PLUGIN_EXPORTS_BEGIN
 
@@ -95,22 +112,38 @@ OIIO_PLUGIN_EXPORTS_END
 
 
 
+PtexTexture*
+PtexInput::texture()
+{
+    Ptex::String perr;
+    PtexTexture* ptex = shared_ptex_cache()->get(m_filename.c_str(), perr);
+    if (!ptex || !perr.empty()) {
+        if (ptex)
+            ptex->release();
+        errorfmt("{}",
+                 perr.empty() ? "Could not open Ptex file" : perr.c_str());
+        return nullptr;
+    }
+    return ptex;
+}
+
+
+
 bool
 PtexInput::open(const std::string& name, ImageSpec& newspec)
 {
-    Ptex::String perr;
-    m_ptex = PtexTexture::open(name.c_str(), perr, true /*premultiply*/);
-    if (!perr.empty()) {
-        if (m_ptex) {
-            m_ptex->release();
-            m_ptex = NULL;
-        }
-        errorfmt("{}", perr.c_str());
+    // Drop anything the cache holds for this file, in case it has changed
+    // since it was last read (as when the ImageCache is invalidated).
+    shared_ptex_cache()->purge(name.c_str());
+    m_filename = name;
+    PtexPtr<PtexTexture> ptex(texture());
+    if (!ptex) {
+        m_filename.clear();
         return false;
     }
 
-    m_numFaces   = m_ptex->numFaces();
-    m_hasMipMaps = m_ptex->hasMipMaps();
+    m_numFaces   = ptex->numFaces();
+    m_hasMipMaps = ptex->hasMipMaps();
 
     bool ok = seek_subimage(0, 0);
     newspec = spec();
@@ -127,8 +160,11 @@ PtexInput::seek_subimage(int subimage, int miplevel)
 
     if (subimage < 0 || subimage >= m_numFaces)
         return false;
+    PtexPtr<PtexTexture> ptex(texture());
+    if (!ptex)
+        return false;
     m_subimage                  = subimage;
-    const Ptex::FaceInfo& pface = m_ptex->getFaceInfo(subimage);
+    const Ptex::FaceInfo& pface = ptex->getFaceInfo(subimage);
     m_faceres                   = pface.res;
 
     int nmiplevels = std::max(m_faceres.ulog2, m_faceres.vlog2) + 1;
@@ -139,7 +175,7 @@ PtexInput::seek_subimage(int subimage, int miplevel)
                              std::max(0, m_faceres.vlog2 - miplevel));
 
     TypeDesc format = TypeDesc::UNKNOWN;
-    switch (m_ptex->dataType()) {
+    switch (ptex->dataType()) {
     case Ptex::dt_uint8: format = TypeDesc::UINT8; break;
     case Ptex::dt_uint16: format = TypeDesc::UINT16; break;
     case Ptex::dt_half: format = TypeDesc::HALF; break;
@@ -149,19 +185,19 @@ PtexInput::seek_subimage(int subimage, int miplevel)
 
     m_spec = ImageSpec(std::max(1, m_faceres.u() >> miplevel),
                        std::max(1, m_faceres.v() >> miplevel),
-                       m_ptex->numChannels(), format);
+                       ptex->numChannels(), format);
 
-    m_spec.alpha_channel = m_ptex->alphaChannel();
+    m_spec.alpha_channel = ptex->alphaChannel();
 
-    if (m_ptex->meshType() == Ptex::mt_triangle)
+    if (ptex->meshType() == Ptex::mt_triangle)
         m_spec.attribute("ptex:meshType", "triangle");
     else
         m_spec.attribute("ptex:meshType", "quad");
 
-    if (m_ptex->hasEdits())
+    if (ptex->hasEdits())
         m_spec.attribute("ptex:hasEdits", (int)1);
 
-    PtexFaceData* facedata = m_ptex->getData(m_subimage, m_faceres);
+    PtexFaceData* facedata = ptex->getData(m_subimage, m_faceres);
     m_isTiled              = facedata->isTiled();
     if (m_isTiled) {
         m_tileres          = facedata->tileRes();
@@ -175,18 +211,18 @@ PtexInput::seek_subimage(int subimage, int miplevel)
     }
 
     std::string wrapmode;
-    if (m_ptex->uBorderMode() == Ptex::m_clamp)
+    if (ptex->uBorderMode() == Ptex::m_clamp)
         wrapmode = "clamp";
-    else if (m_ptex->uBorderMode() == Ptex::m_black)
+    else if (ptex->uBorderMode() == Ptex::m_black)
         wrapmode = "black";
-    else  // if (m_ptex->uBorderMode() == Ptex::m_periodic)
+    else  // if (ptex->uBorderMode() == Ptex::m_periodic)
         wrapmode = "periodic";
     wrapmode += ",";
-    if (m_ptex->uBorderMode() == Ptex::m_clamp)
+    if (ptex->uBorderMode() == Ptex::m_clamp)
         wrapmode += "clamp";
-    else if (m_ptex->uBorderMode() == Ptex::m_black)
+    else if (ptex->uBorderMode() == Ptex::m_black)
         wrapmode += "black";
-    else  // if (m_ptex->uBorderMode() == Ptex::m_periodic)
+    else  // if (ptex->uBorderMode() == Ptex::m_periodic)
         wrapmode += "periodic";
     m_spec.attribute("wrapmode", wrapmode);
 
@@ -199,7 +235,7 @@ PtexInput::seek_subimage(int subimage, int miplevel)
         value    = (const void*)v;                            \
     }
 
-    PtexMetaData* pmeta = m_ptex->getMetaData();
+    PtexMetaData* pmeta = ptex->getMetaData();
     if (pmeta) {
         int n = pmeta->numKeys();
         for (int i = 0; i < n; ++i) {
@@ -270,7 +306,10 @@ PtexInput::read_native_tile(int subimage, int miplevel, int x, int y, int /*z*/,
     if (!seek_subimage(subimage, miplevel))
         return false;
 
-    PtexFaceData* facedata = m_ptex->getData(m_subimage, m_mipfaceres);
+    PtexPtr<PtexTexture> ptex(texture());
+    if (!ptex)
+        return false;
+    PtexFaceData* facedata = ptex->getData(m_subimage, m_mipfaceres);
 
     PtexFaceData* f = facedata;
     if (m_isTiled) {
@@ -13,16 +13,19 @@ namespace PyOpenImageIO {
 
 
 
-static ImageBuf
-ImageBuf_from_buffer(const py::buffer& buffer)
+// Work out the ImageSpec and byte strides of an image laid out in a NumPy
+// array: [y][x][c], [y][x] (single channel), or volumetric [z][y][x][c].
+// Return false after recording an error in ib if the array can't be
+// described that way.
+static bool
+buffer_layout(const py::buffer_info& info, ImageBuf& ib, ImageSpec& spec,
+              stride_t strides[3])
 {
-    ImageBuf ib;
-    const py::buffer_info info = buffer.request();
     TypeDesc format;
     if (info.format.size())
         format = typedesc_from_python_array_code(info.format);
     if (format == TypeUnknown)
-        return ib;
+        return false;
     // Strutil::print("IB from {} buffer: dims = {}\n", format, info.ndim);
     // for (int i = 0; i < info.ndim; ++i)
     //     Strutil::print("IB from buffer: dim[{}]: size = {}, stride = {}\n", i,
@@ -30,38 +33,128 @@ ImageBuf_from_buffer(const py::buffer& buffer)
     if (size_t(info.strides[info.ndim - 1]) != format.size()) {
         ib.errorfmt(
             "ImageBuf-from-numpy-array must have contiguous stride within pixels");
-        return ib;
+        return false;
     }
 
     if (info.ndim == 3) {
         // Assume [y][x][c]
-        ImageSpec spec(info.shape[1], info.shape[0], info.shape[2], format);
-        ib.reset(spec, InitializePixels::No);
-        ib.set_pixels(get_roi(spec), format, info.ptr, info.strides[1],
-                      info.strides[0]);
+        spec       = ImageSpec(info.shape[1], info.shape[0], info.shape[2],
+                               format);
+        strides[0] = info.strides[1];
+        strides[1] = info.strides[0];
+        strides[2] = AutoStride;
     } else if (info.ndim == 2) {
         // Assume [y][x], single channel
-        ImageSpec spec(info.shape[1], info.shape[0], 1, format);
-        ib.reset(spec, InitializePixels::No);
-        ib.set_pixels(get_roi(spec), format, info.ptr, info.strides[1],
-                      info.strides[0]);
+        spec       = ImageSpec(info.shape[1], info.shape[0], 1, format);
+        strides[0] = info.strides[1];
+        strides[1] = info.strides[0];
+        strides[2] = AutoStride;
     } else if (info.ndim == 4) {
         // Assume volume [z][y][x][c]
-        ImageSpec spec(info.shape[2], info.shape[1], info.shape[3], format);
+        spec = ImageSpec(info.shape[2], info.shape[1], info.shape[3], format);
         spec.depth      = info.shape[0];
         spec.full_depth = spec.depth;
-        ib.reset(spec, InitializePixels::No);
-        ib.set_pixels(get_roi(spec), format, info.ptr, info.strides[2],
-                      info.strides[1], info.strides[0]);
+        strides[0]      = info.strides[2];
+        strides[1]      = info.strides[1];
+        strides[2]      = info.strides[0];
     } else {
         ib.errorfmt(
             "ImageBuf-from-numpy-array must have 2, 3, or 4 dimensions");
+        return false;
+    }
+    return true;
+}
+
+
+
+static ImageBuf
+ImageBuf_from_buffer(const py::buffer& buffer)
+{
+    ImageBuf ib;
+    const py::buffer_info info = buffer.request();
+    ImageSpec spec;
+    stride_t strides[3];
+    if (buffer_layout(info, ib, spec, strides)) {
+        ib.reset(spec, InitializePixels::No);
+        ib.set_pixels(get_roi(spec), spec.format, info.ptr, strides[0],
+                      strides[1], strides[2]);
     }
     return ib;
 }
 
 
 
+// Make an APPBUFFER ImageBuf that uses the array's memory in place. The
+// binding keeps the array alive for as long as the ImageBuf.
+static ImageBuf
+ImageBuf_wrap_buffer(const py::buffer& buffer)
+{
+    ImageBuf ib;
+    const py::buffer_info info = buffer.request(true /*writable*/);
+    ImageSpec spec;
+    stride_t strides[3];
+    if (buffer_layout(info, ib, spec, strides))
+        ib.reset(spec, info.ptr, strides[0], strides[1], strides[2]);
+    return ib;
+}
+
+
+
+// The Python struct-module code for a pixel type, or nullptr if there
+// isn't one.
+static const char*
+buffer_format_code(TypeDesc format)
+{
+    switch (format.basetype) {
+    case TypeDesc::UINT8: return "B";
+    case TypeDesc::INT8: return "b";
+    case TypeDesc::UINT16: return "H";
+    case TypeDesc::INT16: return "h";
+    case TypeDesc::UINT32: return "I";
+    case TypeDesc::INT32: return "i";
+    case TypeDesc::UINT64: return "Q";
+    case TypeDesc::INT64: return "q";
+    case TypeDesc::HALF: return "e";
+    case TypeDesc::FLOAT: return "f";
+    case TypeDesc::DOUBLE: return "d";
+    default: return nullptr;
+    }
+}
+
+
+
+// Describe the ImageBuf's own pixel memory to the Python buffer protocol,
+// in the same [y][x][c] or [z][y][x][c] shape that get_pixels() returns,
+// so that numpy.asarray(buf) is a view rather than a copy. Only ImageBufs
+// whose pixels live in memory (not ones backed by the ImageCache) have
+// such a view; the view must not outlive reset() or clear().
+static py::buffer_info
+ImageBuf_buffer_info(ImageBuf& self)
+{
+    void* data = self.localpixels();
+    if (!data || self.deep())
+        throw py::buffer_error(
+            "ImageBuf has no local pixel memory (read with force=True or "
+            "call make_writable() first)");
+    TypeDesc format = self.spec().format;
+    const char* code = buffer_format_code(format);
+    if (!code)
+        throw py::buffer_error("ImageBuf pixel type has no buffer format");
+    const ImageSpec& spec(self.spec());
+    std::vector<py::ssize_t> shape { spec.height, spec.width, spec.nchannels };
+    std::vector<py::ssize_t> strides { self.scanline_stride(),
+                                       self.pixel_stride(),
+                                       py::ssize_t(format.size()) };
+    if (spec.depth > 1) {
+        shape.insert(shape.begin(), spec.depth);
+        strides.insert(strides.begin(), self.z_stride());
+    }
+    return py::buffer_info(data, py::ssize_t(format.size()), code,
+                           py::ssize_t(shape.size()), shape, strides);
+}
+
+
+
 py::tuple
 ImageBuf_getpixel(const ImageBuf& buf, int x, int y, int z = 0,
                   const std::string& wrapname = "black")
@@ -238,7 +331,8 @@ declare_imagebuf(py::module& m)
 {
     using namespace pybind11::literals;
 
-    py::class_<ImageBuf>(m, "ImageBuf")
+    py::class_<ImageBuf>(m, "ImageBuf", py::buffer_protocol())
+        .def_buffer(&ImageBuf_buffer_info)
         .def(py::init<>())
         .def(py::init<const std::string&>())
         .def(py::init<const std::string&, int, int>())
@@ -256,6 +350,11 @@ declare_imagebuf(py::module& m)
                  return ImageBuf_from_buffer(buffer);
              }),
              "buffer"_a)
+        .def(py::init([](const py::buffer& buffer, bool copy) {
+                 return copy ? ImageBuf_from_buffer(buffer)
+                             : ImageBuf_wrap_buffer(buffer);
+             }),
+             "buffer"_a, "copy"_a, py::keep_alive<1, 2>())
         .def("clear", &ImageBuf::clear)
         .def(
             "reset",
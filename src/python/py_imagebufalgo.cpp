@@ -1319,6 +1319,18 @@ IBA_computePixelHashSHA1(const ImageBuf& src, const std::string& extrainfo,
 
 
 
+std::string
+IBA_computePixelHash(const ImageBuf& src, const std::string& hashtype,
+                     const std::string& extrainfo, ROI roi = ROI::All(),
+                     int nthreads = 0)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::computePixelHash(src, hashtype, extrainfo, roi,
+                                          nthreads);
+}
+
+
+
 bool
 IBA_warp(ImageBuf& dst, const ImageBuf& src, py::object values_M,
          const std::string& filtername = "", float filterwidth = 0.0f,
@@ -1583,6 +1595,25 @@ IBA_median_filter_ret(const ImageBuf& src, int width, int height, ROI roi,
 
 
 
+bool
+IBA_rank_filter(ImageBuf& dst, const ImageBuf& src, float rank, int width,
+                int height, ROI roi, int nthreads)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::rank_filter(dst, src, rank, width, height, roi,
+                                     nthreads);
+}
+
+ImageBuf
+IBA_rank_filter_ret(const ImageBuf& src, float rank, int width, int height,
+                    ROI roi, int nthreads)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::rank_filter(src, rank, width, height, roi, nthreads);
+}
+
+
+
 bool
 IBA_dilate(ImageBuf& dst, const ImageBuf& src, int width, int height, ROI roi,
            int nthreads)
@@ -1755,6 +1786,24 @@ IBA_over_ret(const ImageBuf& A, const ImageBuf& B, ROI roi = ROI::All(),
 
 
 
+bool
+IBA_over_layers(ImageBuf& dst, const std::vector<const ImageBuf*>& layers,
+                ROI roi = ROI::All(), int nthreads = 0)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::over(dst, layers, roi, nthreads);
+}
+
+ImageBuf
+IBA_over_layers_ret(const std::vector<const ImageBuf*>& layers,
+                    ROI roi = ROI::All(), int nthreads = 0)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::over(layers, roi, nthreads);
+}
+
+
+
 bool
 IBA_zover(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
           bool z_zeroisinf = false, ROI roi = ROI::All(), int nthreads = 0)
@@ -2305,6 +2354,27 @@ IBA_histogram(const ImageBuf& src, int channel = 0, int bins = 256,
 
 
 
+py::object
+IBA_histograms(const ImageBuf& src, int bins = 256, float min = 0.0f,
+               float max = 1.0f, bool ignore_empty = false, ROI roi = {},
+               int nthreads = 0)
+{
+    std::vector<std::vector<imagesize_t>> hists;
+    {
+        py::gil_scoped_release gil;
+        hists = ImageBufAlgo::histograms(src, bins, min, max, ignore_empty,
+                                         roi, nthreads);
+    }
+    py::tuple result(hists.size());
+    for (size_t c = 0; c < hists.size(); ++c) {
+        std::vector<int> h(hists[c].begin(), hists[c].end());
+        result[c] = C_to_tuple<int>(h);
+    }
+    return result;
+}
+
+
+
 bool
 IBA_capture_image(ImageBuf& dst, int cameranum,
                   TypeDesc::BASETYPE convert = TypeDesc::UNKNOWN)
@@ -2376,7 +2446,8 @@ declare_imagebufalgo(py::module& m)
         .def_readonly("infcount", &ImageBufAlgo::PixelStats::infcount)
         .def_readonly("finitecount", &ImageBufAlgo::PixelStats::finitecount)
         .def_readonly("sum", &ImageBufAlgo::PixelStats::sum)
-        .def_readonly("sum2", &ImageBufAlgo::PixelStats::sum2);
+        .def_readonly("sum2", &ImageBufAlgo::PixelStats::sum2)
+        .def("merge", &ImageBufAlgo::PixelStats::merge);
 
     py::class_<ImageBufAlgo::CompareResults>(m, "CompareResults")
         .def(py::init<>())
@@ -2848,6 +2919,10 @@ declare_imagebufalgo(py::module& m)
                     "extrainfo"_a = "", "roi"_a = ROI::All(), "blocksize"_a = 0,
                     "nthreads"_a = 0)
 
+        .def_static("computePixelHash", &IBA_computePixelHash, "src"_a,
+                    "hashtype"_a = "xxhash", "extrainfo"_a = "",
+                    "roi"_a = ROI::All(), "nthreads"_a = 0)
+
         .def_static("warp", &IBA_warp, "dst"_a, "src"_a, "M"_a,
                     "filtername"_a = "", "filterwidth"_a = 0.0f,
                     "recompute_roi"_a = false, "wrap"_a = "default",
@@ -2937,6 +3012,12 @@ declare_imagebufalgo(py::module& m)
         .def_static("median_filter", &IBA_median_filter_ret, "src"_a,
                     "width"_a = 3, "height"_a = -1, "roi"_a = ROI::All(),
                     "nthreads"_a = 0)
+        .def_static("rank_filter", &IBA_rank_filter, "dst"_a, "src"_a,
+                    "rank"_a, "width"_a = 3, "height"_a = -1,
+                    "roi"_a = ROI::All(), "nthreads"_a = 0)
+        .def_static("rank_filter", &IBA_rank_filter_ret, "src"_a, "rank"_a,
+                    "width"_a = 3, "height"_a = -1, "roi"_a = ROI::All(),
+                    "nthreads"_a = 0)
 
         .def_static("dilate", &IBA_dilate, "dst"_a, "src"_a, "width"_a = 3,
                     "height"_a = -1, "roi"_a = ROI::All(), "nthreads"_a = 0)
@@ -3001,6 +3082,10 @@ declare_imagebufalgo(py::module& m)
                     "roi"_a = ROI::All(), "nthreads"_a = 0)
         .def_static("over", &IBA_over_ret, "A"_a, "B"_a, "roi"_a = ROI::All(),
                     "nthreads"_a = 0)
+        .def_static("over", &IBA_over_layers, "dst"_a, "layers"_a,
+                    "roi"_a = ROI::All(), "nthreads"_a = 0)
+        .def_static("over", &IBA_over_layers_ret, "layers"_a,
+                    "roi"_a = ROI::All(), "nthreads"_a = 0)
 
         .def_static("zover", &IBA_zover, "dst"_a, "A"_a, "B"_a,
                     "z_zeroisinf"_a = false, "roi"_a = ROI::All(),
@@ -3032,6 +3117,9 @@ declare_imagebufalgo(py::module& m)
                     "bins"_a = 256, "min"_a = 0.0f, "max"_a = 1.0f,
                     "ignore_empty"_a = false, "roi"_a = ROI::All(),
                     "nthreads"_a = 0)
+        .def_static("histograms", &IBA_histograms, "src"_a, "bins"_a = 256,
+                    "min"_a = 0.0f, "max"_a = 1.0f, "ignore_empty"_a = false,
+                    "roi"_a = ROI::All(), "nthreads"_a = 0)
 
         .def_static("make_texture", &IBA_make_texture_filename, "mode"_a,
                     "filename"_a, "outputfilename"_a, "config"_a = ImageSpec())
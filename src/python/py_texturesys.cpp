@@ -4,6 +4,10 @@
 
 #include "py_oiio.h"
 
+#include <algorithm>
+
+#include <OpenImageIO/parallel.h>
+
 namespace PyOpenImageIO {
 
 
@@ -65,6 +69,87 @@ public:
 
 
 
+using FloatArray
+    = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+
+// Batched 2D texture lookups at the points given by 1D arrays s and t and
+// their derivatives (None meaning all zero), returning an (N, nchannels)
+// float array. With the GIL released, the points are split across the
+// thread pool and looked up Tex::BatchWidth at a time with the SIMD batch
+// API, all sharing one Sampler made from options.
+static py::object
+TextureSystem_texture_batch(const TextureSystemWrap& ts,
+                            const std::string& filename,
+                            TextureOptWrap& options, const py::object& s,
+                            const py::object& t, const py::object& dsdx,
+                            const py::object& dtdx, const py::object& dsdy,
+                            const py::object& dtdy, int nchannels)
+{
+    if (!ts.m_texsys || nchannels < 1)
+        return py::none();
+    const py::object* args[6] = { &s, &t, &dsdx, &dtdx, &dsdy, &dtdy };
+    FloatArray arrays[6];
+    const float* data[6] = {};
+    size_t n             = 0;
+    for (int a = 0; a < 6; ++a) {
+        if (args[a]->is_none()) {
+            if (a < 2)
+                throw py::type_error("texture_batch: s and t are required");
+            continue;
+        }
+        arrays[a] = FloatArray::ensure(*args[a]);
+        if (!arrays[a] || arrays[a].ndim() != 1)
+            throw py::type_error(
+                "texture_batch: coordinates must be 1D float arrays");
+        if (a == 0)
+            n = size_t(arrays[a].size());
+        else if (size_t(arrays[a].size()) != n)
+            throw py::value_error(
+                "texture_batch: coordinate arrays must be the same length");
+        data[a] = arrays[a].data();
+    }
+
+    FloatArray result({ py::ssize_t(n), py::ssize_t(nchannels) });
+    float* out = result.mutable_data();
+    {
+        py::gil_scoped_release gil;
+        ustring name(filename);
+        TextureSystem* texsys           = ts.m_texsys.get();
+        TextureSystem::Sampler* sampler = texsys->create_sampler(options);
+        parallel_for_chunked(
+            0, int64_t(n), 64 * Tex::BatchWidth, [&](int64_t b, int64_t e) {
+                auto perthread = texsys->get_perthread_info();
+                auto handle    = texsys->get_texture_handle(name, perthread);
+                alignas(Tex::BatchAlign) float lanes[6][Tex::BatchWidth];
+                std::vector<float> soa(size_t(nchannels) * Tex::BatchWidth);
+                for (int64_t i = b; i < e; i += Tex::BatchWidth) {
+                    int nlanes = int(std::min(int64_t(Tex::BatchWidth), e - i));
+                    for (int a = 0; a < 6; ++a)
+                        for (int l = 0; l < Tex::BatchWidth; ++l)
+                            lanes[a][l] = data[a] && l < nlanes ? data[a][i + l]
+                                                                : 0.0f;
+                    Tex::RunMask mask = Tex::RunMaskOn
+                                        >> (Tex::BatchWidth - nlanes);
+                    texsys->texture(handle, perthread, sampler, mask,
+                                    lanes[0], lanes[1], lanes[2], lanes[3],
+                                    lanes[4], lanes[5], nchannels,
+                                    soa.data());
+                    // The batch results are [channel][lane]; the array
+                    // wants [point][channel].
+                    for (int l = 0; l < nlanes; ++l)
+                        for (int c = 0; c < nchannels; ++c)
+                            out[(i + l) * nchannels + c]
+                                = soa[c * Tex::BatchWidth + l];
+                }
+            });
+        texsys->destroy_sampler(sampler);
+    }
+    return std::move(result);
+}
+
+
+
 void
 declare_wrap(py::module& m)
 {
@@ -239,6 +324,9 @@ declare_texturesystem(py::module& m)
             },
             "filename"_a, "options"_a, "s"_a, "t"_a, "dsdx"_a, "dtdx"_a,
             "dsdy"_a, "dtdy"_a, "nchannels"_a)
+        .def("texture_batch", &TextureSystem_texture_batch, "filename"_a,
+             "options"_a, "s"_a, "t"_a, "dsdx"_a, "dtdx"_a, "dsdy"_a,
+             "dtdy"_a, "nchannels"_a)
 
 
         .def(
@@ -9,7 +9,9 @@
 
 #include <OpenImageIO/half.h>
 
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/fmath.h>
+#include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/platform.h>
 #include <OpenImageIO/strutil.h>
@@ -61,7 +63,7 @@ public:
     const char* format_name(void) const override { return "raw"; }
     int supports(string_view feature) const override
     {
-        return (feature == "exif"
+        return (feature == "exif" || feature == "thumbnail"
                 /* not yet? || feature == "iptc"*/);
     }
     bool open(const std::string& name, ImageSpec& newspec) override;
@@ -70,6 +72,7 @@ public:
     bool close() override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool get_thumbnail(ImageBuf& thumb, int subimage) override;
 
 private:
     bool process();
@@ -85,9 +88,15 @@ private:
     std::string m_filename;
     ImageSpec m_config;  // save config requests
     std::string m_make;
+    int m_original_orientation = 1;  // Exif orientation before LibRaw's flip
+    ImageBuf m_preview;              // Embedded preview, if "raw:preview"
 
     bool do_unpack();
 
+    // Extract the camera's embedded preview (JPEG or bitmap) into `preview`
+    // without unpacking or processing the raw data.
+    bool read_preview(ImageBuf& preview);
+
     // Do the actual open. It expects m_filename and m_config to be set.
     bool open_raw(bool unpack, const std::string& name,
                   const ImageSpec& config);
@@ -370,6 +379,23 @@ RawInput::open(const std::string& name, ImageSpec& newspec,
     // will need to close and re-open with unpack=true if and when we need
     // the actual pixel values.
     bool ok = open_raw(false, m_filename, m_config);
+    if (ok && m_config.get_int_attribute("raw:preview")) {
+        // Present the embedded preview in place of the raw image, keeping
+        // the metadata we gathered about the shot.
+        if (!read_preview(m_preview)) {
+            if (!has_error())
+                errorfmt("\"{}\" has no embedded preview", m_filename);
+            close();
+            return false;
+        }
+        const ImageSpec& pspec(m_preview.spec());
+        m_spec.copy_dimensions(pspec);
+        m_spec.channelnames = pspec.channelnames;
+        m_spec.attribute("oiio:ColorSpace", "sRGB");
+        m_spec.attribute("Orientation",
+                         pspec.get_int_attribute("Orientation", 1));
+        m_spec.attribute("raw:preview", 1);
+    }
     if (ok)
         newspec = m_spec;
     return ok;
@@ -436,6 +462,7 @@ RawInput::open_raw(bool unpack, const std::string& name,
     case 6: original_flip = 6; break;
     default: break;
     }
+    m_original_orientation = original_flip;
     m_processor->adjust_sizes_info_only();
 
     // Process image at half size if "raw:half_size" is not 0
@@ -900,7 +927,8 @@ RawInput::open_raw(bool unpack, const std::string& name,
         m_spec.attribute("Orientation", original_flip);
     }
 
-    // FIXME -- thumbnail possibly in m_processor->imgdata.thumbnail
+    // The embedded preview in m_processor->imgdata.thumbnail is only read
+    // on demand, by get_thumbnail() or the "raw:preview" hint.
 
     get_lensinfo();
     get_shootinginfo();
@@ -1331,6 +1359,7 @@ RawInput::close()
         m_image = nullptr;
     }
     m_processor.reset();
+    m_preview.clear();
     m_unpacked = false;
     m_process  = true;
     return true;
@@ -1338,6 +1367,68 @@ RawInput::close()
 
 
 
+bool
+RawInput::read_preview(ImageBuf& preview)
+{
+    if (!m_processor)
+        return false;
+    if (m_processor->unpack_thumb() != LIBRAW_SUCCESS)
+        return false;  // No preview, or one that LibRaw can't extract
+    int ret                       = LIBRAW_SUCCESS;
+    libraw_processed_image_t* mem = m_processor->dcraw_make_mem_thumb(&ret);
+    if (!mem)
+        return false;
+
+    bool ok = false;
+    if (mem->type == LIBRAW_IMAGE_JPEG) {
+        // Most cameras embed a full size or nearly full size JPEG. Decode
+        // it straight from memory.
+        Filesystem::IOMemReader blob(mem->data, mem->data_size);
+        auto in = ImageInput::open("preview.jpg", nullptr, &blob);
+        if (in) {
+            preview.reset(in->spec(0), InitializePixels::No);
+            ok = in->read_image(0, 0, 0, preview.nchannels(),
+                                preview.spec().format, preview.localpixels());
+        }
+    } else if (mem->type == LIBRAW_IMAGE_BITMAP
+               && (mem->colors == 1 || mem->colors == 3)
+               && (mem->bits == 8 || mem->bits == 16)) {
+        ImageSpec spec(mem->width, mem->height, mem->colors,
+                       mem->bits == 16 ? TypeUInt16 : TypeUInt8);
+        preview.reset(spec, InitializePixels::No);
+        if (spec.image_bytes() <= mem->data_size) {
+            memcpy(preview.localpixels(), mem->data, spec.image_bytes());
+            ok = true;
+        }
+    }
+    LibRaw::dcraw_clear_mem(mem);
+    if (!ok) {
+        preview.clear();
+        return false;
+    }
+    // The preview is stored unrotated; say how it should be shown.
+    preview.specmod().attribute("Orientation", m_original_orientation);
+    preview.specmod().attribute("oiio:ColorSpace", "sRGB");
+    return true;
+}
+
+
+
+bool
+RawInput::get_thumbnail(ImageBuf& thumb, int subimage)
+{
+    lock_guard lock(*this);
+    if (subimage != 0)
+        return false;
+    if (m_preview.initialized()) {
+        thumb = m_preview;
+        return true;
+    }
+    return read_preview(thumb);
+}
+
+
+
 bool
 RawInput::do_unpack()
 {
@@ -1395,6 +1486,11 @@ RawInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
     if (y < 0 || y >= m_spec.height)  // out of range scanline
         return false;
 
+    if (m_preview.initialized()) {
+        memcpy(data, m_preview.pixeladdr(0, y), m_spec.scanline_bytes(true));
+        return true;
+    }
+
     if (!m_unpacked)
         do_unpack();
 
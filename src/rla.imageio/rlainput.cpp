@@ -11,6 +11,7 @@
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
 
 #include "rla_pvt.h"
 
@@ -40,6 +41,8 @@ public:
     bool close() override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin,
+                               int yend, int z, void* data) override;
 
 private:
     std::string m_filename;            ///< Stash the filename
@@ -47,6 +50,7 @@ private:
     std::vector<unsigned char> m_buf;  ///< Buffer the image pixels
     int m_subimage;                    ///< Current subimage index
     std::vector<uint32_t> m_sot;       ///< Scanline offsets table
+    std::vector<uint32_t> m_sot_sorted;  ///< Sorted, to find record ends
     int m_stride;                      ///< Number of bytes a contig pixel takes
 
     /// Reset everything to initial state
@@ -78,17 +82,33 @@ private:
     ///
     inline bool read_header();
 
-    /// Helper: read and decode a single channel group consisting of
-    /// channels [first_channel .. first_channel+num_channels-1], which
-    /// all share the same number of significant bits.
+    /// Helper: the file offset just past the RLE records of (file order)
+    /// scanline y, which is wherever the next scanline's records (or the
+    /// next subimage, or the file) begin.
+    size_t scanline_end(int y);
+
+    /// Helper: decode all channels of (file order) scanline y, whose
+    /// records are in memory at [in, inend), into buf. It doesn't touch
+    /// the file or the error state, so it may run on several threads at
+    /// once; any error message is returned in err.
+    bool decode_scanline(int y, const char* in, const char* inend,
+                         unsigned char* buf, std::string& err) const;
+
+    /// Helper: decode a single channel group consisting of channels
+    /// [first_channel .. first_channel+num_channels-1], which all share
+    /// the same number of significant bits, advancing `in` past its
+    /// records.
     bool decode_channel_group(int first_channel, short num_channels,
-                              short num_bits, int y);
+                              short num_bits, int y, const char*& in,
+                              const char* inend, unsigned char* buf,
+                              std::string& err) const;
 
     /// Helper: decode a span of n RLE-encoded bytes from encoded[0..elen-1]
     /// into buf[0],buf[stride],buf[2*stride]...buf[(n-1)*stride].
-    /// Return the number of encoded bytes we ate to fill buf.
+    /// Return the number of encoded bytes we ate to fill buf, or 0 if the
+    /// record was malformed.
     size_t decode_rle_span(unsigned char* buf, int n, int stride,
-                           const char* encoded, size_t elen);
+                           const char* encoded, size_t elen) const;
 
     /// Helper: determine channel TypeDesc
     inline TypeDesc get_channel_typedesc(short chan_type, short chan_bits);
@@ -208,6 +228,8 @@ RLAInput::read_header()
         errorfmt("RLA could not read the scanline offset table");
         return false;
     }
+    m_sot_sorted = m_sot;
+    std::sort(m_sot_sorted.begin(), m_sot_sorted.end());
     return true;
 }
 
@@ -480,7 +502,7 @@ RLAInput::close()
 
 size_t
 RLAInput::decode_rle_span(unsigned char* buf, int n, int stride,
-                          const char* encoded, size_t elen)
+                          const char* encoded, size_t elen) const
 {
     size_t e = 0;
     while (n > 0 && e < elen) {
@@ -498,18 +520,16 @@ RLAInput::decode_rle_span(unsigned char* buf, int n, int stride,
                 *buf = encoded[e++];
         }
     }
-    if (n != 0) {
-        errorfmt("Read error: malformed RLE record");
-        return 0;
-    }
-    return e;
+    return n == 0 ? e : 0;
 }
 
 
 
 bool
 RLAInput::decode_channel_group(int first_channel, short num_channels,
-                               short num_bits, int y)
+                               short num_bits, int y, const char*& in,
+                               const char* inend, unsigned char* buf,
+                               std::string& err) const
 {
     // Some preliminaries -- figure out various sizes and offsets
     int chsize;         // size of the channels in this group, in bytes
@@ -532,38 +552,39 @@ RLAInput::decode_channel_group(int first_channel, short num_channels,
             offset += m_spec.channelformats[i].size();
     }
 
-    // Read the big-endian values into the buffer.
+    // Decode the big-endian values into the buffer.
     // The channels are simply concatenated together in order.
     // Each channel starts with a length, from which we know how many
-    // bytes of encoded RLE data to read.  Then there are RLE
+    // bytes of encoded RLE data follow.  Then there are RLE
     // spans for each 8-bit slice of the channel.
-    std::vector<char> encoded;
     for (int c = 0; c < num_channels; ++c) {
-        // Read the length
-        uint16_t lenu16;  // number of encoded bytes
-        if (!read(&lenu16)) {
-            errorfmt("Read error: couldn't read RLE record length");
+        // Read the big-endian length
+        if (inend - in < 2) {
+            err = "Read error: couldn't read RLE record length";
             return false;
         }
-        size_t length = lenu16;
-        // Read the encoded RLE record
-        encoded.resize(length);
-        if (!length || !read(&encoded[0], length)) {
-            errorfmt("Read error: couldn't read RLE data span");
+        size_t length = (size_t((unsigned char)in[0]) << 8)
+                        | size_t((unsigned char)in[1]);
+        in += 2;
+        // The encoded RLE record
+        if (!length || size_t(inend - in) < length) {
+            err = "Read error: couldn't read RLE data span";
             return false;
         }
+        const char* encoded = in;
+        in += length;
 
         if (chantype == TypeDesc::FLOAT) {
             // Special case -- float data is just dumped raw, no RLE
             if (length != size_t(m_spec.width * chsize)) {
-                errorfmt(
+                err = Strutil::fmt::format(
                     "Read error: not enough data in scanline {}, channel {}", y,
                     c);
                 return false;
             }
             for (int x = 0; x < m_spec.width; ++x)
-                *((float*)&m_buf[offset + c * chsize + x * pixelsize])
-                    = ((float*)&encoded[0])[x];
+                memcpy(&buf[offset + c * chsize + x * pixelsize],
+                       encoded + x * sizeof(float), sizeof(float));
             continue;
         }
 
@@ -572,11 +593,13 @@ RLAInput::decode_channel_group(int first_channel, short num_channels,
         // and strides to decode_rle_span.
         size_t eoffset = 0;
         for (int bytes = 0; bytes < chsize && length > 0; ++bytes) {
-            size_t e = decode_rle_span(&m_buf[offset + c * chsize + bytes],
+            size_t e = decode_rle_span(&buf[offset + c * chsize + bytes],
                                        m_spec.width, pixelsize,
-                                       &encoded[eoffset], length);
-            if (!e)
+                                       encoded + eoffset, length);
+            if (!e) {
+                err = "Read error: malformed RLE record";
                 return false;
+            }
             eoffset += e;
             length -= e;
         }
@@ -587,17 +610,17 @@ RLAInput::decode_channel_group(int first_channel, short num_channels,
     if (littleendian()) {
         if (chsize == 2) {
             if (num_channels == m_spec.nchannels)
-                swap_endian((uint16_t*)&m_buf[0], num_channels * m_spec.width);
+                swap_endian((uint16_t*)&buf[0], num_channels * m_spec.width);
             else
                 for (int x = 0; x < m_spec.width; ++x)
-                    swap_endian((uint16_t*)&m_buf[offset + x * pixelsize],
+                    swap_endian((uint16_t*)&buf[offset + x * pixelsize],
                                 num_channels);
         } else if (chsize == 4 && chantype != TypeDesc::FLOAT) {
             if (num_channels == m_spec.nchannels)
-                swap_endian((uint32_t*)&m_buf[0], num_channels * m_spec.width);
+                swap_endian((uint32_t*)&buf[0], num_channels * m_spec.width);
             else
                 for (int x = 0; x < m_spec.width; ++x)
-                    swap_endian((uint32_t*)&m_buf[offset + x * pixelsize],
+                    swap_endian((uint32_t*)&buf[offset + x * pixelsize],
                                 num_channels);
         }
     }
@@ -611,28 +634,28 @@ RLAInput::decode_channel_group(int first_channel, short num_channels,
     } else if (num_bits == 10) {
         // fast, common case -- use templated hard-code
         for (int x = 0; x < m_spec.width; ++x) {
-            uint16_t* b = (uint16_t*)(&m_buf[offset + x * pixelsize]);
+            uint16_t* b = (uint16_t*)(&buf[offset + x * pixelsize]);
             for (int c = 0; c < num_channels; ++c)
                 b[c] = bit_range_convert<10, 16>(b[c]);
         }
     } else if (num_bits < 8) {
         // rare case, use slow code to make this clause short and simple
         for (int x = 0; x < m_spec.width; ++x) {
-            uint8_t* b = (uint8_t*)&m_buf[offset + x * pixelsize];
+            uint8_t* b = (uint8_t*)&buf[offset + x * pixelsize];
             for (int c = 0; c < num_channels; ++c)
                 b[c] = bit_range_convert(b[c], num_bits, 8);
         }
     } else if (num_bits > 8 && num_bits < 16) {
         // rare case, use slow code to make this clause short and simple
         for (int x = 0; x < m_spec.width; ++x) {
-            uint16_t* b = (uint16_t*)&m_buf[offset + x * pixelsize];
+            uint16_t* b = (uint16_t*)&buf[offset + x * pixelsize];
             for (int c = 0; c < num_channels; ++c)
                 b[c] = bit_range_convert(b[c], num_bits, 16);
         }
     } else if (num_bits > 16 && num_bits < 32) {
         // rare case, use slow code to make this clause short and simple
         for (int x = 0; x < m_spec.width; ++x) {
-            uint32_t* b = (uint32_t*)&m_buf[offset + x * pixelsize];
+            uint32_t* b = (uint32_t*)&buf[offset + x * pixelsize];
             for (int c = 0; c < num_channels; ++c)
                 b[c] = bit_range_convert(b[c], num_bits, 32);
         }
@@ -642,20 +665,25 @@ RLAInput::decode_channel_group(int first_channel, short num_channels,
 
 
 
-bool
-RLAInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
-                               void* data)
+size_t
+RLAInput::scanline_end(int y)
 {
-    lock_guard lock(*this);
-    if (!seek_subimage(subimage, miplevel))
-        return false;
+    uint32_t start = m_sot[y];
+    auto next = std::upper_bound(m_sot_sorted.begin(), m_sot_sorted.end(),
+                                 start);
+    if (next != m_sot_sorted.end())
+        return *next;
+    if (m_rla.NextOffset > 0 && uint32_t(m_rla.NextOffset) > start)
+        return m_rla.NextOffset;
+    return ioproxy()->size();
+}
 
-    // By convention, RLA images store their images bottom-to-top.
-    y = m_spec.height - (y - m_spec.y) - 1;
 
-    // Seek to scanline start, based on the scanline offset table
-    ioseek(m_sot[y]);
 
+bool
+RLAInput::decode_scanline(int y, const char* in, const char* inend,
+                          unsigned char* buf, std::string& err) const
+{
     // Now decode and interleave the channels.
     // The channels are non-interleaved (i.e. rrrrrgggggbbbbb...).
     // Color first, then matte, then auxiliary channels.  We can't
@@ -663,30 +691,143 @@ RLAInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
     // of significant bits may be may be different for each class of
     // channels, so we deal with them separately and interleave into
     // our buffer as we go.
-    size_t size = m_spec.scanline_bytes(true);
-    m_buf.resize(size);
     if (m_rla.NumOfColorChannels > 0)
         if (!decode_channel_group(0, m_rla.NumOfColorChannels,
-                                  m_rla.NumOfChannelBits, y))
+                                  m_rla.NumOfChannelBits, y, in, inend, buf,
+                                  err))
             return false;
     if (m_rla.NumOfMatteChannels > 0)
         if (!decode_channel_group(m_rla.NumOfColorChannels,
                                   m_rla.NumOfMatteChannels,
-                                  m_rla.NumOfMatteBits, y))
+                                  m_rla.NumOfMatteBits, y, in, inend, buf,
+                                  err))
             return false;
     if (m_rla.NumOfAuxChannels > 0)
         if (!decode_channel_group(m_rla.NumOfColorChannels
                                       + m_rla.NumOfMatteChannels,
                                   m_rla.NumOfAuxChannels, m_rla.NumOfAuxBits,
-                                  y))
+                                  y, in, inend, buf, err))
             return false;
+    return true;
+}
+
+
+
+bool
+RLAInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
+                               void* data)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel))
+        return false;
+
+    // By convention, RLA images store their images bottom-to-top.
+    y = m_spec.height - (y - m_spec.y) - 1;
+
+    // Read the scanline's records, based on the scanline offset table
+    size_t begin = m_sot[y], end = scanline_end(y);
+    if (end <= begin) {
+        errorfmt("Read error: bad scanline offset for scanline {}", y);
+        return false;
+    }
+    std::vector<char> records(end - begin);
+    if (!ioseek(begin) || !ioread(records.data(), records.size()))
+        return false;
 
+    size_t size = m_spec.scanline_bytes(true);
+    m_buf.resize(size);
+    std::string err;
+    if (!decode_scanline(y, records.data(), records.data() + records.size(),
+                         m_buf.data(), err)) {
+        errorfmt("{}", err);
+        return false;
+    }
     memcpy(data, &m_buf[0], size);
     return true;
 }
 
 
 
+bool
+RLAInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                int yend, int z, void* data)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel))
+        return false;
+    yend = std::min(yend, m_spec.y + m_spec.height);
+    if (ybegin < m_spec.y || yend - ybegin < 2)
+        return ImageInput::read_native_scanlines(subimage, miplevel, ybegin,
+                                                 yend, z, data);
+
+    // Each scanline's records can be decoded independently. Fetch the
+    // records for all these scanlines with a single read when they are
+    // together in the file (as they nearly always are), then decode the
+    // scanlines in parallel.
+    int nrows = yend - ybegin;
+    std::vector<int> filey(nrows);
+    std::vector<size_t> ends(nrows);
+    size_t lo = std::numeric_limits<size_t>::max(), hi = 0, total = 0;
+    for (int r = 0; r < nrows; ++r) {
+        // By convention, RLA images store their images bottom-to-top.
+        int y    = m_spec.height - (ybegin + r - m_spec.y) - 1;
+        filey[r] = y;
+        ends[r]  = scanline_end(y);
+        if (ends[r] <= m_sot[y]) {
+            errorfmt("Read error: bad scanline offset for scanline {}", y);
+            return false;
+        }
+        lo = std::min(lo, size_t(m_sot[y]));
+        hi = std::max(hi, ends[r]);
+        total += ends[r] - m_sot[y];
+    }
+    std::vector<char> records;
+    std::vector<const char*> starts(nrows);
+    if (hi - lo <= 2 * total + 65536) {
+        records.resize(hi - lo);
+        if (!ioseek(lo) || !ioread(records.data(), records.size()))
+            return false;
+        for (int r = 0; r < nrows; ++r)
+            starts[r] = records.data() + (m_sot[filey[r]] - lo);
+    } else {
+        records.resize(total);
+        size_t pos = 0;
+        for (int r = 0; r < nrows; ++r) {
+            size_t len = ends[r] - m_sot[filey[r]];
+            if (!ioseek(m_sot[filey[r]]) || !ioread(&records[pos], len))
+                return false;
+            starts[r] = &records[pos];
+            pos += len;
+        }
+    }
+
+    size_t scanline_bytes = m_spec.scanline_bytes(true);
+    std::mutex err_mutex;
+    std::string first_err;
+    parallel_for(
+        0, nrows,
+        [&](int64_t r) {
+            std::string err;
+            const char* in = starts[r];
+            if (!decode_scanline(filey[r], in,
+                                 in + (ends[r] - m_sot[filey[r]]),
+                                 (unsigned char*)data + r * scanline_bytes,
+                                 err)) {
+                std::lock_guard<std::mutex> lock(err_mutex);
+                if (first_err.empty())
+                    first_err = err;
+            }
+        },
+        paropt(threads()));
+    if (first_err.size()) {
+        errorfmt("{}", first_err);
+        return false;
+    }
+    return true;
+}
+
+
+
 inline int
 RLAInput::get_month_number(string_view s)
 {
@@ -4,6 +4,7 @@
 
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/fmath.h>
+#include <OpenImageIO/parallel.h>
 
 #include "sgi_pvt.h"
 
@@ -25,6 +26,8 @@ public:
     bool close(void) override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin,
+                               int yend, int z, void* data) override;
 
 private:
     std::string m_filename;
@@ -53,6 +56,18 @@ private:
     // Return true if ok, false if there was a read error.
     bool uncompress_rle_channel(int scanline_off, int scanline_len,
                                 unsigned char* out);
+
+    // Uncompress one channel scanline of RLE data already in memory into
+    // 'out'. Doesn't touch the file or the error state, so it is safe to
+    // call from several threads at once. Return false if the data is
+    // corrupt.
+    bool uncompress_rle(const unsigned char* rle_scanline, int scanline_len,
+                        unsigned char* out) const;
+
+    // Interleave one scanline's separate channels into 'data', fixing
+    // the byte order.
+    void interleave(const unsigned char* const* channeldata,
+                    void* data) const;
 };
 
 
@@ -212,9 +227,23 @@ SgiInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
         }
     }
 
+    std::vector<const unsigned char*> chans(m_spec.nchannels);
+    for (int c = 0; c < m_spec.nchannels; ++c)
+        chans[c] = channeldata[c].data();
+    interleave(chans.data(), data);
+    return true;
+}
+
+
+
+void
+SgiInput::interleave(const unsigned char* const* channeldata,
+                     void* data) const
+{
+    ptrdiff_t bpc = m_sgi_header.bpc;
     if (m_spec.nchannels == 1) {
         // If just one channel, no interleaving is necessary, just memcpy
-        memcpy(data, &(channeldata[0][0]), channeldata[0].size());
+        memcpy(data, channeldata[0], m_spec.width * bpc);
     } else {
         unsigned char* cdata = (unsigned char*)data;
         for (int x = 0; x < m_spec.width; ++x) {
@@ -229,7 +258,89 @@ SgiInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
     // Swap endianness if needed
     if (bpc == 2 && littleendian())
         swap_endian((unsigned short*)data, m_spec.width * m_spec.nchannels);
+}
+
+
+
+bool
+SgiInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                int yend, int z, void* data)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel))
+        return false;
+    yend = std::min(yend, m_spec.height);
+    if (m_sgi_header.storage != sgi_pvt::RLE || ybegin < 0
+        || yend - ybegin < 2)
+        return ImageInput::read_native_scanlines(subimage, miplevel, ybegin,
+                                                 yend, z, data);
+
+    // Every channel scanline is an independent run of RLE bytes. Gather
+    // each channel's runs for these rows with a single read (they are
+    // nearly always contiguous), then decompress all the rows in parallel.
+    int nrows  = yend - ybegin;
+    int nchans = m_spec.nchannels;
+    std::vector<std::vector<unsigned char>> rle(nchans);
+    std::vector<const unsigned char*> runs(size_t(nrows) * nchans);
+    for (int c = 0; c < nchans; ++c) {
+        size_t lo = std::numeric_limits<size_t>::max(), hi = 0, total = 0;
+        for (int y = ybegin; y < yend; ++y) {
+            size_t off = (m_spec.height - 1 - y) + size_t(c) * m_spec.height;
+            lo         = std::min(lo, size_t(start_tab[off]));
+            hi         = std::max(hi, size_t(start_tab[off]) + length_tab[off]);
+            total += length_tab[off];
+        }
+        if (hi - lo <= 2 * total + 65536) {
+            rle[c].resize(hi - lo);
+            if (!ioseek(lo) || !ioread(rle[c].data(), hi - lo))
+                return false;
+            for (int y = ybegin; y < yend; ++y) {
+                size_t off = (m_spec.height - 1 - y)
+                             + size_t(c) * m_spec.height;
+                runs[size_t(y - ybegin) * nchans + c] = rle[c].data()
+                                                        + start_tab[off] - lo;
+            }
+        } else {
+            // Scattered runs: read them one by one, packed together.
+            rle[c].resize(total);
+            size_t pos = 0;
+            for (int y = ybegin; y < yend; ++y) {
+                size_t off = (m_spec.height - 1 - y)
+                             + size_t(c) * m_spec.height;
+                if (!ioseek(start_tab[off])
+                    || !ioread(rle[c].data() + pos, length_tab[off]))
+                    return false;
+                runs[size_t(y - ybegin) * nchans + c] = rle[c].data() + pos;
+                pos += length_tab[off];
+            }
+        }
+    }
 
+    std::atomic<bool> corrupt(false);
+    size_t scanline_bytes = m_spec.scanline_bytes(true);
+    size_t chanline_bytes = size_t(m_spec.width) * m_sgi_header.bpc;
+    parallel_for(
+        0, nrows,
+        [&](int64_t r) {
+            std::unique_ptr<unsigned char[]> buf(
+                new unsigned char[chanline_bytes * nchans]);
+            std::vector<const unsigned char*> chans(nchans);
+            for (int c = 0; c < nchans; ++c) {
+                size_t off = (m_spec.height - 1 - (ybegin + r))
+                             + size_t(c) * m_spec.height;
+                unsigned char* out = buf.get() + c * chanline_bytes;
+                if (!uncompress_rle(runs[r * nchans + c], length_tab[off],
+                                    out))
+                    corrupt = true;
+                chans[c] = out;
+            }
+            interleave(chans.data(), (unsigned char*)data + r * scanline_bytes);
+        },
+        paropt(threads()));
+    // Like the one-scanline path, report corrupt data but still return the
+    // (partially) decoded pixels.
+    if (corrupt)
+        errorfmt("Corrupt RLE data");
     return true;
 }
 
@@ -245,6 +356,24 @@ SgiInput::uncompress_rle_channel(int scanline_off, int scanline_len,
     ioseek(scanline_off);
     if (!ioread(&rle_scanline[0], 1, scanline_len))
         return false;
+    if (bpc != 1 && bpc != 2) {
+        errorfmt("Unknown bytes per channel {}", bpc);
+        return false;
+    }
+    if (!uncompress_rle(rle_scanline.get(), scanline_len, out)) {
+        errorfmt("Corrupt RLE data");
+        return false;
+    }
+    return true;
+}
+
+
+
+bool
+SgiInput::uncompress_rle(const unsigned char* rle_scanline, int scanline_len,
+                         unsigned char* out) const
+{
+    int bpc   = m_sgi_header.bpc;
     int limit = m_spec.width;
     int i     = 0;
     if (bpc == 1) {
@@ -305,15 +434,9 @@ SgiInput::uncompress_rle_channel(int scanline_off, int scanline_len,
             }
         }
     } else {
-        errorfmt("Unknown bytes per channel {}", bpc);
         return false;
     }
-    if (i != scanline_len || limit != 0) {
-        errorfmt("Corrupt RLE data");
-        return false;
-    }
-
-    return true;
+    return i == scanline_len && limit == 0;
 }
 
 
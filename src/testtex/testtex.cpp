@@ -26,6 +26,8 @@
 #include <OpenImageIO/timer.h>
 #include <OpenImageIO/ustring.h>
 
+#include "texturecapture_pvt.h"
+
 using namespace OIIO;
 
 using OIIO::_1;
@@ -62,6 +64,7 @@ static bool batch         = false;
 static bool nowarp        = false;
 static bool tube          = false;
 static bool use_handle    = false;
+static bool use_sampler   = false;
 static bool use_bluenoise = false;
 static float cachesize    = -1;
 static int maxfiles       = -1;
@@ -94,6 +97,8 @@ static std::string subimagename;
 static Imath::M33f xform;
 static std::string texoptions;
 static std::string gtiname;
+static std::string capture_filename;
+static std::string replay_filename;
 static std::string maketest_template;
 static int maketest_res   = 2048;
 static int maketest_chans = 4;
@@ -192,6 +197,8 @@ getargs(int argc, const char* argv[])
       .help(Strutil::fmt::format("Use batched shading, batch size = {}", Tex::BatchWidth));
     ap.arg("--handle", &use_handle)
       .help("Use texture handle rather than name lookup");
+    ap.arg("--sampler", &use_sampler)
+      .help("Use a precomputed Sampler for the options (implies --handle)");
     ap.arg("--searchpath %s:PATHLIST", &searchpath)
       .help("Search path for files (colon-separated directory list)");
     ap.arg("--filtertest", &filtertest)
@@ -270,12 +277,17 @@ getargs(int argc, const char* argv[])
       .help("Use the specified subimage (by index)");
     ap.arg("--subimagename %s:NAME", &subimagename)
       .help("Use the specified subimage (by name)");
+    ap.arg("--capture %s:FILENAME", &capture_filename)
+      .help("Record every texture lookup in a file for --replay (or, with "
+            "--replay, one untimed pass of its lookups)");
+    ap.arg("--replay %s:FILENAME", &replay_filename)
+      .help("Time the lookups in a --capture file, with 1 and --threads threads");
 
     // clang-format on
     ap.parse(argc, argv);
 
     if (filenames.size() < 1 && !num_test_files && !test_construction
-        && !test_getimagespec && !testhash) {
+        && !test_getimagespec && !testhash && replay_filename.empty()) {
         std::cerr << "testtex: Must have at least one input file\n";
         ap.usage();
         exit(EXIT_FAILURE);
@@ -678,6 +690,11 @@ plain_tex_region(ImageBuf& image, ustring filename, Mapping2D mapping,
 
     TextureOpt opt;
     initialize_opt(opt);
+    // A Sampler fixes the options, so it can't be used if they vary per
+    // point.
+    TextureSystem::Sampler* sampler = nullptr;
+    if (use_sampler && widthramp == 0.0f && !stochastic)
+        sampler = texsys->create_sampler(opt);
 
     float* result    = OIIO_ALLOCA(float, std::max(3, nchannels));
     float* dresultds = test_derivs ? OIIO_ALLOCA(float, nchannels) : NULL;
@@ -706,7 +723,11 @@ plain_tex_region(ImageBuf& image, ustring filename, Mapping2D mapping,
 
         // Call the texture system to do the filtering.
         bool ok;
-        if (use_handle)
+        if (sampler)
+            ok = texsys->texture(texture_handle, perthread_info, sampler, s,
+                                 t, dsdx, dtdx, dsdy, dtdy, nchannels, result,
+                                 dresultds, dresultdt);
+        else if (use_handle)
             ok = texsys->texture(texture_handle, perthread_info, opt, s, t,
                                  dsdx, dtdx, dsdy, dtdy, nchannels, result,
                                  dresultds, dresultdt);
@@ -728,6 +749,7 @@ plain_tex_region(ImageBuf& image, ustring filename, Mapping2D mapping,
             image_dt->setpixel(p.x(), p.y(), dresultdt);
         }
     }
+    texsys->destroy_sampler(sampler);
 }
 
 
@@ -809,6 +831,12 @@ plain_tex_region_batch(ImageBuf& image, ustring filename, Mapping2DWide mapping,
 
     TextureOptBatch opt;
     initialize_opt(opt);
+    TextureSystem::Sampler* sampler = nullptr;
+    if (use_sampler && widthramp == 0.0f && !stochastic) {
+        TextureOpt sopt;
+        initialize_opt(sopt);
+        sampler = texsys->create_sampler(sopt);
+    }
 
     int nc               = std::max(3, nchannels);
     FloatWide* result    = OIIO_ALLOCA(FloatWide, nc);
@@ -847,7 +875,13 @@ plain_tex_region_batch(ImageBuf& image, ustring filename, Mapping2DWide mapping,
             RunMask mask = RunMaskOn >> (BatchWidth - npoints);
             // Call the texture system to do the filtering.
             bool ok;
-            if (use_handle)
+            if (sampler)
+                ok = texsys->texture(texture_handle, perthread_info, sampler,
+                                     mask, s.data(), t.data(), dsdx.data(),
+                                     dtdx.data(), dsdy.data(), dtdy.data(),
+                                     nchannels, (float*)result,
+                                     (float*)dresultds, (float*)dresultdt);
+            else if (use_handle)
                 ok = texsys->texture(texture_handle, perthread_info, opt, mask,
                                      s.data(), t.data(), dsdx.data(),
                                      dtdx.data(), dsdy.data(), dtdy.data(),
@@ -883,6 +917,7 @@ plain_tex_region_batch(ImageBuf& image, ustring filename, Mapping2DWide mapping,
             }
         }
     }
+    texsys->destroy_sampler(sampler);
 }
 
 
@@ -1563,6 +1598,164 @@ launch_tex_threads(int numthreads, int iterations)
 
 
 
+struct ReplayLookup {
+    TextureSystem::TextureHandle* handle;
+    TextureOpt opt;
+    int nchannels;
+    float s, t, dsdx, dtdx, dsdy, dtdy;
+};
+
+
+
+static bool
+read_capture(const std::string& filename, std::vector<ReplayLookup>& lookups)
+{
+    FILE* file = Filesystem::fopen(filename, "rb");
+    if (!file) {
+        Strutil::print(std::cerr, "testtex: could not open \"{}\"\n",
+                       filename);
+        return false;
+    }
+    char magic[8];
+    bool ok = fread(magic, 1, 8, file) == 8
+              && !memcmp(magic, pvt::texture_capture_magic, 8);
+    std::vector<ustring> strings;
+    std::vector<TextureSystem::TextureHandle*> handles;
+    int tag;
+    while (ok && (tag = fgetc(file)) != EOF) {
+        if (tag == 'S') {
+            uint32_t len = 0;
+            ok = fread(&len, sizeof(len), 1, file) == 1;
+            std::string str(len, ' ');
+            ok &= fread(&str[0], 1, len, file) == len;
+            strings.emplace_back(str);
+            handles.push_back(nullptr);
+        } else if (tag == 'T') {
+            pvt::TextureCaptureRecord rec;
+            ok = fread(&rec, sizeof(rec), 1, file) == 1
+                 && rec.filename < strings.size()
+                 && rec.subimagename < int32_t(strings.size());
+            if (!ok)
+                break;
+            if (!handles[rec.filename])
+                handles[rec.filename] = texsys->get_texture_handle(
+                    strings[rec.filename]);
+            ReplayLookup r;
+            r.handle       = handles[rec.filename];
+            r.opt.subimage = rec.subimage;
+            if (rec.subimagename >= 0)
+                r.opt.subimagename = strings[rec.subimagename];
+            r.opt.firstchannel        = rec.firstchannel;
+            r.opt.swrap               = (TextureOpt::Wrap)rec.swrap;
+            r.opt.twrap               = (TextureOpt::Wrap)rec.twrap;
+            r.opt.mipmode             = (TextureOpt::MipMode)rec.mipmode;
+            r.opt.interpmode          = (TextureOpt::InterpMode)rec.interpmode;
+            r.opt.anisotropic         = rec.anisotropic;
+            r.opt.conservative_filter = rec.conservative_filter;
+            r.opt.colortransformid    = rec.colortransformid;
+            r.opt.sblur               = rec.sblur;
+            r.opt.tblur               = rec.tblur;
+            r.opt.swidth              = rec.swidth;
+            r.opt.twidth              = rec.twidth;
+            r.opt.fill                = rec.fill;
+            r.opt.rnd                 = rec.rnd;
+            r.nchannels               = rec.nchannels;
+            r.s                       = rec.s;
+            r.t                       = rec.t;
+            r.dsdx                    = rec.dsdx;
+            r.dtdx                    = rec.dtdx;
+            r.dsdy                    = rec.dsdy;
+            r.dtdy                    = rec.dtdy;
+            lookups.push_back(r);
+        } else {
+            ok = false;
+        }
+    }
+    fclose(file);
+    if (!ok)
+        Strutil::print(std::cerr,
+                       "testtex: \"{}\" is not a valid capture file\n",
+                       filename);
+    return ok;
+}
+
+
+
+static void
+replay_thread(const std::vector<ReplayLookup>& lookups, size_t begin,
+              size_t end)
+{
+    TextureSystem::Perthread* thread_info = texsys->get_perthread_info();
+    float result[64];
+    for (int it = 0; it < iters; ++it) {
+        for (size_t i = begin; i < end; ++i) {
+            const ReplayLookup& r(lookups[i]);
+            TextureOpt opt(r.opt);
+            texsys->texture(r.handle, thread_info, opt, r.s, r.t, r.dsdx,
+                            r.dtdx, r.dsdy, r.dtdy, std::min(r.nchannels, 64),
+                            result);
+        }
+    }
+}
+
+
+
+// Each thread replays its own contiguous share of the lookups, iters
+// times over.
+void
+launch_replay_threads(const std::vector<ReplayLookup>& lookups,
+                      int numthreads)
+{
+    if (invalidate_before_iter)
+        texsys->invalidate_all(true);
+    size_t n = lookups.size();
+    OIIO::thread_group threads;
+    for (int i = 0; i < numthreads; ++i)
+        threads.create_thread(std::bind(replay_thread, std::cref(lookups),
+                                        n * i / numthreads,
+                                        n * (i + 1) / numthreads));
+    threads.join_all();
+}
+
+
+
+static bool
+test_replay(const std::string& filename)
+{
+    std::vector<ReplayLookup> lookups;
+    if (!read_capture(filename, lookups) || lookups.empty())
+        return false;
+    if (nthreads == 0)
+        nthreads = Sysutil::hardware_concurrency();
+    if (capture_filename.size()) {
+        // Replay once, in order, into the new capture, which should come
+        // out the same as the file we read. Don't capture the timings.
+        int saved_iters = iters;
+        iters           = 1;
+        replay_thread(lookups, 0, lookups.size());
+        iters = saved_iters;
+        texsys->attribute("capture", "");
+    }
+    Strutil::print("Replaying {} lookups from \"{}\", {} time(s) per trial\n",
+                   lookups.size(), filename, iters);
+    Strutil::print("times are best of {} trials\n\n", ntrials);
+    Strutil::print("threads  time (s)  Mlookups/s\n");
+    Strutil::print("-------- -------- -----------\n");
+    for (int nt : { 1, nthreads }) {
+        double t = time_trial(std::bind(launch_replay_threads,
+                                        std::cref(lookups), nt),
+                              ntrials);
+        Strutil::print("{:3}     {:8.3f}   {:8.2f}\n", nt, t,
+                       double(lookups.size()) * iters / t * 1.0e-6);
+        if (nthreads == 1)
+            break;
+    }
+    Strutil::print("\n{}\n", texsys->getstats(verbose ? 2 : 1));
+    return true;
+}
+
+
+
 class GridImageInput final : public ImageInput {
 public:
     GridImageInput()
@@ -1792,7 +1985,8 @@ main(int argc, const char* argv[])
 
     OIIO::attribute("threads", nthreads);
 
-    texsys = TextureSystem::create();
+    int retcode = EXIT_SUCCESS;
+    texsys      = TextureSystem::create();
     Strutil::sync::print("Created texture system\n");
     if (texoptions.size())
         texsys->attribute("options", texoptions);
@@ -1814,6 +2008,8 @@ main(int argc, const char* argv[])
     texsys->attribute("gray_to_rgb", gray_to_rgb);
     texsys->attribute("flip_t", flip_t);
     texsys->attribute("stochastic", stochastic);
+    if (capture_filename.size())
+        texsys->attribute("capture", capture_filename);
     texcolortransform_id
         = std::max(0, texsys->get_colortransform_id(ustring(texcolorspace),
                                                     ustring("scene_linear")));
@@ -1894,7 +2090,10 @@ main(int argc, const char* argv[])
         // Strutil::print("tex {} -> {:p}\n", f, (void*)texture_handles.back());
     }
 
-    if (threadtimes) {
+    if (replay_filename.size()) {
+        if (!test_replay(replay_filename))
+            retcode = EXIT_FAILURE;
+    } else if (threadtimes) {
         // If the --iters flag was used, do that number of iterations total
         // (divided among the threads). If not supplied (iters will be 1),
         // then use a large constant *per thread*.
@@ -2038,5 +2237,5 @@ main(int argc, const char* argv[])
         Filesystem::remove(f, err);
     }
     shutdown();
-    return 0;
+    return retcode;
 }
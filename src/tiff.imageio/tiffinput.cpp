@@ -136,6 +136,8 @@ public:
     bool read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
                            int ybegin, int yend, int zbegin, int zend,
                            void* data) override;
+    bool native_tile_location(int subimage, int miplevel, int x, int y, int z,
+                              int64_t& offset, int64_t& size) override;
     bool read_scanline(int y, int z, TypeDesc format, void* data,
                        stride_t xstride) override;
     bool read_scanlines(int subimage, int miplevel, int ybegin, int yend, int z,
@@ -150,6 +152,9 @@ public:
                     stride_t ystride, stride_t zstride) override;
 
 private:
+    friend TIFF* oiio_tiff_raw_input(ImageInput* in, int& compression,
+                                     int& predictor);
+
     TIFF* m_tif;                            ///< libtiff handle
     std::string m_filename;                 ///< Stash the filename
     std::vector<unsigned char> m_scratch;   ///< Scratch space for us to use
@@ -165,6 +170,7 @@ private:
     bool m_convert_alpha;            ///< Do we need to associate alpha?
     bool m_separate;                 ///< Separate planarconfig?
     bool m_testopenconfig;           ///< Debug aid to test open-with-config
+    string_view m_metadata;          ///< "oiio:metadata" hint (see tiffutils.h)
     bool m_use_rgba_interface;       ///< Sometimes we punt
     bool m_is_byte_swapped;          ///< Is the file opposite our endian?
     int m_rowsperstrip;              ///< For scanline imgs, rows per strip
@@ -190,6 +196,7 @@ private:
         m_separate                = false;
         m_inputchannels           = 0;
         m_testopenconfig          = false;
+        m_metadata                = "all";
         m_colormap.clear();
         m_use_rgba_interface = false;
         m_subimage_specs.clear();
@@ -556,6 +563,27 @@ oiio_tiff_set_error_handler()
 #endif
 
 
+
+// Used by TIFFOutput::copy_image: if `in` is a TIFF reader whose current
+// strips or tiles decode to exactly the pixels it hands the client, return
+// its libtiff handle (and the compression and predictor it was written
+// with), so that the compressed chunks can be passed through as-is.
+// Return nullptr for anything we'd transform on the way out (palette
+// expansion, alpha association, or the RGBA interface).
+TIFF*
+oiio_tiff_raw_input(ImageInput* in, int& compression, int& predictor)
+{
+    auto tiffin = dynamic_cast<TIFFInput*>(in);
+    if (!tiffin || !tiffin->m_tif || tiffin->m_use_rgba_interface
+        || tiffin->m_convert_alpha
+        || tiffin->m_photometric == PHOTOMETRIC_PALETTE)
+        return nullptr;
+    compression = tiffin->m_compression;
+    predictor   = tiffin->m_predictor;
+    return tiffin->m_tif;
+}
+
+
 static tsize_t
 reader_readproc(thandle_t handle, tdata_t data, tsize_t size)
 {
@@ -731,6 +759,7 @@ TIFFInput::open(const std::string& name, ImageSpec& newspec,
         m_keep_unassociated_alpha = true;
     if (config.get_int_attribute("oiio:RawColor", 0) == 1)
         m_raw_color = true;
+    m_metadata = metadata_hint(config);
     // This configuration hint has no function other than as a debugging aid
     // for testing whether configurations are received properly from other
     // OIIO components.
@@ -1237,9 +1266,12 @@ TIFFInput::readspec(bool read_meta)
     }
 
     // Search for an EXIF IFD in the TIFF file, and if found, rummage
-    // around for Exif fields.
+    // around for Exif fields. It's part of the TIFF directory structure
+    // rather than a separate block, so there's nothing to hold on to for
+    // "lazy" metadata decoding; it's read unless asked for no metadata.
     toff_t exifoffset = 0;
-    if (TIFFGetField(m_tif, TIFFTAG_EXIFIFD, &exifoffset)) {
+    if (m_metadata != "none"
+        && TIFFGetField(m_tif, TIFFTAG_EXIFIFD, &exifoffset)) {
         if (TIFFReadEXIFDirectory(m_tif, exifoffset)) {
             for (const auto& tag : tag_table("Exif"))
                 find_tag(tag.tifftag, tag.tifftype, tag.name);
@@ -1267,7 +1299,8 @@ TIFFInput::readspec(bool read_meta)
     int iptcsize         = 0;
     const char* iptcdata = nullptr;
     TypeDesc iptctype    = tiffgetfieldtype(TIFFTAG_RICHTIFFIPTC);
-    if (TIFFGetField(m_tif, TIFFTAG_RICHTIFFIPTC, &iptcsize, &iptcdata)
+    if ((m_metadata == "all" || m_metadata == "lazy")
+        && TIFFGetField(m_tif, TIFFTAG_RICHTIFFIPTC, &iptcsize, &iptcdata)
         && iptcsize > 0) {
         std::vector<char> iptc;
         if (iptctype.size() == 4) {
@@ -1281,17 +1314,27 @@ TIFFInput::readspec(bool read_meta)
         } else {
             iptc.assign(iptcdata, iptcdata + iptcsize);
         }
-        decode_iptc_iim(&iptc[0], iptcsize, m_spec);
+        if (m_metadata == "lazy")
+            m_spec.attribute("oiio:RawIPTC",
+                             TypeDesc(TypeDesc::UINT8, iptcsize), iptc.data());
+        else
+            decode_iptc_iim(&iptc[0], iptcsize, m_spec);
     }
 
     // Search for an XML packet containing XMP (IPTC, Exif, etc.)
     int xmlsize         = 0;
     const void* xmldata = NULL;
-    if (TIFFGetField(m_tif, TIFFTAG_XMLPACKET, &xmlsize, &xmldata)) {
+    if ((m_metadata == "all" || m_metadata == "lazy")
+        && TIFFGetField(m_tif, TIFFTAG_XMLPACKET, &xmlsize, &xmldata)) {
         // std::cerr << "Found XML data, size " << xmlsize << "\n";
         if (xmldata && xmlsize) {
-            std::string xml((const char*)xmldata, xmlsize);
-            decode_xmp(xml, m_spec);
+            if (m_metadata == "lazy") {
+                m_spec.attribute("oiio:RawXMP",
+                                 TypeDesc(TypeDesc::UINT8, xmlsize), xmldata);
+            } else {
+                std::string xml((const char*)xmldata, xmlsize);
+                decode_xmp(xml, m_spec);
+            }
         }
     }
 
@@ -1925,6 +1968,12 @@ TIFFInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
         // and not if the feature is turned off
         && m_spec.get_int_attribute("tiff:multithread",
                                     OIIO::get_int_attribute("tiff:multithread"));
+    // The pool threads that decompress for us come out of the process-wide
+    // thread budget, and we never have more strips in flight than we were
+    // granted helpers.
+    thread_budget_claim claim(
+        parallelize ? std::min(nstrips, pool->size()) - 1 : 0);
+    parallelize &= claim.granted() > 0;
 
     // Make room for, and read the raw (still compressed) strips. As each
     // one is read, kick off the decompress and any other extras, to execute
@@ -1973,6 +2022,8 @@ TIFFInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
             };
             if (parallelize) {
                 // Push the rest of the work onto the thread pool queue
+                if (stripidx >= size_t(claim.granted()))
+                    tasks.wait_for_task(stripidx - claim.granted());
                 tasks.push(pool->push(uncompress_etc));
             } else {
                 uncompress_etc(0);
@@ -2156,6 +2207,42 @@ TIFFInput::read_native_tile(int subimage, int miplevel, int x, int y, int z,
 
 
 
+bool
+TIFFInput::native_tile_location(int subimage, int miplevel, int x, int y,
+                                int z, int64_t& offset, int64_t& size)
+{
+#if OIIO_TIFFLIB_VERSION >= 40100
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel) || !m_spec.tile_width)
+        return false;
+    // Only raw tiles that read_native_tile would return untouched: no
+    // compression, contiguous whole-byte samples in our byte order, and
+    // none of the color or alpha conversions.
+    if (m_compression != COMPRESSION_NONE || m_separate || m_is_byte_swapped
+        || m_use_rgba_interface || m_convert_alpha
+        || m_spec.format.size() * 8 != m_bitspersample
+        || (m_photometric != PHOTOMETRIC_MINISBLACK
+            && m_photometric != PHOTOMETRIC_RGB)
+        || m_inputchannels != m_spec.nchannels || m_spec.channelformats.size())
+        return false;
+    x -= m_spec.x;
+    y -= m_spec.y;
+    z -= m_spec.z;
+    uint32_t tile = TIFFComputeTile(m_tif, x, y, z, 0);
+    uint64_t off  = TIFFGetStrileOffset(m_tif, tile);
+    uint64_t len  = TIFFGetStrileByteCount(m_tif, tile);
+    if (!off || len != uint64_t(m_spec.tile_bytes(true)))
+        return false;
+    offset = int64_t(off);
+    size   = int64_t(len);
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+
 bool
 TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
                              int ybegin, int yend, int zbegin, int zend,
@@ -2205,6 +2292,10 @@ TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
         // and not if the feature is turned off
         && m_spec.get_int_attribute("tiff:multithread",
                                     OIIO::get_int_attribute("tiff:multithread"));
+    // Decompressing helpers come out of the process-wide thread budget.
+    thread_budget_claim claim(
+        parallelize ? int(std::min(ntiles, size_t(pool->size()))) - 1 : 0);
+    parallelize &= claim.granted() > 0;
 
     // If we're not parallelizing, just call the parent class default
     // implementation of read_native_tiles, which will loop over the tiles
@@ -2249,7 +2340,10 @@ TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
                     ok = false;
                     break;
                 }
-                // Push the rest of the work onto the thread pool queue
+                // Push the rest of the work onto the thread pool queue,
+                // with no more tiles in flight than we have helpers.
+                if (tileidx >= size_t(claim.granted()))
+                    tasks.wait_for_task(tileidx - claim.granted());
                 auto out = this;
                 tasks.push(pool->push([=, &ok](int /*id*/) {
                     out->uncompress_one_strip(cbuf, (unsigned long)csize, ubuf,
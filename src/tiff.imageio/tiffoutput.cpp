@@ -3,6 +3,7 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -66,6 +67,110 @@ namespace {
 
 static double DEFAULT_CHECKPOINT_INTERVAL_SECONDS = 5.0;
 static int MIN_SCANLINES_OR_TILES_PER_CHECKPOINT  = 64;
+
+
+
+// Upper bound on the size of an LZW-compressed buffer of n bytes. Every
+// input byte can in the worst case produce a 12 bit code, plus the
+// occasional clear code when the table fills, plus the leading clear and
+// trailing EOI codes.
+static size_t
+lzw_compress_bound(size_t n)
+{
+    return (n + n / 3800 + 4) * 3 / 2 + 4;
+}
+
+
+
+// LZW-compress src[0..n-1] into dst exactly the way libtiff's encoder
+// does (MSB-first codes of 9-12 bits, "early change" code width
+// increments, ClearCode 256 / EOI 257), so that we can compress strips
+// and tiles ourselves in parallel and hand them to TIFFWriteRawStrip /
+// TIFFWriteRawTile. Return the number of bytes written, or 0 if dst (of
+// size dstsize) was not big enough.
+static size_t
+lzw_compress(const unsigned char* src, size_t n, unsigned char* dst,
+             size_t dstsize)
+{
+    enum { BITS_MIN = 9, BITS_MAX = 12, CODE_CLEAR = 256, CODE_EOI = 257,
+           CODE_FIRST = 258, CODE_MAX = (1 << BITS_MAX) - 1,
+           HSIZE = 8192 };
+    // Open-addressed hash of (prefix code, next byte) -> code.
+    std::unique_ptr<int32_t[]> hkey(new int32_t[HSIZE]);
+    std::unique_ptr<uint16_t[]> hcode(new uint16_t[HSIZE]);
+    auto clear_hash = [&]() {
+        std::fill(hkey.get(), hkey.get() + HSIZE, -1);
+    };
+    unsigned char* out    = dst;
+    unsigned char* outend = dst + dstsize;
+    uint32_t nextdata = 0, nextbits = 0;
+    int nbits = BITS_MIN, maxcode = (1 << BITS_MIN) - 1;
+    int free_ent = CODE_FIRST;
+    auto put = [&](int code) -> bool {
+        nextdata = (nextdata << nbits) | uint32_t(code);
+        nextbits += nbits;
+        while (nextbits >= 8) {
+            if (out >= outend)
+                return false;
+            *out++ = (unsigned char)(nextdata >> (nextbits - 8));
+            nextbits -= 8;
+        }
+        return true;
+    };
+    // After adding a table entry, either restart the table if it's full
+    // or widen the codes if the next entry won't fit.
+    auto advance = [&]() -> bool {
+        if (++free_ent == CODE_MAX - 1) {
+            if (!put(CODE_CLEAR))
+                return false;
+            clear_hash();
+            free_ent = CODE_FIRST;
+            nbits    = BITS_MIN;
+            maxcode  = (1 << BITS_MIN) - 1;
+        } else if (free_ent > maxcode) {
+            ++nbits;
+            maxcode = (1 << nbits) - 1;
+        }
+        return true;
+    };
+
+    clear_hash();
+    if (!put(CODE_CLEAR))
+        return 0;
+    if (n) {
+        int ent = src[0];
+        for (size_t i = 1; i < n; ++i) {
+            int c       = src[i];
+            int32_t key = (ent << 8) | c;
+            uint32_t h  = (uint32_t(key) * 2654435761u) >> (32 - 13);
+            while (hkey[h] >= 0 && hkey[h] != key)
+                h = (h + 1) & (HSIZE - 1);
+            if (hkey[h] == key) {
+                ent = hcode[h];
+                continue;
+            }
+            if (!put(ent))
+                return 0;
+            hkey[h]  = key;
+            hcode[h] = uint16_t(free_ent);
+            ent      = c;
+            if (!advance())
+                return 0;
+        }
+        // Flush the final string. The width of the EOI that follows
+        // accounts for the entry the decoder will think was added.
+        if (!put(ent) || !advance())
+            return 0;
+    }
+    if (!put(CODE_EOI))
+        return 0;
+    if (nextbits > 0) {
+        if (out >= outend)
+            return 0;
+        *out++ = (unsigned char)((nextdata << (8 - nextbits)) & 0xff);
+    }
+    return size_t(out - dst);
+}
 }  // namespace
 
 class TIFFOutput final : public ImageOutput {
@@ -90,6 +195,7 @@ public:
                      stride_t xstride = AutoStride,
                      stride_t ystride = AutoStride,
                      stride_t zstride = AutoStride) override;
+    bool copy_image(ImageInput* in) override;
 
 private:
     TIFF* m_tif = nullptr;
@@ -187,6 +293,24 @@ private:
             }
     }
 
+    // Can the strips or tiles of intif (compressed with the given method
+    // and predictor) be written verbatim into the file we're writing?
+    bool raw_copy_compatible(TIFF* intif, int compression, int predictor);
+    // Copy every strip or tile of intif to our file without decoding it.
+    bool copy_raw_chunks(TIFF* intif);
+
+    // Can we compress strips/tiles ourselves (and therefore in parallel)
+    // with the current compression, predictor, and data format?
+    bool can_compress_in_parallel() const;
+
+    // Upper bound on the compressed size of nbytes of strip/tile data.
+    size_t compress_bound(size_t nbytes) const
+    {
+        return m_compression == COMPRESSION_LZW
+                   ? lzw_compress_bound(nbytes)
+                   : size_t(compressBound((uLong)nbytes));
+    }
+
     void compress_one_strip(void* uncompressed_buf, size_t strip_bytes,
                             void* compressed_buf, unsigned long cbound,
                             int channels, int width, int height,
@@ -282,6 +406,8 @@ oiio_tiff_last_error();
 extern void
 oiio_tiff_set_error_handler();
 #endif
+extern TIFF*
+oiio_tiff_raw_input(ImageInput* in, int& compression, int& predictor);
 
 
 
@@ -1169,6 +1295,121 @@ TIFFOutput::write_exif_data()
 
 
 
+bool
+TIFFOutput::copy_image(ImageInput* in)
+{
+#if OIIO_TIFFLIB_VERSION >= 40000
+    // If the input is a TIFF file laid out and compressed just the way
+    // we'd write it, pass its strips or tiles through without decoding and
+    // re-encoding them. That makes metadata-only rewrites nearly free.
+    int compression = 0, predictor = 0;
+    if (TIFF* intif = oiio_tiff_raw_input(in, compression, predictor)) {
+        ImageInput::lock_guard lock(*in);
+        if (raw_copy_compatible(intif, compression, predictor))
+            return copy_raw_chunks(intif);
+    }
+#endif
+    return ImageOutput::copy_image(in);
+}
+
+
+
+bool
+TIFFOutput::raw_copy_compatible(TIFF* intif, int compression, int predictor)
+{
+    if (!m_tif || compression != m_compression
+        || (predictor != m_predictor && compression != COMPRESSION_NONE)
+        // JPEG streams share tables stored in the directory
+        || compression == COMPRESSION_JPEG || compression == COMPRESSION_OJPEG
+        || TIFFIsTiled(intif) != TIFFIsTiled(m_tif)
+        || TIFFIsByteSwapped(intif) != TIFFIsByteSwapped(m_tif))
+        return false;
+    auto same = [&](ttag_t tag, auto value) {
+        decltype(value) a = 0, b = 0;
+        return TIFFGetFieldDefaulted(intif, tag, &a)
+               && TIFFGetFieldDefaulted(m_tif, tag, &b) && a == b;
+    };
+    if (!same(TIFFTAG_IMAGEWIDTH, uint32_t(0))
+        || !same(TIFFTAG_IMAGELENGTH, uint32_t(0))
+        || !same(TIFFTAG_IMAGEDEPTH, uint32_t(0))
+        || !same(TIFFTAG_BITSPERSAMPLE, uint16_t(0))
+        || !same(TIFFTAG_SAMPLESPERPIXEL, uint16_t(0))
+        || !same(TIFFTAG_SAMPLEFORMAT, uint16_t(0))
+        || !same(TIFFTAG_PLANARCONFIG, uint16_t(0))
+        || !same(TIFFTAG_FILLORDER, uint16_t(0)))
+        return false;
+    if (TIFFIsTiled(intif)) {
+        if (!same(TIFFTAG_TILEWIDTH, uint32_t(0))
+            || !same(TIFFTAG_TILELENGTH, uint32_t(0))
+            || !same(TIFFTAG_TILEDEPTH, uint32_t(0))
+            || TIFFNumberOfTiles(intif) != TIFFNumberOfTiles(m_tif))
+            return false;
+    } else {
+        if (!same(TIFFTAG_ROWSPERSTRIP, uint32_t(0))
+            || TIFFNumberOfStrips(intif) != TIFFNumberOfStrips(m_tif))
+            return false;
+    }
+    // Photometric has no default, and the extra samples must agree for the
+    // alpha to mean the same thing in both files.
+    uint16_t inphot = 0, outphot = 0;
+    if (!TIFFGetField(intif, TIFFTAG_PHOTOMETRIC, &inphot)
+        || !TIFFGetField(m_tif, TIFFTAG_PHOTOMETRIC, &outphot)
+        || inphot != outphot)
+        return false;
+    uint16_t inextra = 0, outextra = 0;
+    uint16_t *ine = nullptr, *oute = nullptr;
+    TIFFGetFieldDefaulted(intif, TIFFTAG_EXTRASAMPLES, &inextra, &ine);
+    TIFFGetFieldDefaulted(m_tif, TIFFTAG_EXTRASAMPLES, &outextra, &oute);
+    if (inextra != outextra
+        || (inextra && !std::equal(ine, ine + inextra, oute)))
+        return false;
+    return true;
+}
+
+
+
+bool
+TIFFOutput::copy_raw_chunks(TIFF* intif)
+{
+#if OIIO_TIFFLIB_VERSION >= 40000
+    bool tiled       = TIFFIsTiled(intif);
+    uint64_t* counts = nullptr;
+    if (!TIFFGetField(intif,
+                      tiled ? TIFFTAG_TILEBYTECOUNTS : TIFFTAG_STRIPBYTECOUNTS,
+                      &counts)
+        || !counts) {
+        errorfmt("Could not read the {} sizes of the input file",
+                 tiled ? "tile" : "strip");
+        return false;
+    }
+    uint32_t nchunks = tiled ? TIFFNumberOfTiles(intif)
+                             : TIFFNumberOfStrips(intif);
+    std::vector<unsigned char> buf;
+    for (uint32_t i = 0; i < nchunks; ++i) {
+        if (!counts[i])
+            continue;  // sparse file, nothing stored for this chunk
+        tmsize_t size = tmsize_t(counts[i]);
+        buf.resize(size);
+        tmsize_t r = tiled ? TIFFReadRawTile(intif, i, buf.data(), size)
+                           : TIFFReadRawStrip(intif, i, buf.data(), size);
+        if (r < 0
+            || (tiled ? TIFFWriteRawTile(m_tif, i, buf.data(), r)
+                      : TIFFWriteRawStrip(m_tif, i, buf.data(), r))
+                   < 0) {
+            std::string err = oiio_tiff_last_error();
+            errorfmt("Failed copying raw {} {}: {}", tiled ? "tile" : "strip",
+                     i, err.size() ? err.c_str() : "unknown error");
+            return false;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+
 bool
 TIFFOutput::close()
 {
@@ -1314,14 +1555,26 @@ TIFFOutput::compress_one_strip(void* uncompressed_buf, size_t strip_bytes,
                                int channels, int width, int height,
                                unsigned long* compressed_size, bool* ok)
 {
-    if (m_spec.format == TypeUInt8)
-        horizontal_predictor((unsigned char*)uncompressed_buf,
-                             (unsigned char*)uncompressed_buf, channels, width,
-                             height);
-    else if (m_spec.format == TypeUInt16)
-        horizontal_predictor((unsigned short*)uncompressed_buf,
-                             (unsigned short*)uncompressed_buf, channels, width,
-                             height);
+    if (m_predictor == PREDICTOR_HORIZONTAL) {
+        // Two's complement differences are the same bits for signed and
+        // unsigned, so only the element size matters.
+        if (m_spec.format.size() == 1)
+            horizontal_predictor((unsigned char*)uncompressed_buf,
+                                 (unsigned char*)uncompressed_buf, channels,
+                                 width, height);
+        else if (m_spec.format.size() == 2)
+            horizontal_predictor((unsigned short*)uncompressed_buf,
+                                 (unsigned short*)uncompressed_buf, channels,
+                                 width, height);
+    }
+    if (m_compression == COMPRESSION_LZW) {
+        *compressed_size = (unsigned long)lzw_compress(
+            (const unsigned char*)uncompressed_buf, strip_bytes,
+            (unsigned char*)compressed_buf, cbound);
+        if (*compressed_size == 0)
+            *ok = false;
+        return;
+    }
     *compressed_size = cbound;
     auto zok         = compress2((Bytef*)compressed_buf, compressed_size,
                                  (const Bytef*)uncompressed_buf,
@@ -1332,6 +1585,22 @@ TIFFOutput::compress_one_strip(void* uncompressed_buf, size_t strip_bytes,
 
 
 
+bool
+TIFFOutput::can_compress_in_parallel() const
+{
+    // only deflate/zip or LZW compression
+    if (m_compression != COMPRESSION_ADOBE_DEFLATE
+        && m_compression != COMPRESSION_LZW)
+        return false;
+    // horizontal predictor on 8 or 16 bit data, or no predictor at all
+    // (the floating point predictor is left to libtiff)
+    if (m_predictor == PREDICTOR_HORIZONTAL)
+        return m_spec.format.size() == 1 || m_spec.format.size() == 2;
+    return m_predictor == PREDICTOR_NONE;
+}
+
+
+
 bool
 TIFFOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
                             const void* data, stride_t xstride,
@@ -1341,9 +1610,10 @@ TIFFOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
     // thread pool to parallelize the compression. This can give a large
     // speedup (5x or more!) because the zip compression dwarfs the
     // actual raw I/O. But libtiff is totally serialized, so we can only
-    // parallelize by making calls to zlib ourselves and then writing
-    // "raw" (compressed) strips. Don't bother trying to handle any of
-    // the uncommon cases with strips. This covers most real-world cases.
+    // parallelize by making calls to zlib (or our own LZW encoder) and
+    // then writing "raw" (compressed) strips. Don't bother trying to
+    // handle any of the uncommon cases with strips. This covers most
+    // real-world cases.
     thread_pool* pool = default_thread_pool();
     int nstrips       = (yend - ybegin + m_rowsperstrip - 1) / m_rowsperstrip;
     bool parallelize =
@@ -1359,11 +1629,9 @@ TIFFOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
         && (spec().format.size() * 8 == m_bitspersample)
         // contig planarconfig only
         && m_planarconfig == PLANARCONFIG_CONTIG
-        // only deflate/zip compression with horizontal predictor
-        && m_compression == COMPRESSION_ADOBE_DEFLATE
-        && m_predictor == PREDICTOR_HORIZONTAL
-        // only uint8, uint16
-        && (m_spec.format == TypeUInt8 || m_spec.format == TypeUInt16)
+        // only compression/predictor/format combinations we can do
+        // ourselves (zip or LZW)
+        && can_compress_in_parallel()
         // only if we're threading and don't enter the thread pool recursively!
         && pool->size() > 1
         && !pool->is_worker()
@@ -1372,6 +1640,12 @@ TIFFOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
         // and not if the feature is turned off
         && m_spec.get_int_attribute("tiff:multithread",
                                     OIIO::get_int_attribute("tiff:multithread"));
+    // The pool threads that compress for us come out of the process-wide
+    // thread budget, and we never have more strips in flight than we were
+    // granted helpers.
+    thread_budget_claim claim(
+        parallelize ? std::min(nstrips, pool->size()) - 1 : 0);
+    parallelize &= claim.granted() > 0;
 
     // If we're not parallelizing, just call the parent class default
     // implementation of write_scanlines, which will loop over the scanlines
@@ -1402,7 +1676,7 @@ TIFFOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
     memcpy(scratch.get(), data, scratch_bytes);
     data                    = scratch.get();
     imagesize_t strip_bytes = m_spec.scanline_bytes(true) * m_rowsperstrip;
-    size_t cbound           = compressBound((uLong)strip_bytes);
+    size_t cbound           = compress_bound(strip_bytes);
     std::unique_ptr<char[]> compressed_scratch(new char[cbound * nstrips]);
     unsigned long* compressed_len;
     OIIO_ALLOCATE_STACK_OR_HEAP(compressed_len, unsigned long, nstrips);
@@ -1416,6 +1690,8 @@ TIFFOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
          y += m_rowsperstrip, ++stripidx) {
         char* cbuf = compressed_scratch.get() + stripidx * cbound;
         auto out   = this;
+        if (stripidx >= size_t(claim.granted()))
+            tasks.wait_for_task(stripidx - claim.granted());
         tasks.push(pool->push([=, &ok](int /*id*/) {
             memcpy((void*)data, origdata, strip_bytes);
             out->compress_one_strip((void*)data, strip_bytes, cbuf, cbound,
@@ -1570,8 +1846,8 @@ TIFFOutput::write_tiles(int xbegin, int xend, int ybegin, int yend, int zbegin,
     // parallelize the compression of the tiles. This can give a large
     // speedup (5x or more!) because the zip compression dwarfs the actual
     // raw I/O. But libtiff is totally serialized, so we can only
-    // parallelize by making calls to zlib ourselves and then writing "raw"
-    // (compressed) strips. Don't bother trying to handle any of the
+    // parallelize by making calls to zlib (or our own LZW encoder) and
+    // then writing "raw" (compressed) tiles. Don't bother trying to handle any of the
     // uncommon cases with strips. This covers most real-world cases.
     thread_pool* pool = default_thread_pool();
     OIIO_DASSERT(m_spec.tile_depth >= 1);
@@ -1589,17 +1865,19 @@ TIFFOutput::write_tiles(int xbegin, int xend, int ybegin, int yend, int zbegin,
         && (spec().format.size() * 8 == m_bitspersample)
         // contig planarconfig only
         && m_planarconfig == PLANARCONFIG_CONTIG
-        // only deflate/zip compression with horizontal predictor
-        && m_compression == COMPRESSION_ADOBE_DEFLATE
-        && m_predictor == PREDICTOR_HORIZONTAL
-        // only uint8, uint16
-        && (m_spec.format == TypeUInt8 || m_spec.format == TypeUInt16)
+        // only compression/predictor/format combinations we can do
+        // ourselves (zip or LZW)
+        && can_compress_in_parallel()
         // only if we're threading and don't enter the thread pool recursively!
         && pool->size() > 1
         && !pool->is_worker()
         // and not if the feature is turned off
         && m_spec.get_int_attribute("tiff:multithread",
                                     OIIO::get_int_attribute("tiff:multithread"));
+    // Compressing helpers come out of the process-wide thread budget.
+    thread_budget_claim claim(
+        parallelize ? int(std::min(ntiles, size_t(pool->size()))) - 1 : 0);
+    parallelize &= claim.granted() > 0;
 
     // If we're not parallelizing, just call the parent class default
     // implementation of write_tiles, which will loop over the tiles and
@@ -1615,7 +1893,7 @@ TIFFOutput::write_tiles(int xbegin, int xend, int ybegin, int yend, int zbegin,
     // Allocate various temporary space we need
     stride_t tile_bytes = (stride_t)m_spec.tile_bytes(true);
     std::vector<std::vector<unsigned char>> tilebuf(ntiles);
-    size_t cbound = compressBound((uLong)tile_bytes);
+    size_t cbound = compress_bound(tile_bytes);
     std::unique_ptr<char[]> compressed_scratch(new char[ntiles * cbound]);
     unsigned long* compressed_len = OIIO_ALLOCA(unsigned long, ntiles);
 
@@ -1631,6 +1909,9 @@ TIFFOutput::write_tiles(int xbegin, int xend, int ybegin, int yend, int zbegin,
         for (int y = ybegin; y < yend; y += m_spec.tile_height) {
             for (int x = xbegin; ok && x < xend;
                  x += m_spec.tile_width, ++tileno) {
+                // No more tiles in flight than we have helpers
+                if (tileno >= claim.granted())
+                    tasks.wait_for_task(size_t(tileno - claim.granted()));
                 tasks.push(pool->push([&, x, y, z, tileno](int /*id*/) {
                     const unsigned char* tilestart
                         = ((unsigned char*)data + (x - xbegin) * xstride
@@ -2,6 +2,9 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <deque>
+#include <map>
+
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imageio.h>
@@ -46,10 +49,19 @@ private:
     WebPIterator m_iter;
     int m_subimage      = -1;  // Subimage we're pointed to
     int m_subimage_read = -1;  // Subimage stored in decoded_image
+    // Composited canvases of every m_snapshot_interval'th subimage (within
+    // a memory budget), and of the last few read, so that we can get to
+    // any frame without compositing everything before it.
+    std::map<int, std::vector<uint8_t>> m_snapshots;
+    int m_snapshot_interval = 8;
+    std::deque<std::pair<int, std::vector<uint8_t>>> m_recent;
 
     void init(void)
     {
         m_filename.clear();
+        m_snapshots.clear();
+        m_recent.clear();
+        m_snapshot_interval = 8;
         ioproxy_clear();
     }
 
@@ -75,6 +87,10 @@ private:
     // hard logic about how to get to the right spot if it's not the next
     // sequential frame.
     bool read_subimage(int subimage, bool read);
+
+    // Save the canvas of the subimage just read, as a snapshot and/or
+    // among the recently read.
+    void remember_subimage();
 };
 
 
@@ -202,7 +218,7 @@ WebpInput::open(const std::string& name, ImageSpec& spec,
     }
 
     // Make space for the decoded image
-    m_decoded_image.reset(new uint8_t[m_spec.image_bytes()]);
+    m_decoded_image.reset(new uint8_t[m_spec.image_bytes()]());
 
     seek_subimage(0, 0);
     spec = m_spec;
@@ -239,38 +255,68 @@ WebpInput::read_subimage(int subimage, bool read)
     if (!read)
         return iter_to_subimage(subimage);
 
-    // If we're pointing to (and have read) the immediately previous frame,
-    // catch up.
-    if (m_subimage == subimage - 1 && m_subimage_read == subimage - 1) {
-        if (!iter_to_subimage(subimage))
-            return false;
+    // Frames are composited atop the ones before them, so find the
+    // closest frame at or before the requested one that we can resume
+    // from: the one last read, a recently read one, or a snapshot.
+    int from = m_subimage_read <= subimage ? m_subimage_read : -1;
+    // The canvas to restore, if not the current one
+    const std::vector<uint8_t>* saved = nullptr;
+    for (auto& r : m_recent) {
+        if (r.first <= subimage && r.first > from) {
+            from  = r.first;
+            saved = &r.second;
+        }
     }
-
-    // If we're pointing to the right subimage, read it if we need to, and
-    // we're done.
-    if (m_subimage == subimage && read_current_subimage())
-        return true;
-
-    // All other cases: backtrack to the beginning and read up to where
-    // we need to be.
-    m_subimage      = -1;
-    m_subimage_read = -1;
-    while (m_subimage < subimage) {
-        if (iter_to_subimage(m_subimage + 1) && read_current_subimage())
-            m_subimage_read = m_subimage;
+    auto snap = m_snapshots.upper_bound(subimage);
+    if (snap != m_snapshots.begin() && (--snap)->first > from) {
+        from  = snap->first;
+        saved = &snap->second;
+    }
+    if (saved)
+        memcpy(m_decoded_image.get(), saved->data(), saved->size());
+    else if (from < 0)
+        memset(m_decoded_image.get(), 0, m_spec.image_bytes());
+    m_subimage_read = from;
+
+    // Read up to where we need to be.
+    while (m_subimage_read < subimage) {
+        if (iter_to_subimage(m_subimage_read + 1) && read_current_subimage())
+            remember_subimage();
         else
             return false;
     }
+    return iter_to_subimage(subimage);
+}
 
-    return true;
 
-    // FIXME: this covers the common cases efficiently: sequential or random
-    // access for reading just subimage metadata, and sequential access to
-    // subimages for reading pixels. Random access to subimages requiring
-    // pixel reads incurs lots of backtracking. It would be straightforward
-    // to add the case where we randomly seek forward (just keep reading
-    // until we catch up), but we can leave that until it becomes apparent
-    // that this is an important performance case.
+
+void
+WebpInput::remember_subimage()
+{
+    // If the snapshots outgrow their memory budget, thin them out and
+    // space them wider apart.
+    const size_t max_snapshot_bytes = 64 * 1024 * 1024;
+    const size_t max_recent         = 8;
+    size_t bytes                    = m_spec.image_bytes();
+    std::vector<uint8_t> canvas(m_decoded_image.get(),
+                                m_decoded_image.get() + bytes);
+    if (m_subimage_read % m_snapshot_interval == 0
+        && !m_snapshots.count(m_subimage_read)) {
+        m_snapshots[m_subimage_read] = canvas;
+        while (m_snapshots.size() > 1
+               && m_snapshots.size() * bytes > max_snapshot_bytes) {
+            m_snapshot_interval *= 2;
+            for (auto s = m_snapshots.begin(); s != m_snapshots.end();)
+                s = (s->first % m_snapshot_interval) ? m_snapshots.erase(s)
+                                                     : std::next(s);
+        }
+    }
+    for (auto& r : m_recent)
+        if (r.first == m_subimage_read)
+            return;
+    m_recent.emplace_back(m_subimage_read, std::move(canvas));
+    if (m_recent.size() > max_recent)
+        m_recent.pop_front();
 }
 
 
@@ -367,7 +413,8 @@ WebpInput::close()
     }
     m_decoded_image.reset();
     m_encoded_image.reset();
-    m_subimage = -1;
+    m_subimage      = -1;
+    m_subimage_read = -1;
     init();
     return true;
 }
@@ -0,0 +1,82 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+# Round trip images through each DDS block compression mode, with and
+# without MIP levels, and check that the decoded pixels stay close to the
+# originals. The sources are vertical ramps, so the colors within any 4x4
+# block lie on a line and every mode should reproduce them to within a
+# few 8 bit steps, even on the smallest MIP levels.
+
+# Largest per-channel error allowed after block compression
+bcthresh = 0.04
+
+def roundtrip (label, src, dst, thresh=bcthresh) :
+    cmd = (oiio_app("idiff") + " -q -a -fail " + str(thresh)
+           + " -warn " + str(thresh) + " " + src + " " + dst)
+    return ("(" + cmd + " && echo \"" + label + ": ok\")" + redirect + " ;\n")
+
+# Sources: RGBA with varying alpha, RGB, two channel, one channel, and a
+# size that does not divide into whole blocks.
+command += oiiotool ("--pattern fill:top=0.1,0.2,0.3,1.0:bottom=0.8,0.9,0.6,0.5"
+                     + " 64x64 4 -d uint8 -o rgba.tif")
+command += oiiotool ("--pattern fill:top=0.1,0.2,0.3,1.0:bottom=0.8,0.9,0.6,1.0"
+                     + " 64x64 4 -d uint8 -o rgb1.tif")
+command += oiiotool ("--pattern fill:top=0.1,0.2,0.3:bottom=0.8,0.9,0.6"
+                     + " 64x64 3 -d half -o rgb.exr")
+command += oiiotool ("--pattern fill:top=0.1,0.9:bottom=0.8,0.2"
+                     + " 64x64 2 -d uint8 -o rg.tif")
+command += oiiotool ("--pattern fill:top=0.1:bottom=0.8"
+                     + " 64x64 1 -d uint8 -o r.tif")
+command += oiiotool ("--pattern fill:top=0.1,0.2,0.3,1.0:bottom=0.8,0.9,0.6,0.5"
+                     + " 37x21 4 -d uint8 -o rgba-npot.tif")
+
+modes = [ ("bc1", "rgb1.tif"), ("bc3", "rgba.tif"), ("bc4", "r.tif"),
+          ("bc5", "rg.tif"), ("bc6h", "rgb.exr"), ("bc7", "rgba.tif") ]
+
+# Single level, written by oiiotool
+for (comp, src) in modes :
+    command += oiiotool (src + " --compression " + comp
+                         + " -o " + comp + ".dds")
+    command += roundtrip (comp, src, comp + ".dds")
+
+# Each encoder effort level, and partial blocks at the image edges
+for q in [ "10", "50", "90" ] :
+    for comp in [ "bc1", "bc7" ] :
+        out = comp + "-q" + q + "-npot.dds"
+        command += oiiotool ("rgba-npot.tif --compression " + comp + ":" + q
+                             + " -o " + out)
+        command += roundtrip (out, "rgba-npot.tif", out)
+
+# Uncompressed 8 bit output of 1 to 4 channels is exact
+command += oiiotool ("rgba.tif --ch R,G,B -o rgb8.tif")
+for src in [ "r.tif", "rg.tif", "rgb8.tif", "rgba.tif" ] :
+    out = "u-" + src.replace(".tif", ".dds")
+    command += oiiotool (src + " -o " + out)
+    command += roundtrip (out, src, out, 0)
+
+# Emulated tiles, and compressing on a single thread, must give exactly
+# the same blocks as the default whole-image, multithreaded write.
+command += oiiotool ("rgba.tif --tile 16 16 --compression bc3 -o bc3-tiled.dds")
+command += roundtrip ("bc3-tiled.dds", "bc3.dds", "bc3-tiled.dds", 0)
+command += oiiotool ("--threads 1 rgba.tif --compression bc7 -o bc7-t1.dds")
+command += roundtrip ("bc7-t1.dds", "bc7.dds", "bc7-t1.dds", 0)
+
+# MIP-mapped, written by maketx --format dds. The uncompressed DDS texture
+# made from the same source serves as the reference for every level.
+for (comp, src) in modes :
+    ref = "ref-" + comp + ".dds"
+    out = comp + "-mip.dds"
+    command += maketx_command (src, ref, "--format dds")
+    command += maketx_command (src, out,
+                               "--format dds --compression " + comp)
+    command += roundtrip (out, ref, out)
+
+# maketx --nomipmap with compression writes a single level
+command += maketx_command ("rgba.tif", "bc3-nomip.dds",
+                           "--format dds --nomipmap --compression bc3")
+command += roundtrip ("bc3-nomip.dds", "rgba.tif", "bc3-nomip.dds")
+
+outputs = [ "out.txt" ]
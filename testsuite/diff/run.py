@@ -4,6 +4,8 @@
 # SPDX-License-Identifier: Apache-2.0
 # https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+import os
+
 
 # Make two images that differ by a particular known pixel value
 command += oiiotool("-pattern fill:color=0.1,0.1,0.1 64x64 3 -d float -o img1.exr")
@@ -22,5 +24,24 @@ command += diff_command("img1.exr", "img1.exr", extraargs="-p")
 command += diff_command("img1.exr", "img2.exr", extraargs="-p -fail 1")
 
 
+# Batch mode, from two directories and from a manifest. Only the verdict,
+# max error, and filenames are checked, since how many pixels a failing
+# pair counts before it stops early is not fixed.
+for d in [ "batch0/sub", "batch1/sub" ] :
+    if not os.path.exists(d) :
+        os.makedirs(d)
+command += oiiotool("img1.exr -o batch0/a.exr")
+command += oiiotool("img1.exr -o batch1/a.exr")
+command += oiiotool("img1.exr -o batch0/sub/b.exr")
+command += oiiotool("img2.exr -o batch1/sub/b.exr")
+with open("manifest.txt", "w") as f :
+    f.write("# reference  result\nimg1.exr img1.exr\n\n"
+            + "img1.exr img2.exr\nimg1.exr missing.exr\n")
+command += (oiio_app("idiff") + " batch0 batch1 | cut -f1,2,5,6"
+            + redirect + " ;\n")
+command += (oiio_app("idiff") + " -batch manifest.txt | cut -f1,2,5,6"
+            + redirect + " ;\n")
+
+
 # Outputs to check against references
 outputs = [ "out.txt" ]
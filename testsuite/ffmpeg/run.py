@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# Make a short movie with short GOPs and B-frames, so that frames are
+# decoded out of display order, using the ffmpeg command that comes with
+# the libraries. Then read its frames out of order, and check each one
+# against the same frame from a plain front-to-back read.
+command += ("ffmpeg -loglevel error -y -f lavfi"
+            + " -i testsrc=size=96x64:rate=24:duration=1.25"
+            + " -c:v mpeg4 -g 6 -bf 2 -pix_fmt yuv420p movie.mp4 ;\n")
+command += pythonbin + " src/seekframes.py movie.mp4 >> out.txt ;\n"
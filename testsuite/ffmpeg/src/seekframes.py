@@ -0,0 +1,45 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+import OpenImageIO as oiio
+import numpy
+
+import sys
+
+filename = sys.argv[1]
+
+# Reference frames: every frame in order
+inp = oiio.ImageInput.open(filename)
+frames = []
+while inp.seek_subimage(len(frames), 0) :
+    frames.append(inp.read_image("uint8"))
+inp.close()
+print("frames:", len(frames))
+
+# Jumps forward past key frames, back into an earlier GOP, back a frame
+# at a time within one GOP (frame cache hits), repeats, and the ends.
+order = [ 17, 3, 4, 2, 25, 24, 23, 22, 0, 29, 12, 12, 13, 7, 28, 1 ]
+
+def check (label, config=None) :
+    if config :
+        inp = oiio.ImageInput.open(filename, config)
+    else :
+        inp = oiio.ImageInput.open(filename)
+    bad = []
+    for f in order :
+        if (not inp.seek_subimage(f, 0)
+            or not numpy.array_equal(inp.read_image("uint8"), frames[f])) :
+            bad.append(f)
+    inp.close()
+    print(label, "mismatched frames:", bad)
+
+check("default")
+
+# Without the frame cache, every jump decodes from a key frame
+config = oiio.ImageSpec()
+config.attribute("ffmpeg:framecache", 0)
+check("no framecache", config)
@@ -0,0 +1,33 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# Source frames, each a different color so that a mix-up between the files
+# converted at once would show.
+for f in range(1, 7) :
+    command += oiiotool ("-pattern fill:top=0.{0},0.2,0.5:bottom=0.5,0.{0},0.2 256x256 3 -d float -o in.000{0}.exr".format(f))
+
+# Convert the whole sequence several files at a time, under a memory limit
+# smaller than two of the files, so that they have to wait for each other.
+command += iconvert ("--parallel-files 3 --max-memory 1 -d uint8 in.#.exr out.#.tif")
+for f in range(1, 7) :
+    command += ("(" + oiio_app("idiff") + " -q -a -fail 0.004 -warn 0.004 "
+                + "in.000{0}.exr out.000{0}.tif && echo \"frame {0}: ok\")".format(f)
+                + redirect + " ;\n")
+
+# An explicit frame range converts only those frames
+command += iconvert ("-d half in.2-3#.exr range.#.exr")
+for f in range(1, 5) :
+    command += ("(test -f range.000{0}.exr && echo \"range.000{0}.exr written\""
+                + " || echo \"range.000{0}.exr not written\")").format(f) + redirect + " ;\n"
+
+# A list of input/output pairs
+command += iconvert ("-d uint16 in.0001.exr pair1.tif in.0005.exr pair5.tif")
+command += ("(" + oiio_app("idiff") + " -q -a -fail 0.0001 in.0001.exr pair1.tif "
+            + "&& " + oiio_app("idiff") + " -q -a -fail 0.0001 in.0005.exr pair5.tif "
+            + "&& echo \"pairs: ok\")" + redirect + " ;\n")
+
+outputs = [ "out.txt" ]
@@ -4,8 +4,32 @@
 # SPDX-License-Identifier: Apache-2.0
 # https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+import os
+import shutil
+
 
 redirect = ' >> out.txt 2>&1 '
 
 command += run_app (oiio_app("igrep") + " -i -E wg ../oiio-images/tahoe-gps.jpg")
 
+
+# Recursive searches of a tree, which are done in parallel but must report
+# in the order of a depth-first walk: tree/sub/ comes before tree/sub.tif.
+# The text file is not an image and is skipped quietly. The JPEG's GPS
+# metadata is only found once its Exif block is decoded.
+for d in [ "tree/sub", "tree/sub2", "exif" ] :
+    if not os.path.exists(d) :
+        os.makedirs(d)
+with open("tree/notes.txt", "w") as f :
+    f.write("red car\n")
+shutil.copyfile(os.path.join(OIIO_TESTSUITE_IMAGEDIR, "tahoe-gps.jpg"),
+                "exif/gps.jpg")
+for (desc, file) in [ ("red car", "tree/a.tif"), ("blue car", "tree/sub/b.tif"),
+                      ("green", "tree/sub.tif"), ("red bus", "tree/sub2/c.tif") ] :
+    command += oiiotool ("-pattern constant:color=0,0,0 4x4 3 --nosoftwareattrib "
+                         + "--attrib ImageDescription \"" + desc + "\" -o " + file)
+command += run_app (oiio_app("igrep") + " -r car tree")
+command += run_app (oiio_app("igrep") + " -r -d -l -E \"red|green\" tree")
+command += run_app (oiio_app("igrep") + " -r -v -l car tree")
+command += run_app (oiio_app("igrep") + " -r WGS exif")
+command += run_app (oiio_app("igrep") + " -l WGS exif/gps.jpg")
@@ -30,3 +30,13 @@ command += info_command ("--info:format=xml tmp.tif", safematch=True)
 # Info for subimages and mips
 command += info_command ("--stats src/subimage.tif", info_program="iinfo")
 command += info_command ("--stats src/mip.tif", info_program="iinfo")
+
+# Several files examined at once are still reported in order, and
+# --summary totals them, counting all MIP levels of grid.tx (the missing
+# file is reported on stderr and counted as unreadable).
+command += oiiotool ("-pattern constant:color=0.5,0.5,0.5 64x32 3 -d uint8 -o sum1.tif")
+command += oiiotool ("-pattern constant:color=0.5,0.5,0.5 64x32 3 -d uint16 -o sum2.tif")
+command += oiiotool ("-pattern constant:color=0.5,0.5,0.5,1 16x16 4 -d half -o sum3.exr")
+command += run_app (oiio_app("iinfo") + " sum1.tif sum3.exr sum2.tif")
+command += (oiio_app("iinfo") + " --summary sum1.tif sum2.tif sum3.exr "
+            + "../common/textures/grid.tx missing.tif" + redirect + " || true ;\n")
@@ -141,6 +141,27 @@ command += oiiotool ("../common/tahoe-tiny.tif " +
                      "--echo \"filename={TOP.filename} file_extension={TOP.file_extension} file_noextension={TOP.file_noextension}\" " +
                      "--echo \"MINCOLOR={TOP.MINCOLOR} MAXCOLOR={TOP.MAXCOLOR} AVGCOLOR={TOP.AVGCOLOR}\"")
 
+# Expressions are compiled once and reused, here for each frame. When the
+# compiled form can't finish, the interpreter takes over (here it stops at
+# the non-number and ignores the "+0"), reusing the image that IMG[file]
+# opened and the stats already computed.
+command += oiiotool ("--frames 1-3 ../common/tahoe-tiny.tif " +
+                     "--echo \"Compiled {FRAME_NUMBER}: {FRAME_NUMBER*TOP.width+IMG[0].height}\"")
+command += oiiotool ("../common/tahoe-tiny.tif " +
+                     "--echo \"Fallback: {TOP.MAXCOLOR+0} {IMG[../common/tahoe-tiny.tif].MINCOLOR+0}\"")
+
+# A cached compiled expression must keep the parser's precedence and
+# left associativity, and must look up variables and attributes afresh
+# each time it is evaluated.
+command += oiiotool ("--frames 1-3 --echo \"Precedence {FRAME_NUMBER}: "
+                     + "{(FRAME_NUMBER+1)*3-2*2} {10-FRAME_NUMBER-1}\"")
+command += oiiotool ('-set i 2 -echo "Cached: {i*i}" '
+                     + '-set i 3 -echo "Cached: {i*i}" '
+                     + '--oiioattrib limits:channels 100 '
+                     + '-echo "Cached: {getattribute(\"limits:channels\")}" '
+                     + '--oiioattrib limits:channels 200 '
+                     + '-echo "Cached: {getattribute(\"limits:channels\")}"')
+
 command += oiiotool (
     "--echo \"Testing NIMAGES:\" " +
     "--echo \"  {NIMAGES}\" " +
@@ -156,6 +177,49 @@ command += oiiotool (
 command += oiiotool ("../common/tahoe-tiny.tif -sub ../common/tahoe-tiny.tif "
                      + "-echo \"postponed sub:\" --printinfo:stats=1:verbose=0")
 
+# An asynchronous output lands under its own name once it's done (it is
+# written to a temp file and renamed), and a single level image doesn't
+# carry along a "textureformat" that would claim it's a MIP-mapped texture.
+command += oiiotool ("--create 16x16 3 --attrib textureformat \"Plain Texture\" "
+                     + "--tile 16 16 -o:async=1 async.tif "
+                     + "async.tif --echo \"async: {TOP.width}x{TOP.height} "
+                     + "textureformat='{TOP[textureformat]}'\"")
+
+# Pointwise ops may write their result over their input's pixels, but
+# only when nothing else refers to that image: a labeled image, or one
+# that --dup left on the stack, must come through unchanged.
+command += oiiotool ("--pattern constant:color=0.25 2x2 1 --label base "
+                     + "--addc 0.5 --mulc 2 "
+                     + "--echo \"inplace: result={TOP.AVGCOLOR} base={IMG[base].AVGCOLOR}\"")
+command += oiiotool ("--pattern constant:color=0.25 2x2 1 --dup --invert "
+                     + "--echo \"inplace: result={TOP.AVGCOLOR} dup={IMG[1].AVGCOLOR}\"")
+
+# Frames run in parallel, with the default memory cap or one so small that
+# only one frame runs at a time, must come out the same as serial frames.
+command += oiiotool ("copyA.#.jpg --invert -o serial.#.tif")
+command += oiiotool ("--parallel-frames copyA.#.jpg --invert -o par.#.tif")
+command += oiiotool ("--parallel-frames --parallel-frames-memory 1 "
+                     + "copyA.#.jpg --invert -o parmem.#.tif")
+for f in range(1, 11) :
+    for p in [ "par", "parmem" ] :
+        command += ("(" + oiio_app("idiff") + " -q -a serial.{0}.tif"
+                    + " {1}.{0}.tif && echo \"{1}.{0}.tif: ok\")"
+                    + redirect + " ;\n").format(f, p)
+
+# In a serial sequence, each frame's inputs are prefetched into the cache
+# while the frame before it runs, and read back out of the cache. Every
+# frame must still match the same command run on its own.
+for f in range(1, 5) :
+    command += oiiotool (("--pattern fill:top=0.{0},0,0:bottom=0,0.{0},0 "
+                          + "128x96 3 -o grad.{0}.tif").format(f))
+command += oiiotool ("grad.1-4#.tif copyA.1-4#.jpg --add -o seqadd.#.tif")
+for f in range(1, 5) :
+    command += oiiotool (("grad.{0}.tif copyA.{0}.jpg --add "
+                          + "-o oneadd.{0}.tif").format(f))
+    command += ("(" + oiio_app("idiff") + " -q -a oneadd.{0}.tif"
+                + " seqadd.{0}.tif && echo \"seqadd.{0}.tif: ok\")"
+                + redirect + " ;\n").format(f)
+
 # To add more tests, just append more lines like the above and also add
 # the new 'feature.tif' (or whatever you call it) to the outputs list,
 # below.
@@ -132,6 +132,50 @@ command += oiiotool ("--pattern constant:color=0.5 64x64 1 --text R --chnames R
 command += oiiotool ("-echo \"Testing -o with no image\" -o out.tif")
 
 
+# --mosaic reads its file inputs in parallel, and reads those it will
+# shrink from a smaller MIP level or a scaled JPEG decode. That must match
+# fitting from the full resolution, to within a small tolerance.
+command += oiiotool ("--pattern fill:topleft=1,0,0:topright=0,1,0:"
+                     + "bottomleft=0,0,1:bottomright=1,1,1 512x512 3 "
+                     + "-otex mosaic-src.tx")
+command += oiiotool ("--pattern fill:top=0.2,0.4,0.8:bottom=0.9,0.5,0.1 "
+                     + "800x600 3 -o mosaic-src.jpg")
+mosaicsrcs = ("mosaic-src.tx mosaic-src.jpg ../common/tahoe-tiny.tif "
+              + "mosaic-src.jpg ")
+command += oiiotool (mosaicsrcs + "--mosaic:pad=4:fit=64x64 2x2 "
+                     + "-d float -o mosaic-reduced.exr")
+command += oiiotool (mosaicsrcs + "--mosaic:pad=4:fit=64x64:reduce=0 2x2 "
+                     + "-d float -o mosaic-full.exr")
+command += ("(" + oiio_app("idiff") + " -q -a -fail 0.03 -warn 0.03 "
+            + "mosaic-full.exr mosaic-reduced.exr"
+            + " && echo \"mosaic reduce: ok\")" + redirect + " ;\n")
+
+
+
+# Rewriting only the metadata of an image hands the compressed strips,
+# tiles, or parts straight to the output. The pixels must come through
+# unchanged, and the new metadata must be there.
+command += oiiotool ("--pattern fill:top=0.1,0.2,0.3:bottom=0.9,0.6,0.3 "
+                     + "128x96 3 -d uint16 --tile 32 32 --compression lzw "
+                     + "-o pass-tiles-src.tif")
+command += oiiotool ("--pattern fill:left=0,0,0:right=1,0.5,0.25 "
+                     + "100x75 3 -d uint8 --compression zip "
+                     + "-o pass-strips-src.tif")
+command += oiiotool ("--pattern fill:topleft=1,0,0:topright=0,1,0:"
+                     + "bottomleft=0,0,1:bottomright=1,1,1 128x128 3 "
+                     + "-d half -otex pass-mip-src.exr")
+for src in [ "pass-tiles-src.tif", "pass-strips-src.tif",
+             "pass-mip-src.exr", "rgb-z-parts64.exr" ] :
+    dst = src.replace("-src", "").replace("rgb-z-parts64", "pass-parts")
+    command += oiiotool (src + " --attrib:allsubimages=1 Artist Lee -o " + dst)
+    command += oiiotool ("-i " + dst + " --echo \"" + dst
+                         + " Artist={TOP[Artist]}\"")
+    command += ("(" + oiio_app("idiff") + " -q -a -fail 0 -warn 0 "
+                + src + " " + dst
+                + " && echo \"passthrough " + dst + ": ok\")"
+                + redirect + " ;\n")
+
+
 # Outputs to check against references
 outputs = [
             "rgonly.exr", "ch-err.exr", "ch-err2.exr",
@@ -0,0 +1,44 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# --lazy must give exactly the pixels that running each command in turn
+# does. The chain of pointwise ops is broken by a filter (which needs the
+# fused result), after which a new chain starts.
+chain = ("--addc 0.1 --mulc 0.5,0.75,1 --invert --clamp:min=0.1:max=0.9 "
+         + "--blur 3x3 --powc 2 --subc 0.05 ")
+command += oiiotool ("../common/tahoe-tiny.tif " + chain + "-d float -o eager.exr")
+command += oiiotool ("--lazy ../common/tahoe-tiny.tif " + chain + "-d float -o lazy.exr")
+command += diff_command ("eager.exr", "lazy.exr")
+
+# An argument with an expression, which may look at the pixels, ends the
+# chain before it.
+command += oiiotool ("--lazy ../common/tahoe-tiny.tif --addc 0.1 "
+                     + "--mulc \"{TOP.AVGCOLOR}\" -d float -o lazyexpr.exr")
+command += oiiotool ("../common/tahoe-tiny.tif --addc 0.1 "
+                     + "--mulc \"{TOP.AVGCOLOR}\" -d float -o eagerexpr.exr")
+command += diff_command ("eagerexpr.exr", "lazyexpr.exr")
+
+# A chain written straight to -o is streamed in bands rather than computed
+# as a whole image, which must not change the result, for tiled outputs
+# (whose bands are rounded to whole tiles) as well as scanline ones. With
+# --lazy, a plain conversion of an untiled file may be streamed as well.
+command += oiiotool ("--lazy ../common/tahoe-tiny.tif --mulc 0.5 --addc 0.25 "
+                     + "--tile 48 40 -d uint16 -o streamtiled.tif")
+command += oiiotool ("../common/tahoe-tiny.tif --mulc 0.5 --addc 0.25 "
+                     + "--tile 48 40 -d uint16 -o eagertiled.tif")
+command += diff_command ("eagertiled.tif", "streamtiled.tif")
+command += oiiotool ("--lazy ../common/tahoe-tiny.tif --invert "
+                     + "-d half -o streamscan.exr")
+command += oiiotool ("../common/tahoe-tiny.tif --invert -d half -o eagerscan.exr")
+command += diff_command ("eagerscan.exr", "streamscan.exr")
+command += oiiotool ("--lazy ../common/tahoe-tiny.tif -d uint16 -o streamconv.tif")
+command += oiiotool ("../common/tahoe-tiny.tif -d uint16 -o eagerconv.tif")
+command += diff_command ("eagerconv.tif", "streamconv.tif")
+
+
+# Outputs to check against references
+outputs = [ "out.txt" ]
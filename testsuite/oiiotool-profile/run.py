@@ -0,0 +1,21 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# --profile writes one trace event per command. Only the shape of the
+# trace is checked; the timings are filtered out by the script.
+command += oiiotool ("--profile prof.json ../common/tahoe-tiny.tif "
+                     + "--resize 64x48 -o resized.tif")
+command += pythonbin + " src/check_profile.py prof.json >> out.txt ;"
+
+# It covers the whole command line, wherever --profile appears on it
+command += oiiotool ("../common/tahoe-tiny.tif --profile prof2.json "
+                     + "-o copy.tif")
+command += pythonbin + " src/check_profile.py prof2.json >> out.txt ;"
+
+
+# Outputs to check against references
+outputs = [ "out.txt" ]
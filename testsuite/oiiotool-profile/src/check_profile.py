@@ -0,0 +1,28 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+# Print the shape of an oiiotool --profile trace: its events and the keys
+# they carry, but none of the timings or sizes, which vary from run to run.
+
+import json
+import sys
+
+with open(sys.argv[1]) as f :
+    trace = json.load(f)
+
+print ("displayTimeUnit:", trace["displayTimeUnit"])
+print ("otherData keys:", sorted(trace["otherData"].keys()))
+for ev in trace["traceEvents"] :
+    if ev["ph"] == "M" :
+        print ("metadata event:", ev["name"], ev["args"]["name"])
+        continue
+    numbers_ok = (ev["ts"] >= 0 and ev["dur"] >= 0
+                  and all(isinstance(v, (int, float)) and v >= 0
+                          for v in ev["args"].values()))
+    print ("event:", ev["name"], ev["ph"], ev["cat"],
+           "frame", ev["args"]["frame"],
+           "numbers ok" if numbers_ok else "BAD NUMBERS")
+    print ("    args:", sorted(ev["args"].keys()))
@@ -0,0 +1,26 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# Start a server in the background, send it malformed requests, which it
+# must refuse without going down, and check that jobs still run on it
+# exactly as they would locally, in the client's working directory and
+# with the client's exit status.
+command += (oiio_app("oiiotool") + "--serve serve.sock > server.log 2>&1 "
+            + "& echo $! > server.pid ;\n")
+command += pythonbin + " src/bad_clients.py serve.sock >> out.txt ;"
+command += oiiotool ("--connect serve.sock --echo \"still serving\"")
+command += oiiotool ("--connect serve.sock --create 16x8 3 -o made.tif")
+command += oiiotool ("made.tif --echo \"made: {TOP.width}x{TOP.height}\"")
+command += (oiiotool ("--connect serve.sock nosuchfile.tif -o out.tif",
+                      silent=True, concat=False)
+            + " 2> /dev/null || echo \"failed job: exit status passed back\""
+            + redirect + ";\n")
+command += "kill `cat server.pid` ;"
+
+
+# Outputs to check against references
+outputs = [ "out.txt" ]
@@ -0,0 +1,97 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+# Send an oiiotool --serve server a series of malformed requests, printing
+# how each was answered. The server must refuse them all and keep running.
+
+import array
+import socket
+import struct
+import sys
+import time
+
+path = sys.argv[1]
+
+
+def connect() :
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    sock.connect(path)
+    return sock
+
+
+def send_header(sock, length, with_fds=True) :
+    data = struct.pack("=I", length)
+    if with_fds :
+        fds = array.array("i", [sys.stdout.fileno(), sys.stderr.fileno()])
+        sock.sendmsg([data], [(socket.SOL_SOCKET, socket.SCM_RIGHTS, fds)])
+    else :
+        sock.sendall(data)
+
+
+def reply(sock) :
+    data = b""
+    while len(data) < 4 :
+        chunk = sock.recv(4 - len(data))
+        if not chunk :
+            return "closed"
+        data += chunk
+    return "status " + str(struct.unpack("=i", data)[0])
+
+
+# Wait for the server to start listening
+for i in range(200) :
+    try :
+        connect().close()
+        break
+    except (socket.error, OSError) :
+        time.sleep(0.05)
+
+# Connect and hang up without sending anything
+connect().close()
+print ("hang up: ok")
+
+# A header that is cut short
+sock = connect()
+sock.sendall(b"\x01\x00")
+sock.shutdown(socket.SHUT_WR)
+print ("short header:", reply(sock))
+sock.close()
+
+# A header without the client's output descriptors
+sock = connect()
+send_header(sock, 8, with_fds=False)
+sock.sendall(b"/\x00echo\x00\x00")
+print ("no descriptors:", reply(sock))
+sock.close()
+
+# An absurd payload length
+sock = connect()
+send_header(sock, 0xffffffff)
+print ("huge length:", reply(sock))
+sock.close()
+
+# A payload shorter than promised
+sock = connect()
+send_header(sock, 100)
+sock.sendall(b"/\x00oiiotool\x00")
+sock.shutdown(socket.SHUT_WR)
+print ("short payload:", reply(sock))
+sock.close()
+
+# A payload with no NUL terminators
+sock = connect()
+send_header(sock, 8)
+sock.sendall(b"abcdefgh")
+print ("unterminated payload:", reply(sock))
+sock.close()
+
+# A working directory that doesn't exist
+payload = b"/no/such/directory\x00oiiotool\x00--echo\x00hi\x00"
+sock = connect()
+send_header(sock, len(payload))
+sock.sendall(payload)
+print ("bad directory:", reply(sock))
+sock.close()
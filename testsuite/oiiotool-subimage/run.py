@@ -42,6 +42,26 @@ command += oiiotool ("-echo \"Select nonexistent subimage\""
 command += oiiotool ("-echo \"Select nonexistent MIP level\""
                      + " ../common/textures/grid.tx --selectmip 14 -o mip14.tif")
 
+# Ops on many small subimages process them concurrently. Each subimage of
+# the result must match the same op applied to that subimage alone.
+parts = ""
+sizes = [ "64x48", "32x32", "17x9", "128x64", "5x5", "40x80" ]
+for (s, res) in enumerate(sizes) :
+    parts += ("--pattern fill:top=0.{0},0.2,0.9:bottom=0.9,0.{0},0.1 "
+              + res + " 3 ").format(s + 1)
+command += oiiotool (parts + "--siappendall -d float -o parts.exr")
+command += oiiotool ("-a parts.exr --mulc 0.5 --addc 0.25 parts.exr --add "
+                     + "-o parts-op.exr")
+for s in range(6) :
+    command += oiiotool (("parts.exr --subimage {0} --mulc 0.5 --addc 0.25 "
+                          + "parts.exr --subimage {0} --add "
+                          + "-o one-op{0}.exr").format(s))
+    command += oiiotool ("parts-op.exr --subimage {0} -o all-op{0}.exr"
+                         .format(s))
+    command += ("(" + oiio_app("idiff") + " -q -a one-op{0}.exr all-op{0}.exr"
+                + " && echo \"subimage {0}: ok\")" + redirect
+                + " ;\n").format(s)
+
 # Outputs to check against references
 outputs = [ 
             "subimages-2.exr", "subimages-4.exr",
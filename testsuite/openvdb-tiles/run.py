@@ -0,0 +1,12 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# Check the batched tile reads of the openvdb test's volumes against the
+# whole-volume read, and the active voxel metadata against the data window.
+vdbdir = OIIO_TESTSUITE_ROOT + "/openvdb/src/"
+for f in [ "sphere.vdb", "sphereCd.vdb" ] :
+    command += pythonbin + " src/vdbtiles.py " + vdbdir + f + " >> out.txt ;\n"
@@ -0,0 +1,60 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+import OpenImageIO as oiio
+import numpy
+
+import os
+import sys
+
+filename = sys.argv[1]
+inp = oiio.ImageInput.open(filename)
+problems = []
+subimage = 0
+while inp.seek_subimage(subimage, 0) :
+    spec = inp.spec()
+    nc = spec.nchannels
+    x0, y0, z0 = spec.x, spec.y, spec.z
+    x1, y1, z1 = x0 + spec.width, y0 + spec.height, z0 + spec.depth
+    tw, th, td = spec.tile_width, spec.tile_height, spec.tile_depth
+    full = inp.read_image(subimage, 0, 0, nc, "float")
+
+    # Every tile on its own, clamped to the data window at the far edges
+    for z in range(z0, z1, td) :
+        for y in range(y0, y1, th) :
+            for x in range(x0, x1, tw) :
+                xe, ye, ze = min(x + tw, x1), min(y + th, y1), min(z + td, z1)
+                tile = inp.read_tiles(subimage, 0, x, xe, y, ye, z, ze,
+                                      0, nc, "float")
+                if not numpy.array_equal(tile.reshape(ze - z, ye - y, xe - x, nc),
+                                         full[z-z0:ze-z0, y-y0:ye-y0, x-x0:xe-x0]) :
+                    problems.append(("tile", subimage, x, y, z))
+
+    # A block of several tiles from the middle of the volume
+    xm, ym, zm = x0 + tw, y0 + th, z0 + td
+    xe, ye, ze = min(xm + 2 * tw, x1), min(ym + 2 * th, y1), min(zm + 2 * td, z1)
+    if xm < xe and ym < ye and zm < ze :
+        block = inp.read_tiles(subimage, 0, xm, xe, ym, ye, zm, ze, 0, nc, "float")
+        if not numpy.array_equal(block.reshape(ze - zm, ye - ym, xe - xm, nc),
+                                 full[zm-z0:ze-z0, ym-y0:ye-y0, xm-x0:xe-x0]) :
+            problems.append(("block", subimage))
+
+    # The active voxel bounds are the volume's full window, and there can't
+    # be more active voxels than fit in them.
+    bbox = spec.getattribute("openvdb:activebbox")
+    count = spec.getattribute("openvdb:activevoxels")
+    if (bbox is None or count is None
+          or tuple(bbox[0:3]) != (spec.full_x, spec.full_y, spec.full_z)
+          or (bbox[3] - bbox[0] + 1, bbox[4] - bbox[1] + 1, bbox[5] - bbox[2] + 1)
+             != (spec.full_width, spec.full_height, spec.full_depth)
+          or not (0 < count <= spec.full_width * spec.full_height * spec.full_depth)) :
+        problems.append(("active", subimage))
+    subimage += 1
+
+inp.close()
+print("{}: {}".format(os.path.basename(filename),
+                      "ok" if subimage and not problems else problems))
@@ -26,5 +26,16 @@ command += oiiotool ("--pattern fill:topleft=1,0,0,1:topright=0,1,0,1:bottomleft
 command += oiiotool ("--pattern fill:color=0.00235,0.00106,0.00117,0.0025 1x1 4 -d uint8 -o smallalpha.png")
 command += oiiotool ("--no-autopremult --dumpdata smallalpha.png")
 
+# Parallel IDAT compression must decode to the same pixels as the serial
+# libpng path, with all the filters in play and many bands.
+command += oiiotool ("--pattern fill:topleft=1,0,0,1:topright=0,1,0,1:bottomleft=0,0,1,1:bottomright=1,1,1,1 1024x512 4 -d uint16 -o serial.png")
+command += oiiotool ("serial.png --attrib png:threads 0 --attrib png:filter 248 -o parallel.png")
+command += diff_command ("serial.png", "parallel.png")
+
+# The "png:fast" input hint (whole-range reads, no checksum verification)
+# must not change the pixels.
+command += oiiotool ("--iconfig png:fast 1 ../oiio-images/oiio-logo-with-alpha.png -o fastread.tif")
+command += diff_command ("../oiio-images/oiio-logo-with-alpha.png", "fastread.tif")
+
 outputs = [ "test16.png", "out.txt" ]
 
@@ -0,0 +1,16 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# Layer channels are only decompressed when their layer is first read, and
+# only one layer is kept decompressed at a time. Read the layers of the
+# psd test's multi-layer files out of order and check them against a
+# front-to-back read.
+psddir = OIIO_TESTSUITE_ROOT + "/psd/src/"
+files = [ "Layers_8bit_RGB.psd", "Layers_16bit_RGB.psd",
+          "Layers_32bit_RGB.psd", "layer-mask.psd" ]
+for f in files :
+    command += pythonbin + " src/layerorder.py " + psddir + f + " >> out.txt ;\n"
@@ -0,0 +1,43 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+import OpenImageIO as oiio
+import numpy
+
+import os
+import sys
+
+filename = sys.argv[1]
+
+# Reference: each layer from its own freshly opened reader
+layers = []
+while True :
+    inp = oiio.ImageInput.open(filename)
+    if not inp.seek_subimage(len(layers), 0) :
+        break
+    layers.append(inp.read_image())
+    inp.close()
+
+# One reader, hopping between layers, revisiting some
+n = len(layers)
+order = list(range(n - 1, -1, -1)) + [ 1 % n, 1 % n, n - 1, 0, n // 2 ]
+inp = oiio.ImageInput.open(filename)
+bad = []
+for s in order :
+    if (not inp.seek_subimage(s, 0)
+        or not numpy.array_equal(inp.read_image(), layers[s])) :
+        bad.append(s)
+    # Also a partial read of a layer's scanlines
+    if n > 1 and s == n - 1 :
+        spec = inp.spec()
+        y0 = spec.y + spec.height // 2
+        rows = inp.read_scanlines(s, 0, y0, spec.y + spec.height, 0, 0,
+                                  spec.nchannels)
+        if not numpy.array_equal(rows, layers[s][y0 - spec.y:]) :
+            bad.append(("rows", s))
+inp.close()
+print("{}: {} layers, mismatched: {}".format(os.path.basename(filename), n, bad))
@@ -9,3 +9,10 @@ imagedir = "src"
 files = [ "triangle.ptx" ]
 for f in files:
     command += info_command (imagedir + "/" + f)
+
+# Two files read by one process share the one Ptex cache, here with the
+# smallest memory budget.
+shutil.copyfile ("src/triangle.ptx", "copy.ptx")
+command += info_command ("copy.ptx",
+                         extraargs="--oiioattrib ptex:max_memory_MB 1 "
+                                   + imagedir + "/triangle.ptx")
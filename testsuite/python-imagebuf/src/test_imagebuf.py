@@ -184,6 +184,19 @@ try:
     print (" from 4D, shape is", b.spec().format, b.roi)
     print ("")
 
+    print ("Wrapping a numpy array without copying:")
+    a = numpy.zeros((3, 2, 4), dtype="f")
+    b = oiio.ImageBuf(a, copy=False)
+    a[1,0] = [0.25, 0.5, 0.75, 1.0]
+    print ("  pixel (0,1) = {:.3g} {:.3g} {:.3g} {:.3g}".format(*b.getpixel(0,1)))
+    v = numpy.asarray(b)
+    print ("  view shape", v.shape, "shares memory:", numpy.shares_memory(v, a))
+    b = oiio.ImageBuf(oiio.ImageSpec(2, 2, 3, "uint8"))
+    v = numpy.asarray(b)
+    v[0,1] = [10, 20, 30]
+    print ("  set through a view, pixel (1,0) = {:.3g} {:.3g} {:.3g}".format(*b.getpixel(1,0)))
+    print ("")
+
     # Test reading from disk
     print ("Testing read of ../common/textures/grid.tx:")
     b = oiio.ImageBuf ("../common/textures/grid.tx")
@@ -55,6 +55,17 @@ diff = oiio.ImageBufAlgo.compare(checker_buf, render_buf, 0, 0)
 
 print("top mip pixel differences when streaming =", diff.nfail)
 
+# The same lookups, all in one batched call
+ys, xs = numpy.mgrid[0:512, 0:512]
+batch = texture_sys.texture_batch(checker, texture_opt,
+                                  ((xs + 0.5) / 512.0).ravel(),
+                                  ((ys + 0.5) / 512.0).ravel(),
+                                  None, None, None, None, 3)
+print("batched result shape =", batch.shape)
+batch_buf = oiio.ImageBuf(batch.reshape(512, 512, 3))
+diff = oiio.ImageBufAlgo.compare(checker_buf, batch_buf, 1.0e-5, 1.0e-5)
+print("top mip pixel differences when batched =", diff.nfail)
+
 print ("")
 
 # Test udim
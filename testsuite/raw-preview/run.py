@@ -0,0 +1,27 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# Read the camera's embedded preview instead of the raw image with the
+# "raw:preview" hint. The preview's size and pixels vary by camera and by
+# libraw version, so just check that we got an 8 bit RGB preview that kept
+# the shot's metadata.
+files = [ "RAW_CANON_EOS_7D.CR2",
+          "RAW_NIKON_D3X.NEF" ]
+
+for f in files:
+    command += oiiotool ("-iconfig raw:preview 1 "
+                         + "-i " + OIIO_TESTSUITE_IMAGEDIR + "/" + f
+                         + " --echo \"" + f + ": preview={TOP['raw:preview']}"
+                         + " channels={TOP.nchannels}"
+                         + " format={TOP.nativeformat}"
+                         + " nonempty={TOP.width > 0 && TOP.height > 0}"
+                         + " make={TOP.Make}\"")
+
+# A file read without the hint is still the full raw image
+command += oiiotool ("-i " + OIIO_TESTSUITE_IMAGEDIR + "/" + files[0]
+                     + " --echo \"" + files[0] + ": preview={TOP['raw:preview']}"
+                     + " size={TOP.width}x{TOP.height}\"")
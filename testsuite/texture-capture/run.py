@@ -0,0 +1,20 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# Capture the lookups of an ordinary run, then replay them while capturing
+# again. The second capture should be identical to the first.
+command += testtex_command ("../common/textures/grid.tx",
+                            "-res 32 24 --capture cap1.bin > capture.log 2>&1",
+                            silent=True)
+command += testtex_command ("--replay cap1.bin --capture cap2.bin",
+                            "--iters 1 --trials 1 --threads 1 > replay.log 2>&1",
+                            silent=True)
+command += run_app (pythonbin + " -c \"import filecmp; "
+                    + "print('capture round trip matches:', "
+                    + "filecmp.cmp('cap1.bin', 'cap2.bin', shallow=False))\"")
+
+outputs = [ "out.txt" ]
@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# Sorting the lanes of a batch by tile only changes the order of the
+# lookups, so the results should match the plain bicubic test.
+refdirlist = [ "ref/", "../texture-interp-bicubic/ref/" ]
+
+command = testtex_command ("../common/textures/grid.tx",
+                           extraargs = "--batch --texoptions coherent_batches=1 "
+                                       + "-interpmode 2  -d uint8 -o out.tif")
+outputs = [ "out.tif" ]
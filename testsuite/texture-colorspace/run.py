@@ -14,4 +14,16 @@
 command += oiiotool ("-pattern constant:color=0.5,0.5,0.5 64x64 3 -d uint8 -otex grey.exr")
 command += testtex_command ("-res 64 64 --no-gettextureinfo --nowarp grey.exr -o nocc.exr")
 command += testtex_command ("-res 60 60 --no-gettextureinfo --nowarp --texcolorspace sRGB grey.exr -o cc.exr")
+
+# The same texture as uint16, and as RGBA with only RGB looked up, should be
+# converted through the same transform and match the uint8 result.
+command += oiiotool ("-pattern constant:color=0.5,0.5,0.5 64x64 3 -d uint16 -otex grey16.exr")
+command += oiiotool ("-pattern constant:color=0.5,0.5,0.5,1 64x64 4 -d uint8 -otex greya.exr")
+command += testtex_command ("-res 60 60 --no-gettextureinfo --nowarp --texcolorspace sRGB grey16.exr -o cc16.exr")
+command += testtex_command ("-res 60 60 --no-gettextureinfo --nowarp --texcolorspace sRGB --nchannels 3 greya.exr -o cca.exr")
+for img in [ "cc16.exr", "cca.exr" ] :
+    command += ("(" + oiio_app("idiff") + " -q -a -fail 0.004 -warn 0.004 "
+                + img + " ref/cc.exr && echo \"" + img + ": ok\")"
+                + redirect + " ;\n")
+
 outputs = [ "nocc.exr", "cc.exr", "out.txt" ]
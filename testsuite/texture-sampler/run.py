@@ -0,0 +1,14 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# Looking up through a precomputed Sampler uses the same options as the
+# plain bicubic test, so the results should match it exactly.
+refdirlist = [ "ref/", "../texture-interp-bicubic/ref/" ]
+
+command = testtex_command ("../common/textures/grid.tx",
+                           extraargs = "--sampler -interpmode 2  -d uint8 -o out.tif")
+outputs = [ "out.tif" ]
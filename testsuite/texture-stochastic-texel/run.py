@@ -0,0 +1,28 @@
+#!/usr/bin/env python
+
+# Copyright Contributors to the OpenImageIO project.
+# SPDX-License-Identifier: Apache-2.0
+# https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+# Magnify a checkerboard of single texels, once with bilinear filtering and
+# once with stochastic single-texel lookups (-stochastic 4). Each stochastic
+# pixel is one of the four texels its bilinear lookup would blend, so the
+# result is noisy, but averaged over 64x64 blocks it must match bilinear.
+
+command += oiiotool ("-pattern checker:width=1:height=1:color1=0,0,0:color2=1,1,1 64x64 3 -d uint8 -otex checker.tx")
+command += testtex_command ("checker.tx",
+                            "-nowarp -res 256 256 -interpmode 1 -o bilinear.exr",
+                            silent=True)
+command += testtex_command ("checker.tx",
+                            "-nowarp -res 256 256 -interpmode 1 -stochastic 4 -o stochastic.exr",
+                            silent=True)
+command += oiiotool ("bilinear.exr --resize:filter=box 4x4 -o bilinear-mean.exr")
+command += oiiotool ("stochastic.exr --resize:filter=box 4x4 -o stochastic-mean.exr")
+command += diff_command ("stochastic-mean.exr", "bilinear-mean.exr",
+                         "-fail 0.04 -failpercent 0 -warn 0.04")
+# Every stochastic pixel really is a single texel, 0 or 1, not a blend:
+# min(x,1-x) is zero everywhere.
+command += oiiotool ("stochastic.exr --dup --invert --min --rangecheck 0,0,0 0,0,0")
+
+outputs = [ "out.txt" ]
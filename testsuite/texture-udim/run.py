@@ -32,4 +32,14 @@ command += testtex_command ("--udim --maketests 10 \"mktest_{:04}.<UDIM>.tx\""
                             + " --maketest-res 1024 --cachesize 1 --maxfiles 5"
                             + " --res 256 256 -d uint8 -o out3.tif")
 
+# Batched lookups must match one-at-a-time lookups, including batches whose
+# lanes straddle tile boundaries or land on tiles with no file (1003, 1013).
+command += testtex_command ("\"file.<UDIM>.tx\"",
+                            "-nowarp -scalest 3 2 -res 100 100 -d uint8 -o udim-scalar.tif",
+                            silent=True)
+command += testtex_command ("\"file.<UDIM>.tx\"",
+                            "--batch -nowarp -scalest 3 2 -res 100 100 -d uint8 -o udim-batch.tif",
+                            silent=True)
+command += diff_command ("udim-batch.tif", "udim-scalar.tif")
+
 outputs = [ "out.tif", "out2.tif", "out3.tif", "out.txt" ]
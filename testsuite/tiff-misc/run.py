@@ -25,4 +25,14 @@ command += oiiotool ("--oiioattrib try_all_readers 0 --info -v src/crash-1633.ti
 command += oiiotool ("--oiioattrib try_all_readers 0 --info src/crash-1643.tif -o out.exr", failureok = True)
 command += iconvert ("src/crash-1709.tif crash-1709.exr", failureok=True)
 
+# Tiled and stripped zip/LZW files are compressed in parallel by our own
+# encoders; make sure they round trip.
+command += oiiotool("--pattern fill:topleft=0,0,0:topright=1,0,0:bottomleft=0,1,0:bottomright=1,1,1 300x200 3 -d uint16 -o pattern.tif")
+command += oiiotool("pattern.tif --tile 64 64 --compression lzw -o tiled-lzw.tif")
+command += oiiotool("pattern.tif -d uint8 --compression lzw -attrib tiff:rowsperstrip 16 -o strip-lzw.tif")
+command += oiiotool("pattern.tif -d uint32 --tile 64 64 --compression zip -o tiled-zip32.tif")
+command += diff_command("tiled-lzw.tif", "pattern.tif")
+command += diff_command("strip-lzw.tif", "pattern.tif")
+command += diff_command("tiled-zip32.tif", "pattern.tif")
+
 outputs = [ "check1.tif", "out.txt" ]